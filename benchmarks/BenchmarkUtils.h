@@ -0,0 +1,45 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+/**
+ * @brief Reports the bytes read and written and the arithmetic operations of one iteration as the rates `GB/s` and
+ * `GFLOP/s`, which are also part of the JSON output (`--benchmark_out_format=json`).
+ */
+inline void setThroughput(benchmark::State & state, double bytesPerIteration, double flopsPerIteration = 0) {
+    state.counters["GB/s"] = benchmark::Counter(bytesPerIteration / 1e9, benchmark::Counter::kIsIterationInvariantRate);
+    if(flopsPerIteration > 0)
+        state.counters["GFLOP/s"] = benchmark::Counter(flopsPerIteration / 1e9,
+                benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/**
+ * @brief The DaphneContext of the kernels, with the default user config (i.e., all CPUs for the kernels that run in
+ * parallel), which is shared by all benchmarks.
+ */
+inline DaphneContext * getBenchmarkContext() {
+    static DaphneUserConfig config;
+    static auto ctx = std::make_unique<DaphneContext>(config);
+    return ctx.get();
+}
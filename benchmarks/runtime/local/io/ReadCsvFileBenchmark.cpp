@@ -0,0 +1,113 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <BenchmarkUtils.h>
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/File.h>
+#include <runtime/local/io/ReadCsvFile.h>
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+/**
+ * @brief Writes a CSV file of random values (integers in even, doubles in odd columns if `mixed`, doubles in all
+ * columns otherwise) to the temporary directory, unless it exists already, and returns its path.
+ */
+static std::string createCsvFile(size_t numRows, size_t numCols, bool mixed) {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("daphne-benchmark-"
+            + std::to_string(numRows) + "x" + std::to_string(numCols) + (mixed ? "-mixed" : "") + ".csv");
+    if(std::filesystem::exists(path))
+        return path.string();
+    std::ofstream ofs(path.string() + ".tmp");
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> dist(-1000, 1000);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const double v = dist(gen);
+            if(mixed && c % 2 == 0)
+                ofs << static_cast<int64_t>(v);
+            else
+                ofs << v;
+            ofs << (c + 1 < numCols ? ',' : '\n');
+        }
+    ofs.close();
+    std::filesystem::rename(path.string() + ".tmp", path);
+    return path.string();
+}
+
+// Arguments: the number of rows and columns.
+template<typename VT>
+static void BM_ReadCsvFile_Dense(benchmark::State & state) {
+    const size_t numRows = state.range(0);
+    const size_t numCols = state.range(1);
+    const std::string path = createCsvFile(numRows, numCols, false);
+
+    for(auto _ : state) {
+        File * file = openFile(path.c_str());
+        DenseMatrix<VT> * res = nullptr;
+        readCsvFile(res, file, numRows, numCols, ',');
+        benchmark::DoNotOptimize(res->getValues());
+        state.PauseTiming();
+        closeFile(file);
+        DataObjectFactory::destroy(res);
+        state.ResumeTiming();
+    }
+
+    // the rate of parsing the text, the page cache holds the file after the first iteration
+    setThroughput(state, static_cast<double>(std::filesystem::file_size(path)));
+    state.SetItemsProcessed(state.iterations() * numRows * numCols);
+}
+
+#define CSV_SHAPES ->Args({1000000, 10})->Args({100000, 100})->Args({1000, 10000})->Unit(benchmark::kMillisecond)
+BENCHMARK_TEMPLATE(BM_ReadCsvFile_Dense, double) CSV_SHAPES;
+BENCHMARK_TEMPLATE(BM_ReadCsvFile_Dense, float) CSV_SHAPES;
+
+// Arguments: the number of rows and columns, alternately of int64 and double values.
+static void BM_ReadCsvFile_Frame(benchmark::State & state) {
+    const size_t numRows = state.range(0);
+    const size_t numCols = state.range(1);
+    const std::string path = createCsvFile(numRows, numCols, true);
+    std::vector<ValueTypeCode> schema(numCols);
+    for(size_t c = 0; c < numCols; c++)
+        schema[c] = c % 2 == 0 ? ValueTypeCode::SI64 : ValueTypeCode::F64;
+
+    for(auto _ : state) {
+        File * file = openFile(path.c_str());
+        Frame * res = nullptr;
+        readCsvFile(res, file, numRows, numCols, ',', schema.data());
+        benchmark::DoNotOptimize(res);
+        state.PauseTiming();
+        closeFile(file);
+        DataObjectFactory::destroy(res);
+        state.ResumeTiming();
+    }
+
+    setThroughput(state, static_cast<double>(std::filesystem::file_size(path)));
+    state.SetItemsProcessed(state.iterations() * numRows * numCols);
+}
+
+BENCHMARK(BM_ReadCsvFile_Frame)->Args({1000000, 10})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <BenchmarkUtils.h>
+
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/RandMatrix.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+// Arguments: the number of rows and columns.
+template<typename VT>
+static void BM_EwBinaryMat_Dense(benchmark::State & state) {
+    const size_t numRows = state.range(0);
+    const size_t numCols = state.range(1);
+    DenseMatrix<VT> * lhs = nullptr;
+    DenseMatrix<VT> * rhs = nullptr;
+    randMatrix<DenseMatrix<VT>, VT>(lhs, numRows, numCols, VT(1), VT(100), 1.0, 42, nullptr);
+    randMatrix<DenseMatrix<VT>, VT>(rhs, numRows, numCols, VT(1), VT(100), 1.0, 43, nullptr);
+    // the result is allocated once, such that the loops are measured, not the allocation
+    auto res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+    for(auto _ : state) {
+        ewBinaryMat(BinaryOpCode::ADD, res, lhs, rhs, getBenchmarkContext());
+        benchmark::DoNotOptimize(res->getValues());
+        benchmark::ClobberMemory();
+    }
+
+    const double numCells = static_cast<double>(numRows) * numCols;
+    setThroughput(state, 3 * numCells * sizeof(VT), numCells);
+    DataObjectFactory::destroy(lhs, rhs, res);
+}
+
+#define DENSE_SHAPES ->Args({1000, 1000})->Args({1000000, 10})->Args({10, 1000000})->Args({4000, 4000})
+BENCHMARK_TEMPLATE(BM_EwBinaryMat_Dense, double) DENSE_SHAPES;
+BENCHMARK_TEMPLATE(BM_EwBinaryMat_Dense, float) DENSE_SHAPES;
+BENCHMARK_TEMPLATE(BM_EwBinaryMat_Dense, int64_t) DENSE_SHAPES;
+
+// Arguments: the number of rows and columns, and the sparsity (non-zeros per 1000 cells) of both operands.
+template<typename VT>
+static void BM_EwBinaryMat_CSR(benchmark::State & state) {
+    const size_t numRows = state.range(0);
+    const size_t numCols = state.range(1);
+    const double sparsity = state.range(2) / 1000.0;
+    CSRMatrix<VT> * lhs = nullptr;
+    CSRMatrix<VT> * rhs = nullptr;
+    randMatrix<CSRMatrix<VT>, VT>(lhs, numRows, numCols, VT(1), VT(100), sparsity, 42, nullptr);
+    randMatrix<CSRMatrix<VT>, VT>(rhs, numRows, numCols, VT(1), VT(100), sparsity, 43, nullptr);
+    const size_t nnz = lhs->getNumNonZeros() + rhs->getNumNonZeros();
+
+    for(auto _ : state) {
+        CSRMatrix<VT> * res = nullptr;
+        ewBinaryMat(BinaryOpCode::ADD, res, lhs, rhs, getBenchmarkContext());
+        benchmark::DoNotOptimize(res->getValues());
+        state.PauseTiming();
+        DataObjectFactory::destroy(res);
+        state.ResumeTiming();
+    }
+
+    // the values and column indexes of both operands and (at most) the same number in the result
+    setThroughput(state, 2.0 * nnz * (sizeof(VT) + sizeof(size_t)), nnz);
+    state.counters["nnz"] = nnz;
+    DataObjectFactory::destroy(lhs, rhs);
+}
+
+#define SPARSE_SHAPES ->Args({100000, 1000, 1})->Args({100000, 1000, 10})->Args({100000, 1000, 100})
+BENCHMARK_TEMPLATE(BM_EwBinaryMat_CSR, double) SPARSE_SHAPES;
+BENCHMARK_TEMPLATE(BM_EwBinaryMat_CSR, float) SPARSE_SHAPES;
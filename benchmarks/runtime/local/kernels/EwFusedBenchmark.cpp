@@ -0,0 +1,105 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <BenchmarkUtils.h>
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/AggAll.h>
+#include <runtime/local/kernels/AggOpCode.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/EwBinaryObjSca.h>
+#include <runtime/local/kernels/EwFused.h>
+#include <runtime/local/kernels/RandMatrix.h>
+
+#include <benchmark/benchmark.h>
+
+// The tree `(a0 - a1) * (a0 - a1) / a2`, optionally summed up, evaluated by one ewFused call (fused) and by one kernel call
+// per operation (unfused), which is what FuseEwiseOpsPass replaces. Arguments: the number of rows and columns, and
+// whether the result is summed up.
+
+template<typename VT>
+struct EwFusedBenchmarkArgs {
+    const DenseMatrix<VT> * args[3] = {};
+
+    EwFusedBenchmarkArgs(size_t numRows, size_t numCols) {
+        for(size_t i = 0; i < 3; i++) {
+            DenseMatrix<VT> * arg = nullptr;
+            randMatrix<DenseMatrix<VT>, VT>(arg, numRows, numCols, VT(1), VT(100), 1.0, 42 + i, nullptr);
+            args[i] = arg;
+        }
+    }
+
+    ~EwFusedBenchmarkArgs() {
+        DataObjectFactory::destroy(args[0], args[1], args[2]);
+    }
+};
+
+template<typename VT>
+static void BM_EwFused_Fused(benchmark::State & state) {
+    const size_t numRows = state.range(0);
+    const size_t numCols = state.range(1);
+    const bool sum = state.range(2);
+    EwFusedBenchmarkArgs<VT> a(numRows, numCols);
+    const char * program = sum ? "sumAll;sub a0 a1;mul r0 r0;div r1 a2" : "none;sub a0 a1;mul r0 r0;div r1 a2";
+    // the result is allocated once, such that the kernel is measured, not the allocation
+    DenseMatrix<VT> * res = DataObjectFactory::create<DenseMatrix<VT>>(sum ? 1 : numRows, sum ? 1 : numCols, false);
+
+    for(auto _ : state) {
+        ewFused(res, program, a.args, 3, getBenchmarkContext());
+        benchmark::DoNotOptimize(res->getValues());
+        benchmark::ClobberMemory();
+    }
+
+    // the three arguments are read and the result is written once
+    const double numCells = static_cast<double>(numRows) * numCols;
+    setThroughput(state, (sum ? 3 : 4) * numCells * sizeof(VT), (sum ? 4 : 3) * numCells);
+    DataObjectFactory::destroy(res);
+}
+
+template<typename VT>
+static void BM_EwFused_Unfused(benchmark::State & state) {
+    const size_t numRows = state.range(0);
+    const size_t numCols = state.range(1);
+    const bool sum = state.range(2);
+    EwFusedBenchmarkArgs<VT> a(numRows, numCols);
+    DenseMatrix<VT> * diff = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    DenseMatrix<VT> * sq = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    DenseMatrix<VT> * res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+    for(auto _ : state) {
+        ewBinaryMat(BinaryOpCode::SUB, diff, a.args[0], a.args[1], getBenchmarkContext());
+        ewBinaryMat(BinaryOpCode::MUL, sq, diff, diff, getBenchmarkContext());
+        ewBinaryMat(BinaryOpCode::DIV, res, sq, a.args[2], getBenchmarkContext());
+        if(sum)
+            benchmark::DoNotOptimize(aggAll(AggOpCode::SUM, res, getBenchmarkContext()));
+        benchmark::DoNotOptimize(res->getValues());
+        benchmark::ClobberMemory();
+    }
+
+    // the same rates as of the fused tree, for comparing the times
+    const double numCells = static_cast<double>(numRows) * numCols;
+    setThroughput(state, (sum ? 3 : 4) * numCells * sizeof(VT), (sum ? 4 : 3) * numCells);
+    DataObjectFactory::destroy(diff, sq, res);
+}
+
+#define FUSED_SHAPES ->Args({1000, 1000, 0})->Args({1000, 1000, 1})->Args({4000, 4000, 0})->Args({4000, 4000, 1}) \
+        ->Args({1000000, 10, 1})
+BENCHMARK_TEMPLATE(BM_EwFused_Fused, double) FUSED_SHAPES;
+BENCHMARK_TEMPLATE(BM_EwFused_Unfused, double) FUSED_SHAPES;
+BENCHMARK_TEMPLATE(BM_EwFused_Fused, float) FUSED_SHAPES;
+BENCHMARK_TEMPLATE(BM_EwFused_Unfused, float) FUSED_SHAPES;
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <BenchmarkUtils.h>
+
+#include <ir/daphneir/Daphne.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/kernels/Group.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+#include <cstdint>
+
+// Arguments: the number of rows and the number of distinct keys.
+static void BM_Group_SumByInt64(benchmark::State & state) {
+    const size_t numRows = state.range(0);
+    const int64_t numKeys = state.range(1);
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64};
+    std::string labels[] = {"k", "v"};
+    auto arg = DataObjectFactory::create<Frame>(numRows, 2, schema, labels, false);
+    int64_t * keys = static_cast<int64_t *>(arg->getColumnRaw(0));
+    double * values = static_cast<double *>(arg->getColumnRaw(1));
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<int64_t> keyDist(0, numKeys - 1);
+    std::uniform_real_distribution<double> valueDist(0, 1);
+    for(size_t r = 0; r < numRows; r++) {
+        keys[r] = keyDist(gen);
+        values[r] = valueDist(gen);
+    }
+
+    const char * keyCols[] = {"k"};
+    const char * aggCols[] = {"v"};
+    mlir::daphne::GroupEnum aggFuncs[] = {mlir::daphne::GroupEnum::SUM};
+    for(auto _ : state) {
+        Frame * res = nullptr;
+        group(res, arg, keyCols, 1, aggCols, 1, aggFuncs, 1, getBenchmarkContext());
+        benchmark::DoNotOptimize(res);
+        state.PauseTiming();
+        DataObjectFactory::destroy(res);
+        state.ResumeTiming();
+    }
+
+    setThroughput(state, numRows * (sizeof(int64_t) + sizeof(double)));
+    state.SetItemsProcessed(state.iterations() * numRows);
+    DataObjectFactory::destroy(arg);
+}
+
+// few groups (fit in the cache), many groups, and about one group per row
+BENCHMARK(BM_Group_SumByInt64)->Args({1000000, 16})->Args({1000000, 100000})->Args({1000000, 1000000})
+        ->Unit(benchmark::kMillisecond);
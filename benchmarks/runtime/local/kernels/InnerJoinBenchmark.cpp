@@ -0,0 +1,75 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <BenchmarkUtils.h>
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/kernels/InnerJoin.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+// a frame of a shuffled int64 key column with the keys [0, numKeys) repeated and a double payload column
+static Frame * createJoinInput(size_t numRows, size_t numKeys, const char * keyLabel, const char * payloadLabel,
+        uint64_t seed) {
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64};
+    std::string labels[] = {keyLabel, payloadLabel};
+    auto frame = DataObjectFactory::create<Frame>(numRows, 2, schema, labels, false);
+    int64_t * keys = static_cast<int64_t *>(frame->getColumnRaw(0));
+    double * payload = static_cast<double *>(frame->getColumnRaw(1));
+    for(size_t r = 0; r < numRows; r++) {
+        keys[r] = static_cast<int64_t>(r % numKeys);
+        payload[r] = static_cast<double>(r);
+    }
+    std::shuffle(keys, keys + numRows, std::mt19937_64(seed));
+    return frame;
+}
+
+// Arguments: the number of rows of the probe side (lhs) and of the build side (rhs), whose keys are unique, i.e.,
+// a foreign-key join.
+static void BM_InnerJoin_ForeignKey(benchmark::State & state) {
+    const size_t numLhs = state.range(0);
+    const size_t numRhs = state.range(1);
+    Frame * lhs = createJoinInput(numLhs, numRhs, "a", "b", 42);
+    Frame * rhs = createJoinInput(numRhs, numRhs, "c", "d", 43);
+
+    for(auto _ : state) {
+        Frame * res = nullptr;
+        innerJoin(res, lhs, rhs, "a", "c", getBenchmarkContext());
+        benchmark::DoNotOptimize(res);
+        state.PauseTiming();
+        DataObjectFactory::destroy(res);
+        state.ResumeTiming();
+    }
+
+    // the inputs and the result of the same number of rows as the probe side
+    const size_t rowBytes = sizeof(int64_t) + sizeof(double);
+    setThroughput(state, (2.0 * numLhs + numRhs) * rowBytes);
+    state.SetItemsProcessed(state.iterations() * (numLhs + numRhs));
+    DataObjectFactory::destroy(lhs, rhs);
+}
+
+// a build side that fits in the cache, one that does not, and as many rows on both sides
+BENCHMARK(BM_InnerJoin_ForeignKey)->Args({1000000, 1000})->Args({1000000, 100000})->Args({1000000, 1000000})
+        ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <BenchmarkUtils.h>
+
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/MatMul.h>
+#include <runtime/local/kernels/RandMatrix.h>
+
+#include <benchmark/benchmark.h>
+
+// Arguments: the number of rows of the lhs, its number of columns (the inner dimension), and the number of columns
+// of the rhs.
+template<typename VT>
+static void BM_MatMul_Dense(benchmark::State & state) {
+    const size_t m = state.range(0);
+    const size_t k = state.range(1);
+    const size_t n = state.range(2);
+    DenseMatrix<VT> * lhs = nullptr;
+    DenseMatrix<VT> * rhs = nullptr;
+    randMatrix<DenseMatrix<VT>, VT>(lhs, m, k, VT(-1), VT(1), 1.0, 42, nullptr);
+    randMatrix<DenseMatrix<VT>, VT>(rhs, k, n, VT(-1), VT(1), 1.0, 43, nullptr);
+    auto res = DataObjectFactory::create<DenseMatrix<VT>>(m, n, false);
+
+    for(auto _ : state) {
+        matMul(res, lhs, rhs, false, false, getBenchmarkContext());
+        benchmark::DoNotOptimize(res->getValues());
+        benchmark::ClobberMemory();
+    }
+
+    setThroughput(state, (static_cast<double>(m) * k + static_cast<double>(k) * n + static_cast<double>(m) * n)
+            * sizeof(VT), 2.0 * m * k * n);
+    DataObjectFactory::destroy(lhs, rhs, res);
+}
+
+// square, tall-skinny (the gram matrix of a data set), matrix-vector, and vector-matrix
+#define DENSE_SHAPES ->Args({512, 512, 512})->Args({2048, 2048, 2048})->Args({100000, 100, 100}) \
+        ->Args({10000, 1000, 1})->Args({1, 1000, 10000})
+BENCHMARK_TEMPLATE(BM_MatMul_Dense, double) DENSE_SHAPES;
+BENCHMARK_TEMPLATE(BM_MatMul_Dense, float) DENSE_SHAPES;
+
+// Arguments: the number of rows and columns of the sparse lhs, its sparsity (non-zeros per 1000 cells), and the
+// number of columns of the dense rhs.
+template<typename VT>
+static void BM_MatMul_CSRDense(benchmark::State & state) {
+    const size_t m = state.range(0);
+    const size_t k = state.range(1);
+    const double sparsity = state.range(2) / 1000.0;
+    const size_t n = state.range(3);
+    CSRMatrix<VT> * lhs = nullptr;
+    DenseMatrix<VT> * rhs = nullptr;
+    randMatrix<CSRMatrix<VT>, VT>(lhs, m, k, VT(-1), VT(1), sparsity, 42, nullptr);
+    randMatrix<DenseMatrix<VT>, VT>(rhs, k, n, VT(-1), VT(1), 1.0, 43, nullptr);
+    const size_t nnz = lhs->getNumNonZeros();
+
+    for(auto _ : state) {
+        DenseMatrix<VT> * res = nullptr;
+        matMul(res, lhs, rhs, false, false, getBenchmarkContext());
+        benchmark::DoNotOptimize(res->getValues());
+        state.PauseTiming();
+        DataObjectFactory::destroy(res);
+        state.ResumeTiming();
+    }
+
+    setThroughput(state, nnz * (sizeof(VT) + sizeof(size_t)) + (static_cast<double>(k) + m) * n * sizeof(VT),
+            2.0 * nnz * n);
+    state.counters["nnz"] = nnz;
+    DataObjectFactory::destroy(lhs, rhs);
+}
+
+BENCHMARK_TEMPLATE(BM_MatMul_CSRDense, double)->Args({100000, 1000, 10, 1})->Args({100000, 1000, 10, 64})
+        ->Args({100000, 1000, 100, 1});
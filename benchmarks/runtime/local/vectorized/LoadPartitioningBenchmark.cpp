@@ -0,0 +1,52 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/LoadPartitioning.h>
+#include <runtime/local/vectorized/LoadPartitioningDefs.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+/**
+ * Measures how fast a partitioning scheme cuts the rows of a pipeline into chunks, which is on the critical path of
+ * the producer of the tasks. The number of chunks is reported, too, since it determines the number of queue
+ * operations of the workers.
+ *
+ * Arguments: the scheme (see SelfSchedulingScheme), the number of rows, and the number of workers.
+ */
+static void BM_LoadPartitioning(benchmark::State & state) {
+    const int scheme = static_cast<int>(state.range(0));
+    const uint64_t numRows = state.range(1);
+    const uint32_t numWorkers = static_cast<uint32_t>(state.range(2));
+    uint64_t numChunks = 0;
+
+    for(auto _ : state) {
+        LoadPartitioning lp(scheme, numRows, 1, numWorkers, false);
+        numChunks = 0;
+        uint64_t numPartitioned = 0;
+        while(lp.hasNextChunk()) {
+            numPartitioned += lp.getNextChunk();
+            numChunks++;
+        }
+        benchmark::DoNotOptimize(numPartitioned);
+    }
+
+    state.counters["chunks"] = static_cast<double>(numChunks);
+    state.SetItemsProcessed(state.iterations() * numChunks);
+}
+
+BENCHMARK(BM_LoadPartitioning)->ArgsProduct({benchmark::CreateDenseRange(STATIC, MFSC, 1), {1000000}, {8, 64}});
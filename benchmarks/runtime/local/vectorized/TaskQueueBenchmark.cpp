@@ -0,0 +1,100 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/TaskQueues.h>
+#include <runtime/local/vectorized/Tasks.h>
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+namespace {
+    // a task that does nothing, such that the queue operations are measured
+    class NopTask : public Task {
+    public:
+        void execute(uint32_t fid, uint32_t batchSize) override {}
+        uint64_t getTaskSize() override { return 1; }
+    };
+
+    // whether the workers except for the first one take their tasks by stealTask() (the top end of a deque)
+    template<class Q> constexpr bool usesStealing = false;
+    template<> constexpr bool usesStealing<WorkStealingDeque> = true;
+}
+
+/**
+ * Fills a closed queue with tasks and measures how fast the given number of workers drain it concurrently, like the
+ * workers of a vectorized pipeline after the tasks were created. With the work-stealing deque, the first worker is
+ * the owner, the others steal.
+ *
+ * Arguments: the number of tasks and the number of workers.
+ */
+template<class Q>
+static void BM_TaskQueue_Drain(benchmark::State & state) {
+    const size_t numTasks = state.range(0);
+    const size_t numWorkers = state.range(1);
+    std::vector<NopTask> tasks(numTasks);
+
+    for(auto _ : state) {
+        state.PauseTiming();
+        Q queue(numTasks);
+        for(auto & t : tasks)
+            queue.enqueueTask(&t);
+        queue.closeInput();
+        std::vector<uint64_t> numDequeued(numWorkers);
+        state.ResumeTiming();
+
+        std::vector<std::thread> workers;
+        for(size_t w = 0; w < numWorkers; w++)
+            workers.emplace_back([&queue, &numDequeued, w]() {
+                const bool steal = usesStealing<Q> && w > 0;
+                uint64_t n = 0;
+                for(Task * t = steal ? queue.stealTask() : queue.dequeueTask(); !dynamic_cast<EOFTask *>(t);
+                        t = steal ? queue.stealTask() : queue.dequeueTask())
+                    n++;
+                numDequeued[w] = n;
+            });
+        for(auto & t : workers)
+            t.join();
+        benchmark::DoNotOptimize(numDequeued.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * numTasks);
+}
+
+#define DRAIN_ARGS ->ArgsProduct({{1 << 20}, {1, 2, 4, 8, 16}})->UseRealTime()->Unit(benchmark::kMillisecond)
+BENCHMARK_TEMPLATE(BM_TaskQueue_Drain, BlockingTaskQueue) DRAIN_ARGS;
+BENCHMARK_TEMPLATE(BM_TaskQueue_Drain, WorkStealingDeque) DRAIN_ARGS;
+
+/**
+ * Measures the owner of a queue alternately enqueuing and dequeuing a task without contention, i.e., the fixed cost
+ * of a queue operation.
+ */
+template<class Q>
+static void BM_TaskQueue_EnqueueDequeue(benchmark::State & state) {
+    Q queue(1024);
+    NopTask task;
+    for(auto _ : state) {
+        queue.enqueueTask(&task);
+        benchmark::DoNotOptimize(queue.dequeueTask());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_TaskQueue_EnqueueDequeue, BlockingTaskQueue);
+BENCHMARK_TEMPLATE(BM_TaskQueue_EnqueueDequeue, WorkStealingDeque);
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+
+# Copyright 2022 The DAPHNE Consortium
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Runs the end-to-end workloads defined in workloads.json (the scripts in scripts/algorithms/ and scalable SQL queries)
+on generated data for a sweep of scale factors, numbers of threads, and configurations of daphne (e.g., --vec with
+several partitioning and queue schemes, or --distributed), and collects the compile and run times into a CSV and a
+JSON report, optionally with strong- and weak-scaling plots.
+
+See doc/development/Benchmarks.md for the usage. Must be invoked from the root directory of DAPHNE.
+"""
+
+import argparse
+import csv
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+WORKLOADS_DIR = os.path.dirname(os.path.abspath(__file__))
+FIELDS = ["workload", "config", "scale", "threads", "repetition", "status", "total_seconds", "compile_seconds",
+          "run_seconds"]
+
+
+def literal(value):
+    """Formats a value as a DaphneDSL literal of a script argument."""
+    if isinstance(value, bool):
+        return "true" if value else "false"
+    if isinstance(value, (int, float)):
+        return repr(value)
+    for parse in (int, float):
+        try:
+            return repr(parse(value))
+        except ValueError:
+            pass
+    return '"' + value + '"'
+
+
+def substitute(value, variables):
+    """Replaces the placeholders like {rows} in a string value of workloads.json."""
+    return value.format(**variables) if isinstance(value, str) else value
+
+
+def script_args(args, variables):
+    return [f"{name}={literal(substitute(value, variables))}" for name, value in args.items()]
+
+
+def scaled_sizes(workload, scale):
+    return {name: max(1, int(round(size * scale))) for name, size in workload["sizes"].items()}
+
+
+def generate_data(daphne, workload, sizes, data_dir):
+    """Generates the input matrix of a workload (once per size), returning its path."""
+    spec = {name: substitute(value, sizes) for name, value in workload["data"].items()}
+    path = os.path.join(data_dir, "data-{rows}x{cols}-{classes}.csv".format(**spec))
+    if not os.path.exists(path + ".meta"):
+        args = script_args(spec, sizes) + [f'out="{path}"']
+        print(f"generating {path}", file=sys.stderr)
+        subprocess.run([daphne, os.path.join(WORKLOADS_DIR, "gen-data.daph")] + args, check=True,
+                       stdout=subprocess.DEVNULL)
+    return path
+
+
+def run_once(daphne, workload, config_options, threads, variables, timeout):
+    """Runs a workload once, returning its status and its total, compile, and run time in seconds."""
+    with tempfile.TemporaryDirectory() as tmp:
+        statistics_file = os.path.join(tmp, "statistics.json")
+        cmd = [daphne] + config_options + [f"--num-threads={threads}", f"--statistics-json={statistics_file}",
+                                           workload["script"]]
+        cmd += script_args(workload["args"], dict(variables, out=tmp))
+        begin = time.perf_counter()
+        try:
+            proc = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, timeout=timeout,
+                                  universal_newlines=True)
+        except subprocess.TimeoutExpired:
+            return "timeout", None, None, None
+        total = time.perf_counter() - begin
+        if proc.returncode != 0:
+            print(f"failed ({proc.returncode}): {' '.join(cmd)}\n{proc.stderr}", file=sys.stderr)
+            return f"error {proc.returncode}", total, None, None
+        # the compile time are the compiler passes and the JIT compilation, the rest (mainly the execution of the
+        # program, besides starting daphne and parsing the script) counts as run time
+        with open(statistics_file) as f:
+            stats = json.load(f)
+        compile_seconds = stats["passSeconds"] + stats["jit"]["seconds"]
+        return "ok", total, compile_seconds, total - compile_seconds
+
+
+def sweep(args):
+    """Returns the (scale, threads) pairs of the runs, for strong scaling all pairs of the given scales and numbers
+    of threads, for weak scaling each scale grows with the number of threads."""
+    pairs = []
+    for scale in args.scales:
+        for threads in args.threads:
+            if args.mode in ("strong", "both"):
+                pairs.append((scale, threads))
+            if args.mode in ("weak", "both"):
+                pairs.append((scale * threads / args.threads[0], threads))
+    return sorted(set(pairs))
+
+
+def run(args):
+    with open(args.workloads_file) as f:
+        definitions = json.load(f)
+    workloads = args.workloads or list(definitions["workloads"])
+    configs = {name: definitions["configs"][name] for name in args.configs}
+    if "distributed" in configs and not os.environ.get("DISTRIBUTED_WORKERS"):
+        sys.exit("the configuration 'distributed' requires the addresses of running workers in DISTRIBUTED_WORKERS")
+    os.makedirs(args.out_dir, exist_ok=True)
+    data_dir = os.path.join(args.out_dir, "data")
+    os.makedirs(data_dir, exist_ok=True)
+
+    results = []
+    csv_path = os.path.join(args.out_dir, "results.csv")
+    with open(csv_path, "w", newline="") as csv_file:
+        writer = csv.DictWriter(csv_file, fieldnames=FIELDS)
+        writer.writeheader()
+        for name in workloads:
+            workload = definitions["workloads"][name]
+            for scale, threads in sweep(args):
+                variables = scaled_sizes(workload, scale)
+                if "data" in workload:
+                    variables["data"] = generate_data(args.daphne, workload, variables, data_dir)
+                for config, options in configs.items():
+                    for repetition in range(args.repetitions):
+                        status, total, compile_seconds, run_seconds = run_once(
+                            args.daphne, workload, options, threads, variables, args.timeout)
+                        result = dict(workload=name, config=config, scale=scale, threads=threads,
+                                      repetition=repetition, status=status, total_seconds=total,
+                                      compile_seconds=compile_seconds, run_seconds=run_seconds)
+                        print(f"{name:12} {config:20} scale {scale:<6g} threads {threads:<4} {status:8} "
+                              + (f"total {total:.3f} s, compile {compile_seconds:.3f} s" if status == "ok" else ""))
+                        writer.writerow(result)
+                        csv_file.flush()
+                        results.append(result)
+
+    with open(os.path.join(args.out_dir, "results.json"), "w") as f:
+        json.dump({"daphne": args.daphne, "mode": args.mode, "results": results}, f, indent=2)
+    print(f"results written to {csv_path} and results.json", file=sys.stderr)
+    if args.plot:
+        plot(results, args)
+
+
+def median_run_seconds(results):
+    """The median run time per (workload, config, scale, threads) of the successful runs."""
+    times = {}
+    for r in results:
+        if r["status"] == "ok":
+            times.setdefault((r["workload"], r["config"], r["scale"], r["threads"]), []).append(r["run_seconds"])
+    return {key: statistics.median(values) for key, values in times.items()}
+
+
+def plot(results, args):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("plotting requires matplotlib", file=sys.stderr)
+        return
+    medians = median_run_seconds(results)
+    base_threads = args.threads[0]
+    for workload in sorted({key[0] for key in medians}):
+        fig, (strong, weak) = plt.subplots(1, 2, figsize=(12, 4.5))
+        for config in sorted({key[1] for key in medians if key[0] == workload}):
+            # strong scaling: the speedup over the fewest threads for a fixed scale
+            for scale in args.scales:
+                points = [(t, medians.get((workload, config, scale, t))) for t in args.threads]
+                base = medians.get((workload, config, scale, base_threads))
+                points = [(t, base / s) for t, s in points if s and base]
+                if len(points) > 1:
+                    strong.plot(*zip(*points), marker="o", label=f"{config}, scale {scale:g}")
+            # weak scaling: the efficiency if the scale grows with the number of threads
+            for scale in args.scales:
+                points = [(t, medians.get((workload, config, scale * t / base_threads, t))) for t in args.threads]
+                base = medians.get((workload, config, scale, base_threads))
+                points = [(t, base / s) for t, s in points if s and base]
+                if len(points) > 1:
+                    weak.plot(*zip(*points), marker="o", label=f"{config}, scale {scale:g}")
+        strong.plot(args.threads, [t / base_threads for t in args.threads], "k--", linewidth=0.8, label="ideal")
+        strong.set(title=f"{workload}: strong scaling", xlabel="threads", ylabel="speedup of the run time")
+        weak.axhline(1.0, color="k", linestyle="--", linewidth=0.8, label="ideal")
+        weak.set(title=f"{workload}: weak scaling", xlabel="threads", ylabel="efficiency of the run time")
+        for ax in (strong, weak):
+            ax.set_xscale("log", base=2)
+            ax.legend(fontsize="small")
+        fig.tight_layout()
+        path = os.path.join(args.out_dir, f"scaling-{workload}.png")
+        fig.savefig(path)
+        plt.close(fig)
+        print(f"plot written to {path}", file=sys.stderr)
+
+
+def comma_list(parse):
+    return lambda value: [parse(v) for v in value.split(",") if v]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--daphne", default="build/bin/daphne", help="the daphne executable")
+    parser.add_argument("--workloads-file", default=os.path.join(WORKLOADS_DIR, "workloads.json"),
+                        help="the definitions of the workloads and configurations")
+    parser.add_argument("--workloads", type=comma_list(str), help="the workloads to run (default: all)")
+    parser.add_argument("--configs", type=comma_list(str), default=["scalar", "vec"],
+                        help="the configurations of daphne to run (default: scalar,vec)")
+    parser.add_argument("--scales", type=comma_list(float), default=[1.0],
+                        help="the scale factors of the data sizes (default: 1)")
+    parser.add_argument("--threads", type=comma_list(int), default=[1, 2, 4, 8],
+                        help="the numbers of threads (default: 1,2,4,8)")
+    parser.add_argument("--mode", choices=["strong", "weak", "both"], default="strong",
+                        help="strong scaling runs each scale with each number of threads, weak scaling multiplies "
+                             "the scale by the number of threads relative to the first one")
+    parser.add_argument("--repetitions", type=int, default=3, help="the runs per combination (default: 3)")
+    parser.add_argument("--timeout", type=float, default=3600, help="the timeout of a run in seconds")
+    parser.add_argument("--out-dir", default="benchmark-results", help="the directory of the results and data")
+    parser.add_argument("--plot", action="store_true", help="plot the strong and weak scaling (needs matplotlib)")
+    args = parser.parse_args()
+    args.threads = sorted(args.threads)
+    run(args)
+
+
+if __name__ == "__main__":
+    main()
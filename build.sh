@@ -42,6 +42,8 @@ function printHelp {
     echo "  -nf, --no-fancy   Suppress all colored and animated output"
     echo "  -y, --yes         Accept all prompts"
     echo "  --arrow           Compile with support for Arrow/Parquet files"
+    echo "  --mpi             Compile with the MPI backend of the distributed runtime"
+    echo "  --benchmarks      Compile the microbenchmarks (target run_benchmarks) with Google Benchmark"
 }
 
 #******************************************************************************
@@ -284,6 +286,7 @@ function cleanBuildDirs() {
       "${thirdpartyPath}/openBlas_v"*".install.success" \
       "${thirdpartyPath}/llvm_v"*".install.success" \
       "${thirdpartyPath}/arrow_v"*".install.success" \
+      "${thirdpartyPath}/benchmark_v"*".install.success" \
       "${llvmCommitFilePath}")
     
     clean dirs files
@@ -308,6 +311,8 @@ function cleanAll() {
       "${thirdpartyPath}/llvm_v"*".install.success" \
       "${thirdpartyPath}/arrow_v"*".install.success" \
       "${thirdpartyPath}/arrow_v"*".download.success" \
+      "${thirdpartyPath}/benchmark_v"*".install.success" \
+      "${thirdpartyPath}/benchmark_v"*".download.success" \
       "${llvmCommitFilePath}")
 
     clean dirs files
@@ -347,6 +352,7 @@ abslVersion=20211102.0
 grpcVersion=1.38.0
 nlohmannjsonVersion=3.10.5
 arrowVersion=d9d78946607f36e25e9d812a5cc956bd00ab2bc9
+benchmarkVersion=1.7.1
 
 #******************************************************************************
 # Set some prefixes, paths and dirs
@@ -381,6 +387,8 @@ par_acceptAll="0"
 unknown_options=""
 BUILD_CUDA="-DUSE_CUDA=OFF"
 BUILD_ARROW="-DUSE_ARROW=OFF"
+BUILD_MPI="-DUSE_MPI=OFF"
+BUILD_BENCHMARKS="-DUSE_BENCHMARKS=OFF"
 BUILD_FPGAOPENCL="-DUSE_FPGAOPENCL=OFF"
 BUILD_DEBUG="-DCMAKE_BUILD_TYPE=Release"
 
@@ -415,6 +423,14 @@ while [[ $# -gt 0 ]]; do
             echo using ARROW
             BUILD_ARROW="-DUSE_ARROW=ON"
             ;;
+        --mpi)
+            echo using MPI
+            BUILD_MPI="-DUSE_MPI=ON"
+            ;;
+        --benchmarks)
+            echo using Google Benchmark
+            BUILD_BENCHMARKS="-DUSE_BENCHMARKS=ON"
+            ;;
         --fpgaopencl)
             echo using FPGAOPENCL
             export BUILD_FPGAOPENCL="-DUSE_FPGAOPENCL=ON"
@@ -668,6 +684,29 @@ if [[ "$BUILD_ARROW" == "-DUSE_ARROW=ON" ]]; then
     fi
 fi
 
+#------------------------------------------------------------------------------
+# Google Benchmark (microbenchmark framework)
+#------------------------------------------------------------------------------
+benchmarkDirName="benchmark"
+if [[ "$BUILD_BENCHMARKS" == "-DUSE_BENCHMARKS=ON" ]]; then
+    if ! is_dependency_downloaded "benchmark_v${benchmarkVersion}"; then
+        daphne_msg "Get Google Benchmark version ${benchmarkVersion}"
+        rm -rf "${sourcePrefix:?}/${benchmarkDirName}"
+        git clone --depth 1 --branch "v${benchmarkVersion}" https://github.com/google/benchmark.git \
+            "${sourcePrefix}/${benchmarkDirName}"
+        dependency_download_success "benchmark_v${benchmarkVersion}"
+    fi
+    if ! is_dependency_installed "benchmark_v${benchmarkVersion}"; then
+        cmake -G Ninja -S "${sourcePrefix}/${benchmarkDirName}" -B "${buildPrefix}/${benchmarkDirName}" \
+            -DCMAKE_INSTALL_PREFIX="${installPrefix}" -DCMAKE_BUILD_TYPE=Release \
+            -DBENCHMARK_ENABLE_TESTING=OFF -DBENCHMARK_ENABLE_GTEST_TESTS=OFF
+        cmake --build "${buildPrefix}/${benchmarkDirName}" --target install
+        dependency_install_success "benchmark_v${benchmarkVersion}"
+    else
+        daphne_msg "No need to build Google Benchmark again."
+    fi
+fi
+
 #------------------------------------------------------------------------------
 # Build MLIR
 #------------------------------------------------------------------------------
@@ -724,7 +763,7 @@ fi
 
 daphne_msg "Build Daphne"
 
-cmake -S "$projectRoot" -B "$daphneBuildDir" -G Ninja $BUILD_CUDA $BUILD_ARROW $BUILD_FPGAOPENCL  $BUILD_DEBUG \
+cmake -S "$projectRoot" -B "$daphneBuildDir" -G Ninja $BUILD_CUDA $BUILD_ARROW $BUILD_MPI $BUILD_BENCHMARKS $BUILD_FPGAOPENCL  $BUILD_DEBUG \
   -DCMAKE_PREFIX_PATH="$installPrefix" -DANTLR_VERSION="$antlrVersion"  \
   -DMLIR_DIR="$buildPrefix/$llvmName/lib/cmake/mlir/" \
   -DLLVM_DIR="$buildPrefix/$llvmName/lib/cmake/llvm/"
@@ -0,0 +1,380 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneServer.h>
+#include <api/cli/StatusCode.h>
+#include <compiler/execution/ParsedIrCache.h>
+#include <parser/daphnedsl/DaphneDSLParser.h>
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "llvm/Support/Error.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    // the output of the request executed by this thread, see DaphneUserConfig::print_stream
+    thread_local std::ostringstream * requestOut = nullptr;
+    thread_local std::ostringstream * requestErr = nullptr;
+    // the control of the request executed by this thread, see DaphneUserConfig::run_control
+    thread_local std::shared_ptr<RunControl> requestControl;
+
+    // how often a client tries to connect to a server that is still starting, every 100 ms
+    const int CONNECT_ATTEMPTS = 100;
+
+    DaphneUserConfig getServerConfig(DaphneUserConfig cfg) {
+        cfg.print_stream = [](bool err) -> std::ostream * { return err ? requestErr : requestOut; };
+        cfg.run_control = []() { return requestControl; };
+        cfg.persistent_worker_pool = true;
+        cfg.cache_reads = true;
+        // The remainders after adaptive checkpoints would be compiled at run-time with the MLIR context of the
+        // executor, concurrently with the compilation of other requests.
+        cfg.adaptive_execution = false;
+        return cfg;
+    }
+
+    nlohmann::json makeResponse(int status, const std::string & out, const std::string & err) {
+        return {{"status", status}, {"out", out}, {"err", err}};
+    }
+
+    sockaddr_un getSocketAddress(const std::string & socketPath) {
+        sockaddr_un addr{};
+        if(socketPath.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("the socket path is too long: " + socketPath);
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        return addr;
+    }
+
+    bool writeLine(int fd, const nlohmann::json & message) {
+        // invalid UTF-8 in the output of a script is replaced instead of failing the response
+        const std::string line = message.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) + "\n";
+        size_t written = 0;
+        while(written < line.size()) {
+            const ssize_t n = send(fd, line.data() + written, line.size() - written, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                return false;
+            written += n;
+        }
+        return true;
+    }
+
+    // reads the next line into line, keeping the bytes after it in buffer
+    bool readLine(int fd, std::string & buffer, std::string & line) {
+        char chunk[4096];
+        size_t pos;
+        while((pos = buffer.find('\n')) == std::string::npos) {
+            const ssize_t n = read(fd, chunk, sizeof(chunk));
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                return false;
+            buffer.append(chunk, n);
+        }
+        line = buffer.substr(0, pos);
+        buffer.erase(0, pos + 1);
+        return true;
+    }
+}
+
+DaphneServer::DaphneServer(bool selectMatrixRepresentations, const DaphneUserConfig & cfg)
+        : userConfig_(getServerConfig(cfg)), executor_(selectMatrixRepresentations, userConfig_),
+          jitCache_(userConfig_.jit_cache_dir) {
+}
+
+std::shared_ptr<JitProgram> DaphneServer::getProgram(const std::string & scriptPath,
+                                                     const std::unordered_map<std::string, std::string> & scriptArgs,
+                                                     int & status, std::ostream & err)
+{
+    std::lock_guard<std::mutex> lock(compileMtx_);
+
+    const std::string key = ParsedIrCache::computeKey(scriptPath, scriptArgs, userConfig_);
+    auto it = programs_.find(key);
+    if(it != programs_.end()) {
+        const auto & deps = it->second.dependencies;
+        if(std::all_of(deps.begin(), deps.end(), [](const std::pair<std::string, std::string> & dep) {
+            return ParsedIrCache::getFileStamp(dep.first) == dep.second;
+        }))
+            return it->second.program;
+        programs_.erase(it);
+    }
+
+    mlir::OpBuilder builder(executor_.getContext());
+    auto loc = mlir::FileLineColLoc::get(builder.getIdentifier(scriptPath), 0, 0);
+    mlir::OwningModuleRef moduleOp(mlir::ModuleOp::create(loc));
+    auto * body = moduleOp->getBody();
+    builder.setInsertionPoint(body, body->begin());
+
+    DaphneDSLParser parser(scriptArgs, userConfig_);
+    try {
+        parser.parseFile(builder, scriptPath);
+    }
+    catch(std::exception & e) {
+        err << "Parser error: " << e.what() << std::endl;
+        status = StatusCode::PARSER_ERROR;
+        return nullptr;
+    }
+
+    std::vector<std::string> dependencies;
+    try {
+        // The diagnostics of the passes are written to the standard error of the server.
+        if(!executor_.runSimplificationPasses(*moduleOp)) {
+            err << "Pass error: see the output of the server" << std::endl;
+            status = StatusCode::PASS_ERROR;
+            return nullptr;
+        }
+        dependencies = ParsedIrCache::getDependencies(*moduleOp, scriptPath, parser.getImportedFiles());
+        if(!executor_.runLoweringPasses(*moduleOp)) {
+            err << "Pass error: see the output of the server" << std::endl;
+            status = StatusCode::PASS_ERROR;
+            return nullptr;
+        }
+    }
+    catch(std::exception & e) {
+        err << "Pass error: " << e.what() << std::endl;
+        status = StatusCode::PASS_ERROR;
+        return nullptr;
+    }
+
+    std::shared_ptr<JitProgram> program;
+    try {
+        program = executor_.createJitProgram(*moduleOp, "main", jitCache_);
+    }
+    catch(std::exception & e) {
+        err << "Execution error: " << e.what() << std::endl;
+    }
+    if(!program) {
+        status = StatusCode::EXECUTION_ERROR;
+        return nullptr;
+    }
+
+    CompiledScript & compiled = programs_[key];
+    compiled.program = program;
+    for(const std::string & dependency : dependencies)
+        compiled.dependencies.emplace_back(dependency, ParsedIrCache::getFileStamp(dependency));
+    return program;
+}
+
+nlohmann::json DaphneServer::run(const std::string & scriptPath,
+                                 const std::unordered_map<std::string, std::string> & scriptArgs,
+                                 const std::string & id, double timeoutSeconds)
+{
+    auto control = std::make_shared<RunControl>();
+    if(timeoutSeconds > 0)
+        control->setTimeout(timeoutSeconds);
+    if(!id.empty()) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if(!running_.emplace(id, control).second)
+            return makeResponse(StatusCode::PARSER_ERROR, "", "Invalid request: the id '" + id + "' is in use\n");
+    }
+
+    std::ostringstream out;
+    std::ostringstream err;
+    int status = StatusCode::SUCCESS;
+    std::shared_ptr<JitProgram> program = getProgram(scriptPath, scriptArgs, status, err);
+    if(program) {
+        requestOut = &out;
+        requestErr = &err;
+        requestControl = control;
+        try {
+            if(auto error = program->invoke("main")) {
+                err << "JIT-Engine invocation failed: " << llvm::toString(std::move(error)) << std::endl;
+                status = StatusCode::EXECUTION_ERROR;
+            }
+        }
+        catch(std::exception & e) {
+            err << "Execution error: " << e.what() << std::endl;
+            status = StatusCode::EXECUTION_ERROR;
+        }
+        requestOut = nullptr;
+        requestErr = nullptr;
+        requestControl = nullptr;
+    }
+    if(!id.empty()) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_.erase(id);
+    }
+    return makeResponse(status, out.str(), err.str());
+}
+
+nlohmann::json DaphneServer::handle(const nlohmann::json & request)
+{
+    if(!request.is_object())
+        return makeResponse(StatusCode::PARSER_ERROR, "", "Invalid request: not a JSON object\n");
+    try {
+        if(request.contains("shutdown")) {
+            shutdown_ = true;
+            // wakes up the thread accepting the connections
+            if(listenFd_ >= 0)
+                ::shutdown(listenFd_, SHUT_RDWR);
+            return makeResponse(StatusCode::SUCCESS, "", "");
+        }
+        if(request.contains("cancel") || request.contains("progress")) {
+            const bool cancel = request.contains("cancel");
+            const std::string id = request.at(cancel ? "cancel" : "progress").get<std::string>();
+            std::shared_ptr<RunControl> control;
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                auto it = running_.find(id);
+                if(it != running_.end())
+                    control = it->second;
+            }
+            if(!control)
+                return makeResponse(StatusCode::PARSER_ERROR, "", "Invalid request: no running request '" + id + "'\n");
+            if(cancel)
+                control->cancel();
+            nlohmann::json response = makeResponse(StatusCode::SUCCESS, "", "");
+            const RunControl::Progress progress = control->getProgress();
+            response["progress"] = {{"pipelines", progress.numPipelines}, {"pipelineRows", progress.pipelineRows},
+                    {"pipelineRowsDone", progress.pipelineRowsDone}, {"totalRowsDone", progress.totalRowsDone},
+                    {"cancelled", progress.cancelled}};
+            return response;
+        }
+        if(request.contains("register")) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            functions_[request.at("register").get<std::string>()] = request.at("script").get<std::string>();
+            return makeResponse(StatusCode::SUCCESS, "", "");
+        }
+
+        std::unordered_map<std::string, std::string> scriptArgs;
+        if(request.contains("args"))
+            for(auto & arg : request.at("args").items())
+                scriptArgs[arg.key()] = arg.value().is_string() ? arg.value().get<std::string>() : arg.value().dump();
+
+        std::string scriptPath;
+        if(request.contains("function")) {
+            const std::string name = request.at("function").get<std::string>();
+            std::lock_guard<std::mutex> lock(mtx_);
+            auto it = functions_.find(name);
+            if(it == functions_.end())
+                return makeResponse(StatusCode::PARSER_ERROR, "", "Invalid request: unknown function '" + name + "'\n");
+            scriptPath = it->second;
+        }
+        else
+            scriptPath = request.at("script").get<std::string>();
+        return run(scriptPath, scriptArgs, request.value("id", std::string()), request.value("timeout", 0.0));
+    }
+    catch(nlohmann::json::exception & e) {
+        return makeResponse(StatusCode::PARSER_ERROR, "", std::string("Invalid request: ") + e.what() + "\n");
+    }
+}
+
+void DaphneServer::serveConnection(int fd)
+{
+    std::string buffer;
+    std::string line;
+    while(readLine(fd, buffer, line)) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if(shutdown_)
+                break;
+            numRunning_++;
+        }
+        const bool written = writeLine(fd, handle(nlohmann::json::parse(line, nullptr, false)));
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            numRunning_--;
+            cv_.notify_all();
+        }
+        if(!written)
+            break;
+    }
+    close(fd);
+}
+
+int DaphneServer::serve(const std::string & socketPath)
+{
+    sockaddr_un addr;
+    try {
+        addr = getSocketAddress(socketPath);
+    }
+    catch(std::exception & e) {
+        std::cerr << "Server error: " << e.what() << std::endl;
+        return StatusCode::EXECUTION_ERROR;
+    }
+    // the socket of a server that was not shut down
+    unlink(socketPath.c_str());
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listenFd_ < 0 || bind(listenFd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+            || listen(listenFd_, SOMAXCONN) != 0) {
+        std::cerr << "Server error: cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        return StatusCode::EXECUTION_ERROR;
+    }
+
+    while(!shutdown_) {
+        const int fd = accept(listenFd_, nullptr, nullptr);
+        if(fd < 0) {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+        std::thread(&DaphneServer::serveConnection, this, fd).detach();
+    }
+    close(listenFd_);
+    unlink(socketPath.c_str());
+
+    // The requests still running are finished, the idle connections are dropped.
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this]() { return numRunning_ == 0; });
+    if(!shutdown_) {
+        std::cerr << "Server error: cannot accept connections: " << std::strerror(errno) << std::endl;
+        return StatusCode::EXECUTION_ERROR;
+    }
+    return StatusCode::SUCCESS;
+}
+
+nlohmann::json DaphneServer::sendRequest(const std::string & socketPath, const nlohmann::json & request)
+{
+    const sockaddr_un addr = getSocketAddress(socketPath);
+    int fd = -1;
+    for(int attempt = 1; ; attempt++) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0)
+            throw std::runtime_error(std::string("cannot create a socket: ") + std::strerror(errno));
+        if(connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0)
+            break;
+        const int error = errno;
+        close(fd);
+        // A server that is still starting has not bound its socket yet.
+        if((error != ENOENT && error != ECONNREFUSED) || attempt == CONNECT_ATTEMPTS)
+            throw std::runtime_error("cannot connect to the daphne server at " + socketPath + ": "
+                    + std::strerror(error));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::string buffer;
+    std::string line;
+    const bool ok = writeLine(fd, request) && readLine(fd, buffer, line);
+    close(fd);
+    if(!ok)
+        throw std::runtime_error("the daphne server at " + socketPath + " closed the connection");
+    return nlohmann::json::parse(line);
+}
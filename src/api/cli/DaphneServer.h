@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_API_CLI_DAPHNESERVER_H
+#define SRC_API_CLI_DAPHNESERVER_H
+
+#pragma once
+
+#include <api/cli/DaphneUserConfig.h>
+#include <compiler/execution/DaphneIrExecutor.h>
+#include <compiler/execution/JitObjectCache.h>
+#include <runtime/local/context/RunControl.h>
+
+#include <nlohmannjson/json.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A long-running daphne process, which executes the DaphneDSL scripts
+ * of the requests sent to it over a UNIX domain socket (see `daphne --serve`
+ * and `daphne --connect`), such that the start-up of the runtime, the
+ * compilation of the scripts, and the reads of unchanged files (e.g., models)
+ * are paid once instead of per run.
+ *
+ * Each request and each response is a JSON object on a line of its own:
+ * - `{"script": path, "args": {name: value, ...}}` runs the script with the
+ *   given script arguments,
+ * - `{"register": name, "script": path}` registers the script as a function
+ *   of the given name,
+ * - `{"function": name, "args": {...}}` runs the script registered as the
+ *   function of the given name, and
+ * - `{"cancel": id}` cancels the running request of the given id,
+ * - `{"progress": id}` returns the progress of the running request of the
+ *   given id (see `RunControl::Progress`) as `"progress"`, and
+ * - `{"shutdown": true}` stops the server after the running requests.
+ *
+ * A request running a script may have an `"id"` (a string), by which other
+ * connections refer to it while it runs, and a time limit in seconds as
+ * `"timeout"`, which takes precedence over the one of the server.
+ *
+ * The response has the status code of the request (see `StatusCode`) and
+ * what the script printed to standard output and standard error, as
+ * `{"status": code, "out": ..., "err": ...}`.
+ *
+ * Every connection is served by a thread of its own and may send requests one
+ * after another, and the requests of different connections are executed
+ * concurrently. The compilation of the scripts is serialized, since it uses
+ * one MLIR context. The compiled programs are kept in memory by the path of
+ * the script and its arguments (which are constants of the compiled code)
+ * and are used as long as the script, its imports, and the files read at
+ * compile time are unchanged (see `ParsedIrCache`). All requests share the
+ * worker pool of the vectorized engine and the data objects read from files
+ * (see `ReadCache`).
+ */
+class DaphneServer {
+    struct CompiledScript {
+        std::shared_ptr<JitProgram> program;
+        // the files the program was compiled from, with their stamps at that time
+        std::vector<std::pair<std::string, std::string>> dependencies;
+    };
+
+    DaphneUserConfig userConfig_;
+    std::mutex compileMtx_;
+    DaphneIrExecutor executor_;
+    JitObjectCache jitCache_;
+    std::map<std::string, CompiledScript> programs_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, std::string> functions_;
+    // the controls of the running requests by their ids
+    std::unordered_map<std::string, std::shared_ptr<RunControl>> running_;
+    size_t numRunning_ = 0;
+    std::atomic<bool> shutdown_{false};
+    int listenFd_ = -1;
+
+    /**
+     * @brief Returns the program compiled from the given script and
+     * arguments, compiling it if needed, or `nullptr` after writing the
+     * errors to `err`.
+     */
+    std::shared_ptr<JitProgram> getProgram(const std::string & scriptPath,
+                                           const std::unordered_map<std::string, std::string> & scriptArgs,
+                                           int & status, std::ostream & err);
+
+    nlohmann::json run(const std::string & scriptPath, const std::unordered_map<std::string, std::string> & scriptArgs,
+                       const std::string & id, double timeoutSeconds);
+
+    void serveConnection(int fd);
+
+public:
+    DaphneServer(bool selectMatrixRepresentations, const DaphneUserConfig & cfg);
+
+    DaphneServer(const DaphneServer &) = delete;
+    DaphneServer & operator=(const DaphneServer &) = delete;
+
+    /**
+     * @brief Serves the requests sent to the given socket until a shutdown
+     * request, and returns the status code of the server.
+     */
+    int serve(const std::string & socketPath);
+
+    /**
+     * @brief Handles one request and returns its response.
+     */
+    nlohmann::json handle(const nlohmann::json & request);
+
+    /**
+     * @brief Sends the given request to the server listening on the given
+     * socket and returns its response, waiting for a server that is still
+     * starting for a few seconds.
+     */
+    static nlohmann::json sendRequest(const std::string & socketPath, const nlohmann::json & request);
+};
+
+#endif //SRC_API_CLI_DAPHNESERVER_H
@@ -17,13 +17,19 @@
 
 #pragma once
 
+#include <runtime/local/context/AdaptiveExecution.h>
 #include <runtime/local/vectorized/LoadPartitioningDefs.h>
 
+#include <functional>
+#include <iosfwd>
 #include <vector>
 #include <string>
 #include <memory>
 #include <map>
 
+class RunControl;
+struct DaphneLibResult;
+
 /*
  * Container to pass around user configuration
  */
@@ -37,10 +43,94 @@ struct DaphneUserConfig {
     bool cuda_fuse_any = false;
     bool vectorized_single_queue = false;
     bool prePartitionRows = false;
+    bool nnzBalancedPartitioning = false;
     bool pinWorkers = false;
+    bool numaAware = false;
     bool hyperthreadingEnabled = false;
     bool debugMultiThreading = false;
+    bool useWorkerPool = true;
+    bool cudaStreamPipelining = false;
+    // the precision of the CUDA matrix multiplications and DNN ops on FP32 data: "default" (FP32), "tf32" (tensor
+    // cores with TF32 inputs), or "fp16"/"bf16" (inputs rounded to half precision, accumulated in FP32)
+    std::string cuda_precision = "default";
+    // the static factor the inputs are scaled by before rounding them to FP16/BF16 (and the results scaled back),
+    // to keep small values from flushing to zero
+    float cuda_loss_scale = 1;
+    // whether the kernels of each batch of a vectorized GPU pipeline are captured into a CUDA graph and launched as
+    // one, updating the graph of the same pipeline and shapes instead of instantiating a new one, see
+    // CUDAContext::runCaptured
+    bool cuda_graphs = false;
     bool use_fpgaopencl = false;
+    // use the vectorizable approximations of FastMath.h (within a few ULPs) in element-wise kernels
+    bool fast_math = false;
+    // the instruction set the hot kernels run their variants for at most ("auto" for the best one of the CPU), and
+    // whether the variants the kernels ran are reported at the end of the execution, see CpuDispatch
+    std::string cpu_isa = "auto";
+    bool cpu_dispatch_stats = false;
+    // the LLVM optimization level (0 to 3) of the JIT-compiled code, and whether it is tuned for the CPU (features)
+    // of the host, e.g., AVX2, AVX-512, or SVE, see DaphneIrExecutor::createExecutionEngine
+    int jit_opt_level = 2;
+    bool jit_native_target = true;
+    // the number of threads the compiler passes run the functions on and the JIT compiles them with (0 for all
+    // hardware threads, 1 for a sequential compilation), see DaphneIrExecutor::createJitProgram
+    int compile_threads = 0;
+    // report the time of each compiler pass and of the LLVM passes of the JIT
+    bool timing_passes = false;
+    // report the time of the phases of a run (initialization, parsing, compilation, loading the kernel libraries,
+    // JIT compilation, and execution), see daphne.cpp
+    bool timing_phases = false;
+    // report the time and the numbers of ops of each compiler pass, the numbers of vectorized pipelines, fused ops,
+    // and kernel calls, and the time of the JIT compilation, also as JSON to the file (if not empty), see
+    // CompileStatistics
+    bool compile_statistics = false;
+    std::string compile_statistics_file;
+    // whether each kernel call is timed and reported per source location of its DaphneDSL statement at the end of the
+    // execution, whether the cycles and last-level cache misses of the calls are counted, too, and the file of the
+    // calls as a Chrome trace (none if empty), see ProfileKernelsPass and KernelProfiler
+    bool profile_kernels = false;
+    bool profile_perf_counters = false;
+    std::string profile_trace_file;
+    // the peak double-precision GFLOP/s and memory bandwidth in GB/s of the machine, against which the profiled
+    // kernel calls with cost estimates are compared (estimated if not positive), see KernelProfiler::printRoofline
+    double machine_peak_gflops = 0;
+    double machine_peak_gbps = 0;
+    // the file of the scheduling trace of the vectorized pipelines, i.e., the tasks, steals, and waits of their
+    // workers as a Chrome trace (none if empty), whose summary per pipeline is printed, too, see SchedulingTrace
+    std::string vectorized_trace_file;
+    // tune the number of threads, the partitioning scheme, and the minimum task size of each vectorized pipeline
+    // signature on its first execution, persisting the choices in the profile file (none if empty), see Autotuner
+    bool vectorized_autotune = false;
+    std::string vectorized_autotune_profile;
+    // the directory of the object cache of the JIT-compiled code (none if empty), see JitObjectCache
+    std::string jit_cache_dir;
+    // the directory of the cache of the IR of scripts after parsing and simplification (none if empty), see
+    // ParsedIrCache
+    std::string parse_cache_dir;
+    // push the WHERE conjuncts of SQL queries below their joins, turn equalities into inner joins, order the joins by
+    // their estimated cardinalities, and drop unread columns early, see OptimizeSqlPass
+    bool sql_optimization = true;
+    // inline small DaphneDSL functions and functions called only once into their callers, see InlineFunctionsPass
+    bool function_inlining = true;
+    // rewrite matrix expressions to cheaper equivalent ones (e.g., reorder matrix multiplication chains), see
+    // AlgebraicSimplificationPass
+    bool algebraic_simplification = false;
+    // eliminate common subexpressions of side-effect-free DAPHNE ops and move loop invariants out of loops, see
+    // MatrixCSEPass and LoopInvariantCodeMotionPass
+    bool matrix_cse_licm = false;
+    // evaluate matrix expressions on compile-time constants with results of at most this many bytes at compile time
+    // (0 to disable), see FoldConstantMatricesPass
+    size_t constant_folding_max_bytes = size_t(256) << 10;
+    // rewrite for-loops over the rows of matrices without dependencies between their iterations into whole-matrix
+    // ops, see RewriteLoopsToMatrixOpsPass
+    bool loop_rewrite = true;
+    // fuse trees of elementwise ops and aggregations into ewFused kernel calls, see FuseEwiseOpsPass
+    bool fuse_ewise = false;
+    // the sparsity below which --select-matrix-repr represents a matrix as sparse, whether the representations are
+    // chosen by a cost model including the conversions between them, and whether the inferred sparsity is an upper
+    // bound instead of an estimate, see SelectMatrixRepresentationsPass and daphne::tryInferSparsity
+    double sparse_threshold = 0.1;
+    bool sparse_cost_model = false;
+    bool sparsity_worst_case = false;
 
     bool debug_llvm = false;
     bool explain_kernels = false;
@@ -52,16 +142,147 @@ struct DaphneUserConfig {
     bool explain_type_adaptation = false;
     bool explain_vectorized = false;
     bool explain_obj_ref_mgnt = false;
+    // print the estimated FLOPs and bytes of each DaphneDSL statement, see EstimateCostsPass
+    bool explain_cost = false;
+    // report the for-loops RewriteLoopsToMatrixOpsPass does not rewrite and why
+    bool explain_loops = false;
     SelfSchedulingScheme taskPartitioningScheme = STATIC;
     QueueTypeOption queueSetupScheme = CENTRALIZED;
 	victimSelectionLogic victimSelection = SEQPRI;
     int numberOfThreads = -1;
     int minimumTaskSize = 1;
+    // the maximum size of the value arrays of dropped data objects kept for reuse, see BufferPool.h
+    size_t buffer_pool_max_cached_bytes = size_t(512) << 20;
+    bool buffer_pool_stats = false;
+    // whether large value arrays are advised to be backed by transparent huge pages
+    bool buffer_pool_huge_pages = true;
+    // whether the live and peak memory of the data objects is tracked per allocation type and DaphneDSL statement and
+    // reported at the end of the execution, and the soft limit of the live bytes in main memory (0 for none), which
+    // implies tracking, see MemoryTracker and TrackMemoryPass
+    bool track_memory = false;
+    size_t memory_limit_bytes = 0;
+    // the bytes of values of dense matrices kept in main memory (0 for no limit), beyond which the least recently
+    // used ones are spilled to files in the directory (the temporary directory if empty) with the compression
+    // ("none" or "lz4"), see SpillManager
+    size_t spill_budget_bytes = 0;
+    std::string spill_dir = "";
+    std::string spill_compression = "none";
+    // the bytes of the results of expensive kernels kept for their reuse by later calls on the same inputs (0 to
+    // disable), see ReuseCache
+    size_t reuse_cache_bytes = 0;
+    // whether matrices in Daphne binary files are mapped into memory instead of being copied, see ReadDaphne.h
+    bool mmap_daphne_files = false;
+    // the rows per block of dense matrices written to Daphne binary files (0 for a single body) and the compression
+    // of the blocks ("none", "zlib", or "lz4"), see DF_options
+    size_t daphne_file_block_rows = 0;
+    std::string daphne_file_compression = "none";
+    // the directory the ranges and local copies of files read from object stores (s3://, http://, https://) are
+    // cached in (none if empty), keyed by their ETags, and the parallel GETs of a read, see ObjectStore
+    std::string object_store_cache = "";
+    size_t object_store_connections = 8;
+    // whether vectorized pipelines read the matrices of fused reads of CSV and Daphne binary files in chunks of rows
+    // (0 rows per chunk for about 16 MiB of values), see MTWrapper::executeStreaming
+    bool vectorized_stream_read = false;
+    size_t vectorized_stream_chunk_rows = 0;
+    // the size from which the dense broadcast inputs of vectorized pipelines with pinned workers are copied to every
+    // NUMA node, such that the workers read them from local memory (0 to disable), see BroadcastReplicas
+    size_t numa_replicate_broadcast_bytes = 0;
+    // whether the vectorized pipelines are formed by a cost model of their memory traffic instead of greedily, see
+    // VectorizeComputationsPass
+    bool vectorized_cost_model = false;
+    // whether files are read in the background ahead of their use, see PrefetchReadsPass
+    bool prefetch_reads = false;
+    // whether the statistics of the columns of the frames and dense matrices read from files are computed, by which
+    // comparisons skip blocks of rows and joins and group-bys of sorted keys merge, see ZoneMap
+    bool zone_maps = false;
+    // whether joins build hash indexes on the key columns of their smaller input and keep them with the frame for
+    // later joins and point filters, and whether the indexes are written next to and read from Daphne binary
+    // files, see KeyIndex
+    bool key_indexes = false;
+    // whether the probe sides of joins and semi-joins with a much smaller or filtered input are filtered by a Bloom
+    // filter of its keys as early as possible, and the rows of the larger inputs of distributed joins without a match
+    // are not sent to the workers, see PushDownBloomFiltersPass and BlockedBloomFilter
+    bool bloom_filters = false;
+    // whether the number of distinct values, the range, the fraction of missing values, and an equi-depth histogram of
+    // each column of the frames read from and written to files are kept in their meta data files, by which the
+    // compiler estimates the selectivities of filters and the sizes of joins, see ColumnStatistics
+    bool column_statistics = false;
+    // the backend of the distributed runtime, "gRPC" (the workers listen at the addresses in DISTRIBUTED_WORKERS) or
+    // "MPI" (the workers are the other ranks of the coordinator's MPI job), see DistributedContext
+    std::string distributed_backend = "gRPC";
+    // the approximate size of the chunks in which the distributed runtime streams the matrices to and from the
+    // workers (0 for one message per matrix), see DistributedGRPCCaller::asyncStoreStreamCall
+    size_t distributed_chunk_bytes = 1 << 20;
+    // the minimum number of workers from which broadcasts and sums of partial results pass through binomial trees
+    // of the workers instead of the coordinator (0 never), see WorkerImplGRPC::BroadcastGRPC
+    size_t distributed_collectives_min_workers = 8;
+    // the minimum number of rows of the inputs of joins and group-bys of frames computed at the distributed workers
+    // instead of the coordinator, and the maximum bytes of an input of a join broadcast to all workers instead of
+    // shuffling both inputs between them, see DistributedShuffle
+    size_t distributed_relational_min_rows = 1 << 16;
+    size_t distributed_broadcast_join_bytes = 1 << 24;
+    // whether the shares of the rows of the distributed workers follow their measured throughput, and the factor of
+    // the median time of the finished tasks of a pipeline after which a straggling task is also computed by an idle
+    // worker (0 never), see DistributedContext::rebalance and DistributedCompute
+    bool distributed_load_balancing = false;
+    double distributed_speculation_factor = 0;
+    // whether the distributed workers read the partitions of the matrices read from files (which they must be able
+    // to access, e.g., on a shared file system) that are only inputs of distributed pipelines themselves, see
+    // DistributedRead
+    bool distributed_read_at_workers = false;
+    // whether distributed pipelines run in the background in program order, while the coordinator continues with
+    // the next statements until it needs their results, see DistributedContext::submit
+    bool distributed_async = false;
+    // the compression of the matrices sent to the distributed workers ("none", "lz4", "zstd", or "adaptive"), which
+    // the workers use for the matrices they send according to their own config, see WireCompression
+    std::string distributed_compression = "none";
+    // the number of worker failures a program survives (0 for none), each of which excludes the worker and runs the
+    // failed pipeline again at the other ones, and the interval in milliseconds of the heartbeats by which failed
+    // workers are detected between pipelines (0 only after a failed pipeline), see DistributedContext::excludeWorker
+    size_t distributed_max_failures = 0;
+    size_t distributed_heartbeat_ms = 1000;
+    // the directory of the checkpoints of the state of the loops of the program (none if empty), from which a
+    // restarted program resumes, and the minimum number of seconds between two checkpoints, see CheckpointLoopsPass
+    std::string checkpoint_dir;
+    double checkpoint_interval_s = 600;
+    // whether the statistics of the distributed transfers are printed at the end of the execution
+    bool distributed_statistics = false;
+    // the port of the HTTP endpoint `/metrics` of a distributed worker in the text format of Prometheus (none if 0),
+    // see WorkerMetrics, and the file the coordinator and the workers append the spans of the traces of the jobs to
+    // (none if empty), see Tracing
+    size_t distributed_metrics_port = 0;
+    std::string distributed_trace_file;
+    // the keys of the user config overridden at the distributed workers for the tasks of this program, as a JSON
+    // object (none if empty), e.g., the number of threads of the vectorized engine, see WorkerImpl::Compute
+    std::string distributed_worker_config;
+    // whether main is split after reads, filters, and joins of unknown result shapes, such that the remainder is
+    // compiled for the actual shapes at run-time (see AdaptiveCheckpointsPass), and the compiler of the remainders,
+    // which is set by the DaphneIrExecutor
+    bool adaptive_execution = false;
+    AdaptiveCallFn adaptive_call;
+    // whether ops on tiny dense matrices of static shapes call kernels instantiated for these shapes, see
+    // MarkStaticShapeOpsPass
+    bool static_shape_kernels = false;
+    // the time limit of a run in seconds (none if 0), after which its vectorized pipelines stop and it fails, and the
+    // control of the runs by their host (see RunControl), e.g., to cancel the request of a client of the daphne
+    // server, which returns the control of the run of the calling thread (a new one for each context if not set)
+    double timeout_seconds = 0;
+    std::function<std::shared_ptr<RunControl>()> run_control;
+    // the following are set by the daphne server for the programs of its requests (see DaphneServer): the stream the
+    // print kernels write to instead of std::cout and std::cerr (if set), whether all contexts of the process share
+    // one worker pool, which outlives them (see WorkerPool::getOrCreate), and whether the data objects read from
+    // files are kept for the later reads of the unchanged files (see ReadCache)
+    std::function<std::ostream * (bool err)> print_stream;
+    bool persistent_worker_pool = false;
+    bool cache_reads = false;
+    // the results of a script run by DaphneLib, which are set by saveDaphneLibResult (see DaphneLib.h)
+    DaphneLibResult * result_struct = nullptr;
+    size_t num_result_structs = 0;
     
 #ifdef USE_CUDA
     // User config holds once context atm for convenience until we have proper system infrastructure
 
-    // CUDA device IDs (future work, as we create only one context atm)
+    // CUDA device IDs to create a context for (all visible devices if empty), the first one is the default device
     std::vector<int> cuda_devices;
 
     // ToDo: This is an arbitrary default taken from sample code
@@ -16,26 +16,34 @@
 
 #include <api/cli/StatusCode.h>
 #include <api/cli/DaphneUserConfig.h>
+#include <api/cli/DaphneServer.h>
 #include <parser/daphnedsl/DaphneDSLParser.h>
 #include "compiler/execution/DaphneIrExecutor.h"
 #include <runtime/local/vectorized/LoadPartitioning.h>
 #include <compiler/execution/DaphneIrExecutor.h>
+#include <compiler/execution/ParsedIrCache.h>
 #include <parser/config/ConfigParser.h>
 
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/PassManager.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 
 #ifdef USE_CUDA
     #include <runtime/local/kernels/CUDA/HostUtils.h>
 #endif
 
+#include <chrono>
 #include <exception>
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <cstdlib>
 #include <cstring>
@@ -65,9 +73,29 @@ void printVersion(llvm::raw_ostream& os) {
         << "https://github.com/daphne-eu/daphne\n";
 }
 
+void printPhaseTimes(const vector<pair<string, double>> & phases, llvm::raw_ostream & os) {
+    double total = 0;
+    os << "===== Phase times =====\n";
+    os << llvm::format("%10s  %s\n", "time [ms]", "phase");
+    for(auto & phase : phases) {
+        os << llvm::format("%10.3f  ", phase.second * 1e3) << phase.first << "\n";
+        total += phase.second;
+    }
+    os << llvm::format("%10.3f  ", total * 1e3) << "total\n";
+}
+
 int
 main(int argc, char** argv)
 {
+    // The time of each phase of the run, see --timing-phases.
+    vector<pair<string, double>> phaseTimes;
+    auto phaseStart = chrono::steady_clock::now();
+    auto endPhase = [&](const string & name) {
+        const auto end = chrono::steady_clock::now();
+        phaseTimes.emplace_back(name, chrono::duration<double>(end - phaseStart).count());
+        phaseStart = end;
+    };
+
     // ************************************************************************
     // Parse command line arguments
     // ************************************************************************
@@ -101,7 +129,9 @@ main(int argc, char** argv)
                 clEnumVal(PLS, "Performance loop-based self-scheduling"),
                 clEnumVal(MSTATIC, "Modified version of Static, i.e., instead of n/p, it uses n/(4*p) where n is number of tasks and p is number of threads"),
                 clEnumVal(MFSC, "Modified version of fixed size chunk self-scheduling, i.e., MFSC does not require profiling information as FSC"),
-                clEnumVal(PSS, "Probabilistic self-scheduling")
+                clEnumVal(PSS, "Probabilistic self-scheduling"),
+                clEnumVal(AWF, "Adaptive weighted factoring, i.e., factoring weighted by the measured speed of the workers"),
+                clEnumVal(AF, "Adaptive factoring, i.e., chunk sizes from the measured mean and variance of the task execution times")
             )
     );
     opt<QueueTypeOption> queueSetupScheme(
@@ -109,7 +139,8 @@ main(int argc, char** argv)
             values(
                 clEnumVal(CENTRALIZED, "One queue (default)"),
                 clEnumVal(PERGROUP, "One queue per CPU group"),
-                clEnumVal(PERCPU, "One queue per CPU core")
+                clEnumVal(PERCPU, "One queue per CPU core"),
+                clEnumVal(PERCPU_LOCKFREE, "One lock-free work-stealing deque per CPU core")
             )
     );
 	opt<victimSelectionLogic> victimSelection(
@@ -118,7 +149,8 @@ main(int argc, char** argv)
                 clEnumVal(SEQ, "Steal from next adjacent worker"),
                 clEnumVal(SEQPRI, "Steal from next adjacent worker, prioritize same NUMA domain"),
                 clEnumVal(RANDOM, "Steal from random worker"),
-				clEnumVal(RANDOMPRI, "Steal from random worker, prioritize same NUMA domain")
+				clEnumVal(RANDOMPRI, "Steal from random worker, prioritize same NUMA domain"),
+                clEnumVal(SEQLOCAL, "Steal from next adjacent worker of the same NUMA domain only")
             )
     );
 
@@ -143,10 +175,28 @@ main(int argc, char** argv)
         "distributed", cat(daphneOptions),
         desc("Enable distributed runtime")
     );
+    opt<string> distributedBackend(
+            "dist-backend", cat(daphneOptions),
+            desc("The backend of the distributed runtime: gRPC (default) or MPI, whose workers are the other ranks "
+                 "of the MPI job of daphne")
+    );
+    opt<string> checkpointDir(
+            "checkpoint-dir", cat(daphneOptions),
+            desc("The directory of the checkpoints of the state of the loops of the program, from which it resumes "
+                 "if it is run again, e.g., after a failure")
+    );
     opt<bool> prePartitionRows(
             "pre-partition", cat(schedulingOptions),
             desc("Partition rows into the number of queues before applying scheduling technique")
     );
+    opt<bool> nnzBalancedPartitioning(
+            "nnz-partitioning", cat(schedulingOptions),
+            desc("Partition sparse inputs by the number of non-zeros instead of the number of rows")
+    );
+    opt<bool> numaAware(
+            "numa-aware", cat(schedulingOptions),
+            desc("Keep the rows of a vectorized pipeline on the NUMA node that computes them")
+    );
     opt<bool> pinWorkers(
             "pin-workers", cat(schedulingOptions),
             desc("Pin workers to CPU cores")
@@ -159,6 +209,142 @@ main(int argc, char** argv)
             "debug-mt", cat(schedulingOptions),
             desc("Prints debug information about the Multithreading Wrapper")
     );
+    opt<string> vecTrace(
+            "vec-trace", cat(schedulingOptions),
+            desc("Record the tasks, steals, and waits of the workers of the vectorized pipelines, print a summary of "
+                 "each pipeline, and write them as a Chrome trace to the given file")
+    );
+    opt<bool> vecAutotune(
+            "vec-autotune", cat(schedulingOptions),
+            desc("Tune the number of threads, the partitioning scheme, and the grain size of each vectorized pipeline "
+                 "on its first execution by trying a few configurations on its first rows")
+    );
+    opt<string> vecAutotuneProfile(
+            "vec-autotune-profile", cat(schedulingOptions),
+            desc("Load the tuned configurations of the vectorized pipelines from the given file and add new ones to "
+                 "it, per machine topology (implies --vec-autotune)")
+    );
+    opt<bool> noWorkerPool(
+            "no-worker-pool", cat(schedulingOptions),
+            desc("Start and join fresh worker threads for every vectorized pipeline instead of reusing a persistent pool")
+    );
+    opt<long> bufferPoolMB(
+            "buffer-pool-mb", cat(daphneOptions), init(-1),
+            desc("The maximum size in MiB of the arrays of dropped matrices cached for reuse (0 disables the cache)")
+    );
+    opt<bool> bufferPoolStats(
+            "buffer-pool-stats", cat(daphneOptions),
+            desc("Print the statistics of the cache of matrix arrays (and of the spilling) at the end of the execution")
+    );
+    opt<bool> noHugePages(
+            "no-huge-pages", cat(daphneOptions),
+            desc("Do not back large matrix arrays by transparent huge pages")
+    );
+    opt<bool> trackMemory(
+            "track-memory", cat(daphneOptions),
+            desc("Track the live and peak memory of the data objects per allocation type and DaphneDSL statement "
+                 "and report it at the end of the execution")
+    );
+    opt<long> memoryLimitMB(
+            "memory-limit-mb", cat(daphneOptions), init(-1),
+            desc("A soft limit in MiB of the live data objects in main memory (implies --track-memory): when it is "
+                 "exceeded, the cached arrays are freed, and if that is not enough, the execution fails with a "
+                 "report of the statements holding the most memory")
+    );
+    opt<long> spillBudgetMB(
+            "spill-budget-mb", cat(daphneOptions), init(-1),
+            desc("The size in MiB of the values of dense matrices kept in main memory, beyond which the least "
+                 "recently used ones are spilled to disk and reloaded when they are accessed again (0 for no limit)")
+    );
+    opt<string> spillDir(
+            "spill-dir", cat(daphneOptions),
+            desc("The directory of the spill files, preferably on a local SSD (default: the temporary directory)")
+    );
+    opt<string> spillCompression(
+            "spill-compression", cat(daphneOptions),
+            desc("Compress the spill files: none or lz4")
+    );
+    opt<long> reuseCacheMB(
+            "reuse-cache-mb", cat(daphneOptions), init(-1),
+            desc("The size in MiB of the results of expensive kernels (e.g., matrix multiplications) kept for their "
+                 "reuse by later calls on the same inputs (0 disables the cache)")
+    );
+    opt<bool> mmapDaphneFiles(
+            "mmap-daphne-files", cat(daphneOptions),
+            desc("Map matrices in Daphne binary files (.dbdf) into memory instead of copying them")
+    );
+    opt<long> dbdfBlockRows(
+            "dbdf-block-rows", cat(daphneOptions), init(-1),
+            desc("Write dense matrices to Daphne binary files (.dbdf) as blocks of this many rows, which are "
+                 "checksummed and written and read in parallel (0 for a single body)")
+    );
+    opt<string> dbdfCompression(
+            "dbdf-compression", cat(daphneOptions),
+            desc("Compress the blocks of dense matrices in Daphne binary files (.dbdf): none, zlib, or lz4")
+    );
+    opt<string> objectStoreCache(
+            "object-store-cache", cat(daphneOptions),
+            desc("The directory the files read from object stores (s3://, http://, https://) are cached in, "
+                 "preferably on a local SSD, keyed by their ETags (default: no cache)")
+    );
+    opt<long> objectStoreConnections(
+            "object-store-connections", cat(daphneOptions), init(-1),
+            desc("The parallel ranged GETs of a read from an object store (default: 8)")
+    );
+    opt<bool> vecStreamRead(
+            "vec-stream-read", cat(schedulingOptions),
+            desc("Fuse reads of CSV and Daphne binary files into vectorized pipelines, which read them in chunks of "
+                 "rows instead of materializing the whole matrix (requires --vec)")
+    );
+    opt<long> vecStreamChunkRows(
+            "vec-stream-chunk-rows", cat(schedulingOptions), init(-1),
+            desc("The rows per chunk of the files read by vectorized pipelines (0 for about 16 MiB of values)")
+    );
+    opt<long> numaReplicateMB(
+            "numa-replicate-mb", cat(schedulingOptions), init(-1),
+            desc("Copy the dense broadcast inputs of at least this many MiB of vectorized pipelines with pinned "
+                 "workers (see --pin-workers and --numa-aware) to every NUMA node (0 to disable)")
+    );
+    opt<bool> vecCostModel(
+            "vec-cost-model", cat(schedulingOptions),
+            desc("Form vectorized pipelines by a cost model of their memory traffic, based on the inferred shapes "
+                 "and sparsity, instead of fusing greedily (requires --vec)")
+    );
+    opt<bool> prefetchReads(
+            "prefetch-reads", cat(daphneOptions),
+            desc("Start reading files in the background ahead of their use, such that reading overlaps the "
+                 "preceding computations")
+    );
+    opt<bool> zoneMaps(
+            "zone-maps", cat(daphneOptions),
+            desc("Compute the minimum, maximum, and sortedness of the blocks of the columns of the frames and matrices "
+                 "read from files, such that comparisons skip blocks and joins and group-bys on sorted keys merge")
+    );
+    opt<bool> keyIndexes(
+            "key-indexes", cat(daphneOptions),
+            desc("Build hash indexes on the key columns of the smaller inputs of joins and keep them for later joins "
+                 "and point filters on the same frames, and write and read them next to Daphne binary files")
+    );
+    opt<bool> bloomFilters(
+            "bloom-filters", cat(daphneOptions),
+            desc("Filter the larger inputs of joins by Bloom filters of the keys of much smaller or filtered inputs, "
+                 "pushed down to their scans or filters, and before they are sent to the distributed workers")
+    );
+    opt<bool> columnStatistics(
+            "column-statistics", cat(daphneOptions),
+            desc("Keep the number of distinct values, the range, and a histogram of each column of the frames read "
+                 "from and written to files in their meta data files, by which the compiler estimates the "
+                 "selectivities of filters and the sizes of joins")
+    );
+    opt<bool> cudaStreams(
+            "cuda-streams", cat(schedulingOptions),
+            desc("Overlap the host-device transfers of the GPU workers with their kernels using multiple CUDA streams")
+    );
+    opt<bool> cudaGraphs(
+            "cuda-graphs", cat(schedulingOptions),
+            desc("Capture the kernels of each batch of a vectorized GPU pipeline into a CUDA graph launched as one, "
+                 "which is updated for the next batches of the same pipeline and shapes")
+    );
     
     // Other options
     
@@ -180,18 +366,187 @@ main(int argc, char** argv)
             "select-matrix-representations", aliasopt(selectMatrixRepr),
             desc("Alias for --select-matrix-repr")
     );
+    opt<double> sparseThreshold(
+            "sparse-threshold", cat(daphneOptions), init(-1),
+            desc("The sparsity below which --select-matrix-repr represents a matrix as sparse (default 0.1)")
+    );
+    opt<bool> sparseCostModel(
+            "sparse-cost-model", cat(daphneOptions),
+            desc("Choose the matrix representations of --select-matrix-repr by a cost model that includes the "
+                 "conversions between them, such that chains of operations stay sparse or dense")
+    );
+    opt<bool> sparsityWorstCase(
+            "sparsity-worst-case", cat(daphneOptions),
+            desc("Infer upper bounds of the sparsity of matrices instead of estimates")
+    );
+    opt<bool> adaptive(
+            "adaptive", cat(daphneOptions),
+            desc("Compile the remainder of the program at run-time, for the actual shapes and sparsity of the "
+                 "results of reads, filters, and joins whose shapes are unknown at compile-time")
+    );
+    opt<bool> staticShapeKernels(
+            "static-shape-kernels", cat(daphneOptions),
+            desc("Call kernels with unrolled loops for elementwise ops and matrix multiplications on dense matrices "
+                 "of static shapes of up to 4x4")
+    );
     opt<bool> cuda(
             "cuda", cat(daphneOptions),
             desc("Use CUDA")
     );
+    opt<std::string> cudaPrecision(
+            "cuda-precision", cat(daphneOptions),
+            desc("The precision of the CUDA matrix multiplications and DNN ops on FP32 data: default, tf32, fp16, "
+                 "or bf16 (the latter two accumulate in FP32)")
+    );
+    opt<float> cudaLossScale(
+            "cuda-loss-scale", cat(daphneOptions), init(0),
+            desc("The factor the inputs are scaled by before rounding them for --cuda-precision=fp16/bf16 "
+                 "(default 1)")
+    );
     opt<bool> fpgaopencl(
             "fpgaopencl", cat(daphneOptions),
             desc("Use FPGAOPENCL")
     );
+    opt<bool> fastMath(
+            "fast-math", cat(daphneOptions),
+            desc("Use vectorizable approximations (within a few ULPs) of transcendental functions like exp and log "
+                 "in element-wise kernels")
+    );
+    opt<string> cpuIsa(
+            "cpu-isa", cat(daphneOptions),
+            desc("The instruction set the hot kernels run their variants for at most: auto (the best one of the "
+                 "CPU, default), generic, sse4.2, avx2, avx512, neon, or sve")
+    );
+    opt<bool> cpuDispatchStats(
+            "cpu-dispatch-stats", cat(daphneOptions),
+            desc("Print the instruction set of the variants each kernel ran at the end of the execution")
+    );
+    opt<int> jitOptLevel(
+            "jit-opt-level", cat(daphneOptions), init(-1),
+            desc("The LLVM optimization level (0 to 3) of the JIT-compiled code (default 2)")
+    );
+    opt<bool> noJitNativeTarget(
+            "no-jit-native-target", cat(daphneOptions),
+            desc("Do not tune the JIT-compiled code for the CPU features of the host (e.g., AVX2, AVX-512, SVE)")
+    );
+    opt<int> compileThreads(
+            "compile-threads", cat(daphneOptions), init(-1),
+            desc("The number of threads to run the compiler passes and the JIT compilation on "
+                 "(default 0 for all hardware threads, 1 for a sequential compilation)")
+    );
+    opt<bool> timingPasses(
+            "timing-passes", cat(daphneOptions),
+            desc("Report the time of each compiler pass and of the LLVM passes of the JIT")
+    );
+    opt<bool> timingPhases(
+            "timing-phases", cat(daphneOptions),
+            desc("Report the time of the initialization, the parsing, the compilation, the loading of the kernel "
+                 "libraries, the JIT compilation, and the execution")
+    );
+    opt<bool> statistics(
+            "statistics", cat(daphneOptions),
+            desc("Report the time and the numbers of ops before and after each compiler pass, the numbers of "
+                 "vectorized pipelines, fused ops, and kernel calls, and the time of the JIT compilation")
+    );
+    opt<string> statisticsJson(
+            "statistics-json", cat(daphneOptions),
+            desc("Write the compile statistics (see --statistics) as JSON to this file")
+    );
+    opt<bool> profileKernels(
+            "profile-kernels", cat(daphneOptions),
+            desc("Time each kernel call and report the calls per DaphneDSL statement at the end of the execution")
+    );
+    opt<bool> profileCounters(
+            "profile-counters", cat(daphneOptions),
+            desc("Count the cycles and last-level cache misses of each profiled kernel call (see --profile-kernels) "
+                 "by perf events")
+    );
+    opt<string> profileTrace(
+            "profile-trace", cat(daphneOptions),
+            desc("Write the profiled kernel calls (see --profile-kernels) as a Chrome trace (JSON) to this file")
+    );
+    opt<double> machinePeakGflops(
+            "machine-peak-gflops", cat(daphneOptions), init(0),
+            desc("The peak double-precision GFLOP/s of the machine for the roofline analysis of the profiled kernel "
+                 "calls (see --profile-kernels; estimated by default)")
+    );
+    opt<double> machinePeakGbps(
+            "machine-peak-gbps", cat(daphneOptions), init(0),
+            desc("The peak memory bandwidth in GB/s of the machine for the roofline analysis of the profiled kernel "
+                 "calls (see --profile-kernels; measured by default)")
+    );
+    opt<string> jitCacheDir(
+            "jit-cache-dir", cat(daphneOptions),
+            desc("Cache the JIT-compiled code in this directory and reuse it for the same compiled IR")
+    );
+    opt<string> parseCacheDir(
+            "parse-cache-dir", cat(daphneOptions),
+            desc("Cache the IR of the script after parsing in this directory and reuse it while the script, its "
+                 "imports, and its arguments are unchanged")
+    );
+    opt<bool> fuseEwise(
+            "fuse-ewise", cat(daphneOptions),
+            desc("Fuse trees of elementwise operations and aggregations into single-pass kernel calls")
+    );
+    opt<bool> matrixCseLicm(
+            "matrix-cse-licm", cat(daphneOptions),
+            desc("Eliminate common subexpressions of matrix operations and move loop-invariant ones out of loops")
+    );
+    opt<long> constantFoldingKB(
+            "constant-folding-kb", cat(daphneOptions), init(-1),
+            desc("Evaluate matrix expressions on compile-time constants (e.g., fill, seq, or rand with a seed) with "
+                 "results of at most this many KiB at compile time (0 to disable, default 256)")
+    );
+    opt<bool> algebraicSimplification(
+            "algebraic-simplification", cat(daphneOptions),
+            desc("Rewrite matrix expressions to cheaper equivalent ones, e.g., reorder chains of matrix "
+                 "multiplications by their inferred shapes")
+    );
+    opt<bool> noLoopRewrite(
+            "no-loop-rewrite", cat(daphneOptions),
+            desc("Keep for-loops over the rows of matrices instead of rewriting loops without dependencies between "
+                 "their iterations into whole-matrix operations (see --explain loops)")
+    );
+    opt<bool> noSqlOptimization(
+            "no-sql-optimization", cat(daphneOptions),
+            desc("Keep the joins and filters of SQL queries in their textual order instead of pushing filters below "
+                 "joins, turning equalities into inner joins, and ordering the joins by their estimated cardinalities")
+    );
+    opt<bool> noFunctionInlining(
+            "no-function-inlining", cat(daphneOptions),
+            desc("Keep the calls of DaphneDSL functions instead of inlining small functions and functions called "
+                 "only once into their callers")
+    );
     opt<string> libDir(
             "libdir", cat(daphneOptions),
             desc("The directory containing kernel libraries")
     );
+    opt<string> serveSocket(
+            "serve", cat(daphneOptions),
+            desc("Run as a server listening on this UNIX domain socket, which keeps the runtime, the compiled "
+                 "scripts, and the data read from files in memory and runs the scripts of the requests sent to it "
+                 "(see --connect)")
+    );
+    opt<string> connectSocket(
+            "connect", cat(daphneOptions),
+            desc("Run the script in the daphne server listening on this UNIX domain socket (see --serve) instead of "
+                 "in this process")
+    );
+    opt<string> registerFunction(
+            "register", cat(daphneOptions),
+            desc("With --connect, register the script as the function of this name at the server instead of "
+                 "running it")
+    );
+    opt<string> callFunction(
+            "call", cat(daphneOptions),
+            desc("With --connect, run the script registered as the function of this name at the server (with the "
+                 "arguments of --args) instead of a script")
+    );
+    opt<double> timeout(
+            "timeout", cat(daphneOptions),
+            desc("Stop the run with an error after this many seconds; the vectorized pipelines stop between their "
+                 "tasks, the other kernels at the next pipeline (with --connect, the time limit of the request)")
+    );
 
     enum ExplainArgs {
       kernels,
@@ -202,7 +557,9 @@ main(int argc, char** argv)
       sql,
       type_adaptation,
       vectorized,
-      obj_ref_mgnt
+      obj_ref_mgnt,
+      cost,
+      loops
     };
 
     llvm::cl::list<ExplainArgs> explainArgList(
@@ -218,7 +575,9 @@ main(int argc, char** argv)
             clEnumVal(vectorized, "Show DaphneIR after vectorization"),
             clEnumVal(obj_ref_mgnt, "Show DaphneIR after managing object references"),
             clEnumVal(kernels, "Show DaphneIR after kernel lowering"),
-            clEnumVal(llvm, "Show DaphneIR after llvm lowering")),
+            clEnumVal(llvm, "Show DaphneIR after llvm lowering"),
+            clEnumVal(cost, "Show the estimated FLOPs and bytes of each DaphneDSL statement"),
+            clEnumVal(loops, "Show which for-loops are rewritten into whole-matrix operations, and why not")),
         CommaSeparated);
 
     llvm::cl::list<string> scriptArgs1(
@@ -240,7 +599,8 @@ main(int argc, char** argv)
 
     // Positional arguments ---------------------------------------------------
     
-    opt<string> inputFile(Positional, desc("script"), Required);
+    // required unless a server is started or a function of a server is called
+    opt<string> inputFile(Positional, desc("script"));
     llvm::cl::list<string> scriptArgs2(ConsumeAfter, desc("[arguments]"));
 
     // ------------------------------------------------------------------------
@@ -259,6 +619,8 @@ main(int argc, char** argv)
             "  daphne --vec example.daphne x=1 y=2.2 z=\"foo\"\n"
             "  daphne --vec --args x=1,y=2.2,z=\"foo\" example.daphne\n"
             "  daphne --vec --args x=1,y=2.2 example.daphne z=\"foo\"\n"
+            "  daphne --vec --serve=/tmp/daphne.sock\n"
+            "  daphne --connect=/tmp/daphne.sock example.daphne x=1 y=2.2 z=\"foo\"\n"
     );
     SetVersionPrinter(&printVersion);
     ParseCommandLineOptions(
@@ -266,6 +628,11 @@ main(int argc, char** argv)
             "The DAPHNE Prototype.\n\nThis program compiles and executes a DaphneDSL script.\n"
     );
 
+    if(inputFile.empty() && serveSocket.empty() && (connectSocket.empty() || callFunction.empty())) {
+        std::cerr << "Parser error: no script given, see daphne --help" << std::endl;
+        return StatusCode::PARSER_ERROR;
+    }
+
     // ************************************************************************
     // Process parsed arguments
     // ************************************************************************
@@ -285,6 +652,10 @@ main(int argc, char** argv)
 //    user_config.debug_llvm = true;
     user_config.use_vectorized_exec = useVectorizedPipelines;
     user_config.use_distributed = useDistributedRuntime; 
+    if(!distributedBackend.empty())
+        user_config.distributed_backend = distributedBackend;
+    if(!checkpointDir.empty())
+        user_config.checkpoint_dir = checkpointDir;
     user_config.use_obj_ref_mgnt = !noObjRefMgnt;
     user_config.libdir = libDir.getValue();
     user_config.library_paths.push_back(user_config.libdir + "/libAllKernels.so");
@@ -294,9 +665,61 @@ main(int argc, char** argv)
     user_config.numberOfThreads = numberOfThreads; 
     user_config.minimumTaskSize = minimumTaskSize; 
     user_config.pinWorkers = pinWorkers;
+    user_config.numaAware = numaAware;
     user_config.hyperthreadingEnabled = hyperthreadingEnabled;
     user_config.debugMultiThreading = debugMultiThreading;
+    user_config.useWorkerPool = !noWorkerPool;
+    user_config.cudaStreamPipelining = cudaStreams;
+    user_config.cuda_graphs = cudaGraphs;
     user_config.prePartitionRows = prePartitionRows;
+    user_config.nnzBalancedPartitioning = nnzBalancedPartitioning;
+    if(bufferPoolMB >= 0)
+        user_config.buffer_pool_max_cached_bytes = static_cast<size_t>(bufferPoolMB) << 20;
+    user_config.buffer_pool_stats = bufferPoolStats;
+    if(noHugePages)
+        user_config.buffer_pool_huge_pages = false;
+    if(trackMemory)
+        user_config.track_memory = true;
+    if(memoryLimitMB >= 0) {
+        user_config.track_memory = true;
+        user_config.memory_limit_bytes = static_cast<size_t>(memoryLimitMB) << 20;
+    }
+    if(spillBudgetMB >= 0)
+        user_config.spill_budget_bytes = static_cast<size_t>(spillBudgetMB) << 20;
+    if(!spillDir.empty())
+        user_config.spill_dir = spillDir;
+    if(!spillCompression.empty())
+        user_config.spill_compression = spillCompression;
+    if(reuseCacheMB >= 0)
+        user_config.reuse_cache_bytes = static_cast<size_t>(reuseCacheMB) << 20;
+    if(mmapDaphneFiles)
+        user_config.mmap_daphne_files = true;
+    if(dbdfBlockRows >= 0)
+        user_config.daphne_file_block_rows = static_cast<size_t>(dbdfBlockRows);
+    if(!dbdfCompression.empty())
+        user_config.daphne_file_compression = dbdfCompression;
+    if(!objectStoreCache.empty())
+        user_config.object_store_cache = objectStoreCache;
+    if(objectStoreConnections > 0)
+        user_config.object_store_connections = static_cast<size_t>(objectStoreConnections);
+    if(vecStreamRead)
+        user_config.vectorized_stream_read = true;
+    if(vecStreamChunkRows >= 0)
+        user_config.vectorized_stream_chunk_rows = static_cast<size_t>(vecStreamChunkRows);
+    if(numaReplicateMB >= 0)
+        user_config.numa_replicate_broadcast_bytes = static_cast<size_t>(numaReplicateMB) << 20;
+    if(vecCostModel)
+        user_config.vectorized_cost_model = true;
+    if(prefetchReads)
+        user_config.prefetch_reads = true;
+    if(zoneMaps)
+        user_config.zone_maps = true;
+    if(keyIndexes)
+        user_config.key_indexes = true;
+    if(bloomFilters)
+        user_config.bloom_filters = true;
+    if(columnStatistics)
+        user_config.column_statistics = true;
 
     for (auto explain : explainArgList) {
         switch (explain) {
@@ -327,6 +750,12 @@ main(int argc, char** argv)
             case obj_ref_mgnt:
                 user_config.explain_obj_ref_mgnt = true;
                 break;
+            case cost:
+                user_config.explain_cost = true;
+                break;
+            case loops:
+                user_config.explain_loops = true;
+                break;
         }
     }
 
@@ -341,6 +770,95 @@ main(int argc, char** argv)
             user_config.use_cuda = true;
         }
     }
+    if(!cudaPrecision.empty())
+        user_config.cuda_precision = cudaPrecision;
+    if(cudaLossScale > 0)
+        user_config.cuda_loss_scale = cudaLossScale;
+
+    if(fastMath)
+        user_config.fast_math = true;
+    if(!cpuIsa.empty())
+        user_config.cpu_isa = cpuIsa;
+    if(cpuDispatchStats)
+        user_config.cpu_dispatch_stats = true;
+    if(jitOptLevel >= 0) {
+        if(jitOptLevel > 3) {
+            std::cerr << "Parser error: --jit-opt-level must be between 0 and 3" << std::endl;
+            return StatusCode::PARSER_ERROR;
+        }
+        user_config.jit_opt_level = jitOptLevel;
+    }
+    if(noJitNativeTarget)
+        user_config.jit_native_target = false;
+    if(compileThreads >= 0)
+        user_config.compile_threads = compileThreads;
+    if(timingPasses)
+        user_config.timing_passes = true;
+    if(timingPhases)
+        user_config.timing_phases = true;
+    if(statistics)
+        user_config.compile_statistics = true;
+    if(!statisticsJson.empty()) {
+        user_config.compile_statistics = true;
+        user_config.compile_statistics_file = statisticsJson.getValue();
+    }
+    if(profileKernels)
+        user_config.profile_kernels = true;
+    if(profileCounters) {
+        user_config.profile_kernels = true;
+        user_config.profile_perf_counters = true;
+    }
+    if(!profileTrace.empty()) {
+        user_config.profile_kernels = true;
+        user_config.profile_trace_file = profileTrace.getValue();
+    }
+    if(machinePeakGflops > 0)
+        user_config.machine_peak_gflops = machinePeakGflops;
+    if(machinePeakGbps > 0)
+        user_config.machine_peak_gbps = machinePeakGbps;
+    if(!vecTrace.empty())
+        user_config.vectorized_trace_file = vecTrace.getValue();
+    if(vecAutotune)
+        user_config.vectorized_autotune = true;
+    if(!vecAutotuneProfile.empty()) {
+        user_config.vectorized_autotune = true;
+        user_config.vectorized_autotune_profile = vecAutotuneProfile.getValue();
+    }
+    if(!jitCacheDir.empty())
+        user_config.jit_cache_dir = jitCacheDir.getValue();
+    if(!parseCacheDir.empty())
+        user_config.parse_cache_dir = parseCacheDir.getValue();
+    if(fuseEwise)
+        user_config.fuse_ewise = true;
+    if(matrixCseLicm)
+        user_config.matrix_cse_licm = true;
+    if(constantFoldingKB >= 0)
+        user_config.constant_folding_max_bytes = static_cast<size_t>(constantFoldingKB) << 10;
+    if(algebraicSimplification)
+        user_config.algebraic_simplification = true;
+    if(noLoopRewrite)
+        user_config.loop_rewrite = false;
+    if(noSqlOptimization)
+        user_config.sql_optimization = false;
+    if(noFunctionInlining)
+        user_config.function_inlining = false;
+    if(sparseThreshold >= 0) {
+        if(sparseThreshold == 0 || sparseThreshold > 1) {
+            std::cerr << "Parser error: --sparse-threshold must be in (0, 1]" << std::endl;
+            return StatusCode::PARSER_ERROR;
+        }
+        user_config.sparse_threshold = sparseThreshold;
+    }
+    if(sparseCostModel)
+        user_config.sparse_cost_model = true;
+    if(sparsityWorstCase)
+        user_config.sparsity_worst_case = true;
+    if(adaptive)
+        user_config.adaptive_execution = true;
+    if(staticShapeKernels)
+        user_config.static_shape_kernels = true;
+    if(timeout > 0)
+        user_config.timeout_seconds = timeout;
 
     if(fpgaopencl) {
         user_config.use_fpgaopencl = true;
@@ -362,6 +880,45 @@ main(int argc, char** argv)
         return StatusCode::PARSER_ERROR;
     }
 
+    // ************************************************************************
+    // Run as or in a daphne server
+    // ************************************************************************
+
+    if(!serveSocket.empty()) {
+        DaphneServer server(selectMatrixRepr, user_config);
+        return server.serve(serveSocket);
+    }
+
+    if(!connectSocket.empty()) {
+        nlohmann::json args = nlohmann::json::object();
+        for(auto & arg : scriptArgsFinal)
+            args[arg.first] = arg.second;
+        nlohmann::json request;
+        if(!callFunction.empty())
+            request = {{"function", callFunction.getValue()}, {"args", args}};
+        else {
+            // the working directory of the server may differ
+            llvm::SmallString<256> scriptPath(inputFile.getValue());
+            llvm::sys::fs::make_absolute(scriptPath);
+            if(!registerFunction.empty())
+                request = {{"register", registerFunction.getValue()}, {"script", scriptPath.str().str()}};
+            else
+                request = {{"script", scriptPath.str().str()}, {"args", args}};
+        }
+        if(timeout > 0)
+            request["timeout"] = timeout.getValue();
+        try {
+            const nlohmann::json response = DaphneServer::sendRequest(connectSocket, request);
+            std::cout << response.at("out").get<string>() << std::flush;
+            std::cerr << response.at("err").get<string>() << std::flush;
+            return response.at("status").get<int>();
+        }
+        catch(std::exception & e) {
+            std::cerr << "Connection error: " << e.what() << std::endl;
+            return StatusCode::EXECUTION_ERROR;
+        }
+    }
+
     // ************************************************************************
     // Compile and execute script
     // ************************************************************************
@@ -369,30 +926,55 @@ main(int argc, char** argv)
     // Creates an MLIR context and loads the required MLIR dialects.
     DaphneIrExecutor
         executor(selectMatrixRepr, user_config);
+    endPhase("initialization");
+
+    // Reuse the IR after parsing and simplification, if the script, its
+    // imports, and its arguments are unchanged. The cache is bypassed to
+    // explain the IR after parsing.
+    const bool explainParsing = user_config.explain_parsing || user_config.explain_parsing_simplified;
+    ParsedIrCache parseCache(explainParsing ? "" : user_config.parse_cache_dir);
+    const string parseKey = user_config.parse_cache_dir.empty() || explainParsing
+            ? "" : ParsedIrCache::computeKey(inputFile, scriptArgsFinal, user_config);
+    OwningModuleRef moduleOp = parseCache.lookup(parseKey, executor.getContext());
+    const bool parsedFromCache = static_cast<bool>(moduleOp);
+    if(!parsedFromCache) {
+        // Create an OpBuilder and an MLIR module and set the builder's insertion
+        // point to the module's body, such that subsequently created DaphneIR
+        // operations are inserted into the module.
+        OpBuilder builder(executor.getContext());
+        auto loc = mlir::FileLineColLoc::get(builder.getIdentifier(inputFile), 0, 0);
+        moduleOp = OwningModuleRef(ModuleOp::create(loc));
+        auto * body = moduleOp->getBody();
+        builder.setInsertionPoint(body, body->begin());
+
+        // Parse the input file and generate the corresponding DaphneIR operations
+        // inside the module, assuming DaphneDSL as the input format.
+        DaphneDSLParser parser(scriptArgsFinal, user_config);
+        try {
+            parser.parseFile(builder, inputFile);
+        }
+        catch(std::exception & e) {
+            std::cerr << "Parser error: " << e.what() << std::endl;
+            return StatusCode::PARSER_ERROR;
+        }
 
-    // Create an OpBuilder and an MLIR module and set the builder's insertion
-    // point to the module's body, such that subsequently created DaphneIR
-    // operations are inserted into the module.
-    OpBuilder builder(executor.getContext());
-    auto loc = mlir::FileLineColLoc::get(builder.getIdentifier(inputFile), 0, 0);
-    auto moduleOp = ModuleOp::create(loc);
-    auto * body = moduleOp.getBody();
-    builder.setInsertionPoint(body, body->begin());
-
-    // Parse the input file and generate the corresponding DaphneIR operations
-    // inside the module, assuming DaphneDSL as the input format.
-    DaphneDSLParser parser(scriptArgsFinal, user_config);
-    try {
-        parser.parseFile(builder, inputFile);
-    }
-    catch(std::exception & e) {
-        std::cerr << "Parser error: " << e.what() << std::endl;
-        return StatusCode::PARSER_ERROR;
+        try{
+            if (!executor.runSimplificationPasses(*moduleOp)) {
+                return StatusCode::PASS_ERROR;
+            }
+        }
+        catch(std::exception & e){
+            std::cerr << "Pass error: " << e.what() << std::endl;
+            return StatusCode::PASS_ERROR;
+        }
+        parseCache.insert(parseKey, *moduleOp,
+                          ParsedIrCache::getDependencies(*moduleOp, inputFile, parser.getImportedFiles()));
     }
+    endPhase(parsedFromCache ? "parsing (cached)" : "parsing");
 
     // Further, process the module, including optimization and lowering passes.
     try{
-        if (!executor.runPasses(moduleOp)) {
+        if (!executor.runLoweringPasses(*moduleOp)) {
             return StatusCode::PASS_ERROR;
         }
     }
@@ -400,16 +982,31 @@ main(int argc, char** argv)
         std::cerr << "Pass error: " << e.what() << std::endl;
         return StatusCode::PASS_ERROR;
     }
+    endPhase("compilation");
 
     // JIT-compile the module and execute it.
     // module->dump(); // print the LLVM IR representation
     try{
-        auto engine = executor.createExecutionEngine(moduleOp);
-        auto error = engine->invoke("main");
+        JitObjectCache jitCache(user_config.jit_cache_dir);
+        auto program = executor.createJitProgram(*moduleOp, "main", jitCache);
+        if (!program)
+            return StatusCode::EXECUTION_ERROR;
+        endPhase("JIT compilation");
+        // The kernel libraries are loaded before the JIT compilation.
+        const CompileStatistics & stats = executor.getStatistics();
+        phaseTimes.back().first += " (" + to_string(stats.jitCacheHits) + " cache hits)";
+        phaseTimes.back().second -= stats.libraryLoadSeconds;
+        phaseTimes.insert(phaseTimes.end() - 1, make_pair("loading " + to_string(stats.libraries.size())
+                + " kernel libraries", stats.libraryLoadSeconds));
+        auto error = program->invoke("main");
         if (error) {
             llvm::errs() << "JIT-Engine invocation failed: " << error;
             return StatusCode::EXECUTION_ERROR;
         }
+        endPhase("execution");
+        executor.reportStatistics();
+        if(user_config.timing_phases)
+            printPhaseTimes(phaseTimes, llvm::errs());
     }
     catch(std::exception & e){
         std::cerr << "Execution error: " << e.what() << std::endl;
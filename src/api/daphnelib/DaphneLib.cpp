@@ -0,0 +1,116 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <api/cli/StatusCode.h>
+#include <api/daphnelib/DaphneLib.h>
+#include <compiler/execution/DaphneIrExecutor.h>
+#include <compiler/execution/JitObjectCache.h>
+#include <parser/config/ConfigParser.h>
+#include <parser/daphnedsl/DaphneDSLParser.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Structure.h>
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "llvm/Support/Error.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+namespace {
+    // drops the results of a failed run
+    void clearResults(DaphneLibResult * results, int64_t numResults) {
+        for(int64_t i = 0; i < numResults; i++) {
+            if(results[i].handle)
+                daphneReleaseResult(results[i].handle);
+            results[i] = DaphneLibResult{nullptr, 0, 0, 0, 0, nullptr};
+        }
+    }
+}
+
+int daphne(DaphneLibResult * results, int64_t numResults, const char * scriptPath, const char * configPath)
+{
+    for(int64_t i = 0; i < numResults; i++)
+        results[i] = DaphneLibResult{nullptr, 0, 0, 0, 0, nullptr};
+
+    DaphneUserConfig userConfig{};
+    try {
+        if(configPath && *configPath)
+            ConfigParser::readUserConfig(configPath, userConfig);
+    }
+    catch(std::exception & e) {
+        std::cerr << "Error while reading user config: " << e.what() << std::endl;
+        return StatusCode::PARSER_ERROR;
+    }
+    if(!userConfig.libdir.empty())
+        userConfig.library_paths.push_back(userConfig.libdir + "/libAllKernels.so");
+    userConfig.result_struct = results;
+    userConfig.num_result_structs = static_cast<size_t>(numResults);
+    // The Python program typically runs many scripts, which share one worker pool.
+    userConfig.persistent_worker_pool = true;
+
+    try {
+        DaphneIrExecutor executor(false, userConfig);
+
+        mlir::OpBuilder builder(executor.getContext());
+        auto loc = mlir::FileLineColLoc::get(builder.getIdentifier(scriptPath), 0, 0);
+        mlir::OwningModuleRef moduleOp(mlir::ModuleOp::create(loc));
+        auto * body = moduleOp->getBody();
+        builder.setInsertionPoint(body, body->begin());
+
+        DaphneDSLParser parser(std::unordered_map<std::string, std::string>(), userConfig);
+        try {
+            parser.parseFile(builder, scriptPath);
+        }
+        catch(std::exception & e) {
+            std::cerr << "Parser error: " << e.what() << std::endl;
+            return StatusCode::PARSER_ERROR;
+        }
+
+        try {
+            if(!executor.runPasses(*moduleOp))
+                return StatusCode::PASS_ERROR;
+        }
+        catch(std::exception & e) {
+            std::cerr << "Pass error: " << e.what() << std::endl;
+            return StatusCode::PASS_ERROR;
+        }
+
+        JitObjectCache jitCache(userConfig.jit_cache_dir);
+        auto program = executor.createJitProgram(*moduleOp, "main", jitCache);
+        if(!program)
+            return StatusCode::EXECUTION_ERROR;
+        if(auto error = program->invoke("main")) {
+            std::cerr << "JIT-Engine invocation failed: " << llvm::toString(std::move(error)) << std::endl;
+            clearResults(results, numResults);
+            return StatusCode::EXECUTION_ERROR;
+        }
+    }
+    catch(std::exception & e) {
+        std::cerr << "Execution error: " << e.what() << std::endl;
+        clearResults(results, numResults);
+        return StatusCode::EXECUTION_ERROR;
+    }
+    return StatusCode::SUCCESS;
+}
+
+void daphneReleaseResult(void * handle)
+{
+    DataObjectFactory::destroy(static_cast<const Structure *>(handle));
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_API_DAPHNELIB_DAPHNELIB_H
+#define SRC_API_DAPHNELIB_DAPHNELIB_H
+
+#pragma once
+
+#include <api/daphnelib/DaphneLibResult.h>
+
+#include <cstdint>
+
+/**
+ * @brief The C interface of DaphneLib, through which the Python API runs DaphneDSL scripts in its own process.
+ *
+ * The matrices of the Python program are passed to the script by the addresses of their values (see the builtin
+ * `receiveFromNumpy`) and wrapped as `DenseMatrix` without copying, and the script passes its results back by
+ * `saveDaphneLibResult`, whose values are exposed as NumPy arrays without copying.
+ */
+extern "C" {
+    /**
+     * @brief Compiles and runs the given DaphneDSL script in this process and returns its status code (see
+     * `StatusCode`), writing the errors to standard error.
+     *
+     * @param results The results of the script by the indices it passed to `saveDaphneLibResult`, each of which
+     * must be released by `daphneReleaseResult` (the handle of an index without a result is `nullptr`).
+     * @param numResults The number of results.
+     * @param scriptPath The path of the script.
+     * @param configPath The path of a user config file (see `UserConfig.json`), or `nullptr` or empty for the
+     * default config.
+     */
+    int daphne(DaphneLibResult * results, int64_t numResults, const char * scriptPath, const char * configPath);
+
+    /**
+     * @brief Releases the matrix of a result, whose values must not be accessed afterwards.
+     */
+    void daphneReleaseResult(void * handle);
+}
+
+#endif //SRC_API_DAPHNELIB_DAPHNELIB_H
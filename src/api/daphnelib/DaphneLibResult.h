@@ -0,0 +1,43 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_API_DAPHNELIB_DAPHNELIBRESULT_H
+#define SRC_API_DAPHNELIB_DAPHNELIBRESULT_H
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief The dense matrix a DaphneDSL script run by DaphneLib passed to `saveDaphneLibResult`, which the Python API
+ * exposes as a NumPy array over its values without copying (see `daphne` in `DaphneLib.h`).
+ *
+ * The layout is mirrored by `DaphneLibResult` in `src/api/python/utils/daphnelib.py`.
+ */
+struct DaphneLibResult {
+    // the values of the matrix (nullptr if the script saved no result)
+    void * address;
+    int64_t rows;
+    int64_t cols;
+    // the number of values between the starts of two rows
+    int64_t rowSkip;
+    // the value type as a `ValueTypeCode`
+    int64_t vtc;
+    // the matrix, which keeps the values alive until it is released by `daphneReleaseResult`
+    void * handle;
+};
+
+#endif //SRC_API_DAPHNELIB_DAPHNELIBRESULT_H
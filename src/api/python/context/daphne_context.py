@@ -23,28 +23,86 @@
 
 __all__ = ["DaphneContext"]
 
-from api.python.utils.consts import VALID_INPUT_TYPES, TMP_PATH
+from api.python.utils.consts import VALID_INPUT_TYPES
+from api.python.utils.daphnelib import prepare_input, receive_args
 import numpy as np
+from api.python.operator.nodes.frame import Frame
 from api.python.operator.nodes.matrix import Matrix
-from typing import Sequence, Dict, Union
+from api.python.script_building.dag import DAGNode, DAGNodeIds, OutputType
+from api.python.script_building.script import DaphneDSLScript
+from typing import Any, Sequence, Dict, List, Union
 
 class DaphneContext(object):
-    #TODO: load data from numpy array
+    node_ids: DAGNodeIds
+    # the matrices and scalars computed so far by the ids of their values (see DAGNodeIds)
+    _results: Dict[int, Any]
+
+    def __init__(self):
+        self.node_ids = DAGNodeIds()
+        self._results = {}
+
+    def compute(self, *nodes: DAGNode) -> List[Any]:
+        """Computes the given matrices (as NumPy arrays), frames (as pandas DataFrames), and scalars in one script,
+        which computes the sub-DAGs they share once, and returns them in the order of the nodes (None for nodes
+        without a value, e.g., prints).
+
+        The results are kept for the later scripts of this context, which use them instead of computing their
+        sub-DAGs again, so the arrays and DataFrames passed to from_numpy and from_pandas must not change while the
+        results computed from them are kept (see clear_cache), and neither must the returned DataFrames, while the
+        returned arrays are read-only.
+        :param nodes: the nodes to compute
+        :return: the values of the nodes
+        """
+        script = DaphneDSLScript(self)
+        script.build_code(*nodes, print_scalars=False)
+        results = script.execute()
+        script.clear(*nodes)
+        values = []
+        for node, result in zip(nodes, results):
+            if result is not None:
+                if node.output_type == OutputType.MATRIX:
+                    result.flags.writeable = False
+                elif node.output_type != OutputType.FRAME:
+                    result = result[0, 0].item()
+                if not node.is_python_local_data:
+                    self._results[self.node_ids.get(node)] = result
+            values.append(result)
+        return values
+
+    def get_cached_result(self, node: DAGNode) -> Any:
+        """Returns the value of the given node computed by an earlier script of this context, or None."""
+        return self._results.get(self.node_ids.get(node))
+
+    def clear_cache(self):
+        """Drops the values computed by the earlier scripts of this context."""
+        self._results = {}
     def from_numpy(self, mat: np.array,
             *args: Sequence[VALID_INPUT_TYPES],
             **kwargs: Dict[str, VALID_INPUT_TYPES]) -> Matrix:
         """Generate DAGNode representing matrix with data given by a numpy array.
+        The script accesses the values of the array without copying them, so the array must not change until the
+        script is executed.
         :param mat: the numpy array
         :param args: unnamed parameters
         :param kwargs: named parameters
         :return: A Matrix
         """
-
-        unnamed_params = ['"src/api/python/tmp/{file_name}.csv\"']
+        mat = prepare_input(mat)
+        unnamed_params = receive_args(mat)
 
         unnamed_params.extend(args)
         named_params = []
-        return Matrix(self, 'readMatrix', unnamed_params, named_params, local_data=mat)
+        return Matrix(self, 'receiveFromNumpy', unnamed_params, named_params, local_data=mat)
+
+    def from_pandas(self, df) -> Frame:
+        """Generate DAGNode representing a frame with the columns of a pandas DataFrame.
+        The DataFrame is passed to the script through Arrow's C data interface, whose numeric columns without nulls
+        are shared rather than copied, so the DataFrame must not change until the script is executed. String columns
+        are copied, and categorical columns become dictionary-encoded columns. Requires pyarrow.
+        :param df: the pandas DataFrame
+        :return: A Frame
+        """
+        return Frame(self, 'receiveFromArrow', local_data=df)
 
     def rand(self, rows: int, cols: int,
             min: Union[float, int] = None, max: Union[float, int] = None,sparsity: Union[float, int] = 0, seed: Union[float, int] = 0
@@ -0,0 +1,67 @@
+# -------------------------------------------------------------
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+# Modifications Copyright 2022 The DAPHNE Consortium
+#
+# -------------------------------------------------------------
+
+__all__ = ["Frame"]
+from typing import TYPE_CHECKING, Dict, Iterable, Sequence, Union
+
+from api.python.script_building.dag import OutputType
+from api.python.utils.consts import VALID_INPUT_TYPES
+from api.python.operator.operation_node import OperationNode
+if TYPE_CHECKING:
+    # to avoid cyclic dependencies during runtime
+    import pandas as pd
+    from context.daphne_context import DaphneContext
+
+class Frame(OperationNode):
+    _pd_dataframe: 'pd.DataFrame'
+
+    def __init__(self, daphne_context: 'DaphneContext', operation: str,
+                 unnamed_input_nodes: Union[str, Iterable[VALID_INPUT_TYPES]] = None,
+                 named_input_nodes: Dict[str, VALID_INPUT_TYPES] = None,
+                 local_data: 'pd.DataFrame' = None) -> 'Frame':
+        self._pd_dataframe = local_data
+        super().__init__(daphne_context, operation, unnamed_input_nodes, named_input_nodes, OutputType.FRAME,
+                         local_data is not None)
+
+    def code_line(self, var_name: str, unnamed_input_vars: Sequence[str],
+                  named_input_vars: Dict[str, str]) -> str:
+        return super().code_line(var_name, unnamed_input_vars, named_input_vars)
+
+    def compute(self) -> 'pd.DataFrame':
+        if self._pd_dataframe is not None:
+            return self._pd_dataframe
+        return super().compute()
+
+    def to_pandas(self) -> 'pd.DataFrame':
+        """Computes this frame as a pandas DataFrame, whose numeric columns share the values of the frame computed
+        by DAPHNE (see DaphneContext.compute).
+        """
+        return self.compute()
+
+    def cbind(self, other: 'Frame') -> 'Frame':
+        """Appends the columns of the other frame to the columns of this frame."""
+        return Frame(self.daphne_context, 'cbind', [self, other])
+
+    def rbind(self, other: 'Frame') -> 'Frame':
+        """Appends the rows of the other frame to the rows of this frame."""
+        return Frame(self.daphne_context, 'rbind', [self, other])
@@ -55,20 +55,22 @@ class OperationNode(DAGNode):
         self._script = None
         self._source_node = None
         self._already_added = False
+        self._node_id = None
         self.daphnedsl_name = ""
         self._is_python_local_data = is_python_local_data
         self._brackets = brackets
         self._output_type = output_type
 
     def compute(self):
-        if self._result_var is None:
-            self._script = DaphneDSLScript(self.daphne_context)
-            result = self._script.build_code(self)
-            self._script.execute()
-            self._script.clear(self)
-            if result is None:
-                return
-            return np.genfromtxt(result, delimiter=',')
+        """Computes the matrix of this node as a NumPy array or the frame of this node as a pandas DataFrame (see
+        DaphneContext.compute), or prints the scalar of this node.
+        """
+        if self._output_type in (OutputType.MATRIX, OutputType.FRAME):
+            return self.daphne_context.compute(self)[0]
+        self._script = DaphneDSLScript(self.daphne_context)
+        self._script.build_code(self)
+        self._script.execute()
+        self._script.clear(self)
     
     def code_line(self, var_name: str, unnamed_input_vars: Sequence[str], named_input_vars: Dict[str, str])->str:
         if self._brackets:
@@ -22,10 +22,12 @@
 # -------------------------------------------------------------
 from abc import ABC
 from enum import Enum, auto
-from typing import TYPE_CHECKING, Any, Dict, Sequence, Union, Optional
+from itertools import count
+from typing import TYPE_CHECKING, Any, Dict, Sequence, Tuple, Union, Optional
 
 class OutputType(Enum):
     MATRIX = auto()
+    FRAME = auto()
     NONE = auto()
     DOUBLE = auto()
 
@@ -38,6 +40,8 @@ class DAGNode(ABC):
     _script: Optional["DaphneDSLScript"]
     _is_python_local_data: bool
     _daphnedsl_name: str
+    # the id of the value the node computes (see DAGNodeIds)
+    _node_id: Optional[int]
 
     def compute() -> Any:
         raise NotImplementedError
@@ -75,4 +79,48 @@ class DAGNode(ABC):
 
     @daphnedsl_name.setter
     def daphnedsl_name(self, value):
-        self._daphnedsl_name = value
\ No newline at end of file
+        self._daphnedsl_name = value
+
+class DAGNodeIds:
+    """Numbers the DAG nodes of a context such that nodes computing the same value get the same id, i.e., nodes of
+    the same operation on inputs of the same ids or literals, by which the scripts compute common sub-DAGs once and
+    the context finds the results it computed before.
+
+    Nodes with side effects, nodes of local data (whose values may change), and nodes drawing random values with a
+    random seed (-1) compute a value of their own and get a new id.
+    """
+    _ids: Dict[Tuple, int]
+
+    def __init__(self):
+        self._ids = {}
+        self._next_id = count()
+
+    def get(self, dag_node: DAGNode) -> int:
+        if dag_node._node_id is None:
+            key = self._key(dag_node)
+            if key is None:
+                dag_node._node_id = next(self._next_id)
+            else:
+                if key not in self._ids:
+                    self._ids[key] = next(self._next_id)
+                dag_node._node_id = self._ids[key]
+        return dag_node._node_id
+
+    def _key(self, dag_node: DAGNode) -> Optional[Tuple]:
+        if dag_node.output_type not in (OutputType.MATRIX, OutputType.FRAME, OutputType.DOUBLE) \
+                or dag_node.is_python_local_data:
+            return None
+        named_input_nodes = dag_node.named_input_nodes if isinstance(dag_node.named_input_nodes, dict) else {}
+        if named_input_nodes.get('seed') == -1:
+            return None
+        source_node = dag_node._source_node
+        return (type(dag_node).__name__, dag_node.operation, dag_node.output_type, getattr(dag_node, '_brackets', False),
+                tuple(self._input_key(n) for n in dag_node.unnamed_input_nodes),
+                tuple((name, self._input_key(n)) for name, n in sorted(named_input_nodes.items())),
+                None if source_node is None else self.get(source_node))
+
+    def _input_key(self, input_node) -> Tuple:
+        if isinstance(input_node, DAGNode):
+            return ('node', self.get(input_node))
+        # distinguishes, e.g., True from 1
+        return (type(input_node).__name__, input_node)
@@ -21,9 +21,10 @@
 #
 # -------------------------------------------------------------
 import os
-from typing import List, Dict, TYPE_CHECKING
+from typing import List, Dict, Optional, TYPE_CHECKING
 from api.python.script_building.dag import DAGNode, OutputType
-from api.python.utils.consts import VALID_INPUT_TYPES, TMP_PATH, PROTOTYPE_PATH
+from api.python.utils.consts import VALID_INPUT_TYPES, PROTOTYPE_PATH
+from api.python.utils.daphnelib import ArrowCData, export_frame, import_frame, prepare_input, receive_args, run_script
 import numpy as np
 
 if TYPE_CHECKING:
@@ -32,28 +33,54 @@ if TYPE_CHECKING:
 
 class DaphneDSLScript:
     daphnedsl_script :str
-    inputs: Dict[str, DAGNode]
+    inputs: Dict[str, np.array]
+    # the record batches passed to the script by receiveFromArrow, and the ones it passes back by sendToArrow by the
+    # positions of their outputs
+    frame_inputs: Dict[str, ArrowCData]
+    frame_outputs: Dict[int, ArrowCData]
     out_var_name:List[str]
     _variable_counter: int
+    _num_results: int
+    # the variables of the values computed so far by the ids of the values (see DAGNodeIds)
+    _vars_by_node_id: Dict[int, str]
+    _named_nodes: List[DAGNode]
 
     def __init__(self, context) -> None:
         self.daphne_context = context
         self.daphnedsl_script = ''
         self.inputs = {}
+        self.frame_inputs = {}
+        self.frame_outputs = {}
         self.out_var_name = []
         self._variable_counter = 0
+        self._num_results = 0
+        self._vars_by_node_id = {}
+        self._named_nodes = []
     
-    def build_code(self, dag_root: DAGNode):
-        baseOutVarString = self._dfs_dag_nodes(dag_root)
-        if dag_root._output_type != OutputType.NONE:
-            self.out_var_name.append(baseOutVarString)
-            if(dag_root.output_type == OutputType.MATRIX):
-                self.add_code(f'writeMatrix({baseOutVarString},"{TMP_PATH}/{baseOutVarString}.csv");')
-                return str(TMP_PATH+"/" + baseOutVarString+ ".csv")
-            else:
-                self.add_code(f'print({baseOutVarString});')
-                return None
-            
+    def build_code(self, *dag_roots: DAGNode, print_scalars: bool = True):
+        """Generates the code computing the given outputs in one script, which computes the sub-DAGs they share
+        once and reuses the results the context computed before instead of their sub-DAGs.
+
+        The script passes the matrices as the results of the positions of their outputs to DaphneLib and the
+        frames as Arrow record batches, and prints the scalars, or passes them as 1x1 matrices if not print_scalars.
+        """
+        for dag_root in dag_roots:
+            baseOutVarString = self._dfs_dag_nodes(dag_root)
+            index = self._num_results
+            self._num_results += 1
+            if dag_root._output_type != OutputType.NONE:
+                self.out_var_name.append(baseOutVarString)
+                if(dag_root.output_type == OutputType.MATRIX):
+                    self.add_code(f'saveDaphneLibResult({baseOutVarString}, {index});')
+                elif dag_root.output_type == OutputType.FRAME:
+                    cdata = ArrowCData()
+                    self.frame_outputs[index] = cdata
+                    array_address, schema_address = cdata.addresses
+                    self.add_code(f'sendToArrow({baseOutVarString}, {array_address}, {schema_address});')
+                elif not print_scalars:
+                    self.add_code(f'saveDaphneLibResult(fill({baseOutVarString}, 1, 1), {index});')
+                else:
+                    self.add_code(f'print({baseOutVarString});')
 
     def add_code(self, code:str)->None:
         """Add a line of DaphneDSL code to our script
@@ -62,17 +89,35 @@ class DaphneDSLScript:
         """
         self.daphnedsl_script += code +'\n'
     
-    def clear(self, dag_root:DAGNode):
-        self._dfs_clear_dag_nodes(dag_root)
+    def clear(self, *dag_roots: DAGNode):
+        for dag_node in self._named_nodes:
+            dag_node._daphnedsl_name = ""
+        self._named_nodes = []
+        self._vars_by_node_id = {}
         self._variable_counter = 0
+        self._num_results = 0
+        self.inputs = {}
+        self.frame_inputs = {}
+        self.frame_outputs = {}
 
-    def execute(self):
-        
+    def execute(self) -> List[Optional[np.array]]:
+        """Runs the script in this process and returns the matrices (as NumPy arrays) and frames (as pandas
+        DataFrames) it computed by the positions of their outputs (None for the outputs it printed or that have no
+        value), without copying their numeric values.
+        """
         os.chdir(PROTOTYPE_PATH)
         temp_out_file = open("tmpdaphne.daphne", "w")
         temp_out_file.writelines(self.daphnedsl_script)
         temp_out_file.close()
-        os.system("build/bin/daphne tmpdaphne.daphne")
+        try:
+            results = run_script("tmpdaphne.daphne", list(self.inputs.values()), self._num_results)
+            for index, cdata in self.frame_outputs.items():
+                results[index] = import_frame(cdata)
+            return results
+        finally:
+            # the batches the script did not take over or pass back
+            for cdata in [*self.frame_inputs.values(), *self.frame_outputs.values()]:
+                cdata.release()
 
     def _dfs_dag_nodes(self, dag_node: VALID_INPUT_TYPES)->str:
         """depth first search to create code from DAG
@@ -86,6 +131,24 @@ class DaphneDSLScript:
         #if node has name -> its already defined in the script -> reuse it
         if dag_node.daphnedsl_name != "":
             return dag_node.daphnedsl_name
+
+        # a node computing the same value as one before (e.g., a common sub-DAG built twice) reuses its variable
+        node_id = self.daphne_context.node_ids.get(dag_node)
+        if node_id in self._vars_by_node_id:
+            return self._name_node(dag_node, self._vars_by_node_id[node_id])
+
+        # a value the context computed before is passed to the script instead of being computed again
+        cached = self.daphne_context.get_cached_result(dag_node)
+        if cached is not None:
+            var_name = self._name_node(dag_node, self._next_unique_var())
+            self._vars_by_node_id[node_id] = var_name
+            if dag_node.output_type == OutputType.MATRIX:
+                self._add_input(var_name, cached)
+            elif dag_node.output_type == OutputType.FRAME:
+                self._add_frame_input(var_name, cached)
+            else:
+                self._add_input(var_name, np.array([[cached]]), scalar=True)
+            return var_name
         
         if dag_node._source_node is not None:
             self._dfs_dag_nodes(dag_node._source_node)
@@ -98,29 +161,39 @@ class DaphneDSLScript:
                 
                 named_input_vars[name] = self._dfs_dag_nodes(input_node)
                 if isinstance(input_node, DAGNode) and input_node._output_type == OutputType.LIST:
-                    dag_node._daphnedsl_name = named_input_vars[name] + name
-                    return dag_node._daphnedsl_name
+                    return self._name_node(dag_node, named_input_vars[name] + name)
 
         
         if dag_node._daphnedsl_name != "":
             return dag_node._daphnedsl_name
 
-        dag_node._daphnedsl_name = self._next_unique_var()
+        self._name_node(dag_node, self._next_unique_var())
+        self._vars_by_node_id[node_id] = dag_node.daphnedsl_name
+        if dag_node.is_python_local_data and dag_node.output_type == OutputType.FRAME:
+            # the batch is exported anew for each script, since the script takes it over
+            self._add_frame_input(dag_node.daphnedsl_name, dag_node._pd_dataframe)
+            return dag_node.daphnedsl_name
+        if dag_node.is_python_local_data:
+            self.inputs[dag_node.daphnedsl_name] = dag_node._np_array
         code_line = dag_node.code_line(dag_node.daphnedsl_name, unnamed_input_vars, named_input_vars)
         self.add_code(code_line)
         return dag_node._daphnedsl_name
 
-    def _dfs_clear_dag_nodes(self, dag_node:VALID_INPUT_TYPES)->str:
-        if not isinstance(dag_node, DAGNode):
-            return
-        dag_node._daphnedsl_name = ""
-        for n in dag_node.unnamed_input_nodes:
-            self._dfs_clear_dag_nodes(n)
-        if(isinstance(dag_node.named_input_nodes, dict)):
-            for name,n in dag_node.named_input_nodes.items():
-                self._dfs_clear_dag_nodes(n)
-        if dag_node._source_node is not None:
-            self._dfs_clear_dag_nodes(dag_node._source_node)
+    def _name_node(self, dag_node: DAGNode, var_name: str) -> str:
+        dag_node._daphnedsl_name = var_name
+        self._named_nodes.append(dag_node)
+        return var_name
+
+    def _add_input(self, var_name: str, mat: np.array, scalar: bool = False):
+        mat = prepare_input(mat)
+        self.inputs[var_name] = mat
+        receive = f'receiveFromNumpy({", ".join(str(arg) for arg in receive_args(mat))})'
+        self.add_code(f'{var_name}=as.scalar({receive});' if scalar else f'{var_name}={receive};')
+
+    def _add_frame_input(self, var_name: str, df):
+        cdata, args = export_frame(df)
+        self.frame_inputs[var_name] = cdata
+        self.add_code(f'{var_name}=receiveFromArrow({", ".join(str(arg) for arg in args)});')
 
     def _next_unique_var(self)->str:
         var_id = self._variable_counter
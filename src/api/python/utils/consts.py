@@ -31,4 +31,6 @@ PYTHON_PATH = os.path.abspath(os.path.dirname(os.path.dirname(__file__)))
 
 TMP_PATH = os.path.join(PYTHON_PATH, "tmp")
 
-PROTOTYPE_PATH = os.path.dirname(os.path.dirname(os.path.dirname(PYTHON_PATH)))
\ No newline at end of file
+PROTOTYPE_PATH = os.path.dirname(os.path.dirname(os.path.dirname(PYTHON_PATH)))
+
+DAPHNELIB_PATH = os.path.join(PROTOTYPE_PATH, "build", "lib", "libDaphneLib.so")
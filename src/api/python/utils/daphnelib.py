@@ -0,0 +1,238 @@
+# -------------------------------------------------------------
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+# Modifications Copyright 2022 The DAPHNE Consortium
+#
+# -------------------------------------------------------------
+"""The bindings of DaphneLib (see src/api/daphnelib/DaphneLib.h), which runs DaphneDSL scripts in this process and
+exchanges matrices with them as NumPy arrays without copying."""
+import ctypes
+import sys
+import weakref
+from typing import Iterable, List, Optional, Tuple
+
+import numpy as np
+
+from api.python.utils.consts import DAPHNELIB_PATH
+
+# the value types of DAPHNE by the NumPy types of their values
+NUMPY_TO_DAPHNE_TYPE = {
+    np.dtype(np.float64): "f64",
+    np.dtype(np.float32): "f32",
+    np.dtype(np.int64): "si64",
+    np.dtype(np.int32): "si32",
+    np.dtype(np.int8): "si8",
+    np.dtype(np.uint64): "ui64",
+    np.dtype(np.uint32): "ui32",
+    np.dtype(np.uint8): "ui8",
+}
+
+# the NumPy types by the ValueTypeCode of DAPHNE (see ValueTypeCode.h)
+VALUE_TYPE_CODE_TO_NUMPY = [
+    np.dtype(np.int8), np.dtype(np.int32), np.dtype(np.int64),
+    np.dtype(np.uint8), np.dtype(np.uint32), np.dtype(np.uint64),
+    np.dtype(np.float32), np.dtype(np.float64),
+]
+
+class DaphneLibResult(ctypes.Structure):
+    """Mirrors DaphneLibResult in src/api/daphnelib/DaphneLibResult.h."""
+    _fields_ = [
+        ("address", ctypes.c_void_p),
+        ("rows", ctypes.c_int64),
+        ("cols", ctypes.c_int64),
+        ("row_skip", ctypes.c_int64),
+        ("vtc", ctypes.c_int64),
+        ("handle", ctypes.c_void_p),
+    ]
+
+class ArrowSchema(ctypes.Structure):
+    """The ArrowSchema of Arrow's C data interface."""
+    pass
+
+ArrowSchema._fields_ = [
+    ("format", ctypes.c_char_p),
+    ("name", ctypes.c_char_p),
+    ("metadata", ctypes.c_char_p),
+    ("flags", ctypes.c_int64),
+    ("n_children", ctypes.c_int64),
+    ("children", ctypes.POINTER(ctypes.POINTER(ArrowSchema))),
+    ("dictionary", ctypes.POINTER(ArrowSchema)),
+    ("release", ctypes.c_void_p),
+    ("private_data", ctypes.c_void_p),
+]
+
+class ArrowArray(ctypes.Structure):
+    """The ArrowArray of Arrow's C data interface."""
+    pass
+
+ArrowArray._fields_ = [
+    ("length", ctypes.c_int64),
+    ("null_count", ctypes.c_int64),
+    ("offset", ctypes.c_int64),
+    ("n_buffers", ctypes.c_int64),
+    ("n_children", ctypes.c_int64),
+    ("buffers", ctypes.POINTER(ctypes.c_void_p)),
+    ("children", ctypes.POINTER(ctypes.POINTER(ArrowArray))),
+    ("dictionary", ctypes.POINTER(ArrowArray)),
+    ("release", ctypes.c_void_p),
+    ("private_data", ctypes.c_void_p),
+]
+
+_RELEASE = ctypes.CFUNCTYPE(None, ctypes.c_void_p)
+
+class ArrowCData:
+    """An ArrowArray and an ArrowSchema, through which a record batch is passed to or from a script (see the builtins
+    receiveFromArrow and sendToArrow)."""
+
+    def __init__(self):
+        self.array = ArrowArray()
+        self.schema = ArrowSchema()
+
+    @property
+    def addresses(self) -> Tuple[int, int]:
+        return ctypes.addressof(self.array), ctypes.addressof(self.schema)
+
+    def release(self):
+        """Releases what the structs hold unless the importer took it over."""
+        for struct in (self.array, self.schema):
+            if struct.release:
+                _RELEASE(struct.release)(ctypes.addressof(struct))
+
+# the value types of DAPHNE by the ids of the Arrow types of the columns they are read from (see valueTypeCodeFor in
+# src/runtime/local/io/ArrowIpc.h)
+ARROW_TO_DAPHNE_TYPE = {
+    "int8": "si8", "int16": "si32", "int32": "si32", "int64": "si64",
+    "bool": "ui8", "uint8": "ui8", "uint16": "ui32", "uint32": "ui32", "uint64": "ui64",
+    "float": "f32", "double": "f64", "string": "str", "large_string": "str",
+}
+
+def _daphne_type_of_arrow(arrow_type) -> str:
+    import pyarrow as pa
+    if pa.types.is_dictionary(arrow_type):
+        arrow_type = arrow_type.value_type
+    name = str(arrow_type)
+    if name not in ARROW_TO_DAPHNE_TYPE:
+        raise ValueError(f"columns of the Arrow type {name} cannot be passed to DAPHNE")
+    return ARROW_TO_DAPHNE_TYPE[name]
+
+def export_frame(df) -> Tuple[ArrowCData, list]:
+    """Exports the given pandas DataFrame as a record batch through Arrow's C data interface, whose numeric columns
+    share the values of the DataFrame, and returns it with the arguments of the DaphneDSL builtin receiveFromArrow
+    for it.
+    """
+    import pyarrow as pa
+    batch = pa.RecordBatch.from_pandas(df, preserve_index=False)
+    cdata = ArrowCData()
+    batch._export_to_c(*cdata.addresses)
+    value_types = ",".join(_daphne_type_of_arrow(field.type) for field in batch.schema)
+    labels = ['"' + field.name.replace('\\', '\\\\').replace('"', '\\"') + '"' for field in batch.schema]
+    return cdata, [*cdata.addresses, batch.num_rows, f'"{value_types}"', *labels]
+
+def import_frame(cdata: ArrowCData):
+    """Imports the record batch a script exported by sendToArrow as a pandas DataFrame, whose numeric columns share
+    the values of the frame of the script."""
+    import pyarrow as pa
+    batch = pa.RecordBatch._import_from_c(*cdata.addresses)
+    # split_blocks avoids consolidating the columns into one 2d block, i.e., copying them
+    return batch.to_pandas(split_blocks=True)
+
+_lib = None
+
+def _get_lib() -> ctypes.CDLL:
+    global _lib
+    if _lib is None:
+        _lib = ctypes.CDLL(DAPHNELIB_PATH)
+        _lib.daphne.argtypes = [ctypes.POINTER(DaphneLibResult), ctypes.c_int64, ctypes.c_char_p, ctypes.c_char_p]
+        _lib.daphne.restype = ctypes.c_int
+        _lib.daphneReleaseResult.argtypes = [ctypes.c_void_p]
+        _lib.daphneReleaseResult.restype = None
+    return _lib
+
+def prepare_input(mat: np.array) -> np.array:
+    """Returns the given matrix, or a copy of it if DAPHNE cannot use its values directly, i.e., if its type is not a
+    value type of DAPHNE or the values of its rows are not adjacent and in ascending order of the rows.
+
+    :param mat: a 1d or 2d array, a 1d array is a column matrix
+    """
+    mat = np.asarray(mat)
+    if mat.ndim == 1:
+        mat = mat.reshape((-1, 1))
+    if mat.ndim != 2:
+        raise ValueError(f"only 1d and 2d arrays can be passed to DAPHNE, but the array has {mat.ndim} dimensions")
+    if mat.dtype not in NUMPY_TO_DAPHNE_TYPE:
+        mat = mat.astype(np.float64)
+    rows, cols = mat.shape
+    row_stride, col_stride = mat.strides
+    if (cols > 1 and col_stride != mat.itemsize) or (rows > 1 and
+            (row_stride % mat.itemsize != 0 or row_stride < cols * mat.itemsize)):
+        mat = np.ascontiguousarray(mat)
+    return mat
+
+def receive_args(mat: np.array) -> list:
+    """Returns the arguments of the DaphneDSL builtin receiveFromNumpy for a matrix prepared by prepare_input."""
+    rows, cols = mat.shape
+    row_skip = mat.strides[0] // mat.itemsize if rows > 1 else cols
+    return [mat.ctypes.data, rows, cols, row_skip, f'"{NUMPY_TO_DAPHNE_TYPE[mat.dtype]}"']
+
+class _DaphneMatrixBuffer:
+    """The values of a matrix of DAPHNE as the base of a NumPy array, which releases the matrix once the array and
+    all views on it are gone."""
+
+    def __init__(self, lib: ctypes.CDLL, result: DaphneLibResult, inputs: Iterable[np.array]):
+        # the result may be a view on the values of an input
+        self._inputs = list(inputs)
+        dtype = VALUE_TYPE_CODE_TO_NUMPY[result.vtc]
+        self.__array_interface__ = {
+            "shape": (result.rows, result.cols),
+            "typestr": dtype.str,
+            "data": (result.address, False),
+            "strides": (result.row_skip * dtype.itemsize, dtype.itemsize),
+            "version": 3,
+        }
+        weakref.finalize(self, lib.daphneReleaseResult, result.handle)
+
+def _to_array(lib: ctypes.CDLL, result: DaphneLibResult, inputs: List[np.array]) -> Optional[np.array]:
+    if not result.handle:
+        return None
+    if result.rows == 0 or result.cols == 0:
+        lib.daphneReleaseResult(result.handle)
+        return np.empty((result.rows, result.cols), dtype=VALUE_TYPE_CODE_TO_NUMPY[result.vtc])
+    return np.asarray(_DaphneMatrixBuffer(lib, result, inputs))
+
+def run_script(script_path: str, inputs: Iterable[np.array] = (), num_results: int = 1,
+               config_path: str = None) -> List[Optional[np.array]]:
+    """Runs the given DaphneDSL script in this process and returns the matrices it passed to saveDaphneLibResult by
+    their indices (None for an index without a matrix) without copying their values.
+
+    :param script_path: the path of the script
+    :param inputs: the arrays passed to the script by receiveFromNumpy, which must not change until it returns
+    :param num_results: the number of result indices of the script
+    :param config_path: the path of a user config file (see UserConfig.json)
+    """
+    lib = _get_lib()
+    inputs = list(inputs)
+    # the prints of the script are flushed to the same file descriptors
+    sys.stdout.flush()
+    sys.stderr.flush()
+    results = (DaphneLibResult * max(num_results, 1))()
+    status = lib.daphne(results, num_results, script_path.encode(),
+                        config_path.encode() if config_path else None)
+    if status != 0:
+        raise RuntimeError(f"the DaphneDSL script {script_path} failed with status {status}")
+    return [_to_array(lib, results[i], inputs) for i in range(num_results)]
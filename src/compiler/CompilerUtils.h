@@ -19,8 +19,12 @@
 #include <ir/daphneir/Daphne.h>
 #include <parser/metadata/MetaDataParser.h>
 
+#include <mlir/Interfaces/SideEffectInterfaces.h>
+#include <mlir/IR/Location.h>
 #include <mlir/IR/Value.h>
 
+#include <algorithm>
+#include <optional>
 #include <stdexcept>
 #include <string>
 
@@ -140,6 +144,50 @@ namespace CompilerUtils {
         return dctx;
     }
     
+    /**
+     * @brief Returns the estimated size of a value in bytes from the shape, value type, representation, and sparsity
+     * of its matrix type (0 for scalars), or `std::nullopt` if they are unknown.
+     */
+    [[maybe_unused]] static std::optional<size_t> estimateBytes(mlir::Value v) {
+        auto matTy = v.getType().dyn_cast<mlir::daphne::MatrixType>();
+        if(!matTy)
+            return v.getType().isa<mlir::daphne::FrameType>() ? std::nullopt : std::optional<size_t>(0);
+        const ssize_t numRows = matTy.getNumRows();
+        const ssize_t numCols = matTy.getNumCols();
+        if(numRows == -1 || numCols == -1 || !matTy.getElementType().isIntOrFloat())
+            return std::nullopt;
+        const double numCells = static_cast<double>(numRows) * numCols;
+        const size_t vtBytes = std::max(1u, matTy.getElementType().getIntOrFloatBitWidth() / 8);
+        if(matTy.getRepresentation() == mlir::daphne::MatrixRepresentation::Sparse) {
+            const double sparsity = matTy.getSparsity() < 0 ? 1.0 : matTy.getSparsity();
+            // the values and column indexes of the non-zeros, and the row offsets
+            return static_cast<size_t>(numCells * sparsity * (vtBytes + sizeof(size_t)))
+                    + (numRows + 1) * sizeof(size_t);
+        }
+        return static_cast<size_t>(numCells * vtBytes);
+    }
+
+    /**
+     * @brief Returns the file, line, and column of the DaphneDSL statement of an operation, also of operations fused
+     * from several ones, or "unknown".
+     */
+    [[maybe_unused]] static std::string getLocationString(mlir::Location loc) { // NOLINT(misc-no-recursion)
+        if(auto fileLoc = loc.dyn_cast<mlir::FileLineColLoc>())
+            return fileLoc.getFilename().str() + ":" + std::to_string(fileLoc.getLine()) + ":"
+                    + std::to_string(fileLoc.getColumn());
+        if(auto nameLoc = loc.dyn_cast<mlir::NameLoc>())
+            return getLocationString(nameLoc.getChildLoc());
+        if(auto callLoc = loc.dyn_cast<mlir::CallSiteLoc>())
+            return getLocationString(callLoc.getCallee());
+        if(auto fusedLoc = loc.dyn_cast<mlir::FusedLoc>())
+            for(mlir::Location subLoc : fusedLoc.getLocations()) {
+                std::string str = getLocationString(subLoc);
+                if(str != "unknown")
+                    return str;
+            }
+        return "unknown";
+    }
+
     [[maybe_unused]] static bool isObjType(mlir::Type t) {
         return t.isa<mlir::daphne::MatrixType, mlir::daphne::FrameType>();
     }
@@ -148,4 +196,82 @@ namespace CompilerUtils {
         return isObjType(v.getType());
     }
 
+    /**
+     * @brief Returns if the operation has no side effects, such that it may be
+     * merged with an equal operation or moved out of a loop, as long as its
+     * operands are defined there.
+     *
+     * Besides the operations declaring no memory effects, these are the
+     * vectorizable computations and the other elementwise unary operations,
+     * aggregations, casts, and matrix multiplications. Operations with regions
+     * are never considered, and neither are the reference counting operations.
+     */
+    [[maybe_unused]] static bool isSideEffectFree(mlir::Operation * op) {
+        if(op->getNumRegions() != 0 || op->getNumResults() == 0)
+            return false;
+        if(llvm::isa<mlir::daphne::IncRefOp, mlir::daphne::DecRefOp>(op))
+            return false;
+        if(auto memInterface = llvm::dyn_cast<mlir::MemoryEffectOpInterface>(op))
+            if(memInterface.hasNoEffect())
+                return true;
+        return llvm::isa<
+                mlir::daphne::Vectorizable,
+                mlir::daphne::EwMinusOp, mlir::daphne::EwAbsOp, mlir::daphne::EwSignOp, mlir::daphne::EwExpOp,
+                mlir::daphne::EwLnOp, mlir::daphne::EwNegOp, mlir::daphne::EwRoundOp, mlir::daphne::EwFloorOp,
+                mlir::daphne::EwCeilOp, mlir::daphne::EwSinOp, mlir::daphne::EwCosOp, mlir::daphne::EwTanOp,
+                mlir::daphne::EwSinhOp, mlir::daphne::EwCoshOp, mlir::daphne::EwTanhOp, mlir::daphne::EwAsinOp,
+                mlir::daphne::EwAcosOp, mlir::daphne::EwAtanOp,
+                mlir::daphne::AllAggSumOp, mlir::daphne::AllAggMinOp, mlir::daphne::AllAggMaxOp,
+                mlir::daphne::AllAggMeanOp, mlir::daphne::AllAggVarOp, mlir::daphne::AllAggStddevOp,
+                mlir::daphne::RowAggIdxMinOp, mlir::daphne::RowAggIdxMaxOp, mlir::daphne::RowAggMeanOp,
+                mlir::daphne::RowAggVarOp, mlir::daphne::RowAggStddevOp,
+                mlir::daphne::ColAggMinOp, mlir::daphne::ColAggMaxOp, mlir::daphne::ColAggIdxMinOp,
+                mlir::daphne::ColAggIdxMaxOp, mlir::daphne::ColAggMeanOp, mlir::daphne::ColAggVarOp,
+                mlir::daphne::ColAggStddevOp,
+                mlir::daphne::TransposeOp, mlir::daphne::SyrkOp, mlir::daphne::GemvOp, mlir::daphne::MatMulOp,
+                mlir::daphne::CastOp
+        >(op);
+    }
+
+    /**
+     * @brief Returns if the operation is a scalar arithmetic operation,
+     * comparison, or cast which is lowered to LLVM IR directly (see
+     * LowerToLLVMPass) instead of a call of the EwBinarySca, EwUnarySca, or
+     * CastSca kernel.
+     *
+     * These are the operations on integers (except booleans) and
+     * floating-point numbers whose operands have the type of the result
+     * (comparisons and logical operations may yield any such type or a
+     * boolean), and the casts between such types and booleans.
+     */
+    [[maybe_unused]] static bool isInlinedScalarOp(mlir::Operation * op) {
+        auto isNumber = [](mlir::Type t) {
+            return t.isF32() || t.isF64() || (t.isa<mlir::IntegerType>() && t.getIntOrFloatBitWidth() > 1);
+        };
+        auto isNumberOrBool = [&](mlir::Type t) {
+            return isNumber(t) || t.isSignlessInteger(1);
+        };
+        if(op->getNumResults() != 1)
+            return false;
+        const mlir::Type resType = op->getResult(0).getType();
+        auto hasOperandsOf = [&](mlir::Type t) {
+            return llvm::all_of(op->getOperandTypes(), [&](mlir::Type o) { return o == t; });
+        };
+
+        if(llvm::isa<mlir::daphne::EwAddOp, mlir::daphne::EwSubOp, mlir::daphne::EwMulOp, mlir::daphne::EwDivOp,
+                mlir::daphne::EwModOp, mlir::daphne::EwMinOp, mlir::daphne::EwMaxOp, mlir::daphne::EwMinusOp,
+                mlir::daphne::EwAbsOp>(op))
+            return isNumber(resType) && hasOperandsOf(resType);
+        if(llvm::isa<mlir::daphne::EwPowOp, mlir::daphne::EwSqrtOp, mlir::daphne::EwExpOp, mlir::daphne::EwLnOp,
+                mlir::daphne::EwFloorOp, mlir::daphne::EwCeilOp>(op))
+            return resType.isa<mlir::FloatType>() && isNumber(resType) && hasOperandsOf(resType);
+        if(llvm::isa<mlir::daphne::EwEqOp, mlir::daphne::EwNeqOp, mlir::daphne::EwLtOp, mlir::daphne::EwLeOp,
+                mlir::daphne::EwGtOp, mlir::daphne::EwGeOp, mlir::daphne::EwAndOp, mlir::daphne::EwOrOp>(op))
+            return isNumberOrBool(resType) && isNumber(op->getOperand(0).getType())
+                    && hasOperandsOf(op->getOperand(0).getType());
+        if(auto castOp = llvm::dyn_cast<mlir::daphne::CastOp>(op))
+            return isNumberOrBool(resType) && isNumberOrBool(castOp.arg().getType()) && !castOp.isTrivialCast();
+        return false;
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+#include "AdaptiveRecompiler.h"
+#include "DaphneIrExecutor.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/SHA1.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Parser.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cmath>
+
+AdaptiveRecompiler::AdaptiveRecompiler(DaphneIrExecutor & executor, const std::string & jitCacheDir)
+    : executor_(executor), jitCache_(jitCacheDir) {
+}
+
+double AdaptiveRecompiler::sparsityBucket(const ObservedProperties & props)
+{
+    const size_t numCells = props.numRows * props.numCols;
+    if(props.numNonZeros < 0 || numCells == 0)
+        return -1.0;
+    const double sparsity = static_cast<double>(props.numNonZeros) / numCells;
+    if(sparsity == 0.0)
+        return 0.0;
+    return std::min(1.0, std::exp2(std::ceil(std::log2(sparsity))));
+}
+
+namespace {
+    mlir::Type specializeType(mlir::Type t, const ObservedProperties & props) {
+        const auto numRows = static_cast<ssize_t>(props.numRows);
+        const auto numCols = static_cast<ssize_t>(props.numCols);
+        if(auto matTy = t.dyn_cast<mlir::daphne::MatrixType>())
+            return matTy
+                    .withShape(numRows, numCols)
+                    .withSparsity(AdaptiveRecompiler::sparsityBucket(props))
+                    .withRepresentation(props.isSparse
+                            ? mlir::daphne::MatrixRepresentation::Sparse
+                            : mlir::daphne::MatrixRepresentation::Dense);
+        if(auto frmTy = t.dyn_cast<mlir::daphne::FrameType>())
+            return frmTy.withShape(numRows, numCols);
+        return t;
+    }
+}
+
+std::shared_ptr<JitProgram> AdaptiveRecompiler::compile(const char * ir, const ObservedProperties * props,
+                                                        size_t numArgs)
+{
+    llvm::SHA1 hash;
+    hash.update(llvm::StringRef(ir));
+    std::string key = llvm::toHex(hash.final(), true);
+    for(size_t i = 0; i < numArgs; i++)
+        key += "|" + std::to_string(props[i].numRows) + "x" + std::to_string(props[i].numCols)
+                + (props[i].isSparse ? "s" : "d") + std::to_string(sparsityBucket(props[i]));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = programs_.find(key);
+    if(it != programs_.end())
+        return it->second;
+
+    mlir::OwningModuleRef module(mlir::parseSourceString<mlir::ModuleOp>(ir, executor_.getContext()));
+    if(!module)
+        throw std::runtime_error("adaptive execution: failed to parse the remainder of the function");
+    auto tailFunc = module->lookupSymbol<mlir::FuncOp>(mlir::daphne::ADAPTIVE_TAIL_FUNC);
+    if(!tailFunc || tailFunc.getNumArguments() != numArgs)
+        throw std::runtime_error("adaptive execution: the remainder of the function does not match its arguments");
+
+    std::vector<mlir::Type> argTypes;
+    mlir::Block & body = tailFunc.body().front();
+    for(size_t i = 0; i < numArgs; i++) {
+        mlir::Type t = specializeType(tailFunc.getType().getInput(i), props[i]);
+        body.getArgument(i).setType(t);
+        argTypes.push_back(t);
+    }
+    tailFunc.setType(mlir::FunctionType::get(executor_.getContext(), argTypes, {}));
+
+    if(!executor_.runPasses(module.get()))
+        throw std::runtime_error("adaptive execution: failed to compile the remainder of the function");
+    auto program = executor_.createJitProgram(module.get(), mlir::daphne::ADAPTIVE_TAIL_FUNC, jitCache_);
+    if(!program)
+        throw std::runtime_error("adaptive execution: failed to JIT-compile the remainder of the function");
+    programs_.emplace(key, program);
+    return program;
+}
+
+void AdaptiveRecompiler::run(const char * ir, const Structure ** args, const ObservedProperties * props,
+                             size_t numArgs)
+{
+    // The remainder may reach the next checkpoint, so the lock is only held while compiling.
+    std::shared_ptr<JitProgram> program = compile(ir, props, numArgs);
+
+    // packed arguments, i.e., pointers to the pointers to the data objects
+    std::vector<const Structure *> argPtrs(args, args + numArgs);
+    std::vector<void *> packedArgs;
+    for(const Structure *& arg : argPtrs)
+        packedArgs.push_back(&arg);
+    if(auto error = program->invokePacked(mlir::daphne::ADAPTIVE_TAIL_FUNC, packedArgs))
+        throw std::runtime_error("adaptive execution: failed to run the remainder of the function: "
+                + llvm::toString(std::move(error)));
+}
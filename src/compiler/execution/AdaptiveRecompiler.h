@@ -0,0 +1,71 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_COMPILER_EXECUTION_ADAPTIVERECOMPILER_H
+#define SRC_COMPILER_EXECUTION_ADAPTIVERECOMPILER_H
+
+#pragma once
+
+#include <compiler/execution/JitObjectCache.h>
+#include <runtime/local/context/AdaptiveExecution.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class DaphneIrExecutor;
+class Structure;
+
+/**
+ * @brief Compiles the remainder of a function after an adaptive checkpoint
+ * (see `AdaptiveCheckpointsPass`) for the properties of its arguments
+ * observed at run-time, and runs it.
+ *
+ * The types of the arguments get the actual shapes, representations, and
+ * sparsities, such that property inference, the selection of
+ * representations and kernels, and the vectorization follow the real data.
+ * The compiled remainders are cached per shape bucket, i.e., per IR and
+ * exact shapes and representations of the arguments, but with the sparsity
+ * rounded up to a power of two. The shapes stay exact, since the number of
+ * rows and columns are folded from the types into the code. The sparsity is
+ * an estimate anyway, so remainders called on data of a similar density
+ * share their code. Scalars are passed as 1x1 matrices, whose values do not
+ * affect the bucket.
+ */
+class AdaptiveRecompiler
+{
+public:
+    AdaptiveRecompiler(DaphneIrExecutor & executor, const std::string & jitCacheDir);
+
+    void run(const char * ir, const Structure ** args, const ObservedProperties * props, size_t numArgs);
+
+    /**
+     * @brief The sparsity the remainder is compiled for, i.e., the observed
+     * sparsity rounded up to a power of two, or -1 if unknown.
+     */
+    static double sparsityBucket(const ObservedProperties & props);
+private:
+    std::shared_ptr<JitProgram> compile(const char * ir, const ObservedProperties * props, size_t numArgs);
+
+    DaphneIrExecutor & executor_;
+    JitObjectCache jitCache_;
+    // the compiled remainders by the IR and the shape buckets of their arguments
+    std::map<std::string, std::shared_ptr<JitProgram>> programs_;
+    std::mutex mutex_;
+};
+
+#endif //SRC_COMPILER_EXECUTION_ADAPTIVERECOMPILER_H
@@ -0,0 +1,161 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "CompileStatistics.h"
+
+#include "llvm/Support/Format.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+const std::vector<std::pair<std::string, std::string>> CompileStatistics::TRACKED_OPS = {
+    {"vectorizedPipelines", "daphne.vectorizedPipeline"},
+    {"fusedOps", "daphne.ewFused"},
+    {"kernelCalls", "daphne.call_kernel"},
+};
+
+size_t CompileStatistics::maxTrackedOps(const std::string & name) const
+{
+    size_t res = 0;
+    for(auto & p : passes) {
+        auto it = p.trackedOps.find(name);
+        if(it != p.trackedOps.end())
+            res = std::max(res, it->second);
+    }
+    return res;
+}
+
+void CompileStatistics::print(llvm::raw_ostream & os) const
+{
+    double passSeconds = 0;
+    os << "===== Compile statistics =====\n";
+    os << llvm::format("%10s  %10s  %10s  %s\n", "time [ms]", "ops before", "ops after", "pass");
+    for(auto & p : passes) {
+        os << llvm::format("%10.3f  %10zu  %10zu  ", p.seconds * 1e3, p.opsBefore, p.opsAfter) << p.name << "\n";
+        passSeconds += p.seconds;
+    }
+    os << llvm::format("%10.3f  ", passSeconds * 1e3) << "total of all passes\n";
+    os << llvm::format("%10.3f  ", jitSeconds * 1e3) << "JIT compilation (" << jitCompilations
+            << " compiled, " << jitCacheHits << " cache hits)\n";
+    os << llvm::format("%10.3f  ", libraryLoadSeconds * 1e3) << "loading " << libraries.size()
+            << " kernel libraries\n";
+    os << "inference: " << inference.numRuns << " runs, " << inference.numVisits << " visits of ops, "
+            << inference.numRefined << " refined, " << inference.numFolded << " folded, " << inference.numRewritten
+            << " rewritten, " << inference.numNotConverged << " not converged\n";
+    for(auto & tracked : TRACKED_OPS)
+        os << tracked.first << ": " << maxTrackedOps(tracked.first) << "\n";
+}
+
+nlohmann::json CompileStatistics::toJson() const
+{
+    nlohmann::json res;
+    nlohmann::json jsonPasses = nlohmann::json::array();
+    double passSeconds = 0;
+    for(auto & p : passes) {
+        nlohmann::json jsonPass = {
+            {"name", p.name},
+            {"seconds", p.seconds},
+            {"opsBefore", p.opsBefore},
+            {"opsAfter", p.opsAfter},
+        };
+        for(auto & tracked : p.trackedOps)
+            jsonPass[tracked.first] = tracked.second;
+        jsonPasses.push_back(jsonPass);
+        passSeconds += p.seconds;
+    }
+    res["passes"] = jsonPasses;
+    res["passSeconds"] = passSeconds;
+    res["jit"] = {
+        {"seconds", jitSeconds},
+        {"compilations", jitCompilations},
+        {"cacheHits", jitCacheHits},
+    };
+    res["libraries"] = {
+        {"seconds", libraryLoadSeconds},
+        {"paths", libraries},
+    };
+    res["inference"] = {
+        {"runs", inference.numRuns},
+        {"visits", inference.numVisits},
+        {"refined", inference.numRefined},
+        {"folded", inference.numFolded},
+        {"rewritten", inference.numRewritten},
+        {"notConverged", inference.numNotConverged},
+    };
+    for(auto & tracked : TRACKED_OPS)
+        res[tracked.first] = maxTrackedOps(tracked.first);
+    return res;
+}
+
+void CompileStatistics::writeJson(const std::string & filename) const
+{
+    std::ofstream ofs(filename);
+    if(!ofs)
+        throw std::runtime_error("could not open file '" + filename + "' for writing the compile statistics");
+    ofs << toJson().dump(2) << std::endl;
+}
+
+namespace {
+    // The passes nesting others, e.g., the ones run on each function, are recorded by the nested passes.
+    bool isAdaptor(mlir::Pass * pass) {
+        return pass->getName().contains("OpToOpPassAdaptor");
+    }
+
+    size_t countOps(mlir::Operation * op) {
+        size_t res = 0;
+        op->walk([&](mlir::Operation *) { res++; });
+        return res;
+    }
+}
+
+void CompileStatisticsInstrumentation::runBeforePass(mlir::Pass * pass, mlir::Operation * op)
+{
+    if(isAdaptor(pass))
+        return;
+    auto it = recordIdxs_.find(pass);
+    if(it == recordIdxs_.end()) {
+        it = recordIdxs_.emplace(pass, stats_.passes.size()).first;
+        CompileStatistics::PassRecord record;
+        record.name = pass->getName().str();
+        stats_.passes.push_back(record);
+    }
+    stats_.passes[it->second].opsBefore += countOps(op);
+    starts_[pass] = std::chrono::steady_clock::now();
+}
+
+void CompileStatisticsInstrumentation::runAfterPass(mlir::Pass * pass, mlir::Operation * op)
+{
+    if(isAdaptor(pass))
+        return;
+    const auto end = std::chrono::steady_clock::now();
+    CompileStatistics::PassRecord & record = stats_.passes[recordIdxs_.at(pass)];
+    record.seconds += std::chrono::duration<double>(end - starts_.at(pass)).count();
+    op->walk([&](mlir::Operation * o) {
+        record.opsAfter++;
+        const llvm::StringRef opName = o->getName().getStringRef();
+        for(auto & tracked : CompileStatistics::TRACKED_OPS)
+            if(opName == tracked.second)
+                record.trackedOps[tracked.first]++;
+    });
+    for(auto & tracked : CompileStatistics::TRACKED_OPS)
+        record.trackedOps.emplace(tracked.first, 0);
+}
+
+void CompileStatisticsInstrumentation::runAfterPassFailed(mlir::Pass * pass, mlir::Operation * op)
+{
+    runAfterPass(pass, op);
+}
@@ -0,0 +1,103 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_COMPILER_EXECUTION_COMPILESTATISTICS_H
+#define SRC_COMPILER_EXECUTION_COMPILESTATISTICS_H
+
+#pragma once
+
+#include <ir/daphneir/Passes.h>
+
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassInstrumentation.h"
+
+#include <nlohmannjson/json.hpp>
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Statistics of the compilation of a DaphneDSL script: the wall time
+ * and the number of ops before and after each pass, the maximum number of
+ * vectorized pipelines, fused elementwise ops, and kernel calls in the IR,
+ * the time of the JIT compilation, and the kernel libraries loaded for the
+ * compiled code and the time of loading them, and the work of the property
+ * inference until its fixpoint.
+ *
+ * The statistics are reported in a human-readable form and as JSON, such
+ * that regressions of the compile latency can be tracked across versions.
+ */
+class CompileStatistics
+{
+public:
+    struct PassRecord {
+        std::string name;
+        double seconds = 0;
+        size_t opsBefore = 0;
+        size_t opsAfter = 0;
+        // the number of ops of interest (see TRACKED_OPS) after the pass
+        std::map<std::string, size_t> trackedOps;
+    };
+
+    // the ops counted after each pass, by their name in the statistics
+    static const std::vector<std::pair<std::string, std::string>> TRACKED_OPS;
+
+    std::vector<PassRecord> passes;
+    double jitSeconds = 0;
+    size_t jitCompilations = 0;
+    size_t jitCacheHits = 0;
+    std::set<std::string> libraries;
+    double libraryLoadSeconds = 0;
+    mlir::daphne::InferenceStatistics inference;
+
+    /**
+     * @brief The maximum number of the given tracked ops after any pass.
+     */
+    size_t maxTrackedOps(const std::string & name) const;
+
+    void print(llvm::raw_ostream & os) const;
+    nlohmann::json toJson() const;
+    void writeJson(const std::string & filename) const;
+};
+
+/**
+ * @brief Records the statistics of each pass run by a pass manager.
+ *
+ * The passes are identified by their address, so the instrumentation must
+ * not outlive its pass manager, and the passes on functions must not run in
+ * parallel (see `mlir::MLIRContext::disableMultithreading`). The records of
+ * a pass run on several functions are summed up.
+ */
+class CompileStatisticsInstrumentation : public mlir::PassInstrumentation
+{
+public:
+    explicit CompileStatisticsInstrumentation(CompileStatistics & stats) : stats_(stats) {}
+
+    void runBeforePass(mlir::Pass * pass, mlir::Operation * op) override;
+    void runAfterPass(mlir::Pass * pass, mlir::Operation * op) override;
+    void runAfterPassFailed(mlir::Pass * pass, mlir::Operation * op) override;
+private:
+    CompileStatistics & stats_;
+    std::map<mlir::Pass *, size_t> recordIdxs_;
+    std::map<mlir::Pass *, std::chrono::steady_clock::time_point> starts_;
+};
+
+#endif //SRC_COMPILER_EXECUTION_COMPILESTATISTICS_H
@@ -18,7 +18,22 @@
 #include <ir/daphneir/Passes.h>
 #include "DaphneIrExecutor.h"
 
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassTimingInfo.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Target/TargetMachine.h"
 #include "mlir/Conversion/SCFToStandard/SCFToStandard.h"
 #include "mlir/Dialect/SCF/SCF.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
@@ -31,9 +46,96 @@
 #include <mlir/Dialect/LLVMIR/LLVMDialect.h>
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
+#include "mlir/Target/LLVMIR/Export.h"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <memory>
+#include <set>
+#include <string>
 #include <utility>
+#include <vector>
+
+static llvm::CodeGenOpt::Level getCodeGenOptLevel(unsigned optLevel)
+{
+    return optLevel == 0 ? llvm::CodeGenOpt::None
+            : optLevel == 1 ? llvm::CodeGenOpt::Less
+            : optLevel == 2 ? llvm::CodeGenOpt::Default
+            : llvm::CodeGenOpt::Aggressive;
+}
+
+/**
+ * @brief Adds the packed wrapper `_mlir_<name>(i8 ** args)` of each function
+ * defined in the module, like `mlir::ExecutionEngine` does, and returns the
+ * pairs of functions and their wrappers.
+ */
+static std::vector<std::pair<llvm::Function *, llvm::Function *>> packFunctionArguments(llvm::Module & module)
+{
+    std::vector<llvm::Function *> funcs;
+    for(llvm::Function & func : module.functions())
+        if(!func.isDeclaration())
+            funcs.push_back(&func);
+
+    llvm::LLVMContext & ctx = module.getContext();
+    llvm::IRBuilder<> builder(ctx);
+    std::vector<std::pair<llvm::Function *, llvm::Function *>> wrappers;
+    for(llvm::Function * func : funcs) {
+        auto wrapperType = llvm::FunctionType::get(
+                builder.getVoidTy(), builder.getInt8PtrTy()->getPointerTo(), /*isVarArg=*/false
+        );
+        auto wrapper = llvm::cast<llvm::Function>(
+                module.getOrInsertFunction(("_mlir_" + func->getName()).str(), wrapperType).getCallee()
+        );
+        builder.SetInsertPoint(llvm::BasicBlock::Create(ctx, "", wrapper));
+        llvm::Value * argList = wrapper->arg_begin();
+
+        // the arguments are pointers to the values, followed by a pointer to the result
+        std::vector<llvm::Value *> args;
+        for(llvm::Argument & arg : func->args()) {
+            llvm::Value * argPtrPtr = builder.CreateGEP(builder.getInt8PtrTy(), argList, builder.getInt64(arg.getArgNo()));
+            llvm::Value * argPtr = builder.CreateLoad(builder.getInt8PtrTy(), argPtrPtr);
+            argPtr = builder.CreateBitCast(argPtr, arg.getType()->getPointerTo());
+            args.push_back(builder.CreateLoad(arg.getType(), argPtr));
+        }
+        llvm::Value * result = builder.CreateCall(func, args);
+        if(!result->getType()->isVoidTy()) {
+            llvm::Value * retPtrPtr = builder.CreateGEP(builder.getInt8PtrTy(), argList, builder.getInt64(args.size()));
+            llvm::Value * retPtr = builder.CreateLoad(builder.getInt8PtrTy(), retPtrPtr);
+            builder.CreateStore(result, builder.CreateBitCast(retPtr, result->getType()->getPointerTo()));
+        }
+        builder.CreateRetVoid();
+        wrappers.emplace_back(func, wrapper);
+    }
+    return wrappers;
+}
+
+/**
+ * @brief Distributes the given functions (and their wrappers) over at most
+ * `numParts` partitions of about the same number of instructions, the largest
+ * functions first, and the global variables to the first partition.
+ */
+static std::vector<llvm::DenseSet<const llvm::GlobalValue *>> partitionModule(
+        llvm::Module & module, const std::vector<std::pair<llvm::Function *, llvm::Function *>> & funcs,
+        unsigned numParts)
+{
+    std::vector<std::pair<size_t, size_t>> sizes; // number of instructions, index into funcs
+    for(size_t i = 0; i < funcs.size(); i++)
+        sizes.emplace_back(funcs[i].first->getInstructionCount(), i);
+    std::sort(sizes.rbegin(), sizes.rend());
+
+    std::vector<llvm::DenseSet<const llvm::GlobalValue *>> parts(std::max(1u, numParts));
+    std::vector<size_t> partSizes(parts.size(), 0);
+    for(auto & entry : sizes) {
+        const size_t p = std::min_element(partSizes.begin(), partSizes.end()) - partSizes.begin();
+        partSizes[p] += entry.first;
+        parts[p].insert(funcs[entry.second].first);
+        parts[p].insert(funcs[entry.second].second);
+    }
+    for(llvm::GlobalVariable & global : module.globals())
+        parts[0].insert(&global);
+    return parts;
+}
 
 DaphneIrExecutor::DaphneIrExecutor(bool selectMatrixRepresentations,
                                    DaphneUserConfig cfg)
@@ -46,9 +148,40 @@ DaphneIrExecutor::DaphneIrExecutor(bool selectMatrixRepresentations,
 
     llvm::InitializeNativeTarget();
     llvm::InitializeNativeTargetAsmPrinter();
+
+    // The passes nested on the functions run on the functions in parallel, except with a single compile thread or
+    // with statistics, which identify the passes by their addresses and thus require running them one after the
+    // other.
+    if(userConfig_.compile_statistics || getNumCompileThreads() == 1)
+        context_.disableMultithreading();
+
+    // The compiled code calls back into this executor at adaptive checkpoints, through the copy of the user config
+    // it refers to (see createJitProgram()).
+    if(userConfig_.adaptive_execution) {
+        adaptiveRecompiler_ = std::make_unique<AdaptiveRecompiler>(*this, userConfig_.jit_cache_dir);
+        userConfig_.adaptive_call = [this](const char * ir, const Structure ** args, const ObservedProperties * props,
+                size_t numArgs) {
+            adaptiveRecompiler_->run(ir, args, props, numArgs);
+        };
+    }
+
+    // Without an index (e.g., kernels built without the categories), all kernels are in the configured libraries.
+    std::ifstream index(getKernelLibDir() + "/kernels.index");
+    std::string line;
+    while(std::getline(index, line)) {
+        const size_t tab = line.find('\t');
+        if(line.empty() || line[0] == '#' || tab == std::string::npos)
+            continue;
+        kernelLibraryIndex_.emplace(line.substr(tab + 1), line.substr(0, tab));
+    }
 }
 
 bool DaphneIrExecutor::runPasses(mlir::ModuleOp module)
+{
+    return runSimplificationPasses(module) && runLoweringPasses(module);
+}
+
+bool DaphneIrExecutor::runSimplificationPasses(mlir::ModuleOp module)
 {
     // FIXME: operations in `template` functions (functions with unknown inputs) can't be verified
     //  as their type constraints are not met.
@@ -63,9 +196,15 @@ bool DaphneIrExecutor::runPasses(mlir::ModuleOp module)
         {
             mlir::PassManager pm(&context_);
             pm.enableVerifier(false);
+            if(userConfig_.timing_passes)
+                pm.enableTiming();
+            if(userConfig_.compile_statistics)
+                pm.addInstrumentation(std::make_unique<CompileStatisticsInstrumentation>(statistics_));
             if(userConfig_.explain_parsing)
                 pm.addPass(mlir::daphne::createPrintIRPass("IR after parsing:"));
             pm.addPass(mlir::daphne::createSpecializeGenericFunctionsPass());
+            if(userConfig_.function_inlining)
+                pm.addPass(mlir::daphne::createInlineFunctionsPass());
             //pm.addPass(mlir::daphne::createPrintIRPass("IR after specializing generic functions:"));
             if(failed(pm.run(module))) {
                 module->dump();
@@ -74,63 +213,157 @@ bool DaphneIrExecutor::runPasses(mlir::ModuleOp module)
             }
         }
         mlir::PassManager pm(&context_);
+        if(userConfig_.timing_passes)
+            pm.enableTiming();
+        if(userConfig_.compile_statistics)
+            pm.addInstrumentation(std::make_unique<CompileStatisticsInstrumentation>(statistics_));
         pm.addPass(mlir::createCanonicalizerPass());
         if(userConfig_.explain_parsing_simplified)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after parsing and some simplifications:"));
+        if(failed(pm.run(module))) {
+            module->dump();
+            module->emitError("module pass error");
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool DaphneIrExecutor::runLoweringPasses(mlir::ModuleOp module)
+{
+    if (module) {
+        llvm::DebugFlag = userConfig_.debug_llvm;
+        mlir::PassManager pm(&context_);
+        if(userConfig_.timing_passes)
+            pm.enableTiming();
+        if(userConfig_.compile_statistics)
+            pm.addInstrumentation(std::make_unique<CompileStatisticsInstrumentation>(statistics_));
         pm.addPass(mlir::daphne::createRewriteSqlOpPass()); // calls SQL Parser
         if(userConfig_.explain_sql)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after SQL parsing:"));
 
-        // TODO There is a cyclic dependency between (shape) inference and
-        // constant folding (included in canonicalization), at the moment we
-        // run only three iterations of both passes (see #173).
-        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass());
-        pm.addPass(mlir::createCanonicalizerPass());
-        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass());
-        pm.addPass(mlir::createCanonicalizerPass());
-        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass());
-        pm.addPass(mlir::createCanonicalizerPass());
-        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass());
-        pm.addPass(mlir::createCanonicalizerPass());
+        // The canonicalization is nested on the functions like the other passes, such that the consecutive nested
+        // passes run on all functions in parallel (see getNumCompileThreads()).
+        //
+        // There is a cyclic dependency between (shape) inference and constant folding (included in
+        // canonicalization, see #173). The InferencePass resolves it by a worklist of the ops whose operands
+        // changed, which it folds, canonicalizes, and infers again until nothing changes anymore. The
+        // canonicalizer afterwards removes the ops that became dead.
+        mlir::daphne::InferenceConfig inferenceCfg(
+                false, true, true, true, true, userConfig_.sparsity_worst_case, true
+        );
+        if(userConfig_.compile_statistics)
+            inferenceCfg.statistics = &statistics_.inference;
+        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass(inferenceCfg));
+        pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+        // Matrix expressions on constants are evaluated by the kernels, which are loaded for this, and their exact
+        // shapes and sparsities are propagated.
+        if(userConfig_.constant_folding_max_bytes && loadSharedLibs(getSharedLibPaths(module))) {
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createFoldConstantMatricesPass(userConfig_));
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass(inferenceCfg));
+            pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+        }
+        // Loops over the rows of matrices become whole-matrix operations on the inferred shapes, before the
+        // representations are selected and the operations are vectorized.
+        if(userConfig_.loop_rewrite) {
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createRewriteLoopsToMatrixOpsPass(userConfig_.explain_loops));
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass(inferenceCfg));
+            pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+        }
+        // The optimization of the SQL queries needs the inferred frame labels and numbers of rows.
+        if(userConfig_.sql_optimization) {
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createOptimizeSqlPass());
+            if(userConfig_.explain_sql)
+                pm.addPass(mlir::daphne::createPrintIRPass("IR after SQL optimization:"));
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass(inferenceCfg));
+            pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+        }
+        // The Bloom filters of the joins are pushed down the plans the SQL optimization chose, and need the inferred
+        // frame labels, column types, and numbers of rows as well.
+        if(userConfig_.bloom_filters) {
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createPushDownBloomFiltersPass());
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInferencePass(inferenceCfg));
+            pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+        }
         //pm.addPass(mlir::daphne::createPrintIRPass("IR after property inference"));
 
-        if(selectMatrixRepresentations_) {
-            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createSelectMatrixRepresentationsPass());
-            //pm.addPass(mlir::daphne::createPrintIRPass("IR after selecting matrix representation"));
+        // Split main after the first op of an unknown result shape, such that the remainder is compiled at run-time
+        // for the actual shape, before any decisions depend on it.
+        if(userConfig_.adaptive_execution) {
+            pm.addPass(mlir::daphne::createAdaptiveCheckpointsPass());
+            if(userConfig_.explain_property_inference)
+                pm.addPass(mlir::daphne::createPrintIRPass("IR after inserting adaptive checkpoints"));
         }
 
+        // Without the selection for all matrices, only the representations requested by DaphneDSL annotations
+        // (`@sparse`, `@dense`) are set.
+        pm.addNestedPass<mlir::FuncOp>(
+                mlir::daphne::createSelectMatrixRepresentationsPass(userConfig_, !selectMatrixRepresentations_));
+        //pm.addPass(mlir::daphne::createPrintIRPass("IR after selecting matrix representation"));
+
         if(userConfig_.explain_property_inference)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after property inference"));
 
+        if(userConfig_.algebraic_simplification) {
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createAlgebraicSimplificationPass());
+            pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+        }
+
         pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createAdaptTypesToKernelsPass());
         if(userConfig_.explain_type_adaptation)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after type adaptation"));
 
+        // The expressions of SQL queries are fused on the typed IR, before their ops could be vectorized.
+        if(userConfig_.sql_optimization) {
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createFuseSqlExprsPass());
+            if(userConfig_.explain_sql)
+                pm.addPass(mlir::daphne::createPrintIRPass("IR after fusing SQL expressions:"));
+        }
+
+        // The ops moved out of loops may become equal to ops before the loops.
+        if(userConfig_.matrix_cse_licm) {
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createMatrixCSEPass());
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createLoopInvariantCodeMotionPass());
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createMatrixCSEPass());
+        }
+
 #if 0
         if (userConfig_.use_distributed) {
             pm.addPass(mlir::daphne::createDistributeComputationsPass());
             //pm.addPass(mlir::daphne::createPrintIRPass("IR after distribution"));
             pm.addPass(mlir::createCSEPass());
             //pm.addPass(mlir::daphne::createPrintIRPass("IR after distribution - CSE"));
-            pm.addPass(mlir::createCanonicalizerPass());
+            pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
             //pm.addPass(mlir::daphne::createPrintIRPass("IR after distribution - canonicalization"));
-            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createWhileLoopInvariantCodeMotionPass());
-            //pm.addPass(mlir::daphne::createPrintIRPass("IR after distribution - WhileLICM"));
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createLoopInvariantCodeMotionPass());
+            //pm.addPass(mlir::daphne::createPrintIRPass("IR after distribution - LICM"));
         }
 #endif
         
         // For now, in order to use the distributed runtime we also require the vectorized engine to be enabled so
         // as to create pipelines. Therefore *if* distributed runtime is enabled, we need to make a vectorization pass.
-        if(userConfig_.use_vectorized_exec || userConfig_.use_distributed) {
-            // TODO: add inference here if we have rewrites that could apply to vectorized pipelines due to smaller sizes
-            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createVectorizeComputationsPass());
-            pm.addPass(mlir::createCanonicalizerPass());
-        }
+        // Otherwise, only the ops annotated by `@vectorize` in DaphneDSL are vectorized.
+        // TODO: add inference here if we have rewrites that could apply to vectorized pipelines due to smaller sizes
+        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createVectorizeComputationsPass(userConfig_));
+        pm.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
+        if(userConfig_.fuse_ewise)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createFuseEwiseOpsPass());
         if(userConfig_.explain_vectorized)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after vectorization"));
+        if(userConfig_.explain_cost || userConfig_.profile_kernels)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createEstimateCostsPass(userConfig_.explain_cost));
         
+        // The checkpoints save the results of distributed pipelines, which must be waited for (see
+        // DistributePipelinesPass).
+        if(!userConfig_.checkpoint_dir.empty())
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createCheckpointLoopsPass(userConfig_));
+
         if (userConfig_.use_distributed)
-            pm.addPass(mlir::daphne::createDistributePipelinesPass());
+            pm.addPass(mlir::daphne::createDistributePipelinesPass(userConfig_));
+
+        if(userConfig_.prefetch_reads)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createPrefetchReadsPass());
 
         pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createInsertDaphneContextPass(userConfig_));
 
@@ -145,13 +378,22 @@ bool DaphneIrExecutor::runPasses(mlir::ModuleOp module)
 #endif
 
 
-        if(userConfig_.use_obj_ref_mgnt)
+        if(userConfig_.static_shape_kernels)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createMarkStaticShapeOpsPass());
+
+        if(userConfig_.use_obj_ref_mgnt) {
             pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createManageObjRefsPass());
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createPlanMemoryPass());
+        }
         if(userConfig_.explain_obj_ref_mgnt)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after managing object references"));
 
         pm.addPass(mlir::createCSEPass());
         pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createRewriteToCallKernelOpPass());
+        if(userConfig_.profile_kernels)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createProfileKernelsPass());
+        if(userConfig_.track_memory || userConfig_.memory_limit_bytes)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createTrackMemoryPass());
         if(userConfig_.explain_kernels)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after kernel lowering"));
 
@@ -170,48 +412,312 @@ bool DaphneIrExecutor::runPasses(mlir::ModuleOp module)
     return false;
 }
 
+unsigned DaphneIrExecutor::getNumCompileThreads() const
+{
+    if(userConfig_.compile_threads > 0)
+        return userConfig_.compile_threads;
+    return llvm::hardware_concurrency().compute_thread_count();
+}
+
 std::unique_ptr<mlir::ExecutionEngine> DaphneIrExecutor::createExecutionEngine(mlir::ModuleOp module)
 {
-    if (module) {
-        // An optimization pipeline to use within the execution engine.
-        auto optPipeline = mlir::makeOptimizingTransformer(0, 0, nullptr);
+    return createExecutionEngine(module, userConfig_);
+}
 
-        llvm::SmallVector<llvm::StringRef, 1> sharedLibRefs;
-        // TODO Find these at run-time.
-        if(userConfig_.libdir.empty()) {
-            sharedLibRefs.push_back("build/src/runtime/local/kernels/libAllKernels.so");
-        }
-        else {
-            sharedLibRefs.insert(sharedLibRefs.end(), userConfig_.library_paths.begin(), userConfig_.library_paths.end());
+std::shared_ptr<JitProgram> DaphneIrExecutor::createJitProgram(mlir::ModuleOp module, llvm::StringRef entryName,
+                                                               JitObjectCache & cache)
+{
+    if (!module)
+        return nullptr;
+    const std::vector<std::string> sharedLibPaths = getSharedLibPaths(module);
+    if(!loadSharedLibs(sharedLibPaths))
+        return nullptr;
+    const auto start = std::chrono::steady_clock::now();
+    const std::string key = JitObjectCache::computeKey(module, userConfig_, sharedLibPaths);
+    if(auto program = cache.lookup(key, userConfig_, sharedLibPaths)) {
+        if(userConfig_.explain_llvm)
+            llvm::errs() << "JIT object cache hit: " << key << "\n";
+        statistics_.jitCacheHits++;
+        statistics_.jitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return program;
+    }
+
+    auto symbolConfig = std::make_unique<DaphneUserConfig>(userConfig_);
+    std::shared_ptr<JitProgram> program;
+    // Modules of several functions are compiled in parallel, unless they are cached as a single object file or the
+    // (global) timers of the LLVM passes are enabled.
+    size_t numFunctions = 0;
+    module.walk([&](mlir::LLVM::LLVMFuncOp func) {
+        if(!func.isExternal())
+            numFunctions++;
+    });
+    const unsigned numThreads = std::min<size_t>(getNumCompileThreads(), numFunctions);
+    if(numThreads > 1 && userConfig_.jit_cache_dir.empty() && !userConfig_.timing_passes) {
+        auto jit = createParallelJit(module, *symbolConfig, numThreads);
+        if (!jit)
+            return nullptr;
+        program = std::make_shared<JitProgram>(std::move(symbolConfig), std::move(jit));
+    }
+    else {
+        auto engine = createExecutionEngine(module, *symbolConfig);
+        if (!engine)
+            return nullptr;
+        auto entry = engine->lookup(("_mlir_" + entryName).str());
+        if (!entry) {
+            llvm::errs() << "Failed to compile " << entryName << ": " << entry.takeError();
+            return nullptr;
         }
+        program = std::make_shared<JitProgram>(std::move(symbolConfig), std::move(engine));
+    }
+    cache.insert(key, program);
+    statistics_.jitCompilations++;
+    statistics_.jitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return program;
+}
+
+void DaphneIrExecutor::reportStatistics()
+{
+    if(!userConfig_.compile_statistics)
+        return;
+    statistics_.print(llvm::errs());
+    if(!userConfig_.compile_statistics_file.empty())
+        statistics_.writeJson(userConfig_.compile_statistics_file);
+}
+
+std::string DaphneIrExecutor::getKernelLibDir() const
+{
+    // TODO Find these at run-time.
+    return userConfig_.libdir.empty() ? "build/src/runtime/local/kernels" : userConfig_.libdir;
+}
+
+std::vector<std::string> DaphneIrExecutor::getSharedLibPaths(mlir::ModuleOp module) const
+{
+    std::vector<std::string> sharedLibPaths;
+    if(userConfig_.libdir.empty()) {
+        sharedLibPaths.push_back(getKernelLibDir() + "/libAllKernels.so");
+    }
+    else {
+        sharedLibPaths.insert(sharedLibPaths.end(), userConfig_.library_paths.begin(), userConfig_.library_paths.end());
+    }
+
+    // The kernels of the categories (e.g., DNN or IO) are only loaded if the module calls any of them.
+    std::set<std::string> categoryLibs;
+    module.walk([&](mlir::LLVM::LLVMFuncOp func) {
+        if(!func.isExternal())
+            return;
+        auto it = kernelLibraryIndex_.find(func.getName().str());
+        if(it != kernelLibraryIndex_.end())
+            categoryLibs.insert(it->second);
+    });
+    for(const std::string & lib : categoryLibs)
+        sharedLibPaths.push_back(getKernelLibDir() + "/lib" + lib + ".so");
 
 #ifdef USE_CUDA
-        if(userConfig_.use_cuda) {
-            if(userConfig_.libdir.empty()) {
-                sharedLibRefs.push_back("build/src/runtime/local/kernels/libCUDAKernels.so");
-            }
+    if(userConfig_.use_cuda) {
+        if(userConfig_.libdir.empty()) {
+            sharedLibPaths.push_back("build/src/runtime/local/kernels/libCUDAKernels.so");
         }
+    }
 #endif
  
 #ifdef USE_FPGAOPENCL
-        if(userConfig_.use_fpgaopencl) {
-            if(userConfig_.libdir.empty()) {
-                sharedLibRefs.push_back("build/src/runtime/local/kernels/libFPGAOPENCLKernels.so");
-            }
+    if(userConfig_.use_fpgaopencl) {
+        if(userConfig_.libdir.empty()) {
+            sharedLibPaths.push_back("build/src/runtime/local/kernels/libFPGAOPENCLKernels.so");
         }
+    }
 #endif
+    return sharedLibPaths;
+}
+
+bool DaphneIrExecutor::loadSharedLibs(const std::vector<std::string> & sharedLibPaths)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for(const std::string & path : sharedLibPaths) {
+        std::string error;
+        if(llvm::sys::DynamicLibrary::LoadLibraryPermanently(path.c_str(), &error)) {
+            llvm::errs() << "Failed to load kernel library " << path << ": " << error << "\n";
+            return false;
+        }
+    }
+    statistics_.libraries.insert(sharedLibPaths.begin(), sharedLibPaths.end());
+    statistics_.libraryLoadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+std::unique_ptr<mlir::ExecutionEngine> DaphneIrExecutor::createExecutionEngine(mlir::ModuleOp module,
+                                                                               const DaphneUserConfig & symbolConfig)
+{
+    if (module) {
+        // An optimization pipeline to use within the execution engine, at the
+        // user's optimization level (which includes inlining from level 2 on)
+        // and tuned for the host's CPU, such that the vectorizers use its
+        // widest vectors (e.g., AVX2, AVX-512, SVE).
+        const unsigned optLevel = userConfig_.jit_opt_level;
+        const llvm::CodeGenOpt::Level codeGenOptLevel = getCodeGenOptLevel(optLevel);
+        std::unique_ptr<llvm::TargetMachine> targetMachine;
+        if(userConfig_.jit_native_target)
+            targetMachine = createHostTargetMachine(codeGenOptLevel);
+        auto optPipeline = mlir::makeOptimizingTransformer(optLevel, 0, targetMachine.get());
+        llvm::TimePassesIsEnabled = userConfig_.timing_passes;
+
+        const std::vector<std::string> sharedLibPaths = getSharedLibPaths(module);
+        llvm::SmallVector<llvm::StringRef, 1> sharedLibRefs(sharedLibPaths.begin(), sharedLibPaths.end());
         registerLLVMDialectTranslation(context_);
         // module.dump();
         auto maybeEngine = mlir::ExecutionEngine::create(
-            module, nullptr, optPipeline, llvm::CodeGenOpt::Level::Default,
+            module, nullptr, optPipeline, codeGenOptLevel,
             sharedLibRefs, true, true, true);
+        if(userConfig_.timing_passes)
+            llvm::reportAndResetTimings(&llvm::errs());
 
         if (!maybeEngine) {
             llvm::errs() << "Failed to create JIT-Execution engine: "
                          << maybeEngine.takeError();
             return nullptr;
         }
+        // The compiled code refers to the user config by a symbol instead of
+        // its address, see LowerToLLVMPass.
+        maybeEngine.get()->registerSymbols([&](llvm::orc::MangleAndInterner interner) {
+            llvm::orc::SymbolMap symbolMap;
+            symbolMap[interner(mlir::daphne::SYMBOL_USERCONFIG)] =
+                    llvm::JITEvaluatedSymbol::fromPointer(&symbolConfig);
+            return symbolMap;
+        });
         return std::move(maybeEngine.get());
     }
     return nullptr;
 }
+
+std::unique_ptr<llvm::orc::LLJIT> DaphneIrExecutor::createParallelJit(mlir::ModuleOp module,
+                                                                     const DaphneUserConfig & symbolConfig,
+                                                                     unsigned numThreads)
+{
+    const unsigned optLevel = userConfig_.jit_opt_level;
+    const llvm::CodeGenOpt::Level codeGenOptLevel = getCodeGenOptLevel(optLevel);
+    const bool nativeTarget = userConfig_.jit_native_target;
+    auto tmBuilder = nativeTarget ? createHostTargetMachineBuilder(codeGenOptLevel)
+            : llvm::orc::JITTargetMachineBuilder::detectHost();
+    if(!tmBuilder) {
+        llvm::errs() << "Failed to detect the JIT target: " << tmBuilder.takeError() << "\n";
+        return nullptr;
+    }
+    tmBuilder->setCodeGenOptLevel(codeGenOptLevel);
+    auto jit = llvm::orc::LLJITBuilder()
+            .setJITTargetMachineBuilder(*tmBuilder)
+            .setNumCompileThreads(numThreads)
+            .create();
+    if(!jit) {
+        llvm::errs() << "Failed to create JIT: " << jit.takeError() << "\n";
+        return nullptr;
+    }
+
+    // Each partition is optimized on its own compile thread, with a target machine of its own.
+    llvm::orc::JITTargetMachineBuilder partTmBuilder = *tmBuilder;
+    (*jit)->getIRTransformLayer().setTransform(
+            [partTmBuilder, optLevel, nativeTarget](llvm::orc::ThreadSafeModule tsm,
+                    const llvm::orc::MaterializationResponsibility &) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+                auto targetMachine = partTmBuilder.createTargetMachine();
+                if(!targetMachine)
+                    return targetMachine.takeError();
+                auto optPipeline = mlir::makeOptimizingTransformer(
+                        optLevel, 0, nativeTarget ? targetMachine->get() : nullptr
+                );
+                if(auto error = tsm.withModuleDo([&](llvm::Module & m) { return optPipeline(&m); }))
+                    return std::move(error);
+                return std::move(tsm);
+            }
+    );
+
+    // The kernels are resolved in the process, which loaded their libraries, and the user config by its symbol.
+    llvm::orc::JITDylib & mainJD = (*jit)->getMainJITDylib();
+    mainJD.addGenerator(llvm::cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            (*jit)->getDataLayout().getGlobalPrefix())));
+    llvm::cantFail(mainJD.define(llvm::orc::absoluteSymbols({{
+            (*jit)->mangleAndIntern(mlir::daphne::SYMBOL_USERCONFIG), llvm::JITEvaluatedSymbol::fromPointer(&symbolConfig)
+    }})));
+
+    registerLLVMDialectTranslation(context_);
+    auto llvmContext = std::make_unique<llvm::LLVMContext>();
+    auto llvmModule = mlir::translateModuleToLLVMIR(module, *llvmContext);
+    if(!llvmModule) {
+        llvm::errs() << "Failed to translate the module to LLVM IR\n";
+        return nullptr;
+    }
+    llvmModule->setDataLayout((*jit)->getDataLayout());
+    llvmModule->setTargetTriple((*jit)->getTargetTriple().str());
+    const auto funcs = packFunctionArguments(*llvmModule);
+    const auto parts = partitionModule(*llvmModule, funcs, numThreads);
+    llvm::orc::SymbolLookupSet wrappers;
+    for(auto & func : funcs)
+        wrappers.add((*jit)->mangleAndIntern(func.second->getName()));
+
+    // The partitions refer to each other's definitions by external symbols, and are compiled in contexts of their
+    // own, which are locked during their compilation.
+    for(llvm::GlobalValue & gv : llvmModule->global_values()) {
+        if(!gv.hasLocalLinkage())
+            continue;
+        if(!gv.hasName())
+            gv.setName("__daphne_local");
+        gv.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        gv.setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+    llvm::orc::ThreadSafeModule whole(std::move(llvmModule), std::move(llvmContext));
+    for(auto & part : parts) {
+        auto tsm = llvm::orc::cloneToNewContext(whole, [&part](const llvm::GlobalValue & gv) {
+            return part.count(&gv) > 0;
+        });
+        if(auto error = (*jit)->addIRModule(std::move(tsm))) {
+            llvm::errs() << "Failed to add a partition to the JIT: " << error << "\n";
+            return nullptr;
+        }
+    }
+
+    // Looking up all functions at once compiles the partitions on the compile threads.
+    auto symbols = (*jit)->getExecutionSession().lookup(llvm::orc::makeJITDylibSearchOrder(&mainJD), wrappers);
+    if(!symbols) {
+        llvm::errs() << "Failed to compile the module: " << symbols.takeError() << "\n";
+        return nullptr;
+    }
+    if(userConfig_.explain_llvm)
+        llvm::errs() << "JIT-compiled " << funcs.size() << " functions in " << parts.size() << " partitions on "
+                << numThreads << " threads\n";
+    return std::move(*jit);
+}
+
+llvm::Expected<llvm::orc::JITTargetMachineBuilder> DaphneIrExecutor::createHostTargetMachineBuilder(
+        llvm::CodeGenOpt::Level codeGenOptLevel)
+{
+    auto tmBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if(!tmBuilder)
+        return tmBuilder.takeError();
+    tmBuilder->setCPU(llvm::sys::getHostCPUName().str());
+    llvm::StringMap<bool> hostFeatures;
+    if(llvm::sys::getHostCPUFeatures(hostFeatures)) {
+        llvm::SubtargetFeatures features;
+        for(auto & feature : hostFeatures)
+            features.AddFeature(feature.first(), feature.second);
+        tmBuilder->addFeatures(features.getFeatures());
+    }
+    tmBuilder->setCodeGenOptLevel(codeGenOptLevel);
+    return tmBuilder;
+}
+
+std::unique_ptr<llvm::TargetMachine> DaphneIrExecutor::createHostTargetMachine(llvm::CodeGenOpt::Level codeGenOptLevel)
+{
+    auto tmBuilder = createHostTargetMachineBuilder(codeGenOptLevel);
+    if(!tmBuilder) {
+        llvm::consumeError(tmBuilder.takeError());
+        return nullptr;
+    }
+    auto targetMachine = tmBuilder->createTargetMachine();
+    if(!targetMachine) {
+        llvm::consumeError(targetMachine.takeError());
+        return nullptr;
+    }
+    if(userConfig_.explain_llvm)
+        llvm::errs() << "JIT target: " << targetMachine.get()->getTargetTriple().str() << ", CPU "
+                << targetMachine.get()->getTargetCPU() << ", features " << targetMachine.get()->getTargetFeatureString()
+                << "\n";
+    return std::move(targetMachine.get());
+}
@@ -21,23 +21,126 @@
 
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetMachine.h"
 #include <api/cli/DaphneUserConfig.h>
+#include <compiler/execution/AdaptiveRecompiler.h>
+#include <compiler/execution/CompileStatistics.h>
+#include <compiler/execution/JitObjectCache.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class DaphneIrExecutor
 {
 public:
     DaphneIrExecutor(bool selectMatrixRepresentations, DaphneUserConfig cfg);
 
+    /**
+     * @brief Runs all passes on a parsed module, i.e., `runSimplificationPasses`
+     * and `runLoweringPasses`.
+     */
     bool runPasses(mlir::ModuleOp module);
+
+    /**
+     * @brief Runs the first passes on a parsed module, which specialize the
+     * generic functions and simplify the IR, but do not depend on the inputs
+     * of the script (see `ParsedIrCache`).
+     */
+    bool runSimplificationPasses(mlir::ModuleOp module);
+
+    /**
+     * @brief Runs the remaining passes on a simplified module, from the
+     * inference of the properties to the lowering to the LLVM dialect.
+     */
+    bool runLoweringPasses(mlir::ModuleOp module);
+
     std::unique_ptr<mlir::ExecutionEngine> createExecutionEngine(mlir::ModuleOp module);
 
+    /**
+     * @brief JIT-compiles the module (after `runPasses`), or returns the code
+     * compiled from the same IR before, see `JitObjectCache`.
+     *
+     * @param entryName A function of the module, whose lookup compiles the
+     * whole module, such that its object can be cached.
+     */
+    std::shared_ptr<JitProgram> createJitProgram(mlir::ModuleOp module, llvm::StringRef entryName,
+                                                 JitObjectCache & cache);
+
+    /**
+     * @brief Prints the statistics of all compilations so far (including the
+     * ones at adaptive checkpoints) and writes them as JSON to the configured
+     * file, if compile statistics are enabled.
+     */
+    void reportStatistics();
+
+    const CompileStatistics & getStatistics() const
+    { return statistics_; }
+
     mlir::MLIRContext *getContext()
     { return &context_; }
 private:
+    /**
+     * @brief Creates an execution engine, which binds the symbol of the user
+     * config in the compiled code to the given one.
+     */
+    std::unique_ptr<mlir::ExecutionEngine> createExecutionEngine(mlir::ModuleOp module,
+                                                                 const DaphneUserConfig & symbolConfig);
+
+    /**
+     * @brief Creates a JIT, which optimizes and compiles the functions of the
+     * module in the given number of partitions on as many threads, and
+     * compiles all of them right away.
+     *
+     * The partitions only call each other's functions, but do not inline
+     * them. Returns `nullptr` if the module cannot be compiled this way.
+     */
+    std::unique_ptr<llvm::orc::LLJIT> createParallelJit(mlir::ModuleOp module, const DaphneUserConfig & symbolConfig,
+                                                        unsigned numThreads);
+
+    /**
+     * @brief Returns the number of threads to compile with, all hardware
+     * threads unless configured otherwise.
+     */
+    unsigned getNumCompileThreads() const;
+
+    /**
+     * @brief Returns the kernel libraries to link the given module (lowered
+     * to the LLVM dialect) with: the configured ones and the libraries of the
+     * kernel categories it calls (see `kernels.index`).
+     */
+    std::vector<std::string> getSharedLibPaths(mlir::ModuleOp module) const;
+
+    /**
+     * @brief Loads the given libraries, such that the time of loading them is
+     * reported separately from the JIT compilation.
+     */
+    bool loadSharedLibs(const std::vector<std::string> & sharedLibPaths);
+
+    std::string getKernelLibDir() const;
+
+    /**
+     * @brief Returns a target machine for the CPU of the host and all its
+     * features, or `nullptr` if the host is not supported.
+     */
+    std::unique_ptr<llvm::TargetMachine> createHostTargetMachine(llvm::CodeGenOpt::Level codeGenOptLevel);
+
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> createHostTargetMachineBuilder(
+            llvm::CodeGenOpt::Level codeGenOptLevel);
+
     mlir::MLIRContext context_;
     bool selectMatrixRepresentations_;
     bool insertFreeOp_{};
     DaphneUserConfig userConfig_;
+    // compiles the remainders of functions after adaptive checkpoints, if adaptive execution is enabled
+    std::unique_ptr<AdaptiveRecompiler> adaptiveRecompiler_;
+    CompileStatistics statistics_;
+    // the library of each function of the kernels outside of AllKernels, from kernels.index
+    std::unordered_map<std::string, std::string> kernelLibraryIndex_;
 };
 
 #endif //SRC_COMPILER_EXECUTION_DAPHNEIREXECUTOR_H
@@ -0,0 +1,174 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <ir/daphneir/Passes.h>
+#include "JitObjectCache.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <string>
+#include <utility>
+
+// ****************************************************************************
+// JitProgram
+// ****************************************************************************
+
+JitProgram::JitProgram(std::unique_ptr<DaphneUserConfig> userConfig, std::unique_ptr<mlir::ExecutionEngine> engine)
+    : userConfig_(std::move(userConfig)), engine_(std::move(engine)) {
+}
+
+JitProgram::JitProgram(std::unique_ptr<DaphneUserConfig> userConfig, std::unique_ptr<llvm::orc::LLJIT> jit)
+    : userConfig_(std::move(userConfig)), jit_(std::move(jit)) {
+}
+
+llvm::Error JitProgram::invokePacked(llvm::StringRef name, llvm::MutableArrayRef<void *> args)
+{
+    if(engine_)
+        return engine_->invokePacked(name, args);
+    // the wrapper generated for each function by the execution engine
+    auto symbol = jit_->lookup(("_mlir_" + name).str());
+    if(!symbol)
+        return symbol.takeError();
+    auto fptr = reinterpret_cast<void (*)(void **)>(symbol->getAddress());
+    (*fptr)(args.data());
+    return llvm::Error::success();
+}
+
+void JitProgram::dumpToObjectFile(llvm::StringRef filename)
+{
+    if(engine_)
+        engine_->dumpToObjectFile(filename);
+}
+
+// ****************************************************************************
+// JitObjectCache
+// ****************************************************************************
+
+JitObjectCache::JitObjectCache(std::string dir) : dir_(std::move(dir)) {
+}
+
+std::string JitObjectCache::computeKey(mlir::ModuleOp module, const DaphneUserConfig & cfg,
+                                       llvm::ArrayRef<std::string> sharedLibPaths)
+{
+    llvm::SHA1 hash;
+    auto update = [&hash](llvm::StringRef s) {
+        hash.update(s);
+        hash.update(llvm::StringRef("\0", 1));
+    };
+
+    update(LLVM_VERSION_STRING);
+    update(llvm::sys::getProcessTriple());
+    update(std::to_string(cfg.jit_opt_level));
+    if(cfg.jit_native_target) {
+        update(llvm::sys::getHostCPUName());
+        llvm::StringMap<bool> hostFeatures;
+        if(llvm::sys::getHostCPUFeatures(hostFeatures))
+            for(auto & feature : hostFeatures)
+                update((feature.second ? "+" : "-") + feature.first().str());
+    }
+
+    // The kernels are linked at run-time, but a rebuilt library may have
+    // changed signatures.
+    for(const std::string & path : sharedLibPaths) {
+        update(path);
+        llvm::sys::fs::file_status status;
+        if(!llvm::sys::fs::status(path, status)) {
+            update(std::to_string(status.getSize()));
+            update(std::to_string(status.getLastModificationTime().time_since_epoch().count()));
+        }
+    }
+
+    std::string ir;
+    llvm::raw_string_ostream os(ir);
+    module.print(os);
+    update(os.str());
+
+    return llvm::toHex(hash.final(), true);
+}
+
+std::string JitObjectCache::getObjectPath(const std::string & key) const
+{
+    return dir_ + "/" + key + ".o";
+}
+
+std::shared_ptr<JitProgram> JitObjectCache::lookup(const std::string & key, const DaphneUserConfig & cfg,
+                                                   llvm::ArrayRef<std::string> sharedLibPaths)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = programs_.find(key);
+    if(it != programs_.end())
+        return it->second;
+    if(dir_.empty())
+        return nullptr;
+
+    auto buffer = llvm::MemoryBuffer::getFile(getObjectPath(key));
+    if(!buffer)
+        return nullptr;
+
+    for(const std::string & path : sharedLibPaths) {
+        std::string error;
+        if(llvm::sys::DynamicLibrary::LoadLibraryPermanently(path.c_str(), &error)) {
+            llvm::errs() << "Failed to load kernel library " << path << ": " << error << "\n";
+            return nullptr;
+        }
+    }
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if(!jit) {
+        llvm::errs() << "Failed to create JIT for cached object: " << jit.takeError() << "\n";
+        return nullptr;
+    }
+    llvm::orc::JITDylib & mainJD = (*jit)->getMainJITDylib();
+    mainJD.addGenerator(llvm::cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            (*jit)->getDataLayout().getGlobalPrefix())));
+    auto userConfig = std::make_unique<DaphneUserConfig>(cfg);
+    llvm::orc::MangleAndInterner mangle(mainJD.getExecutionSession(), (*jit)->getDataLayout());
+    llvm::cantFail(mainJD.define(llvm::orc::absoluteSymbols({{
+            mangle(mlir::daphne::SYMBOL_USERCONFIG), llvm::JITEvaluatedSymbol::fromPointer(userConfig.get())
+    }})));
+    if(auto error = (*jit)->addObjectFile(std::move(*buffer))) {
+        llvm::errs() << "Failed to load cached object: " << error << "\n";
+        return nullptr;
+    }
+
+    auto program = std::make_shared<JitProgram>(std::move(userConfig), std::move(*jit));
+    programs_[key] = program;
+    return program;
+}
+
+void JitObjectCache::insert(const std::string & key, std::shared_ptr<JitProgram> program)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(!dir_.empty() && !llvm::sys::fs::create_directories(dir_)) {
+        const std::string path = getObjectPath(key);
+        const std::string tmpPath = path + ".tmp" + std::to_string(llvm::sys::Process::getProcessId());
+        program->dumpToObjectFile(tmpPath);
+        if(llvm::sys::fs::exists(tmpPath) && llvm::sys::fs::rename(tmpPath, path))
+            llvm::sys::fs::remove(tmpPath);
+    }
+    programs_[key] = std::move(program);
+}
@@ -0,0 +1,115 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_COMPILER_EXECUTION_JITOBJECTCACHE_H
+#define SRC_COMPILER_EXECUTION_JITOBJECTCACHE_H
+
+#pragma once
+
+#include <api/cli/DaphneUserConfig.h>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Support/Error.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/IR/BuiltinOps.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief A JIT-compiled module, whose functions are invoked through their
+ * packed wrappers (like `mlir::ExecutionEngine::invokePacked`).
+ *
+ * The code is either compiled by an MLIR `ExecutionEngine` or loaded from an
+ * object file of a `JitObjectCache`. The program owns the user config the
+ * code refers to (see `mlir::daphne::SYMBOL_USERCONFIG`), such that it can
+ * outlive the `DaphneIrExecutor` that created it.
+ */
+class JitProgram
+{
+public:
+    JitProgram(std::unique_ptr<DaphneUserConfig> userConfig, std::unique_ptr<mlir::ExecutionEngine> engine);
+    JitProgram(std::unique_ptr<DaphneUserConfig> userConfig, std::unique_ptr<llvm::orc::LLJIT> jit);
+
+    llvm::Error invokePacked(llvm::StringRef name, llvm::MutableArrayRef<void *> args = llvm::None);
+
+    llvm::Error invoke(llvm::StringRef name)
+    { return invokePacked(name); }
+
+    /**
+     * @brief Writes the object file of the code compiled by the execution
+     * engine, if any.
+     */
+    void dumpToObjectFile(llvm::StringRef filename);
+private:
+    std::unique_ptr<DaphneUserConfig> userConfig_;
+    std::unique_ptr<mlir::ExecutionEngine> engine_;
+    std::unique_ptr<llvm::orc::LLJIT> jit_;
+};
+
+/**
+ * @brief A cache of JIT-compiled modules, in memory and as object files in a
+ * directory that is shared by all processes, e.g., all runs of a script.
+ *
+ * The key is a hash of the module after all passes, the parts of the user
+ * config affecting the code generation, and the kernel libraries (their
+ * paths, sizes, and modification times). As the passes specialize the IR to
+ * the shapes and other properties of the inputs, they still run for each
+ * module, but the translation to LLVM IR, its optimization, and the code
+ * generation are done once for each distinct IR. The compiled code does not
+ * depend on the process, since the address of the user config is bound to a
+ * symbol when the code is loaded.
+ *
+ * Object files are written to a temporary file and renamed, such that
+ * concurrent processes never read a partial file.
+ */
+class JitObjectCache
+{
+public:
+    /**
+     * @param dir The directory of the object files, or empty to only cache
+     * the programs in memory.
+     */
+    explicit JitObjectCache(std::string dir = "");
+
+    static std::string computeKey(mlir::ModuleOp module, const DaphneUserConfig & cfg,
+                                  llvm::ArrayRef<std::string> sharedLibPaths);
+
+    /**
+     * @brief Returns the program of the given key from memory or loads it
+     * from its object file, or returns `nullptr`.
+     */
+    std::shared_ptr<JitProgram> lookup(const std::string & key, const DaphneUserConfig & cfg,
+                                       llvm::ArrayRef<std::string> sharedLibPaths);
+
+    /**
+     * @brief Caches the given program, which must have been compiled by an
+     * execution engine completely.
+     */
+    void insert(const std::string & key, std::shared_ptr<JitProgram> program);
+private:
+    std::string getObjectPath(const std::string & key) const;
+
+    std::string dir_;
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<JitProgram>> programs_;
+};
+
+#endif //SRC_COMPILER_EXECUTION_JITOBJECTCACHE_H
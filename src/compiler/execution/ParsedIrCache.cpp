@@ -0,0 +1,154 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <compiler/CompilerUtils.h>
+#include <ir/daphneir/Daphne.h>
+#include "ParsedIrCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/Parser.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+namespace {
+    // the prefix of the lines recording the dependencies, which the MLIR parser skips as comments
+    const llvm::StringRef DEPENDS_PREFIX = "// depends\t";
+}
+
+ParsedIrCache::ParsedIrCache(std::string dir) : dir_(std::move(dir)) {
+}
+
+std::string ParsedIrCache::getFileStamp(const std::string & path)
+{
+    llvm::sys::fs::file_status status;
+    if(llvm::sys::fs::status(path, status) || !llvm::sys::fs::exists(status))
+        return "-";
+    return std::to_string(status.getSize()) + "@"
+            + std::to_string(status.getLastModificationTime().time_since_epoch().count());
+}
+
+std::string ParsedIrCache::computeKey(const std::string & scriptPath,
+                                      const std::unordered_map<std::string, std::string> & scriptArgs,
+                                      const DaphneUserConfig & cfg)
+{
+    llvm::SHA1 hash;
+    auto update = [&hash](llvm::StringRef s) {
+        hash.update(s);
+        hash.update(llvm::StringRef("\0", 1));
+    };
+
+    // A rebuilt executable may parse a script differently.
+    static int anchor;
+    const std::string exePath = llvm::sys::fs::getMainExecutable("daphne", &anchor);
+    update(exePath);
+    update(getFileStamp(exePath));
+
+    llvm::SmallString<256> absScriptPath(scriptPath);
+    llvm::sys::fs::make_absolute(absScriptPath);
+    update(absScriptPath);
+
+    const std::map<std::string, std::string> sortedArgs(scriptArgs.begin(), scriptArgs.end());
+    for(auto & arg : sortedArgs) {
+        update(arg.first);
+        update(arg.second);
+    }
+    for(auto & importPaths : cfg.daphnedsl_import_paths) {
+        update(importPaths.first);
+        for(const std::string & path : importPaths.second)
+            update(path);
+    }
+
+    return llvm::toHex(hash.final(), true);
+}
+
+std::vector<std::string> ParsedIrCache::getDependencies(mlir::ModuleOp module, const std::string & scriptPath,
+                                                        const std::vector<std::string> & importedFiles)
+{
+    std::vector<std::string> dependencies = {scriptPath};
+    dependencies.insert(dependencies.end(), importedFiles.begin(), importedFiles.end());
+    // The parser infers the types of the data read from their meta data, which may have been inferred from the data.
+    module.walk([&](mlir::daphne::ReadOp op) {
+        try {
+            const std::string fileName = CompilerUtils::getConstantString2(op.fileName());
+            dependencies.push_back(fileName);
+            dependencies.push_back(fileName + ".meta");
+        }
+        catch(std::runtime_error &) {
+            // not read at compile time
+        }
+    });
+    return dependencies;
+}
+
+std::string ParsedIrCache::getIrPath(const std::string & key) const
+{
+    return dir_ + "/" + key + ".mlir";
+}
+
+mlir::OwningModuleRef ParsedIrCache::lookup(const std::string & key, mlir::MLIRContext * context) const
+{
+    if(dir_.empty())
+        return {};
+    auto buffer = llvm::MemoryBuffer::getFile(getIrPath(key));
+    if(!buffer)
+        return {};
+
+    const llvm::StringRef ir = (*buffer)->getBuffer();
+    llvm::StringRef rest = ir;
+    while(rest.startswith(DEPENDS_PREFIX)) {
+        auto lineAndRest = rest.split('\n');
+        auto pathAndStamp = lineAndRest.first.drop_front(DEPENDS_PREFIX.size()).rsplit('\t');
+        if(getFileStamp(pathAndStamp.first.str()) != pathAndStamp.second)
+            return {};
+        rest = lineAndRest.second;
+    }
+
+    // An unreadable file (e.g., of an older version of the dialect) is parsed again from the script.
+    mlir::ScopedDiagnosticHandler ignoreErrors(context, [](mlir::Diagnostic &) { return mlir::success(); });
+    return mlir::OwningModuleRef(mlir::parseSourceString<mlir::ModuleOp>(ir, context));
+}
+
+void ParsedIrCache::insert(const std::string & key, mlir::ModuleOp module,
+                           const std::vector<std::string> & dependencies) const
+{
+    if(dir_.empty() || llvm::sys::fs::create_directories(dir_))
+        return;
+    const std::string path = getIrPath(key);
+    const std::string tmpPath = path + ".tmp" + std::to_string(llvm::sys::Process::getProcessId());
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(tmpPath, ec);
+        if(ec)
+            return;
+        for(const std::string & dependency : dependencies)
+            os << DEPENDS_PREFIX << dependency << '\t' << getFileStamp(dependency) << '\n';
+        // The locations are kept for the error messages and the profiles of the later passes.
+        mlir::OpPrintingFlags flags;
+        flags.enableDebugInfo();
+        module.print(os, flags);
+    }
+    if(llvm::sys::fs::rename(tmpPath, path))
+        llvm::sys::fs::remove(tmpPath);
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_COMPILER_EXECUTION_PARSEDIRCACHE_H
+#define SRC_COMPILER_EXECUTION_PARSEDIRCACHE_H
+
+#pragma once
+
+#include <api/cli/DaphneUserConfig.h>
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A cache of the IR of DaphneDSL scripts after parsing and the first
+ * simplifications (see `DaphneIrExecutor::runSimplificationPasses`), as text
+ * files in a directory that is shared by all processes, e.g., all runs of a
+ * script.
+ *
+ * The key is a hash of the path of the script, the script arguments, the
+ * import paths of the user config, and the `daphne` executable (its path,
+ * size, and modification time). Each file records the files the IR depends
+ * on, i.e., the script, the imported scripts, and the files read at compile
+ * time (with their meta data), by their sizes and modification times, and is
+ * only used while all of them are unchanged.
+ *
+ * Files are written to a temporary file and renamed, such that concurrent
+ * processes never read a partial file.
+ */
+class ParsedIrCache
+{
+public:
+    /**
+     * @param dir The directory of the IR files, or empty to disable the cache.
+     */
+    explicit ParsedIrCache(std::string dir = "");
+
+    static std::string computeKey(const std::string & scriptPath,
+                                  const std::unordered_map<std::string, std::string> & scriptArgs,
+                                  const DaphneUserConfig & cfg);
+
+    /**
+     * @brief Returns the size and modification time of the given file, or
+     * `-` if it does not exist.
+     */
+    static std::string getFileStamp(const std::string & path);
+
+    /**
+     * @brief Returns the files the given parsed module depends on: the
+     * script, the given imported scripts, and the files read by it whose
+     * names are constants.
+     */
+    static std::vector<std::string> getDependencies(mlir::ModuleOp module, const std::string & scriptPath,
+                                                    const std::vector<std::string> & importedFiles);
+
+    /**
+     * @brief Returns the module of the given key parsed from its file, or
+     * `nullptr` if there is none or any of its dependencies changed.
+     */
+    mlir::OwningModuleRef lookup(const std::string & key, mlir::MLIRContext * context) const;
+
+    /**
+     * @brief Writes the given module to the file of the given key, along with
+     * the current state of the given dependencies.
+     */
+    void insert(const std::string & key, mlir::ModuleOp module, const std::vector<std::string> & dependencies) const;
+private:
+    std::string getIrPath(const std::string & key) const;
+
+    std::string dir_;
+};
+
+#endif //SRC_COMPILER_EXECUTION_PARSEDIRCACHE_H
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compiler/CompilerUtils.h>
+#include <compiler/inference/CardinalityEstimation.h>
+#include <ir/daphneir/Daphne.h>
+
+#include <algorithm>
+#include <exception>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+namespace {
+    std::optional<std::string> constantString(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto strAttr = co.value().dyn_cast<StringAttr>())
+                return strAttr.getValue().str();
+        return std::nullopt;
+    }
+
+    std::optional<double> constantNumber(Value v) {
+        while(auto castOp = v.getDefiningOp<daphne::CastOp>())
+            v = castOp.arg();
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>()) {
+            if(auto intAttr = co.value().dyn_cast<IntegerAttr>())
+                return intAttr.getType().isUnsignedInteger()
+                        ? static_cast<double>(intAttr.getValue().getZExtValue())
+                        : static_cast<double>(intAttr.getValue().getSExtValue());
+            if(auto floatAttr = co.value().dyn_cast<FloatAttr>())
+                return floatAttr.getValueAsDouble();
+        }
+        return std::nullopt;
+    }
+
+    // The SQLVisitor casts the operands of AND and OR to integer matrices via
+    // single-column frames.
+    Value skipCasts(Value v) {
+        for(;;) {
+            if(auto castOp = v.getDefiningOp<daphne::CastOp>())
+                v = castOp.arg();
+            else if(auto createOp = v.getDefiningOp<daphne::CreateFrameOp>()) {
+                if(createOp.cols().size() != 1)
+                    return v;
+                v = createOp.cols()[0];
+            }
+            else
+                return v;
+        }
+    }
+
+    std::optional<size_t> labelIdx(Value frame, const std::string & label) {
+        auto ft = frame.getType().dyn_cast<daphne::FrameType>();
+        if(!ft || !ft.getLabels())
+            return std::nullopt;
+        const std::vector<std::string> & labels = *ft.getLabels();
+        auto it = std::find(labels.begin(), labels.end(), label);
+        if(it == labels.end() || std::find(it + 1, labels.end(), label) != labels.end())
+            return std::nullopt;
+        return it - labels.begin();
+    }
+
+    std::optional<size_t> numCols(Value frame) {
+        if(auto ft = frame.getType().dyn_cast<daphne::FrameType>())
+            return ft.getColumnTypes().size();
+        return std::nullopt;
+    }
+
+    std::optional<FileMetaData> fileMetaData(Value fileName) {
+        try {
+            return CompilerUtils::getFileMetaData(fileName);
+        }
+        catch(const std::exception &) {
+            return std::nullopt;
+        }
+    }
+
+    // the statistics of the column at the given position of a frame
+    std::optional<ColumnStatistics> columnStatisticsAt(Value frame, size_t idx) { // NOLINT(misc-no-recursion)
+        Operation * op = frame.getDefiningOp();
+        if(!op)
+            return std::nullopt;
+        if(auto readOp = llvm::dyn_cast<daphne::ReadOp>(op)) {
+            std::optional<FileMetaData> fmd = fileMetaData(readOp.fileName());
+            if(!fmd || fmd->columnStats.size() != fmd->numCols || idx >= fmd->numCols)
+                return std::nullopt;
+            return fmd->columnStats[idx];
+        }
+        if(auto readOp = llvm::dyn_cast<daphne::ReadColumnsOp>(op)) {
+            std::optional<FileMetaData> fmd = fileMetaData(readOp.fileName());
+            std::optional<std::string> label;
+            if(!fmd || fmd->columnStats.size() != fmd->numCols || idx >= readOp.columns().size()
+                    || !(label = constantString(readOp.columns()[idx])))
+                return std::nullopt;
+            auto it = std::find(fmd->labels.begin(), fmd->labels.end(), *label);
+            if(it == fmd->labels.end())
+                return std::nullopt;
+            return fmd->columnStats[it - fmd->labels.begin()];
+        }
+        // the columns of the argument, or of a subset of its rows
+        if(llvm::isa<daphne::SetColLabelsOp, daphne::SetColLabelsPrefixOp, daphne::FilterRowOp, daphne::OrderOp>(op))
+            return columnStatisticsAt(op->getOperand(0), idx);
+        if(auto semiJoinOp = llvm::dyn_cast<daphne::SemiJoinOp>(op)) {
+            if(frame != semiJoinOp.res())
+                return std::nullopt;
+            return columnStatisticsAt(semiJoinOp.lhs(), idx);
+        }
+        if(auto extractOp = llvm::dyn_cast<daphne::ExtractColOp>(op)) {
+            std::optional<std::string> label = constantString(extractOp.selectedCols());
+            std::optional<size_t> srcIdx;
+            if(idx != 0 || !label || !(srcIdx = labelIdx(extractOp.source(), *label)))
+                return std::nullopt;
+            return columnStatisticsAt(extractOp.source(), *srcIdx);
+        }
+        // the columns of the left input followed by those of the right one
+        if(llvm::isa<daphne::InnerJoinOp, daphne::CartesianOp, daphne::ColBindOp>(op)) {
+            std::optional<size_t> numColsLhs = numCols(op->getOperand(0));
+            if(!numColsLhs)
+                return std::nullopt;
+            return idx < *numColsLhs
+                    ? columnStatisticsAt(op->getOperand(0), idx)
+                    : columnStatisticsAt(op->getOperand(1), idx - *numColsLhs);
+        }
+        return std::nullopt;
+    }
+
+    // the label of the column of the frame v is extracted from, if any
+    std::optional<std::string> columnOf(Value v, Value frame) {
+        while(auto castOp = v.getDefiningOp<daphne::CastOp>())
+            v = castOp.arg();
+        auto extractOp = v.getDefiningOp<daphne::ExtractColOp>();
+        if(!extractOp || extractOp.source() != frame)
+            return std::nullopt;
+        return constantString(extractOp.selectedCols());
+    }
+
+    // the estimated selectivity of the comparison of a column with a constant, if the column has statistics
+    std::optional<double> comparisonSelectivity(Operation * op, Value frame) {
+        std::optional<std::string> label = columnOf(op->getOperand(0), frame);
+        Value constant = op->getOperand(1);
+        bool flipped = false;
+        if(!label) {
+            label = columnOf(op->getOperand(1), frame);
+            constant = op->getOperand(0);
+            flipped = true;
+        }
+        std::optional<ColumnStatistics> stats;
+        if(!label || !(stats = CardinalityEstimation::columnStatistics(frame, *label)))
+            return std::nullopt;
+        std::optional<double> v = constantNumber(constant);
+        if(!v) {
+            // an equality of a string column and a string constant
+            if(constantString(constant) && stats->numDistinct > 0) {
+                const double eq = stats->nonNullFraction() / stats->numDistinct;
+                if(llvm::isa<daphne::EwEqOp>(op))
+                    return eq;
+                if(llvm::isa<daphne::EwNeqOp>(op))
+                    return stats->nonNullFraction() - eq;
+            }
+            return std::nullopt;
+        }
+        // `constant < column` as `column > constant`
+        const bool lt = llvm::isa<daphne::EwLtOp>(op);
+        const bool le = llvm::isa<daphne::EwLeOp>(op);
+        const bool gt = llvm::isa<daphne::EwGtOp>(op);
+        const bool ge = llvm::isa<daphne::EwGeOp>(op);
+        std::optional<double> below;
+        if((lt && !flipped) || (gt && flipped))
+            return stats->fractionBelow(*v, false);
+        if((le && !flipped) || (ge && flipped))
+            return stats->fractionBelow(*v, true);
+        if((gt && !flipped) || (lt && flipped)) {
+            if((below = stats->fractionBelow(*v, true)))
+                return stats->nonNullFraction() - *below;
+            return std::nullopt;
+        }
+        if((ge && !flipped) || (le && flipped)) {
+            if((below = stats->fractionBelow(*v, false)))
+                return stats->nonNullFraction() - *below;
+            return std::nullopt;
+        }
+        std::optional<double> eq = stats->fractionEqual(*v);
+        if(eq && llvm::isa<daphne::EwNeqOp>(op))
+            return stats->nonNullFraction() - *eq;
+        return eq;
+    }
+}
+
+std::optional<ColumnStatistics> CardinalityEstimation::columnStatistics(Value frame, const std::string & label) {
+    std::optional<size_t> idx = labelIdx(frame, label);
+    if(!idx)
+        return std::nullopt;
+    return columnStatisticsAt(frame, *idx);
+}
+
+double CardinalityEstimation::selectivity(Value cond, Value frame) { // NOLINT(misc-no-recursion)
+    Operation * op = skipCasts(cond).getDefiningOp();
+    if(!op)
+        return SELECTIVITY_OTHER;
+    double res;
+    if(llvm::isa<daphne::EwAndOp>(op))
+        res = selectivity(op->getOperand(0), frame) * selectivity(op->getOperand(1), frame);
+    else if(llvm::isa<daphne::EwOrOp>(op)) {
+        const double lhs = selectivity(op->getOperand(0), frame);
+        const double rhs = selectivity(op->getOperand(1), frame);
+        res = lhs + rhs - lhs * rhs;
+    }
+    else if(llvm::isa<daphne::EwEqOp, daphne::EwNeqOp, daphne::EwLtOp, daphne::EwLeOp, daphne::EwGtOp,
+            daphne::EwGeOp>(op))
+        res = comparisonSelectivity(op, frame).value_or(
+                llvm::isa<daphne::EwEqOp>(op) ? SELECTIVITY_EQUALITY : SELECTIVITY_OTHER);
+    else
+        res = SELECTIVITY_OTHER;
+    return std::clamp(res, 0.0, 1.0);
+}
+
+std::optional<double> CardinalityEstimation::numRows(Value frame) { // NOLINT(misc-no-recursion)
+    if(auto ft = frame.getType().dyn_cast<daphne::FrameType>())
+        if(ft.getNumRows() != -1)
+            return static_cast<double>(ft.getNumRows());
+    Operation * op = frame.getDefiningOp();
+    if(!op)
+        return std::nullopt;
+    if(auto readOp = llvm::dyn_cast<daphne::ReadColumnsOp>(op)) {
+        // the rows of the skipped row groups are filtered later on, too
+        if(std::optional<FileMetaData> fmd = fileMetaData(readOp.fileName()))
+            return static_cast<double>(fmd->numRows);
+        return std::nullopt;
+    }
+    if(llvm::isa<daphne::SetColLabelsOp, daphne::SetColLabelsPrefixOp, daphne::ExtractColOp, daphne::OrderOp>(op))
+        return numRows(op->getOperand(0));
+    if(auto filterOp = llvm::dyn_cast<daphne::FilterRowOp>(op)) {
+        std::optional<double> res = numRows(filterOp.source());
+        if(res)
+            *res *= selectivity(filterOp.selectedRows(), filterOp.source());
+        return res;
+    }
+    if(auto cartesianOp = llvm::dyn_cast<daphne::CartesianOp>(op)) {
+        std::optional<double> lhs = numRows(cartesianOp.lhs());
+        std::optional<double> rhs = numRows(cartesianOp.rhs());
+        if(!lhs || !rhs)
+            return std::nullopt;
+        return *lhs * *rhs;
+    }
+    if(auto joinOp = llvm::dyn_cast<daphne::InnerJoinOp>(op)) {
+        std::optional<double> lhs = numRows(joinOp.lhs());
+        std::optional<double> rhs = numRows(joinOp.rhs());
+        if(!lhs || !rhs)
+            return std::nullopt;
+        std::optional<std::string> lhsOn = constantString(joinOp.lhsOn());
+        std::optional<std::string> rhsOn = constantString(joinOp.rhsOn());
+        std::optional<ColumnStatistics> lhsStats = lhsOn ? columnStatistics(joinOp.lhs(), *lhsOn) : std::nullopt;
+        std::optional<ColumnStatistics> rhsStats = rhsOn ? columnStatistics(joinOp.rhs(), *rhsOn) : std::nullopt;
+        if(lhsStats && rhsStats)
+            if(std::optional<double> size = ColumnStatistics::joinSize(*lhs, *lhsStats, *rhs, *rhsStats))
+                return size;
+        return std::max(*lhs, *rhs);
+    }
+    if(auto semiJoinOp = llvm::dyn_cast<daphne::SemiJoinOp>(op)) {
+        std::optional<double> lhs = numRows(semiJoinOp.lhs());
+        if(!lhs || frame != semiJoinOp.res())
+            return std::nullopt;
+        std::optional<std::string> lhsOn = constantString(semiJoinOp.lhsOn());
+        std::optional<std::string> rhsOn = constantString(semiJoinOp.rhsOn());
+        std::optional<ColumnStatistics> lhsStats = lhsOn ? columnStatistics(semiJoinOp.lhs(), *lhsOn) : std::nullopt;
+        std::optional<ColumnStatistics> rhsStats = rhsOn ? columnStatistics(semiJoinOp.rhs(), *rhsOn) : std::nullopt;
+        // the rows whose key is among the keys of the right input
+        if(lhsStats && rhsStats && lhsStats->numDistinct > 0 && rhsStats->numDistinct > 0)
+            return *lhs * lhsStats->nonNullFraction()
+                    * std::min(1.0, static_cast<double>(rhsStats->numDistinct) / lhsStats->numDistinct);
+        return lhs;
+    }
+    if(auto groupOp = llvm::dyn_cast<daphne::GroupOp>(op)) {
+        std::optional<double> input = numRows(groupOp.frame());
+        if(!input)
+            return std::nullopt;
+        // at most the product of the numbers of distinct keys
+        double res = 1;
+        for(Value key : groupOp.keyCol()) {
+            std::optional<std::string> label = constantString(key);
+            std::optional<ColumnStatistics> stats = label ? columnStatistics(groupOp.frame(), *label) : std::nullopt;
+            if(!stats || stats->numDistinct <= 0)
+                return std::nullopt;
+            res *= stats->numDistinct;
+        }
+        return std::min(res, *input);
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/io/ColumnStatistics.h>
+
+#include <mlir/IR/Value.h>
+
+#include <optional>
+#include <string>
+
+/**
+ * @brief Estimates the selectivities of filters and the numbers of rows of
+ * frames from the statistics of the columns of the files they are computed
+ * from (see `ColumnStatistics`), for the optimizations choosing between
+ * plans.
+ *
+ * Unlike the inferred shapes, which the kernels rely on, the estimates may be
+ * wrong. Without statistics, an equality selects `SELECTIVITY_EQUALITY` and
+ * any other condition `SELECTIVITY_OTHER` of the rows, and an equi-join of
+ * inputs without statistics is assumed to be on a key of one of them.
+ */
+namespace CardinalityEstimation {
+    constexpr double SELECTIVITY_EQUALITY = 0.1;
+    constexpr double SELECTIVITY_OTHER = 1.0 / 3;
+
+    /**
+     * @brief Returns the statistics of the column with the given label of a
+     * frame, if the column is (a subset of the rows of) a column of a file
+     * with statistics.
+     */
+    std::optional<ColumnStatistics> columnStatistics(mlir::Value frame, const std::string & label);
+
+    /**
+     * @brief Returns the estimated fraction of the rows of a frame a
+     * condition on its columns is true for, e.g., of the `selectedRows` of a
+     * `FilterRowOp`.
+     *
+     * The conditions are the conjunctions and disjunctions of comparisons of
+     * the columns extracted from the frame with constants.
+     */
+    double selectivity(mlir::Value cond, mlir::Value frame);
+
+    /**
+     * @brief Returns the estimated number of rows of a frame, its inferred
+     * number of rows if it is known.
+     */
+    std::optional<double> numRows(mlir::Value frame);
+}
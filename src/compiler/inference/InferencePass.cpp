@@ -19,7 +19,13 @@
 
 #include <mlir/Dialect/SCF/SCF.h>
 #include <mlir/IR/Operation.h>
+#include <mlir/IR/PatternMatch.h>
 #include <mlir/Pass/Pass.h>
+#include <mlir/Rewrite/FrozenRewritePatternSet.h>
+#include <mlir/Rewrite/PatternApplicator.h>
+#include <mlir/Transforms/FoldUtils.h>
+
+#include <llvm/ADT/DenseMap.h>
 
 #include <stdexcept>
 #include <memory>
@@ -33,14 +39,18 @@ daphne::InferenceConfig::InferenceConfig(bool partialInferenceAllowed,
                                          bool typeInference,
                                          bool shapeInference,
                                          bool frameLabelInference,
-                                         bool sparsityInference)
+                                         bool sparsityInference,
+                                         bool sparsityWorstCase,
+                                         bool fixpoint)
     : partialInferenceAllowed(partialInferenceAllowed), typeInference(typeInference), shapeInference(shapeInference),
-      frameLabelInference(frameLabelInference), sparsityInference(sparsityInference) {}
+      frameLabelInference(frameLabelInference), sparsityInference(sparsityInference),
+      sparsityWorstCase(sparsityWorstCase), fixpoint(fixpoint) {}
 
 namespace {
     /**
-     * @brief Removes properties that are fragile to changes in SCF operations (currently only sparsity). This
-     * ensures that they are valid in loop bodies. This is done inserting a `CastOp`
+     * @brief Removes properties that are fragile to changes in SCF operations (currently the sparsity of matrices
+     * and the sortedness of frames). This ensures that they are valid in loop bodies. This is done inserting a
+     * `CastOp`
      * @param opOperand The operand to the SCF operation
      * @return the new type without the properties
      */
@@ -54,8 +64,82 @@ namespace {
             opOperand.set(castOp);
             return castOp.getType();
         }
+        auto frmTy = ty.dyn_cast<daphne::FrameType>();
+        if(frmTy && frmTy.getSortedBy()) {
+            OpBuilder builder(opOperand.getOwner());
+            auto castOp = builder
+                .create<daphne::CastOp>(opOperand.getOwner()->getLoc(), frmTy.withSortedBy(nullptr), opOperand.get());
+            opOperand.set(castOp);
+            return castOp.getType();
+        }
         return ty;
     }
+
+    /**
+     * @brief The worklist of the fixpoint of the InferencePass, in the order the ops are pushed.
+     *
+     * The canonicalization patterns are applied with the worklist as their rewriter, such that it learns about the
+     * ops they insert, replace, and erase (like MLIR's greedy pattern rewrite driver does).
+     */
+    class InferenceWorklist : public PatternRewriter {
+        std::vector<Operation *> worklist;
+        llvm::DenseMap<Operation *, size_t> worklistIdxs;
+        size_t next = 0;
+
+    public:
+        explicit InferenceWorklist(MLIRContext * ctx) : PatternRewriter(ctx) {}
+
+        void push(Operation * op) {
+            if(worklistIdxs.count(op))
+                return;
+            worklistIdxs[op] = worklist.size();
+            worklist.push_back(op);
+        }
+
+        void remove(Operation * op) {
+            auto it = worklistIdxs.find(op);
+            if(it != worklistIdxs.end()) {
+                worklist[it->second] = nullptr;
+                worklistIdxs.erase(it);
+            }
+        }
+
+        /**
+         * @brief Returns the next op, or `nullptr` if the worklist is empty.
+         */
+        Operation * pop() {
+            while(next < worklist.size())
+                if(Operation * op = worklist[next++]) {
+                    worklistIdxs.erase(op);
+                    return op;
+                }
+            return nullptr;
+        }
+
+        /**
+         * @brief Pushes the users of the results of an op, and the ops whose regions yield them (e.g., loops).
+         */
+        void pushUsers(Operation * op) {
+            for(Value res : op->getResults())
+                for(Operation * user : res.getUsers()) {
+                    push(user);
+                    if(user->hasTrait<OpTrait::IsTerminator>() && !llvm::isa<FuncOp>(user->getParentOp()))
+                        push(user->getParentOp());
+                }
+        }
+
+        void notifyOperationInserted(Operation * op) override {
+            push(op);
+        }
+
+        void notifyOperationRemoved(Operation * op) override {
+            op->walk([&](Operation * nested) { remove(nested); });
+        }
+
+        void notifyRootReplaced(Operation * op) override {
+            pushUsers(op);
+        }
+    };
 }
 
 /**
@@ -67,6 +151,11 @@ namespace {
  * This approach can easily handle dependencies between different properties to
  * be infered without explicitly modeling them.
  * 
+ * With `InferenceConfig::fixpoint`, the walk is followed by a worklist of the
+ * operations, which are folded and canonicalized, and whose properties are
+ * inferred again whenever their operands changed, until nothing changes
+ * anymore (see `inferToFixpoint()`).
+ * 
  * Note that the actual inference logic is outsourced to MLIR operation
  * interfaces.
  */
@@ -90,6 +179,14 @@ class InferencePass : public PassWrapper<InferencePass, FunctionPass> {
             // need the labels in all cases.
         }
 
+        // Sortedness inference. Since the frame labels identify the columns
+        // by which a frame is sorted, it is done along with them. It is
+        // repeated whenever the op is visited, since known sortedness may be
+        // lost when the arguments change.
+        if(cfg.frameLabelInference)
+            if(auto inferSortednessOp = llvm::dyn_cast<daphne::InferSortedness>(op))
+                inferSortednessOp.inferSortedness();
+
         // Shape or Sparsity inference.
         bool doShapeInference = cfg.shapeInference && returnsUnknownShape(op);
         bool doSparsityInference = cfg.sparsityInference && returnsUnknownSparsity(op);
@@ -131,7 +228,7 @@ class InferencePass : public PassWrapper<InferencePass, FunctionPass> {
                 }
                 if (doSparsityInference) {
                     // Try to infer the sparsity of all results of this operation.
-                    std::vector<double> sparsities = daphne::tryInferSparsity(op);
+                    std::vector<double> sparsities = daphne::tryInferSparsity(op, cfg.sparsityWorstCase);
                     const size_t numRes = op->getNumResults();
                     if(sparsities.size() != numRes)
                         throw std::runtime_error(
@@ -265,11 +362,96 @@ class InferencePass : public PassWrapper<InferencePass, FunctionPass> {
         return WalkResult::advance();
     };
 
+    // the visits per op of the function after which the fixpoint is given up, a safeguard against patterns undoing
+    // each other
+    static constexpr size_t MAX_VISITS_PER_OP = 10;
+
+    FrozenRewritePatternSet patterns;
+
+    /**
+     * @brief Canonicalizes the ops of the function and infers the properties of the users of changed values again,
+     * until nothing changes anymore.
+     *
+     * Inference and canonicalization depend on each other, e.g., `nrow(X)` becomes a constant once the shape of `X`
+     * is inferred, which in turn may be the shape of a matrix created later (see #173). Instead of alternating both
+     * on the whole function for a fixed number of rounds, only the ops whose operands changed are visited again.
+     * Since the properties are only inferred where they are unknown, they only become more precise, and the
+     * worklist runs empty.
+     */
+    void inferToFixpoint(FuncOp func) {
+        InferenceWorklist worklist(&getContext());
+        size_t numOps = 0;
+        func.walk<WalkOrder::PreOrder>([&](Operation * op) {
+            if(op != func.getOperation()) {
+                worklist.push(op);
+                numOps++;
+            }
+        });
+        PatternApplicator applicator(patterns);
+        applicator.applyDefaultCostModel();
+        OperationFolder folder(&getContext());
+
+        daphne::InferenceStatistics stats;
+        stats.numRuns = 1;
+        const size_t maxVisits = MAX_VISITS_PER_OP * (numOps + 1);
+        while(Operation * op = worklist.pop()) {
+            if(stats.numVisits++ == maxVisits) {
+                stats.numNotConverged++;
+                func.emitWarning() << "property inference did not reach a fixpoint within " << maxVisits
+                        << " visits of ops";
+                break;
+            }
+
+            std::vector<Type> resTypes(op->getResultTypes().begin(), op->getResultTypes().end());
+            walkOp(op);
+            if(!llvm::equal(resTypes, op->getResultTypes())) {
+                stats.numRefined++;
+                worklist.pushUsers(op);
+            }
+
+            bool inPlaceUpdate = false;
+            auto preReplace = [&](Operation * folded) {
+                worklist.pushUsers(folded);
+                worklist.remove(folded);
+            };
+            if(succeeded(folder.tryToFold(op, nullptr, preReplace, &inPlaceUpdate))) {
+                stats.numFolded++;
+                if(inPlaceUpdate)
+                    worklist.push(op);
+                continue;
+            }
+            worklist.setInsertionPoint(op);
+            if(succeeded(applicator.matchAndRewrite(op, worklist)))
+                stats.numRewritten++;
+        }
+
+        if(daphne::InferenceStatistics * total = cfg.statistics) {
+            total->numRuns += stats.numRuns;
+            total->numVisits += stats.numVisits;
+            total->numRefined += stats.numRefined;
+            total->numFolded += stats.numFolded;
+            total->numRewritten += stats.numRewritten;
+            total->numNotConverged += stats.numNotConverged;
+        }
+    }
+
 public:
     InferencePass(daphne::InferenceConfig cfg) : cfg(cfg) {}
 
+    LogicalResult initialize(MLIRContext * context) override {
+        if(cfg.fixpoint) {
+            RewritePatternSet owningPatterns(context);
+            for(AbstractOperation * op : context->getRegisteredOperations())
+                op->getCanonicalizationPatterns(owningPatterns, context);
+            patterns = FrozenRewritePatternSet(std::move(owningPatterns));
+        }
+        return success();
+    }
+
     void runOnFunction() override {
         getFunction().walk<WalkOrder::PreOrder>(walkOp);
+        if(cfg.fixpoint)
+            inferToFixpoint(getFunction());
         // infer function return types
         getFunction().setType(FunctionType::get(&getContext(),
             getFunction().getType().getInputs(),
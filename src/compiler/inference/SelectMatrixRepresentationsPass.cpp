@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
 #include <ir/daphneir/Daphne.h>
 #include <ir/daphneir/Passes.h>
 
@@ -21,6 +22,8 @@
 #include <mlir/IR/Operation.h>
 #include <mlir/Pass/Pass.h>
 
+#include <llvm/ADT/DenseSet.h>
+
 #include <stdexcept>
 #include <memory>
 #include <vector>
@@ -28,9 +31,117 @@
 
 using namespace mlir;
 
+namespace {
+    /**
+     * @brief A cost model of the representations of matrices, which keeps
+     * chains of operations in the same representation unless changing it pays
+     * off.
+     *
+     * Processing a matrix costs one unit per cell if it is dense, and its
+     * sparsity divided by the threshold per cell if it is sparse, such that
+     * a matrix on its own is sparse below the threshold. Each pair of an
+     * operation and an operand in different representations additionally
+     * costs a conversion of the operand, i.e., one dense and one sparse pass
+     * over its cells. The representations are chosen by local search: each
+     * matrix (with known sparsity) in turn takes the representation of lower
+     * cost given those of its operands and users, until no matrix changes
+     * anymore. Since each change lowers the total cost, this terminates.
+     */
+    class RepresentationCostModel {
+        static constexpr size_t MAX_ROUNDS = 1 << 4;
+
+        const double threshold;
+        llvm::DenseSet<Value> & sparse;
+
+        static bool isMatrix(Value v) {
+            return v.getType().isa<daphne::MatrixType>();
+        }
+
+        static bool isScfOp(Operation * op) {
+            return op->getDialect() == op->getContext()->getOrLoadDialect<scf::SCFDialect>();
+        }
+
+        // the number of cells of the matrix, or of the other matrix of a conversion if unknown
+        static double cellsOf(Value v, Value other) {
+            auto matTy = v.getType().dyn_cast<daphne::MatrixType>();
+            if(matTy.getNumRows() != -1 && matTy.getNumCols() != -1)
+                return static_cast<double>(matTy.getNumRows()) * matTy.getNumCols();
+            if(other)
+                return cellsOf(other, nullptr);
+            return 1.0;
+        }
+
+        static double sparsityOf(Value v) {
+            const double sparsity = v.getType().dyn_cast<daphne::MatrixType>().getSparsity();
+            return sparsity == -1.0 ? 1.0 : sparsity;
+        }
+
+        double processingCost(Value v, bool isSparse) const {
+            return cellsOf(v, nullptr) * (isSparse ? sparsityOf(v) / threshold : 1.0);
+        }
+
+        // the cost of converting v, when used by (or using) w
+        double conversionCost(Value v, Value w) const {
+            return cellsOf(v, w) * (1.0 + sparsityOf(v) / threshold);
+        }
+
+        double cost(Value v, bool isSparse) const {
+            double c = processingCost(v, isSparse);
+            for(Value operand : v.getDefiningOp()->getOperands())
+                if(isMatrix(operand) && sparse.contains(operand) != isSparse)
+                    c += conversionCost(operand, v);
+            for(Operation * user : v.getUsers()) {
+                if(isScfOp(user))
+                    continue;
+                for(Value res : user->getResults())
+                    if(isMatrix(res) && sparse.contains(res) != isSparse) {
+                        c += conversionCost(v, res);
+                        break;
+                    }
+            }
+            return c;
+        }
+
+    public:
+        RepresentationCostModel(double threshold, llvm::DenseSet<Value> & sparse)
+                : threshold(threshold), sparse(sparse) {}
+
+        void select(const std::vector<Value> & candidates) {
+            bool changed = true;
+            for(size_t round = 0; changed && round < MAX_ROUNDS; round++) {
+                changed = false;
+                for(Value v : candidates) {
+                    const bool isSparse = sparse.contains(v);
+                    if(cost(v, !isSparse) < cost(v, isSparse)) {
+                        if(isSparse)
+                            sparse.erase(v);
+                        else
+                            sparse.insert(v);
+                        changed = true;
+                    }
+                }
+            }
+        }
+    };
+}
+
 class SelectMatrixRepresentationsPass : public PassWrapper<SelectMatrixRepresentationsPass, FunctionPass> {
-    static WalkResult walkOp(Operation *op) {
-        if(returnsKnownProperties(op)) {
+    const double threshold;
+    const bool useCostModel;
+    // only the representations requested by DaphneDSL annotations (`@sparse`, `@dense`) are set
+    const bool hintsOnly;
+
+    // the results of non-SCF operations to be represented as sparse matrices
+    llvm::DenseSet<Value> sparse;
+    // whether any operation of the function has a representation hint, whose result may have an unknown sparsity
+    bool anyHints = false;
+
+    void walkBlock(Block &block) {
+        block.walk<WalkOrder::PreOrder>([this](Operation *op) { return walkOp(op); });
+    }
+
+    WalkResult walkOp(Operation *op) {
+        if(anyHints || returnsKnownProperties(op)) {
             const bool isScfOp = op->getDialect() == op->getContext()->getOrLoadDialect<scf::SCFDialect>();
             // ----------------------------------------------------------------
             // Handle all non-SCF operations
@@ -39,9 +150,7 @@ class SelectMatrixRepresentationsPass : public PassWrapper<SelectMatrixRepresent
                 // Set the matrix representation for all result types
                 for(auto res : op->getResults()) {
                     if(auto matTy = res.getType().dyn_cast<daphne::MatrixType>()) {
-                        const double sparsity = matTy.getSparsity();
-                        // TODO: set threshold by user
-                        if(sparsity < 0.1) {
+                        if(sparse.contains(res)) {
                             res.setType(matTy.withRepresentation(daphne::MatrixRepresentation::Sparse));
                         }
                     }
@@ -65,8 +174,8 @@ class SelectMatrixRepresentationsPass : public PassWrapper<SelectMatrixRepresent
                 }
                 // Continue the walk on both blocks of the WhileOp. We trigger
                 // this explicitly, since we need to do something afterwards.
-                beforeBlock.walk<WalkOrder::PreOrder>(walkOp);
-                afterBlock.walk<WalkOrder::PreOrder>(walkOp);
+                walkBlock(beforeBlock);
+                walkBlock(afterBlock);
 
                 // Check if the infered matrix representations match the required result representations.
                 // This is not the case if, for instance, the representation of some
@@ -99,7 +208,7 @@ class SelectMatrixRepresentationsPass : public PassWrapper<SelectMatrixRepresent
                 }
                 // Continue the walk on the body block of the ForOp. We trigger
                 // this explicitly, since we need to do something afterwards.
-                block.walk<WalkOrder::PreOrder>(walkOp);
+                walkBlock(block);
                 // Check if the infered matrix representations match the required result representations.
                 // This is not the case if, for instance, the representation of some
                 // variable written in the loop changes. The ForOp would also
@@ -122,8 +231,8 @@ class SelectMatrixRepresentationsPass : public PassWrapper<SelectMatrixRepresent
             else if(auto ifOp = llvm::dyn_cast<scf::IfOp>(op)) {
                 // Walk the then/else blocks first. We need the inference on
                 // them before we can do anything about the IfOp itself.
-                ifOp.thenBlock()->walk<WalkOrder::PreOrder>(walkOp);
-                ifOp.elseBlock()->walk<WalkOrder::PreOrder>(walkOp);
+                walkBlock(*ifOp.thenBlock());
+                walkBlock(*ifOp.elseBlock());
                 // Check if the yielded matrix representations are the same in both
                 // branches. The IfOp would also check this later during
                 // verification, but here, we want to throw a readable error
@@ -150,9 +259,47 @@ class SelectMatrixRepresentationsPass : public PassWrapper<SelectMatrixRepresent
         return WalkResult::advance();
     };
 
+    // Decides on the representations of the results of all non-SCF
+    // operations, before the walk sets them. The results of operations with
+    // a representation hint get the requested one, regardless of their
+    // sparsity and the cost model.
+    void selectRepresentations() {
+        sparse.clear();
+        anyHints = false;
+        std::vector<Value> candidates;
+        getFunction().walk([&](Operation *op) {
+            if(op->getDialect() == op->getContext()->getOrLoadDialect<scf::SCFDialect>())
+                return;
+            auto hint = op->getAttrOfType<StringAttr>(daphne::ATTR_HINT_REPRESENTATION);
+            anyHints = anyHints || hint;
+            for(Value res : op->getResults())
+                if(auto matTy = res.getType().dyn_cast<daphne::MatrixType>()) {
+                    if(hint) {
+                        if(hint.getValue() == "sparse")
+                            sparse.insert(res);
+                        continue;
+                    }
+                    const double sparsity = matTy.getSparsity();
+                    if(hintsOnly || sparsity == -1.0)
+                        continue;
+                    candidates.push_back(res);
+                    if(sparsity < threshold)
+                        sparse.insert(res);
+                }
+        });
+        if(useCostModel && !hintsOnly)
+            RepresentationCostModel(threshold, sparse).select(candidates);
+    }
+
 public:
+    SelectMatrixRepresentationsPass(double threshold, bool useCostModel, bool hintsOnly)
+            : threshold(threshold), useCostModel(useCostModel), hintsOnly(hintsOnly) {}
+
     void runOnFunction() override {
-        getFunction().walk<WalkOrder::PreOrder>(walkOp);
+        selectRepresentations();
+        if(hintsOnly && !anyHints)
+            return;
+        getFunction().walk<WalkOrder::PreOrder>([this](Operation *op) { return walkOp(op); });
         // infer function return types
         // TODO: cast for UDFs?
         getFunction().setType(FunctionType::get(&getContext(),
@@ -169,6 +316,6 @@ public:
     }
 };
 
-std::unique_ptr<Pass> daphne::createSelectMatrixRepresentationsPass() {
-    return std::make_unique<SelectMatrixRepresentationsPass>();
+std::unique_ptr<Pass> daphne::createSelectMatrixRepresentationsPass(const DaphneUserConfig& cfg, bool hintsOnly) {
+    return std::make_unique<SelectMatrixRepresentationsPass>(cfg.sparse_threshold, cfg.sparse_cost_model, hintsOnly);
 }
\ No newline at end of file
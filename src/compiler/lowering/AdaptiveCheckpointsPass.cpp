@@ -0,0 +1,241 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/IR/BlockAndValueMapping.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/SetVector.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Splits `main` after the first operation whose result has a shape
+ * that is unknown at compile-time, i.e., a read without full meta data, a
+ * filter, or a join, such that the remainder is compiled at run-time for the
+ * actual properties of the intermediate results.
+ *
+ * The operations after this checkpoint are moved into a function
+ * (`ADAPTIVE_TAIL_FUNC`), whose arguments are the matrices and frames they
+ * use. Constant scalars are copied into the function, other numeric scalars
+ * are passed as 1x1 matrices. The function is printed, along with the other
+ * functions it may call, and replaced by an `AdaptiveCallOp` with this IR.
+ * At run-time, the `AdaptiveRecompiler` sets the argument types to the actual
+ * shapes, sparsities, and representations, and runs all passes on it, which
+ * may find the next checkpoint in it.
+ *
+ * Only the top-level operations of `main` (or of a remainder) are considered,
+ * not those in loops or branches, and only if all scalars used after the
+ * checkpoint can be passed.
+ */
+struct AdaptiveCheckpointsPass : public PassWrapper<AdaptiveCheckpointsPass, OperationPass<ModuleOp>> {
+    void runOnOperation() final;
+};
+
+namespace {
+    bool hasUnknownShape(Type t) {
+        if(auto matTy = t.dyn_cast<daphne::MatrixType>())
+            return matTy.getNumRows() == -1 || matTy.getNumCols() == -1;
+        if(auto frmTy = t.dyn_cast<daphne::FrameType>())
+            return frmTy.getNumRows() == -1 || frmTy.getNumCols() == -1;
+        return false;
+    }
+
+    bool isCheckpoint(Operation * op) {
+        if(!llvm::isa<
+                daphne::ReadOp, daphne::FilterRowOp,
+                daphne::InnerJoinOp, daphne::ThetaJoinOp, daphne::FullOuterJoinOp, daphne::LeftOuterJoinOp,
+                daphne::AntiJoinOp, daphne::SemiJoinOp, daphne::GroupJoinOp
+        >(op))
+            return false;
+        return llvm::any_of(op->getResultTypes(), hasUnknownShape);
+    }
+
+    // The value types of the scalars the fill kernel supports.
+    bool isFillable(Type t) {
+        return t.isF64() || t.isF32() || t.isSignedInteger(64) || t.isUnsignedInteger(8);
+    }
+
+    bool isPassableScalar(Type t) {
+        return isFillable(t) || t.isIndex() || t.isa<IntegerType>();
+    }
+
+    /**
+     * @brief The remainder of an entry function after a checkpoint.
+     */
+    struct Tail {
+        std::vector<Operation *> ops;
+        // values defined before the checkpoint and used by the ops
+        llvm::SetVector<Value> liveIns;
+    };
+
+    // The top-level op of the block (or the block's parent op) containing the definition of the value.
+    Operation * definingTopLevelOp(Value v, Block & block) {
+        Operation * op = v.getDefiningOp();
+        if(!op) {
+            if(v.getParentBlock() == &block)
+                return nullptr;
+            op = v.getParentBlock()->getParentOp();
+        }
+        while(op && op->getBlock() != &block)
+            op = op->getParentOp();
+        return op;
+    }
+
+    Tail collectTail(Operation * checkpoint) {
+        Block & block = *checkpoint->getBlock();
+        Tail tail;
+        for(Operation * op = checkpoint->getNextNode(); op && !op->hasTrait<OpTrait::IsTerminator>();
+                op = op->getNextNode())
+            tail.ops.push_back(op);
+        for(Operation * op : tail.ops)
+            op->walk([&](Operation * nested) {
+                for(Value v : nested->getOperands()) {
+                    Operation * def = definingTopLevelOp(v, block);
+                    if(!def || !checkpoint->isBeforeInBlock(def))
+                        tail.liveIns.insert(v);
+                }
+            });
+        return tail;
+    }
+
+    bool isConstant(Value v) {
+        return static_cast<bool>(v.getDefiningOp<daphne::ConstantOp>());
+    }
+
+    bool canPass(Value v) {
+        Type t = v.getType();
+        return t.isa<daphne::MatrixType, daphne::FrameType>() || isConstant(v) || isPassableScalar(t);
+    }
+
+    // The value as a matrix or frame to pass to the remainder.
+    Value boxArgument(OpBuilder & builder, Location loc, Value v) {
+        Type t = v.getType();
+        if(t.isa<daphne::MatrixType, daphne::FrameType>())
+            return v;
+        if(!isFillable(t))
+            v = builder.create<daphne::CastOp>(loc, builder.getIntegerType(64, true), v);
+        Value one = builder.create<daphne::ConstantOp>(loc, builder.getIndexAttr(1));
+        return builder.create<daphne::FillOp>(
+                loc, daphne::MatrixType::get(builder.getContext(), v.getType()).withShape(1, 1), v, one, one
+        );
+    }
+
+    // The inverse of boxArgument() in the remainder.
+    Value unboxArgument(OpBuilder & builder, Location loc, Value arg, Type t) {
+        if(t.isa<daphne::MatrixType, daphne::FrameType>())
+            return arg;
+        Type vt = arg.getType().dyn_cast<daphne::MatrixType>().getElementType();
+        Value v = builder.create<daphne::CastOp>(loc, vt, arg);
+        if(vt != t)
+            v = builder.create<daphne::CastOp>(loc, t, v);
+        return v;
+    }
+
+    /**
+     * @brief Copies the remainder into a function of a new module and returns
+     * the printed module.
+     */
+    std::string outlineTail(ModuleOp module, FuncOp entry, const Tail & tail, ValueRange args) {
+        OpBuilder builder(module.getContext());
+        Location loc = entry.getLoc();
+        ModuleOp tailModule = ModuleOp::create(loc);
+        builder.setInsertionPointToEnd(tailModule.getBody());
+        for(FuncOp f : module.getOps<FuncOp>())
+            if(f != entry)
+                builder.clone(*f);
+
+        std::vector<Type> argTypes;
+        for(Value arg : args)
+            argTypes.push_back(arg.getType());
+        auto tailFunc = builder.create<FuncOp>(
+                loc, daphne::ADAPTIVE_TAIL_FUNC, builder.getFunctionType(argTypes, {})
+        );
+        Block * body = tailFunc.addEntryBlock();
+        builder.setInsertionPointToStart(body);
+
+        BlockAndValueMapping mapping;
+        size_t i = 0;
+        for(Value v : tail.liveIns) {
+            if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+                mapping.map(v, builder.clone(*co)->getResult(0));
+            else
+                mapping.map(v, unboxArgument(builder, loc, body->getArgument(i++), v.getType()));
+        }
+        for(Operation * op : tail.ops)
+            builder.clone(*op, mapping);
+        builder.create<daphne::ReturnOp>(loc);
+
+        std::string ir;
+        llvm::raw_string_ostream os(ir);
+        tailModule.print(os);
+        os.flush();
+        tailModule.erase();
+        return ir;
+    }
+
+    void splitAtCheckpoint(ModuleOp module, FuncOp entry) {
+        Block & block = entry.body().front();
+        if(block.getTerminator()->getNumOperands())
+            return;
+        for(Operation & checkpoint : block) {
+            if(!isCheckpoint(&checkpoint))
+                continue;
+            Tail tail = collectTail(&checkpoint);
+            if(tail.ops.empty())
+                return;
+            // without arguments, there is nothing to adapt to
+            if(!llvm::all_of(tail.liveIns, canPass) || llvm::all_of(tail.liveIns, isConstant))
+                continue;
+
+            OpBuilder builder(checkpoint.getContext());
+            builder.setInsertionPointAfter(&checkpoint);
+            Location loc = checkpoint.getLoc();
+            std::vector<Value> args;
+            for(Value v : tail.liveIns)
+                if(!isConstant(v))
+                    args.push_back(boxArgument(builder, loc, v));
+
+            Value irVal = builder.create<daphne::ConstantOp>(loc, outlineTail(module, entry, tail, args));
+            builder.create<daphne::AdaptiveCallOp>(loc, irVal, args);
+            for(auto it = tail.ops.rbegin(); it != tail.ops.rend(); ++it)
+                (*it)->erase();
+            return;
+        }
+    }
+}
+
+void AdaptiveCheckpointsPass::runOnOperation() {
+    ModuleOp module = getOperation();
+    std::vector<FuncOp> entries;
+    for(FuncOp f : module.getOps<FuncOp>())
+        if(f.getName() == "main" || f.getName() == daphne::ADAPTIVE_TAIL_FUNC)
+            entries.push_back(f);
+    for(FuncOp entry : entries)
+        splitAtCheckpoint(module, entry);
+}
+
+std::unique_ptr<Pass> daphne::createAdaptiveCheckpointsPass() {
+    return std::make_unique<AdaptiveCheckpointsPass>();
+}
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Pass/Pass.h>
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Rewrites matrix expressions to cheaper equivalent ones, based on the
+ * shapes inferred before.
+ *
+ * - The chains of matrix multiplications are reassociated in the order of the
+ *   fewest scalar multiplications, as found by dynamic programming, if that
+ *   is cheaper than the given order.
+ * - The transposition of a matrix multiplication is pushed into its
+ *   `transa`/`transb` flags, i.e., `t(A @ B)` becomes `t(B) @ t(A)`, just
+ *   like the canonicalization of `MatMulOp` does with transposed operands.
+ * - `t(X) @ X` becomes `syrk(X)` and `t(A) @ v` becomes `gemv(A, v)`.
+ * - `sum(a * b)` of two vectors becomes their dot product, i.e., `t(a) @ b`.
+ * - `diagVector(A @ B)` only computes the diagonal, as `rowSums(A * t(B))`.
+ *
+ * The rewritten operations must have a single use, such that no other user
+ * still needs them. This pass runs after the selection of the matrix
+ * representations and only involves dense matrices of the same value type,
+ * for which all the kernels exist.
+ */
+struct AlgebraicSimplificationPass : public PassWrapper<AlgebraicSimplificationPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+namespace {
+    std::optional<bool> constantBool(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto boolAttr = co.value().dyn_cast<BoolAttr>())
+                return boolAttr.getValue();
+        return std::nullopt;
+    }
+
+    daphne::MatrixType denseMatrixType(Value v) {
+        auto matTy = v.getType().dyn_cast<daphne::MatrixType>();
+        if(!matTy || matTy.getRepresentation() != daphne::MatrixRepresentation::Dense)
+            return nullptr;
+        return matTy;
+    }
+
+    // whether v is a dense matrix of a floating-point value type, as required by the BLAS-based kernels
+    bool isDenseFloatMatrix(Value v) {
+        auto matTy = denseMatrixType(v);
+        return matTy && (matTy.getElementType().isF64() || matTy.getElementType().isF32());
+    }
+
+    // whether the op has a single use in its own block
+    bool hasSingleLocalUse(Operation * op) {
+        return op->getResult(0).hasOneUse() && (*op->getResult(0).getUsers().begin())->getBlock() == op->getBlock();
+    }
+
+    daphne::MatrixType resultType(Type vt, ssize_t numRows, ssize_t numCols) {
+        return daphne::MatrixType::get(vt.getContext(), vt).withShape(numRows, numCols);
+    }
+
+    Value createBool(OpBuilder & builder, Location loc, bool b) {
+        return builder.create<daphne::ConstantOp>(loc, builder.getBoolAttr(b));
+    }
+
+    // ************************************************************************
+    // Matrix multiplication chains
+    // ************************************************************************
+
+    // whether the matMul is dense, has constant flags, and its result has the value type
+    bool isChainable(daphne::MatMulOp op, Type vt) {
+        auto matTy = denseMatrixType(op.res());
+        return matTy && matTy.getElementType() == vt && constantBool(op.transa()) && constantBool(op.transb());
+    }
+
+    // whether the matMul is part of the chain of the matMul using its result
+    bool isInnerOfChain(daphne::MatMulOp op) {
+        if(!hasSingleLocalUse(op))
+            return false;
+        auto user = llvm::dyn_cast<daphne::MatMulOp>(*op.res().getUsers().begin());
+        auto matTy = denseMatrixType(op.res());
+        return user && matTy && isChainable(op, matTy.getElementType()) && isChainable(user, matTy.getElementType());
+    }
+
+    struct Factor {
+        Value value;
+        bool transposed;
+        ssize_t numRows;
+        ssize_t numCols;
+    };
+
+    /**
+     * @brief The factors of a chain of matrix multiplications, the
+     * operations computing it (outermost first), and the number of scalar
+     * multiplications of the given order.
+     */
+    struct MatMulChain {
+        Type vt;
+        std::vector<Factor> factors;
+        std::vector<Operation *> ops;
+        double cost = 0;
+        bool valid = true;
+
+        // Adds the factors of the value, transposed or not, and returns its shape.
+        std::pair<ssize_t, ssize_t> add(Value v, bool transposed) {
+            auto op = v.getDefiningOp<daphne::MatMulOp>();
+            if(op && isInnerOfChain(op))
+                return add(op, transposed);
+            auto matTy = denseMatrixType(v);
+            if(!matTy || matTy.getElementType() != vt || matTy.getNumRows() == -1 || matTy.getNumCols() == -1) {
+                valid = false;
+                return {-1, -1};
+            }
+            Factor f{v, transposed, matTy.getNumRows(), matTy.getNumCols()};
+            if(transposed)
+                std::swap(f.numRows, f.numCols);
+            factors.push_back(f);
+            return {f.numRows, f.numCols};
+        }
+
+        std::pair<ssize_t, ssize_t> add(daphne::MatMulOp op, bool transposed) {
+            ops.push_back(op);
+            const bool ta = *constantBool(op.transa());
+            const bool tb = *constantBool(op.transb());
+            // t(A @ B) = t(B) @ t(A)
+            auto lhs = transposed ? add(op.rhs(), !tb) : add(op.lhs(), ta);
+            auto rhs = transposed ? add(op.lhs(), !ta) : add(op.rhs(), tb);
+            cost += static_cast<double>(lhs.first) * lhs.second * rhs.second;
+            return {lhs.first, rhs.second};
+        }
+    };
+
+    /**
+     * @brief Reassociates the chain rooted at the matMul in the order of the
+     * fewest scalar multiplications, if that is cheaper than the given order.
+     */
+    void reorderMatMulChain(daphne::MatMulOp root) {
+        auto rootTy = denseMatrixType(root.res());
+        if(!rootTy || !isChainable(root, rootTy.getElementType()))
+            return;
+        MatMulChain chain{rootTy.getElementType()};
+        chain.add(root, false);
+        const size_t n = chain.factors.size();
+        if(!chain.valid || n < 3)
+            return;
+
+        // the classic dynamic program: cost[i][j] is the cheapest product of the factors i to j, split after split[i][j]
+        std::vector<std::vector<double>> cost(n, std::vector<double>(n, 0));
+        std::vector<std::vector<size_t>> split(n, std::vector<size_t>(n, 0));
+        for(size_t len = 2; len <= n; len++)
+            for(size_t i = 0; i + len <= n; i++) {
+                const size_t j = i + len - 1;
+                cost[i][j] = std::numeric_limits<double>::infinity();
+                for(size_t s = i; s < j; s++) {
+                    const double c = cost[i][s] + cost[s + 1][j] + static_cast<double>(chain.factors[i].numRows)
+                            * chain.factors[s].numCols * chain.factors[j].numCols;
+                    if(c < cost[i][j]) {
+                        cost[i][j] = c;
+                        split[i][j] = s;
+                    }
+                }
+            }
+        if(cost[0][n - 1] >= chain.cost)
+            return;
+
+        OpBuilder builder(root);
+        Location loc = root.getLoc();
+        std::function<std::pair<Value, bool>(size_t, size_t)> build = [&](size_t i, size_t j) {
+            if(i == j)
+                return std::make_pair(chain.factors[i].value, chain.factors[i].transposed);
+            auto lhs = build(i, split[i][j]);
+            auto rhs = build(split[i][j] + 1, j);
+            Type resTy = (i == 0 && j == n - 1)
+                    ? root.getType()
+                    : resultType(chain.vt, chain.factors[i].numRows, chain.factors[j].numCols);
+            Value res = builder.create<daphne::MatMulOp>(
+                    loc, resTy, lhs.first, rhs.first,
+                    createBool(builder, loc, lhs.second), createBool(builder, loc, rhs.second)
+            );
+            return std::make_pair(res, false);
+        };
+        Value res = build(0, n - 1).first;
+        root.res().replaceAllUsesWith(res);
+        for(Operation * op : chain.ops)
+            op->erase();
+    }
+
+    // ************************************************************************
+    // Local rewrites
+    // ************************************************************************
+
+    // t(A @ B) -> t(B) @ t(A)
+    void pushDownTranspose(daphne::TransposeOp op) {
+        auto matMulOp = op.arg().getDefiningOp<daphne::MatMulOp>();
+        if(!matMulOp || !hasSingleLocalUse(matMulOp))
+            return;
+        auto ta = constantBool(matMulOp.transa());
+        auto tb = constantBool(matMulOp.transb());
+        if(!ta || !tb)
+            return;
+        OpBuilder builder(op);
+        Location loc = op.getLoc();
+        Value res = builder.create<daphne::MatMulOp>(
+                loc, op.getType(), matMulOp.rhs(), matMulOp.lhs(),
+                createBool(builder, loc, !*tb), createBool(builder, loc, !*ta)
+        );
+        op.res().replaceAllUsesWith(res);
+        op.erase();
+        matMulOp.erase();
+    }
+
+    // sum(a * b) -> t(a) @ b for column vectors, a @ t(b) for row vectors
+    void rewriteToDotProduct(daphne::AllAggSumOp op) {
+        auto mulOp = op.arg().getDefiningOp<daphne::EwMulOp>();
+        if(!mulOp || !hasSingleLocalUse(mulOp) || !isDenseFloatMatrix(mulOp.lhs()) || !isDenseFloatMatrix(mulOp.rhs()))
+            return;
+        auto lhsTy = denseMatrixType(mulOp.lhs());
+        auto rhsTy = denseMatrixType(mulOp.rhs());
+        Type vt = lhsTy.getElementType();
+        if(rhsTy.getElementType() != vt || op.getType() != vt || lhsTy.getNumRows() != rhsTy.getNumRows()
+                || lhsTy.getNumCols() != rhsTy.getNumCols())
+            return;
+        const bool isCol = lhsTy.getNumCols() == 1 && lhsTy.getNumRows() != -1;
+        const bool isRow = lhsTy.getNumRows() == 1 && lhsTy.getNumCols() != -1;
+        if(!isCol && !isRow)
+            return;
+        OpBuilder builder(op);
+        Location loc = op.getLoc();
+        Value dot;
+        if(isCol)
+            dot = builder.create<daphne::GemvOp>(loc, resultType(vt, 1, 1), mulOp.lhs(), mulOp.rhs());
+        else
+            dot = builder.create<daphne::MatMulOp>(
+                    loc, resultType(vt, 1, 1), mulOp.lhs(), mulOp.rhs(),
+                    createBool(builder, loc, false), createBool(builder, loc, true)
+            );
+        op.res().replaceAllUsesWith(builder.create<daphne::CastOp>(loc, vt, dot).res());
+        op.erase();
+        mulOp.erase();
+    }
+
+    // diagVector(A @ B) -> rowSums(A * t(B)), diagVector(t(A) @ B) -> t(colSums(A * B))
+    void rewriteDiagOfMatMul(daphne::DiagVectorOp op) {
+        auto matMulOp = op.arg().getDefiningOp<daphne::MatMulOp>();
+        if(!matMulOp || !hasSingleLocalUse(matMulOp))
+            return;
+        auto ta = constantBool(matMulOp.transa());
+        auto tb = constantBool(matMulOp.transb());
+        auto lhsTy = denseMatrixType(matMulOp.lhs());
+        auto rhsTy = denseMatrixType(matMulOp.rhs());
+        auto resTy = denseMatrixType(op.res());
+        if(!ta || !tb || !lhsTy || !rhsTy || !resTy)
+            return;
+        Type vt = resTy.getElementType();
+        if(lhsTy.getElementType() != vt || rhsTy.getElementType() != vt)
+            return;
+
+        OpBuilder builder(op);
+        Location loc = op.getLoc();
+        // the right-hand side in the shape of the (possibly transposed) left-hand side
+        Value rhs = matMulOp.rhs();
+        if(*ta == *tb)
+            rhs = builder.create<daphne::TransposeOp>(
+                    loc, resultType(vt, rhsTy.getNumCols(), rhsTy.getNumRows()), rhs
+            );
+        Value prod = builder.create<daphne::EwMulOp>(
+                loc, resultType(vt, lhsTy.getNumRows(), lhsTy.getNumCols()), matMulOp.lhs(), rhs
+        );
+        Value res;
+        if(!*ta)
+            res = builder.create<daphne::RowAggSumOp>(loc, op.getType(), prod);
+        else {
+            Value colSums = builder.create<daphne::ColAggSumOp>(loc, resultType(vt, 1, lhsTy.getNumCols()), prod);
+            res = builder.create<daphne::TransposeOp>(loc, op.getType(), colSums);
+        }
+        op.res().replaceAllUsesWith(res);
+        op.erase();
+        matMulOp.erase();
+    }
+
+    // t(X) @ X -> syrk(X), t(A) @ v -> gemv(A, v)
+    void selectSyrkOrGemv(daphne::MatMulOp op) {
+        auto ta = constantBool(op.transa());
+        auto tb = constantBool(op.transb());
+        auto resTy = denseMatrixType(op.res());
+        if(!ta || !tb || !*ta || *tb || !isDenseFloatMatrix(op.res()))
+            return;
+        auto lhsTy = op.lhs().getType().dyn_cast<daphne::MatrixType>();
+        if(!lhsTy || lhsTy.getElementType() != resTy.getElementType())
+            return;
+        OpBuilder builder(op);
+        Value res;
+        if(op.lhs() == op.rhs())
+            // the kernel also supports a sparse matrix
+            res = builder.create<daphne::SyrkOp>(op.getLoc(), op.getType(), op.lhs());
+        else if(isDenseFloatMatrix(op.rhs()) && denseMatrixType(op.rhs()).getElementType() == resTy.getElementType()
+                && denseMatrixType(op.rhs()).getNumCols() == 1)
+            // the kernel also supports a sparse matrix
+            res = builder.create<daphne::GemvOp>(op.getLoc(), op.getType(), op.lhs(), op.rhs());
+        else
+            return;
+        op.res().replaceAllUsesWith(res);
+        op.erase();
+    }
+}
+
+void AlgebraicSimplificationPass::runOnFunction() {
+    auto func = getFunction();
+
+    std::vector<daphne::TransposeOp> transposeOps;
+    func->walk([&](daphne::TransposeOp op) { transposeOps.push_back(op); });
+    for(auto op : transposeOps)
+        pushDownTranspose(op);
+
+    std::vector<daphne::MatMulOp> chainRoots;
+    func->walk([&](daphne::MatMulOp op) {
+        if(!isInnerOfChain(op))
+            chainRoots.push_back(op);
+    });
+    for(auto op : chainRoots)
+        reorderMatMulChain(op);
+
+    std::vector<daphne::DiagVectorOp> diagOps;
+    func->walk([&](daphne::DiagVectorOp op) { diagOps.push_back(op); });
+    for(auto op : diagOps)
+        rewriteDiagOfMatMul(op);
+
+    std::vector<daphne::AllAggSumOp> sumOps;
+    func->walk([&](daphne::AllAggSumOp op) { sumOps.push_back(op); });
+    for(auto op : sumOps)
+        rewriteToDotProduct(op);
+
+    std::vector<daphne::MatMulOp> matMulOps;
+    func->walk([&](daphne::MatMulOp op) { matMulOps.push_back(op); });
+    for(auto op : matMulOps)
+        selectSyrkOrGemv(op);
+}
+
+std::unique_ptr<Pass> daphne::createAlgebraicSimplificationPass() {
+    return std::make_unique<AlgebraicSimplificationPass>();
+}
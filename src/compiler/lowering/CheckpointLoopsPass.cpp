@@ -0,0 +1,149 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Dialect/SCF/SCF.h>
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Checkpoints the state of the loops of `main`, such that a program
+ * that is run again, e.g., after a failure of the coordinator or of more
+ * distributed workers than it survives, resumes each loop after the iteration
+ * of its last checkpoint instead of starting over.
+ *
+ * After an iteration, the values the loop updates are saved into the
+ * directory of the loop below `checkpoint_dir` if `checkpoint_interval_s`
+ * seconds have passed since the last checkpoint (see Checkpoint.h). Before the
+ * loop, they are restored from the last checkpoint, if any, and a for-loop
+ * starts at the iteration after it. The checkpoints are removed when the loop
+ * has finished.
+ *
+ * Only the loops directly in `main` (not nested ones, which are part of the
+ * state of the iterations of the loops around them) whose updated values are
+ * all matrices of the types of Daphne binary files are checkpointed. A loop is
+ * identified by its position in `main`, so the checkpoints must be removed if
+ * the program changes.
+ */
+struct CheckpointLoopsPass : public PassWrapper<CheckpointLoopsPass, FunctionPass> {
+    const DaphneUserConfig& userConfig;
+
+    explicit CheckpointLoopsPass(const DaphneUserConfig& cfg) : userConfig(cfg) {}
+
+    void runOnFunction() final;
+};
+
+// whether a value updated by a loop can be saved as a Daphne binary file
+static bool isCheckpointable(Type t) {
+    auto matTy = t.dyn_cast<daphne::MatrixType>();
+    if(!matTy)
+        return false;
+    Type et = matTy.getElementType();
+    if(matTy.getRepresentation() == daphne::MatrixRepresentation::Sparse)
+        return et.isF64();
+    return et.isF64() || et.isF32() || et.isSignedInteger(64) || et.isUnsignedInteger(8);
+}
+
+static bool isCheckpointable(ValueRange values) {
+    return !values.empty() && llvm::all_of(values.getTypes(), [](Type t) { return isCheckpointable(t); });
+}
+
+// restores the initial values of a loop from the last checkpoint, where the first one is the operand of the given
+// index of the loop
+static void insertRestores(OpBuilder & builder, Operation * loopOp, unsigned firstOperand, Value dir) {
+    Location loc = loopOp->getLoc();
+    builder.setInsertionPoint(loopOp);
+    for(unsigned i = firstOperand; i < loopOp->getNumOperands(); i++) {
+        Value init = loopOp->getOperand(i);
+        Value index = builder.create<daphne::ConstantOp>(loc, builder.getIndexAttr(i - firstOperand));
+        loopOp->setOperand(i, builder.create<daphne::CheckpointRestoreOp>(loc, init.getType(), init, dir, index));
+    }
+}
+
+// saves the values yielded by the body of a loop as the checkpoint after the given iteration, if one is due
+static void insertSaves(OpBuilder & builder, Operation * yieldOp, Value dir, Value iteration) {
+    Location loc = yieldOp->getLoc();
+    builder.setInsertionPoint(yieldOp);
+    Value due = builder.create<daphne::CheckpointDueOp>(loc, builder.getI1Type(), dir);
+    auto ifOp = builder.create<scf::IfOp>(loc, TypeRange{}, due, false);
+    OpBuilder thenBuilder = ifOp.getThenBodyBuilder();
+    for(unsigned i = 0; i < yieldOp->getNumOperands(); i++) {
+        Value index = thenBuilder.create<daphne::ConstantOp>(loc, thenBuilder.getIndexAttr(i));
+        thenBuilder.create<daphne::CheckpointSaveOp>(loc, yieldOp->getOperand(i), dir, index);
+    }
+    thenBuilder.create<daphne::CheckpointCommitOp>(loc, dir, iteration);
+}
+
+void CheckpointLoopsPass::runOnFunction() {
+    FuncOp func = getFunction();
+    if(func.getName() != "main")
+        return;
+
+    std::vector<Operation *> loops;
+    for(Operation & op : func.body().front())
+        if(llvm::isa<scf::ForOp, scf::WhileOp>(op))
+            loops.push_back(&op);
+
+    OpBuilder builder(&getContext());
+    for(size_t loopIx = 0; loopIx < loops.size(); loopIx++) {
+        Operation * loopOp = loops[loopIx];
+        Location loc = loopOp->getLoc();
+        builder.setInsertionPoint(loopOp);
+        Value dir;
+        auto makeDir = [&]() -> Value {
+            const std::string dirName = userConfig.checkpoint_dir + "/loop" + std::to_string(loopIx);
+            return builder.create<daphne::ConstantOp>(
+                    loc, daphne::StringType::get(&getContext()), builder.getStringAttr(dirName)
+            );
+        };
+
+        if(auto forOp = llvm::dyn_cast<scf::ForOp>(loopOp)) {
+            if(!isCheckpointable(forOp.getIterOperands()))
+                continue;
+            dir = makeDir();
+            insertRestores(builder, forOp, forOp.getNumControlOperands(), dir);
+            builder.setInsertionPoint(forOp);
+            forOp->setOperand(0, builder.create<daphne::CheckpointResumeOp>(
+                    loc, builder.getIndexType(), forOp.lowerBound(), forOp.step(), dir
+            ));
+            insertSaves(builder, forOp.getBody()->getTerminator(), dir, forOp.getInductionVar());
+        }
+        else {
+            auto whileOp = llvm::cast<scf::WhileOp>(loopOp);
+            if(!isCheckpointable(whileOp->getOperands()))
+                continue;
+            dir = makeDir();
+            Value iteration = builder.create<daphne::ConstantOp>(loc, builder.getIndexAttr(0));
+            insertRestores(builder, whileOp, 0, dir);
+            insertSaves(builder, whileOp.after().front().getTerminator(), dir, iteration);
+        }
+
+        builder.setInsertionPointAfter(loopOp);
+        builder.create<daphne::CheckpointClearOp>(loc, dir);
+    }
+}
+
+std::unique_ptr<Pass> daphne::createCheckpointLoopsPass(const DaphneUserConfig& cfg) {
+    return std::make_unique<CheckpointLoopsPass>(cfg);
+}
@@ -23,6 +23,11 @@
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/Transforms/DialectConversion.h"
 
+#include <llvm/ADT/DenseSet.h>
+
+#include <set>
+#include <vector>
+
 using namespace mlir;
 
 /**
@@ -47,6 +52,12 @@ struct DistributePipelines : public OpConversionPattern<daphne::VectorizedPipeli
 
         BlockAndValueMapping mapper;
         op.body().cloneInto(&funcOp.getRegion(), mapper);
+        if (auto resident = op->getAttrOfType<ArrayAttr>(daphne::ATTR_RESIDENT_OUTPUTS)) {
+            std::vector<bool> isResident;
+            for (Attribute attr : resident)
+                isResident.push_back(attr.cast<BoolAttr>().getValue());
+            funcOp->setAttr(daphne::ATTR_RESIDENT_OUTPUTS, tempBuilder.getBoolArrayAttr(isResident));
+        }
 
         std::string s;
         llvm::raw_string_ostream stream(s);
@@ -63,9 +74,152 @@ struct DistributePipelines : public OpConversionPattern<daphne::VectorizedPipeli
     }
 };
 
+/**
+ * @brief Whether the pipeline can be distributed, i.e., its results are dense matrices of the same value type and its
+ * matrix inputs are dense or sparse, of a value type the workers receive (see ProtoDataConverter), unless it is kept
+ * at the coordinator by the DaphneDSL annotation `@distributed(false)`.
+ */
+static bool isDistributable(daphne::VectorizedPipelineOp op)
+{
+    if (auto hint = op->getAttrOfType<BoolAttr>(daphne::ATTR_HINT_DISTRIBUTED))
+        if (!hint.getValue())
+            return false;
+    auto isSupportedValueType = [](Type t) {
+        return t.isF64() || t.isF32() || t.isSignedInteger(64) || t.isSignedInteger(32);
+    };
+    Type resValueType;
+    for (Type t : op.outputs().getTypes()) {
+        auto matTy = t.dyn_cast<daphne::MatrixType>();
+        if (!matTy || matTy.getRepresentation() != daphne::MatrixRepresentation::Dense
+                || !isSupportedValueType(matTy.getElementType())
+                || (resValueType && matTy.getElementType() != resValueType))
+            return false;
+        resValueType = matTy.getElementType();
+    }
+    for (Type t : op.inputs().getTypes()) {
+        if (t.isa<daphne::FrameType>())
+            return false;
+        if (auto matTy = t.dyn_cast<daphne::MatrixType>())
+            if (!isSupportedValueType(matTy.getElementType()))
+                return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Whether the use is an input of the (vectorized or distributed) pipeline, which splits it by rows.
+ */
+template<class PipelineOp>
+static bool isSplitByRows(PipelineOp pipelineOp, OpOperand &use)
+{
+    const unsigned beginIx = pipelineOp.inputs().getBeginOperandIndex();
+    if (use.getOperandNumber() < beginIx || use.getOperandNumber() >= beginIx + pipelineOp.inputs().size())
+        return false;
+    auto split = pipelineOp.splits()[use.getOperandNumber() - beginIx].template cast<daphne::VectorSplitAttr>();
+    return split.getValue() == daphne::VectorSplit::ROWS;
+}
+
+static bool isOnlySplitByRows(Value value, llvm::DenseSet<Value> &visited)
+{
+    // a value carried by a loop is reached again through the loop, whose other uses are checked already
+    if (!visited.insert(value).second)
+        return true;
+    for (OpOperand &use : value.getUses()) {
+        Operation *user = use.getOwner();
+        const unsigned ix = use.getOperandNumber();
+        bool onlySplitByRows = false;
+        // the pipelines that are not distributed read the values at the coordinator
+        if (auto pipelineOp = llvm::dyn_cast<daphne::VectorizedPipelineOp>(user))
+            onlySplitByRows = isDistributable(pipelineOp) && isSplitByRows(pipelineOp, use);
+        else if (auto pipelineOp = llvm::dyn_cast<daphne::DistributedPipelineOp>(user))
+            onlySplitByRows = isSplitByRows(pipelineOp, use);
+        // the value flows into the variables of a loop, whose uses count, too
+        else if (auto forOp = llvm::dyn_cast<scf::ForOp>(user)) {
+            const unsigned numControl = forOp.getNumControlOperands();
+            onlySplitByRows = ix >= numControl
+                    && isOnlySplitByRows(forOp.getRegionIterArgs()[ix - numControl], visited)
+                    && isOnlySplitByRows(forOp.getResult(ix - numControl), visited);
+        }
+        else if (auto whileOp = llvm::dyn_cast<scf::WhileOp>(user))
+            onlySplitByRows = isOnlySplitByRows(whileOp.before().getArgument(ix), visited);
+        else if (auto conditionOp = llvm::dyn_cast<scf::ConditionOp>(user)) {
+            auto whileOp = llvm::cast<scf::WhileOp>(conditionOp->getParentOp());
+            onlySplitByRows = ix > 0
+                    && isOnlySplitByRows(whileOp.after().getArgument(ix - 1), visited)
+                    && isOnlySplitByRows(whileOp.getResult(ix - 1), visited);
+        }
+        else if (auto yieldOp = llvm::dyn_cast<scf::YieldOp>(user)) {
+            Operation *parentOp = yieldOp->getParentOp();
+            if (auto forOp = llvm::dyn_cast<scf::ForOp>(parentOp))
+                onlySplitByRows = isOnlySplitByRows(forOp.getRegionIterArgs()[ix], visited)
+                        && isOnlySplitByRows(forOp.getResult(ix), visited);
+            else if (auto whileOp = llvm::dyn_cast<scf::WhileOp>(parentOp))
+                onlySplitByRows = isOnlySplitByRows(whileOp.before().getArgument(ix), visited);
+            else if (auto ifOp = llvm::dyn_cast<scf::IfOp>(parentOp))
+                onlySplitByRows = isOnlySplitByRows(ifOp.getResult(ix), visited);
+        }
+        if (!onlySplitByRows)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Whether the value is only an input of pipelines, which split it by rows, also in the following iterations
+ * of the loops carrying it.
+ */
+static bool isOnlySplitByRows(Value value)
+{
+    llvm::DenseSet<Value> visited;
+    return !value.use_empty() && isOnlySplitByRows(value, visited);
+}
+
+/**
+ * @brief Inserts a `DistributedWaitOp` for a result or input of the distributed pipeline before its uses by anything
+ * other than distributed pipelines (which run in program order after it) that may run after the pipeline, such that
+ * the coordinator waits for the pipeline only when it needs the data.
+ */
+static void insertWaits(Value value, daphne::DistributedPipelineOp pipelineOp)
+{
+    Block *pipelineBlock = pipelineOp->getBlock();
+    std::set<Operation *> waitsBefore;
+    auto insertWait = [&](Operation *before) {
+        if (!waitsBefore.insert(before).second)
+            return;
+        OpBuilder builder(before);
+        builder.create<daphne::DistributedWaitOp>(pipelineOp.getLoc(), value);
+    };
+    // whether a use precedes the pipeline in a loop body, i.e., runs after it in the next iteration
+    bool waitAtEnd = false;
+    for (Operation *user : value.getUsers()) {
+        if (llvm::isa<daphne::DistributedPipelineOp, daphne::DistributedWaitOp>(user))
+            continue;
+        if (Operation *container = user->getBlock()->findAncestorOpInBlock(*pipelineOp)) {
+            // the user is in the block of the pipeline or of an op containing it
+            if (container->isBeforeInBlock(user))
+                insertWait(user);
+            else if (container == pipelineOp.getOperation())
+                waitAtEnd = true;
+        }
+        else if (Operation *ancestor = pipelineBlock->findAncestorOpInBlock(*user)) {
+            // the user is nested in an op in the block of the pipeline
+            if (pipelineOp->isBeforeInBlock(ancestor))
+                insertWait(ancestor);
+            else
+                waitAtEnd = true;
+        }
+    }
+    if (waitAtEnd && !llvm::isa<FuncOp>(pipelineBlock->getParentOp()))
+        insertWait(pipelineBlock->getTerminator());
+}
+
 struct DistributePipelinesPass
     : public PassWrapper<DistributePipelinesPass, OperationPass<ModuleOp>>
 {
+    const DaphneUserConfig& userConfig;
+
+    explicit DistributePipelinesPass(const DaphneUserConfig& cfg) : userConfig(cfg) {}
+
     void runOnOperation() final;
 };
 
@@ -73,6 +227,30 @@ void DistributePipelinesPass::runOnOperation()
 {
     auto module = getOperation();
 
+    // The results of pipelines combined by rows, which are only inputs of later pipelines split by rows (also in the
+    // next iterations of a loop), stay at the workers instead of being collected, since all matrices are split alike.
+    // Only the final results and the (small) aggregates, e.g., of convergence checks, return to the coordinator. The
+    // coordinator restores lost partitions, shifts rows, and copies the tasks of stragglers by sending the values it
+    // holds, so the results are collected then.
+    const bool keepAtWorkers = userConfig.distributed_max_failures == 0 && !userConfig.distributed_load_balancing
+            && userConfig.distributed_speculation_factor <= 0;
+    if (keepAtWorkers)
+        module.walk([&](daphne::VectorizedPipelineOp pipelineOp) {
+            if (!isDistributable(pipelineOp))
+                return;
+            OpBuilder builder(pipelineOp);
+            std::vector<Attribute> resident;
+            bool anyResident = false;
+            for (auto it : llvm::zip(pipelineOp.outputs(), pipelineOp.combines())) {
+                const bool isResident = std::get<1>(it).cast<daphne::VectorCombineAttr>().getValue()
+                        == daphne::VectorCombine::ROWS && isOnlySplitByRows(std::get<0>(it));
+                resident.push_back(builder.getBoolAttr(isResident));
+                anyResident = anyResident || isResident;
+            }
+            if (anyResident)
+                pipelineOp->setAttr(daphne::ATTR_RESIDENT_OUTPUTS, builder.getArrayAttr(resident));
+        });
+
     OwningRewritePatternList patterns(&getContext());
 
     // convert other operations
@@ -83,18 +261,58 @@ void DistributePipelinesPass::runOnOperation()
     target.addDynamicallyLegalOp<daphne::VectorizedPipelineOp>([](daphne::VectorizedPipelineOp op)
     {
         // TODO Carefully decide if this pipeline shall be distributed, e.g.,
-        // based on physical input size. For now, all pipelines are distributed
-        // (false means this pipeline is illegal and must be rewritten).
-        return false;
+        // based on physical input size. For now, all pipelines on the data
+        // the workers support are distributed (false means this pipeline is
+        // illegal and must be rewritten).
+        return !isDistributable(op);
     });
 
     patterns.insert<DistributePipelines>(&getContext());
 
-    if (failed(applyFullConversion(module, target, std::move(patterns))))
+    if (failed(applyFullConversion(module, target, std::move(patterns)))) {
         signalPassFailure();
+        return;
+    }
+
+    // The workers read the partitions of dense matrices of doubles that are only split by rows among them from the
+    // file themselves, instead of the coordinator reading and sending them.
+    if (userConfig.distributed_read_at_workers)
+        module.walk([&](daphne::ReadOp readOp) {
+            auto matTy = readOp.res().getType().dyn_cast<daphne::MatrixType>();
+            if (!matTy || !matTy.getElementType().isF64()
+                    || matTy.getRepresentation() != daphne::MatrixRepresentation::Dense
+                    || !isOnlySplitByRows(readOp.res()))
+                return;
+            OpBuilder builder(readOp);
+            auto distributedReadOp = builder.create<daphne::DistributedReadOp>(readOp.getLoc(), matTy,
+                                                                                readOp.fileName());
+            readOp.res().replaceAllUsesWith(distributedReadOp.res());
+            readOp.erase();
+        });
+
+    // The joins and group-bys of frames are computed at the workers, if their inputs are large enough at run-time
+    // (see `distributed_relational_min_rows`). Those of sorted inputs are merged locally instead of shuffling them.
+    module.walk([&](Operation *op) {
+        if (llvm::isa<daphne::InnerJoinOp, daphne::SemiJoinOp, daphne::GroupOp>(op) && !op->hasAttr(daphne::ATTR_SORTED_KEYS))
+            op->setAttr(daphne::ATTR_DISTRIBUTED, UnitAttr::get(&getContext()));
+    });
+
+    // The coordinator runs the distributed pipelines in the background and waits for them only where other
+    // operations use their results or inputs (see `DistributedContext::submit`).
+    if (userConfig.distributed_async) {
+        std::vector<daphne::DistributedPipelineOp> pipelineOps;
+        module.walk([&](daphne::DistributedPipelineOp pipelineOp) { pipelineOps.push_back(pipelineOp); });
+        for (auto pipelineOp : pipelineOps) {
+            for (Value res : pipelineOp.outputs())
+                insertWaits(res, pipelineOp);
+            for (Value input : pipelineOp.inputs())
+                if (input.getType().isa<daphne::MatrixType, daphne::FrameType>())
+                    insertWaits(input, pipelineOp);
+        }
+    }
 }
 
-std::unique_ptr<Pass> daphne::createDistributePipelinesPass()
+std::unique_ptr<Pass> daphne::createDistributePipelinesPass(const DaphneUserConfig& cfg)
 {
-    return std::make_unique<DistributePipelinesPass>();
+    return std::make_unique<DistributePipelinesPass>(cfg);
 }
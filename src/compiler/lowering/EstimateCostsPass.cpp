@@ -0,0 +1,250 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compiler/CompilerUtils.h>
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Pass/Pass.h>
+
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Annotates each op on matrices with the estimated floating-point
+ * operations, bytes read, and bytes written of one execution (the attributes
+ * `ATTR_COST_*`), derived from the inferred shapes, value types,
+ * representations, and sparsities of its operands and results.
+ *
+ * The FLOPs are those of the arithmetic: `2 * nnz(lhs) * #cols(res)` for
+ * matrix multiplications (also batched ones), `nnz(A) * #cols(res)` for
+ * `syrk`, `2 * nnz(A)` for `gemv`, and one per non-zero of the first matrix
+ * operand for elementwise ops and aggregations. All other ops only move data. A
+ * vectorized pipeline sums up the FLOPs of its ops, but reads its inputs and
+ * writes its results only once. Ops with unknown shapes are not annotated.
+ *
+ * With `explain_cost`, the estimates are printed per DaphneDSL statement. The
+ * annotations are kept by the RewriteToCallKernelOpPass, such that the
+ * ProfileKernelsPass passes them to the KernelProfiler, which relates them to
+ * the measured time of the kernel calls (roofline analysis).
+ */
+struct EstimateCostsPass : public PassWrapper<EstimateCostsPass, FunctionPass> {
+    bool explain;
+
+    explicit EstimateCostsPass(bool explain) : explain(explain) {}
+
+    void runOnFunction() final;
+};
+
+namespace {
+    struct Cost {
+        double flops = 0;
+        double bytesRead = 0;
+        double bytesWritten = 0;
+    };
+
+    // the number of cells of a matrix, or of its non-zeros if it is sparse, or `std::nullopt` if unknown
+    std::optional<double> numNonZeros(Value v) {
+        auto matTy = v.getType().dyn_cast<daphne::MatrixType>();
+        if(!matTy || matTy.getNumRows() == -1 || matTy.getNumCols() == -1)
+            return std::nullopt;
+        const double numCells = static_cast<double>(matTy.getNumRows()) * matTy.getNumCols();
+        if(matTy.getRepresentation() == daphne::MatrixRepresentation::Sparse && matTy.getSparsity() >= 0)
+            return numCells * matTy.getSparsity();
+        return numCells;
+    }
+
+    std::optional<double> numCols(Value v) {
+        auto matTy = v.getType().dyn_cast<daphne::MatrixType>();
+        if(!matTy || matTy.getNumCols() == -1)
+            return std::nullopt;
+        return static_cast<double>(matTy.getNumCols());
+    }
+
+    bool isAggregation(Operation * op) {
+        return llvm::isa<
+                daphne::AllAggSumOp, daphne::AllAggMinOp, daphne::AllAggMaxOp, daphne::AllAggMeanOp,
+                daphne::AllAggVarOp, daphne::AllAggStddevOp,
+                daphne::RowAggSumOp, daphne::RowAggMinOp, daphne::RowAggMaxOp, daphne::RowAggIdxMinOp,
+                daphne::RowAggIdxMaxOp, daphne::RowAggMeanOp, daphne::RowAggVarOp, daphne::RowAggStddevOp,
+                daphne::ColAggSumOp, daphne::ColAggMinOp, daphne::ColAggMaxOp, daphne::ColAggIdxMinOp,
+                daphne::ColAggIdxMaxOp, daphne::ColAggMeanOp, daphne::ColAggVarOp, daphne::ColAggStddevOp,
+                daphne::CumAggSumOp, daphne::CumAggProdOp, daphne::CumAggMinOp, daphne::CumAggMaxOp
+        >(op);
+    }
+
+    // the FLOPs of one execution of an op, or `std::nullopt` if unknown
+    std::optional<double> estimateFlops(Operation * op) {
+        if(auto vpo = llvm::dyn_cast<daphne::VectorizedPipelineOp>(op)) {
+            double flops = 0;
+            for(Operation & inner : vpo.body().front()) {
+                auto innerFlops = estimateFlops(&inner);
+                if(!innerFlops)
+                    return std::nullopt;
+                flops += *innerFlops;
+            }
+            return flops;
+        }
+        if(llvm::isa<daphne::MatMulOp, daphne::BatchMatMulOp>(op)) {
+            auto nnzLhs = numNonZeros(op->getOperand(0));
+            auto n = numCols(op->getResult(0));
+            if(!nnzLhs || !n)
+                return std::nullopt;
+            double flops = 2 * *nnzLhs * *n;
+            // a sparse rhs saves the multiplications with its zeros, too
+            auto rhsTy = op->getOperand(1).getType().dyn_cast<daphne::MatrixType>();
+            if(rhsTy && rhsTy.getRepresentation() == daphne::MatrixRepresentation::Sparse && rhsTy.getSparsity() >= 0)
+                flops *= rhsTy.getSparsity();
+            return flops;
+        }
+        if(llvm::isa<daphne::SyrkOp>(op)) {
+            auto nnz = numNonZeros(op->getOperand(0));
+            auto n = numCols(op->getResult(0));
+            if(!nnz || !n)
+                return std::nullopt;
+            return *nnz * *n;
+        }
+        if(llvm::isa<daphne::GemvOp>(op)) {
+            auto nnz = numNonZeros(op->getOperand(0));
+            if(!nnz)
+                return std::nullopt;
+            return 2 * *nnz;
+        }
+        if(op->getName().stripDialect().startswith("ew") || isAggregation(op)) {
+            for(Value operand : op->getOperands())
+                if(operand.getType().isa<daphne::MatrixType>())
+                    return numNonZeros(operand);
+            return 0.0;
+        }
+        return 0.0;
+    }
+
+    // the cost of one execution of an op on matrices, or `std::nullopt` if unknown
+    std::optional<Cost> estimateCost(Operation * op) {
+        Cost cost;
+        auto flops = estimateFlops(op);
+        if(!flops)
+            return std::nullopt;
+        cost.flops = *flops;
+        for(Value operand : op->getOperands()) {
+            auto bytes = CompilerUtils::estimateBytes(operand);
+            if(!bytes)
+                return std::nullopt;
+            cost.bytesRead += *bytes;
+        }
+        for(Value res : op->getResults()) {
+            auto bytes = CompilerUtils::estimateBytes(res);
+            if(!bytes)
+                return std::nullopt;
+            cost.bytesWritten += *bytes;
+        }
+        return cost;
+    }
+
+    // whether an op computes on matrices, unlike control flow, function calls, and terminators
+    bool isMatrixOp(Operation * op) {
+        if((op->getNumRegions() && !llvm::isa<daphne::VectorizedPipelineOp>(op))
+                || op->hasTrait<OpTrait::IsTerminator>() || llvm::isa<daphne::GenericCallOp>(op))
+            return false;
+        auto isMatrix = [](Value v) { return v.getType().isa<daphne::MatrixType>(); };
+        return llvm::any_of(op->getOperands(), isMatrix) || llvm::any_of(op->getResults(), isMatrix);
+    }
+
+    // the estimates of the ops of a DaphneDSL statement
+    struct Statement {
+        std::string location;
+        std::vector<std::string> ops;
+        Cost cost;
+        size_t numUnknown = 0;
+    };
+
+    void printStatements(FuncOp func, const std::vector<Statement> & stmts) {
+        std::ostringstream os;
+        os << "Cost estimates of " << func.getName().str() << " (per execution of each statement):\n"
+                << std::setw(12) << "MFLOP" << std::setw(12) << "MB read" << std::setw(12) << "MB written"
+                << std::setw(10) << "FLOP/B" << "  ops @ location\n" << std::fixed;
+        Cost total;
+        for(const Statement & stmt : stmts) {
+            const double bytes = stmt.cost.bytesRead + stmt.cost.bytesWritten;
+            os << std::setprecision(3) << std::setw(12) << (stmt.cost.flops / 1e6)
+                    << std::setw(12) << (stmt.cost.bytesRead / 1e6) << std::setw(12) << (stmt.cost.bytesWritten / 1e6)
+                    << std::setw(10) << std::setprecision(2) << (bytes > 0 ? stmt.cost.flops / bytes : 0.0) << "  ";
+            for(size_t i = 0; i < stmt.ops.size(); i++)
+                os << (i ? ", " : "") << stmt.ops[i];
+            os << " @ " << stmt.location;
+            if(stmt.numUnknown)
+                os << " (" << stmt.numUnknown << " ops of unknown shape not included)";
+            os << "\n";
+            total.flops += stmt.cost.flops;
+            total.bytesRead += stmt.cost.bytesRead;
+            total.bytesWritten += stmt.cost.bytesWritten;
+        }
+        os << std::setprecision(3) << std::setw(12) << (total.flops / 1e6) << std::setw(12) << (total.bytesRead / 1e6)
+                << std::setw(12) << (total.bytesWritten / 1e6) << "            total\n";
+        std::cerr << os.str();
+    }
+}
+
+void EstimateCostsPass::runOnFunction() {
+    FuncOp func = getFunction();
+    OpBuilder builder(&getContext());
+
+    std::vector<Statement> stmts;
+    std::map<std::string, size_t> stmtIxs;
+    func->walk([&](Operation * op) {
+        if(!isMatrixOp(op) || llvm::isa<daphne::VectorizedPipelineOp>(op->getParentOp()))
+            return;
+        auto cost = estimateCost(op);
+        if(cost) {
+            op->setAttr(daphne::ATTR_COST_FLOPS, builder.getF64FloatAttr(cost->flops));
+            op->setAttr(daphne::ATTR_COST_BYTES_READ, builder.getF64FloatAttr(cost->bytesRead));
+            op->setAttr(daphne::ATTR_COST_BYTES_WRITTEN, builder.getF64FloatAttr(cost->bytesWritten));
+        }
+        if(!explain)
+            return;
+
+        const std::string location = CompilerUtils::getLocationString(op->getLoc());
+        auto it = stmtIxs.find(location);
+        if(it == stmtIxs.end()) {
+            it = stmtIxs.emplace(location, stmts.size()).first;
+            stmts.push_back({location, {}, {}, 0});
+        }
+        Statement & stmt = stmts[it->second];
+        stmt.ops.push_back(op->getName().stripDialect().str());
+        if(cost) {
+            stmt.cost.flops += cost->flops;
+            stmt.cost.bytesRead += cost->bytesRead;
+            stmt.cost.bytesWritten += cost->bytesWritten;
+        }
+        else
+            stmt.numUnknown++;
+    });
+
+    if(explain && !stmts.empty())
+        printStatements(func, stmts);
+}
+
+std::unique_ptr<Pass> daphne::createEstimateCostsPass(bool explain) {
+    return std::make_unique<EstimateCostsPass>(explain);
+}
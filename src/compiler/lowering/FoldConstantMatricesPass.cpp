@@ -0,0 +1,274 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/Support/DynamicLibrary.h>
+
+#include <exception>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+using namespace mlir;
+
+/**
+ * @brief Evaluates matrix expressions on compile-time constants at compile
+ * time, such that they are not evaluated in every execution (and every
+ * iteration of a loop) at run-time.
+ *
+ * An op is folded if all its operands are constant scalars or
+ * `MatrixConstantOp`s (e.g., matrix literals or the results of folded ops),
+ * its result is a dense matrix of a known shape of at most
+ * `DaphneUserConfig::constant_folding_max_bytes`, and the kernel of the op
+ * is instantiated for it. Supported are `fill`, `seq`, `rand` with a fixed
+ * seed, `diagMatrix`, `transpose`, and the element-wise unary and binary ops.
+ *
+ * The results are computed by the pre-compiled kernels, which the
+ * `DaphneIrExecutor` loads beforehand, looked up by the same names the
+ * lowering to kernel calls derives from the op and its types. This way, the
+ * folded results are exactly the ones of the run-time. Each result is
+ * embedded as a `MatrixConstantOp` of its exact shape and sparsity, which
+ * the inference afterwards propagates to the ops using it.
+ */
+struct FoldConstantMatricesPass : public PassWrapper<FoldConstantMatricesPass, FunctionPass> {
+    const DaphneUserConfig & userConfig;
+
+    explicit FoldConstantMatricesPass(const DaphneUserConfig & cfg) : userConfig(cfg) {}
+
+    void runOnFunction() final;
+};
+
+// the kernel of the given name in the loaded kernel libraries, or nullptr
+template<typename Fn>
+static Fn * lookupKernel(const std::string & name) {
+    return reinterpret_cast<Fn *>(llvm::sys::DynamicLibrary::SearchForAddressOfSymbol(name));
+}
+
+// the value of a constant scalar (also if it was cast to another scalar type) as the given type
+template<typename T>
+static std::optional<T> constantScalar(Value v) {
+    if(auto castOp = v.getDefiningOp<daphne::CastOp>())
+        if(!castOp.arg().getType().isa<daphne::MatrixType, daphne::FrameType>())
+            v = castOp.arg();
+    auto co = v.getDefiningOp<daphne::ConstantOp>();
+    if(!co)
+        return std::nullopt;
+    if(auto floatAttr = co.value().dyn_cast<FloatAttr>())
+        return static_cast<T>(floatAttr.getValueAsDouble());
+    if(auto intAttr = co.value().dyn_cast<IntegerAttr>()) {
+        Type t = intAttr.getType();
+        if(t.isSignlessInteger(1))
+            return static_cast<T>(intAttr.getValue().getBoolValue());
+        if(t.isUnsignedInteger() || t.isIndex())
+            return static_cast<T>(intAttr.getValue().getZExtValue());
+        return static_cast<T>(intAttr.getValue().getSExtValue());
+    }
+    return std::nullopt;
+}
+
+// the data object of a MatrixConstantOp, or nullptr
+static const Structure * constantObject(Value v) {
+    auto mco = v.getDefiningOp<daphne::MatrixConstantOp>();
+    if(!mco)
+        return nullptr;
+    auto addr = constantScalar<uint64_t>(mco.matrixAddr());
+    return addr ? reinterpret_cast<const Structure *>(*addr) : nullptr;
+}
+
+template<typename VT>
+static const DenseMatrix<VT> * constantMatrix(Value v) {
+    return dynamic_cast<const DenseMatrix<VT> *>(constantObject(v));
+}
+
+/**
+ * @brief Calls the kernel of the given op on its constant operands, returning
+ * its result, or nullptr if the operands are not constant or there is no
+ * such kernel.
+ */
+template<typename VT>
+static DenseMatrix<VT> * evaluate(Operation * op, const std::string & vtName) {
+    using DT = DenseMatrix<VT>;
+    // the kernel names, see RewriteToCallKernelOpPass and genKernelInst.py
+    const std::string mat = "__DenseMatrix_" + vtName;
+    const std::string sca = "__" + vtName;
+    const std::string prefix = "_" + op->getName().stripDialect().str() + mat;
+
+    DT * res = nullptr;
+    if(auto fillOp = dyn_cast<daphne::FillOp>(op)) {
+        auto arg = constantScalar<VT>(fillOp.arg());
+        auto numRows = constantScalar<size_t>(fillOp.numRows());
+        auto numCols = constantScalar<size_t>(fillOp.numCols());
+        auto kernel = lookupKernel<void(DT **, VT, size_t, size_t, DaphneContext *)>(
+                prefix + sca + "__size_t__size_t");
+        if(arg && numRows && numCols && kernel)
+            kernel(&res, *arg, *numRows, *numCols, nullptr);
+    }
+    else if(auto seqOp = dyn_cast<daphne::SeqOp>(op)) {
+        auto from = constantScalar<VT>(seqOp.from());
+        auto to = constantScalar<VT>(seqOp.to());
+        auto inc = constantScalar<VT>(seqOp.inc());
+        auto kernel = lookupKernel<void(DT **, VT, VT, VT, DaphneContext *)>(prefix + sca + sca + sca);
+        if(from && to && inc && kernel)
+            kernel(&res, *from, *to, *inc, nullptr);
+    }
+    else if(auto randOp = dyn_cast<daphne::RandMatrixOp>(op)) {
+        auto numRows = constantScalar<size_t>(randOp.numRows());
+        auto numCols = constantScalar<size_t>(randOp.numCols());
+        auto min = constantScalar<VT>(randOp.min());
+        auto max = constantScalar<VT>(randOp.max());
+        auto sparsity = constantScalar<double>(randOp.sparsity());
+        auto seed = constantScalar<int64_t>(randOp.seed());
+        auto kernel = lookupKernel<void(DT **, size_t, size_t, VT, VT, double, int64_t, DaphneContext *)>(
+                prefix + "__size_t__size_t" + sca + sca + "__double__int64_t");
+        // -1 draws a new seed in every execution
+        if(numRows && numCols && min && max && sparsity && seed && *seed != -1 && kernel)
+            kernel(&res, *numRows, *numCols, *min, *max, *sparsity, *seed, nullptr);
+    }
+    else if(isa<daphne::DiagMatrixOp, daphne::TransposeOp, daphne::EwAbsOp, daphne::EwSignOp, daphne::EwExpOp,
+            daphne::EwLnOp, daphne::EwSqrtOp, daphne::EwRoundOp, daphne::EwFloorOp, daphne::EwCeilOp>(op)) {
+        const DT * arg = constantMatrix<VT>(op->getOperand(0));
+        auto kernel = lookupKernel<void(DT **, const DT *, DaphneContext *)>(prefix + mat);
+        if(arg && kernel)
+            kernel(&res, arg, nullptr);
+    }
+    else if(isa<daphne::EwAddOp, daphne::EwSubOp, daphne::EwMulOp, daphne::EwDivOp, daphne::EwPowOp, daphne::EwLogOp,
+            daphne::EwMinOp, daphne::EwMaxOp, daphne::EwAndOp, daphne::EwOrOp, daphne::EwEqOp, daphne::EwNeqOp,
+            daphne::EwLtOp, daphne::EwLeOp, daphne::EwGtOp, daphne::EwGeOp>(op)) {
+        const DT * lhs = constantMatrix<VT>(op->getOperand(0));
+        if(!lhs)
+            return nullptr;
+        Value rhsVal = op->getOperand(1);
+        if(rhsVal.getType().isa<daphne::MatrixType>()) {
+            const DT * rhs = constantMatrix<VT>(rhsVal);
+            auto kernel = lookupKernel<void(DT **, const DT *, const DT *, DaphneContext *)>(prefix + mat + mat);
+            if(rhs && kernel)
+                kernel(&res, lhs, rhs, nullptr);
+        }
+        else {
+            auto rhs = constantScalar<VT>(rhsVal);
+            auto kernel = lookupKernel<void(DT **, const DT *, VT, DaphneContext *)>(prefix + mat + sca);
+            if(rhs && kernel)
+                kernel(&res, lhs, *rhs, nullptr);
+        }
+    }
+    return res;
+}
+
+template<typename VT>
+static size_t countNonZeros(const DenseMatrix<VT> * mat) {
+    const VT * values = mat->getValues();
+    size_t nnz = 0;
+    for(size_t r = 0; r < mat->getNumRows(); r++, values += mat->getRowSkip())
+        for(size_t c = 0; c < mat->getNumCols(); c++)
+            nnz += values[c] != VT(0);
+    return nnz;
+}
+
+void FoldConstantMatricesPass::runOnFunction() {
+    std::vector<Operation *> ops;
+    getFunction()->walk([&](Operation * op) {
+        if(op->getNumResults() == 1 && op->getNumRegions() == 0 && !isa<daphne::MatrixConstantOp>(op))
+            ops.push_back(op);
+    });
+
+    // the MatrixConstantOps created here, whose data objects are destroyed if they are folded further
+    std::set<Operation *> folded;
+    for(Operation * op : ops) {
+        auto resTy = op->getResult(0).getType().dyn_cast<daphne::MatrixType>();
+        if(!resTy || resTy.getNumRows() < 0 || resTy.getNumCols() < 0
+                || resTy.getRepresentation() != daphne::MatrixRepresentation::Dense)
+            continue;
+        Type et = resTy.getElementType();
+        if(!et.isF64() && !et.isF32() && !et.isSignedInteger(64))
+            continue;
+        const size_t numBytes = static_cast<size_t>(resTy.getNumRows()) * resTy.getNumCols()
+                * (et.getIntOrFloatBitWidth() / 8);
+        if(numBytes > userConfig.constant_folding_max_bytes)
+            continue;
+
+        Structure * res = nullptr;
+        size_t nnz = 0;
+        try {
+            if(et.isF64()) {
+                auto mat = evaluate<double>(op, "double");
+                res = mat;
+                nnz = mat ? countNonZeros(mat) : 0;
+            }
+            else if(et.isF32()) {
+                auto mat = evaluate<float>(op, "float");
+                res = mat;
+                nnz = mat ? countNonZeros(mat) : 0;
+            }
+            else {
+                auto mat = evaluate<int64_t>(op, "int64_t");
+                res = mat;
+                nnz = mat ? countNonZeros(mat) : 0;
+            }
+        }
+        catch(const std::exception &) {
+            // e.g., mismatching shapes, which are reported at run-time
+            continue;
+        }
+        if(!res)
+            continue;
+        const size_t numRows = res->getNumRows();
+        const size_t numCols = res->getNumCols();
+        const double sparsity = numRows * numCols ? static_cast<double>(nnz) / (numRows * numCols) : 0.0;
+
+        // The exact sparsity is kept unless the result is handed out of its block or passed to a function, whose
+        // types must match the ones of the block or function.
+        Type mcoTy = resTy.withShape(numRows, numCols).withSparsity(sparsity);
+        for(Operation * user : op->getUsers())
+            if(user->hasTrait<OpTrait::IsTerminator>() || isa<CallOp, daphne::GenericCallOp>(user))
+                mcoTy = resTy;
+
+        // The data object lives as long as the process, see MatrixConstant.h.
+        OpBuilder builder(op);
+        Location loc = op->getLoc();
+        Value addr = builder.create<daphne::ConstantOp>(loc, builder.getIntegerAttr(
+                builder.getIntegerType(64, false), reinterpret_cast<uint64_t>(res)));
+        auto mco = builder.create<daphne::MatrixConstantOp>(loc, mcoTy, addr);
+        folded.insert(mco);
+
+        std::vector<Value> operands(op->getOperands().begin(), op->getOperands().end());
+        op->getResult(0).replaceAllUsesWith(mco);
+        op->erase();
+        for(Value v : operands) {
+            Operation * def = v.getDefiningOp();
+            if(def && folded.count(def) && def->use_empty()) {
+                DataObjectFactory::destroy(constantObject(v));
+                folded.erase(def);
+                def->erase();
+            }
+        }
+    }
+}
+
+std::unique_ptr<Pass> daphne::createFoldConstantMatricesPass(const DaphneUserConfig & cfg) {
+    return std::make_unique<FoldConstantMatricesPass>(cfg);
+}
@@ -0,0 +1,501 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/SetVector.h>
+#include <llvm/ADT/SmallPtrSet.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cctype>
+
+using namespace mlir;
+
+/**
+ * @brief Replaces each tree of elementwise operations on dense matrices of
+ * the same floating-point value type, optionally consumed by a sum, min, or
+ * max aggregation, by a single `EwFusedOp`.
+ *
+ * The `ewFused` kernel evaluates the whole tree in one pass over its
+ * arguments, block by block, such that the intermediate results are never
+ * materialized (see `EwFused.h` for the program format). It interprets the
+ * tree per block as a kernel-level fallback for fusion, no code is generated. The inner
+ * operations of a tree must have a single use, and their scalar operands must
+ * be constants, which are embedded into the program. This works inside the
+ * bodies of vectorized pipelines as well, where each task then calls one
+ * kernel instead of one per operation.
+ */
+struct FuseEwiseOpsPass : public PassWrapper<FuseEwiseOpsPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+/**
+ * @brief Replaces each tree of elementwise operations on column vectors that
+ * reads columns of frames, such as a predicate of a WHERE clause or an
+ * expression of a SELECT clause of a SQL query, by a single `EwFusedOp` on the
+ * frames of these columns.
+ *
+ * The SQL frontend generates a separate elementwise operation for each
+ * operator of an expression, as well as casts of the frame columns to
+ * matrices, of the operands of `AND`/`OR` to integers (through a frame), and
+ * of the operands of each operation to its result type. The `ewFused` kernel
+ * instead converts the columns block by block and evaluates the whole tree in
+ * one pass, short-circuiting `AND`/`OR` where a block is decided by the left
+ * operand, such that only the final selection or output column is
+ * materialized.
+ *
+ * A tree is evaluated on 64-bit integers if all of its operations are, or on
+ * doubles otherwise, in which case its integer operations must be
+ * comparisons or logical operations, whose results are the same on doubles.
+ * Like `FuseEwiseOpsPass`, but on the typed IR after `AdaptTypesToKernelsPass`.
+ */
+struct FuseSqlExprsPass : public PassWrapper<FuseSqlExprsPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+static bool isEwiseOp(Operation * op) {
+    return llvm::isa<
+            daphne::EwAddOp, daphne::EwSubOp, daphne::EwMulOp, daphne::EwDivOp, daphne::EwPowOp,
+            daphne::EwModOp, daphne::EwLogOp, daphne::EwMinOp, daphne::EwMaxOp,
+            daphne::EwEqOp, daphne::EwNeqOp, daphne::EwLtOp, daphne::EwLeOp, daphne::EwGtOp, daphne::EwGeOp,
+            daphne::EwAndOp, daphne::EwOrOp,
+            daphne::EwSqrtOp, daphne::EwExpOp, daphne::EwLnOp, daphne::EwAbsOp, daphne::EwSignOp,
+            daphne::EwFloorOp, daphne::EwCeilOp, daphne::EwRoundOp
+    >(op);
+}
+
+static bool isAggOp(Operation * op) {
+    return llvm::isa<
+            daphne::AllAggSumOp, daphne::AllAggMinOp, daphne::AllAggMaxOp,
+            daphne::RowAggSumOp, daphne::RowAggMinOp, daphne::RowAggMaxOp,
+            daphne::ColAggSumOp, daphne::ColAggMinOp, daphne::ColAggMaxOp
+    >(op);
+}
+
+// the name of the op in the program, e.g., "add" for "daphne.ewAdd" and
+// "sumRow" for "daphne.sumRow"
+static std::string programName(Operation * op) {
+    std::string name = op->getName().stripDialect().str();
+    if(isEwiseOp(op)) {
+        name = name.substr(2);
+        name[0] = static_cast<char>(std::tolower(name[0]));
+    }
+    return name;
+}
+
+static bool isDenseMatrixOf(Value v, Type vt) {
+    auto matTy = v.getType().dyn_cast<daphne::MatrixType>();
+    return matTy && matTy.getElementType() == vt
+            && matTy.getRepresentation() != daphne::MatrixRepresentation::Sparse;
+}
+
+// the value of a constant scalar, also if it was cast to the value type or is
+// an input of the vectorized pipeline whose body uses it
+static std::optional<double> constantScalar(Value v) {
+    if(auto blockArg = v.dyn_cast<BlockArgument>())
+        if(auto pipeline = llvm::dyn_cast_or_null<daphne::VectorizedPipelineOp>(blockArg.getOwner()->getParentOp()))
+            v = pipeline.inputs()[blockArg.getArgNumber()];
+    if(auto castOp = v.getDefiningOp<daphne::CastOp>())
+        if(!castOp.arg().getType().isa<daphne::MatrixType, daphne::FrameType>())
+            v = castOp.arg();
+    auto constantOp = v.getDefiningOp<daphne::ConstantOp>();
+    if(!constantOp)
+        return std::nullopt;
+    Attribute attr = constantOp.value();
+    if(auto floatAttr = attr.dyn_cast<FloatAttr>())
+        return floatAttr.getValueAsDouble();
+    if(auto intAttr = attr.dyn_cast<IntegerAttr>()) {
+        Type t = intAttr.getType();
+        if(t.isSignlessInteger(1))
+            return intAttr.getValue().getBoolValue() ? 1.0 : 0.0;
+        if(t.isUnsignedInteger())
+            return static_cast<double>(intAttr.getValue().getZExtValue());
+        return static_cast<double>(intAttr.getValue().getSExtValue());
+    }
+    return std::nullopt;
+}
+
+static std::string constantOperand(double value) {
+    std::ostringstream os;
+    os.precision(std::numeric_limits<double>::max_digits10);
+    os << 'c' << value;
+    return os.str();
+}
+
+static Type valueTypeOf(Type t) {
+    if(auto matTy = t.dyn_cast<daphne::MatrixType>())
+        return matTy.getElementType();
+    return t;
+}
+
+// whether the op can be evaluated by the kernel on the given value type
+static bool isFusible(Operation * op, Type vt) {
+    if(!isEwiseOp(op) || !isDenseMatrixOf(op->getResult(0), vt))
+        return false;
+    return llvm::all_of(op->getOperands(), [&](Value v) {
+        return isDenseMatrixOf(v, vt) || constantScalar(v).has_value();
+    });
+}
+
+// the value type of the matrices the op can be fused on, if any
+static Type fusedValueType(Operation * op) {
+    if(!op || !isEwiseOp(op))
+        return nullptr;
+    auto matTy = op->getResult(0).getType().dyn_cast<daphne::MatrixType>();
+    if(!matTy || !(matTy.getElementType().isF64() || matTy.getElementType().isF32()))
+        return nullptr;
+    return isFusible(op, matTy.getElementType()) ? matTy.getElementType() : nullptr;
+}
+
+// whether the result of the op is consumed by the tree of its only user
+static bool isInnerOp(Operation * op) {
+    Value res = op->getResult(0);
+    if(!res.hasOneUse())
+        return false;
+    Operation * user = *res.getUsers().begin();
+    if(user->getBlock() != op->getBlock())
+        return false;
+    Type vt = fusedValueType(op);
+    if(isAggOp(user))
+        return user->getOperand(0) == res;
+    return isFusible(user, vt);
+}
+
+/**
+ * @brief The program of a tree, built from its root in post order, such that
+ * each instruction only refers to the results of preceding instructions.
+ */
+struct FusedProgramBuilder {
+    Type vt;
+    std::vector<Value> args;
+    std::vector<Operation *> ops;
+    std::vector<std::string> instrs;
+
+    std::string operand(Value v, Operation * user) {
+        Operation * def = v.getDefiningOp();
+        if(def && def->getBlock() == user->getBlock() && v.hasOneUse() && fusedValueType(def) == vt)
+            return add(def);
+        if(auto value = constantScalar(v))
+            return constantOperand(*value);
+        auto it = std::find(args.begin(), args.end(), v);
+        if(it == args.end())
+            it = args.insert(args.end(), v);
+        return "a" + std::to_string(it - args.begin());
+    }
+
+    std::string add(Operation * op) {
+        std::string instr = programName(op);
+        for(Value v : op->getOperands())
+            instr += " " + operand(v, op);
+        ops.push_back(op);
+        instrs.push_back(instr);
+        return "r" + std::to_string(instrs.size() - 1);
+    }
+};
+
+void FuseEwiseOpsPass::runOnFunction() {
+    std::vector<Operation *> roots;
+    getFunction()->walk([&](Operation * op) {
+        if(isAggOp(op)) {
+            Operation * def = op->getOperand(0).getDefiningOp();
+            if(fusedValueType(def) && isInnerOp(def)
+                    && valueTypeOf(op->getResult(0).getType()) == fusedValueType(def))
+                roots.push_back(op);
+        }
+        else if(fusedValueType(op) && !isInnerOp(op))
+            roots.push_back(op);
+    });
+
+    for(Operation * root : roots) {
+        const bool isAgg = isAggOp(root);
+        Operation * treeRoot = isAgg ? root->getOperand(0).getDefiningOp() : root;
+        FusedProgramBuilder builder{fusedValueType(treeRoot)};
+        builder.add(treeRoot);
+        // a single elementwise op gains nothing
+        if(builder.ops.size() + isAgg < 2)
+            continue;
+
+        std::string program = isAgg ? programName(root) : "none";
+        for(const std::string & instr : builder.instrs)
+            program += ";" + instr;
+
+        OpBuilder b(root);
+        Location loc = root->getLoc();
+        Value programVal = b.create<daphne::ConstantOp>(
+                loc, daphne::StringType::get(&getContext()), b.getStringAttr(program)
+        );
+        Type resTy = root->getResult(0).getType();
+        // full aggregations yield a 1x1 matrix, which is cast to the scalar
+        const bool isScalar = !resTy.isa<daphne::MatrixType>();
+        Type fusedTy = isScalar
+                ? daphne::MatrixType::get(&getContext(), builder.vt).withShape(1, 1)
+                : resTy;
+        Value res = b.create<daphne::EwFusedOp>(loc, fusedTy, programVal, builder.args);
+        if(isScalar)
+            res = b.create<daphne::CastOp>(loc, resTy, res);
+
+        root->getResult(0).replaceAllUsesWith(res);
+        if(isAgg)
+            root->erase();
+        for(auto it = builder.ops.rbegin(); it != builder.ops.rend(); ++it)
+            (*it)->erase();
+    }
+}
+
+std::unique_ptr<Pass> daphne::createFuseEwiseOpsPass() {
+    return std::make_unique<FuseEwiseOpsPass>();
+}
+
+// ****************************************************************************
+// SQL expressions
+// ****************************************************************************
+
+// whether all values of the op's result are 0 or 1
+static bool isBooleanOp(Operation * op) {
+    return llvm::isa_and_nonnull<
+            daphne::EwEqOp, daphne::EwNeqOp, daphne::EwLtOp, daphne::EwLeOp, daphne::EwGtOp, daphne::EwGeOp,
+            daphne::EwAndOp, daphne::EwOrOp
+    >(op);
+}
+
+// whether casting values from one value type to another loses nothing (up
+// to the precision of doubles for large integers)
+static bool isWideningCast(Type from, Type to) {
+    if(from == to)
+        return true;
+    auto fromInt = from.dyn_cast<IntegerType>();
+    if(to.isF64())
+        return from.isF32() || (fromInt && fromInt.getWidth() > 1);
+    if(to.isSignedInteger(64))
+        return fromInt && fromInt.getWidth() > 1 && (fromInt.getWidth() < 64 || fromInt.isSigned());
+    return false;
+}
+
+static bool isColumnVector(Value v) {
+    auto matTy = v.getType().dyn_cast<daphne::MatrixType>();
+    return matTy && matTy.getNumCols() == 1 && matTy.getRepresentation() != daphne::MatrixRepresentation::Sparse;
+}
+
+// whether the op can be evaluated by the kernel on the value type vt, i.e.,
+// it computes on vt itself or it is a comparison or logical operation on
+// integers
+static bool isSqlFusible(Operation * op, Type vt) {
+    if(!op || !isEwiseOp(op) || !isColumnVector(op->getResult(0)))
+        return false;
+    Type opVt = valueTypeOf(op->getResult(0).getType());
+    if(!(opVt == vt || (vt.isF64() && opVt.isSignedInteger(64) && isBooleanOp(op))))
+        return false;
+    return llvm::all_of(op->getOperands(), [&](Value v) {
+        return (isColumnVector(v) && valueTypeOf(v.getType()) == opVt) || constantScalar(v).has_value();
+    });
+}
+
+/**
+ * @brief The program of a tree of SQL expressions on the value type `vt`,
+ * built from its root in post order. The arguments are single-column frames
+ * or column vectors, which are wrapped into frames.
+ */
+struct SqlProgramBuilder {
+    Type vt;
+    std::vector<Value> args;
+    std::vector<Operation *> ops;
+    std::vector<std::string> instrs;
+    // the casts, frames, and fills the tree reads through
+    llvm::SetVector<Operation *> through;
+    // the number of intermediate results that are not materialized any more
+    size_t numSaved = 0;
+    bool readsFrame = false;
+
+    std::string arg(Value v) {
+        auto it = std::find(args.begin(), args.end(), v);
+        if(it == args.end())
+            it = args.insert(args.end(), v);
+        return "a" + std::to_string(it - args.begin());
+    }
+
+    std::string operand(Value v, Operation * user) {
+        if(auto value = constantScalar(v))
+            return constantOperand(*value);
+
+        // the ops between the user and the value the tree reads
+        std::vector<Operation *> path;
+        while(auto castOp = v.getDefiningOp<daphne::CastOp>()) {
+            if(castOp->getBlock() != user->getBlock())
+                break;
+            Value src = castOp.arg();
+            Type resVt = valueTypeOf(castOp.getType());
+            if(src.getType().isa<daphne::MatrixType>() && isWideningCast(valueTypeOf(src.getType()), resVt)) {
+                // e.g., an integer column compared to a double
+                path.push_back(castOp);
+                numSaved++;
+                v = src;
+                continue;
+            }
+            auto frameTy = src.getType().dyn_cast<daphne::FrameType>();
+            if(!frameTy || frameTy.getColumnTypes().size() != 1)
+                break;
+            auto createFrameOp = src.getDefiningOp<daphne::CreateFrameOp>();
+            if(createFrameOp && createFrameOp->getBlock() == user->getBlock() && createFrameOp.cols().size() == 1
+                    && isBooleanOp(createFrameOp.cols()[0].getDefiningOp())
+                    && valueTypeOf(createFrameOp.cols()[0].getType()).isIntOrFloat()) {
+                // an operand of AND/OR cast to integers through a frame
+                path.push_back(castOp);
+                path.push_back(createFrameOp);
+                numSaved += 2;
+                v = createFrameOp.cols()[0];
+                continue;
+            }
+            Type colVt = frameTy.getColumnTypes()[0];
+            if(!isWideningCast(colVt, resVt))
+                break;
+            // a column of a frame, which is read in place
+            through.insert(castOp);
+            through.insert(path.begin(), path.end());
+            numSaved += colVt != resVt;
+            readsFrame = true;
+            return arg(src);
+        }
+        through.insert(path.begin(), path.end());
+
+        Operation * def = v.getDefiningOp();
+        if(auto fillOp = llvm::dyn_cast_or_null<daphne::FillOp>(def))
+            if(auto value = constantScalar(fillOp.arg())) {
+                through.insert(fillOp);
+                numSaved++;
+                return constantOperand(*value);
+            }
+        const bool singleUse = v.hasOneUse() && llvm::all_of(path, [](Operation * op) {
+            return op->getResult(0).hasOneUse();
+        });
+        if(def && def->getBlock() == user->getBlock() && singleUse && isSqlFusible(def, vt)) {
+            numSaved++;
+            return add(def);
+        }
+        return arg(v);
+    }
+
+    std::string add(Operation * op) {
+        std::string instr = programName(op);
+        for(Value v : op->getOperands())
+            instr += " " + operand(v, op);
+        ops.push_back(op);
+        instrs.push_back(instr);
+        return "r" + std::to_string(instrs.size() - 1);
+    }
+};
+
+// the program of the tree rooted at the op, on doubles if it contains any
+// operation on doubles, and otherwise on the value type of the op
+static std::optional<SqlProgramBuilder> buildSqlProgram(Operation * root) {
+    auto matTy = root->getResult(0).getType().dyn_cast<daphne::MatrixType>();
+    if(!matTy)
+        return std::nullopt;
+    Type vt = matTy.getElementType();
+    if(!(vt.isF64() || vt.isSignedInteger(64)) || !isSqlFusible(root, vt))
+        return std::nullopt;
+    Type f64 = OpBuilder(root->getContext()).getF64Type();
+    if(!vt.isF64() && isSqlFusible(root, f64)) {
+        SqlProgramBuilder builder{f64};
+        builder.add(root);
+        if(llvm::any_of(builder.ops, [](Operation * op) { return valueTypeOf(op->getResult(0).getType()).isF64(); }))
+            return builder;
+    }
+    SqlProgramBuilder builder{vt};
+    builder.add(root);
+    return builder;
+}
+
+void FuseSqlExprsPass::runOnFunction() {
+    // The roots are visited before the inner ops of their trees.
+    std::vector<Operation *> candidates;
+    getFunction()->walk([&](Operation * op) {
+        if(isEwiseOp(op))
+            candidates.push_back(op);
+    });
+    llvm::SmallPtrSet<Operation *, 32> fused;
+
+    for(auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+        Operation * root = *it;
+        if(fused.count(root))
+            continue;
+        std::optional<SqlProgramBuilder> builder = buildSqlProgram(root);
+        // the kernel needs at least one column, and a single operation on
+        // columns read in place gains nothing
+        if(!builder || !builder->readsFrame || builder->numSaved < 2)
+            continue;
+        fused.insert(builder->ops.begin(), builder->ops.end());
+
+        std::string program = "none";
+        for(const std::string & instr : builder->instrs)
+            program += ";" + instr;
+
+        OpBuilder b(root);
+        Location loc = root->getLoc();
+        Type strTy = daphne::StringType::get(&getContext());
+        Value programVal = b.create<daphne::ConstantOp>(loc, strTy, b.getStringAttr(program));
+        std::vector<Value> args;
+        for(Value arg : builder->args) {
+            if(auto matTy = arg.getType().dyn_cast<daphne::MatrixType>()) {
+                Type frameTy = daphne::FrameType::get(&getContext(), {matTy.getElementType()});
+                Value label = b.create<daphne::ConstantOp>(loc, strTy, b.getStringAttr("col"));
+                arg = b.create<daphne::CreateFrameOp>(loc, frameTy, std::vector<Value>{arg}, std::vector<Value>{label});
+            }
+            args.push_back(arg);
+        }
+        Value rootRes = root->getResult(0);
+        auto resTy = rootRes.getType().cast<daphne::MatrixType>();
+        Value res = b.create<daphne::EwFusedOp>(loc, resTy.withElementType(builder->vt), programVal, args);
+        // A selection on doubles is used as it is, any other use gets the
+        // original value type.
+        const bool onlySelects = llvm::all_of(rootRes.getUsers(), [&](Operation * user) {
+            if(auto filterRowOp = llvm::dyn_cast<daphne::FilterRowOp>(user))
+                return filterRowOp.selectedRows() == rootRes && filterRowOp.source().getType().isa<daphne::FrameType>();
+            if(auto filterGroupOp = llvm::dyn_cast<daphne::FilterGroupOp>(user))
+                return filterGroupOp.selectedRows() == rootRes;
+            return false;
+        });
+        if(builder->vt != resTy.getElementType() && !onlySelects)
+            res = b.create<daphne::CastOp>(loc, resTy, res);
+        rootRes.replaceAllUsesWith(res);
+
+        // The fused ops and the casts and frames only they used are dead now.
+        std::vector<Operation *> dead(builder->ops.begin(), builder->ops.end());
+        dead.insert(dead.end(), builder->through.begin(), builder->through.end());
+        for(bool erased = true; erased;) {
+            erased = false;
+            for(Operation *& op : dead)
+                if(op && op->use_empty()) {
+                    op->erase();
+                    op = nullptr;
+                    erased = true;
+                }
+        }
+    }
+}
+
+std::unique_ptr<Pass> daphne::createFuseSqlExprsPass() {
+    return std::make_unique<FuseSqlExprsPass>();
+}
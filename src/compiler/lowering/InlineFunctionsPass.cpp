@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/IR/BlockAndValueMapping.h>
+#include <mlir/Pass/Pass.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Inlines the calls of small DaphneDSL functions, and of functions
+ * called only once, into their callers.
+ *
+ * A call is opaque to the passes on the caller: the arguments get reference
+ * counted, the properties of the results are only those the callee infers for
+ * any call, and no vectorized pipeline spans the call. Inlining the body
+ * instead lets the properties of the actual arguments flow through it and the
+ * ops of the callee fuse with the ops around the call.
+ *
+ * Only functions consisting of a single block without calls are inlined, i.e.,
+ * the call graph is inlined bottom-up over several rounds, and recursive
+ * functions are never inlined. A function is inlined at all of its call sites
+ * or none, such that the inlined functions can be removed afterwards. The pass
+ * runs after the SpecializeGenericFunctionsPass, when all callees are typed.
+ */
+struct InlineFunctionsPass : public PassWrapper<InlineFunctionsPass, OperationPass<ModuleOp>> {
+    // the number of ops up to which a function is inlined at any number of call sites
+    static constexpr size_t MAX_INLINED_OPS = 64;
+
+    void runOnOperation() final;
+};
+
+namespace {
+    bool isInlinable(FuncOp func) {
+        if(!llvm::hasSingleElement(func.getBody())
+                || !llvm::isa<daphne::ReturnOp>(func.getBody().front().getTerminator()))
+            return false;
+        bool inlinable = true;
+        func.getBody().walk([&](Operation * op) {
+            if(llvm::isa<daphne::GenericCallOp, daphne::AdaptiveCallOp>(op)
+                    || (llvm::isa<daphne::ReturnOp>(op) && op->getParentOp() != func.getOperation()))
+                inlinable = false;
+        });
+        return inlinable;
+    }
+
+    size_t countOps(FuncOp func) {
+        size_t res = 0;
+        func.getBody().walk([&](Operation *) { res++; });
+        return res;
+    }
+
+    void inlineCall(daphne::GenericCallOp call, FuncOp callee) {
+        OpBuilder builder(call);
+        Block & body = callee.getBody().front();
+        BlockAndValueMapping mapping;
+        for(auto it : llvm::zip(body.getArguments(), call->getOperands()))
+            mapping.map(std::get<0>(it), std::get<1>(it));
+        for(Operation & op : body.without_terminator())
+            builder.clone(op, mapping);
+        // the types of the results of the call are those of the function (see SpecializeGenericFunctionsPass)
+        for(auto it : llvm::zip(call->getResults(), body.getTerminator()->getOperands()))
+            std::get<0>(it).replaceAllUsesWith(mapping.lookupOrDefault(std::get<1>(it)));
+        call.erase();
+    }
+}
+
+void InlineFunctionsPass::runOnOperation() {
+    ModuleOp module = getOperation();
+    std::map<std::string, FuncOp> functions;
+    module.walk([&](FuncOp func) { functions.emplace(func.sym_name().str(), func); });
+
+    std::set<std::string> inlined;
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        std::map<std::string, std::vector<daphne::GenericCallOp>> callSites;
+        module.walk([&](daphne::GenericCallOp call) { callSites[call.callee().str()].push_back(call); });
+        for(auto & [name, calls] : callSites) {
+            auto it = functions.find(name);
+            if(it == functions.end() || !isInlinable(it->second)
+                    || (calls.size() > 1 && countOps(it->second) > MAX_INLINED_OPS))
+                continue;
+            for(daphne::GenericCallOp call : calls)
+                inlineCall(call, it->second);
+            inlined.insert(name);
+            changed = true;
+        }
+    }
+
+    // all call sites of the inlined functions are gone
+    for(const std::string & name : inlined)
+        functions.at(name).erase();
+}
+
+std::unique_ptr<Pass> daphne::createInlineFunctionsPass() {
+    return std::make_unique<InlineFunctionsPass>();
+}
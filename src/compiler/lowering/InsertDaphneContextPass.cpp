@@ -48,12 +48,14 @@ void InsertDaphneContextPass::runOnFunction()
     Location loc = builder.getUnknownLoc();
 
     // Insert a CreateDaphneContextOp as the first operation in the block.
+    auto configPtr = builder.create<daphne::ConstantOp>(
+            loc, reinterpret_cast<uint64_t>(&user_config)
+    );
+    configPtr->setAttr(daphne::ATTR_USERCONFIG, builder.getUnitAttr());
     builder.create<daphne::CreateDaphneContextOp>(
             loc,
             daphne::DaphneContextType::get(&getContext()),
-            builder.create<daphne::ConstantOp>(
-                    loc, reinterpret_cast<uint64_t>(&user_config)
-            )
+            configPtr
     );
 #ifdef USE_CUDA
     if(user_config.use_cuda) {
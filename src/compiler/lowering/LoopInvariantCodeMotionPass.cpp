@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compiler/CompilerUtils.h"
+#include "ir/daphneir/Daphne.h"
+#include "ir/daphneir/Passes.h"
+
+#include "mlir/Dialect/SCF/SCF.h"
+
+#include <functional>
+#include <memory>
+
+using namespace mlir;
+
+/**
+ * @brief This is a limited variant of loop invariant code motion (LICM),
+ * tailored to the WhileOp and ForOp and to the DAPHNE operations, which
+ * mostly do not declare their (lack of) side effects.
+ * 
+ * We need this because MLIR does not seem to support LICM for while loops.
+ * Nevertheless, we should clarify this (see #175).
+ * 
+ * Side-effect-free operations (see `CompilerUtils::isSideEffectFree`) whose
+ * operands are all defined outside of the loop are moved before it, also
+ * from the branches of the IfOps in its body, such that loop-invariant
+ * expressions like `t(X) @ X` or `colMeans(X)` in an iterative algorithm are
+ * computed once. Inner loops are processed first, such that their invariants
+ * can move further out.
+ * 
+ * This pass must run before the `ManageObjRefsPass`, which then inserts the
+ * reference counting for the moved values just like for any other values.
+ * Functions that already contain reference counting operations are left
+ * alone, since their decrements inside a loop would free a moved value.
+ * 
+ * This pass is strongly inspired by MLIR's LoopInvariantCodeMotion.cpp, but
+ * significantly simplified.
+ */
+struct LoopInvariantCodeMotionPass
+: public PassWrapper <LoopInvariantCodeMotionPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+static void moveLoopInvariants(Operation * loopOp) {
+    SmallPtrSet<Operation *, 8> willBeMovedSet;
+    SmallVector<Operation *, 8> opsToMove;
+
+    auto isDefinedOutsideOfLoop = [&](Value value) {
+        auto definingOp = value.getDefiningOp();
+        return (definingOp && !!willBeMovedSet.count(definingOp)) ||
+                !loopOp->isAncestor(value.getParentBlock()->getParentOp());
+    };
+
+    // collects the invariants of the blocks of the region and of the
+    // branches of the IfOps in them, in the order of their execution
+    std::function<void(Region &)> collect = [&](Region & region) {
+        for(auto & block : region)
+            for(auto & op : block.without_terminator()) {
+                if(auto ifOp = llvm::dyn_cast<scf::IfOp>(op)) {
+                    collect(ifOp.thenRegion());
+                    collect(ifOp.elseRegion());
+                }
+                else if(
+                    CompilerUtils::isSideEffectFree(&op) &&
+                    llvm::all_of(op.getOperands(), isDefinedOutsideOfLoop)
+                ) {
+                    opsToMove.push_back(&op);
+                    willBeMovedSet.insert(&op);
+                }
+            }
+    };
+    for(auto & region : loopOp->getRegions())
+        collect(region);
+
+    for(auto op : opsToMove)
+        op->moveBefore(loopOp);
+}
+
+void LoopInvariantCodeMotionPass::runOnFunction() {
+    auto hasObjRefs = getFunction()->walk([](Operation * op) {
+        if(llvm::isa<daphne::IncRefOp, daphne::DecRefOp>(op))
+            return WalkResult::interrupt();
+        return WalkResult::advance();
+    }).wasInterrupted();
+    if(hasObjRefs)
+        return;
+
+    // the walk is post-order, i.e., visits inner loops first
+    SmallVector<Operation *, 8> loopOps;
+    getFunction()->walk([&](Operation * op) {
+        if(llvm::isa<scf::WhileOp, scf::ForOp>(op))
+            loopOps.push_back(op);
+    });
+    for(auto loopOp : loopOps)
+        moveLoopInvariants(loopOp);
+}
+
+std::unique_ptr<Pass> daphne::createLoopInvariantCodeMotionPass() {
+    return std::make_unique<LoopInvariantCodeMotionPass>();
+}
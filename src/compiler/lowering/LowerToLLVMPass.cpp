@@ -34,10 +34,58 @@ using namespace mlir;
 // be combined into a single variadic result.
 const std::string ATTR_HASVARIADICRESULTS = "hasVariadicResults";
 
-#if 0
-// At the moment, all of these operations are lowered to kernel calls.
-template <typename BinaryOp, typename ReplIOp, typename ReplFOp>
-struct BinaryOpLowering : public OpConversionPattern<BinaryOp>
+// ****************************************************************************
+// Scalar operations
+// ****************************************************************************
+
+// The scalar arithmetic operations, comparisons, and casts of
+// CompilerUtils::isInlinedScalarOp are lowered to LLVM IR directly instead of
+// calls of kernels, such that LLVM optimizes them along with the surrounding
+// control flow (e.g., loop counters and convergence checks). They compute what
+// the kernels compute in C++, e.g., a comparison yields 0 or 1 of the result
+// type.
+
+namespace {
+    // the LLVM types are signless, so the signedness is taken from the DaphneIR type
+    bool isUnsignedInt(Type t) {
+        auto intType = t.dyn_cast<IntegerType>();
+        return intType && intType.isUnsigned();
+    }
+
+    // a boolean as 0 or 1 of the given LLVM type
+    Value fromBool(OpBuilder & builder, Location loc, Value v, Type llvmType) {
+        if(llvmType.isa<FloatType>())
+            return builder.create<LLVM::UIToFPOp>(loc, llvmType, v);
+        if(llvmType.getIntOrFloatBitWidth() == 1)
+            return v;
+        return builder.create<LLVM::ZExtOp>(loc, llvmType, v);
+    }
+
+    // whether a value is not zero, i.e., its conversion to a boolean
+    Value toBool(OpBuilder & builder, Location loc, Value v) {
+        Type t = v.getType();
+        if(t.isa<FloatType>()) {
+            auto zero = builder.create<LLVM::ConstantOp>(loc, t, builder.getFloatAttr(t, 0));
+            return builder.create<LLVM::FCmpOp>(loc, LLVM::FCmpPredicate::une, v, zero);
+        }
+        if(t.getIntOrFloatBitWidth() == 1)
+            return v;
+        auto zero = builder.create<LLVM::ConstantOp>(loc, t, builder.getIntegerAttr(t, 0));
+        return builder.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::ne, v, zero);
+    }
+
+    // `lhs < rhs` of values of the given DaphneIR type
+    Value lessThan(OpBuilder & builder, Location loc, Type type, Value lhs, Value rhs) {
+        if(type.isa<FloatType>())
+            return builder.create<LLVM::FCmpOp>(loc, LLVM::FCmpPredicate::olt, lhs, rhs);
+        return builder.create<LLVM::ICmpOp>(
+                loc, isUnsignedInt(type) ? LLVM::ICmpPredicate::ult : LLVM::ICmpPredicate::slt, lhs, rhs
+        );
+    }
+}
+
+template<class BinaryOp, class SIntOp, class UIntOp, class FloatOp>
+struct ScalarBinaryOpLowering : public OpConversionPattern<BinaryOp>
 {
     using OpConversionPattern<BinaryOp>::OpConversionPattern;
 
@@ -45,23 +93,233 @@ struct BinaryOpLowering : public OpConversionPattern<BinaryOp>
     matchAndRewrite(BinaryOp op, ArrayRef<Value> operands,
                     ConversionPatternRewriter &rewriter) const override
     {
+        if(!CompilerUtils::isInlinedScalarOp(op))
+            return failure();
         Type type = op.getType();
-        if (type.isa<IntegerType>()) {
-            rewriter.replaceOpWithNewOp<ReplIOp>(op.getOperation(), operands);
-        }
-        else if (type.isa<FloatType>()) {
-            rewriter.replaceOpWithNewOp<ReplFOp>(op.getOperation(), operands);
+        Type llvmType = this->getTypeConverter()->convertType(type);
+        if(type.isa<FloatType>())
+            rewriter.replaceOpWithNewOp<FloatOp>(op, llvmType, operands[0], operands[1]);
+        else if(isUnsignedInt(type))
+            rewriter.replaceOpWithNewOp<UIntOp>(op, llvmType, operands[0], operands[1]);
+        else
+            rewriter.replaceOpWithNewOp<SIntOp>(op, llvmType, operands[0], operands[1]);
+        return success();
+    }
+};
+using EwAddOpLowering = ScalarBinaryOpLowering<daphne::EwAddOp, LLVM::AddOp, LLVM::AddOp, LLVM::FAddOp>;
+using EwSubOpLowering = ScalarBinaryOpLowering<daphne::EwSubOp, LLVM::SubOp, LLVM::SubOp, LLVM::FSubOp>;
+using EwMulOpLowering = ScalarBinaryOpLowering<daphne::EwMulOp, LLVM::MulOp, LLVM::MulOp, LLVM::FMulOp>;
+using EwDivOpLowering = ScalarBinaryOpLowering<daphne::EwDivOp, LLVM::SDivOp, LLVM::UDivOp, LLVM::FDivOp>;
+// the remainder takes the sign of the dividend, like std::fmod
+using EwModOpLowering = ScalarBinaryOpLowering<daphne::EwModOp, LLVM::SRemOp, LLVM::URemOp, LLVM::FRemOp>;
+// only inlined for floating-point numbers
+using EwPowOpLowering = ScalarBinaryOpLowering<daphne::EwPowOp, LLVM::PowOp, LLVM::PowOp, LLVM::PowOp>;
+
+// std::min and std::max, which return the first argument if the arguments are equivalent
+template<class MinMaxOp, bool isMin>
+struct ScalarMinMaxOpLowering : public OpConversionPattern<MinMaxOp>
+{
+    using OpConversionPattern<MinMaxOp>::OpConversionPattern;
+
+    LogicalResult
+    matchAndRewrite(MinMaxOp op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+        if(!CompilerUtils::isInlinedScalarOp(op))
+            return failure();
+        Value lhs = operands[0];
+        Value rhs = operands[1];
+        // min: rhs < lhs ? rhs : lhs, max: lhs < rhs ? rhs : lhs
+        Value takeRhs = isMin ? lessThan(rewriter, op.getLoc(), op.getType(), rhs, lhs)
+                : lessThan(rewriter, op.getLoc(), op.getType(), lhs, rhs);
+        rewriter.replaceOpWithNewOp<LLVM::SelectOp>(op, takeRhs, rhs, lhs);
+        return success();
+    }
+};
+using EwMinOpLowering = ScalarMinMaxOpLowering<daphne::EwMinOp, true>;
+using EwMaxOpLowering = ScalarMinMaxOpLowering<daphne::EwMaxOp, false>;
+
+template<class CmpOp, LLVM::ICmpPredicate sintPred, LLVM::ICmpPredicate uintPred, LLVM::FCmpPredicate floatPred>
+struct ScalarCmpOpLowering : public OpConversionPattern<CmpOp>
+{
+    using OpConversionPattern<CmpOp>::OpConversionPattern;
+
+    LogicalResult
+    matchAndRewrite(CmpOp op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+        if(!CompilerUtils::isInlinedScalarOp(op))
+            return failure();
+        Location loc = op.getLoc();
+        Type argType = op.lhs().getType();
+        Value cmp;
+        if(argType.isa<FloatType>())
+            cmp = rewriter.create<LLVM::FCmpOp>(loc, floatPred, operands[0], operands[1]);
+        else
+            cmp = rewriter.create<LLVM::ICmpOp>(loc, isUnsignedInt(argType) ? uintPred : sintPred,
+                    operands[0], operands[1]);
+        rewriter.replaceOp(op, fromBool(rewriter, loc, cmp, this->getTypeConverter()->convertType(op.getType())));
+        return success();
+    }
+};
+// NaN is unequal to every value, and any other comparison with NaN is false
+using EwEqOpLowering = ScalarCmpOpLowering<daphne::EwEqOp,
+        LLVM::ICmpPredicate::eq, LLVM::ICmpPredicate::eq, LLVM::FCmpPredicate::oeq>;
+using EwNeqOpLowering = ScalarCmpOpLowering<daphne::EwNeqOp,
+        LLVM::ICmpPredicate::ne, LLVM::ICmpPredicate::ne, LLVM::FCmpPredicate::une>;
+using EwLtOpLowering = ScalarCmpOpLowering<daphne::EwLtOp,
+        LLVM::ICmpPredicate::slt, LLVM::ICmpPredicate::ult, LLVM::FCmpPredicate::olt>;
+using EwLeOpLowering = ScalarCmpOpLowering<daphne::EwLeOp,
+        LLVM::ICmpPredicate::sle, LLVM::ICmpPredicate::ule, LLVM::FCmpPredicate::ole>;
+using EwGtOpLowering = ScalarCmpOpLowering<daphne::EwGtOp,
+        LLVM::ICmpPredicate::sgt, LLVM::ICmpPredicate::ugt, LLVM::FCmpPredicate::ogt>;
+using EwGeOpLowering = ScalarCmpOpLowering<daphne::EwGeOp,
+        LLVM::ICmpPredicate::sge, LLVM::ICmpPredicate::uge, LLVM::FCmpPredicate::oge>;
+
+template<class LogicalOp, class BoolOp>
+struct ScalarLogicalOpLowering : public OpConversionPattern<LogicalOp>
+{
+    using OpConversionPattern<LogicalOp>::OpConversionPattern;
+
+    LogicalResult
+    matchAndRewrite(LogicalOp op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+        if(!CompilerUtils::isInlinedScalarOp(op))
+            return failure();
+        Location loc = op.getLoc();
+        Value res = rewriter.create<BoolOp>(loc, rewriter.getI1Type(), toBool(rewriter, loc, operands[0]),
+                toBool(rewriter, loc, operands[1]));
+        rewriter.replaceOp(op, fromBool(rewriter, loc, res, this->getTypeConverter()->convertType(op.getType())));
+        return success();
+    }
+};
+using EwAndOpLowering = ScalarLogicalOpLowering<daphne::EwAndOp, LLVM::AndOp>;
+using EwOrOpLowering = ScalarLogicalOpLowering<daphne::EwOrOp, LLVM::OrOp>;
+
+struct EwMinusOpLowering : public OpConversionPattern<daphne::EwMinusOp>
+{
+    using OpConversionPattern::OpConversionPattern;
+
+    LogicalResult
+    matchAndRewrite(daphne::EwMinusOp op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+        if(!CompilerUtils::isInlinedScalarOp(op))
+            return failure();
+        Type llvmType = getTypeConverter()->convertType(op.getType());
+        if(llvmType.isa<FloatType>())
+            rewriter.replaceOpWithNewOp<LLVM::FNegOp>(op, llvmType, operands[0]);
+        else {
+            auto zero = rewriter.create<LLVM::ConstantOp>(op.getLoc(), llvmType, rewriter.getIntegerAttr(llvmType, 0));
+            rewriter.replaceOpWithNewOp<LLVM::SubOp>(op, llvmType, zero, operands[0]);
         }
+        return success();
+    }
+};
+
+struct EwAbsOpLowering : public OpConversionPattern<daphne::EwAbsOp>
+{
+    using OpConversionPattern::OpConversionPattern;
+
+    LogicalResult
+    matchAndRewrite(daphne::EwAbsOp op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+        if(!CompilerUtils::isInlinedScalarOp(op))
+            return failure();
+        Location loc = op.getLoc();
+        Type type = op.getType();
+        Type llvmType = getTypeConverter()->convertType(type);
+        if(type.isa<FloatType>())
+            rewriter.replaceOpWithNewOp<LLVM::FAbsOp>(op, llvmType, operands[0]);
+        else if(isUnsignedInt(type))
+            rewriter.replaceOp(op, operands[0]);
         else {
+            auto zero = rewriter.create<LLVM::ConstantOp>(loc, llvmType, rewriter.getIntegerAttr(llvmType, 0));
+            auto neg = rewriter.create<LLVM::SubOp>(loc, llvmType, zero, operands[0]);
+            rewriter.replaceOpWithNewOp<LLVM::SelectOp>(op, lessThan(rewriter, loc, type, operands[0], zero), neg,
+                    operands[0]);
+        }
+        return success();
+    }
+};
+
+// the unary operations on floating-point numbers with an LLVM intrinsic
+template<class UnaryOp, class IntrinsicOp>
+struct ScalarFloatUnaryOpLowering : public OpConversionPattern<UnaryOp>
+{
+    using OpConversionPattern<UnaryOp>::OpConversionPattern;
+
+    LogicalResult
+    matchAndRewrite(UnaryOp op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+        if(!CompilerUtils::isInlinedScalarOp(op))
+            return failure();
+        rewriter.replaceOpWithNewOp<IntrinsicOp>(op, this->getTypeConverter()->convertType(op.getType()), operands[0]);
+        return success();
+    }
+};
+using EwSqrtOpLowering = ScalarFloatUnaryOpLowering<daphne::EwSqrtOp, LLVM::SqrtOp>;
+using EwExpOpLowering = ScalarFloatUnaryOpLowering<daphne::EwExpOp, LLVM::ExpOp>;
+using EwLnOpLowering = ScalarFloatUnaryOpLowering<daphne::EwLnOp, LLVM::LogOp>;
+using EwFloorOpLowering = ScalarFloatUnaryOpLowering<daphne::EwFloorOp, LLVM::FFloorOp>;
+using EwCeilOpLowering = ScalarFloatUnaryOpLowering<daphne::EwCeilOp, LLVM::FCeilOp>;
+
+// a static_cast between numbers and booleans, see CastSca
+struct ScalarCastOpLowering : public OpConversionPattern<daphne::CastOp>
+{
+    using OpConversionPattern::OpConversionPattern;
+
+    LogicalResult
+    matchAndRewrite(daphne::CastOp op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+        if(!CompilerUtils::isInlinedScalarOp(op))
             return failure();
+        Location loc = op.getLoc();
+        Type argType = op.arg().getType();
+        Value arg = operands[0];
+        Type llvmArgType = arg.getType();
+        Type llvmResType = getTypeConverter()->convertType(op.getType());
+        const unsigned argWidth = llvmArgType.getIntOrFloatBitWidth();
+        const unsigned resWidth = llvmResType.getIntOrFloatBitWidth();
+
+        if(llvmResType.isInteger(1))
+            rewriter.replaceOp(op, toBool(rewriter, loc, arg));
+        else if(llvmArgType.isInteger(1))
+            rewriter.replaceOp(op, fromBool(rewriter, loc, arg, llvmResType));
+        else if(llvmArgType.isa<IntegerType>() && llvmResType.isa<IntegerType>()) {
+            if(argWidth == resWidth)
+                // only the signedness differs
+                rewriter.replaceOp(op, arg);
+            else if(argWidth > resWidth)
+                rewriter.replaceOpWithNewOp<LLVM::TruncOp>(op, llvmResType, arg);
+            else if(isUnsignedInt(argType))
+                rewriter.replaceOpWithNewOp<LLVM::ZExtOp>(op, llvmResType, arg);
+            else
+                rewriter.replaceOpWithNewOp<LLVM::SExtOp>(op, llvmResType, arg);
+        }
+        else if(llvmArgType.isa<IntegerType>()) {
+            if(isUnsignedInt(argType))
+                rewriter.replaceOpWithNewOp<LLVM::UIToFPOp>(op, llvmResType, arg);
+            else
+                rewriter.replaceOpWithNewOp<LLVM::SIToFPOp>(op, llvmResType, arg);
+        }
+        else if(llvmResType.isa<IntegerType>()) {
+            if(isUnsignedInt(op.getType()))
+                rewriter.replaceOpWithNewOp<LLVM::FPToUIOp>(op, llvmResType, arg);
+            else
+                rewriter.replaceOpWithNewOp<LLVM::FPToSIOp>(op, llvmResType, arg);
         }
+        else if(argWidth < resWidth)
+            rewriter.replaceOpWithNewOp<LLVM::FPExtOp>(op, llvmResType, arg);
+        else
+            rewriter.replaceOpWithNewOp<LLVM::FPTruncOp>(op, llvmResType, arg);
         return success();
     }
 };
-using AddOpLowering = BinaryOpLowering<daphne::AddOp, AddIOp, AddFOp>;
-using SubOpLowering = BinaryOpLowering<daphne::SubOp, SubIOp, SubFOp>;
-using MulOpLowering = BinaryOpLowering<daphne::MulOp, MulIOp, MulFOp>;
-#endif
 
 struct ReturnOpLowering : public OpRewritePattern<daphne::ReturnOp>
 {
@@ -80,7 +338,7 @@ struct CastOpLowering : public OpRewritePattern<daphne::CastOp> {
 
     LogicalResult matchAndRewrite(daphne::CastOp op,
                                   PatternRewriter &rewriter) const final {
-        if(op.isTrivialCast() || op.isMatrixPropertyCast()) {
+        if(op.isTrivialCast() || op.isMatrixPropertyCast() || op.isFramePropertyCast()) {
             rewriter.replaceOp(op, op.getOperand());
             return success();
         }
@@ -100,7 +358,27 @@ public:
                     ConversionPatternRewriter &rewriter) const override
     {
         Location loc = op->getLoc();
-        if(auto strAttr = op.value().dyn_cast<StringAttr>()) {
+        if(op->hasAttr(daphne::ATTR_USERCONFIG)) {
+            // The address of the user config is the one of an external
+            // symbol defined by the JIT, not a constant, such that the same
+            // code can be run by other processes, see JitObjectCache.
+            auto moduleOp = op->getParentOfType<ModuleOp>();
+            auto i8Ty = IntegerType::get(rewriter.getContext(), 8);
+            auto global = moduleOp.lookupSymbol<LLVM::GlobalOp>(daphne::SYMBOL_USERCONFIG);
+            if(!global) {
+                OpBuilder::InsertionGuard ig(rewriter);
+                rewriter.setInsertionPointToStart(moduleOp.getBody());
+                global = rewriter.create<LLVM::GlobalOp>(
+                        loc, i8Ty, false, LLVM::Linkage::External, daphne::SYMBOL_USERCONFIG, Attribute()
+                );
+            }
+            rewriter.replaceOpWithNewOp<LLVM::PtrToIntOp>(
+                    op.getOperation(),
+                    IntegerType::get(rewriter.getContext(), 64),
+                    rewriter.create<LLVM::AddressOfOp>(loc, global)
+            );
+        }
+        else if(auto strAttr = op.value().dyn_cast<StringAttr>()) {
             StringRef sr = strAttr.getValue();
 #if 1
             // MLIR does not have direct support for strings. Thus, if this is
@@ -491,7 +769,10 @@ public:
         Type itemType = item.getType();
         if (itemType != elementType) {
             if (elementType.isa<LLVM::LLVMPointerType>()) {
-                if(itemType.isSignedInteger())
+                if(itemType.isa<LLVM::LLVMPointerType>())
+                    // e.g., the file name of a read fused into a vectorized pipeline
+                    item = rewriter.create<LLVM::BitcastOp>(loc, elementType, item);
+                else if(itemType.isSignedInteger())
                     item = rewriter.create<LLVM::SExtOp>(loc, rewriter.getI64Type(), item);
                 else if(itemType.isUnsignedInteger() || itemType.isSignlessInteger())
                     item = rewriter.create<LLVM::ZExtOp>(loc, rewriter.getI64Type(), item);
@@ -501,7 +782,8 @@ public:
                 }
                 else
                     throw std::runtime_error("itemType is an unsupported type");
-                item = rewriter.create<LLVM::IntToPtrOp>(loc, elementType, item);
+                if(!item.getType().isa<LLVM::LLVMPointerType>())
+                    item = rewriter.create<LLVM::IntToPtrOp>(loc, elementType, item);
             }
             else
                 throw std::runtime_error(
@@ -526,6 +808,25 @@ public:
 
     using OpConversionPattern::OpConversionPattern;
 
+    // the input is the name of a file the pipeline reads in chunks, whose matrices are the inputs of the function
+    static bool isStreamedInput(daphne::VectorizedPipelineOp op, size_t i) {
+        return op.splits()[i].cast<daphne::VectorSplitAttr>().getValue() == daphne::VectorSplit::STREAM;
+    }
+
+    // the kernels called by the pipeline (without the types of their arguments and the reference counting), which
+    // are a part of its signature for the Autotuner, e.g., "ewMul,ewAdd,sumRow"
+    static std::string getPipelineOps(daphne::VectorizedPipelineOp op) {
+        std::string ops;
+        op.body().walk([&](daphne::CallKernelOp cko) {
+            std::string kernel = cko.getCalleeAttr().getValue().str();
+            kernel = kernel.substr(1, kernel.find("__", 1) - 1);
+            if(kernel == "incRef" || kernel == "decRef")
+                return;
+            ops += (ops.empty() ? "" : ",") + kernel;
+        });
+        return ops;
+    }
+
     LogicalResult
     matchAndRewrite(daphne::VectorizedPipelineOp op, ArrayRef<Value> operands,
                     ConversionPatternRewriter &rewriter) const override
@@ -537,6 +838,8 @@ public:
         auto loc = op->getLoc();
         auto numDataOperands = op.inputs().size();
         std::vector<mlir::Value> func_ptrs;
+        // collected before the body is moved into the pipeline function, only needed for tuning
+        const std::string ops = cfg.vectorized_autotune ? getPipelineOps(op) : "";
 
         auto i1Ty = IntegerType::get(getContext(), 1);
         auto ptrI1Ty = LLVM::LLVMPointerType::get(i1Ty);
@@ -550,8 +853,13 @@ public:
             auto &moduleBody = moduleOp.body().front();
             rewriter.setInsertionPointToStart(&moduleBody);
 
-            static auto ix = 0;
-            std::string funcName = "_vect" + std::to_string(++ix);
+            // Numbered within the module (not the process), such that the
+            // same module yields the same code, see JitObjectCache.
+            size_t ix = 0;
+            std::string funcName;
+            do
+                funcName = "_vect" + std::to_string(++ix);
+            while(moduleOp.lookupSymbol(funcName));
 
             // TODO: pass daphne context to function
             auto funcType = LLVM::LLVMFunctionType::get(LLVM::LLVMVoidType::get(rewriter.getContext()),
@@ -581,7 +889,7 @@ public:
                         rewriter.create<ConstantOp>(loc, rewriter.getIndexAttr(i))}));
                 Value val = rewriter.create<LLVM::LoadOp>(loc, addr);
                 auto expTy = typeConverter->convertType(op.inputs().getType()[i]);
-                if (expTy != val.getType()) {
+                if (expTy != val.getType() && !isStreamedInput(op, i)) {
                     // casting for scalars
                     val = rewriter.create<LLVM::PtrToIntOp>(loc, rewriter.getI64Type(), val);
                     if(expTy.isa<IntegerType>())
@@ -625,8 +933,11 @@ public:
                 auto &moduleBody = moduleOp.body().front();
                 rewriter.setInsertionPointToStart(&moduleBody);
 
-                static auto ix = 0;
-                std::string funcName = "_vect_cuda" + std::to_string(++ix);
+                size_t ix = 0;
+                std::string funcName;
+                do
+                    funcName = "_vect_cuda" + std::to_string(++ix);
+                while(moduleOp.lookupSymbol(funcName));
 
                 auto funcType = LLVM::LLVMFunctionType::get(LLVM::LLVMVoidType::get(rewriter.getContext()),
             {/*outputs...*/pppI1Ty, /*inputs...*/ ptrPtrI1Ty, /*daphneContext...*/ptrI1Ty});
@@ -653,7 +964,7 @@ public:
                             rewriter.create<ConstantOp>(loc, rewriter.getIndexAttr(i))}));
                     Value val = rewriter.create<LLVM::LoadOp>(loc, addr);
                     auto expTy = typeConverter->convertType(op.inputs().getType()[i]);
-                    if (expTy != val.getType()) {
+                    if (expTy != val.getType() && !isStreamedInput(op, i)) {
                         // casting for scalars
                         val = rewriter.create<LLVM::PtrToIntOp>(loc, rewriter.getI64Type(), val);
                         val = rewriter.create<LLVM::BitcastOp>(loc, expTy, val);
@@ -691,10 +1002,15 @@ public:
         
         if(numRes > 0) {
             // TODO Support individual types for all outputs (see #397).
-            // Check if all results have the same type.
-            Type mt0 = resultTypes[0].dyn_cast<daphne::MatrixType>().withSameElementTypeAndRepr();
+            // Check if all results have the same type (frames of any column types count as the same).
+            auto commonType = [](Type t) -> Type {
+                if(t.isa<daphne::FrameType>())
+                    return daphne::FrameType();
+                return t.dyn_cast<daphne::MatrixType>().withSameElementTypeAndRepr();
+            };
+            Type mt0 = commonType(resultTypes[0]);
             for(size_t i = 1; i < numRes; i++)
-                if(mt0 != resultTypes[i].dyn_cast<daphne::MatrixType>().withSameElementTypeAndRepr())
+                if(mt0 != commonType(resultTypes[i]))
                     throw std::runtime_error(
                             "encountered a vectorized pipelines with different "
                             "result types, but at the moment we require all "
@@ -710,7 +1026,10 @@ public:
         if(numRes > 0) {
             auto m32type = rewriter.getF32Type();
             auto m64type = rewriter.getF64Type();
-            auto res_elem_type = op->getResult(0).getType().dyn_cast<mlir::daphne::MatrixType>().getElementType();
+            // the inputs of a pipeline over frames are passed as structures like the inputs of any other pipeline
+            auto res_elem_type = op->getResult(0).getType().isa<mlir::daphne::FrameType>()
+                    ? m64type
+                    : op->getResult(0).getType().dyn_cast<mlir::daphne::MatrixType>().getElementType();
             if(res_elem_type == m64type)
                 operandType = daphne::MatrixType::get(getContext(), m64type);
             else if(res_elem_type == m32type)
@@ -795,6 +1114,21 @@ public:
         newOperands.push_back(convertToArray(loc, rewriter, ptrPtrI1Ty, func_ptrs));
 //        newOperands.push_back(fnPtr);
 
+        callee << "__char";
+        newOperands.push_back(rewriter.create<daphne::ConstantOp>(loc, daphne::StringType::get(getContext()),
+                rewriter.getStringAttr(ops)));
+
+        // The number of threads and the partitioning scheme of DaphneDSL annotations, or -1 and an empty string for
+        // the ones of the user config.
+        auto numThreads = op->getAttrOfType<IntegerAttr>(daphne::ATTR_HINT_NUM_THREADS);
+        auto schedule = op->getAttrOfType<StringAttr>(daphne::ATTR_HINT_SCHEDULE);
+        callee << "__int64_t";
+        newOperands.push_back(rewriter.create<ConstantOp>(loc, rewriter.getI64IntegerAttr(
+                numThreads ? numThreads.getInt() : -1)));
+        callee << "__char";
+        newOperands.push_back(rewriter.create<daphne::ConstantOp>(loc, daphne::StringType::get(getContext()),
+                rewriter.getStringAttr(schedule ? schedule.getValue() : "")));
+
         // Add ctx
 //        newOperands.push_back(operands.back());
         if (op.ctx() == nullptr) {
@@ -937,6 +1271,17 @@ void DaphneLowerToLLVMPass::runOnOperation()
 
     patterns.insert<VectorizedPipelineOpLowering>(typeConverter, &getContext(), cfg);
 
+    // the scalar ops RewriteToCallKernelOpPass left for inlining
+    patterns.insert<
+            EwAddOpLowering, EwSubOpLowering, EwMulOpLowering, EwDivOpLowering, EwModOpLowering, EwPowOpLowering,
+            EwMinOpLowering, EwMaxOpLowering,
+            EwEqOpLowering, EwNeqOpLowering, EwLtOpLowering, EwLeOpLowering, EwGtOpLowering, EwGeOpLowering,
+            EwAndOpLowering, EwOrOpLowering,
+            EwMinusOpLowering, EwAbsOpLowering,
+            EwSqrtOpLowering, EwExpOpLowering, EwLnOpLowering, EwFloorOpLowering, EwCeilOpLowering,
+            ScalarCastOpLowering
+    >(typeConverter, &getContext());
+
     patterns.insert<
             ConstantOpLowering,
             ReturnOpLowering,
@@ -44,6 +44,11 @@ using namespace mlir;
  *   that decreasing the reference on the new value does not destroy a data
  *   object that is still needed in a surrounding scope, i.e., to prevent
  *   double frees.
+ * - If the last use of a value is an op with `InPlaceSupport` (e.g., an
+ *   element-wise op or a left indexing like `X[i, ] = v`), we insert a
+ *   `MarkLastUseOp` right before it. If there are no other references to the
+ *   data object at run-time, the kernel may then overwrite it with its result
+ *   instead of allocating a new one.
  */
 struct ManageObjRefsPass : public PassWrapper<ManageObjRefsPass, FunctionPass>
 {
@@ -98,6 +103,18 @@ void processValue(OpBuilder builder, Value v) {
                 lastUseOp = thisUseOp;
         }
         decRefAfterOp = lastUseOp;
+
+        // Allow the last user to reuse the data object for its result. Ops
+        // marked for CUDA or FPGA are executed by other kernels, which do not
+        // support this.
+        if(
+            lastUseOp->hasTrait<OpTrait::InPlaceSupport>() &&
+            !lastUseOp->hasAttr("cuda_device") && !lastUseOp->hasAttr("fpgaopencl_device") &&
+            llvm::is_contained(lastUseOp->getOperands(), v)
+        ) {
+            builder.setInsertionPoint(lastUseOp);
+            builder.create<daphne::MarkLastUseOp>(builder.getUnknownLoc(), v);
+        }
     }
 
     // At this point, decRefAfterOp is nullptr, or the last user of v, or the
@@ -196,11 +213,11 @@ void processBlock(OpBuilder builder, Block * b) {
         
         // Casts that will not call a kernel.
         if(auto co = dyn_cast<daphne::CastOp>(op)) {
-            if(co.isTrivialCast() || co.isMatrixPropertyCast())
+            if(co.isTrivialCast() || co.isMatrixPropertyCast() || co.isFramePropertyCast())
                 incRefArgs(op, builder);
         }
-        // Loops and function calls.
-        else if(isa<scf::WhileOp, scf::ForOp, CallOp, daphne::GenericCallOp>(op))
+        // Loops and function calls (also of the remainder of a function after an adaptive checkpoint).
+        else if(isa<scf::WhileOp, scf::ForOp, CallOp, daphne::GenericCallOp, daphne::AdaptiveCallOp>(op))
             incRefArgs(op, builder);
         // YieldOp of IfOp.
         else if(isa<scf::YieldOp>(op) && isa<scf::IfOp>(op.getParentOp())) {
@@ -73,17 +73,115 @@ struct MarkCUDAOpsPass : public PassWrapper<MarkCUDAOpsPass, FunctionPass> {
             pipelineOp.body().cloneInto(&pipelineOp.cuda(), mapper);
             for (auto &op: pipelineOp.cuda().front().getOperations()) {
                 bool isMat = CompilerUtils::isMatrixComputation(&op);
-                if (op.hasTrait<mlir::OpTrait::CUDASupport>() && isMat)
+                if (hasCUDAKernel(&op) && isMat && !isHintedToCPU(&op))
                     op.setAttr("cuda_device", builder.getI32IntegerAttr(0));
             }
         }
     }
     
+    static bool isSparse(mlir::Type type) {
+        auto t = type.dyn_cast<mlir::daphne::MatrixType>();
+        return t && t.getRepresentation() == daphne::MatrixRepresentation::Sparse;
+    }
+
+    static bool involvesSparse(mlir::Operation* op) {
+        return llvm::any_of(op->getOperandTypes(), isSparse) || llvm::any_of(op->getResultTypes(), isSparse);
+    }
+
+    // The size of a sparse matrix in bits (values, column indexes, and row offsets), if its sparsity is known.
+    static int64_t sparseSize(mlir::daphne::MatrixType t) {
+        if(t.getNumRows() < 0 || t.getNumCols() < 0 || t.getSparsity() < 0)
+            return -1;
+        auto nnz = static_cast<int64_t>(t.getSparsity() * t.getNumRows() * t.getNumCols());
+        return nnz * (t.getElementType().getIntOrFloatBitWidth() + 64) + (t.getNumRows() + 1) * 64;
+    }
+
+    /**
+     * @brief Whether there is a CUDA kernel for the op and the representations and value types of its operands and
+     * results (see kernels.json).
+     *
+     * The CSRMatrix kernels are listed here rather than marked by the CUDASupport trait, since some of these ops have
+     * no CUDA kernel for dense matrices and vice versa.
+     */
+    static bool hasCUDAKernel(mlir::Operation* op) {
+        if(!involvesSparse(op)) {
+            if(!op->hasTrait<mlir::OpTrait::CUDASupport>())
+                return false;
+            // the CUDA aggregation kernels are instantiated for these value types only (see kernels.json), the
+            // row-wise and column-wise ones for indexes, too
+            const bool isAllAgg = llvm::isa<daphne::AllAggSumOp, daphne::AllAggMinOp, daphne::AllAggMaxOp,
+                    daphne::AllAggMeanOp, daphne::AllAggStddevOp>(op);
+            if(isAllAgg || llvm::isa<daphne::RowAggSumOp, daphne::RowAggMinOp, daphne::RowAggMaxOp,
+                    daphne::RowAggIdxMinOp, daphne::RowAggIdxMaxOp, daphne::RowAggMeanOp, daphne::RowAggStddevOp,
+                    daphne::ColAggSumOp, daphne::ColAggMinOp, daphne::ColAggMaxOp, daphne::ColAggIdxMinOp,
+                    daphne::ColAggIdxMaxOp, daphne::ColAggMeanOp, daphne::ColAggStddevOp>(op)) {
+                auto isAggValueType = [isAllAgg](mlir::Type type) {
+                    auto t = type.dyn_cast<mlir::daphne::MatrixType>();
+                    if(!t)
+                        return true;
+                    auto vt = t.getElementType();
+                    return vt.isF32() || vt.isF64() || vt.isSignedInteger(64) || (!isAllAgg && vt.isIndex());
+                };
+                return llvm::all_of(op->getOperandTypes(), isAggValueType) &&
+                        llvm::all_of(op->getResultTypes(), isAggValueType);
+            }
+            return true;
+        }
+
+        auto isF32OrF64 = [](mlir::Type type) {
+            auto t = type.dyn_cast<mlir::daphne::MatrixType>();
+            return !t || t.getElementType().isF32() || t.getElementType().isF64();
+        };
+        if(!llvm::all_of(op->getOperandTypes(), isF32OrF64) || !llvm::all_of(op->getResultTypes(), isF32OrF64) ||
+                op->getNumResults() != 1)
+            return false;
+        auto sparse = [op](unsigned idx) { return isSparse(op->getOperand(idx).getType()); };
+        auto sparseRes = isSparse(op->getResult(0).getType());
+        auto isMat = [op](unsigned idx) { return op->getOperand(idx).getType().isa<mlir::daphne::MatrixType>(); };
+
+        // SpMM (CSR x dense -> dense) and SpGEMM (CSR x CSR -> CSR)
+        if(llvm::isa<daphne::MatMulOp>(op))
+            return sparse(0) && sparse(1) == sparseRes;
+        // SpMV of the transposed matrix
+        if(llvm::isa<daphne::GemvOp>(op))
+            return sparse(0) && !sparse(1) && !sparseRes;
+        if(llvm::isa<daphne::EwMulOp>(op))
+            return sparse(0) && isMat(1) && !sparse(1) && sparseRes;
+        if(llvm::isa<daphne::RowAggSumOp, daphne::ColAggSumOp>(op))
+            return sparse(0) && !sparseRes;
+        if(llvm::isa<daphne::AllAggSumOp>(op))
+            return sparse(0);
+        return false;
+    }
+
+    /**
+     * @brief Whether the sparse operands have enough non-zeros to amortize the transfers and kernel launches on the
+     * device. Unlike for dense operands, unknown sizes count as too small.
+     */
+    static bool paysOffSparse(mlir::Operation* op) {
+        // below this many non-zeros, the CPU kernels are faster than the transfer and the launches
+        constexpr double MIN_NUM_NON_ZEROS = 1 << 16;
+        double nnz = 0;
+        for(auto type : op->getOperandTypes()) {
+            if(!isSparse(type))
+                continue;
+            auto t = type.cast<mlir::daphne::MatrixType>();
+            if(t.getNumRows() < 0 || t.getNumCols() < 0 || t.getSparsity() < 0)
+                return false;
+            nnz += t.getSparsity() * t.getNumRows() * t.getNumCols();
+        }
+        return nnz >= MIN_NUM_NON_ZEROS;
+    }
+
     bool fitsInMemory(mlir::Operation* op) const {
         auto opSize = 0ul;
         for(auto operand : op->getOperands()) {
             auto type = operand.getType();
             if(auto t = type.dyn_cast<mlir::daphne::MatrixType>()) {
+                if(isSparse(t) && sparseSize(t) >= 0) {
+                    opSize += sparseSize(t);
+                    continue;
+                }
                 auto rows = t.getNumRows();
                 auto cols = t.getNumCols();
                 if(rows < 0 || cols < 0) {
@@ -103,7 +201,10 @@ struct MarkCUDAOpsPass : public PassWrapper<MarkCUDAOpsPass, FunctionPass> {
         for(auto result : op->getResults()) {
             auto type = result.getType();
             if(auto t = type.dyn_cast<mlir::daphne::MatrixType>()) {
-                opSize += t.getNumRows() * t.getNumCols() * t.getElementType().getIntOrFloatBitWidth();
+                if(isSparse(t) && sparseSize(t) >= 0)
+                    opSize += sparseSize(t);
+                else
+                    opSize += t.getNumRows() * t.getNumCols() * t.getElementType().getIntOrFloatBitWidth();
             }
         }
 //        std::cout << "op out size: " << (opSize-inSize) / 1024 << " kB" << std::endl;
@@ -135,12 +236,59 @@ struct MarkCUDAOpsPass : public PassWrapper<MarkCUDAOpsPass, FunctionPass> {
         return false;
     }
     
+    /**
+     * @brief Whether a read is done by the CUDA kernel, which reads the file into the device memory directly (see
+     * CUDA/Read.h), i.e., whether it reads a dense matrix from a Daphne binary file for ops on the device only.
+     *
+     * Not if the read is prefetched on the host or the read data is kept on the host (cached or with zone maps).
+     */
+    bool readsForDevice(daphne::ReadOp op) const {
+        if(cfg.cache_reads || cfg.zone_maps || op->getParentOfType<daphne::VectorizedPipelineOp>())
+            return false;
+        auto t = op.res().getType().dyn_cast<daphne::MatrixType>();
+        if(!t || t.getRepresentation() == daphne::MatrixRepresentation::Sparse)
+            return false;
+        auto vt = t.getElementType();
+        if(!vt.isF32() && !vt.isF64() && !vt.isSignedInteger(64))
+            return false;
+        auto co = op.fileName().getDefiningOp<daphne::ConstantOp>();
+        auto fileName = co ? co.value().dyn_cast<mlir::StringAttr>() : nullptr;
+        if(!fileName || !fileName.getValue().endswith(".dbdf"))
+            return false;
+        if(llvm::any_of(op.fileName().getUsers(), [](Operation* user) {
+            return llvm::isa<daphne::PrefetchReadOp>(user);
+        }))
+            return false;
+        auto bytes = CompilerUtils::estimateBytes(op.res());
+        if(!bytes || *bytes >= mem_budget)
+            return false;
+        return !op.res().use_empty() && llvm::all_of(op.res().getUsers(), [](Operation* user) {
+            if(auto pipelineOp = llvm::dyn_cast<daphne::VectorizedPipelineOp>(user))
+                return !pipelineOp.cuda().empty();
+            return user->hasAttr("cuda_device");
+        });
+    }
+
+    // whether the op is kept on the host by the DaphneDSL annotation `@device(cpu)`
+    static bool isHintedToCPU(Operation* op) {
+        auto device = op->getAttrOfType<StringAttr>(daphne::ATTR_HINT_DEVICE);
+        return device && device.getValue() == "cpu";
+    }
+
+    /**
+     * @brief Whether the op runs on the device. An op annotated by `@device(gpu)` in DaphneDSL does regardless of
+     * its size, if there is a CUDA kernel for it and its data fits into the memory of the device, one annotated by
+     * `@device(cpu)` never does.
+     */
     bool checkUseCUDA(Operation* op) const {
 //        std::cout << "checkUseCUDA: " << op->getName().getStringRef().str() << std::endl;
         
-        bool use_cuda = op->hasTrait<mlir::OpTrait::CUDASupport>();
+        if(isHintedToCPU(op))
+            return false;
+        bool use_cuda = hasCUDAKernel(op);
         use_cuda = use_cuda && CompilerUtils::isMatrixComputation(op);
-        use_cuda = use_cuda && hasReqMinDims(op);
+        if(!op->hasAttr(daphne::ATTR_HINT_DEVICE))
+            use_cuda = use_cuda && (involvesSparse(op) ? paysOffSparse(op) : hasReqMinDims(op));
         use_cuda = use_cuda && fitsInMemory(op);
         return use_cuda;
     }
@@ -162,6 +310,12 @@ void MarkCUDAOpsPass::runOnFunction() {
         }
         WalkResult::advance();
     });
+
+    // the reads whose data is only used on the device, once their users are marked
+    getFunction()->walk([&](daphne::ReadOp op) {
+        if(readsForDevice(op))
+            op->setAttr("cuda_device", OpBuilder(op).getI32IntegerAttr(0));
+    });
 }
 
 std::unique_ptr<Pass> daphne::createMarkCUDAOpsPass(const DaphneUserConfig& cfg) {
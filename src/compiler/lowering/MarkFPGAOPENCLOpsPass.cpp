@@ -19,7 +19,10 @@
 #include "ir/daphneir/Passes.h"
 #include <mlir/IR/BlockAndValueMapping.h>
 
+#include <algorithm>
 #include <iostream>
+#include <optional>
+#include <thread>
 
 using namespace mlir;
 
@@ -30,6 +33,18 @@ struct MarkFPGAOPENCLOpsPass : public PassWrapper<MarkFPGAOPENCLOpsPass, Functio
      */
     const DaphneUserConfig& cfg;
 
+    // A rough model of the sgemm bitstream and the host it competes with: the
+    // sustained throughputs of the systolic array, of a CPU core, and of the
+    // PCIe link, and the latency of enqueuing the kernels.
+    static constexpr double FPGA_FLOPS = 500e9;
+    static constexpr double CPU_CORE_FLOPS = 30e9;
+    static constexpr double PCIE_BYTES_PER_SEC = 6e9;
+    static constexpr double FPGA_LAUNCH_SECS = 1e-3;
+    // The tiles of the systolic array (see FPGAOPENCL/gemm_interface.h).
+    static constexpr int64_t TILE_I = 448;
+    static constexpr int64_t TILE_J = 512;
+    static constexpr int64_t TILE_K = 512;
+
     explicit MarkFPGAOPENCLOpsPass(const DaphneUserConfig& cfg) : cfg(cfg) {
     }
 
@@ -37,11 +52,57 @@ struct MarkFPGAOPENCLOpsPass : public PassWrapper<MarkFPGAOPENCLOpsPass, Functio
 
     bool checkUseFPGAOPENCL(Operation* op) const {
 //        std::cout << "checkUseFPGAOPENCL: " << op->getName().getStringRef().str() << std::endl;
-        return op->hasTrait<mlir::OpTrait::FPGAOPENCLSupport>();
+        if(!op->hasTrait<mlir::OpTrait::FPGAOPENCLSupport>())
+            return false;
+        if(auto matMulOp = llvm::dyn_cast<daphne::MatMulOp>(op))
+            return isWorthOffloading(matMulOp);
+        return true;
+    }
+
+    static std::optional<bool> constantBool(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto boolAttr = co.value().dyn_cast<BoolAttr>())
+                return boolAttr.getValue();
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Whether the bitstream supports a matrix multiplication and is
+     * estimated to compute it faster than the CPU, including the transfers
+     * of its inputs over PCIe (lhs stays in FPGA memory if it is the result
+     * of an op on the FPGA).
+     */
+    bool isWorthOffloading(daphne::MatMulOp op) const {
+        auto lhsTy = op.lhs().getType().dyn_cast<daphne::MatrixType>();
+        auto rhsTy = op.rhs().getType().dyn_cast<daphne::MatrixType>();
+        if(!lhsTy || !rhsTy || !lhsTy.getElementType().isF32() || !rhsTy.getElementType().isF32())
+            return false;
+        std::optional<bool> transa = constantBool(op.transa());
+        std::optional<bool> transb = constantBool(op.transb());
+        if(!transa || *transa || !transb || *transb)
+            return false;
+        const int64_t m = lhsTy.getNumRows();
+        const int64_t k = lhsTy.getNumCols();
+        const int64_t n = rhsTy.getNumCols();
+        if(m <= 0 || k <= 0 || n <= 0 || m % TILE_I || k % TILE_K || k < 2 * TILE_K || n % TILE_J)
+            return false;
+
+        const double flops = 2.0 * m * n * k;
+        double bytes = static_cast<double>(k) * n * sizeof(float);
+        Operation* lhsDef = op.lhs().getDefiningOp();
+        if(!lhsDef || !lhsDef->hasAttr("fpgaopencl_device"))
+            bytes += static_cast<double>(m) * k * sizeof(float);
+        const double fpgaSecs = bytes / PCIE_BYTES_PER_SEC + flops / FPGA_FLOPS + FPGA_LAUNCH_SECS;
+        const int numThreads = cfg.numberOfThreads > 0 ? cfg.numberOfThreads
+                : std::max(1u, std::thread::hardware_concurrency());
+        const double cpuSecs = flops / (CPU_CORE_FLOPS * numThreads);
+        return fpgaSecs < cpuSecs;
     }
 };
 
 void MarkFPGAOPENCLOpsPass::runOnFunction() {
+    // Ops are visited in order, so whether the lhs of a MatMulOp is already
+    // in FPGA memory is known when deciding on it.
     getFunction()->walk([&](Operation* op) {
         OpBuilder builder(op);
         if(checkUseFPGAOPENCL(op)) {
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Marks the elementwise additions, subtractions, multiplications, and
+ * divisions and the matrix multiplications on tiny dense matrices of static
+ * shapes, such that `RewriteToCallKernelOpPass` calls kernels instantiated
+ * for these shapes (e.g., `_ewAdd_2x3__...`, `_matMul_3x3x3__...`).
+ *
+ * These kernels have completely unrolled loops and do not interpret the op
+ * code or call BLAS, which dominate the run-time of ops on a few cells, e.g.,
+ * on 3x3 covariance matrices or 1xk row vectors. The shapes are generated by
+ * `genKernelInst.py` from the `staticShapes` in `kernels.json`, which must
+ * cover all dimensions up to `MAX_STATIC_DIM`.
+ */
+struct MarkStaticShapeOpsPass : public PassWrapper<MarkStaticShapeOpsPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+namespace {
+    constexpr ssize_t MAX_STATIC_DIM = 4;
+
+    bool isStaticDim(ssize_t d) {
+        return d >= 1 && d <= MAX_STATIC_DIM;
+    }
+
+    // The dense matrix type of a value of the value type, if it has a static shape.
+    daphne::MatrixType staticMatrixType(Value v, Type vt) {
+        auto matTy = v.getType().dyn_cast<daphne::MatrixType>();
+        if(!matTy || matTy.getElementType() != vt || matTy.getRepresentation() != daphne::MatrixRepresentation::Dense
+                || !isStaticDim(matTy.getNumRows()) || !isStaticDim(matTy.getNumCols()))
+            return nullptr;
+        return matTy;
+    }
+
+    std::optional<bool> constantBool(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto attr = co.value().dyn_cast<BoolAttr>())
+                return attr.getValue();
+        return std::nullopt;
+    }
+
+    std::string shapeSuffix(const std::vector<ssize_t> & dims) {
+        std::string s;
+        for(ssize_t d : dims)
+            s += (s.empty() ? "" : "x") + std::to_string(d);
+        return s;
+    }
+
+    // The static shape of an elementwise op on matrices of the same shape, or an empty string.
+    std::string ewBinaryShape(Operation * op) {
+        auto resTy = op->getResult(0).getType().dyn_cast<daphne::MatrixType>();
+        if(!resTy || !(resTy.getElementType().isF64() || resTy.getElementType().isF32()))
+            return "";
+        Type vt = resTy.getElementType();
+        auto lhsTy = staticMatrixType(op->getOperand(0), vt);
+        auto rhsTy = staticMatrixType(op->getOperand(1), vt);
+        if(!staticMatrixType(op->getResult(0), vt) || !lhsTy || !rhsTy)
+            return "";
+        for(auto argTy : {lhsTy, rhsTy})
+            if(argTy.getNumRows() != resTy.getNumRows() || argTy.getNumCols() != resTy.getNumCols())
+                return "";
+        return shapeSuffix({resTy.getNumRows(), resTy.getNumCols()});
+    }
+
+    // The static shape MxKxN of a matrix multiplication, or an empty string.
+    std::string matMulShape(daphne::MatMulOp op) {
+        auto resTy = op.getType().dyn_cast<daphne::MatrixType>();
+        if(!resTy || !(resTy.getElementType().isF64() || resTy.getElementType().isF32()))
+            return "";
+        Type vt = resTy.getElementType();
+        auto lhsTy = staticMatrixType(op.lhs(), vt);
+        if(!staticMatrixType(op.res(), vt) || !lhsTy || !staticMatrixType(op.rhs(), vt))
+            return "";
+        std::optional<bool> transa = constantBool(op.transa());
+        if(!transa || !constantBool(op.transb()))
+            return "";
+        const ssize_t k = *transa ? lhsTy.getNumRows() : lhsTy.getNumCols();
+        return shapeSuffix({resTy.getNumRows(), k, resTy.getNumCols()});
+    }
+}
+
+void MarkStaticShapeOpsPass::runOnFunction() {
+    getFunction()->walk([&](Operation * op) {
+        // Ops on other devices and in vectorized pipelines (whose inputs are split into rows) are not marked.
+        if(op->hasAttr("cuda_device") || op->hasAttr("fpgaopencl_device")
+                || op->getParentOfType<daphne::VectorizedPipelineOp>())
+            return;
+        std::string shape;
+        if(llvm::isa<daphne::EwAddOp, daphne::EwSubOp, daphne::EwMulOp, daphne::EwDivOp>(op))
+            shape = ewBinaryShape(op);
+        else if(auto matMulOp = llvm::dyn_cast<daphne::MatMulOp>(op))
+            shape = matMulShape(matMulOp);
+        if(!shape.empty())
+            op->setAttr(daphne::ATTR_STATIC_SHAPE, StringAttr::get(&getContext(), shape));
+    });
+}
+
+std::unique_ptr<Pass> daphne::createMarkStaticShapeOpsPass() {
+    return std::make_unique<MarkStaticShapeOpsPass>();
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compiler/CompilerUtils.h"
+#include "ir/daphneir/Daphne.h"
+#include "ir/daphneir/Passes.h"
+
+#include "mlir/Dialect/SCF/SCF.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Common subexpression elimination (CSE) of the side-effect-free
+ * DAPHNE operations (see `CompilerUtils::isSideEffectFree`), which MLIR's CSE
+ * does not consider, since most of them do not declare their (lack of) side
+ * effects.
+ *
+ * Two operations are equal if they have the same name, operands, attributes,
+ * and result types, where
+ * - the operands of commutative elementwise operations are unordered,
+ * - constant operands are compared by their value,
+ * - `syrk(X)` and `gemv(A, x)` are matrix multiplications with a transposed
+ *   left-hand side, which is how the canonicalization of `MatMulOp`
+ *   represents `t(X) @ X` and `t(A) @ x`.
+ *
+ * An operation is replaced by an equal one in the same block or in an
+ * enclosing block before it. Equal operations in both branches of an IfOp,
+ * whose operands are defined outside of it, are moved before it and merged.
+ *
+ * This pass must run before the `ManageObjRefsPass`, which then inserts the
+ * reference counting for the merged values just like for any other values.
+ * Functions that already contain reference counting operations are left
+ * alone, since two decrements of a merged value would free it too early.
+ */
+struct MatrixCSEPass : public PassWrapper<MatrixCSEPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+namespace {
+    /**
+     * @brief The identity of an operation, up to the equivalences above.
+     *
+     * The operands are the opaque pointers of the values, or of the
+     * attributes of constants.
+     */
+    struct OpKey {
+        std::string name;
+        std::vector<const void *> operands;
+        const void * attrs;
+        std::vector<const void *> resultTypes;
+
+        bool operator<(const OpKey & other) const {
+            return std::tie(name, operands, attrs, resultTypes)
+                    < std::tie(other.name, other.operands, other.attrs, other.resultTypes);
+        }
+    };
+
+    using OpMap = std::map<OpKey, Operation *>;
+
+    const void * operandKey(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            return co.value().getAsOpaquePointer();
+        return v.getAsOpaquePointer();
+    }
+
+    OpKey makeKey(Operation * op) {
+        OpKey key;
+        key.name = op->getName().getStringRef().str();
+        for(Value v : op->getOperands())
+            key.operands.push_back(operandKey(v));
+        key.attrs = op->getAttrDictionary().getAsOpaquePointer();
+        for(Type t : op->getResultTypes())
+            key.resultTypes.push_back(t.getAsOpaquePointer());
+
+        if(llvm::isa<
+                daphne::EwAddOp, daphne::EwMulOp, daphne::EwMinOp, daphne::EwMaxOp,
+                daphne::EwAndOp, daphne::EwOrOp, daphne::EwXorOp, daphne::EwEqOp, daphne::EwNeqOp
+        >(op))
+            std::sort(key.operands.begin(), key.operands.end());
+        else if(llvm::isa<daphne::SyrkOp, daphne::GemvOp>(op)) {
+            Builder builder(op->getContext());
+            Value lhs = op->getOperand(0);
+            Value rhs = llvm::isa<daphne::SyrkOp>(op) ? lhs : op->getOperand(1);
+            key.name = daphne::MatMulOp::getOperationName().str();
+            key.operands = {
+                operandKey(lhs), operandKey(rhs),
+                builder.getBoolAttr(true).getAsOpaquePointer(), builder.getBoolAttr(false).getAsOpaquePointer()
+            };
+        }
+        return key;
+    }
+
+    bool hasOperandsDefinedOutside(Operation * op, Operation * ancestor) {
+        return llvm::all_of(op->getOperands(), [&](Value v) {
+            return !ancestor->isAncestor(v.getParentBlock()->getParentOp());
+        });
+    }
+
+    // Moves the equal operations of both branches of the IfOp before it, until there are no more, since the
+    // operations using merged ones may become equal, too.
+    void hoistCommonOps(scf::IfOp ifOp) {
+        if(ifOp.elseRegion().empty())
+            return;
+        bool changed = true;
+        while(changed) {
+            changed = false;
+            OpMap thenOps;
+            for(Operation & op : ifOp.thenRegion().front().without_terminator())
+                if(CompilerUtils::isSideEffectFree(&op) && hasOperandsDefinedOutside(&op, ifOp))
+                    thenOps.emplace(makeKey(&op), &op);
+            for(Operation & op : llvm::make_early_inc_range(ifOp.elseRegion().front().without_terminator())) {
+                if(!CompilerUtils::isSideEffectFree(&op) || !hasOperandsDefinedOutside(&op, ifOp))
+                    continue;
+                auto it = thenOps.find(makeKey(&op));
+                if(it == thenOps.end())
+                    continue;
+                it->second->moveBefore(ifOp);
+                op.replaceAllUsesWith(it->second->getResults());
+                op.erase();
+                thenOps.erase(it);
+                changed = true;
+            }
+        }
+    }
+
+    // Replaces the operations equal to a known or preceding operation, with a copy of the known operations for each
+    // block, such that no operation is replaced by one that does not dominate it.
+    void eliminateCommonOps(Region & region, const OpMap & known) {
+        for(Block & block : region) {
+            OpMap blockOps(known);
+            for(Operation & op : llvm::make_early_inc_range(block)) {
+                if(op.getNumRegions() != 0) {
+                    // the regions of isolated operations cannot use the values from outside
+                    const OpMap none;
+                    for(Region & nested : op.getRegions())
+                        eliminateCommonOps(nested, op.hasTrait<OpTrait::IsIsolatedFromAbove>() ? none : blockOps);
+                    continue;
+                }
+                if(!CompilerUtils::isSideEffectFree(&op))
+                    continue;
+                auto inserted = blockOps.emplace(makeKey(&op), &op);
+                if(!inserted.second) {
+                    op.replaceAllUsesWith(inserted.first->second->getResults());
+                    op.erase();
+                }
+            }
+        }
+    }
+}
+
+void MatrixCSEPass::runOnFunction() {
+    auto hasObjRefs = getFunction()->walk([](Operation * op) {
+        if(llvm::isa<daphne::IncRefOp, daphne::DecRefOp>(op))
+            return WalkResult::interrupt();
+        return WalkResult::advance();
+    }).wasInterrupted();
+    if(hasObjRefs)
+        return;
+
+    // the walk is post-order, i.e., the ops moved out of an inner IfOp can be moved further out
+    std::vector<scf::IfOp> ifOps;
+    getFunction()->walk([&](scf::IfOp ifOp) { ifOps.push_back(ifOp); });
+    for(auto ifOp : ifOps)
+        hoistCommonOps(ifOp);
+
+    eliminateCommonOps(getFunction().getBody(), OpMap());
+}
+
+std::unique_ptr<Pass> daphne::createMatrixCSEPass() {
+    return std::make_unique<MatrixCSEPass>();
+}
@@ -0,0 +1,662 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compiler/inference/CardinalityEstimation.h>
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/IR/BlockAndValueMapping.h>
+#include <mlir/Pass/Pass.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Optimizes the relational plans of SQL queries, i.e., the trees of
+ * `cartesian` and `innerJoin` operations the `SQLVisitor` builds in the
+ * textual order of the FROM and JOIN clauses, and the `filterRow` of the
+ * WHERE clause on top of them.
+ *
+ * - The conjuncts of the WHERE clause reading the columns of a single input
+ *   are pushed below the joins, filtering that input.
+ * - The equality conjuncts on columns of the same value type of two inputs
+ *   become `innerJoin`s instead of filters of a cartesian product. The other
+ *   conjuncts on several inputs filter the first join containing all of
+ *   them.
+ * - The joins of more than two inputs are ordered greedily by their
+ *   estimated cardinalities, based on the estimated numbers of rows of the
+ *   inputs and the statistics of their columns (see `CardinalityEstimation`),
+ *   if all of them are known. Otherwise, the inputs are joined in their
+ *   textual order (preferring inputs connected by an equality).
+ * - The columns of the inputs no later operation reads are dropped (as views
+ *   sharing the columns) before they are filtered and joined.
+ *
+ * The pass relies on the frame labels inferred before. A query it cannot
+ * fully analyze, e.g., because a column label does not belong to exactly one
+ * input, is left alone. Since the rows of a join are ordered like those of a
+ * nested-loop join, the rows of the result keep their order unless the joins
+ * are reordered.
+ */
+struct OptimizeSqlPass : public PassWrapper<OptimizeSqlPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+namespace {
+    std::optional<std::string> constantString(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto strAttr = co.value().dyn_cast<StringAttr>())
+                return strAttr.getValue().str();
+        return std::nullopt;
+    }
+
+    bool isComparison(Operation * op) {
+        return llvm::isa<daphne::EwEqOp, daphne::EwNeqOp, daphne::EwLtOp, daphne::EwLeOp, daphne::EwGtOp,
+                daphne::EwGeOp>(op);
+    }
+
+    // The SQLVisitor casts the operands of AND and OR to integer matrices via
+    // single-column frames.
+    Value skipCasts(Value v) {
+        for(;;) {
+            if(auto castOp = v.getDefiningOp<daphne::CastOp>())
+                v = castOp.arg();
+            else if(auto createOp = v.getDefiningOp<daphne::CreateFrameOp>()) {
+                if(createOp.cols().size() != 1)
+                    return v;
+                v = createOp.cols()[0];
+            }
+            else
+                return v;
+        }
+    }
+
+    // the type with unknown properties except for the value types, such that
+    // the inference recomputes them for a copied operation
+    Type withUnknownProperties(Type t) {
+        if(auto mt = t.dyn_cast<daphne::MatrixType>())
+            return mt.withShape(-1, -1).withSparsity(-1);
+        if(auto ft = t.dyn_cast<daphne::FrameType>())
+            return ft.withSameColumnTypes();
+        return t;
+    }
+
+    /**
+     * @brief A conjunct of the WHERE clause and the operations computing it
+     * from the columns of the tree.
+     */
+    struct Conjunct {
+        Value value;
+        // the operations depending on the tree, in the order of the block
+        std::vector<Operation *> ops;
+        std::set<std::string> labels;
+        std::set<size_t> inputs;
+        // whether it depends on the number of rows of the tree
+        bool global = false;
+        bool isEquality = false;
+    };
+
+    // An equality of a column of two inputs, which can be a join key.
+    struct JoinEdge {
+        size_t input[2];
+        std::string label[2];
+    };
+
+    // The frame of a (partial) plan and its column labels and value types.
+    struct Plan {
+        Value frame;
+        std::vector<std::string> labels;
+        std::vector<Type> colTypes;
+    };
+
+    class QueryOptimizer {
+        daphne::FrameType frameType(const std::vector<Type> & colTypes) {
+            return daphne::FrameType::get(&ctx, colTypes);
+        }
+
+        MLIRContext & ctx;
+        OpBuilder builder;
+        Location loc;
+
+        // the tree and the filter of the WHERE clause on top of it (if any)
+        Value tree;
+        daphne::FilterRowOp filter;
+        std::vector<Operation *> treeOps;
+        std::vector<daphne::InnerJoinOp> joinOps;
+
+        // the inputs of the tree in their textual order
+        std::vector<Plan> inputs;
+        std::map<std::string, size_t> inputOfLabel;
+        std::vector<double> numRows;
+
+        std::vector<Conjunct> conjuncts;
+        std::vector<JoinEdge> edges;
+
+        // Collects the inputs and operations of the tree of cartesian products
+        // and inner joins rooted at v.
+        void collectTree(Value v, bool isRoot) {
+            Operation * op = v.getDefiningOp();
+            const bool isTreeOp = op && llvm::isa<daphne::CartesianOp, daphne::InnerJoinOp>(op);
+            if(isTreeOp && (isRoot || (v.hasOneUse() && op->getBlock() == treeOps.front()->getBlock()))) {
+                treeOps.push_back(op);
+                if(auto joinOp = llvm::dyn_cast<daphne::InnerJoinOp>(op))
+                    joinOps.push_back(joinOp);
+                collectTree(op->getOperand(0), false);
+                collectTree(op->getOperand(1), false);
+                return;
+            }
+            inputs.push_back({v, {}, {}});
+        }
+
+        // Adds the operations computing v from the tree to the conjunct and
+        // returns whether v depends on the tree, false in `valid` if the
+        // conjunct reads the tree other than by columns and number of rows.
+        bool collectConjunct(Value v, Conjunct & c, std::map<Operation *, bool> & visited, bool & valid) {
+            Operation * op = v.getDefiningOp();
+            if(!op || op->getBlock() != filter->getBlock())
+                return false;
+            auto it = visited.find(op);
+            if(it != visited.end())
+                return it->second;
+            bool dependent = false;
+            for(Value operand : op->getOperands()) {
+                if(operand == tree) {
+                    dependent = true;
+                    auto extractOp = llvm::dyn_cast<daphne::ExtractColOp>(op);
+                    std::optional<std::string> label;
+                    if(extractOp && extractOp.source() == tree && (label = constantString(extractOp.selectedCols())))
+                        c.labels.insert(*label);
+                    else if(llvm::isa<daphne::NumRowsOp>(op))
+                        c.global = true;
+                    else
+                        valid = false;
+                }
+                else if(collectConjunct(operand, c, visited, valid))
+                    dependent = true;
+            }
+            if(dependent) {
+                if(op->getNumRegions())
+                    valid = false;
+                c.ops.push_back(op);
+            }
+            visited[op] = dependent;
+            return dependent;
+        }
+
+        // the label of the column of the tree v is extracted from, if any
+        std::optional<std::string> columnOf(Value v) {
+            while(auto castOp = v.getDefiningOp<daphne::CastOp>())
+                v = castOp.arg();
+            auto extractOp = v.getDefiningOp<daphne::ExtractColOp>();
+            if(!extractOp || extractOp.source() != tree)
+                return std::nullopt;
+            return constantString(extractOp.selectedCols());
+        }
+
+        Type colTypeOf(const std::string & label) {
+            const Plan & input = inputs[inputOfLabel.at(label)];
+            const size_t idx = std::find(input.labels.begin(), input.labels.end(), label) - input.labels.begin();
+            return input.colTypes[idx];
+        }
+
+        // Splits the condition of the filter into conjuncts, false if it cannot
+        // be analyzed.
+        bool collectConjuncts() {
+            std::vector<Value> values;
+            std::vector<Value> pending = {filter.selectedRows()};
+            while(!pending.empty()) {
+                Value v = pending.back();
+                pending.pop_back();
+                Operation * op = skipCasts(v).getDefiningOp();
+                if(op && llvm::isa<daphne::EwAndOp>(op)) {
+                    pending.push_back(op->getOperand(1));
+                    pending.push_back(op->getOperand(0));
+                }
+                else
+                    values.push_back(v);
+            }
+            // Filtering by the conjuncts one after the other is only the same
+            // as filtering by their conjunction, if they are zeros and ones.
+            if(std::any_of(values.begin(), values.end(), [](Value v) {
+                Operation * op = skipCasts(v).getDefiningOp();
+                return !op || !(isComparison(op) || llvm::isa<daphne::EwOrOp>(op));
+            }))
+                values = {filter.selectedRows()};
+
+            // Any other use of the tree could read any of its columns.
+            std::set<Operation *> condOps;
+            for(Value v : values) {
+                Conjunct c;
+                c.value = v;
+                std::map<Operation *, bool> visited;
+                bool valid = true;
+                collectConjunct(v, c, visited, valid);
+                if(!valid)
+                    return false;
+                std::sort(c.ops.begin(), c.ops.end(), [](Operation * a, Operation * b) { return a->isBeforeInBlock(b); });
+                for(const std::string & label : c.labels) {
+                    auto it = inputOfLabel.find(label);
+                    if(it == inputOfLabel.end())
+                        return false;
+                    c.inputs.insert(it->second);
+                }
+                Operation * op = skipCasts(v).getDefiningOp();
+                c.isEquality = op && llvm::isa<daphne::EwEqOp>(op);
+                condOps.insert(c.ops.begin(), c.ops.end());
+                conjuncts.push_back(std::move(c));
+            }
+            for(Operation * user : tree.getUsers())
+                if(user != filter.getOperation() && !condOps.count(user))
+                    return false;
+            for(Operation * op : condOps)
+                for(Operation * user : op->getUsers())
+                    if(user != filter.getOperation() && !condOps.count(user))
+                        return false;
+            return true;
+        }
+
+        // Adds the labels of the columns the users of v read to `labels` and
+        // the frames passing the columns on to `chain`, false if some user
+        // could read any column.
+        bool collectReadLabels(Value v, std::set<std::string> & labels, std::vector<Operation *> & chain) {
+            for(Operation * user : v.getUsers()) {
+                std::optional<std::string> label;
+                if(auto extractOp = llvm::dyn_cast<daphne::ExtractColOp>(user)) {
+                    if(extractOp.source() != v || !(label = constantString(extractOp.selectedCols())))
+                        return false;
+                    labels.insert(*label);
+                }
+                else if(auto getColIdxOp = llvm::dyn_cast<daphne::GetColIdxOp>(user)) {
+                    if(getColIdxOp.frame() != v || !(label = constantString(getColIdxOp.columnName())))
+                        return false;
+                    labels.insert(*label);
+                }
+                else if(llvm::isa<daphne::NumRowsOp>(user))
+                    continue;
+                else if(auto groupOp = llvm::dyn_cast<daphne::GroupOp>(user)) {
+                    for(Value l : groupOp.keyCol())
+                        if((label = constantString(l)))
+                            labels.insert(*label);
+                        else
+                            return false;
+                    for(Value l : groupOp.aggCol())
+                        if((label = constantString(l)))
+                            labels.insert(*label);
+                        else
+                            return false;
+                }
+                else if((llvm::isa<daphne::FilterRowOp, daphne::OrderOp>(user) && user->getOperand(0) == v)
+                        || (llvm::isa<daphne::ColBindOp>(user) && user->getOperand(0) == v && user->getOperand(1) != v)) {
+                    chain.push_back(user);
+                    if(!collectReadLabels(user->getResult(0), labels, chain))
+                        return false;
+                }
+                else
+                    return false;
+            }
+            return true;
+        }
+
+        // the columns with the given labels of the frame, as a view
+        Plan project(const Plan & plan, const std::vector<std::string> & labels) {
+            if(labels == plan.labels)
+                return plan;
+            Plan res{nullptr, {}, {}};
+            for(const std::string & label : labels) {
+                const size_t idx = std::find(plan.labels.begin(), plan.labels.end(), label) - plan.labels.begin();
+                Value col = builder.create<daphne::ExtractColOp>(
+                        loc, frameType({plan.colTypes[idx]}), plan.frame, builder.create<daphne::ConstantOp>(loc, label)
+                );
+                res.labels.push_back(label);
+                res.colTypes.push_back(plan.colTypes[idx]);
+                res.frame = res.frame
+                        ? builder.create<daphne::ColBindOp>(loc, frameType(res.colTypes), res.frame, col).getResult()
+                        : col;
+            }
+            return res;
+        }
+
+        // the conjunct computed on the plan instead of the tree
+        Value copyConjunct(const Conjunct & c, const Plan & plan) {
+            BlockAndValueMapping mapping;
+            mapping.map(tree, plan.frame);
+            for(Operation * op : c.ops) {
+                Operation * copy = builder.clone(*op, mapping);
+                for(Value res : copy->getResults())
+                    res.setType(withUnknownProperties(res.getType()));
+            }
+            return mapping.lookupOrDefault(c.value);
+        }
+
+        Plan filterBy(const Plan & plan, Value selectedRows) {
+            Value res = builder.create<daphne::FilterRowOp>(loc, frameType(plan.colTypes), plan.frame, selectedRows);
+            return {res, plan.labels, plan.colTypes};
+        }
+
+        Plan filterByEquality(const Plan & plan, const JoinEdge & edge) {
+            Value cols[2];
+            for(size_t i = 0; i < 2; i++) {
+                Type vt = colTypeOf(edge.label[i]);
+                Value col = builder.create<daphne::ExtractColOp>(
+                        loc, frameType({vt}), plan.frame, builder.create<daphne::ConstantOp>(loc, edge.label[i])
+                );
+                cols[i] = builder.create<daphne::CastOp>(loc, daphne::MatrixType::get(&ctx, vt), col);
+            }
+            return filterBy(plan, builder.create<daphne::EwEqOp>(loc, cols[0], cols[1]));
+        }
+
+        static Plan concat(Value frame, const Plan & lhs, const Plan & rhs) {
+            Plan res{frame, lhs.labels, lhs.colTypes};
+            res.labels.insert(res.labels.end(), rhs.labels.begin(), rhs.labels.end());
+            res.colTypes.insert(res.colTypes.end(), rhs.colTypes.begin(), rhs.colTypes.end());
+            return res;
+        }
+
+    public:
+        QueryOptimizer(Operation * root) :
+                ctx(*root->getContext()), builder(root), loc(root->getLoc()), tree(root->getResult(0)) {}
+
+        void optimize() {
+            collectTree(tree, true);
+            const size_t numInputs = inputs.size();
+
+            // the labels, value types, and numbers of rows of the inputs
+            bool allNumRowsKnown = true;
+            for(size_t i = 0; i < numInputs; i++) {
+                auto ft = inputs[i].frame.getType().dyn_cast<daphne::FrameType>();
+                if(!ft || !ft.getLabels())
+                    return;
+                inputs[i].labels = *ft.getLabels();
+                inputs[i].colTypes = ft.getColumnTypes();
+                if(inputs[i].labels.size() != inputs[i].colTypes.size())
+                    return;
+                for(const std::string & label : inputs[i].labels)
+                    if(!inputOfLabel.emplace(label, i).second)
+                        return;
+                std::optional<double> n = CardinalityEstimation::numRows(inputs[i].frame);
+                numRows.push_back(n.value_or(-1));
+                allNumRowsKnown &= n.has_value();
+            }
+
+            // the filter of the WHERE clause and its conjuncts
+            for(Operation * user : tree.getUsers())
+                if(auto filterOp = llvm::dyn_cast<daphne::FilterRowOp>(user))
+                    if(filterOp.source() == tree) {
+                        if(filter)
+                            return;
+                        filter = filterOp;
+                    }
+            if(filter && !collectConjuncts())
+                return;
+            Value result = filter ? filter.res() : tree;
+
+            // the equalities of columns of two inputs
+            for(daphne::InnerJoinOp joinOp : joinOps) {
+                auto lhsOn = constantString(joinOp.lhsOn());
+                auto rhsOn = constantString(joinOp.rhsOn());
+                if(!lhsOn || !rhsOn || !inputOfLabel.count(*lhsOn) || !inputOfLabel.count(*rhsOn))
+                    return;
+                edges.push_back({{inputOfLabel[*lhsOn], inputOfLabel[*rhsOn]}, {*lhsOn, *rhsOn}});
+            }
+            std::vector<bool> isEdge(conjuncts.size(), false);
+            bool changed = false;
+            for(size_t k = 0; k < conjuncts.size(); k++) {
+                const Conjunct & c = conjuncts[k];
+                if(!c.isEquality || c.global || c.inputs.size() != 2)
+                    continue;
+                Operation * eqOp = skipCasts(c.value).getDefiningOp();
+                auto lhs = columnOf(eqOp->getOperand(0));
+                auto rhs = columnOf(eqOp->getOperand(1));
+                if(!lhs || !rhs || inputOfLabel[*lhs] == inputOfLabel[*rhs] || colTypeOf(*lhs) != colTypeOf(*rhs)
+                        || colTypeOf(*lhs).isa<daphne::UnknownType>())
+                    continue;
+                edges.push_back({{inputOfLabel[*lhs], inputOfLabel[*rhs]}, {*lhs, *rhs}});
+                isEdge[k] = true;
+                changed = true;
+            }
+
+            // the conjuncts pushed to a single input, and the estimated
+            // numbers of rows of the filtered inputs
+            std::vector<std::vector<size_t>> pushed(numInputs);
+            for(size_t k = 0; k < conjuncts.size(); k++)
+                if(!isEdge[k] && !conjuncts[k].global && conjuncts[k].inputs.size() == 1) {
+                    const size_t i = *conjuncts[k].inputs.begin();
+                    pushed[i].push_back(k);
+                    numRows[i] *= CardinalityEstimation::selectivity(conjuncts[k].value, tree);
+                    changed = true;
+                }
+
+            // the order of the joins
+            std::vector<size_t> order;
+            std::vector<bool> joined(numInputs, false);
+            // whether the input is connected to the joined ones by an
+            // equality, or has any equality for the first input
+            auto isConnected = [&](size_t j) {
+                for(const JoinEdge & e : edges)
+                    for(size_t side = 0; side < 2; side++)
+                        if(e.input[side] == j && (order.empty() || joined[e.input[1 - side]]))
+                            return true;
+                return false;
+            };
+            // the estimated number of rows of the joined inputs and the input
+            // j, by the statistics of the join keys if known, and otherwise
+            // assuming a join on a key of one of them
+            std::vector<std::array<std::optional<ColumnStatistics>, 2>> edgeStats;
+            for(const JoinEdge & e : edges)
+                edgeStats.push_back({CardinalityEstimation::columnStatistics(inputs[e.input[0]].frame, e.label[0]),
+                        CardinalityEstimation::columnStatistics(inputs[e.input[1]].frame, e.label[1])});
+            double joinedRows = 0;
+            auto joinSize = [&](size_t j) {
+                if(order.empty())
+                    return numRows[j];
+                double res = std::max(joinedRows, numRows[j]);
+                for(size_t k = 0; k < edges.size(); k++)
+                    for(size_t side = 0; side < 2; side++)
+                        if(edges[k].input[side] == j && joined[edges[k].input[1 - side]]
+                                && edgeStats[k][0] && edgeStats[k][1])
+                            if(auto size = ColumnStatistics::joinSize(joinedRows, *edgeStats[k][1 - side],
+                                    numRows[j], *edgeStats[k][side]))
+                                res = std::min(res, *size);
+                return res;
+            };
+            const bool byCardinality = allNumRowsKnown && numInputs > 2;
+            while(order.size() < numInputs) {
+                std::optional<size_t> next;
+                // the first connected input in textual order, or the one of the
+                // smallest join (and the fewest rows), and any input if none is
+                // connected
+                for(bool connectedOnly : {byCardinality || !order.empty(), false}) {
+                    for(size_t j = 0; j < numInputs && !(next && !byCardinality); j++)
+                        if(!joined[j] && (!connectedOnly || isConnected(j))
+                                && (!next || std::make_pair(joinSize(j), numRows[j])
+                                        < std::make_pair(joinSize(*next), numRows[*next])))
+                            next = j;
+                    if(next)
+                        break;
+                }
+                if(byCardinality)
+                    joinedRows = joinSize(*next);
+                order.push_back(*next);
+                joined[*next] = true;
+            }
+            for(size_t k = 0; k < numInputs; k++)
+                changed |= order[k] != k;
+
+            // the columns read after the query, if known
+            std::set<std::string> readLabels;
+            std::vector<Operation *> chain;
+            const bool prune = collectReadLabels(result, readLabels, chain);
+            std::set<std::string> neededLabels = readLabels;
+            for(const Conjunct & c : conjuncts)
+                neededLabels.insert(c.labels.begin(), c.labels.end());
+            for(const JoinEdge & e : edges)
+                neededLabels.insert({e.label[0], e.label[1]});
+            std::vector<std::vector<std::string>> keptLabels(numInputs);
+            for(size_t i = 0; i < numInputs; i++) {
+                for(const std::string & label : inputs[i].labels)
+                    if(!prune || neededLabels.count(label))
+                        keptLabels[i].push_back(label);
+                // keep a column for the rows of the input
+                if(keptLabels[i].empty())
+                    keptLabels[i].push_back(inputs[i].labels.front());
+                changed |= keptLabels[i].size() != inputs[i].labels.size();
+            }
+
+            // the conjuncts on several inputs after the first join containing
+            // them, the others at the end
+            std::vector<std::vector<size_t>> after(numInputs);
+            for(size_t k = 0; k < conjuncts.size(); k++) {
+                const Conjunct & c = conjuncts[k];
+                if(isEdge[k] || (!c.global && c.inputs.size() == 1))
+                    continue;
+                size_t step = numInputs - 1;
+                if(!c.global && !c.inputs.empty()) {
+                    step = 0;
+                    for(size_t s = 0; s < numInputs; s++)
+                        if(c.inputs.count(order[s]))
+                            step = s;
+                }
+                after[step].push_back(k);
+                changed |= step != numInputs - 1;
+            }
+            if(!changed)
+                return;
+
+            // ****************************************************************
+            // Rewrite
+            // ****************************************************************
+
+            if(filter)
+                builder.setInsertionPoint(filter);
+            std::vector<Plan> filtered(numInputs);
+            for(size_t i = 0; i < numInputs; i++) {
+                filtered[i] = project(inputs[i], keptLabels[i]);
+                for(size_t k : pushed[i])
+                    filtered[i] = filterBy(filtered[i], copyConjunct(conjuncts[k], filtered[i]));
+            }
+            std::vector<bool> usedEdge(edges.size(), false);
+            std::fill(joined.begin(), joined.end(), false);
+            Plan plan = filtered[order[0]];
+            joined[order[0]] = true;
+            for(size_t k : after[0])
+                plan = filterBy(plan, copyConjunct(conjuncts[k], plan));
+            for(size_t s = 1; s < numInputs; s++) {
+                const size_t j = order[s];
+                const Plan & rhs = filtered[j];
+                std::vector<size_t> stepEdges;
+                for(size_t e = 0; e < edges.size(); e++)
+                    if(!usedEdge[e] && ((edges[e].input[0] == j && joined[edges[e].input[1]])
+                            || (edges[e].input[1] == j && joined[edges[e].input[0]]))) {
+                        stepEdges.push_back(e);
+                        usedEdge[e] = true;
+                    }
+                joined[j] = true;
+                if(stepEdges.empty()) {
+                    Plan product = concat(nullptr, plan, rhs);
+                    product.frame = builder.create<daphne::CartesianOp>(
+                            loc, frameType(product.colTypes), plan.frame, rhs.frame
+                    );
+                    plan = product;
+                }
+                else {
+                    const JoinEdge & key = edges[stepEdges.front()];
+                    const size_t rhsSide = key.input[0] == j ? 0 : 1;
+                    Plan joinedPlan = concat(nullptr, plan, rhs);
+                    joinedPlan.frame = builder.create<daphne::InnerJoinOp>(
+                            loc, frameType(joinedPlan.colTypes), plan.frame, rhs.frame,
+                            builder.create<daphne::ConstantOp>(loc, key.label[1 - rhsSide]),
+                            builder.create<daphne::ConstantOp>(loc, key.label[rhsSide])
+                    );
+                    plan = joinedPlan;
+                    for(size_t e = 1; e < stepEdges.size(); e++)
+                        plan = filterByEquality(plan, edges[stepEdges[e]]);
+                }
+                for(size_t k : after[s])
+                    plan = filterBy(plan, copyConjunct(conjuncts[k], plan));
+            }
+
+            // the columns in the order of the tree (only the read ones, if
+            // known)
+            std::vector<std::string> resultLabels;
+            for(const Plan & input : inputs)
+                for(const std::string & label : input.labels)
+                    if(!prune || readLabels.count(label))
+                        resultLabels.push_back(label);
+            if(!resultLabels.empty())
+                plan = project(plan, resultLabels);
+            std::vector<std::string> treeLabels;
+            for(const Plan & input : inputs)
+                treeLabels.insert(treeLabels.end(), input.labels.begin(), input.labels.end());
+
+            result.replaceAllUsesWith(plan.frame);
+            // The operations passing on the frame get the new columns.
+            if(plan.labels != treeLabels)
+                for(Operation * op : chain) {
+                    std::vector<Type> colTypes = op->getOperand(0).getType().cast<daphne::FrameType>().getColumnTypes();
+                    if(llvm::isa<daphne::ColBindOp>(op)) {
+                        std::vector<Type> rhsColTypes = op->getOperand(1).getType().cast<daphne::FrameType>().getColumnTypes();
+                        colTypes.insert(colTypes.end(), rhsColTypes.begin(), rhsColTypes.end());
+                    }
+                    op->getResult(0).setType(frameType(colTypes));
+                }
+
+            // the old plan, the filter and its conjuncts first
+            if(filter) {
+                filter->erase();
+                std::vector<Operation *> condOps;
+                for(const Conjunct & c : conjuncts)
+                    condOps.insert(condOps.end(), c.ops.begin(), c.ops.end());
+                std::sort(condOps.begin(), condOps.end(), [](Operation * a, Operation * b) { return b->isBeforeInBlock(a); });
+                condOps.erase(std::unique(condOps.begin(), condOps.end()), condOps.end());
+                for(Operation * op : condOps)
+                    if(op->use_empty())
+                        op->erase();
+            }
+            for(Operation * op : treeOps)
+                if(op->use_empty())
+                    op->erase();
+        }
+    };
+}
+
+void OptimizeSqlPass::runOnFunction() {
+    auto func = getFunction();
+
+    // the roots of the trees of cartesian products and inner joins
+    std::vector<Operation *> roots;
+    func->walk([&](Operation * op) {
+        if(!llvm::isa<daphne::CartesianOp, daphne::InnerJoinOp>(op))
+            return;
+        for(Operation * user : op->getUsers())
+            if(llvm::isa<daphne::CartesianOp, daphne::InnerJoinOp>(user))
+                return;
+        roots.push_back(op);
+    });
+    for(Operation * root : roots)
+        QueryOptimizer(root).optimize();
+}
+
+std::unique_ptr<Pass> daphne::createOptimizeSqlPass() {
+    return std::make_unique<OptimizeSqlPass>();
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+#include <runtime/local/datastructures/BufferPool.h>
+
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/Dialect/SCF/SCF.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/DenseMap.h>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Plans the memory of the intermediates based on their liveness, after
+ * `ManageObjRefsPass` inserted the reference management.
+ *
+ * - Reference transfers: `ManageObjRefsPass` increases the reference of each
+ *   data object passed to a loop, function call, or cast that does not call a
+ *   kernel, and decreases the reference of the value after its last use. If
+ *   this op is the last use, the `IncRefOp` right before it and the `DecRefOp`
+ *   right after it cancel out, i.e., the op takes over the reference of the
+ *   value. Removing both saves two kernel calls, frees the data object as soon
+ *   as the callee or loop drops it, and lets the first iteration of a loop
+ *   update its arguments in place (see `MarkLastUseOp`).
+ * - Buffer slots of loop bodies: The dense intermediates of a static shape in
+ *   a loop body live from their definition to their `DecRefOp` (or across the
+ *   iteration, if they are yielded). Assigning them to buffers of their size
+ *   like a linear scan, the greatest number of such intermediates live at the
+ *   same time is the number of buffers the loop needs per size.
+ * - Buffer reuse hints: For each size of at least
+ *   `BufferPool::MIN_POOLED_BYTES`, a `ReserveBuffersOp` before the loop and a
+ *   `ReleaseBuffersOp` after it make the buffer pool keep that many arrays of
+ *   this size while the loop runs, even beyond its maximum size, such that
+ *   the kernels of every iteration get the arrays of the previous one instead
+ *   of fresh memory.
+ */
+struct PlanMemoryPass : public PassWrapper<PlanMemoryPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+// whether the op takes over a reference of each data object it is passed, see ManageObjRefsPass
+static bool consumesRefs(Operation * op) {
+    if(auto co = dyn_cast<daphne::CastOp>(op))
+        return co.isTrivialCast() || co.isMatrixPropertyCast() || co.isFramePropertyCast();
+    return isa<scf::WhileOp, scf::ForOp, CallOp, daphne::GenericCallOp, daphne::AdaptiveCallOp>(op);
+}
+
+// whether the value is used inside the regions of the op, where it must outlive the op's reference
+static bool isUsedInRegions(Value v, Operation * op) {
+    for(Operation * user : v.getUsers())
+        if(user != op && op->isProperAncestor(user))
+            return true;
+    return false;
+}
+
+/**
+ * @brief Removes the `IncRefOp`s right before the given op that are cancelled
+ * out by a `DecRefOp` right after it.
+ */
+static void elideRefTransfers(Operation * op) {
+    // the IncRefOps and DecRefOps inserted for the op are contiguous around it
+    std::vector<daphne::IncRefOp> incRefs;
+    for(Operation * prev = op->getPrevNode(); prev; prev = prev->getPrevNode()) {
+        auto incRef = dyn_cast<daphne::IncRefOp>(prev);
+        if(!incRef)
+            break;
+        incRefs.push_back(incRef);
+    }
+    std::vector<daphne::DecRefOp> decRefs;
+    for(Operation * next = op->getNextNode(); next; next = next->getNextNode()) {
+        auto decRef = dyn_cast<daphne::DecRefOp>(next);
+        if(!decRef)
+            break;
+        decRefs.push_back(decRef);
+    }
+
+    for(daphne::IncRefOp incRef : incRefs) {
+        Value v = incRef.arg();
+        if(llvm::count(op->getOperands(), v) != 1 || isUsedInRegions(v, op))
+            continue;
+        auto itDec = llvm::find_if(decRefs, [&](daphne::DecRefOp decRef) { return decRef.arg() == v; });
+        if(itDec == decRefs.end())
+            continue;
+        incRef->erase();
+        itDec->erase();
+        decRefs.erase(itDec);
+    }
+}
+
+// the bytes of the values of a dense matrix of a static shape, or 0
+static size_t staticBytes(Type t) {
+    auto mt = t.dyn_cast<daphne::MatrixType>();
+    if(!mt || mt.getNumRows() < 0 || mt.getNumCols() < 0
+            || mt.getRepresentation() != daphne::MatrixRepresentation::Dense)
+        return 0;
+    Type et = mt.getElementType();
+    if(!et.isIntOrFloat())
+        return 0;
+    return static_cast<size_t>(mt.getNumRows()) * mt.getNumCols() * ((et.getIntOrFloatBitWidth() + 7) / 8);
+}
+
+// whether the results of the op are data objects of their own (not the ones of its operands or regions)
+static bool allocatesResults(Operation * op) {
+    if(auto co = dyn_cast<daphne::CastOp>(op))
+        return !(co.isTrivialCast() || co.isMatrixPropertyCast() || co.isFramePropertyCast());
+    return !isa<scf::IfOp, scf::ForOp, scf::WhileOp>(op);
+}
+
+/**
+ * @brief Adds the greatest number of dense intermediates of each size live at
+ * the same time in the given block to `numBuffers` (as the maximum with the
+ * number already there).
+ */
+static void planBuffers(Block & block, std::map<size_t, size_t> & numBuffers) {
+    // the ops by their position in the block
+    llvm::DenseMap<Operation *, size_t> pos;
+    size_t numOps = 0;
+    for(Operation & op : block)
+        pos[&op] = numOps++;
+
+    // the live ranges [begin, end) of the intermediates by their size
+    std::map<size_t, std::vector<std::pair<size_t, size_t>>> ranges;
+    auto addRange = [&](Value v, size_t begin) {
+        const size_t numBytes = staticBytes(v.getType());
+        if(numBytes < BufferPool::MIN_POOLED_BYTES)
+            return;
+        // Values are freed by their DecRefOp, or taken over by their last user (see elideRefTransfers()), or
+        // yielded, such that they live until the end of the iteration.
+        size_t end = begin + 1;
+        for(Operation * user : v.getUsers()) {
+            Operation * op = block.findAncestorOpInBlock(*user);
+            if(!op)
+                continue;
+            if(isa<daphne::DecRefOp>(user))
+                end = std::max(end, pos[op]);
+            else
+                end = std::max(end, op->hasTrait<OpTrait::IsTerminator>() ? numOps : pos[op] + 1);
+        }
+        ranges[numBytes].push_back({begin, end});
+    };
+    // the arguments of the block hold the buffers yielded by the previous iteration
+    for(BlockArgument arg : block.getArguments())
+        addRange(arg, 0);
+    for(Operation & op : block)
+        if(allocatesResults(&op))
+            for(Value v : op.getResults())
+                addRange(v, pos[&op]);
+
+    // A linear scan over the ranges sorted by their begin assigns each one a
+    // free buffer of its size, the number of buffers is the greatest overlap.
+    for(auto & entry : ranges) {
+        std::vector<std::pair<size_t, size_t>> & rs = entry.second;
+        std::sort(rs.begin(), rs.end());
+        std::vector<size_t> busyUntil; // the end of the range in each buffer
+        for(auto & r : rs) {
+            auto free = std::find_if(busyUntil.begin(), busyUntil.end(), [&](size_t end) { return end <= r.first; });
+            if(free != busyUntil.end())
+                *free = r.second;
+            else
+                busyUntil.push_back(r.second);
+        }
+        size_t & num = numBuffers[entry.first];
+        num = std::max(num, busyUntil.size());
+    }
+}
+
+/**
+ * @brief Inserts the buffer reuse hints around the given loop.
+ */
+static void hintBuffers(Operation * loop) {
+    std::map<size_t, size_t> numBuffers;
+    for(Region & r : loop->getRegions())
+        for(Block & b : r.getBlocks())
+            planBuffers(b, numBuffers);
+    if(numBuffers.empty())
+        return;
+
+    OpBuilder builder(loop);
+    Location loc = loop->getLoc();
+    std::vector<std::pair<Value, Value>> hints;
+    for(auto & entry : numBuffers)
+        hints.push_back({
+            builder.create<daphne::ConstantOp>(loc, builder.getIndexAttr(entry.first)),
+            builder.create<daphne::ConstantOp>(loc, builder.getIndexAttr(entry.second))
+        });
+    for(auto & hint : hints)
+        builder.create<daphne::ReserveBuffersOp>(loc, hint.first, hint.second);
+    builder.setInsertionPointAfter(loop);
+    for(auto & hint : hints)
+        builder.create<daphne::ReleaseBuffersOp>(loc, hint.first, hint.second);
+}
+
+void PlanMemoryPass::runOnFunction() {
+    std::vector<Operation *> consumers;
+    std::vector<Operation *> loops;
+    getFunction()->walk([&](Operation * op) {
+        if(op->getParentOfType<daphne::VectorizedPipelineOp>())
+            return;
+        if(consumesRefs(op))
+            consumers.push_back(op);
+        if(isa<scf::ForOp, scf::WhileOp>(op))
+            loops.push_back(op);
+    });
+    for(Operation * op : consumers)
+        elideRefTransfers(op);
+    for(Operation * loop : loops)
+        hintBuffers(loop);
+}
+
+std::unique_ptr<Pass> daphne::createPlanMemoryPass() {
+    return std::make_unique<PlanMemoryPass>();
+}
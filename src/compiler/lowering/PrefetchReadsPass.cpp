@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/AsyncReads.h>
+
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+#include <optional>
+
+using namespace mlir;
+
+/**
+ * @brief Inserts a `PrefetchReadOp` for each `ReadOp` as early as possible in
+ * its block, such that the file is read in the background while the
+ * preceding operations compute.
+ *
+ * The prefetch is placed after the definition of the file name and after the
+ * last operation that might write files, i.e., a `WriteOp` or a call of a
+ * function (or an operation containing one of them in its regions), such
+ * that the read sees the same file. Reads without any computation to overlap
+ * with are left alone.
+ */
+struct PrefetchReadsPass : public PassWrapper<PrefetchReadsPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+// whether the op might write a file the read of which it precedes
+static bool mightWriteFiles(Operation * op) {
+    return op->walk([](Operation * nested) {
+        if(llvm::isa<daphne::WriteOp, daphne::GenericCallOp>(nested))
+            return WalkResult::interrupt();
+        return WalkResult::advance();
+    }).wasInterrupted();
+}
+
+static std::optional<ValueTypeCode> valueTypeCodeOf(Type t) {
+    if(t.isF64()) return ValueTypeCode::F64;
+    if(t.isF32()) return ValueTypeCode::F32;
+    if(t.isSignedInteger(8)) return ValueTypeCode::SI8;
+    if(t.isSignedInteger(32)) return ValueTypeCode::SI32;
+    if(t.isSignedInteger(64)) return ValueTypeCode::SI64;
+    if(t.isUnsignedInteger(8)) return ValueTypeCode::UI8;
+    if(t.isUnsignedInteger(32)) return ValueTypeCode::UI32;
+    if(t.isUnsignedInteger(64)) return ValueTypeCode::UI64;
+    return std::nullopt;
+}
+
+void PrefetchReadsPass::runOnFunction() {
+    getFunction()->walk([&](daphne::ReadOp readOp) {
+        if(readOp->getParentOfType<daphne::VectorizedPipelineOp>())
+            return;
+
+        // the data and value type of the result, as the read kernel sees them
+        AsyncReadDataType dataType;
+        int64_t valueType = -1;
+        Type resTy = readOp.res().getType();
+        if(resTy.isa<daphne::FrameType>())
+            dataType = AsyncReadDataType::Frame;
+        else if(auto matTy = resTy.dyn_cast<daphne::MatrixType>()) {
+            auto vtc = valueTypeCodeOf(matTy.getElementType());
+            if(!vtc)
+                return;
+            valueType = static_cast<int64_t>(*vtc);
+            dataType = matTy.getRepresentation() == daphne::MatrixRepresentation::Sparse
+                    ? AsyncReadDataType::CSRMatrix : AsyncReadDataType::DenseMatrix;
+        }
+        else
+            return;
+
+        // the prefetch goes after the last op before the read that defines the file name or might write files
+        Block * block = readOp->getBlock();
+        Operation * fileNameDef = readOp.fileName().getDefiningOp();
+        Operation * after = nullptr;
+        bool overlaps = false;
+        for(Operation * op = readOp->getPrevNode(); op; op = op->getPrevNode()) {
+            if(op == fileNameDef || mightWriteFiles(op)) {
+                after = op;
+                break;
+            }
+            overlaps |= !llvm::isa<daphne::ConstantOp>(op);
+        }
+        if(!overlaps)
+            return;
+
+        OpBuilder builder(&getContext());
+        if(after)
+            builder.setInsertionPointAfter(after);
+        else
+            builder.setInsertionPointToStart(block);
+        Location loc = readOp->getLoc();
+        builder.create<daphne::PrefetchReadOp>(
+                loc,
+                readOp.fileName(),
+                builder.create<daphne::ConstantOp>(loc, static_cast<int64_t>(dataType)),
+                builder.create<daphne::ConstantOp>(loc, valueType)
+        );
+    });
+}
+
+std::unique_ptr<Pass> daphne::createPrefetchReadsPass() {
+    return std::make_unique<PrefetchReadsPass>();
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compiler/CompilerUtils.h>
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Surrounds each kernel call by the hooks of the KernelProfiler (see
+ * ProfileKernel.h), which record its time, the shapes of its inputs and
+ * outputs, the bytes it allocates, and optionally its cycles and cache misses
+ * per source location of the DaphneDSL statement it belongs to.
+ *
+ * Vectorized pipelines are profiled as a whole, not the kernels of their
+ * tasks. The report of the profile is inserted at the end of `main`.
+ *
+ * This pass runs after the RewriteToCallKernelOpPass, such that the hooks
+ * surround the kernel calls as they are executed, including the ones of the
+ * reference counting. The ops annotated with cost estimates (see
+ * EstimateCostsPass) pass them to the profiler, too.
+ */
+struct ProfileKernelsPass : public PassWrapper<ProfileKernelsPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+static bool isStructure(Type t) {
+    return t.isa<daphne::MatrixType, daphne::FrameType>();
+}
+
+void ProfileKernelsPass::runOnFunction() {
+    FuncOp func = getFunction();
+
+    // The ops to profile are collected first, since the hooks are kernel calls, too.
+    std::vector<Operation *> ops;
+    daphne::CallKernelOp destroyCtx;
+    func->walk([&](Operation * op) {
+        if(op->getParentOfType<daphne::VectorizedPipelineOp>())
+            return;
+        if(auto cko = llvm::dyn_cast<daphne::CallKernelOp>(op)) {
+            if(cko.getCalleeAttr().getValue() == "_destroyDaphneContext")
+                destroyCtx = cko;
+            // all kernels except for the creation of the DaphneContext take it as the last argument
+            else if(cko->getNumOperands() && cko->getOperands().back().getType().isa<daphne::DaphneContextType>())
+                ops.push_back(op);
+        }
+        else if(llvm::isa<daphne::VectorizedPipelineOp>(op))
+            ops.push_back(op);
+    });
+
+    OpBuilder builder(&getContext());
+    auto strTy = daphne::StringType::get(&getContext());
+    for(Operation * op : ops) {
+        Location loc = op->getLoc();
+        Value dctx;
+        std::string kernel;
+        if(auto vpo = llvm::dyn_cast<daphne::VectorizedPipelineOp>(op)) {
+            dctx = vpo.ctx();
+            kernel = "vectorizedPipeline";
+        }
+        else {
+            dctx = op->getOperands().back();
+            kernel = llvm::cast<daphne::CallKernelOp>(op).getCalleeAttr().getValue().str();
+        }
+        if(!dctx)
+            continue;
+
+        builder.setInsertionPoint(op);
+        for(Value arg : op->getOperands())
+            if(isStructure(arg.getType()))
+                builder.create<daphne::CallKernelOp>(loc, "_profileKernelInput__Structure", ValueRange{arg, dctx});
+        // the estimates of the EstimateCostsPass, if any, for the roofline analysis of the profile
+        auto flops = op->getAttrOfType<FloatAttr>(daphne::ATTR_COST_FLOPS);
+        auto bytesRead = op->getAttrOfType<FloatAttr>(daphne::ATTR_COST_BYTES_READ);
+        auto bytesWritten = op->getAttrOfType<FloatAttr>(daphne::ATTR_COST_BYTES_WRITTEN);
+        if(flops && bytesRead && bytesWritten)
+            builder.create<daphne::CallKernelOp>(
+                    loc, "_profileKernelCost__double__double__double", ValueRange{
+                        builder.create<daphne::ConstantOp>(loc, flops.getValueAsDouble()),
+                        builder.create<daphne::ConstantOp>(loc, bytesRead.getValueAsDouble()),
+                        builder.create<daphne::ConstantOp>(loc, bytesWritten.getValueAsDouble()),
+                        dctx
+                    }
+            );
+        Value kernelStr = builder.create<daphne::ConstantOp>(loc, strTy, builder.getStringAttr(kernel));
+        Value locationStr = builder.create<daphne::ConstantOp>(
+                loc, strTy, builder.getStringAttr(CompilerUtils::getLocationString(loc))
+        );
+        builder.create<daphne::CallKernelOp>(
+                loc, "_profileKernelBegin__char__char", ValueRange{kernelStr, locationStr, dctx}
+        );
+
+        builder.setInsertionPointAfter(op);
+        builder.create<daphne::CallKernelOp>(loc, "_profileKernelEnd", ValueRange{dctx});
+        for(Value res : op->getResults())
+            if(isStructure(res.getType()))
+                builder.create<daphne::CallKernelOp>(loc, "_profileKernelOutput__Structure", ValueRange{res, dctx});
+    }
+
+    if(func.getName() == "main" && destroyCtx) {
+        builder.setInsertionPoint(destroyCtx);
+        builder.create<daphne::CallKernelOp>(
+                destroyCtx.getLoc(), "_profileKernelReport", ValueRange{destroyCtx->getOperands().back()}
+        );
+    }
+}
+
+std::unique_ptr<Pass> daphne::createProfileKernelsPass() {
+    return std::make_unique<ProfileKernelsPass>();
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+#include <runtime/local/datastructures/LabelUtils.h>
+
+#include <mlir/IR/Dominance.h>
+#include <mlir/Pass/Pass.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Filters the larger input of each `innerJoin` and `semiJoin` with a
+ * much smaller or filtered input (e.g., a selective dimension joined with a
+ * fact table) by a Bloom filter of the keys of the smaller one, as early as
+ * possible, such that the rows without a match are dropped before later
+ * operations materialize them (sideways information passing).
+ *
+ * The `buildBloomFilter` of the smaller input is probed on the rows of the
+ * larger one (`probeBloomFilter`) where they come from: the filter is pushed
+ * down through the operations keeping the key column and the order of the
+ * rows, i.e., `extractCol`, `setColLabels`, `setColLabelsPrefix`, and the
+ * other input of an `innerJoin` owning the key column, as long as no other
+ * operation uses their results and the smaller input is computed before
+ * them. If it reaches a `filterRow`, its selection is multiplied by the
+ * probed one. Otherwise, a new `filterRow` filters the rows at the scan or
+ * operation it reached.
+ *
+ * An input is much smaller if it has at most a quarter of the rows of the
+ * other one, if both are known, or otherwise if it is the result of a
+ * filter. The key columns must have the same known value type. Since the
+ * rows without a match do not contribute to the join, its result does not
+ * change. A `semiJoin` is only filtered if the positions of the rows of its
+ * larger input are not used, since they would refer to the filtered rows.
+ */
+struct PushDownBloomFiltersPass : public PassWrapper<PushDownBloomFiltersPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+namespace {
+    // the maximum ratio of the rows of the smaller input to those of the larger one
+    constexpr double MAX_BUILD_RATIO = 0.25;
+
+    std::optional<std::string> constantString(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto strAttr = co.value().dyn_cast<StringAttr>())
+                return strAttr.getValue().str();
+        return std::nullopt;
+    }
+
+    // The position of a label of a frame, if the labels are known and the label is unique.
+    std::optional<size_t> labelIdx(Value frame, const std::string & label) {
+        auto ft = frame.getType().dyn_cast<daphne::FrameType>();
+        if(!ft || !ft.getLabels())
+            return std::nullopt;
+        const std::vector<std::string> & labels = *ft.getLabels();
+        if(std::count(labels.begin(), labels.end(), label) != 1)
+            return std::nullopt;
+        return std::find(labels.begin(), labels.end(), label) - labels.begin();
+    }
+
+    // The value type of the column of a frame of the given label, if it is known and a key the kernels hash.
+    std::optional<Type> keyType(Value frame, const std::string & label) {
+        std::optional<size_t> idx = labelIdx(frame, label);
+        if(!idx)
+            return std::nullopt;
+        Type t = frame.getType().cast<daphne::FrameType>().getColumnTypes()[*idx];
+        if(!t.isIntOrFloat() && !t.isa<daphne::StringType>())
+            return std::nullopt;
+        return t;
+    }
+
+    // Whether the rows of a frame are a subset of the rows of another one selected by a predicate.
+    bool isFiltered(Value frame) {
+        for(;;) {
+            Operation * op = frame.getDefiningOp();
+            if(llvm::isa_and_nonnull<daphne::FilterRowOp, daphne::SemiJoinOp, daphne::FilterGroupOp>(op))
+                return true;
+            if(auto extractOp = llvm::dyn_cast_or_null<daphne::ExtractColOp>(op))
+                frame = extractOp.source();
+            else if(auto labelsOp = llvm::dyn_cast_or_null<daphne::SetColLabelsOp>(op))
+                frame = labelsOp.arg();
+            else if(auto prefixOp = llvm::dyn_cast_or_null<daphne::SetColLabelsPrefixOp>(op))
+                frame = prefixOp.arg();
+            else
+                return false;
+        }
+    }
+
+    // Whether the build input is much smaller than the probed one (see above).
+    bool isMuchSmaller(Value build, Value probed) {
+        const ssize_t numRowsBuild = build.getType().cast<daphne::FrameType>().getNumRows();
+        const ssize_t numRowsProbed = probed.getType().cast<daphne::FrameType>().getNumRows();
+        if(numRowsBuild != -1 && numRowsProbed != -1)
+            return numRowsBuild <= MAX_BUILD_RATIO * numRowsProbed;
+        return isFiltered(build);
+    }
+
+    // The frame an operation on the rows of a frame computes its result from, and the label of the given column
+    // of the result in it, if the rows of the result are a subsequence of the rows of that frame, whose values of
+    // the column are the values of the column of the result.
+    std::optional<std::pair<Value, std::string>> sourceOf(Operation * op, Value res, const std::string & label) {
+        auto ftRes = res.getType().dyn_cast<daphne::FrameType>();
+        if(!ftRes || !ftRes.getLabels())
+            return std::nullopt;
+        if(auto extractOp = llvm::dyn_cast<daphne::ExtractColOp>(op)) {
+            if(extractOp.source().getType().isa<daphne::FrameType>() && labelIdx(extractOp.source(), label))
+                return std::make_pair(extractOp.source(), label);
+        }
+        else if(auto labelsOp = llvm::dyn_cast<daphne::SetColLabelsOp>(op)) {
+            std::optional<size_t> idx = labelIdx(res, label);
+            auto ftArg = labelsOp.arg().getType().dyn_cast<daphne::FrameType>();
+            if(idx && ftArg && ftArg.getLabels() && *idx < ftArg.getLabels()->size())
+                return std::make_pair(labelsOp.arg(), (*ftArg.getLabels())[*idx]);
+        }
+        else if(auto prefixOp = llvm::dyn_cast<daphne::SetColLabelsPrefixOp>(op)) {
+            std::optional<std::string> prefix = constantString(prefixOp.prefix());
+            auto ftArg = prefixOp.arg().getType().dyn_cast<daphne::FrameType>();
+            if(!prefix || !ftArg || !ftArg.getLabels())
+                return std::nullopt;
+            std::optional<std::string> argLabel;
+            for(const std::string & l : *ftArg.getLabels())
+                if(LabelUtils::setPrefix(*prefix, l) == label) {
+                    if(argLabel)
+                        return std::nullopt;
+                    argLabel = l;
+                }
+            if(argLabel)
+                return std::make_pair(prefixOp.arg(), *argLabel);
+        }
+        else if(auto joinOp = llvm::dyn_cast<daphne::InnerJoinOp>(op)) {
+            // the rows of an input without a match in the other one do not contribute to the result
+            const bool inLhs = labelIdx(joinOp.lhs(), label).has_value();
+            const bool inRhs = labelIdx(joinOp.rhs(), label).has_value();
+            if(inLhs != inRhs)
+                return std::make_pair(inLhs ? joinOp.lhs() : joinOp.rhs(), label);
+        }
+        return std::nullopt;
+    }
+
+    class BloomFilterPusher {
+        MLIRContext & ctx;
+        DominanceInfo & domInfo;
+
+    public:
+        BloomFilterPusher(MLIRContext & ctx, DominanceInfo & domInfo) : ctx(ctx), domInfo(domInfo) {}
+
+        /**
+         * @brief Filters the rows of the frame `probed` used by `user` without a match of the column `probedOn`
+         * in the column `buildOn` of `build`, as early as possible. Returns whether it was filtered.
+         */
+        bool push(Operation * user, Value probed, const std::string & probedOn, Value build,
+                const std::string & buildOn) {
+            if(probed == build || !isMuchSmaller(build, probed))
+                return false;
+            std::optional<Type> typeProbed = keyType(probed, probedOn);
+            std::optional<Type> typeBuild = keyType(build, buildOn);
+            if(!typeProbed || !typeBuild || *typeProbed != *typeBuild)
+                return false;
+
+            // The rows of probed are filtered before user, or the ones the operation computing it reads, as long
+            // as no other operation sees them and the build input is computed before.
+            Value frame = probed;
+            std::string label = probedOn;
+            Block * block = user->getBlock();
+            for(;;) {
+                Operation * def = frame.getDefiningOp();
+                if(!def || def->getBlock() != block || !frame.hasOneUse() || !domInfo.properlyDominates(build, def))
+                    break;
+                if(auto filterOp = llvm::dyn_cast<daphne::FilterRowOp>(def)) {
+                    auto selTy = filterOp.selectedRows().getType().dyn_cast<daphne::MatrixType>();
+                    if(filterOp.source().getType().isa<daphne::FrameType>() && selTy
+                            && (selTy.getElementType().isF64() || selTy.getElementType().isSignedInteger(64))) {
+                        combine(filterOp, label, build, buildOn);
+                        return true;
+                    }
+                    break;
+                }
+                auto source = sourceOf(def, frame, label);
+                if(!source)
+                    break;
+                user = def;
+                std::tie(frame, label) = *source;
+            }
+            insert(user, frame, label, build, buildOn);
+            return true;
+        }
+
+    private:
+        Value probe(OpBuilder & builder, Location loc, Type selVt, Value frame, const std::string & label,
+                Value build, const std::string & buildOn) {
+            Value filter = builder.create<daphne::BuildBloomFilterOp>(
+                    loc, daphne::MatrixType::get(&ctx, builder.getIntegerType(64, false)),
+                    build, builder.create<daphne::ConstantOp>(loc, buildOn)
+            );
+            return builder.create<daphne::ProbeBloomFilterOp>(
+                    loc, daphne::MatrixType::get(&ctx, selVt),
+                    frame, builder.create<daphne::ConstantOp>(loc, label), filter
+            );
+        }
+
+        // Selects only the rows of the filter that may have a match.
+        void combine(daphne::FilterRowOp filterOp, const std::string & label, Value build,
+                const std::string & buildOn) {
+            OpBuilder builder(filterOp);
+            Location loc = filterOp->getLoc();
+            Value sel = filterOp.selectedRows();
+            auto selTy = sel.getType().cast<daphne::MatrixType>();
+            Value probed = probe(builder, loc, selTy.getElementType(), filterOp.source(), label, build, buildOn);
+            Value both = builder.create<daphne::EwMulOp>(loc, selTy.withShape(-1, -1).withSparsity(-1), sel, probed);
+            filterOp->setOperand(1, both);
+        }
+
+        // Filters the rows of the frame used by user that may have a match.
+        void insert(Operation * user, Value frame, const std::string & label, Value build,
+                const std::string & buildOn) {
+            OpBuilder builder(user);
+            Location loc = user->getLoc();
+            Value probed = probe(builder, loc, builder.getIntegerType(64, true), frame, label, build, buildOn);
+            auto ft = frame.getType().cast<daphne::FrameType>();
+            Value filtered = builder.create<daphne::FilterRowOp>(
+                    loc, ft.withShape(-1, ft.getNumCols()), frame, probed
+            );
+            user->replaceUsesOfWith(frame, filtered);
+        }
+    };
+}
+
+void PushDownBloomFiltersPass::runOnFunction() {
+    std::vector<Operation *> joinOps;
+    getFunction()->walk([&](Operation * op) {
+        if(llvm::isa<daphne::InnerJoinOp, daphne::SemiJoinOp>(op))
+            joinOps.push_back(op);
+    });
+
+    DominanceInfo domInfo(getFunction());
+    BloomFilterPusher pusher(getContext(), domInfo);
+    for(Operation * op : joinOps) {
+        std::optional<std::string> lhsOn = constantString(op->getOperand(2));
+        std::optional<std::string> rhsOn = constantString(op->getOperand(3));
+        Value lhs = op->getOperand(0);
+        Value rhs = op->getOperand(1);
+        if(!lhsOn || !rhsOn || !lhs.getType().isa<daphne::FrameType>() || !rhs.getType().isa<daphne::FrameType>())
+            continue;
+        if(auto semiJoinOp = llvm::dyn_cast<daphne::SemiJoinOp>(op)) {
+            if(semiJoinOp.lhsTids().use_empty())
+                pusher.push(op, lhs, *lhsOn, rhs, *rhsOn);
+        }
+        else if(!pusher.push(op, lhs, *lhsOn, rhs, *rhsOn))
+            pusher.push(op, rhs, *rhsOn, lhs, *lhsOn);
+    }
+}
+
+std::unique_ptr<Pass> daphne::createPushDownBloomFiltersPass() {
+    return std::make_unique<PushDownBloomFiltersPass>();
+}
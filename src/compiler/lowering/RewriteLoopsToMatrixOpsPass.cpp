@@ -0,0 +1,443 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compiler/CompilerUtils.h>
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Dialect/SCF/SCF.h>
+#include <mlir/IR/BlockAndValueMapping.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/DenseMap.h>
+
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+using namespace mlir;
+
+/**
+ * @brief Rewrites for-loops that compute each row of their results from the
+ * same row of their inputs into whole-matrix operations.
+ *
+ * A loop like `for(i in 0:n - 1) { y[i, 0] = x[i, 0] * a + b; }` calls a
+ * kernel for each slice, elementwise operation, and insertion of each
+ * iteration. If the body only
+ * - reads the rows `i + c` (or columns thereof) of matrices defined before
+ *   the loop, for constants `c`,
+ * - computes elementwise operations on these rows and loop-invariant scalars,
+ * - and writes the results to the rows `i + c` (or columns thereof) of the
+ *   variables updated in the loop, which it reads at most at the same rows
+ *   before,
+ * then the iterations do not depend on each other, and the loop is replaced
+ * by the same operations on the slices of all rows the loop visits, which
+ * are a single kernel call each (and vectorizable). The induction variable is
+ * `d * iv` of the `ForOp`'s `iv`, where `d` is the counting direction, such
+ * that the visited rows are `[min(d * lb, d * (ub - 1)), max(...) + 1)` if the
+ * step of the `ForOp` is one. The operations are guarded by an `IfOp` for
+ * loops without iterations.
+ *
+ * With `explain`, the loops that are not rewritten are reported along with
+ * the reason.
+ */
+struct RewriteLoopsToMatrixOpsPass : public PassWrapper<RewriteLoopsToMatrixOpsPass, FunctionPass> {
+    bool explain;
+
+    explicit RewriteLoopsToMatrixOpsPass(bool explain) : explain(explain) {}
+
+    void runOnFunction() final;
+};
+
+namespace {
+    // What a value in the body of the loop is with respect to its iterations.
+    enum class Kind {
+        Invariant, // the same in all iterations
+        LoopVar,   // the induction variable, possibly cast
+        Position,  // the row position d * iv + offset, possibly cast
+        Rows,      // the rows of matrices at the positions, or an elementwise function of them
+        Variable,  // a variable updated in the loop, at the beginning of the iteration
+        Written,   // a variable updated in the loop, whose rows at the position + offset were overwritten
+    };
+
+    struct Info {
+        Kind kind;
+        int64_t offset = 0;
+    };
+
+    class LoopAnalysis {
+        scf::ForOp loop;
+        llvm::DenseMap<Value, Info> infos;
+
+    public:
+        // the counting direction `d`
+        Value dir;
+        // why the loop cannot be rewritten (empty if it can)
+        std::string reason;
+
+        explicit LoopAnalysis(scf::ForOp loop) : loop(loop) {}
+
+        bool analyze();
+        void rewrite();
+
+    private:
+        bool fail(Operation * op, const std::string & why) {
+            std::stringstream s;
+            s << why;
+            if(op)
+                s << " (" << op->getName().getStringRef().str() << " @ "
+                        << CompilerUtils::getLocationString(op->getLoc()) << ")";
+            reason = s.str();
+            return false;
+        }
+
+        Info info(Value v) {
+            auto it = infos.find(v);
+            if(it != infos.end())
+                return it->second;
+            return {Kind::Invariant}; // defined before the loop
+        }
+
+        bool analyzeOp(Operation * op);
+        bool checkUpdates();
+    };
+}
+
+static bool isEwiseOp(Operation * op) {
+    return llvm::isa<
+            daphne::EwAddOp, daphne::EwSubOp, daphne::EwMulOp, daphne::EwDivOp, daphne::EwPowOp,
+            daphne::EwModOp, daphne::EwLogOp, daphne::EwMinOp, daphne::EwMaxOp,
+            daphne::EwEqOp, daphne::EwNeqOp, daphne::EwLtOp, daphne::EwLeOp, daphne::EwGtOp, daphne::EwGeOp,
+            daphne::EwAndOp, daphne::EwOrOp,
+            daphne::EwMinusOp, daphne::EwAbsOp, daphne::EwSignOp, daphne::EwExpOp, daphne::EwLnOp, daphne::EwSqrtOp,
+            daphne::EwNegOp, daphne::EwRoundOp, daphne::EwFloorOp, daphne::EwCeilOp,
+            daphne::EwSinOp, daphne::EwCosOp, daphne::EwTanOp, daphne::EwSinhOp, daphne::EwCoshOp, daphne::EwTanhOp,
+            daphne::EwAsinOp, daphne::EwAcosOp, daphne::EwAtanOp
+    >(op);
+}
+
+// the value of an integer constant, also if it was cast
+static std::optional<int64_t> constantInt(Value v) {
+    while(auto castOp = v.getDefiningOp<daphne::CastOp>())
+        v = castOp.arg();
+    if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+        if(auto intAttr = co.value().dyn_cast<IntegerAttr>())
+            return intAttr.getValue().getSExtValue();
+    return std::nullopt;
+}
+
+static bool isIntOrIndex(Type t) {
+    return t.isa<IntegerType, IndexType>();
+}
+
+bool LoopAnalysis::analyzeOp(Operation * op) {
+    auto setAll = [&](Info i) {
+        for(Value res : op->getResults())
+            infos[res] = i;
+        return true;
+    };
+    if(op->getNumRegions())
+        return fail(op, "contains control flow");
+
+    // Positions: casts and constant offsets of d * iv.
+    if(auto co = llvm::dyn_cast<daphne::CastOp>(op)) {
+        Info i = info(co.arg());
+        if(i.kind == Kind::LoopVar || i.kind == Kind::Position) {
+            if(!isIntOrIndex(co.getType()))
+                return fail(op, "uses the loop variable other than as a row position");
+            return setAll(i);
+        }
+    }
+    if(auto mulOp = llvm::dyn_cast<daphne::EwMulOp>(op)) {
+        Value lhs = mulOp.lhs();
+        Value rhs = mulOp.rhs();
+        if(info(rhs).kind == Kind::LoopVar)
+            std::swap(lhs, rhs);
+        if(info(lhs).kind == Kind::LoopVar && info(rhs).kind == Kind::Invariant) {
+            if((dir && dir != rhs) || loop.getLoopBody().isAncestor(rhs.getParentRegion()))
+                return fail(op, "uses the loop variable other than as a row position");
+            dir = rhs;
+            return setAll({Kind::Position, 0});
+        }
+    }
+    if(llvm::isa<daphne::EwAddOp, daphne::EwSubOp>(op)) {
+        Value lhs = op->getOperand(0);
+        Value rhs = op->getOperand(1);
+        int64_t sign = llvm::isa<daphne::EwSubOp>(op) ? -1 : 1;
+        if(sign == 1 && info(rhs).kind == Kind::Position)
+            std::swap(lhs, rhs);
+        if(info(lhs).kind == Kind::Position) {
+            auto c = constantInt(rhs);
+            if(!c)
+                return fail(op, "uses a row position other than the loop variable plus a constant");
+            return setAll({Kind::Position, info(lhs).offset + sign * *c});
+        }
+    }
+
+    // Reads of rows at the positions.
+    if(auto sro = llvm::dyn_cast<daphne::SliceRowOp>(op)) {
+        Info lo = info(sro.lowerIncl());
+        Info hi = info(sro.upperExcl());
+        if(lo.kind == Kind::Position || hi.kind == Kind::Position) {
+            if(lo.kind != Kind::Position || hi.kind != Kind::Position || hi.offset != lo.offset + 1)
+                return fail(op, "reads more than one row per iteration");
+            if(!sro.source().getType().isa<daphne::MatrixType>())
+                return fail(op, "reads rows of a frame");
+            // the rows of the updated variables are checked against their writes in checkUpdates()
+            Info src = info(sro.source());
+            if(src.kind == Kind::Written && src.offset != lo.offset)
+                return fail(op, "reads a row written by another iteration");
+            if(src.kind == Kind::Rows)
+                return fail(op, "reads rows of a matrix computed in the loop");
+            return setAll({Kind::Rows, lo.offset});
+        }
+    }
+    if(auto ins = llvm::dyn_cast<daphne::InsertRowOp>(op)) {
+        Info lo = info(ins.rowLowerIncl());
+        Info hi = info(ins.rowUpperExcl());
+        if(lo.kind != Kind::Position || hi.kind != Kind::Position || hi.offset != lo.offset + 1)
+            return fail(op, "writes rows at positions other than the loop variable plus a constant");
+        if(!ins.arg().getType().isa<daphne::MatrixType>())
+            return fail(op, "writes rows of a frame");
+        Info arg = info(ins.arg());
+        if(arg.kind != Kind::Variable && !(arg.kind == Kind::Written && arg.offset == lo.offset))
+            return fail(op, "writes different rows of a variable in one iteration");
+        if(info(ins.ins()).kind != Kind::Rows)
+            return fail(op, "writes values that are not computed from the same rows");
+        return setAll({Kind::Written, lo.offset});
+    }
+    // Reads and writes of columns of the rows.
+    if(llvm::isa<daphne::SliceColOp, daphne::InsertColOp>(op)) {
+        const bool isInsert = llvm::isa<daphne::InsertColOp>(op);
+        Value arg = op->getOperand(0);
+        if(info(arg).kind == Kind::Rows) {
+            for(Value bound : op->getOperands().drop_front(isInsert ? 2 : 1))
+                if(info(bound).kind != Kind::Invariant)
+                    return fail(op, "uses the loop variable as a column position");
+            if(isInsert && info(op->getOperand(1)).kind != Kind::Rows)
+                return fail(op, "writes values that are not computed from the same rows");
+            return setAll({Kind::Rows, 0});
+        }
+    }
+
+    // Elementwise operations on the rows and loop-invariant scalars.
+    bool anyRows = false;
+    for(Value operand : op->getOperands()) {
+        Info i = info(operand);
+        if(i.kind == Kind::LoopVar || i.kind == Kind::Position)
+            return fail(op, "uses the loop variable other than as a row position");
+        if(i.kind == Kind::Variable || i.kind == Kind::Written)
+            return fail(op, "reads a variable updated in the loop other than by rows");
+        anyRows = anyRows || i.kind == Kind::Rows;
+    }
+    if(anyRows) {
+        if(!isEwiseOp(op))
+            return fail(op, "computes other than elementwise operations on the rows");
+        // A row combined with a single value of another row broadcasts it, which would be a column of the
+        // slices, thus all rows must be of the same width.
+        ssize_t numCols = -1;
+        for(Value operand : op->getOperands()) {
+            auto mt = operand.getType().dyn_cast<daphne::MatrixType>();
+            if(info(operand).kind == Kind::Invariant && mt)
+                return fail(op, "combines the rows with a loop-invariant matrix");
+            if(info(operand).kind != Kind::Rows)
+                continue;
+            if(!mt || mt.getNumCols() < 0 || (numCols >= 0 && mt.getNumCols() != numCols))
+                return fail(op, "combines rows of different or unknown widths");
+            numCols = mt.getNumCols();
+        }
+        if(!op->getResult(0).getType().isa<daphne::MatrixType>())
+            return fail(op, "computes a scalar from the rows");
+        return setAll({Kind::Rows, 0});
+    }
+
+    // Anything else must be the same in all iterations.
+    if(!CompilerUtils::isSideEffectFree(op))
+        return fail(op, "contains an operation with side effects");
+    return setAll({Kind::Invariant});
+}
+
+bool LoopAnalysis::checkUpdates() {
+    Block * body = loop.getBody();
+    Operation * yieldOp = body->getTerminator();
+    bool anyWrite = false;
+    for(BlockArgument arg : body->getArguments().drop_front()) {
+        if(!arg.getType().isa<daphne::MatrixType>())
+            return fail(nullptr, "updates a scalar or frame in each iteration");
+        Value yielded = yieldOp->getOperand(arg.getArgNumber() - 1);
+        if(yielded == arg)
+            continue;
+        // The variable must be the result of writing rows to it, which is followed back to its beginning.
+        Info y = info(yielded);
+        if(y.kind != Kind::Written)
+            return fail(yielded.getDefiningOp(), "updates a variable other than by rows");
+        Value v = yielded;
+        while(auto ins = v.getDefiningOp<daphne::InsertRowOp>())
+            v = ins.arg();
+        if(v != arg)
+            return fail(yielded.getDefiningOp(), "updates a variable by the rows of another one");
+        // Rows of the variable must be read before they are overwritten, which only holds for the own ones.
+        for(Operation * user : arg.getUsers())
+            if(auto sro = llvm::dyn_cast<daphne::SliceRowOp>(user))
+                if(info(sro.getResult()).offset != y.offset)
+                    return fail(user, "reads a row written by another iteration");
+        anyWrite = true;
+    }
+    if(!anyWrite)
+        return fail(nullptr, "does not write any rows");
+
+    // The step of the ForOp must be 1, i.e., the constant 1 or d * d.
+    Value step = loop.getStep();
+    while(auto castOp = step.getDefiningOp<daphne::CastOp>())
+        step = castOp.arg();
+    auto stepMul = step.getDefiningOp<daphne::EwMulOp>();
+    const bool stepIsOne = constantInt(step) == 1 || (stepMul && stepMul.lhs() == dir && stepMul.rhs() == dir);
+    const auto d = constantInt(dir);
+    if(!stepIsOne || (d && *d != 1 && *d != -1))
+        return fail(nullptr, "has a step other than 1 or -1");
+    return true;
+}
+
+bool LoopAnalysis::analyze() {
+    Block * body = loop.getBody();
+    infos[loop.getInductionVar()] = {Kind::LoopVar};
+    for(BlockArgument arg : body->getArguments().drop_front())
+        infos[arg] = {Kind::Variable};
+
+    for(Operation & op : body->without_terminator())
+        if(!analyzeOp(&op))
+            return false;
+    if(!dir)
+        return fail(nullptr, "does not use the loop variable as a row position");
+    return checkUpdates();
+}
+
+void LoopAnalysis::rewrite() {
+    Location loc = loop.getLoc();
+    OpBuilder builder(loop);
+    Type si64 = builder.getIntegerType(64, true);
+    Type sizeType = builder.getIndexType();
+    auto constant = [&](OpBuilder & b, int64_t c) {
+        return static_cast<Value>(b.create<daphne::ConstantOp>(loc, b.getIntegerAttr(si64, c)));
+    };
+    auto cast = [&](OpBuilder & b, Type t, Value v) {
+        return static_cast<Value>(b.create<daphne::CastOp>(loc, t, v));
+    };
+
+    // The visited rows [lo, hi), and whether there are any.
+    Value lb = cast(builder, si64, loop.getLowerBound());
+    Value ub = cast(builder, si64, loop.getUpperBound());
+    Value cond = cast(builder, builder.getI1Type(), builder.create<daphne::EwLtOp>(loc, si64, lb, ub));
+    Value lo = lb;
+    Value hi = ub;
+    if(constantInt(dir) != 1) {
+        Value first = builder.create<daphne::EwMulOp>(loc, si64, lb, dir);
+        Value last = builder.create<daphne::EwMulOp>(
+                loc, si64, builder.create<daphne::EwSubOp>(loc, si64, ub, constant(builder, 1)), dir
+        );
+        lo = builder.create<daphne::EwMinOp>(loc, si64, first, last);
+        hi = builder.create<daphne::EwAddOp>(
+                loc, si64, builder.create<daphne::EwMaxOp>(loc, si64, first, last), constant(builder, 1)
+        );
+    }
+
+    auto ifOp = builder.create<scf::IfOp>(loc, loop.getResultTypes(), cond, true);
+    OpBuilder elseBuilder = ifOp.getElseBodyBuilder();
+    elseBuilder.create<scf::YieldOp>(loc, loop.getIterOperands());
+
+    OpBuilder thenBuilder = ifOp.getThenBodyBuilder();
+    auto rows = [&](int64_t offset, bool upper) {
+        return cast(thenBuilder, sizeType, thenBuilder.create<daphne::EwAddOp>(
+                loc, si64, upper ? hi : lo, constant(thenBuilder, offset)
+        ));
+    };
+    // the rows of all iterations instead of one
+    auto allRowsType = [](Type t) {
+        if(auto mt = t.dyn_cast<daphne::MatrixType>())
+            return static_cast<Type>(mt.withShape(-1, mt.getNumCols()).withSparsity(-1.0));
+        return t;
+    };
+
+    Block * body = loop.getBody();
+    BlockAndValueMapping mapping;
+    for(BlockArgument arg : body->getArguments().drop_front())
+        mapping.map(arg, loop.getIterOperands()[arg.getArgNumber() - 1]);
+    for(Operation & op : body->without_terminator()) {
+        Info i = info(op.getResult(0));
+        if(i.kind == Kind::LoopVar || i.kind == Kind::Position)
+            continue;
+        if(auto sro = llvm::dyn_cast<daphne::SliceRowOp>(op)) {
+            if(i.kind == Kind::Rows && info(sro.lowerIncl()).kind == Kind::Position) {
+                mapping.map(sro.getResult(), thenBuilder.create<daphne::SliceRowOp>(
+                        loc, allRowsType(sro.getType()), mapping.lookupOrDefault(sro.source()), rows(i.offset, false),
+                        rows(i.offset, true)
+                ));
+                continue;
+            }
+        }
+        if(auto ins = llvm::dyn_cast<daphne::InsertRowOp>(op)) {
+            mapping.map(ins.getResult(), thenBuilder.create<daphne::InsertRowOp>(
+                    loc, ins.getType(), mapping.lookupOrDefault(ins.arg()), mapping.lookupOrDefault(ins.ins()), rows(i.offset, false),
+                    rows(i.offset, true)
+            ));
+            continue;
+        }
+        Operation * clone = thenBuilder.clone(op, mapping);
+        if(i.kind == Kind::Rows)
+            for(Value res : clone->getResults())
+                res.setType(allRowsType(res.getType()));
+    }
+    std::vector<Value> results;
+    for(Value v : body->getTerminator()->getOperands())
+        results.push_back(mapping.lookupOrDefault(v));
+    thenBuilder.create<scf::YieldOp>(loc, results);
+
+    loop->replaceAllUsesWith(ifOp->getResults());
+    loop->erase();
+}
+
+void RewriteLoopsToMatrixOpsPass::runOnFunction() {
+    std::vector<scf::ForOp> loops;
+    getFunction()->walk([&](scf::ForOp loop) {
+        loops.push_back(loop);
+    });
+    // the functions are rewritten in parallel, such that the explanation of each one is printed at once
+    std::stringstream explanation;
+    for(scf::ForOp loop : loops) {
+        LoopAnalysis analysis(loop);
+        const bool rewritable = analysis.analyze();
+        if(explain) {
+            explanation << "loop @ " << CompilerUtils::getLocationString(loop.getLoc()) << ": ";
+            if(rewritable)
+                explanation << "rewritten into whole-matrix operations" << std::endl;
+            else
+                explanation << "not rewritten, since it " << analysis.reason << std::endl;
+        }
+        if(rewritable)
+            analysis.rewrite();
+    }
+    if(explain)
+        std::cerr << explanation.str() << std::flush;
+}
+
+std::unique_ptr<Pass> daphne::createRewriteLoopsToMatrixOpsPass(bool explain) {
+    return std::make_unique<RewriteLoopsToMatrixOpsPass>(explain);
+}
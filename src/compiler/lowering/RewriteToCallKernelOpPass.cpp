@@ -24,6 +24,7 @@
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 
+#include <cctype>
 #include <memory>
 #include <utility>
 #include <iostream>
@@ -45,9 +46,14 @@ namespace
                 return 4;
             if(llvm::isa<daphne::OrderOp>(op))
                 return 4;
+            if(llvm::isa<daphne::OrderTopKOp>(op))
+                return 5;
             if(llvm::isa<daphne::GroupOp>(op))
                 return 3;
-            if(llvm::isa<daphne::CreateFrameOp, daphne::SetColLabelsOp>(op))
+            if(llvm::isa<daphne::FilterGroupOp>(op))
+                return 4;
+            if(llvm::isa<daphne::CreateFrameOp, daphne::SetColLabelsOp, daphne::ReadColumnsOp, daphne::EwFusedOp,
+                    daphne::AdaptiveCallOp>(op))
                 return 2;
             if(llvm::isa<daphne::DistributedComputeOp>(op))
                 return 1;
@@ -81,6 +87,33 @@ namespace
                         isVariadic[index]
                 );
             }
+            if(auto concreteOp = llvm::dyn_cast<daphne::ReadColumnsOp>(op)) {
+                auto idxAndLen = concreteOp.getODSOperandIndexAndLength(index);
+                static bool isVariadic[] = {false, true};
+                return std::make_tuple(
+                        idxAndLen.first,
+                        idxAndLen.second,
+                        isVariadic[index]
+                );
+            }
+            if(auto concreteOp = llvm::dyn_cast<daphne::EwFusedOp>(op)) {
+                auto idxAndLen = concreteOp.getODSOperandIndexAndLength(index);
+                static bool isVariadic[] = {false, true};
+                return std::make_tuple(
+                        idxAndLen.first,
+                        idxAndLen.second,
+                        isVariadic[index]
+                );
+            }
+            if(auto concreteOp = llvm::dyn_cast<daphne::AdaptiveCallOp>(op)) {
+                auto idxAndLen = concreteOp.getODSOperandIndexAndLength(index);
+                static bool isVariadic[] = {false, true};
+                return std::make_tuple(
+                        idxAndLen.first,
+                        idxAndLen.second,
+                        isVariadic[index]
+                );
+            }
             if(auto concreteOp = llvm::dyn_cast<daphne::DistributedComputeOp>(op)) {
                 auto idxAndLen = concreteOp.getODSOperandIndexAndLength(index);
                 static bool isVariadic[] = {true};
@@ -99,6 +132,15 @@ namespace
                         isVariadic[index]
                 );
             }
+            if(auto concreteOp = llvm::dyn_cast<daphne::FilterGroupOp>(op)) {
+                auto idxAndLen = concreteOp.getODSOperandIndexAndLength(index);
+                static bool isVariadic[] = {false, false, true, true};
+                return std::make_tuple(
+                        idxAndLen.first,
+                        idxAndLen.second,
+                        isVariadic[index]
+                );
+            }
             if(auto concreteOp = llvm::dyn_cast<daphne::ThetaJoinOp>(op)) {
                 auto idxAndLen = concreteOp.getODSOperandIndexAndLength(index);
                 static bool isVariadic[] = {false, false, true, true};
@@ -117,6 +159,15 @@ namespace
                         isVariadic[index]
                 );
             }
+            if(auto concreteOp = llvm::dyn_cast<daphne::OrderTopKOp>(op)) {
+                auto idxAndLen = concreteOp.getODSOperandIndexAndLength(index);
+                static bool isVariadic[] = {false, true, true, false, false};
+                return std::make_tuple(
+                        idxAndLen.first,
+                        idxAndLen.second,
+                        isVariadic[index]
+                );
+            }
             throw std::runtime_error(
                     "lowering to kernel call not yet supported for this variadic operation: "
                     + op->getName().getStringRef().str()
@@ -169,18 +220,35 @@ namespace
 	    }
 		    
 
-            callee << '_' << op->getName().stripDialect().data();
+            std::string opName = op->getName().stripDialect().str();
+            // Ops computed at the distributed workers, see DistributePipelinesPass.
+            if(op->hasAttr(daphne::ATTR_DISTRIBUTED)) {
+                opName[0] = std::toupper(opName[0]);
+                opName = "distributed" + opName;
+            }
+            // Joins and group-bys of sorted inputs, see InnerJoinOp::canonicalize and GroupOp::canonicalize.
+            else if(op->hasAttr(daphne::ATTR_SORTED_KEYS)) {
+                opName[0] = std::toupper(opName[0]);
+                opName = "sorted" + opName;
+            }
+            callee << '_' << opName;
+            // Kernels instantiated for a static shape, see MarkStaticShapeOpsPass.
+            if(auto staticShape = op->getAttrOfType<StringAttr>(daphne::ATTR_STATIC_SHAPE))
+                callee << '_' << staticShape.getValue().str();
 
 
             // TODO Don't enumerate all ops, decide based on a trait.
             const bool generalizeInputTypes =
                 llvm::isa<daphne::CreateFrameOp>(op) ||
                 llvm::isa<daphne::DistributedComputeOp>(op) ||
+                llvm::isa<daphne::AdaptiveCallOp>(op) ||
                 llvm::isa<daphne::NumCellsOp>(op) ||
                 llvm::isa<daphne::NumColsOp>(op) ||
                 llvm::isa<daphne::NumRowsOp>(op) ||
                 llvm::isa<daphne::IncRefOp>(op) ||
-                llvm::isa<daphne::DecRefOp>(op);
+                llvm::isa<daphne::DecRefOp>(op) ||
+                llvm::isa<daphne::MarkLastUseOp>(op) ||
+                llvm::isa<daphne::DistributedWaitOp>(op);
 
             // Append names of result types to the kernel name.
             Operation::result_type_range resultTypes = op->getResultTypes();
@@ -253,15 +321,19 @@ namespace
                     newOperands.push_back(op->getOperand(i));
                 }
 
-            if(auto groupOp = llvm::dyn_cast<daphne::GroupOp>(op)) {
-                // GroupOp carries the aggregation functions to apply as an
-                // attribute. Since attributes to not automatically become
-                // inputs to the kernel call, we need to add them explicitly
-                // here.
+            ArrayAttr aggFuncs;
+            if(auto groupOp = llvm::dyn_cast<daphne::GroupOp>(op))
+                aggFuncs = groupOp.aggFuncs();
+            else if(auto filterGroupOp = llvm::dyn_cast<daphne::FilterGroupOp>(op))
+                aggFuncs = filterGroupOp.aggFuncs();
+            if(aggFuncs) {
+                // GroupOp and FilterGroupOp carry the aggregation functions
+                // to apply as an attribute. Since attributes to not
+                // automatically become inputs to the kernel call, we need to
+                // add them explicitly here.
 
                 callee << "__GroupEnum_variadic__size_t";
 
-                ArrayAttr aggFuncs = groupOp.aggFuncs();
                 const size_t numAggFuncs = aggFuncs.size();
                 const Type t = rewriter.getIntegerType(32, false);
                 auto cvpOp = rewriter.create<daphne::CreateVariadicPackOp>(
@@ -336,6 +408,44 @@ namespace
                 );
             }
 
+            if(auto readColumnsOp = llvm::dyn_cast<daphne::ReadColumnsOp>(op)) {
+                // ReadColumnsOp carries the predicates for skipping row groups
+                // as attributes. Since attributes do not automatically become
+                // inputs to the kernel call, we need to add them explicitly
+                // here, as one variadic pack each for the columns, the
+                // comparisons, and the values.
+                callee << "__char_variadic__size_t__CompareOperation__size_t__double_variadic__size_t";
+
+                auto addPack = [&](Type t, ArrayAttr attrs, auto toConstant) {
+                    auto cvpOp = rewriter.create<daphne::CreateVariadicPackOp>(
+                            loc,
+                            daphne::VariadicPackType::get(rewriter.getContext(), t),
+                            rewriter.getIndexAttr(attrs.size())
+                    );
+                    size_t k = 0;
+                    for(Attribute attr : attrs.getValue())
+                        rewriter.create<daphne::StoreVariadicPackOp>(
+                                loc, cvpOp, toConstant(attr), rewriter.getIndexAttr(k++)
+                        );
+                    newOperands.push_back(cvpOp);
+                    newOperands.push_back(rewriter.create<daphne::ConstantOp>(
+                            loc, rewriter.getIndexAttr(attrs.size()))
+                    );
+                };
+                const Type strTy = daphne::StringType::get(rewriter.getContext());
+                addPack(strTy, readColumnsOp.predColumns(), [&](Attribute attr) {
+                    return rewriter.create<daphne::ConstantOp>(loc, strTy, attr.cast<StringAttr>());
+                });
+                const Type cmpTy = rewriter.getIntegerType(32, false);
+                addPack(cmpTy, readColumnsOp.predCmps(), [&](Attribute attr) {
+                    return rewriter.create<daphne::ConstantOp>(loc, rewriter.getIntegerAttr(cmpTy,
+                            static_cast<uint32_t>(attr.dyn_cast<daphne::CompareOperationAttr>().getValue())));
+                });
+                addPack(rewriter.getF64Type(), readColumnsOp.predValues(), [&](Attribute attr) {
+                    return rewriter.create<daphne::ConstantOp>(loc, attr.cast<FloatAttr>());
+                });
+            }
+
             if(auto distCompOp = llvm::dyn_cast<daphne::DistributedComputeOp>(op)) {
                 MLIRContext newContext;
                 OpBuilder tempBuilder(&newContext);
@@ -374,6 +484,11 @@ namespace
                     newOperands,
                     op->getResultTypes()
                     );
+            // Keep the cost estimates for the ProfileKernelsPass, see EstimateCostsPass.
+            for(const std::string & attrName :
+                    {daphne::ATTR_COST_FLOPS, daphne::ATTR_COST_BYTES_READ, daphne::ATTR_COST_BYTES_WRITTEN})
+                if(Attribute cost = op->getAttr(attrName))
+                    kernel->setAttr(attrName, cost);
             rewriter.replaceOp(op, kernel.getResults());
             return success();
         }
@@ -398,7 +513,9 @@ namespace
             
             std::stringstream callee;
             callee << "_distributedPipeline"; // kernel name
-            callee << "__DenseMatrix_double_variadic" // outputs
+            // all outputs are dense matrices of the same value type (see DistributePipelinesPass)
+            callee << "__" << CompilerUtils::mlirTypeToCppTypeName(op.outputs()[0].getType(), false)
+                << "_variadic" // outputs
                 << "__size_t" // numOutputs
                 << "__Structure_variadic" // inputs
                 << "__size_t" // numInputs
@@ -506,8 +623,19 @@ void RewriteToCallKernelOpPass::runOnFunction()
             daphne::GenericCallOp
     >();
     target.addDynamicallyLegalOp<daphne::CastOp>([](daphne::CastOp op) {
-        return op.isTrivialCast() || op.isMatrixPropertyCast();
+        return op.isTrivialCast() || op.isMatrixPropertyCast() || op.isFramePropertyCast()
+                || CompilerUtils::isInlinedScalarOp(op);
     });
+    // The scalar arithmetic operations, comparisons, and casts are lowered to
+    // LLVM IR directly by the LowerToLLVMPass.
+    target.addDynamicallyLegalOp<
+            daphne::EwAddOp, daphne::EwSubOp, daphne::EwMulOp, daphne::EwDivOp, daphne::EwModOp, daphne::EwPowOp,
+            daphne::EwMinOp, daphne::EwMaxOp,
+            daphne::EwEqOp, daphne::EwNeqOp, daphne::EwLtOp, daphne::EwLeOp, daphne::EwGtOp, daphne::EwGeOp,
+            daphne::EwAndOp, daphne::EwOrOp,
+            daphne::EwMinusOp, daphne::EwAbsOp,
+            daphne::EwSqrtOp, daphne::EwExpOp, daphne::EwLnOp, daphne::EwFloorOp, daphne::EwCeilOp
+    >([](Operation * op) { return CompilerUtils::isInlinedScalarOp(op); });
 
     // Determine the DaphneContext valid in the MLIR function being rewritten.
     mlir::Value dctx = CompilerUtils::getDaphneContext(func);
@@ -25,6 +25,7 @@
 
 #include <memory>
 #include <stdexcept>
+#include <map>
 #include <string>
 #include <set>
 #include <unordered_map>
@@ -146,6 +147,22 @@ namespace {
         return function;
     }
 
+    /**
+     * @brief Prints a function under a placeholder name, such that functions with identical signatures and bodies
+     * print identically.
+     * @param function The `FuncOp`
+     * @return The printed function
+     */
+    std::string printWithoutName(FuncOp function) {
+        const std::string name = function.sym_name().str();
+        function.setName("__specialization");
+        std::string s;
+        llvm::raw_string_ostream stream(s);
+        function->print(stream);
+        function.setName(name);
+        return stream.str();
+    }
+
     class SpecializeGenericFunctionsPass
         : public PassWrapper<SpecializeGenericFunctionsPass, OperationPass<ModuleOp>> {
         std::unordered_map<std::string, FuncOp> functions;
@@ -225,6 +242,41 @@ namespace {
             });
         }
 
+        /**
+         * @brief Replaces the specializations of a template function by an earlier one with the same signature and
+         * body, such that each distinct function is JIT-compiled only once.
+         *
+         * E.g., a function called with arguments whose types differ only in properties the body does not depend on
+         * results in several specializations of identical code.
+         * @param module The module containing the functions and their calls
+         */
+        void deduplicateSpecializations(ModuleOp module) {
+            std::unordered_map<std::string, std::string> replacements;
+            for(auto it = specializedVersions.begin(); it != specializedVersions.end(); ) {
+                auto groupEnd = specializedVersions.upper_bound(it->first);
+                std::unordered_map<std::string, FuncOp> distinct;
+                for(; it != groupEnd; ++it) {
+                    FuncOp specializedFunc = it->second;
+                    if(isFunctionTemplate(specializedFunc))
+                        continue;
+                    auto existing = distinct.emplace(printWithoutName(specializedFunc), specializedFunc);
+                    if(!existing.second)
+                        replacements[specializedFunc.sym_name().str()] = existing.first->second.sym_name().str();
+                }
+            }
+            if(replacements.empty())
+                return;
+            module.walk([&](daphne::GenericCallOp callOp) {
+                auto it = replacements.find(callOp.callee().str());
+                if(it != replacements.end())
+                    callOp.calleeAttr(StringAttr::get(callOp.getContext(), it->second));
+            });
+            for(auto & replacement : replacements) {
+                functions[replacement.first].erase();
+                functions.erase(replacement.first);
+            }
+        }
+
     public:
         void runOnOperation() final;
     };
@@ -266,6 +318,7 @@ void SpecializeGenericFunctionsPass::runOnOperation() {
         }
         specializeCallsInFunction(function);
     }
+    deduplicateSpecializations(module);
     // delete templates
     for(auto f : functions) {
         if(isFunctionTemplate(f.second)) {
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compiler/CompilerUtils.h>
+#include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
+
+#include <mlir/Interfaces/CallInterfaces.h>
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Tells the MemoryTracker the source location of the DaphneDSL
+ * statement before its kernels run (see MemoryUsage.h), such that the data
+ * objects they create are attributed to it. The memory usage is reported at
+ * the end of `main`.
+ *
+ * A statement is only set again when it changes within a block, or after an
+ * operation with regions or a function call, which may set other statements.
+ * The kernels of the tasks of vectorized pipelines are attributed to the
+ * statement of the pipeline.
+ *
+ * This pass runs after the RewriteToCallKernelOpPass, such that the
+ * statements also cover the kernels of the reference counting.
+ */
+struct TrackMemoryPass : public PassWrapper<TrackMemoryPass, FunctionPass> {
+    void runOnFunction() final;
+};
+
+void TrackMemoryPass::runOnFunction() {
+    FuncOp func = getFunction();
+
+    // The ops are collected first, since setting the statement is a kernel call, too.
+    std::vector<std::pair<Operation *, Value>> ops;
+    daphne::CallKernelOp destroyCtx;
+    func->walk([&](Operation * op) {
+        if(op->getParentOfType<daphne::VectorizedPipelineOp>())
+            return;
+        if(auto cko = llvm::dyn_cast<daphne::CallKernelOp>(op)) {
+            if(cko.getCalleeAttr().getValue() == "_destroyDaphneContext")
+                destroyCtx = cko;
+            // all kernels except for the creation of the DaphneContext take it as the last argument
+            else if(cko->getNumOperands() && cko->getOperands().back().getType().isa<daphne::DaphneContextType>())
+                ops.emplace_back(op, cko->getOperands().back());
+        }
+        else if(auto vpo = llvm::dyn_cast<daphne::VectorizedPipelineOp>(op)) {
+            if(vpo.ctx())
+                ops.emplace_back(op, vpo.ctx());
+        }
+    });
+
+    OpBuilder builder(&getContext());
+    auto strTy = daphne::StringType::get(&getContext());
+    Block * lastBlock = nullptr;
+    Operation * lastOp = nullptr;
+    std::string lastLocation;
+    for(auto & [op, dctx] : ops) {
+        const std::string location = CompilerUtils::getLocationString(op->getLoc());
+        // the statement set before still holds if no op in between may have set another one
+        bool unchanged = op->getBlock() == lastBlock && location == lastLocation;
+        for(Operation * between = unchanged ? lastOp->getNextNode() : op; between != op;
+                between = between->getNextNode())
+            if(between->getNumRegions() || llvm::isa<CallOpInterface>(between)) {
+                unchanged = false;
+                break;
+            }
+        lastBlock = op->getBlock();
+        lastOp = op;
+        if(unchanged)
+            continue;
+        lastLocation = location;
+
+        builder.setInsertionPoint(op);
+        Value locationStr = builder.create<daphne::ConstantOp>(op->getLoc(), strTy, builder.getStringAttr(location));
+        builder.create<daphne::CallKernelOp>(
+                op->getLoc(), "_setMemoryStatement__char", ValueRange{locationStr, dctx}
+        );
+    }
+
+    if(func.getName() == "main" && destroyCtx) {
+        builder.setInsertionPoint(destroyCtx);
+        builder.create<daphne::CallKernelOp>(
+                destroyCtx.getLoc(), "_printMemoryUsage", ValueRange{destroyCtx->getOperands().back()}
+        );
+    }
+}
+
+std::unique_ptr<Pass> daphne::createTrackMemoryPass() {
+    return std::make_unique<TrackMemoryPass>();
+}
@@ -22,8 +22,12 @@
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Transforms/DialectConversion.h"
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <set>
+#include <string>
+#include <thread>
 #include <iostream>
 
 using namespace mlir;
@@ -81,16 +85,284 @@ namespace
         return true;
     }
 
+    /**
+     * @brief Check if the results of the pipeline that are used outside of it share their matrix representation, since
+     * the runtime combines all results of a pipeline into matrices of one data type. The inputs of a pipeline may mix
+     * dense and sparse matrices, though. Frames count as a representation of their own.
+     * @param pipeline The pipeline
+     * @return true if all results used outside of the pipeline are dense, all are sparse, or all are frames, false
+     * otherwise
+     */
+    bool hasUniformResultRepresentation(const std::vector<daphne::Vectorizable>& pipeline) {
+        std::optional<bool> frames;
+        std::optional<daphne::MatrixRepresentation> repr;
+        for (auto v : pipeline) {
+            for (auto result : v->getResults()) {
+                auto ty = result.getType();
+                if (!ty.isa<daphne::MatrixType, daphne::FrameType>()
+                        || llvm::all_of(result.getUsers(), [&](Operation * user) {
+                        return std::find(pipeline.begin(), pipeline.end(), user) != pipeline.end();
+                    })) {
+                    continue;
+                }
+                const bool isFrame = ty.isa<daphne::FrameType>();
+                if (frames && *frames != isFrame) {
+                    return false;
+                }
+                frames = isFrame;
+                if (isFrame) {
+                    continue;
+                }
+                auto matTy = ty.cast<daphne::MatrixType>();
+                if (repr && *repr != matTy.getRepresentation()) {
+                    return false;
+                }
+                repr = matTy.getRepresentation();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Whether the op is vectorized by an annotation of its statement in DaphneDSL (`@vectorize`), regardless of
+     * the user config.
+     */
+    bool isHintedToVectorize(Operation * op) {
+        auto hint = op->getAttrOfType<BoolAttr>(daphne::ATTR_HINT_VECTORIZE);
+        return hint && hint.getValue();
+    }
+
+    /**
+     * @brief Check if the operations have the same execution hints of DaphneDSL annotations, which apply to the whole
+     * pipeline they are fused into (e.g., its number of threads).
+     */
+    bool haveSameHints(Operation * op1, Operation * op2) {
+        for(const std::string & name : {daphne::ATTR_HINT_VECTORIZE, daphne::ATTR_HINT_NUM_THREADS,
+                daphne::ATTR_HINT_SCHEDULE, daphne::ATTR_HINT_DEVICE, daphne::ATTR_HINT_DISTRIBUTED})
+            if(op1->getAttr(name) != op2->getAttr(name))
+                return false;
+        return true;
+    }
+
+    std::string describe(Operation * op) {
+        std::string str;
+        llvm::raw_string_ostream os(str);
+        os << op->getName() << " at " << op->getLoc();
+        return os.str();
+    }
+
+    /**
+     * @brief The dimension the vectorizable operations are split along.
+     *
+     * The tasks of a pipeline work on one range of indexes, which refers to the rows of its `ROWS`-split inputs and
+     * to the columns of its `COLS`-split inputs. An operation is split along the columns of its inputs if it supports
+     * that and its split inputs are dense matrices wider than tall (see `shouldSplitCols`), and along their rows
+     * otherwise. Since a result is only fused into a pipeline if its combine matches the split of its use, all
+     * operations of a pipeline refer to the same range.
+     */
+    struct VectorSplitDims {
+        std::set<Operation *> byCols;
+
+        std::vector<daphne::VectorSplit> getSplits(daphne::Vectorizable v) const {
+            return byCols.count(v.getOperation()) ? v.getVectorSplitsByCols() : v.getVectorSplits();
+        }
+
+        std::vector<daphne::VectorCombine> getCombines(daphne::Vectorizable v) const {
+            return byCols.count(v.getOperation()) ? v.getVectorCombinesByCols() : v.getVectorCombines();
+        }
+
+        static bool shouldSplitCols(daphne::Vectorizable v) {
+            auto splits = v.getVectorSplitsByCols();
+            if(splits.empty())
+                return false;
+            bool anySplit = false;
+            for(auto e : llvm::zip(v->getOperands(), splits)) {
+                if(std::get<1>(e) != daphne::VectorSplit::COLS)
+                    continue;
+                auto matTy = std::get<0>(e).getType().dyn_cast<daphne::MatrixType>();
+                if(!matTy)
+                    return false;
+                // a single column is broadcast to all tasks
+                if(matTy.getNumCols() == 1)
+                    continue;
+                // the runtime only views dense matrices by columns
+                if(matTy.getRepresentation() != daphne::MatrixRepresentation::Dense || matTy.getNumRows() == -1
+                        || matTy.getNumCols() <= matTy.getNumRows())
+                    return false;
+                anySplit = true;
+            }
+            return anySplit && llvm::all_of(v->getResultTypes(), [](Type t) {
+                auto matTy = t.dyn_cast<daphne::MatrixType>();
+                return matTy && matTy.getRepresentation() == daphne::MatrixRepresentation::Dense;
+            });
+        }
+    };
+
+    /**
+     * @brief A cost model of the memory traffic of vectorized pipelines, based on the shapes and sparsity inferred
+     * by the `InferencePass`.
+     *
+     * A pipeline reads its split inputs and writes its results used outside of it once, while its intermediates
+     * stay in the caches of the workers. Every task reads the broadcast inputs entirely, though, i.e., the inputs
+     * not split or of a single row (column) for row (column) splits (see `BroadcastInputPins::isBroadcast`). While
+     * they fit into the cache, they are effectively read from memory once, beyond that once by each thread. Hence,
+     * two pipelines are only fused if that does not increase the estimated traffic, i.e., if the intermediates saved
+     * outweigh the broadcast inputs dragged into the tasks of the other one. Nothing is recomputed, since the
+     * pipeline returns all results used outside of it.
+     *
+     * The dimension of the split is chosen per operation beforehand (see `VectorSplitDims`), so the choice is between
+     * splitting and not vectorizing the operations at all, for pipelines too small to be worth their tasks. Pipelines
+     * of unknown shapes are formed greedily.
+     */
+    struct PipelineCostModel {
+        // the size of the broadcast inputs of a pipeline that are read from memory once for all tasks
+        static constexpr size_t BROADCAST_CACHE_BYTES = 1 << 21;
+        // the minimum traffic of a pipeline worth splitting into tasks
+        static constexpr size_t MIN_PIPELINE_BYTES = 1 << 16;
+
+        size_t numThreads;
+        bool explain;
+        const VectorSplitDims * dims;
+
+        // the extent of the matrix along the dimension of the split, or -1 if unknown or not split
+        static ssize_t getSplitExtent(daphne::MatrixType matTy, daphne::VectorSplit split) {
+            if(split == daphne::VectorSplit::ROWS)
+                return matTy.getNumRows();
+            if(split == daphne::VectorSplit::COLS)
+                return matTy.getNumCols();
+            return -1;
+        }
+
+        // the number of rows (or columns) the pipeline splits, or `std::nullopt` if unknown
+        std::optional<size_t> splitRows(const std::vector<daphne::Vectorizable> & pipeline) const {
+            size_t numRows = 0;
+            for(auto v : pipeline)
+                for(auto e : llvm::zip(v->getOperands(), dims->getSplits(v))) {
+                    auto matTy = std::get<0>(e).getType().dyn_cast<daphne::MatrixType>();
+                    auto split = std::get<1>(e);
+                    if(!matTy || (split != daphne::VectorSplit::ROWS && split != daphne::VectorSplit::COLS))
+                        continue;
+                    const ssize_t extent = getSplitExtent(matTy, split);
+                    if(extent == -1)
+                        return std::nullopt;
+                    numRows = std::max<size_t>(numRows, extent);
+                }
+            return numRows;
+        }
+
+        std::optional<size_t> estimateTraffic(const std::vector<daphne::Vectorizable> & pipeline) const {
+            auto isPartOfPipeline = [&](Operation * op) {
+                return op && std::find(pipeline.begin(), pipeline.end(), op) != pipeline.end();
+            };
+            std::vector<Value> inputs;
+            size_t splitBytes = 0;
+            size_t broadcastBytes = 0;
+            size_t resultBytes = 0;
+            for(auto v : pipeline) {
+                for(auto e : llvm::zip(v->getOperands(), dims->getSplits(v))) {
+                    Value operand = std::get<0>(e);
+                    if(isPartOfPipeline(operand.getDefiningOp()) || llvm::is_contained(inputs, operand))
+                        continue;
+                    inputs.push_back(operand);
+                    auto bytes = CompilerUtils::estimateBytes(operand);
+                    if(!bytes)
+                        return std::nullopt;
+                    auto matTy = operand.getType().dyn_cast<daphne::MatrixType>();
+                    if(matTy && getSplitExtent(matTy, std::get<1>(e)) != -1
+                            && getSplitExtent(matTy, std::get<1>(e)) != 1)
+                        splitBytes += *bytes;
+                    else
+                        broadcastBytes += *bytes;
+                }
+                for(auto result : v->getResults()) {
+                    if(llvm::all_of(result.getUsers(), isPartOfPipeline))
+                        continue;
+                    auto bytes = CompilerUtils::estimateBytes(result);
+                    if(!bytes)
+                        return std::nullopt;
+                    resultBytes += *bytes;
+                }
+            }
+            const size_t broadcastTraffic = broadcastBytes <= BROADCAST_CACHE_BYTES
+                    ? broadcastBytes
+                    : broadcastBytes * numThreads;
+            return splitBytes + resultBytes + broadcastTraffic;
+        }
+
+        /**
+         * @brief Decides if the pipeline `other` (whose results are used by `current`) shall be fused into the
+         * pipeline `current`.
+         */
+        bool shouldFuse(const std::vector<daphne::Vectorizable> & current,
+                        const std::vector<daphne::Vectorizable> & other) const {
+            std::vector<daphne::Vectorizable> fused(current);
+            fused.insert(fused.end(), other.begin(), other.end());
+            auto trafficCurrent = estimateTraffic(current);
+            auto trafficOther = estimateTraffic(other);
+            auto trafficFused = estimateTraffic(fused);
+            if(!trafficCurrent || !trafficOther || !trafficFused)
+                return true;
+            const bool fuse = *trafficFused <= *trafficCurrent + *trafficOther;
+            if(explain)
+                llvm::errs() << "VectorizeComputationsPass: " << (fuse ? "fuse " : "cut before ")
+                        << describe(other.front()) << " into the pipeline of " << describe(current.front())
+                        << " (traffic " << *trafficCurrent << " + " << *trafficOther << " bytes, fused "
+                        << *trafficFused << " bytes)\n";
+            return fuse;
+        }
+
+        // decides if the pipeline shall be split into tasks, or not be vectorized at all
+        bool shouldVectorize(const std::vector<daphne::Vectorizable> & pipeline) const {
+            auto traffic = estimateTraffic(pipeline);
+            auto numRows = splitRows(pipeline);
+            if(!traffic || !numRows)
+                return true;
+            const bool vectorize = *traffic >= MIN_PIPELINE_BYTES && *numRows > 1;
+            if(explain)
+                llvm::errs() << "VectorizeComputationsPass: pipeline of " << pipeline.size() << " operations ending at "
+                        << describe(pipeline.front()) << ": split "
+                        << (!vectorize ? "NONE (not vectorized)"
+                                : dims->byCols.count(pipeline.front().getOperation()) ? "COLS" : "ROWS")
+                        << " (" << *numRows << " rows/cols, traffic " << *traffic << " bytes)\n";
+            return vectorize;
+        }
+    };
+
+    /**
+     * @brief Chooses the strategy of a matrix multiplication `A @ t(B)` by the sizes of its operands.
+     *
+     * Either the rows of `A` are split and `B` is broadcast to all tasks (or distributed workers), or the rows of `B`
+     * (i.e., the columns of the result) are split and `A` is broadcast (`ATTR_BROADCAST_LHS`). With `W` workers, the
+     * traffic is `|A| + W * |B| + |C|` or `W * |A| + |B| + |C|`, respectively, so the smaller operand is broadcast.
+     * The other transpositions allow only one strategy (see `MatMulOp::getVectorSplits`).
+     */
+    void chooseMatMulStrategy(daphne::MatMulOp op, bool explain) {
+        auto coTa = op.transa().getDefiningOp<daphne::ConstantOp>();
+        auto coTb = op.transb().getDefiningOp<daphne::ConstantOp>();
+        if(!coTa || !coTb || coTa.value().cast<BoolAttr>().getValue() || !coTb.value().cast<BoolAttr>().getValue())
+            return;
+        auto bytesLhs = CompilerUtils::estimateBytes(op.lhs());
+        auto bytesRhs = CompilerUtils::estimateBytes(op.rhs());
+        if(!bytesLhs || !bytesRhs || *bytesLhs >= *bytesRhs)
+            return;
+        op->setAttr(daphne::ATTR_BROADCAST_LHS, UnitAttr::get(op->getContext()));
+        if(explain)
+            llvm::errs() << "VectorizeComputationsPass: broadcast the lhs of " << describe(op)
+                    << " (" << *bytesLhs << " bytes) instead of its rhs (" << *bytesRhs << " bytes)\n";
+    }
+
     /**
      * @brief Greedily fuses the operation into the pipeline if possible.
      * @param operationToPipelineIx A map of operations to their index in the pipelines collection
      * @param pipelines The collection of pipelines
      * @param currentPipelineIx The index of the current pipeline into which we want to possibly fuse the operation
      * @param operationToCheck The operation we possibly want to fuse into the current pipeline
+     * @param costModel The cost model deciding where to cut pipelines, or `nullptr` to fuse greedily
      */
     void greedyPipelineFusion(std::map<daphne::Vectorizable, size_t> &operationToPipelineIx,
                               std::vector<std::vector<daphne::Vectorizable>> &pipelines,
-                              size_t currentPipelineIx, daphne::Vectorizable operationToCheck) {
+                              size_t currentPipelineIx, daphne::Vectorizable operationToCheck,
+                              const PipelineCostModel * costModel) {
         auto &currentPipeline = pipelines[currentPipelineIx];
         auto existingPipelineIt = operationToPipelineIx.find(operationToCheck);
         if(existingPipelineIt != operationToPipelineIx.end()) {
@@ -102,6 +374,12 @@ namespace
                     continue;
                 }
             }
+            std::vector<daphne::Vectorizable> fused(currentPipeline);
+            fused.insert(fused.end(), existingPipeline.begin(), existingPipeline.end());
+            if(!hasUniformResultRepresentation(fused))
+                return;
+            if(costModel && !costModel->shouldFuse(currentPipeline, existingPipeline))
+                return;
             // append existing to current
             currentPipeline.insert(currentPipeline.end(), existingPipeline.begin(), existingPipeline.end());
             for (auto vectorizable : existingPipeline) {
@@ -111,6 +389,11 @@ namespace
             existingPipeline.clear();
         }
         else if(isDirectlyFusible(operationToCheck, currentPipeline)) {
+            std::vector<daphne::Vectorizable> fused(currentPipeline);
+            fused.push_back(operationToCheck);
+            if(!hasUniformResultRepresentation(fused)
+                    || (costModel && !costModel->shouldFuse(currentPipeline, {operationToCheck})))
+                return;
             currentPipeline.push_back(operationToCheck);
             operationToPipelineIx[operationToCheck] = currentPipelineIx;
         }
@@ -172,7 +455,50 @@ namespace
         }
     }
 
+    /**
+     * @brief Check if the `ReadOp` can be fused into the pipeline, such that the pipeline reads the file in chunks of
+     * rows (split `STREAM`) instead of the whole matrix being read before.
+     *
+     * This requires a dense matrix of known shape from a CSV or Daphne binary file of a constant name, whose value
+     * type matches the results of the pipeline, and all uses of the matrix must be row-split operands of the pipeline.
+     * @param readOp The read operation to check
+     * @param pipeline The pipeline
+     * @param dims The dimensions the operations of the pipeline are split along
+     * @return true if it can be fused, false otherwise
+     */
+    bool isStreamableRead(daphne::ReadOp readOp, const std::vector<daphne::Vectorizable>& pipeline,
+                          const VectorSplitDims& dims) {
+        auto matTy = readOp.res().getType().dyn_cast<daphne::MatrixType>();
+        if(!matTy || matTy.getRepresentation() != daphne::MatrixRepresentation::Dense || matTy.getNumRows() == -1
+                || matTy.getNumCols() == -1)
+            return false;
+        if(!matTy.getElementType().isF64() && !matTy.getElementType().isF32())
+            return false;
+        auto co = llvm::dyn_cast_or_null<daphne::ConstantOp>(readOp.fileName().getDefiningOp());
+        auto strAttr = co ? co.value().dyn_cast<StringAttr>() : nullptr;
+        if(!strAttr || !(strAttr.getValue().endswith(".csv") || strAttr.getValue().endswith(".dbdf")))
+            return false;
+        for(auto v : pipeline) {
+            if(v->getBlock() != readOp->getBlock())
+                return false;
+            for(auto resTy : v->getResultTypes()) {
+                auto resMatTy = resTy.dyn_cast<daphne::MatrixType>();
+                if(!resMatTy || resMatTy.getElementType() != matTy.getElementType())
+                    return false;
+            }
+        }
+        for(OpOperand & use : readOp.res().getUses()) {
+            auto v = llvm::dyn_cast<daphne::Vectorizable>(use.getOwner());
+            if(!v || std::find(pipeline.begin(), pipeline.end(), v) == pipeline.end()
+                    || dims.getSplits(v)[use.getOperandNumber()] != daphne::VectorSplit::ROWS)
+                return false;
+        }
+        return true;
+    }
+
     struct VectorizeComputationsPass : public PassWrapper<VectorizeComputationsPass, OperationPass<FuncOp>> {
+        const DaphneUserConfig& userConfig;
+        explicit VectorizeComputationsPass(const DaphneUserConfig& cfg) : userConfig(cfg) {}
         void runOnOperation() final;
     };
 }
@@ -184,19 +510,62 @@ void VectorizeComputationsPass::runOnOperation()
     //  This requires multi-returns in way more cases, which is not implemented yet.
 
     // Find vectorizable operations and their inputs of vectorizable operations
+    // The min and max combines and the column splits are only supported by the local CPU runtime (not by the CUDA
+    // tasks and the distributed workers).
+    const bool localCpuOnly = !userConfig.use_cuda && !userConfig.use_distributed;
+    // Without the vectorized engine enabled for all ops, only the ops of the statements annotated by `@vectorize`
+    // are vectorized.
+    const bool vectorizeAll = userConfig.use_vectorized_exec || userConfig.use_distributed;
+    if(!vectorizeAll && !func->walk([](Operation * op) {
+            return isHintedToVectorize(op) ? WalkResult::interrupt() : WalkResult::advance();
+        }).wasInterrupted())
+        return;
+    VectorSplitDims dims;
+    func->walk([&](daphne::MatMulOp op) {
+        if(vectorizeAll || isHintedToVectorize(op))
+            chooseMatMulStrategy(op, userConfig.explain_vectorized);
+    });
+    auto isFrameComputation = [](Operation * op) {
+        auto isFrame = [](Type ty) { return ty.isa<daphne::FrameType>(); };
+        return llvm::any_of(op->getOperandTypes(), isFrame) || llvm::any_of(op->getResultTypes(), isFrame);
+    };
+    auto canVectorize = [&](daphne::Vectorizable op) {
+        if(!(CompilerUtils::isMatrixComputation(op) || isFrameComputation(op)) || op.getVectorSplits().empty())
+            return false;
+        // `@vectorize(false)` keeps the op out of the pipelines
+        if(auto hint = op->getAttrOfType<BoolAttr>(daphne::ATTR_HINT_VECTORIZE))
+            if(!hint.getValue())
+                return false;
+        if(!vectorizeAll && !isHintedToVectorize(op))
+            return false;
+        // the pipelines over frames are only run by the local CPU runtime
+        if(!localCpuOnly && isFrameComputation(op))
+            return false;
+        if(!localCpuOnly)
+            for(auto combine : dims.getCombines(op))
+                if(combine == daphne::VectorCombine::MIN || combine == daphne::VectorCombine::MAX)
+                    return false;
+        return true;
+    };
     std::vector<daphne::Vectorizable> vectOps;
     func->walk([&](daphne::Vectorizable op)
     {
-      if(CompilerUtils::isMatrixComputation(op))
+      if(canVectorize(op)) {
+          if(localCpuOnly && VectorSplitDims::shouldSplitCols(op))
+              dims.byCols.insert(op.getOperation());
           vectOps.emplace_back(op);
+      }
     });
     std::vector<daphne::Vectorizable> vectorizables(vectOps.begin(), vectOps.end());
     std::multimap<daphne::Vectorizable, daphne::Vectorizable> possibleMerges;
     for(auto v : vectorizables) {
-        for(auto e : llvm::zip(v->getOperands(), v.getVectorSplits())) {
+        for(auto e : llvm::zip(v->getOperands(), dims.getSplits(v))) {
             auto operand = std::get<0>(e);
             auto defOp = operand.getDefiningOp<daphne::Vectorizable>();
-            if(defOp && v->getBlock() == defOp->getBlock() && CompilerUtils::isMatrixComputation(defOp)) {
+            // The parts of a filtered frame have fewer rows than the tasks they were computed by, so they are
+            // only concatenated at the end of a pipeline.
+            if(defOp && v->getBlock() == defOp->getBlock() && canVectorize(defOp)
+                    && !llvm::isa<daphne::FilterRowOp>(defOp) && haveSameHints(v, defOp)) {
                 // defOp is not a candidate for fusion with v, if the
                 // result/operand along which we would fuse is used within a
                 // nested block (e.g., control structure) between defOp and v.
@@ -225,12 +594,16 @@ void VectorizeComputationsPass::runOnOperation()
                     auto split = std::get<1>(e);
                     // find the corresponding `OpResult` to figure out combine
                     auto opResult = *llvm::find(defOp->getResults(), operand);
-                    auto combine = defOp.getVectorCombines()[opResult.getResultNumber()];
+                    auto combine = dims.getCombines(defOp)[opResult.getResultNumber()];
 
                     if(split == daphne::VectorSplit::ROWS) {
                         if(combine == daphne::VectorCombine::ROWS)
                             possibleMerges.insert({v, defOp});
                     }
+                    else if(split == daphne::VectorSplit::COLS) {
+                        if(combine == daphne::VectorCombine::COLS)
+                            possibleMerges.insert({v, defOp});
+                    }
                     else if (split == daphne::VectorSplit::NONE) {
                         // can't be merged
                     }
@@ -242,6 +615,14 @@ void VectorizeComputationsPass::runOnOperation()
         }
     }
 
+    std::optional<PipelineCostModel> costModel;
+    if(userConfig.vectorized_cost_model) {
+        const size_t numThreads = userConfig.numberOfThreads > 0
+                ? userConfig.numberOfThreads
+                : std::max(1u, std::thread::hardware_concurrency());
+        costModel = PipelineCostModel{numThreads, userConfig.explain_vectorized, &dims};
+    }
+
     // Collect vectorizable operations that can be computed together in pipelines
     std::map<daphne::Vectorizable, size_t> operationToPipelineIx;
     std::vector<std::vector<daphne::Vectorizable>> pipelines;
@@ -264,7 +645,8 @@ void VectorizeComputationsPass::runOnOperation()
         for(auto it = itRange.first; it != itRange.second; ++it) {
             auto operandVectorizable = it->second;
             // TODO: this fuses greedily, the first pipeline we can fuse this operation into, we do. improve
-            greedyPipelineFusion(operationToPipelineIx, pipelines, pipelineIx, operandVectorizable);
+            greedyPipelineFusion(operationToPipelineIx, pipelines, pipelineIx, operandVectorizable,
+                                 costModel ? &*costModel : nullptr);
         }
     }
 
@@ -274,9 +656,27 @@ void VectorizeComputationsPass::runOnOperation()
         if(pipeline.empty()) {
             continue;
         }
+        // the distributed runtime requires all pipelines, and the annotated ones are vectorized as requested
+        if(costModel && !userConfig.use_distributed && !isHintedToVectorize(pipeline.front())
+                && !costModel->shouldVectorize(pipeline)) {
+            continue;
+        }
         auto valueIsPartOfPipeline = [&](Value operand) {
             return llvm::any_of(pipeline, [&](daphne::Vectorizable lv) { return lv == operand.getDefiningOp(); });
         };
+        // the fused reads, whose matrix is passed to the pipeline as the name of the file (once for all its uses)
+        std::vector<daphne::ReadOp> streamedReads;
+        if(userConfig.vectorized_stream_read && !userConfig.use_distributed) {
+            for(auto v : pipeline)
+                for(auto operand : v->getOperands())
+                    if(auto readOp = operand.getDefiningOp<daphne::ReadOp>())
+                        if(llvm::find(streamedReads, readOp) == streamedReads.end()
+                                && isStreamableRead(readOp, pipeline, dims))
+                            streamedReads.push_back(readOp);
+        }
+        std::map<Operation*, size_t> streamedReadArgs;
+        // the index of the block argument of every operand from outside the pipeline, in the order of the operations
+        std::vector<size_t> operandArgs;
         std::vector<Attribute> vSplitAttrs;
         std::vector<Attribute> vCombineAttrs;
         std::vector<Location> locations;
@@ -292,15 +692,29 @@ void VectorizeComputationsPass::runOnOperation()
         movePipelineInterleavedOperations(builder.getInsertionPoint(), pipeline);
         for(auto vIt = pipeline.rbegin(); vIt != pipeline.rend(); ++vIt) {
             auto v = *vIt;
-            auto vSplits = v.getVectorSplits();
-            auto vCombines = v.getVectorCombines();
+            auto vSplits = dims.getSplits(v);
+            auto vCombines = dims.getCombines(v);
             // TODO: although we do create enum attributes, it might make sense/make it easier to
             //  just directly use an I64ArrayAttribute
             for(auto i = 0u; i < v->getNumOperands(); ++i) {
                 auto operand = v->getOperand(i);
                 if(!valueIsPartOfPipeline(operand)) {
-                    vSplitAttrs.push_back(daphne::VectorSplitAttr::get(&getContext(), vSplits[i]));
-                    operands.push_back(operand);
+                    auto readOp = operand.getDefiningOp<daphne::ReadOp>();
+                    if(readOp && llvm::find(streamedReads, readOp) != streamedReads.end()) {
+                        auto it = streamedReadArgs.find(readOp);
+                        if(it != streamedReadArgs.end()) {
+                            operandArgs.push_back(it->second);
+                            continue;
+                        }
+                        streamedReadArgs[readOp] = operands.size();
+                        vSplitAttrs.push_back(daphne::VectorSplitAttr::get(&getContext(), daphne::VectorSplit::STREAM));
+                        operands.push_back(readOp.fileName());
+                    }
+                    else {
+                        vSplitAttrs.push_back(daphne::VectorSplitAttr::get(&getContext(), vSplits[i]));
+                        operands.push_back(operand);
+                    }
+                    operandArgs.push_back(operands.size() - 1);
                 }
             }
             for(auto vCombine : vCombines) {
@@ -329,20 +743,45 @@ void VectorizeComputationsPass::runOnOperation()
             builder.getArrayAttr(vSplitAttrs),
             builder.getArrayAttr(vCombineAttrs),
             nullptr);
+        // the hints of the operations (which are the same for all of them) on the pipeline, see LowerToLLVMPass and
+        // DistributePipelinesPass
+        for(const std::string & name : {daphne::ATTR_HINT_NUM_THREADS, daphne::ATTR_HINT_SCHEDULE,
+                daphne::ATTR_HINT_DISTRIBUTED})
+            if(Attribute hint = pipeline.front()->getAttr(name))
+                pipelineOp->setAttr(name, hint);
         Block *bodyBlock = builder.createBlock(&pipelineOp.body());
 
         for(size_t i = 0u; i < operands.size(); ++i) {
             auto argTy = operands[i].getType();
             switch (vSplitAttrs[i].cast<daphne::VectorSplitAttr>().getValue()) {
                 case daphne::VectorSplit::ROWS: {
-                    auto matTy = argTy.cast<daphne::MatrixType>();
                     // only remove row information
+                    if(auto frTy = argTy.dyn_cast<daphne::FrameType>()) {
+                        argTy = frTy.withShape(-1, frTy.getNumCols());
+                        break;
+                    }
+                    auto matTy = argTy.cast<daphne::MatrixType>();
                     argTy = matTy.withShape(-1, matTy.getNumCols());
                     break;
                 }
+                case daphne::VectorSplit::COLS: {
+                    auto matTy = argTy.cast<daphne::MatrixType>();
+                    // only remove column information
+                    argTy = matTy.withShape(matTy.getNumRows(), -1);
+                    break;
+                }
                 case daphne::VectorSplit::NONE:
                     // keep any size information
                     break;
+                case daphne::VectorSplit::STREAM: {
+                    // the argument is the matrix of the fused read (whose operand is the file name)
+                    auto readOp = llvm::find_if(streamedReads, [&](daphne::ReadOp r) {
+                        return streamedReadArgs[r] == i;
+                    });
+                    auto matTy = (*readOp).res().getType().cast<daphne::MatrixType>();
+                    argTy = matTy.withShape(-1, matTy.getNumCols());
+                    break;
+                }
             }
             bodyBlock->addArgument(argTy);
         }
@@ -358,7 +797,7 @@ void VectorizeComputationsPass::runOnOperation()
 
             for(auto i = 0u; i < numOperands; ++i) {
                 if(!valueIsPartOfPipeline(v->getOperand(i))) {
-                    v->setOperand(i, bodyBlock->getArgument(argsIx++));
+                    v->setOperand(i, bodyBlock->getArgument(operandArgs[argsIx++]));
                 }
             }
 
@@ -371,9 +810,12 @@ void VectorizeComputationsPass::runOnOperation()
                 // TODO: switch to type based size inference instead
                 // FIXME: if output is dynamic sized, we can't do this
                 // replace `NumRowOp` and `NumColOp`s for output size inference
+                // (the rows of a filtered frame are only an upper bound)
+                const bool exactRows = !llvm::isa<daphne::FilterRowOp>(v.getOperation());
                 for(auto& use: old.getUses()) {
                     auto* op = use.getOwner();
-                    if(auto nrowOp = llvm::dyn_cast<daphne::NumRowsOp>(op)) {
+                    auto nrowOp = llvm::dyn_cast<daphne::NumRowsOp>(op);
+                    if(nrowOp && exactRows) {
                         nrowOp.replaceAllUsesWith(pipelineOp.out_rows()[replacement.getResultNumber()]);
                         nrowOp.erase();
                     }
@@ -393,13 +835,37 @@ void VectorizeComputationsPass::runOnOperation()
                 if(auto ty = resVal.getType().dyn_cast<daphne::MatrixType>()) {
                     resVal.setType(ty.withShape(-1, -1));
                 }
+                else if(auto ty = resVal.getType().dyn_cast<daphne::FrameType>()) {
+                    resVal.setType(ty.withShape(-1, -1));
+                }
             }
         });
         builder.setInsertionPointToEnd(bodyBlock);
         builder.create<daphne::ReturnOp>(loc, results);
+
+        // The fused reads are only left with the output size inference of the pipeline, which is known from the
+        // shape of their matrices.
+        for(auto readOp : streamedReads) {
+            auto matTy = readOp.res().getType().cast<daphne::MatrixType>();
+            for(Operation * user : llvm::make_early_inc_range(readOp->getUsers())) {
+                ssize_t size;
+                if(llvm::isa<daphne::NumRowsOp>(user))
+                    size = matTy.getNumRows();
+                else if(llvm::isa<daphne::NumColsOp>(user))
+                    size = matTy.getNumCols();
+                else
+                    continue;
+                builder.setInsertionPoint(user);
+                user->getResult(0).replaceAllUsesWith(
+                        builder.create<daphne::ConstantOp>(user->getLoc(), builder.getIndexAttr(size)));
+                user->erase();
+            }
+            if(readOp->use_empty())
+                readOp->erase();
+        }
     }
 }
 
-std::unique_ptr<Pass> daphne::createVectorizeComputationsPass() {
-    return std::make_unique<VectorizeComputationsPass>();
+std::unique_ptr<Pass> daphne::createVectorizeComputationsPass(const DaphneUserConfig& cfg) {
+    return std::make_unique<VectorizeComputationsPass>(cfg);
 }
@@ -41,9 +41,11 @@
 #include <ir/daphneir/DaphneInferFrameLabelsOpInterface.h>
 #include <ir/daphneir/DaphneInferSparsityOpInterface.h>
 #include <ir/daphneir/DaphneInferShapeOpInterface.h>
+#include <ir/daphneir/DaphneInferSortednessOpInterface.h>
 #include <ir/daphneir/DaphneInferTypesOpInterface.h>
 #include <ir/daphneir/DaphneVectorizableOpInterface.h>
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -52,6 +54,10 @@ namespace mlir::OpTrait {
     template<class ConcreteOp>
     class FPGAOPENCLSupport : public TraitBase<ConcreteOp, FPGAOPENCLSupport> {
     };
+
+    template<class ConcreteOp>
+    class InPlaceSupport : public TraitBase<ConcreteOp, InPlaceSupport> {
+    };
 }
 
 namespace mlir::daphne {
@@ -15,6 +15,7 @@
  */
 
 #include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
 #include <ir/daphneir/DaphneOpsEnums.cpp.inc>
 #define GET_OP_CLASSES
 #include <ir/daphneir/DaphneOps.cpp.inc>
@@ -44,6 +45,11 @@
 #include <llvm/ADT/APInt.h>
 #include <llvm/ADT/APSInt.h>
 
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
 void mlir::daphne::DaphneDialect::initialize()
 {
     addOperations<
@@ -232,6 +238,16 @@ void mlir::daphne::DaphneDialect::printType(mlir::Type type,
         }
         else
             os << '?';
+        // Sortedness (only printed when known).
+        if(std::vector<std::string> * sortedBy = t.getSortedBy()) {
+            os << ":sorted[";
+            for (size_t i = 0; i < sortedBy->size(); i++) {
+                os << '"' << (*sortedBy)[i] << '"';
+                if(i < sortedBy->size() - 1)
+                    os << ", ";
+            }
+            os << ']';
+        }
         os << '>';
     }
     else if (auto handle = type.dyn_cast<mlir::daphne::HandleType>()) {
@@ -377,7 +393,8 @@ mlir::OpFoldResult mlir::daphne::ConstantOp::fold(mlir::ArrayRef<mlir::Attribute
         ::llvm::function_ref<::mlir::InFlightDiagnostic()> emitError,
         std::vector<Type> columnTypes,
         ssize_t numRows, ssize_t numCols,
-        std::vector<std::string> * labels
+        std::vector<std::string> * labels,
+        std::vector<std::string> * sortedBy
 )
 {
     // TODO Verify the individual column types.
@@ -391,6 +408,8 @@ mlir::OpFoldResult mlir::daphne::ConstantOp::fold(mlir::ArrayRef<mlir::Attribute
     }
     if(labels && labels->size() != columnTypes.size())
         return mlir::failure();
+    if(sortedBy && sortedBy->size() > columnTypes.size())
+        return mlir::failure();
     return mlir::success();
 }
 
@@ -442,6 +461,11 @@ mlir::LogicalResult mlir::daphne::VectorizedPipelineOp::canonicalize(mlir::daphn
         op.splits(),
         rewriter.getArrayAttr(vCombineAttrs),
         op.ctx());
+    // the execution hints of DaphneDSL annotations, see VectorizeComputationsPass
+    for(const std::string & name : {mlir::daphne::ATTR_HINT_NUM_THREADS, mlir::daphne::ATTR_HINT_SCHEDULE,
+            mlir::daphne::ATTR_HINT_DISTRIBUTED})
+        if(Attribute hint = op->getAttr(name))
+            pipelineOp->setAttr(name, hint);
     pipelineOp.body().takeBody(op.body());
     if(!op.cuda().getBlocks().empty())
         pipelineOp.cuda().takeBody(op.cuda());
@@ -1013,6 +1037,423 @@ mlir::LogicalResult mlir::daphne::NumCellsOp::canonicalize(
     return mlir::failure();
 }
 
+/**
+ * @brief Replaces the first rows of an order, i.e., `sliceRow(order(...), 0,
+ * k)`, by `orderTopK`, which does not sort all rows, if the order has no other
+ * uses.
+ */
+mlir::LogicalResult mlir::daphne::SliceRowOp::canonicalize(
+        mlir::daphne::SliceRowOp op, PatternRewriter &rewriter
+) {
+    auto orderOp = op.source().getDefiningOp<mlir::daphne::OrderOp>();
+    if(!orderOp || !orderOp->hasOneUse())
+        return mlir::failure();
+
+    // the lower bound may be a casted constant
+    mlir::Value lower = op.lowerIncl();
+    if(auto castOp = lower.getDefiningOp<mlir::daphne::CastOp>())
+        lower = castOp.arg();
+    auto co = lower.getDefiningOp<mlir::daphne::ConstantOp>();
+    if(!co)
+        return mlir::failure();
+    auto intAttr = co.value().dyn_cast<mlir::IntegerAttr>();
+    if(!intAttr || intAttr.getValue().getSExtValue() != 0)
+        return mlir::failure();
+
+    rewriter.replaceOpWithNewOp<mlir::daphne::OrderTopKOp>(
+            op, op.getType(), orderOp.arg(), orderOp.colIdxs(), orderOp.ascs(), orderOp.returnIdxs(),
+            op.upperExcl()
+    );
+    rewriter.eraseOp(orderOp);
+    return mlir::success();
+}
+
+/**
+ * @brief Replaces a `ReadOp` of a frame from a Parquet file by a
+ * `ReadColumnsOp` of only the columns the program uses, if all uses of the
+ * frame extract columns by their labels, possibly after a `FilterRowOp`.
+ *
+ * If the rows are filtered by comparing a column with a constant, and this is
+ * the only use of the column before the filter, the comparison is pushed down
+ * into the `ReadColumnsOp`, such that it skips the row groups in which no row
+ * satisfies the comparison. The `FilterRowOp` remains in place.
+ */
+mlir::LogicalResult mlir::daphne::ReadOp::canonicalize(
+        mlir::daphne::ReadOp op, PatternRewriter &rewriter
+) {
+    auto ft = op.getType().dyn_cast<mlir::daphne::FrameType>();
+    if(!ft || !ft.getLabels())
+        return mlir::failure();
+    auto getConstantString = [](mlir::Value v, std::string &str) {
+        if(auto co = v.getDefiningOp<mlir::daphne::ConstantOp>())
+            if(auto strAttr = co.value().dyn_cast<mlir::StringAttr>()) {
+                str = strAttr.getValue().str();
+                return true;
+            }
+        return false;
+    };
+    std::string fileName;
+    const std::string ext = ".parquet";
+    if(!getConstantString(op.fileName(), fileName) || fileName.size() < ext.size()
+            || fileName.compare(fileName.size() - ext.size(), ext.size(), ext) != 0)
+        return mlir::failure();
+
+    // The columns extracted from the frame or from the filtered frame.
+    const std::vector<std::string> & labels = *ft.getLabels();
+    std::vector<bool> used(labels.size(), false);
+    auto useColumn = [&](mlir::daphne::ExtractColOp extractOp, mlir::Value source) {
+        std::string label;
+        if(extractOp.source() != source || !getConstantString(extractOp.selectedCols(), label))
+            return false;
+        auto it = std::find(labels.begin(), labels.end(), label);
+        if(it == labels.end())
+            return false;
+        used[it - labels.begin()] = true;
+        return true;
+    };
+    std::vector<mlir::daphne::ExtractColOp> directExtractOps;
+    mlir::daphne::FilterRowOp filterOp = nullptr;
+    for(mlir::Operation * user : op->getUsers()) {
+        if(auto extractOp = llvm::dyn_cast<mlir::daphne::ExtractColOp>(user)) {
+            if(!useColumn(extractOp, op.res()))
+                return mlir::failure();
+            directExtractOps.push_back(extractOp);
+        }
+        else if(auto fo = llvm::dyn_cast<mlir::daphne::FilterRowOp>(user)) {
+            if(filterOp || fo.source() != op.res())
+                return mlir::failure();
+            filterOp = fo;
+            for(mlir::Operation * filterUser : fo->getUsers()) {
+                auto extractOp = llvm::dyn_cast<mlir::daphne::ExtractColOp>(filterUser);
+                if(!extractOp || !useColumn(extractOp, fo.res()))
+                    return mlir::failure();
+            }
+        }
+        else
+            return mlir::failure();
+    }
+
+    // The predicate of the filter, if it is `column cmp constant` or `constant cmp column`
+    // on the only column extracted before the filter (casts aside).
+    std::vector<llvm::StringRef> predColumns;
+    std::vector<mlir::Attribute> predCmps;
+    std::vector<double> predValues;
+    if(filterOp && directExtractOps.size() == 1) {
+        auto skipCasts = [](mlir::Value v) {
+            while(auto castOp = v.getDefiningOp<mlir::daphne::CastOp>()) {
+                if(!castOp->hasOneUse())
+                    break;
+                v = castOp.arg();
+            }
+            return v;
+        };
+        auto isPredColumn = [&](mlir::Value v) {
+            auto extractOp = v.getDefiningOp<mlir::daphne::ExtractColOp>();
+            return extractOp && extractOp.getOperation() == directExtractOps[0].getOperation() && extractOp->hasOneUse();
+        };
+        auto getConstantNumber = [](mlir::Value v, double &value) {
+            if(auto co = v.getDefiningOp<mlir::daphne::ConstantOp>()) {
+                if(auto floatAttr = co.value().dyn_cast<mlir::FloatAttr>()) {
+                    value = floatAttr.getValueAsDouble();
+                    return true;
+                }
+                if(auto intAttr = co.value().dyn_cast<mlir::IntegerAttr>()) {
+                    value = intAttr.getType().isUnsignedInteger()
+                            ? static_cast<double>(intAttr.getValue().getZExtValue())
+                            : static_cast<double>(intAttr.getValue().getSExtValue());
+                    return true;
+                }
+            }
+            return false;
+        };
+        mlir::Operation * cmpOp = skipCasts(filterOp.selectedRows()).getDefiningOp();
+        std::optional<mlir::daphne::CompareOperation> cmp;
+        std::optional<mlir::daphne::CompareOperation> mirroredCmp;
+        if(cmpOp && cmpOp->hasOneUse()) {
+            if(llvm::isa<mlir::daphne::EwEqOp>(cmpOp))
+                cmp = mirroredCmp = mlir::daphne::CompareOperation::Equal;
+            else if(llvm::isa<mlir::daphne::EwNeqOp>(cmpOp))
+                cmp = mirroredCmp = mlir::daphne::CompareOperation::NotEqual;
+            else if(llvm::isa<mlir::daphne::EwLtOp>(cmpOp)) {
+                cmp = mlir::daphne::CompareOperation::LessThan;
+                mirroredCmp = mlir::daphne::CompareOperation::GreaterThan;
+            }
+            else if(llvm::isa<mlir::daphne::EwLeOp>(cmpOp)) {
+                cmp = mlir::daphne::CompareOperation::LessEqual;
+                mirroredCmp = mlir::daphne::CompareOperation::GreaterEqual;
+            }
+            else if(llvm::isa<mlir::daphne::EwGtOp>(cmpOp)) {
+                cmp = mlir::daphne::CompareOperation::GreaterThan;
+                mirroredCmp = mlir::daphne::CompareOperation::LessThan;
+            }
+            else if(llvm::isa<mlir::daphne::EwGeOp>(cmpOp)) {
+                cmp = mlir::daphne::CompareOperation::GreaterEqual;
+                mirroredCmp = mlir::daphne::CompareOperation::LessEqual;
+            }
+        }
+        if(cmp) {
+            mlir::Value lhs = skipCasts(cmpOp->getOperand(0));
+            mlir::Value rhs = skipCasts(cmpOp->getOperand(1));
+            double value;
+            std::optional<mlir::daphne::CompareOperation> pushedCmp;
+            if(isPredColumn(lhs) && getConstantNumber(rhs, value))
+                pushedCmp = cmp;
+            else if(isPredColumn(rhs) && getConstantNumber(lhs, value))
+                pushedCmp = mirroredCmp;
+            if(pushedCmp) {
+                std::string label;
+                getConstantString(directExtractOps[0].selectedCols(), label);
+                predColumns.push_back(*std::find(labels.begin(), labels.end(), label));
+                predCmps.push_back(mlir::daphne::CompareOperationAttr::get(rewriter.getContext(), *pushedCmp));
+                predValues.push_back(value);
+            }
+        }
+    }
+
+    // nothing to gain, or an unused frame
+    if((predColumns.empty() && std::all_of(used.begin(), used.end(), [](bool u) { return u; }))
+            || std::none_of(used.begin(), used.end(), [](bool u) { return u; }))
+        return mlir::failure();
+
+    std::vector<mlir::Type> colTypes;
+    auto * newLabels = new std::vector<std::string>();
+    std::vector<mlir::Value> columns;
+    const mlir::Type strTy = mlir::daphne::StringType::get(rewriter.getContext());
+    for(size_t c = 0; c < labels.size(); c++)
+        if(used[c]) {
+            colTypes.push_back(ft.getColumnTypes()[c]);
+            newLabels->push_back(labels[c]);
+            columns.push_back(rewriter.create<mlir::daphne::ConstantOp>(
+                    op.getLoc(), strTy, rewriter.getStringAttr(labels[c])
+            ));
+        }
+    // skipped row groups make the number of rows unknown
+    const ssize_t numRows = predColumns.empty() ? ft.getNumRows() : -1;
+    auto resTy = mlir::daphne::FrameType::get(
+            rewriter.getContext(), colTypes, numRows, static_cast<ssize_t>(colTypes.size()), newLabels
+    );
+    if(filterOp)
+        rewriter.updateRootInPlace(filterOp, [&]() {
+            filterOp.res().setType(resTy.withShape(-1, resTy.getNumCols()));
+        });
+    rewriter.replaceOpWithNewOp<mlir::daphne::ReadColumnsOp>(
+            op, resTy, op.fileName(), columns, rewriter.getStrArrayAttr(predColumns),
+            rewriter.getArrayAttr(predCmps), rewriter.getF64ArrayAttr(predValues)
+    );
+    return mlir::success();
+}
+
+/**
+ * @brief Replaces a filter of a cartesian product by a `ThetaJoinOp`, if the
+ * filter is a comparison (or a conjunction of comparisons) of a column of the
+ * left side and a column of the right side, such that only the pairs of rows
+ * satisfying the comparisons are materialized.
+ *
+ * The comparisons and the cartesian product are erased, unless they have
+ * other uses.
+ */
+mlir::LogicalResult mlir::daphne::FilterRowOp::canonicalize(
+        mlir::daphne::FilterRowOp op, PatternRewriter &rewriter
+) {
+    auto cartOp = op.source().getDefiningOp<mlir::daphne::CartesianOp>();
+    if(!cartOp)
+        return mlir::failure();
+    auto lhsTy = cartOp.lhs().getType().dyn_cast<mlir::daphne::FrameType>();
+    auto rhsTy = cartOp.rhs().getType().dyn_cast<mlir::daphne::FrameType>();
+    if(!lhsTy || !rhsTy || !lhsTy.getLabels() || !rhsTy.getLabels())
+        return mlir::failure();
+    const std::vector<std::string> & lhsLabels = *lhsTy.getLabels();
+    const std::vector<std::string> & rhsLabels = *rhsTy.getLabels();
+
+    // the operations of the predicate, erased after the rewrite
+    std::vector<mlir::Operation *> predOps;
+    auto addPredOp = [&](mlir::Operation * o) {
+        if(std::find(predOps.begin(), predOps.end(), o) == predOps.end())
+            predOps.push_back(o);
+    };
+    auto skipCasts = [&](mlir::Value v) {
+        while(auto castOp = v.getDefiningOp<mlir::daphne::CastOp>()) {
+            addPredOp(castOp);
+            v = castOp.arg();
+        }
+        return v;
+    };
+    // the side (0 for lhs, 1 for rhs) of the column of the product extracted
+    // as the given value, or -1
+    auto sideOf = [&](mlir::Value v, mlir::Value & label) {
+        auto extractOp = skipCasts(v).getDefiningOp<mlir::daphne::ExtractColOp>();
+        if(!extractOp || extractOp.source() != cartOp.res())
+            return -1;
+        auto co = extractOp.selectedCols().getDefiningOp<mlir::daphne::ConstantOp>();
+        auto strAttr = co ? co.value().dyn_cast<mlir::StringAttr>() : nullptr;
+        if(!strAttr)
+            return -1;
+        const std::string l = strAttr.getValue().str();
+        const bool inLhs = std::find(lhsLabels.begin(), lhsLabels.end(), l) != lhsLabels.end();
+        const bool inRhs = std::find(rhsLabels.begin(), rhsLabels.end(), l) != rhsLabels.end();
+        if(inLhs == inRhs)
+            return -1;
+        addPredOp(extractOp);
+        label = extractOp.selectedCols();
+        return inLhs ? 0 : 1;
+    };
+
+    std::vector<mlir::Value> lhsOn;
+    std::vector<mlir::Value> rhsOn;
+    std::vector<mlir::Attribute> cmps;
+    std::vector<mlir::Value> conjuncts = {op.selectedRows()};
+    while(!conjuncts.empty()) {
+        mlir::Operation * cmpOp = skipCasts(conjuncts.back()).getDefiningOp();
+        conjuncts.pop_back();
+        if(!cmpOp)
+            return mlir::failure();
+        addPredOp(cmpOp);
+        if(llvm::isa<mlir::daphne::EwAndOp>(cmpOp)) {
+            conjuncts.push_back(cmpOp->getOperand(0));
+            conjuncts.push_back(cmpOp->getOperand(1));
+            continue;
+        }
+        std::optional<mlir::daphne::CompareOperation> cmp;
+        std::optional<mlir::daphne::CompareOperation> mirroredCmp;
+        if(llvm::isa<mlir::daphne::EwEqOp>(cmpOp))
+            cmp = mirroredCmp = mlir::daphne::CompareOperation::Equal;
+        else if(llvm::isa<mlir::daphne::EwNeqOp>(cmpOp))
+            cmp = mirroredCmp = mlir::daphne::CompareOperation::NotEqual;
+        else if(llvm::isa<mlir::daphne::EwLtOp>(cmpOp)) {
+            cmp = mlir::daphne::CompareOperation::LessThan;
+            mirroredCmp = mlir::daphne::CompareOperation::GreaterThan;
+        }
+        else if(llvm::isa<mlir::daphne::EwLeOp>(cmpOp)) {
+            cmp = mlir::daphne::CompareOperation::LessEqual;
+            mirroredCmp = mlir::daphne::CompareOperation::GreaterEqual;
+        }
+        else if(llvm::isa<mlir::daphne::EwGtOp>(cmpOp)) {
+            cmp = mlir::daphne::CompareOperation::GreaterThan;
+            mirroredCmp = mlir::daphne::CompareOperation::LessThan;
+        }
+        else if(llvm::isa<mlir::daphne::EwGeOp>(cmpOp)) {
+            cmp = mlir::daphne::CompareOperation::GreaterEqual;
+            mirroredCmp = mlir::daphne::CompareOperation::LessEqual;
+        }
+        else
+            return mlir::failure();
+        mlir::Value label0, label1;
+        const int side0 = sideOf(cmpOp->getOperand(0), label0);
+        const int side1 = sideOf(cmpOp->getOperand(1), label1);
+        if(side0 == 0 && side1 == 1) {
+            lhsOn.push_back(label0);
+            rhsOn.push_back(label1);
+            cmps.push_back(mlir::daphne::CompareOperationAttr::get(rewriter.getContext(), *cmp));
+        }
+        else if(side0 == 1 && side1 == 0) {
+            lhsOn.push_back(label1);
+            rhsOn.push_back(label0);
+            cmps.push_back(mlir::daphne::CompareOperationAttr::get(rewriter.getContext(), *mirroredCmp));
+        }
+        else
+            return mlir::failure();
+    }
+
+    rewriter.replaceOpWithNewOp<mlir::daphne::ThetaJoinOp>(
+            op, op.getType(), cartOp.lhs(), cartOp.rhs(), lhsOn, rhsOn, rewriter.getArrayAttr(cmps)
+    );
+    // operations shared by several comparisons become unused later
+    for(bool erased = true; erased; ) {
+        erased = false;
+        for(mlir::Operation *& o : predOps)
+            if(o && o->use_empty()) {
+                rewriter.eraseOp(o);
+                o = nullptr;
+                erased = true;
+            }
+    }
+    if(cartOp->use_empty())
+        rewriter.eraseOp(cartOp);
+    return mlir::success();
+}
+
+/**
+ * @brief Marks the op with `ATTR_SORTED_KEYS` if its input frames are known to
+ * be sorted by the given key columns, and unmarks it if they are not anymore.
+ *
+ * @return `true` if the mark was changed.
+ */
+static bool updateSortedKeys(
+        mlir::Operation * op, const std::vector<std::pair<mlir::Value, std::vector<mlir::Value>>> & inputs,
+        PatternRewriter &rewriter
+) {
+    bool sorted = true;
+    for(auto & [frame, keys] : inputs) {
+        auto ft = frame.getType().dyn_cast<mlir::daphne::FrameType>();
+        std::vector<std::string> labels;
+        for(mlir::Value k : keys) {
+            mlir::StringAttr strAttr;
+            if(auto co = k.getDefiningOp<mlir::daphne::ConstantOp>())
+                strAttr = co.value().dyn_cast<mlir::StringAttr>();
+            if(!strAttr) {
+                sorted = false;
+                break;
+            }
+            labels.push_back(strAttr.getValue().str());
+        }
+        sorted = sorted && ft && ft.isSortedBy(labels);
+    }
+    if(sorted == op->hasAttr(mlir::daphne::ATTR_SORTED_KEYS))
+        return false;
+    rewriter.updateRootInPlace(op, [&]() {
+        if(sorted)
+            op->setAttr(mlir::daphne::ATTR_SORTED_KEYS, rewriter.getUnitAttr());
+        else
+            op->removeAttr(mlir::daphne::ATTR_SORTED_KEYS);
+    });
+    return true;
+}
+
+/**
+ * @brief Selects a merge join (see `ATTR_SORTED_KEYS`), if both inputs are
+ * sorted by their key columns.
+ */
+mlir::LogicalResult mlir::daphne::InnerJoinOp::canonicalize(
+        mlir::daphne::InnerJoinOp op, PatternRewriter &rewriter
+) {
+    return mlir::success(updateSortedKeys(
+            op, {{op.lhs(), {op.lhsOn()}}, {op.rhs(), {op.rhsOn()}}}, rewriter
+    ));
+}
+
+/**
+ * @brief Selects a streaming aggregation (see `ATTR_SORTED_KEYS`), if the
+ * input is sorted by the key columns. Otherwise, fuses a `GroupOp` on the
+ * rows filtered by a `FilterRowOp` into a `FilterGroupOp`, which filters and
+ * aggregates chunks of the rows in parallel without materializing the
+ * filtered frame.
+ *
+ * The filter must not have other uses. Filters of cross products and joins
+ * are left alone, since they are optimized together with the joins (see
+ * `FilterRowOp::canonicalize` and the `OptimizeSqlPass`).
+ */
+mlir::LogicalResult mlir::daphne::GroupOp::canonicalize(
+        mlir::daphne::GroupOp op, PatternRewriter &rewriter
+) {
+    if(!op.keyCol().empty() && updateSortedKeys(
+            op, {{op.frame(), std::vector<mlir::Value>(op.keyCol().begin(), op.keyCol().end())}}, rewriter
+    ))
+        return mlir::success();
+    if(op->hasAttr(mlir::daphne::ATTR_SORTED_KEYS))
+        return mlir::failure();
+    auto filterOp = op.frame().getDefiningOp<mlir::daphne::FilterRowOp>();
+    if(!filterOp || !filterOp->hasOneUse() || !filterOp.source().getType().isa<mlir::daphne::FrameType>())
+        return mlir::failure();
+    mlir::Operation * sourceOp = filterOp.source().getDefiningOp();
+    if(llvm::isa_and_nonnull<mlir::daphne::CartesianOp, mlir::daphne::InnerJoinOp>(sourceOp))
+        return mlir::failure();
+    rewriter.replaceOpWithNewOp<mlir::daphne::FilterGroupOp>(
+            op, op.getType(), filterOp.source(), filterOp.selectedRows(), op.keyCol(), op.aggCol(), op.aggFuncs()
+    );
+    rewriter.eraseOp(filterOp);
+    return mlir::success();
+}
+
 /**
  * @brief Replaces a `DistributeOp` by a `DistributedReadOp`, if its input
  * value (a) is defined by a `ReadOp`, and (b) is not used elsewhere.
@@ -154,6 +154,14 @@ void daphne::OrderOp::inferFrameLabels() {
     }
 }
 
+void daphne::OrderTopKOp::inferFrameLabels() {
+    Type t = arg().getType();
+    if(auto ft = t.dyn_cast<daphne::FrameType>()) {
+        Value res = getResult();
+        res.setType(res.getType().dyn_cast<daphne::FrameType>().withLabels(ft.getLabels()));
+    }
+}
+
 void daphne::InnerJoinOp::inferFrameLabels() {
     auto newLabels = new std::vector<std::string>();
     auto ft1 = lhs().getType().dyn_cast<daphne::FrameType>();
@@ -190,19 +198,21 @@ void daphne::ThetaJoinOp::inferFrameLabels() {
     getResult().setType(res().getType().dyn_cast<daphne::FrameType>().withLabels(newLabels));
 }
 
-void daphne::GroupOp::inferFrameLabels() {
+// Sets the labels of the result of a GroupOp or FilterGroupOp.
+template<class GroupLikeOp>
+void inferFrameLabelsGroup(GroupLikeOp op) {
     auto newLabels = new std::vector<std::string>();
     std::vector<std::string> aggColLabels;
     std::vector<std::string> aggFuncNames;
 
-    for(Value t: keyCol()){ //Adopting keyCol Labels
+    for(Value t: op.keyCol()){ //Adopting keyCol Labels
         newLabels->push_back(getConstantString(t));
     }
 
-    for(Value t: aggCol()){
+    for(Value t: op.aggCol()){
         aggColLabels.push_back(getConstantString(t));
     }
-    for(Attribute t: aggFuncs()){
+    for(Attribute t: op.aggFuncs()){
         GroupEnum aggFuncValue = t.dyn_cast<GroupEnumAttr>().getValue();
         aggFuncNames.push_back(stringifyGroupEnum(aggFuncValue).str());
     }
@@ -210,7 +220,15 @@ void daphne::GroupOp::inferFrameLabels() {
         newLabels->push_back(aggFuncNames.at(i) + "(" + aggColLabels.at(i) + ")");
     }
 
-    getResult().setType(res().getType().dyn_cast<daphne::FrameType>().withLabels(newLabels));
+    op.getResult().setType(op.res().getType().dyn_cast<daphne::FrameType>().withLabels(newLabels));
+}
+
+void daphne::GroupOp::inferFrameLabels() {
+    inferFrameLabelsGroup(*this);
+}
+
+void daphne::FilterGroupOp::inferFrameLabels() {
+    inferFrameLabelsGroup(*this);
 }
 
 void daphne::SetColLabelsOp::inferFrameLabels() {
@@ -16,9 +16,11 @@
 
 #include <compiler/CompilerUtils.h>
 #include <ir/daphneir/Daphne.h>
+#include <runtime/local/datastructures/Structure.h>
 
 #include <mlir/IR/Value.h>
 
+#include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <utility>
@@ -203,6 +205,17 @@ ssize_t daphne::SeqOp::inferNumRows() {
     );
 }
 
+std::vector<std::pair<ssize_t, ssize_t>> daphne::MatrixConstantOp::inferShape() {
+    // The matrix was created by the compiler in this process.
+    try {
+        auto mat = reinterpret_cast<const Structure *>(getConstantInt(matrixAddr()));
+        return {{static_cast<ssize_t>(mat->getNumRows()), static_cast<ssize_t>(mat->getNumCols())}};
+    }
+    catch(const std::runtime_error & e) {
+        return {{-1, -1}};
+    }
+}
+
 std::vector<std::pair<ssize_t, ssize_t>> daphne::CreateFrameOp::inferShape() {
     return {{inferNumRowsFromArgs(cols()), inferNumColsFromSumOfArgs(cols())}};
 }
@@ -220,6 +233,13 @@ std::vector<std::pair<ssize_t, ssize_t>> daphne::GroupOp::inferShape() {
     return {{numRows, numCols}};
 }
 
+std::vector<std::pair<ssize_t, ssize_t>> daphne::FilterGroupOp::inferShape() {
+    // We don't know the exact number of groups here.
+    const size_t numRows = -1;
+    const size_t numCols = inferNumColsFromArgs(keyCol()) + inferNumColsFromArgs(aggCol());
+    return {{numRows, numCols}};
+}
+
 std::vector<std::pair<ssize_t, ssize_t>> daphne::MatMulOp::inferShape() {
     auto shapeLhs = getShape(lhs());
     auto shapeRhs = getShape(rhs());
@@ -241,11 +261,48 @@ std::vector<std::pair<ssize_t, ssize_t>> daphne::MatMulOp::inferShape() {
     return {{numRows, numCols}};
 }
 
+std::vector<std::pair<ssize_t, ssize_t>> daphne::BatchMatMulOp::inferShape() {
+    auto shapeLhs = getShape(lhs());
+    auto shapeRhs = getShape(rhs());
+    const ssize_t numBatches = getSizeOrUnknown(this->numBatches());
+    auto coTa = transa().getDefiningOp<mlir::daphne::ConstantOp>();
+    auto coTb = transb().getDefiningOp<mlir::daphne::ConstantOp>();
+
+    // the blocks of lhs are stacked, so the result has as many rows as lhs unless they are transposed
+    ssize_t numRows = -1;
+    if(coTa) {
+        if(!coTa.value().dyn_cast<mlir::BoolAttr>().getValue())
+            numRows = shapeLhs.first;
+        else if(numBatches != -1 && shapeLhs.second != -1)
+            numRows = numBatches * shapeLhs.second;
+    }
+
+    ssize_t numCols = -1;
+    if(coTb) {
+        if(!coTb.value().dyn_cast<mlir::BoolAttr>().getValue())
+            numCols = shapeRhs.second;
+        else if(numBatches > 0 && shapeRhs.first != -1)
+            numCols = shapeRhs.first / numBatches;
+    }
+
+    return {{numRows, numCols}};
+}
+
+std::vector<std::pair<ssize_t, ssize_t>> daphne::QuantizedMatMulOp::inferShape() {
+    return {{getShape(lhs()).first, getShape(rhs()).second}};
+}
+
 std::vector<std::pair<ssize_t, ssize_t>> daphne::ReadOp::inferShape() {
     FileMetaData fmd = CompilerUtils::getFileMetaData(fileName());
     return {{fmd.numRows, fmd.numCols}};
 }
 
+std::vector<std::pair<ssize_t, ssize_t>> daphne::ReadColumnsOp::inferShape() {
+    // skipped row groups make the number of rows unknown
+    const ssize_t numRows = predColumns().empty() ? CompilerUtils::getFileMetaData(fileName()).numRows : -1;
+    return {{numRows, static_cast<ssize_t>(columns().size())}};
+}
+
 std::vector<std::pair<ssize_t, ssize_t>> daphne::OrderOp::inferShape() {
     size_t numRows = -1;
     size_t numCols = -1;
@@ -267,6 +324,31 @@ std::vector<std::pair<ssize_t, ssize_t>> daphne::OrderOp::inferShape() {
     return {{numRows, numCols}};
 }
 
+std::vector<std::pair<ssize_t, ssize_t>> daphne::OrderTopKOp::inferShape() {
+    ssize_t numRows = -1;
+    ssize_t numCols = -1;
+    Type t = arg().getType();
+    if(auto mt = t.dyn_cast<daphne::MatrixType>()) {
+        numRows = mt.getNumRows();
+        numCols = mt.getNumCols();
+    }
+    if(auto ft = t.dyn_cast<daphne::FrameType>()) {
+        numRows = ft.getNumRows();
+        numCols = ft.getNumCols();
+    }
+    if(auto co = returnIdxs().getDefiningOp<mlir::daphne::ConstantOp>())
+        if(co.value().dyn_cast<mlir::BoolAttr>().getValue())
+            numCols = 1;
+    // at most k rows
+    ssize_t numRowsRes = -1;
+    if(auto co = k().getDefiningOp<mlir::daphne::ConstantOp>())
+        if(auto intAttr = co.value().dyn_cast<mlir::IntegerAttr>()) {
+            const ssize_t kVal = intAttr.getValue().getSExtValue();
+            numRowsRes = numRows == -1 ? -1 : std::min(numRows, kVal);
+        }
+    return {{numRowsRes, numCols}};
+}
+
 // ****************************************************************************
 // Shape inference trait implementations
 // ****************************************************************************
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ir/daphneir/Daphne.h>
+#include <runtime/local/datastructures/LabelUtils.h>
+
+#include <mlir/IR/Value.h>
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mlir::daphne {
+#include <ir/daphneir/DaphneInferSortednessOpInterface.cpp.inc>
+}
+
+using namespace mlir;
+
+// ****************************************************************************
+// Utilities
+// ****************************************************************************
+
+namespace {
+    // The value of a constant string.
+    std::optional<std::string> constantString(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto strAttr = co.value().dyn_cast<StringAttr>())
+                return strAttr.getValue().str();
+        return std::nullopt;
+    }
+
+    // The value of a constant integer or boolean, also if it was cast.
+    std::optional<int64_t> constantInt(Value v) {
+        if(auto castOp = v.getDefiningOp<daphne::CastOp>())
+            v = castOp.arg();
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto intAttr = co.value().dyn_cast<IntegerAttr>())
+                return intAttr.getValue().getLimitedValue();
+        return std::nullopt;
+    }
+
+    // The label of the column at the given position of a frame, which is a
+    // constant or the result of a `GetColIdxOp`.
+    std::optional<std::string> columnLabel(Value colIdx, daphne::FrameType ft) {
+        Value v = colIdx;
+        if(auto castOp = v.getDefiningOp<daphne::CastOp>())
+            v = castOp.arg();
+        if(auto getColIdxOp = v.getDefiningOp<daphne::GetColIdxOp>())
+            return constantString(getColIdxOp.columnName());
+        std::optional<int64_t> idx = constantInt(colIdx);
+        std::vector<std::string> * labels = ft.getLabels();
+        if(idx && labels && *idx >= 0 && static_cast<size_t>(*idx) < labels->size())
+            return (*labels)[*idx];
+        return std::nullopt;
+    }
+
+    // The leading columns of sortedBy whose labels are among the given ones,
+    // or nullptr if there are none.
+    std::vector<std::string> * sortedByPrefix(std::vector<std::string> * sortedBy,
+            const std::vector<std::string> * labels) {
+        if(!sortedBy || !labels)
+            return nullptr;
+        auto * prefix = new std::vector<std::string>();
+        for(const std::string & l : *sortedBy) {
+            if(std::find(labels->begin(), labels->end(), l) == labels->end())
+                break;
+            prefix->push_back(l);
+        }
+        if(prefix->empty()) {
+            delete prefix;
+            return nullptr;
+        }
+        return prefix;
+    }
+
+    void setSortedBy(Value res, std::vector<std::string> * sortedBy) {
+        if(auto ft = res.getType().dyn_cast<daphne::FrameType>())
+            res.setType(ft.withSortedBy(sortedBy));
+    }
+
+    // Keeps the sortedness of the frame arg in res, whose rows are a
+    // subsequence of the rows of arg, and whose labels may be fewer.
+    void keepSortedness(Value res, Value arg) {
+        auto ftArg = arg.getType().dyn_cast<daphne::FrameType>();
+        auto ftRes = res.getType().dyn_cast<daphne::FrameType>();
+        if(ftArg && ftRes)
+            setSortedBy(res, sortedByPrefix(ftArg.getSortedBy(), ftRes.getLabels()));
+    }
+
+    // Sets the sortedness of the result of an order of the given columns.
+    void inferSortednessOrder(Value res, Value arg, ValueRange colIdxs, ValueRange ascs) {
+        auto ft = arg.getType().dyn_cast<daphne::FrameType>();
+        if(!ft || !res.getType().isa<daphne::FrameType>())
+            return;
+        auto * sortedBy = new std::vector<std::string>();
+        for(size_t i = 0; i < colIdxs.size(); i++) {
+            std::optional<int64_t> asc = constantInt(ascs[i]);
+            std::optional<std::string> label = columnLabel(colIdxs[i], ft);
+            // Only the leading ascending columns are recorded.
+            if(!asc || !*asc || !label)
+                break;
+            sortedBy->push_back(*label);
+        }
+        if(sortedBy->empty()) {
+            delete sortedBy;
+            sortedBy = nullptr;
+        }
+        setSortedBy(res, sortedBy);
+    }
+
+    // Sets the sortedness of the result of a group-by, whose groups are
+    // ordered by their keys.
+    template<class GroupLikeOp>
+    void inferSortednessGroup(GroupLikeOp op) {
+        auto * sortedBy = new std::vector<std::string>();
+        for(Value k : op.keyCol()) {
+            std::optional<std::string> label = constantString(k);
+            if(!label)
+                break;
+            sortedBy->push_back(*label);
+        }
+        if(sortedBy->empty()) {
+            delete sortedBy;
+            sortedBy = nullptr;
+        }
+        setSortedBy(op.res(), sortedBy);
+    }
+}
+
+// ****************************************************************************
+// Sortedness inference implementations
+// ****************************************************************************
+
+void daphne::ColBindOp::inferSortedness() {
+    // The rows of lhs keep their order.
+    keepSortedness(res(), lhs());
+}
+
+void daphne::ExtractColOp::inferSortedness() {
+    keepSortedness(res(), source());
+}
+
+void daphne::FilterRowOp::inferSortedness() {
+    keepSortedness(res(), source());
+}
+
+void daphne::OrderOp::inferSortedness() {
+    inferSortednessOrder(res(), arg(), colIdxs(), ascs());
+}
+
+void daphne::OrderTopKOp::inferSortedness() {
+    inferSortednessOrder(res(), arg(), colIdxs(), ascs());
+}
+
+void daphne::InnerJoinOp::inferSortedness() {
+    // The rows of the result are ordered by the rows of lhs (see the kernel),
+    // irrespective of whether they are merged or hashed.
+    keepSortedness(res(), lhs());
+}
+
+void daphne::GroupOp::inferSortedness() {
+    inferSortednessGroup(*this);
+}
+
+void daphne::FilterGroupOp::inferSortedness() {
+    inferSortednessGroup(*this);
+}
+
+void daphne::SetColLabelsOp::inferSortedness() {
+    auto ft = arg().getType().dyn_cast<daphne::FrameType>();
+    auto ftRes = res().getType().dyn_cast<daphne::FrameType>();
+    if(!ft || !ftRes || !ft.getSortedBy() || !ft.getLabels() || !ftRes.getLabels()) {
+        setSortedBy(res(), nullptr);
+        return;
+    }
+    // The labels are renamed by their positions.
+    const std::vector<std::string> & oldLabels = *ft.getLabels();
+    const std::vector<std::string> & newLabels = *ftRes.getLabels();
+    auto * sortedBy = new std::vector<std::string>();
+    for(const std::string & l : *ft.getSortedBy()) {
+        const size_t pos = std::find(oldLabels.begin(), oldLabels.end(), l) - oldLabels.begin();
+        if(pos >= newLabels.size())
+            break;
+        sortedBy->push_back(newLabels[pos]);
+    }
+    if(sortedBy->empty()) {
+        delete sortedBy;
+        sortedBy = nullptr;
+    }
+    setSortedBy(res(), sortedBy);
+}
+
+void daphne::SetColLabelsPrefixOp::inferSortedness() {
+    auto ft = arg().getType().dyn_cast<daphne::FrameType>();
+    std::optional<std::string> prefixStr = constantString(prefix());
+    if(!ft || !ft.getSortedBy() || !prefixStr) {
+        setSortedBy(res(), nullptr);
+        return;
+    }
+    auto * sortedBy = new std::vector<std::string>();
+    for(const std::string & l : *ft.getSortedBy())
+        sortedBy->push_back(LabelUtils::setPrefix(*prefixStr, l));
+    setSortedBy(res(), sortedBy);
+}
@@ -20,10 +20,15 @@
 
 #include <parser/metadata/MetaDataParser.h>
 
+#include <algorithm>
+#include <functional>
+#include <optional>
 #include <vector>
 #include <stdexcept>
 #include <utility>
 
+#include <cmath>
+
 namespace mlir::daphne {
 #include <ir/daphneir/DaphneInferSparsityOpInterface.cpp.inc>
 }
@@ -35,13 +40,38 @@ using namespace mlir::OpTrait;
 // Utilities
 // ****************************************************************************
 
+// The value of a constant scalar, also if it was cast to another value type.
+std::optional<double> getConstantScalar(Value v) {
+    if(auto castOp = v.getDefiningOp<daphne::CastOp>())
+        if(!castOp.arg().getType().isa<daphne::MatrixType, daphne::FrameType>())
+            v = castOp.arg();
+    auto co = v.getDefiningOp<daphne::ConstantOp>();
+    if(!co)
+        return std::nullopt;
+    if(auto floatAttr = co.value().dyn_cast<FloatAttr>())
+        return floatAttr.getValueAsDouble();
+    if(auto intAttr = co.value().dyn_cast<IntegerAttr>()) {
+        Type t = intAttr.getType();
+        if(t.isSignlessInteger(1))
+            return intAttr.getValue().getBoolValue() ? 1.0 : 0.0;
+        if(t.isUnsignedInteger())
+            return static_cast<double>(intAttr.getValue().getZExtValue());
+        return static_cast<double>(intAttr.getValue().getSExtValue());
+    }
+    return std::nullopt;
+}
+
 double getSparsityOrUnknownFromType(Value v) {
     Type t = v.getType();
     if(auto mt = t.dyn_cast<daphne::MatrixType>())
         return mt.getSparsity();
-    else // scalar or frame
-        // TODO: read scalar value (if 0 -> sparsity 0.0)
+    if(t.isa<daphne::FrameType>())
         return -1.0;
+    // A scalar acts like a matrix of the same value in all cells, i.e., a
+    // zero scalar is completely sparse and any other one completely dense.
+    if(auto value = getConstantScalar(v))
+        return *value == 0.0 ? 0.0 : 1.0;
+    return -1.0;
 }
 
 double getSparsityOrUnknownFromScalar(Value v) {
@@ -57,7 +87,7 @@ double getSparsityOrUnknownFromScalar(Value v) {
 // Sparsity inference interface implementations
 // ****************************************************************************
 
-std::vector<double> daphne::DiagMatrixOp::inferSparsity() {
+std::vector<double> daphne::DiagMatrixOp::inferSparsity(bool worstCase) {
     auto argTy = arg().getType().dyn_cast<daphne::MatrixType>();
     auto k = argTy.getNumRows();
     auto sparsity = argTy.getSparsity();
@@ -69,7 +99,7 @@ std::vector<double> daphne::DiagMatrixOp::inferSparsity() {
     return {sparsity / k};
 }
 
-std::vector<double> daphne::MatMulOp::inferSparsity() {
+std::vector<double> daphne::MatMulOp::inferSparsity(bool worstCase) {
     auto lhsTy = lhs().getType().dyn_cast<daphne::MatrixType>();
     auto rhsTy = rhs().getType().dyn_cast<daphne::MatrixType>();
     if(lhsTy.getSparsity() == -1.0 || rhsTy.getSparsity() == -1.0) {
@@ -81,21 +111,29 @@ std::vector<double> daphne::MatMulOp::inferSparsity() {
     }
     if(k == -1)
         return {-1.0};
+    else if(worstCase)
+        // Each non-zero of the lhs contributes to at most one row of the
+        // result (and vice versa for the rhs), i.e., nnz(res) <= nnz(lhs) *
+        // numCols(res) and nnz(res) <= numRows(res) * nnz(rhs).
+        return {std::min({1.0, lhsTy.getSparsity() * k, rhsTy.getSparsity() * k})};
     else
         // unbiased estimate
         return {1.0 - std::pow(1.0 - lhsTy.getSparsity() * rhsTy.getSparsity(), k)};
 }
 
-std::vector<double> daphne::TriOp::inferSparsity() {
+std::vector<double> daphne::TriOp::inferSparsity(bool worstCase) {
     auto argTy = arg().getType().dyn_cast<daphne::MatrixType>();
     if(argTy.getSparsity() == -1.0) {
         return {-1.0};
     }
+    // All non-zeros could be in the selected triangle.
+    if(worstCase)
+        return {argTy.getSparsity()};
     // TODO: remove diagonal
     return {argTy.getSparsity() / 2.0};
 }
 
-std::vector<double> daphne::ReadOp::inferSparsity() {
+std::vector<double> daphne::ReadOp::inferSparsity(bool worstCase) {
     // TODO Use CompilerUtils::getFileMetaData() here, but it throws if the
     // file name is not a constant (after constant propagation).
     if(auto co = llvm::dyn_cast<mlir::daphne::ConstantOp>(fileName().getDefiningOp())) {
@@ -111,6 +149,69 @@ std::vector<double> daphne::ReadOp::inferSparsity() {
     return {-1.0};
 }
 
+/**
+ * @brief The sparsity of the result of a comparison, which is non-zero
+ * wherever the comparison holds.
+ *
+ * Each operand is a matrix or a constant scalar. The result is zero in the
+ * cells in which the matrices are zero if the comparison does not hold for
+ * zero (e.g., `X > 0`, `X != Y`), or non-zero there if it does (e.g.,
+ * `X == 0`, `X <= Y`). For the non-zero cells, the average case assumes the
+ * opposite outcome, while the worst case assumes non-zero results only.
+ */
+double inferSparsityOfCmp(Value lhs, Value rhs, const std::function<bool(double, double)> & cmp, bool worstCase) {
+    const bool lhsIsMat = lhs.getType().isa<daphne::MatrixType>();
+    const bool rhsIsMat = rhs.getType().isa<daphne::MatrixType>();
+    if(!lhsIsMat && !rhsIsMat)
+        return -1.0;
+    const double spLhs = getSparsityOrUnknownFromType(lhs);
+    const double spRhs = getSparsityOrUnknownFromType(rhs);
+    if(spLhs == -1.0 || spRhs == -1.0)
+        return -1.0;
+    // The values of both operands in the cells in which the matrices are
+    // zero, and the sparsity of the cells in which any matrix is non-zero.
+    double zeroLhs = 0.0;
+    double zeroRhs = 0.0;
+    double sparsity;
+    if(lhsIsMat && rhsIsMat)
+        sparsity = worstCase ? std::min(1.0, spLhs + spRhs) : spLhs + spRhs - spLhs * spRhs;
+    else if(lhsIsMat) {
+        zeroRhs = *getConstantScalar(rhs);
+        sparsity = spLhs;
+    }
+    else {
+        zeroLhs = *getConstantScalar(lhs);
+        sparsity = spRhs;
+    }
+    if(!cmp(zeroLhs, zeroRhs))
+        return sparsity;
+    return worstCase ? 1.0 : 1.0 - sparsity;
+}
+
+std::vector<double> daphne::EwEqOp::inferSparsity(bool worstCase) {
+    return {inferSparsityOfCmp(lhs(), rhs(), std::equal_to<double>(), worstCase)};
+}
+
+std::vector<double> daphne::EwNeqOp::inferSparsity(bool worstCase) {
+    return {inferSparsityOfCmp(lhs(), rhs(), std::not_equal_to<double>(), worstCase)};
+}
+
+std::vector<double> daphne::EwLtOp::inferSparsity(bool worstCase) {
+    return {inferSparsityOfCmp(lhs(), rhs(), std::less<double>(), worstCase)};
+}
+
+std::vector<double> daphne::EwLeOp::inferSparsity(bool worstCase) {
+    return {inferSparsityOfCmp(lhs(), rhs(), std::less_equal<double>(), worstCase)};
+}
+
+std::vector<double> daphne::EwGtOp::inferSparsity(bool worstCase) {
+    return {inferSparsityOfCmp(lhs(), rhs(), std::greater<double>(), worstCase)};
+}
+
+std::vector<double> daphne::EwGeOp::inferSparsity(bool worstCase) {
+    return {inferSparsityOfCmp(lhs(), rhs(), std::greater_equal<double>(), worstCase)};
+}
+
 // ****************************************************************************
 // Sparsity inference trait implementations
 // ****************************************************************************
@@ -155,11 +256,11 @@ struct trySparsityFromIthArg {
 // Sparsity inference function
 // ****************************************************************************
 
-std::vector<double> daphne::tryInferSparsity(Operation *op) {
+std::vector<double> daphne::tryInferSparsity(Operation *op, bool worstCase) {
     if(auto inferSparsityOp = llvm::dyn_cast<daphne::InferSparsity>(op))
         // If the operation implements the sparsity inference interface,
         // we apply that.
-        return inferSparsityOp.inferSparsity();
+        return inferSparsityOp.inferSparsity(worstCase);
     else if(op->getNumResults() == 1) {
         // If the operation does not implement the sparsity inference interface
         // and has exactly one result, we utilize its sparsity inference traits.
@@ -173,16 +274,22 @@ std::vector<double> daphne::tryInferSparsity(Operation *op) {
             auto spLhs = getSparsityOrUnknownFromType(op->getOperand(0));
             auto spRhs = getSparsityOrUnknownFromType(op->getOperand(1));
             if(spLhs != -1.0 && spRhs != -1.0)
-                // unbiased estimate
-                sparsity = spLhs + spRhs - spLhs * spRhs;
+                sparsity = worstCase
+                        // the non-zeros of both sides could be disjoint
+                        ? std::min(1.0, spLhs + spRhs)
+                        // unbiased estimate
+                        : spLhs + spRhs - spLhs * spRhs;
         }
 
         if(op->hasTrait<EwSparseIfEither>()) {
             auto spLhs = getSparsityOrUnknownFromType(op->getOperand(0));
             auto spRhs = getSparsityOrUnknownFromType(op->getOperand(1));
             if(spLhs != -1.0 && spRhs != -1.0)
-                // unbiased estimate
-                sparsity = spLhs * spRhs;
+                sparsity = worstCase
+                        // the non-zeros of both sides could be the same
+                        ? std::min(spLhs, spRhs)
+                        // unbiased estimate
+                        : spLhs * spRhs;
             else if (spLhs != -1.0)
                 sparsity = spLhs;
             else if (spRhs != -1.0)
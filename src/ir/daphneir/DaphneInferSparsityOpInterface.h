@@ -82,13 +82,19 @@ namespace mlir::daphne {
  * inferred based on the available information, or if the operation does not
  * have any relevant traits or interfaces, -1.0 (unknown) will be returned for sparsity.
  *
+ * By default, the sparsity is an average-case estimate, assuming the non-zeros of
+ * the arguments are distributed independently and uniformly. Alternatively, it is
+ * a worst-case upper bound, which never underestimates the number of non-zeros,
+ * such that a sparse representation chosen based on it never becomes too dense.
+ *
  * @param op The operation whose results' sparsities shall be inferred.
+ * @param worstCase Whether to infer upper bounds instead of estimates.
  * @return A vector of sparsity. The i-th element in this vector represents the
  * sparsity of the i-th result of the given
  * operation. A value of -1.0 for any sparsity indicates
  * that this number is not known (yet).
  */
-std::vector<double> tryInferSparsity(mlir::Operation* op);
+std::vector<double> tryInferSparsity(mlir::Operation* op, bool worstCase = false);
 }
 
 #endif // SRC_IR_DAPHNEIR_DAPHNEINFERSPARSITYOPINTERFACE_H
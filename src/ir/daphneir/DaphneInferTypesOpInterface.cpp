@@ -142,27 +142,29 @@ std::vector<Type> daphne::SemiJoinOp::inferTypes() {
     };
 }
 
-std::vector<Type> daphne::GroupOp::inferTypes() {
-    MLIRContext * ctx = getContext();
+// The types of the result of a GroupOp or FilterGroupOp.
+template<class GroupLikeOp>
+std::vector<Type> inferTypesGroup(GroupLikeOp op) {
+    MLIRContext * ctx = op.getContext();
     Builder builder(ctx);
 
-    daphne::FrameType arg = frame().getType().dyn_cast<daphne::FrameType>();
+    daphne::FrameType arg = op.frame().getType().dyn_cast<daphne::FrameType>();
 
     std::vector<Type> newColumnTypes;
     std::vector<Value> aggColValues;
     std::vector<std::string> aggFuncNames;
 
-    for(Value t : keyCol()){
+    for(Value t : op.keyCol()){
         //Key Types getting adopted for the new Frame
         newColumnTypes.push_back(getFrameColumnTypeByLabel(arg, t));
     }
 
     // Values get collected in a easier to use Datastructure
-    for(Value t : aggCol()){
+    for(Value t : op.aggCol()){
         aggColValues.push_back(t);
     }
     // Function names get collected in a easier to use Datastructure
-    for(Attribute t: aggFuncs()){
+    for(Attribute t: op.aggFuncs()){
         GroupEnum aggFuncValue = t.dyn_cast<GroupEnumAttr>().getValue();
         aggFuncNames.push_back(stringifyGroupEnum(aggFuncValue).str());
     }
@@ -181,6 +183,14 @@ std::vector<Type> daphne::GroupOp::inferTypes() {
     return {daphne::FrameType::get(ctx, newColumnTypes)};
 }
 
+std::vector<Type> daphne::GroupOp::inferTypes() {
+    return inferTypesGroup(*this);
+}
+
+std::vector<Type> daphne::FilterGroupOp::inferTypes() {
+    return inferTypesGroup(*this);
+}
+
 std::vector<Type> daphne::ExtractOp::inferTypes() {
     throw std::runtime_error("type inference not implemented for ExtractOp"); // TODO
 }
@@ -200,6 +210,16 @@ std::vector<Type> daphne::OrderOp::inferTypes() {
     return {t};
 }
 
+std::vector<Type> daphne::OrderTopKOp::inferTypes() {
+    Type srcType = arg().getType();
+    Type t;
+    if(auto mt = srcType.dyn_cast<daphne::MatrixType>())
+        t = mt.withSameElementType();
+    else if(auto ft = srcType.dyn_cast<daphne::FrameType>())
+        t = ft.withSameColumnTypes();
+    return {t};
+}
+
 std::vector<Type> daphne::SliceColOp::inferTypes() {
     throw std::runtime_error("type inference not implemented for SliceColOp"); // TODO
 }
@@ -15,7 +15,9 @@
  */
 
 #include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
 
+#include <optional>
 #include <vector>
 
 namespace mlir::daphne
@@ -46,6 +48,16 @@ std::vector<daphne::VectorCombine> getVectorCombines_EwBinaryOp(EwBinaryOp *op)
     return {daphne::VectorCombine::ROWS};
 }
 template<class EwBinaryOp>
+std::vector<daphne::VectorSplit> getVectorSplitsByCols_EwBinaryOp(EwBinaryOp *op)
+{
+    // Matrix -> column-wise, Scalar -> none
+    auto lhsSplit =
+        op->lhs().getType().template isa<daphne::MatrixType>() ? daphne::VectorSplit::COLS : daphne::VectorSplit::NONE;
+    auto rhsSplit =
+        op->rhs().getType().template isa<daphne::MatrixType>() ? daphne::VectorSplit::COLS : daphne::VectorSplit::NONE;
+    return {lhsSplit, rhsSplit};
+}
+template<class EwBinaryOp>
 std::vector<std::pair<Value, Value>> createOpsOutputSizes_EwBinaryOp(EwBinaryOp *op, OpBuilder &builder)
 {
     auto loc = op->getLoc();
@@ -115,8 +127,38 @@ std::vector<std::pair<Value, Value>> createOpsOutputSizes_ColAggOp(ColAggOp *op,
 
 // ----------------------------------------------------------------------------
 // Matrix multiplication
+// The strategy depends on the transpositions (see MatMulOp::canonicalize) and the ATTR_BROADCAST_LHS chosen by the
+// VectorizeComputationsPass: `A @ B` splits the rows of `A` and broadcasts `B`, `A @ t(B)` alternatively splits the
+// rows of `B` (i.e., the columns of the result) and broadcasts `A`, and `t(A) @ B` splits the rows of both, such that
+// each task computes a partial sum of the whole result. `t(A) @ t(B)` and unknown transpositions are not vectorized.
+namespace {
+    std::optional<bool> getConstantFlag(Value v) {
+        if(auto co = v.getDefiningOp<daphne::ConstantOp>())
+            if(auto attr = co.value().dyn_cast<BoolAttr>())
+                return attr.getValue();
+        return std::nullopt;
+    }
+}
 std::vector<daphne::VectorSplit> daphne::MatMulOp::getVectorSplits()
 {
+    auto ta = getConstantFlag(transa());
+    auto tb = getConstantFlag(transb());
+    if(!ta || !tb || (*ta && *tb))
+        return {};
+    if(*ta)
+        return {
+            daphne::VectorSplit::ROWS, // lhs
+            daphne::VectorSplit::ROWS, // rhs
+            daphne::VectorSplit::NONE, // transa
+            daphne::VectorSplit::NONE  // transb
+        };
+    if(*tb && getOperation()->hasAttr(daphne::ATTR_BROADCAST_LHS))
+        return {
+            daphne::VectorSplit::NONE, // lhs
+            daphne::VectorSplit::ROWS, // rhs
+            daphne::VectorSplit::NONE, // transa
+            daphne::VectorSplit::NONE  // transb
+        };
     return {
         daphne::VectorSplit::ROWS, // lhs
         daphne::VectorSplit::NONE, // rhs
@@ -126,14 +168,25 @@ std::vector<daphne::VectorSplit> daphne::MatMulOp::getVectorSplits()
 }
 std::vector<daphne::VectorCombine> daphne::MatMulOp::getVectorCombines()
 {
+    auto splits = getVectorSplits();
+    if(splits.empty())
+        return {};
+    if(splits[0] == daphne::VectorSplit::ROWS && splits[1] == daphne::VectorSplit::ROWS)
+        return {daphne::VectorCombine::ADD};
+    if(splits[1] == daphne::VectorSplit::ROWS)
+        return {daphne::VectorCombine::COLS};
     return {daphne::VectorCombine::ROWS};
 }
 std::vector<std::pair<Value, Value>> daphne::MatMulOp::createOpsOutputSizes(OpBuilder &builder)
 {
     auto loc = getLoc();
     auto sizeTy = builder.getIndexType();
-    auto rows = builder.create<daphne::NumRowsOp>(loc, sizeTy, lhs());
-    auto cols = builder.create<daphne::NumColsOp>(loc, sizeTy, rhs());
+    Value rows = getConstantFlag(transa()).value_or(false)
+            ? static_cast<Value>(builder.create<daphne::NumColsOp>(loc, sizeTy, lhs()))
+            : static_cast<Value>(builder.create<daphne::NumRowsOp>(loc, sizeTy, lhs()));
+    Value cols = getConstantFlag(transb()).value_or(false)
+            ? static_cast<Value>(builder.create<daphne::NumRowsOp>(loc, sizeTy, rhs()))
+            : static_cast<Value>(builder.create<daphne::NumColsOp>(loc, sizeTy, rhs()));
     return {{rows, cols}};
 }
 // ----------------------------------------------------------------------------
@@ -147,6 +200,12 @@ std::vector<std::pair<Value, Value>> daphne::MatMulOp::createOpsOutputSizes(OpBu
     std::vector<daphne::VectorCombine> daphne::OP::getVectorCombines() { \
         return getVectorCombines_EwBinaryOp(this); \
     } \
+    std::vector<daphne::VectorSplit> daphne::OP::getVectorSplitsByCols() { \
+        return getVectorSplitsByCols_EwBinaryOp(this); \
+    } \
+    std::vector<daphne::VectorCombine> daphne::OP::getVectorCombinesByCols() { \
+        return {daphne::VectorCombine::COLS}; \
+    } \
     std::vector<std::pair<Value, Value>> daphne::OP::createOpsOutputSizes(OpBuilder &builder) { \
         return createOpsOutputSizes_EwBinaryOp(this, builder); \
     }
@@ -191,6 +250,12 @@ IMPL_SPLIT_COMBINE_EWBINARYOP(EwGeOp)
     std::vector<daphne::VectorCombine> daphne::OP::getVectorCombines() { \
         return getVectorCombines_EwUnaryOp(this); \
     } \
+    std::vector<daphne::VectorSplit> daphne::OP::getVectorSplitsByCols() { \
+        return {daphne::VectorSplit::COLS}; \
+    } \
+    std::vector<daphne::VectorCombine> daphne::OP::getVectorCombinesByCols() { \
+        return {daphne::VectorCombine::COLS}; \
+    } \
     std::vector<std::pair<Value, Value>> daphne::OP::createOpsOutputSizes(OpBuilder &builder) { \
         return createOpsOutputSizes_EwUnaryOp(this, builder); \
     }
@@ -202,7 +267,8 @@ IMPL_SPLIT_COMBINE_EWUNARYOP(EwSqrtOp)
 
 // ----------------------------------------------------------------------------
 // Aggregations
-// TODO: splitting and combining by column probably makes more sense
+// Split along the aggregated dimension, the parts of the tasks are aggregated by the combine, otherwise they are
+// placed side by side.
 #define IMPL_SPLIT_COMBINE_ROWAGG(OP) \
     std::vector<daphne::VectorSplit> daphne::OP::getVectorSplits() { \
         return getVectorSplits_RowAggOp(this); \
@@ -210,6 +276,9 @@ IMPL_SPLIT_COMBINE_EWUNARYOP(EwSqrtOp)
     std::vector<daphne::VectorCombine> daphne::OP::getVectorCombines() { \
         return getVectorCombines_RowAggOp(this); \
     } \
+    std::vector<daphne::VectorSplit> daphne::OP::getVectorSplitsByCols() { \
+        return {daphne::VectorSplit::COLS}; \
+    } \
     std::vector<std::pair<Value, Value>> daphne::OP::createOpsOutputSizes(OpBuilder &builder) { \
         return createOpsOutputSizes_RowAggOp(this, builder); \
     }
@@ -217,20 +286,48 @@ IMPL_SPLIT_COMBINE_EWUNARYOP(EwSqrtOp)
     std::vector<daphne::VectorSplit> daphne::OP::getVectorSplits() { \
         return getVectorSplits_ColAggOp(this); \
     } \
+    std::vector<daphne::VectorSplit> daphne::OP::getVectorSplitsByCols() { \
+        return {daphne::VectorSplit::COLS}; \
+    } \
+    std::vector<daphne::VectorCombine> daphne::OP::getVectorCombinesByCols() { \
+        return {daphne::VectorCombine::COLS}; \
+    } \
     std::vector<std::pair<Value, Value>> daphne::OP::createOpsOutputSizes(OpBuilder &builder) { \
         return createOpsOutputSizes_ColAggOp(this, builder); \
     }
 
 // RowAgg
 IMPL_SPLIT_COMBINE_ROWAGG(RowAggMinOp)
+std::vector<daphne::VectorCombine> daphne::RowAggMinOp::getVectorCombinesByCols()
+{
+    return {daphne::VectorCombine::MIN};
+}
 IMPL_SPLIT_COMBINE_ROWAGG(RowAggMaxOp)
+std::vector<daphne::VectorCombine> daphne::RowAggMaxOp::getVectorCombinesByCols()
+{
+    return {daphne::VectorCombine::MAX};
+}
 IMPL_SPLIT_COMBINE_ROWAGG(RowAggSumOp)
+std::vector<daphne::VectorCombine> daphne::RowAggSumOp::getVectorCombinesByCols()
+{
+    return {daphne::VectorCombine::ADD};
+}
 
 IMPL_SPLIT_COMBINE_COLAGG(ColAggSumOp)
 std::vector<daphne::VectorCombine> daphne::ColAggSumOp::getVectorCombines()
 {
     return {daphne::VectorCombine::ADD};
 }
+IMPL_SPLIT_COMBINE_COLAGG(ColAggMinOp)
+std::vector<daphne::VectorCombine> daphne::ColAggMinOp::getVectorCombines()
+{
+    return {daphne::VectorCombine::MIN};
+}
+IMPL_SPLIT_COMBINE_COLAGG(ColAggMaxOp)
+std::vector<daphne::VectorCombine> daphne::ColAggMaxOp::getVectorCombines()
+{
+    return {daphne::VectorCombine::MAX};
+}
 
 #undef IMPL_SPLIT_COMBINE_ROWAGG
 #undef IMPL_SPLIT_COMBINE_COLAGG
@@ -241,6 +338,9 @@ std::vector<daphne::VectorCombine> daphne::ColAggSumOp::getVectorCombines()
 // Left and right indexing
 std::vector<daphne::VectorSplit> daphne::ExtractColOp::getVectorSplits()
 {
+    // the label of a column of a frame is a string, which is not passed to a pipeline
+    if(selectedCols().getType().isa<daphne::StringType>())
+        return {};
     return {daphne::VectorSplit::ROWS, daphne::VectorSplit::NONE};
 }
 std::vector<daphne::VectorCombine> daphne::ExtractColOp::getVectorCombines()
@@ -256,6 +356,28 @@ std::vector<std::pair<Value, Value>> daphne::ExtractColOp::createOpsOutputSizes(
     auto cols = builder.create<daphne::NumRowsOp>(loc, sizeTy, selectedCols());
     return {{rows, cols}};
 }
+
+// Only frames are filtered, since the parts of a frame are concatenated, while the parts of a matrix are placed at the
+// rows they were computed from (see `VectorizedDataSink`).
+std::vector<daphne::VectorSplit> daphne::FilterRowOp::getVectorSplits()
+{
+    if(!source().getType().isa<daphne::FrameType>())
+        return {};
+    return {daphne::VectorSplit::ROWS, daphne::VectorSplit::ROWS};
+}
+std::vector<daphne::VectorCombine> daphne::FilterRowOp::getVectorCombines()
+{
+    return {daphne::VectorCombine::ROWS};
+}
+std::vector<std::pair<Value, Value>> daphne::FilterRowOp::createOpsOutputSizes(OpBuilder &builder)
+{
+    auto loc = getLoc();
+    auto sizeTy = builder.getIndexType();
+    // an upper bound of the rows, which the VectorizeComputationsPass does not use for the result
+    auto rows = builder.create<daphne::NumRowsOp>(loc, sizeTy, source());
+    auto cols = builder.create<daphne::NumColsOp>(loc, sizeTy, source());
+    return {{rows, cols}};
+}
 // ----------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------
@@ -268,6 +390,14 @@ std::vector<daphne::VectorCombine> daphne::TransposeOp::getVectorCombines()
 {
     return {daphne::VectorCombine::COLS};
 }
+std::vector<daphne::VectorSplit> daphne::TransposeOp::getVectorSplitsByCols()
+{
+    return {daphne::VectorSplit::COLS};
+}
+std::vector<daphne::VectorCombine> daphne::TransposeOp::getVectorCombinesByCols()
+{
+    return {daphne::VectorCombine::ROWS};
+}
 std::vector<std::pair<Value, Value>> daphne::TransposeOp::createOpsOutputSizes(OpBuilder &builder)
 {
     auto loc = getLoc();
@@ -303,6 +433,30 @@ std::vector<std::pair<Value, Value>> daphne::ColBindOp::createOpsOutputSizes(OpB
 
 // ----------------------------------------------------------------------------
 // Other
+// Casts between frames and matrices convert every row on its own. Other casts (of scalars, or of the value type or
+// representation of a matrix) are not vectorized.
+std::vector<daphne::VectorSplit> daphne::CastOp::getVectorSplits()
+{
+    auto argTy = arg().getType();
+    auto resTy = res().getType();
+    if((argTy.isa<daphne::FrameType>() && resTy.isa<daphne::MatrixType>())
+            || (argTy.isa<daphne::MatrixType>() && resTy.isa<daphne::FrameType>()))
+        return {daphne::VectorSplit::ROWS};
+    return {};
+}
+std::vector<daphne::VectorCombine> daphne::CastOp::getVectorCombines()
+{
+    return {daphne::VectorCombine::ROWS};
+}
+std::vector<std::pair<Value, Value>> daphne::CastOp::createOpsOutputSizes(OpBuilder &builder)
+{
+    auto loc = getLoc();
+    auto sizeTy = builder.getIndexType();
+    auto rows = builder.create<daphne::NumRowsOp>(loc, sizeTy, arg());
+    auto cols = builder.create<daphne::NumColsOp>(loc, sizeTy, arg());
+    return {{rows, cols}};
+}
+
 std::vector<daphne::VectorSplit> daphne::SyrkOp::getVectorSplits()
 {
     return {daphne::VectorSplit::ROWS};
@@ -26,34 +26,125 @@
 #include <string>
 
 namespace mlir::daphne {
+    // The work of the InferencePass until the fixpoint, summed up over its runs, see CompileStatistics.
+    struct InferenceStatistics {
+        size_t numRuns = 0;
+        // the ops taken from the worklist, and the ones whose results got more precise types
+        size_t numVisits = 0;
+        size_t numRefined = 0;
+        // the ops folded and rewritten by canonicalization patterns
+        size_t numFolded = 0;
+        size_t numRewritten = 0;
+        // the runs stopped by the limit of visits before reaching the fixpoint
+        size_t numNotConverged = 0;
+    };
+
     struct InferenceConfig {
         InferenceConfig(bool partialInferenceAllowed,
                         bool typeInference,
                         bool shapeInference,
                         bool frameLabelInference,
-                        bool sparsityInference);
+                        bool sparsityInference,
+                        bool sparsityWorstCase = false,
+                        bool fixpoint = false);
         bool partialInferenceAllowed;
         bool typeInference;
         bool shapeInference;
         bool frameLabelInference;
         bool sparsityInference;
+        // infer upper bounds of the sparsity instead of estimates, see daphne::tryInferSparsity
+        bool sparsityWorstCase;
+        // canonicalize the ops and infer the properties of the users of changed values again until nothing changes
+        bool fixpoint;
+        // where the work of the fixpoint is counted, if not null
+        InferenceStatistics * statistics = nullptr;
     };
 
+    // The attribute of the constant of the address of the user config, which
+    // the InsertDaphneContextPass passes to the CreateDaphneContextOp, and the
+    // external symbol it is lowered to. The JIT defines the symbol, such that
+    // the compiled code does not depend on the address (see JitObjectCache).
+    inline const std::string ATTR_USERCONFIG = "daphne.userConfig";
+    inline const std::string SYMBOL_USERCONFIG = "_daphne_user_config";
+
+    // The function of the remainder of `main` after an adaptive checkpoint, which is compiled at run-time for the
+    // actual properties of its arguments, see AdaptiveCheckpointsPass and AdaptiveRecompiler.
+    inline const std::string ADAPTIVE_TAIL_FUNC = "adaptive_tail";
+
+    // The static shape of an op (e.g., "2x3"), for which a kernel with completely unrolled loops is called, see
+    // MarkStaticShapeOpsPass.
+    inline const std::string ATTR_STATIC_SHAPE = "daphne.staticShape";
+
+    // The estimated floating-point operations, bytes read, and bytes written of one execution of an op, see
+    // EstimateCostsPass.
+    inline const std::string ATTR_COST_FLOPS = "daphne.costFlops";
+    inline const std::string ATTR_COST_BYTES_READ = "daphne.costBytesRead";
+    inline const std::string ATTR_COST_BYTES_WRITTEN = "daphne.costBytesWritten";
+
+    // Whether each result of a distributed pipeline stays at the workers instead of being collected, as it is only
+    // the input of later distributed pipelines, see DistributePipelinesPass. Set on the `dist` function of the IR
+    // fragment.
+    inline const std::string ATTR_RESIDENT_OUTPUTS = "daphne.residentOutputs";
+
+    // Whether a matrix multiplication `A @ t(B)` splits the rows of `B` and broadcasts `A` instead of the other way
+    // round, since `A` is the smaller one, see VectorizeComputationsPass and MatMulOp::getVectorSplits.
+    inline const std::string ATTR_BROADCAST_LHS = "daphne.broadcastLhs";
+
+    // Whether a join or group-by of frames calls the kernel computing it at the distributed workers (e.g.,
+    // `_distributedInnerJoin` instead of `_innerJoin`), see DistributePipelinesPass and DistributedShuffle.
+    inline const std::string ATTR_DISTRIBUTED = "daphne.distributed";
+
+    // Whether the input frames of a join or group-by are sorted by its key columns (see `FrameType::getSortedBy`),
+    // such that it calls a merge join (`_sortedInnerJoin`) or a streaming aggregation (`_sortedGroup`) instead of
+    // hashing or ordering the rows, see `InnerJoinOp::canonicalize` and `GroupOp::canonicalize`.
+    inline const std::string ATTR_SORTED_KEYS = "daphne.sortedKeys";
+
+    // The execution hints of the DaphneDSL annotations of a statement (e.g., `@vectorize(threads=16,
+    // schedule="GSS")`), which the DaphneDSLVisitor sets on the matrix and frame ops of the statement and which
+    // override the user config for these ops: whether the op is vectorized (bool), the number of CPU threads (i64)
+    // and the partitioning scheme (string, as in the user config) of its pipeline, see VectorizeComputationsPass and
+    // MTWrapper, the representation of its matrix results ("dense" or "sparse"), see
+    // SelectMatrixRepresentationsPass, its device ("cpu" or "gpu"), see MarkCUDAOpsPass, and whether its pipeline is
+    // distributed (bool), see DistributePipelinesPass.
+    inline const std::string ATTR_HINT_VECTORIZE = "daphne.hintVectorize";
+    inline const std::string ATTR_HINT_NUM_THREADS = "daphne.hintNumThreads";
+    inline const std::string ATTR_HINT_SCHEDULE = "daphne.hintSchedule";
+    inline const std::string ATTR_HINT_REPRESENTATION = "daphne.hintRepresentation";
+    inline const std::string ATTR_HINT_DEVICE = "daphne.hintDevice";
+    inline const std::string ATTR_HINT_DISTRIBUTED = "daphne.hintDistributed";
+
     // alphabetically sorted list of passes
+    std::unique_ptr<Pass> createAdaptiveCheckpointsPass();
     std::unique_ptr<Pass> createAdaptTypesToKernelsPass();
+    std::unique_ptr<Pass> createAlgebraicSimplificationPass();
+    std::unique_ptr<Pass> createCheckpointLoopsPass(const DaphneUserConfig& cfg);
     std::unique_ptr<Pass> createDistributeComputationsPass();
-    std::unique_ptr<Pass> createDistributePipelinesPass();
+    std::unique_ptr<Pass> createDistributePipelinesPass(const DaphneUserConfig& cfg);
+    std::unique_ptr<Pass> createEstimateCostsPass(bool explain = false);
+    std::unique_ptr<Pass> createFoldConstantMatricesPass(const DaphneUserConfig& cfg);
+    std::unique_ptr<Pass> createFuseEwiseOpsPass();
+    std::unique_ptr<Pass> createFuseSqlExprsPass();
+    std::unique_ptr<Pass> createInlineFunctionsPass();
     std::unique_ptr<Pass> createInferencePass(InferenceConfig cfg = {false, true, true, true, true});
     std::unique_ptr<Pass> createInsertDaphneContextPass(const DaphneUserConfig& cfg);
+    std::unique_ptr<Pass> createLoopInvariantCodeMotionPass();
     std::unique_ptr<Pass> createLowerToLLVMPass(const DaphneUserConfig& cfg);
     std::unique_ptr<Pass> createManageObjRefsPass();
+    std::unique_ptr<Pass> createMarkStaticShapeOpsPass();
+    std::unique_ptr<Pass> createMatrixCSEPass();
+    std::unique_ptr<Pass> createOptimizeSqlPass();
+    std::unique_ptr<Pass> createPlanMemoryPass();
+    std::unique_ptr<Pass> createPrefetchReadsPass();
     std::unique_ptr<Pass> createPrintIRPass(std::string message = "");
+    std::unique_ptr<Pass> createProfileKernelsPass();
+    std::unique_ptr<Pass> createPushDownBloomFiltersPass();
+    std::unique_ptr<Pass> createRewriteLoopsToMatrixOpsPass(bool explain = false);
     std::unique_ptr<Pass> createRewriteSqlOpPass();
     std::unique_ptr<Pass> createRewriteToCallKernelOpPass();
-    std::unique_ptr<Pass> createSelectMatrixRepresentationsPass();
+    std::unique_ptr<Pass> createSelectMatrixRepresentationsPass(const DaphneUserConfig& cfg, bool hintsOnly = false);
     std::unique_ptr<Pass> createSpecializeGenericFunctionsPass();
-    std::unique_ptr<Pass> createVectorizeComputationsPass();
-    std::unique_ptr<Pass> createWhileLoopInvariantCodeMotionPass();
+    std::unique_ptr<Pass> createTrackMemoryPass();
+    std::unique_ptr<Pass> createVectorizeComputationsPass(const DaphneUserConfig& cfg);
 #ifdef USE_CUDA
     std::unique_ptr<Pass> createMarkCUDAOpsPass(const DaphneUserConfig& cfg);
 #endif
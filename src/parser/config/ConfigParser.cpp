@@ -30,10 +30,16 @@ bool ConfigParser::fileExists(const std::string& filename) {
 
 void ConfigParser::readUserConfig(const std::string& filename, DaphneUserConfig& config) {
     std::ifstream ifs(filename);
-    nlohmann::basic_json jf = nlohmann::json::parse(ifs);
+    readUserConfig(nlohmann::json::parse(ifs), filename, config);
+}
+
+void ConfigParser::readUserConfigFromString(const std::string& jsonStr, DaphneUserConfig& config) {
+    readUserConfig(nlohmann::json::parse(jsonStr), "distributed_worker_config", config);
+}
 
+void ConfigParser::readUserConfig(const nlohmann::json& jf, const std::string& source, DaphneUserConfig& config) {
 //try {
-    checkAnyUnexpectedKeys(jf, filename);   // raise an error if the config JSON file contains any unexpected keys
+    checkAnyUnexpectedKeys(jf, source);   // raise an error if the config JSON file contains any unexpected keys
 
     if (keyExists(jf, DaphneConfigJsonParams::USE_CUDA_))
         config.use_cuda = jf.at(DaphneConfigJsonParams::USE_CUDA_).get<bool>();
@@ -43,8 +49,90 @@ void ConfigParser::readUserConfig(const std::string& filename, DaphneUserConfig&
         config.use_obj_ref_mgnt = jf.at(DaphneConfigJsonParams::USE_OBJ_REF_MGNT).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::CUDA_FUSE_ANY))
         config.cuda_fuse_any = jf.at(DaphneConfigJsonParams::CUDA_FUSE_ANY).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::CUDA_PRECISION))
+        config.cuda_precision = jf.at(DaphneConfigJsonParams::CUDA_PRECISION).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::CUDA_LOSS_SCALE))
+        config.cuda_loss_scale = jf.at(DaphneConfigJsonParams::CUDA_LOSS_SCALE).get<float>();
+    if (keyExists(jf, DaphneConfigJsonParams::CUDA_GRAPHS))
+        config.cuda_graphs = jf.at(DaphneConfigJsonParams::CUDA_GRAPHS).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_SINGLE_QUEUE))
         config.vectorized_single_queue = jf.at(DaphneConfigJsonParams::VECTORIZED_SINGLE_QUEUE).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::FAST_MATH))
+        config.fast_math = jf.at(DaphneConfigJsonParams::FAST_MATH).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::CPU_ISA))
+        config.cpu_isa = jf.at(DaphneConfigJsonParams::CPU_ISA).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::CPU_DISPATCH_STATS))
+        config.cpu_dispatch_stats = jf.at(DaphneConfigJsonParams::CPU_DISPATCH_STATS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::JIT_OPT_LEVEL)) {
+        config.jit_opt_level = jf.at(DaphneConfigJsonParams::JIT_OPT_LEVEL).get<int>();
+        if (config.jit_opt_level < 0 || config.jit_opt_level > 3)
+            throw std::invalid_argument("Invalid value for \"jit_opt_level\", which must be between 0 and 3");
+    }
+    if (keyExists(jf, DaphneConfigJsonParams::JIT_NATIVE_TARGET))
+        config.jit_native_target = jf.at(DaphneConfigJsonParams::JIT_NATIVE_TARGET).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::COMPILE_THREADS)) {
+        config.compile_threads = jf.at(DaphneConfigJsonParams::COMPILE_THREADS).get<int>();
+        if (config.compile_threads < 0)
+            throw std::invalid_argument("Invalid value for \"compile_threads\", which must not be negative");
+    }
+    if (keyExists(jf, DaphneConfigJsonParams::TIMING_PASSES))
+        config.timing_passes = jf.at(DaphneConfigJsonParams::TIMING_PASSES).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::TIMING_PHASES))
+        config.timing_phases = jf.at(DaphneConfigJsonParams::TIMING_PHASES).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::COMPILE_STATISTICS))
+        config.compile_statistics = jf.at(DaphneConfigJsonParams::COMPILE_STATISTICS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::COMPILE_STATISTICS_FILE))
+        config.compile_statistics_file = jf.at(DaphneConfigJsonParams::COMPILE_STATISTICS_FILE).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::PROFILE_KERNELS))
+        config.profile_kernels = jf.at(DaphneConfigJsonParams::PROFILE_KERNELS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::PROFILE_PERF_COUNTERS))
+        config.profile_perf_counters = jf.at(DaphneConfigJsonParams::PROFILE_PERF_COUNTERS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::PROFILE_TRACE_FILE))
+        config.profile_trace_file = jf.at(DaphneConfigJsonParams::PROFILE_TRACE_FILE).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::MACHINE_PEAK_GFLOPS))
+        config.machine_peak_gflops = jf.at(DaphneConfigJsonParams::MACHINE_PEAK_GFLOPS).get<double>();
+    if (keyExists(jf, DaphneConfigJsonParams::MACHINE_PEAK_GBPS))
+        config.machine_peak_gbps = jf.at(DaphneConfigJsonParams::MACHINE_PEAK_GBPS).get<double>();
+    if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_TRACE_FILE))
+        config.vectorized_trace_file = jf.at(DaphneConfigJsonParams::VECTORIZED_TRACE_FILE).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_AUTOTUNE))
+        config.vectorized_autotune = jf.at(DaphneConfigJsonParams::VECTORIZED_AUTOTUNE).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_AUTOTUNE_PROFILE))
+        config.vectorized_autotune_profile =
+                jf.at(DaphneConfigJsonParams::VECTORIZED_AUTOTUNE_PROFILE).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::JIT_CACHE_DIR))
+        config.jit_cache_dir = jf.at(DaphneConfigJsonParams::JIT_CACHE_DIR).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::PARSE_CACHE_DIR))
+        config.parse_cache_dir = jf.at(DaphneConfigJsonParams::PARSE_CACHE_DIR).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::FUSE_EWISE))
+        config.fuse_ewise = jf.at(DaphneConfigJsonParams::FUSE_EWISE).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::MATRIX_CSE_LICM))
+        config.matrix_cse_licm = jf.at(DaphneConfigJsonParams::MATRIX_CSE_LICM).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::CONSTANT_FOLDING_MAX_BYTES))
+        config.constant_folding_max_bytes = jf.at(DaphneConfigJsonParams::CONSTANT_FOLDING_MAX_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::ALGEBRAIC_SIMPLIFICATION))
+        config.algebraic_simplification = jf.at(DaphneConfigJsonParams::ALGEBRAIC_SIMPLIFICATION).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::LOOP_REWRITE))
+        config.loop_rewrite = jf.at(DaphneConfigJsonParams::LOOP_REWRITE).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::SQL_OPTIMIZATION))
+        config.sql_optimization = jf.at(DaphneConfigJsonParams::SQL_OPTIMIZATION).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::FUNCTION_INLINING))
+        config.function_inlining = jf.at(DaphneConfigJsonParams::FUNCTION_INLINING).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::SPARSE_THRESHOLD)) {
+        config.sparse_threshold = jf.at(DaphneConfigJsonParams::SPARSE_THRESHOLD).get<double>();
+        if (config.sparse_threshold <= 0 || config.sparse_threshold > 1)
+            throw std::invalid_argument("Invalid value for \"sparse_threshold\", which must be in (0, 1]");
+    }
+    if (keyExists(jf, DaphneConfigJsonParams::SPARSE_COST_MODEL))
+        config.sparse_cost_model = jf.at(DaphneConfigJsonParams::SPARSE_COST_MODEL).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::SPARSITY_WORST_CASE))
+        config.sparsity_worst_case = jf.at(DaphneConfigJsonParams::SPARSITY_WORST_CASE).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::ADAPTIVE_EXECUTION))
+        config.adaptive_execution = jf.at(DaphneConfigJsonParams::ADAPTIVE_EXECUTION).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::STATIC_SHAPE_KERNELS))
+        config.static_shape_kernels = jf.at(DaphneConfigJsonParams::STATIC_SHAPE_KERNELS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::TIMEOUT_SECONDS))
+        config.timeout_seconds = jf.at(DaphneConfigJsonParams::TIMEOUT_SECONDS).get<double>();
     if (keyExists(jf, DaphneConfigJsonParams::DEBUG_LLVM))
         config.debug_llvm = jf.at(DaphneConfigJsonParams::DEBUG_LLVM).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::EXPLAIN_KERNELS))
@@ -65,6 +153,10 @@ void ConfigParser::readUserConfig(const std::string& filename, DaphneUserConfig&
         config.explain_vectorized = jf.at(DaphneConfigJsonParams::EXPLAIN_VECTORIZED).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::EXPLAIN_OBJ_REF_MGNT))
         config.explain_obj_ref_mgnt = jf.at(DaphneConfigJsonParams::EXPLAIN_OBJ_REF_MGNT).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::EXPLAIN_COST))
+        config.explain_cost = jf.at(DaphneConfigJsonParams::EXPLAIN_COST).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::EXPLAIN_LOOPS))
+        config.explain_loops = jf.at(DaphneConfigJsonParams::EXPLAIN_LOOPS).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::TASK_PARTITIONING_SCHEME)) {
         config.taskPartitioningScheme = jf.at(DaphneConfigJsonParams::TASK_PARTITIONING_SCHEME).get<SelfSchedulingScheme>();
         if (config.taskPartitioningScheme == SelfSchedulingScheme::INVALID) {
@@ -75,6 +167,94 @@ void ConfigParser::readUserConfig(const std::string& filename, DaphneUserConfig&
         config.numberOfThreads = jf.at(DaphneConfigJsonParams::NUMBER_OF_THREADS).get<int>();
     if (keyExists(jf, DaphneConfigJsonParams::MINIMUM_TASK_SIZE))
         config.minimumTaskSize = jf.at(DaphneConfigJsonParams::MINIMUM_TASK_SIZE).get<int>();
+    if (keyExists(jf, DaphneConfigJsonParams::BUFFER_POOL_MAX_CACHED_BYTES))
+        config.buffer_pool_max_cached_bytes = jf.at(DaphneConfigJsonParams::BUFFER_POOL_MAX_CACHED_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::BUFFER_POOL_HUGE_PAGES))
+        config.buffer_pool_huge_pages = jf.at(DaphneConfigJsonParams::BUFFER_POOL_HUGE_PAGES).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::TRACK_MEMORY))
+        config.track_memory = jf.at(DaphneConfigJsonParams::TRACK_MEMORY).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::MEMORY_LIMIT_BYTES))
+        config.memory_limit_bytes = jf.at(DaphneConfigJsonParams::MEMORY_LIMIT_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::SPILL_BUDGET_BYTES))
+        config.spill_budget_bytes = jf.at(DaphneConfigJsonParams::SPILL_BUDGET_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::SPILL_DIR))
+        config.spill_dir = jf.at(DaphneConfigJsonParams::SPILL_DIR).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::SPILL_COMPRESSION))
+        config.spill_compression = jf.at(DaphneConfigJsonParams::SPILL_COMPRESSION).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::REUSE_CACHE_BYTES))
+        config.reuse_cache_bytes = jf.at(DaphneConfigJsonParams::REUSE_CACHE_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::MMAP_DAPHNE_FILES))
+        config.mmap_daphne_files = jf.at(DaphneConfigJsonParams::MMAP_DAPHNE_FILES).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::DAPHNE_FILE_BLOCK_ROWS))
+        config.daphne_file_block_rows = jf.at(DaphneConfigJsonParams::DAPHNE_FILE_BLOCK_ROWS).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::DAPHNE_FILE_COMPRESSION))
+        config.daphne_file_compression = jf.at(DaphneConfigJsonParams::DAPHNE_FILE_COMPRESSION).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::OBJECT_STORE_CACHE))
+        config.object_store_cache = jf.at(DaphneConfigJsonParams::OBJECT_STORE_CACHE).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::OBJECT_STORE_CONNECTIONS))
+        config.object_store_connections = jf.at(DaphneConfigJsonParams::OBJECT_STORE_CONNECTIONS).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_STREAM_READ))
+        config.vectorized_stream_read = jf.at(DaphneConfigJsonParams::VECTORIZED_STREAM_READ).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_STREAM_CHUNK_ROWS))
+        config.vectorized_stream_chunk_rows = jf.at(DaphneConfigJsonParams::VECTORIZED_STREAM_CHUNK_ROWS).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::NUMA_REPLICATE_BROADCAST_BYTES))
+        config.numa_replicate_broadcast_bytes =
+                jf.at(DaphneConfigJsonParams::NUMA_REPLICATE_BROADCAST_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_COST_MODEL))
+        config.vectorized_cost_model = jf.at(DaphneConfigJsonParams::VECTORIZED_COST_MODEL).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::PREFETCH_READS))
+        config.prefetch_reads = jf.at(DaphneConfigJsonParams::PREFETCH_READS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::ZONE_MAPS))
+        config.zone_maps = jf.at(DaphneConfigJsonParams::ZONE_MAPS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::KEY_INDEXES))
+        config.key_indexes = jf.at(DaphneConfigJsonParams::KEY_INDEXES).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::BLOOM_FILTERS))
+        config.bloom_filters = jf.at(DaphneConfigJsonParams::BLOOM_FILTERS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::COLUMN_STATISTICS))
+        config.column_statistics = jf.at(DaphneConfigJsonParams::COLUMN_STATISTICS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_BACKEND))
+        config.distributed_backend = jf.at(DaphneConfigJsonParams::DISTRIBUTED_BACKEND).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_CHUNK_BYTES))
+        config.distributed_chunk_bytes = jf.at(DaphneConfigJsonParams::DISTRIBUTED_CHUNK_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_COLLECTIVES_MIN_WORKERS))
+        config.distributed_collectives_min_workers = jf.at(DaphneConfigJsonParams::DISTRIBUTED_COLLECTIVES_MIN_WORKERS).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_RELATIONAL_MIN_ROWS))
+        config.distributed_relational_min_rows = jf.at(DaphneConfigJsonParams::DISTRIBUTED_RELATIONAL_MIN_ROWS).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_BROADCAST_JOIN_BYTES))
+        config.distributed_broadcast_join_bytes = jf.at(DaphneConfigJsonParams::DISTRIBUTED_BROADCAST_JOIN_BYTES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_LOAD_BALANCING))
+        config.distributed_load_balancing = jf.at(DaphneConfigJsonParams::DISTRIBUTED_LOAD_BALANCING).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_SPECULATION_FACTOR))
+        config.distributed_speculation_factor = jf.at(DaphneConfigJsonParams::DISTRIBUTED_SPECULATION_FACTOR).get<double>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_READ_AT_WORKERS))
+        config.distributed_read_at_workers = jf.at(DaphneConfigJsonParams::DISTRIBUTED_READ_AT_WORKERS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_ASYNC))
+        config.distributed_async = jf.at(DaphneConfigJsonParams::DISTRIBUTED_ASYNC).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_COMPRESSION))
+        config.distributed_compression = jf.at(DaphneConfigJsonParams::DISTRIBUTED_COMPRESSION).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_MAX_FAILURES))
+        config.distributed_max_failures = jf.at(DaphneConfigJsonParams::DISTRIBUTED_MAX_FAILURES).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_HEARTBEAT_MS))
+        config.distributed_heartbeat_ms = jf.at(DaphneConfigJsonParams::DISTRIBUTED_HEARTBEAT_MS).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::CHECKPOINT_DIR))
+        config.checkpoint_dir = jf.at(DaphneConfigJsonParams::CHECKPOINT_DIR).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::CHECKPOINT_INTERVAL_S))
+        config.checkpoint_interval_s = jf.at(DaphneConfigJsonParams::CHECKPOINT_INTERVAL_S).get<double>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_STATISTICS))
+        config.distributed_statistics = jf.at(DaphneConfigJsonParams::DISTRIBUTED_STATISTICS).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_METRICS_PORT))
+        config.distributed_metrics_port = jf.at(DaphneConfigJsonParams::DISTRIBUTED_METRICS_PORT).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_TRACE_FILE))
+        config.distributed_trace_file = jf.at(DaphneConfigJsonParams::DISTRIBUTED_TRACE_FILE).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::DISTRIBUTED_WORKER_CONFIG)) {
+        const auto &workerConfig = jf.at(DaphneConfigJsonParams::DISTRIBUTED_WORKER_CONFIG);
+        if (!workerConfig.is_object())
+            throw std::invalid_argument("Invalid value for \"distributed_worker_config\", which must be an object");
+        // Check the keys and values here already, instead of at the workers.
+        DaphneUserConfig checkedConfig;
+        readUserConfig(workerConfig, source + ": distributed_worker_config", checkedConfig);
+        config.distributed_worker_config = workerConfig.empty() ? "" : workerConfig.dump();
+    }
 #ifdef USE_CUDA
     if (keyExists(jf, DaphneConfigJsonParams::CUDA_DEVICES))
         config.cuda_devices = jf.at(DaphneConfigJsonParams::CUDA_DEVICES).get<std::vector<int>>();
@@ -35,14 +35,22 @@ NLOHMANN_JSON_SERIALIZE_ENUM(SelfSchedulingScheme, {
     {PLS, "PLS"},
     {MSTATIC, "MSTATIC"},
     {MFSC, "MFSC"},
-    {PSS, "PSS"}
+    {PSS, "PSS"},
+    {AWF, "AWF"},
+    {AF, "AF"}
 })
 
 class ConfigParser {
 public:
     static bool fileExists(const std::string& filename);
     static void readUserConfig(const std::string& filename, DaphneUserConfig& config);
+    /**
+     * @brief Overrides the given user config by the keys of the given JSON
+     * object, e.g., the config of the distributed workers sent with a task.
+     */
+    static void readUserConfigFromString(const std::string& jsonStr, DaphneUserConfig& config);
 private:
+    static void readUserConfig(const nlohmann::json& jf, const std::string& source, DaphneUserConfig& config);
     static bool keyExists(const nlohmann::json& j, const std::string& key);
     static void checkAnyUnexpectedKeys(const nlohmann::basic_json<>& j, const std::string& filename);
 };
@@ -29,7 +29,43 @@ struct DaphneConfigJsonParams {
     inline static const std::string USE_VECTORIZED_EXEC = "use_vectorized_exec";
     inline static const std::string USE_OBJ_REF_MGNT = "use_obj_ref_mgnt";
     inline static const std::string CUDA_FUSE_ANY = "cuda_fuse_any";
+    inline static const std::string CUDA_PRECISION = "cuda_precision";
+    inline static const std::string CUDA_LOSS_SCALE = "cuda_loss_scale";
+    inline static const std::string CUDA_GRAPHS = "cuda_graphs";
     inline static const std::string VECTORIZED_SINGLE_QUEUE = "vectorized_single_queue";
+    inline static const std::string FAST_MATH = "fast_math";
+    inline static const std::string CPU_ISA = "cpu_isa";
+    inline static const std::string CPU_DISPATCH_STATS = "cpu_dispatch_stats";
+    inline static const std::string JIT_OPT_LEVEL = "jit_opt_level";
+    inline static const std::string JIT_NATIVE_TARGET = "jit_native_target";
+    inline static const std::string COMPILE_THREADS = "compile_threads";
+    inline static const std::string TIMING_PASSES = "timing_passes";
+    inline static const std::string TIMING_PHASES = "timing_phases";
+    inline static const std::string COMPILE_STATISTICS = "compile_statistics";
+    inline static const std::string COMPILE_STATISTICS_FILE = "compile_statistics_file";
+    inline static const std::string PROFILE_KERNELS = "profile_kernels";
+    inline static const std::string PROFILE_PERF_COUNTERS = "profile_perf_counters";
+    inline static const std::string PROFILE_TRACE_FILE = "profile_trace_file";
+    inline static const std::string MACHINE_PEAK_GFLOPS = "machine_peak_gflops";
+    inline static const std::string MACHINE_PEAK_GBPS = "machine_peak_gbps";
+    inline static const std::string VECTORIZED_TRACE_FILE = "vectorized_trace_file";
+    inline static const std::string VECTORIZED_AUTOTUNE = "vectorized_autotune";
+    inline static const std::string VECTORIZED_AUTOTUNE_PROFILE = "vectorized_autotune_profile";
+    inline static const std::string JIT_CACHE_DIR = "jit_cache_dir";
+    inline static const std::string PARSE_CACHE_DIR = "parse_cache_dir";
+    inline static const std::string FUSE_EWISE = "fuse_ewise";
+    inline static const std::string MATRIX_CSE_LICM = "matrix_cse_licm";
+    inline static const std::string CONSTANT_FOLDING_MAX_BYTES = "constant_folding_max_bytes";
+    inline static const std::string ALGEBRAIC_SIMPLIFICATION = "algebraic_simplification";
+    inline static const std::string LOOP_REWRITE = "loop_rewrite";
+    inline static const std::string SQL_OPTIMIZATION = "sql_optimization";
+    inline static const std::string FUNCTION_INLINING = "function_inlining";
+    inline static const std::string SPARSE_THRESHOLD = "sparse_threshold";
+    inline static const std::string SPARSE_COST_MODEL = "sparse_cost_model";
+    inline static const std::string SPARSITY_WORST_CASE = "sparsity_worst_case";
+    inline static const std::string ADAPTIVE_EXECUTION = "adaptive_execution";
+    inline static const std::string STATIC_SHAPE_KERNELS = "static_shape_kernels";
+    inline static const std::string TIMEOUT_SECONDS = "timeout_seconds";
 
     inline static const std::string DEBUG_LLVM = "debug_llvm";
     inline static const std::string EXPLAIN_KERNELS = "explain_kernels";
@@ -41,9 +77,51 @@ struct DaphneConfigJsonParams {
     inline static const std::string EXPLAIN_TYPE_ADAPTATION = "explain_type_adaptation";
     inline static const std::string EXPLAIN_VECTORIZED = "explain_vectorized";
     inline static const std::string EXPLAIN_OBJ_REF_MGNT = "explain_obj_ref_mgnt";
+    inline static const std::string EXPLAIN_COST = "explain_cost";
+    inline static const std::string EXPLAIN_LOOPS = "explain_loops";
     inline static const std::string TASK_PARTITIONING_SCHEME = "taskPartitioningScheme";
     inline static const std::string NUMBER_OF_THREADS = "numberOfThreads";
     inline static const std::string MINIMUM_TASK_SIZE = "minimumTaskSize";
+    inline static const std::string BUFFER_POOL_MAX_CACHED_BYTES = "buffer_pool_max_cached_bytes";
+    inline static const std::string BUFFER_POOL_HUGE_PAGES = "buffer_pool_huge_pages";
+    inline static const std::string TRACK_MEMORY = "track_memory";
+    inline static const std::string MEMORY_LIMIT_BYTES = "memory_limit_bytes";
+    inline static const std::string SPILL_BUDGET_BYTES = "spill_budget_bytes";
+    inline static const std::string SPILL_DIR = "spill_dir";
+    inline static const std::string SPILL_COMPRESSION = "spill_compression";
+    inline static const std::string REUSE_CACHE_BYTES = "reuse_cache_bytes";
+    inline static const std::string MMAP_DAPHNE_FILES = "mmap_daphne_files";
+    inline static const std::string DAPHNE_FILE_BLOCK_ROWS = "daphne_file_block_rows";
+    inline static const std::string DAPHNE_FILE_COMPRESSION = "daphne_file_compression";
+    inline static const std::string OBJECT_STORE_CACHE = "object_store_cache";
+    inline static const std::string OBJECT_STORE_CONNECTIONS = "object_store_connections";
+    inline static const std::string VECTORIZED_STREAM_READ = "vectorized_stream_read";
+    inline static const std::string VECTORIZED_STREAM_CHUNK_ROWS = "vectorized_stream_chunk_rows";
+    inline static const std::string NUMA_REPLICATE_BROADCAST_BYTES = "numa_replicate_broadcast_bytes";
+    inline static const std::string VECTORIZED_COST_MODEL = "vectorized_cost_model";
+    inline static const std::string PREFETCH_READS = "prefetch_reads";
+    inline static const std::string ZONE_MAPS = "zone_maps";
+    inline static const std::string KEY_INDEXES = "key_indexes";
+    inline static const std::string BLOOM_FILTERS = "bloom_filters";
+    inline static const std::string COLUMN_STATISTICS = "column_statistics";
+    inline static const std::string DISTRIBUTED_BACKEND = "distributed_backend";
+    inline static const std::string DISTRIBUTED_CHUNK_BYTES = "distributed_chunk_bytes";
+    inline static const std::string DISTRIBUTED_COLLECTIVES_MIN_WORKERS = "distributed_collectives_min_workers";
+    inline static const std::string DISTRIBUTED_RELATIONAL_MIN_ROWS = "distributed_relational_min_rows";
+    inline static const std::string DISTRIBUTED_BROADCAST_JOIN_BYTES = "distributed_broadcast_join_bytes";
+    inline static const std::string DISTRIBUTED_LOAD_BALANCING = "distributed_load_balancing";
+    inline static const std::string DISTRIBUTED_SPECULATION_FACTOR = "distributed_speculation_factor";
+    inline static const std::string DISTRIBUTED_READ_AT_WORKERS = "distributed_read_at_workers";
+    inline static const std::string DISTRIBUTED_ASYNC = "distributed_async";
+    inline static const std::string DISTRIBUTED_COMPRESSION = "distributed_compression";
+    inline static const std::string DISTRIBUTED_MAX_FAILURES = "distributed_max_failures";
+    inline static const std::string DISTRIBUTED_HEARTBEAT_MS = "distributed_heartbeat_ms";
+    inline static const std::string CHECKPOINT_DIR = "checkpoint_dir";
+    inline static const std::string CHECKPOINT_INTERVAL_S = "checkpoint_interval_s";
+    inline static const std::string DISTRIBUTED_STATISTICS = "distributed_statistics";
+    inline static const std::string DISTRIBUTED_METRICS_PORT = "distributed_metrics_port";
+    inline static const std::string DISTRIBUTED_TRACE_FILE = "distributed_trace_file";
+    inline static const std::string DISTRIBUTED_WORKER_CONFIG = "distributed_worker_config";
 
     inline static const std::string CUDA_DEVICES = "cuda_devices";
 
@@ -56,7 +134,43 @@ struct DaphneConfigJsonParams {
             USE_VECTORIZED_EXEC,
             USE_OBJ_REF_MGNT,
             CUDA_FUSE_ANY,
+            CUDA_PRECISION,
+            CUDA_LOSS_SCALE,
+            CUDA_GRAPHS,
             VECTORIZED_SINGLE_QUEUE,
+            FAST_MATH,
+            CPU_ISA,
+            CPU_DISPATCH_STATS,
+            JIT_OPT_LEVEL,
+            JIT_NATIVE_TARGET,
+            COMPILE_THREADS,
+            TIMING_PASSES,
+            TIMING_PHASES,
+            COMPILE_STATISTICS,
+            COMPILE_STATISTICS_FILE,
+            PROFILE_KERNELS,
+            PROFILE_PERF_COUNTERS,
+            PROFILE_TRACE_FILE,
+            MACHINE_PEAK_GFLOPS,
+            MACHINE_PEAK_GBPS,
+            VECTORIZED_TRACE_FILE,
+            VECTORIZED_AUTOTUNE,
+            VECTORIZED_AUTOTUNE_PROFILE,
+            JIT_CACHE_DIR,
+            PARSE_CACHE_DIR,
+            FUSE_EWISE,
+            MATRIX_CSE_LICM,
+            CONSTANT_FOLDING_MAX_BYTES,
+            ALGEBRAIC_SIMPLIFICATION,
+            LOOP_REWRITE,
+            SQL_OPTIMIZATION,
+            FUNCTION_INLINING,
+            SPARSE_THRESHOLD,
+            SPARSE_COST_MODEL,
+            SPARSITY_WORST_CASE,
+            ADAPTIVE_EXECUTION,
+            STATIC_SHAPE_KERNELS,
+            TIMEOUT_SECONDS,
             DEBUG_LLVM,
             EXPLAIN_KERNELS,
             EXPLAIN_LLVM,
@@ -67,9 +181,51 @@ struct DaphneConfigJsonParams {
             EXPLAIN_TYPE_ADAPTATION,
             EXPLAIN_VECTORIZED,
             EXPLAIN_OBJ_REF_MGNT,
+            EXPLAIN_COST,
+            EXPLAIN_LOOPS,
             TASK_PARTITIONING_SCHEME,
             NUMBER_OF_THREADS,
             MINIMUM_TASK_SIZE,
+            BUFFER_POOL_MAX_CACHED_BYTES,
+            BUFFER_POOL_HUGE_PAGES,
+            TRACK_MEMORY,
+            MEMORY_LIMIT_BYTES,
+            SPILL_BUDGET_BYTES,
+            SPILL_DIR,
+            SPILL_COMPRESSION,
+            REUSE_CACHE_BYTES,
+            MMAP_DAPHNE_FILES,
+            DAPHNE_FILE_BLOCK_ROWS,
+            DAPHNE_FILE_COMPRESSION,
+            OBJECT_STORE_CACHE,
+            OBJECT_STORE_CONNECTIONS,
+            VECTORIZED_STREAM_READ,
+            VECTORIZED_STREAM_CHUNK_ROWS,
+            NUMA_REPLICATE_BROADCAST_BYTES,
+            VECTORIZED_COST_MODEL,
+            PREFETCH_READS,
+            ZONE_MAPS,
+            KEY_INDEXES,
+            BLOOM_FILTERS,
+            COLUMN_STATISTICS,
+            DISTRIBUTED_BACKEND,
+            DISTRIBUTED_CHUNK_BYTES,
+            DISTRIBUTED_COLLECTIVES_MIN_WORKERS,
+            DISTRIBUTED_RELATIONAL_MIN_ROWS,
+            DISTRIBUTED_BROADCAST_JOIN_BYTES,
+            DISTRIBUTED_LOAD_BALANCING,
+            DISTRIBUTED_SPECULATION_FACTOR,
+            DISTRIBUTED_READ_AT_WORKERS,
+            DISTRIBUTED_ASYNC,
+            DISTRIBUTED_COMPRESSION,
+            DISTRIBUTED_MAX_FAILURES,
+            DISTRIBUTED_HEARTBEAT_MS,
+            CHECKPOINT_DIR,
+            CHECKPOINT_INTERVAL_S,
+            DISTRIBUTED_STATISTICS,
+            DISTRIBUTED_METRICS_PORT,
+            DISTRIBUTED_TRACE_FILE,
+            DISTRIBUTED_WORKER_CONFIG,
             CUDA_DEVICES,
             LIB_DIR,
             LIBRARY_PATHS,
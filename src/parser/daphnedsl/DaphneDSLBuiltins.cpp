@@ -22,6 +22,7 @@
 
 #include "antlr4-runtime.h"
 
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -406,6 +407,25 @@ antlrcpp::Any DaphneDSLBuiltins::build(mlir::Location loc, const std::string & f
                 )
         );
     }
+    if(func == "sampleBernoulli") {
+        checkNumArgsExact(func, numArgs, 3);
+        mlir::Value arg = args[0];
+        mlir::Value fraction = utils.castIf(builder.getF64Type(), args[1]);
+        mlir::Value seed = utils.castSeedIf(args[2]);
+        return static_cast<mlir::Value>(
+                builder.create<SampleBernoulliOp>(loc, utils.matrixOfSizeType, arg, fraction, seed)
+        );
+    }
+    if(func == "sampleStratified") {
+        checkNumArgsExact(func, numArgs, 4);
+        mlir::Value arg = args[0];
+        mlir::Value keyCol = utils.castSizeIf(args[1]);
+        mlir::Value fraction = utils.castIf(builder.getF64Type(), args[2]);
+        mlir::Value seed = utils.castSeedIf(args[3]);
+        return static_cast<mlir::Value>(
+                builder.create<SampleStratifiedOp>(loc, utils.matrixOfSizeType, arg, keyCol, fraction, seed)
+        );
+    }
     if(func == "seq") {
         checkNumArgsExact(func, numArgs, 3);
         mlir::Value from = args[0];
@@ -545,6 +565,14 @@ antlrcpp::Any DaphneDSLBuiltins::build(mlir::Location loc, const std::string & f
         return createRowOrColAggOp<RowAggIdxMaxOp, ColAggIdxMaxOp>(loc, func, args);
     if(func == "count")
         return createGrpAggOp<GrpAggCountOp>(loc, func, args);
+    if(func == "quantileApprox") {
+        checkNumArgsExact(func, numArgs, 2);
+        mlir::Value arg = args[0];
+        mlir::Value q = utils.castIf(builder.getF64Type(), args[1]);
+        return static_cast<mlir::Value>(
+                builder.create<QuantileApproxOp>(loc, utils.matrixOf(builder.getF64Type()), arg, q)
+        );
+    }
 
     // --------------------------------------------------------------------
     // Cumulative aggregation
@@ -716,6 +744,21 @@ antlrcpp::Any DaphneDSLBuiltins::build(mlir::Location loc, const std::string & f
     if(func == "syrk") {
         return createSameTypeUnaryOp<SyrkOp>(loc, func, args);
     }
+    if(func == "batchMatMul") {
+        checkNumArgsBetween(func, numArgs, 3, 5);
+        mlir::Value lhs = args[0];
+        mlir::Value rhs = args[1];
+        mlir::Value numBatches = utils.castSizeIf(args[2]);
+        mlir::Value transa = (numArgs < 4)
+                ? builder.create<ConstantOp>(loc, builder.getBoolAttr(false))
+                : utils.castBoolIf(args[3]);
+        mlir::Value transb = (numArgs < 5)
+                ? builder.create<ConstantOp>(loc, builder.getBoolAttr(false))
+                : utils.castBoolIf(args[4]);
+        return utils.retValWithInferedType(builder.create<BatchMatMulOp>(
+                loc, utils.unknownType, lhs, rhs, numBatches, transa, transb
+        ));
+    }
     if(func == "gemv") {
         checkNumArgsExact(func, numArgs, 2);
         mlir::Value mat = args[0];
@@ -898,6 +941,18 @@ antlrcpp::Any DaphneDSLBuiltins::build(mlir::Location loc, const std::string & f
                 arg, min, max
         ));
     }
+    if(func == "quantizedMatMul") {
+        checkNumArgsExact(func, args.size(), 6);
+        mlir::Value lhs = args[0];
+        mlir::Value rhs = args[1];
+        mlir::Value lhsMin = utils.castIf(builder.getF32Type(), args[2]);
+        mlir::Value lhsMax = utils.castIf(builder.getF32Type(), args[3]);
+        mlir::Value rhsMin = utils.castIf(builder.getF32Type(), args[4]);
+        mlir::Value rhsMax = utils.castIf(builder.getF32Type(), args[5]);
+        return static_cast<mlir::Value>(builder.create<QuantizedMatMulOp>(
+                loc, utils.matrixOf(builder.getF32Type()), lhs, rhs, lhsMin, lhsMax, rhsMin, rhsMax
+        ));
+    }
 
     // ********************************************************************
     // Input/output
@@ -920,6 +975,52 @@ antlrcpp::Any DaphneDSLBuiltins::build(mlir::Location loc, const std::string & f
                 loc, arg, newline, err
         );
     }
+    if(func == "receiveFromNumpy") {
+        checkNumArgsExact(func, numArgs, 5);
+        mlir::Value address = utils.castUI64If(args[0]);
+        mlir::Value numRows = utils.castSizeIf(args[1]);
+        mlir::Value numCols = utils.castSizeIf(args[2]);
+        mlir::Value rowSkip = utils.castSizeIf(args[3]);
+        mlir::Type vt = utils.getValueTypeByName(CompilerUtils::getConstantString2(args[4]));
+        return static_cast<mlir::Value>(builder.create<ReceiveFromNumpyOp>(
+                loc, utils.matrixOf(vt), address, numRows, numCols, rowSkip
+        ));
+    }
+    if(func == "saveDaphneLibResult") {
+        checkNumArgsBetween(func, numArgs, 1, 2);
+        mlir::Value index = (numArgs < 2)
+                ? builder.create<ConstantOp>(loc, builder.getIndexAttr(0))
+                : utils.castSizeIf(args[1]);
+        return builder.create<SaveDaphneLibResultOp>(loc, args[0], index);
+    }
+    if(func == "receiveFromArrow") {
+        checkNumArgsMin(func, numArgs, 5);
+        mlir::Value arrayAddress = utils.castUI64If(args[0]);
+        mlir::Value schemaAddress = utils.castUI64If(args[1]);
+        mlir::Value numRows = utils.castSizeIf(args[2]);
+        // the value types of the columns separated by commas, followed by one label per column
+        std::vector<mlir::Type> cts;
+        std::stringstream valueTypes(CompilerUtils::getConstantString2(args[3]));
+        for(std::string vt; std::getline(valueTypes, vt, ',');)
+            cts.push_back(utils.getValueTypeByName(vt));
+        if(cts.size() != numArgs - 4)
+            throw std::runtime_error(
+                    func + " expects one label per column, but got " + std::to_string(numArgs - 4) +
+                    " labels for " + std::to_string(cts.size()) + " columns"
+            );
+        auto * labels = new std::vector<std::string>();
+        for(size_t i = 4; i < numArgs; i++)
+            labels->push_back(CompilerUtils::getConstantString2(args[i]));
+        mlir::Value numCols = builder.create<ConstantOp>(loc, builder.getIndexAttr(cts.size()));
+        mlir::Type resType = mlir::daphne::FrameType::get(builder.getContext(), cts, -1, static_cast<ssize_t>(cts.size()), labels);
+        return static_cast<mlir::Value>(builder.create<ReceiveFromArrowOp>(
+                loc, resType, arrayAddress, schemaAddress, numRows, numCols
+        ));
+    }
+    if(func == "sendToArrow") {
+        checkNumArgsExact(func, numArgs, 3);
+        return builder.create<SendToArrowOp>(loc, args[0], utils.castUI64If(args[1]), utils.castUI64If(args[2]));
+    }
     if(func == "readFrame" || func == "readMatrix") {
         checkNumArgsExact(func, numArgs, 1);
 
@@ -1041,6 +1142,10 @@ antlrcpp::Any DaphneDSLBuiltins::build(mlir::Location loc, const std::string & f
                 loc, builder.getIntegerType(64, true)
         ));
     }
+    if(func == "printMemoryUsage") {
+        checkNumArgsExact(func, numArgs, 0);
+        return builder.create<PrintMemoryUsageOp>(loc);
+    }
 
     // ********************************************************************
 
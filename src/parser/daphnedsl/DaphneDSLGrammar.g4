@@ -40,8 +40,20 @@ statement:
     | functionStatement
     | returnStatement
     | importStatement
+    | annotatedStatement
     ;
 
+// An annotation applies to the statement it precedes (which may be annotated
+// again), e.g., `@vectorize(threads=4) X = A + B;`.
+annotatedStatement:
+    annotation stmt=statement ;
+
+annotation:
+    '@' name=IDENTIFIER ( '(' ( annotationArg ( ',' annotationArg )* )? ')' )? ;
+
+annotationArg:
+    ( key=IDENTIFIER '=' )? ( lit=literal | id=IDENTIFIER ) ;
+
 importStatement:
     KW_IMPORT filePath=STRING_LITERAL (KW_AS alias=STRING_LITERAL)?';';
 
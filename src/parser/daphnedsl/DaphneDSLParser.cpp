@@ -56,6 +56,7 @@ void DaphneDSLParser::parseStream(mlir::OpBuilder & builder, std::istream & stre
         DaphneDSLGrammarParser::ScriptContext * ctx = parser.script();
         DaphneDSLVisitor visitor(module, builder, args, sourceName, userConf);
         visitor.visitScript(ctx);
+        importedFiles = visitor.getImportedFiles();
 
         mlir::Location loc = mlir::FileLineColLoc::get(builder.getIdentifier(sourceName), 0, 0);
         if(!builder.getBlock()->empty()) {
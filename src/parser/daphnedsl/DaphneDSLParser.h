@@ -25,11 +25,13 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 class DaphneDSLParser : public Parser {
 
     std::unordered_map<std::string, std::string> args;
     DaphneUserConfig userConf;
+    std::vector<std::string> importedFiles;
     
 public:
 
@@ -39,5 +41,13 @@ public:
     DaphneDSLParser() : DaphneDSLParser(std::unordered_map<std::string, std::string>(), DaphneUserConfig()) { }
 
     void parseStream(mlir::OpBuilder &builder, std::istream &stream, const std::string &sourceName) override;
+
+    /**
+     * @brief Returns the paths of the scripts imported by the last parsed
+     * script.
+     */
+    const std::vector<std::string> & getImportedFiles() const {
+        return importedFiles;
+    }
     
 };
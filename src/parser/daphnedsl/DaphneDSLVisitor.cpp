@@ -16,6 +16,7 @@
 
 #include <compiler/CompilerUtils.h>
 #include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
 #include <parser/daphnedsl/DaphneDSLVisitor.h>
 #include <parser/daphnedsl/DaphneDSLParser.h>
 #include <parser/CancelingErrorListener.h>
@@ -249,6 +250,118 @@ antlrcpp::Any DaphneDSLVisitor::visitStatement(DaphneDSLGrammarParser::Statement
     return visitChildren(ctx);
 }
 
+/**
+ * @brief Sets the execution hints of an annotation on the given op of the DaphneIR dialect, except for the hints it
+ * already got from an inner annotation.
+ */
+static void setHints(mlir::Operation * op, const std::vector<std::pair<std::string, mlir::Attribute>> & hints) {
+    if(op->getDialect() != op->getContext()->getOrLoadDialect<mlir::daphne::DaphneDialect>()
+            || llvm::isa<mlir::daphne::ConstantOp>(op) || op->hasTrait<mlir::OpTrait::IsTerminator>())
+        return;
+    for(auto & hint : hints)
+        if(!op->hasAttr(hint.first))
+            op->setAttr(hint.first, hint.second);
+}
+
+antlrcpp::Any DaphneDSLVisitor::visitAnnotatedStatement(DaphneDSLGrammarParser::AnnotatedStatementContext * ctx) {
+    if(ctx->stmt->functionStatement() || ctx->stmt->importStatement())
+        throw std::runtime_error("annotations are not supported on function definitions and imports");
+    auto hints = visit(ctx->annotation()).as<std::vector<std::pair<std::string, mlir::Attribute>>>();
+
+    // The ops of the statement are inserted between the op before the
+    // insertion point (if any) and the insertion point.
+    mlir::Block * block = builder.getBlock();
+    mlir::Operation * prev = builder.getInsertionPoint() == block->begin()
+            ? nullptr
+            : &*std::prev(builder.getInsertionPoint());
+    antlrcpp::Any res = visit(ctx->stmt);
+    for(auto it = prev ? std::next(prev->getIterator()) : block->begin(); it != builder.getInsertionPoint(); ++it)
+        it->walk([&](mlir::Operation * op) { setHints(op, hints); });
+    return res;
+}
+
+antlrcpp::Any DaphneDSLVisitor::visitAnnotation(DaphneDSLGrammarParser::AnnotationContext * ctx) {
+    const std::string name = ctx->name->getText();
+    std::vector<std::pair<std::string, mlir::Attribute>> args;
+    for(auto argCtx : ctx->annotationArg())
+        args.push_back(visitAnnotationArg(argCtx).as<std::pair<std::string, mlir::Attribute>>());
+    auto invalidArg = [&](const std::pair<std::string, mlir::Attribute> & arg) {
+        std::string s;
+        llvm::raw_string_ostream stream(s);
+        stream << "invalid argument of the annotation @" << name << ": ";
+        if(!arg.first.empty())
+            stream << arg.first << "=";
+        stream << arg.second;
+        return std::runtime_error(stream.str());
+    };
+
+    // the hints as the attributes to set on the ops of the annotated statement
+    std::vector<std::pair<std::string, mlir::Attribute>> hints;
+    if(name == "vectorize" || name == "distributed") {
+        const std::string & attrName = name == "vectorize"
+                ? mlir::daphne::ATTR_HINT_VECTORIZE
+                : mlir::daphne::ATTR_HINT_DISTRIBUTED;
+        // the only positional argument switches the hint on or off
+        mlir::Attribute enabled = builder.getBoolAttr(true);
+        for(auto & arg : args) {
+            if(arg.first.empty() && arg.second.isa<mlir::BoolAttr>() && &arg == &args.front())
+                enabled = arg.second;
+            else if(name == "vectorize" && arg.first == "threads") {
+                auto numThreads = arg.second.dyn_cast<mlir::IntegerAttr>();
+                if(!numThreads || numThreads.getInt() < 1)
+                    throw invalidArg(arg);
+                hints.emplace_back(mlir::daphne::ATTR_HINT_NUM_THREADS, numThreads);
+            }
+            else if(name == "vectorize" && arg.first == "schedule") {
+                // the names of the partitioning schemes in the user config
+                auto schedule = arg.second.dyn_cast<mlir::StringAttr>();
+                if(!schedule || nlohmann::json(schedule.getValue().str()).get<SelfSchedulingScheme>() == INVALID)
+                    throw invalidArg(arg);
+                hints.emplace_back(mlir::daphne::ATTR_HINT_SCHEDULE, schedule);
+            }
+            else
+                throw invalidArg(arg);
+        }
+        hints.emplace_back(attrName, enabled);
+    }
+    else if(name == "sparse" || name == "dense") {
+        if(!args.empty())
+            throw invalidArg(args.front());
+        hints.emplace_back(mlir::daphne::ATTR_HINT_REPRESENTATION, builder.getStringAttr(name));
+    }
+    else if(name == "device") {
+        if(args.size() != 1)
+            throw std::runtime_error("the annotation @device expects one argument, cpu or gpu");
+        auto device = args.front().second.dyn_cast<mlir::StringAttr>();
+        if(!args.front().first.empty() || !device || (device.getValue() != "cpu" && device.getValue() != "gpu"))
+            throw invalidArg(args.front());
+        hints.emplace_back(mlir::daphne::ATTR_HINT_DEVICE, device);
+    }
+    else
+        throw std::runtime_error("unknown annotation @" + name);
+    return hints;
+}
+
+antlrcpp::Any DaphneDSLVisitor::visitAnnotationArg(DaphneDSLGrammarParser::AnnotationArgContext * ctx) {
+    // The arguments of annotations are attributes rather than constant ops,
+    // since they are not part of the computation.
+    const std::string key = ctx->key ? ctx->key->getText() : "";
+    mlir::Attribute val;
+    if(ctx->id)
+        val = builder.getStringAttr(ctx->id->getText());
+    else if(auto lit = ctx->lit->INT_LITERAL())
+        val = builder.getI64IntegerAttr(atol(lit->getText().c_str()));
+    else if(ctx->lit->bl)
+        val = builder.getBoolAttr(ctx->lit->bl->KW_TRUE() != nullptr);
+    else if(auto lit = ctx->lit->STRING_LITERAL()) {
+        const std::string str = lit->getText();
+        val = builder.getStringAttr(str.substr(1, str.size() - 2));
+    }
+    else
+        throw std::runtime_error("unsupported argument of an annotation: " + ctx->getText());
+    return std::make_pair(key, val);
+}
+
 antlrcpp::Any DaphneDSLVisitor::visitBlockStatement(DaphneDSLGrammarParser::BlockStatementContext * ctx) {
     symbolTable.pushScope();
     antlrcpp::Any res = visitChildren(ctx);
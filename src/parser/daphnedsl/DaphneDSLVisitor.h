@@ -112,11 +112,25 @@ public:
         scriptPaths.push(rootScriptPath);
         userConf = std::move(userConf_);
     };
+
+    /**
+     * @brief Returns the paths of all scripts imported so far (also by
+     * imported scripts).
+     */
+    const std::vector<std::string> & getImportedFiles() const {
+        return importedFiles;
+    }
     
     antlrcpp::Any visitScript(DaphneDSLGrammarParser::ScriptContext * ctx) override;
 
     antlrcpp::Any visitStatement(DaphneDSLGrammarParser::StatementContext * ctx) override;
-    
+
+    antlrcpp::Any visitAnnotatedStatement(DaphneDSLGrammarParser::AnnotatedStatementContext * ctx) override;
+
+    antlrcpp::Any visitAnnotation(DaphneDSLGrammarParser::AnnotationContext * ctx) override;
+
+    antlrcpp::Any visitAnnotationArg(DaphneDSLGrammarParser::AnnotationArgContext * ctx) override;
+
     antlrcpp::Any visitImportStatement(DaphneDSLGrammarParser::ImportStatementContext * ctx) override;
 
     antlrcpp::Any visitBlockStatement(DaphneDSLGrammarParser::BlockStatementContext * ctx) override;
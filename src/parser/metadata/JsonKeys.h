@@ -36,6 +36,21 @@ struct JsonKeys {
 
     // optional key
     inline static const std::string NUM_NON_ZEROS = "numNonZeros";  // int (default: -1)
+
+    // written along with inferred meta data
+    inline static const std::string INFERRED_FROM = "inferredFrom";  // object of the following keys
+    inline static const std::string FILE_SIZE = "fileSize";  // int
+    inline static const std::string MTIME = "mtime";  // int (nanoseconds)
+
+    // optional key, see ColumnStatistics
+    inline static const std::string COLUMN_STATISTICS = "columnStatistics";  // array of objects of the following keys
+    inline static const std::string NUM_DISTINCT = "numDistinct";  // int
+    inline static const std::string MIN = "min";  // float
+    inline static const std::string MAX = "max";  // float
+    inline static const std::string NULL_FRACTION = "nullFraction";  // float
+    inline static const std::string HISTOGRAM = "histogram";  // array of floats
+    // written along with the statistics, which are valid as long as the data file is unchanged
+    inline static const std::string COLUMN_STATISTICS_FROM = "columnStatisticsFrom";  // object like INFERRED_FROM
 };
 
 #endif
\ No newline at end of file
@@ -16,17 +16,94 @@
 
 #include <parser/metadata/MetaDataParser.h>
 #include <parser/metadata/JsonKeys.h>
+#include <runtime/local/io/InferCsvMetaData.h>
+#include <runtime/local/io/ObjectStore.h>
+#include <runtime/local/io/ReadHDF5.h>
 
 #include <fstream>
 
+#include <cmath>
+
+#include <cstdio>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
 FileMetaData MetaDataParser::readMetaData(const std::string& filename_) {
+    std::string filename = (filename_.find(".meta") == std::string::npos) ? filename_ + ".meta" : filename_;
+    const std::string dataFilename = dataFilenameOf(filename);
+    const nlohmann::json stamp = fileStamp(dataFilename);
+    std::ifstream ifs;
+    if (isObjectURL(filename.c_str())) {
+        // the meta data file of an object is an object next to it, if there is one
+        try {
+            ifs.open(ObjectStore::localPath(filename.c_str()), std::ios::in);
+        }
+        catch (const std::runtime_error &) {
+        }
+    }
+    else
+        ifs.open(filename, std::ios::in);
+    if (ifs.good()) {
+        nlohmann::json jf = nlohmann::json::parse(ifs);
+        // inferred meta data and statistics are valid as long as the data file is unchanged
+        if (!keyExists(jf, JsonKeys::INFERRED_FROM) || stamp.is_null() || jf.at(JsonKeys::INFERRED_FROM) == stamp) {
+            FileMetaData metaData = fromJson(jf);
+            if (keyExists(jf, JsonKeys::COLUMN_STATISTICS_FROM) && !stamp.is_null()
+                    && jf.at(JsonKeys::COLUMN_STATISTICS_FROM) != stamp)
+                metaData.columnStats.clear();
+            return metaData;
+        }
+    }
+#ifdef USE_HDF5
+    // the dimensions, value type, and labels of an HDF5 dataset are stored in the file
+    else if (isHDF5File(dataFilename))
+        return readHDF5MetaData(dataFilename.c_str());
+#endif
+    else if (stamp.is_null() || dataFilename.size() < 4
+            || dataFilename.compare(dataFilename.size() - 4, 4, ".csv") != 0)
+        throw std::runtime_error("Could not open file '" + filename + ".meta' for reading meta data.");
+
+    // infer the meta data of a CSV file and keep them in the meta data file for the next reads, if it can be written
+    FileMetaData metaData = inferCsvMetaData(dataFilename.c_str());
+    nlohmann::json json = toJson(metaData);
+    json[JsonKeys::INFERRED_FROM] = stamp;
+    replaceFile(filename, json);
+    return metaData;
+}
+
+void MetaDataParser::writeColumnStatistics(const std::string& filename_, const std::vector<ColumnStatistics>& stats) {
     std::string filename = (filename_.find(".meta") == std::string::npos) ? filename_ + ".meta" : filename_;
     std::ifstream ifs(filename, std::ios::in);
     if (!ifs.good())
-        throw std::runtime_error("Could not open file '" + filename + ".meta' for reading meta data.");
+        return;
+    nlohmann::json json = nlohmann::json::parse(ifs);
+    ifs.close();
+    if (!keyExists(json, JsonKeys::NUM_COLS) || json.at(JsonKeys::NUM_COLS).get<size_t>() != stats.size())
+        throw std::runtime_error("the statistics of " + std::to_string(stats.size())
+                + " columns do not match the meta data file '" + filename + "'");
+    json[JsonKeys::COLUMN_STATISTICS] = columnStatisticsToJson(stats);
+    const nlohmann::json stamp = fileStamp(dataFilenameOf(filename));
+    if (stamp.is_null())
+        json.erase(JsonKeys::COLUMN_STATISTICS_FROM);
+    else
+        json[JsonKeys::COLUMN_STATISTICS_FROM] = stamp;
+    replaceFile(filename, json);
+}
 
-    nlohmann::basic_json jf = nlohmann::json::parse(ifs);
+void MetaDataParser::writeMetaData(const std::string& filename_, const FileMetaData& metaData) {
+    std::string filename = (filename_.find(".meta") == std::string::npos) ? filename_ + ".meta" : filename_;
+    std::ofstream ofs(filename, std::ios::out);
+    if (!ofs.good())
+        throw std::runtime_error("could not open file '" + filename + "'.meta for writing meta data");
+
+    if(ofs.is_open())
+        ofs << toJson(metaData).dump();
+    else
+        throw std::runtime_error("could not open file '" + filename + "'.meta for writing meta data");
+}
 
+FileMetaData MetaDataParser::fromJson(const nlohmann::json& jf) {
     if (!keyExists(jf, JsonKeys::NUM_ROWS) || !keyExists(jf, JsonKeys::NUM_COLS)) {
         throw std::invalid_argument("A meta data JSON file should always contain \"" + JsonKeys::NUM_ROWS + "\" and \""
                                     + JsonKeys::NUM_COLS + "\" keys.");
@@ -41,7 +118,9 @@ FileMetaData MetaDataParser::readMetaData(const std::string& filename_) {
     if (isSingleValueType) {
         if (keyExists(jf, JsonKeys::VALUE_TYPE)) {
             ValueTypeCode vtc = jf.at(JsonKeys::VALUE_TYPE).get<ValueTypeCode>();
-            return {numRows, numCols, isSingleValueType, vtc, numNonZeros};
+            FileMetaData metaData(numRows, numCols, isSingleValueType, vtc, numNonZeros);
+            metaData.columnStats = columnStatisticsFromJson(jf, numCols);
+            return metaData;
         }
         else {
             throw std::invalid_argument("A (matrix) meta data JSON file should contain the \"" + JsonKeys::VALUE_TYPE
@@ -57,7 +136,9 @@ FileMetaData MetaDataParser::readMetaData(const std::string& filename_) {
                 schema.emplace_back(column.getValueType());
                 labels.emplace_back(column.getLabel());
             }
-            return {numRows, numCols, isSingleValueType, schema, labels, numNonZeros};
+            FileMetaData metaData(numRows, numCols, isSingleValueType, schema, labels, numNonZeros);
+            metaData.columnStats = columnStatisticsFromJson(jf, numCols);
+            return metaData;
         }
         else {
             throw std::invalid_argument("A (frame) meta data JSON file should contain the \"" + JsonKeys::SCHEMA
@@ -66,42 +147,115 @@ FileMetaData MetaDataParser::readMetaData(const std::string& filename_) {
     }
 }
 
-void MetaDataParser::writeMetaData(const std::string& filename_, const FileMetaData& metaData) {
-    std::string filename = (filename_.find(".meta") == std::string::npos) ? filename_ + ".meta" : filename_;
-    std::ofstream ofs(filename, std::ios::out);
-    if (!ofs.good())
-        throw std::runtime_error("could not open file '" + filename + "'.meta for writing meta data");
+nlohmann::json MetaDataParser::toJson(const FileMetaData& metaData) {
+    nlohmann::json json;
 
-    if(ofs.is_open()) {
-        nlohmann::json json;
+    json[JsonKeys::NUM_ROWS] = metaData.numRows;
+    json[JsonKeys::NUM_COLS] = metaData.numCols;
 
-        json[JsonKeys::NUM_ROWS] = metaData.numRows;
-        json[JsonKeys::NUM_COLS] = metaData.numCols;
+    if (metaData.isSingleValueType) {
+        if (metaData.schema.size() != 1)
+            throw std::runtime_error("inappropriate meta data tried to be written to file");
+        json[JsonKeys::VALUE_TYPE] = metaData.schema[0];
+    }
+    else {
+        std::vector<SchemaColumn> schemaColumns;
+        // assume that the schema and labels are the same lengths
+        for (unsigned int i = 0; i < metaData.schema.size(); i++) {
+            SchemaColumn schemaColumn;
+            schemaColumn.setLabel(metaData.labels[i]);
+            schemaColumn.setValueType(metaData.schema[i]);
+            schemaColumns.emplace_back(schemaColumn);
+        }
+        json[JsonKeys::SCHEMA] = schemaColumns;
+    }
+
+    if (metaData.numNonZeros != -1)
+        json[JsonKeys::NUM_NON_ZEROS] = metaData.numNonZeros;
+
+    if (!metaData.columnStats.empty())
+        json[JsonKeys::COLUMN_STATISTICS] = columnStatisticsToJson(metaData.columnStats);
 
-        if (metaData.isSingleValueType) {
-            if (metaData.schema.size() != 1)
-                throw std::runtime_error("inappropriate meta data tried to be written to file");
-            json[JsonKeys::VALUE_TYPE] = metaData.schema[0];
+    return json;
+}
+
+std::vector<ColumnStatistics> MetaDataParser::columnStatisticsFromJson(const nlohmann::json& jf, size_t numCols) {
+    std::vector<ColumnStatistics> stats;
+    if (!keyExists(jf, JsonKeys::COLUMN_STATISTICS))
+        return stats;
+    const nlohmann::json& columns = jf.at(JsonKeys::COLUMN_STATISTICS);
+    if (!columns.is_array() || columns.size() != numCols)
+        throw std::invalid_argument("The \"" + JsonKeys::COLUMN_STATISTICS
+                + "\" key of a meta data JSON file should have an object for each column.");
+    for (const auto& column : columns) {
+        ColumnStatistics s;
+        if (keyExists(column, JsonKeys::NUM_DISTINCT))
+            s.numDistinct = column.at(JsonKeys::NUM_DISTINCT).get<ssize_t>();
+        if (keyExists(column, JsonKeys::MIN) && keyExists(column, JsonKeys::MAX)) {
+            s.min = column.at(JsonKeys::MIN).get<double>();
+            s.max = column.at(JsonKeys::MAX).get<double>();
         }
-        else {
-            std::vector<SchemaColumn> schemaColumns;
-            // assume that the schema and labels are the same lengths
-            for (unsigned int i = 0; i < metaData.schema.size(); i++) {
-                SchemaColumn schemaColumn;
-                schemaColumn.setLabel(metaData.labels[i]);
-                schemaColumn.setValueType(metaData.schema[i]);
-                schemaColumns.emplace_back(schemaColumn);
-            }
-            json[JsonKeys::SCHEMA] = schemaColumns;
+        if (keyExists(column, JsonKeys::NULL_FRACTION))
+            s.nullFraction = column.at(JsonKeys::NULL_FRACTION).get<double>();
+        if (keyExists(column, JsonKeys::HISTOGRAM) && s.hasRange())
+            s.histogram = column.at(JsonKeys::HISTOGRAM).get<std::vector<double>>();
+        stats.push_back(std::move(s));
+    }
+    return stats;
+}
+
+nlohmann::json MetaDataParser::columnStatisticsToJson(const std::vector<ColumnStatistics>& stats) {
+    // unknown statistics are left out, JSON has no NaNs
+    nlohmann::json columns = nlohmann::json::array();
+    for (const ColumnStatistics& s : stats) {
+        nlohmann::json column = nlohmann::json::object();
+        if (s.numDistinct != -1)
+            column[JsonKeys::NUM_DISTINCT] = s.numDistinct;
+        if (s.hasRange()) {
+            column[JsonKeys::MIN] = s.min;
+            column[JsonKeys::MAX] = s.max;
+            if (!s.histogram.empty())
+                column[JsonKeys::HISTOGRAM] = s.histogram;
         }
+        if (!std::isnan(s.nullFraction))
+            column[JsonKeys::NULL_FRACTION] = s.nullFraction;
+        columns.push_back(std::move(column));
+    }
+    return columns;
+}
 
-        if (metaData.numNonZeros != -1)
-            json[JsonKeys::NUM_NON_ZEROS] = metaData.numNonZeros;
+bool MetaDataParser::isHDF5File(const std::string& filename) {
+    auto endsWith = [&](const std::string& ext) {
+        return filename.size() > ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+    };
+    return endsWith(".h5") || endsWith(".hdf5");
+}
 
+std::string MetaDataParser::dataFilenameOf(const std::string& filename) {
+    return (filename.size() > 5 && filename.compare(filename.size() - 5, 5, ".meta") == 0)
+            ? filename.substr(0, filename.size() - 5) : "";
+}
+
+void MetaDataParser::replaceFile(const std::string& filename, const nlohmann::json& json) {
+    // written to a temporary file first, such that concurrent readers never see a partial file
+    const std::string tmpFilename = filename + ".tmp" + std::to_string(getpid());
+    std::ofstream ofs(tmpFilename, std::ios::out);
+    if (ofs.good()) {
         ofs << json.dump();
+        ofs.close();
+        if (!ofs.good() || std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+            std::remove(tmpFilename.c_str());
     }
-    else
-        throw std::runtime_error("could not open file '" + filename + "'.meta for writing meta data");
+}
+
+nlohmann::json MetaDataParser::fileStamp(const std::string& filename) {
+    struct stat st;
+    if (filename.empty() || stat(filename.c_str(), &st) != 0)
+        return nullptr;
+    nlohmann::json stamp;
+    stamp[JsonKeys::FILE_SIZE] = static_cast<int64_t>(st.st_size);
+    stamp[JsonKeys::MTIME] = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return stamp;
 }
 
 bool MetaDataParser::keyExists(const nlohmann::json& j, const std::string& key) { return j.find(key) != j.end(); }
@@ -22,6 +22,7 @@
 #include <runtime/local/datastructures/ValueTypeCode.h>
 
 #include <string>
+#include <vector>
 
 // must be in the same namespace as the enum class ValueTypeCode
 NLOHMANN_JSON_SERIALIZE_ENUM(ValueTypeCode, {
@@ -33,7 +34,8 @@ NLOHMANN_JSON_SERIALIZE_ENUM(ValueTypeCode, {
     { ValueTypeCode::UI32, "ui32" },
     { ValueTypeCode::UI64, "ui64" },
     { ValueTypeCode::F32, "f32" },
-    { ValueTypeCode::F64, "f64" }
+    { ValueTypeCode::F64, "f64" },
+    { ValueTypeCode::STR, "str" }
 })
 
 /**
@@ -61,6 +63,12 @@ public:
      *
      * @param filename The name of the file for which to retrieve the meta data.
      * Meta data should be passed using a simple JSON-based format.
+     * If a CSV file has no meta data file, its meta data are inferred (see
+     * `InferCsvMetaData`) and written to the meta data file along with the
+     * size and modification time of the CSV file, such that they are only
+     * inferred again once the CSV file changes. An HDF5 file (.h5, .hdf5)
+     * without a meta data file has the meta data of its dataset (see
+     * `HDF5Dataset`).
      * @return The meta data of the specified file.
      * @throws std::runtime_error Thrown if the specified file could not be open.
      * @throws std::invalid_argument Thrown if the JSON file contains any unexpected
@@ -77,7 +85,51 @@ public:
      */
     static void writeMetaData(const std::string& filename, const FileMetaData& metaData);
 
+    /**
+     * @brief Adds the statistics of the columns of a file to its meta data
+     * file, if there is one, keeping the rest of it.
+     *
+     * The statistics are stamped with the size and modification time of the
+     * data file, such that they are dropped once it changes.
+     *
+     * @param filename The name of the data file or of its meta data file.
+     * @param stats The statistics of each column of the file.
+     * @throws std::runtime_error Thrown if the meta data file has a different
+     * number of columns.
+     */
+    static void writeColumnStatistics(const std::string& filename, const std::vector<ColumnStatistics>& stats);
+
 private:
+    static FileMetaData fromJson(const nlohmann::json& jf);
+
+    static nlohmann::json toJson(const FileMetaData& metaData);
+
+    static std::vector<ColumnStatistics> columnStatisticsFromJson(const nlohmann::json& jf, size_t numCols);
+
+    static nlohmann::json columnStatisticsToJson(const std::vector<ColumnStatistics>& stats);
+
+    /**
+     * @brief Returns the name of the data file the meta data file is named
+     * after, or an empty string.
+     */
+    static std::string dataFilenameOf(const std::string& filename);
+
+    /**
+     * @brief Whether the file name has the extension of an HDF5 file.
+     */
+    static bool isHDF5File(const std::string& filename);
+
+    /**
+     * @brief Replaces the file by the JSON, if it can be written.
+     */
+    static void replaceFile(const std::string& filename, const nlohmann::json& json);
+
+    /**
+     * @brief Returns the size and modification time of a file, or null if it
+     * does not exist.
+     */
+    static nlohmann::json fileStamp(const std::string& filename);
+
     /**
      * @brief Checks whether a specified key exists in JSON or not.
      *
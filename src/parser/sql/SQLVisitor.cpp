@@ -445,7 +445,15 @@ antlrcpp::Any SQLVisitor::visitSelect(
     }
 
     //If a where clause exist, filter <currentFrame> accordingly.
-    if(ctx->whereClause()){
+    //In case of a group by clause on a single table, the filter is created
+    //after the columns to aggregate have been added to <currentFrame>, such
+    //that the grouping directly works on the filtered rows and both fuse into
+    //a FilterGroupOp. The filters of joins stay on top of the joins, where
+    //they are optimized together with them.
+    bool isJoin = currentFrame.getDefiningOp<mlir::daphne::CartesianOp>()
+        || currentFrame.getDefiningOp<mlir::daphne::InnerJoinOp>();
+    bool deferWhere = ctx->whereClause() && ctx->groupByClause() && !isJoin;
+    if(ctx->whereClause() && !deferWhere){
         currentFrame = utils.valueOrError(visit(ctx->whereClause()));
     }
 
@@ -462,6 +470,12 @@ antlrcpp::Any SQLVisitor::visitSelect(
             visit(ctx->selectExpr(i));
         }
         setBit(sqlFlag, (int64_t)SQLBit::codegen, 1);
+        if(deferWhere){
+            //The where clause may refer to columns not in the group.
+            setBit(sqlFlag, (int64_t)SQLBit::group, 0);
+            currentFrame = utils.valueOrError(visit(ctx->whereClause()));
+            setBit(sqlFlag, (int64_t)SQLBit::group, 1);
+        }
         visit(ctx->groupByClause());
     }
 
@@ -20,14 +20,22 @@
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/WireCompression.h>
 
 #include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
 #include <runtime/local/datastructures/DataPlacement.h>
 #include <runtime/local/datastructures/Range.h>
 #include <runtime/distributed/proto/DistributedGRPCCaller.h>
+#ifdef USE_MPI
+#include <runtime/distributed/mpi/MPIHelper.h>
+#endif
 
 #include <cassert>
 #include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -83,11 +91,10 @@ struct Broadcast<ALLOCATION_TYPE::DIST_GRPC, DT>
             mat = DataObjectFactory::create<DenseMatrix<double>>(0, 0, false); 
         } 
         else { // Not scalar
-            auto denseMat = dynamic_cast<const DenseMatrix<double>*>(mat);
-            if (!denseMat){
-                throw std::runtime_error("Distribute grpc only supports DenseMatrix<double> for now");
-            }
-            ProtoDataConverter<DenseMatrix<double>>::convertToProto(denseMat, protoMsg.mutable_matrix());
+            // dense and CSR matrices of any value type of the proto messages
+            convertMatrixToProto(mat, protoMsg.mutable_matrix());
+            // compressed once for all workers, which forward it as is along the tree
+            compressMatrix(protoMsg.mutable_matrix(), parseWireCompression(dctx->config.distributed_compression));
         }
         
         Range range;
@@ -95,47 +102,113 @@ struct Broadcast<ALLOCATION_TYPE::DIST_GRPC, DT>
         range.c_start = 0;
         range.r_len = mat->getNumRows();
         range.c_len = mat->getNumCols();        
+        // the workers the data is not placed at yet, with the IDs of their data placements
+        std::vector<std::pair<std::string, size_t>> targets;
         for (auto i=0ul; i < workers.size(); i++){
             auto workerAddr = workers.at(i);
 
-            // If DataPlacement dp already exists simply
-            // update range (in case we have a different one) and distributed data
-            DataPlacement *dp;
-            if ((dp = mat->getMetaDataObject().getDataPlacementByLocation(workerAddr))) {                
-                mat->getMetaDataObject().updateRangeDataPlacementByID(dp->dp_id, &range);
-                auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
-                data.ix = DistributedIndex(0, 0);
-                dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
-            }
-            else {  // else create new dp entry
-                DistributedData data;
-                data.ix = DistributedIndex(0, 0);
-                AllocationDescriptorGRPC allocationDescriptor (dctx, 
-                                                                workerAddr,  
-                                                                data);
-                dp = mat->getMetaDataObject().addDataPlacement(&allocationDescriptor, &range);
-            }
-            if (dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData().isPlacedAtWorker)
+            DataPlacement *dp = DistributedContext::getOrAddPlacement(mat, workerAddr, range, DistributedIndex(0, 0), dctx);
+            // Skip if already placed at the worker, e.g., by an earlier pipeline
+            if (DistributedContext::isPlaced(dp))
                 continue;
             
-            StoredInfo storedInfo({dp->dp_id});
-            caller.asyncStoreCall(workerAddr, storedInfo, protoMsg);
+            targets.push_back({workerAddr, dp->dp_id});
         }       
         
-        while (!caller.isQueueEmpty()){
-            auto response = caller.getNextResult();            
-            auto dp_id = response.storedInfo.dp_id;
+        auto setStored = [&mat](size_t dp_id, const distributed::StoredData &storedData) {
             auto dp = mat->getMetaDataObject().getDataPlacementByID(dp_id);
 
             auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
 
-            auto storedData = response.result;
             data.identifier = storedData.identifier();
             data.numRows = storedData.num_rows();
             data.numCols = storedData.num_cols();
             data.isPlacedAtWorker = true;
+            data.origin = DistributedOrigin::BROADCAST;
 
             dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);            
+        };
+
+        const size_t minWorkers = dctx->config.distributed_collectives_min_workers;
+        if (minWorkers > 0 && targets.size() >= minWorkers) {
+            // The workers forward the data to each other along a binomial tree, such that it leaves the coordinator
+            // only once.
+            distributed::BroadcastRequest request;
+            request.mutable_data()->Swap(&protoMsg);
+            std::map<std::string, size_t> dpIds;
+            for (size_t i = 0; i < targets.size(); i++) {
+                if (i > 0)
+                    request.add_peers(targets[i].first);
+                dpIds[targets[i].first] = targets[i].second;
+            }
+            DistributedGRPCCaller<StoredInfo, distributed::BroadcastRequest, distributed::CollectiveResult> treeCaller;
+            treeCaller.asyncBroadcastCall(targets[0].first, StoredInfo({targets[0].second}), request);
+            auto response = treeCaller.getNextResult();
+            for (auto &peer : response.result.stored()) {
+                // the worker called does not know its own address
+                auto addr = peer.address().empty() ? targets[0].first : peer.address();
+                setStored(dpIds.at(addr), peer.stored());
+            }
+            return;
+        }
+
+        for (auto &target : targets)
+            caller.asyncStoreCall(target.first, StoredInfo({target.second}), protoMsg);
+        while (!caller.isQueueEmpty()){
+            auto response = caller.getNextResult();            
+            setStored(response.storedInfo.dp_id, response.result);
         }                
     };           
 };
+
+// ----------------------------------------------------------------------------
+// MPI
+// ----------------------------------------------------------------------------
+
+#ifdef USE_MPI
+template<class DT>
+struct Broadcast<ALLOCATION_TYPE::DIST_MPI, DT>
+{
+    static void apply(DT *&mat, bool isScalar, DCTX(dctx))
+    {
+        auto ctx = DistributedContext::get(dctx);
+        auto workers = ctx->getWorkers();
+
+        assert(mat != nullptr && "Matrix to broadcast is nullptr");
+        double val = 0;
+        if (isScalar) {
+            val = *((double*)(&mat));
+            // Need matrix for metadata, type of matrix does not really matter.
+            mat = DataObjectFactory::create<DenseMatrix<double>>(0, 0, false);
+        }
+        auto denseMat = dynamic_cast<const DenseMatrix<double>*>(mat);
+        if (!isScalar && !denseMat)
+            throw std::runtime_error("Broadcast MPI only supports DenseMatrix<double> for now");
+
+        Range range(0, 0, mat->getNumRows(), mat->getNumCols());
+        std::vector<DataPlacement *> dps;
+        bool allPlaced = true;
+        for (size_t workerIx = 0; workerIx < workers.size(); workerIx++) {
+            dps.push_back(DistributedContext::getOrAddPlacement(mat, workers[workerIx], range, DistributedIndex(0, 0),
+                                                                dctx));
+            allPlaced = allPlaced && DistributedContext::isPlaced(dps.back());
+        }
+        // Skip if already placed at all workers, e.g., by an earlier pipeline. Otherwise, the collective reaches all
+        // of them, whose placements all refer to the new copy.
+        if (allPlaced)
+            return;
+
+        auto stored = isScalar ? MPIHelper::broadcastScalar(val) : MPIHelper::broadcastMatrix(denseMat);
+        for (size_t workerIx = 0; workerIx < workers.size(); workerIx++) {
+            const auto &storedData = stored[MPIHelper::getWorkerRank(workerIx)];
+            auto data = DistributedContext::getDistributedData(dps[workerIx]);
+            data.identifier = MPIHelper::getIdentifier(storedData);
+            data.numRows = storedData.numRows;
+            data.numCols = storedData.numCols;
+            data.isPlacedAtWorker = true;
+            data.origin = DistributedOrigin::BROADCAST;
+            DistributedContext::updateDistributedData(dps[workerIx], data);
+        }
+    }
+};
+#endif
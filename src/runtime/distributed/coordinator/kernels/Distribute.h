@@ -21,8 +21,17 @@
 #include <runtime/local/datastructures/DenseMatrix.h>
 
 #include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
+#include <runtime/distributed/coordinator/kernels/DistributedRead.h>
 #include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/WireCompression.h>
 #include <runtime/distributed/proto/DistributedGRPCCaller.h>
+#ifdef USE_MPI
+#include <runtime/distributed/mpi/MPIHelper.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
@@ -67,66 +76,74 @@ struct Distribute<ALLOCATION_TYPE::DIST_GRPC, DT>
         
         auto ctx = DistributedContext::get(dctx);
         auto workers = ctx->getWorkers();
+        const auto compression = parseWireCompression(dctx->config.distributed_compression);
     
         assert(mat != nullptr);
 
+        // The partitions of a matrix the workers read themselves are read from the file, too, e.g., after the
+        // partitioning changed.
+        const std::string sourceFile = DistributedContext::getSourceFile(mat);
+        std::vector<DataPlacement *> readDps;
+
         auto r = 0ul;
         for (auto workerIx = 0ul; workerIx < workers.size() && r < mat->getNumRows(); workerIx++) {            
             auto workerAddr = workers.at(workerIx);                      
 
-            auto k = mat->getNumRows() / workers.size();
-            auto m = mat->getNumRows() % workers.size();            
-
-            Range range;
-            range.r_start = (workerIx * k) + std::min(workerIx, m);
-            range.r_len = ((workerIx + 1) * k + std::min(workerIx + 1, m)) - range.r_start;
-            range.c_start = 0;
-            range.c_len = mat->getNumCols();
-                        
-            // If dp already exists simply
-            // update range (in case we have a different one) and distribute data
-            DataPlacement *dp;
-            if ((dp = mat->getMetaDataObject().getDataPlacementByLocation(workerAddr))) {                
-                mat->getMetaDataObject().updateRangeDataPlacementByID(dp->dp_id, &range);     
-                auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
-                // TODO Currently we do not support distributing/splitting 
-                // by columns. When we do, this should be changed (e.g. Index(0, workerIx))
-                data.ix = DistributedIndex(workerIx, 0);
-                dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
-            }
-            else { // Else, create new object metadata entry
-                DistributedData data;
-                // TODO Currently we do not support distributing/splitting 
-                // by columns. When we do, this should be changed (e.g. Index(0, workerIx))
-                data.ix = DistributedIndex(workerIx, 0);
-                AllocationDescriptorGRPC allocationDescriptor(
-                                            dctx,
-                                            workerAddr,
-                                            data);
-                dp = mat->getMetaDataObject().addDataPlacement(&allocationDescriptor, &range);                    
-            }
+            // All matrices are split alike, such that partitions of the same rows are co-located.
+            const Range range = ctx->getRowPartition(mat->getNumRows(), mat->getNumCols(), workerIx);
+            // TODO Currently we do not support distributing/splitting 
+            // by columns. When we do, this should be changed (e.g. Index(0, workerIx))
+            DataPlacement *dp = DistributedContext::getOrAddPlacement(mat, workerAddr, range,
+                                                                      DistributedIndex(workerIx, 0), dctx);
             // keep track of processed rows
-            // Skip if already placed at workers
-            if (dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData().isPlacedAtWorker)
+            r = range.r_start + range.r_len;
+            // Skip if already placed at the worker, e.g., by an earlier pipeline
+            if (DistributedContext::isPlaced(dp))
+                continue;
+            if (!sourceFile.empty()) {
+                readDps.push_back(dp);
                 continue;
-            distributed::Data protoMsg;
-        
-
-            // TODO: We need to handle different data types 
-            // (this will be simplified when serialization is implemented)
-            auto denseMat = dynamic_cast<const DenseMatrix<double>*>(mat);
-            if (!denseMat){
-                throw std::runtime_error("Distribute grpc only supports DenseMatrix<double> for now");
             }
-            ProtoDataConverter<DenseMatrix<double>>::convertToProto(denseMat, protoMsg.mutable_matrix(), 
-                                                    range.r_start,
-                                                    range.r_start + range.r_len,
-                                                    range.c_start,
-                                                    range.c_start + range.c_len);
+            distributed::Data protoMsg;
 
+            // Dense and CSR matrices of any value type of the proto messages; the rows of CSR matrices are sent
+            // as they are, without densifying them.
             StoredInfo storedInfo({dp->dp_id}); 
-            caller.asyncStoreCall(dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getLocation(), storedInfo, protoMsg);
-            r = (workerIx + 1) * k + std::min(workerIx + 1, m);
+            const auto &location = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getLocation();
+            const size_t rowEnd = range.r_start + range.r_len;
+            size_t numNonZeros = 0;
+            const size_t numBytes = getNumBytes(mat, range.r_start, rowEnd, numNonZeros);
+            const size_t rowsPerChunk = getRowsPerChunk(range.r_len, numBytes, dctx->config.distributed_chunk_bytes);
+            if (range.r_len > rowsPerChunk) {
+                // Stream the partition in chunks of rows, which the worker converts while the next ones arrive.
+                caller.asyncStoreStreamCall(location, storedInfo,
+                        [mat, range, rowEnd, rowsPerChunk, numNonZeros, compression, rowBegin = range.r_start](distributed::MatrixChunk &chunk) mutable {
+                    if (rowBegin >= rowEnd)
+                        return false;
+                    const size_t chunkEnd = std::min(rowEnd, rowBegin + rowsPerChunk);
+                    chunk.set_num_rows(range.r_len);
+                    chunk.set_num_cols(range.c_len);
+                    chunk.set_num_non_zeros(numNonZeros);
+                    chunk.set_row_begin(rowBegin - range.r_start);
+                    convertMatrixToProto(mat, chunk.mutable_rows(),
+                                         rowBegin,
+                                         chunkEnd,
+                                         range.c_start,
+                                         range.c_start + range.c_len);
+                    compressMatrix(chunk.mutable_rows(), compression);
+                    rowBegin = chunkEnd;
+                    return true;
+                });
+            }
+            else {
+                convertMatrixToProto(mat, protoMsg.mutable_matrix(), 
+                                     range.r_start,
+                                     range.r_start + range.r_len,
+                                     range.c_start,
+                                     range.c_start + range.c_len);
+                compressMatrix(protoMsg.mutable_matrix(), compression);
+                caller.asyncStoreCall(location, storedInfo, protoMsg);
+            }
         }                
                        
 
@@ -146,7 +163,67 @@ struct Distribute<ALLOCATION_TYPE::DIST_GRPC, DT>
             data.isPlacedAtWorker = true;
             dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);            
         }
+        if (!readDps.empty())
+            DistributedRead<ALLOCATION_TYPE::DIST_GRPC, DenseMatrix<double>>::readPlacements(
+                    dynamic_cast<const DenseMatrix<double>*>(mat), sourceFile, readDps);
 
     }
 };
 
+// ----------------------------------------------------------------------------
+// MPI
+// ----------------------------------------------------------------------------
+
+#ifdef USE_MPI
+template<class DT>
+struct Distribute<ALLOCATION_TYPE::DIST_MPI, DT>
+{
+    static void apply(DT *mat, DCTX(dctx)) {
+        auto ctx = DistributedContext::get(dctx);
+        auto workers = ctx->getWorkers();
+
+        assert(mat != nullptr);
+
+        auto denseMat = dynamic_cast<const DenseMatrix<double>*>(mat);
+        if (!denseMat)
+            throw std::runtime_error("Distribute MPI only supports DenseMatrix<double> for now");
+
+        // The rows each rank receives (none for the coordinator and for the workers which hold their partition
+        // already), which are scattered by a single collective.
+        std::vector<int> counts(workers.size() + 1, 0);
+        std::vector<int> displs(workers.size() + 1, 0);
+        std::vector<DataPlacement *> dps(workers.size() + 1, nullptr);
+        bool anyToSend = false;
+        for (size_t workerIx = 0; workerIx < workers.size(); workerIx++) {
+            // All matrices are split alike, such that partitions of the same rows are co-located.
+            const Range range = ctx->getRowPartition(mat->getNumRows(), mat->getNumCols(), workerIx);
+            if (range.r_len == 0)
+                continue;
+            DataPlacement *dp = DistributedContext::getOrAddPlacement(mat, workers[workerIx], range,
+                                                                      DistributedIndex(workerIx, 0), dctx);
+            // Skip if already placed at the worker, e.g., by an earlier pipeline
+            if (DistributedContext::isPlaced(dp))
+                continue;
+            const int rank = MPIHelper::getWorkerRank(workerIx);
+            counts[rank] = MPIHelper::toInt(range.r_len);
+            displs[rank] = MPIHelper::toInt(range.r_start);
+            dps[rank] = dp;
+            anyToSend = true;
+        }
+        if (!anyToSend)
+            return;
+
+        auto stored = MPIHelper::scatterRows(denseMat, counts, displs);
+        for (size_t rank = 1; rank < dps.size(); rank++) {
+            if (!dps[rank])
+                continue;
+            auto data = DistributedContext::getDistributedData(dps[rank]);
+            data.identifier = MPIHelper::getIdentifier(stored[rank]);
+            data.numRows = stored[rank].numRows;
+            data.numCols = stored[rank].numCols;
+            data.isPlacedAtWorker = true;
+            DistributedContext::updateDistributedData(dps[rank], data);
+        }
+    }
+};
+#endif
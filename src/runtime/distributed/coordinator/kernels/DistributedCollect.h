@@ -18,14 +18,22 @@
 #define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDCOLLECT_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 
 #include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
+#include <runtime/local/datastructures/AllocationDescriptorMPI.h>
 #include <runtime/distributed/proto/ProtoDataConverter.h>
 #include <runtime/distributed/proto/DistributedGRPCCaller.h>
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
+#include <runtime/distributed/coordinator/kernels/DistributedReduce.h>
+#ifdef USE_MPI
+#include <runtime/distributed/mpi/MPIHelper.h>
+#endif
+
+#include <type_traits>
 
 #include <cassert>
 #include <cstddef>
@@ -69,22 +77,62 @@ struct DistributedCollect<ALLOCATION_TYPE::DIST_GRPC, DT>
 
         struct StoredInfo{
             size_t dp_id;
+            // whether the chunks were already converted as they arrived
+            bool streamed;
         };
         DistributedGRPCCaller<StoredInfo, distributed::StoredData, distributed::Matrix> caller;
 
+        // The results are dense matrices of any value type of the proto messages.
+        using VT = typename DT::VT;
+        using DenseDT = DenseMatrix<VT>;
+        auto denseMat = dynamic_cast<DenseDT*>(mat);
+        if (!denseMat){
+            throw std::runtime_error("Distribute grpc only supports dense results for now");
+        }
 
         auto dpVector = mat->getMetaDataObject().getDataPlacementByType(ALLOCATION_TYPE::DIST_GRPC);
+        // the reduction along a tree of workers sums up doubles only
+        if (std::is_same<VT, double>::value && !dpVector->empty()
+                && dynamic_cast<AllocationDescriptorGRPC&>(*(dpVector->front()->allocation))
+                .getDistributedData().vectorCombine == VectorCombine::ADD) {
+            const size_t minWorkers = dctx->config.distributed_collectives_min_workers;
+            if (minWorkers > 0 && dpVector->size() >= minWorkers) {
+                distributedReduce<ALLOCATION_TYPE::DIST_GRPC>(mat, DistributedReduceMode::REDUCE, dctx);
+                return;
+            }
+        }
         for (auto &dp : *dpVector) {
             auto address = dp->allocation->getLocation();
             
             auto distributedData = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
-            StoredInfo storedInfo({dp->dp_id});
             distributed::StoredData protoData;
             protoData.set_identifier(distributedData.identifier);
             protoData.set_num_rows(distributedData.numRows);
             protoData.set_num_cols(distributedData.numCols);                       
 
-            caller.asyncTransferCall(address, storedInfo, protoData);
+            const size_t chunkBytes = dctx->config.distributed_chunk_bytes;
+            const Range range = *(dp->range);
+            if (distributedData.vectorCombine != VectorCombine::ADD
+                    && range.r_len > getRowsPerChunk(range.r_len, range.r_len * range.c_len * sizeof(VT), chunkBytes)) {
+                // Convert the chunks of rows into the result as they arrive.
+                distributed::TransferRequest request;
+                *request.mutable_stored() = protoData;
+                request.set_chunk_bytes(chunkBytes);
+                caller.asyncTransferStreamCall(address, StoredInfo({dp->dp_id, true}), request,
+                        [denseMat, range](const distributed::MatrixChunk &chunk) {
+                    const size_t rowBegin = range.r_start + chunk.row_begin();
+                    const size_t rowEnd = rowBegin + chunk.rows().num_rows();
+                    if (chunk.row_begin() + chunk.rows().num_rows() > range.r_len)
+                        throw std::runtime_error("DistributedCollect: the chunk does not fit into the partition");
+                    if (rowBegin < rowEnd)
+                        ProtoDataConverter<DenseDT>::convertFromProto(
+                            chunk.rows(), denseMat,
+                            rowBegin, rowEnd,
+                            range.c_start, range.c_start + range.c_len);
+                });
+            }
+            else
+                caller.asyncTransferCall(address, StoredInfo({dp->dp_id, false}), protoData);
         }
                 
         
@@ -95,20 +143,88 @@ struct DistributedCollect<ALLOCATION_TYPE::DIST_GRPC, DT>
             auto dp = mat->getMetaDataObject().getDataPlacementByID(dp_id);
             auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();            
 
-            auto matProto = response.result;
-            
-            auto denseMat = dynamic_cast<DenseMatrix<double>*>(mat);
-            if (!denseMat){
-                throw std::runtime_error("Distribute grpc only supports DenseMatrix<double> for now");
-            }        
-            ProtoDataConverter<DenseMatrix<double>>::convertFromProto(
-                matProto, denseMat,
-                dp->range->r_start, dp->range->r_start + dp->range->r_len,
-                dp->range->c_start, dp->range->c_start + dp->range->c_len);                
-            data.isPlacedAtWorker = false;
+            if (data.vectorCombine == VectorCombine::ADD) {
+                // The partial results are summed up into the result, which is allocated with zeros.
+                auto part = DataObjectFactory::create<DenseDT>(
+                        response.result.num_rows(), response.result.num_cols(), false);
+                ProtoDataConverter<DenseDT>::convertFromProto(response.result, part);
+                if (part->getNumRows() != denseMat->getNumRows() || part->getNumCols() != denseMat->getNumCols())
+                    throw std::runtime_error("DistributedCollect: the partial results have different shapes");
+                for (size_t r = 0; r < part->getNumRows(); r++) {
+                    VT *resRow = denseMat->getValues() + r * denseMat->getRowSkip();
+                    const VT *partRow = part->getValues() + r * part->getRowSkip();
+                    for (size_t c = 0; c < part->getNumCols(); c++)
+                        resRow[c] += partRow[c];
+                }
+                DataObjectFactory::destroy(part);
+            }
+            else if (!response.storedInfo.streamed)
+                ProtoDataConverter<DenseDT>::convertFromProto(
+                    response.result, denseMat,
+                    dp->range->r_start, dp->range->r_start + dp->range->r_len,
+                    dp->range->c_start, dp->range->c_start + dp->range->c_len);                
+            // The partitions stay at the workers as inputs of the next pipelines, but the partial results of
+            // aggregations do not hold the result.
+            data.isPlacedAtWorker = data.vectorCombine != VectorCombine::ADD;
             dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
         } 
     };
 };
 
-#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDCOLLECT_H
\ No newline at end of file
+// ----------------------------------------------------------------------------
+// MPI
+// ----------------------------------------------------------------------------
+
+#ifdef USE_MPI
+template<class DT>
+struct DistributedCollect<ALLOCATION_TYPE::DIST_MPI, DT>
+{
+    static void apply(DT *&mat, DCTX(dctx))
+    {
+        assert (mat != nullptr && "result matrix must be already allocated by wrapper since only there exists information regarding size");
+
+        auto denseMat = dynamic_cast<DenseMatrix<double>*>(mat);
+        if (!denseMat)
+            throw std::runtime_error("DistributedCollect MPI only supports DenseMatrix<double> for now");
+
+        auto dpVector = mat->getMetaDataObject().getDataPlacementByType(ALLOCATION_TYPE::DIST_MPI);
+        if (dpVector->empty())
+            return;
+
+        // the partitions of the ranks, by rank, which are empty for the coordinator
+        const size_t numRanks = MPIHelper::getSize();
+        std::vector<MPIHelper::StoredData> parts(numRanks, MPIHelper::StoredData{});
+        std::vector<int> counts(numRanks, 0);
+        std::vector<int> displs(numRanks, 0);
+        std::vector<size_t> colStarts(numRanks, 0);
+        const VectorCombine combine = DistributedContext::getDistributedData(dpVector->front().get()).vectorCombine;
+        for (auto &dp : *dpVector) {
+            const int rank = dynamic_cast<AllocationDescriptorMPI&>(*(dp->allocation)).getRank();
+            auto data = DistributedContext::getDistributedData(dp.get());
+            const Range range = *(dp->range);
+            parts[rank] = MPIHelper::makeStoredData(data.identifier, data.numRows, data.numCols);
+            counts[rank] = MPIHelper::toInt(range.r_len);
+            displs[rank] = MPIHelper::toInt(range.r_start);
+            colStarts[rank] = range.c_start;
+        }
+
+        if (combine == VectorCombine::ADD)
+            // The partial results are summed up into the result, which is allocated with zeros.
+            MPIHelper::sum(denseMat, parts);
+        else if (combine == VectorCombine::COLS)
+            MPIHelper::gatherCols(denseMat, parts, colStarts);
+        else
+            MPIHelper::gatherRows(denseMat, parts, counts, displs);
+
+        for (auto &dp : *dpVector) {
+            // The partitions stay at the workers as inputs of the next pipelines, but the partial results of
+            // aggregations do not hold the result.
+            auto data = DistributedContext::getDistributedData(dp.get());
+            data.isPlacedAtWorker = data.vectorCombine != VectorCombine::ADD;
+            DistributedContext::updateDistributedData(dp.get(), data);
+        }
+    };
+};
+#endif
+
+#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDCOLLECT_H
@@ -18,18 +18,34 @@
 #define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDCOMPUTE_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
+#include <runtime/local/datastructures/AllocationDescriptorMPI.h>
 
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
 #include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/WireCompression.h>
 #include <runtime/distributed/proto/DistributedGRPCCaller.h>
+#include <runtime/distributed/coordinator/kernels/DistributedRead.h>
+#ifdef USE_MPI
+#include <runtime/distributed/mpi/MPIHelper.h>
+#endif
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/SHA1.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
 
 using mlir::daphne::VectorCombine;
+using mlir::daphne::VectorSplit;
 
 
 
@@ -40,7 +56,7 @@ using mlir::daphne::VectorCombine;
 template<ALLOCATION_TYPE AT, class DTRes, class DTArgs>
 struct DistributedCompute
 {
-    static void apply(DTRes **&res, size_t numOutputs, DTArgs **args, size_t numInputs, const char *mlirCode, VectorCombine *vectorCombine, DCTX(dctx)) = delete;
+    static void apply(DTRes **&res, size_t numOutputs, DTArgs **args, size_t numInputs, const char *mlirCode, VectorSplit *vectorSplit, VectorCombine *vectorCombine, DCTX(dctx)) = delete;
 };
 
 // ****************************************************************************
@@ -48,9 +64,9 @@ struct DistributedCompute
 // ****************************************************************************
 
 template<ALLOCATION_TYPE AT, class DTRes, class DTArgs>
-void distributedCompute(DTRes **&res, size_t numOutputs, DTArgs **args, size_t numInputs, const char *mlirCode, VectorCombine *vectorCombine, DCTX(dctx))
+void distributedCompute(DTRes **&res, size_t numOutputs, DTArgs **args, size_t numInputs, const char *mlirCode, VectorSplit *vectorSplit, VectorCombine *vectorCombine, DCTX(dctx))
 {
-    DistributedCompute<AT, DTRes, DTArgs>::apply(res, numOutputs, args, numInputs, mlirCode, vectorCombine, dctx);
+    DistributedCompute<AT, DTRes, DTArgs>::apply(res, numOutputs, args, numInputs, mlirCode, vectorSplit, vectorCombine, dctx);
 }
 
 // ****************************************************************************
@@ -70,6 +86,7 @@ struct DistributedCompute<ALLOCATION_TYPE::DIST_GRPC, DTRes, const Structure>
                       const Structure **args,
                       size_t numInputs,
                       const char *mlirCode,
+                      VectorSplit *vectorSplit,
                       VectorCombine *vectorCombine,                      
                       DCTX(dctx))
     {
@@ -77,57 +94,54 @@ struct DistributedCompute<ALLOCATION_TYPE::DIST_GRPC, DTRes, const Structure>
         auto workers = ctx->getWorkers();
         
         struct StoredInfo {
+            // the worker computing the task
             std::string addr;
+            // the index of the worker whose partitions the task computes, which differs from the one computing it
+            // for a speculative task
+            size_t ownerIx;
+            std::chrono::steady_clock::time_point start;
+            // the task, to send it again with its code if the worker does not know the fragment
+            distributed::Task task;
         };                
         DistributedGRPCCaller<StoredInfo, distributed::Task, distributed::ComputeResult> caller;
 
+        // The workers keep the fragments they compiled, so each one is sent with its code only once.
+        llvm::SHA1 hash;
+        hash.update(llvm::StringRef(mlirCode));
+        const std::string fragmentId = llvm::toHex(hash.final(), true);
+
         // Initialize Distributed index array, needed for results
         std::vector<DistributedIndex> ix(numOutputs, DistributedIndex(0, 0));
+        // the ranges of the outputs of the task of each worker
+        std::vector<std::vector<Range>> outputRanges(workers.size());
+        // the number of rows of the partitions of the task of each worker, by which its throughput is measured
+        std::vector<size_t> taskRows(workers.size(), 0);
         
         // Iterate over workers
         // Pass all the nessecary arguments for the pipeline
-        for (auto addr : workers) {
+        for (size_t workerIx = 0; workerIx < workers.size(); workerIx++) {
+            const auto &addr = workers[workerIx];
             // Set output meta data
             for (size_t i = 0; i < numOutputs; i++){                 
-                // Get Result ranges
-                auto combineType = vectorCombine[i];
-                auto workersSize = workers.size();
-                size_t k = 0, m = 0;                
-                if (combineType == VectorCombine::ROWS) {
-                    k = (*res[i])->getNumRows() / workersSize;
-                    m = (*res[i])->getNumRows() % workersSize;
-                }
-                else if (combineType == VectorCombine::COLS){
-                    k = (*res[i])->getNumCols() / workersSize;
-                    m = (*res[i])->getNumCols() % workersSize;
-                }
-                else
-                    assert(!"Only Rows/Cols combineType supported atm");
+                if (vectorCombine[i] != VectorCombine::ROWS && vectorCombine[i] != VectorCombine::COLS
+                        && vectorCombine[i] != VectorCombine::ADD)
+                    assert(!"Only Rows/Cols/Add combineType supported atm");
 
                 DistributedData data;
                 data.ix = ix[i];
                 data.vectorCombine = vectorCombine[i];
                 data.isPlacedAtWorker = true;
+                data.origin = DistributedOrigin::COMPUTE;
                                 
                 // Update distributed index for next iteration
-                // and set ranges for objmetadata
-                Range range;
-                if (vectorCombine[i] == VectorCombine::ROWS) {
+                if (vectorCombine[i] == VectorCombine::ROWS)
                     ix[i] = DistributedIndex(ix[i].getRow() + 1, ix[i].getCol());            
-                    
-                    range.r_start = data.ix.getRow() * k + std::min(data.ix.getRow(), m);
-                    range.r_len = ((data.ix.getRow() + 1) * k + std::min((data.ix.getRow() + 1), m)) - range.r_start;
-                    range.c_start = 0;
-                    range.c_len = (*res[i])->getNumCols();
-                }
-                if (vectorCombine[i] == VectorCombine::COLS) {
+                if (vectorCombine[i] == VectorCombine::COLS)
                     ix[i] = DistributedIndex(ix[i].getRow(), ix[i].getCol() + 1);
-                    
-                    range.r_start = 0; 
-                    range.r_len = (*res[i])->getNumRows(); 
-                    range.c_start = data.ix.getCol() * k + std::min(data.ix.getCol(), m);
-                    range.c_len = ((data.ix.getCol() + 1) * k + std::min((data.ix.getCol() + 1), m)) - range.c_start;
-                }
+                // Each worker holds a partial result of the whole shape of the results combined by ADD, which are
+                // summed up by the collect.
+                Range range = ctx->getOutputRange(vectorCombine[i], *res[i], workerIx);
+                outputRanges[workerIx].push_back(range);
 
                 // If dp already exists for this worker, update the range and data
                 if (auto dp = (*res[i])->getMetaDataObject().getDataPlacementByLocation(addr)) { 
@@ -142,10 +156,19 @@ struct DistributedCompute<ALLOCATION_TYPE::DIST_GRPC, DTRes, const Structure>
                     ((*res[i]))->getMetaDataObject().addDataPlacement(&allocationDescriptor, &range);                    
                 } 
             }
+            for (size_t i = 0; i < numInputs && !taskRows[workerIx]; i++)
+                if (!DistributedContext::isBroadcast(vectorSplit[i], args[i]))
+                    taskRows[workerIx] = ctx->getInputRange(vectorSplit[i], args[i], workerIx).r_len;
+        }
 
+        // Builds the task on the partitions of the worker of index ownerIx, which are placed at the given worker.
+        auto makeTask = [&](const std::string &addr, size_t ownerIx) {
             distributed::Task task;
             for (size_t i = 0; i < numInputs; i++){
-                auto dp = args[i]->getMetaDataObject().getDataPlacementByLocation(addr);
+                auto dp = DistributedContext::findPlacement(args[i], addr,
+                                                            ctx->getInputRange(vectorSplit[i], args[i], ownerIx));
+                if (!dp)
+                    throw std::runtime_error("DistributedCompute: an input is not placed at worker " + addr);
                 auto distrData = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
 
                 distributed::StoredData protoData;
@@ -155,34 +178,264 @@ struct DistributedCompute<ALLOCATION_TYPE::DIST_GRPC, DTRes, const Structure>
 
                 *task.add_inputs()->mutable_stored() = protoData;
             }
-            task.set_mlir_code(mlirCode);
-            StoredInfo storedInfo({addr});    
+            task.set_fragment_id(fragmentId);
+            task.set_config_json(dctx->config.distributed_worker_config);
+            if (!ctx->isFragmentSent(addr, fragmentId)) {
+                task.set_mlir_code(mlirCode);
+                ctx->setFragmentSent(addr, fragmentId);
+            }
+            return task;
+        };
+
+        // the calls of the task of each worker and of the speculative copy of its task (if any)
+        std::vector<const void *> handles(workers.size(), nullptr);
+        std::vector<const void *> backupHandles(workers.size(), nullptr);
+        for (size_t workerIx = 0; workerIx < workers.size(); workerIx++) {
+            const auto &addr = workers[workerIx];
+            auto task = makeTask(addr, workerIx);
+            StoredInfo storedInfo({addr, workerIx, std::chrono::steady_clock::now(), task});    
             // TODO for now resuing channels seems to slow things down... 
             // It is faster if we generate channel for each call and let gRPC handle resources internally
             // We might need to change this in the future and re-use channels ( data.getChannel() )
-            caller.asyncComputeCall(addr, storedInfo, task);
+            handles[workerIx] = caller.asyncComputeCall(addr, storedInfo, task);
         }
+        const auto computeStart = std::chrono::steady_clock::now();
         
+        // A task still running after `distributed_speculation_factor` times the median time of the finished ones is
+        // computed by the fastest idle worker, too, and the result which arrives first is taken.
+        const double speculationFactor = dctx->config.distributed_speculation_factor;
+        bool canSpeculate = speculationFactor > 0 && workers.size() > 1;
+        for (size_t o = 0; o < numOutputs; o++)
+            // The partial results of all tasks have the same range, so a worker cannot hold two of them.
+            canSpeculate = canSpeculate && vectorCombine[o] != VectorCombine::ADD;
+        std::vector<bool> done(workers.size(), false);
+        std::vector<bool> idle(workers.size(), false);
+        std::vector<double> finishedSeconds;
+
         // Get Results
         while (!caller.isQueueEmpty()){
-            auto response = caller.getNextResult();
+            std::optional<decltype(caller.getNextResult())> next;
+            if (canSpeculate && !finishedSeconds.empty()) {
+                std::vector<double> sorted(finishedSeconds);
+                std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+                const auto deadline = computeStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(speculationFactor * sorted[sorted.size() / 2]));
+                next = caller.tryGetNextResult(std::chrono::system_clock::now() + (deadline - std::chrono::steady_clock::now()));
+                if (!next) {
+                    if (!speculate(caller, handles, backupHandles, done, idle, args, numInputs, vectorSplit, makeTask, ctx, dctx))
+                        // There is no straggler left to copy or no idle worker.
+                        canSpeculate = false;
+                    continue;
+                }
+            }
+            else
+                next = caller.getNextResult();
+            auto response = std::move(*next);
             auto addr = response.storedInfo.addr;
+            const size_t ownerIx = response.storedInfo.ownerIx;
+            const bool isBackup = addr != workers[ownerIx];
+            if (response.cancelled || done[ownerIx])
+                // The other copy of the task finished first.
+                continue;
             
             auto computeResult = response.result;            
+            if (computeResult.unknown_fragment()) {
+                // The worker evicted the compiled fragment.
+                auto task = response.storedInfo.task;
+                task.set_mlir_code(mlirCode);
+                auto &handle = isBackup ? backupHandles[ownerIx] : handles[ownerIx];
+                handle = caller.asyncComputeCall(addr, StoredInfo({addr, ownerIx, response.storedInfo.start, task}), task);
+                continue;
+            }
+
+            done[ownerIx] = true;
+            const double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - response.storedInfo.start).count();
+            finishedSeconds.push_back(seconds);
+            const size_t workerIx = std::find(workers.begin(), workers.end(), addr) - workers.begin();
+            ctx->reportTask(workerIx, taskRows[ownerIx], seconds);
+            idle[workerIx] = true;
+            if (isBackup && handles[ownerIx]) {
+                // The straggler took at least as long as the copy of its task.
+                caller.cancelCall(handles[ownerIx]);
+                ctx->reportTask(ownerIx, taskRows[ownerIx], seconds);
+            }
+            else if (!isBackup && backupHandles[ownerIx])
+                caller.cancelCall(backupHandles[ownerIx]);
             
             for (int o = 0; o < computeResult.outputs_size(); o++){            
                 auto resMat = *res[o];
-                auto dp = resMat->getMetaDataObject().getDataPlacementByLocation(addr);
+                const Range &range = outputRanges[ownerIx][o];
+                auto dp = DistributedContext::findPlacement(resMat, workers[ownerIx], range);
 
                 auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
                 data.identifier = computeResult.outputs()[o].stored().identifier();
                 data.numRows = computeResult.outputs()[o].stored().num_rows();
                 data.numCols = computeResult.outputs()[o].stored().num_cols();
                 data.isPlacedAtWorker = true;
-                dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);                                                
+                if (isBackup) {
+                    // The result of the straggler's range is at the worker of the copy.
+                    AllocationDescriptorGRPC allocationDescriptor(dctx, addr, data);
+                    Range backupRange = range;
+                    resMat->getMetaDataObject().addDataPlacement(&allocationDescriptor, &backupRange);
+                    resMat->getMetaDataObject().removeDataPlacement(dp->dp_id);
+                }
+                else
+                    dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);                                                
             }            
         }                
     }
+
+private:
+    /**
+     * @brief Computes the task of a straggling worker also at the fastest idle worker, whose inputs are placed there
+     * before.
+     *
+     * @return Whether a copy of a task was started
+     */
+    template<class Caller, class MakeTask>
+    static bool speculate(Caller &caller, std::vector<const void *> &handles, std::vector<const void *> &backupHandles,
+                          const std::vector<bool> &done, std::vector<bool> &idle, const Structure **args,
+                          size_t numInputs, VectorSplit *vectorSplit, MakeTask &makeTask, DistributedContext *ctx,
+                          DCTX(dctx))
+    {
+        auto workers = ctx->getWorkers();
+        size_t ownerIx = workers.size();
+        for (size_t i = 0; i < workers.size() && ownerIx == workers.size(); i++)
+            if (!done[i] && !backupHandles[i])
+                ownerIx = i;
+        size_t backupIx = workers.size();
+        for (size_t i = 0; i < workers.size(); i++)
+            if (idle[i] && (backupIx == workers.size() || ctx->getThroughput(i) > ctx->getThroughput(backupIx)))
+                backupIx = i;
+        if (ownerIx == workers.size() || backupIx == workers.size())
+            return false;
+        const auto &addr = workers[backupIx];
+        idle[backupIx] = false;
+
+        // Place the straggler's partitions at the worker of the copy.
+        struct StoredInfo {
+            size_t argIx;
+            size_t dp_id;
+        };
+        DistributedGRPCCaller<StoredInfo, distributed::Data, distributed::StoredData> storeCaller;
+        for (size_t i = 0; i < numInputs; i++) {
+            const Range range = ctx->getInputRange(vectorSplit[i], args[i], ownerIx);
+            auto dp = DistributedContext::getOrAddPlacement(args[i], addr, range, DistributedIndex(ownerIx, 0), dctx);
+            if (DistributedContext::isPlaced(dp))
+                continue;
+            const std::string sourceFile = DistributedContext::getSourceFile(args[i]);
+            if (!sourceFile.empty()) {
+                // The coordinator does not hold the values of a matrix the workers read themselves.
+                DistributedRead<ALLOCATION_TYPE::DIST_GRPC, DenseMatrix<double>>::readPlacements(
+                        dynamic_cast<const DenseMatrix<double>*>(args[i]), sourceFile, {dp});
+                continue;
+            }
+            distributed::Data protoMsg;
+            convertMatrixToProto(args[i], protoMsg.mutable_matrix(),
+                                 range.r_start, range.r_start + range.r_len,
+                                 range.c_start, range.c_start + range.c_len);
+            compressMatrix(protoMsg.mutable_matrix(), parseWireCompression(dctx->config.distributed_compression));
+            storeCaller.asyncStoreCall(addr, StoredInfo({i, dp->dp_id}), protoMsg);
+        }
+        while (!storeCaller.isQueueEmpty()) {
+            auto response = storeCaller.getNextResult();
+            auto dp = args[response.storedInfo.argIx]->getMetaDataObject().getDataPlacementByID(response.storedInfo.dp_id);
+            auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
+            data.identifier = response.result.identifier();
+            data.numRows = response.result.num_rows();
+            data.numCols = response.result.num_cols();
+            data.isPlacedAtWorker = true;
+            dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
+        }
+
+        auto task = makeTask(addr, ownerIx);
+        backupHandles[ownerIx] = caller.asyncComputeCall(addr, {addr, ownerIx, std::chrono::steady_clock::now(), task},
+                                                         task);
+        return true;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// MPI
+// ----------------------------------------------------------------------------
+
+#ifdef USE_MPI
+template<class DTRes>
+struct DistributedCompute<ALLOCATION_TYPE::DIST_MPI, DTRes, const Structure>
+{
+    static void apply(DTRes **&res,
+                      size_t numOutputs,
+                      const Structure **args,
+                      size_t numInputs,
+                      const char *mlirCode,
+                      VectorSplit *vectorSplit,
+                      VectorCombine *vectorCombine,
+                      DCTX(dctx))
+    {
+        auto ctx = DistributedContext::get(dctx);
+        auto workers = ctx->getWorkers();
+
+        // the inputs of the task of each rank, by rank
+        std::vector<MPIHelper::StoredData> inputs(MPIHelper::getSize() * numInputs, MPIHelper::StoredData{});
+        for (size_t workerIx = 0; workerIx < workers.size(); workerIx++) {
+            const auto &rank = workers[workerIx];
+            // Set output meta data, like for gRPC
+            for (size_t i = 0; i < numOutputs; i++) {
+                if (vectorCombine[i] != VectorCombine::ROWS && vectorCombine[i] != VectorCombine::COLS
+                        && vectorCombine[i] != VectorCombine::ADD)
+                    assert(!"Only Rows/Cols/Add combineType supported atm");
+                DistributedData data;
+                if (vectorCombine[i] == VectorCombine::ROWS)
+                    data.ix = DistributedIndex(workerIx, 0);
+                if (vectorCombine[i] == VectorCombine::COLS)
+                    data.ix = DistributedIndex(0, workerIx);
+                data.vectorCombine = vectorCombine[i];
+                data.isPlacedAtWorker = true;
+                data.origin = DistributedOrigin::COMPUTE;
+                Range range = ctx->getOutputRange(vectorCombine[i], *res[i], workerIx);
+                if (auto dp = (*res[i])->getMetaDataObject().getDataPlacementByLocation(rank)) {
+                    (*res[i])->getMetaDataObject().updateRangeDataPlacementByID(dp->dp_id, &range);
+                    DistributedContext::updateDistributedData(dp, data);
+                }
+                else {
+                    AllocationDescriptorMPI allocationDescriptor(dctx, MPIHelper::getWorkerRank(workerIx), data);
+                    (*res[i])->getMetaDataObject().addDataPlacement(&allocationDescriptor, &range);
+                }
+            }
+            for (size_t i = 0; i < numInputs; i++) {
+                auto dp = DistributedContext::findPlacement(args[i], rank,
+                                                            ctx->getInputRange(vectorSplit[i], args[i], workerIx),
+                                                            ALLOCATION_TYPE::DIST_MPI);
+                if (!dp)
+                    throw std::runtime_error("DistributedCompute: an input is not placed at rank " + rank);
+                auto distrData = DistributedContext::getDistributedData(dp);
+                inputs[MPIHelper::getWorkerRank(workerIx) * numInputs + i] =
+                        MPIHelper::makeStoredData(distrData.identifier, distrData.numRows, distrData.numCols);
+            }
+        }
+
+        // The workers keep the fragments they compiled by the hash of their code.
+        auto outputs = MPIHelper::compute(mlirCode, dctx->config.distributed_worker_config, inputs, numInputs,
+                                          numOutputs);
+
+        for (size_t workerIx = 0; workerIx < workers.size(); workerIx++) {
+            for (size_t o = 0; o < numOutputs; o++) {
+                auto resMat = *res[o];
+                auto dp = DistributedContext::findPlacement(resMat, workers[workerIx],
+                                                            ctx->getOutputRange(vectorCombine[o], resMat, workerIx),
+                                                            ALLOCATION_TYPE::DIST_MPI);
+                const auto &stored = outputs[MPIHelper::getWorkerRank(workerIx) * numOutputs + o];
+                auto data = DistributedContext::getDistributedData(dp);
+                data.identifier = MPIHelper::getIdentifier(stored);
+                data.numRows = stored.numRows;
+                data.numCols = stored.numCols;
+                data.isPlacedAtWorker = true;
+                DistributedContext::updateDistributedData(dp, data);
+            }
+        }
+    }
 };
+#endif
 
-#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDCOMPUTE_H
\ No newline at end of file
+#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDCOMPUTE_H
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDGROUP_H
+#define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDGROUP_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/Group.h>
+
+#include <runtime/distributed/coordinator/kernels/DistributedShuffle.h>
+#include <runtime/distributed/proto/HashPartition.h>
+#include <runtime/distributed/proto/worker.pb.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<ALLOCATION_TYPE AT, class DT>
+struct DistributedGroup {
+    static void apply(DT *&res, const DT *arg, const char **keyCols, size_t numKeyCols, const char **aggCols,
+                      size_t numAggCols, mlir::daphne::GroupEnum *aggFuncs, size_t numAggFuncs, DCTX(dctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Groups the rows of the frame by the key columns at the distributed workers, like the local `group`.
+ *
+ * The rows are shuffled between the workers by the hashes of their keys, such that each worker groups one partition
+ * of the keys. If all aggregation functions are decomposable (COUNT, SUM, MIN, MAX), each worker pre-aggregates its
+ * block of the rows before the shuffle, such that at most one row per group and worker is sent. The result is
+ * ordered by the keys like the local one.
+ */
+template<ALLOCATION_TYPE AT, class DT>
+void distributedGroup(DT *&res, const DT *arg, const char **keyCols, size_t numKeyCols, const char **aggCols,
+                      size_t numAggCols, mlir::daphne::GroupEnum *aggFuncs, size_t numAggFuncs, DCTX(dctx))
+{
+    DistributedGroup<AT, DT>::apply(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggFuncs, dctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different distributed backends
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// GRPC
+// ----------------------------------------------------------------------------
+
+template<>
+struct DistributedGroup<ALLOCATION_TYPE::DIST_GRPC, Frame>
+{
+    using Shuffle = DistributedShuffle<ALLOCATION_TYPE::DIST_GRPC>;
+
+    /**
+     * @brief The function aggregating the partial aggregates of the given function, or `false` if there is none.
+     */
+    static bool getMergeFunc(mlir::daphne::GroupEnum aggFunc, mlir::daphne::GroupEnum &mergeFunc) {
+        using mlir::daphne::GroupEnum;
+        switch (aggFunc) {
+            case GroupEnum::COUNT: mergeFunc = GroupEnum::SUM; return true;
+            case GroupEnum::SUM: mergeFunc = GroupEnum::SUM; return true;
+            case GroupEnum::MIN: mergeFunc = GroupEnum::MIN; return true;
+            case GroupEnum::MAX: mergeFunc = GroupEnum::MAX; return true;
+            default: return false;
+        }
+    }
+
+    static void apply(Frame *&res, const Frame *arg, const char **keyCols, size_t numKeyCols, const char **aggCols,
+                      size_t numAggCols, mlir::daphne::GroupEnum *aggFuncs, size_t numAggFuncs, DCTX(dctx)) {
+        if (numKeyCols == 0 || numAggCols != numAggFuncs)
+            throw std::runtime_error("distributedGroup: at least one key column and one function per aggregated "
+                                     "column are required");
+        auto workers = DistributedContext::get(dctx)->getWorkers();
+        const std::vector<std::string> keys(keyCols, keyCols + numKeyCols);
+
+        std::vector<mlir::daphne::GroupEnum> mergeFuncs(numAggCols);
+        bool decomposable = true;
+        for (size_t i = 0; i < numAggCols; i++)
+            decomposable = decomposable && getMergeFunc(aggFuncs[i], mergeFuncs[i]);
+
+        // the groups of the blocks of the rows, or the rows themselves, partitioned by their keys
+        auto blocks = Shuffle::scatter(arg, workers, "");
+        auto results = Shuffle::relational(workers, [&](size_t w, distributed::RelationalRequest &request) {
+            Shuffle::setStored(request.mutable_lhs(), blocks[w]);
+            if (decomposable) {
+                request.set_op(distributed::RelationalRequest::GROUP);
+                setAggregation(request, keys, aggCols, aggFuncs, numAggCols);
+            }
+            else
+                request.set_op(distributed::RelationalRequest::CONCAT);
+            Shuffle::setPartitioning(request, keys, workers.size());
+            request.set_free_inputs(true);
+        });
+        auto partitions = Shuffle::shuffle(workers, {Shuffle::getPartitions(results)})[0];
+
+        // The partial aggregates "F(col)" are aggregated again and keep their labels.
+        std::vector<std::string> partialLabels;
+        for (size_t i = 0; i < numAggCols; i++)
+            partialLabels.push_back(myStringifyGroupEnum(aggFuncs[i]) + "(" + aggCols[i] + ")");
+        std::vector<const char *> partialCols;
+        for (auto &label : partialLabels)
+            partialCols.push_back(label.c_str());
+        results = Shuffle::relational(workers, [&](size_t w, distributed::RelationalRequest &request) {
+            request.set_op(distributed::RelationalRequest::GROUP);
+            Shuffle::setStored(request.mutable_lhs(), partitions[w]);
+            if (decomposable) {
+                setAggregation(request, keys, partialCols.data(), mergeFuncs.data(), numAggCols);
+                for (auto &key : keys)
+                    request.add_labels(key);
+                for (auto &label : partialLabels)
+                    request.add_labels(label);
+            }
+            else
+                setAggregation(request, keys, aggCols, aggFuncs, numAggCols);
+            request.set_collect(true);
+            request.set_free_inputs(true);
+        });
+        Frame *grouped = Shuffle::collect(results);
+
+        // The groups of each worker are ordered by their keys, but not the groups of all workers.
+        res = gatherRows(grouped, orderByKeys(grouped, numKeyCols));
+        DataObjectFactory::destroy(grouped);
+    }
+
+    template<typename VT>
+    static bool lessValue(const void *values, size_t a, size_t b) {
+        return static_cast<const VT *>(values)[a] < static_cast<const VT *>(values)[b];
+    }
+
+    /**
+     * @brief The rows of the frame ordered by the first `numKeyCols` columns, of any value type (unlike `order`).
+     */
+    static std::vector<size_t> orderByKeys(const Frame *frame, size_t numKeyCols) {
+        using Less = bool (*)(const void *, size_t, size_t);
+        std::vector<std::pair<Less, const void *>> keys;
+        for (size_t c = 0; c < numKeyCols; c++) {
+            Less less;
+            switch (frame->getColumnType(c)) {
+                case ValueTypeCode::SI8:  less = lessValue<int8_t>; break;
+                case ValueTypeCode::SI32: less = lessValue<int32_t>; break;
+                case ValueTypeCode::SI64: less = lessValue<int64_t>; break;
+                case ValueTypeCode::UI8:  less = lessValue<uint8_t>; break;
+                case ValueTypeCode::UI32: less = lessValue<uint32_t>; break;
+                case ValueTypeCode::UI64: less = lessValue<uint64_t>; break;
+                case ValueTypeCode::F32:  less = lessValue<float>; break;
+                case ValueTypeCode::F64:  less = lessValue<double>; break;
+                case ValueTypeCode::STR:  less = lessValue<std::string>; break;
+                default:
+                    throw std::runtime_error("distributedGroup: unsupported value type of a key column");
+            }
+            keys.emplace_back(less, frame->getColumnRaw(c));
+        }
+        std::vector<size_t> rows(frame->getNumRows());
+        std::iota(rows.begin(), rows.end(), 0);
+        std::sort(rows.begin(), rows.end(), [&keys](size_t a, size_t b) {
+            for (auto &[less, values] : keys) {
+                if (less(values, a, b))
+                    return true;
+                if (less(values, b, a))
+                    return false;
+            }
+            return false;
+        });
+        return rows;
+    }
+
+    static void setAggregation(distributed::RelationalRequest &request, const std::vector<std::string> &keys,
+                               const char **aggCols, const mlir::daphne::GroupEnum *aggFuncs, size_t numAggCols) {
+        for (auto &key : keys)
+            request.add_lhs_on(key);
+        for (size_t i = 0; i < numAggCols; i++) {
+            request.add_agg_cols(aggCols[i]);
+            request.add_agg_funcs(static_cast<int32_t>(aggFuncs[i]));
+        }
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDGROUP_H
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDINNERJOIN_H
+#define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDINNERJOIN_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+
+#include <runtime/distributed/coordinator/kernels/DistributedShuffle.h>
+#include <runtime/distributed/proto/HashPartition.h>
+#include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/worker.pb.h>
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<ALLOCATION_TYPE AT>
+struct DistributedInnerJoin {
+    static void apply(Frame *&res, const Frame *lhs, const Frame *rhs, const char **lhsOn, const char **rhsOn,
+                      size_t numOn, DCTX(dctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Joins the rows of lhs and rhs at the distributed workers, like the local `innerJoin`.
+ *
+ * An input of at most `distributed_broadcast_join_bytes` is broadcast to all workers, which join it with a block of
+ * the rows of the other input. Otherwise, the rows of both inputs are shuffled between the workers by the hashes of
+ * their keys, such that each worker joins one partition of the keys. The result has the same rows in the same order
+ * as the local one. With Bloom filters enabled, the rows of the larger input without a match in the much smaller one
+ * are dropped before they are sent (see `DistributedShuffle::dropUnmatched()`).
+ */
+template<ALLOCATION_TYPE AT>
+void distributedInnerJoin(Frame *&res, const Frame *lhs, const Frame *rhs, const char **lhsOn, const char **rhsOn,
+                          size_t numOn, DCTX(dctx))
+{
+    DistributedInnerJoin<AT>::apply(res, lhs, rhs, lhsOn, rhsOn, numOn, dctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different distributed backends
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// GRPC
+// ----------------------------------------------------------------------------
+
+template<>
+struct DistributedInnerJoin<ALLOCATION_TYPE::DIST_GRPC>
+{
+    using Shuffle = DistributedShuffle<ALLOCATION_TYPE::DIST_GRPC>;
+
+    // the labels of the columns of the indexes of the rows of the inputs, by which the result is ordered
+    static inline const std::string ROW_ID_LHS = "__rowid_lhs";
+    static inline const std::string ROW_ID_RHS = "__rowid_rhs";
+
+    static void apply(Frame *&res, const Frame *lhs, const Frame *rhs, const char **lhsOn, const char **rhsOn,
+                      size_t numOn, DCTX(dctx)) {
+        auto workers = DistributedContext::get(dctx)->getWorkers();
+
+        // The rows of the larger input without a match in the smaller one are not sent. The rows kept are in their
+        // order, such that the result is ordered by them like by the rows of the input.
+        const std::vector<std::string> keysLhs(lhsOn, lhsOn + numOn);
+        const std::vector<std::string> keysRhs(rhsOn, rhsOn + numOn);
+        std::vector<size_t> rowsKept;
+        Frame *filtered = nullptr;
+        if (lhs->getNumRows() >= rhs->getNumRows()) {
+            if ((filtered = Shuffle::dropUnmatched(lhs, keysLhs, rhs, keysRhs, rowsKept, dctx)))
+                lhs = filtered;
+        }
+        else if ((filtered = Shuffle::dropUnmatched(rhs, keysRhs, lhs, keysLhs, rowsKept, dctx)))
+            rhs = filtered;
+
+        const size_t maxBroadcastBytes = dctx->config.distributed_broadcast_join_bytes;
+        const size_t numBytesLhs = getNumBytes(lhs);
+        const size_t numBytesRhs = getNumBytes(rhs);
+
+        Shuffle::Parts partsLhs, partsRhs;
+        // The joins of the blocks of lhs with the whole rhs are in the order of the local join already.
+        bool hasRowIds = true;
+        if (numBytesRhs <= numBytesLhs && numBytesRhs <= maxBroadcastBytes) {
+            partsLhs = Shuffle::scatter(lhs, workers, "");
+            partsRhs = Shuffle::broadcast(rhs, workers, "", dctx);
+            hasRowIds = false;
+        }
+        else if (numBytesLhs <= maxBroadcastBytes) {
+            partsLhs = Shuffle::broadcast(lhs, workers, ROW_ID_LHS, dctx);
+            partsRhs = Shuffle::scatter(rhs, workers, ROW_ID_RHS);
+        }
+        else {
+            auto partitionsLhs = Shuffle::partition(workers, Shuffle::scatter(lhs, workers, ROW_ID_LHS), keysLhs);
+            auto partitionsRhs = Shuffle::partition(workers, Shuffle::scatter(rhs, workers, ROW_ID_RHS), keysRhs);
+            auto shuffled = Shuffle::shuffle(workers, {partitionsLhs, partitionsRhs});
+            partsLhs = shuffled[0];
+            partsRhs = shuffled[1];
+        }
+
+        auto results = Shuffle::relational(workers, [&](size_t w, distributed::RelationalRequest &request) {
+            request.set_op(distributed::RelationalRequest::INNER_JOIN);
+            Shuffle::setStored(request.mutable_lhs(), partsLhs[w]);
+            Shuffle::setStored(request.mutable_rhs(), partsRhs[w]);
+            for (size_t i = 0; i < numOn; i++) {
+                request.add_lhs_on(lhsOn[i]);
+                request.add_rhs_on(rhsOn[i]);
+            }
+            request.set_collect(true);
+            request.set_free_inputs(true);
+        });
+        Frame *joined = Shuffle::collect(results);
+        // the columns of the row ids follow the columns of lhs and rhs, respectively
+        const size_t numColsLhs = lhs->getNumCols();
+        const size_t colRowIdLhs = numColsLhs;
+        const size_t colRowIdRhs = numColsLhs + 1 + rhs->getNumCols();
+        if (filtered)
+            DataObjectFactory::destroy(filtered);
+        if (!hasRowIds) {
+            res = joined;
+            return;
+        }
+
+        std::vector<size_t> colIdxs;
+        for (size_t c = 0; c < joined->getNumCols(); c++)
+            if (c != colRowIdLhs && c != colRowIdRhs)
+                colIdxs.push_back(c);
+        res = gatherRows(joined, Shuffle::orderByRowIds(joined, {colRowIdLhs, colRowIdRhs}), colIdxs);
+        DataObjectFactory::destroy(joined);
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDINNERJOIN_H
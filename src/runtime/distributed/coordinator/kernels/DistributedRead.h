@@ -18,26 +18,140 @@
 #define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDREAD_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
-#include <runtime/local/io/ReadCsv.h>
-#include <runtime/local/io/File.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/Read.h>
 #include <parser/metadata/MetaDataParser.h>
-#include <cassert>
+
+#include <runtime/distributed/proto/worker.pb.h>
+#include <runtime/distributed/proto/DistributedGRPCCaller.h>
+
+#include <string>
+#include <vector>
+
 #include <cstddef>
 
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
 
+template<ALLOCATION_TYPE AT, class DTRes>
+struct DistributedRead {
+    static void apply(DTRes *&res, const char *filename, DCTX(dctx)) = delete;
+};
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
-template<class DT>
-void distributedRead(Handle<DT> *&res, const char * filename, DCTX(ctx))
+/**
+ * @brief Reads a matrix, whose workers read their partitions from the file themselves, e.g., on a shared or parallel
+ * file system, such that only the metadata passes through the coordinator.
+ *
+ * The coordinator does not hold the values of the result, which must therefore only be the input of distributed
+ * pipelines split by rows (see `DistributePipelinesPass`). Files the workers cannot read by rows are read by the
+ * coordinator instead.
+ */
+template<ALLOCATION_TYPE AT, class DTRes>
+void distributedRead(DTRes *&res, const char *filename, DCTX(dctx))
 {
-    FileMetaData fmd = MetaDataParser::readMetaData(filename);
-
-    readCsv(res, filename, fmd.numRows, fmd.numCols, ',');
+    DistributedRead<AT, DTRes>::apply(res, filename, dctx);
 }
 
+// ****************************************************************************
+// (Partial) template specializations for different distributed backends
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// GRPC
+// ----------------------------------------------------------------------------
+
+template<>
+struct DistributedRead<ALLOCATION_TYPE::DIST_GRPC, DenseMatrix<double>>
+{
+    static void apply(DenseMatrix<double> *&res, const char *filename, DCTX(dctx)) {
+        FileMetaData fmd = MetaDataParser::readMetaData(filename);
+        // A single row is broadcast to all workers, which the coordinator sends.
+        if (!canReadRows(filename) || fmd.numRows == 1) {
+            read(res, filename, dctx);
+            return;
+        }
+        if (res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<double>>(fmd.numRows, fmd.numCols, false);
+
+        auto ctx = DistributedContext::get(dctx);
+        // The placements are changed by the pipelines running in the background, too.
+        if (dctx->config.distributed_async)
+            ctx->waitAll();
+        auto workers = ctx->getWorkers();
+        std::vector<DataPlacement *> dps;
+        auto r = 0ul;
+        for (auto workerIx = 0ul; workerIx < workers.size() && r < res->getNumRows(); workerIx++) {
+            // All matrices are split alike, such that partitions of the same rows are co-located.
+            const Range range = ctx->getRowPartition(res->getNumRows(), res->getNumCols(), workerIx);
+            dps.push_back(DistributedContext::getOrAddPlacement(res, workers.at(workerIx), range,
+                                                                DistributedIndex(workerIx, 0), dctx));
+            r = range.r_start + range.r_len;
+        }
+        readPlacements(res, filename, dps);
+    }
+
+    /**
+     * @brief Whether the workers can read the rows of the given file.
+     */
+    static bool canReadRows(const char *filename) {
+        switch (extValue(filename)) {
+            case 0: // CSV
+            case 3: // Daphne binary
+#ifdef USE_ARROW
+            case 2: // Parquet
+#endif
+#ifdef USE_HDF5
+            case 5: // HDF5
+#endif
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Lets the worker of each of the given placements of the matrix read its range from the file.
+     */
+    static void readPlacements(const DenseMatrix<double> *mat, const std::string &filename,
+                               const std::vector<DataPlacement *> &dps) {
+        struct StoredInfo {
+            size_t dp_id;
+        };
+        DistributedGRPCCaller<StoredInfo, distributed::ReadRequest, distributed::StoredData> caller;
+
+        for (auto dp : dps) {
+            distributed::ReadRequest request;
+            request.set_filename(filename);
+            request.set_row_begin(dp->range->r_start);
+            request.set_row_end(dp->range->r_start + dp->range->r_len);
+            request.set_num_cols(mat->getNumCols());
+            caller.asyncReadCall(dp->allocation->getLocation(), StoredInfo({dp->dp_id}), request);
+        }
+
+        // get results
+        while (!caller.isQueueEmpty()) {
+            auto response = caller.getNextResult();
+            auto dp = mat->getMetaDataObject().getDataPlacementByID(response.storedInfo.dp_id);
+
+            auto storedData = response.result;
+            auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
+            data.identifier = storedData.identifier();
+            data.numRows = storedData.num_rows();
+            data.numCols = storedData.num_cols();
+            data.isPlacedAtWorker = true;
+            data.sourceFile = filename;
+            data.origin = DistributedOrigin::READ;
+            dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
+        }
+    }
+};
 
 #endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDREAD_H
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDREDUCE_H
+#define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDREDUCE_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
+#include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/DistributedGRPCCaller.h>
+#include <runtime/distributed/proto/worker.pb.h>
+#include <runtime/distributed/proto/worker.grpc.pb.h>
+
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+
+using mlir::daphne::VectorCombine;
+
+/**
+ * @brief Where the sum of the partial results at the workers ends up.
+ */
+enum class DistributedReduceMode {
+    // at the coordinator
+    REDUCE,
+    // at all workers
+    ALL_REDUCE,
+    // a block of its rows at each worker, such that it is placed like a result combined by rows
+    REDUCE_SCATTER,
+};
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<ALLOCATION_TYPE AT, class DT>
+struct DistributedReduce {
+    static void apply(DT *&mat, DistributedReduceMode mode, DCTX(dctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Sums up the partial results of a matrix combined by `VectorCombine::ADD`, which are placed at the workers.
+ */
+template<ALLOCATION_TYPE AT, class DT>
+void distributedReduce(DT *&mat, DistributedReduceMode mode, DCTX(dctx))
+{
+    DistributedReduce<AT, DT>::apply(mat, mode, dctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different distributed backends
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// GRPC
+// ----------------------------------------------------------------------------
+
+template<class DT>
+struct DistributedReduce<ALLOCATION_TYPE::DIST_GRPC, DT>
+{
+    static void apply(DT *&mat, DistributedReduceMode mode, DCTX(dctx)) 
+    {
+        assert (mat != nullptr && "result matrix must be already allocated by wrapper since only there exists information regarding size");        
+
+        auto denseMat = dynamic_cast<DenseMatrix<double>*>(mat);
+        if (!denseMat){
+            throw std::runtime_error("Distribute grpc only supports DenseMatrix<double> for now");
+        }
+
+        auto dpVector = mat->getMetaDataObject().getDataPlacementByType(ALLOCATION_TYPE::DIST_GRPC);
+        if (dpVector->empty())
+            return;
+
+        // The workers sum up the partial results along a binomial tree rooted at the first one, such that the
+        // coordinator receives (or sends) nothing but the sum.
+        distributed::ReduceRequest request;
+        if (mode == DistributedReduceMode::REDUCE)
+            request.set_mode(distributed::ReduceRequest::REDUCE);
+        else if (mode == DistributedReduceMode::ALL_REDUCE)
+            request.set_mode(distributed::ReduceRequest::ALL_REDUCE);
+        else
+            request.set_mode(distributed::ReduceRequest::REDUCE_SCATTER);
+        for (auto &dp : *dpVector) {
+            auto distributedData = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
+            distributed::StoredData protoData;
+            protoData.set_identifier(distributedData.identifier);
+            protoData.set_num_rows(distributedData.numRows);
+            protoData.set_num_cols(distributedData.numCols);
+            if (dp == dpVector->front())
+                *request.mutable_stored() = protoData;
+            else {
+                auto peer = request.add_peers();
+                peer->set_address(dp->allocation->getLocation());
+                *peer->mutable_stored() = protoData;
+            }
+        }
+        const std::string rootAddr = dpVector->front()->allocation->getLocation();
+
+        DistributedGRPCCaller<std::string, distributed::ReduceRequest, distributed::CollectiveResult> caller;
+        caller.asyncReduceCall(rootAddr, rootAddr, request);
+        auto response = caller.getNextResult();
+
+        if (mode == DistributedReduceMode::REDUCE) {
+            ProtoDataConverter<DenseMatrix<double>>::convertFromProto(response.result.matrix(), denseMat);
+            for (auto &dp : *dpVector) {
+                auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
+                data.isPlacedAtWorker = false;
+                dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
+            }
+            return;
+        }
+
+        size_t rowIx = 0;
+        for (auto &peer : response.result.stored()) {
+            // the worker called does not know its own address
+            auto addr = peer.address().empty() ? rootAddr : peer.address();
+            auto dp = mat->getMetaDataObject().getDataPlacementByLocation(addr);
+            auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
+            data.identifier = peer.stored().identifier();
+            data.numRows = peer.stored().num_rows();
+            data.numCols = peer.stored().num_cols();
+            data.isPlacedAtWorker = true;
+            // The sum is not to be summed up again, but collected like a result combined by rows.
+            data.vectorCombine = VectorCombine::ROWS;
+            data.origin = DistributedOrigin::COMPUTE;
+            Range range;
+            range.c_start = 0;
+            range.c_len = mat->getNumCols();
+            if (mode == DistributedReduceMode::REDUCE_SCATTER) {
+                data.ix = DistributedIndex(rowIx++, 0);
+                range.r_start = peer.row_begin();
+                range.r_len = peer.stored().num_rows();
+            }
+            else {
+                // Each worker holds the whole sum, like a broadcast matrix.
+                data.ix = DistributedIndex(0, 0);
+                range.r_start = 0;
+                range.r_len = mat->getNumRows();
+            }
+            mat->getMetaDataObject().updateRangeDataPlacementByID(dp->dp_id, &range);
+            dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
+        }
+    };
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDREDUCE_H
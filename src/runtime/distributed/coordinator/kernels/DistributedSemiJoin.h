@@ -0,0 +1,148 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDSEMIJOIN_H
+#define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDSEMIJOIN_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+
+#include <runtime/distributed/coordinator/kernels/DistributedShuffle.h>
+#include <runtime/distributed/proto/HashPartition.h>
+#include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/worker.pb.h>
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<ALLOCATION_TYPE AT, typename VTLhsTid>
+struct DistributedSemiJoin {
+    static void apply(Frame *&res, DenseMatrix<VTLhsTid> *&lhsTid, const Frame *lhs, const Frame *rhs,
+                      const char *lhsOn, const char *rhsOn, DCTX(dctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Finds the rows of lhs with a match in rhs at the distributed workers, like the local `semiJoin`.
+ *
+ * Only the key columns are sent to the workers. The key column of rhs is broadcast to all workers if it has at most
+ * `distributed_broadcast_join_bytes`, otherwise both key columns are shuffled between the workers by the hashes of
+ * the keys. The result has the same rows in the same order as the local one. With Bloom filters enabled, the keys of
+ * lhs without a match in a much smaller rhs are dropped before they are sent (see
+ * `DistributedShuffle::dropUnmatched()`).
+ */
+template<ALLOCATION_TYPE AT, typename VTLhsTid>
+void distributedSemiJoin(Frame *&res, DenseMatrix<VTLhsTid> *&lhsTid, const Frame *lhs, const Frame *rhs,
+                         const char *lhsOn, const char *rhsOn, DCTX(dctx))
+{
+    DistributedSemiJoin<AT, VTLhsTid>::apply(res, lhsTid, lhs, rhs, lhsOn, rhsOn, dctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different distributed backends
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// GRPC
+// ----------------------------------------------------------------------------
+
+template<typename VTLhsTid>
+struct DistributedSemiJoin<ALLOCATION_TYPE::DIST_GRPC, VTLhsTid>
+{
+    using Shuffle = DistributedShuffle<ALLOCATION_TYPE::DIST_GRPC>;
+
+    // the label of the column of the indexes of the rows of lhs
+    static inline const std::string ROW_ID = "__rowid";
+
+    static void apply(Frame *&res, DenseMatrix<VTLhsTid> *&lhsTid, const Frame *lhs, const Frame *rhs,
+                      const char *lhsOn, const char *rhsOn, DCTX(dctx)) {
+        auto workers = DistributedContext::get(dctx)->getWorkers();
+        const size_t colLhs = lhs->getColumnIdx(lhsOn);
+        const size_t colRhs = rhs->getColumnIdx(rhsOn);
+        auto keysLhs = DataObjectFactory::create<Frame>(lhs, 0, lhs->getNumRows(), 1, &colLhs);
+        auto keysRhs = DataObjectFactory::create<Frame>(rhs, 0, rhs->getNumRows(), 1, &colRhs);
+
+        // The keys of lhs without a match in rhs are not sent, such that the row ids are the positions of the rows
+        // kept.
+        std::vector<size_t> rowsKept;
+        bool dropped = false;
+        if (Frame *filtered = Shuffle::dropUnmatched(keysLhs, {lhsOn}, keysRhs, {rhsOn}, rowsKept, dctx)) {
+            DataObjectFactory::destroy(keysLhs);
+            keysLhs = filtered;
+            dropped = true;
+        }
+
+        Shuffle::Parts partsLhs, partsRhs;
+        // The matches of the blocks of lhs in the whole rhs are in the order of the rows of lhs already.
+        bool ordered = false;
+        if (getNumBytes(keysRhs) <= dctx->config.distributed_broadcast_join_bytes) {
+            partsLhs = Shuffle::scatter(keysLhs, workers, ROW_ID);
+            partsRhs = Shuffle::broadcast(keysRhs, workers, "", dctx);
+            ordered = true;
+        }
+        else {
+            auto partitionsLhs = Shuffle::partition(workers, Shuffle::scatter(keysLhs, workers, ROW_ID), {lhsOn});
+            auto partitionsRhs = Shuffle::partition(workers, Shuffle::scatter(keysRhs, workers, ""), {rhsOn});
+            auto shuffled = Shuffle::shuffle(workers, {partitionsLhs, partitionsRhs});
+            partsLhs = shuffled[0];
+            partsRhs = shuffled[1];
+        }
+        DataObjectFactory::destroy(keysLhs, keysRhs);
+
+        auto results = Shuffle::relational(workers, [&](size_t w, distributed::RelationalRequest &request) {
+            request.set_op(distributed::RelationalRequest::SEMI_JOIN);
+            Shuffle::setStored(request.mutable_lhs(), partsLhs[w]);
+            Shuffle::setStored(request.mutable_rhs(), partsRhs[w]);
+            request.add_lhs_on(lhsOn);
+            request.add_rhs_on(rhsOn);
+            request.set_row_id(ROW_ID);
+            request.set_collect(true);
+            request.set_free_inputs(true);
+        });
+        // the key column and the row id column of the matches
+        Frame *matches = Shuffle::collect(results);
+        std::vector<size_t> rows(matches->getNumRows());
+        if (ordered)
+            std::iota(rows.begin(), rows.end(), 0);
+        else
+            rows = Shuffle::orderByRowIds(matches, {1});
+
+        res = gatherRows(matches, rows, {0});
+        if (lhsTid == nullptr)
+            lhsTid = DataObjectFactory::create<DenseMatrix<VTLhsTid>>(rows.size(), 1, false);
+        auto rowIds = static_cast<const uint64_t *>(matches->getColumnRaw(1));
+        VTLhsTid *valuesTid = lhsTid->getValues();
+        for (size_t r = 0; r < rows.size(); r++)
+            valuesTid[r] = static_cast<VTLhsTid>(dropped ? rowsKept[rowIds[rows[r]]] : rowIds[rows[r]]);
+        DataObjectFactory::destroy(matches);
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDSEMIJOIN_H
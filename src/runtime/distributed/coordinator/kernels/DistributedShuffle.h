@@ -0,0 +1,314 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDSHUFFLE_H
+#define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDSHUFFLE_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/local/datastructures/DistributedGarbage.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/IAllocationDescriptor.h>
+#include <runtime/local/kernels/BloomFilters.h>
+
+#include <runtime/distributed/proto/DistributedGRPCCaller.h>
+#include <runtime/distributed/proto/HashPartition.h>
+#include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/worker.pb.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+/**
+ * @brief The primitives of the distributed relational operators on frames: scattering and broadcasting a frame to
+ * the workers, computing a relational operator at each worker, and shuffling hash partitions between the workers.
+ *
+ * Unlike the matrices of distributed pipelines, the frames do not stay at the workers. They only live during an
+ * operator, which frees its intermediates at the end (see `free()`).
+ */
+template<ALLOCATION_TYPE AT>
+struct DistributedShuffle {};
+
+// ****************************************************************************
+// (Partial) template specializations for different distributed backends
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// GRPC
+// ----------------------------------------------------------------------------
+
+template<>
+struct DistributedShuffle<ALLOCATION_TYPE::DIST_GRPC>
+{
+    // the frames stored at each worker, by the index of the worker
+    using Parts = std::vector<std::vector<distributed::StoredData>>;
+    using Results = std::vector<distributed::RelationalResult>;
+
+    // the maximum ratio of the rows of the smaller input of a join to those of the larger one, up to which the
+    // rows of the larger one are filtered before they are sent (see `dropUnmatched()`)
+    static constexpr double MAX_BLOOM_FILTER_RATIO = 0.25;
+
+    /**
+     * @brief Drops the rows of `probed` without a match in `build`, by a Bloom filter of the keys of `build`, if
+     * Bloom filters are enabled (see `DaphneUserConfig::bloom_filters`) and `build` is much smaller than `probed`.
+     * The key columns of both frames must have the same value types. Only a few rows without a match are kept.
+     *
+     * @param rows The rows of `probed` kept, in ascending order
+     * @return The frame of the rows kept, or `nullptr` if no rows were dropped
+     */
+    static Frame *dropUnmatched(const Frame *probed, const std::vector<std::string> &probedOn, const Frame *build,
+                                const std::vector<std::string> &buildOn, std::vector<size_t> &rows, DCTX(dctx)) {
+        if (!dctx->config.bloom_filters
+                || build->getNumRows() > MAX_BLOOM_FILTER_RATIO * probed->getNumRows())
+            return nullptr;
+        std::vector<size_t> keyColsProbed, keyColsBuild;
+        for (size_t i = 0; i < probedOn.size(); i++) {
+            keyColsProbed.push_back(probed->getColumnIdx(probedOn[i]));
+            keyColsBuild.push_back(build->getColumnIdx(buildOn[i]));
+            if (probed->getColumnType(keyColsProbed.back()) != build->getColumnType(keyColsBuild.back()))
+                return nullptr;
+        }
+        rows = BloomFilters::matchingRows(probed, keyColsProbed, build, keyColsBuild, dctx);
+        if (rows.size() == probed->getNumRows())
+            return nullptr;
+        return gatherRows(probed, rows);
+    }
+
+    /**
+     * @brief Stores a block of rows of the frame at each worker, with a column of uint64_t of the indexes of the
+     * rows in the frame of the given label, unless it is empty.
+     */
+    static Parts scatter(const Frame *frame, const std::vector<std::string> &workers, const std::string &rowIdLabel) {
+        const size_t numRows = frame->getNumRows();
+        const size_t k = numRows / workers.size();
+        const size_t m = numRows % workers.size();
+        auto rowBegin = [k, m](size_t i) { return i * k + std::min(i, m); };
+
+        DistributedGRPCCaller<size_t, distributed::Data, distributed::StoredData> caller;
+        for (size_t w = 0; w < workers.size(); w++) {
+            distributed::Data data;
+            convertFrameToProto(frame, data.mutable_frame(), rowBegin(w), rowBegin(w + 1), rowIdLabel);
+            caller.asyncStoreCall(workers[w], w, data);
+        }
+        Parts parts(workers.size());
+        while (!caller.isQueueEmpty()) {
+            auto response = caller.getNextResult();
+            parts[response.storedInfo].push_back(response.result);
+        }
+        return parts;
+    }
+
+    /**
+     * @brief Stores the whole frame at each worker, which the workers forward to each other along a binomial tree
+     * from `distributed_collectives_min_workers` workers on. The frame gets a column of the indexes of its rows of
+     * the given label, unless it is empty.
+     */
+    static Parts broadcast(const Frame *frame, const std::vector<std::string> &workers, const std::string &rowIdLabel,
+                           DCTX(dctx)) {
+        distributed::Data data;
+        convertFrameToProto(frame, data.mutable_frame(), 0, frame->getNumRows(), rowIdLabel);
+        Parts parts(workers.size());
+        const size_t minWorkers = dctx->config.distributed_collectives_min_workers;
+        if (minWorkers > 0 && workers.size() >= minWorkers) {
+            distributed::BroadcastRequest request;
+            request.mutable_data()->Swap(&data);
+            std::map<std::string, size_t> workerIxs;
+            for (size_t w = 0; w < workers.size(); w++) {
+                if (w > 0)
+                    request.add_peers(workers[w]);
+                workerIxs[workers[w]] = w;
+            }
+            DistributedGRPCCaller<size_t, distributed::BroadcastRequest, distributed::CollectiveResult> caller;
+            caller.asyncBroadcastCall(workers[0], 0, request);
+            for (auto &peer : caller.getNextResult().result.stored()) {
+                // the worker called does not know its own address
+                auto addr = peer.address().empty() ? workers[0] : peer.address();
+                parts[workerIxs.at(addr)].push_back(peer.stored());
+            }
+            return parts;
+        }
+        DistributedGRPCCaller<size_t, distributed::Data, distributed::StoredData> caller;
+        for (size_t w = 0; w < workers.size(); w++)
+            caller.asyncStoreCall(workers[w], w, data);
+        while (!caller.isQueueEmpty()) {
+            auto response = caller.getNextResult();
+            parts[response.storedInfo].push_back(response.result);
+        }
+        return parts;
+    }
+
+    /**
+     * @brief Lets each worker compute the relational operator of the request `fill` fills in for the index of the
+     * worker, and returns their results by the index of the worker.
+     */
+    static Results relational(const std::vector<std::string> &workers,
+                              const std::function<void(size_t, distributed::RelationalRequest &)> &fill) {
+        DistributedGRPCCaller<size_t, distributed::RelationalRequest, distributed::RelationalResult> caller;
+        for (size_t w = 0; w < workers.size(); w++) {
+            distributed::RelationalRequest request;
+            fill(w, request);
+            caller.asyncRelationalCall(workers[w], w, request);
+        }
+        Results results(workers.size());
+        while (!caller.isQueueEmpty()) {
+            auto response = caller.getNextResult();
+            results[response.storedInfo] = std::move(response.result);
+        }
+        return results;
+    }
+
+    /**
+     * @brief The hash partitions of the results of `relational()` at each worker, which it stored by the index of
+     * the worker they belong to.
+     */
+    static Parts getPartitions(const Results &results) {
+        Parts parts;
+        for (auto &result : results)
+            parts.emplace_back(result.stored().begin(), result.stored().end());
+        return parts;
+    }
+
+    /**
+     * @brief Lets each worker split the rows of its frames into hash partitions by the given key columns, one per
+     * worker, and free the frames.
+     */
+    static Parts partition(const std::vector<std::string> &workers, const Parts &parts,
+                           const std::vector<std::string> &keyCols) {
+        auto results = relational(workers, [&](size_t w, distributed::RelationalRequest &request) {
+            request.set_op(distributed::RelationalRequest::CONCAT);
+            setStored(request.mutable_lhs(), parts[w]);
+            setPartitioning(request, keyCols, workers.size());
+            request.set_free_inputs(true);
+        });
+        return getPartitions(results);
+    }
+
+    /**
+     * @brief Shuffles the hash partitions of the frames between the workers, such that each worker holds the
+     * partitions of its index of all workers afterwards, and frees the partitions sent.
+     *
+     * The workers send the partitions to each other directly, pairwise in rounds, in which each worker exchanges
+     * its partitions with at most one peer (like the rounds of a round-robin tournament). A worker serves one call at
+     * a time, such that a worker waiting for its peer must not be the peer of another worker waiting for it.
+     *
+     * @param partitions Per frame, the partitions at each worker (see `getPartitions()`)
+     * @return Per frame, the partitions at each worker after the shuffle
+     */
+    static std::vector<Parts> shuffle(const std::vector<std::string> &workers,
+                                      const std::vector<Parts> &partitions) {
+        const size_t numWorkers = workers.size();
+        std::vector<Parts> res(partitions.size(), Parts(numWorkers));
+        for (size_t f = 0; f < partitions.size(); f++)
+            for (size_t w = 0; w < numWorkers; w++)
+                res[f][w].push_back(partitions[f][w].at(w));
+
+        // With an odd number of workers, the peer of one worker in each round is missing.
+        const size_t n = numWorkers + numWorkers % 2;
+        for (size_t round = 0; round + 1 < n; round++) {
+            auto player = [n, round](size_t p) { return p == 0 ? 0 : (p - 1 + round) % (n - 1) + 1; };
+            DistributedGRPCCaller<std::pair<size_t, size_t>, distributed::ExchangeRequest,
+                                  distributed::ExchangeResult> caller;
+            for (size_t p = 0; p < n / 2; p++) {
+                const size_t a = std::min(player(p), player(n - 1 - p));
+                const size_t b = std::max(player(p), player(n - 1 - p));
+                if (b >= numWorkers)
+                    continue;
+                distributed::ExchangeRequest request;
+                request.set_peer(workers[b]);
+                request.set_free_sent(true);
+                for (size_t f = 0; f < partitions.size(); f++) {
+                    *request.add_send() = partitions[f][a].at(b);
+                    *request.add_receive() = partitions[f][b].at(a);
+                }
+                caller.asyncExchangeCall(workers[a], {a, b}, request);
+            }
+            while (!caller.isQueueEmpty()) {
+                auto response = caller.getNextResult();
+                const auto [a, b] = response.storedInfo;
+                for (size_t f = 0; f < partitions.size(); f++) {
+                    res[f][a].push_back(response.result.received(f));
+                    res[f][b].push_back(response.result.peer_received(f));
+                }
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Creates the frame of the rows of the frames the workers returned, in the order of the workers.
+     */
+    static Frame *collect(const Results &results) {
+        std::vector<const distributed::Frame *> frameProtos;
+        for (auto &result : results)
+            frameProtos.push_back(&result.frame());
+        return createFrameFromProto(frameProtos);
+    }
+
+    /**
+     * @brief The rows of the frame ordered by the given columns of uint64_t, e.g., the indexes of the rows of the
+     * inputs of the operator the frame is the result of (see `scatter()`).
+     */
+    static std::vector<size_t> orderByRowIds(const Frame *frame, const std::vector<size_t> &colIdxs) {
+        std::vector<const uint64_t *> rowIds;
+        for (size_t c : colIdxs)
+            rowIds.push_back(static_cast<const uint64_t *>(frame->getColumnRaw(c)));
+        std::vector<size_t> rows(frame->getNumRows());
+        std::iota(rows.begin(), rows.end(), 0);
+        std::sort(rows.begin(), rows.end(), [&rowIds](size_t a, size_t b) {
+            for (auto values : rowIds)
+                if (values[a] != values[b])
+                    return values[a] < values[b];
+            return false;
+        });
+        return rows;
+    }
+
+    /**
+     * @brief Frees the frames at the workers.
+     */
+    static void free(const std::vector<std::string> &workers, const Parts &parts) {
+        for (size_t w = 0; w < parts.size(); w++)
+            for (auto &stored : parts[w])
+                DistributedGarbage::get().release(workers[w], stored.identifier());
+    }
+
+    static void setStored(google::protobuf::RepeatedPtrField<distributed::StoredData> *field,
+                          const std::vector<distributed::StoredData> &stored) {
+        for (auto &s : stored)
+            *field->Add() = s;
+    }
+
+    static void setPartitioning(distributed::RelationalRequest &request, const std::vector<std::string> &keyCols,
+                                size_t numWorkers) {
+        request.set_num_partitions(numWorkers);
+        for (auto &keyCol : keyCols)
+            request.add_partition_on(keyCol);
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDSHUFFLE_H
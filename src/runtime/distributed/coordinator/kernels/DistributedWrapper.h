@@ -18,6 +18,7 @@
 #define SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDWRAPPER_H
 
 #include <ir/daphneir/Daphne.h>
+#include <ir/daphneir/Passes.h>
 
 #include <runtime/distributed/coordinator/kernels/Broadcast.h>
 #include <runtime/distributed/coordinator/kernels/Distribute.h>
@@ -25,6 +26,8 @@
 #include <runtime/distributed/coordinator/kernels/DistributedCompute.h>
 
 #include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DistributedGarbage.h>
 
 
 
@@ -33,6 +36,9 @@
 #include <mlir/Parser.h>
 #include <llvm/Support/SourceMgr.h>
 #include <mlir/IR/BuiltinTypes.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 using mlir::daphne::VectorSplit;
@@ -43,10 +49,6 @@ class DistributedWrapper {
 private:
     DCTX(_dctx);
 
-protected:
-    bool isBroadcast(mlir::daphne::VectorSplit splitMethod, const Structure *input) {
-        return splitMethod == VectorSplit::NONE || (splitMethod == VectorSplit::ROWS && input->getNumRows() == 1);
-    }
 public:
     DistributedWrapper(DCTX(dctx)) : _dctx(dctx) {
         //TODO start workers from here instead of manually (e.g. resource manager) ? 
@@ -65,23 +67,166 @@ public:
                  VectorCombine *combines)                 
     {        
         auto ctx = DistributedContext::get(_dctx);
-        auto workers = ctx->getWorkers();
-        
-        // Backend Implementation 
-        // gRPC hard-coded selection
-        // TODO choose implementation based on configFile/command-line argument        
-        const auto alloc_type = ALLOCATION_TYPE::DIST_GRPC;
 
         // output allocation for row-wise combine
+        bool allocated = true;
         for(size_t i = 0; i < numOutputs; ++i) {
             if(*(res[i]) == nullptr && outRows[i] != -1 && outCols[i] != -1) {
                 auto zeroOut = combines[i] == mlir::daphne::VectorCombine::ADD;
-                // TODO we know result is only DenseMatrix<double> for now,
-                // but in the future this will change to support other DataTypes
+                // the results are dense matrices of any value type of the proto messages (see DistributedCollect)
                 *(res[i]) = DataObjectFactory::create<DT>(outRows[i], outCols[i], zeroOut);
             }
+            allocated = allocated && *(res[i]) != nullptr;
+        }
+
+        if (!_dctx->config.distributed_async) {
+            run(mlirCode, res, inputs, numInputs, numOutputs, splits, combines);
+            return;
+        }
+        if (!allocated) {
+            // The program needs the shapes of the results right away.
+            ctx->waitAll();
+            run(mlirCode, res, inputs, numInputs, numOutputs, splits, combines);
+            return;
         }
 
+        // The pipeline runs in the background (see DistributedContext::submit), on copies of the arrays of the
+        // compiled code, whose scalar inputs are held in the pointers themselves. The data objects are kept alive
+        // until it has finished, even if the program frees them before.
+        auto inputTypes = getPipelineInputTypes(mlirCode);
+        std::vector<const Structure *> objs;
+        for (size_t i = 0; i < numInputs; i++)
+            if (inputTypes.at(i) == INPUT_TYPE::Matrix)
+                objs.push_back(inputs[i]);
+        for (size_t i = 0; i < numOutputs; i++)
+            objs.push_back(*(res[i]));
+        for (auto obj : objs)
+            obj->increaseRefCounter();
+
+        std::string code(mlirCode);
+        std::vector<const Structure *> inputsCopy(inputs, inputs + numInputs);
+        std::vector<DT *> outputs;
+        for (size_t i = 0; i < numOutputs; i++)
+            outputs.push_back(*(res[i]));
+        std::vector<VectorSplit> splitsCopy(splits, splits + numInputs);
+        std::vector<VectorCombine> combinesCopy(combines, combines + numOutputs);
+        DCTX(dctx) = _dctx;
+        ctx->submit([=]() mutable {
+            std::vector<DT **> resCopy;
+            for (auto &output : outputs)
+                resCopy.push_back(&output);
+            try {
+                DistributedWrapper<DT>(dctx).run(code.c_str(), resCopy.data(), inputsCopy.data(), inputsCopy.size(),
+                                                 outputs.size(), splitsCopy.data(), combinesCopy.data());
+            }
+            catch (...) {
+                for (auto obj : objs)
+                    DataObjectFactory::destroy(obj);
+                throw;
+            }
+            for (auto obj : objs)
+                DataObjectFactory::destroy(obj);
+        }, objs);
+    }
+
+private:
+    /**
+     * @brief Distributes the inputs, computes the pipeline at the workers, and collects the results, which are
+     * allocated already, with the distributed backend of the context (see `distributed_backend`).
+     */
+    void run(const char *mlirCode,
+             DT ***res,
+             const Structure **inputs,
+             size_t numInputs,
+             size_t numOutputs,
+             VectorSplit *splits,
+             VectorCombine *combines)
+    {
+#ifdef USE_MPI
+        if (DistributedContext::get(_dctx)->getBackend() == ALLOCATION_TYPE::DIST_MPI) {
+            runOn<ALLOCATION_TYPE::DIST_MPI>(mlirCode, res, inputs, numInputs, numOutputs, splits, combines);
+            return;
+        }
+#endif
+        runWithRecovery(mlirCode, res, inputs, numInputs, numOutputs, splits, combines);
+    }
+
+    /**
+     * @brief Runs the pipeline with gRPC, excluding the workers that failed (see `distributed_max_failures`), and
+     * runs it again at the other workers if a worker failed while it ran.
+     */
+    void runWithRecovery(const char *mlirCode,
+                         DT ***res,
+                         const Structure **inputs,
+                         size_t numInputs,
+                         size_t numOutputs,
+                         VectorSplit *splits,
+                         VectorCombine *combines)
+    {
+        auto ctx = DistributedContext::get(_dctx);
+        const size_t maxFailures = _dctx->config.distributed_max_failures;
+        // the data of the data objects destroyed since the last pipeline is freed at the workers in the meantime
+        DistributedGarbage::get().flush(false);
+        // the workers suspected by the heartbeats are excluded before they fail the pipeline
+        if (maxFailures > 0)
+            excludeWorkers(ctx->detectFailedWorkers(false), maxFailures);
+        while (true) {
+            try {
+                runOn<ALLOCATION_TYPE::DIST_GRPC>(mlirCode, res, inputs, numInputs, numOutputs, splits, combines);
+                return;
+            }
+            catch (std::exception &) {
+                if (maxFailures == 0)
+                    throw;
+                // The pipeline failed for another reason if all workers are alive.
+                auto failedWorkers = ctx->detectFailedWorkers(true);
+                if (failedWorkers.empty())
+                    throw;
+                excludeWorkers(failedWorkers, maxFailures);
+            }
+            // The results are computed anew, where the partial results of aggregations are summed up from zero.
+            for (size_t o = 0; o < numOutputs; o++) {
+                auto &mdo = (*res[o])->getMetaDataObject();
+                std::vector<size_t> ids;
+                for (auto &dp : *mdo.getDataPlacementByType(ALLOCATION_TYPE::DIST_GRPC))
+                    ids.push_back(dp->dp_id);
+                for (size_t id : ids)
+                    mdo.removeDataPlacement(id);
+                if (combines[o] == VectorCombine::ADD) {
+                    using VT = typename DT::VT;
+                    auto denseMat = dynamic_cast<DenseMatrix<VT>*>(*res[o]);
+                    for (size_t r = 0; r < denseMat->getNumRows(); r++)
+                        std::fill_n(denseMat->getValues() + r * denseMat->getRowSkip(), denseMat->getNumCols(), VT(0));
+                }
+            }
+        }
+    }
+
+    void excludeWorkers(const std::vector<std::string> &failedWorkers, size_t maxFailures) {
+        auto ctx = DistributedContext::get(_dctx);
+        for (const auto &worker : failedWorkers) {
+            if (ctx->getNumFailedWorkers() >= maxFailures)
+                throw std::runtime_error("distributed worker " + worker + " failed after " + std::to_string(maxFailures)
+                        + " failed workers already (see distributed_max_failures)");
+            ctx->excludeWorker(worker);
+        }
+    }
+
+    template<ALLOCATION_TYPE alloc_type>
+    void runOn(const char *mlirCode,
+               DT ***res,
+               const Structure **inputs,
+               size_t numInputs,
+               size_t numOutputs,
+               VectorSplit *splits,
+               VectorCombine *combines)
+    {
+        auto ctx = DistributedContext::get(_dctx);
+        if (_dctx->config.distributed_load_balancing)
+            // Shift rows to the workers that were faster in the previous pipelines; the inputs are sent again
+            // where their partitions changed.
+            ctx->rebalance();
+
         // Currently an input might appear twice in the inputs array of a pipeline.
         // E.g. an input is needed both "Distributed/Scattered" and "Broadcasted".
         // This might cause conflicts regarding the meta data of an object since 
@@ -100,14 +245,24 @@ public:
             throw std::runtime_error("Distributed runtime only supports unique inputs for now (no duplicate inputs in a pipeline)");
         
         // Parse mlir code fragment to determin pipeline inputs/outputs
-        auto inputTypes = getPipelineInputTypes(mlirCode);
+        std::vector<bool> residentOutputs;
+        auto inputTypes = getPipelineInputTypes(mlirCode, &residentOutputs);
+        // The placements at failed workers are restored at the others by their lineage.
+        for (size_t i = 0; i < numInputs; i++)
+            if (inputTypes.at(i) == INPUT_TYPE::Matrix)
+                ctx->dropLostPlacements(inputs[i]);
+        // Sparse inputs split by rows are split by their non-zeros, and so are the other matrices of their number of
+        // rows, which are co-located with them.
+        for (size_t i = 0; i < numInputs; i++)
+            if (inputTypes.at(i) == INPUT_TYPE::Matrix && !DistributedContext::isBroadcast(splits[i], inputs[i]))
+                if (const size_t *rowOffsets = getRowOffsets(inputs[i]))
+                    ctx->balanceNonZeros(inputs[i]->getNumRows(), rowOffsets);
         // Distribute and broadcast inputs        
         // Each primitive sends information to workers and changes the Structures' metadata information 
         for (auto i = 0u; i < numInputs; ++i) {
-            // if already placed on workers, skip
-            // TODO maybe this is not enough. We might also need to check if data resides in the specific way we need to.
-            // (i.e. rows/cols splitted accordingly). If it does then we can skip.
-            if (isBroadcast(splits[i], inputs[i])){
+            // Inputs already placed at the workers in the way needed, e.g., by an earlier pipeline, are not sent
+            // again (the placements are by worker and range, see DistributedContext).
+            if (DistributedContext::isBroadcast(splits[i], inputs[i])){
                 auto type = inputTypes.at(i);
                 if (type==INPUT_TYPE::Matrix) {            
                     broadcast<alloc_type>(inputs[i], false, _dctx);
@@ -124,24 +279,44 @@ public:
         }
 
           
-        distributedCompute<alloc_type>(res, numOutputs, inputs, numInputs, mlirCode, combines, _dctx);
+        distributedCompute<alloc_type>(res, numOutputs, inputs, numInputs, mlirCode, splits, combines, _dctx);
 
-        // Collect
+        // Collect, except for the results which stay at the workers as the inputs of the next pipelines (see
+        // DistributePipelinesPass), such that the coordinator does not hold their values
         for (size_t o = 0; o < numOutputs; o++){
-            assert ((combines[o] == VectorCombine::ROWS || combines[o] == VectorCombine::COLS) && "we only support rows/cols combine atm");
+            if (!residentOutputs.empty() && residentOutputs.at(o))
+                continue;
+            // the partial results combined by ADD are summed up by the collect
+            assert ((combines[o] == VectorCombine::ROWS || combines[o] == VectorCombine::COLS || combines[o] == VectorCombine::ADD) && "we only support rows/cols/add combine atm");
             distributedCollect<alloc_type>(*res[o], _dctx);           
         }
-        
-        
     }
 
-private:
+    /**
+     * @brief The row offsets of a CSR matrix, or nullptr for other data objects.
+     */
+    static const size_t *getRowOffsets(const Structure *obj) {
+        if (auto mat = dynamic_cast<const CSRMatrix<double>*>(obj))
+            return mat->getRowOffsets();
+        if (auto mat = dynamic_cast<const CSRMatrix<float>*>(obj))
+            return mat->getRowOffsets();
+        if (auto mat = dynamic_cast<const CSRMatrix<int64_t>*>(obj))
+            return mat->getRowOffsets();
+        if (auto mat = dynamic_cast<const CSRMatrix<int32_t>*>(obj))
+            return mat->getRowOffsets();
+        return nullptr;
+    }
+
     enum INPUT_TYPE {
         Matrix,
         Double,
         // TOOD add more
     };
-    std::vector<INPUT_TYPE> getPipelineInputTypes(const char *mlirCode)
+    /**
+     * @brief Returns the types of the inputs of the pipeline, and whether each of its results stays at the workers
+     * (`ATTR_RESIDENT_OUTPUTS`, empty if none does) if `residentOutputs` is given.
+     */
+    std::vector<INPUT_TYPE> getPipelineInputTypes(const char *mlirCode, std::vector<bool> *residentOutputs = nullptr)
     {
         // is it safe to pass null for mlir::DaphneContext? 
         // Fixme: is it ok to allow unregistered dialects?
@@ -160,6 +335,10 @@ private:
             throw std::runtime_error(message);
         }
         auto distFuncTy = distFunc.getType();
+        if (residentOutputs)
+            if (auto resident = distFunc->getAttrOfType<mlir::ArrayAttr>(mlir::daphne::ATTR_RESIDENT_OUTPUTS))
+                for (auto attr : resident)
+                    residentOutputs->push_back(attr.cast<mlir::BoolAttr>().getValue());
         
         // TODO passing a vector<mlir::Type> seems to causes problems...
         // Use enum as work around for now but consider returning mlir::Type
@@ -0,0 +1,347 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_MPI_MPIHELPER_H
+#define SRC_RUNTIME_DISTRIBUTED_MPI_MPIHELPER_H
+
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The protocol of the MPI backend of the distributed runtime between the coordinator (rank 0 of
+ * `MPI_COMM_WORLD`) and the distributed workers (all other ranks).
+ *
+ * The workers wait for the header of the next command, which the coordinator broadcasts, and then take part in the
+ * collectives of the command: the partitions of a matrix are scattered by `MPI_Scatterv`, matrices and scalars needed
+ * by all workers are sent by `MPI_Bcast`, the partitions of the results are gathered by `MPI_Gatherv` (or received one
+ * by one if they are split by columns), and the partial results of aggregations are summed up by `MPI_Reduce`. The
+ * counts and displacements of the matrices are rows (see `RowType`), which exceed the range of `int` much later than
+ * the cells.
+ */
+class MPIHelper {
+public:
+    static constexpr int COORDINATOR = 0;
+    // the maximum length of the identifiers of the data at the workers and of the error messages of their tasks
+    static constexpr size_t ID_BYTES = 32;
+    static constexpr size_t ERROR_BYTES = 1024;
+
+    enum class Command : int64_t {
+        // args: the number of columns of the matrix whose partitions are scattered
+        STORE,
+        // args: the shape of the matrix, whether it is a scalar instead, and the bits of the scalar
+        BROADCAST,
+        // args: the lengths of the code and the config of the task, and the number of its inputs and outputs
+        COMPUTE,
+        // args: none, the partitions are gathered by rows, received by columns, or summed up
+        COLLECT_ROWS,
+        COLLECT_COLS,
+        SUM,
+        SHUTDOWN,
+    };
+
+    struct Header {
+        Command command;
+        uint64_t args[4];
+    };
+
+    // the identifier and shape of data stored at a worker, with a fixed size for the collectives
+    struct StoredData {
+        char identifier[ID_BYTES];
+        uint64_t numRows;
+        uint64_t numCols;
+    };
+
+    /**
+     * @brief The datatype of a row of doubles of a dense matrix whose rows are `rowSkip` cells apart.
+     */
+    class RowType {
+        MPI_Datatype type;
+    public:
+        RowType(size_t numCols, size_t rowSkip) {
+            MPI_Datatype row;
+            MPI_Type_contiguous(toInt(numCols), MPI_DOUBLE, &row);
+            MPI_Type_create_resized(row, 0, static_cast<MPI_Aint>(rowSkip * sizeof(double)), &type);
+            MPI_Type_free(&row);
+            MPI_Type_commit(&type);
+        }
+        RowType(const RowType &) = delete;
+        RowType &operator=(const RowType &) = delete;
+        ~RowType() {
+            MPI_Type_free(&type);
+        }
+        MPI_Datatype get() const {
+            return type;
+        }
+    };
+
+    static int getRank() {
+        int rank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        return rank;
+    }
+
+    static int getSize() {
+        int size;
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+        return size;
+    }
+
+    /**
+     * @brief The rank of the worker of the given index in `DistributedContext::getWorkers`.
+     */
+    static int getWorkerRank(size_t workerIx) {
+        return static_cast<int>(workerIx) + 1;
+    }
+
+    static void check(int err, const char *op) {
+        if (err == MPI_SUCCESS)
+            return;
+        char msg[MPI_MAX_ERROR_STRING];
+        int len = 0;
+        MPI_Error_string(err, msg, &len);
+        throw std::runtime_error(std::string("MPI: ") + op + " failed: " + std::string(msg, len));
+    }
+
+    static int toInt(size_t count) {
+        if (count > static_cast<size_t>(INT_MAX))
+            throw std::runtime_error("MPI: " + std::to_string(count) + " elements exceed the counts of MPI");
+        return static_cast<int>(count);
+    }
+
+    /**
+     * @brief Initializes MPI at the calling process, which may call MPI from any single thread at a time (e.g., the
+     * one of the asynchronous pipelines of the coordinator). The errors of MPI are thrown instead of aborting.
+     */
+    static void init() {
+        int initialized;
+        MPI_Initialized(&initialized);
+        if (!initialized) {
+            int provided;
+            MPI_Init_thread(nullptr, nullptr, MPI_THREAD_SERIALIZED, &provided);
+            if (provided < MPI_THREAD_SERIALIZED)
+                throw std::runtime_error("MPI: the MPI library does not support calls from different threads");
+        }
+        MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
+    }
+
+    static void broadcastHeader(Header &header) {
+        check(MPI_Bcast(&header, sizeof(Header), MPI_BYTE, COORDINATOR, MPI_COMM_WORLD), "MPI_Bcast");
+    }
+
+    /**
+     * @brief Broadcasts the string of the coordinator, whose length the workers know from the header already.
+     */
+    static void broadcastString(std::string &str) {
+        check(MPI_Bcast(str.data(), toInt(str.size()), MPI_CHAR, COORDINATOR, MPI_COMM_WORLD), "MPI_Bcast");
+    }
+
+    static StoredData makeStoredData(const std::string &identifier, size_t numRows, size_t numCols) {
+        if (identifier.size() >= ID_BYTES)
+            throw std::runtime_error("MPI: the identifier " + identifier + " is too long");
+        StoredData data{};
+        std::memcpy(data.identifier, identifier.data(), identifier.size());
+        data.numRows = numRows;
+        data.numCols = numCols;
+        return data;
+    }
+
+    static std::string getIdentifier(const StoredData &data) {
+        return std::string(data.identifier, strnlen(data.identifier, ID_BYTES));
+    }
+
+    /**
+     * @brief Sends `count` stored data of each rank from the coordinator, by rank (ignored at the workers).
+     *
+     * @return The `count` stored data of the calling rank
+     */
+    static std::vector<StoredData> scatterStored(const std::vector<StoredData> &all, size_t count) {
+        std::vector<StoredData> own(count);
+        const int bytes = toInt(count * sizeof(StoredData));
+        check(MPI_Scatter(all.data(), bytes, MPI_BYTE, own.data(), bytes, MPI_BYTE, COORDINATOR, MPI_COMM_WORLD),
+              "MPI_Scatter");
+        return own;
+    }
+
+    /**
+     * @brief Gathers `count` stored data of each rank at the coordinator, where missing ones are empty.
+     *
+     * @return The stored data of all ranks by rank at the coordinator, or nothing at the workers
+     */
+    static std::vector<StoredData> gatherStored(std::vector<StoredData> own, size_t count) {
+        own.resize(count, StoredData{});
+        std::vector<StoredData> all;
+        if (getRank() == COORDINATOR)
+            all.resize(count * getSize());
+        const int bytes = toInt(count * sizeof(StoredData));
+        check(MPI_Gather(own.data(), bytes, MPI_BYTE, all.data(), bytes, MPI_BYTE, COORDINATOR, MPI_COMM_WORLD),
+              "MPI_Gather");
+        return all;
+    }
+
+    /**
+     * @brief Gathers the error messages of the workers (empty if there was none) at the coordinator.
+     */
+    static std::vector<std::string> gatherErrors(const std::string &own) {
+        std::vector<char> ownBytes(ERROR_BYTES, '\0');
+        std::memcpy(ownBytes.data(), own.data(), std::min(own.size(), ERROR_BYTES - 1));
+        std::vector<char> all;
+        if (getRank() == COORDINATOR)
+            all.resize(ERROR_BYTES * getSize());
+        check(MPI_Gather(ownBytes.data(), ERROR_BYTES, MPI_CHAR, all.data(), ERROR_BYTES, MPI_CHAR, COORDINATOR,
+                         MPI_COMM_WORLD), "MPI_Gather");
+        std::vector<std::string> errors;
+        for (size_t i = 0; i < all.size(); i += ERROR_BYTES)
+            errors.emplace_back(all.data() + i, strnlen(all.data() + i, ERROR_BYTES));
+        return errors;
+    }
+
+    // ------------------------------------------------------------------------
+    // The commands, called by the coordinator
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Sends the given numbers of rows (by rank, 0 for none) of the matrix from the given first rows to the
+     * workers, which store them.
+     *
+     * @return The stored data of the ranks that received rows, by rank
+     */
+    static std::vector<StoredData> scatterRows(const DenseMatrix<double> *mat, const std::vector<int> &counts,
+                                               const std::vector<int> &displs) {
+        Header header{Command::STORE, {mat->getNumCols(), 0, 0, 0}};
+        broadcastHeader(header);
+        std::vector<uint64_t> numRows(counts.begin(), counts.end());
+        uint64_t ownRows;
+        check(MPI_Scatter(numRows.data(), 1, MPI_UINT64_T, &ownRows, 1, MPI_UINT64_T, COORDINATOR, MPI_COMM_WORLD),
+              "MPI_Scatter");
+        RowType rowType(mat->getNumCols(), mat->getRowSkip());
+        check(MPI_Scatterv(mat->getValues(), counts.data(), displs.data(), rowType.get(), nullptr, 0, rowType.get(),
+                           COORDINATOR, MPI_COMM_WORLD), "MPI_Scatterv");
+        return gatherStored({}, 1);
+    }
+
+    /**
+     * @brief Sends the matrix to all workers, which store it.
+     *
+     * @return The stored data of all ranks, by rank
+     */
+    static std::vector<StoredData> broadcastMatrix(const DenseMatrix<double> *mat) {
+        Header header{Command::BROADCAST, {mat->getNumRows(), mat->getNumCols(), 0, 0}};
+        broadcastHeader(header);
+        RowType rowType(mat->getNumCols(), mat->getRowSkip());
+        check(MPI_Bcast(const_cast<double *>(mat->getValues()), toInt(mat->getNumRows()), rowType.get(),
+                        COORDINATOR, MPI_COMM_WORLD), "MPI_Bcast");
+        return gatherStored({}, 1);
+    }
+
+    static std::vector<StoredData> broadcastScalar(double val) {
+        Header header{Command::BROADCAST, {0, 0, 1, 0}};
+        std::memcpy(&header.args[3], &val, sizeof(double));
+        broadcastHeader(header);
+        return gatherStored({}, 1);
+    }
+
+    /**
+     * @brief Computes the task of the given code at all workers on their inputs (`numInputs` per rank, by rank).
+     *
+     * @return The `numOutputs` outputs of each rank, by rank
+     */
+    static std::vector<StoredData> compute(std::string code, std::string config, const std::vector<StoredData> &inputs,
+                                           size_t numInputs, size_t numOutputs) {
+        Header header{Command::COMPUTE, {code.size(), config.size(), numInputs, numOutputs}};
+        broadcastHeader(header);
+        broadcastString(code);
+        broadcastString(config);
+        scatterStored(inputs, numInputs);
+        auto outputs = gatherStored({}, numOutputs);
+        auto errors = gatherErrors("");
+        for (size_t rank = 0; rank < errors.size(); rank++)
+            if (!errors[rank].empty())
+                throw std::runtime_error("DistributedCompute: the task failed at rank " + std::to_string(rank) + ": "
+                                         + errors[rank]);
+        return outputs;
+    }
+
+    /**
+     * @brief Copies the partitions of the workers (by rank, empty identifiers for none) into the given numbers of
+     * rows from the given first rows of the matrix.
+     */
+    static void gatherRows(DenseMatrix<double> *mat, const std::vector<StoredData> &parts,
+                           const std::vector<int> &counts, const std::vector<int> &displs) {
+        Header header{Command::COLLECT_ROWS, {0, 0, 0, 0}};
+        broadcastHeader(header);
+        scatterStored(parts, 1);
+        RowType rowType(mat->getNumCols(), mat->getRowSkip());
+        check(MPI_Gatherv(nullptr, 0, rowType.get(), mat->getValues(), counts.data(), displs.data(), rowType.get(),
+                          COORDINATOR, MPI_COMM_WORLD), "MPI_Gatherv");
+    }
+
+    /**
+     * @brief Copies the partitions of the workers (by rank, empty identifiers for none), which hold all rows, into
+     * the columns from the given first columns of the matrix.
+     */
+    static void gatherCols(DenseMatrix<double> *mat, const std::vector<StoredData> &parts,
+                           const std::vector<size_t> &colStarts) {
+        Header header{Command::COLLECT_COLS, {0, 0, 0, 0}};
+        broadcastHeader(header);
+        scatterStored(parts, 1);
+        for (size_t rank = 1; rank < parts.size(); rank++) {
+            if (getIdentifier(parts[rank]).empty())
+                continue;
+            RowType rowType(parts[rank].numCols, mat->getRowSkip());
+            check(MPI_Recv(mat->getValues() + colStarts[rank], toInt(mat->getNumRows()), rowType.get(),
+                           static_cast<int>(rank), 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE), "MPI_Recv");
+        }
+    }
+
+    /**
+     * @brief Adds the sum of the partial results of the workers (by rank, empty identifiers for none), which have the
+     * shape of the matrix, to the matrix.
+     */
+    static void sum(DenseMatrix<double> *mat, const std::vector<StoredData> &parts) {
+        Header header{Command::SUM, {mat->getNumRows(), mat->getNumCols(), 0, 0}};
+        broadcastHeader(header);
+        scatterStored(parts, 1);
+        const size_t numCols = mat->getNumCols();
+        std::vector<double> sums(mat->getNumRows() * numCols, 0.0);
+        check(MPI_Reduce(MPI_IN_PLACE, sums.data(), toInt(sums.size()), MPI_DOUBLE, MPI_SUM, COORDINATOR,
+                         MPI_COMM_WORLD), "MPI_Reduce");
+        for (size_t r = 0; r < mat->getNumRows(); r++) {
+            double *resRow = mat->getValues() + r * mat->getRowSkip();
+            for (size_t c = 0; c < numCols; c++)
+                resRow[c] += sums[r * numCols + c];
+        }
+    }
+
+    /**
+     * @brief Lets the workers exit and finalizes MPI.
+     */
+    static void shutdown() {
+        Header header{Command::SHUTDOWN, {0, 0, 0, 0}};
+        broadcastHeader(header);
+        MPI_Finalize();
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_MPI_MPIHELPER_H
@@ -16,6 +16,28 @@
 
 #include "CallData.h"
 
+#include <runtime/local/datastructures/DataObjectFactory.h>
+
+#include <exception>
+#include <string>
+
+namespace {
+    // the context of the trace of the caller, if any (see Tracing)
+    std::string getTraceparent(const grpc::ServerContext &ctx) {
+        auto it = ctx.client_metadata().find(TraceContext::HEADER);
+        if (it == ctx.client_metadata().end())
+            return "";
+        return std::string(it->second.data(), it->second.size());
+    }
+
+    void finishCall(ServedCall &served, const WorkerImplGRPC *worker, const grpc::Status &status, uint64_t bytesOut) {
+        std::string error;
+        if (!status.ok())
+            error = status.error_message().empty() ? "failed" : status.error_message();
+        served.finish(error, bytesOut, worker->GetResidentBytes(), worker->GetNumObjects());
+    }
+}
+
 void StoreCallData::Proceed() {
     if (status_ == CREATE)
     {
@@ -30,7 +52,9 @@ void StoreCallData::Proceed() {
         status_ = FINISH;
 
         new StoreCallData(worker, cq_);
+        ServedCall served("Store", getTraceparent(ctx_), data.ByteSizeLong());
         grpc::Status status = worker->StoreGRPC(&ctx_, &data, &storedData);
+        finishCall(served, worker, status, storedData.ByteSizeLong());
 
         responder_.Finish(storedData, grpc::Status::OK, this);
     }
@@ -56,7 +80,9 @@ void ComputeCallData::Proceed() {
 
         new ComputeCallData(worker, cq_);
 
+        ServedCall served("Compute", getTraceparent(ctx_), task.ByteSizeLong());
         grpc::Status status = worker->ComputeGRPC(&ctx_, &task, &result);
+        finishCall(served, worker, status, result.ByteSizeLong());
 
         responder_.Finish(result, status, this);
     }
@@ -82,7 +108,9 @@ void TransferCallData::Proceed() {
 
         new TransferCallData(worker, cq_);
 
+        ServedCall served("Transfer", getTraceparent(ctx_), storedData.ByteSizeLong());
         grpc::Status status = worker->TransferGRPC(&ctx_, &storedData, &matrix);
+        finishCall(served, worker, status, matrix.ByteSizeLong());
 
         responder_.Finish(matrix, status, this);
     }
@@ -94,28 +122,314 @@ void TransferCallData::Proceed() {
 }
 
 
-// void FreeMemCallData::Proceed() {
-//     if (status_ == CREATE)
-//     {
-//         // Make this instance progress to the PROCESS state.
-//         status_ = PROCESS;
+StoreStreamCallData::~StoreStreamCallData() {
+    if (mat)
+        DataObjectFactory::destroy(mat);
+}
+
+void StoreStreamCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestStoreStream(&ctx_, &reader_, cq_, cq_, this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = READ;
+
+        new StoreStreamCallData(worker, cq_);
+
+        served = std::make_unique<ServedCall>("StoreStream", getTraceparent(ctx_), 0, false);
+        reader_.Read(&chunk, this);
+    }
+    else if (status_ == READ)
+    {
+        served->addBytesIn(chunk.ByteSizeLong());
+        try {
+            worker->StoreChunkGRPC(chunk, mat);
+        }
+        catch (std::exception &e) {
+            status_ = FINISH;
+            grpc::Status status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            finishCall(*served, worker, status, 0);
+            reader_.FinishWithError(status, this);
+            return;
+        }
+        reader_.Read(&chunk, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void StoreStreamCallData::ProceedNotOk() {
+    if (status_ == READ)
+    {
+        status_ = FINISH;
+
+        grpc::Status status = worker->StoreStreamGRPC(mat, &storedData);
+        if (status.ok())
+            // The worker owns the stored matrix now.
+            mat = nullptr;
+        finishCall(*served, worker, status, storedData.ByteSizeLong());
+
+        reader_.Finish(storedData, status, this);
+    }
+    else
+        delete this;
+}
+
+void TransferStreamCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestTransferStream(&ctx_, &request, &writer_, cq_, cq_,
+                                        this);
+    }
+    else if (status_ == PROCESS)
+    {
+        new TransferStreamCallData(worker, cq_);
+
+        served = std::make_unique<ServedCall>("TransferStream", getTraceparent(ctx_), request.ByteSizeLong(), false);
+        const auto &stored = request.stored();
+        mat = worker->Transfer({stored.identifier(), stored.num_rows(), stored.num_cols()});
+        if (!mat) {
+            status_ = FINISH;
+            grpc::Status status(grpc::StatusCode::NOT_FOUND, "GRPC: no matrix " + stored.identifier());
+            finishCall(*served, worker, status, 0);
+            writer_.Finish(status, this);
+            return;
+        }
+        // Even an empty matrix is sent as one chunk, which carries its shape.
+        WriteNextChunk();
+    }
+    else if (status_ == WRITE)
+    {
+        if (rowBegin < mat->getNumRows())
+            WriteNextChunk();
+        else {
+            status_ = FINISH;
+            finishCall(*served, worker, grpc::Status::OK, bytesOut);
+            writer_.Finish(grpc::Status::OK, this);
+        }
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void TransferStreamCallData::WriteNextChunk() {
+    chunk.Clear();
+    try {
+        rowBegin = worker->TransferChunkGRPC(mat, rowBegin, request.chunk_bytes(), &chunk);
+    }
+    catch (std::exception &e) {
+        status_ = FINISH;
+        grpc::Status status(grpc::StatusCode::ABORTED, e.what());
+        finishCall(*served, worker, status, bytesOut);
+        writer_.Finish(status, this);
+        return;
+    }
+    bytesOut += chunk.ByteSizeLong();
+    status_ = WRITE;
+    writer_.Write(chunk, this);
+}
+
+void BroadcastCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestBroadcast(&ctx_, &request, &responder_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = FINISH;
+
+        new BroadcastCallData(worker, cq_);
+
+        ServedCall served("Broadcast", getTraceparent(ctx_), request.ByteSizeLong());
+        grpc::Status status = worker->BroadcastGRPC(&ctx_, &request, &result);
+        finishCall(served, worker, status, result.ByteSizeLong());
+
+        responder_.Finish(result, status, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void ReduceCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestReduce(&ctx_, &request, &responder_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = FINISH;
+
+        new ReduceCallData(worker, cq_);
+
+        ServedCall served("Reduce", getTraceparent(ctx_), request.ByteSizeLong());
+        grpc::Status status = worker->ReduceGRPC(&ctx_, &request, &result);
+        finishCall(served, worker, status, result.ByteSizeLong());
+
+        responder_.Finish(result, status, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void ReadCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestRead(&ctx_, &request, &responder_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = FINISH;
+
+        new ReadCallData(worker, cq_);
+
+        ServedCall served("Read", getTraceparent(ctx_), request.ByteSizeLong());
+        grpc::Status status = worker->ReadGRPC(&ctx_, &request, &storedData);
+        finishCall(served, worker, status, storedData.ByteSizeLong());
+
+        responder_.Finish(storedData, status, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void HeartbeatCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        status_ = PROCESS;
+
+        service_->RequestHeartbeat(&ctx_, &request, &responder_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = FINISH;
+
+        new HeartbeatCallData(worker, cq_);
+
+        responder_.Finish(response, grpc::Status::OK, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void FreeMemCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestFreeMem(&ctx_, &request, &responder_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = FINISH;
+
+        new FreeMemCallData(worker, cq_);
+
+        ServedCall served("FreeMem", getTraceparent(ctx_), request.ByteSizeLong());
+        grpc::Status status = worker->FreeMemGRPC(&ctx_, &request, &workerMemory);
+        finishCall(served, worker, status, workerMemory.ByteSizeLong());
+
+        responder_.Finish(workerMemory, status, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void RelationalCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestRelational(&ctx_, &request, &responder_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = FINISH;
 
-//         service_->RequestFreeMem(&ctx_, &storedData, &responder_, cq_, cq_,
-//                                     this);
-//     }
-//     else if (status_ == PROCESS)
-//     {
-//         status_ = FINISH;
+        new RelationalCallData(worker, cq_);
 
-//         new FreeMemCallData(worker, cq_);
+        ServedCall served("Relational", getTraceparent(ctx_), request.ByteSizeLong());
+        grpc::Status status = worker->RelationalGRPC(&ctx_, &request, &relationalResult);
+        finishCall(served, worker, status, relationalResult.ByteSizeLong());
 
-//         grpc::Status status = worker->FreeMem(&ctx_, &storedData, &emptyMessage);
+        responder_.Finish(relationalResult, status, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
 
-//         responder_.Finish(emptyMessage, status, this);
-//     }
-//     else
-//     {
-//         GPR_ASSERT(status_ == FINISH);
-//         delete this;
-//     }
-// }
\ No newline at end of file
+void ExchangeCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestExchange(&ctx_, &request, &responder_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = FINISH;
+
+        new ExchangeCallData(worker, cq_);
+
+        ServedCall served("Exchange", getTraceparent(ctx_), request.ByteSizeLong());
+        grpc::Status status = worker->ExchangeGRPC(&ctx_, &request, &exchangeResult);
+        finishCall(served, worker, status, exchangeResult.ByteSizeLong());
+
+        responder_.Finish(exchangeResult, status, this);
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
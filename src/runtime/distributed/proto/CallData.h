@@ -18,13 +18,19 @@
 #pragma once
 
 #include <runtime/distributed/worker/WorkerImplGRPC.h>
+#include <runtime/distributed/worker/WorkerMetrics.h>
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
 
+#include <memory>
+
 class CallData
 {
 public:
     virtual void Proceed() = 0;
+    // Called instead of Proceed() if the event of the call failed, e.g., at the end of a stream or if the client
+    // cancelled the call.
+    virtual void ProceedNotOk() { delete this; }
     virtual ~CallData() = default;
 };
 class StoreCallData final : public CallData
@@ -129,32 +135,307 @@ private:
     CallStatus status_; // The current serving state.
 };
 
-// class FreeMemCallData final : public CallData
-// {
-//     public:
-//         FreeMemCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
-//             : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
-//         {
-//             // Invoke the serving logic right away.
-//             Proceed();
-//         }
-//         void Proceed() override;
-//     private:
-//         WorkerImplGRPC *worker;
-//         distributed::Worker::AsyncService *service_;
-//         // The producer-consumer queue where for asynchronous server notifications.
-//         grpc::ServerCompletionQueue *cq_;
-//         grpc::ServerContext ctx_;
-        
-//         distributed::StoredData storedData;
-//         distributed::Empty emptyMessage;
-//         grpc::ServerAsyncResponseWriter<distributed::Empty> responder_;
-
-//     enum CallStatus
-//     {
-//         CREATE,
-//         PROCESS,
-//         FINISH
-//     };
-//     CallStatus status_; // The current serving state.
-// };
+class StoreStreamCallData final : public CallData
+{
+public:
+    StoreStreamCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), reader_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    ~StoreStreamCallData() override;
+    void Proceed() override;
+    // the end of the chunks
+    void ProceedNotOk() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client, one chunk after the other.
+    distributed::MatrixChunk chunk;
+    // The matrix assembled from the chunks so far, owned by this call until it is stored.
+    Structure *mat = nullptr;
+    // the metrics of the call from its first chunk on
+    std::unique_ptr<ServedCall> served;
+    // What we send back to the client.
+    distributed::StoredData storedData;
+    // The means to get back to the client.
+    grpc::ServerAsyncReader<distributed::StoredData, distributed::MatrixChunk> reader_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        READ,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class TransferStreamCallData final : public CallData
+{
+public:
+    TransferStreamCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), writer_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    void WriteNextChunk();
+
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::TransferRequest request;
+    // What we send back to the client, one chunk after the other.
+    distributed::MatrixChunk chunk;
+    const Structure *mat = nullptr;
+    size_t rowBegin = 0;
+    // the metrics of the call and the bytes of the chunks sent so far
+    std::unique_ptr<ServedCall> served;
+    uint64_t bytesOut = 0;
+    // The means to get back to the client.
+    grpc::ServerAsyncWriter<distributed::MatrixChunk> writer_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        WRITE,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class BroadcastCallData final : public CallData
+{
+public:
+    BroadcastCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::BroadcastRequest request;
+    // What we send back to the client.
+    distributed::CollectiveResult result;
+    // The means to get back to the client.
+    grpc::ServerAsyncResponseWriter<distributed::CollectiveResult> responder_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class ReduceCallData final : public CallData
+{
+public:
+    ReduceCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::ReduceRequest request;
+    // What we send back to the client.
+    distributed::CollectiveResult result;
+    // The means to get back to the client.
+    grpc::ServerAsyncResponseWriter<distributed::CollectiveResult> responder_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class ReadCallData final : public CallData
+{
+public:
+    ReadCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::ReadRequest request;
+    // What we send back to the client.
+    distributed::StoredData storedData;
+    // The means to get back to the client.
+    grpc::ServerAsyncResponseWriter<distributed::StoredData> responder_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+/**
+ * @brief Answers the heartbeats of the coordinator, which are served on a
+ * completion queue and thread of their own (see WorkerImplGRPC::Wait), such
+ * that the worker answers them while it computes.
+ */
+class HeartbeatCallData final : public CallData
+{
+public:
+    HeartbeatCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    distributed::Empty request;
+    distributed::Empty response;
+    grpc::ServerAsyncResponseWriter<distributed::Empty> responder_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class FreeMemCallData final : public CallData
+{
+public:
+    FreeMemCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::FreeMemRequest request;
+    // What we send back to the client.
+    distributed::WorkerMemory workerMemory;
+    // The means to get back to the client.
+    grpc::ServerAsyncResponseWriter<distributed::WorkerMemory> responder_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class RelationalCallData final : public CallData
+{
+public:
+    RelationalCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::RelationalRequest request;
+    // What we send back to the client.
+    distributed::RelationalResult relationalResult;
+    // The means to get back to the client.
+    grpc::ServerAsyncResponseWriter<distributed::RelationalResult> responder_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class ExchangeCallData final : public CallData
+{
+public:
+    ExchangeCallData(WorkerImplGRPC *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), responder_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImplGRPC *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::ExchangeRequest request;
+    // What we send back to the client.
+    distributed::ExchangeResult exchangeResult;
+    // The means to get back to the client.
+    grpc::ServerAsyncResponseWriter<distributed::ExchangeResult> responder_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
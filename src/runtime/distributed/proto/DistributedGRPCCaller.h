@@ -19,6 +19,19 @@
 #include <grpcpp/grpcpp.h>
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
+#include <runtime/distributed/proto/Tracing.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
 // ****************************************************************************
 // Class for async communication
@@ -49,6 +62,8 @@ private:
         StoredInfo storedInfo;
         // Contains the actual result of the call
         ReturnType result;
+        // Whether the call was cancelled by cancelCall(), such that the result is empty
+        bool cancelled = false;
     };
     struct AsyncClientCall
     {
@@ -57,13 +72,70 @@ private:
         
         StoredInfo storedInfo;
         ReturnType result;
+        bool cancelled = false;
+
+        AsyncClientCall() {
+            // The calls are children of the current span of the trace of the job, if any (see Tracing).
+            const TraceContext parent = Tracing::get().getCurrent();
+            if (parent.isValid())
+                context_.AddMetadata(TraceContext::HEADER, parent.toHeader());
+        }
     };
     int callCounter = 0;
     grpc::CompletionQueue cq_;
 
+    // The streamed calls run in threads of their own, which pass their finished calls to getNextResult().
+    int streamCounter = 0;
+    std::vector<std::thread> streamThreads;
+    std::deque<AsyncClientCall *> finishedStreams;
+    std::mutex streamMutex;
+    std::condition_variable streamFinished;
+    // The chunks are converted from and to the data objects one at a time, since they are not thread-safe, while
+    // the streams send and receive in parallel.
+    std::mutex chunkMutex;
+
+    ResultData finishCall(AsyncClientCall *call, bool ok) {
+        if (call->cancelled) {
+            ResultData ret({call->storedInfo, ReturnType(), true});
+            delete call;
+            return ret;
+        }
+        if (!(ok && call->status.ok())){
+            const std::string message = call->status.error_message();
+            delete call;
+            drain();
+            throw std::runtime_error(message);
+        }
+        ResultData ret({call->storedInfo, call->result});
+        delete call;
+        return ret;
+    }
+
+    // Waits for the outstanding unary calls after one failed, e.g., with its worker, such that the completion queue
+    // is not destroyed while they are pending (the streamed calls are joined by the destructor).
+    void drain() {
+        void *tag;
+        bool ok;
+        while (callCounter > 0 && cq_.Next(&tag, &ok)) {
+            callCounter--;
+            delete static_cast<AsyncClientCall*>(tag);
+        }
+    }
+
+    void finishStream(AsyncClientCall *call) {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        finishedStreams.push_back(call);
+        streamFinished.notify_one();
+    }
+
 public:
     DistributedGRPCCaller() {};
-    ~DistributedGRPCCaller() {};
+    ~DistributedGRPCCaller() {
+        for (auto &t : streamThreads)
+            t.join();
+        for (auto call : finishedStreams)
+            delete call;
+    };
     
     /**
     * @brief Enqueues an asynchronous Store call to be executed.     
@@ -102,8 +174,9 @@ public:
     * @param  workerAddr An address (or channel) to make the call
     * @param  StoredInfo An StoredInfo type returned when call response is ready
     * @param  arg Argument passed to the asynchronous call
+    * @return A handle of the call for cancelCall()
     */
-    void asyncComputeCall(
+    const void *asyncComputeCall(
         const std::shared_ptr<grpc::Channel> &channel,
         const StoredInfo &storedInfo,
         const Argument &arg
@@ -117,15 +190,29 @@ public:
         
         response_reader->Finish(&call->result, &call->status, (void*)call);
         callCounter++;
+        return call;
     }
-    void asyncComputeCall(
+    const void *asyncComputeCall(
         const std::string &workerAddr,
         const StoredInfo &storedInfo,
         const Argument &arg
         )
     {
         auto channel = GetOrCreateChannel(workerAddr);
-        asyncComputeCall(channel, storedInfo, arg);
+        return asyncComputeCall(channel, storedInfo, arg);
+    }
+
+    /**
+    * @brief Cancels a call, whose result was not returned yet, e.g., a task
+    *        executed by another worker in the meantime. The result of the
+    *        call is still returned, but with `cancelled` set.
+    * 
+    * @param  handle The handle returned when the call was enqueued
+    */
+    void cancelCall(const void *handle) {
+        auto call = static_cast<AsyncClientCall *>(const_cast<void *>(handle));
+        call->cancelled = true;
+        call->context_.TryCancel();
     }
     /**
     * @brief Enqueues an asynchronous Transfer call to be executed.     
@@ -158,38 +245,209 @@ public:
         auto channel = GetOrCreateChannel(workerAddr);
         asyncTransferCall(channel, storedInfo, arg);
     }
-    
     /**
-    * @brief Enqueues an asynchronous FreeMem call to be executed.     
-    * 
-    * @param  workerAddr An address (or channel) to make the call
+    * @brief Enqueues an asynchronous Broadcast call to be executed, which the
+    *        worker forwards to the peers in the argument.
+    *
+    * @param  workerAddr An address to make the call
     * @param  StoredInfo An StoredInfo type returned when call response is ready
     * @param  arg Argument passed to the asynchronous call
     */
-    void asyncFreeMemCall(
-        const std::shared_ptr<grpc::Channel> &channel,
+    void asyncBroadcastCall(
+        const std::string &workerAddr,
         const StoredInfo &storedInfo,
-        const Argument &arg
+        const distributed::BroadcastRequest &arg
         )
     {
         AsyncClientCall *call = new AsyncClientCall;
         call->storedInfo = storedInfo;
 
-        auto stub = distributed::Worker::NewStub(channel);
-        auto response_reader = stub->AsyncFreeMem(&call->context_, arg, &cq_);
-        
+        auto stub = distributed::Worker::NewStub(GetOrCreateChannel(workerAddr));
+        auto response_reader = stub->AsyncBroadcast(&call->context_, arg, &cq_);
+
         response_reader->Finish(&call->result, &call->status, (void*)call);
         callCounter++;
     }
-    void asyncFreeMemCall(
+    /**
+    * @brief Enqueues an asynchronous Reduce call to be executed, which the
+    *        worker forwards to the peers in the argument.
+    *
+    * @param  workerAddr An address to make the call
+    * @param  StoredInfo An StoredInfo type returned when call response is ready
+    * @param  arg Argument passed to the asynchronous call
+    */
+    void asyncReduceCall(
         const std::string &workerAddr,
         const StoredInfo &storedInfo,
-        const Argument &arg
+        const distributed::ReduceRequest &arg
         )
     {
-        auto channel = GetOrCreateChannel(workerAddr);
-        asyncFreeMemCall(channels, storedInfo, arg);
+        AsyncClientCall *call = new AsyncClientCall;
+        call->storedInfo = storedInfo;
+
+        auto stub = distributed::Worker::NewStub(GetOrCreateChannel(workerAddr));
+        auto response_reader = stub->AsyncReduce(&call->context_, arg, &cq_);
+
+        response_reader->Finish(&call->result, &call->status, (void*)call);
+        callCounter++;
+    }
+    /**
+    * @brief Enqueues an asynchronous Read call to be executed, by which the
+    *        worker reads rows of a file itself.
+    *
+    * @param  workerAddr An address to make the call
+    * @param  StoredInfo An StoredInfo type returned when call response is ready
+    * @param  arg Argument passed to the asynchronous call
+    */
+    void asyncReadCall(
+        const std::string &workerAddr,
+        const StoredInfo &storedInfo,
+        const distributed::ReadRequest &arg
+        )
+    {
+        AsyncClientCall *call = new AsyncClientCall;
+        call->storedInfo = storedInfo;
+
+        auto stub = distributed::Worker::NewStub(GetOrCreateChannel(workerAddr));
+        auto response_reader = stub->AsyncRead(&call->context_, arg, &cq_);
+
+        response_reader->Finish(&call->result, &call->status, (void*)call);
+        callCounter++;
+    }
+    /**
+    * @brief Enqueues an asynchronous Relational call to be executed, by which
+    *        the worker computes a relational operator on its frames.
+    *
+    * @param  workerAddr An address to make the call
+    * @param  StoredInfo An StoredInfo type returned when call response is ready
+    * @param  arg Argument passed to the asynchronous call
+    */
+    void asyncRelationalCall(
+        const std::string &workerAddr,
+        const StoredInfo &storedInfo,
+        const distributed::RelationalRequest &arg
+        )
+    {
+        AsyncClientCall *call = new AsyncClientCall;
+        call->storedInfo = storedInfo;
+
+        auto stub = distributed::Worker::NewStub(GetOrCreateChannel(workerAddr));
+        auto response_reader = stub->AsyncRelational(&call->context_, arg, &cq_);
+
+        response_reader->Finish(&call->result, &call->status, (void*)call);
+        callCounter++;
     }
+    /**
+    * @brief Enqueues an asynchronous Exchange call to be executed, by which
+    *        the worker swaps hash partitions with the peer in the argument.
+    *
+    * @param  workerAddr An address to make the call
+    * @param  StoredInfo An StoredInfo type returned when call response is ready
+    * @param  arg Argument passed to the asynchronous call
+    */
+    void asyncExchangeCall(
+        const std::string &workerAddr,
+        const StoredInfo &storedInfo,
+        const distributed::ExchangeRequest &arg
+        )
+    {
+        AsyncClientCall *call = new AsyncClientCall;
+        call->storedInfo = storedInfo;
+
+        auto stub = distributed::Worker::NewStub(GetOrCreateChannel(workerAddr));
+        auto response_reader = stub->AsyncExchange(&call->context_, arg, &cq_);
+
+        response_reader->Finish(&call->result, &call->status, (void*)call);
+        callCounter++;
+    }
+
+    /**
+    * @brief Starts a StoreStream call, which sends the chunks of rows filled
+    *        in by `nextChunk` (until it returns false) in a thread of its own,
+    *        such that the streams to several workers overlap.
+    * 
+    * @param  workerAddr An address to make the call
+    * @param  StoredInfo An StoredInfo type returned when call response is ready
+    * @param  nextChunk Fills in the next chunk, called at least once
+    */
+    void asyncStoreStreamCall(
+        const std::string &workerAddr,
+        const StoredInfo &storedInfo,
+        std::function<bool(distributed::MatrixChunk &)> nextChunk
+        )
+    {
+        AsyncClientCall *call = new AsyncClientCall;
+        call->storedInfo = storedInfo;
+        auto stub = distributed::Worker::NewStub(GetOrCreateChannel(workerAddr));
+
+        streamThreads.emplace_back([this, call, stub = std::move(stub), nextChunk]() {
+            auto writer = stub->StoreStream(&call->context_, &call->result);
+            distributed::MatrixChunk chunk;
+            try {
+                while (true) {
+                    chunk.Clear();
+                    {
+                        std::lock_guard<std::mutex> lock(chunkMutex);
+                        if (!nextChunk(chunk))
+                            break;
+                    }
+                    // The worker closed the stream, its status is returned by Finish().
+                    if (!writer->Write(chunk))
+                        break;
+                }
+                writer->WritesDone();
+                call->status = writer->Finish();
+            }
+            catch (std::exception &e) {
+                call->context_.TryCancel();
+                writer->Finish();
+                call->status = grpc::Status(grpc::StatusCode::ABORTED, e.what());
+            }
+            finishStream(call);
+        });
+        streamCounter++;
+    }
+    /**
+    * @brief Starts a TransferStream call, which hands the chunks of rows to
+    *        `onChunk` as they arrive, in a thread of its own, such that the
+    *        streams from several workers overlap.
+    * 
+    * @param  workerAddr An address to make the call
+    * @param  StoredInfo An StoredInfo type returned when call response is ready
+    * @param  arg The stored data to transfer and the size of the chunks
+    * @param  onChunk Converts a chunk, e.g., into a preallocated matrix
+    */
+    void asyncTransferStreamCall(
+        const std::string &workerAddr,
+        const StoredInfo &storedInfo,
+        const distributed::TransferRequest &arg,
+        std::function<void(const distributed::MatrixChunk &)> onChunk
+        )
+    {
+        AsyncClientCall *call = new AsyncClientCall;
+        call->storedInfo = storedInfo;
+        auto stub = distributed::Worker::NewStub(GetOrCreateChannel(workerAddr));
+
+        streamThreads.emplace_back([this, call, stub = std::move(stub), arg, onChunk]() {
+            auto reader = stub->TransferStream(&call->context_, arg);
+            distributed::MatrixChunk chunk;
+            try {
+                while (reader->Read(&chunk)) {
+                    std::lock_guard<std::mutex> lock(chunkMutex);
+                    onChunk(chunk);
+                }
+                call->status = reader->Finish();
+            }
+            catch (std::exception &e) {
+                call->context_.TryCancel();
+                reader->Finish();
+                call->status = grpc::Status(grpc::StatusCode::ABORTED, e.what());
+            }
+            finishStream(call);
+        });
+        streamCounter++;
+    }
+
     /**
     * @brief    Get the next available result from the queue of asynchronous calls
     * @result   A struct with two fields. First field is "StoredInfo" struct passed when the call was enqueued
@@ -198,24 +456,45 @@ public:
     ResultData getNextResult() {
         void *got_tag;
         bool ok = false;
-        cq_.Next(&got_tag, &ok);
-        callCounter--;
-        AsyncClientCall *call = static_cast<AsyncClientCall*>(got_tag);    
-        if (!(ok && call->status.ok())){
-            throw std::runtime_error(
-                call->status.error_message()
-            );
+        std::unique_lock<std::mutex> lock(streamMutex);
+        if (finishedStreams.empty() && callCounter > 0) {
+            // The finished streams wait until the next call.
+            lock.unlock();
+            cq_.Next(&got_tag, &ok);
+            callCounter--;
         }
-        ResultData ret({call->storedInfo, call->result});
-        delete call;
-        return ret;
+        else {
+            streamFinished.wait(lock, [this]() { return !finishedStreams.empty(); });
+            got_tag = finishedStreams.front();
+            finishedStreams.pop_front();
+            streamCounter--;
+            ok = true;
+        }
+        return finishCall(static_cast<AsyncClientCall*>(got_tag), ok);
+    };
+
+    /**
+    * @brief    Like getNextResult(), but waits for the unary calls only and
+    *           only until the deadline.
+    * @result   The result of the next call, or none if no call finished
+    *           before the deadline
+    */
+    std::optional<ResultData> tryGetNextResult(std::chrono::system_clock::time_point deadline) {
+        if (callCounter == 0)
+            return std::nullopt;
+        void *got_tag;
+        bool ok = false;
+        if (cq_.AsyncNext(&got_tag, &ok, deadline) != grpc::CompletionQueue::GOT_EVENT)
+            return std::nullopt;
+        callCounter--;
+        return finishCall(static_cast<AsyncClientCall*>(got_tag), ok);
     };
 
     /**
     * @brief Returns True if there are no more async calls to wait
     */
     bool isQueueEmpty() {
-        return (callCounter == 0);
+        return (callCounter == 0 && streamCounter == 0);
     };
 
     /**
@@ -240,4 +519,52 @@ public:
     
 };
 
+/**
+ * @brief Whether the worker at the given address answers a heartbeat within the given timeout. The workers answer
+ * heartbeats on a thread of their own, i.e., also while they compute.
+ */
+inline bool pingWorker(const std::string &workerAddr, std::chrono::milliseconds timeout) {
+    static std::mutex channelsMutex;
+    static std::map<std::string, std::shared_ptr<grpc::Channel>> channels;
+    std::shared_ptr<grpc::Channel> channel;
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        auto &c = channels[workerAddr];
+        if (!c)
+            c = grpc::CreateChannel(workerAddr, grpc::InsecureChannelCredentials());
+        channel = c;
+    }
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + timeout);
+    distributed::Empty request, response;
+    return distributed::Worker::NewStub(channel)->Heartbeat(&context, request, &response).ok();
+}
+
+/**
+ * @brief Frees the data of the given identifiers at the worker at the given address and returns the bytes the worker
+ * holds afterwards, or `std::nullopt` if it does not answer within the given timeout (see DistributedGarbage).
+ */
+inline std::optional<uint64_t> freeWorkerData(const std::string &workerAddr, const std::vector<std::string> &identifiers,
+                                              std::chrono::milliseconds timeout) {
+    static std::mutex channelsMutex;
+    static std::map<std::string, std::shared_ptr<grpc::Channel>> channels;
+    std::shared_ptr<grpc::Channel> channel;
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        auto &c = channels[workerAddr];
+        if (!c)
+            c = grpc::CreateChannel(workerAddr, grpc::InsecureChannelCredentials());
+        channel = c;
+    }
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + timeout);
+    distributed::FreeMemRequest request;
+    for (const auto &identifier : identifiers)
+        request.add_identifiers(identifier);
+    distributed::WorkerMemory response;
+    if (!distributed::Worker::NewStub(channel)->FreeMem(&context, request, &response).ok())
+        return std::nullopt;
+    return response.resident_bytes();
+}
+
 #endif //SRC_RUNTIME_DISTRIBUTED_COORDINATOR_KERNELS_DISTRIBUTEDCALLER_H
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_PROTO_HASHPARTITION_H
+#define SRC_RUNTIME_DISTRIBUTED_PROTO_HASHPARTITION_H
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <util/ColumnHash.h>
+
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+template<typename VT>
+void hashPartitionColumn(std::vector<uint64_t> &hashes, const void *values, bool first) {
+    ColumnHash::hashColumn(hashes.data(), static_cast<const VT *>(values), hashes.size(), first);
+}
+
+/**
+ * @brief Splits the rows of the frame into `numParts` partitions by the hash of their values in the key columns,
+ * such that the rows of equal keys are in the same partition, also across frames, whose key columns have the same
+ * value types.
+ *
+ * The workers partition their rows alike, such that the partitions of the same index of all workers form a hash
+ * partition of the whole frame, which the shuffle of the distributed relational operators sends to the same worker.
+ *
+ * @return The rows of each partition in ascending order
+ */
+inline std::vector<std::vector<size_t>> hashPartition(const Frame *frame, const std::vector<std::string> &keyCols,
+                                                      size_t numParts) {
+    if (numParts == 0)
+        throw std::runtime_error("hashPartition: the number of partitions must be positive");
+    const size_t numRows = frame->getNumRows();
+    std::vector<uint64_t> hashes(numRows, 0);
+    for (size_t i = 0; i < keyCols.size(); i++) {
+        const size_t idx = frame->getColumnIdx(keyCols[i]);
+        const void *values = frame->getColumnRaw(idx);
+        const bool first = i == 0;
+        switch (frame->getColumnType(idx)) {
+            case ValueTypeCode::SI8:  hashPartitionColumn<int8_t>(hashes, values, first); break;
+            case ValueTypeCode::SI32: hashPartitionColumn<int32_t>(hashes, values, first); break;
+            case ValueTypeCode::SI64: hashPartitionColumn<int64_t>(hashes, values, first); break;
+            case ValueTypeCode::UI8:  hashPartitionColumn<uint8_t>(hashes, values, first); break;
+            case ValueTypeCode::UI32: hashPartitionColumn<uint32_t>(hashes, values, first); break;
+            case ValueTypeCode::UI64: hashPartitionColumn<uint64_t>(hashes, values, first); break;
+            case ValueTypeCode::F32:  hashPartitionColumn<float>(hashes, values, first); break;
+            case ValueTypeCode::F64:  hashPartitionColumn<double>(hashes, values, first); break;
+            case ValueTypeCode::STR:  hashPartitionColumn<std::string>(hashes, values, first); break;
+            default:
+                throw std::runtime_error("hashPartition: unsupported value type of the key column " + keyCols[i]);
+        }
+    }
+    std::vector<std::vector<size_t>> parts(numParts);
+    for (size_t r = 0; r < numRows; r++)
+        parts[hashes[r] % numParts].push_back(r);
+    return parts;
+}
+
+/**
+ * @brief Copies the given rows of the given columns of the frame into a new frame, e.g., a hash partition.
+ */
+inline Frame *gatherRows(const Frame *frame, const std::vector<size_t> &rows, const std::vector<size_t> &colIdxs) {
+    std::vector<ValueTypeCode> schema;
+    std::vector<std::string> labels;
+    for (size_t c : colIdxs) {
+        schema.push_back(frame->getColumnType(c));
+        labels.push_back(frame->getLabels()[c]);
+    }
+    auto res = DataObjectFactory::create<Frame>(rows.size(), colIdxs.size(), schema.data(), labels.data(), false);
+    for (size_t i = 0; i < colIdxs.size(); i++) {
+        if (schema[i] == ValueTypeCode::STR) {
+            auto stringsArg = static_cast<const std::string *>(frame->getColumnRaw(colIdxs[i]));
+            auto stringsRes = static_cast<std::string *>(res->getColumnRaw(i));
+            for (size_t r = 0; r < rows.size(); r++)
+                stringsRes[r] = stringsArg[rows[r]];
+            continue;
+        }
+        const size_t elemSize = ValueTypeUtils::sizeOf(schema[i]);
+        auto valuesArg = static_cast<const uint8_t *>(frame->getColumnRaw(colIdxs[i]));
+        auto valuesRes = static_cast<uint8_t *>(res->getColumnRaw(i));
+        for (size_t r = 0; r < rows.size(); r++)
+            std::memcpy(valuesRes + r * elemSize, valuesArg + rows[r] * elemSize, elemSize);
+    }
+    return res;
+}
+
+inline Frame *gatherRows(const Frame *frame, const std::vector<size_t> &rows) {
+    std::vector<size_t> colIdxs(frame->getNumCols());
+    std::iota(colIdxs.begin(), colIdxs.end(), 0);
+    return gatherRows(frame, rows, colIdxs);
+}
+
+#endif //SRC_RUNTIME_DISTRIBUTED_PROTO_HASHPARTITION_H
@@ -15,6 +15,19 @@
  */
 
 #include "ProtoDataConverter.h"
+#include "WireCompression.h"
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <stdexcept>
+#include <type_traits>
+
+#include <cstdint>
+#include <cstring>
+
+// The column indexes and row offsets are sent as raw uint64.
+static_assert(sizeof(size_t) == sizeof(uint64_t), "ProtoDataConverter: size_t must have 64 bits");
 
 
 // ----------------------------------------------------------------------------
@@ -30,15 +43,21 @@ void ProtoDataConverter<DenseMatrix<VT>>::convertToProto(const DenseMatrix<VT> *
                                         size_t colBegin,
                                         size_t colEnd)
 {
-    matProto->set_num_rows(rowEnd - rowBegin);
-    matProto->set_num_cols(colEnd - colBegin);
+    const size_t numRows = rowEnd - rowBegin;
+    const size_t numCols = colEnd - colBegin;
+    matProto->set_num_rows(numRows);
+    matProto->set_num_cols(numCols);
 
-    auto *cells = getMutableCells(matProto);
-    cells->Reserve(mat->getNumRows() * mat->getNumCols());
-    for (auto r = rowBegin; r < rowEnd; ++r) {
-        for (auto c = colBegin; c < colEnd; ++c) {
-            cells->Add(mat->get(r, c));
-        }
+    auto *cells = getMutableRawCells(matProto);
+    const size_t rowSkip = mat->getRowSkip();
+    const size_t rowBytes = numCols * sizeof(VT);
+    const VT *values = mat->getValues() + rowBegin * rowSkip + colBegin;
+    if (numCols == rowSkip)
+        cells->assign(reinterpret_cast<const char *>(values), numRows * rowBytes);
+    else {
+        cells->resize(numRows * rowBytes);
+        for (size_t r = 0; r < numRows; r++)
+            std::memcpy(&(*cells)[r * rowBytes], values + r * rowSkip, rowBytes);
     }
 }
 
@@ -56,8 +75,28 @@ void ProtoDataConverter<DenseMatrix<VT>>::convertFromProto(const distributed::Ma
                                           size_t colBegin,
                                           size_t colEnd)
 {
-    auto denseMatProto = matProto.dense_matrix();
-    auto cells = getCells(&matProto);
+    if (isCompressed(matProto)) {
+        distributed::Matrix decompressed;
+        convertFromProto(decompressMatrix(matProto, decompressed), mat, rowBegin, rowEnd, colBegin, colEnd);
+        return;
+    }
+    if (auto *rawCells = getRawCells(&matProto)) {
+        const size_t numRows = rowEnd - rowBegin;
+        const size_t numCols = colEnd - colBegin;
+        const size_t rowSkip = mat->getRowSkip();
+        const size_t rowBytes = numCols * sizeof(VT);
+        if (rawCells->size() != numRows * rowBytes)
+            throw std::runtime_error("ProtoDataConverter: the raw cells do not match the shape of the matrix");
+        VT *values = mat->getValues() + rowBegin * rowSkip + colBegin;
+        if (numCols == rowSkip)
+            std::memcpy(values, rawCells->data(), numRows * rowBytes);
+        else
+            for (size_t r = 0; r < numRows; r++)
+                std::memcpy(values + r * rowSkip, rawCells->data() + r * rowBytes, rowBytes);
+        return;
+    }
+
+    const auto &cells = getCells(&matProto);
     for (auto r = rowBegin; r < rowEnd; ++r) {
         for (auto c = colBegin; c < colEnd; ++c) {
             auto val = cells.Get((r - rowBegin) * matProto.num_cols() + (c - colBegin));
@@ -72,25 +111,74 @@ void ProtoDataConverter<DenseMatrix<VT>>::convertFromProto(const distributed::Ma
 }
 
 template<>
-google::protobuf::RepeatedField<int64_t> *ProtoDataConverter<DenseMatrix<int64_t>>::getMutableCells(distributed::Matrix *matProto)
+const google::protobuf::RepeatedField<int64_t> & ProtoDataConverter<DenseMatrix<int64_t>>::getCells(const distributed::Matrix *matProto)
 {
-    return matProto->mutable_dense_matrix()->mutable_cells_i64()->mutable_cells();
+    return matProto->dense_matrix().cells_i64().cells();
 }
 template<>
-google::protobuf::RepeatedField<double> *ProtoDataConverter<DenseMatrix<double>>::getMutableCells(distributed::Matrix *matProto)
+const google::protobuf::RepeatedField<double> & ProtoDataConverter<DenseMatrix<double>>::getCells(const distributed::Matrix *matProto)
 {
-    return matProto->mutable_dense_matrix()->mutable_cells_f64()->mutable_cells();
+    return matProto->dense_matrix().cells_f64().cells();
+}
+template<>
+const google::protobuf::RepeatedField<float> & ProtoDataConverter<DenseMatrix<float>>::getCells(const distributed::Matrix *matProto)
+{
+    return matProto->dense_matrix().cells_f32().cells();
+}
+template<>
+const google::protobuf::RepeatedField<int32_t> & ProtoDataConverter<DenseMatrix<int32_t>>::getCells(const distributed::Matrix *matProto)
+{
+    return matProto->dense_matrix().cells_i32().cells();
 }
 
 template<>
-const google::protobuf::RepeatedField<int64_t> ProtoDataConverter<DenseMatrix<int64_t>>::getCells(const distributed::Matrix *matProto)
+const std::string *ProtoDataConverter<DenseMatrix<int64_t>>::getRawCells(const distributed::Matrix *matProto)
 {
-    return matProto->dense_matrix().cells_i64().cells();
+    if (matProto->dense_matrix().cells_case() != distributed::DenseMatrix::CellsCase::kRawI64)
+        return nullptr;
+    return &matProto->dense_matrix().raw_i64();
 }
 template<>
-const google::protobuf::RepeatedField<double> ProtoDataConverter<DenseMatrix<double>>::getCells(const distributed::Matrix *matProto)
+const std::string *ProtoDataConverter<DenseMatrix<double>>::getRawCells(const distributed::Matrix *matProto)
 {
-    return matProto->dense_matrix().cells_f64().cells();
+    if (matProto->dense_matrix().cells_case() != distributed::DenseMatrix::CellsCase::kRawF64)
+        return nullptr;
+    return &matProto->dense_matrix().raw_f64();
+}
+template<>
+const std::string *ProtoDataConverter<DenseMatrix<float>>::getRawCells(const distributed::Matrix *matProto)
+{
+    if (matProto->dense_matrix().cells_case() != distributed::DenseMatrix::CellsCase::kRawF32)
+        return nullptr;
+    return &matProto->dense_matrix().raw_f32();
+}
+template<>
+const std::string *ProtoDataConverter<DenseMatrix<int32_t>>::getRawCells(const distributed::Matrix *matProto)
+{
+    if (matProto->dense_matrix().cells_case() != distributed::DenseMatrix::CellsCase::kRawI32)
+        return nullptr;
+    return &matProto->dense_matrix().raw_i32();
+}
+
+template<>
+std::string *ProtoDataConverter<DenseMatrix<int64_t>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_dense_matrix()->mutable_raw_i64();
+}
+template<>
+std::string *ProtoDataConverter<DenseMatrix<double>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_dense_matrix()->mutable_raw_f64();
+}
+template<>
+std::string *ProtoDataConverter<DenseMatrix<float>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_dense_matrix()->mutable_raw_f32();
+}
+template<>
+std::string *ProtoDataConverter<DenseMatrix<int32_t>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_dense_matrix()->mutable_raw_i32();
 }
 
 // ----------------------------------------------------------------------------
@@ -114,32 +202,15 @@ void ProtoDataConverter<CSRMatrix<VT>>::convertToProto(const CSRMatrix<VT> *mat,
     matProto->set_num_rows(rowEnd - rowBegin);
     matProto->set_num_cols(colEnd - colBegin);
 
-    auto *values = getMutableCells(matProto);    
-    auto *colIdxsProto = csrMatProto->mutable_colidx()->mutable_cells();
-    auto *rowOffsetsProto = csrMatProto->mutable_row_offsets()->mutable_cells();
-        
-    // Allocate memory only for the values within the given range.
-    size_t numNonZeros = 0;
-    for (size_t r = rowBegin; r < rowEnd; r++)
-        numNonZeros += mat->getNumNonZeros(r);
-    values->Reserve(numNonZeros);
-    colIdxsProto->Reserve(numNonZeros);
-
-    rowOffsetsProto->Reserve(rowEnd - rowBegin + 1);
-    
-    rowOffsetsProto->Add(0);
-    auto lastOffset = 0;
-    for (auto r = rowBegin; r < rowEnd; r++) {
-        const size_t rowNumNonZeros = mat->getNumNonZeros(r);
-        const size_t * rowColIdxs = mat->getColIdxs(r);
-        const VT *rowValues = mat->getValues(r);
-        rowOffsetsProto->Add(lastOffset + rowNumNonZeros);
-        lastOffset += rowNumNonZeros;
-        for(size_t i = 0; i < rowNumNonZeros; i++) {
-            values->Add(rowValues[i]);
-            colIdxsProto->Add(rowColIdxs[i]);
-        }
-    }
+    // The receiver rebases the row offsets to its own first row.
+    const size_t *rowOffsets = mat->getRowOffsets();
+    const size_t numNonZeros = rowOffsets[rowEnd] - rowOffsets[rowBegin];
+    csrMatProto->set_raw_row_offsets(reinterpret_cast<const char *>(rowOffsets + rowBegin),
+                                     (rowEnd - rowBegin + 1) * sizeof(size_t));
+    csrMatProto->set_raw_col_idxs(reinterpret_cast<const char *>(mat->getColIdxs(rowBegin)),
+                                  numNonZeros * sizeof(size_t));
+    getMutableRawCells(matProto)->assign(reinterpret_cast<const char *>(mat->getValues(rowBegin)),
+                                         numNonZeros * sizeof(VT));
 }
 template<typename VT>
 void ProtoDataConverter<CSRMatrix<VT>>::convertFromProto(const distributed::Matrix &matProto,
@@ -149,17 +220,44 @@ void ProtoDataConverter<CSRMatrix<VT>>::convertFromProto(const distributed::Matr
                                           size_t colBegin,
                                           size_t colEnd)
 {    
-    auto csrMatProto = matProto.csr_matrix();
- 
-    auto valuesProto = getCells(&matProto);    
-    auto colIdxsProto = csrMatProto.colidx().cells();
-    auto rowOffsetsProto = csrMatProto.row_offsets().cells();
+    if (isCompressed(matProto)) {
+        distributed::Matrix decompressed;
+        convertFromProto(decompressMatrix(matProto, decompressed), mat, rowBegin, rowEnd, colBegin, colEnd);
+        return;
+    }
+    const auto &csrMatProto = matProto.csr_matrix();
 
     assert (rowBegin < rowEnd && "ProtoDataConverter: rowBegin must be lower than rowEnd");
     if (rowBegin == 0)
         mat->getRowOffsets()[0] = 0;
     // Else rowOffset[rowBegin] is already set.
 
+    if (auto *rawValues = getRawCells(&matProto)) {
+        const std::string &rawRowOffsets = csrMatProto.raw_row_offsets();
+        const std::string &rawColIdxs = csrMatProto.raw_col_idxs();
+        if (rawRowOffsets.size() != (rowEnd - rowBegin + 1) * sizeof(size_t))
+            throw std::runtime_error("ProtoDataConverter: the raw row offsets do not match the shape of the matrix");
+
+        // Copy the row offsets and rebase them from the sender's to the receiver's first row.
+        size_t *rowOffsets = mat->getRowOffsets();
+        const size_t base = rowOffsets[rowBegin];
+        std::memcpy(rowOffsets + rowBegin, rawRowOffsets.data(), rawRowOffsets.size());
+        const size_t protoBase = rowOffsets[rowBegin];
+        for (size_t r = rowBegin; r <= rowEnd; r++)
+            rowOffsets[r] = rowOffsets[r] - protoBase + base;
+
+        const size_t numNonZeros = rowOffsets[rowEnd] - base;
+        if (rawValues->size() != numNonZeros * sizeof(VT) || rawColIdxs.size() != numNonZeros * sizeof(size_t))
+            throw std::runtime_error("ProtoDataConverter: the raw values or column indexes do not match the row offsets");
+        std::memcpy(mat->getValues(rowBegin), rawValues->data(), rawValues->size());
+        std::memcpy(mat->getColIdxs(rowBegin), rawColIdxs.data(), rawColIdxs.size());
+        return;
+    }
+
+    const auto &valuesProto = getCells(&matProto);
+    const auto &colIdxsProto = csrMatProto.colidx().cells();
+    const auto &rowOffsetsProto = csrMatProto.row_offsets().cells();
+
     size_t protoValColIdx = 0;
     size_t protoRow = 0;
     for (size_t r = rowBegin; r < rowEnd; r++) {
@@ -183,30 +281,376 @@ void ProtoDataConverter<CSRMatrix<VT>>::convertFromProto(const distributed::Matr
 }
 
 template<>
-google::protobuf::RepeatedField<int64_t> *ProtoDataConverter<CSRMatrix<int64_t>>::getMutableCells(distributed::Matrix *matProto)
+const google::protobuf::RepeatedField<int64_t> & ProtoDataConverter<CSRMatrix<int64_t>>::getCells(const distributed::Matrix *matProto)
 {
-    return matProto->mutable_csr_matrix()->mutable_values_i64()->mutable_cells();
+    return matProto->csr_matrix().values_i64().cells();
 }
 template<>
-google::protobuf::RepeatedField<double> *ProtoDataConverter<CSRMatrix<double>>::getMutableCells(distributed::Matrix *matProto)
+const google::protobuf::RepeatedField<double> & ProtoDataConverter<CSRMatrix<double>>::getCells(const distributed::Matrix *matProto)
 {
-    return matProto->mutable_csr_matrix()->mutable_values_f64()->mutable_cells();
+    return matProto->csr_matrix().values_f64().cells();
+}
+template<>
+const google::protobuf::RepeatedField<float> & ProtoDataConverter<CSRMatrix<float>>::getCells(const distributed::Matrix *matProto)
+{
+    return matProto->csr_matrix().values_f32().cells();
+}
+template<>
+const google::protobuf::RepeatedField<int32_t> & ProtoDataConverter<CSRMatrix<int32_t>>::getCells(const distributed::Matrix *matProto)
+{
+    return matProto->csr_matrix().values_i32().cells();
 }
 
 template<>
-const google::protobuf::RepeatedField<int64_t> ProtoDataConverter<CSRMatrix<int64_t>>::getCells(const distributed::Matrix *matProto)
+const std::string *ProtoDataConverter<CSRMatrix<int64_t>>::getRawCells(const distributed::Matrix *matProto)
 {
-    return matProto->csr_matrix().values_i64().cells();
+    if (matProto->csr_matrix().values_case() != distributed::CSRMatrix::ValuesCase::kRawValuesI64)
+        return nullptr;
+    return &matProto->csr_matrix().raw_values_i64();
 }
 template<>
-const google::protobuf::RepeatedField<double> ProtoDataConverter<CSRMatrix<double>>::getCells(const distributed::Matrix *matProto)
+const std::string *ProtoDataConverter<CSRMatrix<double>>::getRawCells(const distributed::Matrix *matProto)
 {
-    return matProto->csr_matrix().values_f64().cells();
+    if (matProto->csr_matrix().values_case() != distributed::CSRMatrix::ValuesCase::kRawValuesF64)
+        return nullptr;
+    return &matProto->csr_matrix().raw_values_f64();
+}
+template<>
+const std::string *ProtoDataConverter<CSRMatrix<float>>::getRawCells(const distributed::Matrix *matProto)
+{
+    if (matProto->csr_matrix().values_case() != distributed::CSRMatrix::ValuesCase::kRawValuesF32)
+        return nullptr;
+    return &matProto->csr_matrix().raw_values_f32();
+}
+template<>
+const std::string *ProtoDataConverter<CSRMatrix<int32_t>>::getRawCells(const distributed::Matrix *matProto)
+{
+    if (matProto->csr_matrix().values_case() != distributed::CSRMatrix::ValuesCase::kRawValuesI32)
+        return nullptr;
+    return &matProto->csr_matrix().raw_values_i32();
+}
+
+template<>
+std::string *ProtoDataConverter<CSRMatrix<int64_t>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_csr_matrix()->mutable_raw_values_i64();
+}
+template<>
+std::string *ProtoDataConverter<CSRMatrix<double>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_csr_matrix()->mutable_raw_values_f64();
+}
+template<>
+std::string *ProtoDataConverter<CSRMatrix<float>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_csr_matrix()->mutable_raw_values_f32();
+}
+template<>
+std::string *ProtoDataConverter<CSRMatrix<int32_t>>::getMutableRawCells(distributed::Matrix *matProto)
+{
+    return matProto->mutable_csr_matrix()->mutable_raw_values_i32();
+}
+
+
+// ----------------------------------------------------------------------------
+// Any matrix
+// ----------------------------------------------------------------------------
+
+namespace {
+    // Calls `f` with the matrix cast to its type, if it is a dense or CSR matrix of a value type of the proto
+    // messages, and returns whether it is one.
+    template<class F>
+    bool visitMatrix(const Structure *mat, F f)
+    {
+        if (auto m = dynamic_cast<const DenseMatrix<double> *>(mat)) f(m);
+        else if (auto m = dynamic_cast<const DenseMatrix<float> *>(mat)) f(m);
+        else if (auto m = dynamic_cast<const DenseMatrix<int64_t> *>(mat)) f(m);
+        else if (auto m = dynamic_cast<const DenseMatrix<int32_t> *>(mat)) f(m);
+        else if (auto m = dynamic_cast<const CSRMatrix<double> *>(mat)) f(m);
+        else if (auto m = dynamic_cast<const CSRMatrix<float> *>(mat)) f(m);
+        else if (auto m = dynamic_cast<const CSRMatrix<int64_t> *>(mat)) f(m);
+        else if (auto m = dynamic_cast<const CSRMatrix<int32_t> *>(mat)) f(m);
+        else
+            return false;
+        return true;
+    }
+
+    template<typename VT>
+    size_t getNumValues(const std::string &raw, int numCells)
+    {
+        return raw.empty() ? static_cast<size_t>(numCells) : raw.size() / sizeof(VT);
+    }
+}
+
+void convertMatrixToProto(const Structure *mat, distributed::Matrix *matProto, size_t rowBegin, size_t rowEnd,
+                          size_t colBegin, size_t colEnd)
+{
+    const bool supported = visitMatrix(mat, [&](auto m) {
+        using DT = std::remove_const_t<std::remove_pointer_t<decltype(m)>>;
+        ProtoDataConverter<DT>::convertToProto(m, matProto, rowBegin, rowEnd, colBegin, colEnd);
+    });
+    if (!supported)
+        throw std::runtime_error("ProtoDataConverter: only dense and CSR matrices of double, float, int64_t, and "
+                                 "int32_t can be sent");
+}
+
+void convertMatrixToProto(const Structure *mat, distributed::Matrix *matProto)
+{
+    convertMatrixToProto(mat, matProto, 0, mat->getNumRows(), 0, mat->getNumCols());
+}
+
+void convertMatrixFromProto(const distributed::Matrix &matProto, Structure *mat, size_t rowBegin, size_t rowEnd,
+                            size_t colBegin, size_t colEnd)
+{
+    const bool supported = visitMatrix(mat, [&](auto m) {
+        using DT = std::remove_const_t<std::remove_pointer_t<decltype(m)>>;
+        ProtoDataConverter<DT>::convertFromProto(matProto, const_cast<DT *>(m), rowBegin, rowEnd, colBegin, colEnd);
+    });
+    if (!supported)
+        throw std::runtime_error("ProtoDataConverter: only dense and CSR matrices of double, float, int64_t, and "
+                                 "int32_t can be received");
+}
+
+void convertMatrixFromProto(const distributed::Matrix &matProto, Structure *mat)
+{
+    convertMatrixFromProto(matProto, mat, 0, mat->getNumRows(), 0, mat->getNumCols());
+}
+
+size_t getNumBytes(const Structure *mat, size_t rowBegin, size_t rowEnd, size_t &numNonZeros)
+{
+    size_t numBytes = 0;
+    numNonZeros = 0;
+    const bool supported = visitMatrix(mat, [&](auto m) {
+        using DT = std::remove_const_t<std::remove_pointer_t<decltype(m)>>;
+        using VT = typename DT::VT;
+        if constexpr (std::is_same_v<DT, CSRMatrix<VT>>) {
+            numNonZeros = m->getRowOffsets()[rowEnd] - m->getRowOffsets()[rowBegin];
+            numBytes = numNonZeros * (sizeof(VT) + sizeof(size_t)) + (rowEnd - rowBegin + 1) * sizeof(size_t);
+        }
+        else
+            numBytes = (rowEnd - rowBegin) * m->getNumCols() * sizeof(VT);
+    });
+    if (!supported)
+        throw std::runtime_error("ProtoDataConverter: only dense and CSR matrices of double, float, int64_t, and "
+                                 "int32_t can be sent");
+    return numBytes;
+}
+
+size_t getNumNonZeros(const distributed::Matrix &matProto)
+{
+    const auto &csrMat = matProto.csr_matrix();
+    switch (csrMat.values_case()) {
+        case distributed::CSRMatrix::ValuesCase::kValuesF64:
+        case distributed::CSRMatrix::ValuesCase::kRawValuesF64:
+            return getNumValues<double>(csrMat.raw_values_f64(), csrMat.values_f64().cells_size());
+        case distributed::CSRMatrix::ValuesCase::kValuesF32:
+        case distributed::CSRMatrix::ValuesCase::kRawValuesF32:
+            return getNumValues<float>(csrMat.raw_values_f32(), csrMat.values_f32().cells_size());
+        case distributed::CSRMatrix::ValuesCase::kValuesI64:
+        case distributed::CSRMatrix::ValuesCase::kRawValuesI64:
+            return getNumValues<int64_t>(csrMat.raw_values_i64(), csrMat.values_i64().cells_size());
+        case distributed::CSRMatrix::ValuesCase::kValuesI32:
+        case distributed::CSRMatrix::ValuesCase::kRawValuesI32:
+            return getNumValues<int32_t>(csrMat.raw_values_i32(), csrMat.values_i32().cells_size());
+        default:
+            return 0;
+    }
+}
+
+Structure *createMatrixForProto(const distributed::Matrix &matProto, size_t numRows, size_t numCols,
+                                size_t numNonZeros)
+{
+    switch (matProto.matrix_case()) {
+        case distributed::Matrix::MatrixCase::kDenseMatrix:
+            switch (matProto.dense_matrix().cells_case()) {
+                case distributed::DenseMatrix::CellsCase::kCellsF64:
+                case distributed::DenseMatrix::CellsCase::kRawF64:
+                    return DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+                case distributed::DenseMatrix::CellsCase::kCellsF32:
+                case distributed::DenseMatrix::CellsCase::kRawF32:
+                    return DataObjectFactory::create<DenseMatrix<float>>(numRows, numCols, false);
+                case distributed::DenseMatrix::CellsCase::kCellsI64:
+                case distributed::DenseMatrix::CellsCase::kRawI64:
+                    return DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, numCols, false);
+                case distributed::DenseMatrix::CellsCase::kCellsI32:
+                case distributed::DenseMatrix::CellsCase::kRawI32:
+                    return DataObjectFactory::create<DenseMatrix<int32_t>>(numRows, numCols, false);
+                default:
+                    throw std::runtime_error("ProtoDataConverter: Proto message 'Matrix': cells not set");
+            }
+        case distributed::Matrix::MatrixCase::kCsrMatrix:
+            switch (matProto.csr_matrix().values_case()) {
+                case distributed::CSRMatrix::ValuesCase::kValuesF64:
+                case distributed::CSRMatrix::ValuesCase::kRawValuesF64:
+                    return DataObjectFactory::create<CSRMatrix<double>>(numRows, numCols, numNonZeros, true);
+                case distributed::CSRMatrix::ValuesCase::kValuesF32:
+                case distributed::CSRMatrix::ValuesCase::kRawValuesF32:
+                    return DataObjectFactory::create<CSRMatrix<float>>(numRows, numCols, numNonZeros, true);
+                case distributed::CSRMatrix::ValuesCase::kValuesI64:
+                case distributed::CSRMatrix::ValuesCase::kRawValuesI64:
+                    return DataObjectFactory::create<CSRMatrix<int64_t>>(numRows, numCols, numNonZeros, true);
+                case distributed::CSRMatrix::ValuesCase::kValuesI32:
+                case distributed::CSRMatrix::ValuesCase::kRawValuesI32:
+                    return DataObjectFactory::create<CSRMatrix<int32_t>>(numRows, numCols, numNonZeros, true);
+                default:
+                    throw std::runtime_error("ProtoDataConverter: Proto message 'Matrix': cell values not set");
+            }
+        default:
+            throw std::runtime_error("ProtoDataConverter: Proto message 'Matrix': matrix not set");
+    }
 }
 
+Structure *createMatrixFromProto(const distributed::Matrix &matProto)
+{
+    if (isCompressed(matProto)) {
+        distributed::Matrix decompressed;
+        return createMatrixFromProto(decompressMatrix(matProto, decompressed));
+    }
+    Structure *mat = createMatrixForProto(matProto, matProto.num_rows(), matProto.num_cols(), getNumNonZeros(matProto));
+    convertMatrixFromProto(matProto, mat);
+    return mat;
+}
+
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
 
+namespace {
+    // Copies the cells of the given rows of a column into the proto message, where `row(i)` is the i-th row, at once
+    // if the rows are contiguous.
+    template<class RowFn>
+    void convertColumnToProto(const Frame *frame, size_t idx, size_t numRows, RowFn row, bool contiguous,
+                              distributed::FrameColumn *colProto) {
+        const ValueTypeCode vtc = frame->getColumnType(idx);
+        colProto->set_label(frame->getLabels()[idx]);
+        colProto->set_value_type(static_cast<uint32_t>(vtc));
+        if (vtc == ValueTypeCode::STR) {
+            auto strings = static_cast<const std::string *>(frame->getColumnRaw(idx));
+            colProto->mutable_strings()->Reserve(numRows);
+            for (size_t i = 0; i < numRows; i++)
+                colProto->add_strings(strings[row(i)]);
+            return;
+        }
+        const size_t elemSize = ValueTypeUtils::sizeOf(vtc);
+        auto values = static_cast<const char *>(frame->getColumnRaw(idx));
+        std::string *raw = colProto->mutable_raw();
+        if (contiguous) {
+            raw->assign(values + row(0) * elemSize, numRows * elemSize);
+            return;
+        }
+        raw->resize(numRows * elemSize);
+        for (size_t i = 0; i < numRows; i++)
+            std::memcpy(&(*raw)[i * elemSize], values + row(i) * elemSize, elemSize);
+    }
+}
+
+void convertFrameToProto(const Frame *frame, distributed::Frame *frameProto, size_t rowBegin, size_t rowEnd,
+                         const std::string &rowIdLabel)
+{
+    const size_t numRows = rowEnd - rowBegin;
+    frameProto->set_num_rows(numRows);
+    for (size_t c = 0; c < frame->getNumCols(); c++)
+        convertColumnToProto(frame, c, numRows, [rowBegin](size_t i) { return rowBegin + i; }, true,
+                             frameProto->add_columns());
+    if (rowIdLabel.empty())
+        return;
+    auto colProto = frameProto->add_columns();
+    colProto->set_label(rowIdLabel);
+    colProto->set_value_type(static_cast<uint32_t>(ValueTypeCode::UI64));
+    std::string *raw = colProto->mutable_raw();
+    raw->resize(numRows * sizeof(uint64_t));
+    for (size_t i = 0; i < numRows; i++) {
+        const uint64_t rowId = rowBegin + i;
+        std::memcpy(&(*raw)[i * sizeof(uint64_t)], &rowId, sizeof(uint64_t));
+    }
+}
+
+void convertFrameToProto(const Frame *frame, distributed::Frame *frameProto)
+{
+    convertFrameToProto(frame, frameProto, 0, frame->getNumRows());
+}
+
+void convertFrameToProto(const Frame *frame, distributed::Frame *frameProto, const std::vector<size_t> &rows)
+{
+    frameProto->set_num_rows(rows.size());
+    for (size_t c = 0; c < frame->getNumCols(); c++)
+        convertColumnToProto(frame, c, rows.size(), [&rows](size_t i) { return rows[i]; }, false,
+                             frameProto->add_columns());
+}
+
+Frame *createFrameFromProto(const std::vector<const distributed::Frame *> &frameProtos)
+{
+    if (frameProtos.empty())
+        throw std::runtime_error("ProtoDataConverter: no proto message 'Frame' to create the frame of");
+    const distributed::Frame &first = *frameProtos.front();
+    const size_t numCols = first.columns_size();
+    std::vector<ValueTypeCode> schema(numCols);
+    std::vector<std::string> labels(numCols);
+    for (size_t c = 0; c < numCols; c++) {
+        schema[c] = static_cast<ValueTypeCode>(first.columns(c).value_type());
+        labels[c] = first.columns(c).label();
+    }
+    size_t numRows = 0;
+    for (auto frameProto : frameProtos) {
+        if (static_cast<size_t>(frameProto->columns_size()) != numCols)
+            throw std::runtime_error("ProtoDataConverter: Proto messages 'Frame' of different numbers of columns");
+        for (size_t c = 0; c < numCols; c++) {
+            const auto &colProto = frameProto->columns(c);
+            if (static_cast<ValueTypeCode>(colProto.value_type()) != schema[c] || colProto.label() != labels[c])
+                throw std::runtime_error("ProtoDataConverter: Proto messages 'Frame' of different schemas");
+            const size_t numCells = schema[c] == ValueTypeCode::STR
+                    ? colProto.strings_size() : colProto.raw().size() / ValueTypeUtils::sizeOf(schema[c]);
+            if (numCells != frameProto->num_rows())
+                throw std::runtime_error("ProtoDataConverter: Proto message 'Frame': column " + labels[c]
+                                         + " does not have " + std::to_string(frameProto->num_rows()) + " rows");
+        }
+        numRows += frameProto->num_rows();
+    }
+
+    auto frame = DataObjectFactory::create<Frame>(numRows, numCols, schema.data(), labels.data(), false);
+    for (size_t c = 0; c < numCols; c++) {
+        size_t r = 0;
+        for (auto frameProto : frameProtos) {
+            const auto &colProto = frameProto->columns(c);
+            if (schema[c] == ValueTypeCode::STR)
+                std::copy(colProto.strings().begin(), colProto.strings().end(),
+                          static_cast<std::string *>(frame->getColumnRaw(c)) + r);
+            else
+                std::memcpy(static_cast<char *>(frame->getColumnRaw(c)) + r * ValueTypeUtils::sizeOf(schema[c]),
+                            colProto.raw().data(), colProto.raw().size());
+            r += frameProto->num_rows();
+        }
+    }
+    return frame;
+}
+
+Frame *createFrameFromProto(const distributed::Frame &frameProto)
+{
+    return createFrameFromProto(std::vector<const distributed::Frame *>{&frameProto});
+}
+
+size_t getNumBytes(const Frame *frame)
+{
+    const size_t numRows = frame->getNumRows();
+    size_t numBytes = 0;
+    for (size_t c = 0; c < frame->getNumCols(); c++) {
+        const ValueTypeCode vtc = frame->getColumnType(c);
+        if (vtc != ValueTypeCode::STR) {
+            numBytes += numRows * ValueTypeUtils::sizeOf(vtc);
+            continue;
+        }
+        auto strings = static_cast<const std::string *>(frame->getColumnRaw(c));
+        for (size_t r = 0; r < numRows; r++)
+            numBytes += strings[r].size() + 2;
+    }
+    return numBytes;
+}
 
 template class ProtoDataConverter<DenseMatrix<double>>;
+template class ProtoDataConverter<DenseMatrix<float>>;
 template class ProtoDataConverter<DenseMatrix<int64_t>>;
+template class ProtoDataConverter<DenseMatrix<int32_t>>;
 template class ProtoDataConverter<CSRMatrix<double>>;
+template class ProtoDataConverter<CSRMatrix<float>>;
 template class ProtoDataConverter<CSRMatrix<int64_t>>;
+template class ProtoDataConverter<CSRMatrix<int32_t>>;
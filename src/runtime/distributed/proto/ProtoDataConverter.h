@@ -19,9 +19,30 @@
 
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+/**
+ * @brief The number of rows of the chunks of a streamed transfer (see
+ * `MatrixChunk` in worker.proto), such that a chunk has about the given number
+ * of bytes, or all rows in one chunk if `chunkBytes` is 0.
+ *
+ * @param numBytes The size of all rows in bytes.
+ */
+inline size_t getRowsPerChunk(size_t numRows, size_t numBytes, size_t chunkBytes) {
+    if (chunkBytes == 0 || numRows == 0)
+        return std::max<size_t>(numRows, 1);
+    const size_t bytesPerRow = std::max<size_t>(numBytes / numRows, 1);
+    return std::max<size_t>(chunkBytes / bytesPerRow, 1);
+}
+
 template<class DT>
 class ProtoDataConverter
 { };
@@ -31,9 +52,16 @@ template<typename VT>
 class ProtoDataConverter<DenseMatrix<VT>>
 {
 private:
-    static const google::protobuf::RepeatedField<VT> getCells(const distributed::Matrix *matProto);
-    static google::protobuf::RepeatedField<VT> *getMutableCells(distributed::Matrix *matProto);
+    static const google::protobuf::RepeatedField<VT> & getCells(const distributed::Matrix *matProto);
+    // the raw bytes of the cells, or nullptr if the cells are sent one by one
+    static const std::string *getRawCells(const distributed::Matrix *matProto);
+    static std::string *getMutableRawCells(distributed::Matrix *matProto);
 public:
+    /**
+     * @brief Copies the cells of the (sub-)matrix into the proto message as
+     * raw bytes, i.e., row by row (or at once if the rows are contiguous)
+     * instead of encoding each cell.
+     */
     static void convertToProto(const DenseMatrix<VT> *mat, distributed::Matrix *matProto);
     static void convertToProto(const DenseMatrix<VT> *mat,
                                distributed::Matrix *matProto,
@@ -41,6 +69,11 @@ public:
                                size_t rowEnd,
                                size_t colBegin,
                                size_t colEnd);
+    /**
+     * @brief Copies the cells of the proto message into the (sub-)matrix,
+     * decompressing them first if they were compressed (see
+     * `compressMatrix`).
+     */
     static void convertFromProto(const distributed::Matrix &matProto, DenseMatrix<VT> *mat);
     static void convertFromProto(const distributed::Matrix &matProto,
                                  DenseMatrix<VT> *mat,
@@ -61,10 +94,14 @@ template<typename VT>
 class ProtoDataConverter<CSRMatrix<VT>>
 {
 private:
-    static const google::protobuf::RepeatedField<VT> getCells(const distributed::Matrix *matProto);
-    static google::protobuf::RepeatedField<VT> *getMutableCells(distributed::Matrix *matProto);
+    static const google::protobuf::RepeatedField<VT> & getCells(const distributed::Matrix *matProto);
+    // the raw bytes of the values, or nullptr if the values are sent one by one
+    static const std::string *getRawCells(const distributed::Matrix *matProto);
+    static std::string *getMutableRawCells(distributed::Matrix *matProto);
 public:
     // Overloaded functions for Sparse Matrices
+    // The values, column indexes, and row offsets of the given rows are
+    // contiguous, so each of them is copied into the proto message at once.
     static void convertToProto(const CSRMatrix<VT> *mat, distributed::Matrix *matProto);
     static void convertToProto(const CSRMatrix<VT> *mat,
                                distributed::Matrix *matProto,
@@ -86,4 +123,76 @@ template<typename VT>
 class ProtoDataConverter<const CSRMatrix<VT>> : public ProtoDataConverter<CSRMatrix<VT>>
 { /* TODO */ };
 
+// ----------------------------------------------------------------------------
+// Any matrix
+// ----------------------------------------------------------------------------
+// The dense and CSR matrices of the value types of the proto messages (double, float, int64_t, and int32_t), whose
+// type is only known at run-time, e.g., at the workers. The given rows of CSR matrices stay sparse, i.e., a
+// partition is sent as the slices of its values, column indexes, and row offsets.
+
+void convertMatrixToProto(const Structure *mat, distributed::Matrix *matProto);
+void convertMatrixToProto(const Structure *mat, distributed::Matrix *matProto, size_t rowBegin, size_t rowEnd,
+                          size_t colBegin, size_t colEnd);
+void convertMatrixFromProto(const distributed::Matrix &matProto, Structure *mat);
+void convertMatrixFromProto(const distributed::Matrix &matProto, Structure *mat, size_t rowBegin, size_t rowEnd,
+                            size_t colBegin, size_t colEnd);
+
+/**
+ * @brief The bytes of the given rows of the matrix in a proto message, e.g., to split them into chunks, and their
+ * number of non-zeros if it is a CSR matrix (or else 0).
+ */
+size_t getNumBytes(const Structure *mat, size_t rowBegin, size_t rowEnd, size_t &numNonZeros);
+
+/**
+ * @brief The number of non-zeros of the (uncompressed) CSR matrix of the proto message, or 0 for dense matrices.
+ */
+size_t getNumNonZeros(const distributed::Matrix &matProto);
+
+/**
+ * @brief Creates a matrix of the representation and value type of the (uncompressed) proto message with the given
+ * shape, e.g., of a matrix sent in chunks.
+ */
+Structure *createMatrixForProto(const distributed::Matrix &matProto, size_t numRows, size_t numCols,
+                                size_t numNonZeros);
+
+/**
+ * @brief Creates the matrix of the proto message, decompressing it first if it was compressed.
+ */
+Structure *createMatrixFromProto(const distributed::Matrix &matProto);
+
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
+// The columns of numeric value types are copied as raw bytes, the ones of strings string by string.
+
+/**
+ * @brief Copies the rows [rowBegin, rowEnd) of the frame into the proto message, and appends a column of uint64_t
+ * with the indexes of these rows in the frame, if `rowIdLabel` is not empty, e.g., to restore the order of the rows
+ * after a shuffle.
+ */
+void convertFrameToProto(const Frame *frame, distributed::Frame *frameProto, size_t rowBegin, size_t rowEnd,
+                         const std::string &rowIdLabel = "");
+void convertFrameToProto(const Frame *frame, distributed::Frame *frameProto);
+
+/**
+ * @brief Copies the given rows of the frame in the given order into the proto message, e.g., a hash partition.
+ */
+void convertFrameToProto(const Frame *frame, distributed::Frame *frameProto, const std::vector<size_t> &rows);
+
+/**
+ * @brief Creates the frame of the proto message.
+ */
+Frame *createFrameFromProto(const distributed::Frame &frameProto);
+
+/**
+ * @brief Creates the frame of the rows of the given proto messages one after the other, which must have the same
+ * schema and labels, e.g., the partitions of a frame collected from the workers.
+ */
+Frame *createFrameFromProto(const std::vector<const distributed::Frame *> &frameProtos);
+
+/**
+ * @brief The approximate bytes of the frame in a proto message.
+ */
+size_t getNumBytes(const Frame *frame);
+
 #endif //SRC_RUNTIME_DISTRIBUTED_UTILS_PROTODATACONVERTER_H
\ No newline at end of file
@@ -0,0 +1,200 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_PROTO_TRACING_H
+#define SRC_RUNTIME_DISTRIBUTED_PROTO_TRACING_H
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @brief The context of a span of a trace, which the calls to the distributed workers carry in the `traceparent`
+ * entry of their gRPC metadata, in the format of the W3C Trace Context ("00-<trace id>-<span id>-01").
+ */
+struct TraceContext {
+    static constexpr const char *HEADER = "traceparent";
+
+    // 32 and 16 lower-case hex digits, or empty if there is no trace
+    std::string traceId;
+    std::string spanId;
+
+    bool isValid() const { return !traceId.empty() && !spanId.empty(); }
+
+    std::string toHeader() const { return "00-" + traceId + "-" + spanId + "-01"; }
+
+    /**
+     * @brief The context of the given header, which is invalid if the header is malformed.
+     */
+    static TraceContext fromHeader(const std::string &header) {
+        auto isHex = [&header](size_t begin, size_t length) {
+            for (size_t i = begin; i < begin + length; i++)
+                if (!std::isxdigit(static_cast<unsigned char>(header[i])))
+                    return false;
+            return true;
+        };
+        if (header.size() < 55 || header[2] != '-' || header[35] != '-' || header[52] != '-' || !isHex(0, 2) ||
+            !isHex(3, 32) || !isHex(36, 16))
+            return {};
+        return {header.substr(3, 32), header.substr(36, 16)};
+    }
+};
+
+/**
+ * @brief The traces of the distributed jobs, whose spans this process appends to a file as JSON lines, one object
+ * per span with the fields of OpenTelemetry (OTLP), such that a collector assembles the spans of the coordinator and
+ * of all workers into one trace per job.
+ *
+ * The coordinator starts the trace of its job (see `startTrace()`), whose span is the parent of the calls to the
+ * workers. A worker records a span per call it serves, which is the current span while the call is served, such
+ * that the calls it makes to its peers are children of it. Since each worker serves one call at a time, and the
+ * calls of the coordinator belong to its job, the current span is the one of the process, not of a thread.
+ */
+class Tracing {
+    std::mutex mutex;
+    std::ofstream out;
+    // the service recorded with the spans, e.g., the address of a worker
+    std::string service;
+    TraceContext current;
+    std::mt19937_64 random{std::random_device{}()};
+    // the span of the job this process started and its start time
+    TraceContext root;
+    uint64_t rootStartNanos = 0;
+
+    static std::string escape(const std::string &s) {
+        std::string res;
+        for (char c : s) {
+            if (c == '"' || c == '\\')
+                res += '\\';
+            if (static_cast<unsigned char>(c) < 0x20)
+                res += ' ';
+            else
+                res += c;
+        }
+        return res;
+    }
+
+public:
+    static Tracing &get() {
+        static Tracing tracing;
+        return tracing;
+    }
+
+    static uint64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Appends the spans of this process to the given file from now on, with the given name of the service.
+     *
+     * A file opened before, e.g., by an earlier distributed context of the same process, is closed.
+     */
+    void open(const std::string &file, const std::string &serviceName) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (out.is_open())
+            out.close();
+        out.clear();
+        out.open(file, std::ios::app);
+        if (!out)
+            throw std::runtime_error("cannot open the trace file " + file);
+        service = serviceName;
+    }
+
+    bool isEnabled() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return out.is_open();
+    }
+
+    /**
+     * @brief A new random ID of the given number of bytes as hex digits, e.g., 16 for a trace and 8 for a span.
+     */
+    std::string newId(size_t numBytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string id;
+        char hex[17];
+        while (id.size() < 2 * numBytes) {
+            std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(random()));
+            id += hex;
+        }
+        return id.substr(0, 2 * numBytes);
+    }
+
+    TraceContext getCurrent() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return current;
+    }
+
+    void setCurrent(const TraceContext &context) {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = context;
+    }
+
+    /**
+     * @brief Starts a new trace, whose root span is the current one until `endTrace()`.
+     */
+    void startTrace() {
+        TraceContext context{newId(16), newId(8)};
+        std::lock_guard<std::mutex> lock(mutex);
+        root = current = context;
+        rootStartNanos = nowNanos();
+    }
+
+    /**
+     * @brief Records the root span of the trace started with the given name, if any.
+     */
+    void endTrace(const std::string &name) {
+        TraceContext context;
+        uint64_t startNanos;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!root.isValid())
+                return;
+            context = root;
+            startNanos = rootStartNanos;
+            root = current = TraceContext();
+        }
+        record(name, context, "", startNanos, nowNanos(), "");
+    }
+
+    /**
+     * @brief Appends the span to the file, with the given error message, or none if empty.
+     */
+    void record(const std::string &name, const TraceContext &span, const std::string &parentSpanId,
+                uint64_t startNanos, uint64_t endNanos, const std::string &error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!out.is_open())
+            return;
+        out << "{\"traceId\":\"" << span.traceId << "\",\"spanId\":\"" << span.spanId
+            << "\",\"parentSpanId\":\"" << parentSpanId << "\",\"name\":\"" << escape(name)
+            << "\",\"service\":\"" << escape(service) << "\",\"startTimeUnixNano\":" << startNanos
+            << ",\"endTimeUnixNano\":" << endNanos << ",\"status\":{\"code\":" << (error.empty() ? 1 : 2);
+        if (!error.empty())
+            out << ",\"message\":\"" << escape(error) << "\"";
+        out << "}}\n";
+        out.flush();
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_PROTO_TRACING_H
@@ -0,0 +1,363 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "WireCompression.h"
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    // raw fields of fewer bytes are sent uncompressed
+    constexpr size_t MIN_COMPRESS_BYTES = 4096;
+    // the slices of the raw fields compressed to choose the codec adaptively
+    constexpr size_t SAMPLE_SLICES = 16;
+    constexpr size_t SAMPLE_SLICE_BYTES = 4096;
+    // the minimum compression ratio of the sample to compress the matrix at all
+    constexpr double MIN_RATIO = 1.2;
+    // the factor by which the sample compressed by ZSTD must be smaller than by LZ4 to spend ZSTD's time on it
+    constexpr double MIN_ZSTD_GAIN = 1.25;
+    constexpr int ZSTD_LEVEL = 3;
+
+    // The raw fields of the matrix, which are (de)compressed, or none if its values are sent one by one.
+    std::vector<std::string *> getRawFields(distributed::Matrix *matProto) {
+        std::vector<std::string *> fields;
+        switch (matProto->matrix_case()) {
+            case distributed::Matrix::MatrixCase::kDenseMatrix: {
+                auto dense = matProto->mutable_dense_matrix();
+                switch (dense->cells_case()) {
+                    case distributed::DenseMatrix::CellsCase::kRawF64: fields.push_back(dense->mutable_raw_f64()); break;
+                    case distributed::DenseMatrix::CellsCase::kRawF32: fields.push_back(dense->mutable_raw_f32()); break;
+                    case distributed::DenseMatrix::CellsCase::kRawI64: fields.push_back(dense->mutable_raw_i64()); break;
+                    case distributed::DenseMatrix::CellsCase::kRawI32: fields.push_back(dense->mutable_raw_i32()); break;
+                    default: break;
+                }
+                break;
+            }
+            case distributed::Matrix::MatrixCase::kCsrMatrix: {
+                auto csr = matProto->mutable_csr_matrix();
+                switch (csr->values_case()) {
+                    case distributed::CSRMatrix::ValuesCase::kRawValuesF64: fields.push_back(csr->mutable_raw_values_f64()); break;
+                    case distributed::CSRMatrix::ValuesCase::kRawValuesF32: fields.push_back(csr->mutable_raw_values_f32()); break;
+                    case distributed::CSRMatrix::ValuesCase::kRawValuesI64: fields.push_back(csr->mutable_raw_values_i64()); break;
+                    case distributed::CSRMatrix::ValuesCase::kRawValuesI32: fields.push_back(csr->mutable_raw_values_i32()); break;
+                    default: return fields;
+                }
+                fields.push_back(csr->mutable_raw_row_offsets());
+                fields.push_back(csr->mutable_raw_col_idxs());
+                break;
+            }
+            default:
+                break;
+        }
+        return fields;
+    }
+
+    size_t getSize(const std::vector<std::string *> &fields) {
+        size_t size = 0;
+        for (auto field : fields)
+            size += field->size();
+        return size;
+    }
+
+    // ------------------------------------------------------------------------
+    // Delta and varint encoding of the indexes of CSR matrices
+    // ------------------------------------------------------------------------
+
+    void putVarint(std::string &out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    uint64_t getVarint(const char *&p, const char *end) {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end)
+                throw std::runtime_error("WireCompression: truncated varint");
+            const auto b = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        throw std::runtime_error("WireCompression: invalid varint");
+    }
+
+    std::vector<uint64_t> getUint64s(const std::string &raw) {
+        std::vector<uint64_t> values(raw.size() / sizeof(uint64_t));
+        std::memcpy(values.data(), raw.data(), values.size() * sizeof(uint64_t));
+        return values;
+    }
+
+    void setUint64s(std::string *raw, const std::vector<uint64_t> &values) {
+        raw->assign(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(uint64_t));
+    }
+
+    // The numbers of non-zeros of the rows and the column indexes as differences to the previous ones in their rows,
+    // which are mostly small for the sorted column indexes.
+    void encodeCsrIndexes(distributed::CSRMatrix *csr, size_t numRows) {
+        const auto rowOffsets = getUint64s(csr->raw_row_offsets());
+        const auto colIdxs = getUint64s(csr->raw_col_idxs());
+        if (rowOffsets.size() != numRows + 1 || colIdxs.size() != rowOffsets[numRows] - rowOffsets[0])
+            throw std::runtime_error("WireCompression: the row offsets do not match the shape of the matrix");
+        std::string rowNonZeros;
+        std::string colDeltas;
+        size_t i = 0;
+        for (size_t r = 0; r < numRows; r++) {
+            putVarint(rowNonZeros, rowOffsets[r + 1] - rowOffsets[r]);
+            uint64_t prev = 0;
+            for (; i < rowOffsets[r + 1] - rowOffsets[0]; i++) {
+                const auto delta = static_cast<int64_t>(colIdxs[i] - prev);
+                putVarint(colDeltas, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+                prev = colIdxs[i];
+            }
+        }
+        csr->set_raw_row_offsets(std::move(rowNonZeros));
+        csr->set_raw_col_idxs(std::move(colDeltas));
+        csr->set_delta_varint_idxs(true);
+    }
+
+    void decodeCsrIndexes(distributed::CSRMatrix *csr, size_t numRows) {
+        std::vector<uint64_t> rowOffsets(numRows + 1, 0);
+        const char *p = csr->raw_row_offsets().data();
+        const char *end = p + csr->raw_row_offsets().size();
+        for (size_t r = 0; r < numRows; r++)
+            rowOffsets[r + 1] = rowOffsets[r] + getVarint(p, end);
+
+        std::vector<uint64_t> colIdxs(rowOffsets[numRows]);
+        p = csr->raw_col_idxs().data();
+        end = p + csr->raw_col_idxs().size();
+        size_t i = 0;
+        for (size_t r = 0; r < numRows; r++) {
+            uint64_t prev = 0;
+            for (; i < rowOffsets[r + 1]; i++) {
+                const uint64_t zigzag = getVarint(p, end);
+                prev += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+                colIdxs[i] = prev;
+            }
+        }
+        setUint64s(csr->mutable_raw_row_offsets(), rowOffsets);
+        setUint64s(csr->mutable_raw_col_idxs(), colIdxs);
+        csr->set_delta_varint_idxs(false);
+    }
+
+    // ------------------------------------------------------------------------
+    // Codecs
+    // ------------------------------------------------------------------------
+
+    // The field compressed by the codec, preceded by its uncompressed size.
+    std::string compressField(const std::string &raw, distributed::Codec codec) {
+        const uint64_t rawSize = raw.size();
+        std::string out(sizeof(uint64_t), '\0');
+        std::memcpy(&out[0], &rawSize, sizeof(uint64_t));
+        switch (codec) {
+#ifdef USE_LZ4
+            case distributed::CODEC_LZ4: {
+                const int bound = LZ4_compressBound(static_cast<int>(raw.size()));
+                out.resize(sizeof(uint64_t) + bound);
+                const int n = LZ4_compress_default(raw.data(), &out[sizeof(uint64_t)], static_cast<int>(raw.size()),
+                                                   bound);
+                if (n <= 0)
+                    throw std::runtime_error("WireCompression: LZ4 compression failed");
+                out.resize(sizeof(uint64_t) + n);
+                return out;
+            }
+#endif
+#ifdef USE_ZSTD
+            case distributed::CODEC_ZSTD: {
+                const size_t bound = ZSTD_compressBound(raw.size());
+                out.resize(sizeof(uint64_t) + bound);
+                const size_t n = ZSTD_compress(&out[sizeof(uint64_t)], bound, raw.data(), raw.size(), ZSTD_LEVEL);
+                if (ZSTD_isError(n))
+                    throw std::runtime_error(std::string("WireCompression: ") + ZSTD_getErrorName(n));
+                out.resize(sizeof(uint64_t) + n);
+                return out;
+            }
+#endif
+            default:
+                throw std::runtime_error("WireCompression: codec not supported by this build");
+        }
+    }
+
+    std::string decompressField(const std::string &field, distributed::Codec codec) {
+        uint64_t rawSize;
+        if (field.size() < sizeof(uint64_t))
+            throw std::runtime_error("WireCompression: truncated field");
+        std::memcpy(&rawSize, field.data(), sizeof(uint64_t));
+        const char *src = field.data() + sizeof(uint64_t);
+        const size_t srcSize = field.size() - sizeof(uint64_t);
+        std::string out(rawSize, '\0');
+        switch (codec) {
+#ifdef USE_LZ4
+            case distributed::CODEC_LZ4:
+                if (LZ4_decompress_safe(src, &out[0], static_cast<int>(srcSize), static_cast<int>(rawSize))
+                        != static_cast<int>(rawSize))
+                    throw std::runtime_error("WireCompression: LZ4 decompression failed");
+                return out;
+#endif
+#ifdef USE_ZSTD
+            case distributed::CODEC_ZSTD: {
+                const size_t n = ZSTD_decompress(&out[0], rawSize, src, srcSize);
+                if (ZSTD_isError(n) || n != rawSize)
+                    throw std::runtime_error("WireCompression: ZSTD decompression failed");
+                return out;
+            }
+#endif
+            default:
+                throw std::runtime_error("WireCompression: codec not supported by this build");
+        }
+    }
+
+    // The codec of the smallest compressed sample of the fields, or none if the sample hardly compresses.
+    distributed::Codec chooseCodec(const std::vector<std::string *> &fields) {
+        const size_t totalSize = getSize(fields);
+        std::string sample;
+        for (auto field : fields) {
+            // the slices of each field in proportion to its size, spread evenly over it
+            const size_t numSlices = std::max<size_t>(1, SAMPLE_SLICES * field->size() / totalSize);
+            const size_t stride = field->size() / numSlices;
+            for (size_t i = 0; i < numSlices; i++)
+                sample.append(*field, i * stride, std::min(SAMPLE_SLICE_BYTES, stride));
+        }
+        distributed::Codec codec = distributed::CODEC_NONE;
+        double maxSize = sample.size() / MIN_RATIO;
+#ifdef USE_LZ4
+        const size_t lz4Size = compressField(sample, distributed::CODEC_LZ4).size();
+        if (lz4Size < maxSize) {
+            codec = distributed::CODEC_LZ4;
+            maxSize = lz4Size / MIN_ZSTD_GAIN;
+        }
+#endif
+#ifdef USE_ZSTD
+        if (compressField(sample, distributed::CODEC_ZSTD).size() < maxSize)
+            codec = distributed::CODEC_ZSTD;
+#endif
+        return codec;
+    }
+}
+
+WireCompression parseWireCompression(const std::string &compression) {
+    if (compression.empty() || compression == "none")
+        return WireCompression::NONE;
+    if (compression == "lz4") {
+#ifndef USE_LZ4
+        throw std::runtime_error("distributed_compression: lz4 is not supported by this build");
+#endif
+        return WireCompression::LZ4;
+    }
+    if (compression == "zstd") {
+#ifndef USE_ZSTD
+        throw std::runtime_error("distributed_compression: zstd is not supported by this build");
+#endif
+        return WireCompression::ZSTD;
+    }
+    if (compression == "adaptive")
+        return WireCompression::ADAPTIVE;
+    throw std::runtime_error("distributed_compression: unknown compression '" + compression
+            + "', expected none, lz4, zstd, or adaptive");
+}
+
+void compressMatrix(distributed::Matrix *matProto, WireCompression compression) {
+    if (compression == WireCompression::NONE || isCompressed(*matProto))
+        return;
+    auto &stats = WireStatistics::get();
+    const auto start = std::chrono::steady_clock::now();
+
+    auto fields = getRawFields(matProto);
+    const size_t rawSize = getSize(fields);
+    if (rawSize < MIN_COMPRESS_BYTES) {
+        stats.numUncompressed++;
+        return;
+    }
+    const bool isCsr = matProto->matrix_case() == distributed::Matrix::MatrixCase::kCsrMatrix;
+    if (isCsr)
+        encodeCsrIndexes(matProto->mutable_csr_matrix(), matProto->num_rows());
+
+    distributed::Codec codec;
+    switch (compression) {
+        case WireCompression::LZ4: codec = distributed::CODEC_LZ4; break;
+        case WireCompression::ZSTD: codec = distributed::CODEC_ZSTD; break;
+        default: codec = chooseCodec(fields); break;
+    }
+    if (codec != distributed::CODEC_NONE) {
+        std::vector<std::string> compressed;
+        size_t compressedSize = 0;
+        for (auto field : fields) {
+            compressed.push_back(compressField(*field, codec));
+            compressedSize += compressed.back().size();
+        }
+        // incompressible data is sent as is
+        if (compressedSize < getSize(fields)) {
+            for (size_t i = 0; i < fields.size(); i++)
+                fields[i]->swap(compressed[i]);
+            matProto->set_codec(codec);
+        }
+    }
+    if (!isCompressed(*matProto)) {
+        stats.numUncompressed++;
+        return;
+    }
+    stats.numCompressed++;
+    stats.rawBytes += rawSize;
+    stats.wireBytes += getSize(fields);
+    stats.compressNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+bool isCompressed(const distributed::Matrix &matProto) {
+    return matProto.codec() != distributed::CODEC_NONE
+            || (matProto.matrix_case() == distributed::Matrix::MatrixCase::kCsrMatrix
+                && matProto.csr_matrix().delta_varint_idxs());
+}
+
+const distributed::Matrix &decompressMatrix(const distributed::Matrix &matProto, distributed::Matrix &buffer) {
+    if (!isCompressed(matProto))
+        return matProto;
+    auto &stats = WireStatistics::get();
+    const auto start = std::chrono::steady_clock::now();
+
+    buffer = matProto;
+    auto fields = getRawFields(&buffer);
+    const size_t wireSize = getSize(fields);
+    if (buffer.codec() != distributed::CODEC_NONE) {
+        for (auto field : fields)
+            *field = decompressField(*field, buffer.codec());
+        buffer.set_codec(distributed::CODEC_NONE);
+    }
+    if (buffer.matrix_case() == distributed::Matrix::MatrixCase::kCsrMatrix && buffer.csr_matrix().delta_varint_idxs())
+        decodeCsrIndexes(buffer.mutable_csr_matrix(), buffer.num_rows());
+
+    stats.numDecompressed++;
+    stats.rawBytes += getSize(fields);
+    stats.wireBytes += wireSize;
+    stats.decompressNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    return buffer;
+}
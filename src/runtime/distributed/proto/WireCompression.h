@@ -0,0 +1,61 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_PROTO_WIRECOMPRESSION_H
+#define SRC_RUNTIME_DISTRIBUTED_PROTO_WIRECOMPRESSION_H
+
+#include <runtime/distributed/proto/WireStatistics.h>
+#include <runtime/distributed/proto/worker.pb.h>
+
+#include <string>
+
+/**
+ * @brief How the matrices sent between the coordinator and the distributed
+ * workers are compressed, see the user config `distributed_compression`.
+ */
+enum class WireCompression {
+    NONE,
+    LZ4,
+    ZSTD,
+    // the codec is chosen per matrix from the compression ratios of a sample
+    ADAPTIVE,
+};
+
+/**
+ * @brief Parses "none", "lz4", "zstd", or "adaptive".
+ */
+WireCompression parseWireCompression(const std::string &compression);
+
+/**
+ * @brief Compresses the raw fields of the matrix (after `convertToProto`) in
+ * place. The row offsets and column indexes of CSR matrices are encoded as
+ * deltas in varints first. Matrices of a few KiB, and with `ADAPTIVE` the
+ * ones whose sample hardly compresses, are sent uncompressed.
+ */
+void compressMatrix(distributed::Matrix *matProto, WireCompression compression);
+
+/**
+ * @brief Whether the matrix must be decompressed before its values are read.
+ */
+bool isCompressed(const distributed::Matrix &matProto);
+
+/**
+ * @brief Returns the uncompressed matrix, which is the given one if it is
+ * not compressed, or else decompressed into `buffer`.
+ */
+const distributed::Matrix &decompressMatrix(const distributed::Matrix &matProto, distributed::Matrix &buffer);
+
+#endif //SRC_RUNTIME_DISTRIBUTED_PROTO_WIRECOMPRESSION_H
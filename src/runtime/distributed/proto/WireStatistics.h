@@ -0,0 +1,57 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_PROTO_WIRESTATISTICS_H
+#define SRC_RUNTIME_DISTRIBUTED_PROTO_WIRESTATISTICS_H
+
+#include <atomic>
+#include <ostream>
+
+#include <cstdint>
+
+/**
+ * @brief The statistics of the compression of the matrices this process sent
+ * to or received from the distributed workers, see `compressMatrix`.
+ */
+struct WireStatistics {
+    // the matrices compressed and decompressed
+    std::atomic<uint64_t> numCompressed{0};
+    std::atomic<uint64_t> numDecompressed{0};
+    // the raw fields of the matrices sent uncompressed, since they were small or hardly compressed
+    std::atomic<uint64_t> numUncompressed{0};
+    // the sizes of the raw fields of the (de)compressed matrices, before and after the compression
+    std::atomic<uint64_t> rawBytes{0};
+    std::atomic<uint64_t> wireBytes{0};
+    std::atomic<uint64_t> compressNanos{0};
+    std::atomic<uint64_t> decompressNanos{0};
+
+    static WireStatistics &get() {
+        static WireStatistics stats;
+        return stats;
+    }
+
+    void print(std::ostream &os) const {
+        const uint64_t raw = rawBytes;
+        const uint64_t wire = wireBytes;
+        os << "Distributed transfers: " << numCompressed << " matrices compressed, " << numDecompressed
+                << " decompressed, " << numUncompressed << " sent uncompressed, " << ((raw - wire) >> 10)
+                << " KiB saved of " << (raw >> 10) << " KiB, "
+                << (compressNanos / 1000000) << " ms compressing, "
+                << (decompressNanos / 1000000) << " ms decompressing" << std::endl;
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_PROTO_WIRESTATISTICS_H
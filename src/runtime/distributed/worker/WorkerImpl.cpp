@@ -23,34 +23,72 @@
 #include <mlir/Parser.h>
 #include <mlir/Pass/PassManager.h>
 #include <mlir/Transforms/Passes.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/SHA1.h>
 #include <llvm/Support/SourceMgr.h>
 
 #include <ir/daphneir/Daphne.h>
 
 #include "WorkerImpl.h"
+#include "WorkerMetrics.h"
 
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/kernels/Read.h>
 #include <runtime/local/io/ReadCsv.h>
+#include <runtime/local/io/RowChunkReader.h>
 #include <runtime/local/io/File.h>
 #include <compiler/execution/DaphneIrExecutor.h>
+#include <parser/config/ConfigParser.h>
+
+#include <chrono>
 
 const std::string WorkerImpl::DISTRIBUTED_FUNCTION_NAME = "dist";
 
-WorkerImpl::WorkerImpl() : tmp_file_counter_(0), localData_()
+WorkerImpl::WorkerImpl(DaphneUserConfig cfg) : tmp_file_counter_(0), localData_(), cfg_(std::move(cfg))
 {
 }
 
 WorkerImpl::~WorkerImpl() = default;
 
+namespace {
+    template<typename VT>
+    bool getBytes(Structure *mat, size_t &bytes) {
+        if (auto m = dynamic_cast<DenseMatrix<VT> *>(mat)) {
+            bytes = m->getNumRows() * m->getNumCols() * sizeof(VT);
+            return true;
+        }
+        if (auto m = dynamic_cast<CSRMatrix<VT> *>(mat)) {
+            bytes = m->getNumNonZeros() * (sizeof(VT) + sizeof(size_t)) + (m->getNumRows() + 1) * sizeof(size_t);
+            return true;
+        }
+        return false;
+    }
+
+    size_t getBytes(Structure *mat) {
+        size_t bytes = 0;
+        if (getBytes<double>(mat, bytes) || getBytes<float>(mat, bytes) || getBytes<int64_t>(mat, bytes)
+                || getBytes<int32_t>(mat, bytes))
+            return bytes;
+        // e.g., frames, estimated by cells of 8 bytes
+        return mat->getNumRows() * mat->getNumCols() * 8;
+    }
+}
+
+void WorkerImpl::track(const std::string &identifier, Structure *mat)
+{
+    const size_t bytes = getBytes(mat);
+    localBytes_[identifier] = bytes;
+    residentBytes_ += bytes;
+}
 
 template<>
 WorkerImpl::StoredInfo WorkerImpl::Store<Structure>(Structure *mat)
 {    
     auto identifier = "tmp_" + std::to_string(tmp_file_counter_++);
     localData_[identifier] = mat;
+    track(identifier, mat);
     return StoredInfo({identifier, mat->getNumRows(), mat->getNumCols()});
 }
 template<>
@@ -59,48 +97,131 @@ WorkerImpl::StoredInfo WorkerImpl::Store<double>(double *val)
     auto identifier = "tmp_" + std::to_string(tmp_file_counter_++);
     // The vectorized engine expects as input, a pointer value
     // to the memory holding a value. Therefore we need to allocate memory
-    // and save the value of the pointer to that address.
-    
-    // TODO: We need to implement a free operation (this applies to objects/matrices too). 
-    // It's probably best that coordinator decides when
-    // memory should be freed, (either when requesting data or by specifing a "FreeMemory" RPC call).
+    // and save the value of the pointer to that address. The coordinator
+    // frees it once it does not use it anymore (see FreeMem).
     double * valPtr = new double(*val);
     localData_[identifier] = valPtr;
+    localScalars_.insert(identifier);
+    localBytes_[identifier] = sizeof(double);
+    residentBytes_ += sizeof(double);
     return StoredInfo({identifier, 0, 0});
 }
     
     
 
 
-WorkerImpl::Status WorkerImpl::Compute(std::vector<WorkerImpl::StoredInfo> *outputs, std::vector<WorkerImpl::StoredInfo> inputs, std::string mlirCode)
+bool WorkerImpl::HasFragment(const std::string &fragmentId, const std::string &configJson) const
+{
+    return fragmentsById_.count(fragmentId + configJson) > 0;
+}
+
+DaphneIrExecutor &WorkerImpl::getExecutor(const std::string &configJson)
 {
-    // ToDo: user config
-    DaphneUserConfig cfg;
-    cfg.use_vectorized_exec = true;
+    auto it = executors_.find(configJson);
+    if (it != executors_.end())
+        return *it->second;
+
+    DaphneUserConfig cfg = cfg_;
+    if (!configJson.empty())
+        ConfigParser::readUserConfigFromString(configJson, cfg);
+    // The fragments are already distributed.
     cfg.use_distributed = false;
-    // TODO Decide if vectorized pipelines should be used on this worker.
     // TODO Decide if selectMatrixReprs should be used on this worker.
     // TODO Once we hand over longer pipelines to the workers, we might not
     // want to hardcode insertFreeOp to false anymore. But maybe we will insert
     // the FreeOps at the coordinator already.
-    DaphneIrExecutor executor(false, cfg);
+    return *executors_.emplace(configJson, std::make_unique<DaphneIrExecutor>(false, cfg)).first->second;
+}
 
-    mlir::OwningModuleRef module(mlir::parseSourceString<mlir::ModuleOp>(mlirCode, executor.getContext()));
+const WorkerImpl::CompiledFragment *WorkerImpl::getOrCompileFragment(const std::string &mlirCode,
+                                                                     const std::string &fragmentId,
+                                                                     const std::string &configJson,
+                                                                     std::string &error)
+{
+    const std::string key = fragmentId + configJson;
+    auto it = fragmentsById_.find(key);
+    if (it != fragmentsById_.end()) {
+        fragments_.splice(fragments_.begin(), fragments_, it->second);
+        WorkerMetrics::get().recordFragment(true);
+        return &it->second->second;
+    }
+    if (mlirCode.empty()) {
+        error = "Unknown fragment " + fragmentId + "\n";
+        return nullptr;
+    }
+
+    const auto compileStart = std::chrono::steady_clock::now();
+    DaphneIrExecutor *executor;
+    try {
+        executor = &getExecutor(configJson);
+    }
+    catch (std::exception &e) {
+        error = std::string("Invalid config of the task: ") + e.what() + "\n";
+        return nullptr;
+    }
+
+    mlir::OwningModuleRef module(mlir::parseSourceString<mlir::ModuleOp>(mlirCode, executor->getContext()));
     if (!module) {
-        auto message = "Failed to parse source string.\n";
-        llvm::errs() << message;
-        return WorkerImpl::Status(false, message);
+        error = "Failed to parse source string.\n";
+        return nullptr;
     }
 
     auto *distOp = module->lookupSymbol(DISTRIBUTED_FUNCTION_NAME);
     mlir::FuncOp distFunc;
     if (!(distFunc = llvm::dyn_cast_or_null<mlir::FuncOp>(distOp))) {
-        auto message = "MLIR fragment has to contain `dist` FuncOp\n";
-        llvm::errs() << message;
-        return WorkerImpl::Status(false, message);
+        error = "MLIR fragment has to contain `dist` FuncOp\n";
+        return nullptr;
     }
     auto distFuncTy = distFunc.getType();
 
+    // TODO Before we run the passes, we should insert information on shape
+    // (and potentially other properties) into the types of the arguments of
+    // the DISTRIBUTED_FUNCTION_NAME function. At least the shape can be
+    // obtained from the cached data partitions in localData_. Then, shape
+    // inference etc. should work within this function. The fragments would
+    // then have to be cached by these properties, too.
+    if (!executor->runPasses(module.get())) {
+        error = "Module Pass Error.\n";
+        return nullptr;
+    }
+
+    mlir::registerLLVMDialectTranslation(*module->getContext());
+
+    // The compiled fragments are kept by this worker, so the programs are not cached a second time.
+    JitObjectCache jitCache;
+    auto program = executor->createJitProgram(module.get(), DISTRIBUTED_FUNCTION_NAME, jitCache);
+    if (!program) {
+        error = "Failed to create JIT-Execution engine";
+        return nullptr;
+    }
+
+    WorkerMetrics::get().recordFragment(
+            false, std::chrono::duration<double>(std::chrono::steady_clock::now() - compileStart).count());
+
+    if (fragments_.size() >= MAX_COMPILED_FRAGMENTS) {
+        fragmentsById_.erase(fragments_.back().first);
+        fragments_.pop_back();
+    }
+    fragments_.emplace_front(key, CompiledFragment{program, distFuncTy});
+    fragmentsById_[key] = fragments_.begin();
+    return &fragments_.front().second;
+}
+
+WorkerImpl::Status WorkerImpl::Compute(std::vector<WorkerImpl::StoredInfo> *outputs, std::vector<WorkerImpl::StoredInfo> inputs, std::string mlirCode, std::string fragmentId, const std::string &configJson)
+{
+    if (fragmentId.empty()) {
+        llvm::SHA1 hash;
+        hash.update(mlirCode);
+        fragmentId = llvm::toHex(hash.final(), true);
+    }
+    std::string compileError;
+    const CompiledFragment *fragment = getOrCompileFragment(mlirCode, fragmentId, configJson, compileError);
+    if (!fragment) {
+        llvm::errs() << compileError;
+        return WorkerImpl::Status(false, compileError);
+    }
+    auto distFuncTy = fragment->distFuncTy;
+
     std::vector<void *> inputsObj;
     std::vector<void *> outputsObj;
     auto packedInputsOutputs = createPackedCInterfaceInputsOutputs(distFuncTy,
@@ -122,26 +243,8 @@ WorkerImpl::Status WorkerImpl::Compute(std::vector<WorkerImpl::StoredInfo> *outp
             reinterpret_cast<Structure*>(inputsObj[i])->increaseRefCounter();
 
     // Execution
-    // TODO Before we run the passes, we should insert information on shape
-    // (and potentially other properties) into the types of the arguments of
-    // the DISTRIBUTED_FUNCTION_NAME function. At least the shape can be
-    // obtained from the cached data partitions in localData_. Then, shape
-    // inference etc. should work within this function.
-    if (!executor.runPasses(module.get())) {
-        std::stringstream ss;
-        ss << "Module Pass Error.\n";
-        // module->print(ss, llvm::None);
-        llvm::errs() << ss.str();
-        return WorkerImpl::Status(false, ss.str());
-    }
-
-    mlir::registerLLVMDialectTranslation(*module->getContext());
-
-    auto engine = executor.createExecutionEngine(module.get());
-    if (!engine) {
-        return WorkerImpl::Status(false, std::string("Failed to create JIT-Execution engine"));
-    }
-    auto error = engine->invokePacked(DISTRIBUTED_FUNCTION_NAME,
+    auto &program = fragment->program;
+    auto error = program->invokePacked(DISTRIBUTED_FUNCTION_NAME,
         llvm::MutableArrayRef<void *>{&packedInputsOutputs[0], (size_t)0});
 
     if (error) {
@@ -157,6 +260,7 @@ WorkerImpl::Status WorkerImpl::Compute(std::vector<WorkerImpl::StoredInfo> *outp
         localData_[identification] = output;
 
         auto mat = static_cast<Structure*>(output);
+        track(identification, mat);
 
         outputs->push_back(StoredInfo({identification, mat->getNumRows(), mat->getNumCols()}));
     }
@@ -184,6 +288,47 @@ Structure * WorkerImpl::Transfer(StoredInfo info)
     return mat;
 }
 
+WorkerImpl::StoredInfo WorkerImpl::ReadRows(const std::string &filename, size_t rowBegin, size_t rowEnd,
+                                            size_t numCols)
+{
+    if (rowBegin > rowEnd)
+        throw std::runtime_error("ReadRows: invalid range of rows of file " + filename);
+    // the rows are read on the workers of a context of the worker's configuration
+    DaphneContext ctx(cfg_);
+    const int ext = extValue(filename.c_str());
+    DenseMatrix<double> *mat = nullptr;
+    switch (ext) {
+        case 0:
+        case 3: {
+            // CSV lines are skipped without parsing them, Daphne binary files are read from the first row on.
+            RowChunkReader<double> reader(filename.c_str(), ext == 0
+                                                  ? RowChunkReader<double>::Format::CSV
+                                                  : RowChunkReader<double>::Format::DAPHNE,
+                                          rowEnd, numCols, ',', &ctx);
+            reader.skip(rowBegin);
+            mat = reader.readNext(rowEnd - rowBegin);
+            break;
+        }
+#ifdef USE_ARROW
+        case 2:
+            readParquetRows(mat, filename.c_str(), rowBegin, rowEnd, &ctx);
+            break;
+#endif
+#ifdef USE_HDF5
+        case 5:
+            // only the chunks of the rows are read
+            readHDF5Rows(mat, filename.c_str(), rowBegin, rowEnd, 0, std::numeric_limits<size_t>::max(), &ctx);
+            break;
+#endif
+        default:
+            throw std::runtime_error("ReadRows: file " + filename + " cannot be read by rows");
+    }
+    if (mat == nullptr)
+        // an empty range
+        mat = DataObjectFactory::create<DenseMatrix<double>>(0, numCols, false);
+    return Store<Structure>(mat);
+}
+
 
 std::vector<void *> WorkerImpl::createPackedCInterfaceInputsOutputs(mlir::FunctionType functionType,
                                                                     std::vector<WorkerImpl::StoredInfo> workInputs,
@@ -277,45 +422,29 @@ Structure *WorkerImpl::readOrGetMatrix(const std::string &identifier, size_t num
 //        auto result = localData_.insert({identifier, m});
 //        assert(result.second && "Value should always be inserted");
         assert(localData_.insert({identifier, m}).second && "Value should always be inserted");
+        track(identifier, m);
         return m;    
     }
 }
 
-// grpc::Status WorkerImpl::FreeMem(::grpc::ServerContext *context,
-//                                const ::distributed::StoredData *request,
-//                                ::distributed::Empty *emptyMessg)
-// {
-//     // switch (request->type())
-//     // {
-//     // case distributed::StoredData::Type::StoredData_Type_DenseMatrix_i64:
-//     // case distributed::StoredData::Type::StoredData_Type_CSRMatrix_i64:
-//     //     return FreeMemType<int64_t>(context, request, emptyMessg);
-//     //     break;
-//     // case distributed::StoredData::Type::StoredData_Type_DenseMatrix_f64:
-//     // case distributed::StoredData::Type::StoredData_Type_CSRMatrix_f64:
-//     //     return FreeMemType<double>(context, request, emptyMessg);
-//     //     break;
-//     // default:
-//     //     break;
-//     // }
-//     // return grpc::Status::CANCELLED;
-// }
-
-// template<typename VT>
-// grpc::Status WorkerImpl::FreeMemType(::grpc::ServerContext *context,
-//                                const ::distributed::StoredData *request,
-//                                ::distributed::Empty *emptyMessg)
-// {
-//     auto identifier = request->identifier();
-//     auto data_it = localData_.find(identifier);
-
-//     if (data_it != localData_.end()) {
-//         auto * mat = reinterpret_cast<Matrix<VT> *>(data_it->second);
-//         if(auto m = dynamic_cast<DenseMatrix<VT> *>(mat))
-//             DataObjectFactory::destroy(m);
-//         else if(auto m = dynamic_cast<CSRMatrix<VT> *>(mat))
-//             DataObjectFactory::destroy(m);
-//         localData_.erase(identifier);
-//     }
-//     return grpc::Status::OK;
-// }
+size_t WorkerImpl::FreeMem(const std::vector<std::string> &identifiers)
+{
+    size_t numFreed = 0;
+    for (const auto &identifier : identifiers) {
+        auto data_it = localData_.find(identifier);
+        if (data_it == localData_.end())
+            continue;
+        if (localScalars_.erase(identifier))
+            delete static_cast<double *>(data_it->second);
+        else
+            DataObjectFactory::destroy(static_cast<Structure *>(data_it->second));
+        localData_.erase(data_it);
+        auto bytes_it = localBytes_.find(identifier);
+        if (bytes_it != localBytes_.end()) {
+            residentBytes_ -= bytes_it->second;
+            localBytes_.erase(bytes_it);
+        }
+        numFreed++;
+    }
+    return numFreed;
+}
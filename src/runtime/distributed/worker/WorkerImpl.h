@@ -17,12 +17,22 @@
 #ifndef SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERIMPL_H
 #define SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERIMPL_H
 
+#include <list>
 #include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <mlir/IR/BuiltinTypes.h>
 
+#include <api/cli/DaphneUserConfig.h>
+#include <compiler/execution/JitObjectCache.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 
+class DaphneIrExecutor;
+
 class WorkerImpl  
 {
 public:
@@ -39,7 +49,11 @@ public:
     
     const static std::string DISTRIBUTED_FUNCTION_NAME;
    
-    WorkerImpl();
+    /**
+     * @param cfg The user config of this worker, e.g., the number of threads of the vectorized engine, which is used
+     * for all tasks, unless they override it
+     */
+    explicit WorkerImpl(DaphneUserConfig cfg);
     ~WorkerImpl();
     
     virtual void Wait() { };
@@ -62,10 +76,18 @@ public:
      * 
      * @param outputs vector to populate with results of the pipeline (identifier, numRows/cols, etc.)
      * @param inputs vector with inputs of pipeline (identifiers to use, etc.)
-     * @param mlirCode mlir code fragment
+     * @param mlirCode mlir code fragment, or empty to compute the fragment of the given ID compiled before
+     * @param fragmentId The ID of the fragment, or empty to identify it by a hash of its code
+     * @param configJson The keys of the worker's user config overridden for this task, as a JSON object (or empty)
      * @return WorkerImpl::Status contains if everything went fine, with an optional error message
      */
-    WorkerImpl::Status Compute(std::vector<WorkerImpl::StoredInfo> *outputs, std::vector<WorkerImpl::StoredInfo> inputs, std::string mlirCode) ;
+    WorkerImpl::Status Compute(std::vector<WorkerImpl::StoredInfo> *outputs, std::vector<WorkerImpl::StoredInfo> inputs, std::string mlirCode, std::string fragmentId = "", const std::string &configJson = "") ;
+
+    /**
+     * @brief Whether the fragment of the given ID is compiled for the given config, such that it can be computed
+     * without its code
+     */
+    bool HasFragment(const std::string &fragmentId, const std::string &configJson = "") const;
 
     /**
      * @brief Returns a matrix stored in worker's memory
@@ -75,9 +97,62 @@ public:
      */
     Structure * Transfer(StoredInfo storedInfo);
 
+    /**
+     * @brief Reads the rows [rowBegin, rowEnd) of a dense matrix of doubles from a file (CSV, Daphne binary, or
+     * Parquet) and stores them at the worker's memory. Of Daphne binary files with blocks and Parquet files, only
+     * the blocks or row groups containing these rows are read.
+     *
+     * @return StoredInfo Information regarding stored object (identifier, numRows, numCols)
+     */
+    StoredInfo ReadRows(const std::string &filename, size_t rowBegin, size_t rowEnd, size_t numCols);
+
+    /**
+     * @brief Frees the data of the given identifiers, which the coordinator does not use anymore. Unknown
+     * identifiers, e.g., of data freed before, are ignored.
+     *
+     * @return The number of freed objects
+     */
+    size_t FreeMem(const std::vector<std::string> &identifiers);
+
+    /**
+     * @brief The bytes of the data held in worker's memory
+     */
+    uint64_t GetResidentBytes() const { return residentBytes_; }
+
+    size_t GetNumObjects() const { return localData_.size(); }
+
 private:
     uint64_t tmp_file_counter_ = 0;
     std::unordered_map<std::string, void *> localData_;
+    // the bytes of the data by identifier, the scalars stored by the coordinator, and the sum of the bytes
+    std::unordered_map<std::string, size_t> localBytes_;
+    std::unordered_set<std::string> localScalars_;
+    uint64_t residentBytes_ = 0;
+
+    void track(const std::string &identifier, Structure *mat);
+
+    struct CompiledFragment {
+        std::shared_ptr<JitProgram> program;
+        mlir::FunctionType distFuncTy;
+    };
+    // the maximum number of compiled fragments kept, the least recently used one is evicted first
+    static constexpr size_t MAX_COMPILED_FRAGMENTS = 64;
+    DaphneUserConfig cfg_;
+    // The executors of the fragments by the config overridden by the tasks, whose contexts own the types of the
+    // compiled fragments. Iterative algorithms compute the same fragments again and again, which are parsed,
+    // lowered, and JIT-compiled only once.
+    std::map<std::string, std::unique_ptr<DaphneIrExecutor>> executors_;
+    // the compiled fragments by their ID and the overridden config, the most recently used one first
+    std::list<std::pair<std::string, CompiledFragment>> fragments_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, CompiledFragment>>::iterator> fragmentsById_;
+
+    /**
+     * @brief Returns the compiled fragment of the given ID, which is compiled from the given code if it was not
+     * compiled before, or `nullptr` with an error message.
+     */
+    const CompiledFragment *getOrCompileFragment(const std::string &mlirCode, const std::string &fragmentId,
+                                                 const std::string &configJson, std::string &error);
+    DaphneIrExecutor &getExecutor(const std::string &configJson);
     /**
      * Creates a vector holding pointers to the inputs as well as the outputs. This vector can directly be passed
      * to the `ExecutionEngine::invokePacked` method.
@@ -18,20 +18,41 @@
 #include "WorkerImplGRPC.h"
 
 #include <runtime/distributed/proto/CallData.h>
+#include <runtime/distributed/proto/DistributedGRPCCaller.h>
 #include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/WireCompression.h>
+#include <runtime/distributed/proto/HashPartition.h>
+#include <runtime/distributed/proto/Tracing.h>
+#include <runtime/distributed/worker/WorkerMetrics.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/Group.h>
+#include <runtime/local/kernels/InnerJoin.h>
+#include <runtime/local/kernels/SemiJoin.h>
 
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/server_builder.h>
 
-WorkerImplGRPC::WorkerImplGRPC(std::string addr)
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+WorkerImplGRPC::WorkerImplGRPC(std::string addr, DaphneUserConfig cfg)
+        : WorkerImpl(cfg), compression_(parseWireCompression(cfg.distributed_compression))
 {
     builder.AddListeningPort(addr, grpc::InsecureServerCredentials());
     cq_ = builder.AddCompletionQueue();
+    heartbeatCq_ = builder.AddCompletionQueue();
     builder.RegisterService(&service_);
     builder.SetMaxReceiveMessageSize(INT_MAX);
     builder.SetMaxSendMessageSize(INT_MAX);
     server = builder.BuildAndStart();
+    if (cfg.distributed_metrics_port > 0)
+        WorkerMetrics::get().serve(cfg.distributed_metrics_port);
+    if (!cfg.distributed_trace_file.empty())
+        Tracing::get().open(cfg.distributed_trace_file, "worker " + addr);
 }
 
 void WorkerImplGRPC::Wait() {
@@ -39,7 +60,25 @@ void WorkerImplGRPC::Wait() {
     new StoreCallData(this, cq_.get());
     new ComputeCallData(this, cq_.get());
     new TransferCallData(this, cq_.get());
-    // new FreeMemCallData(this, cq_.get());
+    new StoreStreamCallData(this, cq_.get());
+    new TransferStreamCallData(this, cq_.get());
+    new BroadcastCallData(this, cq_.get());
+    new ReduceCallData(this, cq_.get());
+    new ReadCallData(this, cq_.get());
+    new FreeMemCallData(this, cq_.get());
+    new RelationalCallData(this, cq_.get());
+    new ExchangeCallData(this, cq_.get());
+    new HeartbeatCallData(this, heartbeatCq_.get());
+    heartbeatThread = std::thread([this]() {
+        void *tag;
+        bool ok;
+        while (heartbeatCq_->Next(&tag, &ok)) {
+            if (ok)
+                static_cast<CallData*>(tag)->Proceed();
+            else
+                static_cast<CallData*>(tag)->ProceedNotOk();
+        }
+    });
     void* tag;  // uniquely identifies a request.
     bool ok;
     // Block waiting to read the next event from the completion queue. The
@@ -53,26 +92,12 @@ void WorkerImplGRPC::Wait() {
             // We might need to add locks inside Store/Compute/Transfer methods if we deploy threads
             static_cast<CallData*>(tag)->Proceed();
         } else {
-            // TODO maybe handle this internally ?
-            delete static_cast<CallData*>(tag);
+            // e.g., the end of the chunks of a StoreStream call
+            static_cast<CallData*>(tag)->ProceedNotOk();
         }
     }
-}
-template<>
-DenseMatrix<double>* WorkerImplGRPC::CreateMatrix<DenseMatrix<double>>(const ::distributed::Matrix *mat) {
-    return DataObjectFactory::create<DenseMatrix<double>>(mat->num_rows(), mat->num_cols(), false);
-}
-template<>
-DenseMatrix<int64_t>* WorkerImplGRPC::CreateMatrix<DenseMatrix<int64_t>>(const ::distributed::Matrix *mat) {
-    return DataObjectFactory::create<DenseMatrix<int64_t>>(mat->num_rows(), mat->num_cols(), false);
-}
-template<>
-CSRMatrix<double>* WorkerImplGRPC::CreateMatrix<CSRMatrix<double>>(const ::distributed::Matrix *mat) {
-    return DataObjectFactory::create<CSRMatrix<double>>(mat->num_rows(), mat->num_cols(), mat->csr_matrix().values_f64().cells_size(), true);
-}
-template<>
-CSRMatrix<int64_t>* WorkerImplGRPC::CreateMatrix<CSRMatrix<int64_t>>(const ::distributed::Matrix *mat) {
-    return DataObjectFactory::create<CSRMatrix<int64_t>>(mat->num_rows(), mat->num_cols(), mat->csr_matrix().values_i64().cells_size(), true);
+    heartbeatCq_->Shutdown();
+    heartbeatThread.join();
 }
 
 grpc::Status WorkerImplGRPC::StoreGRPC(::grpc::ServerContext *context,
@@ -82,56 +107,14 @@ grpc::Status WorkerImplGRPC::StoreGRPC(::grpc::ServerContext *context,
     StoredInfo storedInfo;
     switch (request->data_case()){
         case distributed::Data::DataCase::kMatrix: {
-            Structure *mat = nullptr;
-            auto matrix = &request->matrix();
-            switch (matrix->matrix_case()) {
-                case distributed::Matrix::MatrixCase::kDenseMatrix:
-                    switch (matrix->dense_matrix().cells_case())
-                    {
-                    case distributed::DenseMatrix::CellsCase::kCellsI64:
-                    // TODO: initialize different type if VT is I32
-                    case distributed::DenseMatrix::CellsCase::kCellsI32:
-                        mat = CreateMatrix<DenseMatrix<int64_t>>(matrix);
-                        ProtoDataConverter<DenseMatrix<int64_t>>::convertFromProto(*matrix, dynamic_cast<DenseMatrix<int64_t>*>(mat));
-                        break;
-                    case distributed::DenseMatrix::CellsCase::kCellsF64:
-                    // TODO: initialize different type if VT is F32
-                    case distributed::DenseMatrix::CellsCase::kCellsF32:
-                        mat = CreateMatrix<DenseMatrix<double>>(matrix);
-                        ProtoDataConverter<DenseMatrix<double>>::convertFromProto(*matrix, dynamic_cast<DenseMatrix<double>*>(mat));
-                        break;    
-                    default:
-                        break;
-                    }
-                    break;
-                case distributed::Matrix::MatrixCase::kCsrMatrix:
-                    switch (matrix->csr_matrix().values_case())
-                    {
-                    case distributed::CSRMatrix::ValuesCase::kValuesI64:
-                    // TODO: initialize different type if VT is I32
-                    case distributed::CSRMatrix::ValuesCase::kValuesI32:
-                        mat = CreateMatrix<CSRMatrix<int64_t>>(matrix);
-                        ProtoDataConverter<CSRMatrix<int64_t>>::convertFromProto(*matrix, dynamic_cast<CSRMatrix<int64_t>*>(mat));
-                        break;
-                    case distributed::CSRMatrix::ValuesCase::kValuesF64:
-                    // TODO: initialize different type if VT is F32
-                    case distributed::CSRMatrix::ValuesCase::kValuesF32:
-                        mat = CreateMatrix<CSRMatrix<double>>(matrix);
-                        ProtoDataConverter<CSRMatrix<double>>::convertFromProto(*matrix, dynamic_cast<CSRMatrix<double>*>(mat));
-                        break;
-                    case distributed::CSRMatrix::ValuesCase::VALUES_NOT_SET:
-                    default:
-                        throw std::runtime_error("GRPC: Proto message 'Matrix': cell values not set");
-                    }
-                    break;
-                case distributed::Matrix::MatrixCase::MATRIX_NOT_SET:
-                default:
-                    throw std::runtime_error("GRPC: Proto message 'Matrix': matrix not set");
-            }
-            assert(mat != nullptr && "GRPC: proto message was not converted to Daphne Structure");
+            // dense and CSR matrices of double, float, int64_t, and int32_t, as the coordinator sent them
+            Structure *mat = createMatrixFromProto(request->matrix());
             storedInfo = Store<Structure>(mat);
             break; 
         }
+        case distributed::Data::DataCase::kFrame:
+            storedInfo = Store<Structure>(createFrameFromProto(request->frame()));
+            break;
         case distributed::Data::DataCase::kValue:
         {
             auto protoVal = &request->value();
@@ -161,6 +144,46 @@ grpc::Status WorkerImplGRPC::StoreGRPC(::grpc::ServerContext *context,
     return ::grpc::Status::OK;
 }
 
+void WorkerImplGRPC::StoreChunkGRPC(const ::distributed::MatrixChunk &chunk, Structure *&mat)
+{
+    const auto &rows = chunk.rows();
+    if (!mat)
+        mat = createMatrixForProto(rows, chunk.num_rows(), chunk.num_cols(), chunk.num_non_zeros());
+    const size_t numRows = rows.num_rows();
+    if (numRows == 0)
+        return;
+    if (chunk.row_begin() + numRows > mat->getNumRows() || rows.num_cols() != mat->getNumCols())
+        throw std::runtime_error("GRPC: the chunk does not fit into the matrix");
+    convertMatrixFromProto(rows, mat, chunk.row_begin(), chunk.row_begin() + numRows, 0, mat->getNumCols());
+}
+
+grpc::Status WorkerImplGRPC::StoreStreamGRPC(Structure *mat, ::distributed::StoredData *response)
+{
+    if (!mat)
+        return ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "GRPC: the stream did not contain any chunk");
+    StoredInfo storedInfo = Store<Structure>(mat);
+    response->set_identifier(storedInfo.identifier);
+    response->set_num_rows(storedInfo.numRows);
+    response->set_num_cols(storedInfo.numCols);
+    return ::grpc::Status::OK;
+}
+
+size_t WorkerImplGRPC::TransferChunkGRPC(const Structure *mat, size_t rowBegin, size_t chunkBytes,
+                                         ::distributed::MatrixChunk *chunk)
+{
+    const size_t numRows = mat->getNumRows();
+    size_t numNonZeros = 0;
+    const size_t numBytes = getNumBytes(mat, 0, numRows, numNonZeros);
+    const size_t rowEnd = std::min(numRows, rowBegin + getRowsPerChunk(numRows, numBytes, chunkBytes));
+    chunk->set_num_rows(numRows);
+    chunk->set_num_cols(mat->getNumCols());
+    chunk->set_num_non_zeros(numNonZeros);
+    chunk->set_row_begin(rowBegin);
+    convertMatrixToProto(mat, chunk->mutable_rows(), rowBegin, rowEnd, 0, mat->getNumCols());
+    compressMatrix(chunk->mutable_rows(), compression_);
+    return rowEnd;
+}
+
 grpc::Status WorkerImplGRPC::ComputeGRPC(::grpc::ServerContext *context,
                          const ::distributed::Task *request,
                          ::distributed::ComputeResult *response)
@@ -173,7 +196,11 @@ grpc::Status WorkerImplGRPC::ComputeGRPC(::grpc::ServerContext *context,
         auto stored = input.stored();
         inputs.push_back(StoredInfo({stored.identifier(), stored.num_rows(), stored.num_cols()}));
     }
-    auto respMsg = Compute(&outputs, inputs, request->mlir_code());
+    if (request->mlir_code().empty() && !HasFragment(request->fragment_id(), request->config_json())) {
+        response->set_unknown_fragment(true);
+        return ::grpc::Status::OK;
+    }
+    auto respMsg = Compute(&outputs, inputs, request->mlir_code(), request->fragment_id(), request->config_json());
     for (auto output : outputs){        
         distributed::WorkData workData;        
         workData.mutable_stored()->set_identifier(output.identifier);
@@ -193,15 +220,438 @@ grpc::Status WorkerImplGRPC::TransferGRPC(::grpc::ServerContext *context,
 {
     StoredInfo info({request->identifier(), request->num_rows(), request->num_cols()});
     Structure *mat = Transfer(info);
-    if(auto matDT = dynamic_cast<DenseMatrix<double>*>(mat))        
-        ProtoDataConverter<DenseMatrix<double>>::convertToProto(matDT, response);
-    else if(auto matDT = dynamic_cast<DenseMatrix<int64_t>*>(mat))        
-        ProtoDataConverter<DenseMatrix<int64_t>>::convertToProto(matDT, response);
-    else if(auto matDT = dynamic_cast<CSRMatrix<int64_t>*>(mat))        
-        ProtoDataConverter<CSRMatrix<int64_t>>::convertToProto(matDT, response);
-    else if(auto matDT = dynamic_cast<CSRMatrix<double>*>(mat))        
-        ProtoDataConverter<CSRMatrix<double>>::convertToProto(matDT, response);
-    else 
-        std::runtime_error("Type is not supported atm");
+    convertMatrixToProto(mat, response);
+    compressMatrix(response, compression_);
     return ::grpc::Status::OK;
-}
\ No newline at end of file
+}
+
+grpc::Status WorkerImplGRPC::ReadGRPC(::grpc::ServerContext *context,
+                         const ::distributed::ReadRequest *request,
+                         ::distributed::StoredData *response)
+{
+    StoredInfo storedInfo;
+    try {
+        storedInfo = ReadRows(request->filename(), request->row_begin(), request->row_end(), request->num_cols());
+    }
+    catch (std::exception &e) {
+        return ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+    }
+    response->set_identifier(storedInfo.identifier);
+    response->set_num_rows(storedInfo.numRows);
+    response->set_num_cols(storedInfo.numCols);
+    return ::grpc::Status::OK;
+}
+
+grpc::Status WorkerImplGRPC::FreeMemGRPC(::grpc::ServerContext *context,
+                         const ::distributed::FreeMemRequest *request,
+                         ::distributed::WorkerMemory *response)
+{
+    FreeMem(std::vector<std::string>(request->identifiers().begin(), request->identifiers().end()));
+    response->set_resident_bytes(GetResidentBytes());
+    response->set_num_objects(GetNumObjects());
+    return ::grpc::Status::OK;
+}
+namespace {
+    // The subtrees of the binomial tree rooted at the worker called, as ranges [begin, end) of its peers. The first
+    // peer of each range is a child of the worker called, which forwards to the rest of its range in turn, such that
+    // the data reaches n peers in about log2(n + 1) steps. The children are called at once, the one of the largest
+    // subtree first.
+    std::vector<std::pair<int, int>> getSubtrees(int numPeers) {
+        std::vector<std::pair<int, int>> subtrees;
+        for (int end = numPeers; end > 0; end /= 2)
+            subtrees.emplace_back(end / 2, end);
+        return subtrees;
+    }
+
+    // Appends the data stored by a child to the response, including the one at the child itself, whose address only
+    // the caller knows.
+    void addStoredByChild(const std::string &childAddr, const distributed::CollectiveResult &childResult,
+                          distributed::CollectiveResult *response) {
+        for (auto stored : childResult.stored()) {
+            if (stored.address().empty())
+                stored.set_address(childAddr);
+            *response->add_stored() = stored;
+        }
+    }
+
+    void addInto(DenseMatrix<double> *sum, const distributed::Matrix &matProto) {
+        if (matProto.num_rows() != sum->getNumRows() || matProto.num_cols() != sum->getNumCols())
+            throw std::runtime_error("GRPC: the partial results to sum up have different shapes");
+        auto part = DataObjectFactory::create<DenseMatrix<double>>(sum->getNumRows(), sum->getNumCols(), false);
+        ProtoDataConverter<DenseMatrix<double>>::convertFromProto(matProto, part);
+        for (size_t r = 0; r < sum->getNumRows(); r++) {
+            double *sumRow = sum->getValues() + r * sum->getRowSkip();
+            const double *partRow = part->getValues() + r * part->getRowSkip();
+            for (size_t c = 0; c < sum->getNumCols(); c++)
+                sumRow[c] += partRow[c];
+        }
+        DataObjectFactory::destroy(part);
+    }
+}
+
+grpc::Status WorkerImplGRPC::BroadcastToPeers(const ::distributed::Data &data, const std::vector<std::string> &peers,
+                                              ::distributed::CollectiveResult *response)
+{
+    DistributedGRPCCaller<std::string, distributed::BroadcastRequest, distributed::CollectiveResult> caller;
+    for (auto subtree : getSubtrees(static_cast<int>(peers.size()))) {
+        distributed::BroadcastRequest childRequest;
+        *childRequest.mutable_data() = data;
+        for (int i = subtree.first + 1; i < subtree.second; i++)
+            childRequest.add_peers(peers[i]);
+        caller.asyncBroadcastCall(peers[subtree.first], peers[subtree.first], childRequest);
+    }
+    // All calls are waited for, such that none is pending when the caller goes out of scope.
+    std::string error;
+    while (!caller.isQueueEmpty()) {
+        try {
+            auto child = caller.getNextResult();
+            addStoredByChild(child.storedInfo, child.result, response);
+        }
+        catch (std::exception &e) {
+            error = e.what();
+        }
+    }
+    if (!error.empty())
+        return ::grpc::Status(grpc::StatusCode::ABORTED, error);
+    return ::grpc::Status::OK;
+}
+
+grpc::Status WorkerImplGRPC::BroadcastGRPC(::grpc::ServerContext *context,
+                         const ::distributed::BroadcastRequest *request,
+                         ::distributed::CollectiveResult *response)
+{
+    auto status = StoreGRPC(context, &request->data(), response->add_stored()->mutable_stored());
+    if (!status.ok())
+        return status;
+    return BroadcastToPeers(request->data(),
+                            std::vector<std::string>(request->peers().begin(), request->peers().end()), response);
+}
+
+grpc::Status WorkerImplGRPC::ReduceGRPC(::grpc::ServerContext *context,
+                         const ::distributed::ReduceRequest *request,
+                         ::distributed::CollectiveResult *response)
+{
+    const auto &stored = request->stored();
+    auto partial = dynamic_cast<DenseMatrix<double>*>(Transfer({stored.identifier(), stored.num_rows(), stored.num_cols()}));
+    if (!partial)
+        return ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                              "GRPC: only partial results of type DenseMatrix<double> can be summed up");
+
+    // The children sum up the partial results of their subtrees, while the one of this worker is copied.
+    DistributedGRPCCaller<std::string, distributed::ReduceRequest, distributed::CollectiveResult> caller;
+    for (auto subtree : getSubtrees(request->peers_size())) {
+        const auto &child = request->peers(subtree.first);
+        distributed::ReduceRequest childRequest;
+        childRequest.set_mode(distributed::ReduceRequest::REDUCE);
+        *childRequest.mutable_stored() = child.stored();
+        for (int i = subtree.first + 1; i < subtree.second; i++)
+            *childRequest.add_peers() = request->peers(i);
+        caller.asyncReduceCall(child.address(), child.address(), childRequest);
+    }
+    const size_t numRows = partial->getNumRows();
+    const size_t numCols = partial->getNumCols();
+    auto sum = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+    for (size_t r = 0; r < numRows; r++)
+        std::copy(partial->getValues() + r * partial->getRowSkip(),
+                  partial->getValues() + r * partial->getRowSkip() + numCols,
+                  sum->getValues() + r * sum->getRowSkip());
+    std::string error;
+    while (!caller.isQueueEmpty()) {
+        try {
+            addInto(sum, caller.getNextResult().result.matrix());
+        }
+        catch (std::exception &e) {
+            error = e.what();
+        }
+    }
+    if (!error.empty()) {
+        DataObjectFactory::destroy(sum);
+        return ::grpc::Status(grpc::StatusCode::ABORTED, error);
+    }
+
+    switch (request->mode()) {
+        case distributed::ReduceRequest::REDUCE:
+            ProtoDataConverter<DenseMatrix<double>>::convertToProto(sum, response->mutable_matrix());
+            compressMatrix(response->mutable_matrix(), compression_);
+            DataObjectFactory::destroy(sum);
+            return ::grpc::Status::OK;
+        case distributed::ReduceRequest::ALL_REDUCE: {
+            StoredInfo storedInfo = Store<Structure>(sum);
+            auto self = response->add_stored()->mutable_stored();
+            self->set_identifier(storedInfo.identifier);
+            self->set_num_rows(storedInfo.numRows);
+            self->set_num_cols(storedInfo.numCols);
+            distributed::Data data;
+            ProtoDataConverter<DenseMatrix<double>>::convertToProto(sum, data.mutable_matrix());
+            compressMatrix(data.mutable_matrix(), compression_);
+            std::vector<std::string> peers;
+            for (auto &peer : request->peers())
+                peers.push_back(peer.address());
+            return BroadcastToPeers(data, peers, response);
+        }
+        case distributed::ReduceRequest::REDUCE_SCATTER: {
+            // The blocks of rows are split like the results combined by rows, this worker keeps the first one.
+            const size_t numWorkers = request->peers_size() + 1;
+            const size_t k = numRows / numWorkers;
+            const size_t m = numRows % numWorkers;
+            auto rowBegin = [k, m](size_t i) { return i * k + std::min(i, m); };
+
+            DistributedGRPCCaller<distributed::PeerData, distributed::Data, distributed::StoredData> storeCaller;
+            for (size_t i = 1; i < numWorkers; i++) {
+                distributed::PeerData peer;
+                peer.set_address(request->peers(i - 1).address());
+                peer.set_row_begin(rowBegin(i));
+                distributed::Data data;
+                ProtoDataConverter<DenseMatrix<double>>::convertToProto(sum, data.mutable_matrix(),
+                                                                        rowBegin(i), rowBegin(i + 1), 0, numCols);
+                compressMatrix(data.mutable_matrix(), compression_);
+                storeCaller.asyncStoreCall(peer.address(), peer, data);
+            }
+            StoredInfo storedInfo = Store<Structure>(
+                    DataObjectFactory::create<DenseMatrix<double>>(sum, 0, rowBegin(1), 0, numCols));
+            DataObjectFactory::destroy(sum);
+            auto self = response->add_stored()->mutable_stored();
+            self->set_identifier(storedInfo.identifier);
+            self->set_num_rows(storedInfo.numRows);
+            self->set_num_cols(storedInfo.numCols);
+            while (!storeCaller.isQueueEmpty()) {
+                try {
+                    auto peer = storeCaller.getNextResult();
+                    *peer.storedInfo.mutable_stored() = peer.result;
+                    *response->add_stored() = peer.storedInfo;
+                }
+                catch (std::exception &e) {
+                    error = e.what();
+                }
+            }
+            if (!error.empty())
+                return ::grpc::Status(grpc::StatusCode::ABORTED, error);
+            return ::grpc::Status::OK;
+        }
+        default:
+            DataObjectFactory::destroy(sum);
+            return ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "GRPC: unknown mode of Reduce");
+    }
+}
+
+namespace {
+    void setStoredData(const WorkerImpl::StoredInfo &storedInfo, distributed::StoredData *stored) {
+        stored->set_identifier(storedInfo.identifier);
+        stored->set_num_rows(storedInfo.numRows);
+        stored->set_num_cols(storedInfo.numCols);
+    }
+
+    // Concatenates the rows of the given frames, which must have the same schema and labels.
+    Frame *concatFrames(const std::vector<const Frame *> &frames) {
+        const Frame *first = frames.front();
+        const size_t numCols = first->getNumCols();
+        size_t numRows = 0;
+        for (auto frame : frames) {
+            if (frame->getNumCols() != numCols
+                    || !std::equal(first->getSchema(), first->getSchema() + numCols, frame->getSchema())
+                    || !std::equal(first->getLabels(), first->getLabels() + numCols, frame->getLabels()))
+                throw std::runtime_error("GRPC: the frames to concatenate must have the same schema and labels");
+            numRows += frame->getNumRows();
+        }
+        auto res = DataObjectFactory::create<Frame>(numRows, numCols, first->getSchema(), first->getLabels(), false);
+        for (size_t c = 0; c < numCols; c++) {
+            const ValueTypeCode vtc = first->getColumnType(c);
+            size_t r = 0;
+            for (auto frame : frames) {
+                const size_t n = frame->getNumRows();
+                if (vtc == ValueTypeCode::STR)
+                    std::copy_n(static_cast<const std::string *>(frame->getColumnRaw(c)), n,
+                                static_cast<std::string *>(res->getColumnRaw(c)) + r);
+                else {
+                    const size_t elemSize = ValueTypeUtils::sizeOf(vtc);
+                    std::memcpy(static_cast<uint8_t *>(res->getColumnRaw(c)) + r * elemSize,
+                                frame->getColumnRaw(c), n * elemSize);
+                }
+                r += n;
+            }
+        }
+        return res;
+    }
+
+    // The key column and the row id column (of uint64_t) of the rows of lhs with a match in rhs.
+    Frame *semiJoinRowIds(const Frame *lhs, const Frame *rhs, const std::string &lhsOn, const std::string &rhsOn,
+                          const std::string &rowId) {
+        Frame *keys = nullptr;
+        DenseMatrix<size_t> *tids = nullptr;
+        semiJoin<size_t>(keys, tids, lhs, rhs, lhsOn.c_str(), rhsOn.c_str(), nullptr);
+        if (!keys)
+            throw std::runtime_error("GRPC: the semi-join only supports key columns of int64_t");
+        const size_t numRows = keys->getNumRows();
+        const ValueTypeCode schema[] = {keys->getColumnType(0), ValueTypeCode::UI64};
+        const std::string labels[] = {lhsOn, rowId};
+        auto res = DataObjectFactory::create<Frame>(numRows, 2, schema, labels, false);
+        std::memcpy(res->getColumnRaw(0), keys->getColumnRaw(0), numRows * ValueTypeUtils::sizeOf(schema[0]));
+        auto rowIdsLhs = static_cast<const uint64_t *>(lhs->getColumnRaw(lhs->getColumnIdx(rowId)));
+        auto rowIdsRes = static_cast<uint64_t *>(res->getColumnRaw(1));
+        for (size_t r = 0; r < numRows; r++)
+            rowIdsRes[r] = rowIdsLhs[tids->get(r, 0)];
+        DataObjectFactory::destroy(keys, tids);
+        return res;
+    }
+
+    std::vector<const char *> toCStrings(const google::protobuf::RepeatedPtrField<std::string> &strings) {
+        std::vector<const char *> res;
+        for (auto &s : strings)
+            res.push_back(s.c_str());
+        return res;
+    }
+}
+
+Frame *WorkerImplGRPC::GetFrame(const ::distributed::StoredData &stored)
+{
+    auto frame = dynamic_cast<Frame *>(Transfer({stored.identifier(), stored.num_rows(), stored.num_cols()}));
+    if (!frame)
+        throw std::runtime_error("GRPC: " + stored.identifier() + " is not a frame");
+    return frame;
+}
+
+void WorkerImplGRPC::FreeFrames(const google::protobuf::RepeatedPtrField<::distributed::StoredData> &stored)
+{
+    std::vector<std::string> identifiers;
+    for (auto &s : stored)
+        identifiers.push_back(s.identifier());
+    FreeMem(identifiers);
+}
+
+grpc::Status WorkerImplGRPC::RelationalGRPC(::grpc::ServerContext *context,
+                         const ::distributed::RelationalRequest *request,
+                         ::distributed::RelationalResult *response)
+{
+    if (request->lhs().empty())
+        return ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "GRPC: the relational operator has no input");
+    // the inputs concatenated from several ones
+    std::vector<Frame *> owned;
+    Frame *res = nullptr;
+    // whether the result is the single input (CONCAT), which is not copied
+    bool resIsInput = false;
+    bool resStored = false;
+    bool inputKept = false;
+    try {
+        auto concat = [&](const google::protobuf::RepeatedPtrField<::distributed::StoredData> &stored) {
+            std::vector<const Frame *> frames;
+            for (auto &s : stored)
+                frames.push_back(GetFrame(s));
+            if (frames.size() == 1)
+                return const_cast<Frame *>(frames.front());
+            owned.push_back(concatFrames(frames));
+            return owned.back();
+        };
+        Frame *lhs = concat(request->lhs());
+        switch (request->op()) {
+            case distributed::RelationalRequest::CONCAT:
+                res = lhs;
+                resIsInput = request->lhs_size() == 1;
+                break;
+            case distributed::RelationalRequest::INNER_JOIN: {
+                Frame *rhs = concat(request->rhs());
+                auto lhsOn = toCStrings(request->lhs_on());
+                auto rhsOn = toCStrings(request->rhs_on());
+                if (lhsOn.size() != rhsOn.size())
+                    throw std::runtime_error("GRPC: the join must have as many key columns of lhs as of rhs");
+                innerJoin(res, lhs, rhs, lhsOn.data(), rhsOn.data(), lhsOn.size(), nullptr);
+                break;
+            }
+            case distributed::RelationalRequest::SEMI_JOIN: {
+                Frame *rhs = concat(request->rhs());
+                if (request->lhs_on_size() != 1 || request->rhs_on_size() != 1)
+                    throw std::runtime_error("GRPC: the semi-join must have a single key column");
+                res = semiJoinRowIds(lhs, rhs, request->lhs_on(0), request->rhs_on(0), request->row_id());
+                break;
+            }
+            case distributed::RelationalRequest::GROUP: {
+                auto keyCols = toCStrings(request->lhs_on());
+                auto aggCols = toCStrings(request->agg_cols());
+                std::vector<mlir::daphne::GroupEnum> aggFuncs;
+                for (auto f : request->agg_funcs())
+                    aggFuncs.push_back(static_cast<mlir::daphne::GroupEnum>(f));
+                group(res, lhs, keyCols.data(), keyCols.size(), aggCols.data(), aggCols.size(), aggFuncs.data(),
+                      aggFuncs.size(), nullptr);
+                break;
+            }
+            default:
+                throw std::runtime_error("GRPC: unknown relational operator");
+        }
+        if (!request->labels().empty()) {
+            if (static_cast<size_t>(request->labels_size()) != res->getNumCols())
+                throw std::runtime_error("GRPC: the result must have as many labels as columns");
+            std::vector<std::string> labels(request->labels().begin(), request->labels().end());
+            res->setLabels(labels.data());
+        }
+
+        if (request->num_partitions() > 0) {
+            std::vector<std::string> keyCols(request->partition_on().begin(), request->partition_on().end());
+            for (auto &rows : hashPartition(res, keyCols, request->num_partitions()))
+                setStoredData(Store<Structure>(gatherRows(res, rows)), response->add_stored());
+        }
+        else if (request->collect())
+            convertFrameToProto(res, response->mutable_frame());
+        else if (resIsInput) {
+            *response->add_stored() = request->lhs(0);
+            inputKept = true;
+        }
+        else {
+            setStoredData(Store<Structure>(res), response->add_stored());
+            resStored = true;
+        }
+    }
+    catch (std::exception &e) {
+        for (auto frame : owned)
+            if (frame != res)
+                DataObjectFactory::destroy(frame);
+        if (res && !resIsInput)
+            DataObjectFactory::destroy(res);
+        return ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+    }
+    for (auto frame : owned)
+        if (frame != res)
+            DataObjectFactory::destroy(frame);
+    if (!resIsInput && !resStored)
+        DataObjectFactory::destroy(res);
+    // The single input stored as the result is kept.
+    if (request->free_inputs() && !inputKept) {
+        FreeFrames(request->lhs());
+        FreeFrames(request->rhs());
+    }
+    return ::grpc::Status::OK;
+}
+
+grpc::Status WorkerImplGRPC::ExchangeGRPC(::grpc::ServerContext *context,
+                         const ::distributed::ExchangeRequest *request,
+                         ::distributed::ExchangeResult *response)
+{
+    try {
+        if (request->peer().empty()) {
+            // This worker is the peer of the caller, which waits for the partitions requested.
+            for (auto &frame : request->frames())
+                setStoredData(Store<Structure>(createFrameFromProto(frame)), response->add_received());
+            for (auto &stored : request->send())
+                convertFrameToProto(GetFrame(stored), response->add_frames());
+            if (request->free_sent())
+                FreeFrames(request->send());
+            return ::grpc::Status::OK;
+        }
+
+        distributed::ExchangeRequest peerRequest;
+        *peerRequest.mutable_send() = request->receive();
+        peerRequest.set_free_sent(request->free_sent());
+        for (auto &stored : request->send())
+            convertFrameToProto(GetFrame(stored), peerRequest.add_frames());
+        if (request->free_sent())
+            FreeFrames(request->send());
+        DistributedGRPCCaller<std::string, distributed::ExchangeRequest, distributed::ExchangeResult> caller;
+        caller.asyncExchangeCall(request->peer(), request->peer(), peerRequest);
+        auto peerResult = caller.getNextResult().result;
+        *response->mutable_peer_received() = peerResult.received();
+        for (auto &frame : peerResult.frames())
+            setStoredData(Store<Structure>(createFrameFromProto(frame)), response->add_received());
+    }
+    catch (std::exception &e) {
+        return ::grpc::Status(grpc::StatusCode::ABORTED, e.what());
+    }
+    return ::grpc::Status::OK;
+}
@@ -21,18 +21,26 @@
 
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/server_builder.h>
+#include <thread>
 #include "runtime/distributed/proto/worker.pb.h"
 #include "runtime/distributed/proto/worker.grpc.pb.h"
+#include "runtime/distributed/proto/WireCompression.h"
+#include "runtime/local/datastructures/Frame.h"
 
 
 class WorkerImplGRPC : public WorkerImpl 
 {
 private:
     std::unique_ptr<grpc::ServerCompletionQueue> cq_;
+    // the heartbeats are served on a thread of their own, such that they are answered while the worker computes
+    std::unique_ptr<grpc::ServerCompletionQueue> heartbeatCq_;
+    std::thread heartbeatThread;
     grpc::ServerBuilder builder;
     std::unique_ptr<grpc::Server> server;
+    // the compression of the matrices this worker sends, by its own user config
+    WireCompression compression_;
 public:
-    WorkerImplGRPC(std::string addr);
+    WorkerImplGRPC(std::string addr, DaphneUserConfig cfg);
     void Wait() override;
     grpc::Status StoreGRPC(::grpc::ServerContext *context,
                          const ::distributed::Data *request,
@@ -44,10 +52,78 @@ public:
                           const ::distributed::StoredData *request,
                          ::distributed::Matrix *response) ;
 
-    template<class DT>
-    DT* CreateMatrix(const ::distributed::Matrix *mat);
+    /**
+     * @brief Converts a chunk of a StoreStream call into the matrix, which is
+     * created from the first chunk (if `mat` is `nullptr`).
+     */
+    void StoreChunkGRPC(const ::distributed::MatrixChunk &chunk, Structure *&mat);
+    grpc::Status StoreStreamGRPC(Structure *mat, ::distributed::StoredData *response);
+    /**
+     * @brief Converts the next chunk of a TransferStream call, starting at
+     * the given row, and returns the row after the chunk.
+     */
+    size_t TransferChunkGRPC(const Structure *mat, size_t rowBegin, size_t chunkBytes,
+                             ::distributed::MatrixChunk *chunk);
+
+    /**
+     * @brief Stores the data and forwards it to the peers along a binomial
+     * tree, whose inner workers forward it to their subtrees in turn.
+     */
+    grpc::Status BroadcastGRPC(::grpc::ServerContext *context,
+                         const ::distributed::BroadcastRequest *request,
+                         ::distributed::CollectiveResult *response) ;
+    /**
+     * @brief Sums up the partial results of this worker and its peers along
+     * a binomial tree, and returns the sum, or stores it at all of them
+     * (all-reduce) or a block of its rows at each one (reduce-scatter).
+     */
+    grpc::Status ReduceGRPC(::grpc::ServerContext *context,
+                         const ::distributed::ReduceRequest *request,
+                         ::distributed::CollectiveResult *response) ;
+
+    grpc::Status ReadGRPC(::grpc::ServerContext *context,
+                         const ::distributed::ReadRequest *request,
+                         ::distributed::StoredData *response) ;
+
+    /**
+     * @brief Frees the data the coordinator does not use anymore and returns the bytes this worker holds afterwards.
+     */
+    grpc::Status FreeMemGRPC(::grpc::ServerContext *context,
+                         const ::distributed::FreeMemRequest *request,
+                         ::distributed::WorkerMemory *response) ;
+
+    /**
+     * @brief Computes a relational operator on the frames stored at this
+     * worker, whose result is stored as a whole or by hash partitions, or
+     * returned.
+     */
+    grpc::Status RelationalGRPC(::grpc::ServerContext *context,
+                         const ::distributed::RelationalRequest *request,
+                         ::distributed::RelationalResult *response) ;
+    /**
+     * @brief Swaps hash partitions of frames with the peer of the request,
+     * or, if this worker is the peer, stores the partitions sent and returns
+     * the requested ones.
+     */
+    grpc::Status ExchangeGRPC(::grpc::ServerContext *context,
+                         const ::distributed::ExchangeRequest *request,
+                         ::distributed::ExchangeResult *response) ;
 
     distributed::Worker::AsyncService service_;
+private:
+    /**
+     * @brief The frame of the given identifier stored at this worker.
+     */
+    Frame *GetFrame(const ::distributed::StoredData &stored);
+    void FreeFrames(const google::protobuf::RepeatedPtrField<::distributed::StoredData> &stored);
+
+    /**
+     * @brief Sends the data to the children of this worker in the binomial
+     * tree of the given peers and appends the data stored by all of them to
+     * the response.
+     */
+    grpc::Status BroadcastToPeers(const ::distributed::Data &data, const std::vector<std::string> &peers,
+                                  ::distributed::CollectiveResult *response);
 };
 
 #endif //SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERIMPLGRPC_H
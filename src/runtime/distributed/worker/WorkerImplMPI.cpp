@@ -0,0 +1,186 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "WorkerImplMPI.h"
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+WorkerImplMPI::WorkerImplMPI(DaphneUserConfig cfg) : WorkerImpl(cfg)
+{
+    MPIHelper::init();
+}
+
+void WorkerImplMPI::Wait() {
+    while (true) {
+        MPIHelper::Header header;
+        try {
+            MPIHelper::broadcastHeader(header);
+            switch (header.command) {
+                case MPIHelper::Command::STORE:
+                    StoreMPI(header);
+                    break;
+                case MPIHelper::Command::BROADCAST:
+                    BroadcastMPI(header);
+                    break;
+                case MPIHelper::Command::COMPUTE:
+                    ComputeMPI(header);
+                    break;
+                case MPIHelper::Command::COLLECT_ROWS:
+                    CollectRowsMPI();
+                    break;
+                case MPIHelper::Command::COLLECT_COLS:
+                    CollectColsMPI();
+                    break;
+                case MPIHelper::Command::SUM:
+                    SumMPI(header);
+                    break;
+                case MPIHelper::Command::SHUTDOWN:
+                    MPI_Finalize();
+                    return;
+            }
+        }
+        catch (std::exception &e) {
+            // The coordinator and the other workers cannot go on with the collectives of the command, so the whole
+            // job is aborted. The errors of the tasks themselves are reported to the coordinator instead.
+            std::cerr << "Distributed worker of rank " << MPIHelper::getRank() << ": " << e.what() << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+}
+
+void WorkerImplMPI::StoreMPI(const MPIHelper::Header &header) {
+    const size_t numCols = header.args[0];
+    uint64_t numRows;
+    MPIHelper::check(MPI_Scatter(nullptr, 1, MPI_UINT64_T, &numRows, 1, MPI_UINT64_T, MPIHelper::COORDINATOR,
+                                 MPI_COMM_WORLD), "MPI_Scatter");
+    DenseMatrix<double> *mat = nullptr;
+    if (numRows > 0)
+        mat = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+    MPIHelper::RowType rowType(numCols, numCols);
+    MPIHelper::check(MPI_Scatterv(nullptr, nullptr, nullptr, rowType.get(), mat ? mat->getValues() : nullptr,
+                                  MPIHelper::toInt(numRows), rowType.get(), MPIHelper::COORDINATOR, MPI_COMM_WORLD),
+                     "MPI_Scatterv");
+    std::vector<MPIHelper::StoredData> stored;
+    if (mat) {
+        auto info = Store<Structure>(mat);
+        stored.push_back(MPIHelper::makeStoredData(info.identifier, info.numRows, info.numCols));
+    }
+    MPIHelper::gatherStored(stored, 1);
+}
+
+void WorkerImplMPI::BroadcastMPI(const MPIHelper::Header &header) {
+    StoredInfo info;
+    if (header.args[2]) {
+        double val;
+        std::memcpy(&val, &header.args[3], sizeof(double));
+        info = Store(&val);
+    }
+    else {
+        const size_t numRows = header.args[0];
+        const size_t numCols = header.args[1];
+        auto mat = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+        MPIHelper::RowType rowType(numCols, numCols);
+        MPIHelper::check(MPI_Bcast(mat->getValues(), MPIHelper::toInt(numRows), rowType.get(), MPIHelper::COORDINATOR,
+                                   MPI_COMM_WORLD), "MPI_Bcast");
+        info = Store<Structure>(mat);
+    }
+    MPIHelper::gatherStored({MPIHelper::makeStoredData(info.identifier, info.numRows, info.numCols)}, 1);
+}
+
+void WorkerImplMPI::ComputeMPI(const MPIHelper::Header &header) {
+    std::string mlirCode(header.args[0], '\0');
+    std::string configJson(header.args[1], '\0');
+    const size_t numInputs = header.args[2];
+    const size_t numOutputs = header.args[3];
+    MPIHelper::broadcastString(mlirCode);
+    MPIHelper::broadcastString(configJson);
+    std::vector<StoredInfo> inputs;
+    for (auto &input : MPIHelper::scatterStored({}, numInputs))
+        inputs.push_back(StoredInfo({MPIHelper::getIdentifier(input), input.numRows, input.numCols}));
+
+    std::vector<StoredInfo> outputs;
+    std::string error;
+    try {
+        // The compiled fragments are kept by the hash of their code.
+        auto status = Compute(&outputs, inputs, mlirCode, "", configJson);
+        if (!status.ok())
+            error = status.error_message().empty() ? "the task failed" : status.error_message();
+    }
+    catch (std::exception &e) {
+        error = e.what();
+    }
+    std::vector<MPIHelper::StoredData> stored;
+    if (error.empty() && outputs.size() != numOutputs)
+        error = "the task has " + std::to_string(outputs.size()) + " outputs instead of " + std::to_string(numOutputs);
+    if (error.empty())
+        for (auto &output : outputs)
+            stored.push_back(MPIHelper::makeStoredData(output.identifier, output.numRows, output.numCols));
+    MPIHelper::gatherStored(stored, numOutputs);
+    MPIHelper::gatherErrors(error);
+}
+
+const DenseMatrix<double> *WorkerImplMPI::GetPart(const MPIHelper::StoredData &stored) {
+    const std::string identifier = MPIHelper::getIdentifier(stored);
+    if (identifier.empty())
+        return nullptr;
+    auto part = dynamic_cast<const DenseMatrix<double>*>(Transfer(StoredInfo({identifier, stored.numRows,
+                                                                               stored.numCols})));
+    if (!part)
+        throw std::runtime_error("the MPI backend only supports DenseMatrix<double> for now");
+    return part;
+}
+
+void WorkerImplMPI::CollectRowsMPI() {
+    auto part = GetPart(MPIHelper::scatterStored({}, 1)[0]);
+    const size_t numCols = part ? part->getNumCols() : 0;
+    MPIHelper::RowType rowType(numCols, part ? part->getRowSkip() : 0);
+    MPIHelper::check(MPI_Gatherv(part ? part->getValues() : nullptr, part ? MPIHelper::toInt(part->getNumRows()) : 0,
+                                 rowType.get(), nullptr, nullptr, nullptr, rowType.get(), MPIHelper::COORDINATOR,
+                                 MPI_COMM_WORLD), "MPI_Gatherv");
+}
+
+void WorkerImplMPI::CollectColsMPI() {
+    auto part = GetPart(MPIHelper::scatterStored({}, 1)[0]);
+    if (!part)
+        return;
+    MPIHelper::RowType rowType(part->getNumCols(), part->getRowSkip());
+    MPIHelper::check(MPI_Send(part->getValues(), MPIHelper::toInt(part->getNumRows()), rowType.get(),
+                              MPIHelper::COORDINATOR, 0, MPI_COMM_WORLD), "MPI_Send");
+}
+
+void WorkerImplMPI::SumMPI(const MPIHelper::Header &header) {
+    const size_t numRows = header.args[0];
+    const size_t numCols = header.args[1];
+    auto part = GetPart(MPIHelper::scatterStored({}, 1)[0]);
+    // the partial result without the gaps between its rows, or zeros if this worker has none
+    std::vector<double> values(numRows * numCols, 0.0);
+    if (part) {
+        if (part->getNumRows() != numRows || part->getNumCols() != numCols)
+            throw std::runtime_error("the partial results have different shapes");
+        for (size_t r = 0; r < numRows; r++)
+            std::copy(part->getValues() + r * part->getRowSkip(), part->getValues() + r * part->getRowSkip() + numCols,
+                      values.begin() + r * numCols);
+    }
+    MPIHelper::check(MPI_Reduce(values.data(), nullptr, MPIHelper::toInt(values.size()), MPI_DOUBLE, MPI_SUM,
+                                MPIHelper::COORDINATOR, MPI_COMM_WORLD), "MPI_Reduce");
+}
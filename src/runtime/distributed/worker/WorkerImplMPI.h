@@ -0,0 +1,51 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERIMPLMPI_H
+#define SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERIMPLMPI_H
+
+#include "WorkerImpl.h"
+
+#include <runtime/distributed/mpi/MPIHelper.h>
+
+/**
+ * @brief A distributed worker of the MPI backend, which is a rank other than 0 of the MPI job of the coordinator
+ * and takes part in the commands of the coordinator (see `MPIHelper`).
+ */
+class WorkerImplMPI : public WorkerImpl
+{
+public:
+    explicit WorkerImplMPI(DaphneUserConfig cfg);
+    /**
+     * @brief Serves the commands of the coordinator until it shuts the workers down, and finalizes MPI.
+     */
+    void Wait() override;
+
+private:
+    void StoreMPI(const MPIHelper::Header &header);
+    void BroadcastMPI(const MPIHelper::Header &header);
+    void ComputeMPI(const MPIHelper::Header &header);
+    void CollectRowsMPI();
+    void CollectColsMPI();
+    void SumMPI(const MPIHelper::Header &header);
+
+    /**
+     * @brief The partition of the given stored data, or `nullptr` for an empty identifier.
+     */
+    const DenseMatrix<double> *GetPart(const MPIHelper::StoredData &stored);
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERIMPLMPI_H
@@ -0,0 +1,202 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "WorkerMetrics.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <cerrno>
+#include <cstring>
+
+void WorkerMetrics::recordCall(const std::string &rpc, double seconds, bool ok, uint64_t bytesIn, uint64_t bytesOut) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &metrics = rpcs[rpc];
+    metrics.numCalls++;
+    if (!ok)
+        metrics.numErrors++;
+    size_t bucket = 0;
+    while (bucket < LATENCY_BUCKETS.size() && seconds > LATENCY_BUCKETS[bucket])
+        bucket++;
+    metrics.buckets[bucket]++;
+    metrics.sumSeconds += seconds;
+    metrics.bytesIn += bytesIn;
+    metrics.bytesOut += bytesOut;
+}
+
+void WorkerMetrics::recordFragment(bool cached, double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cached)
+        fragmentHits++;
+    else {
+        fragmentMisses++;
+        compileSeconds += seconds;
+    }
+}
+
+void WorkerMetrics::setResident(uint64_t bytes, uint64_t objects) {
+    std::lock_guard<std::mutex> lock(mutex);
+    residentBytes = bytes;
+    numObjects = objects;
+}
+
+void WorkerMetrics::beginCall() {
+    std::lock_guard<std::mutex> lock(mutex);
+    inFlight++;
+}
+
+void WorkerMetrics::endCall() {
+    std::lock_guard<std::mutex> lock(mutex);
+    inFlight--;
+}
+
+std::string WorkerMetrics::render() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream os;
+    os.precision(10);
+    auto header = [&os](const char *name, const char *type, const char *help) {
+        os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    };
+    auto perRpc = [&](const char *name, const char *help, uint64_t RpcMetrics::*field) {
+        header(name, "counter", help);
+        for (auto &[rpc, metrics] : rpcs)
+            os << name << "{rpc=\"" << rpc << "\"} " << metrics.*field << "\n";
+    };
+
+    perRpc("daphne_worker_rpcs_total", "The calls served by the worker.", &RpcMetrics::numCalls);
+    perRpc("daphne_worker_rpc_errors_total", "The calls served by the worker that failed.", &RpcMetrics::numErrors);
+    perRpc("daphne_worker_received_bytes_total", "The bytes of the messages received by the worker.",
+           &RpcMetrics::bytesIn);
+    perRpc("daphne_worker_sent_bytes_total", "The bytes of the messages sent by the worker.", &RpcMetrics::bytesOut);
+
+    header("daphne_worker_rpc_duration_seconds", "histogram", "The latencies of the calls served by the worker.");
+    for (auto &[rpc, metrics] : rpcs) {
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < LATENCY_BUCKETS.size(); b++) {
+            cumulative += metrics.buckets[b];
+            os << "daphne_worker_rpc_duration_seconds_bucket{rpc=\"" << rpc << "\",le=\"" << LATENCY_BUCKETS[b]
+               << "\"} " << cumulative << "\n";
+        }
+        os << "daphne_worker_rpc_duration_seconds_bucket{rpc=\"" << rpc << "\",le=\"+Inf\"} " << metrics.numCalls
+           << "\n";
+        os << "daphne_worker_rpc_duration_seconds_sum{rpc=\"" << rpc << "\"} " << metrics.sumSeconds << "\n";
+        os << "daphne_worker_rpc_duration_seconds_count{rpc=\"" << rpc << "\"} " << metrics.numCalls << "\n";
+    }
+
+    header("daphne_worker_fragment_cache_hits_total", "counter",
+           "The fragments computed by the worker that were compiled before.");
+    os << "daphne_worker_fragment_cache_hits_total " << fragmentHits << "\n";
+    header("daphne_worker_fragment_cache_misses_total", "counter", "The fragments compiled by the worker.");
+    os << "daphne_worker_fragment_cache_misses_total " << fragmentMisses << "\n";
+    header("daphne_worker_compile_seconds_total", "counter", "The time the worker spent compiling fragments.");
+    os << "daphne_worker_compile_seconds_total " << compileSeconds << "\n";
+    header("daphne_worker_resident_bytes", "gauge", "The bytes of the data objects held by the worker.");
+    os << "daphne_worker_resident_bytes " << residentBytes << "\n";
+    header("daphne_worker_objects", "gauge", "The data objects held by the worker.");
+    os << "daphne_worker_objects " << numObjects << "\n";
+    header("daphne_worker_rpcs_in_flight", "gauge", "The calls accepted by the worker but not finished.");
+    os << "daphne_worker_rpcs_in_flight " << inFlight << "\n";
+    return os.str();
+}
+
+void WorkerMetrics::serve(uint16_t port) {
+    const int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+        throw std::runtime_error("cannot create the socket of the metrics endpoint");
+    const int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(sock, 16) < 0) {
+        close(sock);
+        throw std::runtime_error("cannot listen on port " + std::to_string(port) + " for the metrics endpoint: " +
+                                 std::strerror(errno));
+    }
+    std::thread([this, sock]() {
+        while (true) {
+            const int client = accept(sock, nullptr, nullptr);
+            if (client < 0)
+                continue;
+            // the request line suffices, the headers and a body are ignored
+            char request[1024];
+            const ssize_t n = recv(client, request, sizeof(request) - 1, 0);
+            std::string response;
+            if (n > 0 && std::string(request, n).rfind("GET /metrics", 0) == 0) {
+                const std::string body = render();
+                response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                        std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            }
+            else
+                response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            for (size_t sent = 0; sent < response.size();) {
+                const ssize_t s = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (s <= 0)
+                    break;
+                sent += s;
+            }
+            close(client);
+        }
+    }).detach();
+}
+
+ServedCall::ServedCall(std::string rpc, const std::string &traceparent, uint64_t bytesIn, bool makeCurrent)
+        : rpc(std::move(rpc)), startNanos(Tracing::nowNanos()), bytesIn(bytesIn), current(makeCurrent)
+{
+    WorkerMetrics::get().beginCall();
+    auto &tracing = Tracing::get();
+    if (!tracing.isEnabled())
+        return;
+    // A call without the context of a trace starts a trace of its own.
+    const TraceContext parent = TraceContext::fromHeader(traceparent);
+    span = {parent.isValid() ? parent.traceId : tracing.newId(16), tracing.newId(8)};
+    parentSpanId = parent.spanId;
+    if (current) {
+        previous = tracing.getCurrent();
+        tracing.setCurrent(span);
+    }
+}
+
+ServedCall::~ServedCall() {
+    if (finished)
+        return;
+    WorkerMetrics::get().endCall();
+    if (current && span.isValid())
+        Tracing::get().setCurrent(previous);
+}
+
+void ServedCall::finish(const std::string &error, uint64_t bytesOut, uint64_t residentBytes, uint64_t numObjects) {
+    const uint64_t endNanos = Tracing::nowNanos();
+    auto &metrics = WorkerMetrics::get();
+    metrics.recordCall(rpc, (endNanos - startNanos) / 1e9, error.empty(), bytesIn, bytesOut);
+    metrics.setResident(residentBytes, numObjects);
+    metrics.endCall();
+    if (span.isValid()) {
+        auto &tracing = Tracing::get();
+        tracing.record(rpc, span, parentSpanId, startNanos, endNanos, error);
+        if (current)
+            tracing.setCurrent(previous);
+    }
+    finished = true;
+}
@@ -0,0 +1,128 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERMETRICS_H
+#define SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERMETRICS_H
+
+#include <runtime/distributed/proto/Tracing.h>
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The metrics of a distributed worker, which it serves in the text format of Prometheus at the HTTP endpoint
+ * `/metrics` of the port `distributed_metrics_port` (see `serve()`).
+ *
+ * Per RPC, the metrics are the calls, the failed calls, a histogram of their latencies, and the bytes received and
+ * sent. Besides, there are the hits and misses of the compiled fragments of the worker and the time spent
+ * compiling, the bytes and the number of the data objects the worker holds, and the calls accepted but not finished.
+ */
+class WorkerMetrics {
+public:
+    // the upper bounds of the buckets of the histograms of the latencies in seconds, besides +Inf
+    static constexpr std::array<double, 12> LATENCY_BUCKETS = {
+            0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 1, 5, 30};
+
+    static WorkerMetrics &get() {
+        static WorkerMetrics metrics;
+        return metrics;
+    }
+
+    /**
+     * @brief Records a finished call of the given RPC.
+     */
+    void recordCall(const std::string &rpc, double seconds, bool ok, uint64_t bytesIn, uint64_t bytesOut);
+    /**
+     * @brief Records a fragment computed, which was compiled before or compiled in the given seconds.
+     */
+    void recordFragment(bool cached, double compileSeconds = 0);
+    void setResident(uint64_t bytes, uint64_t numObjects);
+    // the calls accepted but not finished
+    void beginCall();
+    void endCall();
+
+    /**
+     * @brief The metrics in the text format of Prometheus.
+     */
+    std::string render() const;
+
+    /**
+     * @brief Serves the metrics at `GET /metrics` on the given port of all interfaces, on a thread of its own, which
+     * runs as long as the process.
+     */
+    void serve(uint16_t port);
+
+private:
+    struct RpcMetrics {
+        uint64_t numCalls = 0;
+        uint64_t numErrors = 0;
+        // the calls per bucket of LATENCY_BUCKETS, not cumulative, and the calls above the last bound
+        std::array<uint64_t, LATENCY_BUCKETS.size() + 1> buckets{};
+        double sumSeconds = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, RpcMetrics> rpcs;
+    uint64_t fragmentHits = 0;
+    uint64_t fragmentMisses = 0;
+    double compileSeconds = 0;
+    uint64_t residentBytes = 0;
+    uint64_t numObjects = 0;
+    uint64_t inFlight = 0;
+};
+
+/**
+ * @brief A call served by a distributed worker from its start to `finish()`, which records its metrics and its span
+ * of the trace of the caller (see Tracing).
+ *
+ * The span is the current one of the worker until the call finishes if `makeCurrent` is set, such that the calls it
+ * makes to the peers of the worker are children of it. Streamed calls, which are served interleaved with others,
+ * do not set it.
+ */
+class ServedCall {
+    std::string rpc;
+    uint64_t startNanos;
+    uint64_t bytesIn;
+    TraceContext span;
+    std::string parentSpanId;
+    bool current;
+    TraceContext previous;
+    bool finished = false;
+
+public:
+    /**
+     * @param traceparent The `traceparent` metadata of the call, or empty
+     */
+    ServedCall(std::string rpc, const std::string &traceparent, uint64_t bytesIn, bool makeCurrent = true);
+    ~ServedCall();
+
+    void addBytesIn(uint64_t bytes) { bytesIn += bytes; }
+
+    /**
+     * @brief Records the call with the given error message (none if empty), the bytes sent, and the resident data of
+     * the worker afterwards.
+     */
+    void finish(const std::string &error, uint64_t bytesOut, uint64_t residentBytes, uint64_t numObjects);
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERMETRICS_H
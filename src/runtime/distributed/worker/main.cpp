@@ -16,22 +16,58 @@
 
 
 #include <iostream>
+#include <string>
 
 #include "WorkerImpl.h"
 #include "WorkerImplGRPC.h"
+#ifdef USE_MPI
+#include "WorkerImplMPI.h"
+#endif
+
+#include <api/cli/DaphneUserConfig.h>
+#include <parser/config/ConfigParser.h>
+#include <runtime/local/io/ObjectStore.h>
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <Address:Port>" << std::endl;
+    if (argc != 2 && argc != 3) {
+        std::cout << "Usage: " << argv[0] << " <Address:Port> [<UserConfig.json>]" << std::endl;
+        std::cout << "       " << argv[0] << " --mpi [<UserConfig.json>]" << std::endl;
         exit(1);
     }
     auto addr = argv[1];
 
-    // TODO choose specific implementation based on arguments or config file
-    WorkerImpl *service = new WorkerImplGRPC(addr);
-    
-    std::cout << "Started Distributed Worker on `" << addr << "`\n";
+    // The user config of this worker, e.g., the number of threads, the scheduling scheme, and the devices of the
+    // vectorized engine, which the tasks of a program may override (see `distributed_worker_config`).
+    DaphneUserConfig cfg;
+    cfg.use_vectorized_exec = true;
+    if (argc == 3) {
+        try {
+            if (ConfigParser::fileExists(argv[2]))
+                ConfigParser::readUserConfig(argv[2], cfg);
+        }
+        catch (std::exception &e) {
+            std::cerr << "Parser error while reading worker config: " << e.what() << std::endl;
+            exit(1);
+        }
+    }
+    // the workers read only their own ranges of the files in object stores
+    ObjectStore::get().configure(cfg.object_store_cache, cfg.object_store_connections);
+
+    WorkerImpl *service;
+    if (std::string(addr) == "--mpi") {
+        // A rank of the MPI job of the coordinator, e.g., started by mpirun or srun together with it.
+#ifdef USE_MPI
+        service = new WorkerImplMPI(cfg);
+#else
+        std::cerr << "The distributed worker was built without MPI" << std::endl;
+        exit(1);
+#endif
+    }
+    else {
+        service = new WorkerImplGRPC(addr, cfg);
+        std::cout << "Started Distributed Worker on `" << addr << "`\n";
+    }
     service->Wait();
 
     return 0;
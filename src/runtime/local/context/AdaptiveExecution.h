@@ -0,0 +1,45 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+
+#include <cstddef>
+#include <cstdint>
+
+class Structure;
+
+/**
+ * @brief The properties of an intermediate result observed at run-time, at a
+ * checkpoint of adaptive execution (see `AdaptiveCheckpointsPass`).
+ */
+struct ObservedProperties {
+    size_t numRows;
+    size_t numCols;
+    // -1 if not known, e.g., for frames
+    int64_t numNonZeros;
+    bool isSparse;
+};
+
+/**
+ * @brief Compiles the remainder of a function, given as the textual IR of a
+ * module, for the observed properties of its arguments, and runs it on them
+ * (see `AdaptiveRecompiler`).
+ */
+using AdaptiveCallFn = std::function<
+        void(const char * ir, const Structure ** args, const ObservedProperties * props, size_t numArgs)
+>;
@@ -15,8 +15,37 @@
  */
 
 #include "runtime/local/context/CUDAContext.h"
+#include "runtime/local/datastructures/MemoryTracker.h"
 
-size_t CUDAContext::alloc_count = 0;
+#include <nvrtc.h>
+
+#include <stdexcept>
+
+std::atomic<size_t> CUDAContext::alloc_count{0};
+thread_local size_t CUDAContext::current_device = 0;
+thread_local cudaStream_t CUDAContext::current_stream = nullptr;
+
+namespace {
+    // makes a device the current one of the calling thread until the end of the scope, e.g., to allocate memory on
+    // a device other than the one of the calling thread
+    class DeviceGuard {
+        int prev_device = -1;
+    public:
+        explicit DeviceGuard(int device_id) {
+            CHECK_CUDART(cudaGetDevice(&prev_device));
+            if(prev_device != device_id)
+                CHECK_CUDART(cudaSetDevice(device_id));
+        }
+        DeviceGuard(const DeviceGuard&) = delete;
+        DeviceGuard& operator=(const DeviceGuard&) = delete;
+        ~DeviceGuard() {
+            int device_id;
+            cudaGetDevice(&device_id);
+            if(device_id != prev_device)
+                cudaSetDevice(prev_device);
+        }
+    };
+}
 
 void CUDAContext::destroy() {
 #ifndef NDEBUG
@@ -35,7 +64,42 @@ void CUDAContext::destroy() {
     CHECK_CUDNN(cudnnDestroyConvolutionDescriptor(conv_desc));
     CHECK_CUDNN(cudnnDestroyFilterDescriptor(filter_desc));
 
-    CHECK_CUDART(cudaFree(cudnn_workspace));
+    cudnn_workspace.reset();
+    {
+        std::lock_guard<std::mutex> lock(graph_mtx);
+        for(auto& [key, exec] : graph_execs)
+            CHECK_CUDART(cudaGraphExecDestroy(exec));
+        graph_execs.clear();
+    }
+    CHECK_CUDART(cudaStreamDestroy(graph_stream));
+    {
+        std::lock_guard<std::mutex> lock(generated_mtx);
+        for(auto& [signature, module] : generated_modules)
+            cuModuleUnload(module);
+        generated_modules.clear();
+    }
+    CHECK_CUDART(cudaStreamDestroy(h2d_stream));
+    CHECK_CUDART(cudaStreamDestroy(d2h_stream));
+    for(auto& [buffer, size] : pinned_buffers)
+        if(buffer)
+            CHECK_CUDART(cudaFreeHost(buffer));
+    pinned_buffers.clear();
+    {
+        std::lock_guard<std::mutex> lock(alloc_mtx);
+        allocations.clear();
+    }
+#ifndef NDEBUG
+    auto stats = memory_pool->getStatistics();
+    std::cerr << "CUDA memory pool of device " << device_id << ": " << stats.hits << " hits, " << stats.misses
+            << " misses, " << stats.reservedBytes << " bytes reserved, fragmentation " << stats.getFragmentation()
+            << std::endl;
+    auto residency_stats = residency->getStatistics();
+    std::cerr << "CUDA residency of device " << device_id << ": " << residency_stats.evictions << " evictions, "
+            << residency_stats.writeBacks << " thereof with write-back (" << residency_stats.writeBackBytes
+            << " bytes)" << std::endl;
+#endif
+    // blocks still referenced elsewhere return to the device allocator once released
+    memory_pool->releaseCached();
 //    CHECK_CUDART(cudaFree(cublas_workspace));
 //    CHECK_CUBLAS(cublasLtDestroy(ltHandle));
 }
@@ -49,12 +113,33 @@ void CUDAContext::init() {
     // ToDo: make this a user config item
     float mem_usage = 0.9f;
     mem_budget = total * mem_usage;
+    const int id = device_id;
+    residency = std::make_unique<ResidencyManager>(mem_budget);
+    memory_pool = DeviceMemoryPool::create(mem_budget,
+            [id](size_t size) -> void* {
+                DeviceGuard guard(id);
+                void* ptr = nullptr;
+                if(cudaMalloc(&ptr, size) != cudaSuccess) {
+                    // clear the error, the pool retries after releasing its cached blocks
+                    cudaGetLastError();
+                    return nullptr;
+                }
+                return ptr;
+            },
+            [id](void* ptr) {
+                DeviceGuard guard(id);
+                CHECK_CUDART(cudaFree(ptr));
+            });
 #ifndef NDEBUG
     std::cerr << "Using CUDA device " << device_id << ": " << device_properties.name  << "\nAvailable mem: "
             << available << " Total mem: " << total << " using " << mem_usage * 100 << "% thereof -> " << mem_budget
             << std::endl;
 #endif
     CHECK_CUBLAS(cublasCreate(&cublas_handle));
+    // tensor cores for the FP32 routines of cuBLAS (FP16/BF16 additionally round the inputs of the matrix
+    // multiplications, see MixedPrecision.h)
+    if(precision != CUDAPrecision::DEFAULT)
+        CHECK_CUBLAS(cublasSetMathMode(cublas_handle, CUBLAS_TF32_TENSOR_OP_MATH));
     CHECK_CUSPARSE(cusparseCreate(&cusparse_handle));
     CHECK_CUDNN(cudnnCreate(&cudnn_handle));
     CHECK_CUDNN(cudnnCreatePoolingDescriptor(&pooling_desc));
@@ -68,6 +153,11 @@ void CUDAContext::init() {
 
     CHECK_CUDART(cudaStreamCreateWithFlags(&cusolver_stream, cudaStreamNonBlocking));
     CHECK_CUSOLVER(cusolverDnSetStream(cusolver_handle, cusolver_stream));
+    CHECK_CUDART(cudaStreamCreateWithFlags(&h2d_stream, cudaStreamNonBlocking));
+    CHECK_CUDART(cudaStreamCreateWithFlags(&d2h_stream, cudaStreamNonBlocking));
+    // a synchronous copy on the default stream while capturing from this stream fails the capture, instead of copying
+    // data the captured kernels have not computed yet
+    CHECK_CUDART(cudaStreamCreate(&graph_stream));
 
     getCUDNNWorkspace(64 * 1024 * 1024);
 
@@ -100,7 +190,9 @@ void* CUDAContext::getCUDNNWorkspace(size_t size) {
         //#ifndef NDEBUG
 //        std::cerr << "Allocating cudnn conv workspace of size " << size << " bytes" << std::endl;
         //#endif
-        CHECK_CUDART(cudaMalloc(&cudnn_workspace, size));
+        // the previous workspace returns to the memory pool
+        cudnn_workspace.reset();
+        cudnn_workspace = allocate(size);
         cudnn_workspace_size = size;
     }
     //#ifndef NDEBUG
@@ -108,10 +200,34 @@ void* CUDAContext::getCUDNNWorkspace(size_t size) {
 //        std::cerr << "Not allocating cudnn conv workspace of size " << size << " bytes" << std::endl;
 //    }
     //#endif
-    return cudnn_workspace;
+    return cudnn_workspace.get();
 }
 
-std::unique_ptr<IContext> CUDAContext::createCudaContext(int device_id) {
+cudnnMathType_t CUDAContext::getConvMathType() const {
+    switch(precision) {
+        case CUDAPrecision::TF32:
+            return CUDNN_TENSOR_OP_MATH;
+        case CUDAPrecision::FP16:
+        case CUDAPrecision::BF16:
+            return CUDNN_TENSOR_OP_MATH_ALLOW_CONVERSION;
+        default:
+            return CUDNN_DEFAULT_MATH;
+    }
+}
+
+CUDAPrecision CUDAContext::precisionFromString(const std::string& str) {
+    if(str == "default")
+        return CUDAPrecision::DEFAULT;
+    if(str == "tf32")
+        return CUDAPrecision::TF32;
+    if(str == "fp16")
+        return CUDAPrecision::FP16;
+    if(str == "bf16")
+        return CUDAPrecision::BF16;
+    throw std::runtime_error("unknown CUDA precision: " + str + " (expected default, tf32, fp16, or bf16)");
+}
+
+std::unique_ptr<IContext> CUDAContext::createCudaContext(int device_id, CUDAPrecision precision, float loss_scale) {
 
     int device_count = -1;
     CHECK_CUDART(cudaGetDeviceCount(&device_count));
@@ -126,25 +242,188 @@ std::unique_ptr<IContext> CUDAContext::createCudaContext(int device_id) {
         return nullptr;
     }
 
-    auto ctx = std::unique_ptr<CUDAContext>(new CUDAContext(device_id));
+    if(loss_scale <= 0)
+        throw std::runtime_error("the CUDA loss scale must be positive");
+
+    auto ctx = std::unique_ptr<CUDAContext>(new CUDAContext(device_id, precision, loss_scale));
     ctx->init();
     return ctx;
 }
 
-std::shared_ptr<std::byte> CUDAContext::malloc(size_t size, bool zero, size_t& id) {
+bool CUDAContext::enablePeerAccess(const CUDAContext* other) {
+    if(other->device_id == device_id)
+        return true;
+    int can_access = 0;
+    CHECK_CUDART(cudaDeviceCanAccessPeer(&can_access, device_id, other->device_id));
+    if(!can_access)
+        return false;
+    DeviceGuard guard(device_id);
+    auto status = cudaDeviceEnablePeerAccess(other->device_id, 0);
+    if(status != cudaSuccess && status != cudaErrorPeerAccessAlreadyEnabled)
+        CHECK_CUDART(status);
+    // clear the error state in case the access was enabled before
+    cudaGetLastError();
+    peer_devices.insert(other->device_id);
+    return true;
+}
+
+void CUDAContext::setCurrentDevice(DaphneContext* ctx, size_t id) {
+    CHECK_CUDART(cudaSetDevice(get(ctx, id)->device_id));
+    current_device = id;
+}
+
+std::shared_ptr<std::byte> CUDAContext::malloc(size_t size, bool zero, size_t& id, cudaStream_t stream) {
     id = alloc_count++;
-    std::byte* dev_ptr;
-    CHECK_CUDART(cudaMalloc(reinterpret_cast<void **>(&dev_ptr), size));
-    allocations.emplace(id, std::shared_ptr<std::byte>(dev_ptr, CudaDeleter<std::byte>()));
+    // evicting may free device memory, thus, it must not happen under alloc_mtx
+    residency->makeRoom(size);
+    std::shared_ptr<std::byte> ptr;
+    try {
+        ptr = allocate(size, stream);
+    }
+    catch(const std::runtime_error&) {
+        // other allocations (e.g., workspaces) are not tracked, such that the device may be full within the budget
+        if(!residency->evict(size))
+            throw;
+        ptr = allocate(size, stream);
+    }
+    if(MemoryTracker::isEnabled()) {
+        // the device memory is accounted for until the last reference to it is dropped
+        auto tracked = MemoryTracker::get().track(ALLOCATION_TYPE::GPU_CUDA, size);
+        ptr = std::shared_ptr<std::byte>(ptr.get(), [ptr, tracked](std::byte *) {});
+    }
+    {
+        std::lock_guard<std::mutex> lock(alloc_mtx);
+        allocations.emplace(id, ptr);
+    }
 
-    if(zero)
-        CHECK_CUDART(cudaMemset(dev_ptr, 0, size));
-    return allocations.at(id);
+    if(zero) {
+        // the calling thread may work with another device, e.g., when prefetching the inputs of all devices
+        DeviceGuard guard(device_id);
+        CHECK_CUDART(cudaMemsetAsync(ptr.get(), 0, size, stream ? stream : current_stream));
+    }
+    return ptr;
 }
 
 void CUDAContext::free(size_t id) {
-    // ToDo: handle reuse
-    CHECK_CUDART(cudaFree(allocations.at(id).get()));
+    // the memory returns to the pool once the last reference is dropped
+    std::lock_guard<std::mutex> lock(alloc_mtx);
     allocations.erase(id);
 }
 
+void* CUDAContext::getPinnedBuffer(size_t slot, size_t size) {
+    if(slot >= pinned_buffers.size())
+        pinned_buffers.resize(slot + 1, {nullptr, 0});
+    auto& [buffer, capacity] = pinned_buffers[slot];
+    if(capacity < size) {
+        if(buffer)
+            CHECK_CUDART(cudaFreeHost(buffer));
+        CHECK_CUDART(cudaHostAlloc(&buffer, size, cudaHostAllocPortable));
+        capacity = size;
+    }
+    return buffer;
+}
+
+std::shared_ptr<std::byte> CUDAContext::allocate(size_t size, cudaStream_t stream) {
+    // the blocks allocated while capturing are used (and reused) by the graph on its stream
+    return memory_pool->allocate(size, stream ? stream : current_stream);
+}
+
+void CUDAContext::setLibraryStreams(cudaStream_t stream) {
+    CHECK_CUBLAS(cublasSetStream(cublas_handle, stream));
+    CHECK_CUSPARSE(cusparseSetStream(cusparse_handle, stream));
+    CHECK_CUDNN(cudnnSetStream(cudnn_handle, stream));
+    CHECK_CUSOLVER(cusolverDnSetStream(cusolver_handle, stream ? stream : cusolver_stream));
+}
+
+bool CUDAContext::runCaptured(const std::string& key, const std::function<void()>& launches) {
+    std::lock_guard<std::mutex> lock(graph_mtx);
+    if(uncapturable_graphs.find(key) != uncapturable_graphs.end())
+        return false;
+
+    setLibraryStreams(graph_stream);
+    current_stream = graph_stream;
+    CHECK_CUDART(cudaStreamBeginCapture(graph_stream, cudaStreamCaptureModeRelaxed));
+    bool launched = true;
+    try {
+        launches();
+    }
+    catch(const std::exception&) {
+        // e.g., a synchronous copy invalidated the capture, the caller runs the launches again without capturing
+        launched = false;
+    }
+    cudaGraph_t graph = nullptr;
+    const bool captured = cudaStreamEndCapture(graph_stream, &graph) == cudaSuccess && launched;
+    current_stream = nullptr;
+    setLibraryStreams(nullptr);
+    if(!captured) {
+        // clear the error of the invalidated capture
+        cudaGetLastError();
+        if(graph)
+            cudaGraphDestroy(graph);
+        uncapturable_graphs.insert(key);
+        return false;
+    }
+
+    auto it = graph_execs.find(key);
+    bool updated = false;
+    if(it != graph_execs.end()) {
+#if CUDART_VERSION >= 12000
+        cudaGraphExecUpdateResultInfo info;
+        updated = cudaGraphExecUpdate(it->second, graph, &info) == cudaSuccess;
+#else
+        cudaGraphNode_t error_node;
+        cudaGraphExecUpdateResult result;
+        updated = cudaGraphExecUpdate(it->second, graph, &error_node, &result) == cudaSuccess;
+#endif
+        if(!updated) {
+            // the topology changed (e.g., a library chose another algorithm), the graph is instantiated anew
+            cudaGetLastError();
+            CHECK_CUDART(cudaGraphExecDestroy(it->second));
+            graph_execs.erase(it);
+        }
+    }
+    if(!updated) {
+        cudaGraphExec_t exec;
+        CHECK_CUDART(cudaGraphInstantiateWithFlags(&exec, graph, 0));
+        it = graph_execs.emplace(key, exec).first;
+    }
+    CHECK_CUDART(cudaGraphDestroy(graph));
+    CHECK_CUDART(cudaGraphLaunch(it->second, graph_stream));
+    return true;
+}
+
+CUmodule CUDAContext::getGeneratedModule(const std::string& signature, const std::function<std::string()>& source) {
+    std::lock_guard<std::mutex> lock(generated_mtx);
+    auto it = generated_modules.find(signature);
+    if(it != generated_modules.end())
+        return it->second;
+
+    const std::string src = source();
+    nvrtcProgram prog;
+    if(nvrtcCreateProgram(&prog, src.c_str(), "generated.cu", 0, nullptr, nullptr) != NVRTC_SUCCESS)
+        throw std::runtime_error("CUDAContext: failed to create the NVRTC program for " + signature);
+    const std::string arch = "--gpu-architecture=compute_" + std::to_string(device_properties.major) +
+            std::to_string(device_properties.minor);
+    const char* options[] = {arch.c_str(), "--std=c++14"};
+    if(nvrtcCompileProgram(prog, 2, options) != NVRTC_SUCCESS) {
+        size_t logSize;
+        nvrtcGetProgramLogSize(prog, &logSize);
+        std::string log(logSize, '\0');
+        nvrtcGetProgramLog(prog, log.data());
+        nvrtcDestroyProgram(&prog);
+        throw std::runtime_error("CUDAContext: failed to compile the generated kernel " + signature + ":\n" + log);
+    }
+    size_t ptxSize;
+    nvrtcGetPTXSize(prog, &ptxSize);
+    std::string ptx(ptxSize, '\0');
+    nvrtcGetPTX(prog, ptx.data());
+    nvrtcDestroyProgram(&prog);
+
+    // the module belongs to the primary context of this device, which the runtime API uses as well
+    DeviceGuard guard(device_id);
+    CUmodule module;
+    if(cuModuleLoadData(&module, ptx.c_str()) != CUDA_SUCCESS)
+        throw std::runtime_error("CUDAContext: failed to load the generated kernel " + signature);
+    generated_modules[signature] = module;
+    return module;
+}
@@ -17,17 +17,38 @@
 #pragma once
 
 #include "runtime/local/context/DaphneContext.h"
+#include "runtime/local/context/DeviceMemoryPool.h"
+#include "runtime/local/context/ResidencyManager.h"
 #include "runtime/local/kernels/CUDA/HostUtils.h"
 
+#include <atomic>
 #include <cassert>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The precision of the matrix multiplications and DNN ops on FP32 data (see `cuda_precision` in the user config).
+ *
+ * `TF32` runs them on the tensor cores with inputs rounded to TF32, `FP16` and `BF16` round the inputs to half
+ * precision and accumulate in FP32. FP64 data is not affected.
+ */
+enum class CUDAPrecision { DEFAULT, TF32, FP16, BF16 };
 
 class CUDAContext final : public IContext {
     int device_id = -1;
     size_t mem_budget = 0;
 
+    CUDAPrecision precision = CUDAPrecision::DEFAULT;
+    // the factor inputs are scaled by before rounding them to FP16/BF16
+    float loss_scale = 1;
+
     cudaDeviceProp device_properties{};
 
     cublasHandle_t cublas_handle = nullptr;
@@ -42,11 +63,49 @@ class CUDAContext final : public IContext {
 
     // preallocate 64MB
     size_t cudnn_workspace_size{};
-    void* cudnn_workspace{};
+    std::shared_ptr<std::byte> cudnn_workspace{};
+
+    // the device memory of this context is allocated from this pool, which caches released blocks
+    std::shared_ptr<DeviceMemoryPool> memory_pool;
+
+    // the data placements resident on this device, evicted (least recently used first) when the device fills up
+    std::unique_ptr<ResidencyManager> residency;
+
+    // the streams for the host-device transfers of stream-pipelined GPU tasks (not synchronizing with the default one)
+    cudaStream_t h2d_stream{};
+    cudaStream_t d2h_stream{};
+    // pinned host memory for staging these transfers, and its size per slot
+    std::vector<std::pair<void*, size_t>> pinned_buffers;
     
     std::map<size_t, std::shared_ptr<std::byte>> allocations;
-    static size_t alloc_count;
-    explicit CUDAContext(int id) : device_id(id) { }
+    // the GPU worker of the device and the main thread may allocate concurrently
+    std::mutex alloc_mtx;
+    static std::atomic<size_t> alloc_count;
+
+    // the CUDA device IDs whose memory this device can access directly
+    std::set<int> peer_devices;
+
+    // the modules compiled at runtime (e.g., the fused element-wise kernels), by the signature of their source
+    std::map<std::string, CUmodule> generated_modules;
+    std::mutex generated_mtx;
+
+    // the index (in DaphneContext::cuda_contexts) of the device the CUDA kernels of the calling thread run on
+    static thread_local size_t current_device;
+
+    // the stream the CUDA kernels of the calling thread are launched on, nullptr for the default stream
+    static thread_local cudaStream_t current_stream;
+
+    // the stream the CUDA graphs are captured from and launched on, which synchronizes with the default stream
+    cudaStream_t graph_stream{};
+    // the executable graphs of the captured launch sequences, and the sequences which cannot be captured, by key
+    std::map<std::string, cudaGraphExec_t> graph_execs;
+    std::set<std::string> uncapturable_graphs;
+    std::mutex graph_mtx;
+
+    void setLibraryStreams(cudaStream_t stream);
+
+    CUDAContext(int id, CUDAPrecision precision, float loss_scale) : device_id(id), precision(precision),
+            loss_scale(loss_scale) { }
     
     void init();
     
@@ -57,7 +116,13 @@ public:
     ~CUDAContext() = default;
 
     void destroy() override;
-    static std::unique_ptr<IContext> createCudaContext(int id);
+    static std::unique_ptr<IContext> createCudaContext(int id, CUDAPrecision precision = CUDAPrecision::DEFAULT,
+            float loss_scale = 1);
+
+    /**
+     * @brief Parses the `cuda_precision` of the user config ("default", "tf32", "fp16", or "bf16").
+     */
+    static CUDAPrecision precisionFromString(const std::string& str);
 
     [[nodiscard]] cublasHandle_t getCublasHandle() const { return cublas_handle; }
     [[nodiscard]] cusparseHandle_t getCusparseHandle() const { return cusparse_handle; }
@@ -65,7 +130,7 @@ public:
     [[nodiscard]] const cudaDeviceProp* getDeviceProperties() const { return &device_properties; }
     [[nodiscard]] cudnnHandle_t  getCUDNNHandle() const { return cudnn_handle; }
     [[nodiscard]] cusolverDnHandle_t getCUSOLVERHandle() const { return cusolver_handle; }
-    cudaStream_t getCuSolverStream() { return cusolver_stream; }
+    cudaStream_t getCuSolverStream() { return current_stream ? current_stream : cusolver_stream; }
 
     template<class T>
     [[nodiscard]] cudnnDataType_t getCUDNNDataType() const;
@@ -77,6 +142,34 @@ public:
 
     [[nodiscard]] size_t getMemBudget() const { return mem_budget; }
 
+    [[nodiscard]] int getDeviceID() const { return device_id; }
+
+    [[nodiscard]] CUDAPrecision getPrecision() const { return precision; }
+    [[nodiscard]] float getLossScale() const { return loss_scale; }
+
+    // whether FP32 matrix multiplications round their inputs to FP16/BF16 (see MixedPrecision.h)
+    [[nodiscard]] bool usesHalfPrecision() const {
+        return precision == CUDAPrecision::FP16 || precision == CUDAPrecision::BF16;
+    }
+
+    /**
+     * @brief Returns the cuDNN math type of the convolutions for the precision of this context, which permits tensor
+     * cores (and, for FP16/BF16, the conversion of FP32 data to half precision) for FP32 data.
+     */
+    [[nodiscard]] cudnnMathType_t getConvMathType() const;
+
+    /**
+     * @brief Enables direct access to the memory of another device (e.g., for cudaMemcpyPeer without a detour via the
+     * host) if the devices support it.
+     *
+     * @return Whether this device can access the memory of the other one.
+     */
+    bool enablePeerAccess(const CUDAContext* other);
+
+    [[nodiscard]] bool canAccessPeer(const CUDAContext* other) const {
+        return peer_devices.find(other->device_id) != peer_devices.end();
+    }
+
     int conv_algorithm = -1;
     cudnnPoolingDescriptor_t pooling_desc{};
     cudnnTensorDescriptor_t src_tensor_desc{}, dst_tensor_desc{}, bn_tensor_desc{};
@@ -88,8 +181,70 @@ public:
 
     static CUDAContext* get(DaphneContext* ctx, size_t id) { return dynamic_cast<CUDAContext*>(ctx->getCUDAContext(id)); }
 
-
-    std::shared_ptr<std::byte> malloc(size_t size, bool zero, size_t& id);
+    /**
+     * @brief Makes the device with the given index (in `DaphneContext::cuda_contexts`) the one the CUDA kernels called
+     * by the calling thread run on, e.g., in the GPU worker of that device. Defaults to the first device.
+     */
+    static void setCurrentDevice(DaphneContext* ctx, size_t id);
+
+    [[nodiscard]] static size_t getCurrentDevice() { return current_device; }
+
+    /**
+     * @brief Returns the stream the CUDA kernels of the calling thread are launched on, i.e., the stream of the graph
+     * being captured by `runCaptured`, or nullptr for the default stream.
+     */
+    [[nodiscard]] static cudaStream_t getComputeStream() { return current_stream; }
+
+    /**
+     * @brief Captures the kernels (and library calls) `launches` issues into a CUDA graph and launches it as one.
+     *
+     * The graph of a key is instantiated once. The graphs captured later for the same key (e.g., for the next batch of
+     * a GPU pipeline with the same shapes) update the executable graph, i.e., its buffer pointers and scalars, instead
+     * of instantiating a new one. The graph runs asynchronously on a stream that synchronizes with the default one.
+     *
+     * The capture fails if `launches` synchronizes with the device (e.g., copies data to the host), in which case
+     * nothing ran and the key is not captured again.
+     *
+     * @return Whether the launches were captured and launched. If not, the caller has to discard the results of
+     * `launches` and run them without capturing.
+     */
+    bool runCaptured(const std::string& key, const std::function<void()>& launches);
+
+    /**
+     * @brief Allocates device memory from the memory pool of this context, registered under the returned `id` until
+     * `free(id)`. The memory returns to the pool once the last reference to it is dropped.
+     *
+     * If the device memory is exhausted, resident data placements are evicted (see `ResidencyManager`) to make room.
+     */
+    std::shared_ptr<std::byte> malloc(size_t size, bool zero, size_t& id, cudaStream_t stream = nullptr);
     void free(size_t id);
+
+    /**
+     * @brief Allocates a temporary buffer (e.g., a library workspace) from the memory pool of this context, which
+     * returns to the pool once the last reference to it is dropped.
+     */
+    std::shared_ptr<std::byte> allocate(size_t size, cudaStream_t stream = nullptr);
+
+    [[nodiscard]] cudaStream_t getH2DStream() const { return h2d_stream; }
+    [[nodiscard]] cudaStream_t getD2HStream() const { return d2h_stream; }
+
+    /**
+     * @brief Returns the pinned host buffer of the given slot with at least `size` bytes, which is reallocated (without
+     * preserving its contents) if it is smaller. Must only be used by the GPU worker of this device, which has to make
+     * sure that no transfer from or to the buffer is pending.
+     */
+    void* getPinnedBuffer(size_t slot, size_t size);
+
+    [[nodiscard]] DeviceMemoryPool::Statistics getMemoryPoolStatistics() const {
+        return memory_pool->getStatistics();
+    }
+
+    [[nodiscard]] ResidencyManager* getResidencyManager() const { return residency.get(); }
+
+    /**
+     * @brief Returns the module compiled (with NVRTC, for this device) from the CUDA source `source()` generates for
+     * the given signature. Each signature is compiled once, the module is cached for the lifetime of this context.
+     */
+    CUmodule getGeneratedModule(const std::string& signature, const std::function<std::string()>& source);
     
 };
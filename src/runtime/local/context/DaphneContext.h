@@ -23,6 +23,7 @@
 #include <memory>
 
 #include "IContext.h"
+#include "RunControl.h"
 
 #ifdef USE_FPGAOPENCL
     #include "FPGAContext.h"
@@ -59,6 +60,23 @@ struct DaphneContext {
 
     std::unique_ptr<IContext> distributed_context;
 
+    /**
+     * @brief The persistent CPU worker threads of the vectorized engine, created lazily by the first vectorized
+     * pipeline and reused by all following ones.
+     */
+    std::unique_ptr<IContext> worker_pool;
+
+    /**
+     * @brief The reads of files started ahead of their use (see AsyncReads), created by the first prefetched read.
+     */
+    std::unique_ptr<IContext> async_reads;
+
+    /**
+     * @brief The cancellation, the time limit, and the progress of this run, which the vectorized pipelines check
+     * and report between their tasks, possibly shared with the host of the run (see `DaphneUserConfig::run_control`).
+     */
+    std::shared_ptr<RunControl> run_control;
+
     /**
      * @brief The user configuration (including information passed via CLI
      * arguments etc.).
@@ -69,10 +87,19 @@ struct DaphneContext {
     DaphneUserConfig& config;
 
     explicit DaphneContext(DaphneUserConfig& config) : config(config) {
-        //
+        if(config.run_control)
+            run_control = config.run_control();
+        if(!run_control)
+            run_control = std::make_shared<RunControl>();
+        // the time limit of the host (if any) takes precedence
+        if(config.timeout_seconds > 0 && !run_control->hasTimeout())
+            run_control->setTimeout(config.timeout_seconds);
     }
 
     ~DaphneContext() {
+        // finishes the distributed pipelines still running in the background first
+        if(distributed_context)
+            distributed_context->destroy();
         for (auto& ctx : cuda_contexts) {
             ctx->destroy();
         }
@@ -81,6 +108,10 @@ struct DaphneContext {
         }
         cuda_contexts.clear();
         fpga_contexts.clear();
+        if(async_reads)
+            async_reads->destroy();
+        if(worker_pool)
+            worker_pool->destroy();
 
 
     }
@@ -108,6 +139,25 @@ struct DaphneContext {
     [[nodiscard]] IContext *getDistributedContext() const {
         return distributed_context.get();
     }
+
+    [[nodiscard]] RunControl *getRunControl() const {
+        return run_control.get();
+    }
+
+    [[nodiscard]] IContext *getWorkerPool() const {
+        return worker_pool.get();
+    }
     
     [[maybe_unused]] [[nodiscard]] DaphneUserConfig getUserConfig() const { return config; }
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Returns the stream the print kernels write to, i.e., standard output or standard error unless the user config
+ * of the given context (if any) redirects them, e.g., to the response of a request to the daphne server.
+ */
+inline std::ostream & getPrintStream(bool err, const DaphneContext * ctx) {
+    if(ctx && ctx->config.print_stream)
+        if(std::ostream * os = ctx->config.print_stream(err))
+            return *os;
+    return err ? std::cerr : std::cout;
+}
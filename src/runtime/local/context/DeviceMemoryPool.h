@@ -0,0 +1,224 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A caching allocator for device memory, which keeps the blocks released by their users for later allocations
+ * of the same size class instead of returning them to the (synchronizing) device allocator.
+ *
+ * The requested sizes are rounded up to size classes, such that blocks of slightly different sizes (e.g., of the
+ * batches of a vectorized pipeline) can be reused. Released blocks are cached per stream: a block is only reused by
+ * allocations on the stream it was released on, which orders the new use after all pending work of the previous one.
+ *
+ * The pool never holds more than its budget: if an allocation would exceed it (or the device allocator fails), all
+ * cached blocks are returned to the device allocator first. Blocks in use beyond the budget are returned to the device
+ * allocator directly once released.
+ */
+class DeviceMemoryPool : public std::enable_shared_from_this<DeviceMemoryPool> {
+public:
+    // an opaque stream handle (e.g., a cudaStream_t), nullptr for the default stream
+    using Stream = void*;
+    // returns nullptr if the device allocator is out of memory
+    using AllocFunc = std::function<void*(size_t)>;
+    using FreeFunc = std::function<void(void*)>;
+
+    // blocks up to this size are rounded up to multiples of SMALL_BLOCK_ALIGNMENT
+    static constexpr size_t SMALL_BLOCK_LIMIT = 1 << 20;
+    static constexpr size_t SMALL_BLOCK_ALIGNMENT = 512;
+
+    struct Statistics {
+        // allocations served from the cache and from the device allocator
+        size_t hits = 0;
+        size_t misses = 0;
+        // the number of times the cached blocks were returned to the device allocator
+        size_t cacheReleases = 0;
+        // the memory held from the device allocator, i.e., of the blocks in use and of the cached ones
+        size_t reservedBytes = 0;
+        // the (rounded) sizes of the blocks in use and the sizes they were requested with
+        size_t inUseBytes = 0;
+        size_t requestedBytes = 0;
+        size_t cachedBytes = 0;
+        size_t numCachedBlocks = 0;
+
+        [[nodiscard]] double getHitRate() const {
+            return hits + misses ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+        }
+
+        /**
+         * @brief Returns the share of the reserved memory not holding requested data, i.e., the rounding to size
+         * classes within the blocks in use and the cached blocks.
+         */
+        [[nodiscard]] double getFragmentation() const {
+            return reservedBytes ? 1.0 - static_cast<double>(requestedBytes) / static_cast<double>(reservedBytes)
+                    : 0.0;
+        }
+    };
+
+private:
+    struct Block {
+        size_t size;
+        size_t requested;
+        Stream stream;
+    };
+
+    const size_t _budget;
+    const AllocFunc _alloc;
+    const FreeFunc _free;
+
+    mutable std::mutex _mtx;
+    // the cached blocks per stream and size class
+    std::map<Stream, std::unordered_map<size_t, std::vector<std::byte*>>> _cached;
+    std::unordered_map<std::byte*, Block> _inUse;
+    Statistics _stats;
+
+    DeviceMemoryPool(size_t budget, AllocFunc alloc, FreeFunc free) : _budget(budget), _alloc(std::move(alloc)),
+            _free(std::move(free)) {}
+
+    void releaseCachedLocked() {
+        if(_stats.numCachedBlocks == 0)
+            return;
+        for(auto& [stream, sizeClasses] : _cached)
+            for(auto& [size, blocks] : sizeClasses)
+                for(auto* ptr : blocks) {
+                    _free(ptr);
+                    _stats.reservedBytes -= size;
+                }
+        _cached.clear();
+        _stats.cachedBytes = 0;
+        _stats.numCachedBlocks = 0;
+        _stats.cacheReleases++;
+    }
+
+    void deallocate(std::byte* ptr) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto it = _inUse.find(ptr);
+        // called by the deleters of the blocks, which must not throw
+        if(it == _inUse.end())
+            return;
+        const Block block = it->second;
+        _inUse.erase(it);
+        _stats.inUseBytes -= block.size;
+        _stats.requestedBytes -= block.requested;
+        if(_stats.reservedBytes > _budget) {
+            _free(ptr);
+            _stats.reservedBytes -= block.size;
+            return;
+        }
+        _cached[block.stream][block.size].push_back(ptr);
+        _stats.cachedBytes += block.size;
+        _stats.numCachedBlocks++;
+    }
+
+public:
+    DeviceMemoryPool(const DeviceMemoryPool&) = delete;
+    DeviceMemoryPool& operator=(const DeviceMemoryPool&) = delete;
+
+    ~DeviceMemoryPool() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        releaseCachedLocked();
+    }
+
+    /**
+     * @param budget The maximum number of bytes the pool holds from the device allocator for caching.
+     * @param alloc Allocates device memory, returns nullptr if out of memory.
+     * @param free Returns device memory allocated by `alloc`.
+     */
+    static std::shared_ptr<DeviceMemoryPool> create(size_t budget, AllocFunc alloc, FreeFunc free) {
+        return std::shared_ptr<DeviceMemoryPool>(new DeviceMemoryPool(budget, std::move(alloc), std::move(free)));
+    }
+
+    /**
+     * @brief Returns the size class of the given size: multiples of `SMALL_BLOCK_ALIGNMENT` for small blocks, and four
+     * classes per power of two for larger ones, such that the rounding wastes less than a quarter of a block.
+     */
+    static size_t roundSize(size_t size) {
+        if(size <= SMALL_BLOCK_LIMIT)
+            return std::max<size_t>(1, (size + SMALL_BLOCK_ALIGNMENT - 1) / SMALL_BLOCK_ALIGNMENT)
+                    * SMALL_BLOCK_ALIGNMENT;
+        size_t pow = SMALL_BLOCK_LIMIT;
+        while(pow < size / 2 + size % 2)
+            pow *= 2;
+        const size_t step = pow / 4;
+        return (size + step - 1) / step * step;
+    }
+
+    /**
+     * @brief Allocates a block of at least `size` bytes for use on the given stream. The block returns to the pool
+     * once the last reference to it is dropped, which also keeps the pool alive until then.
+     */
+    std::shared_ptr<std::byte> allocate(size_t size, Stream stream = nullptr) {
+        const size_t rounded = roundSize(size);
+        std::byte* ptr = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            auto streamIt = _cached.find(stream);
+            if(streamIt != _cached.end()) {
+                auto classIt = streamIt->second.find(rounded);
+                if(classIt != streamIt->second.end() && !classIt->second.empty()) {
+                    ptr = classIt->second.back();
+                    classIt->second.pop_back();
+                    _stats.cachedBytes -= rounded;
+                    _stats.numCachedBlocks--;
+                    _stats.hits++;
+                }
+            }
+            if(!ptr) {
+                _stats.misses++;
+                if(_stats.reservedBytes + rounded > _budget)
+                    releaseCachedLocked();
+                ptr = static_cast<std::byte*>(_alloc(rounded));
+                if(!ptr && _stats.numCachedBlocks) {
+                    releaseCachedLocked();
+                    ptr = static_cast<std::byte*>(_alloc(rounded));
+                }
+                if(!ptr)
+                    throw std::runtime_error("DeviceMemoryPool: out of device memory allocating " +
+                            std::to_string(rounded) + " bytes");
+                _stats.reservedBytes += rounded;
+            }
+            _inUse.emplace(ptr, Block{rounded, size, stream});
+            _stats.inUseBytes += rounded;
+            _stats.requestedBytes += size;
+        }
+        return std::shared_ptr<std::byte>(ptr, [pool = shared_from_this()](std::byte* p) { pool->deallocate(p); });
+    }
+
+    /**
+     * @brief Returns all cached blocks to the device allocator, e.g., before handing the device memory to another
+     * library.
+     */
+    void releaseCached() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        releaseCachedLocked();
+    }
+
+    [[nodiscard]] Statistics getStatistics() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _stats;
+    }
+};
@@ -17,7 +17,30 @@
 #pragma once
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
+#include <runtime/local/datastructures/AllocationDescriptorMPI.h>
+#include <runtime/local/datastructures/DataPlacement.h>
+#include <runtime/local/datastructures/DistributedGarbage.h>
+#include <runtime/local/datastructures/Range.h>
+#include <runtime/local/datastructures/Structure.h>
+#include <runtime/local/vectorized/LoadPartitioning.h>
+#include <runtime/distributed/proto/Tracing.h>
+#ifdef USE_MPI
+#include <runtime/distributed/mpi/MPIHelper.h>
+#endif
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 #include <cstdlib>
 #include <string>
@@ -27,9 +50,97 @@
 // TODO: Separate implementation in a .cpp file?
 class DistributedContext final : public IContext {
 private:
+    // the distributed backend, DIST_GRPC or DIST_MPI, whose placements the data objects have
+    ALLOCATION_TYPE backend;
+    // the addresses of the workers with gRPC, or their ranks with MPI
     std::vector<std::string> workers;
+    // the IDs of the fragments sent to each worker, which are sent without their code from then on
+    std::map<std::string, std::set<std::string>> sentFragments;
+    // the measured throughput of the workers by their index, with one slot per worker
+    std::unique_ptr<ChunkFeedback> throughput;
+    // the shares of the rows of the workers when matrices are split by rows, or empty for equal shares
+    std::vector<double> rowShares;
+    // the first rows of the workers (and the number of rows at the end) by the number of rows of the matrices whose
+    // rows are split by the non-zeros of a sparse matrix (see `balanceNonZeros`)
+    std::map<size_t, std::vector<size_t>> nonZeroRowStarts;
+    // the numbers of rows of the matrices split so far, whose partitions are not changed by `balanceNonZeros`
+    mutable std::set<size_t> splitNumRows;
+    // the workers excluded after they failed, whose placements are restored at the others (see `excludeWorker`)
+    std::set<std::string> failedWorkers;
+
+    // the failure detection by heartbeats in the background (see `enableFailureDetection`), which only marks the
+    // workers as suspected, such that the program excludes them between pipelines
+    std::function<bool(const std::string &)> ping;
+    std::mutex heartbeatMutex;
+    std::condition_variable heartbeatCv;
+    std::thread heartbeatThread;
+    bool heartbeatStopped = false;
+    std::vector<std::string> monitoredWorkers;
+    std::set<std::string> suspectedWorkers;
+
+    // the distributed pipelines submitted to run in the background, one after the other (see `submit`)
+    std::mutex asyncMutex;
+    std::condition_variable asyncCv;
+    std::deque<std::function<void()>> asyncQueue;
+    std::thread asyncThread;
+    bool asyncStopped = false;
+    // the exception of the first failed pipeline, which fails all later ones
+    std::exception_ptr asyncError;
+    // the last pipeline using each data object, which is only accessed by the thread of the program
+    std::map<const Structure *, std::shared_future<void>> pending;
+
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(asyncMutex);
+                asyncCv.wait(lock, [this]() { return asyncStopped || !asyncQueue.empty(); });
+                if (asyncQueue.empty())
+                    return;
+                job = std::move(asyncQueue.front());
+                asyncQueue.pop_front();
+            }
+            job();
+        }
+    };
+    void heartbeat(std::chrono::milliseconds interval) {
+        std::map<std::string, size_t> missed;
+        std::unique_lock<std::mutex> lock(heartbeatMutex);
+        while (!heartbeatCv.wait_for(lock, interval, [this]() { return heartbeatStopped; })) {
+            auto monitored = monitoredWorkers;
+            lock.unlock();
+            std::vector<std::string> failed;
+            for (const auto &worker : monitored) {
+                if (ping(worker))
+                    missed[worker] = 0;
+                else if (++missed[worker] == HEARTBEAT_MISSES)
+                    failed.push_back(worker);
+            }
+            lock.lock();
+            suspectedWorkers.insert(failed.begin(), failed.end());
+        }
+    };
 public:
-    DistributedContext() {
+    explicit DistributedContext(ALLOCATION_TYPE backend = ALLOCATION_TYPE::DIST_GRPC) : backend(backend) {
+        if (backend == ALLOCATION_TYPE::DIST_MPI) {
+#ifdef USE_MPI
+            // The coordinator is rank 0 and the workers are all other ranks, which are started with it, e.g., by
+            // mpirun or srun.
+            MPIHelper::init();
+            if (MPIHelper::getRank() != MPIHelper::COORDINATOR)
+                throw std::runtime_error("the coordinator of the MPI backend must be rank 0");
+            for (int rank = 1; rank < MPIHelper::getSize(); rank++)
+                workers.push_back(std::to_string(rank));
+            if (workers.empty())
+                throw std::runtime_error("the MPI backend needs at least one worker rank besides the coordinator");
+            throughput = std::make_unique<ChunkFeedback>(workers.size());
+            return;
+#else
+            throw std::runtime_error("the MPI backend of the distributed runtime requires Daphne to be built with MPI");
+#endif
+        }
+        if (backend != ALLOCATION_TYPE::DIST_GRPC)
+            throw std::runtime_error("unsupported distributed backend");
 
         // TODO: Get the list of distributed workers from daphne user config/cli arguments and
         // keep environmental variables optional.
@@ -48,16 +159,56 @@ public:
             workersStr.erase(0, pos + delimiter.size());
         }
         workers.push_back(workersStr);
+        throughput = std::make_unique<ChunkFeedback>(workers.size());
     }
-    ~DistributedContext() = default;
+    ~DistributedContext() override {
+        destroy();
+    };
 
-    static std::unique_ptr<IContext> createDistributedContext() {
-        auto ctx = std::unique_ptr<DistributedContext>(new DistributedContext());
+    static std::unique_ptr<IContext> createDistributedContext(ALLOCATION_TYPE backend = ALLOCATION_TYPE::DIST_GRPC) {
+        auto ctx = std::unique_ptr<DistributedContext>(new DistributedContext(backend));
         return ctx;
     };
 
+    /**
+     * @brief Parses the distributed backend of the user config, "gRPC" or "MPI".
+     */
+    static ALLOCATION_TYPE parseBackend(const std::string &backend) {
+        if (backend == "gRPC" || backend == "grpc")
+            return ALLOCATION_TYPE::DIST_GRPC;
+        if (backend == "MPI" || backend == "mpi")
+            return ALLOCATION_TYPE::DIST_MPI;
+        throw std::runtime_error("unknown distributed backend \"" + backend + "\", which must be gRPC or MPI");
+    };
+
     void destroy() override {
-        // Clean up
+        {
+            std::lock_guard<std::mutex> lock(heartbeatMutex);
+            heartbeatStopped = true;
+            heartbeatCv.notify_all();
+        }
+        if (heartbeatThread.joinable())
+            heartbeatThread.join();
+        {
+            std::lock_guard<std::mutex> lock(asyncMutex);
+            if (asyncStopped)
+                return;
+            // the pipelines submitted so far still run, since the program may have written their results
+            asyncStopped = true;
+            asyncCv.notify_all();
+        }
+        if (asyncThread.joinable())
+            asyncThread.join();
+        // nobody waits for the failed pipelines anymore
+        pending.clear();
+        if (backend == ALLOCATION_TYPE::DIST_GRPC) {
+            DistributedGarbage::get().shutdown();
+            Tracing::get().endTrace("daphne");
+        }
+#ifdef USE_MPI
+        if (backend == ALLOCATION_TYPE::DIST_MPI)
+            MPIHelper::shutdown();
+#endif
     };
 
     static DistributedContext* get(DaphneContext *ctx) { return dynamic_cast<DistributedContext*>(ctx->getDistributedContext()); };
@@ -65,4 +216,416 @@ public:
     std::vector<std::string> getWorkers(){
         return workers;
     };
-};
\ No newline at end of file
+
+    ALLOCATION_TYPE getBackend() const {
+        return backend;
+    };
+
+    bool isFragmentSent(const std::string &worker, const std::string &fragmentId) {
+        auto it = sentFragments.find(worker);
+        return it != sentFragments.end() && it->second.count(fragmentId);
+    };
+
+    void setFragmentSent(const std::string &worker, const std::string &fragmentId) {
+        sentFragments[worker].insert(fragmentId);
+    };
+
+    // ------------------------------------------------------------------------
+    // Placement of the data objects at the workers
+    // ------------------------------------------------------------------------
+    // The placements are kept in the meta data of the data objects, one per worker and range, such that a matrix
+    // may be both split by rows and broadcast. A range placed at a worker is never sent to it again, e.g., the
+    // matrix of an iterative algorithm is distributed only once and the results split by rows stay at the workers
+    // as inputs of the next pipelines.
+
+    /**
+     * @brief The rows of a matrix of the given shape, which the worker of the given index holds if the matrix is
+     * split by rows. All matrices are split alike, such that the partitions of inputs of the same number of rows,
+     * e.g., of element-wise ops or joins, and of the results combined by rows are co-located.
+     */
+    Range getRowPartition(size_t numRows, size_t numCols, size_t workerIx) const {
+        Range range;
+        range.c_start = 0;
+        range.c_len = numCols;
+        splitNumRows.insert(numRows);
+        auto nonZeroIt = nonZeroRowStarts.find(numRows);
+        if (rowShares.empty() && nonZeroIt != nonZeroRowStarts.end() && nonZeroIt->second.size() == workers.size() + 1) {
+            range.r_start = nonZeroIt->second[workerIx];
+            range.r_len = nonZeroIt->second[workerIx + 1] - range.r_start;
+        }
+        else if (rowShares.empty()) {
+            const size_t k = numRows / workers.size();
+            const size_t m = numRows % workers.size();
+            range.r_start = workerIx * k + std::min(workerIx, m);
+            range.r_len = ((workerIx + 1) * k + std::min(workerIx + 1, m)) - range.r_start;
+        }
+        else {
+            double sharesBefore = 0;
+            for (size_t i = 0; i < workerIx; i++)
+                sharesBefore += rowShares[i];
+            range.r_start = std::llround(numRows * sharesBefore);
+            const size_t rowEnd = workerIx + 1 == workers.size()
+                    ? numRows : std::llround(numRows * (sharesBefore + rowShares[workerIx]));
+            range.r_len = rowEnd - range.r_start;
+        }
+        return range;
+    };
+
+    /**
+     * @brief Splits the matrices of the given number of rows, such that each worker holds about the same number of
+     * non-zeros of the sparse matrix of the given row offsets, instead of the same number of rows. Skewed sparse
+     * matrices, e.g., graphs of a power-law degree distribution, would otherwise leave the workers of the dense rows
+     * computing while the others wait. Matrices of this number of rows that were split already keep their
+     * partitions, i.e., the first sparse matrix of a number of rows decides, and the shares of `rebalance` take
+     * precedence.
+     *
+     * @return Whether the partitions changed
+     */
+    bool balanceNonZeros(size_t numRows, const size_t *rowOffsets) {
+        if (workers.size() < 2 || numRows < workers.size() || splitNumRows.count(numRows))
+            return false;
+        const size_t base = rowOffsets[0];
+        const size_t numNonZeros = rowOffsets[numRows] - base;
+        std::vector<size_t> starts = {0};
+        for (size_t i = 1; i < workers.size(); i++) {
+            const size_t target = base + numNonZeros * i / workers.size();
+            size_t start = std::lower_bound(rowOffsets, rowOffsets + numRows + 1, target) - rowOffsets;
+            // each worker keeps at least one row
+            start = std::max(start, starts.back() + 1);
+            start = std::min(start, numRows - (workers.size() - i));
+            starts.push_back(start);
+        }
+        starts.push_back(numRows);
+        nonZeroRowStarts[numRows] = std::move(starts);
+        return true;
+    };
+
+    // ------------------------------------------------------------------------
+    // Load balancing
+    // ------------------------------------------------------------------------
+
+    // the factor by which the predicted time of the slowest worker must exceed the mean to rebalance the shares
+    static constexpr double REBALANCE_IMBALANCE = 1.2;
+
+    /**
+     * @brief Records that the worker of the given index computed a task on the given number of rows in the given
+     * time (including the communication).
+     */
+    void reportTask(size_t workerIx, size_t numRows, double seconds) {
+        throughput->report(workerIx, numRows, seconds);
+    };
+
+    /**
+     * @brief The measured number of rows per second of the worker of the given index, or 0 if not measured yet.
+     */
+    double getThroughput(size_t workerIx) const {
+        return throughput->getSlotRate(workerIx);
+    };
+
+    /**
+     * @brief Makes the shares of the rows of the workers proportional to their measured throughput (like the
+     * adaptive weighted factoring of `LoadPartitioning` among the threads of a worker), if the predicted time of the
+     * slowest worker exceeds the mean by more than `REBALANCE_IMBALANCE`. The partitions placed with the previous
+     * shares are sent again when they are needed, so the shares only change between pipelines.
+     *
+     * @return Whether the shares changed
+     */
+    bool rebalance() {
+        std::vector<double> rates;
+        double sumRates = 0;
+        for (size_t i = 0; i < workers.size(); i++) {
+            rates.push_back(getThroughput(i));
+            if (rates.back() <= 0)
+                return false;
+            sumRates += rates.back();
+        }
+        double maxTime = 0, sumTimes = 0;
+        for (size_t i = 0; i < workers.size(); i++) {
+            const double share = rowShares.empty() ? 1.0 / workers.size() : rowShares[i];
+            maxTime = std::max(maxTime, share / rates[i]);
+            sumTimes += share / rates[i];
+        }
+        if (maxTime <= REBALANCE_IMBALANCE * sumTimes / workers.size())
+            return false;
+        rowShares.clear();
+        for (auto rate : rates)
+            rowShares.push_back(rate / sumRates);
+        return true;
+    };
+
+    /**
+     * @brief Whether an input of a pipeline split in the given way is broadcast, i.e., each worker holds all of it.
+     */
+    static bool isBroadcast(mlir::daphne::VectorSplit splitMethod, const Structure *input) {
+        return splitMethod == mlir::daphne::VectorSplit::NONE
+                || (splitMethod == mlir::daphne::VectorSplit::ROWS && input->getNumRows() == 1);
+    };
+
+    /**
+     * @brief The range of an input of a pipeline split in the given way, which the worker of the given index holds.
+     */
+    Range getInputRange(mlir::daphne::VectorSplit splitMethod, const Structure *input, size_t workerIx) const {
+        if (isBroadcast(splitMethod, input))
+            return Range(0, 0, input->getNumRows(), input->getNumCols());
+        return getRowPartition(input->getNumRows(), input->getNumCols(), workerIx);
+    };
+
+    /**
+     * @brief The range of an output of a pipeline combined in the given way, which the worker of the given index
+     * computes. Results combined by rows (columns) are split like the rows of the inputs, such that they can be inputs
+     * of the next pipelines in place, and each worker holds a partial result of the whole shape of the results summed
+     * up.
+     */
+    Range getOutputRange(mlir::daphne::VectorCombine combine, const Structure *output, size_t workerIx) const {
+        if (combine == mlir::daphne::VectorCombine::ROWS)
+            return getRowPartition(output->getNumRows(), output->getNumCols(), workerIx);
+        if (combine == mlir::daphne::VectorCombine::COLS) {
+            // the columns follow the rows of the split inputs, e.g., of `B` in `A @ t(B)`
+            const Range cols = getRowPartition(output->getNumCols(), output->getNumRows(), workerIx);
+            return Range(0, cols.r_start, output->getNumRows(), cols.r_len);
+        }
+        return Range(0, 0, output->getNumRows(), output->getNumCols());
+    };
+
+    /**
+     * @brief The data at the worker of a placement of either backend.
+     */
+    static DistributedData getDistributedData(const DataPlacement *dp) {
+        if (dp->allocation->getType() == ALLOCATION_TYPE::DIST_MPI)
+            return dynamic_cast<AllocationDescriptorMPI&>(*(dp->allocation)).getDistributedData();
+        return dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
+    };
+
+    static void updateDistributedData(DataPlacement *dp, const DistributedData &data) {
+        if (dp->allocation->getType() == ALLOCATION_TYPE::DIST_MPI)
+            dynamic_cast<AllocationDescriptorMPI&>(*(dp->allocation)).updateDistributedData(data);
+        else
+            dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).updateDistributedData(data);
+    };
+
+    /**
+     * @brief Returns the placement of the given range of the data object at the given worker of the given backend,
+     * or `nullptr` if there is none.
+     */
+    static DataPlacement *findPlacement(const Structure *obj, const std::string &worker, const Range &range,
+                                        ALLOCATION_TYPE type = ALLOCATION_TYPE::DIST_GRPC) {
+        for (auto &dp : *obj->getMetaDataObject().getDataPlacementByType(type))
+            if (dp->allocation->getLocation() == worker && dp->range && *dp->range == range)
+                return dp.get();
+        return nullptr;
+    };
+
+    /**
+     * @brief Returns the placement of the given range of the data object at the given worker, which is added (not
+     * placed yet) if there is none.
+     */
+    static DataPlacement *getOrAddPlacement(const Structure *obj, const std::string &worker, Range range,
+                                            DistributedIndex ix, DaphneContext *dctx) {
+        const ALLOCATION_TYPE type = get(dctx)->getBackend();
+        if (auto dp = findPlacement(obj, worker, range, type))
+            return dp;
+        DistributedData data;
+        data.ix = ix;
+        if (type == ALLOCATION_TYPE::DIST_MPI) {
+            AllocationDescriptorMPI allocationDescriptor(dctx, std::stoi(worker), data);
+            return obj->getMetaDataObject().addDataPlacement(&allocationDescriptor, &range);
+        }
+        AllocationDescriptorGRPC allocationDescriptor(dctx, worker, data);
+        return obj->getMetaDataObject().addDataPlacement(&allocationDescriptor, &range);
+    };
+
+    /**
+     * @brief The file the workers read the data object from themselves, such that the coordinator does not hold its
+     * values and other ranges are read from the file, too, or empty if the coordinator holds the data object.
+     */
+    static std::string getSourceFile(const Structure *obj) {
+        for (auto &dp : *obj->getMetaDataObject().getDataPlacementByType(ALLOCATION_TYPE::DIST_GRPC)) {
+            auto data = dynamic_cast<AllocationDescriptorGRPC&>(*(dp->allocation)).getDistributedData();
+            if (!data.sourceFile.empty())
+                return data.sourceFile;
+        }
+        return "";
+    };
+
+    /**
+     * @brief Whether the worker of the placement holds its range of the data object, such that it need not be sent
+     * again. The partial results of aggregations (combined by `VectorCombine::ADD`) do not count.
+     */
+    static bool isPlaced(const DataPlacement *dp) {
+        auto data = getDistributedData(dp);
+        return data.isPlacedAtWorker && data.vectorCombine != mlir::daphne::VectorCombine::ADD;
+    };
+
+    // ------------------------------------------------------------------------
+    // Fault tolerance
+    // ------------------------------------------------------------------------
+    // A failed worker is excluded for the rest of the program and the pipeline it failed runs again at the other
+    // workers (see DistributedWrapper). Its placements are restored there by their lineage (`DistributedOrigin`):
+    // the coordinator holds the values of all data objects it sent and collects the results of all pipelines, so
+    // they are sent again, and the partitions the workers read themselves are read again from their file.
+
+    // the number of heartbeats a worker misses in a row before it is suspected to have failed
+    static constexpr size_t HEARTBEAT_MISSES = 3;
+
+    /**
+     * @brief Enables the detection of failed workers by the given function, which returns whether a worker answers,
+     * and pings the workers in the given interval in the background (none if 0), such that a failed worker is
+     * excluded before the next pipeline instead of failing it.
+     */
+    void enableFailureDetection(std::function<bool(const std::string &)> pingFn, std::chrono::milliseconds interval) {
+        std::lock_guard<std::mutex> lock(heartbeatMutex);
+        ping = std::move(pingFn);
+        monitoredWorkers = workers;
+        if (interval.count() > 0 && !heartbeatThread.joinable() && !heartbeatStopped)
+            heartbeatThread = std::thread(&DistributedContext::heartbeat, this, interval);
+    };
+
+    /**
+     * @brief Returns the workers suspected to have failed by the heartbeats, and with `pingNow` (e.g., after a
+     * pipeline failed) also those which do not answer a ping right away.
+     */
+    std::vector<std::string> detectFailedWorkers(bool pingNow) {
+        std::set<std::string> failed;
+        {
+            std::lock_guard<std::mutex> lock(heartbeatMutex);
+            if (!ping)
+                return {};
+            failed.swap(suspectedWorkers);
+        }
+        if (pingNow)
+            for (const auto &worker : workers)
+                if (!ping(worker))
+                    failed.insert(worker);
+        std::vector<std::string> res;
+        for (const auto &worker : workers)
+            if (failed.count(worker))
+                res.push_back(worker);
+        return res;
+    };
+
+    /**
+     * @brief Excludes the given worker from the distributed pipelines for the rest of the program. The rows are
+     * split among the others in equal shares again.
+     */
+    void excludeWorker(const std::string &worker) {
+        auto it = std::find(workers.begin(), workers.end(), worker);
+        if (it == workers.end())
+            return;
+        if (workers.size() == 1)
+            throw std::runtime_error("the last distributed worker " + worker + " failed");
+        workers.erase(it);
+        failedWorkers.insert(worker);
+        sentFragments.erase(worker);
+        rowShares.clear();
+        nonZeroRowStarts.clear();
+        splitNumRows.clear();
+        throughput = std::make_unique<ChunkFeedback>(workers.size());
+        std::lock_guard<std::mutex> lock(heartbeatMutex);
+        monitoredWorkers = workers;
+    };
+
+    size_t getNumFailedWorkers() const {
+        return failedWorkers.size();
+    };
+
+    /**
+     * @brief Restores the placements of the data object at the failed workers by their lineage: those read from a
+     * file are kept as not placed (they hold the name of the file, which the partitions are read from again), and
+     * all others are removed, since the coordinator holds their values.
+     */
+    void dropLostPlacements(const Structure *obj) const {
+        if (failedWorkers.empty())
+            return;
+        auto &mdo = obj->getMetaDataObject();
+        std::vector<size_t> lostIds;
+        for (auto &dp : *mdo.getDataPlacementByType(backend)) {
+            if (!failedWorkers.count(dp->allocation->getLocation()))
+                continue;
+            auto data = getDistributedData(dp.get());
+            if (data.origin == DistributedOrigin::READ) {
+                data.isPlacedAtWorker = false;
+                updateDistributedData(dp.get(), data);
+            }
+            else
+                lostIds.push_back(dp->dp_id);
+        }
+        for (size_t id : lostIds)
+            mdo.removeDataPlacement(id);
+    };
+
+    // ------------------------------------------------------------------------
+    // Asynchronous execution
+    // ------------------------------------------------------------------------
+    // The distributed pipelines may run in the background, while the coordinator goes on with the program, such that
+    // the local operations overlap with the distributed ones. They run one after the other on a single thread in
+    // program order, so the placements in the meta data of the data objects are only changed by one thread at a time.
+    // The compiler inserts a `DistributedWaitOp` before the other operations using a data object of a pipeline.
+
+    /**
+     * @brief Runs the given distributed pipeline in the background after the ones submitted before, using the
+     * given data objects, which must stay alive until it has finished.
+     *
+     * Once a pipeline fails, all later ones fail with its exception, too, which the next wait for any of them
+     * rethrows.
+     */
+    void submit(std::function<void()> job, const std::vector<const Structure *> &objs) {
+        auto task = std::make_shared<std::packaged_task<void()>>([this, job = std::move(job)]() {
+            if (asyncError)
+                std::rethrow_exception(asyncError);
+            try {
+                job();
+            }
+            catch (...) {
+                asyncError = std::current_exception();
+                throw;
+            }
+        });
+        auto result = task->get_future().share();
+        // the pipelines that finished successfully need no waiting anymore
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
+            try {
+                it->second.get();
+                it = pending.erase(it);
+            }
+            catch (...) {
+                ++it;
+            }
+        }
+        for (auto obj : objs)
+            pending[obj] = result;
+
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        if (asyncStopped)
+            throw std::runtime_error("distributed pipeline submitted after the context was destroyed");
+        if (!asyncThread.joinable())
+            asyncThread = std::thread(&DistributedContext::work, this);
+        asyncQueue.emplace_back([task]() { (*task)(); });
+        asyncCv.notify_one();
+    };
+
+    /**
+     * @brief Waits for the last pipeline submitted with the given data object, if any, rethrowing its exception.
+     */
+    void waitFor(const Structure *obj) {
+        auto it = pending.find(obj);
+        if (it == pending.end())
+            return;
+        auto result = it->second;
+        pending.erase(it);
+        result.get();
+    };
+
+    /**
+     * @brief Waits for all pipelines submitted so far, rethrowing the exception of a failed one.
+     */
+    void waitAll() {
+        auto all = std::move(pending);
+        pending.clear();
+        for (auto &p : all)
+            p.second.get();
+    };
+};
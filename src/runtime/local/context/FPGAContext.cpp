@@ -17,6 +17,9 @@
 #include "AOCLUtils/aocl_utils.h"
 #include "CL/opencl.h"
 #include "runtime/local/context/FPGAContext.h"
+
+#include <stdexcept>
+#include <vector>
 //#include <cstdio>
 //#include <cstdlib>
 //#include <cstring>
@@ -45,6 +48,114 @@ void FPGAContext::destroy() {
 #ifndef NDEBUG
     std::cout << "Destroying FPGA context..." << std::endl;
 #endif
+    for (auto & [buf, event] : pending)
+        clReleaseEvent(event);
+    pending.clear();
+    for (auto & [name, kernel] : kernels)
+        clReleaseKernel(kernel);
+    kernels.clear();
+    if (program)
+        clReleaseProgram(program);
+    program = NULL;
+    for (cl_command_queue & queue : queues) {
+        if (queue) {
+            clFinish(queue);
+            clReleaseCommandQueue(queue);
+        }
+        queue = NULL;
+    }
+    if (context)
+        clReleaseContext(context);
+    context = NULL;
+    free(platforms);
+    platforms = NULL;
+}
+
+void FPGAContext::loadBitstream() {
+    cl_int status;
+    const char *aocx_file = getenv("BITSTREAM");
+    FILE *fp = aocx_file ? fopen(aocx_file, "rb") : NULL;
+    if (fp == NULL)
+        throw std::runtime_error("FPGAContext: failed to open the AOCX file given by the environment variable BITSTREAM");
+    fseek(fp, 0, SEEK_END);
+    size_t binary_length = ftell(fp);
+    std::vector<unsigned char> binary(binary_length);
+    rewind(fp);
+    if (fread(binary.data(), binary_length, 1, fp) == 0) {
+        fclose(fp);
+        throw std::runtime_error("FPGAContext: failed to read from the AOCX file");
+    }
+    fclose(fp);
+
+    const unsigned char *binaryPtr = binary.data();
+    program = clCreateProgramWithBinary(
+        context,
+        1,
+        devices,
+        &binary_length,
+        &binaryPtr,
+        &status,
+        NULL);
+    CHECK(status);
+    status = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
+    CHECK(status);
+}
+
+cl_kernel FPGAContext::getKernel(const std::string & name) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = kernels.find(name);
+    if (it != kernels.end())
+        return it->second;
+    if (!program)
+        loadBitstream();
+    cl_int status;
+    cl_kernel kernel = clCreateKernel(program, name.c_str(), &status);
+    if (status != CL_SUCCESS)
+        throw std::runtime_error("FPGAContext: the bitstream has no kernel " + name);
+    kernels[name] = kernel;
+    return kernel;
+}
+
+cl_event FPGAContext::getPending(cl_mem buf) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = pending.find(buf);
+    return it == pending.end() ? NULL : it->second;
+}
+
+void FPGAContext::setPending(cl_mem buf, cl_event event) {
+    std::lock_guard<std::mutex> lock(mtx);
+    clRetainEvent(event);
+    auto it = pending.find(buf);
+    if (it != pending.end()) {
+        clReleaseEvent(it->second);
+        it->second = event;
+    }
+    else
+        pending[buf] = event;
+}
+
+void FPGAContext::waitFor(cl_mem buf) {
+    cl_event event = NULL;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = pending.find(buf);
+        if (it == pending.end())
+            return;
+        event = it->second;
+        pending.erase(it);
+    }
+    cl_int status = clWaitForEvents(1, &event);
+    clReleaseEvent(event);
+    CHECK(status);
+}
+
+void FPGAContext::forget(cl_mem buf) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = pending.find(buf);
+    if (it != pending.end()) {
+        clReleaseEvent(it->second);
+        pending.erase(it);
+    }
 }
 
 void FPGAContext::init() {
@@ -158,6 +269,15 @@ void FPGAContext::init() {
         NULL,
         &status);
     CHECK(status);
+
+    for (cl_command_queue & queue : queues) {
+        queue = clCreateCommandQueue(
+            context,
+            devices[0],
+            CL_QUEUE_PROFILING_ENABLE,
+            &status);
+        CHECK(status);
+    }
 }
 
 std::unique_ptr<IContext> FPGAContext::createFpgaContext(int device_id) {
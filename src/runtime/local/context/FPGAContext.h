@@ -24,7 +24,10 @@
 #include <CL/opencl.h>
 #include <cassert>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 
 class FPGAContext : public IContext {
     int device_id = -1;
@@ -42,9 +45,12 @@ public:
     cl_uint numDevices = 0;
     cl_context context = NULL;
 
-
-
-
+    // The command queues of the kernels of a bitstream, which run concurrently
+    // (e.g., the loaders, feeders, and unloader of the systolic array of the
+    // sgemm bitstream), and of the transfers between host and device memory,
+    // such that transfers overlap each other and the computation.
+    static constexpr int NUM_KERNEL_QUEUES = 6;
+    static constexpr int NUM_TRANSFER_QUEUES = 2;
 
     FPGAContext() = delete;
     FPGAContext(const FPGAContext&) = delete;
@@ -54,6 +60,28 @@ public:
     void destroy() override;
     static std::unique_ptr<IContext> createFpgaContext(int id);
 
+    [[nodiscard]] cl_command_queue getKernelQueue(int i) const { return queues[i]; }
+    [[nodiscard]] cl_command_queue getTransferQueue(int i) const { return queues[NUM_KERNEL_QUEUES + i]; }
+
+    /**
+     * @brief Returns the kernel of the given name in the bitstream (the
+     * environment variable `BITSTREAM`), which is loaded once.
+     */
+    cl_kernel getKernel(const std::string & name);
+
+    /**
+     * @brief Returns the event of the last command enqueued on a buffer in
+     * device memory, which later commands on the buffer must wait for, or
+     * `NULL` if there is none.
+     */
+    cl_event getPending(cl_mem buf);
+    void setPending(cl_mem buf, cl_event event);
+    /**
+     * @brief Blocks until the last command enqueued on a buffer has finished.
+     */
+    void waitFor(cl_mem buf);
+    void forget(cl_mem buf);
+
 //    [[nodiscard]] cublasHandle_t getCublasHandle() const { return cublas_handle; }
 //    [[nodiscard]] cusparseHandle_t getCusparseHandle() const { return cusparse_handle; }
 
@@ -64,5 +92,12 @@ public:
 
 
 private:
+    cl_command_queue queues[NUM_KERNEL_QUEUES + NUM_TRANSFER_QUEUES] = {};
+    cl_program program = NULL;
+    std::map<std::string, cl_kernel> kernels;
+    std::map<cl_mem, cl_event> pending;
+    std::mutex mtx;
+
     void init();
+    void loadBitstream();
 };
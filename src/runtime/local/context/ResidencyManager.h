@@ -0,0 +1,236 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+
+class Structure;
+
+/**
+ * @brief Tracks the data placements resident in the memory of one device and evicts the least recently used ones
+ * when the device memory fills up.
+ *
+ * The data objects register their device placements (`track()`) and report every access to them (`touch()`). If an
+ * allocation would exceed the budget, `makeRoom()` evicts placements in LRU order. Among the oldest candidates, clean
+ * placements (another placement, e.g., on the host, holds the latest version) are preferred over dirty ones, whose
+ * eviction requires a write-back. The eviction itself (including the write-back) is done by the data object.
+ *
+ * The raw pointers returned by `getValues()` are not reference counted. Thus, the most recently accessed placements
+ * (e.g., the inputs of the running kernel) are not evicted, and the ones of objects hinted as soon to be used
+ * (`hint()`, e.g., the prefetched inputs of a pipeline) for a longer time.
+ */
+class ResidencyManager {
+public:
+    // whether the placement holds the only latest version of the data, i.e., needs a write-back on eviction
+    using DirtyCheck = std::function<bool()>;
+    // writes the placement back (if it is dirty) and removes it from its data object
+    using Evictor = std::function<void()>;
+
+    // the number of most recent accesses whose placements are protected from eviction
+    static constexpr size_t DEFAULT_PROTECTED_ACCESSES = 16;
+    // the factor by which a hint extends this protection
+    static constexpr size_t HINT_PROTECTION_FACTOR = 8;
+    // the number of oldest candidates among which a clean placement is preferred
+    static constexpr size_t EVICTION_WINDOW = 4;
+
+    struct Statistics {
+        size_t residentBytes = 0;
+        size_t numResident = 0;
+        size_t evictions = 0;
+        // the evictions which required a write-back, and the bytes written
+        size_t writeBacks = 0;
+        size_t writeBackBytes = 0;
+    };
+
+private:
+    struct Entry {
+        const Structure* owner;
+        size_t placementId;
+        size_t bytes;
+        // the entry is protected from eviction until the tick reaches this value
+        uint64_t protectedUntil;
+        DirtyCheck isDirty;
+        Evictor evict;
+    };
+    using Key = std::pair<const Structure*, size_t>;
+
+    const size_t _budget;
+    const size_t _protectedAccesses;
+
+    // the evictors may access this manager again (e.g., by destroying the placement)
+    mutable std::recursive_mutex _mtx;
+    // in LRU order, the most recently used entry last
+    std::list<Entry> _lru;
+    std::map<Key, std::list<Entry>::iterator> _entries;
+    uint64_t _tick = 0;
+    Statistics _stats;
+
+    void moveToBack(std::list<Entry>::iterator it, size_t protectedAccesses) {
+        ++_tick;
+        it->protectedUntil = std::max(it->protectedUntil, _tick + protectedAccesses);
+        _lru.splice(_lru.end(), _lru, it);
+    }
+
+    [[nodiscard]] bool isProtected(const Entry& e) const { return e.protectedUntil > _tick; }
+
+    // evicts one placement, returns false if all resident placements are protected
+    bool evictOne() {
+        auto victim = _lru.end();
+        bool victimDirty = false;
+        size_t candidates = 0;
+        for(auto it = _lru.begin(); it != _lru.end() && candidates < EVICTION_WINDOW; ++it) {
+            if(isProtected(*it))
+                continue;
+            candidates++;
+            const bool dirty = it->isDirty();
+            if(victim == _lru.end() || (victimDirty && !dirty)) {
+                victim = it;
+                victimDirty = dirty;
+            }
+            if(!dirty)
+                break;
+        }
+        if(victim == _lru.end())
+            return false;
+
+        Entry entry = std::move(*victim);
+        _entries.erase({entry.owner, entry.placementId});
+        _lru.erase(victim);
+        _stats.residentBytes -= entry.bytes;
+        _stats.numResident--;
+        _stats.evictions++;
+        if(victimDirty) {
+            _stats.writeBacks++;
+            _stats.writeBackBytes += entry.bytes;
+        }
+        entry.evict();
+        return true;
+    }
+
+public:
+    /**
+     * @param budget The number of bytes of tracked placements the device may hold.
+     * @param protectedAccesses The number of most recent accesses whose placements are protected from eviction.
+     */
+    explicit ResidencyManager(size_t budget, size_t protectedAccesses = DEFAULT_PROTECTED_ACCESSES)
+            : _budget(budget), _protectedAccesses(protectedAccesses) {}
+
+    ResidencyManager(const ResidencyManager&) = delete;
+    ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+    /**
+     * @brief Reports an access to a tracked placement, making it the most recently used one.
+     *
+     * @return Whether the placement is tracked, otherwise it has to be registered by `track()`.
+     */
+    bool touch(const Structure* owner, size_t placementId) {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        auto it = _entries.find({owner, placementId});
+        if(it == _entries.end())
+            return false;
+        // repeated accesses to the most recently used placement (e.g., element-wise by a kernel) count as one, such
+        // that they do not end the protection of the other recent ones
+        if(std::next(it->second) != _lru.end() || !isProtected(*it->second))
+            moveToBack(it->second, _protectedAccesses);
+        return true;
+    }
+
+    /**
+     * @brief Registers a placement of `bytes` bytes resident on the device as the most recently used one.
+     */
+    void track(const Structure* owner, size_t placementId, size_t bytes, DirtyCheck isDirty, Evictor evict) {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        if(touch(owner, placementId))
+            return;
+        _lru.push_back({owner, placementId, bytes, 0, std::move(isDirty), std::move(evict)});
+        _entries.emplace(Key{owner, placementId}, std::prev(_lru.end()));
+        moveToBack(std::prev(_lru.end()), _protectedAccesses);
+        _stats.residentBytes += bytes;
+        _stats.numResident++;
+    }
+
+    /**
+     * @brief Stops tracking the placements of the given data object, e.g., when it is destroyed.
+     */
+    void forget(const Structure* owner) {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        for(auto it = _entries.lower_bound({owner, 0}); it != _entries.end() && it->first.first == owner;) {
+            _stats.residentBytes -= it->second->bytes;
+            _stats.numResident--;
+            _lru.erase(it->second);
+            it = _entries.erase(it);
+        }
+    }
+
+    /**
+     * @brief Marks the placements of the given data object as soon to be used (e.g., the prefetched inputs of a
+     * pipeline), which protects them from eviction for `HINT_PROTECTION_FACTOR` times as many accesses as a regular
+     * access.
+     */
+    void hint(const Structure* owner) {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        for(auto it = _entries.lower_bound({owner, 0}); it != _entries.end() && it->first.first == owner; ++it) {
+            moveToBack(it->second, _protectedAccesses * HINT_PROTECTION_FACTOR);
+        }
+    }
+
+    /**
+     * @brief Evicts placements until another `bytes` bytes fit into the budget, or all remaining placements are
+     * protected.
+     *
+     * @return Whether the bytes fit into the budget.
+     */
+    bool makeRoom(size_t bytes) {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        while(_stats.residentBytes + bytes > _budget)
+            if(!evictOne())
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Evicts placements of at least `bytes` bytes (if not protected), e.g., after an allocation failed
+     * although the budget was not exhausted.
+     *
+     * @return The number of bytes evicted.
+     */
+    size_t evict(size_t bytes) {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        const size_t before = _stats.residentBytes;
+        while(before - _stats.residentBytes < bytes)
+            if(!evictOne())
+                break;
+        return before - _stats.residentBytes;
+    }
+
+    [[nodiscard]] bool isTracked(const Structure* owner, size_t placementId) const {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        return _entries.find({owner, placementId}) != _entries.end();
+    }
+
+    [[nodiscard]] Statistics getStatistics() const {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        return _stats;
+    }
+};
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief The error a run stops with once it was cancelled or exceeded its time limit.
+ */
+class CancelledError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief The cooperative cancellation, the time limit, and the progress of one run of a program, shared by its
+ * `DaphneContext` and the host of the run (e.g., the daphne server), which may cancel it or observe its progress
+ * from another thread.
+ *
+ * The workers of the vectorized pipelines check it between their tasks: once the run is cancelled, they drain their
+ * queues without executing the remaining tasks, and the pipeline frees its partial outputs and throws a
+ * `CancelledError` (see `VectorizedPipeline`), as does every later pipeline. The workers add the rows of the
+ * executed tasks to the progress.
+ */
+class RunControl {
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<bool> cancelled{false};
+    // the time limit as nanoseconds of the steady clock, none if the maximum
+    std::atomic<int64_t> deadlineNs{std::numeric_limits<int64_t>::max()};
+    std::atomic<bool> timedOut{false};
+
+    std::atomic<uint64_t> numPipelines{0};
+    std::atomic<uint64_t> pipelineRows{0};
+    std::atomic<uint64_t> pipelineRowsDone{0};
+    std::atomic<uint64_t> totalRowsDone{0};
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+public:
+    struct Progress {
+        // the vectorized pipelines started so far
+        uint64_t numPipelines;
+        // the rows of the current (or last) pipeline, and how many of them were processed
+        uint64_t pipelineRows;
+        uint64_t pipelineRowsDone;
+        // the rows processed by all pipelines so far
+        uint64_t totalRowsDone;
+        bool cancelled;
+    };
+
+    void cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Limits the run to the given number of seconds from now.
+     */
+    void setTimeout(double seconds) {
+        deadlineNs.store(nowNs() + static_cast<int64_t>(seconds * 1e9), std::memory_order_relaxed);
+    }
+
+    bool hasTimeout() const {
+        return deadlineNs.load(std::memory_order_relaxed) != std::numeric_limits<int64_t>::max();
+    }
+
+    bool isCancelled() {
+        if(cancelled.load(std::memory_order_relaxed))
+            return true;
+        if(hasTimeout() && nowNs() >= deadlineNs.load(std::memory_order_relaxed)) {
+            timedOut.store(true, std::memory_order_relaxed);
+            cancelled.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Throws a `CancelledError` if the run was cancelled or exceeded its time limit.
+     */
+    void throwIfCancelled() {
+        if(isCancelled())
+            throw CancelledError(timedOut.load(std::memory_order_relaxed)
+                    ? "the run exceeded its time limit" : "the run was cancelled");
+    }
+
+    void beginPipeline(uint64_t rows) {
+        pipelineRowsDone.store(0, std::memory_order_relaxed);
+        pipelineRows.store(rows, std::memory_order_relaxed);
+        numPipelines.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addRows(uint64_t rows) {
+        pipelineRowsDone.fetch_add(rows, std::memory_order_relaxed);
+        totalRowsDone.fetch_add(rows, std::memory_order_relaxed);
+    }
+
+    Progress getProgress() const {
+        return {numPipelines.load(std::memory_order_relaxed), pipelineRows.load(std::memory_order_relaxed),
+                pipelineRowsDone.load(std::memory_order_relaxed), totalRowsDone.load(std::memory_order_relaxed),
+                cancelled.load(std::memory_order_relaxed)};
+    }
+};
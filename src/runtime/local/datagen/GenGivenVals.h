@@ -17,9 +17,14 @@
 #ifndef SRC_RUNTIME_LOCAL_DATAGEN_GENGIVENVALS_H
 #define SRC_RUNTIME_LOCAL_DATAGEN_GENGIVENVALS_H
 
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 
 #include <algorithm>
 #include <vector>
@@ -146,5 +151,103 @@ struct GenGivenVals<CSRMatrix<VT>> {
         return res;
     }
 };
+// ----------------------------------------------------------------------------
+// BlockedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct GenGivenVals<BlockedMatrix<VT>> {
+    static BlockedMatrix<VT> * generate(size_t numRows, const std::vector<VT> & elements, size_t minNumNonZeros = 0) {
+        const size_t numCells = elements.size();
+        assert((numCells % numRows == 0) && "number of given data elements must be divisible by given number of rows");
+        const size_t numCols = numCells / numRows;
+        auto res = DataObjectFactory::create<BlockedMatrix<VT>>(numRows, numCols);
+        // the blocks are populated by the CSR generator, which is independent of the generic interfaces
+        const size_t blockSize = res->getBlockSize();
+        for(size_t rb = 0; rb < res->getNumRowBlocks(); rb++)
+            for(size_t cb = 0; cb < res->getNumColBlocks(); cb++) {
+                const size_t blockNumRows = res->getBlockNumRows(rb);
+                const size_t blockNumCols = res->getBlockNumCols(cb);
+                std::vector<VT> blockElements;
+                blockElements.reserve(blockNumRows * blockNumCols);
+                for(size_t r = rb * blockSize; r < rb * blockSize + blockNumRows; r++)
+                    for(size_t c = cb * blockSize; c < cb * blockSize + blockNumCols; c++)
+                        blockElements.push_back(elements[r * numCols + c]);
+                res->setSparseBlock(rb, cb, GenGivenVals<CSRMatrix<VT>>::generate(blockNumRows, blockElements));
+                res->compactBlock(rb, cb);
+            }
+        return res;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DCSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct GenGivenVals<DCSRMatrix<VT>> {
+    static DCSRMatrix<VT> * generate(size_t numRows, const std::vector<VT> & elements, size_t minNumNonZeros = 0) {
+        const size_t numCells = elements.size();
+        assert((numCells % numRows == 0) && "number of given data elements must be divisible by given number of rows");
+        const size_t numCols = numCells / numRows;
+        auto res = DataObjectFactory::create<DCSRMatrix<VT>>(numRows, numCols, minNumNonZeros);
+        res->prepareAppend();
+        for(size_t r = 0; r < numRows; r++)
+            for(size_t c = 0; c < numCols; c++)
+                res->append(r, c, elements[r * numCols + c]);
+        res->finishAppend();
+        return res;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CompressedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct GenGivenVals<CompressedMatrix<VT>> {
+    static CompressedMatrix<VT> * generate(size_t numRows, const std::vector<VT> & elements, size_t minNumNonZeros = 0) {
+        const size_t numCells = elements.size();
+        assert((numCells % numRows == 0) && "number of given data elements must be divisible by given number of rows");
+        const size_t numCols = numCells / numRows;
+        return DataObjectFactory::create<CompressedMatrix<VT>>(numRows, numCols, elements.data(), numCols);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct GenGivenVals<DenseMatrixCM<VT>> {
+    static DenseMatrixCM<VT> * generate(size_t numRows, const std::vector<VT> & elements, size_t minNumNonZeros = 0) {
+        const size_t numCells = elements.size();
+        assert((numCells % numRows == 0) && "number of given data elements must be divisible by given number of rows");
+        const size_t numCols = numCells / numRows;
+        auto res = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numCols, false);
+        for(size_t r = 0; r < numRows; r++)
+            for(size_t c = 0; c < numCols; c++)
+                res->set(r, c, elements[r * numCols + c]);
+        return res;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// BitMatrix
+// ----------------------------------------------------------------------------
+
+template<>
+struct GenGivenVals<BitMatrix> {
+    static BitMatrix * generate(size_t numRows, const std::vector<bool> & elements, size_t minNumNonZeros = 0) {
+        const size_t numCells = elements.size();
+        assert((numCells % numRows == 0) && "number of given data elements must be divisible by given number of rows");
+        const size_t numCols = numCells / numRows;
+        auto res = DataObjectFactory::create<BitMatrix>(numRows, numCols, true);
+        for(size_t i = 0; i < numCells; i++)
+            if(elements[i])
+                res->set(i / numCols, i % numCols, true);
+        return res;
+    }
+};
 
 #endif //SRC_RUNTIME_LOCAL_DATAGEN_GENGIVENVALS_H
\ No newline at end of file
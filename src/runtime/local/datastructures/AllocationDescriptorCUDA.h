@@ -62,6 +62,10 @@ public:
         CHECK_CUDART(cudaMemcpy(dst, data.get(), size, cudaMemcpyDeviceToHost));
     };
 
+    [[nodiscard]] ResidencyManager* getResidencyManager() const override {
+        return CUDAContext::get(dctx, device_id)->getResidencyManager();
+    }
+
     bool operator==(const IAllocationDescriptor* other) const override {
         if(getType() == other->getType())
             return(getLocation() == dynamic_cast<const AllocationDescriptorCUDA *>(other)->getLocation());
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/AllocationDescriptorDisk.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/MemoryTracker.h>
+#include <runtime/local/datastructures/SpillManager.h>
+#include <runtime/local/io/ReadDaphne.h>
+#include <runtime/local/io/WriteDaphne.h>
+
+#include <stdexcept>
+#include <utility>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct AllocationDescriptorDisk::SpillFile {
+    std::string path;
+    bool written = false;
+    // accounts for the size of the file while it exists
+    std::shared_ptr<void> tracked{};
+
+    explicit SpillFile(std::string path) : path(std::move(path)) { }
+
+    ~SpillFile() {
+        if(written)
+            unlink(path.c_str());
+    }
+};
+
+namespace {
+    // the spill files are written and read on the evicting thread, since the process-wide spill manager has no
+    // context whose workers could be used
+    template<typename VT>
+    void writeSpillFile(const std::byte * src, uint64_t numRows, uint64_t numCols, const std::string & path) {
+        DF_options opts;
+        opts.compression = SpillManager::get().getCompression();
+        WriteDaphne<DenseMatrix<VT>>::writeValues(reinterpret_cast<const VT *>(src), numRows, numCols, numCols,
+                path.c_str(), opts);
+    }
+
+    template<typename VT>
+    void readSpillFile(std::byte * dst, uint64_t numRows, uint64_t numCols, const std::string & path) {
+        ReadDaphne<DenseMatrix<VT>>::readValues(reinterpret_cast<VT *>(dst), path.c_str(), numRows, numCols,
+                nullptr);
+    }
+
+    void writeSpillFile(ValueTypeCode vt, const std::byte * src, uint64_t numRows, uint64_t numCols,
+            const std::string & path) {
+        switch(vt) {
+            case ValueTypeCode::SI8: writeSpillFile<int8_t>(src, numRows, numCols, path); break;
+            case ValueTypeCode::SI32: writeSpillFile<int32_t>(src, numRows, numCols, path); break;
+            case ValueTypeCode::SI64: writeSpillFile<int64_t>(src, numRows, numCols, path); break;
+            case ValueTypeCode::UI8: writeSpillFile<uint8_t>(src, numRows, numCols, path); break;
+            case ValueTypeCode::UI32: writeSpillFile<uint32_t>(src, numRows, numCols, path); break;
+            case ValueTypeCode::UI64: writeSpillFile<uint64_t>(src, numRows, numCols, path); break;
+            case ValueTypeCode::F32: writeSpillFile<float>(src, numRows, numCols, path); break;
+            case ValueTypeCode::F64: writeSpillFile<double>(src, numRows, numCols, path); break;
+            default: throw std::runtime_error("AllocationDescriptorDisk: unsupported value type");
+        }
+    }
+
+    void readSpillFile(ValueTypeCode vt, std::byte * dst, uint64_t numRows, uint64_t numCols,
+            const std::string & path) {
+        switch(vt) {
+            case ValueTypeCode::SI8: readSpillFile<int8_t>(dst, numRows, numCols, path); break;
+            case ValueTypeCode::SI32: readSpillFile<int32_t>(dst, numRows, numCols, path); break;
+            case ValueTypeCode::SI64: readSpillFile<int64_t>(dst, numRows, numCols, path); break;
+            case ValueTypeCode::UI8: readSpillFile<uint8_t>(dst, numRows, numCols, path); break;
+            case ValueTypeCode::UI32: readSpillFile<uint32_t>(dst, numRows, numCols, path); break;
+            case ValueTypeCode::UI64: readSpillFile<uint64_t>(dst, numRows, numCols, path); break;
+            case ValueTypeCode::F32: readSpillFile<float>(dst, numRows, numCols, path); break;
+            case ValueTypeCode::F64: readSpillFile<double>(dst, numRows, numCols, path); break;
+            default: throw std::runtime_error("AllocationDescriptorDisk: unsupported value type");
+        }
+    }
+}
+
+void AllocationDescriptorDisk::createAllocation(size_t size, bool zero) {
+    file = std::make_shared<SpillFile>(SpillManager::get().newFilePath());
+}
+
+std::string AllocationDescriptorDisk::getLocation() const {
+    return file ? file->path : "";
+}
+
+void AllocationDescriptorDisk::transferTo(std::byte* src, size_t size) {
+    if(!file)
+        createAllocation(size, false);
+    const uint64_t rowBytes = numCols * valueSize;
+    const uint64_t numRows = rowBytes ? size / rowBytes : 0;
+    // a failed write may leave a partial file behind
+    file->written = true;
+    writeSpillFile(vt, src, numRows, numCols, file->path);
+
+    struct stat st;
+    if(stat(file->path.c_str(), &st) != 0)
+        throw std::runtime_error("AllocationDescriptorDisk: cannot write the spill file " + file->path);
+    const uint64_t fileBytes = st.st_size;
+    file->tracked.reset();
+    file->tracked = MemoryTracker::get().track(ALLOCATION_TYPE::DISK, fileBytes);
+    SpillManager::get().addSpill(size, fileBytes);
+}
+
+void AllocationDescriptorDisk::transferFrom(std::byte* dst, size_t size) {
+    if(!file || !file->written)
+        throw std::runtime_error("AllocationDescriptorDisk: the values were not spilled");
+    const uint64_t rowBytes = numCols * valueSize;
+    const uint64_t numRows = rowBytes ? size / rowBytes : 0;
+    readSpillFile(vt, dst, numRows, numCols, file->path);
+    SpillManager::get().addReload(size);
+}
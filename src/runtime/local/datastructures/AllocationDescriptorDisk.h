@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "DataPlacement.h"
+#include <runtime/local/datastructures/ValueTypeCode.h>
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief An allocation in a spill file on local disk, which holds the values of a dense matrix evicted from main
+ * memory (see `SpillManager`).
+ *
+ * The spill file is a Daphne binary file of the matrix, a single body if uncompressed, or blocks of rows compressed
+ * by LZ4 otherwise (see `DaphneFile.h`). It is created by the first transfer to it and removed when the last copy of
+ * the descriptor (i.e., the data placement) is destroyed. The values cannot be accessed in place (`getData()` is
+ * null), but are transferred back to main memory.
+ */
+class AllocationDescriptorDisk : public IAllocationDescriptor {
+    struct SpillFile;
+
+    ALLOCATION_TYPE type = ALLOCATION_TYPE::DISK;
+    size_t numCols;
+    ValueTypeCode vt;
+    size_t valueSize;
+    // shared by the clones of this descriptor
+    std::shared_ptr<SpillFile> file{};
+
+public:
+    AllocationDescriptorDisk() = delete;
+
+    /**
+     * @param numCols The number of columns of the matrix, whose rows are stored contiguously.
+     * @param vt The value type of the matrix in the spill file.
+     * @param valueSize The size of a value in bytes.
+     */
+    AllocationDescriptorDisk(size_t numCols, ValueTypeCode vt, size_t valueSize) : numCols(numCols), vt(vt),
+            valueSize(valueSize) { }
+
+    ~AllocationDescriptorDisk() override = default;
+
+    [[nodiscard]] ALLOCATION_TYPE getType() const override { return type; }
+
+    // chooses the path of the spill file, which is written by transferTo()
+    void createAllocation(size_t size, bool zero) override;
+
+    // the path of the spill file
+    [[nodiscard]] std::string getLocation() const override;
+
+    std::shared_ptr<std::byte> getData() override { return nullptr; }
+
+    // writes the spill file
+    void transferTo(std::byte* src, size_t size) override;
+
+    // reads the spill file
+    void transferFrom(std::byte* dst, size_t size) override;
+
+    [[nodiscard]] std::unique_ptr<IAllocationDescriptor> clone() const override {
+        return std::make_unique<AllocationDescriptorDisk>(*this);
+    }
+
+    bool operator==(const IAllocationDescriptor* other) const override {
+        return getType() == other->getType() && getLocation() == other->getLocation();
+    }
+};
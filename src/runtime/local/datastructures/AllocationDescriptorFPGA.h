@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "DataPlacement.h"
+#include "runtime/local/context/DaphneContext.h"
+#include "runtime/local/context/FPGAContext.h"
+
+/**
+ * @brief Describes a buffer in the global memory of an Intel FPGA.
+ *
+ * The buffer is an OpenCL memory object, which is not addressable by the host;
+ * `getData()` returns the `cl_mem` handle disguised as a pointer, which
+ * `buffer()` turns back into the handle. Transfers wait for the last command
+ * enqueued on the buffer (e.g., the kernel computing it), such that kernels
+ * can run asynchronously and consume the results of other kernels without a
+ * round trip through main memory.
+ */
+class AllocationDescriptorFPGA : public IAllocationDescriptor {
+    ALLOCATION_TYPE type = ALLOCATION_TYPE::FPGA_INT;
+    uint32_t device_id{};
+    DaphneContext* dctx{};
+    std::shared_ptr<std::byte> data{};
+
+public:
+    AllocationDescriptorFPGA() = delete;
+
+    AllocationDescriptorFPGA(DaphneContext* ctx, uint32_t device_id) : device_id(device_id), dctx(ctx) { }
+
+    [[nodiscard]] ALLOCATION_TYPE getType() const override { return type; }
+
+    [[nodiscard]] std::string getLocation() const override { return std::to_string(device_id); }
+
+    static cl_mem buffer(const void* data) { return reinterpret_cast<cl_mem>(const_cast<void*>(data)); }
+
+    void createAllocation(size_t size, bool zero) override {
+        auto fctx = dctx->getFPGAContext(device_id);
+        cl_int status;
+        cl_mem buf = clCreateBuffer(fctx->context, CL_MEM_READ_WRITE, size, NULL, &status);
+        if(status != CL_SUCCESS)
+            throw std::runtime_error("AllocationDescriptorFPGA: failed to allocate " + std::to_string(size) +
+                    " bytes of FPGA memory, error " + std::to_string(status));
+        data = std::shared_ptr<std::byte>(reinterpret_cast<std::byte*>(buf), [fctx](std::byte* p) {
+            fctx->forget(buffer(p));
+            clReleaseMemObject(buffer(p));
+        });
+        if(zero) {
+            std::vector<std::byte> zeros(size);
+            transferTo(zeros.data(), size);
+        }
+    }
+
+    std::shared_ptr<std::byte> getData() override { return data; }
+
+    [[nodiscard]] std::unique_ptr<IAllocationDescriptor> clone() const override {
+        return std::make_unique<AllocationDescriptorFPGA>(*this);
+    }
+
+    void transferTo(std::byte* src, size_t size) override {
+        auto fctx = dctx->getFPGAContext(device_id);
+        fctx->waitFor(buffer(data.get()));
+        cl_int status = clEnqueueWriteBuffer(fctx->getTransferQueue(0), buffer(data.get()), CL_TRUE, 0, size, src,
+                0, NULL, NULL);
+        if(status != CL_SUCCESS)
+            throw std::runtime_error("AllocationDescriptorFPGA: transfer to the FPGA failed, error " +
+                    std::to_string(status));
+    }
+    void transferFrom(std::byte* dst, size_t size) override {
+        auto fctx = dctx->getFPGAContext(device_id);
+        fctx->waitFor(buffer(data.get()));
+        cl_int status = clEnqueueReadBuffer(fctx->getTransferQueue(0), buffer(data.get()), CL_TRUE, 0, size, dst,
+                0, NULL, NULL);
+        if(status != CL_SUCCESS)
+            throw std::runtime_error("AllocationDescriptorFPGA: transfer from the FPGA failed, error " +
+                    std::to_string(status));
+    };
+
+    bool operator==(const IAllocationDescriptor* other) const override {
+        if(getType() == other->getType())
+            return(getLocation() == dynamic_cast<const AllocationDescriptorFPGA *>(other)->getLocation());
+        return false;
+    }
+};
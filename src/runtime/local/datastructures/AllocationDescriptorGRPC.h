@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <runtime/local/datastructures/DistributedGarbage.h>
+#include <runtime/local/datastructures/MemoryTracker.h>
 #include <runtime/local/datastructures/Structure.h>
 #include <ir/daphneir/Daphne.h>
 
@@ -51,14 +53,32 @@ private:
 };
 
 
+/**
+ * @brief The operation that placed data at a worker (its lineage), by which a placement lost with a failed worker is
+ * restored at the other ones (see DistributedContext::excludeWorker).
+ */
+enum class DistributedOrigin {
+    // sent by the coordinator, which holds the values (Distribute, Broadcast)
+    DISTRIBUTE,
+    BROADCAST,
+    // read by the worker from the source file (DistributedRead)
+    READ,
+    // computed by a pipeline (DistributedCompute), whose results the coordinator collects
+    COMPUTE
+};
+
 struct DistributedData
 {
     std::string identifier;
     size_t numRows, numCols;
-    mlir::daphne::VectorCombine vectorCombine;
+    // how the partial results of a pipeline are combined (partitions of the inputs are split by rows)
+    mlir::daphne::VectorCombine vectorCombine = mlir::daphne::VectorCombine::ROWS;
     bool isPlacedAtWorker = false;
     DistributedIndex ix;
-
+    // the file the workers read the data from themselves (see `DistributedRead`), or empty if it was sent by the
+    // coordinator
+    std::string sourceFile;
+    DistributedOrigin origin = DistributedOrigin::DISTRIBUTE;
 };
 
 class AllocationDescriptorGRPC : public IAllocationDescriptor {
@@ -67,6 +87,10 @@ private:
     ALLOCATION_TYPE type = ALLOCATION_TYPE::DIST_GRPC;
     const std::string workerAddress;
     DistributedData distributedData;
+    // accounts for the partition placed at the worker (see MemoryTracker) until all copies of this descriptor are gone
+    std::shared_ptr<void> trackedPlacement;
+    // frees the data at the worker (see DistributedGarbage) once all copies of this descriptor are gone
+    std::shared_ptr<void> workerData;
     std::shared_ptr<std::byte> data;
 public:
     AllocationDescriptorGRPC() {} ;
@@ -120,5 +144,13 @@ public:
     const DistributedData getDistributedData()
     { return distributedData; }
     void updateDistributedData(DistributedData data_)
-    { distributedData = data_; }
+    {
+        // the distributed data objects are DenseMatrix<double> for now
+        if(data_.isPlacedAtWorker && !trackedPlacement)
+            trackedPlacement = MemoryTracker::get().track(type, data_.numRows * data_.numCols * sizeof(double));
+        // the data replaced by new data at the worker, e.g., a partial result by the next one, is freed
+        if(data_.isPlacedAtWorker && (!workerData || data_.identifier != distributedData.identifier))
+            workerData = DistributedGarbage::get().hold(workerAddress, data_.identifier);
+        distributedData = data_;
+    }
 };
@@ -17,6 +17,8 @@
 #pragma once
 
 #include "DataPlacement.h"
+#include <runtime/local/datastructures/SpillManager.h>
+
 #include <memory>
 
 class AllocationDescriptorHost : public IAllocationDescriptor {
@@ -36,4 +38,8 @@ public:
         return std::make_unique<AllocationDescriptorHost>(*this);
     }
     bool operator==(const IAllocationDescriptor* other) const override { return (getType() == other->getType()); }
+    // the values of dense matrices in main memory are spilled to disk beyond a budget, if enabled
+    [[nodiscard]] ResidencyManager* getResidencyManager() const override {
+        return SpillManager::get().getResidencyManager();
+    }
 };
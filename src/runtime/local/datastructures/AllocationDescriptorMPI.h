@@ -0,0 +1,83 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/AllocationDescriptorGRPC.h>
+
+#include <string>
+
+/**
+ * @brief The placement of a data object at a distributed worker of the MPI backend, whose location is the rank of
+ * the worker in `MPI_COMM_WORLD` (the coordinator is rank 0).
+ */
+class AllocationDescriptorMPI : public IAllocationDescriptor {
+private:
+    DaphneContext *ctx;
+    ALLOCATION_TYPE type = ALLOCATION_TYPE::DIST_MPI;
+    int processRankID;
+    DistributedData distributedData;
+    // accounts for the partition placed at the worker (see MemoryTracker) until all copies of this descriptor are gone
+    std::shared_ptr<void> trackedPlacement;
+public:
+    AllocationDescriptorMPI() {} ;
+    AllocationDescriptorMPI(DaphneContext* ctx,
+                            int id,
+                            const DistributedData &data) : ctx(ctx), processRankID(id), distributedData(data) { } ;
+
+    ~AllocationDescriptorMPI() override {};
+    [[nodiscard]] ALLOCATION_TYPE getType() const override
+    { return type; };
+
+    std::string getLocation() const override
+    { return std::to_string(processRankID); };
+    int getRank() const
+    { return processRankID; };
+    void createAllocation(size_t size, bool zero) override {}
+    std::shared_ptr<std::byte> getData() override {
+        throw std::runtime_error("TransferTo/From functions are not implemented yet.");
+    }
+
+    bool operator==(const IAllocationDescriptor* other) const override {
+        if(getType() == other->getType())
+            return(getLocation() == dynamic_cast<const AllocationDescriptorMPI *>(other)->getLocation());
+        return false;
+    }
+
+    [[nodiscard]] std::unique_ptr<IAllocationDescriptor> clone() const override {
+        return std::make_unique<AllocationDescriptorMPI>(*this);
+    }
+
+    // Like for gRPC, all communication is handled by the distributed kernels (e.g. Distribute.h).
+    void transferTo(std::byte *src, size_t size) override {
+        throw std::runtime_error("TransferTo (MPI) function is not implemented yet.");
+    };
+    void transferFrom(std::byte *src, size_t size) override {
+        throw std::runtime_error("TransferFrom (MPI) function is not implemented yet.");
+    };
+
+    const DistributedIndex getDistributedIndex()
+    { return distributedData.ix; }
+    const DistributedData getDistributedData()
+    { return distributedData; }
+    void updateDistributedData(DistributedData data_)
+    {
+        // the distributed data objects are DenseMatrix<double> for now
+        if(data_.isPlacedAtWorker && !trackedPlacement)
+            trackedPlacement = MemoryTracker::get().track(type, data_.numRows * data_.numCols * sizeof(double));
+        distributedData = data_;
+    }
+};
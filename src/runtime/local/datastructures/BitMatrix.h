@@ -0,0 +1,180 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Matrix.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief A matrix of booleans packed into 64-bit words, e.g., the mask of a
+ * comparison.
+ *
+ * The cells are numbered in row-major fashion without any padding between the
+ * rows, cell `i` being bit `i % 64` of word `i / 64`. Thus, a mask takes one
+ * bit per cell rather than the 64 bits of a `DenseMatrix<double>` of zeros
+ * and ones, and 64 cells can be counted (by popcount) or tested at once. The
+ * bits beyond the last cell in the last word are always zero.
+ *
+ * Slices are copies, since a range of rows or columns does not start at a
+ * word boundary in general.
+ */
+class BitMatrix : public Matrix<bool> {
+    // `using`, so that we do not need to prefix each occurrence of these
+    // fields from the super-classes.
+    using Matrix<bool>::numRows;
+    using Matrix<bool>::numCols;
+
+    size_t numWords;
+    std::shared_ptr<uint64_t[]> words;
+
+    // Grant DataObjectFactory access to the private constructors and
+    // destructors.
+    template<class DataType, typename ... ArgTypes>
+    friend DataType * DataObjectFactory::create(ArgTypes ...);
+    template<class DataType>
+    friend void DataObjectFactory::destroy(const DataType * obj);
+
+    /**
+     * @brief Creates a `BitMatrix` and allocates enough words for the
+     * specified size.
+     *
+     * @param numRows The exact number of rows.
+     * @param numCols The exact number of columns.
+     * @param zero Whether all bits shall be initialized to zero (`true`), or
+     * only the ones beyond the last cell (`false`).
+     */
+    BitMatrix(size_t numRows, size_t numCols, bool zero) :
+            Matrix<bool>(numRows, numCols), numWords(getNumWordsFor(numRows * numCols)),
+            words(BufferPool::get().allocShared<uint64_t>(std::max<size_t>(1, numWords)))
+    {
+        if(zero)
+            memset(words.get(), 0, numWords * sizeof(uint64_t));
+        else if(numWords)
+            words[numWords - 1] = 0;
+    }
+
+    ~BitMatrix() override {
+        // nothing to do
+    }
+
+public:
+
+    /**
+     * @brief Returns the number of words needed for the given number of bits.
+     */
+    static size_t getNumWordsFor(size_t numBits) {
+        return (numBits + 63) / 64;
+    }
+
+    size_t getNumWords() const {
+        return numWords;
+    }
+
+    const uint64_t * getWords() const {
+        return words.get();
+    }
+
+    uint64_t * getWords() {
+        return words.get();
+    }
+
+    size_t getSizeInBytes() const {
+        return numWords * sizeof(uint64_t);
+    }
+
+    bool get(size_t rowIdx, size_t colIdx) const override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        const size_t i = rowIdx * numCols + colIdx;
+        return (words[i / 64] >> (i % 64)) & 1;
+    }
+
+    void set(size_t rowIdx, size_t colIdx, bool value) override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        const size_t i = rowIdx * numCols + colIdx;
+        const uint64_t bit = uint64_t(1) << (i % 64);
+        if(value)
+            words[i / 64] |= bit;
+        else
+            words[i / 64] &= ~bit;
+    }
+
+    void prepareAppend() override {
+        memset(words.get(), 0, numWords * sizeof(uint64_t));
+    }
+
+    void append(size_t rowIdx, size_t colIdx, bool value) override {
+        if(value)
+            set(rowIdx, colIdx, true);
+    }
+
+    void finishAppend() override {
+        // nothing to do
+    }
+
+    void print(std::ostream & os) const override {
+        os << "BitMatrix(" << numRows << 'x' << numCols << ", bool)" << std::endl;
+        for(size_t r = 0; r < numRows; r++) {
+            for(size_t c = 0; c < numCols; c++) {
+                os << get(r, c);
+                if(c < numCols - 1)
+                    os << ' ';
+            }
+            os << std::endl;
+        }
+    }
+
+    BitMatrix* sliceRow(size_t rl, size_t ru) const override {
+        return slice(rl, ru, 0, numCols);
+    }
+
+    BitMatrix* sliceCol(size_t cl, size_t cu) const override {
+        return slice(0, numRows, cl, cu);
+    }
+
+    /**
+     * @brief Returns a copy of the given rows and columns of this matrix.
+     */
+    BitMatrix* slice(size_t rl, size_t ru, size_t cl, size_t cu) const override {
+        if(rl > ru || ru > numRows || cl > cu || cu > numCols)
+            throw std::runtime_error("BitMatrix: the bounds of the slice are invalid");
+        auto res = DataObjectFactory::create<BitMatrix>(ru - rl, cu - cl, true);
+        for(size_t r = rl; r < ru; r++)
+            for(size_t c = cl; c < cu; c++)
+                if(get(r, c))
+                    res->set(r - rl, c - cl, true);
+        return res;
+    }
+};
+
+inline std::ostream & operator<<(std::ostream & os, const BitMatrix & obj)
+{
+    obj.print(os);
+    return os;
+}
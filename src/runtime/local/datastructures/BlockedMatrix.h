@@ -0,0 +1,474 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Matrix.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief A matrix partitioned into a grid of square blocks, each of which is
+ * stored in the representation suiting its own density.
+ *
+ * A block is either empty (all zeros, nothing allocated), a `DenseMatrix` or
+ * a `CSRMatrix`, mirroring the body types of the blocks of the DAPHNE file
+ * format (see `DF_body_block` in `DaphneFile.h`). The blocks of the last row
+ * and column of blocks may be smaller than the block size. Thus, kernels can
+ * work on cache-sized blocks and dense regions of an otherwise sparse matrix
+ * (or the other way around) are stored efficiently.
+ *
+ * `set()` keeps a modified block dense until the representations of the
+ * blocks are chosen again by `compact()`. `append()` collects the values per
+ * block and `finishAppend()` builds each block in its final representation.
+ */
+template<typename ValueType>
+class BlockedMatrix : public Matrix<ValueType> {
+public:
+    enum class BlockType {EMPTY, DENSE, SPARSE};
+
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 256;
+
+    /**
+     * @brief Blocks with at most this share of non-zeros are stored as
+     * `CSRMatrix`, all others as `DenseMatrix` (as the sparsity threshold of
+     * the compiler's selection of matrix representations).
+     */
+    static constexpr double SPARSITY_THRESHOLD = 0.1;
+
+private:
+    // `using`, so that we do not need to prefix each occurrence of these
+    // fields from the super-classes.
+    using Matrix<ValueType>::numRows;
+    using Matrix<ValueType>::numCols;
+
+    struct Block {
+        BlockType type = BlockType::EMPTY;
+        DenseMatrix<ValueType> * dense = nullptr;
+        CSRMatrix<ValueType> * sparse = nullptr;
+    };
+
+    const size_t blockSize;
+    const size_t numRowBlocks;
+    const size_t numColBlocks;
+
+    // in row-major order of the grid
+    std::vector<Block> blocks;
+
+    // the values appended per block since `prepareAppend()`
+    std::vector<std::vector<std::tuple<size_t, size_t, ValueType>>> appended;
+
+    // Grant DataObjectFactory access to the private constructors and
+    // destructors.
+    template<class DataType, typename ... ArgTypes>
+    friend DataType * DataObjectFactory::create(ArgTypes ...);
+    template<class DataType>
+    friend void DataObjectFactory::destroy(const DataType * obj);
+
+    /**
+     * @brief Creates a `BlockedMatrix` of the given size whose blocks are all
+     * empty, i.e., a matrix of zeros.
+     *
+     * @param numRows The exact number of rows.
+     * @param numCols The exact number of columns.
+     * @param blockSize The number of rows and columns of each block.
+     */
+    BlockedMatrix(size_t numRows, size_t numCols, size_t blockSize = DEFAULT_BLOCK_SIZE) :
+            Matrix<ValueType>(numRows, numCols),
+            blockSize(blockSize),
+            numRowBlocks((numRows + blockSize - 1) / blockSize),
+            numColBlocks((numCols + blockSize - 1) / blockSize)
+    {
+        if(blockSize == 0)
+            throw std::runtime_error("BlockedMatrix: the block size must not be zero");
+        blocks.resize(numRowBlocks * numColBlocks);
+    }
+
+    virtual ~BlockedMatrix() {
+        for(size_t i = 0; i < blocks.size(); i++)
+            release(blocks[i]);
+    }
+
+    static void release(Block & block) {
+        if(block.dense)
+            DataObjectFactory::destroy(block.dense);
+        if(block.sparse)
+            DataObjectFactory::destroy(block.sparse);
+        block = Block();
+    }
+
+    Block & getBlock(size_t rowBlock, size_t colBlock) {
+        assert((rowBlock < numRowBlocks) && "rowBlock is out of bounds");
+        assert((colBlock < numColBlocks) && "colBlock is out of bounds");
+        return blocks[rowBlock * numColBlocks + colBlock];
+    }
+
+    const Block & getBlock(size_t rowBlock, size_t colBlock) const {
+        assert((rowBlock < numRowBlocks) && "rowBlock is out of bounds");
+        assert((colBlock < numColBlocks) && "colBlock is out of bounds");
+        return blocks[rowBlock * numColBlocks + colBlock];
+    }
+
+    void checkBlockShape(size_t rowBlock, size_t colBlock, const Matrix<ValueType> * block) const {
+        if(block->getNumRows() != getBlockNumRows(rowBlock) || block->getNumCols() != getBlockNumCols(colBlock))
+            throw std::runtime_error("BlockedMatrix: the block does not match the shape of its position");
+    }
+
+    static size_t countNonZeros(const DenseMatrix<ValueType> * block) {
+        const size_t rows = block->getNumRows();
+        const size_t cols = block->getNumCols();
+        const size_t rowSkip = block->getRowSkip();
+        const ValueType * values = block->getValues();
+        size_t nnz = 0;
+        for(size_t r = 0; r < rows; r++, values += rowSkip)
+            for(size_t c = 0; c < cols; c++)
+                nnz += values[c] != ValueType(0);
+        return nnz;
+    }
+
+    static DenseMatrix<ValueType> * toDense(const CSRMatrix<ValueType> * block) {
+        const size_t rows = block->getNumRows();
+        auto res = DataObjectFactory::create<DenseMatrix<ValueType>>(rows, block->getNumCols(), true);
+        ValueType * resRow = res->getValues();
+        for(size_t r = 0; r < rows; r++, resRow += res->getRowSkip()) {
+            const size_t rowNumNonZeros = block->getNumNonZeros(r);
+            const size_t * rowColIdxs = block->getColIdxs(r);
+            const ValueType * rowValues = block->getValues(r);
+            for(size_t i = 0; i < rowNumNonZeros; i++)
+                resRow[rowColIdxs[i]] = rowValues[i];
+        }
+        return res;
+    }
+
+    static CSRMatrix<ValueType> * toSparse(const DenseMatrix<ValueType> * block, size_t numNonZeros) {
+        const size_t rows = block->getNumRows();
+        const size_t cols = block->getNumCols();
+        auto res = DataObjectFactory::create<CSRMatrix<ValueType>>(rows, cols, numNonZeros, false);
+        ValueType * resValues = res->getValues();
+        size_t * resColIdxs = res->getColIdxs();
+        size_t * resRowOffsets = res->getRowOffsets();
+        const ValueType * row = block->getValues();
+        size_t pos = 0;
+        resRowOffsets[0] = 0;
+        for(size_t r = 0; r < rows; r++, row += block->getRowSkip()) {
+            for(size_t c = 0; c < cols; c++)
+                if(row[c] != ValueType(0)) {
+                    resValues[pos] = row[c];
+                    resColIdxs[pos] = c;
+                    pos++;
+                }
+            resRowOffsets[r + 1] = pos;
+        }
+        return res;
+    }
+
+public:
+
+    size_t getBlockSize() const {
+        return blockSize;
+    }
+
+    size_t getNumRowBlocks() const {
+        return numRowBlocks;
+    }
+
+    size_t getNumColBlocks() const {
+        return numColBlocks;
+    }
+
+    /**
+     * @brief Returns the number of rows of the blocks in the given row of
+     * blocks, which is less than the block size for the last one.
+     */
+    size_t getBlockNumRows(size_t rowBlock) const {
+        return std::min(blockSize, numRows - rowBlock * blockSize);
+    }
+
+    /**
+     * @brief Returns the number of columns of the blocks in the given column
+     * of blocks, which is less than the block size for the last one.
+     */
+    size_t getBlockNumCols(size_t colBlock) const {
+        return std::min(blockSize, numCols - colBlock * blockSize);
+    }
+
+    BlockType getBlockType(size_t rowBlock, size_t colBlock) const {
+        return getBlock(rowBlock, colBlock).type;
+    }
+
+    /**
+     * @brief Returns the given block if it is dense, `nullptr` otherwise.
+     */
+    const DenseMatrix<ValueType> * getDenseBlock(size_t rowBlock, size_t colBlock) const {
+        return getBlock(rowBlock, colBlock).dense;
+    }
+
+    DenseMatrix<ValueType> * getDenseBlock(size_t rowBlock, size_t colBlock) {
+        return getBlock(rowBlock, colBlock).dense;
+    }
+
+    /**
+     * @brief Returns the given block if it is sparse, `nullptr` otherwise.
+     */
+    const CSRMatrix<ValueType> * getSparseBlock(size_t rowBlock, size_t colBlock) const {
+        return getBlock(rowBlock, colBlock).sparse;
+    }
+
+    CSRMatrix<ValueType> * getSparseBlock(size_t rowBlock, size_t colBlock) {
+        return getBlock(rowBlock, colBlock).sparse;
+    }
+
+    /**
+     * @brief Replaces the given block by a dense one, taking over the caller's
+     * reference to it. Passing `nullptr` makes the block empty.
+     */
+    void setDenseBlock(size_t rowBlock, size_t colBlock, DenseMatrix<ValueType> * block) {
+        Block & b = getBlock(rowBlock, colBlock);
+        if(block)
+            checkBlockShape(rowBlock, colBlock, block);
+        release(b);
+        if(block) {
+            b.type = BlockType::DENSE;
+            b.dense = block;
+        }
+    }
+
+    /**
+     * @brief Replaces the given block by a sparse one, taking over the
+     * caller's reference to it. Passing `nullptr` makes the block empty.
+     */
+    void setSparseBlock(size_t rowBlock, size_t colBlock, CSRMatrix<ValueType> * block) {
+        Block & b = getBlock(rowBlock, colBlock);
+        if(block)
+            checkBlockShape(rowBlock, colBlock, block);
+        release(b);
+        if(block) {
+            b.type = BlockType::SPARSE;
+            b.sparse = block;
+        }
+    }
+
+    /**
+     * @brief Chooses the representation of the given block by its share of
+     * non-zeros: empty without any, sparse up to `SPARSITY_THRESHOLD`, dense
+     * otherwise.
+     */
+    void compactBlock(size_t rowBlock, size_t colBlock) {
+        Block & b = getBlock(rowBlock, colBlock);
+        if(b.type == BlockType::EMPTY)
+            return;
+        const size_t numCells = getBlockNumRows(rowBlock) * getBlockNumCols(colBlock);
+        const size_t nnz = b.dense ? countNonZeros(b.dense) : b.sparse->getNumNonZeros();
+        if(nnz == 0)
+            release(b);
+        else if(nnz <= SPARSITY_THRESHOLD * numCells) {
+            if(b.dense) {
+                CSRMatrix<ValueType> * sparse = toSparse(b.dense, nnz);
+                release(b);
+                b.type = BlockType::SPARSE;
+                b.sparse = sparse;
+            }
+        }
+        else if(b.sparse) {
+            DenseMatrix<ValueType> * dense = toDense(b.sparse);
+            release(b);
+            b.type = BlockType::DENSE;
+            b.dense = dense;
+        }
+    }
+
+    /**
+     * @brief Chooses the representation of each block, see `compactBlock()`.
+     */
+    void compact() {
+        for(size_t rb = 0; rb < numRowBlocks; rb++)
+            for(size_t cb = 0; cb < numColBlocks; cb++)
+                compactBlock(rb, cb);
+    }
+
+    /**
+     * @brief Returns the given block as a dense one, converting it (or
+     * allocating zeros for an empty block) if necessary.
+     */
+    DenseMatrix<ValueType> * densifyBlock(size_t rowBlock, size_t colBlock) {
+        Block & b = getBlock(rowBlock, colBlock);
+        if(b.type == BlockType::DENSE)
+            return b.dense;
+        DenseMatrix<ValueType> * dense = b.sparse ? toDense(b.sparse)
+                : DataObjectFactory::create<DenseMatrix<ValueType>>(
+                        getBlockNumRows(rowBlock), getBlockNumCols(colBlock), true);
+        release(b);
+        b.type = BlockType::DENSE;
+        b.dense = dense;
+        return dense;
+    }
+
+    /**
+     * @brief Returns the given block as a `DenseMatrix`, converting it (or
+     * allocating zeros for an empty block) if necessary.
+     *
+     * The caller must destroy the returned matrix, which is the block itself
+     * (with an additional reference) if it is dense.
+     */
+    const DenseMatrix<ValueType> * getBlockAsDense(size_t rowBlock, size_t colBlock) const {
+        const Block & b = getBlock(rowBlock, colBlock);
+        if(b.dense) {
+            b.dense->increaseRefCounter();
+            return b.dense;
+        }
+        if(b.sparse)
+            return toDense(b.sparse);
+        return DataObjectFactory::create<DenseMatrix<ValueType>>(
+                getBlockNumRows(rowBlock), getBlockNumCols(colBlock), true);
+    }
+
+    size_t getNumNonZeros() const {
+        size_t nnz = 0;
+        for(const Block & b : blocks)
+            if(b.dense)
+                nnz += countNonZeros(b.dense);
+            else if(b.sparse)
+                nnz += b.sparse->getNumNonZeros();
+        return nnz;
+    }
+
+    ValueType get(size_t rowIdx, size_t colIdx) const override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        const Block & b = getBlock(rowIdx / blockSize, colIdx / blockSize);
+        if(b.dense)
+            return b.dense->get(rowIdx % blockSize, colIdx % blockSize);
+        if(b.sparse)
+            return b.sparse->get(rowIdx % blockSize, colIdx % blockSize);
+        return ValueType(0);
+    }
+
+    void set(size_t rowIdx, size_t colIdx, ValueType value) override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        const size_t rowBlock = rowIdx / blockSize;
+        const size_t colBlock = colIdx / blockSize;
+        if(value == ValueType(0) && getBlockType(rowBlock, colBlock) == BlockType::EMPTY)
+            return;
+        densifyBlock(rowBlock, colBlock)->set(rowIdx % blockSize, colIdx % blockSize, value);
+    }
+
+    void prepareAppend() override {
+        for(size_t i = 0; i < blocks.size(); i++)
+            release(blocks[i]);
+        appended.clear();
+        appended.resize(blocks.size());
+    }
+
+    void append(size_t rowIdx, size_t colIdx, ValueType value) override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        if(value == ValueType(0))
+            return;
+        const size_t rowBlock = rowIdx / blockSize;
+        const size_t colBlock = colIdx / blockSize;
+        appended[rowBlock * numColBlocks + colBlock].emplace_back(rowIdx % blockSize, colIdx % blockSize, value);
+    }
+
+    void finishAppend() override {
+        for(size_t rb = 0; rb < numRowBlocks; rb++)
+            for(size_t cb = 0; cb < numColBlocks; cb++) {
+                auto & entries = appended[rb * numColBlocks + cb];
+                if(entries.empty())
+                    continue;
+                const size_t rows = getBlockNumRows(rb);
+                const size_t cols = getBlockNumCols(cb);
+                Block & b = getBlock(rb, cb);
+                if(entries.size() <= SPARSITY_THRESHOLD * rows * cols) {
+                    // stable, such that entries appended in row-major order keep their order
+                    std::stable_sort(entries.begin(), entries.end(), [](const auto & lhs, const auto & rhs) {
+                        return std::get<0>(lhs) < std::get<0>(rhs);
+                    });
+                    b.type = BlockType::SPARSE;
+                    b.sparse = DataObjectFactory::create<CSRMatrix<ValueType>>(rows, cols, entries.size(), false);
+                    ValueType * values = b.sparse->getValues();
+                    size_t * colIdxs = b.sparse->getColIdxs();
+                    size_t * rowOffsets = b.sparse->getRowOffsets();
+                    std::fill(rowOffsets, rowOffsets + rows + 1, 0);
+                    for(size_t i = 0; i < entries.size(); i++) {
+                        values[i] = std::get<2>(entries[i]);
+                        colIdxs[i] = std::get<1>(entries[i]);
+                        rowOffsets[std::get<0>(entries[i]) + 1]++;
+                    }
+                    for(size_t r = 0; r < rows; r++)
+                        rowOffsets[r + 1] += rowOffsets[r];
+                }
+                else {
+                    b.type = BlockType::DENSE;
+                    b.dense = DataObjectFactory::create<DenseMatrix<ValueType>>(rows, cols, true);
+                    ValueType * values = b.dense->getValues();
+                    for(const auto & [r, c, v] : entries)
+                        values[r * cols + c] = v;
+                }
+                std::vector<std::tuple<size_t, size_t, ValueType>>().swap(entries);
+            }
+        appended.clear();
+    }
+
+    void print(std::ostream & os) const override {
+        os << "BlockedMatrix(" << numRows << 'x' << numCols << ", "
+                << ValueTypeUtils::cppNameFor<ValueType> << ')' << std::endl;
+        for(size_t r = 0; r < numRows; r++) {
+            for(size_t c = 0; c < numCols; c++) {
+                const ValueType val = get(r, c);
+                switch(ValueTypeUtils::codeFor<ValueType>) {
+                    case ValueTypeCode::SI8 : os << static_cast<int32_t>(val); break;
+                    case ValueTypeCode::UI8 : os << static_cast<uint32_t>(val); break;
+                    default : os << val; break;
+                }
+                if(c < numCols - 1)
+                    os << ' ';
+            }
+            os << std::endl;
+        }
+    }
+
+    BlockedMatrix* sliceRow(size_t rl, size_t ru) const override {
+        throw std::runtime_error("BlockedMatrix does not support sliceRow yet");
+    }
+
+    BlockedMatrix* sliceCol(size_t cl, size_t cu) const override {
+        throw std::runtime_error("BlockedMatrix does not support sliceCol yet");
+    }
+
+    BlockedMatrix* slice(size_t rl, size_t ru, size_t cl, size_t cu) const override {
+        throw std::runtime_error("BlockedMatrix does not support slice yet");
+    }
+};
+
+template <typename ValueType>
+std::ostream & operator<<(std::ostream & os, const BlockedMatrix<ValueType> & obj)
+{
+    obj.print(os);
+    return os;
+}
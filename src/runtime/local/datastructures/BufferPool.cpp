@@ -0,0 +1,234 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/MemoryTracker.h>
+
+#include <algorithm>
+#include <functional>
+#include <new>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <sys/mman.h>
+
+// the maximum size of the cached arrays unless set otherwise, see DaphneUserConfig::buffer_pool_max_cached_bytes
+static constexpr size_t DEFAULT_MAX_CACHED_BYTES = size_t(512) << 20;
+
+static thread_local size_t threadAllocatedBytes = 0;
+
+BufferPool::BufferPool() : maxCachedBytes(DEFAULT_MAX_CACHED_BYTES), useHugePages(true) {}
+
+BufferPool & BufferPool::get() {
+    static BufferPool * pool = new BufferPool();
+    return *pool;
+}
+
+size_t BufferPool::getSizeClass(size_t numBytes) {
+    if(numBytes < MIN_POOLED_BYTES)
+        return numBytes;
+    // four classes per power of two, i.e., at most 25% of the array are unused
+    size_t highBit = 63 - __builtin_clzll(numBytes);
+    const size_t step = size_t(1) << (highBit - 2);
+    const size_t classBytes = (numBytes + step - 1) / step * step;
+    if(classBytes >= HUGE_PAGE_BYTES)
+        return (classBytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    return classBytes;
+}
+
+void * BufferPool::allocateFresh(size_t classBytes) {
+    if(classBytes < HUGE_PAGE_BYTES) {
+        // the size classes below the huge pages are multiples of the alignment
+        void * ptr = std::aligned_alloc(ALIGNMENT, classBytes);
+        if(!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+    // Map one huge page more than needed and unmap the unaligned head and tail, such that the array is made of
+    // whole huge pages.
+    const size_t mapBytes = classBytes + HUGE_PAGE_BYTES;
+    void * map = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(map == MAP_FAILED)
+        throw std::bad_alloc();
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(map);
+    const uintptr_t aligned = (begin + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    if(aligned > begin)
+        munmap(map, aligned - begin);
+    if(aligned + classBytes < begin + mapBytes)
+        munmap(reinterpret_cast<void *>(aligned + classBytes), begin + mapBytes - aligned - classBytes);
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    bool advise;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        advise = useHugePages;
+    }
+    madvise(reinterpret_cast<void *>(aligned), classBytes, advise ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#endif
+    return reinterpret_cast<void *>(aligned);
+}
+
+void BufferPool::freeFresh(void * ptr, size_t classBytes) {
+    if(classBytes < HUGE_PAGE_BYTES)
+        std::free(ptr);
+    else
+        munmap(ptr, classBytes);
+}
+
+size_t BufferPool::getThreadAllocatedBytes() {
+    return threadAllocatedBytes;
+}
+
+void * BufferPool::allocate(size_t numBytes) {
+    // may free the cached arrays to stay within the memory limit, thus, it must not happen under mtx
+    if(MemoryTracker::isEnabled())
+        MemoryTracker::get().allocate(ALLOCATION_TYPE::HOST, numBytes);
+    threadAllocatedBytes += numBytes;
+    if(numBytes < MIN_POOLED_BYTES) {
+        const size_t alignedBytes = (std::max<size_t>(numBytes, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        void * ptr = std::aligned_alloc(ALIGNMENT, alignedBytes);
+        if(!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+    const size_t classBytes = getSizeClass(numBytes);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.numRequests++;
+        auto it = freeLists.find(classBytes);
+        if(it != freeLists.end() && !it->second.empty()) {
+            void * ptr = it->second.back();
+            it->second.pop_back();
+            stats.numHits++;
+            stats.cachedBytes -= classBytes;
+            return ptr;
+        }
+        if(classBytes >= HUGE_PAGE_BYTES)
+            stats.hugePageBytes += classBytes;
+    }
+    return allocateFresh(classBytes);
+}
+
+void BufferPool::release(void * ptr, size_t numBytes) {
+    if(MemoryTracker::isEnabled())
+        MemoryTracker::get().release(ALLOCATION_TYPE::HOST, numBytes);
+    if(numBytes < MIN_POOLED_BYTES) {
+        std::free(ptr);
+        return;
+    }
+    const size_t classBytes = getSizeClass(numBytes);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<void *> & freeList = freeLists[classBytes];
+        auto itRes = reservations.find(classBytes);
+        const bool reserved = itRes != reservations.end() && freeList.size() < itRes->second;
+        if(reserved || stats.cachedBytes + classBytes <= maxCachedBytes) {
+            freeList.push_back(ptr);
+            stats.cachedBytes += classBytes;
+            stats.peakCachedBytes = std::max(stats.peakCachedBytes, stats.cachedBytes);
+            return;
+        }
+        stats.numEvictions++;
+        if(classBytes >= HUGE_PAGE_BYTES)
+            stats.hugePageBytes -= classBytes;
+    }
+    freeFresh(ptr, classBytes);
+}
+
+void BufferPool::trim(bool keepReserved) {
+    // frees the largest arrays first, they matter the most for the memory footprint
+    std::vector<size_t> classes;
+    for(auto & entry : freeLists)
+        classes.push_back(entry.first);
+    std::sort(classes.begin(), classes.end(), std::greater<size_t>());
+    for(size_t classBytes : classes) {
+        std::vector<void *> & freeList = freeLists[classBytes];
+        size_t numKept = 0;
+        if(keepReserved) {
+            auto itRes = reservations.find(classBytes);
+            if(itRes != reservations.end())
+                numKept = itRes->second;
+        }
+        while(stats.cachedBytes > maxCachedBytes && freeList.size() > numKept) {
+            freeFresh(freeList.back(), classBytes);
+            freeList.pop_back();
+            stats.cachedBytes -= classBytes;
+            if(classBytes >= HUGE_PAGE_BYTES)
+                stats.hugePageBytes -= classBytes;
+        }
+    }
+}
+
+void BufferPool::reserve(size_t numBytes, size_t count) {
+    if(numBytes < MIN_POOLED_BYTES || !count)
+        return;
+    std::lock_guard<std::mutex> lock(mtx);
+    reservations[getSizeClass(numBytes)] += count;
+}
+
+void BufferPool::unreserve(size_t numBytes, size_t count) {
+    if(numBytes < MIN_POOLED_BYTES || !count)
+        return;
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = reservations.find(getSizeClass(numBytes));
+    if(it == reservations.end())
+        return;
+    if(it->second <= count)
+        reservations.erase(it);
+    else
+        it->second -= count;
+    trim(true);
+}
+
+size_t BufferPool::getMaxCachedBytes() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return maxCachedBytes;
+}
+
+void BufferPool::setMaxCachedBytes(size_t maxCachedBytes) {
+    std::lock_guard<std::mutex> lock(mtx);
+    this->maxCachedBytes = maxCachedBytes;
+    trim(true);
+}
+
+void BufferPool::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    const size_t maxCachedBytesBefore = maxCachedBytes;
+    maxCachedBytes = 0;
+    trim(false);
+    maxCachedBytes = maxCachedBytesBefore;
+}
+
+bool BufferPool::getUseHugePages() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return useHugePages;
+}
+
+void BufferPool::setUseHugePages(bool useHugePages) {
+    std::lock_guard<std::mutex> lock(mtx);
+    this->useHugePages = useHugePages;
+}
+
+BufferPool::Stats BufferPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
+
+void BufferPool::Stats::print(std::ostream & os) const {
+    os << "BufferPool: " << numHits << " of " << numRequests << " requests served from the cache, "
+            << numEvictions << " evictions, " << (cachedBytes >> 20) << " MiB cached (peak "
+            << (peakCachedBytes >> 20) << " MiB), " << (hugePageBytes >> 20) << " MiB in huge pages" << std::endl;
+}
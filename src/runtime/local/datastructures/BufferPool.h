@@ -0,0 +1,161 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+
+/**
+ * @brief A process-wide cache of the value arrays of data objects.
+ *
+ * Loops that create and drop intermediates of the same shape in every
+ * iteration would otherwise allocate (and page-fault) fresh memory in every
+ * iteration. Arrays of at least `MIN_POOLED_BYTES` are rounded up to a size
+ * class (four per power of two) and, when their last `std::shared_ptr` dies,
+ * kept for the next request of the same size class, as long as the cache holds
+ * at most `getMaxCachedBytes()`. Arrays of at least `HUGE_PAGE_BYTES` are
+ * mapped separately and aligned to huge pages, which the kernel may back by
+ * transparent huge pages (see `setUseHugePages()`). Smaller arrays are left to
+ * the regular allocator. All arrays are aligned to `ALIGNMENT` bytes, i.e., to
+ * cache lines and the widest SIMD registers.
+ *
+ * The compiler reserves the arrays a loop body needs at the same time (see
+ * `reserve()`), which are cached beyond `getMaxCachedBytes()` until the loop
+ * is done, such that large intermediates are not unmapped and mapped again in
+ * every iteration.
+ */
+class BufferPool {
+public:
+    static constexpr size_t MIN_POOLED_BYTES = 64 * 1024;
+    static constexpr size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+    static constexpr size_t ALIGNMENT = 64;
+
+    struct Stats {
+        // requests for arrays of a pooled size
+        size_t numRequests = 0;
+        // requests served from the cache
+        size_t numHits = 0;
+        // returned arrays freed since they did not fit into the cache
+        size_t numEvictions = 0;
+        size_t cachedBytes = 0;
+        size_t peakCachedBytes = 0;
+        // the memory in arrays of whole huge pages, in use or cached
+        size_t hugePageBytes = 0;
+
+        void print(std::ostream & os) const;
+    };
+
+private:
+    mutable std::mutex mtx;
+    size_t maxCachedBytes;
+    bool useHugePages;
+    // the cached arrays by their size class
+    std::unordered_map<size_t, std::vector<void *>> freeLists;
+    // the number of arrays reserved by size class, which are cached in any case
+    std::unordered_map<size_t, size_t> reservations;
+    Stats stats;
+
+    BufferPool();
+
+    void * allocateFresh(size_t classBytes);
+    static void freeFresh(void * ptr, size_t classBytes);
+    void trim(bool keepReserved);
+
+public:
+    BufferPool(const BufferPool &) = delete;
+    BufferPool & operator=(const BufferPool &) = delete;
+
+    /**
+     * @brief Returns the process-wide pool, which lives until the process
+     * ends (such that static data objects can still return their arrays).
+     */
+    static BufferPool & get();
+
+    /**
+     * @brief Returns the size of the array actually allocated for a request
+     * of the given size.
+     */
+    static size_t getSizeClass(size_t numBytes);
+
+    void * allocate(size_t numBytes);
+
+    /**
+     * @brief Returns the number of bytes of the arrays requested by the
+     * calling thread so far, see KernelProfiler.
+     */
+    static size_t getThreadAllocatedBytes();
+
+    void release(void * ptr, size_t numBytes);
+
+    /**
+     * @brief Allocates an uninitialized array of the given number of elements,
+     * which goes back to the pool when the last `std::shared_ptr` to it dies.
+     */
+    template<typename VT>
+    std::shared_ptr<VT[]> allocShared(size_t numElements) {
+        static_assert(std::is_trivially_default_constructible<VT>::value && std::is_trivially_destructible<VT>::value,
+                "only arrays of trivial types can be pooled");
+        const size_t numBytes = numElements * sizeof(VT);
+        return std::shared_ptr<VT[]>(static_cast<VT *>(allocate(numBytes)), [numBytes](VT * ptr) {
+            BufferPool::get().release(ptr, numBytes);
+        });
+    }
+
+    /**
+     * @brief Reserves the given number of arrays of the size class of the
+     * given size, i.e., up to that many returned arrays of this size class are
+     * cached even beyond `getMaxCachedBytes()`. Reservations add up until they
+     * are undone by `unreserve()`.
+     */
+    void reserve(size_t numBytes, size_t count);
+
+    /**
+     * @brief Undoes a `reserve()` of the same arguments, freeing cached arrays
+     * beyond the maximum size of the cache.
+     */
+    void unreserve(size_t numBytes, size_t count);
+
+    size_t getMaxCachedBytes() const;
+
+    /**
+     * @brief Sets the maximum size of the cached arrays, freeing cached arrays
+     * beyond it. Zero disables the caching.
+     */
+    void setMaxCachedBytes(size_t maxCachedBytes);
+
+    /**
+     * @brief Frees all cached arrays, reserved or not.
+     */
+    void clear();
+
+    bool getUseHugePages() const;
+
+    /**
+     * @brief Sets whether arrays of whole huge pages are advised to be backed
+     * by transparent huge pages (`MADV_HUGEPAGE`) or not (`MADV_NOHUGEPAGE`),
+     * which takes effect for arrays allocated afterwards.
+     */
+    void setUseHugePages(bool useHugePages);
+
+    Stats getStats() const;
+};
@@ -16,17 +16,50 @@
 
 #pragma once
 
+#include <runtime/local/datastructures/BufferPool.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/IAllocationDescriptor.h>
 #include <runtime/local/datastructures/Matrix.h>
+#include <runtime/local/datastructures/SellCSigma.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 
 #include <algorithm>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <limits>
+
+/**
+ * @brief A copy of the arrays of a `CSRMatrix` in another memory (e.g., of a
+ * GPU), see `CSRMatrix::getPlacement()`.
+ *
+ * The copy holds exactly the non-zeros of the matrix and its row offsets start
+ * at zero, even if the matrix is a view on a larger `CSRMatrix`.
+ */
+template<typename ValueType>
+struct CSRPlacement {
+    std::unique_ptr<IAllocationDescriptor> values;
+    std::unique_ptr<IAllocationDescriptor> colIdxs;
+    std::unique_ptr<IAllocationDescriptor> rowOffsets;
+
+    const ValueType * getValues() const {
+        return reinterpret_cast<const ValueType *>(values->getData().get());
+    }
+
+    const size_t * getColIdxs() const {
+        return reinterpret_cast<const size_t *>(colIdxs->getData().get());
+    }
+
+    const size_t * getRowOffsets() const {
+        return reinterpret_cast<const size_t *>(rowOffsets->getData().get());
+    }
+};
 
 /**
  * @brief A sparse matrix in Compressed Sparse Row (CSR) format.
@@ -44,6 +77,17 @@
  * `CSRMatrix`. Thus, to traverse the matrix by row, you can safely go via the
  * `rowOffsets`, but for traversing the matrix by non-zero value, you must
  * start at `values[rowOffsets[0]`.
+ * 
+ * For column-wise access, a matrix can build and cache its transposition
+ * (i.e., a CSC representation of itself), see `getTransposed()`. The cache is
+ * dropped whenever the matrix is accessed through one of its non-const
+ * accessors. Writes through views on the same arrays are not tracked, which is
+ * why views never cache their transposition.
+ *
+ * Likewise, a matrix caches the copies of its arrays in other memories (e.g.,
+ * of a GPU) made by `getPlacement()`, a copy of its column indexes in 32
+ * bits, see `getCompactColIdxs()`, and its SELL-C-sigma representation, see
+ * `getSell()`.
  */
 template<typename ValueType>
 class CSRMatrix : public Matrix<ValueType> {
@@ -72,6 +116,45 @@ class CSRMatrix : public Matrix<ValueType> {
     std::shared_ptr<size_t> rowOffsets;
     
     size_t lastAppendedRowIdx;
+    
+    /**
+     * @brief The cached transposition of this matrix, if built by
+     * `getTransposed()` since the last write.
+     */
+    mutable std::shared_ptr<const CSRMatrix<ValueType>> transposed;
+    mutable std::mutex transposedMutex;
+
+    /**
+     * @brief The cached copies of this matrix in other memories, if made by
+     * `getPlacement()` since the last write.
+     */
+    mutable std::vector<std::shared_ptr<const CSRPlacement<ValueType>>> placements;
+    mutable std::mutex placementsMutex;
+
+    /**
+     * @brief The cached 32-bit copy of `colIdxs`, if built by
+     * `getCompactColIdxs()` since the last write, and whether it was requested
+     * once before.
+     */
+    mutable std::shared_ptr<const uint32_t> compactColIdxs;
+    mutable bool compactColIdxsRequested = false;
+    mutable std::mutex compactColIdxsMutex;
+
+    /**
+     * @brief The cached SELL-C-sigma representation of this matrix, if built
+     * by `getSell()` since the last write, whether it was requested once
+     * before, and whether it was rejected due to too much padding.
+     */
+    mutable std::shared_ptr<const SellCSigma<ValueType>> sell;
+    mutable bool sellRequested = false;
+    mutable bool sellRejected = false;
+    mutable std::mutex sellMutex;
+
+    template<typename VT>
+    static std::shared_ptr<VT> allocPooled(size_t numElements) {
+        std::shared_ptr<VT[]> array = BufferPool::get().allocShared<VT>(numElements);
+        return std::shared_ptr<VT>(array, array.get());
+    }
 
     // Grant DataObjectFactory access to the private constructors and
     // destructors.
@@ -96,9 +179,9 @@ class CSRMatrix : public Matrix<ValueType> {
             numRowsAllocated(maxNumRows),
             isRowAllocatedBefore(false),
             maxNumNonZeros(maxNumNonZeros),
-            values(new ValueType[maxNumNonZeros], std::default_delete<ValueType[]>()),
-            colIdxs(new size_t[maxNumNonZeros], std::default_delete<size_t[]>()),
-            rowOffsets(new size_t[numRows + 1], std::default_delete<size_t[]>()),
+            values(allocPooled<ValueType>(maxNumNonZeros)),
+            colIdxs(allocPooled<size_t>(maxNumNonZeros)),
+            rowOffsets(allocPooled<size_t>(numRows + 1)),
             lastAppendedRowIdx(0)
     {
         if(zero) {
@@ -108,6 +191,31 @@ class CSRMatrix : public Matrix<ValueType> {
         }
     }
     
+    /**
+     * @brief Creates a `CSRMatrix` around existing internal arrays without
+     * copying the data.
+     *
+     * @param numRows The exact number of rows.
+     * @param numCols The exact number of columns.
+     * @param numNonZeros The exact number of non-zeros in the matrix.
+     * @param values An array of `numNonZeros` values.
+     * @param colIdxs An array of `numNonZeros` column indexes.
+     * @param rowOffsets An array of `numRows + 1` row offsets, starting at zero.
+     */
+    CSRMatrix(size_t numRows, size_t numCols, size_t numNonZeros, std::shared_ptr<ValueType> values,
+            std::shared_ptr<size_t> colIdxs, std::shared_ptr<size_t> rowOffsets) :
+            Matrix<ValueType>(numRows, numCols),
+            numRowsAllocated(numRows),
+            isRowAllocatedBefore(false),
+            maxNumNonZeros(numNonZeros),
+            values(values),
+            colIdxs(colIdxs),
+            rowOffsets(rowOffsets),
+            lastAppendedRowIdx(0)
+    {
+        // nothing to do
+    }
+
     /**
      * @brief Creates a `CSRMatrix` around a sub-matrix of another `CSRMatrix`
      * without copying the data.
@@ -131,12 +239,82 @@ class CSRMatrix : public Matrix<ValueType> {
         values = src->values;
         colIdxs = src->colIdxs;
         rowOffsets = std::shared_ptr<size_t>(src->rowOffsets, src->rowOffsets.get() + rowLowerIncl);
+        // the compact column indexes are positioned like colIdxs, so a view can share those of its source
+        compactColIdxs = src->getCachedCompactColIdxs();
     }
-    
+
+    /**
+     * @brief Creates a `CSRMatrix` with the sparsity structure of another `CSRMatrix` and new values, which are not
+     * initialized.
+     *
+     * The column indexes are shared with `src` without copying them, and so are the row offsets, unless `src` is a
+     * view whose non-zeros do not start at the beginning of its arrays. Like for a view, changing the structure of
+     * the new matrix (e.g., by `set()`) changes the one of `src`.
+     *
+     * @param src The other `CSRMatrix`.
+     */
+    CSRMatrix(const CSRMatrix<ValueType> * src) :
+            Matrix<ValueType>(src->numRows, src->numCols),
+            isRowAllocatedBefore(false),
+            lastAppendedRowIdx(0)
+    {
+        assert(src && "src must not be null");
+        const size_t * rowOffsetsSrc = src->rowOffsets.get();
+        const size_t firstPos = rowOffsetsSrc[0];
+        maxNumNonZeros = rowOffsetsSrc[numRows] - firstPos;
+        values = allocPooled<ValueType>(maxNumNonZeros);
+        if(firstPos == 0) {
+            numRowsAllocated = src->numRowsAllocated;
+            colIdxs = src->colIdxs;
+            rowOffsets = src->rowOffsets;
+            compactColIdxs = src->getCachedCompactColIdxs();
+        }
+        else {
+            numRowsAllocated = numRows;
+            colIdxs = std::shared_ptr<size_t>(src->colIdxs, src->colIdxs.get() + firstPos);
+            rowOffsets = allocPooled<size_t>(numRows + 1);
+            for(size_t r = 0; r <= numRows; r++)
+                rowOffsets.get()[r] = rowOffsetsSrc[r] - firstPos;
+        }
+    }
+
     virtual ~CSRMatrix() {
         // nothing to do
     }
     
+    void invalidateCaches() {
+        if(transposed) {
+            std::lock_guard<std::mutex> lock(transposedMutex);
+            transposed.reset();
+        }
+        if(!placements.empty()) {
+            std::lock_guard<std::mutex> lock(placementsMutex);
+            placements.clear();
+        }
+        if(compactColIdxs || compactColIdxsRequested) {
+            std::lock_guard<std::mutex> lock(compactColIdxsMutex);
+            compactColIdxs.reset();
+            compactColIdxsRequested = false;
+        }
+        if(sell || sellRequested) {
+            std::lock_guard<std::mutex> lock(sellMutex);
+            sell.reset();
+            sellRequested = false;
+            sellRejected = false;
+        }
+    }
+
+    template<typename VT>
+    static std::unique_ptr<IAllocationDescriptor> copyTo(const IAllocationDescriptor * allocInfo, const VT * src,
+            size_t numElements) {
+        auto dst = allocInfo->clone();
+        // we allocate at least one element, such that empty arrays have a valid address, too
+        dst->createAllocation(std::max<size_t>(numElements, 1) * sizeof(VT), false);
+        if(numElements)
+            dst->transferTo(reinterpret_cast<std::byte *>(const_cast<VT *>(src)), numElements * sizeof(VT));
+        return dst;
+    }
+    
     void fillNextPosUntil(size_t nextPos, size_t rowIdx) {
         if(rowIdx > lastAppendedRowIdx) {
             for(size_t r = lastAppendedRowIdx + 2; r <= rowIdx + 1; r++)
@@ -169,6 +347,7 @@ public:
     }
 
     ValueType * getValues() {
+        invalidateCaches();
         return values.get();
     }
     
@@ -177,16 +356,18 @@ public:
     }
     
     ValueType * getValues(size_t rowIdx) {
-        // We allow equality here to enable retrieving a pointer to the end.
-        assert((rowIdx <= numRows) && "rowIdx is out of bounds");
-        return values.get() + rowOffsets.get()[rowIdx];
+        invalidateCaches();
+        return const_cast<ValueType *>(static_cast<const CSRMatrix<ValueType> *>(this)->getValues(rowIdx));
     }
     
     const ValueType * getValues(size_t rowIdx) const {
-        return const_cast<CSRMatrix<ValueType> *>(this)->getValues(rowIdx);
+        // We allow equality here to enable retrieving a pointer to the end.
+        assert((rowIdx <= numRows) && "rowIdx is out of bounds");
+        return values.get() + rowOffsets.get()[rowIdx];
     }
     
     size_t * getColIdxs() {
+        invalidateCaches();
         return colIdxs.get();
     }
     
@@ -195,16 +376,18 @@ public:
     }
     
     size_t * getColIdxs(size_t rowIdx) {
-        // We allow equality here to enable retrieving a pointer to the end.
-        assert((rowIdx <= numRows) && "rowIdx is out of bounds");
-        return colIdxs.get() + rowOffsets.get()[rowIdx];
+        invalidateCaches();
+        return const_cast<size_t *>(static_cast<const CSRMatrix<ValueType> *>(this)->getColIdxs(rowIdx));
     }
 
     const size_t * getColIdxs(size_t rowIdx) const {
-        return const_cast<CSRMatrix<ValueType> *>(this)->getColIdxs(rowIdx);
+        // We allow equality here to enable retrieving a pointer to the end.
+        assert((rowIdx <= numRows) && "rowIdx is out of bounds");
+        return colIdxs.get() + rowOffsets.get()[rowIdx];
     }
 
     size_t * getRowOffsets() {
+        invalidateCaches();
         return rowOffsets.get();
     }
 
@@ -281,6 +464,7 @@ public:
     }
     
     void prepareAppend() override {
+        invalidateCaches();
         if(isRowAllocatedBefore)
             // In this case, we assume that the matrix has been populated up to
             // just before this view.
@@ -300,6 +484,7 @@ public:
         if(value == ValueType(0))
             return;
         
+        invalidateCaches();
         const size_t nextPos = rowOffsets.get()[lastAppendedRowIdx + 1];
         fillNextPosUntil(nextPos, rowIdx);
         
@@ -316,6 +501,163 @@ public:
         return (numRowsAllocated > numRows || isRowAllocatedBefore);
     }
     
+    /**
+     * @brief Writes the transposition of this matrix into `res`, which must
+     * have been allocated for `numCols` rows, `numRows` columns, and at least
+     * as many non-zeros as this matrix.
+     */
+    void transposeInto(CSRMatrix<ValueType> * res) const {
+        const ValueType * valuesArg = values.get();
+        const size_t * colIdxsArg = colIdxs.get();
+        const size_t * rowOffsetsArg = rowOffsets.get();
+        
+        ValueType * valuesRes = res->getValues();
+        size_t * colIdxsRes = res->getColIdxs();
+        size_t * rowOffsetsRes = res->getRowOffsets();
+        
+        // a counting sort of the non-zeros by their column
+        std::fill(rowOffsetsRes, rowOffsetsRes + numCols + 1, 0);
+        for(size_t i = rowOffsetsArg[0]; i < rowOffsetsArg[numRows]; i++)
+            rowOffsetsRes[colIdxsArg[i] + 1]++;
+        for(size_t c = 0; c < numCols; c++)
+            rowOffsetsRes[c + 1] += rowOffsetsRes[c];
+        
+        std::vector<size_t> nextPos(rowOffsetsRes, rowOffsetsRes + numCols);
+        for(size_t r = 0; r < numRows; r++)
+            for(size_t i = rowOffsetsArg[r]; i < rowOffsetsArg[r + 1]; i++) {
+                const size_t pos = nextPos[colIdxsArg[i]]++;
+                valuesRes[pos] = valuesArg[i];
+                colIdxsRes[pos] = r;
+            }
+    }
+    
+    /**
+     * @brief Returns the transposition of this matrix, which (unless this
+     * matrix is a view) is built once and cached until the next write to this
+     * matrix, turning repeated column-wise accesses into a one-time cost.
+     */
+    std::shared_ptr<const CSRMatrix<ValueType>> getTransposed() const {
+        std::lock_guard<std::mutex> lock(transposedMutex);
+        if(transposed)
+            return transposed;
+        auto res = DataObjectFactory::create<CSRMatrix<ValueType>>(numCols, numRows, getNumNonZeros(), false);
+        transposeInto(res);
+        std::shared_ptr<const CSRMatrix<ValueType>> ptr(res, [](const CSRMatrix<ValueType> * m) {
+            DataObjectFactory::destroy(m);
+        });
+        if(!isView())
+            transposed = ptr;
+        return ptr;
+    }
+    
+    /**
+     * @brief Returns the cached transposition of this matrix, or `nullptr` if
+     * there is none.
+     */
+    std::shared_ptr<const CSRMatrix<ValueType>> getCachedTransposed() const {
+        std::lock_guard<std::mutex> lock(transposedMutex);
+        return transposed;
+    }
+    
+    /**
+     * @brief Returns a copy of this matrix in the memory described by
+     * `allocInfo` (e.g., of a GPU), which (unless this matrix is a view) is
+     * made once and cached until the next write to this matrix, such that
+     * repeated operations on the device do not transfer the matrix again.
+     */
+    std::shared_ptr<const CSRPlacement<ValueType>> getPlacement(const IAllocationDescriptor * allocInfo) const {
+        std::lock_guard<std::mutex> lock(placementsMutex);
+        for(auto & placement : placements)
+            if(*placement->values == allocInfo)
+                return placement;
+
+        const size_t numNonZeros = getNumNonZeros();
+        const size_t offset = rowOffsets.get()[0];
+        auto res = std::make_shared<CSRPlacement<ValueType>>();
+        res->values = copyTo(allocInfo, values.get() + offset, numNonZeros);
+        res->colIdxs = copyTo(allocInfo, colIdxs.get() + offset, numNonZeros);
+        if(offset) {
+            std::vector<size_t> rebased(rowOffsets.get(), rowOffsets.get() + numRows + 1);
+            for(auto & rowOffset : rebased)
+                rowOffset -= offset;
+            res->rowOffsets = copyTo(allocInfo, rebased.data(), numRows + 1);
+        }
+        else
+            res->rowOffsets = copyTo(allocInfo, rowOffsets.get(), numRows + 1);
+        if(!isView())
+            placements.push_back(res);
+        return res;
+    }
+
+    /**
+     * @brief Returns the column indexes of this matrix in 32 bits (positioned
+     * like `getColIdxs()`), which halves the memory traffic of the indexes in
+     * memory-bound kernels like sparse matrix-vector products, or `nullptr`.
+     *
+     * The copy is built on the second request since the last write to this
+     * matrix and cached until the next one, such that only repeated operations
+     * on the same matrix pay for the conversion. Views never build it, but
+     * share the copy of their source if it has one when they are created. The
+     * result is `nullptr` before the second request, for views without a
+     * shared copy, and for matrices with more than 2^32 columns.
+     */
+    std::shared_ptr<const uint32_t> getCompactColIdxs() const {
+        std::lock_guard<std::mutex> lock(compactColIdxsMutex);
+        if(compactColIdxs || isView() || numCols > std::numeric_limits<uint32_t>::max())
+            return compactColIdxs;
+        if(!compactColIdxsRequested) {
+            compactColIdxsRequested = true;
+            return nullptr;
+        }
+        const size_t numPositions = rowOffsets.get()[numRows];
+        std::shared_ptr<uint32_t> res = allocPooled<uint32_t>(std::max<size_t>(numPositions, 1));
+        const size_t * src = colIdxs.get();
+        uint32_t * dst = res.get();
+        for(size_t i = rowOffsets.get()[0]; i < numPositions; i++)
+            dst[i] = static_cast<uint32_t>(src[i]);
+        compactColIdxs = res;
+        return compactColIdxs;
+    }
+
+    /**
+     * @brief Returns the cached 32-bit column indexes of this matrix, or
+     * `nullptr` if there are none.
+     */
+    std::shared_ptr<const uint32_t> getCachedCompactColIdxs() const {
+        std::lock_guard<std::mutex> lock(compactColIdxsMutex);
+        return compactColIdxs;
+    }
+
+    /**
+     * @brief Returns the SELL-C-sigma representation of this matrix (see
+     * `SellCSigma`), whose sparse matrix-vector products vectorize regardless
+     * of the lengths of the rows, or `nullptr`.
+     *
+     * Like `getCompactColIdxs()`, the representation is built on the second
+     * request since the last write to this matrix and cached until the next
+     * one, such that only matrices multiplied repeatedly (e.g., in the loop of
+     * an iterative solver) are converted. The result is `nullptr` before the
+     * second request, for views, for matrices with more than 2^31 columns, and
+     * if the padding would more than double the number of stored values.
+     */
+    std::shared_ptr<const SellCSigma<ValueType>> getSell() const {
+        std::lock_guard<std::mutex> lock(sellMutex);
+        if(sell || sellRejected || isView() || numCols > std::numeric_limits<int32_t>::max())
+            return sell;
+        if(!sellRequested) {
+            sellRequested = true;
+            return nullptr;
+        }
+        auto res = std::make_shared<SellCSigma<ValueType>>(SellCSigma<ValueType>::fromCSR(numRows, values.get(),
+                colIdxs.get(), rowOffsets.get()));
+        if(res->numPadding > getNumNonZeros()) {
+            sellRejected = true;
+            return nullptr;
+        }
+        sell = res;
+        return sell;
+    }
+
     void printValue(std::ostream & os, ValueType val) const {
       switch (ValueTypeUtils::codeFor<ValueType>) {
         case ValueTypeCode::SI8 : os << static_cast<int32_t>(val); break;
@@ -378,6 +720,31 @@ public:
         return DataObjectFactory::create<CSRMatrix>(this, rl, ru);
     }
 
+    bool rebindRowView(const Structure* src, size_t rl, size_t ru) override {
+        invalidateCaches();
+        if(!src) {
+            values.reset();
+            colIdxs.reset();
+            rowOffsets.reset();
+            numRows = 0;
+            return true;
+        }
+        auto srcMat = dynamic_cast<const CSRMatrix<ValueType>*>(src);
+        if(!srcMat)
+            return false;
+        assert((rl < ru && ru <= srcMat->numRows) && "invalid row range");
+        numRows = ru - rl;
+        numCols = srcMat->numCols;
+        numRowsAllocated = srcMat->numRowsAllocated - rl;
+        isRowAllocatedBefore = rl > 0;
+        maxNumNonZeros = srcMat->maxNumNonZeros;
+        values = srcMat->values;
+        colIdxs = srcMat->colIdxs;
+        rowOffsets = std::shared_ptr<size_t>(srcMat->rowOffsets, srcMat->rowOffsets.get() + rl);
+        lastAppendedRowIdx = 0;
+        return true;
+    }
+
     CSRMatrix* sliceCol(size_t cl, size_t cu) const override {
         throw std::runtime_error("CSRMatrix does not support sliceCol yet");
     }
@@ -0,0 +1,458 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The compressed representations a column of a `Frame` can be stored
+ * in, see `Frame::encodeColumn()`.
+ *
+ * - `DICTIONARY`: the sorted distinct values and a bit-packed code per row,
+ *   for low-cardinality columns. The codes preserve the order of the values,
+ *   such that equality, grouping, and sorting can work on the codes.
+ * - `RUN_LENGTH`: one value per run of equal consecutive values, for sorted
+ *   or clustered columns.
+ * - `FRAME_OF_REFERENCE`: the minimum and the bit-packed difference of each
+ *   row to it, for integer columns of a narrow range (e.g., timestamps).
+ */
+enum class ColumnEncoding {
+    NONE,
+    DICTIONARY,
+    RUN_LENGTH,
+    FRAME_OF_REFERENCE,
+};
+
+/**
+ * @brief An array of unsigned integers of a fixed number of bits each, packed
+ * into 64-bit words.
+ */
+class BitPackedArray {
+    size_t numElements;
+    unsigned bitWidth;
+    // one word more than necessary, such that get() may always read two words
+    std::vector<uint64_t> words;
+
+public:
+    BitPackedArray(size_t numElements, unsigned bitWidth) :
+            numElements(numElements), bitWidth(bitWidth), words((numElements * bitWidth + 63) / 64 + 1, 0)
+    {
+        if(bitWidth > 64)
+            throw std::runtime_error("BitPackedArray: the bit width must be at most 64");
+    }
+
+    /**
+     * @brief Returns the number of bits needed to represent all values from
+     * zero to `maxValue`.
+     */
+    static unsigned bitWidthFor(uint64_t maxValue) {
+        unsigned width = 0;
+        for(; width < 64 && (maxValue >> width); width++);
+        return width;
+    }
+
+    size_t getNumElements() const {
+        return numElements;
+    }
+
+    unsigned getBitWidth() const {
+        return bitWidth;
+    }
+
+    size_t getSizeInBytes() const {
+        return words.size() * sizeof(uint64_t);
+    }
+
+    uint64_t get(size_t i) const {
+        if(bitWidth == 0)
+            return 0;
+        const size_t pos = i * bitWidth;
+        const size_t word = pos / 64;
+        const unsigned offset = pos % 64;
+        uint64_t value = words[word] >> offset;
+        if(offset + bitWidth > 64)
+            value |= words[word + 1] << (64 - offset);
+        return bitWidth == 64 ? value : value & ((uint64_t(1) << bitWidth) - 1);
+    }
+
+    /**
+     * @brief Sets the i-th element, which must not have been set before.
+     */
+    void init(size_t i, uint64_t value) {
+        if(bitWidth == 0)
+            return;
+        const size_t pos = i * bitWidth;
+        const size_t word = pos / 64;
+        const unsigned offset = pos % 64;
+        words[word] |= value << offset;
+        if(offset + bitWidth > 64)
+            words[word + 1] |= value >> (64 - offset);
+    }
+};
+
+/**
+ * @brief The value-type-independent interface of an encoded column.
+ *
+ * Encoded columns are immutable, such that frames (e.g., views) can share
+ * them.
+ */
+class EncodedColumn {
+protected:
+    const size_t numRows;
+
+    explicit EncodedColumn(size_t numRows) : numRows(numRows) {}
+
+public:
+    virtual ~EncodedColumn() = default;
+
+    size_t getNumRows() const {
+        return numRows;
+    }
+
+    virtual ColumnEncoding getEncoding() const = 0;
+
+    virtual ValueTypeCode getValueType() const = 0;
+
+    /**
+     * @brief Writes the values of the rows from `rowBegin` to `rowEnd` as a
+     * plain array of the column's value type to `dst`.
+     */
+    virtual void decode(void * dst, size_t rowBegin, size_t rowEnd) const = 0;
+
+    /**
+     * @brief Returns the memory held by this encoded column.
+     */
+    virtual size_t getSizeInBytes() const = 0;
+};
+
+/**
+ * @brief The value-type-independent part of a `DictionaryColumn`: the code of
+ * each row, such that kernels can work on the codes without knowing the value
+ * type.
+ */
+class DictionaryCodes : public EncodedColumn {
+protected:
+    const size_t dictionarySize;
+    BitPackedArray codes;
+
+    DictionaryCodes(size_t dictionarySize, BitPackedArray codes) :
+            EncodedColumn(codes.getNumElements()), dictionarySize(dictionarySize), codes(std::move(codes)) {}
+
+public:
+    ColumnEncoding getEncoding() const override {
+        return ColumnEncoding::DICTIONARY;
+    }
+
+    size_t getDictionarySize() const {
+        return dictionarySize;
+    }
+
+    size_t getCode(size_t rowIdx) const {
+        return codes.get(rowIdx);
+    }
+};
+
+/**
+ * @brief A column encoded by the sorted distinct values and a bit-packed code
+ * (the position of the value in the dictionary) per row.
+ *
+ * Since the dictionary is sorted, the order of the codes is the order of the
+ * values.
+ */
+template<typename VT>
+class DictionaryColumn : public DictionaryCodes {
+    std::shared_ptr<const std::vector<VT>> dictionary;
+
+public:
+    DictionaryColumn(std::shared_ptr<const std::vector<VT>> dictionary, BitPackedArray codes) :
+            DictionaryCodes(dictionary->size(), std::move(codes)), dictionary(std::move(dictionary)) {}
+
+    static std::shared_ptr<DictionaryColumn> encode(const VT * values, size_t numRows) {
+        auto dictionary = std::make_shared<std::vector<VT>>(values, values + numRows);
+        std::sort(dictionary->begin(), dictionary->end());
+        dictionary->erase(std::unique(dictionary->begin(), dictionary->end()), dictionary->end());
+        BitPackedArray codes(numRows, BitPackedArray::bitWidthFor(dictionary->empty() ? 0 : dictionary->size() - 1));
+        for(size_t r = 0; r < numRows; r++)
+            codes.init(r, std::lower_bound(dictionary->begin(), dictionary->end(), values[r]) - dictionary->begin());
+        return std::make_shared<DictionaryColumn>(std::move(dictionary), std::move(codes));
+    }
+
+    ValueTypeCode getValueType() const override {
+        return ValueTypeUtils::codeFor<VT>;
+    }
+
+    const std::shared_ptr<const std::vector<VT>> & getDictionary() const {
+        return dictionary;
+    }
+
+    VT get(size_t rowIdx) const {
+        return (*dictionary)[codes.get(rowIdx)];
+    }
+
+    /**
+     * @brief Returns the code of the given value, or the size of the
+     * dictionary if the value does not occur in this column.
+     */
+    size_t findCode(VT value) const {
+        auto it = std::lower_bound(dictionary->begin(), dictionary->end(), value);
+        return (it != dictionary->end() && *it == value) ? it - dictionary->begin() : dictionary->size();
+    }
+
+    /**
+     * @brief Evaluates `column == value` for the first `numRows` rows on the
+     * codes, writing 1 or 0 per row to `res`.
+     */
+    template<typename VTSel>
+    void selectEq(VT value, VTSel * res, size_t numRows) const {
+        const size_t code = findCode(value);
+        for(size_t r = 0; r < numRows; r++)
+            res[r] = codes.get(r) == code;
+    }
+
+    /**
+     * @brief Returns the rows among the first `numRows` rows whose `sel` is
+     * non-zero as a new column sharing this column's dictionary.
+     */
+    template<typename VTSel>
+    std::shared_ptr<DictionaryColumn> filter(const VTSel * sel, size_t numRows) const {
+        size_t numRowsRes = 0;
+        for(size_t r = 0; r < numRows; r++)
+            numRowsRes += sel[r] != VTSel(0);
+        BitPackedArray codesRes(numRowsRes, codes.getBitWidth());
+        for(size_t r = 0, pos = 0; r < numRows; r++)
+            if(sel[r])
+                codesRes.init(pos++, codes.get(r));
+        return std::make_shared<DictionaryColumn>(dictionary, std::move(codesRes));
+    }
+
+    /**
+     * @brief Returns the rows at the given (ascending) positions as a new
+     * column sharing this column's dictionary.
+     */
+    std::shared_ptr<DictionaryColumn> gather(const size_t * positions, size_t numPositions) const {
+        BitPackedArray codesRes(numPositions, codes.getBitWidth());
+        for(size_t i = 0; i < numPositions; i++)
+            codesRes.init(i, codes.get(positions[i]));
+        return std::make_shared<DictionaryColumn>(dictionary, std::move(codesRes));
+    }
+
+    void decode(void * dst, size_t rowBegin, size_t rowEnd) const override {
+        VT * res = static_cast<VT *>(dst);
+        for(size_t r = rowBegin; r < rowEnd; r++)
+            *res++ = (*dictionary)[codes.get(r)];
+    }
+
+    size_t getSizeInBytes() const override {
+        return codes.getSizeInBytes() + dictionary->size() * sizeof(VT);
+    }
+};
+
+/**
+ * @brief A column encoded by one value per run of equal consecutive values and
+ * the (exclusive) end row of each run.
+ */
+template<typename VT>
+class RunLengthColumn : public EncodedColumn {
+    std::vector<VT> values;
+    std::vector<size_t> runEnds;
+
+public:
+    RunLengthColumn(std::vector<VT> values, std::vector<size_t> runEnds) :
+            EncodedColumn(runEnds.empty() ? 0 : runEnds.back()), values(std::move(values)),
+            runEnds(std::move(runEnds)) {}
+
+    static std::shared_ptr<RunLengthColumn> encode(const VT * values, size_t numRows) {
+        std::vector<VT> runValues;
+        std::vector<size_t> runEnds;
+        for(size_t r = 0; r < numRows; r++) {
+            if(runValues.empty() || !(values[r] == runValues.back())) {
+                if(!runValues.empty())
+                    runEnds.push_back(r);
+                runValues.push_back(values[r]);
+            }
+        }
+        if(!runValues.empty())
+            runEnds.push_back(numRows);
+        return std::make_shared<RunLengthColumn>(std::move(runValues), std::move(runEnds));
+    }
+
+    ColumnEncoding getEncoding() const override {
+        return ColumnEncoding::RUN_LENGTH;
+    }
+
+    ValueTypeCode getValueType() const override {
+        return ValueTypeUtils::codeFor<VT>;
+    }
+
+    size_t getNumRuns() const {
+        return values.size();
+    }
+
+    const std::vector<VT> & getRunValues() const {
+        return values;
+    }
+
+    const std::vector<size_t> & getRunEnds() const {
+        return runEnds;
+    }
+
+    VT get(size_t rowIdx) const {
+        return values[std::upper_bound(runEnds.begin(), runEnds.end(), rowIdx) - runEnds.begin()];
+    }
+
+    /**
+     * @brief Evaluates `column == value` for the first `numRows` rows run by
+     * run, writing 1 or 0 per row to `res`.
+     */
+    template<typename VTSel>
+    void selectEq(VT value, VTSel * res, size_t numRows) const {
+        for(size_t i = 0, begin = 0; i < values.size() && begin < numRows; begin = runEnds[i++])
+            std::fill(res + begin, res + std::min(runEnds[i], numRows), VTSel(values[i] == value));
+    }
+
+    void decode(void * dst, size_t rowBegin, size_t rowEnd) const override {
+        VT * res = static_cast<VT *>(dst);
+        size_t i = std::upper_bound(runEnds.begin(), runEnds.end(), rowBegin) - runEnds.begin();
+        for(size_t r = rowBegin; r < rowEnd; i++) {
+            const size_t end = std::min(runEnds[i], rowEnd);
+            res = std::fill_n(res, end - r, values[i]);
+            r = end;
+        }
+    }
+
+    size_t getSizeInBytes() const override {
+        return values.size() * sizeof(VT) + runEnds.size() * sizeof(size_t);
+    }
+};
+
+/**
+ * @brief An integer column encoded by its minimum (the reference) and the
+ * bit-packed difference of each row to it.
+ */
+template<typename VT>
+class FrameOfReferenceColumn : public EncodedColumn {
+    static_assert(std::is_integral<VT>::value, "frame-of-reference encoding is only supported for integers");
+
+    VT reference;
+    BitPackedArray deltas;
+
+public:
+    FrameOfReferenceColumn(VT reference, BitPackedArray deltas) :
+            EncodedColumn(deltas.getNumElements()), reference(reference), deltas(std::move(deltas)) {}
+
+    static std::shared_ptr<FrameOfReferenceColumn> encode(const VT * values, size_t numRows) {
+        VT min = numRows ? *std::min_element(values, values + numRows) : VT(0);
+        VT max = numRows ? *std::max_element(values, values + numRows) : VT(0);
+        // the differences are computed modulo 2^64, which is exact for the range of any integer type
+        BitPackedArray deltas(numRows, BitPackedArray::bitWidthFor(static_cast<uint64_t>(max) - static_cast<uint64_t>(min)));
+        for(size_t r = 0; r < numRows; r++)
+            deltas.init(r, static_cast<uint64_t>(values[r]) - static_cast<uint64_t>(min));
+        return std::make_shared<FrameOfReferenceColumn>(min, std::move(deltas));
+    }
+
+    ColumnEncoding getEncoding() const override {
+        return ColumnEncoding::FRAME_OF_REFERENCE;
+    }
+
+    ValueTypeCode getValueType() const override {
+        return ValueTypeUtils::codeFor<VT>;
+    }
+
+    VT getReference() const {
+        return reference;
+    }
+
+    unsigned getBitWidth() const {
+        return deltas.getBitWidth();
+    }
+
+    VT get(size_t rowIdx) const {
+        return static_cast<VT>(static_cast<uint64_t>(reference) + deltas.get(rowIdx));
+    }
+
+    /**
+     * @brief Evaluates `column == value` for the first `numRows` rows on the
+     * differences, writing 1 or 0 per row to `res`.
+     */
+    template<typename VTSel>
+    void selectEq(VT value, VTSel * res, size_t numRows) const {
+        const uint64_t delta = static_cast<uint64_t>(value) - static_cast<uint64_t>(reference);
+        const bool inRange = value >= reference && BitPackedArray::bitWidthFor(delta) <= deltas.getBitWidth();
+        for(size_t r = 0; r < numRows; r++)
+            res[r] = inRange && deltas.get(r) == delta;
+    }
+
+    void decode(void * dst, size_t rowBegin, size_t rowEnd) const override {
+        VT * res = static_cast<VT *>(dst);
+        for(size_t r = rowBegin; r < rowEnd; r++)
+            *res++ = get(r);
+    }
+
+    size_t getSizeInBytes() const override {
+        return sizeof(VT) + deltas.getSizeInBytes();
+    }
+};
+
+namespace ColumnEncodingUtils {
+    template<typename VT>
+    std::shared_ptr<const EncodedColumn> encode(ColumnEncoding encoding, const VT * values, size_t numRows) {
+        switch(encoding) {
+            case ColumnEncoding::DICTIONARY:
+                return DictionaryColumn<VT>::encode(values, numRows);
+            case ColumnEncoding::RUN_LENGTH:
+                return RunLengthColumn<VT>::encode(values, numRows);
+            case ColumnEncoding::FRAME_OF_REFERENCE:
+                if constexpr(std::is_integral<VT>::value)
+                    return FrameOfReferenceColumn<VT>::encode(values, numRows);
+                else
+                    throw std::runtime_error("frame-of-reference encoding is only supported for integer columns");
+            default:
+                throw std::runtime_error("unsupported column encoding");
+        }
+    }
+
+    /**
+     * @brief Encodes the given plain array of values of the given type.
+     */
+    inline std::shared_ptr<const EncodedColumn> encode(ColumnEncoding encoding, ValueTypeCode vtc,
+            const void * values, size_t numRows) {
+        switch(vtc) {
+            case ValueTypeCode::SI8:  return encode(encoding, static_cast<const int8_t *>(values), numRows);
+            case ValueTypeCode::SI32: return encode(encoding, static_cast<const int32_t *>(values), numRows);
+            case ValueTypeCode::SI64: return encode(encoding, static_cast<const int64_t *>(values), numRows);
+            case ValueTypeCode::UI8:  return encode(encoding, static_cast<const uint8_t *>(values), numRows);
+            case ValueTypeCode::UI32: return encode(encoding, static_cast<const uint32_t *>(values), numRows);
+            case ValueTypeCode::UI64: return encode(encoding, static_cast<const uint64_t *>(values), numRows);
+            case ValueTypeCode::F32:  return encode(encoding, static_cast<const float *>(values), numRows);
+            case ValueTypeCode::F64:  return encode(encoding, static_cast<const double *>(values), numRows);
+            case ValueTypeCode::STR:  return encode(encoding, static_cast<const std::string *>(values), numRows);
+            default:
+                throw std::runtime_error("unsupported value type for a column encoding");
+        }
+    }
+}
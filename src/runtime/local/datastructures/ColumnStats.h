@@ -0,0 +1,225 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/KeyIndex.h>
+#include <runtime/local/datastructures/MetaDataObject.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The value-type-independent part of the statistics of a column of a
+ * `Frame` or a `DenseMatrix`, see `ZoneMap`.
+ *
+ * The statistics are immutable, such that frames (e.g., views) can share
+ * them. They are dropped when the values of the column are written.
+ */
+class ColumnStats {
+protected:
+    const size_t numRows;
+    bool sorted = false;
+
+    explicit ColumnStats(size_t numRows) : numRows(numRows) {}
+
+public:
+    // the rows of a block, which is a unit of skipping (a multiple of 64, such
+    // that a block covers whole words of a `BitMatrix`)
+    static constexpr size_t BLOCK_ROWS = 1 << 16;
+
+    virtual ~ColumnStats() = default;
+
+    /**
+     * @brief The rows the statistics were computed on. A view on the leading
+     * rows of the column may have fewer, for which the statistics of its last
+     * block are bounds rather than exact.
+     */
+    size_t getNumRows() const {
+        return numRows;
+    }
+
+    size_t getNumBlocks() const {
+        return (numRows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    }
+
+    /**
+     * @brief Whether the values are in ascending order and none is null.
+     */
+    bool isSorted() const {
+        return sorted;
+    }
+
+    virtual ValueTypeCode getValueType() const = 0;
+};
+
+/**
+ * @brief The minimum, the maximum, and the number of nulls (NaNs) of each
+ * block of `ColumnStats::BLOCK_ROWS` rows of a column, and whether the column
+ * is sorted.
+ *
+ * Kernels skip the blocks whose bounds decide a predicate for all their rows
+ * (see `BitMask::compare()`), and choose algorithms for sorted inputs (e.g.,
+ * a merge join). The minimum and the maximum of a block only cover its values
+ * that are not null. The blocks can be computed in parallel, see `initBlock()`.
+ */
+template<typename VT>
+class ZoneMap : public ColumnStats {
+    static_assert(std::is_arithmetic<VT>::value, "ZoneMap: only columns of numbers have statistics");
+
+    std::vector<VT> mins;
+    std::vector<VT> maxs;
+    std::vector<size_t> nullCounts;
+    // whether the values of each block are sorted and not null
+    std::vector<uint8_t> blockSorted;
+
+    static bool isNull(VT v) {
+        if constexpr(std::is_floating_point<VT>::value)
+            return std::isnan(v);
+        else
+            return false;
+    }
+
+public:
+    explicit ZoneMap(size_t numRows) : ColumnStats(numRows),
+            mins(getNumBlocks()), maxs(getNumBlocks()), nullCounts(getNumBlocks()), blockSorted(getNumBlocks()) {}
+
+    /**
+     * @brief Computes the statistics of the given column in a single pass.
+     *
+     * @param values The values of the column.
+     * @param numRows The number of rows.
+     * @param stride The distance between the values of two consecutive rows
+     * (e.g., the row skip of a matrix).
+     */
+    static std::shared_ptr<const ZoneMap> compute(const VT * values, size_t numRows, size_t stride = 1) {
+        auto zm = std::make_shared<ZoneMap>(numRows);
+        for(size_t b = 0; b < zm->getNumBlocks(); b++)
+            zm->initBlock(b, values, stride);
+        zm->finish();
+        return zm;
+    }
+
+    /**
+     * @brief Creates the statistics of a column known to be sorted without
+     * nulls (e.g., the output of an order-preserving kernel on a sorted
+     * column), reading only the first and the last value of each block.
+     */
+    static std::shared_ptr<const ZoneMap> computeSorted(const VT * values, size_t numRows, size_t stride = 1) {
+        auto zm = std::make_shared<ZoneMap>(numRows);
+        for(size_t b = 0; b < zm->getNumBlocks(); b++) {
+            zm->mins[b] = values[b * BLOCK_ROWS * stride];
+            zm->maxs[b] = values[(zm->getBlockEnd(b) - 1) * stride];
+            zm->blockSorted[b] = true;
+        }
+        zm->sorted = true;
+        return zm;
+    }
+
+    /**
+     * @brief Computes the statistics of the b-th block. Distinct blocks may be
+     * computed concurrently, before `finish()` is called once.
+     */
+    void initBlock(size_t b, const VT * values, size_t stride = 1) {
+        const size_t end = getBlockEnd(b);
+        size_t nulls = 0;
+        bool isSorted = true;
+        bool any = false;
+        VT mn = VT(0);
+        VT mx = VT(0);
+        VT prev = VT(0);
+        for(size_t r = b * BLOCK_ROWS; r < end; r++) {
+            const VT v = values[r * stride];
+            if(isNull(v)) {
+                nulls++;
+                continue;
+            }
+            if(!any) {
+                mn = mx = v;
+                any = true;
+            }
+            else {
+                isSorted = isSorted && prev <= v;
+                mn = std::min(mn, v);
+                mx = std::max(mx, v);
+            }
+            prev = v;
+        }
+        mins[b] = mn;
+        maxs[b] = mx;
+        nullCounts[b] = nulls;
+        blockSorted[b] = isSorted && nulls == 0;
+    }
+
+    /**
+     * @brief Derives the sortedness of the column from its blocks.
+     */
+    void finish() {
+        sorted = true;
+        for(size_t b = 0; sorted && b < getNumBlocks(); b++)
+            sorted = blockSorted[b] && (b == 0 || maxs[b - 1] <= mins[b]);
+    }
+
+    ValueTypeCode getValueType() const override {
+        return ValueTypeUtils::codeFor<VT>;
+    }
+
+    size_t getBlockEnd(size_t b) const {
+        return std::min(numRows, (b + 1) * BLOCK_ROWS);
+    }
+
+    VT getMin(size_t b) const {
+        return mins[b];
+    }
+
+    VT getMax(size_t b) const {
+        return maxs[b];
+    }
+
+    size_t getNullCount(size_t b) const {
+        return nullCounts[b];
+    }
+
+    /**
+     * @brief Whether all values of the b-th block are null, such that its
+     * minimum and maximum are undefined.
+     */
+    bool isAllNull(size_t b) const {
+        return nullCounts[b] == getBlockEnd(b) - b * BLOCK_ROWS;
+    }
+};
+
+/**
+ * @brief The statistics of the columns of a `DenseMatrix`, which the matrix
+ * keeps as its derived data (see `MetaDataObject::getDerived()`), such that
+ * they are dropped when its values are written.
+ *
+ * A matrix of a column of a frame also keeps the index of the column, if the
+ * frame has one (see `KeyIndex`).
+ */
+template<typename VT>
+struct MatrixColumnStats : public DerivedData {
+    std::vector<std::shared_ptr<const ZoneMap<VT>>> columns;
+    std::vector<std::shared_ptr<const KeyIndex>> indexes;
+};
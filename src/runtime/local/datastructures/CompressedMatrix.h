@@ -0,0 +1,605 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Matrix.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The encodings of the column groups of a `CompressedMatrix`.
+ *
+ * - `DDC` (dense dictionary coding): the position of the tuple of each row in
+ *   the dictionary, one byte per row.
+ * - `OLE` (offset-list encoding): the ascending rows of each tuple of the
+ *   dictionary. The rows which are not listed have the default tuple (usually
+ *   all zeros), which is not in the dictionary.
+ * - `RLE` (run-length encoding): the runs of consecutive rows of each tuple of
+ *   the dictionary, otherwise like `OLE`.
+ * - `UNCOMPRESSED`: the values of each row, for the columns with too many
+ *   distinct values.
+ */
+enum class ColGroupEncoding {
+    UNCOMPRESSED,
+    DDC,
+    OLE,
+    RLE,
+};
+
+/**
+ * @brief The mapping of the rows of a column group to the tuples of its
+ * dictionary, which does not depend on the values of the tuples, such that
+ * groups with different values (e.g., the results of scalar operations) can
+ * share it.
+ */
+struct ColGroupMapping {
+    // DDC: the tuple of each row
+    std::vector<uint8_t> codes;
+    // OLE: the rows of tuple i at rows[offsets[i], offsets[i + 1]);
+    // RLE: the runs of tuple i as pairs of their first and (exclusive) last row at rows[offsets[i], offsets[i + 1])
+    std::vector<size_t> offsets;
+    std::vector<uint32_t> rows;
+};
+
+/**
+ * @brief A group of columns of a `CompressedMatrix`, whose rows are encoded as
+ * a whole (co-coded), i.e., the dictionary has the distinct tuples of the
+ * values of the columns in the rows.
+ */
+template<typename VT>
+struct ColGroup {
+    ColGroupEncoding encoding = ColGroupEncoding::UNCOMPRESSED;
+    // the columns of the matrix in this group, in ascending order
+    std::vector<size_t> colIdxs;
+    // DDC, OLE, RLE: the tuples, row-major (getNumTuples() x getNumCols())
+    std::vector<VT> dictionary;
+    // OLE, RLE: the tuple of the rows which are not listed
+    std::vector<VT> defaultTuple;
+    // DDC, OLE, RLE
+    std::shared_ptr<const ColGroupMapping> mapping;
+    // UNCOMPRESSED: the values, row-major (number of rows x getNumCols())
+    std::vector<VT> values;
+
+    size_t getNumCols() const {
+        return colIdxs.size();
+    }
+
+    size_t getNumTuples() const {
+        return colIdxs.empty() ? 0 : dictionary.size() / colIdxs.size();
+    }
+
+    const VT * getTuple(size_t t) const {
+        return dictionary.data() + t * colIdxs.size();
+    }
+
+    /**
+     * @brief OLE, RLE: Calls `func(begin, end)` for the ranges of consecutive
+     * rows of tuple `t` between the rows `rowBegin` and `rowEnd`.
+     */
+    template<class Func>
+    void forEachRange(size_t t, size_t rowBegin, size_t rowEnd, Func func) const {
+        const uint32_t * begin = mapping->rows.data() + mapping->offsets[t];
+        const uint32_t * end = mapping->rows.data() + mapping->offsets[t + 1];
+        if(encoding == ColGroupEncoding::OLE) {
+            for(const uint32_t * ptr = std::lower_bound(begin, end, rowBegin); ptr != end && *ptr < rowEnd; ptr++)
+                func(size_t(*ptr), size_t(*ptr) + 1);
+            return;
+        }
+        // the first run ending after rowBegin
+        size_t lo = 0;
+        size_t hi = (end - begin) / 2;
+        while(lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if(begin[2 * mid + 1] <= rowBegin)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for(const uint32_t * ptr = begin + 2 * lo; ptr != end && ptr[0] < rowEnd; ptr += 2)
+            func(std::max<size_t>(ptr[0], rowBegin), std::min<size_t>(ptr[1], rowEnd));
+    }
+
+    /**
+     * @brief DDC, OLE, RLE: Returns the number of rows of each tuple, followed
+     * by the number of rows of the default tuple (zero for DDC).
+     */
+    std::vector<size_t> getTupleCounts(size_t numRows) const {
+        const size_t numTuples = getNumTuples();
+        std::vector<size_t> counts(numTuples + 1, 0);
+        if(encoding == ColGroupEncoding::DDC) {
+            for(uint8_t code : mapping->codes)
+                counts[code]++;
+            return counts;
+        }
+        size_t numListed = 0;
+        for(size_t t = 0; t < numTuples; t++) {
+            forEachRange(t, 0, numRows, [&](size_t begin, size_t end) { counts[t] += end - begin; });
+            numListed += counts[t];
+        }
+        counts[numTuples] = numRows - numListed;
+        return counts;
+    }
+
+    /**
+     * @brief Returns the value of the `pos`-th column of this group in the
+     * given row.
+     */
+    VT get(size_t rowIdx, size_t pos) const {
+        const size_t numCols = getNumCols();
+        switch(encoding) {
+            case ColGroupEncoding::UNCOMPRESSED:
+                return values[rowIdx * numCols + pos];
+            case ColGroupEncoding::DDC:
+                return getTuple(mapping->codes[rowIdx])[pos];
+            default:
+                for(size_t t = 0; t < getNumTuples(); t++) {
+                    bool found = false;
+                    forEachRange(t, rowIdx, rowIdx + 1, [&](size_t, size_t) { found = true; });
+                    if(found)
+                        return getTuple(t)[pos];
+                }
+                return defaultTuple[pos];
+        }
+    }
+
+    /**
+     * @brief Writes the values of the columns of this group in the rows from
+     * `rowBegin` to `rowEnd` to the columns `colIdxs` of the row-major array
+     * `dst`, whose first row is `rowBegin`.
+     */
+    void decompress(VT * dst, size_t rowSkip, size_t rowBegin, size_t rowEnd) const {
+        const size_t numCols = getNumCols();
+        auto setRow = [&](size_t r, const VT * tuple) {
+            VT * row = dst + (r - rowBegin) * rowSkip;
+            for(size_t i = 0; i < numCols; i++)
+                row[colIdxs[i]] = tuple[i];
+        };
+        switch(encoding) {
+            case ColGroupEncoding::UNCOMPRESSED:
+                for(size_t r = rowBegin; r < rowEnd; r++)
+                    setRow(r, values.data() + r * numCols);
+                break;
+            case ColGroupEncoding::DDC:
+                for(size_t r = rowBegin; r < rowEnd; r++)
+                    setRow(r, getTuple(mapping->codes[r]));
+                break;
+            default:
+                for(size_t r = rowBegin; r < rowEnd; r++)
+                    setRow(r, defaultTuple.data());
+                for(size_t t = 0; t < getNumTuples(); t++)
+                    forEachRange(t, rowBegin, rowEnd, [&](size_t begin, size_t end) {
+                        for(size_t r = begin; r < end; r++)
+                            setRow(r, getTuple(t));
+                    });
+        }
+    }
+
+    size_t getSizeInBytes() const {
+        size_t size = (colIdxs.size() + defaultTuple.size()) * sizeof(size_t)
+                + (dictionary.size() + values.size()) * sizeof(VT);
+        if(mapping)
+            size += mapping->codes.size() + mapping->offsets.size() * sizeof(size_t)
+                    + mapping->rows.size() * sizeof(uint32_t);
+        return size;
+    }
+};
+
+/**
+ * @brief A compressed matrix in the style of compressed linear algebra (CLA),
+ * for dense data with few distinct values per column, e.g., one-hot encoded,
+ * bucketized, or quantized features.
+ *
+ * The columns are partitioned into column groups, which encode the tuples of
+ * the values of their columns in each row by a dictionary of the distinct
+ * tuples (see `ColGroupEncoding`). Columns with too many distinct values form
+ * a single uncompressed group. Matrix multiplications and aggregations work on
+ * the dictionaries and the mappings of the rows to them, without
+ * decompressing the matrix.
+ *
+ * A compressed matrix is immutable: it is built from dense values (directly
+ * or by `append()`), and `set()` is not supported. Slices are compressed
+ * copies.
+ */
+template<typename ValueType>
+class CompressedMatrix : public Matrix<ValueType> {
+public:
+    // the maximum number of tuples of a dictionary, such that the codes of DDC fit into a byte
+    static constexpr size_t MAX_TUPLES = 256;
+    // the maximum number of rows the planning of the compression samples per column
+    static constexpr size_t SAMPLE_SIZE = 4096;
+
+private:
+    // `using`, so that we do not need to prefix each occurrence of these
+    // fields from the super-classes.
+    using Matrix<ValueType>::numRows;
+    using Matrix<ValueType>::numCols;
+
+    std::vector<ColGroup<ValueType>> colGroups;
+    // the group of each column and the position of the column in this group
+    std::vector<std::pair<size_t, size_t>> colPositions;
+    // the values populated by append(), which are compressed by finishAppend()
+    std::vector<ValueType> appendBuffer;
+
+    /**
+     * @brief A column group during the compression, whose rows are mapped to
+     * the tuples of the dictionary by one code per row.
+     */
+    struct Candidate {
+        std::vector<size_t> colIdxs;
+        std::vector<ValueType> dictionary;
+        std::vector<uint8_t> codes;
+    };
+
+    // Grant DataObjectFactory access to the private constructors and
+    // destructors.
+    template<class DataType, typename ... ArgTypes>
+    friend DataType * DataObjectFactory::create(ArgTypes ...);
+    template<class DataType>
+    friend void DataObjectFactory::destroy(const DataType * obj);
+
+    /**
+     * @brief Creates a `CompressedMatrix` of the given size by compressing the
+     * given row-major values.
+     */
+    CompressedMatrix(size_t numRows, size_t numCols, const ValueType * values, size_t rowSkip) :
+            Matrix<ValueType>(numRows, numCols)
+    {
+        compress(values, rowSkip);
+    }
+
+    /**
+     * @brief Creates a `CompressedMatrix` of the given size from the given
+     * column groups, which must partition the columns.
+     */
+    CompressedMatrix(size_t numRows, size_t numCols, const std::vector<ColGroup<ValueType>> & colGroups) :
+            Matrix<ValueType>(numRows, numCols), colGroups(colGroups)
+    {
+        indexColumns();
+    }
+
+    virtual ~CompressedMatrix() {
+        // nothing to do
+    }
+
+    void indexColumns() {
+        colPositions.assign(numCols, {0, 0});
+        for(size_t g = 0; g < colGroups.size(); g++)
+            for(size_t i = 0; i < colGroups[g].getNumCols(); i++)
+                colPositions[colGroups[g].colIdxs[i]] = {g, i};
+    }
+
+    /**
+     * @brief Returns whether the distinct values of a column in a sample of
+     * the rows fit into a dictionary, i.e., whether encoding the column pays
+     * off.
+     */
+    bool isCompressible(const ValueType * values, size_t rowSkip, size_t c) const {
+        const size_t sampleSize = std::min(numRows, SAMPLE_SIZE);
+        std::unordered_set<ValueType> distinct;
+        for(size_t i = 0; i < sampleSize; i++) {
+            distinct.insert(values[(i * numRows / sampleSize) * rowSkip + c]);
+            if(distinct.size() > MAX_TUPLES)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Dictionary-encodes a column, unless it has too many distinct
+     * values.
+     */
+    bool encodeColumn(const ValueType * values, size_t rowSkip, size_t c, Candidate & res) const {
+        std::unordered_map<ValueType, uint8_t> codes;
+        res.colIdxs = {c};
+        res.codes.resize(numRows);
+        for(size_t r = 0; r < numRows; r++) {
+            const ValueType v = values[r * rowSkip + c];
+            auto it = codes.find(v);
+            if(it == codes.end()) {
+                if(codes.size() == MAX_TUPLES)
+                    return false;
+                it = codes.emplace(v, static_cast<uint8_t>(codes.size())).first;
+                res.dictionary.push_back(v);
+            }
+            res.codes[r] = it->second;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Co-codes two column groups, unless their combination has too many
+     * distinct tuples.
+     */
+    bool merge(const Candidate & lhs, const Candidate & rhs, Candidate & res) const {
+        const size_t numTuplesRhs = rhs.dictionary.size() / rhs.colIdxs.size();
+        std::vector<int> pairCodes(lhs.dictionary.size() / lhs.colIdxs.size() * numTuplesRhs, -1);
+        res.colIdxs = lhs.colIdxs;
+        res.colIdxs.insert(res.colIdxs.end(), rhs.colIdxs.begin(), rhs.colIdxs.end());
+        res.codes.resize(numRows);
+        size_t numTuples = 0;
+        for(size_t r = 0; r < numRows; r++) {
+            int & code = pairCodes[lhs.codes[r] * numTuplesRhs + rhs.codes[r]];
+            if(code < 0) {
+                if(numTuples == MAX_TUPLES)
+                    return false;
+                code = static_cast<int>(numTuples++);
+                const ValueType * tupleLhs = lhs.dictionary.data() + lhs.codes[r] * lhs.colIdxs.size();
+                const ValueType * tupleRhs = rhs.dictionary.data() + rhs.codes[r] * rhs.colIdxs.size();
+                res.dictionary.insert(res.dictionary.end(), tupleLhs, tupleLhs + lhs.colIdxs.size());
+                res.dictionary.insert(res.dictionary.end(), tupleRhs, tupleRhs + rhs.colIdxs.size());
+            }
+            res.codes[r] = static_cast<uint8_t>(code);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Returns the smallest encoding of a column group and its size in
+     * bytes, as well as the tuple which becomes the default one of OLE and
+     * RLE (the most frequent tuple).
+     */
+    std::pair<ColGroupEncoding, size_t> chooseEncoding(const Candidate & cand, size_t & defaultTuple) const {
+        const size_t numTuples = cand.dictionary.size() / cand.colIdxs.size();
+        std::vector<size_t> counts(numTuples, 0);
+        std::vector<size_t> numRuns(numTuples, 0);
+        for(size_t r = 0; r < numRows; r++) {
+            counts[cand.codes[r]]++;
+            if(r == 0 || cand.codes[r] != cand.codes[r - 1])
+                numRuns[cand.codes[r]]++;
+        }
+        defaultTuple = std::max_element(counts.begin(), counts.end()) - counts.begin();
+        size_t numRunsListed = 0;
+        for(size_t t = 0; t < numTuples; t++)
+            numRunsListed += t == defaultTuple ? 0 : numRuns[t];
+
+        const size_t dictSize = cand.dictionary.size() * sizeof(ValueType);
+        std::pair<ColGroupEncoding, size_t> best{ColGroupEncoding::UNCOMPRESSED,
+                numRows * cand.colIdxs.size() * sizeof(ValueType)};
+        auto consider = [&](ColGroupEncoding encoding, size_t size) {
+            if(size < best.second)
+                best = {encoding, size};
+        };
+        consider(ColGroupEncoding::DDC, numRows + dictSize);
+        // the rows of OLE and RLE are 32-bit
+        if(numRows <= std::numeric_limits<uint32_t>::max()) {
+            consider(ColGroupEncoding::OLE, (numRows - counts[defaultTuple]) * sizeof(uint32_t)
+                    + numTuples * sizeof(size_t) + dictSize);
+            consider(ColGroupEncoding::RLE, numRunsListed * 2 * sizeof(uint32_t)
+                    + numTuples * sizeof(size_t) + dictSize);
+        }
+        return best;
+    }
+
+    ColGroup<ValueType> encodeGroup(Candidate & cand, ColGroupEncoding encoding, size_t defaultTuple) const {
+        const size_t numGroupCols = cand.colIdxs.size();
+        const size_t numTuples = cand.dictionary.size() / numGroupCols;
+        ColGroup<ValueType> res;
+        res.encoding = encoding;
+        res.colIdxs = cand.colIdxs;
+        auto mapping = std::make_shared<ColGroupMapping>();
+        if(encoding == ColGroupEncoding::DDC) {
+            res.dictionary = std::move(cand.dictionary);
+            mapping->codes = std::move(cand.codes);
+            res.mapping = std::move(mapping);
+            return res;
+        }
+
+        // the default tuple leaves the dictionary
+        std::vector<size_t> newCodes(numTuples, numTuples);
+        for(size_t t = 0, i = 0; t < numTuples; t++) {
+            const ValueType * tuple = cand.dictionary.data() + t * numGroupCols;
+            if(t == defaultTuple)
+                res.defaultTuple.assign(tuple, tuple + numGroupCols);
+            else {
+                newCodes[t] = i++;
+                res.dictionary.insert(res.dictionary.end(), tuple, tuple + numGroupCols);
+            }
+        }
+
+        const bool isRLE = encoding == ColGroupEncoding::RLE;
+        auto startsRange = [&](size_t r) {
+            return newCodes[cand.codes[r]] < numTuples && (!isRLE || r == 0 || cand.codes[r] != cand.codes[r - 1]);
+        };
+        mapping->offsets.assign(numTuples, 0);
+        for(size_t r = 0; r < numRows; r++)
+            if(startsRange(r))
+                mapping->offsets[newCodes[cand.codes[r]] + 1] += isRLE ? 2 : 1;
+        for(size_t t = 1; t < numTuples; t++)
+            mapping->offsets[t] += mapping->offsets[t - 1];
+        mapping->rows.resize(mapping->offsets[numTuples - 1]);
+        std::vector<size_t> pos(mapping->offsets.begin(), mapping->offsets.end() - 1);
+        for(size_t r = 0; r < numRows; r++) {
+            if(!startsRange(r))
+                continue;
+            const size_t t = newCodes[cand.codes[r]];
+            mapping->rows[pos[t]++] = static_cast<uint32_t>(r);
+            if(isRLE) {
+                size_t end = r + 1;
+                while(end < numRows && cand.codes[end] == cand.codes[r])
+                    end++;
+                mapping->rows[pos[t]++] = static_cast<uint32_t>(end);
+            }
+        }
+        res.mapping = std::move(mapping);
+        return res;
+    }
+
+    /**
+     * @brief Plans and builds the column groups of the given values.
+     *
+     * The columns whose distinct values in a sample of the rows fit into a
+     * dictionary are dictionary-encoded, consecutive ones are co-coded as long
+     * as that makes them smaller (e.g., the columns of a one-hot encoded
+     * feature), and each group gets its smallest encoding. The other columns
+     * stay uncompressed.
+     */
+    void compress(const ValueType * values, size_t rowSkip) {
+        colGroups.clear();
+        std::vector<size_t> uncompressedCols;
+        std::vector<Candidate> cands;
+        for(size_t c = 0; c < numCols; c++) {
+            Candidate cand;
+            if(numRows && isCompressible(values, rowSkip, c) && encodeColumn(values, rowSkip, c, cand)) {
+                size_t defaultTuple;
+                Candidate merged;
+                if(!cands.empty() && merge(cands.back(), cand, merged)
+                        && chooseEncoding(merged, defaultTuple).second
+                                < chooseEncoding(cands.back(), defaultTuple).second
+                                + chooseEncoding(cand, defaultTuple).second)
+                    cands.back() = std::move(merged);
+                else
+                    cands.push_back(std::move(cand));
+            }
+            else
+                uncompressedCols.push_back(c);
+        }
+
+        for(Candidate & cand : cands) {
+            size_t defaultTuple;
+            const ColGroupEncoding encoding = chooseEncoding(cand, defaultTuple).first;
+            if(encoding == ColGroupEncoding::UNCOMPRESSED)
+                uncompressedCols.insert(uncompressedCols.end(), cand.colIdxs.begin(), cand.colIdxs.end());
+            else
+                colGroups.push_back(encodeGroup(cand, encoding, defaultTuple));
+        }
+
+        if(!uncompressedCols.empty()) {
+            std::sort(uncompressedCols.begin(), uncompressedCols.end());
+            ColGroup<ValueType> group;
+            group.colIdxs = uncompressedCols;
+            group.values.resize(numRows * uncompressedCols.size());
+            ValueType * dst = group.values.data();
+            for(size_t r = 0; r < numRows; r++)
+                for(size_t c : uncompressedCols)
+                    *dst++ = values[r * rowSkip + c];
+            colGroups.push_back(std::move(group));
+        }
+        indexColumns();
+    }
+
+public:
+
+    const std::vector<ColGroup<ValueType>> & getColGroups() const {
+        return colGroups;
+    }
+
+    /**
+     * @brief Returns the memory of the column groups.
+     */
+    size_t getSizeInBytes() const {
+        size_t size = 0;
+        for(const ColGroup<ValueType> & group : colGroups)
+            size += group.getSizeInBytes();
+        return size;
+    }
+
+    /**
+     * @brief Writes the rows from `rowBegin` to `rowEnd` to the row-major
+     * array `dst`.
+     */
+    void decompress(ValueType * dst, size_t rowSkip, size_t rowBegin, size_t rowEnd) const {
+        for(const ColGroup<ValueType> & group : colGroups)
+            group.decompress(dst, rowSkip, rowBegin, rowEnd);
+    }
+
+    ValueType get(size_t rowIdx, size_t colIdx) const override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        const auto & [g, pos] = colPositions[colIdx];
+        return colGroups[g].get(rowIdx, pos);
+    }
+
+    void set(size_t rowIdx, size_t colIdx, ValueType value) override {
+        throw std::runtime_error("CompressedMatrix: a compressed matrix cannot be modified, use append() instead");
+    }
+
+    void prepareAppend() override {
+        appendBuffer.assign(numRows * numCols, ValueType(0));
+    }
+
+    void append(size_t rowIdx, size_t colIdx, ValueType value) override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        appendBuffer[rowIdx * numCols + colIdx] = value;
+    }
+
+    void finishAppend() override {
+        compress(appendBuffer.data(), numCols);
+        std::vector<ValueType>().swap(appendBuffer);
+    }
+
+    void print(std::ostream & os) const override {
+        os << "CompressedMatrix(" << numRows << 'x' << numCols << ", "
+                << ValueTypeUtils::cppNameFor<ValueType> << ')' << std::endl;
+        std::vector<ValueType> row(numCols);
+        for(size_t r = 0; r < numRows; r++) {
+            decompress(row.data(), numCols, r, r + 1);
+            for(size_t c = 0; c < numCols; c++) {
+                switch(ValueTypeUtils::codeFor<ValueType>) {
+                    case ValueTypeCode::SI8 : os << static_cast<int32_t>(row[c]); break;
+                    case ValueTypeCode::UI8 : os << static_cast<uint32_t>(row[c]); break;
+                    default : os << row[c]; break;
+                }
+                if(c < numCols - 1)
+                    os << ' ';
+            }
+            os << std::endl;
+        }
+    }
+
+    CompressedMatrix* sliceRow(size_t rl, size_t ru) const override {
+        return slice(rl, ru, 0, numCols);
+    }
+
+    CompressedMatrix* sliceCol(size_t cl, size_t cu) const override {
+        return slice(0, numRows, cl, cu);
+    }
+
+    /**
+     * @brief Returns a compressed copy of the given rows and columns of this
+     * matrix.
+     */
+    CompressedMatrix* slice(size_t rl, size_t ru, size_t cl, size_t cu) const override {
+        if(rl > ru || ru > numRows || cl > cu || cu > numCols)
+            throw std::runtime_error("CompressedMatrix: the bounds of the slice are invalid");
+        std::vector<ValueType> values((ru - rl) * numCols);
+        decompress(values.data(), numCols, rl, ru);
+        return DataObjectFactory::create<CompressedMatrix<ValueType>>(ru - rl, cu - cl,
+                static_cast<const ValueType *>(values.data() + cl), numCols);
+    }
+};
+
+template <typename ValueType>
+std::ostream & operator<<(std::ostream & os, const CompressedMatrix<ValueType> & obj)
+{
+    obj.print(os);
+    return os;
+}
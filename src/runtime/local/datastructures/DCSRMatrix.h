@@ -0,0 +1,279 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Matrix.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A doubly compressed sparse row (DCSR) matrix for ultra-sparse data,
+ * i.e., matrices with fewer non-zeros than rows.
+ *
+ * Like a `CSRMatrix`, but the row offsets exist only for the rows that have
+ * non-zeros, which are listed in ascending order in the row indexes. Thus,
+ * the memory of the matrix is proportional to its number of non-zeros only,
+ * independent of its number of rows, e.g., for the interactions of a billion
+ * users with a billion items. This is the in-memory counterpart of the
+ * ultra-sparse bodies of the DAPHNE file format (see
+ * `DF_body_t::ultra_sparse` in `DaphneFile.h`).
+ *
+ * The column indexes within a row are sorted, and zeros are never stored.
+ * `set()` inserts into the arrays (linear in the number of non-zeros), so
+ * the matrix should be populated by `append()`. Slices are copies, not views.
+ */
+template<typename ValueType>
+class DCSRMatrix : public Matrix<ValueType> {
+    // `using`, so that we do not need to prefix each occurrence of these
+    // fields from the super-classes.
+    using Matrix<ValueType>::numRows;
+    using Matrix<ValueType>::numCols;
+
+    // the rows with non-zeros, in ascending order
+    std::vector<size_t> rowIdxs;
+    // the non-zeros of the i-th of these rows are at [rowOffsets[i], rowOffsets[i + 1])
+    std::vector<size_t> rowOffsets;
+    std::vector<size_t> colIdxs;
+    std::vector<ValueType> values;
+
+    // Grant DataObjectFactory access to the private constructors and
+    // destructors.
+    template<class DataType, typename ... ArgTypes>
+    friend DataType * DataObjectFactory::create(ArgTypes ...);
+    template<class DataType>
+    friend void DataObjectFactory::destroy(const DataType * obj);
+
+    /**
+     * @brief Creates a `DCSRMatrix` of the given size without any non-zeros.
+     *
+     * @param numRows The exact number of rows.
+     * @param numCols The exact number of columns.
+     * @param maxNumNonZeros The number of non-zeros to reserve memory for.
+     */
+    DCSRMatrix(size_t numRows, size_t numCols, size_t maxNumNonZeros = 0) :
+            Matrix<ValueType>(numRows, numCols), rowOffsets(1, 0)
+    {
+        reserve(maxNumNonZeros);
+    }
+
+    virtual ~DCSRMatrix() {
+        // nothing to do
+    }
+
+    /**
+     * @brief Returns the position of the given row in the row indexes, or of
+     * the first row after it if it has no non-zeros.
+     */
+    size_t findRow(size_t rowIdx) const {
+        return std::lower_bound(rowIdxs.begin(), rowIdxs.end(), rowIdx) - rowIdxs.begin();
+    }
+
+    bool hasRow(size_t pos, size_t rowIdx) const {
+        return pos < rowIdxs.size() && rowIdxs[pos] == rowIdx;
+    }
+
+    void shiftRowOffsets(size_t pos, bool increment) {
+        for(size_t i = pos + 1; i < rowOffsets.size(); i++)
+            increment ? rowOffsets[i]++ : rowOffsets[i]--;
+    }
+
+public:
+
+    size_t getNumNonZeros() const {
+        return values.size();
+    }
+
+    /**
+     * @brief Returns the number of rows with at least one non-zero.
+     */
+    size_t getNumNonZeroRows() const {
+        return rowIdxs.size();
+    }
+
+    /**
+     * @brief Returns the indexes of the rows with non-zeros, in ascending
+     * order (`getNumNonZeroRows()` many).
+     */
+    const size_t * getRowIdxs() const {
+        return rowIdxs.data();
+    }
+
+    /**
+     * @brief Returns the offsets of the non-zeros of the rows with non-zeros
+     * (`getNumNonZeroRows() + 1` many, starting at zero).
+     */
+    const size_t * getRowOffsets() const {
+        return rowOffsets.data();
+    }
+
+    const size_t * getColIdxs() const {
+        return colIdxs.data();
+    }
+
+    const ValueType * getValues() const {
+        return values.data();
+    }
+
+    /**
+     * @brief Reserves memory for the given number of non-zeros, and as many
+     * rows with non-zeros (at most the number of rows).
+     */
+    void reserve(size_t numNonZeros) {
+        rowIdxs.reserve(std::min(numNonZeros, numRows));
+        rowOffsets.reserve(std::min(numNonZeros, numRows) + 1);
+        colIdxs.reserve(numNonZeros);
+        values.reserve(numNonZeros);
+    }
+
+    ValueType get(size_t rowIdx, size_t colIdx) const override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        const size_t pos = findRow(rowIdx);
+        if(!hasRow(pos, rowIdx))
+            return ValueType(0);
+        const size_t * colIdxsBeg = colIdxs.data() + rowOffsets[pos];
+        const size_t * colIdxsEnd = colIdxs.data() + rowOffsets[pos + 1];
+        const size_t * ptr = std::lower_bound(colIdxsBeg, colIdxsEnd, colIdx);
+        if(ptr != colIdxsEnd && *ptr == colIdx)
+            return values[ptr - colIdxs.data()];
+        return ValueType(0);
+    }
+
+    void set(size_t rowIdx, size_t colIdx, ValueType value) override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        const size_t pos = findRow(rowIdx);
+        if(!hasRow(pos, rowIdx)) {
+            if(value == ValueType(0))
+                return;
+            const size_t offset = rowOffsets[pos];
+            rowIdxs.insert(rowIdxs.begin() + pos, rowIdx);
+            rowOffsets.insert(rowOffsets.begin() + pos + 1, offset);
+        }
+        auto colIdxsBeg = colIdxs.begin() + rowOffsets[pos];
+        auto colIdxsEnd = colIdxs.begin() + rowOffsets[pos + 1];
+        auto it = std::lower_bound(colIdxsBeg, colIdxsEnd, colIdx);
+        const size_t i = it - colIdxs.begin();
+        if(it != colIdxsEnd && *it == colIdx) {
+            if(value != ValueType(0)) {
+                values[i] = value;
+                return;
+            }
+            colIdxs.erase(it);
+            values.erase(values.begin() + i);
+            shiftRowOffsets(pos, false);
+            // a row without non-zeros is not stored
+            if(rowOffsets[pos] == rowOffsets[pos + 1]) {
+                rowIdxs.erase(rowIdxs.begin() + pos);
+                rowOffsets.erase(rowOffsets.begin() + pos + 1);
+            }
+            return;
+        }
+        if(value == ValueType(0))
+            return;
+        colIdxs.insert(it, colIdx);
+        values.insert(values.begin() + i, value);
+        shiftRowOffsets(pos, true);
+    }
+
+    void prepareAppend() override {
+        rowIdxs.clear();
+        rowOffsets.assign(1, 0);
+        colIdxs.clear();
+        values.clear();
+    }
+
+    void append(size_t rowIdx, size_t colIdx, ValueType value) override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        assert((rowIdxs.empty() || rowIdx > rowIdxs.back() || (rowIdx == rowIdxs.back() && colIdx > colIdxs.back()))
+                && "the coordinates must be appended in row-major order");
+        if(value == ValueType(0))
+            return;
+        if(rowIdxs.empty() || rowIdxs.back() != rowIdx) {
+            rowIdxs.push_back(rowIdx);
+            rowOffsets.push_back(rowOffsets.back());
+        }
+        colIdxs.push_back(colIdx);
+        values.push_back(value);
+        rowOffsets.back()++;
+    }
+
+    void finishAppend() override {
+        // nothing to do
+    }
+
+    /**
+     * @brief Prints the non-zeros of this matrix as coordinates, one per
+     * line, since a matrix of this type is usually too large to be printed
+     * cell by cell.
+     */
+    void print(std::ostream & os) const override {
+        os << "DCSRMatrix(" << numRows << 'x' << numCols << ", "
+                << ValueTypeUtils::cppNameFor<ValueType> << ')' << std::endl;
+        for(size_t i = 0; i < rowIdxs.size(); i++)
+            for(size_t k = rowOffsets[i]; k < rowOffsets[i + 1]; k++) {
+                os << rowIdxs[i] << ' ' << colIdxs[k] << ' ';
+                switch(ValueTypeUtils::codeFor<ValueType>) {
+                    case ValueTypeCode::SI8 : os << static_cast<int32_t>(values[k]); break;
+                    case ValueTypeCode::UI8 : os << static_cast<uint32_t>(values[k]); break;
+                    default : os << values[k]; break;
+                }
+                os << std::endl;
+            }
+    }
+
+    DCSRMatrix* sliceRow(size_t rl, size_t ru) const override {
+        return slice(rl, ru, 0, numCols);
+    }
+
+    DCSRMatrix* sliceCol(size_t cl, size_t cu) const override {
+        return slice(0, numRows, cl, cu);
+    }
+
+    /**
+     * @brief Returns a copy of the given rows and columns of this matrix.
+     */
+    DCSRMatrix* slice(size_t rl, size_t ru, size_t cl, size_t cu) const override {
+        if(rl > ru || ru > numRows || cl > cu || cu > numCols)
+            throw std::runtime_error("DCSRMatrix: the bounds of the slice are invalid");
+        auto res = DataObjectFactory::create<DCSRMatrix<ValueType>>(ru - rl, cu - cl);
+        for(size_t i = findRow(rl); i < rowIdxs.size() && rowIdxs[i] < ru; i++) {
+            const size_t * colIdxsBeg = colIdxs.data() + rowOffsets[i];
+            const size_t * colIdxsEnd = colIdxs.data() + rowOffsets[i + 1];
+            for(const size_t * ptr = std::lower_bound(colIdxsBeg, colIdxsEnd, cl); ptr != colIdxsEnd && *ptr < cu; ptr++)
+                res->append(rowIdxs[i] - rl, *ptr - cl, values[ptr - colIdxs.data()]);
+        }
+        return res;
+    }
+};
+
+template <typename ValueType>
+std::ostream & operator<<(std::ostream & os, const DCSRMatrix<ValueType> & obj)
+{
+    obj.print(os);
+    return os;
+}
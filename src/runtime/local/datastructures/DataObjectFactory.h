@@ -17,6 +17,9 @@
 #ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_DATAOBJECTFACTORY_H
 #define SRC_RUNTIME_LOCAL_DATASTRUCTURES_DATAOBJECTFACTORY_H
 
+#include <runtime/local/datastructures/MemoryTracker.h>
+
+#include <atomic>
 #include <stdexcept>
 
 struct DataObjectFactory {
@@ -34,7 +37,13 @@ struct DataObjectFactory {
     template<class DataType, typename ... ArgTypes>
     static DataType * create(ArgTypes ... args) {
         // TODO Employ placement-new.
-        return new DataType(args...);
+        if(!MemoryTracker::isEnabled())
+            return new DataType(args...);
+        // the memory the constructor allocates is attributed to the new data object
+        const size_t allocatedBefore = MemoryTracker::getThreadAllocatedBytes();
+        DataType * obj = new DataType(args...);
+        MemoryTracker::get().addObject(obj, MemoryTracker::getThreadAllocatedBytes() - allocatedBefore);
+        return obj;
     }
     
     /**
@@ -44,7 +53,7 @@ struct DataObjectFactory {
      * Decreases the reference counter of the given data object. If the
      * reference counter becomes zero, the data object is destroyed.
      * 
-     * The access is protected by a mutex, such that multiple threads may call
+     * The reference counter is atomic, such that multiple threads may call
      * this method concurrently.
      * 
      * @param obj The data object to destroy.
@@ -57,14 +66,15 @@ struct DataObjectFactory {
                     "DataObjectFactory::destroy() must not be called with nullptr"
             );
         
-        obj->refCounterMutex.lock();
-        obj->refCounter--;
-        if(obj->refCounter == 0) {
-            obj->refCounterMutex.unlock();
+        // Releasing the reference must publish all prior accesses of this
+        // thread to the thread deleting the object, which in turn must
+        // observe them before deleting it.
+        if(obj->refCounter.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(MemoryTracker::isEnabled())
+                MemoryTracker::get().removeObject(obj);
             delete obj;
         }
-        else
-            obj->refCounterMutex.unlock();
     }
 
     // TODO Simplify many places in the code (especially test cases) by using
@@ -15,6 +15,24 @@
  */
 
 #include "DenseMatrix.h"
+#include <runtime/local/datastructures/AllocationDescriptorDisk.h>
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/SpillManager.h>
+
+#include <runtime/local/context/ResidencyManager.h>
+
+#include <algorithm>
+#include <type_traits>
+
+// the value type of the spill files of the values, bools are stored as bytes
+template<typename ValueType>
+static ValueTypeCode getSpillValueTypeCode() {
+    if constexpr(std::is_same<ValueType, bool>::value)
+        return ValueTypeCode::UI8;
+    else
+        return ValueTypeUtils::codeFor<ValueType>;
+}
+
 template<typename ValueType>
 DenseMatrix<ValueType>::DenseMatrix(size_t maxNumRows, size_t numCols, bool zero, IAllocationDescriptor* allocInfo) :
         Matrix<ValueType>(maxNumRows, numCols), rowSkip(numCols), lastAppendedRowIdx(0), lastAppendedColIdx(0)
@@ -28,6 +46,7 @@ DenseMatrix<ValueType>::DenseMatrix(size_t maxNumRows, size_t numCols, bool zero
 #endif
         new_data_placement = this->mdo.addDataPlacement(allocInfo);
         new_data_placement->allocation->createAllocation(bufferSize(), zero);
+        trackResidency(new_data_placement);
     }
     else {
         AllocationDescriptorHost myHostAllocInfo;
@@ -62,7 +81,9 @@ DenseMatrix<ValueType>::DenseMatrix(const DenseMatrix<ValueType> * src, size_t r
     assert((colLowerIncl < colUpperExcl) && "colLowerIncl must be lower than colUpperExcl");
 
     rowSkip = src->rowSkip;
+    colOffset = src->colOffset + colLowerIncl;
     auto offset = rowLowerIncl * src->rowSkip + colLowerIncl;
+    src->reloadSpilledValues();
     alloc_shared_values(src->values, offset);
     // ToDo: handle object meta data
     AllocationDescriptorHost myHostAllocInfo;
@@ -70,9 +91,36 @@ DenseMatrix<ValueType>::DenseMatrix(const DenseMatrix<ValueType> * src, size_t r
     this->mdo.addLatest(new_placement->dp_id);
 }
 
+template<typename ValueType>
+DenseMatrix<ValueType>::DenseMatrix(const DenseMatrix<ValueType> * src, size_t numRows, size_t numCols) :
+        Matrix<ValueType>(numRows, numCols), rowSkip(src->rowSkip), colOffset(src->colOffset),
+        numSpareRows(numRows <= src->numRows + src->numSpareRows ? src->numRows + src->numSpareRows - numRows : 0),
+        lastAppendedRowIdx(0), lastAppendedColIdx(0)
+{
+    assert((numCols <= src->numCols + src->getNumSpareCols()) && "numCols exceeds the row skip of src");
+    src->reloadSpilledValues();
+    alloc_shared_values(src->values);
+    AllocationDescriptorHost myHostAllocInfo;
+    auto new_placement = this->mdo.addDataPlacement(&myHostAllocInfo);
+    this->mdo.addLatest(new_placement->dp_id);
+}
+
+template<typename ValueType>
+DenseMatrix<ValueType>::DenseMatrix(const DenseMatrix<ValueType> * src) :
+        Matrix<ValueType>(src->numCols, src->numRows), rowSkip(src->numRows), lastAppendedRowIdx(0),
+        lastAppendedColIdx(0), transposedSrc(src), transpositionPending(true)
+{
+    src->increaseRefCounter();
+    AllocationDescriptorHost myHostAllocInfo;
+    DataPlacement* new_data_placement = this->mdo.addDataPlacement(&myHostAllocInfo);
+    this->mdo.addLatest(new_data_placement->dp_id);
+}
+
 template<typename ValueType>
 auto DenseMatrix<ValueType>::getValuesInternal(const IAllocationDescriptor* alloc_desc, const Range* range)
         -> std::tuple<bool, size_t, ValueType*> {
+    if(transpositionPending.load(std::memory_order_acquire))
+        materializeTransposition();
     // If no range information is provided we assume the full range that this matrix covers
     if(range == nullptr || *range == Range(*this)) {
         if(alloc_desc) {
@@ -100,11 +148,7 @@ auto DenseMatrix<ValueType>::getValuesInternal(const IAllocationDescriptor* allo
 
                 // if we found a data placement that is not in host memory, transfer it there before returning
                 if(std::get<0>(result) == true && std::get<2>(result) == nullptr) {
-                    AllocationDescriptorHost myHostAllocInfo;
-                    if(!values)
-                        this->alloc_shared_values();
-                    this->mdo.addDataPlacement(&myHostAllocInfo);
-                    placement->allocation->transferFrom(reinterpret_cast<std::byte *>(values.get()), bufferSize());
+                    loadHostValues(placement);
                     std::get<2>(result) = values.get();
                 }
 
@@ -114,6 +158,7 @@ auto DenseMatrix<ValueType>::getValuesInternal(const IAllocationDescriptor* allo
 
                 // transfer to requested data placement
                 new_data_placement->allocation->transferTo(reinterpret_cast<std::byte *>(values.get()), bufferSize());
+                trackResidency(new_data_placement);
                 return std::make_tuple(false, new_data_placement->dp_id, reinterpret_cast<ValueType *>(
                         new_data_placement->allocation->getData().get()));
             }
@@ -122,6 +167,7 @@ auto DenseMatrix<ValueType>::getValuesInternal(const IAllocationDescriptor* allo
                 if(!latest) {
                     ret->allocation->transferTo(reinterpret_cast<std::byte *>(values.get()), bufferSize());
                 }
+                trackResidency(ret);
                 return std::make_tuple(latest, ret->dp_id, reinterpret_cast<ValueType *>(ret->allocation->getData()
                         .get()));
             }
@@ -131,6 +177,7 @@ auto DenseMatrix<ValueType>::getValuesInternal(const IAllocationDescriptor* allo
             std::tuple<bool, size_t, ValueType *> result = std::make_tuple(false, 0, nullptr);
             auto latest = this->mdo.getLatest();
             DataPlacement *placement;
+            DataPlacement *hostPlacement = nullptr;
             for (auto &placement_id: latest) {
                 placement = this->mdo.getDataPlacementByID(placement_id);
                 if(placement->range == nullptr || *(placement->range) == Range{0, 0, this->getNumRows(),
@@ -140,30 +187,149 @@ auto DenseMatrix<ValueType>::getValuesInternal(const IAllocationDescriptor* allo
                     // prefer host allocation
                     if(placement->allocation->getType() == ALLOCATION_TYPE::HOST) {
                         std::get<2>(result) = reinterpret_cast<ValueType *>(values.get());
+                        hostPlacement = placement;
                         break;
                     }
                 }
             }
 
-            // if we found a data placement that is not in host memory, transfer it there before returning
+            // if we found a data placement that is not in host memory (e.g., on a device or spilled to disk),
+            // transfer it there before returning, the host placement becomes one of the latest versions
             if(std::get<0>(result) == true && std::get<2>(result) == nullptr) {
-                AllocationDescriptorHost myHostAllocInfo;
-                if(!values)
-                    const_cast<DenseMatrix<ValueType> *>(this)->alloc_shared_values();
-                this->mdo.addDataPlacement(&myHostAllocInfo);
-                placement->allocation->transferFrom(reinterpret_cast<std::byte *>(values.get()), bufferSize());
-                std::get<2>(result) = values.get();
+                hostPlacement = loadHostValues(placement);
+                result = std::make_tuple(false, hostPlacement->dp_id, values.get());
             }
             if(std::get<2>(result) == nullptr)
                 throw std::runtime_error("Error: no object meta data in matrix");
-            else
-                return result;
+            if(SpillManager::isEnabled())
+                trackResidency(hostPlacement);
+            return result;
         }
     }
     else
         throw std::runtime_error("Error: range support under construction");
 }
 
+template<typename ValueType>
+DenseMatrix<ValueType>::~DenseMatrix() {
+    if(transposedSrc)
+        DataObjectFactory::destroy(transposedSrc);
+    for(auto type = 0u; type < static_cast<size_t>(ALLOCATION_TYPE::NUM_ALLOC_TYPES); ++type)
+        for(auto &placement : *this->mdo.getDataPlacementByType(static_cast<ALLOCATION_TYPE>(type)))
+            if(auto residency = placement->allocation->getResidencyManager())
+                residency->forget(this);
+}
+
+template<typename ValueType>
+void DenseMatrix<ValueType>::trackResidency(const DataPlacement* placement) {
+    auto residency = placement->allocation->getResidencyManager();
+    if(!residency || residency->touch(this, placement->dp_id))
+        return;
+    // host values shared with other matrices (e.g., views) would not be freed by spilling them
+    if(placement->allocation->getType() == ALLOCATION_TYPE::HOST && (rowSkip != numCols || values.use_count() != 1))
+        return;
+    const size_t id = placement->dp_id;
+    residency->track(this, id, bufferSize(), [this, id]() { return isOnlyLatestVersion(id); },
+            [this, id]() { evictDataPlacement(id); });
+}
+
+template<typename ValueType>
+bool DenseMatrix<ValueType>::isOnlyLatestVersion(size_t id) const {
+    auto latest = this->mdo.getLatest();
+    return latest.size() == 1 && latest.front() == id;
+}
+
+template<typename ValueType>
+void DenseMatrix<ValueType>::evictDataPlacement(size_t id) {
+    auto placement = this->mdo.getDataPlacementByID(id);
+    if(!placement)
+        return;
+    if(placement->allocation->getType() == ALLOCATION_TYPE::HOST) {
+        spillValues(placement);
+        return;
+    }
+    // write back to the host allocation, which becomes the latest version
+    if(isOnlyLatestVersion(id))
+        this->mdo.setLatest(loadHostValues(placement)->dp_id);
+    this->mdo.removeDataPlacement(id);
+}
+
+template<typename ValueType>
+void DenseMatrix<ValueType>::spillValues(const DataPlacement* placement) {
+    // the values may have been shared since they were tracked
+    if(!values || rowSkip != numCols || values.use_count() != 1)
+        return;
+    const size_t id = placement->dp_id;
+    if(isOnlyLatestVersion(id)) {
+        // a spill file of values changed since they were reloaded is overwritten
+        auto diskPlacements = this->mdo.getDataPlacementByType(ALLOCATION_TYPE::DISK);
+        DataPlacement* disk;
+        if(diskPlacements->empty()) {
+            AllocationDescriptorDisk myDiskAllocInfo(numCols, getSpillValueTypeCode<ValueType>(), sizeof(ValueType));
+            disk = this->mdo.addDataPlacement(&myDiskAllocInfo);
+            disk->allocation->createAllocation(bufferSize(), false);
+        }
+        else
+            disk = diskPlacements->front().get();
+        disk->allocation->transferTo(reinterpret_cast<std::byte *>(values.get()), bufferSize());
+        this->mdo.setLatest(disk->dp_id);
+    }
+    this->mdo.removeDataPlacement(id);
+    values.reset();
+}
+
+template<typename ValueType>
+DataPlacement* DenseMatrix<ValueType>::loadHostValues(const DataPlacement* src) {
+    if(!values)
+        alloc_shared_values();
+    src->allocation->transferFrom(reinterpret_cast<std::byte *>(values.get()), bufferSize());
+    auto hostPlacements = this->mdo.getDataPlacementByType(ALLOCATION_TYPE::HOST);
+    if(!hostPlacements->empty())
+        return hostPlacements->front().get();
+    AllocationDescriptorHost myHostAllocInfo;
+    return this->mdo.addDataPlacement(&myHostAllocInfo);
+}
+
+template<typename ValueType>
+void DenseMatrix<ValueType>::materializeTransposition() const {
+    // the edge length of the square tiles, which are transposed such that neither the reads nor the writes stride
+    // through memory
+    constexpr size_t TILE = 32;
+    std::lock_guard<std::mutex> lock(transpositionMutex);
+    if(!transpositionPending.load(std::memory_order_relaxed))
+        return;
+    auto self = const_cast<DenseMatrix<ValueType> *>(this);
+    self->alloc_shared_values();
+    const ValueType * valuesSrc = transposedSrc->getValues();
+    const size_t rowSkipSrc = transposedSrc->rowSkip;
+    ValueType * valuesRes = values.get();
+    for(size_t r0 = 0; r0 < numRows; r0 += TILE)
+        for(size_t c0 = 0; c0 < numCols; c0 += TILE) {
+            const size_t rowEnd = std::min(r0 + TILE, numRows);
+            const size_t colEnd = std::min(c0 + TILE, numCols);
+            for(size_t c = c0; c < colEnd; c++)
+                for(size_t r = r0; r < rowEnd; r++)
+                    valuesRes[r * rowSkip + c] = valuesSrc[c * rowSkipSrc + r];
+        }
+    transpositionPending.store(false, std::memory_order_release);
+}
+
+template<typename ValueType>
+void DenseMatrix<ValueType>::releaseTransposedSource() {
+    if(transpositionPending.load(std::memory_order_acquire))
+        materializeTransposition();
+    DataObjectFactory::destroy(transposedSrc);
+    transposedSrc = nullptr;
+}
+
+template<typename ValueType>
+void DenseMatrix<ValueType>::reloadSpilledValues() const {
+    if(transpositionPending.load(std::memory_order_acquire))
+        materializeTransposition();
+    if(!values && !this->mdo.getDataPlacementByType(ALLOCATION_TYPE::DISK)->empty())
+        getValues();
+}
+
 template <typename ValueType> void DenseMatrix<ValueType>::printValue(std::ostream & os, ValueType val) const {
     os << val;
 }
@@ -186,8 +352,13 @@ void DenseMatrix<ValueType>::alloc_shared_values(std::shared_ptr<ValueType[]> sr
     if(src) {
         values = std::shared_ptr<ValueType[]>(src, src.get() + offset);
     }
-    else
-        values = std::shared_ptr<ValueType[]>(new ValueType[numRows*numCols]);
+    else {
+        // other matrices may have to be spilled to keep the values in main memory within the budget
+        SpillManager::get().makeRoom(numRows * numCols * sizeof(ValueType));
+        values = BufferPool::get().allocShared<ValueType>(numRows*numCols);
+        // e.g., values reloaded after spilling do not keep the spare rows
+        numSpareRows = 0;
+    }
 }
 
 template<typename ValueType>
@@ -17,15 +17,22 @@
 #pragma once
 
 #include <runtime/local/datastructures/AllocationDescriptorHost.h>
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/ColumnStats.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/KeyIndex.h>
 #include <runtime/local/datastructures/Matrix.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 
 /**
@@ -39,6 +46,10 @@
  * `DenseMatrix`. Thus, in general, the row skip (see `getRowSkip()`) needs to
  * be added to a pointer to a particular cell in the `values` array in order to
  * obtain a pointer to the corresponding cell in the next row.
+ *
+ * An instance might also be the lazy transposition of another `DenseMatrix`
+ * (see `getTransposedSource()`), whose values are only transposed when they
+ * are accessed directly.
  */
 template <typename ValueType>
 class DenseMatrix : public Matrix<ValueType>
@@ -49,10 +60,22 @@ class DenseMatrix : public Matrix<ValueType>
     using Matrix<ValueType>::numCols;
     
     size_t rowSkip;
+    // the column of the rows of the values the first column of this matrix is at, such that views know how many
+    // columns of the row skip follow their last one
+    size_t colOffset = 0;
+    // the rows of the values after the last row of this matrix, which were allocated but no row of this matrix
+    // covers (e.g., the capacity reserved by `RowBind` for appending rows in place)
+    size_t numSpareRows = 0;
     std::shared_ptr<ValueType[]> values{};
     
     size_t lastAppendedRowIdx;
     size_t lastAppendedColIdx;
+
+    // the matrix this one is the transposition of, which it holds a reference to, see `getTransposedSource()`
+    const DenseMatrix<ValueType> * transposedSrc = nullptr;
+    // whether the values of the transposition were not created yet
+    mutable std::atomic<bool> transpositionPending{false};
+    mutable std::mutex transpositionMutex;
     
     // Grant DataObjectFactory access to the private constructors and
     // destructors.
@@ -92,7 +115,27 @@ class DenseMatrix : public Matrix<ValueType>
     DenseMatrix(const DenseMatrix<ValueType> * src, size_t rowLowerIncl, size_t rowUpperExcl, size_t colLowerIncl,
             size_t colUpperExcl);
 
-    ~DenseMatrix() override = default;
+    /**
+     * @brief Creates a `DenseMatrix` starting at the first cell of another `DenseMatrix` and sharing its values and
+     * row skip without copying the data, but of the given size, which may extend beyond the other matrix within the
+     * same values (e.g., to the adjacent columns or rows of another view on them, or to its spare columns).
+     *
+     * @param src The other dense matrix.
+     * @param numRows The exact number of rows, such that the rows lie within the values of `src` (e.g., at most the
+     * rows of `src` plus its spare rows).
+     * @param numCols The exact number of columns, at most the columns of `src` plus its spare columns.
+     */
+    DenseMatrix(const DenseMatrix<ValueType> * src, size_t numRows, size_t numCols);
+
+    /**
+     * @brief Creates a `DenseMatrix` as the lazy transposition of another `DenseMatrix`, i.e., without transposing
+     * the values until they are accessed directly (see `getTransposedSource()`).
+     *
+     * @param src The other dense matrix, which is referenced until this matrix is destroyed or written.
+     */
+    explicit DenseMatrix(const DenseMatrix<ValueType> * src);
+
+    ~DenseMatrix() override;
 
     [[nodiscard]] size_t pos(size_t rowIdx, size_t colIdx) const {
         if(rowIdx >= numRows)
@@ -153,11 +196,33 @@ class DenseMatrix : public Matrix<ValueType>
     auto getValuesInternal(const IAllocationDescriptor* alloc_desc = nullptr, const Range* range = nullptr)
     -> std::tuple<bool, size_t, ValueType*>;
 
+    // reports an access to the placement to the residency manager of its memory (if any)
+    void trackResidency(const DataPlacement* placement);
+
+    // whether the placement holds the only latest version of the values, i.e., is the only up-to-date copy
+    [[nodiscard]] bool isOnlyLatestVersion(size_t id) const;
+
+    // transfers the values from another placement to main memory and returns the host placement
+    DataPlacement* loadHostValues(const DataPlacement* src);
+
+    // writes the host values to a spill file (unless it is up to date) and frees them, see SpillManager
+    void spillValues(const DataPlacement* placement);
+
+    // transfers the values back to main memory if they were spilled, before they are accessed directly
+    void reloadSpilledValues() const;
+
+    // creates the values of a lazy transposition from its source (once, even if called concurrently)
+    void materializeTransposition() const;
+
+    // ends a lazy transposition before its values are written, which no longer are the transposed source then
+    void releaseTransposedSource();
+
 public:
 
     void shrinkNumRows(size_t numRows) {
         assert((numRows <= this->numRows) && "number of rows can only the shrunk");
         // TODO Here we could reduce the allocated size of the values array.
+        numSpareRows += this->numRows - numRows;
         this->numRows = numRows;
     }
     
@@ -165,6 +230,50 @@ public:
         return rowSkip;
     }
 
+    /**
+     * @brief Returns the matrix this matrix is the transposition of, if it was created lazily by `Transpose`, or
+     * `nullptr`.
+     *
+     * Kernels which can process a transposed operand natively (e.g., BLAS by `CblasTrans`) should read the source
+     * instead, such that the transposition costs nothing. The values of this matrix are only created when they are
+     * accessed directly (e.g., by `getValues()`), and the source is released when this matrix is written.
+     */
+    [[nodiscard]] const DenseMatrix<ValueType> * getTransposedSource() const {
+        return transposedSrc;
+    }
+
+    /**
+     * @brief The number of columns of the row skip after the last column of this matrix, which no column of this
+     * matrix covers (e.g., the capacity reserved by `ColBind` for appending columns in place).
+     */
+    [[nodiscard]] size_t getNumSpareCols() const {
+        return rowSkip - colOffset - numCols;
+    }
+
+    /**
+     * @brief The number of rows of the values after the last row of this matrix, which were allocated but no row of
+     * this matrix covers (e.g., the capacity reserved by `RowBind` for appending rows in place, or the rows cut off by
+     * `shrinkNumRows()`).
+     *
+     * Other matrices may cover them, unless this matrix is the only one on its values.
+     */
+    [[nodiscard]] size_t getNumSpareRows() const {
+        return numSpareRows;
+    }
+
+    /**
+     * @brief Whether each row of the host values starts at a multiple of
+     * `BufferPool::ALIGNMENT` bytes, such that kernels may use aligned loads
+     * and stores (e.g., through `__builtin_assume_aligned`).
+     *
+     * The arrays allocated for matrices are always aligned, but views may
+     * start anywhere within them and rows are not padded.
+     */
+    [[nodiscard]] bool isAligned() const {
+        const bool rowsAligned = this->numRows <= 1 || (rowSkip * sizeof(ValueType)) % BufferPool::ALIGNMENT == 0;
+        return rowsAligned && reinterpret_cast<uintptr_t>(values.get()) % BufferPool::ALIGNMENT == 0;
+    }
+
     /**
      * @brief Fetch a pointer to the data held by this structure meant for read-only access.
      *
@@ -189,7 +298,8 @@ public:
      * @brief Fetch a pointer to the data held by this structure meant for read-write access.
      *
      * A difference is made between read-only and read-write access. With read-write access, all copies in various
-     * memory spaces will be invalidated because data is assumed to change.
+     * memory spaces will be invalidated because data is assumed to change, as is the data derived from the values
+     * (see `MetaDataObject::getDerived()`).
      *
      * @param alloc_desc An allocation descriptor describing which type of memory is requested (e.g. main memory in
      * the current system, memory in an accelerator card or memory in another host)
@@ -198,17 +308,72 @@ public:
      * @return A pointer to the data in the requested memory space
      */
     ValueType* getValues(IAllocationDescriptor* alloc_desc = nullptr, const Range* range = nullptr) {
+        if(transposedSrc)
+            releaseTransposedSource();
         auto [isLatest, id, ptr] = const_cast<DenseMatrix<ValueType>*>(this)->getValuesInternal(alloc_desc, range);
-        if(!isLatest)
-            this->mdo.setLatest(id);
+        // even if the allocation was up to date, the other ones are outdated by the write, as is the derived data
+        this->mdo.setLatest(id);
+        this->mdo.invalidateDerived();
         return ptr;
     }
     
     std::shared_ptr<ValueType[]> getValuesSharedPtr() const {
+        reloadSpilledValues();
         return values;
     }
+
+    /**
+     * @brief Whether a kernel may overwrite the values of this matrix with its
+     * result, i.e., this matrix is at the last use of its only reference and
+     * no other data object (e.g., a view) shares its values.
+     */
+    [[nodiscard]] bool isOverwritable() const {
+        return this->isAtLastUse() && this->getRefCounter() == 1 && values.use_count() == 1;
+    }
+
+    /**
+     * @brief Returns the statistics of the c-th column (see `ZoneMap`), or `nullptr` if none were computed or the
+     * values were written since.
+     */
+    [[nodiscard]] std::shared_ptr<const ZoneMap<ValueType>> getZoneMap(size_t c) const {
+        auto stats = this->mdo.template getDerived<MatrixColumnStats<ValueType>>();
+        return (stats && c < stats->columns.size()) ? stats->columns[c] : nullptr;
+    }
+
+    /**
+     * @brief Returns the index of the values of the c-th column (see `KeyIndex`), or `nullptr` if it has none or
+     * the values were written since.
+     */
+    [[nodiscard]] std::shared_ptr<const KeyIndex> getKeyIndex(size_t c) const {
+        auto stats = this->mdo.template getDerived<MatrixColumnStats<ValueType>>();
+        return (stats && c < stats->indexes.size()) ? stats->indexes[c] : nullptr;
+    }
+
+    /**
+     * @brief Keeps the statistics of the columns (one per column, `nullptr` for a column without) and, optionally,
+     * their indexes, replacing the other data derived from the values (e.g., the factorization kept by `Solve`).
+     */
+    void setZoneMaps(std::vector<std::shared_ptr<const ZoneMap<ValueType>>> zoneMaps,
+            std::vector<std::shared_ptr<const KeyIndex>> keyIndexes = {}) const {
+        auto stats = std::make_shared<MatrixColumnStats<ValueType>>();
+        stats->columns = std::move(zoneMaps);
+        stats->indexes = std::move(keyIndexes);
+        this->mdo.setDerived(std::move(stats));
+    }
+
+    /**
+     * @brief Removes a placement of the values, e.g., when its residency manager evicts it. If a device placement
+     * holds the only latest version, it is written back to the host before. The host placement is spilled to disk
+     * instead (see `SpillManager`), unless its values are shared with other matrices.
+     *
+     * @param id The ID of the data placement.
+     */
+    void evictDataPlacement(size_t id);
     
     ValueType get(size_t rowIdx, size_t colIdx) const override {
+        // a single cell of a lazy transposition does not need all values
+        if(transpositionPending.load(std::memory_order_acquire))
+            return transposedSrc->get(colIdx, rowIdx);
         return getValues()[pos(rowIdx, colIdx)];
     }
     
@@ -218,6 +383,8 @@ public:
     }
     
     void prepareAppend() override {
+        if(transposedSrc)
+            releaseTransposedSource();
         values.get()[0] = ValueType(0);
         lastAppendedRowIdx = 0;
         lastAppendedColIdx = 0;
@@ -264,6 +431,31 @@ public:
         return DataObjectFactory::create<DenseMatrix<ValueType>>(this, rl, ru, cl, cu);
     }
 
+    bool rebindRowView(const Structure* src, size_t rl, size_t ru) override {
+        // a view which was transferred to another device cannot be moved
+        if(this->mdo.hasPlacementsOtherThan(ALLOCATION_TYPE::HOST) || transposedSrc)
+            return false;
+        if(!src) {
+            values.reset();
+            numRows = 0;
+            return true;
+        }
+        auto srcMat = dynamic_cast<const DenseMatrix<ValueType>*>(src);
+        if(!srcMat)
+            return false;
+        srcMat->reloadSpilledValues();
+        assert((rl < ru && ru <= srcMat->numRows) && "invalid row range");
+        numRows = ru - rl;
+        numCols = srcMat->numCols;
+        rowSkip = srcMat->rowSkip;
+        colOffset = srcMat->colOffset;
+        numSpareRows = 0;
+        alloc_shared_values(srcMat->values, rl * srcMat->rowSkip);
+        lastAppendedRowIdx = 0;
+        lastAppendedColIdx = 0;
+        return true;
+    }
+
     // convenience functions
     size_t bufferSize();
 
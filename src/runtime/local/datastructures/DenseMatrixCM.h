@@ -0,0 +1,231 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Matrix.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief A dense matrix with its values arranged in column-major fashion.
+ *
+ * Like a `DenseMatrix`, but the array contains all values in the first
+ * column, followed by all values in the second column, etc. This suits
+ * column-oriented workloads: each column is a contiguous array, such that
+ * column aggregations, column extraction and column binding stream through
+ * memory, the columns can be shared with a `Frame` without copying them (see
+ * `CastObj`), and BLAS is called with `CblasColMajor` rather than on
+ * transposed copies.
+ *
+ * Each instance of this class might represent a sub-matrix of another
+ * `DenseMatrixCM`. Thus, in general, the column skip (see `getColSkip()`)
+ * needs to be added to a pointer to a particular cell in the `values` array in
+ * order to obtain a pointer to the corresponding cell in the next column.
+ */
+template<typename ValueType>
+class DenseMatrixCM : public Matrix<ValueType> {
+    // `using`, so that we do not need to prefix each occurrence of these
+    // fields from the super-classes.
+    using Matrix<ValueType>::numRows;
+    using Matrix<ValueType>::numCols;
+
+    size_t colSkip;
+    std::shared_ptr<ValueType[]> values;
+
+    // Grant DataObjectFactory access to the private constructors and
+    // destructors.
+    template<class DataType, typename ... ArgTypes>
+    friend DataType * DataObjectFactory::create(ArgTypes ...);
+    template<class DataType>
+    friend void DataObjectFactory::destroy(const DataType * obj);
+
+    /**
+     * @brief Creates a `DenseMatrixCM` and allocates enough memory for the
+     * specified size in the `values` array.
+     *
+     * @param numRows The exact number of rows.
+     * @param numCols The exact number of columns.
+     * @param zero Whether the allocated memory of the `values` array shall be
+     * initialized to zeros (`true`), or be left uninitialized (`false`).
+     */
+    DenseMatrixCM(size_t numRows, size_t numCols, bool zero) :
+            Matrix<ValueType>(numRows, numCols), colSkip(numRows),
+            values(BufferPool::get().allocShared<ValueType>(numRows * numCols))
+    {
+        if(zero)
+            memset(values.get(), 0, numRows * numCols * sizeof(ValueType));
+    }
+
+    /**
+     * @brief Creates a `DenseMatrixCM` around an existing array of values
+     * without copying the data.
+     *
+     * @param numRows The exact number of rows.
+     * @param numCols The exact number of columns.
+     * @param values The array of values, the first column at its start.
+     * @param colSkip The distance between the starts of two adjacent columns,
+     * at least `numRows`.
+     */
+    DenseMatrixCM(size_t numRows, size_t numCols, std::shared_ptr<ValueType[]> values, size_t colSkip) :
+            Matrix<ValueType>(numRows, numCols), colSkip(colSkip), values(std::move(values))
+    {
+        assert((colSkip >= numRows || numCols <= 1) && "colSkip must not be less than numRows");
+    }
+
+    /**
+     * @brief Creates a `DenseMatrixCM` around a sub-matrix of another
+     * `DenseMatrixCM` without copying the data.
+     *
+     * @param src The other dense matrix.
+     * @param rowLowerIncl Inclusive lower bound for the range of rows to extract.
+     * @param rowUpperExcl Exclusive upper bound for the range of rows to extract.
+     * @param colLowerIncl Inclusive lower bound for the range of columns to extract.
+     * @param colUpperExcl Exclusive upper bound for the range of columns to extract.
+     */
+    DenseMatrixCM(const DenseMatrixCM<ValueType> * src, size_t rowLowerIncl, size_t rowUpperExcl,
+            size_t colLowerIncl, size_t colUpperExcl) :
+            Matrix<ValueType>(rowUpperExcl - rowLowerIncl, colUpperExcl - colLowerIncl), colSkip(src->colSkip),
+            values(src->values, src->values.get() + colLowerIncl * src->colSkip + rowLowerIncl)
+    {
+        // nothing to do
+    }
+
+    virtual ~DenseMatrixCM() {
+        // nothing to do
+    }
+
+    void printValue(std::ostream & os, ValueType val) const {
+        switch(ValueTypeUtils::codeFor<ValueType>) {
+            case ValueTypeCode::SI8 : os << static_cast<int32_t>(val); break;
+            case ValueTypeCode::UI8 : os << static_cast<uint32_t>(val); break;
+            default : os << val; break;
+        }
+    }
+
+public:
+
+    /**
+     * @brief The distance between the starts of two adjacent columns in the
+     * `values` array.
+     */
+    size_t getColSkip() const {
+        return colSkip;
+    }
+
+    const ValueType * getValues() const {
+        return values.get();
+    }
+
+    ValueType * getValues() {
+        return values.get();
+    }
+
+    std::shared_ptr<ValueType[]> getValuesSharedPtr() const {
+        return values;
+    }
+
+    /**
+     * @brief Returns a pointer to the contiguous values of the given column.
+     */
+    const ValueType * getColumn(size_t colIdx) const {
+        return values.get() + colIdx * colSkip;
+    }
+
+    ValueType * getColumn(size_t colIdx) {
+        return values.get() + colIdx * colSkip;
+    }
+
+    /**
+     * @brief Returns whether the columns of this matrix are adjacent in the
+     * `values` array, such that it can be treated as one array.
+     */
+    bool isContiguous() const {
+        return colSkip == numRows || numCols <= 1;
+    }
+
+    ValueType get(size_t rowIdx, size_t colIdx) const override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        return values.get()[colIdx * colSkip + rowIdx];
+    }
+
+    void set(size_t rowIdx, size_t colIdx, ValueType value) override {
+        assert((rowIdx < numRows) && "rowIdx is out of bounds");
+        assert((colIdx < numCols) && "colIdx is out of bounds");
+        values.get()[colIdx * colSkip + rowIdx] = value;
+    }
+
+    void prepareAppend() override {
+        for(size_t c = 0; c < numCols; c++)
+            memset(getColumn(c), 0, numRows * sizeof(ValueType));
+    }
+
+    void append(size_t rowIdx, size_t colIdx, ValueType value) override {
+        set(rowIdx, colIdx, value);
+    }
+
+    void finishAppend() override {
+        // nothing to do
+    }
+
+    void print(std::ostream & os) const override {
+        os << "DenseMatrixCM(" << numRows << 'x' << numCols << ", " << ValueTypeUtils::cppNameFor<ValueType> << ')'
+                << std::endl;
+        for(size_t r = 0; r < numRows; r++) {
+            for(size_t c = 0; c < numCols; c++) {
+                printValue(os, get(r, c));
+                if(c < numCols - 1)
+                    os << ' ';
+            }
+            os << std::endl;
+        }
+    }
+
+    DenseMatrixCM* sliceRow(size_t rl, size_t ru) const override {
+        return slice(rl, ru, 0, numCols);
+    }
+
+    DenseMatrixCM* sliceCol(size_t cl, size_t cu) const override {
+        return slice(0, numRows, cl, cu);
+    }
+
+    /**
+     * @brief Returns a view on the given rows and columns of this matrix.
+     */
+    DenseMatrixCM* slice(size_t rl, size_t ru, size_t cl, size_t cu) const override {
+        if(rl > ru || ru > numRows || cl > cu || cu > numCols)
+            throw std::runtime_error("DenseMatrixCM: the bounds of the slice are invalid");
+        return DataObjectFactory::create<DenseMatrixCM<ValueType>>(this, rl, ru, cl, cu);
+    }
+};
+
+template <typename ValueType>
+std::ostream & operator<<(std::ostream & os, const DenseMatrixCM<ValueType> & obj)
+{
+    obj.print(os);
+    return os;
+}
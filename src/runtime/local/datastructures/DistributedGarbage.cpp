@@ -0,0 +1,128 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DistributedGarbage.h>
+
+#include <iomanip>
+
+DistributedGarbage & DistributedGarbage::get() {
+    static DistributedGarbage * garbage = new DistributedGarbage();
+    return *garbage;
+}
+
+void DistributedGarbage::work() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while(true) {
+        cv.wait(lock, [this]() { return stopped || !batches.empty(); });
+        if(batches.empty())
+            return;
+        auto batch = std::move(batches.front());
+        batches.pop_front();
+        numInFlight++;
+        FreeFunction fn = freeFn;
+        lock.unlock();
+        std::optional<uint64_t> residentBytes;
+        try {
+            residentBytes = fn(batch.first, batch.second);
+        }
+        catch(...) {
+            // the worker failed, see DistributedContext::excludeWorker
+        }
+        lock.lock();
+        WorkerStats & workerStats = stats[batch.first];
+        if(residentBytes) {
+            workerStats.numFreed += batch.second.size();
+            workerStats.residentBytes = residentBytes;
+        }
+        else
+            workerStats.numFailed += batch.second.size();
+        numInFlight--;
+        idleCv.notify_all();
+    }
+}
+
+void DistributedGarbage::setFreeFunction(FreeFunction fn) {
+    std::lock_guard<std::mutex> lock(mtx);
+    freeFn = std::move(fn);
+    stopped = false;
+    if(!thread.joinable())
+        thread = std::thread(&DistributedGarbage::work, this);
+}
+
+void DistributedGarbage::shutdown() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopped = true;
+        cv.notify_all();
+    }
+    if(thread.joinable())
+        thread.join();
+    std::lock_guard<std::mutex> lock(mtx);
+    freeFn = nullptr;
+}
+
+std::shared_ptr<void> DistributedGarbage::hold(const std::string &worker, const std::string &identifier) {
+    // the handle points to the collector, such that it is not null
+    return std::shared_ptr<void>(this, [worker, identifier](void *) {
+        DistributedGarbage::get().release(worker, identifier);
+    });
+}
+
+void DistributedGarbage::release(const std::string &worker, const std::string &identifier) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if(!freeFn || stopped)
+        return;
+    auto &ids = pending[worker];
+    ids.push_back(identifier);
+    if(ids.size() >= BATCH_SIZE) {
+        batches.emplace_back(worker, std::move(ids));
+        pending.erase(worker);
+        cv.notify_one();
+    }
+}
+
+void DistributedGarbage::flush(bool wait) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if(!freeFn || !thread.joinable())
+        return;
+    for(auto &p : pending)
+        batches.emplace_back(p.first, std::move(p.second));
+    pending.clear();
+    cv.notify_one();
+    if(wait)
+        idleCv.wait(lock, [this]() { return batches.empty() && numInFlight == 0; });
+}
+
+std::map<std::string, DistributedGarbage::WorkerStats> DistributedGarbage::getStats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
+
+void DistributedGarbage::printStats(std::ostream &os) const {
+    const auto workerStats = getStats();
+    if(workerStats.empty())
+        return;
+    os << "Distributed data freed at the workers:" << std::endl;
+    for(const auto &[worker, s] : workerStats) {
+        os << "  " << std::left << std::setw(24) << worker << std::right << s.numFreed << " freed";
+        if(s.numFailed)
+            os << ", " << s.numFailed << " failed";
+        if(s.residentBytes)
+            os << ", " << std::fixed << std::setprecision(1) << (*s.residentBytes / 1e6) << " MB held";
+        os << std::endl;
+    }
+}
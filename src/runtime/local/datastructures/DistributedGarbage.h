@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Frees the data the distributed workers hold for the coordinator once the data objects placed there are
+ * destroyed, such that the memory of the workers does not grow with the iterations of a program.
+ *
+ * The allocation descriptors of the placements keep a handle of the data at the worker (see `hold()`), which their
+ * copies share. When the last copy is gone, e.g., after `DataObjectFactory::destroy()` destroyed the data object, the
+ * identifier of the data is queued for its worker. The identifiers are freed in batches of up to `BATCH_SIZE` per
+ * worker by a thread in the background, which calls the free function of the distributed backend (see
+ * `setFreeFunction()`); `flush()` frees the remaining ones, e.g., before each distributed pipeline. Without a free
+ * function, e.g., before the distributed context was created or after it was destroyed, the identifiers are dropped.
+ */
+class DistributedGarbage {
+public:
+    static constexpr size_t BATCH_SIZE = 64;
+
+    /**
+     * @brief Frees the data of the given identifiers at the given worker and returns the bytes the worker holds
+     * afterwards, or `std::nullopt` if the worker did not answer.
+     */
+    using FreeFunction = std::function<std::optional<uint64_t>(const std::string &worker,
+                                                               const std::vector<std::string> &identifiers)>;
+
+    struct WorkerStats {
+        size_t numFreed = 0;
+        // the identifiers of failed calls, e.g., to a failed worker
+        size_t numFailed = 0;
+        // the bytes the worker reported to hold after the last call
+        std::optional<uint64_t> residentBytes;
+    };
+
+private:
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    // notified when a batch was freed, see `flush()`
+    std::condition_variable idleCv;
+    FreeFunction freeFn;
+    // the identifiers by worker, which are not yet part of a batch
+    std::map<std::string, std::vector<std::string>> pending;
+    std::deque<std::pair<std::string, std::vector<std::string>>> batches;
+    size_t numInFlight = 0;
+    std::map<std::string, WorkerStats> stats;
+    std::thread thread;
+    bool stopped = false;
+
+    DistributedGarbage() = default;
+
+    void work();
+
+public:
+    DistributedGarbage(const DistributedGarbage &) = delete;
+    DistributedGarbage & operator=(const DistributedGarbage &) = delete;
+
+    /**
+     * @brief Returns the process-wide collector, which lives until the process ends.
+     */
+    static DistributedGarbage & get();
+
+    /**
+     * @brief Sets the free function of the distributed backend and starts freeing the queued identifiers.
+     */
+    void setFreeFunction(FreeFunction fn);
+
+    /**
+     * @brief Frees the remaining identifiers, waits for them, and stops freeing, e.g., when the distributed context
+     * is destroyed.
+     */
+    void shutdown();
+
+    /**
+     * @brief Returns a handle of the data of the given identifier at the given worker, which is queued to be freed
+     * once the handle (and all copies of it) are dropped.
+     */
+    std::shared_ptr<void> hold(const std::string &worker, const std::string &identifier);
+
+    /**
+     * @brief Queues the data of the given identifier at the given worker to be freed.
+     */
+    void release(const std::string &worker, const std::string &identifier);
+
+    /**
+     * @brief Frees all queued identifiers, and waits until they are freed if `wait` is set.
+     */
+    void flush(bool wait = true);
+
+    std::map<std::string, WorkerStats> getStats() const;
+
+    /**
+     * @brief Prints the number of freed identifiers and the bytes held per worker, if any were freed.
+     */
+    void printStats(std::ostream &os) const;
+};
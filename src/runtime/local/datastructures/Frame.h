@@ -17,17 +17,24 @@
 #ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_FRAME_H
 #define SRC_RUNTIME_LOCAL_DATASTRUCTURES_FRAME_H
 
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/ColumnEncoding.h>
+#include <runtime/local/datastructures/ColumnStats.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/FrameSchema.h>
+#include <runtime/local/datastructures/KeyIndex.h>
 #include <runtime/local/datastructures/Structure.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <cassert>
@@ -39,7 +46,13 @@
  * @brief A data structure with an individual value type per column.
  * 
  * A `Frame` is organized in column-major fashion and is backed by an
- * individual dense array for each column.
+ * individual dense array for each column. Optionally, a column can be stored
+ * in a compressed encoding instead, see `encodeColumn()`, and can have
+ * statistics on its values, see `getColumnStats()`.
+ * 
+ * The array of a column of value type `ValueTypeCode::STR` holds a
+ * `std::string` per row. Kernels copying the rows of such a column must copy
+ * the strings rather than their bytes.
  */
 class Frame : public Structure {
     
@@ -51,24 +64,19 @@ class Frame : public Structure {
     friend void DataObjectFactory::destroy(const DataType * obj);
     
     /**
-     * @brief An array of length `numCols` of the value types of the columns of
-     * this frame.
+     * @brief The value types and the labels of the columns of this frame,
+     * shared with the frames of the same columns (e.g., its row slices).
      * 
      * Note that the schema is not encoded as template parameters since this
      * would lead to an explosion of frame types to be compiled.
      */
-    ValueTypeCode * schema;
-    
-    /**
-     * @brief An array of length `numCols` of the names of the columns of this
-     * frame.
-     */
-    std::string * labels;
+    std::shared_ptr<const FrameSchema> meta;
     
     /**
-     * @brief A mapping from a column's label to its position in the frame.
+     * @brief Shorthand for the array of length `numCols` of the value types
+     * of the columns of `meta`.
      */
-    std::unordered_map<std::string, size_t> labels2idxs;
+    const ValueTypeCode * schema;
     
     /**
      * @brief The common pointer type used for the array of each column,
@@ -90,41 +98,63 @@ class Frame : public Structure {
     std::shared_ptr<ColByteType> * columns;
     
     /**
-     * @brief Initializes the mapping from column labels to column positions in
-     * the frame and checks for duplicate column labels.
+     * @brief An array of length `numCols` of the encoded representations of
+     * the columns of this frame, `nullptr` for columns without an encoding.
      * 
-     * This method should be called by each constructor, after the column
-     * labels have been initialized.
+     * The dense array of an encoded column is only created when the column is
+     * accessed as such, see `materialize()`. Encoded columns may hold more
+     * rows than this frame (e.g., if this frame is a view), the rows beyond
+     * `numRows` are not part of this frame.
      */
-    void initLabels2Idxs() {
-        labels2idxs.clear();
-        for(size_t i = 0; i < numCols; i++) {
-            if(labels2idxs.count(labels[i]))
-                throw std::runtime_error(
-                        "a frame's column labels must be unique, but '" +
-                        labels[i] + "' occurs more than once"
-                );
-            labels2idxs[labels[i]] = i;
-        }
-    }
-
+    std::shared_ptr<const EncodedColumn> * encodings;
+    
     /**
-     * @brief Initializes the mapping from column labels to column positions in
-     * the frame and assigns default labels to duplicate column labels.
+     * @brief An array of length `numCols` of the statistics of the columns of
+     * this frame, `nullptr` for columns without.
      * 
-     * This method should only be called by constructors, that may intentionally duplicate 
-     * columns, instead of initLabels2Idxs(), after the column labels have been initialized.
+     * The statistics are dropped when a column is accessed through the
+     * non-`const` accessors. Like encoded columns, they may cover more rows
+     * than this frame.
      */
-    void initDeduplicatedLabels2Idxs() {
-        labels2idxs.clear();
-        for(size_t i = 0; i < numCols; i++) {
-            if(labels2idxs.count(labels[i]))
-               labels[i] = getDefaultLabel(i);
-            labels2idxs[labels[i]] = i;
+    std::shared_ptr<const ColumnStats> * stats;
+    
+    /**
+     * @brief Guards the creation of the dense arrays of encoded columns,
+     * which can happen through the `const` accessors.
+     */
+    mutable std::mutex materializeMutex;
+    
+    /**
+     * @brief Allocates the (uninitialized) array of a column, see `BufferPool`.
+     * 
+     * The `std::string`s of a string column are constructed (as empty
+     * strings) and destructed with the array, since they own their bytes.
+     */
+    static std::shared_ptr<ColByteType> allocColumn(ValueTypeCode vtc, size_t numRows) {
+        if(vtc == ValueTypeCode::STR) {
+            std::shared_ptr<std::string[]> column(new std::string[numRows]);
+            return std::shared_ptr<ColByteType>(column, reinterpret_cast<ColByteType *>(column.get()));
         }
+        std::shared_ptr<ColByteType[]> column = BufferPool::get().allocShared<ColByteType>(
+                numRows * ValueTypeUtils::sizeOf(vtc));
+        return std::shared_ptr<ColByteType>(column, column.get());
+    }
+    
+    /**
+     * @brief Creates the dense array of the idx-th column from its encoded
+     * representation, unless it exists already.
+     */
+    void materialize(size_t idx) const {
+        if(!encodings[idx])
+            return;
+        std::lock_guard<std::mutex> lock(materializeMutex);
+        if(columns[idx])
+            return;
+        auto column = allocColumn(schema[idx], numRows);
+        encodings[idx]->decode(column.get(), 0, numRows);
+        columns[idx] = column;
     }
     
-    // TODO Should the given schema array really be copied, or reused?
     /**
      * @brief Creates a `Frame` and allocates enough memory for the specified
      * size.
@@ -133,26 +163,25 @@ class Frame : public Structure {
      * @param numCols The exact number of columns.
      * @param schema An array of length `numCols` of the value types of the
      * individual columns. The given array will be copied.
+     * @param labels An array of length `numCols` of the labels of the
+     * columns, or `nullptr` for the default labels.
      * @param zero Whether the allocated memory of the internal column arrays
      * shall be initialized to zeros (`true`), or be left uninitialized
      * (`false`).
      */
     Frame(size_t maxNumRows, size_t numCols, const ValueTypeCode * schema, const std::string * labels, bool zero) :
             Structure(maxNumRows, numCols),
-            schema(new ValueTypeCode[numCols]),
-            labels(new std::string[numCols]),
-            columns(new std::shared_ptr<ColByteType>[numCols])
+            meta(FrameSchema::create(numCols, schema, labels)),
+            schema(meta->getSchema()),
+            columns(new std::shared_ptr<ColByteType>[numCols]),
+            encodings(new std::shared_ptr<const EncodedColumn>[numCols]),
+            stats(new std::shared_ptr<const ColumnStats>[numCols])
     {
         for(size_t i = 0; i < numCols; i++) {
-            this->schema[i] = schema[i];
-            this->labels[i] = labels ? labels[i] : getDefaultLabel(i);
-            const size_t sizeAlloc = maxNumRows * ValueTypeUtils::sizeOf(schema[i]);
-            this->columns[i] = std::shared_ptr<ColByteType>(new ColByteType[sizeAlloc],
-                    std::default_delete<ColByteType []>());
-            if(zero)
-                memset(this->columns[i].get(), 0, sizeAlloc);
+            this->columns[i] = allocColumn(schema[i], maxNumRows);
+            if(zero && schema[i] != ValueTypeCode::STR)
+                memset(this->columns[i].get(), 0, maxNumRows * ValueTypeUtils::sizeOf(schema[i]));
         }
-        initLabels2Idxs();
     }
     
     Frame(const Frame * lhs, const Frame * rhs) :
@@ -163,28 +192,36 @@ class Frame : public Structure {
                     "both input frames must have the same number of rows"
             );
         
-        schema = new ValueTypeCode[numCols];
-        labels = new std::string[numCols];
-        columns = new std::shared_ptr<ColByteType>[numCols];
-        
         const size_t numColsLhs = lhs->getNumCols();
         const size_t numColsRhs = rhs->getNumCols();
         
+        // The concatenated columns need a schema of their own, which the
+        // slices of the result share again.
+        std::vector<ValueTypeCode> newSchema(lhs->schema, lhs->schema + numColsLhs);
+        newSchema.insert(newSchema.end(), rhs->schema, rhs->schema + numColsRhs);
+        std::vector<std::string> newLabels(lhs->getLabels(), lhs->getLabels() + numColsLhs);
+        newLabels.insert(newLabels.end(), rhs->getLabels(), rhs->getLabels() + numColsRhs);
+        meta = FrameSchema::create(numCols, newSchema.data(), newLabels.data());
+        schema = meta->getSchema();
+        columns = new std::shared_ptr<ColByteType>[numCols];
+        encodings = new std::shared_ptr<const EncodedColumn>[numCols];
+        stats = new std::shared_ptr<const ColumnStats>[numCols];
+        
         for(size_t i = 0; i < numColsLhs; i++) {
-            schema [i] = lhs->schema[i];
-            labels [i] = lhs->labels[i];
             columns[i] = std::shared_ptr<ColByteType>(lhs->columns[i]);
+            encodings[i] = lhs->encodings[i];
+            stats[i] = lhs->stats[i];
         }
         for(size_t i = 0; i < numColsRhs; i++) {
-            schema [numColsLhs + i] = rhs->schema[i];
-            labels [numColsLhs + i] = rhs->labels[i];
             columns[numColsLhs + i] = std::shared_ptr<ColByteType>(rhs->columns[i]);
+            encodings[numColsLhs + i] = rhs->encodings[i];
+            stats[numColsLhs + i] = rhs->stats[i];
         }
-        initLabels2Idxs();
     }
     
     template<typename VT>
-    bool tryValueType(Structure * colMat, ValueTypeCode * schemaSlot, std::shared_ptr<ColByteType> * columnsSlot) {
+    bool tryValueType(Structure * colMat, ValueTypeCode * schemaSlot, std::shared_ptr<ColByteType> * columnsSlot,
+            std::shared_ptr<const ColumnStats> * statsSlot) {
         if(auto colMat2 = dynamic_cast<DenseMatrix<VT> *>(colMat)) {
             assert(
                     (colMat2->getRowSkip() == 1) &&
@@ -193,6 +230,7 @@ class Frame : public Structure {
             *schemaSlot = ValueTypeUtils::codeFor<VT>;
             std::shared_ptr<VT[]> orig = colMat2->getValuesSharedPtr();
             *columnsSlot = std::shared_ptr<ColByteType>(orig, reinterpret_cast<ColByteType *>(orig.get()));
+            *statsSlot = colMat2->getZoneMap(0);
             return true;
         }
         return false;
@@ -219,9 +257,10 @@ class Frame : public Structure {
         const size_t numCols = colMats.size();
         assert(numCols && "you must provide at least one column matrix");
 //        const size_t numRows = colMats[0]->getNumRows();
-        schema = new ValueTypeCode[numCols];
-        this->labels = new std::string[numCols];
+        std::vector<ValueTypeCode> newSchema(numCols);
         columns = new std::shared_ptr<ColByteType>[numCols];
+        encodings = new std::shared_ptr<const EncodedColumn>[numCols];
+        stats = new std::shared_ptr<const ColumnStats>[numCols];
         for(size_t c = 0; c < numCols; c++) {
             Structure * colMat = colMats[c];
             assert(
@@ -232,27 +271,60 @@ class Frame : public Structure {
                     (colMat->getNumRows() == numRows) &&
                     "all given column matrices must have the same number of rows"
             );
-            this->labels[c] = labels ? labels[c] : getDefaultLabel(c);
             // For all value types.
+            ValueTypeCode * schemaSlot = newSchema.data() + c;
             bool found = false;
-            found = found || tryValueType<int8_t> (colMat, schema + c, columns + c);
-            found = found || tryValueType<int32_t>(colMat, schema + c, columns + c);
-            found = found || tryValueType<int64_t>(colMat, schema + c, columns + c);
-            found = found || tryValueType<uint8_t> (colMat, schema + c, columns + c);
-            found = found || tryValueType<uint32_t>(colMat, schema + c, columns + c);
-            found = found || tryValueType<uint64_t>(colMat, schema + c, columns + c);
-            found = found || tryValueType<float> (colMat, schema + c, columns + c);
-            found = found || tryValueType<double>(colMat, schema + c, columns + c);
+            found = found || tryValueType<int8_t> (colMat, schemaSlot, columns + c, stats + c);
+            found = found || tryValueType<int32_t>(colMat, schemaSlot, columns + c, stats + c);
+            found = found || tryValueType<int64_t>(colMat, schemaSlot, columns + c, stats + c);
+            found = found || tryValueType<uint8_t> (colMat, schemaSlot, columns + c, stats + c);
+            found = found || tryValueType<uint32_t>(colMat, schemaSlot, columns + c, stats + c);
+            found = found || tryValueType<uint64_t>(colMat, schemaSlot, columns + c, stats + c);
+            found = found || tryValueType<float> (colMat, schemaSlot, columns + c, stats + c);
+            found = found || tryValueType<double>(colMat, schemaSlot, columns + c, stats + c);
             if(!found)
                 throw std::runtime_error("unsupported value type");
         }
-        initLabels2Idxs();
+        meta = FrameSchema::create(numCols, newSchema.data(), labels);
+        schema = meta->getSchema();
     }
     
+    /**
+     * @brief Creates a `Frame` around the given column arrays and encoded
+     * columns without copying them, e.g., around the buffers of another
+     * library, which the `std::shared_ptr`s release through their deleters.
+     *
+     * @param columns An array of length `numCols` of the column arrays, each
+     * holding at least `numRows` values (`nullptr` for encoded columns). The
+     * array of a `STR` column must hold `std::string`s.
+     * @param encodings An array of length `numCols` of the encoded columns
+     * (`nullptr` for the others), or `nullptr` if no column is encoded.
+     */
+    Frame(size_t numRows, size_t numCols, const ValueTypeCode * schema, const std::string * labels,
+          const std::shared_ptr<ColByteType> * columns, const std::shared_ptr<const EncodedColumn> * encodings) :
+            Structure(numRows, numCols),
+            meta(FrameSchema::create(numCols, schema, labels)),
+            schema(meta->getSchema()),
+            columns(new std::shared_ptr<ColByteType>[numCols]),
+            encodings(new std::shared_ptr<const EncodedColumn>[numCols]),
+            stats(new std::shared_ptr<const ColumnStats>[numCols])
+    {
+        for(size_t i = 0; i < numCols; i++) {
+            this->columns[i] = columns[i];
+            if(encodings)
+                this->encodings[i] = encodings[i];
+            if(!this->columns[i] && !this->encodings[i])
+                throw std::runtime_error("each column of a frame must have an array or an encoding");
+        }
+    }
+
     /**
      * @brief Creates a `Frame` around a sub-frame of another `Frame` without
      * copying the data.
      * 
+     * A slice of all columns of `src` in their order shares the schema and
+     * the labels of `src`, such that it only copies the column pointers.
+     * 
      * @param src The other frame.
      * @param rowLowerIncl Inclusive lower bound for the range of rows to extract.
      * @param rowUpperIncl Exclusive upper bound for the range of rows to extract.
@@ -270,24 +342,48 @@ class Frame : public Structure {
         for(size_t i = 0; i < numCols; i++)
             assert((colIdxs[i] < src->numCols) && "some colIdx is out of bounds");
         
-        this->schema = new ValueTypeCode[numCols];
-        this->labels = new std::string[numCols];
+        bool allCols = numCols == src->numCols;
+        for(size_t i = 0; allCols && i < numCols; i++)
+            allCols = colIdxs[i] == i;
+        if(allCols)
+            this->meta = src->meta;
+        else {
+            std::vector<ValueTypeCode> newSchema(numCols);
+            std::vector<std::string> newLabels(numCols);
+            for(size_t i = 0; i < numCols; i++) {
+                newSchema[i] = src->schema[colIdxs[i]];
+                newLabels[i] = src->getLabels()[colIdxs[i]];
+            }
+            this->meta = FrameSchema::create(numCols, newSchema.data(), newLabels.data(), true);
+        }
+        this->schema = this->meta->getSchema();
         this->columns = new std::shared_ptr<ColByteType>[numCols];
+        this->encodings = new std::shared_ptr<const EncodedColumn>[numCols];
+        this->stats = new std::shared_ptr<const ColumnStats>[numCols];
         for(size_t i = 0; i < numCols; i++) {
-            this->schema[i] = src->schema[colIdxs[i]];
-            this->labels[i] = src->labels[colIdxs[i]];
+            // The statistics of the leading rows bound those of a view on
+            // them.
+            if(rowLowerIncl == 0)
+                this->stats[i] = src->stats[colIdxs[i]];
+            // A view on the leading rows can share the encoded column, other
+            // views need its dense array.
+            if(rowLowerIncl == 0 && src->encodings[colIdxs[i]]) {
+                this->encodings[i] = src->encodings[colIdxs[i]];
+                this->columns[i] = src->columns[colIdxs[i]];
+                continue;
+            }
+            src->materialize(colIdxs[i]);
             this->columns[i] = std::shared_ptr<ColByteType>(
                     src->columns[colIdxs[i]],
                     src->columns[colIdxs[i]].get() + rowLowerIncl * ValueTypeUtils::sizeOf(schema[i])
             );
         }
-        initDeduplicatedLabels2Idxs();
     }
     
     ~Frame() {
-        delete[] schema;
-        delete[] labels;
         delete[] columns;
+        delete[] encodings;
+        delete[] stats;
     }
     
 public:
@@ -299,12 +395,13 @@ public:
      * @return The default label for the pos-th column.
      */
     static const std::string getDefaultLabel(size_t pos) {
-        return "col_" + std::to_string(pos);
+        return FrameSchema::getDefaultLabel(pos);
     }
     
     void shrinkNumRows(size_t numRows) {
         // TODO Here we could reduce the allocated size of the column arrays.
         this->numRows = numRows;
+        this->mdo.invalidateDerived();
     }
     
     const ValueTypeCode * getSchema() const {
@@ -312,20 +409,28 @@ public:
     }
     
     const std::string * getLabels() const {
-        return labels;
+        return meta->getLabels();
     }
     
+    /**
+     * @brief Returns the schema and the labels of this frame, which frames
+     * with the same columns may share.
+     */
+    std::shared_ptr<const FrameSchema> getFrameSchema() const {
+        return meta;
+    }
+    
+    /**
+     * @brief Replaces the labels of this frame. The frames sharing the
+     * previous labels (e.g., the slices of this frame) keep them.
+     */
     void setLabels(const std::string * newLabels) {
-        for(size_t i = 0; i < numCols; i++)
-            labels[i] = newLabels[i];
-        initLabels2Idxs();
+        meta = FrameSchema::create(numCols, schema, newLabels);
+        schema = meta->getSchema();
     }
     
     size_t getColumnIdx(const std::string & label) const {
-        auto it = labels2idxs.find(label);
-        if(it != labels2idxs.end())
-            return it->second;
-        throw std::runtime_error("column label not found: '" + label + "'");
+        return meta->getColumnIdx(label);
     }
     
     ValueTypeCode getColumnType(size_t idx) const {
@@ -337,21 +442,186 @@ public:
         return getColumnType(getColumnIdx(label));
     }
     
+    /**
+     * @brief Stores the idx-th column in the given encoding, replacing its
+     * dense array.
+     * 
+     * The dense array is recreated (but the encoding kept) when the column is
+     * read through the `const` accessors. Accessing the column through the
+     * non-`const` accessors drops the encoding, since the caller could modify
+     * the values.
+     * 
+     * @param idx The position of the column.
+     * @param encoding The encoding to use, `ColumnEncoding::NONE` to store
+     * the column as a dense array only.
+     */
+    void encodeColumn(size_t idx, ColumnEncoding encoding) {
+        assert((idx < numCols) && "column index is out of bounds");
+        materialize(idx);
+        if(encoding == ColumnEncoding::NONE) {
+            encodings[idx] = nullptr;
+            return;
+        }
+        encodings[idx] = ColumnEncodingUtils::encode(encoding, schema[idx], columns[idx].get(), numRows);
+        columns[idx] = nullptr;
+    }
+    
+    /**
+     * @brief Replaces the idx-th column by the given encoded column, which
+     * must have the column's value type and at least `numRows` rows.
+     */
+    void setEncodedColumn(size_t idx, std::shared_ptr<const EncodedColumn> column) {
+        assert((idx < numCols) && "column index is out of bounds");
+        if(column->getValueType() != schema[idx])
+            throw std::runtime_error("the encoded column must have the value type of the column it replaces");
+        if(column->getNumRows() < numRows)
+            throw std::runtime_error("the encoded column must have at least as many rows as the frame");
+        encodings[idx] = std::move(column);
+        columns[idx] = nullptr;
+        stats[idx] = nullptr;
+        this->mdo.invalidateDerived();
+    }
+    
+    ColumnEncoding getColumnEncoding(size_t idx) const {
+        assert((idx < numCols) && "column index is out of bounds");
+        return encodings[idx] ? encodings[idx]->getEncoding() : ColumnEncoding::NONE;
+    }
+    
+    /**
+     * @brief Returns the encoded representation of the idx-th column, or
+     * `nullptr` if the column is not encoded.
+     */
+    std::shared_ptr<const EncodedColumn> getEncodedColumn(size_t idx) const {
+        assert((idx < numCols) && "column index is out of bounds");
+        return encodings[idx];
+    }
+    
+    /**
+     * @brief Returns the codes of the idx-th column, or `nullptr` if the
+     * column is not dictionary-encoded.
+     */
+    const DictionaryCodes * getDictionaryCodes(size_t idx) const {
+        assert((idx < numCols) && "column index is out of bounds");
+        return dynamic_cast<const DictionaryCodes *>(encodings[idx].get());
+    }
+    
+    /**
+     * @brief Returns the idx-th column as a `DictionaryColumn`, or `nullptr`
+     * if the column is not dictionary-encoded.
+     */
+    template<typename ValueType>
+    const DictionaryColumn<ValueType> * getDictionaryColumn(size_t idx) const {
+        assert((idx < numCols) && "column index is out of bounds");
+        return dynamic_cast<const DictionaryColumn<ValueType> *>(encodings[idx].get());
+    }
+    
+    /**
+     * @brief Returns the statistics of the idx-th column, or `nullptr` if the
+     * column has none.
+     */
+    std::shared_ptr<const ColumnStats> getColumnStats(size_t idx) const {
+        assert((idx < numCols) && "column index is out of bounds");
+        return stats[idx];
+    }
+    
+    /**
+     * @brief Returns the statistics of the idx-th column as a `ZoneMap`, or
+     * `nullptr` if the column has none.
+     */
+    template<typename ValueType>
+    std::shared_ptr<const ZoneMap<ValueType>> getZoneMap(size_t idx) const {
+        return std::dynamic_pointer_cast<const ZoneMap<ValueType>>(getColumnStats(idx));
+    }
+    
+    /**
+     * @brief Keeps the given statistics of the idx-th column, which must have
+     * been computed on its current values (or `nullptr` to drop them).
+     */
+    void setColumnStats(size_t idx, std::shared_ptr<const ColumnStats> columnStats) {
+        assert((idx < numCols) && "column index is out of bounds");
+        if(columnStats && columnStats->getValueType() != schema[idx])
+            throw std::runtime_error("the statistics must have the value type of the column");
+        stats[idx] = std::move(columnStats);
+    }
+    
+    /**
+     * @brief Whether the idx-th column is known to be sorted in ascending
+     * order (see `ColumnStats::isSorted()`).
+     */
+    bool isColumnSorted(size_t idx) const {
+        assert((idx < numCols) && "column index is out of bounds");
+        return stats[idx] && stats[idx]->isSorted();
+    }
+    
+    /**
+     * @brief Returns the index on the given key columns (see `KeyIndex`), or
+     * `nullptr` if there is none or the columns were written since.
+     */
+    std::shared_ptr<const KeyIndex> getKeyIndex(const std::vector<size_t> & keyCols) const {
+        if(auto keyIndexes = this->mdo.template getDerived<FrameKeyIndexes>())
+            for(const auto & keyIndex : keyIndexes->indexes)
+                if(keyIndex->getKeyCols() == keyCols)
+                    return keyIndex;
+        return nullptr;
+    }
+    
+    std::vector<std::shared_ptr<const KeyIndex>> getKeyIndexes() const {
+        auto keyIndexes = this->mdo.template getDerived<FrameKeyIndexes>();
+        return keyIndexes ? keyIndexes->indexes : std::vector<std::shared_ptr<const KeyIndex>>();
+    }
+    
+    /**
+     * @brief Keeps the given index, which must have been built on the current
+     * values of its key columns, replacing an index on the same columns.
+     * 
+     * The indexes are dropped when any column is accessed through the
+     * non-`const` accessors or the number of rows changes. Since they are
+     * derived data, they can be added to a `const` frame, e.g., by the first
+     * of several joins with it.
+     */
+    void addKeyIndex(std::shared_ptr<const KeyIndex> keyIndex) const {
+        if(keyIndex->getNumRows() != numRows)
+            throw std::runtime_error("the index must have the number of rows of the frame");
+        for(size_t c : keyIndex->getKeyCols())
+            if(c >= numCols)
+                throw std::runtime_error("the key columns of the index must be columns of the frame");
+        auto keyIndexes = std::make_shared<FrameKeyIndexes>();
+        for(const auto & other : getKeyIndexes())
+            if(other->getKeyCols() != keyIndex->getKeyCols())
+                keyIndexes->indexes.push_back(other);
+        keyIndexes->indexes.push_back(std::move(keyIndex));
+        this->mdo.setDerived(std::move(keyIndexes));
+    }
+    
     template<typename ValueType>
     DenseMatrix<ValueType> * getColumn(size_t idx) {
+        materialize(idx);
+        encodings[idx] = nullptr;
+        stats[idx] = nullptr;
+        this->mdo.invalidateDerived();
+        return const_cast<DenseMatrix<ValueType> *>(std::as_const(*this).getColumn<ValueType>(idx));
+    }
+    
+    template<typename ValueType>
+    const DenseMatrix<ValueType> * getColumn(size_t idx) const {
         assert((ValueTypeUtils::codeFor<ValueType> == schema[idx]) && "requested value type must match the type of the column");
-        return DataObjectFactory::create<DenseMatrix<ValueType>>(
+        materialize(idx);
+        auto column = DataObjectFactory::create<DenseMatrix<ValueType>>(
                 numRows, 1,
                 std::shared_ptr<ValueType[]>(
                         columns[idx],
                         reinterpret_cast<ValueType *>(columns[idx].get())
                 )
         );
-    }
-    
-    template<typename ValueType>
-    const DenseMatrix<ValueType> * getColumn(size_t idx) const {
-        return const_cast<Frame *>(this)->getColumn<ValueType>(idx);
+        // The matrix keeps the statistics and the index of the column until
+        // its values are written.
+        if constexpr(std::is_arithmetic<ValueType>::value) {
+            auto zoneMap = getZoneMap<ValueType>(idx);
+            auto keyIndex = getKeyIndex({idx});
+            if(zoneMap || keyIndex)
+                column->setZoneMaps({zoneMap}, {keyIndex});
+        }
+        return column;
     }
     
     template<typename ValueType>
@@ -361,15 +631,20 @@ public:
     
     template<typename ValueType>
     const DenseMatrix<ValueType> * getColumn(const std::string & label) const {
-        return const_cast<Frame *>(this)->getColumn<ValueType>(label);
+        return getColumn<ValueType>(getColumnIdx(label));
     }
     
     void * getColumnRaw(size_t idx) {
+        materialize(idx);
+        encodings[idx] = nullptr;
+        stats[idx] = nullptr;
+        this->mdo.invalidateDerived();
         return columns[idx].get();
     }
     
     const void * getColumnRaw(size_t idx) const {
-        return const_cast<Frame *>(this)->getColumnRaw(idx);
+        materialize(idx);
+        return columns[idx].get();
     }
     
     void print(std::ostream & os) const override {
@@ -377,12 +652,14 @@ public:
         for(size_t c = 0; c < numCols; c++) {
             // TODO Ideally, special characters in the labels should be
             // escaped.
-            os << labels[c] << ':';
+            os << getLabels()[c] << ':';
             os << ValueTypeUtils::cppNameForCode(schema[c]);
             if(c < numCols - 1)
                 os << ", ";
         }
         os << "])" << std::endl;
+        for (size_t c = 0; c < numCols; c++)
+            materialize(c);
         for (size_t r = 0; r < numRows; r++) {
             for (size_t c = 0; c < numCols; c++) {
                 ValueTypeUtils::printValue(os, schema[c], columns[c].get(), r);
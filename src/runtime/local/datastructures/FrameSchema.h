@@ -0,0 +1,111 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_FRAMESCHEMA_H
+#define SRC_RUNTIME_LOCAL_DATASTRUCTURES_FRAMESCHEMA_H
+
+#include <runtime/local/datastructures/ValueTypeCode.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+
+/**
+ * @brief The value types and the labels of the columns of a `Frame`, and the
+ * mapping from the labels to the positions of the columns.
+ *
+ * A `FrameSchema` is immutable, such that the frames with the same columns
+ * share one (e.g., a frame and its row slices), and creating a slice copies
+ * no labels. A frame whose labels change gets a new one, see
+ * `Frame::setLabels()`.
+ */
+class FrameSchema {
+
+    std::vector<ValueTypeCode> schema;
+
+    std::vector<std::string> labels;
+
+    std::unordered_map<std::string, size_t> labels2idxs;
+
+public:
+
+    /**
+     * @brief Returns the default label to use for the pos-th column, if no
+     * column label was specified.
+     */
+    static std::string getDefaultLabel(size_t pos) {
+        return "col_" + std::to_string(pos);
+    }
+
+    /**
+     * @param numCols The number of columns.
+     * @param schema An array of length `numCols` of the value types of the
+     * columns.
+     * @param labels An array of length `numCols` of the labels of the
+     * columns, or `nullptr` for the default labels.
+     * @param deduplicate Whether duplicate labels are replaced by the default
+     * labels (e.g., for slices that repeat columns) or rejected.
+     */
+    FrameSchema(size_t numCols, const ValueTypeCode * schema, const std::string * labels, bool deduplicate = false) :
+            schema(schema, schema + numCols)
+    {
+        this->labels.reserve(numCols);
+        labels2idxs.reserve(numCols);
+        for(size_t i = 0; i < numCols; i++) {
+            this->labels.push_back(labels ? labels[i] : getDefaultLabel(i));
+            if(labels2idxs.count(this->labels[i])) {
+                if(!deduplicate)
+                    throw std::runtime_error(
+                            "a frame's column labels must be unique, but '" +
+                            this->labels[i] + "' occurs more than once"
+                    );
+                this->labels[i] = getDefaultLabel(i);
+            }
+            labels2idxs[this->labels[i]] = i;
+        }
+    }
+
+    static std::shared_ptr<const FrameSchema> create(
+            size_t numCols, const ValueTypeCode * schema, const std::string * labels, bool deduplicate = false
+    ) {
+        return std::make_shared<const FrameSchema>(numCols, schema, labels, deduplicate);
+    }
+
+    size_t getNumCols() const {
+        return schema.size();
+    }
+
+    const ValueTypeCode * getSchema() const {
+        return schema.data();
+    }
+
+    const std::string * getLabels() const {
+        return labels.data();
+    }
+
+    size_t getColumnIdx(const std::string & label) const {
+        auto it = labels2idxs.find(label);
+        if(it != labels2idxs.end())
+            return it->second;
+        throw std::runtime_error("column label not found: '" + label + "'");
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_DATASTRUCTURES_FRAMESCHEMA_H
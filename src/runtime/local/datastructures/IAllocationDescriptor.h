@@ -18,11 +18,14 @@
 
 #include <memory>
 
+class ResidencyManager;
+
 // An alphabetically sorted wishlist of supported allocation types ;-)
 // Supporting all of that is probably unmaintainable :-/
 enum class ALLOCATION_TYPE {
+    DISK, // spilled out of main memory
     DIST_GRPC,
-    DIST_OPENMPI,
+    DIST_MPI,
     DIST_SPARK,
     GPU_CUDA,
     GPU_HIP,
@@ -55,4 +58,6 @@ public:
     virtual void transferFrom(std::byte* dst, size_t size) = 0;
     [[nodiscard]] virtual std::unique_ptr<IAllocationDescriptor> clone() const = 0;
     virtual bool operator==(const IAllocationDescriptor* other) const { return (getType() == other->getType()); }
+    // the manager of the placements resident in the memory this descriptor allocates, if it evicts them when full
+    [[nodiscard]] virtual ResidencyManager* getResidencyManager() const { return nullptr; }
 };
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/MetaDataObject.h>
+#include <util/FlatHashMap.h>
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A hash index on one or more key columns of a `Frame`, which maps
+ * each distinct key to the rows holding it, in ascending order.
+ *
+ * The index only holds the positions of rows, the keys are compared by the
+ * caller on the values of the indexed frame (see `find()`), such that the
+ * index does not depend on the value types. The keys are numbered in the
+ * order of their first occurrence. The index is immutable, such that it can
+ * be kept with a frame (see `Frame::addKeyIndex()`) for the joins and filters
+ * of later kernels, and is dropped when the frame is written.
+ */
+class KeyIndex {
+    std::vector<size_t> keyCols;
+    size_t numRows;
+    FlatHashIndex table;
+    // the rows of the k-th key are rows[begins[k]] to rows[begins[k + 1] - 1]
+    std::vector<size_t> begins;
+    std::vector<size_t> rows;
+
+    // groups the rows by the key they were assigned
+    void groupRows(const std::vector<size_t> & keyOf) {
+        const size_t numKeys = table.size();
+        begins.assign(numKeys + 1, 0);
+        for(size_t r = 0; r < numRows; r++)
+            begins[keyOf[r] + 1]++;
+        for(size_t k = 0; k < numKeys; k++)
+            begins[k + 1] += begins[k];
+        std::vector<size_t> next(begins.begin(), begins.end() - 1);
+        rows.resize(numRows);
+        for(size_t r = 0; r < numRows; r++)
+            rows[next[keyOf[r]]++] = r;
+    }
+
+public:
+    static constexpr size_t npos = FlatHashIndex::npos;
+
+    /**
+     * @brief Creates the index of the keys of the given rows.
+     *
+     * @param keyCols The positions of the key columns in the frame.
+     * @param hashes The hash of the key of each row.
+     * @param numRows The number of rows.
+     * @param rowsEqual Whether the rows `a` and `b` have the same key, called
+     * as `rowsEqual(a, b)`.
+     */
+    template<class RowsEqual>
+    KeyIndex(std::vector<size_t> keyCols, const uint64_t * hashes, size_t numRows, RowsEqual rowsEqual)
+            : keyCols(std::move(keyCols)), numRows(numRows), table(numRows) {
+        std::vector<size_t> keyOf(numRows);
+        std::vector<size_t> firstRows;
+        for(size_t r = 0; r < numRows; r++) {
+            const auto [k, inserted] = table.findOrInsert(hashes[r], [&](size_t k) {
+                return rowsEqual(firstRows[k], r);
+            });
+            if(inserted)
+                firstRows.push_back(r);
+            keyOf[r] = k;
+        }
+        groupRows(keyOf);
+    }
+
+    /**
+     * @brief Recreates an index from its rows grouped by key (e.g., read from
+     * a file, see `getBegins()` and `getRows()`), hashing only the first row
+     * of each key.
+     *
+     * @param hashOfRow The hash of the key of a row, called as `hashOfRow(r)`.
+     * @param rowsEqual Whether two rows have the same key, which is never
+     * true for the first rows of two groups.
+     */
+    template<class HashOfRow, class RowsEqual>
+    KeyIndex(std::vector<size_t> keyCols, std::vector<size_t> begins, std::vector<size_t> rows,
+            HashOfRow hashOfRow, RowsEqual rowsEqual)
+            : keyCols(std::move(keyCols)), numRows(rows.size()), begins(std::move(begins)), rows(std::move(rows)) {
+        if(this->begins.empty() || this->begins.front() != 0 || this->begins.back() != numRows)
+            throw std::runtime_error("KeyIndex: the groups of rows must cover all rows");
+        const size_t numKeys = this->begins.size() - 1;
+        std::vector<bool> seen(numRows, false);
+        for(size_t k = 0; k < numKeys; k++) {
+            if(this->begins[k] >= this->begins[k + 1])
+                throw std::runtime_error("KeyIndex: a key must have at least one row");
+            for(size_t i = this->begins[k]; i < this->begins[k + 1]; i++) {
+                const size_t r = this->rows[i];
+                if(r >= numRows || seen[r] || (i > this->begins[k] && r <= this->rows[i - 1]))
+                    throw std::runtime_error("KeyIndex: the rows of a key must be distinct and ascending");
+                seen[r] = true;
+            }
+        }
+        table = FlatHashIndex(numKeys);
+        for(size_t k = 0; k < numKeys; k++) {
+            const size_t first = this->rows[this->begins[k]];
+            if(!table.findOrInsert(hashOfRow(first), [&](size_t j) {
+                return rowsEqual(this->rows[this->begins[j]], first);
+            }).second)
+                throw std::runtime_error("KeyIndex: two groups of rows have the same key");
+        }
+    }
+
+    /**
+     * @brief Returns the key with the hash `h` for which `isKey(r)` is true,
+     * where `r` is the first row of the key, or `npos`.
+     */
+    template<class IsKey>
+    size_t find(uint64_t h, IsKey isKey) const {
+        return table.find(h, [&](size_t k) { return isKey(rows[begins[k]]); });
+    }
+
+    const std::vector<size_t> & getKeyCols() const {
+        return keyCols;
+    }
+
+    /**
+     * @brief The rows the index was built on, which must be the rows of the
+     * indexed frame.
+     */
+    size_t getNumRows() const {
+        return numRows;
+    }
+
+    size_t getNumKeys() const {
+        return begins.size() - 1;
+    }
+
+    size_t getFirstRow(size_t k) const {
+        return rows[begins[k]];
+    }
+
+    /**
+     * @brief The rows holding the k-th key, in ascending order, are the ones
+     * from `getRowsBegin(k)` to `getRowsEnd(k)`.
+     */
+    const size_t * getRowsBegin(size_t k) const {
+        return rows.data() + begins[k];
+    }
+
+    const size_t * getRowsEnd(size_t k) const {
+        return rows.data() + begins[k + 1];
+    }
+
+    const std::vector<size_t> & getBegins() const {
+        return begins;
+    }
+
+    const std::vector<size_t> & getRows() const {
+        return rows;
+    }
+};
+
+/**
+ * @brief The indexes on the key columns of a `Frame`, which the frame keeps
+ * as its derived data (see `MetaDataObject::getDerived()`), such that they
+ * are dropped when its columns are written.
+ */
+struct FrameKeyIndexes : public DerivedData {
+    std::vector<std::shared_ptr<const KeyIndex>> indexes;
+};
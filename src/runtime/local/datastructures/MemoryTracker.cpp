@@ -0,0 +1,190 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/MemoryTracker.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+static thread_local size_t threadAllocatedBytes = 0;
+
+static const char * getTypeName(ALLOCATION_TYPE type) {
+    switch(type) {
+        case ALLOCATION_TYPE::HOST: return "host";
+        case ALLOCATION_TYPE::HOST_PINNED_CUDA: return "host (pinned)";
+        case ALLOCATION_TYPE::GPU_CUDA: return "CUDA";
+        case ALLOCATION_TYPE::GPU_HIP: return "HIP";
+        case ALLOCATION_TYPE::DISK: return "spilled to disk";
+        case ALLOCATION_TYPE::DIST_GRPC: return "gRPC workers";
+        case ALLOCATION_TYPE::DIST_MPI: return "MPI workers";
+        case ALLOCATION_TYPE::DIST_SPARK: return "Spark";
+        default: return "other";
+    }
+}
+
+static double toMiB(int64_t bytes) {
+    return std::max<int64_t>(bytes, 0) / double(1 << 20);
+}
+
+MemoryTracker & MemoryTracker::get() {
+    static MemoryTracker * tracker = new MemoryTracker();
+    return *tracker;
+}
+
+void MemoryTracker::enable(size_t hostLimitBytes) {
+    this->hostLimitBytes = hostLimitBytes;
+    enabled = true;
+}
+
+void MemoryTracker::disable() {
+    enabled = false;
+    hostLimitBytes = 0;
+    statement = nullptr;
+    for(auto & c : counters) {
+        c.liveBytes = 0;
+        c.peakBytes = 0;
+        c.numAllocations = 0;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    objects.clear();
+    statements.clear();
+}
+
+void MemoryTracker::enforceHostLimit(int64_t liveBytes, size_t numBytes) {
+    const int64_t limit = static_cast<int64_t>(hostLimitBytes.load(std::memory_order_relaxed));
+    // the arrays cached by the BufferPool count towards the footprint, but can be dropped
+    BufferPool & pool = BufferPool::get();
+    if(liveBytes + static_cast<int64_t>(pool.getStats().cachedBytes) <= limit)
+        return;
+    pool.clear();
+    if(liveBytes <= limit)
+        return;
+    counters[static_cast<size_t>(ALLOCATION_TYPE::HOST)].liveBytes.fetch_sub(numBytes, std::memory_order_relaxed);
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << "the memory limit of " << toMiB(limit) << " MiB is exceeded by an "
+            << "allocation of " << toMiB(numBytes) << " MiB in main memory, " << toMiB(liveBytes - numBytes)
+            << " MiB are live\n";
+    printReport(ss, 10);
+    throw std::runtime_error(ss.str());
+}
+
+void MemoryTracker::allocate(ALLOCATION_TYPE type, size_t numBytes) {
+    Counter & c = counters[static_cast<size_t>(type)];
+    const int64_t live = c.liveBytes.fetch_add(numBytes, std::memory_order_relaxed) + numBytes;
+    if(type == ALLOCATION_TYPE::HOST && hostLimitBytes.load(std::memory_order_relaxed))
+        enforceHostLimit(live, numBytes);
+    // spill files are written while other data objects are created, but do not belong to them
+    if(type != ALLOCATION_TYPE::DISK)
+        threadAllocatedBytes += numBytes;
+    c.numAllocations.fetch_add(1, std::memory_order_relaxed);
+    int64_t peak = c.peakBytes.load(std::memory_order_relaxed);
+    while(live > peak && !c.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+}
+
+void MemoryTracker::release(ALLOCATION_TYPE type, size_t numBytes) {
+    counters[static_cast<size_t>(type)].liveBytes.fetch_sub(numBytes, std::memory_order_relaxed);
+}
+
+std::shared_ptr<void> MemoryTracker::track(ALLOCATION_TYPE type, size_t numBytes) {
+    if(!isEnabled())
+        return nullptr;
+    allocate(type, numBytes);
+    // the handle points to the tracker, such that it is not null
+    return std::shared_ptr<void>(this, [type, numBytes](void *) {
+        MemoryTracker::get().release(type, numBytes);
+    });
+}
+
+size_t MemoryTracker::getThreadAllocatedBytes() {
+    return threadAllocatedBytes;
+}
+
+void MemoryTracker::addObject(const void * obj, size_t numBytes) {
+    // views and other objects without allocations of their own are not attributed
+    if(!numBytes)
+        return;
+    const char * location = statement.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mtx);
+    StatementStats & s = statements[location ? location : "(outside of statements)"];
+    s.numObjects++;
+    s.numLiveObjects++;
+    s.liveBytes += numBytes;
+    s.peakBytes = std::max(s.peakBytes, s.liveBytes);
+    objects[obj] = {static_cast<int64_t>(numBytes), &s};
+}
+
+void MemoryTracker::removeObject(const void * obj) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = objects.find(obj);
+    if(it == objects.end())
+        return;
+    it->second.statement->numLiveObjects--;
+    it->second.statement->liveBytes -= it->second.bytes;
+    objects.erase(it);
+}
+
+MemoryTracker::TypeStats MemoryTracker::getTypeStats(ALLOCATION_TYPE type) const {
+    const Counter & c = counters[static_cast<size_t>(type)];
+    return {c.liveBytes.load(), c.peakBytes.load(), c.numAllocations.load()};
+}
+
+std::map<std::string, MemoryTracker::StatementStats> MemoryTracker::getStatementStats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return statements;
+}
+
+void MemoryTracker::printReport(std::ostream & os, size_t maxStatements) const {
+    if(!isEnabled()) {
+        os << "Memory: not tracked (see --track-memory)" << std::endl;
+        return;
+    }
+    const std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1) << "Memory:";
+    bool first = true;
+    for(size_t i = 0; i < NUM_TYPES; i++) {
+        const TypeStats t = getTypeStats(static_cast<ALLOCATION_TYPE>(i));
+        if(!t.numAllocations)
+            continue;
+        os << (first ? " " : ", ") << getTypeName(static_cast<ALLOCATION_TYPE>(i)) << " " << toMiB(t.liveBytes)
+                << " MiB live (peak " << toMiB(t.peakBytes) << " MiB)";
+        first = false;
+    }
+    if(first)
+        os << " nothing allocated";
+    os << std::endl;
+
+    // the statements holding the most memory now first, then the ones which held the most
+    auto stats = getStatementStats();
+    std::vector<std::pair<std::string, StatementStats>> sorted(stats.begin(), stats.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto & a, const auto & b) {
+        return a.second.liveBytes != b.second.liveBytes ? a.second.liveBytes > b.second.liveBytes
+                : a.second.peakBytes > b.second.peakBytes;
+    });
+    if(sorted.size() > maxStatements)
+        sorted.resize(maxStatements);
+    if(!sorted.empty())
+        os << std::setw(12) << "live [MiB]" << std::setw(12) << "peak [MiB]" << std::setw(8) << "live"
+                << std::setw(10) << "objects" << "  statement" << std::endl;
+    for(auto & s : sorted)
+        os << std::setw(12) << toMiB(s.second.liveBytes) << std::setw(12) << toMiB(s.second.peakBytes)
+                << std::setw(8) << s.second.numLiveObjects << std::setw(10) << s.second.numObjects
+                << "  " << s.first << std::endl;
+    os.flags(flags);
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/IAllocationDescriptor.h>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Accounts for the memory of the data objects, which helps to find out which intermediates are alive when a
+ * program runs out of memory.
+ *
+ * When enabled (see `--track-memory`), the tracker counts the live bytes and their high-water mark per allocation
+ * type: the arrays of the BufferPool in main memory (`HOST`), the device memory of the CUDAContext (`GPU_CUDA`), and
+ * the partitions placed at distributed workers (`DIST_GRPC`, `DIST_MPI`). Moreover, each data object created by
+ * `DataObjectFactory::create()` is attributed to the DaphneDSL statement that was executing at that time (see
+ * `setStatement()`, which the TrackMemoryPass calls before the kernels), along with the bytes its creation allocated.
+ *
+ * Optionally, the live bytes in main memory are limited softly: if an allocation exceeds the limit, the arrays cached
+ * by the BufferPool are freed first, and if that is not enough, the allocation fails with an error listing the
+ * statements holding the most memory.
+ */
+class MemoryTracker {
+public:
+    static constexpr size_t NUM_TYPES = static_cast<size_t>(ALLOCATION_TYPE::NUM_ALLOC_TYPES);
+
+    struct TypeStats {
+        int64_t liveBytes = 0;
+        int64_t peakBytes = 0;
+        size_t numAllocations = 0;
+    };
+
+    // the data objects created by a statement
+    struct StatementStats {
+        size_t numObjects = 0;
+        size_t numLiveObjects = 0;
+        int64_t liveBytes = 0;
+        // the high-water mark of the live bytes of this statement, not necessarily at the same time as the others
+        int64_t peakBytes = 0;
+    };
+
+private:
+    struct Counter {
+        std::atomic<int64_t> liveBytes{0};
+        std::atomic<int64_t> peakBytes{0};
+        std::atomic<size_t> numAllocations{0};
+    };
+
+    struct LiveObject {
+        int64_t bytes;
+        StatementStats * statement;
+    };
+
+    inline static std::atomic<bool> enabled{false};
+
+    std::array<Counter, NUM_TYPES> counters;
+    std::atomic<size_t> hostLimitBytes{0};
+    // the source location of the statement executing now, a constant of the compiled program
+    std::atomic<const char *> statement{nullptr};
+
+    mutable std::mutex mtx;
+    std::map<std::string, StatementStats> statements;
+    std::unordered_map<const void *, LiveObject> objects;
+
+    MemoryTracker() = default;
+
+    void enforceHostLimit(int64_t liveBytes, size_t numBytes);
+
+public:
+    MemoryTracker(const MemoryTracker &) = delete;
+    MemoryTracker & operator=(const MemoryTracker &) = delete;
+
+    /**
+     * @brief Returns the process-wide tracker, which lives until the process ends.
+     */
+    static MemoryTracker & get();
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Starts tracking, with a soft limit of the live bytes in main memory (zero for none).
+     *
+     * Should be called before any data object is created, since memory allocated before is not accounted for.
+     */
+    void enable(size_t hostLimitBytes = 0);
+
+    /**
+     * @brief Stops tracking and forgets everything tracked so far.
+     */
+    void disable();
+
+    /**
+     * @brief Accounts for an allocation of the given type, which is attributed to the data object created by the
+     * calling thread, if any.
+     *
+     * @throws std::runtime_error if the live bytes in main memory would exceed the limit
+     */
+    void allocate(ALLOCATION_TYPE type, size_t numBytes);
+
+    void release(ALLOCATION_TYPE type, size_t numBytes);
+
+    /**
+     * @brief Accounts for an allocation of the given type until the returned handle (and all copies of it) are
+     * dropped, e.g., by the allocation descriptors sharing a placement. Returns nullptr if tracking is disabled.
+     */
+    std::shared_ptr<void> track(ALLOCATION_TYPE type, size_t numBytes);
+
+    /**
+     * @brief Returns the number of bytes allocated by the calling thread so far while tracking.
+     */
+    static size_t getThreadAllocatedBytes();
+
+    /**
+     * @brief Sets the source location of the statement that creates the data objects from now on, which must live
+     * until the next call.
+     */
+    void setStatement(const char * location) {
+        statement.store(location, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Records a new data object, whose creation allocated the given number of bytes.
+     */
+    void addObject(const void * obj, size_t numBytes);
+
+    /**
+     * @brief Forgets a destroyed data object.
+     */
+    void removeObject(const void * obj);
+
+    TypeStats getTypeStats(ALLOCATION_TYPE type) const;
+
+    std::map<std::string, StatementStats> getStatementStats() const;
+
+    /**
+     * @brief Prints the live and peak bytes per allocation type and the statements whose data objects hold the most
+     * memory.
+     */
+    void printReport(std::ostream & os, size_t maxStatements = 20) const;
+};
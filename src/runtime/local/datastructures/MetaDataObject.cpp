@@ -48,6 +48,19 @@ void MetaDataObject::updateRangeDataPlacementByID(size_t id, Range *r) {
     }
 }
 
+void MetaDataObject::removeDataPlacement(size_t id) {
+    for(auto &_omdType : data_placements) {
+        for(auto it = _omdType.begin(); it != _omdType.end(); ++it) {
+            if((*it)->dp_id == id) {
+                _omdType.erase(it);
+                latest_version.erase(std::remove(latest_version.begin(), latest_version.end(), id),
+                        latest_version.end());
+                return;
+            }
+        }
+    }
+}
+
 DataPlacement *MetaDataObject::getDataPlacementByID(size_t id) const {
     for (const auto &_omdType: data_placements) {
         for (auto &_omd: _omdType) {
@@ -75,6 +88,13 @@ const DataPlacement* MetaDataObject::findDataPlacementByType(const IAllocationDe
     }
 }
 
+bool MetaDataObject::hasPlacementsOtherThan(ALLOCATION_TYPE type) const {
+    for(size_t i = 0; i < data_placements.size(); i++)
+        if(i != static_cast<size_t>(type) && !data_placements[i].empty())
+            return true;
+    return false;
+}
+
 bool MetaDataObject::isLatestVersion(size_t placement) const {
     return (std::find(latest_version.begin(), latest_version.end(), placement) != latest_version.end());
 }
@@ -20,9 +20,18 @@
 #include "Range.h"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <array>
 
+/**
+ * @brief A value computed from the data of a structure (e.g., the factorization of a matrix by `solve`), which is
+ * kept with the structure for later kernels on the same data and dropped once the data is written.
+ */
+struct DerivedData {
+    virtual ~DerivedData() = default;
+};
+
 /**
  * @brief The MetaDataObject class contains meta data of a data structure (Frame, Matrix)
  *
@@ -35,6 +44,10 @@ class MetaDataObject {
             static_cast<size_t>(ALLOCATION_TYPE::NUM_ALLOC_TYPES)> data_placements;
     std::vector<size_t> latest_version;
 
+    // accessed atomically, since kernels on different threads may read the same structure
+    std::shared_ptr<const DerivedData> derived;
+    std::atomic<bool> hasDerived{false};
+
 public:
     DataPlacement *addDataPlacement(const IAllocationDescriptor *allocInfo, Range *r = nullptr);
     const DataPlacement *findDataPlacementByType(const IAllocationDescriptor *alloc_desc, const Range *range) const;
@@ -43,10 +56,39 @@ public:
     [[nodiscard]] auto getDataPlacementByType(ALLOCATION_TYPE type) const ->
             const std::vector<std::unique_ptr<DataPlacement>>*;
     void updateRangeDataPlacementByID(size_t id, Range *r);
+    // removes the placement (e.g., an evicted device copy), which must not be the only latest version
+    void removeDataPlacement(size_t id);
+    [[nodiscard]] bool hasPlacementsOtherThan(ALLOCATION_TYPE type) const;
 
     [[nodiscard]] bool isLatestVersion(size_t placement) const;
     void addLatest(size_t id);
     void setLatest(size_t id);
     [[nodiscard]] auto getLatest() const -> std::vector<size_t>;
 
+    /**
+     * @brief Returns the data derived from the data of the structure, if it is of the given type, or `nullptr`.
+     */
+    template<class T>
+    [[nodiscard]] std::shared_ptr<const T> getDerived() const {
+        if(!hasDerived.load(std::memory_order_acquire))
+            return nullptr;
+        return std::dynamic_pointer_cast<const T>(std::atomic_load(&derived));
+    }
+
+    /**
+     * @brief Keeps the given data derived from the data of the structure, replacing the one kept before.
+     */
+    void setDerived(std::shared_ptr<const DerivedData> d) {
+        std::atomic_store(&derived, std::move(d));
+        hasDerived.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Drops the derived data, since the data of the structure is written.
+     */
+    void invalidateDerived() {
+        if(hasDerived.exchange(false, std::memory_order_acq_rel))
+            std::atomic_store(&derived, std::shared_ptr<const DerivedData>());
+    }
+
 };
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/ReuseCache.h>
+
+#include <algorithm>
+#include <iomanip>
+
+ReuseCache & ReuseCache::get() {
+    // never destroyed, since the cached objects may outlive the kernel libraries at exit
+    static ReuseCache * cache = new ReuseCache();
+    return *cache;
+}
+
+std::vector<const Structure *> ReuseCache::evict(size_t numBytes) {
+    const size_t budget = budgetBytes.load(std::memory_order_relaxed);
+    std::vector<const Structure *> evicted;
+    while(!entries.empty() && cachedBytes + numBytes > budget) {
+        auto victim = std::min_element(entries.begin(), entries.end(), [](const auto & a, const auto & b) {
+            return a.second.priority < b.second.priority;
+        });
+        inflation = victim->second.priority;
+        cachedBytes -= victim->second.numBytes;
+        evicted.push_back(victim->second.obj);
+        entries.erase(victim);
+        stats.evictions++;
+    }
+    return evicted;
+}
+
+void ReuseCache::setBudget(size_t numBytes) {
+    std::vector<const Structure *> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        budgetBytes.store(numBytes, std::memory_order_relaxed);
+        evicted = evict(0);
+    }
+    for(const Structure * obj : evicted)
+        DataObjectFactory::destroy(obj);
+}
+
+const Structure * ReuseCache::lookup(const std::string & key) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = entries.find(key);
+    if(it == entries.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+    Entry & e = it->second;
+    e.priority = inflation + e.cost / std::max<size_t>(e.numBytes, 1);
+    stats.hits++;
+    stats.savedSeconds += e.cost;
+    e.obj->increaseRefCounter();
+    return e.obj;
+}
+
+void ReuseCache::insert(const std::string & key, const Structure * obj, size_t numBytes, double cost) {
+    std::vector<const Structure *> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        // another thread may have computed the same result meanwhile
+        const size_t budget = budgetBytes.load(std::memory_order_relaxed);
+        if(budget == 0 || numBytes > budget || entries.count(key))
+            return;
+        evicted = evict(numBytes);
+        obj->increaseRefCounter();
+        entries.emplace(key, Entry{obj, numBytes, cost, inflation + cost / std::max<size_t>(numBytes, 1)});
+        cachedBytes += numBytes;
+    }
+    for(const Structure * e : evicted)
+        DataObjectFactory::destroy(e);
+}
+
+void ReuseCache::clear() {
+    std::vector<const Structure *> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for(auto & entry : entries)
+            evicted.push_back(entry.second.obj);
+        entries.clear();
+        cachedBytes = 0;
+        inflation = 0;
+        stats = Statistics();
+    }
+    for(const Structure * obj : evicted)
+        DataObjectFactory::destroy(obj);
+}
+
+ReuseCache::Statistics ReuseCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    Statistics s = stats;
+    s.numEntries = entries.size();
+    s.cachedBytes = cachedBytes;
+    return s;
+}
+
+void ReuseCache::Statistics::print(std::ostream & os) const {
+    const std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1) << "ReuseCache: " << hits << " hits (" << savedSeconds
+            << " s saved), " << misses << " misses, " << evictions << " evictions, " << numEntries << " results of "
+            << cachedBytes / double(1 << 20) << " MiB cached" << std::endl;
+    os.flags(flags);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Structure.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief The results of expensive deterministic kernels (e.g., `matMul`, `syrk`, `solve`, `innerJoin`), kept in
+ * memory and reused by later calls of the same kernel on the same inputs, e.g., the same `t(X) @ X` in every
+ * iteration of a loop or for every parameter of a sweep.
+ *
+ * A call is identified by its lineage: the kernel, the lineage IDs of its data arguments (see
+ * `Structure::getLineageId()`), and the values of its scalar arguments. A cached result gets the lineage ID derived
+ * from its call, such that calls on it are recognized again; kernels like `transpose` only derive the lineage of
+ * their results without caching them (see `"reuse"` in kernels.json).
+ *
+ * When enabled (see `--reuse-cache-mb`), the cached results are limited by a budget of bytes and evicted by
+ * GreedyDual-Size, i.e., the results with the lowest time to recompute them per byte go first, aged by the priority
+ * of the last eviction. A reused result is shared by reference counting; the cache holds a reference of its own,
+ * such that no kernel updates it in place. The values of cached dense matrices remain subject to spilling (see
+ * `SpillManager`), i.e., the cold ones are moved to disk rather than being recomputed.
+ */
+class ReuseCache {
+public:
+    struct Statistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        // the number and bytes of the cached results
+        size_t numEntries = 0;
+        size_t cachedBytes = 0;
+        // the run time of the kernels saved by the hits
+        double savedSeconds = 0;
+
+        void print(std::ostream & os) const;
+    };
+
+private:
+    inline static std::atomic<size_t> budgetBytes{0};
+
+    struct Entry {
+        const Structure * obj;
+        size_t numBytes;
+        // the seconds it took to compute the result
+        double cost;
+        // the GreedyDual-Size priority, the lowest is evicted first
+        double priority;
+    };
+
+    mutable std::mutex mtx;
+    std::unordered_map<std::string, Entry> entries;
+    size_t cachedBytes = 0;
+    // the priority of the last eviction, which ages the entries not hit since
+    double inflation = 0;
+    Statistics stats;
+
+    ReuseCache() = default;
+
+    // evicts entries until the given bytes fit into the budget, returns the results to destroy
+    std::vector<const Structure *> evict(size_t numBytes);
+
+    template<typename VT>
+    static size_t getNumBytes(const DenseMatrix<VT> * mat) {
+        return mat->getNumRows() * mat->getNumCols() * sizeof(VT);
+    }
+
+    template<typename VT>
+    static size_t getNumBytes(const CSRMatrix<VT> * mat) {
+        return mat->getNumNonZeros() * (sizeof(VT) + sizeof(size_t)) + (mat->getNumRows() + 1) * sizeof(size_t);
+    }
+
+    // an estimate for other data types, e.g., frames
+    static size_t getNumBytes(const Structure * obj) {
+        return obj->getNumRows() * obj->getNumCols() * sizeof(double);
+    }
+
+    static void appendToKey(std::string & key, const void * data, size_t size) {
+        key.append(static_cast<const char *>(data), size);
+    }
+
+    template<typename T>
+    static void appendToKey(std::string & key, const T & arg) {
+        if constexpr(std::is_pointer<T>::value
+                && std::is_base_of<Structure, std::remove_cv_t<std::remove_pointer_t<T>>>::value) {
+            const uint64_t id = arg ? arg->getLineageId() : 0;
+            appendToKey(key, &id, sizeof(id));
+        }
+        else if constexpr(std::is_same<std::decay_t<T>, const char *>::value
+                || std::is_same<std::decay_t<T>, char *>::value) {
+            const size_t size = std::strlen(arg);
+            appendToKey(key, &size, sizeof(size));
+            appendToKey(key, arg, size);
+        }
+        else {
+            static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                    "ReuseCache: unsupported kernel argument");
+            appendToKey(key, &arg, sizeof(arg));
+        }
+    }
+
+    template<typename... Args>
+    static std::string makeKey(const char * kernel, const Args &... args) {
+        std::string key(kernel);
+        key.push_back('\0');
+        (appendToKey(key, args), ...);
+        return key;
+    }
+
+    static uint64_t deriveLineageId(const std::string & key) {
+        const uint64_t id = std::hash<std::string>{}(key);
+        return id ? id : 1;
+    }
+
+public:
+    ReuseCache(const ReuseCache &) = delete;
+    ReuseCache & operator=(const ReuseCache &) = delete;
+
+    /**
+     * @brief Returns the process-wide reuse cache, which lives until the process ends.
+     */
+    static ReuseCache & get();
+
+    static bool isEnabled() {
+        return budgetBytes.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * @brief Sets the bytes of the cached results, evicting the ones beyond; 0 disables the cache and drops all
+     * results.
+     */
+    void setBudget(size_t numBytes);
+
+    /**
+     * @brief Returns the result cached for the given key, with a new reference for the caller, or `nullptr` if there
+     * is none.
+     */
+    const Structure * lookup(const std::string & key);
+
+    /**
+     * @brief Keeps a reference to the given result of the given key, if it fits into the budget.
+     *
+     * @param cost The seconds it took to compute the result.
+     */
+    void insert(const std::string & key, const Structure * obj, size_t numBytes, double cost);
+
+    /**
+     * @brief Drops all cached results and resets the statistics.
+     */
+    void clear();
+
+    Statistics getStatistics() const;
+
+    /**
+     * @brief Calls the given kernel, unless the cache has its result for the given arguments.
+     *
+     * @param kernel The name of the kernel instantiation.
+     * @param res The result of the kernel, which is only looked up if it has not been allocated yet.
+     * @param func Calls the kernel, which sets `res`.
+     * @param args The data and scalar arguments of the kernel, which determine its result.
+     */
+    template<class DTRes, class Func, typename... Args>
+    static void call(const char * kernel, DTRes *& res, Func && func, const Args &... args) {
+        if(!isEnabled() || res != nullptr) {
+            func();
+            return;
+        }
+        ReuseCache & cache = get();
+        const std::string key = makeKey(kernel, args...);
+        if(const Structure * cached = cache.lookup(key)) {
+            res = const_cast<DTRes *>(static_cast<const DTRes *>(cached));
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+        res->setLineageId(deriveLineageId(key));
+        cache.insert(key, res, getNumBytes(res), cost.count());
+    }
+
+    /**
+     * @brief Calls the given kernel and gives its result the lineage derived from the arguments, without caching it,
+     * for cheap kernels (e.g., `transpose`) whose results are the arguments of cached ones.
+     */
+    template<class DTRes, class Func, typename... Args>
+    static void callDerivingLineage(const char * kernel, DTRes *& res, Func && func, const Args &... args) {
+        const bool allocated = res != nullptr;
+        func();
+        if(isEnabled() && !allocated)
+            res->setLineageId(deriveLineageId(makeKey(kernel, args...)));
+    }
+};
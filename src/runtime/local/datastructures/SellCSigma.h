@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A sparse matrix in the SELL-C-sigma format (sliced ELLPACK), built
+ * from the arrays of a `CSRMatrix` (see `CSRMatrix::getSell()`) for sparse
+ * matrix-vector products that process `C` rows at once in SIMD lanes.
+ *
+ * The rows are sorted by their number of non-zeros (descending) within windows
+ * of `SIGMA` rows, and each `C` consecutive sorted rows form a slice. A slice
+ * is padded to its longest row and stored column-major, i.e., the j-th
+ * non-zeros of the rows of a slice are adjacent. Padding has the value and
+ * column index zero, and lies beyond the length of its lane in `rowLengths`.
+ */
+template<typename ValueType>
+struct SellCSigma {
+    static constexpr size_t C = 8;
+    static constexpr size_t SIGMA = 256;
+
+    size_t numRows = 0;
+    size_t numSlices = 0;
+    // the position of each slice in `values` and `colIdxs`, followed by their size
+    std::vector<size_t> sliceOffsets;
+    std::vector<ValueType> values;
+    std::vector<uint32_t> colIdxs;
+    // the row and its number of non-zeros of each lane of each slice (`numRows`
+    // and zero for the lanes beyond the last row)
+    std::vector<size_t> rows;
+    std::vector<uint32_t> rowLengths;
+    // the number of padding values of the rows (excluding the lanes beyond the last row)
+    size_t numPadding = 0;
+
+    /**
+     * @brief Builds the SELL-C-sigma representation of the CSR arrays of a
+     * matrix with the given number of rows, whose column indexes must fit into
+     * 31 bits.
+     */
+    static SellCSigma fromCSR(size_t numRows, const ValueType * values, const size_t * colIdxs,
+            const size_t * rowOffsets) {
+        SellCSigma res;
+        res.numRows = numRows;
+        res.numSlices = (numRows + C - 1) / C;
+
+        std::vector<size_t> order(numRows);
+        std::iota(order.begin(), order.end(), 0);
+        auto length = [&](size_t r) { return rowOffsets[r + 1] - rowOffsets[r]; };
+        for(size_t w = 0; w < numRows; w += SIGMA)
+            std::stable_sort(order.begin() + w, order.begin() + std::min(numRows, w + SIGMA),
+                    [&](size_t a, size_t b) { return length(a) > length(b); });
+
+        res.rows.assign(res.numSlices * C, numRows);
+        res.rowLengths.assign(res.numSlices * C, 0);
+        res.sliceOffsets.resize(res.numSlices + 1);
+        res.sliceOffsets[0] = 0;
+        for(size_t s = 0; s < res.numSlices; s++) {
+            size_t width = 0;
+            for(size_t l = 0; l < C && s * C + l < numRows; l++) {
+                const size_t r = order[s * C + l];
+                res.rows[s * C + l] = r;
+                res.rowLengths[s * C + l] = static_cast<uint32_t>(length(r));
+                width = std::max(width, length(r));
+            }
+            res.sliceOffsets[s + 1] = res.sliceOffsets[s] + width * C;
+            for(size_t l = 0; l < C && s * C + l < numRows; l++)
+                res.numPadding += width - res.rowLengths[s * C + l];
+        }
+
+        res.values.assign(res.sliceOffsets[res.numSlices], ValueType(0));
+        res.colIdxs.assign(res.sliceOffsets[res.numSlices], 0);
+        for(size_t s = 0; s < res.numSlices; s++)
+            for(size_t l = 0; l < C && s * C + l < numRows; l++) {
+                const size_t r = res.rows[s * C + l];
+                for(size_t k = rowOffsets[r]; k < rowOffsets[r + 1]; k++) {
+                    const size_t pos = res.sliceOffsets[s] + (k - rowOffsets[r]) * C + l;
+                    res.values[pos] = values[k];
+                    res.colIdxs[pos] = static_cast<uint32_t>(colIdxs[k]);
+                }
+            }
+        return res;
+    }
+};
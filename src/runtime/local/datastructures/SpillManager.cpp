@@ -0,0 +1,103 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/context/ResidencyManager.h>
+#include <runtime/local/datastructures/SpillManager.h>
+
+#include <iomanip>
+#include <stdexcept>
+
+#include <cstdlib>
+
+#include <unistd.h>
+
+SpillManager::SpillManager() = default;
+
+SpillManager::~SpillManager() = default;
+
+SpillManager & SpillManager::get() {
+    static SpillManager * manager = new SpillManager();
+    return *manager;
+}
+
+void SpillManager::enable(size_t budgetBytes, const std::string & dir, DF_compression_t compression,
+        size_t protectedAccesses) {
+#ifndef USE_LZ4
+    if(compression == DF_compression_t::lz4)
+        throw std::runtime_error("SpillManager: lz4 compression is not supported by this build");
+#endif
+    if(compression != DF_compression_t::none && compression != DF_compression_t::lz4)
+        throw std::runtime_error("SpillManager: spill files are either uncompressed or compressed by lz4");
+    this->dir = dir;
+    if(this->dir.empty()) {
+        const char * tmp = std::getenv("TMPDIR");
+        this->dir = tmp && *tmp ? tmp : "/tmp";
+    }
+    this->compression = compression;
+    residency = std::make_unique<ResidencyManager>(budgetBytes, protectedAccesses);
+    enabled = true;
+}
+
+void SpillManager::disable() {
+    enabled = false;
+    residency.reset();
+    spills = 0;
+    spilledBytes = 0;
+    writtenBytes = 0;
+    reloads = 0;
+    reloadedBytes = 0;
+}
+
+void SpillManager::makeRoom(size_t numBytes) {
+    if(auto r = getResidencyManager())
+        r->makeRoom(numBytes);
+}
+
+std::string SpillManager::newFilePath() {
+    return dir + "/daphne-spill-" + std::to_string(getpid()) + "-" + std::to_string(numFiles++) + ".dbdf";
+}
+
+void SpillManager::addSpill(size_t numBytes, size_t fileBytes) {
+    spills.fetch_add(1, std::memory_order_relaxed);
+    spilledBytes.fetch_add(numBytes, std::memory_order_relaxed);
+    writtenBytes.fetch_add(fileBytes, std::memory_order_relaxed);
+}
+
+void SpillManager::addReload(size_t numBytes) {
+    reloads.fetch_add(1, std::memory_order_relaxed);
+    reloadedBytes.fetch_add(numBytes, std::memory_order_relaxed);
+}
+
+SpillManager::Statistics SpillManager::getStatistics() const {
+    Statistics s;
+    if(auto r = getResidencyManager())
+        s.evictions = r->getStatistics().evictions;
+    s.spills = spills.load();
+    s.spilledBytes = spilledBytes.load();
+    s.writtenBytes = writtenBytes.load();
+    s.reloads = reloads.load();
+    s.reloadedBytes = reloadedBytes.load();
+    return s;
+}
+
+void SpillManager::Statistics::print(std::ostream & os) const {
+    const std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1) << "SpillManager: " << evictions << " evictions, " << spills
+            << " spills of " << spilledBytes / double(1 << 20) << " MiB (" << writtenBytes / double(1 << 20)
+            << " MiB written), " << reloads << " reloads of " << reloadedBytes / double(1 << 20) << " MiB"
+            << std::endl;
+    os.flags(flags);
+}
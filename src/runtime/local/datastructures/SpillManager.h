@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/io/DaphneFile.h>
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include <cstddef>
+
+class ResidencyManager;
+
+/**
+ * @brief Spills the values of cold dense matrices from main memory to local disk when they exceed a budget, such
+ * that the intermediates of a program may exceed the main memory.
+ *
+ * When enabled (see `--spill-budget-mb`), the host placements of the values of dense matrices are tracked by a
+ * `ResidencyManager` like the placements in device memory. Before a new array of values is allocated, the least
+ * recently used matrices are evicted until it fits into the budget: their values are written to a spill file (see
+ * `AllocationDescriptorDisk`) and freed. Matrices whose values are already up to date in a spill file (i.e., were
+ * only read since they were reloaded) are preferred, since they are evicted without writing. An evicted matrix is
+ * reloaded transparently when its values are accessed again (`DenseMatrix::getValues()`).
+ *
+ * Values shared with other matrices (e.g., views) are not spilled, since spilling would not free them. The most
+ * recently accessed matrices (e.g., the inputs of the running kernel) are protected from eviction, since the raw
+ * pointers to their values are not reference counted.
+ */
+class SpillManager {
+public:
+    // the number of most recent accesses to host values protected from eviction, more than for device memory, since
+    // a kernel may access the values of its inputs and result repeatedly
+    static constexpr size_t PROTECTED_ACCESSES = 64;
+
+    struct Statistics {
+        // the evictions of values from main memory, and the ones which wrote the values to a spill file
+        size_t evictions = 0;
+        size_t spills = 0;
+        // the bytes of the spilled values and of the spill files (less if compressed)
+        size_t spilledBytes = 0;
+        size_t writtenBytes = 0;
+        size_t reloads = 0;
+        size_t reloadedBytes = 0;
+
+        void print(std::ostream & os) const;
+    };
+
+private:
+    inline static std::atomic<bool> enabled{false};
+
+    std::unique_ptr<ResidencyManager> residency;
+    std::string dir;
+    DF_compression_t compression = DF_compression_t::none;
+    std::atomic<size_t> numFiles{0};
+
+    std::atomic<size_t> spills{0};
+    std::atomic<size_t> spilledBytes{0};
+    std::atomic<size_t> writtenBytes{0};
+    std::atomic<size_t> reloads{0};
+    std::atomic<size_t> reloadedBytes{0};
+
+    SpillManager();
+    ~SpillManager();
+
+public:
+    SpillManager(const SpillManager &) = delete;
+    SpillManager & operator=(const SpillManager &) = delete;
+
+    /**
+     * @brief Returns the process-wide spill manager, which lives until the process ends.
+     */
+    static SpillManager & get();
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Starts spilling the values of dense matrices in main memory beyond the budget.
+     *
+     * Should be called before any data object is created, since only the matrices accessed afterwards are tracked.
+     *
+     * @param budgetBytes The number of bytes of values of dense matrices kept in main memory.
+     * @param dir The directory of the spill files, preferably on a local SSD, the temporary directory if empty.
+     * @param compression The compression of the spill files, `none` or `lz4`.
+     * @param protectedAccesses The number of most recent accesses to values protected from eviction.
+     */
+    void enable(size_t budgetBytes, const std::string & dir, DF_compression_t compression,
+            size_t protectedAccesses = PROTECTED_ACCESSES);
+
+    /**
+     * @brief Stops spilling and resets the statistics. Values spilled before remain in their spill files until they
+     * are reloaded or their matrices are destroyed.
+     */
+    void disable();
+
+    /**
+     * @brief Returns the manager of the values of dense matrices in main memory, or nullptr if spilling is disabled.
+     */
+    [[nodiscard]] ResidencyManager * getResidencyManager() const {
+        return isEnabled() ? residency.get() : nullptr;
+    }
+
+    /**
+     * @brief Makes room for a new array of values in main memory by evicting the least recently used values beyond
+     * the budget, if spilling is enabled. The array is allocated even if the budget cannot be kept.
+     */
+    void makeRoom(size_t numBytes);
+
+    /**
+     * @brief Returns the path of a new spill file, which does not exist yet.
+     */
+    std::string newFilePath();
+
+    [[nodiscard]] DF_compression_t getCompression() const { return compression; }
+
+    void addSpill(size_t numBytes, size_t fileBytes);
+
+    void addReload(size_t numBytes);
+
+    [[nodiscard]] Statistics getStatistics() const;
+};
@@ -19,10 +19,13 @@
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/MetaDataObject.h>
 
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <map>
-#include <mutex>
-#include <array>
+#include <random>
+#include <stdexcept>
 
 /**
  * @brief The base class of all data structure implementations.
@@ -30,8 +33,16 @@
 class Structure
 {
 private:
-    mutable size_t refCounter;
-    mutable std::mutex refCounterMutex;
+    mutable std::atomic<size_t> refCounter;
+
+    /**
+     * @brief Whether the SSA value referring to this data object is not used
+     * after the current kernel call, see `markLastUse()`.
+     */
+    mutable bool lastUse;
+
+    // the ID of the lineage of this data object (0 until assigned), see `getLineageId()`
+    mutable std::atomic<uint64_t> lineageId;
     
     template<class DataType>
     friend void DataObjectFactory::destroy(const DataType * obj);
@@ -40,7 +51,7 @@ protected:
     size_t numRows;
     size_t numCols;
 
-    Structure(size_t numRows, size_t numCols) : refCounter(1), numRows(numRows), numCols(numCols) { };
+    Structure(size_t numRows, size_t numCols) : refCounter(1), lastUse(false), lineageId(0), numRows(numRows), numCols(numCols) { };
 
     mutable MetaDataObject mdo;
 
@@ -56,7 +67,7 @@ public:
     }
 
     size_t getRefCounter() const {
-        return refCounter;
+        return refCounter.load(std::memory_order_acquire);
     }
     
     MetaDataObject& getMetaDataObject() const {
@@ -66,19 +77,103 @@ public:
     /**
      * @brief Increases the reference counter of this data object.
      * 
-     * The access is protected by a mutex, such that multiple threads may call
+     * The reference counter is atomic, such that multiple threads may call
      * this method concurrently.
      */
     void increaseRefCounter() const {
-        refCounterMutex.lock();
-        refCounter++;
-        refCounterMutex.unlock();
+        // a new reference can only be derived from an existing one, so no
+        // ordering is required
+        refCounter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Increases the reference counter of this data object by `n` with
+     * a single atomic operation, e.g., to pin an input for many calls of a
+     * pipeline function.
+     */
+    void increaseRefCounter(size_t n) const {
+        refCounter.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Drops `n` references obtained by `increaseRefCounter(n)` which
+     * were not released by `DataObjectFactory::destroy()`.
+     *
+     * In contrast to `destroy()`, this never deletes the data object, i.e.,
+     * the caller must still hold another reference.
+     */
+    void unpinRefCounter(size_t n) const {
+        size_t current = refCounter.load(std::memory_order_relaxed);
+        do {
+            if(current <= n)
+                throw std::runtime_error("unpinRefCounter() must not release the last reference");
+        } while(!refCounter.compare_exchange_weak(current, current - n, std::memory_order_release,
+                std::memory_order_relaxed));
+    }
+    
+    /**
+     * @brief Marks that the reference held by the calling SSA value is
+     * released directly after the next kernel call, such that this kernel may
+     * reuse this data object for its result if there are no other references.
+     *
+     * Inserted by the compiler before operations with in-place support (see
+     * `ManageObjRefsPass`) and cleared again when the reference is released
+     * by `decRef()`.
+     */
+    void markLastUse() const {
+        lastUse = true;
+    }
+
+    void clearLastUse() const {
+        lastUse = false;
+    }
+
+    bool isAtLastUse() const {
+        return lastUse;
+    }
+
+    /**
+     * @brief Returns the ID of the lineage of this data object, i.e., of the
+     * computation that produced its values, assigning a fresh one on the first
+     * call.
+     *
+     * The results of kernels with reuse (see `ReuseCache`) get an ID derived
+     * from the kernel and the lineage of its arguments, such that repeated
+     * computations on them are recognized, too. The ID must be renewed when
+     * the values are overwritten in place.
+     */
+    uint64_t getLineageId() const {
+        uint64_t id = lineageId.load(std::memory_order_relaxed);
+        if(id != 0)
+            return id;
+        const uint64_t fresh = newLineageId();
+        return lineageId.compare_exchange_strong(id, fresh, std::memory_order_relaxed) ? fresh : id;
+    }
+
+    void setLineageId(uint64_t id) const {
+        lineageId.store(id, std::memory_order_relaxed);
+    }
+
+    void renewLineageId() const {
+        lineageId.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns a fresh lineage ID, which is not derived from others.
+     */
+    static uint64_t newLineageId() {
+        // randomly seeded, such that the IDs stay unique if each kernel
+        // library has a counter of its own
+        static std::atomic<uint64_t> next{(uint64_t(std::random_device{}()) << 32) ^ std::random_device{}()};
+        uint64_t id;
+        while((id = next.fetch_add(1, std::memory_order_relaxed)) == 0);
+        return id;
     }
     
-    // Note that there is no method for decreasing the reference counter here.
-    // Instead, use DataObjectFactory::destroy(). It is important that the
-    // reference counter becoming zero triggers the deletion of the data
-    // object. Thus, we cannot handle it here.
+    // Note that there is no method for decreasing the reference counter to
+    // zero here. Instead, use DataObjectFactory::destroy(). It is important
+    // that the reference counter becoming zero triggers the deletion of the
+    // data object. Thus, we cannot handle it here.
 
     [[nodiscard]] size_t getNumRows() const
     {
@@ -141,4 +236,23 @@ public:
      * @return 
      */
     virtual Structure* slice(size_t rl, size_t ru, size_t cl, size_t cu) const = 0;
+
+    /**
+     * @brief Turns this row view (created by `sliceRow()`) into a view on
+     * the rows `rl` to `ru` of `src` in place, without allocating anything.
+     *
+     * This allows to reuse one view for many consecutive row ranges, e.g.,
+     * the batches of a vectorized pipeline. Must only be called while the
+     * caller holds the only reference to this view. If `src` is `nullptr`,
+     * the view drops its reference to the data it refers to.
+     *
+     * @param src The data object to view, of the same type as this view.
+     * @param rl Row range lower bound (inclusive).
+     * @param ru Row range upper bound (exclusive).
+     * @return `false` if this data type does not support rebinding views or
+     * `src` is of another type, in which case nothing was changed.
+     */
+    virtual bool rebindRowView(const Structure* src, size_t rl, size_t ru) {
+        return false;
+    }
 };
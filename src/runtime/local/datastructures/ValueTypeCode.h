@@ -31,6 +31,7 @@ enum class ValueTypeCode : uint8_t {
     UI8, UI32, UI64, // unsigned integers (uintx_t)
     F32, F64, // floating point (float, double)
     INVALID, // only for JSON enum conversion
+    STR, // variable-length strings (std::string), only for the columns of frames
     // TODO Support bool as well, but poses some challenges (e.g. sizeof).
 //    UI1 // boolean (bool)
 };
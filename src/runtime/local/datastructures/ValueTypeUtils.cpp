@@ -34,6 +34,7 @@ size_t ValueTypeUtils::sizeOf(ValueTypeCode type) {
         case ValueTypeCode::UI64: return sizeof(uint64_t);
         case ValueTypeCode::F32: return sizeof(float);
         case ValueTypeCode::F64: return sizeof(double);
+        case ValueTypeCode::STR: return sizeof(std::string);
         default: throw std::runtime_error("ValueTypeUtils::sizeOf: unknown value type code");
     }
 }
@@ -50,6 +51,7 @@ void ValueTypeUtils::printValue(std::ostream & os, ValueTypeCode type, const voi
         case ValueTypeCode::UI64: os << reinterpret_cast<const uint64_t *>(array)[pos]; break;
         case ValueTypeCode::F32: os << reinterpret_cast<const float  *>(array)[pos]; break;
         case ValueTypeCode::F64: os << reinterpret_cast<const double *>(array)[pos]; break;
+        case ValueTypeCode::STR: os << reinterpret_cast<const std::string *>(array)[pos]; break;
         default: throw std::runtime_error("ValueTypeUtils::printValue: unknown value type code");
     }
 }
@@ -62,6 +64,7 @@ template<> const ValueTypeCode ValueTypeUtils::codeFor<uint32_t> = ValueTypeCode
 template<> const ValueTypeCode ValueTypeUtils::codeFor<uint64_t> = ValueTypeCode::UI64;
 template<> const ValueTypeCode ValueTypeUtils::codeFor<float>  = ValueTypeCode::F32;
 template<> const ValueTypeCode ValueTypeUtils::codeFor<double> = ValueTypeCode::F64;
+template<> const ValueTypeCode ValueTypeUtils::codeFor<std::string> = ValueTypeCode::STR;
 
 template<> const std::string ValueTypeUtils::cppNameFor<int8_t>   = "int8_t";
 template<> const std::string ValueTypeUtils::cppNameFor<int32_t>  = "int32_t";
@@ -73,6 +76,7 @@ template<> const std::string ValueTypeUtils::cppNameFor<float>  = "float";
 template<> const std::string ValueTypeUtils::cppNameFor<double> = "double";
 template<> const std::string ValueTypeUtils::cppNameFor<bool> = "bool";
 template<> const std::string ValueTypeUtils::cppNameFor<const char*> = "const char*";
+template<> const std::string ValueTypeUtils::cppNameFor<std::string> = "std::string";
 
 template<> const std::string ValueTypeUtils::irNameFor<int8_t>   = "si8";
 template<> const std::string ValueTypeUtils::irNameFor<int32_t>  = "si32";
@@ -82,6 +86,7 @@ template<> const std::string ValueTypeUtils::irNameFor<uint32_t> = "ui32";
 template<> const std::string ValueTypeUtils::irNameFor<uint64_t> = "ui64";
 template<> const std::string ValueTypeUtils::irNameFor<float>  = "f32";
 template<> const std::string ValueTypeUtils::irNameFor<double> = "f64";
+template<> const std::string ValueTypeUtils::irNameFor<std::string> = "str";
     
 const std::string ValueTypeUtils::cppNameForCode(ValueTypeCode type) {
     switch(type) {
@@ -93,6 +98,7 @@ const std::string ValueTypeUtils::cppNameForCode(ValueTypeCode type) {
         case ValueTypeCode::UI64: return cppNameFor<uint64_t>;
         case ValueTypeCode::F32: return cppNameFor<float>;
         case ValueTypeCode::F64: return cppNameFor<double>;
+        case ValueTypeCode::STR: return cppNameFor<std::string>;
         default: throw std::runtime_error("ValueTypeUtils::cppNameForCode: unknown value type code");
     }
 }
@@ -107,6 +113,7 @@ const std::string ValueTypeUtils::irNameForCode(ValueTypeCode type) {
         case ValueTypeCode::UI64: return irNameFor<uint64_t>;
         case ValueTypeCode::F32: return irNameFor<float>;
         case ValueTypeCode::F64: return irNameFor<double>;
+        case ValueTypeCode::STR: return irNameFor<std::string>;
         default: throw std::runtime_error("ValueTypeUtils::irNameForCode: unknown value type code");
     }
 }
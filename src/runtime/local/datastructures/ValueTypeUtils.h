@@ -60,6 +60,7 @@ template<> const ValueTypeCode ValueTypeUtils::codeFor<uint32_t>;
 template<> const ValueTypeCode ValueTypeUtils::codeFor<uint64_t>;
 template<> const ValueTypeCode ValueTypeUtils::codeFor<float>;
 template<> const ValueTypeCode ValueTypeUtils::codeFor<double>;
+template<> const ValueTypeCode ValueTypeUtils::codeFor<std::string>;
 
 template<> const std::string ValueTypeUtils::cppNameFor<int8_t>;
 template<> const std::string ValueTypeUtils::cppNameFor<int32_t>;
@@ -70,6 +71,7 @@ template<> const std::string ValueTypeUtils::cppNameFor<uint64_t>;
 template<> const std::string ValueTypeUtils::cppNameFor<float>;
 template<> const std::string ValueTypeUtils::cppNameFor<double>;
 template<> const std::string ValueTypeUtils::cppNameFor<bool>;
+template<> const std::string ValueTypeUtils::cppNameFor<std::string>;
 
 template<> const std::string ValueTypeUtils::irNameFor<int8_t>;
 template<> const std::string ValueTypeUtils::irNameFor<int32_t>;
@@ -79,4 +81,5 @@ template<> const std::string ValueTypeUtils::irNameFor<uint32_t>;
 template<> const std::string ValueTypeUtils::irNameFor<uint64_t>;
 template<> const std::string ValueTypeUtils::irNameFor<float>;
 template<> const std::string ValueTypeUtils::irNameFor<double>;
+template<> const std::string ValueTypeUtils::irNameFor<std::string>;
 
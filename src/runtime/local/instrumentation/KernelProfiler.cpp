@@ -0,0 +1,452 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/instrumentation/KernelProfiler.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+struct KernelProfiler::ThreadLog {
+    size_t threadIx;
+    std::map<std::pair<const char *, const char *>, SiteStats> sites;
+    std::vector<Call> calls;
+    // the calls beyond MAX_TRACED_CALLS, which are only summed up
+    size_t numUntraced = 0;
+};
+
+struct KernelProfiler::ThreadState {
+    struct OpenCall {
+        const char * kernel;
+        const char * location;
+        std::chrono::steady_clock::time_point start;
+        size_t allocatedBytes;
+        uint64_t cycles;
+        uint64_t llcMisses;
+        bool counted;
+        std::vector<Shape> inputs;
+        double flops;
+        double bytes;
+    };
+
+    ThreadLog * log = nullptr;
+    std::vector<Shape> pendingInputs;
+    // the estimated FLOPs and bytes of the next call, negative if none
+    double pendingFlops = -1;
+    double pendingBytes = -1;
+    std::vector<OpenCall> openCalls;
+    // the index of the last ended call in the log, if it is traced
+    size_t lastCall = std::numeric_limits<size_t>::max();
+    // the group of the perf events of the cycles (the leader) and the last-level cache misses
+    int perfLeader = -1;
+    int perfMember = -1;
+    bool perfOpened = false;
+
+    ~ThreadState() {
+        if(perfMember != -1)
+            close(perfMember);
+        if(perfLeader != -1)
+            close(perfLeader);
+    }
+
+    // opens the perf events of the calling thread on first use, returning whether they can be read
+    bool openPerfEvents() {
+        if(perfOpened)
+            return perfLeader != -1;
+        perfOpened = true;
+#ifdef __linux__
+        auto openEvent = [](uint32_t type, uint64_t config, int groupFd) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = groupFd == -1;
+            // user space only, which unprivileged processes may count with the default perf_event_paranoid
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+        };
+        perfLeader = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+        if(perfLeader != -1)
+            perfMember = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, perfLeader);
+        if(perfLeader != -1 && perfMember != -1) {
+            ioctl(perfLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            return true;
+        }
+        if(perfLeader != -1)
+            close(perfLeader);
+        perfLeader = -1;
+#endif
+        static std::once_flag warned;
+        std::call_once(warned, []() {
+            std::cerr << "KernelProfiler: the perf events of the cycles and cache misses cannot be opened, "
+                    "e.g., due to /proc/sys/kernel/perf_event_paranoid, so they are not counted" << std::endl;
+        });
+        return false;
+    }
+
+    void readPerfEvents(uint64_t & cycles, uint64_t & llcMisses) const {
+        struct {
+            uint64_t nr;
+            uint64_t values[2];
+        } group;
+        if(read(perfLeader, &group, sizeof(group)) != sizeof(group) || group.nr != 2) {
+            cycles = llcMisses = 0;
+            return;
+        }
+        cycles = group.values[0];
+        llcMisses = group.values[1];
+    }
+};
+
+void KernelProfiler::SiteStats::add(const SiteStats & other) {
+    numCalls += other.numCalls;
+    totalNanos += other.totalNanos;
+    maxNanos = std::max(maxNanos, other.maxNanos);
+    allocatedBytes += other.allocatedBytes;
+    cycles += other.cycles;
+    llcMisses += other.llcMisses;
+    flops += other.flops;
+    bytes += other.bytes;
+    estimatedNanos += other.estimatedNanos;
+}
+
+KernelProfiler::KernelProfiler() : epoch(std::chrono::steady_clock::now()) {}
+
+KernelProfiler::~KernelProfiler() = default;
+
+KernelProfiler & KernelProfiler::get() {
+    // lives until the process ends, such that threads ending later can still use it
+    static KernelProfiler * profiler = new KernelProfiler();
+    return *profiler;
+}
+
+KernelProfiler::ThreadState & KernelProfiler::getThreadState() {
+    static thread_local ThreadState state;
+    if(!state.log) {
+        std::lock_guard<std::mutex> lock(mtx);
+        logs.push_back(std::make_unique<ThreadLog>());
+        logs.back()->threadIx = logs.size() - 1;
+        state.log = logs.back().get();
+    }
+    return state;
+}
+
+void KernelProfiler::addInput(const Structure * arg) {
+    getThreadState().pendingInputs.push_back({arg->getNumRows(), arg->getNumCols()});
+}
+
+void KernelProfiler::setCost(double flops, double bytesRead, double bytesWritten) {
+    ThreadState & state = getThreadState();
+    state.pendingFlops = flops;
+    state.pendingBytes = bytesRead + bytesWritten;
+}
+
+void KernelProfiler::begin(const char * kernel, const char * location, bool countPerfEvents) {
+    ThreadState & state = getThreadState();
+    ThreadState::OpenCall call{
+            kernel, location, {}, BufferPool::getThreadAllocatedBytes(), 0, 0, false, {},
+            state.pendingFlops, state.pendingBytes
+    };
+    call.inputs.swap(state.pendingInputs);
+    state.pendingFlops = state.pendingBytes = -1;
+    if(countPerfEvents && state.openPerfEvents()) {
+        state.readPerfEvents(call.cycles, call.llcMisses);
+        call.counted = true;
+    }
+    // the time is taken last, such that reading the counters is not part of it
+    call.start = std::chrono::steady_clock::now();
+    state.openCalls.push_back(std::move(call));
+}
+
+void KernelProfiler::end() {
+    const auto now = std::chrono::steady_clock::now();
+    ThreadState & state = getThreadState();
+    if(state.openCalls.empty())
+        return;
+    ThreadState::OpenCall & open = state.openCalls.back();
+
+    uint64_t cycles = 0;
+    uint64_t llcMisses = 0;
+    if(open.counted) {
+        state.readPerfEvents(cycles, llcMisses);
+        cycles -= open.cycles;
+        llcMisses -= open.llcMisses;
+    }
+    const auto startNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(open.start - epoch).count();
+    const auto durationNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now - open.start).count();
+    const size_t allocatedBytes = BufferPool::getThreadAllocatedBytes() - open.allocatedBytes;
+
+    ThreadLog & log = *state.log;
+    SiteStats & site = log.sites[{open.kernel, open.location}];
+    site.numCalls++;
+    site.totalNanos += durationNanos;
+    site.maxNanos = std::max<uint64_t>(site.maxNanos, durationNanos);
+    site.allocatedBytes += allocatedBytes;
+    site.cycles += cycles;
+    site.llcMisses += llcMisses;
+    if(open.flops >= 0) {
+        site.flops += open.flops;
+        site.bytes += open.bytes;
+        site.estimatedNanos += durationNanos;
+    }
+
+    if(log.calls.size() < MAX_TRACED_CALLS) {
+        state.lastCall = log.calls.size();
+        log.calls.push_back({
+                open.kernel, open.location, static_cast<uint64_t>(startNanos), static_cast<uint64_t>(durationNanos),
+                allocatedBytes, cycles, llcMisses, std::move(open.inputs), {}
+        });
+    }
+    else {
+        state.lastCall = std::numeric_limits<size_t>::max();
+        log.numUntraced++;
+    }
+    state.openCalls.pop_back();
+}
+
+void KernelProfiler::addOutput(const Structure * res) {
+    ThreadState & state = getThreadState();
+    if(state.lastCall < state.log->calls.size())
+        state.log->calls[state.lastCall].outputs.push_back({res->getNumRows(), res->getNumCols()});
+}
+
+std::map<std::pair<std::string, std::string>, KernelProfiler::SiteStats> KernelProfiler::getSiteStats() const {
+    std::map<std::pair<std::string, std::string>, SiteStats> res;
+    std::lock_guard<std::mutex> lock(mtx);
+    for(auto & log : logs)
+        for(auto & site : log->sites)
+            res[{getKernelName(site.first.first), site.first.second}].add(site.second);
+    return res;
+}
+
+void KernelProfiler::printSummary(std::ostream & os) const {
+    auto sites = getSiteStats();
+    std::vector<std::pair<std::pair<std::string, std::string>, SiteStats>> sorted(sites.begin(), sites.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto & a, const auto & b) {
+        return a.second.totalNanos > b.second.totalNanos;
+    });
+    SiteStats total;
+    for(auto & site : sorted)
+        total.add(site.second);
+    const bool counted = total.cycles > 0;
+
+    const std::ios::fmtflags flags = os.flags();
+    os << "Kernel profile: " << total.numCalls << " calls, " << std::fixed << std::setprecision(3)
+            << (total.totalNanos / 1e6) << " ms" << std::endl;
+    os << std::setw(12) << "time [ms]" << std::setw(8) << "%" << std::setw(10) << "calls"
+            << std::setw(12) << "mean [us]" << std::setw(12) << "max [us]" << std::setw(12) << "alloc [MiB]";
+    if(counted)
+        os << std::setw(12) << "Mcycles" << std::setw(14) << "LLC misses";
+    os << "  kernel @ location" << std::endl;
+    for(auto & site : sorted) {
+        const SiteStats & s = site.second;
+        os << std::setw(12) << std::setprecision(3) << (s.totalNanos / 1e6)
+                << std::setw(8) << std::setprecision(1)
+                << (total.totalNanos ? 100.0 * s.totalNanos / total.totalNanos : 0.0)
+                << std::setw(10) << s.numCalls
+                << std::setw(12) << std::setprecision(2) << (s.totalNanos / 1e3 / s.numCalls)
+                << std::setw(12) << (s.maxNanos / 1e3)
+                << std::setw(12) << (s.allocatedBytes / double(1 << 20));
+        if(counted)
+            os << std::setw(12) << (s.cycles / 1e6) << std::setw(14) << s.llcMisses;
+        os << "  " << site.first.first << " @ " << site.first.second << std::endl;
+    }
+    os.flags(flags);
+}
+
+bool KernelProfiler::hasCosts() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    for(auto & log : logs)
+        for(auto & site : log->sites)
+            if(site.second.estimatedNanos)
+                return true;
+    return false;
+}
+
+void KernelProfiler::printRoofline(std::ostream & os, const Peaks & peaks) const {
+    auto sites = getSiteStats();
+    std::vector<std::pair<std::pair<std::string, std::string>, SiteStats>> sorted;
+    for(auto & site : sites)
+        if(site.second.estimatedNanos)
+            sorted.emplace_back(site);
+    if(sorted.empty())
+        return;
+    std::sort(sorted.begin(), sorted.end(), [](const auto & a, const auto & b) {
+        return a.second.estimatedNanos > b.second.estimatedNanos;
+    });
+
+    const std::ios::fmtflags flags = os.flags();
+    // the arithmetic intensity at which the roofs meet
+    const double ridge = peaks.gflops / peaks.gbps;
+    os << "Roofline (estimated FLOPs and bytes, measured time; peaks " << std::fixed << std::setprecision(1)
+            << peaks.gflops << " GFLOP/s and " << peaks.gbps << " GB/s, ridge at " << std::setprecision(2) << ridge
+            << " FLOP/B)" << std::endl;
+    os << std::setw(12) << "time [ms]" << std::setw(10) << "GFLOP" << std::setw(10) << "GB" << std::setw(9) << "FLOP/B"
+            << std::setw(10) << "GFLOP/s" << std::setw(8) << "%peak" << std::setw(10) << "GB/s" << std::setw(8)
+            << "%peak" << std::setw(9) << "bound" << "  kernel @ location" << std::endl;
+    for(auto & site : sorted) {
+        const SiteStats & s = site.second;
+        // GFLOP/s and GB/s are FLOP/ns and B/ns
+        const double gflops = s.flops / s.estimatedNanos;
+        const double gbps = s.bytes / s.estimatedNanos;
+        const double intensity = s.bytes > 0 ? s.flops / s.bytes : 0.0;
+        os << std::setw(12) << std::setprecision(3) << (s.estimatedNanos / 1e6)
+                << std::setw(10) << (s.flops / 1e9) << std::setw(10) << (s.bytes / 1e9)
+                << std::setw(9) << std::setprecision(2) << intensity
+                << std::setw(10) << gflops << std::setw(8) << std::setprecision(1) << (100 * gflops / peaks.gflops)
+                << std::setw(10) << std::setprecision(2) << gbps << std::setw(8) << std::setprecision(1)
+                << (100 * gbps / peaks.gbps)
+                << std::setw(9) << (intensity < ridge ? "memory" : "compute")
+                << "  " << site.first.first << " @ " << site.first.second << std::endl;
+    }
+    os.flags(flags);
+}
+
+KernelProfiler::Peaks KernelProfiler::estimatePeaks(size_t numThreads) {
+    numThreads = std::max<size_t>(1, numThreads);
+
+    // the double-precision FLOPs per cycle of two FMA units of the vector width
+    double flopsPerCycle;
+    switch(CpuDispatch::detect()) {
+        case CpuIsa::AVX512: flopsPerCycle = 32; break;
+        case CpuIsa::AVX2: flopsPerCycle = 16; break;
+        case CpuIsa::NEON: // fall through
+        case CpuIsa::SVE: flopsPerCycle = 8; break;
+        default: flopsPerCycle = 4; break;
+    }
+    double ghz = 2.5;
+    std::ifstream freqFile("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    double khz = 0;
+    if(freqFile >> khz && khz > 0)
+        ghz = khz / 1e6;
+
+    // the triad a = b + s * c over arrays larger than the last-level caches, the best of a few repetitions
+    const size_t numElems = size_t(1) << 22;
+    std::vector<double> a(numElems), b(numElems, 1.0), c(numElems, 2.0);
+    double bestNanos = std::numeric_limits<double>::max();
+    for(int rep = 0; rep < 3; rep++) {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for(size_t t = 0; t < numThreads; t++)
+            threads.emplace_back([&, t]() {
+                const size_t end = (t + 1) * numElems / numThreads;
+                for(size_t i = t * numElems / numThreads; i < end; i++)
+                    a[i] = b[i] + 3.0 * c[i];
+            });
+        for(auto & thread : threads)
+            thread.join();
+        const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        bestNanos = std::min(bestNanos, static_cast<double>(nanos));
+    }
+    // keep the stores
+    volatile double sink = a[numElems / 2];
+    (void)sink;
+
+    return {numThreads * ghz * flopsPerCycle, 3 * sizeof(double) * numElems / bestNanos};
+}
+
+// a JSON string literal of the given string
+static std::string jsonString(const char * s) {
+    std::string res = "\"";
+    for(; *s; s++) {
+        const unsigned char c = *s;
+        if(c == '"' || c == '\\') {
+            res += '\\';
+            res += c;
+        }
+        else if(c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            res += escaped;
+        }
+        else
+            res += c;
+    }
+    return res + "\"";
+}
+
+static std::string shapesString(const std::vector<KernelProfiler::Shape> & shapes) {
+    std::string res;
+    for(auto & shape : shapes)
+        res += (res.empty() ? "" : ", ") + std::to_string(shape.numRows) + "x" + std::to_string(shape.numCols);
+    return res;
+}
+
+void KernelProfiler::writeChromeTrace(std::ostream & os) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    const auto pid = getpid();
+    const std::ios::fmtflags flags = os.flags();
+    os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    os << std::fixed << std::setprecision(3);
+    for(auto & log : logs)
+        for(const Call & call : log->calls) {
+            os << (first ? "\n" : ",\n");
+            first = false;
+            // the time stamps and durations are in microseconds
+            os << "{\"name\": " << jsonString(getKernelName(call.kernel).c_str()) << ", \"cat\": \"kernel\", "
+                    << "\"ph\": \"X\", \"ts\": " << (call.startNanos / 1e3) << ", \"dur\": "
+                    << (call.durationNanos / 1e3) << ", \"pid\": " << pid << ", \"tid\": " << log->threadIx
+                    << ", \"args\": {\"location\": " << jsonString(call.location)
+                    << ", \"kernel\": " << jsonString(call.kernel)
+                    << ", \"inputs\": " << jsonString(shapesString(call.inputs).c_str())
+                    << ", \"outputs\": " << jsonString(shapesString(call.outputs).c_str())
+                    << ", \"allocatedBytes\": " << call.allocatedBytes;
+            if(call.cycles)
+                os << ", \"cycles\": " << call.cycles << ", \"llcMisses\": " << call.llcMisses;
+            os << "}}";
+        }
+    os << "\n]}" << std::endl;
+    os.flags(flags);
+    for(auto & log : logs)
+        if(log->numUntraced)
+            std::cerr << "KernelProfiler: " << log->numUntraced << " calls of thread " << log->threadIx
+                    << " are not in the trace, which holds " << MAX_TRACED_CALLS << " calls per thread" << std::endl;
+}
+
+void KernelProfiler::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for(auto & log : logs) {
+        log->sites.clear();
+        log->calls.clear();
+        log->numUntraced = 0;
+    }
+}
+
+std::string KernelProfiler::getKernelName(const std::string & kernelFunc) {
+    const size_t begin = (!kernelFunc.empty() && kernelFunc[0] == '_') ? 1 : 0;
+    const size_t typesBegin = kernelFunc.find("__", begin);
+    return kernelFunc.substr(begin, typesBegin == std::string::npos ? std::string::npos : typesBegin - begin);
+}
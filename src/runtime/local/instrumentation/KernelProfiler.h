@@ -0,0 +1,184 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/Structure.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Records the calls of the kernels, which the ProfileKernelsPass
+ * surrounds by the hooks of ProfileKernel.h.
+ *
+ * For each call, the wall time, the shapes of the data objects it takes and
+ * returns, the bytes of the arrays it allocates (see
+ * `BufferPool::getThreadAllocatedBytes()`), and, optionally, the cycles and
+ * last-level cache misses it takes (by perf events, if the kernel allows it)
+ * are recorded. The calls are summed up per kernel and source location of the
+ * DaphneDSL statement it belongs to, and the first `MAX_TRACED_CALLS` calls of
+ * each thread are kept for the Chrome trace (see `writeChromeTrace()`).
+ *
+ * The calls are recorded per thread without synchronization, so the summary
+ * and the trace must only be taken once the threads calling kernels are done.
+ */
+class KernelProfiler {
+public:
+    static constexpr size_t MAX_TRACED_CALLS = size_t(1) << 20;
+
+    struct Shape {
+        size_t numRows;
+        size_t numCols;
+    };
+
+    struct Call {
+        // the kernel function and the source location, which are the strings of the constants of the compiled code
+        const char * kernel;
+        const char * location;
+        // since the creation of the profiler
+        uint64_t startNanos;
+        uint64_t durationNanos;
+        size_t allocatedBytes;
+        // zero if not counted
+        uint64_t cycles;
+        uint64_t llcMisses;
+        std::vector<Shape> inputs;
+        std::vector<Shape> outputs;
+    };
+
+    // the calls of a kernel at a source location
+    struct SiteStats {
+        size_t numCalls = 0;
+        uint64_t totalNanos = 0;
+        uint64_t maxNanos = 0;
+        size_t allocatedBytes = 0;
+        uint64_t cycles = 0;
+        uint64_t llcMisses = 0;
+        // the estimated FLOPs and bytes of the calls with cost estimates (see `setCost()`), and their time
+        double flops = 0;
+        double bytes = 0;
+        uint64_t estimatedNanos = 0;
+
+        void add(const SiteStats & other);
+    };
+
+    // the peak performance and memory bandwidth of the machine, the roofs of the roofline analysis
+    struct Peaks {
+        double gflops;
+        double gbps;
+    };
+
+private:
+    struct ThreadLog;
+    struct ThreadState;
+
+    const std::chrono::steady_clock::time_point epoch;
+    mutable std::mutex mtx;
+    std::vector<std::unique_ptr<ThreadLog>> logs;
+
+    KernelProfiler();
+
+    ThreadState & getThreadState();
+
+public:
+    KernelProfiler(const KernelProfiler &) = delete;
+    KernelProfiler & operator=(const KernelProfiler &) = delete;
+    ~KernelProfiler();
+
+    static KernelProfiler & get();
+
+    /**
+     * @brief Records an input of the next call of the calling thread.
+     */
+    void addInput(const Structure * arg);
+
+    /**
+     * @brief Records the estimated costs of the next call of the calling thread (see EstimateCostsPass).
+     */
+    void setCost(double flops, double bytesRead, double bytesWritten);
+
+    /**
+     * @brief Starts a call of the given kernel function at the given source location (both must live as long as the
+     * profiler) on the calling thread.
+     */
+    void begin(const char * kernel, const char * location, bool countPerfEvents);
+
+    /**
+     * @brief Ends the last call started on the calling thread.
+     */
+    void end();
+
+    /**
+     * @brief Records an output of the last call ended on the calling thread.
+     */
+    void addOutput(const Structure * res);
+
+    /**
+     * @brief Returns the calls summed up per kernel (without the types in the name of the kernel function) and source
+     * location.
+     */
+    std::map<std::pair<std::string, std::string>, SiteStats> getSiteStats() const;
+
+    /**
+     * @brief Prints the summed up calls, the most expensive ones first.
+     */
+    void printSummary(std::ostream & os) const;
+
+    /**
+     * @brief Prints the achieved GFLOP/s and GB/s of the calls with cost estimates against the peaks of the machine,
+     * the most expensive ones first, or nothing if there are none.
+     */
+    void printRoofline(std::ostream & os, const Peaks & peaks) const;
+
+    /**
+     * @brief Returns whether any call with cost estimates was recorded.
+     */
+    bool hasCosts() const;
+
+    /**
+     * @brief Estimates the peaks of the machine for the given number of threads: the double-precision GFLOP/s from
+     * the maximum clock frequency and the vector width of the CPU (see CpuDispatch), and the GB/s by a short
+     * STREAM-like triad. Both are rough estimates, which the user may override (see `DaphneUserConfig`).
+     */
+    static Peaks estimatePeaks(size_t numThreads);
+
+    /**
+     * @brief Writes the traced calls as complete events of the Chrome trace format, which chrome://tracing and
+     * Perfetto display.
+     */
+    void writeChromeTrace(std::ostream & os) const;
+
+    /**
+     * @brief Forgets all calls.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the name of a kernel function without the types of the arguments and results, e.g., "ewAdd"
+     * for "_ewAdd__DenseMatrix_double__DenseMatrix_double__DenseMatrix_double".
+     */
+    static std::string getKernelName(const std::string & kernelFunc);
+};
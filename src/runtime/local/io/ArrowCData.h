@@ -0,0 +1,307 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifdef USE_ARROW
+
+#include <runtime/local/datastructures/ColumnEncoding.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <runtime/local/io/ArrowIpc.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <arrow/api.h>
+#include <arrow/c/abi.h>
+#include <arrow/c/bridge.h>
+
+// The exchange of frames with other libraries in the same process (e.g., pandas
+// through pyarrow) by Arrow's C data interface, such that the numeric columns
+// are shared rather than copied.
+
+// ****************************************************************************
+// Import
+// ****************************************************************************
+
+// the values of a numeric column, which keep the Arrow array alive if they are its buffer
+template <typename VT> std::shared_ptr<uint8_t> arrowColumnValues(const std::shared_ptr<arrow::Array> &arr) {
+  DenseMatrix<VT> *colMat = arrowToColumnMatrix<VT>(std::make_shared<arrow::ChunkedArray>(arr), true);
+  std::shared_ptr<VT[]> values = colMat->getValuesSharedPtr();
+  DataObjectFactory::destroy(colMat);
+  return std::shared_ptr<uint8_t>(values, reinterpret_cast<uint8_t *>(values.get()));
+}
+
+inline std::shared_ptr<uint8_t> arrowColumnValues(const std::shared_ptr<arrow::Array> &arr, ValueTypeCode vtc) {
+  switch (vtc) {
+    case ValueTypeCode::SI8:  return arrowColumnValues<int8_t>(arr);
+    case ValueTypeCode::SI32: return arrowColumnValues<int32_t>(arr);
+    case ValueTypeCode::SI64: return arrowColumnValues<int64_t>(arr);
+    case ValueTypeCode::UI8:  return arrowColumnValues<uint8_t>(arr);
+    case ValueTypeCode::UI32: return arrowColumnValues<uint32_t>(arr);
+    case ValueTypeCode::UI64: return arrowColumnValues<uint64_t>(arr);
+    case ValueTypeCode::F32:  return arrowColumnValues<float>(arr);
+    case ValueTypeCode::F64:  return arrowColumnValues<double>(arr);
+    default:
+      throw std::runtime_error("ArrowCData: unsupported value type");
+  }
+}
+
+inline bool isArrowStringType(const arrow::DataType &type) {
+  return type.id() == arrow::Type::STRING || type.id() == arrow::Type::LARGE_STRING;
+}
+
+// the strings of a string array, nulls become empty strings
+inline std::vector<std::string> arrowStrings(const arrow::Array &arr) {
+  std::vector<std::string> res(arr.length());
+  for (int64_t i = 0; i < arr.length(); i++)
+    if (arr.IsValid(i))
+      res[i] = arr.type_id() == arrow::Type::STRING
+          ? static_cast<const arrow::StringArray &>(arr).GetString(i)
+          : static_cast<const arrow::LargeStringArray &>(arr).GetString(i);
+  return res;
+}
+
+// the values of a numeric array, nulls become the null value of ReadParquet
+template <typename VT> std::vector<VT> arrowValues(const std::shared_ptr<arrow::Array> &arr) {
+  std::vector<VT> res(arr->length());
+  copyArrowColumn(arrow::ChunkedArray(arr), res.data(), 1);
+  return res;
+}
+
+inline std::shared_ptr<uint8_t> stringColumnOf(std::vector<std::string> strings) {
+  std::shared_ptr<std::string[]> column(new std::string[strings.size()]);
+  std::move(strings.begin(), strings.end(), column.get());
+  return std::shared_ptr<uint8_t>(column, reinterpret_cast<uint8_t *>(column.get()));
+}
+
+/**
+ * @brief Converts a dictionary array to a `DictionaryColumn`, whose dictionary
+ * is the sorted distinct values of the Arrow dictionary (a null index stands
+ * for the default value, e.g., the empty string).
+ */
+template <typename VT>
+std::shared_ptr<const EncodedColumn> arrowToDictionaryColumn(const arrow::DictionaryArray &arr,
+                                                             const std::vector<VT> &arrowDictionary) {
+  std::vector<VT> values(arrowDictionary);
+  if (arr.null_count() > 0)
+    values.push_back(VT());
+  auto dictionary = std::make_shared<std::vector<VT>>(values);
+  std::sort(dictionary->begin(), dictionary->end());
+  dictionary->erase(std::unique(dictionary->begin(), dictionary->end()), dictionary->end());
+  std::vector<uint64_t> codeOf(values.size());
+  for (size_t i = 0; i < values.size(); i++)
+    codeOf[i] = std::lower_bound(dictionary->begin(), dictionary->end(), values[i]) - dictionary->begin();
+  const uint64_t nullCode = arr.null_count() > 0 ? codeOf.back() : 0;
+
+  const int64_t numRows = arr.length();
+  BitPackedArray codes(numRows, BitPackedArray::bitWidthFor(dictionary->empty() ? 0 : dictionary->size() - 1));
+  for (int64_t r = 0; r < numRows; r++)
+    codes.init(r, arr.IsValid(r) ? codeOf[arr.GetValueIndex(r)] : nullCode);
+  return std::make_shared<DictionaryColumn<VT>>(std::move(dictionary), std::move(codes));
+}
+
+inline ValueTypeCode arrowDictionaryValueType(const arrow::DictionaryType &type) {
+  return isArrowStringType(*type.value_type()) ? ValueTypeCode::STR : valueTypeCodeFor(*type.value_type());
+}
+
+inline std::shared_ptr<const EncodedColumn> arrowToDictionaryColumn(const arrow::DictionaryArray &arr) {
+  const std::shared_ptr<arrow::Array> &dict = arr.dictionary();
+  switch (arrowDictionaryValueType(static_cast<const arrow::DictionaryType &>(*arr.type()))) {
+    case ValueTypeCode::SI8:  return arrowToDictionaryColumn(arr, arrowValues<int8_t>(dict));
+    case ValueTypeCode::SI32: return arrowToDictionaryColumn(arr, arrowValues<int32_t>(dict));
+    case ValueTypeCode::SI64: return arrowToDictionaryColumn(arr, arrowValues<int64_t>(dict));
+    case ValueTypeCode::UI8:  return arrowToDictionaryColumn(arr, arrowValues<uint8_t>(dict));
+    case ValueTypeCode::UI32: return arrowToDictionaryColumn(arr, arrowValues<uint32_t>(dict));
+    case ValueTypeCode::UI64: return arrowToDictionaryColumn(arr, arrowValues<uint64_t>(dict));
+    case ValueTypeCode::F32:  return arrowToDictionaryColumn(arr, arrowValues<float>(dict));
+    case ValueTypeCode::F64:  return arrowToDictionaryColumn(arr, arrowValues<double>(dict));
+    case ValueTypeCode::STR:  return arrowToDictionaryColumn(arr, arrowStrings(*dict));
+    default:
+      throw std::runtime_error("ArrowCData: unsupported value type of a dictionary");
+  }
+}
+
+/**
+ * @brief Imports a record batch exported through Arrow's C data interface as a
+ * frame, taking over the ownership of the exported array.
+ *
+ * The numeric columns without nulls share the buffers of the array, which the
+ * frame releases through the release callback of the exporter once it does
+ * not use them anymore. String columns are copied, since a frame holds a
+ * `std::string` per row, and dictionary columns become `DictionaryColumn`s.
+ */
+inline Frame *arrowCDataToFrame(struct ArrowArray *array, struct ArrowSchema *schema) {
+  auto imported = arrow::ImportRecordBatch(array, schema);
+  if (!imported.ok())
+    throw std::runtime_error("ArrowCData: cannot import the record batch: " + imported.status().ToString());
+  std::shared_ptr<arrow::RecordBatch> batch = *imported;
+
+  const size_t numCols = static_cast<size_t>(batch->num_columns());
+  std::vector<ValueTypeCode> vtcs(numCols);
+  std::vector<std::shared_ptr<uint8_t>> columns(numCols);
+  std::vector<std::shared_ptr<const EncodedColumn>> encodings(numCols);
+  for (size_t c = 0; c < numCols; c++) {
+    const std::shared_ptr<arrow::Array> &col = batch->column(c);
+    if (col->type_id() == arrow::Type::DICTIONARY) {
+      vtcs[c] = arrowDictionaryValueType(static_cast<const arrow::DictionaryType &>(*col->type()));
+      encodings[c] = arrowToDictionaryColumn(static_cast<const arrow::DictionaryArray &>(*col));
+    } else if (isArrowStringType(*col->type())) {
+      vtcs[c] = ValueTypeCode::STR;
+      columns[c] = stringColumnOf(arrowStrings(*col));
+    } else {
+      vtcs[c] = valueTypeCodeFor(*col->type());
+      columns[c] = arrowColumnValues(col, vtcs[c]);
+    }
+  }
+  std::vector<std::string> labels = arrowColumnNames(*batch->schema());
+  return DataObjectFactory::create<Frame>(static_cast<size_t>(batch->num_rows()), numCols, vtcs.data(),
+                                          labels.data(), columns.data(), encodings.data());
+}
+
+// ****************************************************************************
+// Export
+// ****************************************************************************
+
+// a buffer over the values of a frame column, which keeps them alive
+class SharedColumnBuffer : public arrow::Buffer {
+  std::shared_ptr<const void> owner;
+
+public:
+  SharedColumnBuffer(std::shared_ptr<const void> owner, const void *data, int64_t size)
+      : arrow::Buffer(static_cast<const uint8_t *>(data), size), owner(std::move(owner)) {}
+};
+
+template <typename VT> std::shared_ptr<arrow::Array> arrowArrayOfColumn(const Frame *arg, size_t idx) {
+  const DenseMatrix<VT> *colMat = arg->getColumn<VT>(idx);
+  std::shared_ptr<VT[]> values = colMat->getValuesSharedPtr();
+  DataObjectFactory::destroy(colMat);
+  const int64_t numRows = static_cast<int64_t>(arg->getNumRows());
+  auto buffer = std::make_shared<SharedColumnBuffer>(values, values.get(), numRows * sizeof(VT));
+  return arrow::MakeArray(arrow::ArrayData::Make(arrowTypeFor(ValueTypeUtils::codeFor<VT>), numRows,
+                                                 {nullptr, buffer}, 0));
+}
+
+inline void checkArrowCData(const arrow::Status &st, const char *what) {
+  if (!st.ok())
+    throw std::runtime_error("ArrowCData: cannot " + std::string(what) + ": " + st.ToString());
+}
+
+inline std::shared_ptr<arrow::Array> arrowStringArrayOf(const std::string *strings, size_t numStrings) {
+  arrow::StringBuilder builder;
+  checkArrowCData(builder.Reserve(numStrings), "allocate a string column");
+  for (size_t i = 0; i < numStrings; i++)
+    checkArrowCData(builder.Append(strings[i]), "build a string column");
+  std::shared_ptr<arrow::Array> res;
+  checkArrowCData(builder.Finish(&res), "build a string column");
+  return res;
+}
+
+template <typename VT> std::shared_ptr<arrow::Array> arrowDictionaryOf(const std::vector<VT> &values) {
+  if constexpr (std::is_same<VT, std::string>::value)
+    return arrowStringArrayOf(values.data(), values.size());
+  else {
+    // the dictionary is small, so it is copied rather than kept alive
+    auto buffer = arrow::AllocateBuffer(values.size() * sizeof(VT));
+    checkArrowCData(buffer.status(), "allocate a dictionary");
+    std::copy(values.begin(), values.end(), reinterpret_cast<VT *>((*buffer)->mutable_data()));
+    return arrow::MakeArray(arrow::ArrayData::Make(arrowTypeFor(ValueTypeUtils::codeFor<VT>),
+                                                   static_cast<int64_t>(values.size()),
+                                                   {nullptr, std::shared_ptr<arrow::Buffer>(std::move(*buffer))}, 0));
+  }
+}
+
+template <typename VT> std::shared_ptr<arrow::Array> arrowDictionaryArrayOf(const Frame *arg, size_t idx) {
+  const DictionaryColumn<VT> *col = arg->getDictionaryColumn<VT>(idx);
+  const size_t numRows = arg->getNumRows();
+  arrow::Int32Builder indices;
+  checkArrowCData(indices.Reserve(numRows), "allocate the indices of a dictionary column");
+  for (size_t r = 0; r < numRows; r++)
+    indices.UnsafeAppend(static_cast<int32_t>(col->getCode(r)));
+  std::shared_ptr<arrow::Array> indicesArr;
+  checkArrowCData(indices.Finish(&indicesArr), "build the indices of a dictionary column");
+  std::shared_ptr<arrow::Array> dictionary = arrowDictionaryOf(*col->getDictionary());
+  // the dictionary is sorted, so the order of the indices is the order of the values
+  auto res = arrow::DictionaryArray::FromArrays(arrow::dictionary(arrow::int32(), dictionary->type(), true),
+                                                indicesArr, dictionary);
+  checkArrowCData(res.status(), "build a dictionary column");
+  return *res;
+}
+
+inline std::shared_ptr<arrow::Array> arrowArrayOfColumn(const Frame *arg, size_t idx) {
+  const ValueTypeCode vtc = arg->getColumnType(idx);
+  if (arg->getColumnEncoding(idx) == ColumnEncoding::DICTIONARY) {
+    switch (vtc) {
+      case ValueTypeCode::SI8:  return arrowDictionaryArrayOf<int8_t>(arg, idx);
+      case ValueTypeCode::SI32: return arrowDictionaryArrayOf<int32_t>(arg, idx);
+      case ValueTypeCode::SI64: return arrowDictionaryArrayOf<int64_t>(arg, idx);
+      case ValueTypeCode::UI8:  return arrowDictionaryArrayOf<uint8_t>(arg, idx);
+      case ValueTypeCode::UI32: return arrowDictionaryArrayOf<uint32_t>(arg, idx);
+      case ValueTypeCode::UI64: return arrowDictionaryArrayOf<uint64_t>(arg, idx);
+      case ValueTypeCode::F32:  return arrowDictionaryArrayOf<float>(arg, idx);
+      case ValueTypeCode::F64:  return arrowDictionaryArrayOf<double>(arg, idx);
+      case ValueTypeCode::STR:  return arrowDictionaryArrayOf<std::string>(arg, idx);
+      default: break;
+    }
+  }
+  switch (vtc) {
+    case ValueTypeCode::SI8:  return arrowArrayOfColumn<int8_t>(arg, idx);
+    case ValueTypeCode::SI32: return arrowArrayOfColumn<int32_t>(arg, idx);
+    case ValueTypeCode::SI64: return arrowArrayOfColumn<int64_t>(arg, idx);
+    case ValueTypeCode::UI8:  return arrowArrayOfColumn<uint8_t>(arg, idx);
+    case ValueTypeCode::UI32: return arrowArrayOfColumn<uint32_t>(arg, idx);
+    case ValueTypeCode::UI64: return arrowArrayOfColumn<uint64_t>(arg, idx);
+    case ValueTypeCode::F32:  return arrowArrayOfColumn<float>(arg, idx);
+    case ValueTypeCode::F64:  return arrowArrayOfColumn<double>(arg, idx);
+    case ValueTypeCode::STR:
+      return arrowStringArrayOf(static_cast<const std::string *>(arg->getColumnRaw(idx)), arg->getNumRows());
+    default:
+      throw std::runtime_error("ArrowCData: unsupported value type of a frame column");
+  }
+}
+
+/**
+ * @brief Exports a frame as a record batch through Arrow's C data interface
+ * into the given structs, which the importer owns afterwards.
+ *
+ * The numeric columns are exported without copying them and stay alive until
+ * the importer releases the array. String columns are copied, and dictionary
+ * columns become dictionary arrays over the sorted values.
+ */
+inline void frameToArrowCData(const Frame *arg, struct ArrowArray *array, struct ArrowSchema *schema) {
+  const std::string *labels = arg->getLabels();
+  arrow::FieldVector fields;
+  std::vector<std::shared_ptr<arrow::Array>> cols;
+  for (size_t c = 0; c < arg->getNumCols(); c++) {
+    cols.push_back(arrowArrayOfColumn(arg, c));
+    fields.push_back(arrow::field(labels[c], cols.back()->type(), false));
+  }
+  auto batch = arrow::RecordBatch::Make(arrow::schema(fields), static_cast<int64_t>(arg->getNumRows()), cols);
+  checkArrowCData(arrow::ExportRecordBatch(*batch, array, schema), "export the record batch");
+}
+
+#endif
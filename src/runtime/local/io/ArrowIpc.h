@@ -0,0 +1,465 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifdef USE_ARROW
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <runtime/local/io/ReadParquet.h>
+#include <runtime/local/io/utils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+
+// ****************************************************************************
+// Value types
+// ****************************************************************************
+
+inline std::shared_ptr<arrow::DataType> arrowTypeFor(ValueTypeCode vtc) {
+  switch (vtc) {
+    case ValueTypeCode::SI8:  return arrow::int8();
+    case ValueTypeCode::SI32: return arrow::int32();
+    case ValueTypeCode::SI64: return arrow::int64();
+    case ValueTypeCode::UI8:  return arrow::uint8();
+    case ValueTypeCode::UI32: return arrow::uint32();
+    case ValueTypeCode::UI64: return arrow::uint64();
+    case ValueTypeCode::F32:  return arrow::float32();
+    case ValueTypeCode::F64:  return arrow::float64();
+    default:
+      throw std::runtime_error("ArrowIpc: unsupported value type");
+  }
+}
+
+// the value type of a column of the given Arrow type, narrower integers are widened
+inline ValueTypeCode valueTypeCodeFor(const arrow::DataType &type) {
+  switch (type.id()) {
+    case arrow::Type::INT8:   return ValueTypeCode::SI8;
+    case arrow::Type::INT16:
+    case arrow::Type::INT32:  return ValueTypeCode::SI32;
+    case arrow::Type::INT64:  return ValueTypeCode::SI64;
+    case arrow::Type::BOOL:
+    case arrow::Type::UINT8:  return ValueTypeCode::UI8;
+    case arrow::Type::UINT16:
+    case arrow::Type::UINT32: return ValueTypeCode::UI32;
+    case arrow::Type::UINT64: return ValueTypeCode::UI64;
+    case arrow::Type::FLOAT:  return ValueTypeCode::F32;
+    case arrow::Type::DOUBLE: return ValueTypeCode::F64;
+    default:
+      throw std::runtime_error("ArrowIpc: unsupported column type " + type.ToString());
+  }
+}
+
+// ****************************************************************************
+// Conversion of record batches
+// ****************************************************************************
+
+/**
+ * @brief Converts the columns of a record batch or table to a frame, whose
+ * columns adopt the Arrow buffers (e.g., a memory-mapped file) if possible,
+ * see `arrowToColumnMatrix`.
+ *
+ * @param schema The value types of the columns, or `nullptr` for those of the
+ * Arrow columns.
+ */
+inline Frame *arrowToFrame(const std::vector<std::shared_ptr<arrow::ChunkedArray>> &cols,
+                           const std::vector<std::string> &names, const ValueTypeCode *schema, bool zeroCopy) {
+  std::vector<Structure *> colMats;
+  Frame *res = nullptr;
+  try {
+    for (size_t c = 0; c < cols.size(); c++)
+      colMats.push_back(arrowToColumnMatrix(cols[c], schema ? schema[c] : valueTypeCodeFor(*cols[c]->type()),
+                                            zeroCopy));
+    res = DataObjectFactory::create<Frame>(colMats, names.data());
+  } catch (...) {
+    for (Structure *colMat : colMats)
+      DataObjectFactory::destroy(colMat);
+    throw;
+  }
+  // the frame shares the values of the column matrices
+  for (Structure *colMat : colMats)
+    DataObjectFactory::destroy(colMat);
+  return res;
+}
+
+/**
+ * @brief Converts the columns of a record batch or table to a dense matrix.
+ *
+ * A matrix written by `ArrowIpcWriter` is a single column of fixed-size
+ * lists, one per row, whose child values are the row-major values of the
+ * matrix. The result adopts them without copying if they are a single array
+ * of `VT` without nulls. Otherwise, the columns become the columns of the
+ * matrix, copied in parallel.
+ */
+template <typename VT>
+DenseMatrix<VT> *arrowToDenseMatrix(const std::vector<std::shared_ptr<arrow::ChunkedArray>> &cols, bool zeroCopy,
+                                    DCTX(ctx) = nullptr) {
+  using ArrowT = typename arrow::CTypeTraits<VT>::ArrowType;
+  if (cols.size() == 1 && cols[0]->type()->id() == arrow::Type::FIXED_SIZE_LIST) {
+    const auto &listType = static_cast<const arrow::FixedSizeListType &>(*cols[0]->type());
+    const size_t numRows = static_cast<size_t>(cols[0]->length());
+    const size_t numCols = static_cast<size_t>(listType.list_size());
+    if (zeroCopy && cols[0]->num_chunks() == 1 && cols[0]->null_count() == 0
+        && listType.value_type()->id() == ArrowT::type_id) {
+      auto list = std::static_pointer_cast<arrow::FixedSizeListArray>(cols[0]->chunk(0));
+      auto child = std::static_pointer_cast<arrow::NumericArray<ArrowT>>(list->values());
+      VT *vals = const_cast<VT *>(child->raw_values());
+      if (child->null_count() == 0 && vals && reinterpret_cast<uintptr_t>(vals) % alignof(VT) == 0) {
+        // the values keep the Arrow array (and its buffers) alive
+        std::shared_ptr<VT[]> values(child, vals + list->value_offset(0));
+        return DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, values);
+      }
+    }
+    auto *res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    size_t row = 0;
+    for (const std::shared_ptr<arrow::Array> &chunk : cols[0]->chunks()) {
+      auto list = std::static_pointer_cast<arrow::FixedSizeListArray>(chunk);
+      auto values = std::make_shared<arrow::ChunkedArray>(list->Flatten().ValueOrDie());
+      copyArrowColumn(*values, res->getValues() + row * numCols, 1);
+      row += list->length();
+    }
+    return res;
+  }
+
+  const size_t numRows = cols.empty() ? 0 : static_cast<size_t>(cols[0]->length());
+  auto *res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, cols.size(), false);
+  VT *valuesRes = res->getValues();
+  const size_t rowSkip = res->getRowSkip();
+  WorkerPool::parallelFor(ctx, cols.size(), [&](size_t c) {
+    copyArrowColumn(*cols[c], valuesRes + c, rowSkip);
+  });
+  return res;
+}
+
+inline std::vector<std::shared_ptr<arrow::ChunkedArray>> arrowColumns(const arrow::RecordBatch &batch) {
+  std::vector<std::shared_ptr<arrow::ChunkedArray>> cols;
+  for (int c = 0; c < batch.num_columns(); c++)
+    cols.push_back(std::make_shared<arrow::ChunkedArray>(batch.column(c)));
+  return cols;
+}
+
+inline std::vector<std::string> arrowColumnNames(const arrow::Schema &schema) {
+  std::vector<std::string> names;
+  for (int c = 0; c < schema.num_fields(); c++)
+    names.push_back(schema.field(c)->name());
+  return names;
+}
+
+// wraps the values without copying them, they must outlive the array
+inline std::shared_ptr<arrow::Array> arrowArrayOf(const void *values, size_t numValues, ValueTypeCode vtc) {
+  auto buffer = std::make_shared<arrow::Buffer>(static_cast<const uint8_t *>(values),
+                                                numValues * ValueTypeUtils::sizeOf(vtc));
+  return arrow::MakeArray(arrow::ArrayData::Make(arrowTypeFor(vtc), numValues, {nullptr, buffer}, 0));
+}
+
+// ****************************************************************************
+// Reading
+// ****************************************************************************
+
+/**
+ * @brief An Arrow IPC file (Feather v2) or stream, memory-mapped and read one
+ * record batch after the other, such that the columns of a batch are the
+ * mapped buffers of the file.
+ *
+ * A file in a shared-memory file system (e.g., `/dev/shm`) thus hands the data
+ * over between processes without any copy.
+ */
+class ArrowIpcReader {
+  std::shared_ptr<arrow::io::MemoryMappedFile> file;
+  // the random access reader of the file format, or the reader of the stream format
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> fileReader;
+  std::shared_ptr<arrow::ipc::RecordBatchStreamReader> streamReader;
+  int nextBatch = 0;
+
+  void check(const arrow::Status &st, const char *what) const {
+    if (!st.ok())
+      throw std::runtime_error("ArrowIpc: cannot " + std::string(what) + " of file " + filename + ": "
+          + st.ToString());
+  }
+
+public:
+  const std::string filename;
+
+  explicit ArrowIpcReader(const char *filename) : filename(filename) {
+    auto mapped = arrow::io::MemoryMappedFile::Open(filename, arrow::io::FileMode::READ);
+    check(mapped.status(), "map the data");
+    file = *mapped;
+    // the file format starts with its magic number, the stream format with a message
+    auto magic = file->ReadAt(0, 6);
+    check(magic.status(), "read the header");
+    if ((*magic)->ToString() == "ARROW1") {
+      auto reader = arrow::ipc::RecordBatchFileReader::Open(file);
+      check(reader.status(), "read the footer");
+      fileReader = *reader;
+    } else {
+      auto reader = arrow::ipc::RecordBatchStreamReader::Open(file);
+      check(reader.status(), "read the schema");
+      streamReader = *reader;
+    }
+  }
+
+  std::shared_ptr<arrow::Schema> getSchema() const {
+    return fileReader ? fileReader->schema() : streamReader->schema();
+  }
+
+  /**
+   * @brief Returns the next record batch, or `nullptr` after the last one.
+   */
+  std::shared_ptr<arrow::RecordBatch> readNext() {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    if (fileReader) {
+      if (nextBatch < fileReader->num_record_batches()) {
+        auto res = fileReader->ReadRecordBatch(nextBatch++);
+        check(res.status(), "read a record batch");
+        batch = *res;
+      }
+    } else
+      check(streamReader->ReadNext(&batch), "read a record batch");
+    return batch;
+  }
+
+  /**
+   * @brief Returns the columns of all remaining record batches, which are one
+   * chunk per batch.
+   */
+  std::vector<std::shared_ptr<arrow::ChunkedArray>> readAll() {
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+    while (auto batch = readNext())
+      batches.push_back(batch);
+    std::shared_ptr<arrow::Schema> schema = getSchema();
+    std::vector<std::shared_ptr<arrow::ChunkedArray>> cols;
+    for (int c = 0; c < schema->num_fields(); c++) {
+      arrow::ArrayVector chunks;
+      for (auto &batch : batches)
+        chunks.push_back(batch->column(c));
+      cols.push_back(std::make_shared<arrow::ChunkedArray>(chunks, schema->field(c)->type()));
+    }
+    return cols;
+  }
+};
+
+// ****************************************************************************
+// Writing
+// ****************************************************************************
+
+struct ArrowIpcWriteOptions {
+  // the IPC stream format instead of the file format (Feather v2)
+  bool stream = false;
+  // the rows per record batch, zero for a single batch
+  size_t rowsPerBatch = 0;
+};
+
+/**
+ * @brief Writes frames or dense matrices of the same schema as record batches
+ * to an Arrow IPC file or stream, whose buffers are the columns of the frames
+ * or the values of the matrices, i.e., they are not copied before they are
+ * written.
+ */
+class ArrowIpcWriter {
+  std::shared_ptr<arrow::io::FileOutputStream> out;
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  std::shared_ptr<arrow::Schema> schema;
+  const ArrowIpcWriteOptions opts;
+
+  void check(const arrow::Status &st, const char *what) const {
+    if (!st.ok())
+      throw std::runtime_error("ArrowIpc: cannot " + std::string(what) + " of file " + filename + ": "
+          + st.ToString());
+  }
+
+  void write(const std::shared_ptr<arrow::Schema> &batchSchema, int64_t numRows,
+             const std::vector<std::shared_ptr<arrow::Array>> &cols) {
+    if (!writer) {
+      schema = batchSchema;
+      auto w = opts.stream ? arrow::ipc::MakeStreamWriter(out, schema) : arrow::ipc::MakeFileWriter(out, schema);
+      check(w.status(), "write the schema");
+      writer = *w;
+    } else if (!schema->Equals(*batchSchema))
+      throw std::runtime_error("ArrowIpc: all record batches of file " + filename + " must have the same schema");
+    auto batch = arrow::RecordBatch::Make(schema, numRows, cols);
+    const int64_t rowsPerBatch = static_cast<int64_t>(opts.rowsPerBatch);
+    if (rowsPerBatch == 0 || rowsPerBatch >= numRows)
+      check(writer->WriteRecordBatch(*batch), "write a record batch");
+    else
+      for (int64_t r = 0; r < numRows; r += rowsPerBatch)
+        check(writer->WriteRecordBatch(*batch->Slice(r, rowsPerBatch)), "write a record batch");
+  }
+
+public:
+  const std::string filename;
+
+  ArrowIpcWriter(const char *filename, const ArrowIpcWriteOptions &opts = ArrowIpcWriteOptions())
+      : opts(opts), filename(filename) {
+    auto o = arrow::io::FileOutputStream::Open(filename);
+    check(o.status(), "open");
+    out = *o;
+  }
+
+  ArrowIpcWriter(const ArrowIpcWriter &) = delete;
+  ArrowIpcWriter &operator=(const ArrowIpcWriter &) = delete;
+
+  ~ArrowIpcWriter() {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+
+  void write(const Frame *arg) {
+    const ValueTypeCode *vtcs = arg->getSchema();
+    const std::string *labels = arg->getLabels();
+    arrow::FieldVector fields;
+    std::vector<std::shared_ptr<arrow::Array>> cols;
+    for (size_t c = 0; c < arg->getNumCols(); c++) {
+      fields.push_back(arrow::field(labels[c], arrowTypeFor(vtcs[c]), false));
+      cols.push_back(arrowArrayOf(arg->getColumnRaw(c), arg->getNumRows(), vtcs[c]));
+    }
+    write(arrow::schema(fields), arg->getNumRows(), cols);
+  }
+
+  template <typename VT> void write(const DenseMatrix<VT> *arg) {
+    const ValueTypeCode vtc = ValueTypeUtils::codeFor<VT>;
+    const size_t numRows = arg->getNumRows();
+    const size_t numCols = arg->getNumCols();
+    // the rows of a view are gathered
+    std::shared_ptr<DenseMatrix<VT>> gathered;
+    const VT *values = arg->getValues();
+    if (arg->getRowSkip() != numCols && numRows > 1) {
+      gathered = std::shared_ptr<DenseMatrix<VT>>(DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false),
+                                                  [](DenseMatrix<VT> *m) { DataObjectFactory::destroy(m); });
+      for (size_t r = 0; r < numRows; r++)
+        memcpy(gathered->getValues() + r * numCols, values + r * arg->getRowSkip(), numCols * sizeof(VT));
+      values = gathered->getValues();
+    }
+    auto listType = arrow::fixed_size_list(arrow::field("item", arrowTypeFor(vtc), false), numCols);
+    auto child = arrowArrayOf(values, numRows * numCols, vtc);
+    auto list = arrow::MakeArray(arrow::ArrayData::Make(listType, numRows, {nullptr}, {child->data()}, 0));
+    write(arrow::schema({arrow::field("matrix", listType, false)}), numRows, {list});
+  }
+
+  // writes the footer of the file format or the end of the stream
+  void close() {
+    if (writer) {
+      check(writer->Close(), "write the footer");
+      writer.reset();
+    }
+    if (out && !out->closed())
+      check(out->Close(), "close");
+  }
+};
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template <class DTRes> struct ReadArrowIpc {
+  static void apply(DTRes *&res, const char *filename, const ValueTypeCode *schema, const std::string *labels,
+                    DCTX(ctx)) = delete;
+};
+
+template <class DTArg> struct WriteArrowIpc {
+  static void apply(const DTArg *arg, const char *filename, const ArrowIpcWriteOptions &opts) = delete;
+};
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Reads all record batches of an Arrow IPC file or stream, a single
+ * batch without copying the mapped columns.
+ *
+ * @param schema The value types of the frame columns, or `nullptr` for those
+ * of the file; ignored for matrices.
+ * @param labels The labels of the frame columns, or `nullptr` for the names of
+ * the fields of the file.
+ */
+template <class DTRes>
+void readArrowIpc(DTRes *&res, const char *filename, const ValueTypeCode *schema = nullptr,
+                  const std::string *labels = nullptr, DCTX(ctx) = nullptr) {
+  ReadArrowIpc<DTRes>::apply(res, filename, schema, labels, ctx);
+}
+
+template <class DTArg>
+void writeArrowIpc(const DTArg *arg, const char *filename, const ArrowIpcWriteOptions &opts = ArrowIpcWriteOptions()) {
+  WriteArrowIpc<DTArg>::apply(arg, filename, opts);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
+
+template <> struct ReadArrowIpc<Frame> {
+  static void apply(Frame *&res, const char *filename, const ValueTypeCode *schema, const std::string *labels,
+                    DCTX(ctx)) {
+    ArrowIpcReader reader(filename);
+    std::vector<std::string> names = arrowColumnNames(*reader.getSchema());
+    if (labels)
+      std::copy(labels, labels + names.size(), names.begin());
+    res = arrowToFrame(reader.readAll(), names, schema, true);
+  }
+};
+
+template <> struct WriteArrowIpc<Frame> {
+  static void apply(const Frame *arg, const char *filename, const ArrowIpcWriteOptions &opts) {
+    ArrowIpcWriter writer(filename, opts);
+    writer.write(arg);
+    writer.close();
+  }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix
+// ----------------------------------------------------------------------------
+
+template <typename VT> struct ReadArrowIpc<DenseMatrix<VT>> {
+  static void apply(DenseMatrix<VT> *&res, const char *filename, const ValueTypeCode *schema,
+                    const std::string *labels, DCTX(ctx)) {
+    ArrowIpcReader reader(filename);
+    res = arrowToDenseMatrix<VT>(reader.readAll(), true, ctx);
+  }
+};
+
+template <typename VT> struct WriteArrowIpc<DenseMatrix<VT>> {
+  static void apply(const DenseMatrix<VT> *arg, const char *filename, const ArrowIpcWriteOptions &opts) {
+    ArrowIpcWriter writer(filename, opts);
+    writer.write(arg);
+    writer.close();
+  }
+};
+
+#endif
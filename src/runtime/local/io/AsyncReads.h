@@ -0,0 +1,157 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/IContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Structure.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/**
+ * @brief The data type of the result of a prefetched read, see `prefetchRead`.
+ */
+enum class AsyncReadDataType : int64_t {
+    DenseMatrix = 0,
+    CSRMatrix = 1,
+    Frame = 2,
+};
+
+/**
+ * @brief The reads of files started ahead of their use by `prefetchRead`,
+ * which run on a few I/O threads of their own, while the script computes.
+ *
+ * A read kernel looking for a file of the same data and value type takes the
+ * data object of the oldest of these reads, waiting only if it has not
+ * finished yet. The data objects that are never taken are destroyed with the
+ * context.
+ */
+class AsyncReads : public IContext {
+public:
+    using Key = std::tuple<std::string, AsyncReadDataType, int64_t>;
+
+    // the reads running at the same time, each of which is parallel itself
+    static constexpr size_t NUM_THREADS = 2;
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> queue;
+    std::multimap<Key, std::shared_future<Structure *>> pending;
+    std::vector<std::thread> threads;
+    bool stopped = false;
+
+    void work() {
+        while(true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this]() { return stopped || !queue.empty(); });
+                if(queue.empty())
+                    return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            job();
+        }
+    }
+
+public:
+    AsyncReads() {
+        for(size_t i = 0; i < NUM_THREADS; i++)
+            threads.emplace_back(&AsyncReads::work, this);
+    }
+
+    ~AsyncReads() override {
+        destroy();
+    }
+
+    static AsyncReads * get(DaphneContext * ctx) {
+        return ctx ? static_cast<AsyncReads *>(ctx->async_reads.get()) : nullptr;
+    }
+
+    static AsyncReads * getOrCreate(DaphneContext * ctx) {
+        if(!ctx->async_reads)
+            ctx->async_reads = std::make_unique<AsyncReads>();
+        return get(ctx);
+    }
+
+    /**
+     * @brief Starts `read()` on an I/O thread, whose result `take(key)` returns.
+     */
+    void submit(const Key & key, std::function<Structure *()> read) {
+        auto task = std::make_shared<std::packaged_task<Structure *()>>(std::move(read));
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.emplace(key, task->get_future().share());
+        queue.emplace_back([task]() { (*task)(); });
+        cv.notify_one();
+    }
+
+    /**
+     * @brief Returns the data object of the oldest read of the given key, or
+     * `nullptr` if there is none, rethrowing the exception of a failed read.
+     */
+    Structure * take(const Key & key) {
+        std::shared_future<Structure *> result;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = pending.find(key);
+            if(it == pending.end())
+                return nullptr;
+            result = it->second;
+            pending.erase(it);
+        }
+        return result.get();
+    }
+
+    void destroy() override {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if(stopped)
+                return;
+            stopped = true;
+            // reads not started yet are dropped
+            queue.clear();
+            cv.notify_all();
+        }
+        for(auto & t : threads)
+            t.join();
+        for(auto & p : pending)
+            try {
+                if(p.second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                    if(Structure * obj = p.second.get())
+                        DataObjectFactory::destroy(obj);
+            } catch(...) {
+                // nobody waits for the failed read
+            }
+        pending.clear();
+    }
+};
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+
+#include <sys/types.h>
+
+/**
+ * @brief The statistics of a column of a file, by which the compiler
+ * estimates the selectivities of filters and the sizes of joins.
+ *
+ * The statistics are approximate: the number of distinct values is estimated
+ * by a HyperLogLog sketch and the histogram by a KLL sketch of the column
+ * (see `collectColumnStatistics`), and they are kept in the meta data file
+ * of the file (see `MetaDataParser`). The missing values are the NaNs of
+ * floating-point columns, the other statistics are of the other values. The
+ * range and the histogram are unknown for string columns.
+ */
+struct ColumnStatistics {
+    // the number of buckets of the histograms collected
+    static constexpr size_t NUM_BUCKETS = 32;
+
+    // the number of distinct values, -1 if unknown
+    ssize_t numDistinct = -1;
+    // the minimum and the maximum, NaN if unknown
+    double min = std::numeric_limits<double>::quiet_NaN();
+    double max = std::numeric_limits<double>::quiet_NaN();
+    // the fraction of missing values, NaN if unknown
+    double nullFraction = std::numeric_limits<double>::quiet_NaN();
+    // the inner bounds of an equi-depth histogram, i.e., the values between
+    // its buckets of the same number of values, from `min` to `max`
+    std::vector<double> histogram;
+
+    bool hasRange() const {
+        return !std::isnan(min) && !std::isnan(max);
+    }
+
+    /**
+     * @brief Returns the estimated fraction of the rows whose value is less
+     * than (or equal to, if `inclusive`) `v`, if the range is known.
+     *
+     * The values are assumed to be spread uniformly within the buckets of
+     * the histogram, or the range without one.
+     */
+    std::optional<double> fractionBelow(double v, bool inclusive) const {
+        if(!hasRange() || std::isnan(v))
+            return std::nullopt;
+        std::vector<double> bounds = {min};
+        bounds.insert(bounds.end(), histogram.begin(), histogram.end());
+        bounds.push_back(max);
+        const size_t numBuckets = bounds.size() - 1;
+        double numBelow = 0;
+        for(size_t b = 0; b < numBuckets; b++) {
+            const double lo = bounds[b];
+            const double hi = bounds[b + 1];
+            if(hi < v)
+                numBelow += 1;
+            else if(lo == v && hi == v)
+                numBelow += inclusive;
+            else if(lo <= v && v <= hi)
+                numBelow += (v - lo) / (hi - lo);
+        }
+        return numBelow / numBuckets * nonNullFraction();
+    }
+
+    /**
+     * @brief Returns the estimated fraction of the rows whose value equals
+     * `v`, if the number of distinct values is known.
+     *
+     * The values are assumed to occur equally often, unless whole buckets of
+     * the histogram consist of `v`.
+     */
+    std::optional<double> fractionEqual(double v) const {
+        if(hasRange() && (v < min || v > max))
+            return 0.0;
+        if(numDistinct <= 0)
+            return std::nullopt;
+        double res = 1.0 / numDistinct;
+        if(hasRange() && !histogram.empty()) {
+            std::vector<double> bounds = {min};
+            bounds.insert(bounds.end(), histogram.begin(), histogram.end());
+            bounds.push_back(max);
+            size_t numBuckets = 0;
+            for(size_t b = 0; b + 1 < bounds.size(); b++)
+                numBuckets += bounds[b] == v && bounds[b + 1] == v;
+            res = std::max(res, static_cast<double>(numBuckets) / (bounds.size() - 1));
+        }
+        return res * nonNullFraction();
+    }
+
+    double nonNullFraction() const {
+        return std::isnan(nullFraction) ? 1.0 : 1.0 - nullFraction;
+    }
+
+    /**
+     * @brief Returns the estimated number of rows of an equi-join of inputs
+     * of the given numbers of rows on columns of the given statistics, if the
+     * numbers of distinct values are known.
+     *
+     * Each value of the column with fewer distinct values is assumed to occur
+     * in the other column, too (e.g., a foreign key referencing a key).
+     */
+    static std::optional<double> joinSize(double numRowsLhs, const ColumnStatistics & lhs, double numRowsRhs,
+            const ColumnStatistics & rhs) {
+        if(lhs.numDistinct <= 0 || rhs.numDistinct <= 0)
+            return std::nullopt;
+        return numRowsLhs * lhs.nonNullFraction() * numRowsRhs * rhs.nonNullFraction()
+                / std::max(lhs.numDistinct, rhs.numDistinct);
+    }
+};
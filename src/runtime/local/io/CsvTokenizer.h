@@ -0,0 +1,179 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/vectorized/CpuDispatch.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// ****************************************************************************
+// Vectorized scanning of CSV lines
+// ****************************************************************************
+
+// The scans compare 32 (AVX2) or 16 (SSE2, NEON) bytes at a time and extract
+// the matches as a bitmask, which is what makes the tokenizing run at several
+// GB/s. x86-64 always has SSE2, AVX2 is used if the CPU supports it (see
+// CpuDispatch).
+
+// the scans of 16 bytes at a time, and of the remaining bytes one at a time
+inline const char *csvFind2Baseline(const char *p, const char *end, char a, char b) {
+#if defined(__SSE2__)
+    const __m128i va16 = _mm_set1_epi8(a);
+    const __m128i vb16 = _mm_set1_epi8(b);
+    for(; p + 16 <= end; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, va16), _mm_cmpeq_epi8(chunk, vb16))));
+        if(mask)
+            return p + __builtin_ctz(mask);
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t va16 = vdupq_n_u8(static_cast<uint8_t>(a));
+    const uint8x16_t vb16 = vdupq_n_u8(static_cast<uint8_t>(b));
+    for(; p + 16 <= end; p += 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t eq = vorrq_u8(vceqq_u8(chunk, va16), vceqq_u8(chunk, vb16));
+        // narrow the 16 byte masks to 16 nibbles
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if(mask)
+            return p + (__builtin_ctzll(mask) >> 2);
+    }
+#endif
+    for(; p < end; p++)
+        if(*p == a || *p == b)
+            return p;
+    return end;
+}
+
+inline uint64_t csvCountBaseline(const char *p, const char *end, char c) {
+    uint64_t count = 0;
+#if defined(__SSE2__)
+    const __m128i vc16 = _mm_set1_epi8(c);
+    for(; p + 16 <= end; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        count += __builtin_popcount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, vc16))));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t vc16 = vdupq_n_u8(static_cast<uint8_t>(c));
+    for(; p + 16 <= end; p += 16) {
+        const uint8x16_t eq = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(p)), vc16);
+        count += vaddvq_u8(vandq_u8(eq, vdupq_n_u8(1)));
+    }
+#endif
+    for(; p < end; p++)
+        count += *p == c;
+    return count;
+}
+
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+DAPHNE_TARGET_AVX2 inline const char *csvFind2Avx2(const char *p, const char *end, char a, char b) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    for(; p + 32 <= end; p += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, va), _mm256_cmpeq_epi8(chunk, vb))));
+        if(mask)
+            return p + __builtin_ctz(mask);
+    }
+    return csvFind2Baseline(p, end, a, b);
+}
+
+DAPHNE_TARGET_AVX2 inline uint64_t csvCountAvx2(const char *p, const char *end, char c) {
+    uint64_t count = 0;
+    const __m256i vc = _mm256_set1_epi8(c);
+    for(; p + 32 <= end; p += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        count += __builtin_popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, vc))));
+    }
+    return count + csvCountBaseline(p, end, c);
+}
+#endif
+
+/**
+ * @brief Returns the instruction set of the scans, AVX2 or the baseline.
+ */
+inline CpuIsa csvScanIsa() {
+    static std::atomic<uint32_t> recorded{0};
+    const CpuIsa isa = CpuDispatch::includes(CpuDispatch::getIsa(), CpuIsa::AVX2) ? CpuIsa::AVX2 : CpuIsa::GENERIC;
+    CpuDispatch::record(recorded, "readCsv", isa);
+    return isa;
+}
+
+/**
+ * @brief Returns the first occurrence of a or b in [p, end), or end.
+ */
+inline const char *csvFind2(const char *p, const char *end, char a, char b) {
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+    if(csvScanIsa() == CpuIsa::AVX2)
+        return csvFind2Avx2(p, end, a, b);
+#endif
+    return csvFind2Baseline(p, end, a, b);
+}
+
+/**
+ * @brief Returns the number of occurrences of c in [p, end).
+ */
+inline uint64_t csvCount(const char *p, const char *end, char c) {
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+    if(csvScanIsa() == CpuIsa::AVX2)
+        return csvCountAvx2(p, end, c);
+#endif
+    return csvCountBaseline(p, end, c);
+}
+
+/**
+ * @brief Returns the field at pos of the line [pos, lineEnd) without the
+ * enclosing quotes (if any) and a trailing '\r', and advances pos beyond the
+ * delimiter after the field.
+ *
+ * Delimiters inside a quoted field do not end the field. Doubled quotes inside
+ * a quoted field are kept as they are, since numbers do not contain quotes.
+ */
+inline void csvNextField(const char *&pos, const char *lineEnd, char delim, const char *&fieldBegin,
+        const char *&fieldEnd) {
+    const char *p = pos;
+    if(p < lineEnd && *p == '"') {
+        fieldBegin = ++p;
+        // the closing quote, skipping doubled quotes
+        for(;;) {
+            p = csvFind2(p, lineEnd, '"', '"');
+            if(p + 1 < lineEnd && p[1] == '"')
+                p += 2;
+            else
+                break;
+        }
+        fieldEnd = p;
+        p = csvFind2(p, lineEnd, delim, delim);
+    }
+    else {
+        fieldBegin = p;
+        p = csvFind2(p, lineEnd, delim, delim);
+        fieldEnd = p;
+        if(fieldEnd > fieldBegin && fieldEnd == lineEnd && fieldEnd[-1] == '\r')
+            fieldEnd--;
+    }
+    pos = p < lineEnd ? p + 1 : lineEnd;
+}
@@ -17,8 +17,22 @@
 #ifndef SRC_RUNTIME_LOCAL_IO_DAPHNEFILE_H
 #define SRC_RUNTIME_LOCAL_IO_DAPHNEFILE_H
 
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
 #include <cstdint>
+#include <cstring>
 
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+struct DaphneContext;
 
 struct DF_header {
 	uint8_t version;
@@ -40,6 +54,186 @@ struct DF_body_block {
 	uint8_t bt;
 };
 
-enum DF_body_t {empty = 0, dense = 1, sparse = 2, ultra_sparse = 3};
+// csr: the row offsets, column indexes and values of a CSR matrix as arrays
+enum DF_body_t {empty = 0, dense = 1, sparse = 2, ultra_sparse = 3, csr = 4};
+
+// Since version 2, the value arrays of dense blocks and the arrays of csr
+// blocks start at file offsets that are multiples of DF_body_alignment (padded
+// with zeros), such that a mapping of the file can be used without copying.
+const uint8_t DF_version = 2;
+const uint64_t DF_body_alignment = 64;
+
+inline uint64_t DF_align(uint64_t offset) {
+	return (offset + DF_body_alignment - 1) / DF_body_alignment * DF_body_alignment;
+}
+
+// Since version 3, a dense matrix can be stored as blocks of consecutive rows
+// instead of a single body. The header and the value type are followed by a
+// DF_block_index and its DF_block_entry's, and each block starts at an offset
+// that is a multiple of DF_body_alignment. A block holds its rows in row-major
+// order, compressed as given by the index.
+const uint8_t DF_version_blocks = 3;
+
+enum class DF_compression_t : uint8_t {none = 0, zlib = 1, lz4 = 2};
+
+inline DF_compression_t DF_compressionFromString(const std::string & compression) {
+	if (compression == "none")
+		return DF_compression_t::none;
+	if (compression == "zlib")
+		return DF_compression_t::zlib;
+	if (compression == "lz4")
+		return DF_compression_t::lz4;
+	throw std::runtime_error("unknown compression of Daphne binary files: " + compression);
+}
+
+struct DF_block_index {
+	uint64_t nbblocks;
+	uint64_t rowsPerBlock;
+	DF_compression_t compression;
+};
+
+struct DF_block_entry {
+	uint64_t offset; // of the block in the file
+	uint64_t nbytes; // of the block in the file, i.e., after the compression
+	uint64_t rx; // first row
+	uint64_t nbrows;
+	uint32_t checksum; // CRC-32 of the block in the file
+	// the minimum and maximum value of the block, the bytes of the value type
+	uint64_t min;
+	uint64_t max;
+};
+
+// Since version 4, a frame is stored column by column. The header is followed
+// by the value type of each column, the label of each column (its length as a
+// uint16_t and its bytes), and a DF_frame_column per column. The arrays of the
+// columns start at offsets that are multiples of DF_body_alignment.
+const uint8_t DF_version_frame = 4;
+
+// plain: the values of a column of a fixed-width value type
+// strings: the end offset of each string in the bytes (as uint64_t, preceded
+// by a zero) and the bytes of all strings
+// dictionary: a code per row (uint32_t) and the sorted distinct strings, like
+// a strings column
+enum class DF_column_t : uint8_t {plain = 0, strings = 1, dictionary = 2};
+
+struct DF_frame_column {
+	DF_column_t ct;
+	uint64_t offset; // of the first array of the column in the file
+	uint64_t nbytes; // of the bytes of the strings (strings and dictionary)
+	uint64_t dictsize; // the number of distinct strings (dictionary)
+};
+
+// string columns with at most this fraction of distinct values are stored
+// with a dictionary
+const double DF_dictionary_max_distinct = 0.5;
+
+// the positions of the arrays of a column of a frame (codes and offsets only
+// for the column types having them) and the end of its last array
+struct DF_column_layout {
+	uint64_t codes;
+	uint64_t offsets;
+	uint64_t values; // the values of a plain column, the bytes of the strings otherwise
+	uint64_t end;
+};
+
+inline DF_column_layout DF_layoutColumn(const DF_frame_column & col, uint64_t nbrows, uint64_t valueSize) {
+	DF_column_layout l = {};
+	switch (col.ct) {
+		case DF_column_t::plain:
+			l.values = col.offset;
+			l.end = l.values + nbrows * valueSize;
+			break;
+		case DF_column_t::strings:
+			l.offsets = col.offset;
+			l.values = DF_align(l.offsets + (nbrows + 1) * sizeof(uint64_t));
+			l.end = l.values + col.nbytes;
+			break;
+		case DF_column_t::dictionary:
+			l.codes = col.offset;
+			l.offsets = DF_align(l.codes + nbrows * sizeof(uint32_t));
+			l.values = DF_align(l.offsets + (col.dictsize + 1) * sizeof(uint64_t));
+			l.end = l.values + col.nbytes;
+			break;
+		default:
+			throw std::runtime_error("unknown column type in a Daphne binary file");
+	}
+	return l;
+}
+
+// The indexes on the key columns of a frame (see KeyIndex) can be stored in a
+// file next to the frame's file, named like it with DF_key_indexes_suffix
+// appended. It starts with a DF_key_indexes_header and, per index, the number
+// of key columns, their positions and the number of keys. These are followed
+// by the arrays of the indexes, per index the begin of the rows of each key in
+// the rows and their end, and the rows grouped by key (all as uint64_t). The
+// indexes are dropped if the frame's file does not have the recorded size.
+const char * const DF_key_indexes_suffix = ".idx";
+const uint64_t DF_key_indexes_magic = 0x3158444946485044; // "DPHFIDX1"
+
+struct DF_key_indexes_header {
+	uint64_t magic;
+	uint64_t nbrows;
+	uint64_t nbindexes;
+	uint64_t framebytes; // the size of the frame's file
+};
+
+// the size of the uncompressed blocks unless the number of rows is given
+const uint64_t DF_default_block_bytes = uint64_t(1) << 20;
+
+/**
+ * @brief Options for writing and reading Daphne binary files.
+ */
+struct DF_options {
+	// rows per block of a dense matrix, zero for a single uncompressed body
+	// (version 2), unless the blocks are compressed
+	uint64_t rowsPerBlock = 0;
+	DF_compression_t compression = DF_compression_t::none;
+	// the context on whose workers blocks are (de)compressed and transferred,
+	// sequentially if none
+	DaphneContext * ctx = nullptr;
+	// whether the indexes of a frame are written next to its file, see
+	// DF_key_indexes_header
+	bool keyIndexes = false;
+};
+
+template <typename VT>
+uint64_t DF_packStat(VT v) {
+	static_assert(sizeof(VT) <= sizeof(uint64_t), "the statistics of a block are at most 8 bytes");
+	uint64_t stat = 0;
+	memcpy(&stat, &v, sizeof(VT));
+	return stat;
+}
+
+template <typename VT>
+VT DF_unpackStat(uint64_t stat) {
+	VT v;
+	memcpy(&v, &stat, sizeof(VT));
+	return v;
+}
+
+// CRC-32 (the polynomial of zlib, gzip and PNG), continuing from crc
+inline uint32_t DF_crc32(uint32_t crc, const uint8_t * data, uint64_t nbytes) {
+#ifdef USE_ZLIB
+	const uint64_t maxChunk = uint64_t(1) << 30;
+	for (uint64_t i = 0; i < nbytes; i += maxChunk)
+		crc = crc32(crc, data + i, static_cast<uInt>(std::min(maxChunk, nbytes - i)));
+	return crc;
+#else
+	static const std::array<uint32_t, 256> table = [] {
+		std::array<uint32_t, 256> t;
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			t[i] = c;
+		}
+		return t;
+	}();
+	crc = ~crc;
+	for (uint64_t i = 0; i < nbytes; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+#endif
+}
 
 #endif
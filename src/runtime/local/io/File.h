@@ -17,6 +17,8 @@
 #ifndef SRC_RUNTIME_LOCAL_IO_FILE_H
 #define SRC_RUNTIME_LOCAL_IO_FILE_H
 
+#include <runtime/local/io/ObjectStore.h>
+
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -24,6 +26,9 @@ struct File {
   FILE *identifier;
   unsigned long pos;
   unsigned long read;
+  // the buffer of getLine(), reused for all lines
+  char *line;
+  size_t lineCapacity;
 };
 
 inline struct File *openMemFile(FILE *ident){
@@ -31,42 +36,49 @@ inline struct File *openMemFile(FILE *ident){
 
   f->identifier = ident;
   f->pos = 0;
+  f->line = NULL;
+  f->lineCapacity = 0;
 
   return f;
 }
 
+// an object in an object store (see isObjectURL) is read from a local copy
 inline struct File *openFile(const char *filename) {
-  struct File *f = (struct File *)malloc(sizeof(struct File));
-
-  f->identifier = fopen(filename, "r");
-  f->pos = 0;
-
-  if (f->identifier == NULL)
+  FILE *ident = fopen(ObjectStore::localPath(filename).c_str(), "r");
+  if (ident == NULL)
     return NULL;
-  return f;
+  return openMemFile(ident);
 }
 
 inline struct File *openFileForWrite(const char *filename) {
-  struct File *f = (struct File *)malloc(sizeof(struct File));
-
-  f->identifier = fopen(filename, "w+");
-  f->pos = 0;
-  
-  if (f->identifier == NULL)
+  FILE *ident = fopen(filename, "w+");
+  if (ident == NULL)
     return NULL;
-  return f;
+  return openMemFile(ident);
 }
 
-inline void closeFile(File *f) { fclose(f->identifier); }
+inline void closeFile(File *f) {
+  fclose(f->identifier);
+  free(f->line);
+  free(f);
+}
 
+// the returned line is valid until the next call, and empty at the end of the file
 inline char *getLine(File *f) {
-  char *line = NULL;
-  size_t len = 0;
-
-  f->read = getline(&line, &len, f->identifier);
+  f->read = getline(&f->line, &f->lineCapacity, f->identifier);
   f->pos += f->read;
+  if ((ssize_t)f->read == -1 && f->line != NULL)
+    f->line[0] = '\0';
+
+  return f->line;
+}
 
-  return line;
+// the end of the line last returned by getLine(), excluding the newline
+inline const char *getLineEnd(File *f) {
+  if ((ssize_t)f->read <= 0)
+    return f->line;
+  const char *end = f->line + f->read;
+  return end[-1] == '\n' ? end - 1 : end;
 }
 
 #endif
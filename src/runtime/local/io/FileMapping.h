@@ -0,0 +1,89 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/io/ObjectStore.h>
+
+#include <memory>
+
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief A private (copy-on-write) mapping of a whole file, which is unmapped
+ * when the last `std::shared_ptr` to it (e.g., the values of a matrix read
+ * without copying) dies.
+ *
+ * The pages are shared with the page cache and with other processes mapping
+ * the same file, until a kernel writes to them.
+ */
+struct FileMapping {
+	uint8_t * addr;
+	uint64_t length;
+
+	FileMapping(uint8_t * addr, uint64_t length) : addr(addr), length(length) {}
+	FileMapping(const FileMapping &) = delete;
+	FileMapping & operator=(const FileMapping &) = delete;
+
+	~FileMapping() {
+		munmap(addr, length);
+	}
+
+	// returns nullptr if the file cannot be mapped, e.g., an object in an object store, whose ranges are read as needed
+	static std::shared_ptr<FileMapping> map(const char * filename) {
+		if (isObjectURL(filename))
+			return nullptr;
+		const int fd = open(filename, O_RDONLY);
+		if (fd < 0)
+			return nullptr;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+			close(fd);
+			return nullptr;
+		}
+		void * addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (addr == MAP_FAILED)
+			return nullptr;
+		return std::make_shared<FileMapping>(static_cast<uint8_t *>(addr), st.st_size);
+	}
+
+	// reads a (possibly unaligned) header field at pos and advances pos
+	template <typename T>
+	bool read(uint64_t & pos, T & field) const {
+		if (pos + sizeof(T) > length)
+			return false;
+		memcpy(&field, addr + pos, sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	// returns the array of numElements at pos and advances pos, or nullptr if it is misaligned or out of bounds
+	template <typename T>
+	T * array(uint64_t & pos, uint64_t numElements) const {
+		if (pos % alignof(T) != 0 || pos > length || numElements > (length - pos) / sizeof(T))
+			return nullptr;
+		T * arr = reinterpret_cast<T *>(addr + pos);
+		pos += numElements * sizeof(T);
+		return arr;
+	}
+};
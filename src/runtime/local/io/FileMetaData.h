@@ -17,6 +17,7 @@
 #pragma once
 
 #include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/ColumnStatistics.h>
 
 #include <utility>
 #include <vector>
@@ -34,6 +35,8 @@ struct FileMetaData {
     std::vector<ValueTypeCode> schema;
     std::vector<std::string> labels;
     const ssize_t numNonZeros;
+    // the statistics of the columns, empty if unknown, see ColumnStatistics
+    std::vector<ColumnStatistics> columnStats;
     
     /**
      * @brief Construct a new File Meta Data object for Frames
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/CsvTokenizer.h>
+#include <runtime/local/io/File.h>
+#include <runtime/local/io/FileMapping.h>
+#include <runtime/local/io/FileMetaData.h>
+#include <runtime/local/io/utils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Infers the meta data of a CSV file without a meta data file.
+ *
+ * The value types are inferred from a few samples of whole lines spread over
+ * the file: a column is `si64` if all its sampled fields are integers and
+ * `f64` otherwise. The number of rows is the number of lines, which are
+ * counted on the workers of the context with vectorized scans (see `csvCount`), such that
+ * inferring the meta data takes a fraction of the time of reading the file.
+ *
+ * Since the types are only inferred from the samples, a value of another type
+ * in the rest of the file is converted like in a file with such meta data.
+ */
+struct InferCsvMetaData {
+    // the number of samples and the (maximum) bytes of each
+    static constexpr size_t NUM_SAMPLES = 8;
+    static constexpr uint64_t SAMPLE_BYTES = uint64_t(1) << 16;
+    // don't count the lines of ranges smaller than this on separate workers
+    static constexpr uint64_t MIN_RANGE_BYTES = uint64_t(1) << 22;
+
+    enum class Kind { EMPTY, INT, FLOAT };
+
+    static FileMetaData apply(const char * filename, char delim = ',', DCTX(ctx) = nullptr) {
+        std::shared_ptr<FileMapping> file = FileMapping::map(filename);
+        if(!file) {
+            File * f = openFile(filename);
+            if(f == nullptr)
+                throw std::runtime_error(std::string("cannot open file '") + filename + "' to infer its meta data");
+            closeFile(f);
+            throw std::runtime_error(std::string("cannot infer the meta data of the empty file '") + filename + "'");
+        }
+        const char * data = reinterpret_cast<const char *>(file->addr);
+        const uint64_t length = file->length;
+
+        // the value types of the columns in the sampled lines
+        std::vector<Kind> kinds;
+        bool first = true;
+        uint64_t sampleEnd = 0;
+        for(size_t i = 0; i < NUM_SAMPLES && sampleEnd < length; i++) {
+            uint64_t begin = std::max(sampleEnd, length / NUM_SAMPLES * i);
+            if(begin > sampleEnd) {
+                const void * nl = memchr(data + begin - 1, '\n', length - begin + 1);
+                begin = nl ? static_cast<const char *>(nl) - data + 1 : length;
+            }
+            const char * p = data + begin;
+            const char * end = data + std::min(length, begin + SAMPLE_BYTES);
+            // at least one whole line
+            do {
+                const char * nl = static_cast<const char *>(memchr(p, '\n', data + length - p));
+                const char * lineEnd = nl ? nl : data + length;
+                if(lineEnd > p && !(lineEnd == p + 1 && *p == '\r')) {
+                    sampleLine(p, lineEnd, delim, kinds, first, filename);
+                    first = false;
+                }
+                p = nl ? nl + 1 : data + length;
+            } while(p < end);
+            sampleEnd = p - data;
+        }
+        if(kinds.empty())
+            throw std::runtime_error(std::string("cannot infer the meta data of the file '") + filename
+                    + "', which has no values");
+
+        const size_t numRows = countLines(data, length, ctx);
+        const size_t numCols = kinds.size();
+        std::vector<ValueTypeCode> schema;
+        for(Kind k : kinds)
+            schema.push_back(k == Kind::INT ? ValueTypeCode::SI64 : ValueTypeCode::F64);
+        if(std::all_of(schema.begin(), schema.end(), [&](ValueTypeCode vtc) { return vtc == schema[0]; }))
+            return {numRows, numCols, true, schema[0]};
+        std::vector<std::string> labels;
+        for(size_t c = 0; c < numCols; c++)
+            labels.push_back(Frame::getDefaultLabel(c));
+        return {numRows, numCols, false, schema, labels};
+    }
+
+    /**
+     * @brief Returns the number of lines of [data, data + length), like
+     * `CsvLines`, i.e., the number of newlines plus a last line without one.
+     */
+    static uint64_t countLines(const char * data, uint64_t length, DCTX(ctx) = nullptr) {
+        const uint64_t numRanges = std::max<uint64_t>(1, std::min<uint64_t>(WorkerPool::getNumWorkers(ctx),
+                length / MIN_RANGE_BYTES));
+        std::vector<uint64_t> counts(numRanges, 0);
+        WorkerPool::parallelFor(ctx, numRanges, [&](size_t i) {
+            counts[i] = csvCount(data + length / numRanges * i,
+                    data + (i + 1 == numRanges ? length : length / numRanges * (i + 1)), '\n');
+        });
+        uint64_t numLines = 0;
+        for(uint64_t c : counts)
+            numLines += c;
+        return numLines + (length > 0 && data[length - 1] != '\n');
+    }
+
+    static Kind kindOf(const char * begin, const char * end) {
+        while(begin < end && (*begin == ' ' || *begin == '\t'))
+            begin++;
+        while(end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+            end--;
+        if(begin == end)
+            return Kind::EMPTY;
+        if(*begin == '+' && end - begin > 1)
+            begin++;
+        int64_t i;
+        std::from_chars_result r = std::from_chars(begin, end, i);
+        if(r.ec == std::errc() && r.ptr == end)
+            return Kind::INT;
+        double d;
+        r = std::from_chars(begin, end, d);
+        // integers out of the range of si64, too
+        if((r.ec == std::errc() || r.ec == std::errc::result_out_of_range) && r.ptr == end)
+            return Kind::FLOAT;
+        throw std::invalid_argument("'" + std::string(begin, end) + "' is not a number");
+    }
+
+private:
+    static void sampleLine(const char * line, const char * lineEnd, char delim, std::vector<Kind> & kinds,
+            bool first, const char * filename) {
+        size_t c = 0;
+        for(const char * pos = line; ; c++) {
+            const char * fieldBegin, * fieldEnd;
+            const char * fieldPos = pos;
+            csvNextField(pos, lineEnd, delim, fieldBegin, fieldEnd);
+            if(first)
+                kinds.push_back(Kind::EMPTY);
+            else if(c >= kinds.size())
+                throw std::runtime_error(std::string("cannot infer the meta data of the file '") + filename
+                        + "', whose lines have different numbers of fields");
+            try {
+                kinds[c] = std::max(kinds[c], kindOf(fieldBegin, fieldEnd));
+            }
+            catch(const std::invalid_argument & e) {
+                throw std::runtime_error(std::string("cannot infer the value type of column ") + std::to_string(c)
+                        + " of the file '" + filename + "': " + e.what() + ", please provide a meta data file");
+            }
+            // the last field, unless it ended at a delimiter at the end of the line
+            if(pos == lineEnd && (fieldPos == lineEnd || pos[-1] != delim))
+                break;
+        }
+        if(c + 1 != kinds.size())
+            throw std::runtime_error(std::string("cannot infer the meta data of the file '") + filename
+                    + "', whose lines have different numbers of fields");
+    }
+};
+
+/**
+ * @brief Infers the meta data of a CSV file, see `InferCsvMetaData`.
+ */
+inline FileMetaData inferCsvMetaData(const char * filename, char delim = ',', DCTX(ctx) = nullptr) {
+    return InferCsvMetaData::apply(filename, delim, ctx);
+}
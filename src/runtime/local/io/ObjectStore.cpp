@@ -0,0 +1,440 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/io/ObjectStore.h>
+#include <runtime/local/io/utils.h>
+
+#ifdef USE_CURL
+#include <curl/curl.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+	// the attempts of a GET failing transiently, e.g., by a timeout or a throttling object store
+	constexpr int MAX_ATTEMPTS = 4;
+
+	struct Response {
+		long status = 0;
+		std::string etag;
+		// the size of the object from the Content-Range of a partial response, -1 if there is none
+		int64_t totalSize = -1;
+		std::vector<uint8_t> body;
+	};
+
+	struct TransientError : std::runtime_error {
+		using std::runtime_error::runtime_error;
+	};
+
+	const char * envOr(const char * name, const char * dflt) {
+		const char * value = getenv(name);
+		return value && *value ? value : dflt;
+	}
+
+	// the HTTP(S) URL of an object and, for an S3 object, its region
+	std::pair<std::string, std::string> resolveURL(const std::string & url) {
+		if(url.compare(0, 5, "s3://") != 0)
+			return {url, ""};
+		const std::string path = url.substr(5);
+		const size_t slash = path.find('/');
+		if(slash == std::string::npos || slash == 0 || slash + 1 == path.size())
+			throw std::runtime_error("ObjectStore: invalid S3 URL " + url);
+		const std::string bucket = path.substr(0, slash);
+		const std::string key = path.substr(slash + 1);
+		const std::string region = envOr("AWS_REGION", envOr("AWS_DEFAULT_REGION", "us-east-1"));
+		std::string endpoint = envOr("AWS_ENDPOINT_URL", "");
+		if(!endpoint.empty()) {
+			while(endpoint.back() == '/')
+				endpoint.pop_back();
+			return {endpoint + "/" + bucket + "/" + key, region};
+		}
+		return {"https://" + bucket + ".s3." + region + ".amazonaws.com/" + key, region};
+	}
+
+	std::string hashHex(const std::string & s) {
+		std::ostringstream os;
+		os << std::hex << std::hash<std::string>{}(s);
+		return os.str();
+	}
+
+#ifdef USE_CURL
+	size_t onBody(char * data, size_t size, size_t n, void * user) {
+		auto & body = static_cast<Response *>(user)->body;
+		body.insert(body.end(), data, data + size * n);
+		return size * n;
+	}
+
+	size_t onHeader(char * data, size_t size, size_t n, void * user) {
+		auto & res = *static_cast<Response *>(user);
+		const std::string line(data, size * n);
+		// the headers of a response after a redirect replace the ones before
+		if(line.compare(0, 5, "HTTP/") == 0) {
+			res.etag.clear();
+			res.totalSize = -1;
+			return size * n;
+		}
+		const size_t colon = line.find(':');
+		if(colon == std::string::npos)
+			return size * n;
+		std::string name = line.substr(0, colon);
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+		const size_t begin = line.find_first_not_of(" \t", colon + 1);
+		const size_t end = line.find_last_not_of(" \t\r\n");
+		const std::string value = begin == std::string::npos || end < begin ? "" : line.substr(begin, end - begin + 1);
+		if(name == "etag")
+			res.etag = value;
+		else if(name == "content-range") {
+			const size_t total = value.rfind('/');
+			if(total != std::string::npos && value.compare(total + 1, std::string::npos, "*") != 0)
+				res.totalSize = std::stoll(value.substr(total + 1));
+		}
+		return size * n;
+	}
+
+	Response get(const std::string & httpURL, const std::string & s3Region, uint64_t offset, uint64_t nbytes) {
+		static std::once_flag init;
+		std::call_once(init, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+		// a handle per thread, which keeps its connections open for the next GETs
+		thread_local std::unique_ptr<CURL, void (*)(CURL *)> handle(curl_easy_init(), curl_easy_cleanup);
+		CURL * curl = handle.get();
+		if(!curl)
+			throw std::runtime_error("ObjectStore: cannot initialize libcurl");
+		curl_easy_reset(curl);
+
+		Response res;
+		res.body.reserve(nbytes);
+		const std::string range = std::to_string(offset) + "-" + std::to_string(offset + nbytes - 1);
+		curl_easy_setopt(curl, CURLOPT_URL, httpURL.c_str());
+		curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+		curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+		curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, onBody);
+		curl_easy_setopt(curl, CURLOPT_WRITEDATA, &res);
+		curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, onHeader);
+		curl_easy_setopt(curl, CURLOPT_HEADERDATA, &res);
+
+		struct curl_slist * headers = nullptr;
+		std::string sigv4;
+		std::string userpwd;
+		const char * keyId = getenv("AWS_ACCESS_KEY_ID");
+		const char * secret = getenv("AWS_SECRET_ACCESS_KEY");
+		if(!s3Region.empty() && keyId && secret) {
+#if LIBCURL_VERSION_NUM >= 0x074b00
+			sigv4 = "aws:amz:" + s3Region + ":s3";
+			userpwd = std::string(keyId) + ":" + secret;
+			curl_easy_setopt(curl, CURLOPT_AWS_SIGV4, sigv4.c_str());
+			curl_easy_setopt(curl, CURLOPT_USERPWD, userpwd.c_str());
+			headers = curl_slist_append(headers, "x-amz-content-sha256: UNSIGNED-PAYLOAD");
+			if(const char * token = getenv("AWS_SESSION_TOKEN"))
+				headers = curl_slist_append(headers, ("x-amz-security-token: " + std::string(token)).c_str());
+			curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+#else
+			throw std::runtime_error("ObjectStore: signing S3 requests requires libcurl 7.75 or later");
+#endif
+		}
+
+		const CURLcode code = curl_easy_perform(curl);
+		curl_slist_free_all(headers);
+		if(code != CURLE_OK)
+			throw TransientError(curl_easy_strerror(code));
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &res.status);
+		return res;
+	}
+#else
+	Response get(const std::string & httpURL, const std::string &, uint64_t, uint64_t) {
+		throw std::runtime_error("ObjectStore: DAPHNE was built without libcurl, cannot read " + httpURL);
+	}
+#endif
+
+	// a GET of the bytes [offset, offset + nbytes) of an object, retried on transient failures
+	Response request(const std::string & url, const std::string & httpURL, const std::string & s3Region,
+			uint64_t offset, uint64_t nbytes) {
+		for(int attempt = 1;; attempt++) {
+			std::string error;
+			try {
+				Response res = get(httpURL, s3Region, offset, nbytes);
+				if(res.status < 500 && res.status != 429)
+					return res;
+				error = "HTTP status " + std::to_string(res.status);
+			}
+			catch(const TransientError & e) {
+				error = e.what();
+			}
+			if(attempt == MAX_ATTEMPTS)
+				throw std::runtime_error("ObjectStore: cannot read " + url + ": " + error);
+			std::this_thread::sleep_for(std::chrono::milliseconds(100 << attempt));
+		}
+	}
+
+	// reads a whole cached range, false if it is not cached
+	bool readCacheFile(const std::string & path, uint8_t * dst, uint64_t nbytes) {
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if(fd < 0)
+			return false;
+		uint64_t done = 0;
+		while(done < nbytes) {
+			const ssize_t n = pread(fd, dst + done, nbytes - done, done);
+			if(n < 0 && errno == EINTR)
+				continue;
+			if(n <= 0)
+				break;
+			done += n;
+		}
+		close(fd);
+		return done == nbytes;
+	}
+
+	// writes a cached range by renaming a temporary file, such that concurrent readers never see a partial one
+	void writeCacheFile(const std::string & path, const uint8_t * src, uint64_t nbytes) {
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+		const std::string tmp = path + ".tmp" + hashHex(std::to_string(getpid()) + "-"
+				+ std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+		const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(fd < 0)
+			return;
+		// the cache is best effort, a range that cannot be written is fetched again next time
+		bool success = true;
+		try {
+			pwriteAll(fd, src, nbytes, 0);
+		}
+		catch(const std::runtime_error &) {
+			success = false;
+		}
+		close(fd);
+		if(!success || rename(tmp.c_str(), path.c_str()) != 0)
+			unlink(tmp.c_str());
+	}
+}
+
+// ****************************************************************************
+// ObjectStoreObject
+// ****************************************************************************
+
+void ObjectStoreObject::fetch(uint64_t offset, uint8_t * dst, uint64_t nbytes) const {
+	const uint64_t numParts = (nbytes + PART_BYTES - 1) / PART_BYTES;
+	auto fetchPart = [&](uint64_t i) {
+		const uint64_t partOffset = i * PART_BYTES;
+		const uint64_t n = std::min(PART_BYTES, nbytes - partOffset);
+		const Response res = request(url, httpURL, s3Region, offset + partOffset, n);
+		const uint8_t * body = res.body.data();
+		if(res.status == 200 && res.body.size() == size)
+			// the server does not support ranges and sent the whole object
+			body += offset + partOffset;
+		else if(res.status != 206 || res.body.size() != n)
+			throw std::runtime_error("ObjectStore: cannot read " + url + ": HTTP status " + std::to_string(res.status));
+		if(!etag.empty() && !res.etag.empty() && res.etag != etag)
+			throw std::runtime_error("ObjectStore: the object " + url + " changed while reading it");
+		std::copy(body, body + n, dst + partOffset);
+	};
+	// the GETs wait for the network rather than use a CPU, so there is one thread per connection instead of the
+	// workers of a context; the first exception is rethrown by the future of its connection after all finished
+	std::atomic<uint64_t> nextPart{0};
+	auto fetchParts = [&]() {
+		for(uint64_t i = nextPart++; i < numParts; i = nextPart++)
+			fetchPart(i);
+	};
+	const size_t numThreads = std::min<uint64_t>(numConnections, numParts);
+	std::vector<std::future<void>> connections;
+	for(size_t t = 1; t < numThreads; t++)
+		connections.push_back(std::async(std::launch::async, fetchParts));
+	std::exception_ptr error;
+	try {
+		fetchParts();
+	}
+	catch(...) {
+		error = std::current_exception();
+	}
+	for(std::future<void> & f : connections)
+		try {
+			f.get();
+		}
+		catch(...) {
+			if(!error)
+				error = std::current_exception();
+		}
+	if(error)
+		std::rethrow_exception(error);
+}
+
+std::string ObjectStoreObject::cachePath(uint64_t offset, uint64_t nbytes) const {
+	return cacheDir + "/" + std::to_string(offset) + "-" + std::to_string(nbytes);
+}
+
+void ObjectStoreObject::read(uint64_t offset, void * dst, uint64_t nbytes) {
+	if(offset > size || nbytes > size - offset)
+		throw std::runtime_error("ObjectStore: unexpected end of object " + url);
+	uint8_t * d = static_cast<uint8_t *>(dst);
+	if(offset + nbytes <= head.size()) {
+		std::copy(head.begin() + offset, head.begin() + offset + nbytes, d);
+		return;
+	}
+
+	// fetches a range unless it is cached, and caches it
+	auto fetchCached = [this](uint64_t o, uint8_t * buf, uint64_t n) {
+		if(!cacheDir.empty() && readCacheFile(cachePath(o, n), buf, n))
+			return;
+		fetch(o, buf, n);
+		if(!cacheDir.empty())
+			writeCacheFile(cachePath(o, n), buf, n);
+	};
+
+	std::shared_future<std::vector<uint8_t>> ahead;
+	{
+		std::lock_guard<std::mutex> lock(prefetchMtx);
+		auto it = prefetched.find({offset, nbytes});
+		if(it != prefetched.end()) {
+			ahead = it->second;
+			prefetched.erase(it);
+		}
+		// the ranges before this read are not read anymore
+		prefetched.erase(prefetched.begin(), prefetched.lower_bound({offset, 0}));
+		const uint64_t next = offset + nbytes;
+		if(offset == lastEnd && next < size && prefetched.size() < MAX_PREFETCHED) {
+			const uint64_t n = std::min(nbytes, size - next);
+			prefetched.emplace(std::make_pair(next, n), std::async(std::launch::async, [fetchCached, next, n] {
+				std::vector<uint8_t> buf(n);
+				fetchCached(next, buf.data(), n);
+				return buf;
+			}).share());
+		}
+		lastEnd = std::max(lastEnd, next);
+	}
+
+	if(ahead.valid()) {
+		const std::vector<uint8_t> & buf = ahead.get();
+		std::copy(buf.begin(), buf.end(), d);
+	}
+	else
+		fetchCached(offset, d, nbytes);
+}
+
+// ****************************************************************************
+// ObjectStore
+// ****************************************************************************
+
+ObjectStore::~ObjectStore() {
+	for(const std::string & path : tempCopies)
+		unlink(path.c_str());
+}
+
+void ObjectStore::configure(const std::string & cacheDir, size_t numConnections) {
+	std::lock_guard<std::mutex> lock(mtx);
+	this->cacheDir = cacheDir;
+	this->numConnections = std::max<size_t>(numConnections, 1);
+}
+
+std::shared_ptr<ObjectStoreObject> ObjectStore::open(const std::string & url) {
+	std::string dir;
+	size_t connections;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		auto it = objects.find(url);
+		if(it != objects.end())
+			return it->second;
+		dir = cacheDir;
+		connections = numConnections;
+	}
+
+	auto [httpURL, s3Region] = resolveURL(url);
+	std::shared_ptr<ObjectStoreObject> obj(new ObjectStoreObject(url, httpURL, s3Region));
+	obj->numConnections = connections;
+	Response res = request(url, httpURL, s3Region, 0, ObjectStoreObject::HEAD_BYTES);
+	if(res.status == 416)
+		// an empty object, which has no range
+		obj->size = 0;
+	else if(res.status == 206 || res.status == 200) {
+		obj->size = res.status == 206 && res.totalSize >= 0 ? res.totalSize : res.body.size();
+		res.body.resize(std::min<uint64_t>(res.body.size(), ObjectStoreObject::HEAD_BYTES));
+		obj->head = std::move(res.body);
+	}
+	else
+		throw std::runtime_error("ObjectStore: cannot open " + url + ": HTTP status " + std::to_string(res.status));
+	obj->etag = res.etag;
+	// only an object with an ETag can be cached, by which its versions are told apart
+	if(!dir.empty() && !obj->etag.empty()) {
+		std::string version;
+		for(char c : obj->etag)
+			if(std::isalnum(static_cast<unsigned char>(c)))
+				version += c;
+		obj->cacheDir = dir + "/" + hashHex(url) + "-" + version;
+	}
+
+	std::lock_guard<std::mutex> lock(mtx);
+	// a concurrent open of the same URL may have been first
+	return objects.emplace(url, obj).first->second;
+}
+
+std::string ObjectStore::localCopy(const std::string & url) {
+	std::shared_ptr<ObjectStoreObject> obj = open(url);
+	const bool temp = obj->cacheDir.empty();
+	const std::string path = temp
+			? (std::filesystem::temp_directory_path() / ("daphne-object-" + std::to_string(getpid()) + "-" + hashHex(url))).string()
+			: obj->cacheDir + "/object";
+	struct stat st;
+	if(stat(path.c_str(), &st) == 0 && uint64_t(st.st_size) == obj->getSize())
+		return path;
+
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+	const std::string tmp = path + ".tmp" + hashHex(std::to_string(getpid()) + "-"
+			+ std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+	const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		throw std::runtime_error("ObjectStore: cannot create the local copy " + tmp + " of " + url);
+	try {
+		// the object is fetched in chunks of parts fetched in parallel, which bounds the memory used
+		const uint64_t chunkBytes = ObjectStoreObject::PART_BYTES * obj->numConnections;
+		std::vector<uint8_t> buf(std::min(chunkBytes, obj->getSize()));
+		for(uint64_t offset = 0; offset < obj->getSize(); offset += chunkBytes) {
+			const uint64_t n = std::min(chunkBytes, obj->getSize() - offset);
+			obj->fetch(offset, buf.data(), n);
+			pwriteAll(fd, buf.data(), n, offset);
+		}
+	}
+	catch(...) {
+		close(fd);
+		unlink(tmp.c_str());
+		throw;
+	}
+	close(fd);
+	if(rename(tmp.c_str(), path.c_str()) != 0) {
+		unlink(tmp.c_str());
+		throw std::runtime_error("ObjectStore: cannot create the local copy " + path + " of " + url);
+	}
+	if(temp) {
+		std::lock_guard<std::mutex> lock(mtx);
+		if(std::find(tempCopies.begin(), tempCopies.end(), path) == tempCopies.end())
+			tempCopies.push_back(path);
+	}
+	return path;
+}
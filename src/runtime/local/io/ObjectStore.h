@@ -0,0 +1,161 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Whether a file name is the URL of an object in an object store
+ * (`s3://bucket/key`, `http://...`, or `https://...`), which the readers
+ * fetch by HTTP range requests instead of opening a local file.
+ */
+inline bool isObjectURL(const char * filename) {
+	return strncmp(filename, "s3://", 5) == 0 || strncmp(filename, "http://", 7) == 0
+			|| strncmp(filename, "https://", 8) == 0;
+}
+
+/**
+ * @brief An object in an S3-compatible object store or on an HTTP server,
+ * whose byte ranges are read by ranged GETs.
+ *
+ * The first bytes of the object (holding the headers of the file formats)
+ * are fetched when it is opened. Large ranges are fetched by several GETs in
+ * parallel. A read continuing the last one fetches the range of the same
+ * size after it ahead, e.g., the next blocks of a Daphne binary file read in
+ * chunks of rows. With a cache directory (see `ObjectStore::configure`), the
+ * ranges read are kept on the local disk, keyed by the ETag of the object,
+ * such that the next reads of the same version of the object do not fetch
+ * them again.
+ */
+class ObjectStoreObject {
+	friend class ObjectStore;
+
+public:
+	// the bytes of the object fetched when it is opened
+	static constexpr uint64_t HEAD_BYTES = uint64_t(256) << 10;
+	// the size of the parts of a range fetched by separate GETs
+	static constexpr uint64_t PART_BYTES = uint64_t(8) << 20;
+	// the most ranges fetched ahead at a time
+	static constexpr size_t MAX_PREFETCHED = 2;
+
+private:
+	// the URL as given and the HTTP(S) URL of the object
+	const std::string url;
+	const std::string httpURL;
+	// the region of an S3 object, whose requests are signed if there are credentials
+	const std::string s3Region;
+	uint64_t size = 0;
+	std::string etag;
+	std::vector<uint8_t> head;
+	// the directory of the cached ranges of this version of the object, empty without a cache
+	std::string cacheDir;
+	size_t numConnections;
+
+	std::mutex prefetchMtx;
+	// the ranges fetched ahead, by their first byte and size
+	std::map<std::pair<uint64_t, uint64_t>, std::shared_future<std::vector<uint8_t>>> prefetched;
+	// the end of the last read
+	uint64_t lastEnd = 0;
+
+	ObjectStoreObject(std::string url, std::string httpURL, std::string s3Region)
+			: url(std::move(url)), httpURL(std::move(httpURL)), s3Region(std::move(s3Region)) {}
+
+	// fetches [offset, offset + nbytes) by parallel GETs of at most PART_BYTES
+	void fetch(uint64_t offset, uint8_t * dst, uint64_t nbytes) const;
+
+	std::string cachePath(uint64_t offset, uint64_t nbytes) const;
+
+public:
+	ObjectStoreObject(const ObjectStoreObject &) = delete;
+	ObjectStoreObject & operator=(const ObjectStoreObject &) = delete;
+
+	const std::string & getURL() const { return url; }
+	uint64_t getSize() const { return size; }
+	const std::string & getETag() const { return etag; }
+
+	/**
+	 * @brief Reads the bytes [offset, offset + nbytes) of the object, which
+	 * may be called by several threads concurrently.
+	 */
+	void read(uint64_t offset, void * dst, uint64_t nbytes);
+};
+
+/**
+ * @brief The objects of object stores the readers read, opened once per
+ * process.
+ *
+ * `s3://bucket/key` is fetched from `$AWS_ENDPOINT_URL/bucket/key` if the
+ * variable is set (e.g., for MinIO), from
+ * `https://bucket.s3.$AWS_REGION.amazonaws.com/key` otherwise. The requests
+ * are signed (AWS Signature Version 4) if `AWS_ACCESS_KEY_ID` and
+ * `AWS_SECRET_ACCESS_KEY` are set. The readers of formats without random
+ * access (e.g., CSV) read a local copy of the whole object (see `localPath`).
+ */
+class ObjectStore {
+	std::mutex mtx;
+	std::map<std::string, std::shared_ptr<ObjectStoreObject>> objects;
+	// the local copies of objects outside of the cache, removed at the end of the process
+	std::vector<std::string> tempCopies;
+	std::string cacheDir;
+	size_t numConnections = 8;
+
+	ObjectStore() = default;
+	~ObjectStore();
+
+public:
+	static ObjectStore & get() {
+		static ObjectStore store;
+		return store;
+	}
+
+	/**
+	 * @brief Sets the directory the read ranges and the local copies of the
+	 * objects are cached in (none if empty), preferably on a local SSD, and
+	 * the parallel GETs of a read.
+	 */
+	void configure(const std::string & cacheDir, size_t numConnections);
+
+	/**
+	 * @brief Returns the object of the given URL, whose size and ETag are
+	 * determined when it is opened first.
+	 */
+	std::shared_ptr<ObjectStoreObject> open(const std::string & url);
+
+	/**
+	 * @brief Returns the path of a local copy of the object of the given URL,
+	 * fetched by parallel ranged GETs unless it is cached.
+	 */
+	std::string localCopy(const std::string & url);
+
+	/**
+	 * @brief Returns the given file name, or the path of a local copy if it
+	 * is the URL of an object.
+	 */
+	static std::string localPath(const char * filename) {
+		return isObjectURL(filename) ? get().localCopy(filename) : std::string(filename);
+	}
+};
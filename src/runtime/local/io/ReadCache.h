@@ -0,0 +1,120 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Structure.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <cstdint>
+
+#include <sys/stat.h>
+
+/**
+ * @brief The data objects read from files, kept in memory across the runs of
+ * scripts in one process (e.g., the models used by the requests to the daphne
+ * server) and reused by later reads of the same file as long as its size and
+ * modification time are unchanged (see `DaphneUserConfig::cache_reads`).
+ *
+ * A reused data object is shared by reference counting; the cache holds a
+ * reference of its own, such that no kernel updates it in place.
+ */
+class ReadCache {
+public:
+    // the file, the data type (see AsyncReadDataType), and the value type code
+    using Key = std::tuple<std::string, int64_t, int64_t>;
+
+private:
+    struct Entry {
+        std::string stamp;
+        const Structure * obj;
+    };
+
+    std::mutex mtx;
+    std::map<Key, Entry> entries;
+
+    ReadCache() = default;
+
+public:
+    ReadCache(const ReadCache &) = delete;
+    ReadCache & operator=(const ReadCache &) = delete;
+
+    static ReadCache & get() {
+        // never destroyed, since the cached objects may outlive the kernel libraries at exit
+        static ReadCache * cache = new ReadCache();
+        return *cache;
+    }
+
+    /**
+     * @brief Returns the size and modification time of the given file, or an
+     * empty string if it does not exist.
+     */
+    static std::string getFileStamp(const std::string & filename) {
+        struct stat st{};
+        if(stat(filename.c_str(), &st) != 0)
+            return "";
+        return std::to_string(st.st_size) + "@" + std::to_string(st.st_mtim.tv_sec) + "."
+                + std::to_string(st.st_mtim.tv_nsec);
+    }
+
+    /**
+     * @brief Returns the data object read from the given file before, with a
+     * new reference for the caller, or `nullptr` if there is none or the file
+     * changed since.
+     */
+    template<class DT>
+    DT * lookup(const Key & key) {
+        const std::string stamp = getFileStamp(std::get<0>(key));
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = entries.find(key);
+        if(it == entries.end() || stamp.empty() || it->second.stamp != stamp)
+            return nullptr;
+        it->second.obj->increaseRefCounter();
+        return const_cast<DT *>(static_cast<const DT *>(it->second.obj));
+    }
+
+    /**
+     * @brief Keeps a reference to the given data object read from the file of
+     * the given key, replacing the one of an earlier version of the file.
+     */
+    template<class DT>
+    void insert(const Key & key, const DT * obj) {
+        const std::string stamp = getFileStamp(std::get<0>(key));
+        if(stamp.empty())
+            return;
+        obj->increaseRefCounter();
+        const Structure * replaced = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = entries.find(key);
+            if(it != entries.end())
+                replaced = it->second.obj;
+            entries[key] = Entry{stamp, obj};
+        }
+        if(replaced)
+            DataObjectFactory::destroy(replaced);
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return entries.size();
+    }
+};
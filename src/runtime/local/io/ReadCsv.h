@@ -16,62 +16,168 @@
 
 #pragma once
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 
+#include <runtime/local/io/CsvTokenizer.h>
 #include <runtime/local/io/File.h>
+#include <runtime/local/io/FileMapping.h>
 #include <runtime/local/io/utils.h>
 #include <runtime/local/io/ReadCsvFile.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
 #include <util/preprocessor_defs.h>
 
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <queue>
 #include <fstream>
 #include <limits>
 #include <sstream>
 
+/**
+ * @brief The lines of a CSV file mapped into memory, split into byte ranges at
+ * line boundaries, such that the ranges can be parsed in parallel into the
+ * preallocated rows of a data object on the workers of the context.
+ */
+struct CsvLines {
+  // don't split the file into ranges smaller than this
+  static constexpr uint64_t MIN_RANGE_BYTES = uint64_t(1) << 20;
+
+  std::shared_ptr<FileMapping> file;
+  // the first byte of each range and the end of the file
+  std::vector<uint64_t> rangeBegins;
+  // the index of the first line of each range and the number of lines
+  std::vector<uint64_t> rangeFirstLines;
+  DaphneContext *ctx;
+
+  CsvLines(const char *filename, DCTX(ctx)) : ctx(ctx) {
+    file = FileMapping::map(filename);
+    const uint64_t length = file ? file->length : 0;
+    if (!file) {
+      struct File *f = openFile(filename);
+      if (f == nullptr)
+        throw std::runtime_error(std::string("ReadCsv: cannot open file ") + filename);
+      // an empty file
+      closeFile(f);
+    }
+    const char *data = file ? reinterpret_cast<const char *>(file->addr) : nullptr;
+
+    // a few ranges per worker for the balance, each starting after a newline
+    const uint64_t numRanges = std::max<uint64_t>(1, std::min<uint64_t>(4 * WorkerPool::getNumWorkers(ctx),
+        length / MIN_RANGE_BYTES));
+    rangeBegins.push_back(0);
+    for (uint64_t i = 1; i < numRanges; i++) {
+      uint64_t begin = std::max(rangeBegins.back(), length / numRanges * i);
+      const void *nl = memchr(data + begin, '\n', length - begin);
+      begin = nl ? static_cast<const char *>(nl) - data + 1 : length;
+      rangeBegins.push_back(begin);
+    }
+    rangeBegins.push_back(length);
+
+    std::vector<uint64_t> numLines(numRanges, 0);
+    WorkerPool::parallelFor(ctx, numRanges, [&](size_t i) {
+      for (const char *p = data + rangeBegins[i], *end = data + rangeBegins[i + 1]; p < end; numLines[i]++) {
+        const void *nl = memchr(p, '\n', end - p);
+        p = nl ? static_cast<const char *>(nl) + 1 : end;
+      }
+    });
+    rangeFirstLines.push_back(0);
+    for (uint64_t i = 0; i < numRanges; i++)
+      rangeFirstLines.push_back(rangeFirstLines.back() + numLines[i]);
+  }
+
+  uint64_t getNumLines() const {
+    return rangeFirstLines.back();
+  }
+
+  void requireLines(uint64_t numLines) const {
+    if (numLines > getNumLines())
+      throw std::runtime_error("ReadCsv: the file has " + std::to_string(getNumLines()) + " lines, expected "
+          + std::to_string(numLines));
+  }
+
+  /**
+   * @brief Calls func(line, lineEnd, lineIdx) for the first numLines lines in
+   * parallel, where [line, lineEnd) excludes the newline and is not
+   * null-terminated.
+   */
+  template <typename Func>
+  void forEachLine(uint64_t numLines, Func func) const {
+    requireLines(numLines);
+    const char *data = file ? reinterpret_cast<const char *>(file->addr) : nullptr;
+    WorkerPool::parallelFor(ctx, rangeBegins.size() - 1, [&](size_t i) {
+      uint64_t lineIdx = rangeFirstLines[i];
+      for (const char *p = data + rangeBegins[i], *end = data + rangeBegins[i + 1];
+           p < end && lineIdx < numLines; lineIdx++) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+        func(p, nl ? nl : end, lineIdx);
+        p = nl ? nl + 1 : end;
+      }
+    });
+  }
+
+  /**
+   * @brief Converts the field at pos of [line, lineEnd) and advances pos to
+   * the next field. Missing fields are converted like empty strings.
+   */
+  template <typename VT>
+  static void convertField(const char *&pos, const char *lineEnd, char delim, VT *v) {
+    const char *fieldBegin, *fieldEnd;
+    csvNextField(pos, lineEnd, delim, fieldBegin, fieldEnd);
+    convertCstr(fieldBegin, fieldEnd, v);
+  }
+};
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
 
 template <class DTRes> struct ReadCsv {
   static void apply(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
-                    char delim) = delete;
+                    char delim, DCTX(ctx)) = delete;
 
   static void apply(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
-                    ssize_t numNonZeros, bool sorted = true) = delete;
+                    ssize_t numNonZeros, bool sorted, DCTX(ctx)) = delete;
 
   static void apply(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
-                    char delim, ValueTypeCode *schema) = delete;
+                    char delim, ValueTypeCode *schema, DCTX(ctx)) = delete;
 };
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
+// These functions map the file into memory and parse it on the workers of the
+// context (sequentially without a context), see CsvLines.
+
 template <class DTRes>
 void readCsv(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
-             char delim) {
-  ReadCsv<DTRes>::apply(res, filename, numRows, numCols, delim);
+             char delim, DCTX(ctx) = nullptr) {
+  ReadCsv<DTRes>::apply(res, filename, numRows, numCols, delim, ctx);
 }
 
 template <class DTRes>
 void readCsv(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
-             char delim, ValueTypeCode *schema) {
-  ReadCsv<DTRes>::apply(res, filename, numRows, numCols, delim, schema);
+             char delim, ValueTypeCode *schema, DCTX(ctx) = nullptr) {
+  ReadCsv<DTRes>::apply(res, filename, numRows, numCols, delim, schema, ctx);
 }
 
 template <class DTRes>
 void readCsv(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
-             char delim, ssize_t numNonZeros, bool sorted = true) {
-    ReadCsv<DTRes>::apply(res, filename, numRows, numCols, delim, numNonZeros, sorted);
+             char delim, ssize_t numNonZeros, bool sorted, DCTX(ctx) = nullptr) {
+    ReadCsv<DTRes>::apply(res, filename, numRows, numCols, delim, numNonZeros, sorted, ctx);
 }
 
 // ****************************************************************************
@@ -84,10 +190,24 @@ void readCsv(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
 
 template <typename VT> struct ReadCsv<DenseMatrix<VT>> {
   static void apply(DenseMatrix<VT> *&res, const char *filename, size_t numRows,
-                    size_t numCols, char delim) {
-    struct File *file = openFile(filename);
-    readCsvFile(res, file, numRows, numCols, delim);
-    closeFile(file);
+                    size_t numCols, char delim, DCTX(ctx)) {
+    assert(numRows > 0 && "numRows must be > 0");
+    assert(numCols > 0 && "numCols must be > 0");
+
+    CsvLines lines(filename, ctx);
+    lines.requireLines(numRows);
+
+    if (res == nullptr) {
+      res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    }
+
+    VT * valuesRes = res->getValues();
+    const size_t rowSkip = res->getRowSkip();
+    lines.forEachLine(numRows, [&](const char *pos, const char *lineEnd, uint64_t r) {
+      VT * rowRes = valuesRes + r * rowSkip;
+      for(size_t c = 0; c < numCols; c++)
+        CsvLines::convertField(pos, lineEnd, delim, rowRes + c);
+    });
   }
 };
 
@@ -97,10 +217,49 @@ template <typename VT> struct ReadCsv<DenseMatrix<VT>> {
 
 template <typename VT> struct ReadCsv<CSRMatrix<VT>> {
     static void apply(CSRMatrix<VT> *&res, const char *filename, size_t numRows,
-                      size_t numCols, char delim, ssize_t numNonZeros, bool sorted = true) {
-        struct File *file = openFile(filename);
-        readCsvFile(res, file, numRows, numCols, delim, numNonZeros, sorted);
-        closeFile(file);
+                      size_t numCols, char delim, ssize_t numNonZeros, bool sorted, DCTX(ctx)) {
+        if(!sorted) {
+            // the unsorted coordinates are sorted by the sequential reader
+            struct File *file = openFile(filename);
+            if(file == nullptr)
+                throw std::runtime_error(std::string("ReadCsv: cannot open file ") + filename);
+            readCsvFile(res, file, numRows, numCols, delim, numNonZeros, sorted);
+            closeFile(file);
+            return;
+        }
+        assert(numNonZeros != -1
+            && "Currently reading of sparse matrices requires a number of non zeros to be defined");
+
+        CsvLines lines(filename, ctx);
+        lines.requireLines(static_cast<size_t>(numNonZeros));
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(
+                numRows, numCols, numNonZeros, false
+            );
+
+        // the coordinates are parsed in parallel, the row offsets counted afterwards
+        const size_t nnz = static_cast<size_t>(numNonZeros);
+        auto *colIdxs = res->getColIdxs();
+        auto *values = res->getValues();
+        std::vector<uint64_t> rows(nnz);
+        lines.forEachLine(nnz, [&](const char *pos, const char *lineEnd, uint64_t i) {
+            CsvLines::convertField(pos, lineEnd, delim, &rows[i]);
+            uint64_t col;
+            CsvLines::convertField(pos, lineEnd, delim, &col);
+            if(rows[i] >= numRows || col >= numCols)
+                throw std::runtime_error("Position [" + std::to_string(rows[i]) + ", " + std::to_string(col)
+                    + "] is not part of matrix<" + std::to_string(numRows) + ", " + std::to_string(numCols) + ">");
+            values[i] = 1;
+            colIdxs[i] = col;
+        });
+
+        auto *rowOffsets = res->getRowOffsets();
+        std::memset(rowOffsets, 0, (numRows + 1) * sizeof(size_t));
+        for(size_t i = 0; i < nnz; i++)
+            rowOffsets[rows[i] + 1]++;
+        for(size_t r = 1; r <= numRows; r++)
+            rowOffsets[r] += rowOffsets[r - 1];
     }
 };
 
@@ -111,9 +270,66 @@ template <typename VT> struct ReadCsv<CSRMatrix<VT>> {
 
 template <> struct ReadCsv<Frame> {
   static void apply(Frame *&res, const char *filename, size_t numRows,
-                    size_t numCols, char delim, ValueTypeCode *schema) {
-    struct File *file = openFile(filename);
-    readCsvFile(res, file, numRows, numCols, delim, schema);
-    closeFile(file);
+                    size_t numCols, char delim, ValueTypeCode *schema, DCTX(ctx)) {
+    assert(numRows > 0 && "numRows must be > 0");
+    assert(numCols > 0 && "numCols must be > 0");
+
+    CsvLines lines(filename, ctx);
+    lines.requireLines(numRows);
+
+    if (res == nullptr) {
+      res = DataObjectFactory::create<Frame>(numRows, numCols, schema, nullptr, false);
+    }
+
+    std::vector<uint8_t *> rawCols(numCols);
+    std::vector<ValueTypeCode> colTypes(numCols);
+    for(size_t i = 0; i < numCols; i++) {
+        rawCols[i] = reinterpret_cast<uint8_t *>(res->getColumnRaw(i));
+        colTypes[i] = res->getColumnType(i);
+    }
+
+    lines.forEachLine(numRows, [&](const char *pos, const char *lineEnd, uint64_t row) {
+      for (size_t col = 0; col < numCols; col++) {
+        switch (colTypes[col]) {
+        case ValueTypeCode::SI8:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<int8_t *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::SI32:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<int32_t *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::SI64:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<int64_t *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::UI8:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<uint8_t *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::UI32:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<uint32_t *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::UI64:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<uint64_t *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::F32:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<float *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::F64:
+          CsvLines::convertField(pos, lineEnd, delim, reinterpret_cast<double *>(rawCols[col]) + row);
+          break;
+        case ValueTypeCode::STR: {
+          const char *fieldBegin, *fieldEnd;
+          csvNextField(pos, lineEnd, delim, fieldBegin, fieldEnd);
+          std::string &v = reinterpret_cast<std::string *>(rawCols[col])[row];
+          v.assign(fieldBegin, fieldEnd);
+          // a doubled quote inside a quoted field is one quote
+          if (fieldEnd < lineEnd && *fieldEnd == '"')
+            for (size_t i = 0; (i = v.find("\"\"", i)) != std::string::npos; i++)
+              v.erase(i, 1);
+          break;
+        }
+        default:
+          throw std::runtime_error("ReadCsv::apply: unknown value type code");
+        }
+      }
+    });
   }
 };
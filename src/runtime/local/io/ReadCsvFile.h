@@ -21,6 +21,7 @@
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 
+#include <runtime/local/io/CsvTokenizer.h>
 #include <runtime/local/io/File.h>
 #include <runtime/local/io/utils.h>
 
@@ -92,33 +93,22 @@ template <typename VT> struct ReadCsvFile<DenseMatrix<VT>> {
       res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
     }
 
-    char *line;
-    size_t cell = 0;
     VT * valuesRes = res->getValues();
+    const size_t rowSkip = res->getRowSkip();
 
     for(size_t r = 0; r < numRows; r++) {
-      line = getLine(file);
+      getLine(file);
       // TODO Assuming that the given numRows is available, this should never
       // happen.
 //      if (line == NULL)
 //        break;
 
-      size_t pos = 0;
+      const char *pos = file->line;
+      const char *lineEnd = getLineEnd(file);
+      const char *fieldBegin, *fieldEnd;
       for(size_t c = 0; c < numCols; c++) {
-        VT val;
-        convertCstr(line + pos, &val);
-        
-        // TODO This assumes that rowSkip == numCols.
-        valuesRes[cell++] = val;
-        
-        // TODO We could even exploit the fact that the strtoX functions can
-        // return a pointer to the first character after the parsed input, then
-        // we wouldn't have to search for that ourselves, just would need to
-        // check if it is really the delimiter.
-        if(c < numCols - 1) {
-            while(line[pos] != delim) pos++;
-            pos++; // skip delimiter
-        }
+        csvNextField(pos, lineEnd, delim, fieldBegin, fieldEnd);
+        convertCstr(fieldBegin, fieldEnd, valuesRes + r * rowSkip + c);
       }
     }
   }
@@ -166,17 +156,17 @@ private:
         auto *colIdxs = res->getColIdxs();
         auto *values = res->getValues();
 
-        char *line;
-        size_t pos;
         uint64_t row;
         uint64_t col;
         for (size_t i = 0; i < numNonZeros; ++i) {
-            line = getLine(file);
-            convertCstr(line, &row);
-            pos = 0;
-            while(line[pos] != delim) pos++;
-            pos++; // skip delimiter
-            convertCstr(line + pos, &col);
+            getLine(file);
+            const char *pos = file->line;
+            const char *lineEnd = getLineEnd(file);
+            const char *fieldBegin, *fieldEnd;
+            csvNextField(pos, lineEnd, delim, fieldBegin, fieldEnd);
+            convertCstr(fieldBegin, fieldEnd, &row);
+            csvNextField(pos, lineEnd, delim, fieldBegin, fieldEnd);
+            convertCstr(fieldBegin, fieldEnd, &col);
 
             rowOffsets[row + 1] += 1;
             values[i] = 1;
@@ -261,69 +251,44 @@ template <> struct ReadCsvFile<Frame> {
       if (line == NULL)
         break;
 
-      size_t pos = 0;
-      while (1) {
+      const char *pos = line;
+      const char *lineEnd = getLineEnd(file);
+      const char *fieldBegin, *fieldEnd;
+      for (col = 0; col < numCols; col++) {
+        csvNextField(pos, lineEnd, delim, fieldBegin, fieldEnd);
         switch (colTypes[col]) {
         case ValueTypeCode::SI8:
-          int8_t val_si8;
-          convertCstr(line + pos, &val_si8);
-          reinterpret_cast<int8_t *>(rawCols[col])[row] = val_si8;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<int8_t *>(rawCols[col]) + row);
           break;
         case ValueTypeCode::SI32:
-          int32_t val_si32;
-          convertCstr(line + pos, &val_si32);
-          reinterpret_cast<int32_t *>(rawCols[col])[row] = val_si32;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<int32_t *>(rawCols[col]) + row);
           break;
         case ValueTypeCode::SI64:
-          int64_t val_si64;
-          convertCstr(line + pos, &val_si64);
-          reinterpret_cast<int64_t *>(rawCols[col])[row] = val_si64;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<int64_t *>(rawCols[col]) + row);
           break;
         case ValueTypeCode::UI8:
-          uint8_t val_ui8;
-          convertCstr(line + pos, &val_ui8);
-          reinterpret_cast<uint8_t *>(rawCols[col])[row] = val_ui8;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<uint8_t *>(rawCols[col]) + row);
           break;
         case ValueTypeCode::UI32:
-          uint32_t val_ui32;
-          convertCstr(line + pos, &val_ui32);
-          reinterpret_cast<uint32_t *>(rawCols[col])[row] = val_ui32;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<uint32_t *>(rawCols[col]) + row);
           break;
         case ValueTypeCode::UI64:
-          uint64_t val_ui64;
-          convertCstr(line + pos, &val_ui64);
-          reinterpret_cast<uint64_t *>(rawCols[col])[row] = val_ui64;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<uint64_t *>(rawCols[col]) + row);
           break;
         case ValueTypeCode::F32:
-          float val_f32;
-          convertCstr(line + pos, &val_f32);
-          reinterpret_cast<float *>(rawCols[col])[row] = val_f32;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<float *>(rawCols[col]) + row);
           break;
         case ValueTypeCode::F64:
-          double val_f64;
-          convertCstr(line + pos, &val_f64);
-          reinterpret_cast<double *>(rawCols[col])[row] = val_f64;
+          convertCstr(fieldBegin, fieldEnd, reinterpret_cast<double *>(rawCols[col]) + row);
           break;
         default:
           throw std::runtime_error("ReadCsvFile::apply: unknown value type code");
         }
-
-        if (++col >= numCols) {
-          break;
-        }
-        
-        // TODO We could even exploit the fact that the strtoX functions can
-        // return a pointer to the first character after the parsed input, then
-        // we wouldn't have to search for that ourselves, just would need to
-        // check if it is really the delimiter.
-        while(line[pos] != delim) pos++;
-        pos++; // skip delimiter
       }
 
       if (++row >= numRows) {
         break;
       }
-      col = 0;
     }
     
     delete[] rawCols;
@@ -16,43 +16,220 @@
 
 #pragma once
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 
 #include <runtime/local/io/DaphneFile.h>
+#include <runtime/local/io/FileMapping.h>
+#include <runtime/local/io/ObjectStore.h>
 #include <runtime/local/io/utils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
 #include <util/preprocessor_defs.h>
 
+#include <algorithm>
+#include <memory>
+#include <tuple>
 #include <type_traits>
 #include <cassert>
+#include <cerrno>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <stdlib.h>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief A Daphne binary file read with `pread`, such that several threads can
+ * read (different parts of) it concurrently.
+ *
+ * The file may be an object in an object store (see `isObjectURL`), whose
+ * ranges are fetched as they are read, e.g., only the blocks of the rows a
+ * (distributed) worker reads.
+ */
+struct DaphneFileReader {
+	// -1 for an object
+	int fd = -1;
+	std::shared_ptr<ObjectStoreObject> object;
+
+	explicit DaphneFileReader(const char * filename) {
+		if (isObjectURL(filename)) {
+			object = ObjectStore::get().open(filename);
+			return;
+		}
+		fd = open(filename, O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error(std::string("ReadDaphne: cannot open file ") + filename);
+	}
+	DaphneFileReader(const DaphneFileReader &) = delete;
+	DaphneFileReader & operator=(const DaphneFileReader &) = delete;
+
+	~DaphneFileReader() {
+		if (fd >= 0)
+			close(fd);
+	}
+
+	uint64_t size() const {
+		if (object)
+			return object->getSize();
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+			throw std::runtime_error("ReadDaphne: cannot read the file");
+		return st.st_size;
+	}
+
+	void readBytes(uint64_t pos, void * dst, uint64_t nbytes) const {
+		if (object) {
+			if (pos > object->getSize() || nbytes > object->getSize() - pos)
+				throw std::runtime_error("ReadDaphne: unexpected end of file");
+			object->read(pos, dst, nbytes);
+			return;
+		}
+		uint8_t * d = static_cast<uint8_t *>(dst);
+		while (nbytes > 0) {
+			const ssize_t n = pread(fd, d, nbytes, pos);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				throw std::runtime_error("ReadDaphne: unexpected end of file");
+			d += n;
+			pos += n;
+			nbytes -= n;
+		}
+	}
+
+	// reads a header field at pos and advances pos
+	template <typename T>
+	void read(uint64_t & pos, T & field) const {
+		readBytes(pos, &field, sizeof(T));
+		pos += sizeof(T);
+	}
+};
+
+/**
+ * @brief Returns the blocks of a dense matrix in a Daphne binary file of
+ * version 3 or later (see `DF_version_blocks`), or no blocks for other files.
+ *
+ * The minimum and maximum value of each block allow skipping blocks, e.g., by
+ * reading only the rows of the other blocks with `readDaphneRows`.
+ */
+inline std::vector<DF_block_entry> readDaphneBlocks(const char * filename, DF_block_index * index = nullptr) {
+	DaphneFileReader f(filename);
+	uint64_t pos = 0;
+	DF_header h;
+	f.read(pos, h);
+	if (h.version < DF_version_blocks || h.dt != DF_data_t::DenseMatrix_t)
+		return {};
+	ValueTypeCode vt;
+	f.read(pos, vt);
+	DF_block_index idx;
+	f.read(pos, idx);
+	// every block has at least one row
+	if (idx.nbblocks > h.nbrows)
+		throw std::runtime_error("ReadDaphne: corrupt block index");
+	std::vector<DF_block_entry> entries(idx.nbblocks);
+	f.readBytes(pos, entries.data(), idx.nbblocks * sizeof(DF_block_entry));
+	uint64_t rx = 0;
+	for (const DF_block_entry & e : entries) {
+		if (e.rx != rx || e.nbrows == 0 || e.nbrows > h.nbrows - rx)
+			throw std::runtime_error("ReadDaphne: corrupt block index");
+		rx += e.nbrows;
+	}
+	if (rx != h.nbrows)
+		throw std::runtime_error("ReadDaphne: corrupt block index");
+	if (index)
+		*index = idx;
+	return entries;
+}
+
+
+/**
+ * @brief Reads the non-zeros of an ultra-sparse body (see
+ * `DF_body_t::ultra_sparse`) after its value type and number of non-zeros:
+ * per non-zero, its row index, its column index (omitted if the matrix has a
+ * single column), both as `uint32_t`, and its value. The non-zeros are
+ * returned in row-major order, regardless of their order in the file.
+ */
+template <typename VT>
+std::vector<std::tuple<size_t, size_t, VT>> readDaphneCOO(std::ifstream &f, const DF_body_block &bb, uint64_t nzb) {
+	const bool singleCol = bb.nbcols == 1;
+	const size_t entrySize = (singleCol ? 1 : 2) * sizeof(uint32_t) + sizeof(VT);
+	std::vector<char> buf(nzb * entrySize);
+	f.read(buf.data(), buf.size());
+	if (static_cast<uint64_t>(f.gcount()) != buf.size())
+		throw std::runtime_error("ReadDaphne: unexpected end of file");
+
+	std::vector<std::tuple<size_t, size_t, VT>> nonZeros(nzb);
+	const char * entry = buf.data();
+	for (uint64_t n = 0; n < nzb; n++, entry += entrySize) {
+		uint32_t i;
+		uint32_t j = 0;
+		VT val;
+		memcpy(&i, entry, sizeof(i));
+		if (!singleCol)
+			memcpy(&j, entry + sizeof(i), sizeof(j));
+		memcpy(&val, entry + entrySize - sizeof(VT), sizeof(VT));
+		if (i >= bb.nbrows || j >= bb.nbcols)
+			throw std::runtime_error("ReadDaphne: index of a non-zero out of bounds");
+		nonZeros[n] = {i, j, val};
+	}
+	const auto byCoords = [](const auto & a, const auto & b) {
+		return std::get<0>(a) != std::get<0>(b) ? std::get<0>(a) < std::get<0>(b) : std::get<1>(a) < std::get<1>(b);
+	};
+	if (!std::is_sorted(nonZeros.begin(), nonZeros.end(), byCoords))
+		std::sort(nonZeros.begin(), nonZeros.end(), byCoords);
+	return nonZeros;
+}
 
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
 
 template <class DTRes> struct ReadDaphne {
-  static void apply(DTRes *&res, const char *filename) = delete;
+  static void apply(DTRes *&res, const char *filename, bool mapped, DCTX(ctx)) = delete;
 };
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
+/**
+ * @brief Reads a data object from a Daphne binary file.
+ *
+ * @param mapped Whether to map a matrix file into memory and use its arrays
+ * without copying, if the file format allows that (version 2 or later, see
+ * `DF_body_alignment`). Otherwise, the file is read into new arrays.
+ * @param ctx The context on whose workers the parts of a dense matrix are read
+ * and decompressed, sequentially without a context.
+ */
 template <class DTRes>
-void readDaphne(DTRes *&res, const char *filename) {
-  ReadDaphne<DTRes>::apply(res, filename);
+void readDaphne(DTRes *&res, const char *filename, bool mapped = false, DCTX(ctx) = nullptr) {
+  ReadDaphne<DTRes>::apply(res, filename, mapped, ctx);
+}
+
+/**
+ * @brief Reads the rows [rowBegin, rowEnd) of a dense matrix from a Daphne
+ * binary file. Of a file with blocks (version 3 or later), only the blocks
+ * containing these rows are read.
+ */
+template <typename VT>
+void readDaphneRows(DenseMatrix<VT> *&res, const char *filename, size_t rowBegin, size_t rowEnd,
+    DCTX(ctx) = nullptr) {
+  ReadDaphne<DenseMatrix<VT>>::applyRows(res, filename, rowBegin, rowEnd, ctx);
 }
 
 // ****************************************************************************
@@ -60,57 +237,245 @@ void readDaphne(DTRes *&res, const char *filename) {
 // ****************************************************************************
 
 template <typename VT> struct ReadDaphne<DenseMatrix<VT>> {
-  static void apply(DenseMatrix<VT> *&res, const char *filename) {
+  static bool applyMapped(DenseMatrix<VT> *&res, const char *filename) {
+    std::shared_ptr<FileMapping> m = FileMapping::map(filename);
+    if (!m)
+      return false;
 
-    std::ifstream f;
-    f.open(filename, std::ios::in|std::ios::binary);
-    // TODO: check f.good()
-
-    // read header
+    uint64_t pos = 0;
     DF_header h;
-    f.read((char *)&h, sizeof(h));
+    ValueTypeCode vt;
+    DF_body b;
+    DF_body_block bb;
+    if (!m->read(pos, h) || h.version < 2 || h.dt != DF_data_t::DenseMatrix_t || !m->read(pos, vt)
+        || !m->read(pos, b) || !m->read(pos, bb) || bb.bt != DF_body_t::dense || !m->read(pos, vt)
+        || vt != ValueTypeUtils::codeFor<VT>)
+      return false;
+
+    pos = DF_align(pos);
+    VT * vals = m->template array<VT>(pos, uint64_t(bb.nbrows) * bb.nbcols);
+    if (!vals)
+      return false;
+    // the values keep the mapping alive
+    auto values = std::shared_ptr<VT[]>(m, vals);
+    res = DataObjectFactory::create<DenseMatrix<VT>>(static_cast<size_t>(bb.nbrows), static_cast<size_t>(bb.nbcols),
+        values);
+    return true;
+  }
 
-    if (h.dt == DF_data_t::DenseMatrix_t) {
-	    ValueTypeCode vt;
-	    f.read((char *)&vt, sizeof(vt));
+  static void apply(DenseMatrix<VT> *&res, const char *filename, bool mapped, DCTX(ctx)) {
+    if (mapped && applyMapped(res, filename))
+      return;
+    applyRows(res, filename, 0, std::numeric_limits<size_t>::max(), ctx);
+  }
 
-	    DF_body b;
-	    f.read((char *)&b, sizeof(b));
-	    // b is ignored for now - assumed to be 0,0
-	    //TODO: consider multiple blocks
+  // rowEnd is the number of rows of the file if it is the maximum of size_t
+  static void applyRows(DenseMatrix<VT> *&res, const char *filename, size_t rowBegin, size_t rowEnd,
+      DCTX(ctx)) {
+    DaphneFileReader f(filename);
+    uint64_t pos = 0;
 
-	    DF_body_block bb;
-	    f.read((char *)&bb,sizeof(bb));
-	    // empty Matrix
-	    if (bb.bt == DF_body_t::empty) {
-		res = DataObjectFactory::create<DenseMatrix<VT>>(0, 0, false);
-		goto exit;
+    // read header
+    DF_header h;
+    f.read(pos, h);
+    if (h.dt != DF_data_t::DenseMatrix_t)
+      return;
+
+    ValueTypeCode vt;
+    f.read(pos, vt);
+
+    if (rowEnd == std::numeric_limits<size_t>::max())
+      rowEnd = h.nbrows;
+    if (rowBegin > rowEnd || rowEnd > h.nbrows)
+      throw std::runtime_error("ReadDaphne: the rows to read are out of bounds");
+
+    if (h.version < DF_version_blocks) {
+      DF_body b;
+      f.read(pos, b);
+      // b is ignored for now - assumed to be 0,0
+
+      DF_body_block bb;
+      f.read(pos, bb);
+      // empty Matrix
+      if (bb.bt == DF_body_t::empty) {
+        res = DataObjectFactory::create<DenseMatrix<VT>>(0, 0, false);
+        return;
+      }
+      if (bb.bt != DF_body_t::dense)
+        return;
+    }
 
-	    // Dense Matrix
-	    } else if (bb.bt == DF_body_t::dense) {
-		 f.read((char *)&vt, sizeof(vt));
+    auto out = DataObjectFactory::create<DenseMatrix<VT>>(rowEnd - rowBegin, static_cast<size_t>(h.nbcols), false);
+    try {
+      readRows(out->getValues(), filename, f, h, vt, pos, rowBegin, rowEnd, ctx);
+    } catch (...) {
+      DataObjectFactory::destroy(out);
+      throw;
+    }
+    res = out;
+  }
 
-         size_t numItems = bb.nbrows*bb.nbcols;
-         std::streamsize memBlockSize = numItems * sizeof(VT);
-         auto memblock = std::shared_ptr<VT[]>(new VT[numItems], std::default_delete<VT[]>());
-         f.read(reinterpret_cast<char*>(memblock.get()), memBlockSize);
-		 res = DataObjectFactory::create<DenseMatrix<VT>>(static_cast<size_t>(bb.nbrows), static_cast<size_t>(bb.nbcols),
-                 memblock);
+  /**
+   * @brief Reads the values of a dense matrix of the given shape into `dst`, whose rows are contiguous, e.g., those
+   * of a matrix spilled to disk (see `AllocationDescriptorDisk`).
+   */
+  static void readValues(VT *dst, const char *filename, uint64_t numRows, uint64_t numCols, DCTX(ctx)) {
+    DaphneFileReader f(filename);
+    uint64_t pos = 0;
+    DF_header h;
+    f.read(pos, h);
+    ValueTypeCode vt;
+    f.read(pos, vt);
+    if (h.dt != DF_data_t::DenseMatrix_t || h.nbrows != numRows || h.nbcols != numCols)
+      throw std::runtime_error(std::string("ReadDaphne: file ") + filename + " does not match the matrix");
+    if (h.version < DF_version_blocks) {
+      DF_body b;
+      f.read(pos, b);
+      DF_body_block bb;
+      f.read(pos, bb);
+      if (bb.bt != DF_body_t::dense)
+        throw std::runtime_error(std::string("ReadDaphne: file ") + filename + " does not match the matrix");
+    }
+    readRows(dst, filename, f, h, vt, pos, 0, numRows, ctx);
+  }
 
-		 goto exit;
-	    }
+  // reads the rows [rowBegin, rowEnd) into dst, pos is after the dense body block of a file without blocks
+  static void readRows(VT *dstValues, const char *filename, const DaphneFileReader &f, const DF_header &h,
+      ValueTypeCode vt, uint64_t pos, size_t rowBegin, size_t rowEnd, DCTX(ctx)) {
+    if (h.version >= DF_version_blocks) {
+      readBlocks(dstValues, filename, f, h, vt, rowBegin, rowEnd, ctx);
+      return;
     }
-exit:
-   f.close();
-   return;
+
+    f.read(pos, vt);
+    if (h.version >= 2)
+      pos = DF_align(pos);
+
+    // the rows are read in parts of DF_default_block_bytes in parallel
+    const uint64_t rowBytes = h.nbcols * sizeof(VT);
+    const uint64_t begin = pos + rowBegin * rowBytes;
+    const uint64_t nbytes = (rowEnd - rowBegin) * rowBytes;
+    uint8_t * dst = reinterpret_cast<uint8_t *>(dstValues);
+    const uint64_t numParts = (nbytes + DF_default_block_bytes - 1) / DF_default_block_bytes;
+    WorkerPool::parallelFor(ctx, numParts, [&](size_t i) {
+      const uint64_t offset = i * DF_default_block_bytes;
+      f.readBytes(begin + offset, dst + offset, std::min(DF_default_block_bytes, nbytes - offset));
+    });
+  }
+
+  static void readBlocks(VT *dstValues, const char *filename, const DaphneFileReader &f, const DF_header &h,
+      ValueTypeCode vt, size_t rowBegin, size_t rowEnd, DCTX(ctx)) {
+    if (vt != ValueTypeUtils::codeFor<VT>)
+      throw std::runtime_error("ReadDaphne: the value type of the file does not match the matrix");
+    DF_block_index idx;
+    const std::vector<DF_block_entry> entries = readDaphneBlocks(filename, &idx);
+    if (idx.compression != DF_compression_t::none
+#ifdef USE_ZLIB
+        && idx.compression != DF_compression_t::zlib
+#endif
+#ifdef USE_LZ4
+        && idx.compression != DF_compression_t::lz4
+#endif
+    )
+      throw std::runtime_error("ReadDaphne: the compression of the file is not supported");
+
+    const uint64_t rowBytes = h.nbcols * sizeof(VT);
+    uint8_t * dst = reinterpret_cast<uint8_t *>(dstValues);
+    WorkerPool::parallelFor(ctx, entries.size(), [&](size_t i) {
+      const DF_block_entry & e = entries[i];
+      const uint64_t first = std::max<uint64_t>(e.rx, rowBegin);
+      const uint64_t last = std::min<uint64_t>(e.rx + e.nbrows, rowEnd);
+      if (first >= last)
+        return;
+      // blocks are read (and checked) as a whole, those inside the rows directly into the matrix
+      const bool whole = first == e.rx && last == e.rx + e.nbrows;
+      uint8_t * rowsDst = dst + (first - rowBegin) * rowBytes;
+      const uint64_t rawBytes = e.nbrows * rowBytes;
+      std::vector<uint8_t> stored;
+      std::vector<uint8_t> raw;
+      uint8_t * storedData = rowsDst;
+      if (idx.compression != DF_compression_t::none || !whole) {
+        stored.resize(e.nbytes);
+        storedData = stored.data();
+      }
+      if (idx.compression == DF_compression_t::none && e.nbytes != rawBytes)
+        throw std::runtime_error("ReadDaphne: corrupt block index");
+      f.readBytes(e.offset, storedData, e.nbytes);
+      if (DF_crc32(0, storedData, e.nbytes) != e.checksum)
+        throw std::runtime_error("ReadDaphne: checksum mismatch in the block of row " + std::to_string(e.rx));
+
+      const uint8_t * rawData = storedData;
+#ifdef USE_ZLIB
+      if (idx.compression == DF_compression_t::zlib) {
+        uint8_t * decompressed = rowsDst;
+        if (!whole) {
+          raw.resize(rawBytes);
+          decompressed = raw.data();
+        }
+        uLongf n = rawBytes;
+        if (uncompress(decompressed, &n, storedData, e.nbytes) != Z_OK || n != rawBytes)
+          throw std::runtime_error("ReadDaphne: corrupt block of row " + std::to_string(e.rx));
+        rawData = decompressed;
+      }
+#endif
+#ifdef USE_LZ4
+      if (idx.compression == DF_compression_t::lz4) {
+        uint8_t * decompressed = rowsDst;
+        if (!whole) {
+          raw.resize(rawBytes);
+          decompressed = raw.data();
+        }
+        const int n = LZ4_decompress_safe(reinterpret_cast<const char *>(storedData),
+            reinterpret_cast<char *>(decompressed), static_cast<int>(e.nbytes), static_cast<int>(rawBytes));
+        if (n < 0 || static_cast<uint64_t>(n) != rawBytes)
+          throw std::runtime_error("ReadDaphne: corrupt block of row " + std::to_string(e.rx));
+        rawData = decompressed;
+      }
+#endif
+      if (!whole)
+        memcpy(rowsDst, rawData + (first - e.rx) * rowBytes, (last - first) * rowBytes);
+    });
   }
 };
 
 template <typename VT> struct ReadDaphne<CSRMatrix<VT>> {
-  static void apply(CSRMatrix<VT> *&res, const char *filename) {
+  static bool applyMapped(CSRMatrix<VT> *&res, const char *filename) {
+    std::shared_ptr<FileMapping> m = FileMapping::map(filename);
+    if (!m)
+      return false;
+
+    uint64_t pos = 0;
+    DF_header h;
+    ValueTypeCode vt;
+    DF_body b;
+    DF_body_block bb;
+    uint64_t nzb;
+    if (!m->read(pos, h) || h.version < 2 || h.dt != DF_data_t::CSRMatrix_t || !m->read(pos, vt)
+        || !m->read(pos, b) || !m->read(pos, bb) || bb.bt != DF_body_t::csr || !m->read(pos, vt)
+        || vt != ValueTypeUtils::codeFor<VT> || !m->read(pos, nzb))
+      return false;
+
+    pos = DF_align(pos);
+    size_t * rowOffsets = m->template array<size_t>(pos, uint64_t(bb.nbrows) + 1);
+    pos = DF_align(pos);
+    size_t * colIdxs = rowOffsets ? m->template array<size_t>(pos, nzb) : nullptr;
+    pos = DF_align(pos);
+    VT * vals = colIdxs ? m->template array<VT>(pos, nzb) : nullptr;
+    if (!vals)
+      return false;
+    // the arrays keep the mapping alive
+    res = DataObjectFactory::create<CSRMatrix<VT>>(static_cast<size_t>(bb.nbrows), static_cast<size_t>(bb.nbcols),
+        static_cast<size_t>(nzb), std::shared_ptr<VT>(m, vals), std::shared_ptr<size_t>(m, colIdxs),
+        std::shared_ptr<size_t>(m, rowOffsets));
+    return true;
+  }
+
+  static void apply(CSRMatrix<VT> *&res, const char *filename, bool mapped, DCTX(ctx)) {
+    if (mapped && applyMapped(res, filename))
+      return;
 
     std::ifstream f;
-    f.open(filename, std::ios::in|std::ios::binary);
+    f.open(ObjectStore::localPath(filename), std::ios::in|std::ios::binary);
     // TODO: check f.good()
 
     // read header
@@ -160,8 +525,8 @@ template <typename VT> struct ReadDaphne<CSRMatrix<VT>> {
 
 		goto exit;
 
-            // COO Matrix
-	    } else if (bb.bt == DF_body_t::ultra_sparse) {
+	    // CSR arrays
+	    } else if (bb.bt == DF_body_t::csr) {
 		    uint8_t vt;
 		    f.read((char *)&vt, sizeof(vt));
 
@@ -171,35 +536,39 @@ template <typename VT> struct ReadDaphne<CSRMatrix<VT>> {
 		    res = DataObjectFactory::create<CSRMatrix<VT>>(
 				bb.nbrows, bb.nbcols, nzb, false);
 
-		   // Single column case
-		   if (bb.nbcols == 1) {
-			for (uint64_t n = 0; n < nzb; n++) {
-				uint32_t i;
-				f.read((char *)&i, sizeof(i));
+		    f.seekg(DF_align(f.tellg()));
+		    f.read((char *)res->getRowOffsets(), (bb.nbrows + 1) * sizeof(size_t));
+		    f.seekg(DF_align(f.tellg()));
+		    f.read((char *)res->getColIdxs(), nzb * sizeof(size_t));
+		    f.seekg(DF_align(f.tellg()));
+		    f.read((char *)res->getValues(), nzb * sizeof(VT));
 
-				VT val;
-				f.read((char *)&val, sizeof(val));
-
-				res->set(i, 1, val);
-			}
-			goto exit;
-		   } else {
-			   // TODO: check numcols is greater than 1
-			for (uint64_t n = 0; n < nzb; n++) {
-				uint32_t i;
-				f.read((char *)&i, sizeof(i));
+		goto exit;
 
-				uint32_t j;
-				f.read((char *)&j, sizeof(j));
+            // COO Matrix
+	    } else if (bb.bt == DF_body_t::ultra_sparse) {
+		    uint8_t vt;
+		    f.read((char *)&vt, sizeof(vt));
 
-				VT val;
-				f.read((char *)&val, sizeof(val));
+		    uint64_t nzb;
+		    f.read((char *)&nzb, sizeof(nzb));
 
-				res->set(i, j, val);
-			}
-			goto exit;
-		   }
+		    const auto nonZeros = readDaphneCOO<VT>(f, bb, nzb);
+		    res = DataObjectFactory::create<CSRMatrix<VT>>(
+				bb.nbrows, bb.nbcols, nzb, false);
+		    size_t * rowOffsets = res->getRowOffsets();
+		    size_t * colIdxs = res->getColIdxs();
+		    VT * vals = res->getValues();
+		    std::fill(rowOffsets, rowOffsets + bb.nbrows + 1, 0);
+		    for (uint64_t n = 0; n < nzb; n++) {
+			    rowOffsets[std::get<0>(nonZeros[n]) + 1]++;
+			    colIdxs[n] = std::get<1>(nonZeros[n]);
+			    vals[n] = std::get<2>(nonZeros[n]);
+		    }
+		    for (size_t i = 0; i < bb.nbrows; i++)
+			    rowOffsets[i + 1] += rowOffsets[i];
 
+		goto exit;
 	    }
 	    //TODO: frames
 exit:
@@ -209,11 +578,137 @@ exit:
   }
 };
 
+template <typename VT> struct ReadDaphne<DCSRMatrix<VT>> {
+  static void apply(DCSRMatrix<VT> *&res, const char *filename, bool mapped, DCTX(ctx)) {
+    std::ifstream f;
+    f.open(ObjectStore::localPath(filename), std::ios::in|std::ios::binary);
+    if (!f.good())
+      throw std::runtime_error(std::string("ReadDaphne: cannot open file ") + filename);
+
+    DF_header h;
+    uint8_t vt;
+    DF_body b;
+    DF_body_block bb;
+    f.read((char *)&h, sizeof(h));
+    f.read((char *)&vt, sizeof(vt));
+    f.read((char *)&b, sizeof(b));
+    f.read((char *)&bb, sizeof(bb));
+    if (!f.good() || h.dt != DF_data_t::CSRMatrix_t)
+      throw std::runtime_error("ReadDaphne: the file does not contain a sparse matrix");
+
+    // other bodies are read as a CSRMatrix first, whose rows are all stored
+    if (bb.bt != DF_body_t::ultra_sparse) {
+      f.close();
+      CSRMatrix<VT> * csr = nullptr;
+      ReadDaphne<CSRMatrix<VT>>::apply(csr, filename, mapped, ctx);
+      res = DataObjectFactory::create<DCSRMatrix<VT>>(csr->getNumRows(), csr->getNumCols(), csr->getNumNonZeros());
+      for (size_t r = 0; r < csr->getNumRows(); r++) {
+        const size_t * colIdxs = csr->getColIdxs(r);
+        const VT * vals = csr->getValues(r);
+        for (size_t i = 0; i < csr->getNumNonZeros(r); i++)
+          res->append(r, colIdxs[i], vals[i]);
+      }
+      DataObjectFactory::destroy(csr);
+      return;
+    }
+
+    uint64_t nzb;
+    f.read((char *)&vt, sizeof(vt));
+    f.read((char *)&nzb, sizeof(nzb));
+    if (static_cast<ValueTypeCode>(vt) != ValueTypeUtils::codeFor<VT>)
+      throw std::runtime_error("ReadDaphne: the value type of the file does not match");
+    const auto nonZeros = readDaphneCOO<VT>(f, bb, nzb);
+    res = DataObjectFactory::create<DCSRMatrix<VT>>(bb.nbrows, bb.nbcols, nzb);
+    for (const auto & [i, j, val] : nonZeros)
+      res->append(i, j, val);
+    f.close();
+  }
+};
+
+/**
+ * @brief An index on the key columns of a frame as stored next to its Daphne
+ * binary file, see `DF_key_indexes_header`.
+ */
+struct DF_key_index {
+	std::vector<size_t> keyCols;
+	std::vector<size_t> begins;
+	std::vector<size_t> rows;
+};
+
+/**
+ * @brief Reads the indexes stored next to the Daphne binary file of a frame
+ * with the given number of columns and rows, or none if there is no such file
+ * or the frame's file was changed since they were written.
+ *
+ * The indexes are checked to group all rows when they are recreated, see
+ * `KeyIndexes::restore()`.
+ */
+inline std::vector<DF_key_index> readDaphneKeyIndexes(const char * filename, uint64_t numRows, uint64_t numCols) {
+	const std::string idxFilename = std::string(filename) + DF_key_indexes_suffix;
+	struct stat st;
+	struct stat stIdx;
+	if (stat(filename, &st) != 0 || stat(idxFilename.c_str(), &stIdx) != 0)
+		return {};
+	const uint64_t idxBytes = stIdx.st_size;
+	DaphneFileReader f(idxFilename.c_str());
+	uint64_t pos = 0;
+	DF_key_indexes_header h;
+	if (idxBytes < sizeof(h))
+		throw std::runtime_error("ReadDaphne: corrupt indexes " + idxFilename);
+	f.read(pos, h);
+	if (h.magic != DF_key_indexes_magic)
+		throw std::runtime_error("ReadDaphne: corrupt indexes " + idxFilename);
+	if (h.nbrows != numRows || h.framebytes != static_cast<uint64_t>(st.st_size))
+		return {};
+
+	// each index takes at least three numbers
+	if (h.nbindexes > idxBytes / (3 * sizeof(uint64_t)))
+		throw std::runtime_error("ReadDaphne: corrupt indexes " + idxFilename);
+	std::vector<DF_key_index> keyIndexes(h.nbindexes);
+	std::vector<uint64_t> numKeys(h.nbindexes);
+	for (uint64_t i = 0; i < h.nbindexes; i++) {
+		uint64_t numKeyCols;
+		f.read(pos, numKeyCols);
+		if (numKeyCols == 0 || numKeyCols > numCols)
+			throw std::runtime_error("ReadDaphne: corrupt indexes " + idxFilename);
+		keyIndexes[i].keyCols.resize(numKeyCols);
+		f.readBytes(pos, keyIndexes[i].keyCols.data(), numKeyCols * sizeof(uint64_t));
+		pos += numKeyCols * sizeof(uint64_t);
+		for (size_t c : keyIndexes[i].keyCols)
+			if (c >= numCols)
+				throw std::runtime_error("ReadDaphne: corrupt indexes " + idxFilename);
+		f.read(pos, numKeys[i]);
+		if (numKeys[i] > numRows)
+			throw std::runtime_error("ReadDaphne: corrupt indexes " + idxFilename);
+	}
+	for (uint64_t i = 0; i < h.nbindexes; i++) {
+		if (pos + (numKeys[i] + 1 + numRows) * sizeof(uint64_t) > idxBytes)
+			throw std::runtime_error("ReadDaphne: corrupt indexes " + idxFilename);
+		keyIndexes[i].begins.resize(numKeys[i] + 1);
+		f.readBytes(pos, keyIndexes[i].begins.data(), (numKeys[i] + 1) * sizeof(uint64_t));
+		pos += (numKeys[i] + 1) * sizeof(uint64_t);
+		keyIndexes[i].rows.resize(numRows);
+		f.readBytes(pos, keyIndexes[i].rows.data(), numRows * sizeof(uint64_t));
+		pos += numRows * sizeof(uint64_t);
+	}
+	return keyIndexes;
+}
+
 template <> struct ReadDaphne<Frame> {
-  static void apply(Frame *&res, const char *filename){
+  static void apply(Frame *&res, const char *filename, bool mapped, DCTX(ctx)){
+    {
+      DaphneFileReader fr(filename);
+      uint64_t pos = 0;
+      DF_header h;
+      fr.read(pos, h);
+      if (h.version >= DF_version_frame && h.dt == DF_data_t::Frame_t) {
+        readColumns(res, fr, pos, h, ctx);
+        return;
+      }
+    }
 
     std::ifstream f;
-    f.open(filename, std::ios::in|std::ios::binary);
+    f.open(ObjectStore::localPath(filename), std::ios::in|std::ios::binary);
     // TODO: check f.good()
 
     // read commong part of the header
@@ -305,4 +800,84 @@ template <> struct ReadDaphne<Frame> {
     f.close();
     return;
   }
+
+  // reads a frame stored column by column (version 4 or later), see DF_version_frame
+  static void readColumns(Frame *&res, const DaphneFileReader &f, uint64_t pos, const DF_header &h,
+      DCTX(ctx)) {
+    const uint64_t fileSize = f.size();
+    const uint64_t numRows = h.nbrows;
+    const uint64_t numCols = h.nbcols;
+    // every column has at least a byte per row
+    if (numCols > fileSize || (numCols > 0 && numRows > fileSize))
+      throw std::runtime_error("ReadDaphne: corrupt frame header");
+
+    std::vector<ValueTypeCode> schema(numCols);
+    f.readBytes(pos, schema.data(), numCols * sizeof(ValueTypeCode));
+    pos += numCols * sizeof(ValueTypeCode);
+    std::vector<std::string> labels(numCols);
+    for (uint64_t c = 0; c < numCols; c++) {
+      uint16_t len;
+      f.read(pos, len);
+      labels[c].resize(len);
+      f.readBytes(pos, &labels[c][0], len);
+      pos += len;
+    }
+    std::vector<DF_frame_column> cols(numCols);
+    f.readBytes(pos, cols.data(), numCols * sizeof(DF_frame_column));
+    for (uint64_t c = 0; c < numCols; c++) {
+      const DF_frame_column &col = cols[c];
+      const bool isStr = schema[c] == ValueTypeCode::STR;
+      // string columns are never plain, all others always
+      if ((col.ct == DF_column_t::plain) == isStr || col.offset > fileSize || col.nbytes > fileSize
+          || col.dictsize > numRows
+          || DF_layoutColumn(col, numRows, isStr ? 0 : ValueTypeUtils::sizeOf(schema[c])).end > fileSize)
+        throw std::runtime_error("ReadDaphne: corrupt frame column " + std::to_string(c));
+    }
+
+    if (res == nullptr)
+      res = DataObjectFactory::create<Frame>(numRows, numCols, schema.data(), labels.data(), false);
+
+    WorkerPool::parallelFor(ctx, numCols, [&](size_t c) {
+      const DF_frame_column &col = cols[c];
+      const DF_column_layout l = DF_layoutColumn(col, numRows,
+          schema[c] == ValueTypeCode::STR ? 0 : ValueTypeUtils::sizeOf(schema[c]));
+      if (col.ct == DF_column_t::plain) {
+        f.readBytes(l.values, res->getColumnRaw(c), l.end - l.values);
+        return;
+      }
+      const uint64_t numStrings = col.ct == DF_column_t::strings ? numRows : col.dictsize;
+      std::vector<uint64_t> offsets(numStrings + 1);
+      f.readBytes(l.offsets, offsets.data(), offsets.size() * sizeof(uint64_t));
+      std::string bytes(col.nbytes, '\0');
+      f.readBytes(l.values, &bytes[0], col.nbytes);
+      if (offsets[0] != 0 || offsets[numStrings] != col.nbytes)
+        throw std::runtime_error("ReadDaphne: corrupt string column " + std::to_string(c));
+      for (uint64_t i = 0; i < numStrings; i++)
+        if (offsets[i + 1] < offsets[i])
+          throw std::runtime_error("ReadDaphne: corrupt string column " + std::to_string(c));
+
+      if (col.ct == DF_column_t::strings) {
+        std::string *values = static_cast<std::string *>(res->getColumnRaw(c));
+        for (uint64_t r = 0; r < numRows; r++)
+          values[r].assign(bytes, offsets[r], offsets[r + 1] - offsets[r]);
+        return;
+      }
+      // a dictionary column stays dictionary-encoded in the frame
+      auto dictionary = std::make_shared<std::vector<std::string>>(numStrings);
+      for (uint64_t i = 0; i < numStrings; i++) {
+        (*dictionary)[i].assign(bytes, offsets[i], offsets[i + 1] - offsets[i]);
+        if (i > 0 && !((*dictionary)[i - 1] < (*dictionary)[i]))
+          throw std::runtime_error("ReadDaphne: the dictionary of column " + std::to_string(c) + " is not sorted");
+      }
+      std::vector<uint32_t> codes(numRows);
+      f.readBytes(l.codes, codes.data(), numRows * sizeof(uint32_t));
+      BitPackedArray packed(numRows, BitPackedArray::bitWidthFor(numStrings ? numStrings - 1 : 0));
+      for (uint64_t r = 0; r < numRows; r++) {
+        if (codes[r] >= numStrings)
+          throw std::runtime_error("ReadDaphne: corrupt dictionary codes of column " + std::to_string(c));
+        packed.init(r, codes[r]);
+      }
+      res->setEncodedColumn(c, std::make_shared<DictionaryColumn<std::string>>(dictionary, std::move(packed)));
+    });
+  }
 };
@@ -0,0 +1,557 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifdef USE_HDF5
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/io/FileMetaData.h>
+#include <runtime/local/io/ObjectStore.h>
+#include <runtime/local/io/utils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <hdf5.h>
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// ****************************************************************************
+// HDF5 datasets
+// ****************************************************************************
+
+/**
+ * @brief The dataset of a matrix in an HDF5 file: the dataset `data` in the
+ * root group if there is one, otherwise the only dataset in the root group. A
+ * one-dimensional dataset is a column vector.
+ *
+ * The HDF5 library is not thread-safe (in its default build), thus, all its
+ * calls are serialized by `mutex()`. The chunks of a chunked dataset (and the
+ * rows of a contiguous one) are read by `pread` and decoded (deflate and
+ * shuffle) in parallel outside of the library, if the values are stored as
+ * the value type of the matrix; otherwise, the library reads and converts
+ * them.
+ */
+class HDF5Dataset {
+  // an identifier of the HDF5 library, closed by the given function
+  struct Handle {
+    hid_t id = H5I_INVALID_HID;
+    herr_t (*closer)(hid_t) = nullptr;
+
+    Handle() = default;
+    Handle(hid_t id, herr_t (*closer)(hid_t)) : id(id), closer(closer) {}
+    Handle(const Handle &) = delete;
+    Handle &operator=(const Handle &) = delete;
+    Handle &operator=(Handle &&other) noexcept {
+      std::swap(id, other.id);
+      std::swap(closer, other.closer);
+      return *this;
+    }
+    ~Handle() {
+      if (id >= 0 && closer)
+        closer(id);
+    }
+    operator hid_t() const { return id; }
+  };
+
+  // a chunk intersecting the rows and columns read, whose bytes start at `addr` in the file (unless it is not
+  // allocated, i.e., holds the fill value)
+  struct Chunk {
+    uint64_t row;
+    uint64_t col;
+    haddr_t addr;
+    hsize_t nbytes;
+    unsigned filterMask;
+  };
+
+  const std::string filename;
+  // the local file, a copy of an object in an object store
+  std::string path;
+  Handle file;
+  Handle dset;
+  Handle type;
+  Handle dcpl;
+  int rank = 0;
+  hsize_t chunkDims[2] = {1, 1};
+  // the filters of a chunked dataset in the order they were applied when writing, with the element size of shuffle
+  std::vector<std::pair<H5Z_filter_t, size_t>> filters;
+  bool hasUserBlock = false;
+
+  void check(bool ok, const std::string &what) const {
+    if (!ok)
+      throw std::runtime_error("ReadHDF5: cannot " + what + " of file " + filename);
+  }
+
+#if H5_VERSION_GE(1, 12, 0)
+  using LinkInfo = H5L_info2_t;
+#else
+  using LinkInfo = H5L_info_t;
+#endif
+
+  static herr_t collectDataset(hid_t group, const char *name, const LinkInfo *, void *data) {
+    const hid_t obj = H5Oopen(group, name, H5P_DEFAULT);
+    if (obj < 0)
+      return 0;
+    if (H5Iget_type(obj) == H5I_DATASET)
+      static_cast<std::vector<std::string> *>(data)->emplace_back(name);
+    H5Oclose(obj);
+    return 0;
+  }
+
+  template <typename VT> static hid_t nativeType() {
+    if constexpr (std::is_same<VT, double>::value) return H5T_NATIVE_DOUBLE;
+    else if constexpr (std::is_same<VT, float>::value) return H5T_NATIVE_FLOAT;
+    else if constexpr (std::is_same<VT, int8_t>::value) return H5T_NATIVE_INT8;
+    else if constexpr (std::is_same<VT, int32_t>::value) return H5T_NATIVE_INT32;
+    else if constexpr (std::is_same<VT, int64_t>::value) return H5T_NATIVE_INT64;
+    else if constexpr (std::is_same<VT, uint8_t>::value) return H5T_NATIVE_UINT8;
+    else if constexpr (std::is_same<VT, uint32_t>::value) return H5T_NATIVE_UINT32;
+    else if constexpr (std::is_same<VT, uint64_t>::value) return H5T_NATIVE_UINT64;
+    else
+      static_assert(!std::is_same<VT, VT>::value, "ReadHDF5: unsupported value type");
+  }
+
+  void readLabels() {
+    if (H5Aexists(dset, "labels") <= 0)
+      return;
+    Handle attr(H5Aopen(dset, "labels", H5P_DEFAULT), H5Aclose);
+    check(attr >= 0, "read the labels");
+    Handle space(H5Aget_space(attr), H5Sclose);
+    const hssize_t n = H5Sget_simple_extent_npoints(space);
+    Handle atype(H5Aget_type(attr), H5Tclose);
+    if (n != hssize_t(numCols) || H5Tget_class(atype) != H5T_STRING)
+      throw std::runtime_error("ReadHDF5: the labels of file " + filename + " are not a string per column");
+    if (H5Tis_variable_str(atype) > 0) {
+      Handle memType(H5Tcopy(H5T_C_S1), H5Tclose);
+      H5Tset_size(memType, H5T_VARIABLE);
+      std::vector<char *> strs(n, nullptr);
+      check(H5Aread(attr, memType, strs.data()) >= 0, "read the labels");
+      for (char *s : strs)
+        labels.emplace_back(s ? s : "");
+      Handle memSpace(H5Screate_simple(1, std::vector<hsize_t>{hsize_t(n)}.data(), nullptr), H5Sclose);
+#if H5_VERSION_GE(1, 12, 0)
+      H5Treclaim(memType, memSpace, H5P_DEFAULT, strs.data());
+#else
+      H5Dvlen_reclaim(memType, memSpace, H5P_DEFAULT, strs.data());
+#endif
+    } else {
+      const size_t len = H5Tget_size(atype);
+      std::vector<char> buf(len * n);
+      check(H5Aread(attr, atype, buf.data()) >= 0, "read the labels");
+      for (hssize_t c = 0; c < n; c++) {
+        const char *s = buf.data() + c * len;
+        labels.emplace_back(s, strnlen(s, len));
+      }
+    }
+  }
+
+  static void preadAll(int fd, void *dst, uint64_t nbytes, uint64_t pos) {
+    uint8_t *d = static_cast<uint8_t *>(dst);
+    while (nbytes > 0) {
+      const ssize_t n = pread(fd, d, nbytes, pos);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        throw std::runtime_error("ReadHDF5: unexpected end of file");
+      d += n;
+      pos += n;
+      nbytes -= n;
+    }
+  }
+
+  // reverses the shuffle filter, which stores the first bytes of all elements, then the second bytes, and so on
+  static void unshuffle(const uint8_t *src, uint8_t *dst, size_t nbytes, size_t elemSize) {
+    const size_t n = elemSize ? nbytes / elemSize : 0;
+    for (size_t b = 0; b < elemSize; b++)
+      for (size_t e = 0; e < n; e++)
+        dst[e * elemSize + b] = src[b * n + e];
+    std::memcpy(dst + n * elemSize, src + n * elemSize, nbytes - n * elemSize);
+  }
+
+  // whether the chunks can be decoded outside of the library
+  bool canDecodeChunks() const {
+    for (const auto &f : filters) {
+      if (f.first == H5Z_FILTER_SHUFFLE)
+        continue;
+#ifdef USE_ZLIB
+      if (f.first == H5Z_FILTER_DEFLATE)
+        continue;
+#endif
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Decodes the bytes of a chunk by the filters not skipped for it (in reverse order) into `dst` of `nbytes`,
+   * the size of a full chunk.
+   */
+  void decodeChunk(const std::vector<uint8_t> &raw, unsigned filterMask, uint8_t *dst, size_t nbytes) const {
+    std::vector<size_t> applied;
+    for (size_t i = 0; i < filters.size(); i++)
+      if (!(filterMask & (1u << i)))
+        applied.push_back(i);
+    if (applied.empty()) {
+      if (raw.size() != nbytes)
+        throw std::runtime_error("ReadHDF5: corrupt chunk in file " + filename);
+      std::memcpy(dst, raw.data(), nbytes);
+      return;
+    }
+    // the intermediate results alternate between two buffers, the last filter writes into dst
+    std::vector<uint8_t> bufs[2];
+    const uint8_t *cur = raw.data();
+    size_t curBytes = raw.size();
+    for (size_t k = applied.size(); k-- > 0;) {
+      uint8_t *out = dst;
+      if (k > 0) {
+        bufs[k % 2].resize(nbytes);
+        out = bufs[k % 2].data();
+      }
+      const auto &f = filters[applied[k]];
+      if (f.first == H5Z_FILTER_SHUFFLE) {
+        if (curBytes != nbytes)
+          throw std::runtime_error("ReadHDF5: corrupt chunk in file " + filename);
+        unshuffle(cur, out, nbytes, f.second);
+      }
+#ifdef USE_ZLIB
+      else if (f.first == H5Z_FILTER_DEFLATE) {
+        uLongf outBytes = nbytes;
+        if (uncompress(out, &outBytes, cur, curBytes) != Z_OK || outBytes != nbytes)
+          throw std::runtime_error("ReadHDF5: corrupt compressed chunk in file " + filename);
+      }
+#endif
+      cur = out;
+      curBytes = nbytes;
+    }
+  }
+
+  template <typename VT>
+  void readChunked(VT *dst, size_t rowSkip, uint64_t rowBegin, uint64_t rowEnd, uint64_t colBegin, uint64_t colEnd,
+                   DCTX(ctx)) const {
+    const uint64_t cr = chunkDims[0];
+    const uint64_t cc = rank == 2 ? chunkDims[1] : 1;
+    VT fill = 0;
+    std::vector<Chunk> chunks;
+    {
+      std::lock_guard<std::mutex> lock(mutex());
+      H5D_fill_value_t defined;
+      if (H5Pfill_value_defined(dcpl, &defined) >= 0 && defined != H5D_FILL_VALUE_UNDEFINED)
+        H5Pget_fill_value(dcpl, nativeType<VT>(), &fill);
+      for (uint64_t r = rowBegin / cr * cr; r < rowEnd; r += cr)
+        for (uint64_t c = colBegin / cc * cc; c < colEnd; c += cc) {
+          hsize_t offset[2] = {r, c};
+          Chunk chunk{r, c, HADDR_UNDEF, 0, 0};
+          check(H5Dget_chunk_info_by_coord(dset, offset, &chunk.filterMask, &chunk.addr, &chunk.nbytes) >= 0,
+                "locate a chunk");
+          chunks.push_back(chunk);
+        }
+    }
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("ReadHDF5: cannot open file " + filename);
+    const size_t chunkBytes = cr * cc * sizeof(VT);
+    const bool allCols = colBegin == 0 && colEnd == numCols && cc == numCols && rowSkip == numCols;
+    try {
+      WorkerPool::parallelFor(ctx, chunks.size(), [&](size_t i) {
+        const Chunk &chunk = chunks[i];
+        const uint64_t r0 = std::max(chunk.row, rowBegin);
+        const uint64_t r1 = std::min(chunk.row + cr, rowEnd);
+        const uint64_t c0 = std::max(chunk.col, colBegin);
+        const uint64_t c1 = std::min(chunk.col + cc, colEnd);
+        if (chunk.addr == HADDR_UNDEF) {
+          for (uint64_t r = r0; r < r1; r++)
+            std::fill(dst + (r - rowBegin) * rowSkip + (c0 - colBegin), dst + (r - rowBegin) * rowSkip + (c1 - colBegin),
+                      fill);
+          return;
+        }
+        std::vector<uint8_t> raw(chunk.nbytes);
+        preadAll(fd, raw.data(), chunk.nbytes, chunk.addr);
+        // a chunk of whole rows within the rows read is decoded into the matrix directly
+        if (allCols && r0 == chunk.row && r1 == chunk.row + cr) {
+          decodeChunk(raw, chunk.filterMask, reinterpret_cast<uint8_t *>(dst + (r0 - rowBegin) * rowSkip), chunkBytes);
+          return;
+        }
+        std::vector<VT> values(cr * cc);
+        decodeChunk(raw, chunk.filterMask, reinterpret_cast<uint8_t *>(values.data()), chunkBytes);
+        for (uint64_t r = r0; r < r1; r++) {
+          const VT *src = values.data() + (r - chunk.row) * cc + (c0 - chunk.col);
+          std::copy(src, src + (c1 - c0), dst + (r - rowBegin) * rowSkip + (c0 - colBegin));
+        }
+      });
+    } catch (...) {
+      close(fd);
+      throw;
+    }
+    close(fd);
+  }
+
+  template <typename VT>
+  void readContiguous(VT *dst, size_t rowSkip, uint64_t rowBegin, uint64_t rowEnd, uint64_t colBegin,
+                      uint64_t colEnd, haddr_t offset, DCTX(ctx)) const {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("ReadHDF5: cannot open file " + filename);
+    // blocks of rows of about 1 MiB
+    const uint64_t blockRows = std::max<uint64_t>(1, (uint64_t(1) << 20) / (numCols * sizeof(VT)));
+    const bool allCols = colBegin == 0 && colEnd == numCols && rowSkip == numCols;
+    try {
+      WorkerPool::parallelFor(ctx, (rowEnd - rowBegin + blockRows - 1) / blockRows, [&](size_t b) {
+        const uint64_t r0 = rowBegin + b * blockRows;
+        const uint64_t r1 = std::min(r0 + blockRows, rowEnd);
+        if (allCols) {
+          preadAll(fd, dst + (r0 - rowBegin) * rowSkip, (r1 - r0) * numCols * sizeof(VT),
+                   offset + r0 * numCols * sizeof(VT));
+          return;
+        }
+        for (uint64_t r = r0; r < r1; r++)
+          preadAll(fd, dst + (r - rowBegin) * rowSkip, (colEnd - colBegin) * sizeof(VT),
+                   offset + (r * numCols + colBegin) * sizeof(VT));
+      });
+    } catch (...) {
+      close(fd);
+      throw;
+    }
+    close(fd);
+  }
+
+  // reads a hyperslab by the library, which converts the values to the value type
+  template <typename VT>
+  void readConverted(VT *dst, size_t rowSkip, uint64_t rowBegin, uint64_t rowEnd, uint64_t colBegin,
+                     uint64_t colEnd) const {
+    std::lock_guard<std::mutex> lock(mutex());
+    Handle fileSpace(H5Dget_space(dset), H5Sclose);
+    hsize_t start[2] = {rowBegin, colBegin};
+    hsize_t count[2] = {rowEnd - rowBegin, colEnd - colBegin};
+    check(H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, nullptr, count, nullptr) >= 0, "select the values");
+    hsize_t memDims[2] = {rowEnd - rowBegin, rowSkip};
+    Handle memSpace(H5Screate_simple(2, memDims, nullptr), H5Sclose);
+    hsize_t memStart[2] = {0, 0};
+    check(H5Sselect_hyperslab(memSpace, H5S_SELECT_SET, memStart, nullptr, count, nullptr) >= 0,
+          "select the values");
+    check(H5Dread(dset, nativeType<VT>(), memSpace, fileSpace, H5P_DEFAULT, dst) >= 0, "read the values");
+  }
+
+  // opens the file and its dataset, called with the mutex locked
+  void openDataset() {
+    // the errors are reported by exceptions
+    H5Eset_auto2(H5E_DEFAULT, nullptr, nullptr);
+    file = Handle(H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT), H5Fclose);
+    check(file >= 0, "open");
+
+    std::string name = "data";
+    if (H5Lexists(file, "data", H5P_DEFAULT) <= 0) {
+      std::vector<std::string> names;
+      hsize_t idx = 0;
+      H5Literate(file, H5_INDEX_NAME, H5_ITER_INC, &idx, collectDataset, &names);
+      if (names.size() != 1)
+        throw std::runtime_error("ReadHDF5: file " + filename
+                                 + " must have a dataset named data or a single dataset in its root group");
+      name = names[0];
+    }
+    dset = Handle(H5Dopen2(file, name.c_str(), H5P_DEFAULT), H5Dclose);
+    check(dset >= 0, "open the dataset " + name);
+
+    Handle space(H5Dget_space(dset), H5Sclose);
+    rank = H5Sget_simple_extent_ndims(space);
+    if (rank != 1 && rank != 2)
+      throw std::runtime_error("ReadHDF5: the dataset of file " + filename + " is not 1- or 2-dimensional");
+    hsize_t dims[2] = {0, 1};
+    H5Sget_simple_extent_dims(space, dims, nullptr);
+    numRows = dims[0];
+    numCols = dims[1];
+
+    type = Handle(H5Dget_type(dset), H5Tclose);
+    const size_t size = H5Tget_size(type);
+    switch (H5Tget_class(type)) {
+      case H5T_FLOAT:
+        valueType = size <= 4 ? ValueTypeCode::F32 : ValueTypeCode::F64;
+        break;
+      case H5T_INTEGER: {
+        const bool isSigned = H5Tget_sign(type) != H5T_SGN_NONE;
+        if (size == 1)
+          valueType = isSigned ? ValueTypeCode::SI8 : ValueTypeCode::UI8;
+        else if (size <= 4)
+          valueType = isSigned ? ValueTypeCode::SI32 : ValueTypeCode::UI32;
+        else
+          valueType = isSigned ? ValueTypeCode::SI64 : ValueTypeCode::UI64;
+        break;
+      }
+      default:
+        throw std::runtime_error("ReadHDF5: the dataset of file " + filename + " is not numeric");
+    }
+
+    dcpl = Handle(H5Dget_create_plist(dset), H5Pclose);
+    if (H5Pget_layout(dcpl) == H5D_CHUNKED) {
+      H5Pget_chunk(dcpl, rank, chunkDims);
+      const int numFilters = H5Pget_nfilters(dcpl);
+      for (int i = 0; i < numFilters; i++) {
+        unsigned flags;
+        size_t numValues = 1;
+        unsigned values[1] = {0};
+        unsigned config;
+        const H5Z_filter_t id = H5Pget_filter2(dcpl, i, &flags, &numValues, values, 0, nullptr, &config);
+        filters.emplace_back(id, id == H5Z_FILTER_SHUFFLE && numValues > 0 ? values[0] : size);
+      }
+    }
+    // the addresses of the library are relative to the end of a user block
+    Handle fcpl(H5Fget_create_plist(file), H5Pclose);
+    hsize_t userBlock = 0;
+    H5Pget_userblock(fcpl, &userBlock);
+    hasUserBlock = userBlock != 0;
+
+    readLabels();
+  }
+
+  void closeAll() {
+    dcpl = Handle();
+    type = Handle();
+    dset = Handle();
+    file = Handle();
+  }
+
+public:
+  uint64_t numRows = 0;
+  uint64_t numCols = 0;
+  ValueTypeCode valueType;
+  // the `labels` attribute of the dataset, a string per column, if it has one
+  std::vector<std::string> labels;
+
+  static std::mutex &mutex() {
+    static std::mutex mtx;
+    return mtx;
+  }
+
+  explicit HDF5Dataset(const char *filename) : filename(filename), path(ObjectStore::localPath(filename)) {
+    std::lock_guard<std::mutex> lock(mutex());
+    try {
+      openDataset();
+    } catch (...) {
+      closeAll();
+      throw;
+    }
+  }
+
+  HDF5Dataset(const HDF5Dataset &) = delete;
+  HDF5Dataset &operator=(const HDF5Dataset &) = delete;
+
+  ~HDF5Dataset() {
+    std::lock_guard<std::mutex> lock(mutex());
+    closeAll();
+  }
+
+  FileMetaData getMetaData() const {
+    if (labels.empty())
+      return FileMetaData(numRows, numCols, true, valueType);
+    return FileMetaData(numRows, numCols, true, std::vector<ValueTypeCode>{valueType}, labels);
+  }
+
+  /**
+   * @brief Reads the values of the rows [rowBegin, rowEnd) and the columns [colBegin, colEnd) into `dst`, whose
+   * rows are `rowSkip` values apart, on the workers of `ctx` (sequentially without a context).
+   */
+  template <typename VT>
+  void read(VT *dst, size_t rowSkip, uint64_t rowBegin, uint64_t rowEnd, uint64_t colBegin, uint64_t colEnd,
+            DCTX(ctx)) const {
+    if (rowBegin > rowEnd || rowEnd > numRows || colBegin > colEnd || colEnd > numCols)
+      throw std::runtime_error("ReadHDF5: the values to read are out of bounds of file " + filename);
+    if (rowBegin == rowEnd || colBegin == colEnd)
+      return;
+
+    H5D_layout_t layout;
+    bool native;
+    haddr_t offset = HADDR_UNDEF;
+    {
+      std::lock_guard<std::mutex> lock(mutex());
+      layout = H5Pget_layout(dcpl);
+      native = H5Tequal(type, nativeType<VT>()) > 0;
+      if (layout == H5D_CONTIGUOUS)
+        offset = H5Dget_offset(dset);
+    }
+    if (native && !hasUserBlock) {
+      if (layout == H5D_CHUNKED && canDecodeChunks())
+        return readChunked(dst, rowSkip, rowBegin, rowEnd, colBegin, colEnd, ctx);
+      if (layout == H5D_CONTIGUOUS && offset != HADDR_UNDEF)
+        return readContiguous(dst, rowSkip, rowBegin, rowEnd, colBegin, colEnd, offset, ctx);
+    }
+    readConverted(dst, rowSkip, rowBegin, rowEnd, colBegin, colEnd);
+  }
+};
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Reads a dense matrix from the dataset of an HDF5 file (see
+ * `HDF5Dataset`), whose dimensions it is created with unless it is given.
+ */
+template <typename VT> void readHDF5(DenseMatrix<VT> *&res, const char *filename, DCTX(ctx) = nullptr) {
+  HDF5Dataset dset(filename);
+  if (res == nullptr)
+    res = DataObjectFactory::create<DenseMatrix<VT>>(dset.numRows, dset.numCols, false);
+  else if (res->getNumRows() != dset.numRows || res->getNumCols() != dset.numCols)
+    throw std::runtime_error(std::string("ReadHDF5: the matrix does not match the dataset of file ") + filename);
+  dset.read(res->getValues(), res->getRowSkip(), 0, dset.numRows, 0, dset.numCols, ctx);
+}
+
+/**
+ * @brief Reads the rows [rowBegin, rowEnd) and the columns [colBegin,
+ * colEnd) (all if `colEnd` is the maximum) of the dataset of an HDF5 file,
+ * of which only the chunks containing these values are read, e.g., by a
+ * distributed worker reading its rows.
+ */
+template <typename VT>
+void readHDF5Rows(DenseMatrix<VT> *&res, const char *filename, size_t rowBegin, size_t rowEnd, size_t colBegin = 0,
+                  size_t colEnd = std::numeric_limits<size_t>::max(), DCTX(ctx) = nullptr) {
+  HDF5Dataset dset(filename);
+  if (colEnd == std::numeric_limits<size_t>::max())
+    colEnd = dset.numCols;
+  if (rowBegin > rowEnd || rowEnd > dset.numRows || colBegin > colEnd || colEnd > dset.numCols)
+    throw std::runtime_error(std::string("ReadHDF5: the values to read are out of bounds of file ") + filename);
+  res = DataObjectFactory::create<DenseMatrix<VT>>(rowEnd - rowBegin, colEnd - colBegin, false);
+  dset.read(res->getValues(), res->getRowSkip(), rowBegin, rowEnd, colBegin, colEnd, ctx);
+}
+
+/**
+ * @brief The meta data of the dataset of an HDF5 file: its dimensions and
+ * value type, and its `labels` attribute, if it has one.
+ */
+inline FileMetaData readHDF5MetaData(const char *filename) {
+  return HDF5Dataset(filename).getMetaData();
+}
+
+#endif
@@ -17,15 +17,27 @@
 #ifndef MM_IO_H
 #define MM_IO_H
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/io/MMFile.h>
-#include <vector>
+#include <runtime/local/io/ReadCsv.h>
+#include <runtime/local/io/utils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstring>
 
 typedef char MM_typecode[4];
 
@@ -36,20 +48,142 @@ char *mm_typecode_to_str(MM_typecode matcode);
 // ****************************************************************************
 
 template <class DTRes> struct ReadMM {
-  static void apply(DTRes *&res, const char *filename) = delete;
+  static void apply(DTRes *&res, const char *filename, DCTX(ctx)) = delete;
 };
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
+// Files in coordinate format are mapped into memory and parsed on the workers
+// of the context (sequentially without a context), see MMCoordinates. Files in
+// array format and frames are read sequentially.
+
 template <class DTRes>
-void readMM(DTRes *&res, const char *filename) {
-  ReadMM<DTRes>::apply(res, filename);
+void readMM(DTRes *&res, const char *filename, DCTX(ctx) = nullptr) {
+  ReadMM<DTRes>::apply(res, filename, ctx);
 }
 
+// ****************************************************************************
+// Parallel parsing of the coordinate format
+// ****************************************************************************
+
+/**
+ * @brief The entries of a Matrix Market file in coordinate format, parsed in
+ * parallel from the mapped file (the lines after the header are split into
+ * byte ranges by CsvLines), with zero-based indexes.
+ *
+ * The entries are kept as stored in the file, i.e., the mirrored entries of a
+ * symmetric or skew-symmetric matrix are left to the reader building the data
+ * object, see isMirrored() and mirroredValue().
+ */
+template <typename VT> struct MMCoordinates {
+  MM_typecode typecode{};
+  size_t numRows = 0;
+  size_t numCols = 0;
+  std::vector<size_t> rows;
+  std::vector<size_t> cols;
+  std::vector<VT> values;
+
+  /**
+   * @brief Reads the banner of the file and, if the file is in coordinate
+   * format, its entries. Otherwise, isCoordinate() is false and nothing but
+   * the banner is read.
+   */
+  MMCoordinates(const char *filename, DCTX(ctx)) {
+    struct File *f = openFile(filename);
+    if (f == nullptr)
+      throw std::runtime_error(std::string("ReadMM: cannot open file ") + filename);
+    if (mm_read_banner(f, &typecode) != 0) {
+      closeFile(f);
+      throw std::runtime_error(std::string("ReadMM: invalid Matrix Market banner in file ") + filename);
+    }
+    if (!isCoordinate()) {
+      closeFile(f);
+      return;
+    }
+    size_t numEntries;
+    const int err = mm_read_mtx_crd_size(f, &numRows, &numCols, &numEntries);
+    const uint64_t headerBytes = f->pos;
+    closeFile(f);
+    if (err != 0)
+      throw std::runtime_error(std::string("ReadMM: missing size line in file ") + filename);
+
+    CsvLines lines(filename, ctx);
+    // the banner, the comments, and the size line
+    uint64_t headerLines = 0;
+    const char *data = reinterpret_cast<const char *>(lines.file->addr);
+    for (const char *p = data, *end = data + headerBytes; (p = static_cast<const char *>(memchr(p, '\n', end - p)));
+         p++)
+      headerLines++;
+
+    rows.resize(numEntries);
+    cols.resize(numEntries);
+    values.resize(numEntries);
+    const bool pattern = mm_is_pattern(typecode);
+    lines.forEachLine(headerLines + numEntries, [&](const char *pos, const char *lineEnd, uint64_t lineIdx) {
+      if (lineIdx < headerLines)
+        return;
+      const size_t i = lineIdx - headerLines;
+      rows[i] = parseIndex(pos, lineEnd, numRows, lineIdx);
+      cols[i] = parseIndex(pos, lineEnd, numCols, lineIdx);
+      if (pattern)
+        values[i] = 1;
+      else
+        convertCstr(pos, lineEnd, &values[i]);
+    });
+  }
+
+  bool isCoordinate() const { return mm_is_coordinate(typecode); }
+
+  size_t numEntries() const { return rows.size(); }
+
+  // whether entry i stands for a second entry in the transposed position
+  bool isMirrored(size_t i) const {
+    return (mm_is_symmetric(typecode) || mm_is_skew(typecode)) && rows[i] != cols[i];
+  }
+
+  // the value of the second entry of a mirrored entry (cast to comply when VT is unsigned)
+  VT mirroredValue(size_t i) const {
+    return mm_is_skew(typecode) ? (VT)-values[i] : values[i];
+  }
+
+private:
+  // parses the one-based index at pos, advances pos, and returns the zero-based index
+  static size_t parseIndex(const char *&pos, const char *lineEnd, size_t bound, uint64_t lineIdx) {
+    pos = skipSpaces(pos, lineEnd);
+    size_t idx = 0;
+    const char *begin = pos;
+    for (; pos < lineEnd && static_cast<unsigned char>(*pos - '0') < 10; pos++)
+      idx = idx * 10 + static_cast<size_t>(*pos - '0');
+    if (pos == begin || idx == 0 || idx > bound)
+      throw std::runtime_error("ReadMM: invalid or out-of-bounds index in line " + std::to_string(lineIdx + 1)
+          + " (bound " + std::to_string(bound) + ")");
+    return idx - 1;
+  }
+};
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
 template <typename VT> struct ReadMM<DenseMatrix<VT>> {
-  static void apply(DenseMatrix<VT> *&res, const char *filename){
+  static void apply(DenseMatrix<VT> *&res, const char *filename, DCTX(ctx)){
+    MMCoordinates<VT> coords(filename, ctx);
+    if(coords.isCoordinate()) {
+      if(res == nullptr)
+        res = DataObjectFactory::create<DenseMatrix<VT>>(coords.numRows, coords.numCols, true);
+      // sequentially, such that later duplicates overwrite earlier ones
+      VT *valuesRes = res->getValues();
+      const size_t rowSkip = res->getRowSkip();
+      for(size_t i = 0; i < coords.numEntries(); i++) {
+        valuesRes[coords.rows[i] * rowSkip + coords.cols[i]] = coords.values[i];
+        if(coords.isMirrored(i))
+          valuesRes[coords.cols[i] * rowSkip + coords.rows[i]] = coords.mirroredValue(i);
+      }
+      return;
+    }
+
     MMFile<VT> mmfile(filename);
     if(res == nullptr)
       res = DataObjectFactory::create<DenseMatrix<VT>>(
@@ -64,7 +198,19 @@ template <typename VT> struct ReadMM<DenseMatrix<VT>> {
 };
 
 template <typename VT> struct ReadMM<CSRMatrix<VT>> {
-  static void apply(CSRMatrix<VT> *&res, const char *filename){
+  // the number of entries counted or scattered by one task
+  static constexpr size_t ENTRIES_PER_TASK = size_t(1) << 16;
+  // the number of rows sorted by one task
+  static constexpr size_t ROWS_PER_TASK = size_t(1) << 12;
+
+  static void apply(CSRMatrix<VT> *&res, const char *filename, DCTX(ctx)){
+    MMCoordinates<VT> coords(filename, ctx);
+    if(coords.isCoordinate()) {
+      buildFromCoordinates(res, coords, ctx);
+      return;
+    }
+
+    // the array format, as column-major dense values
     MMFile<VT> mmfile(filename);
 
     using entry_t = typename MMFile<VT>::Entry;
@@ -103,10 +249,81 @@ template <typename VT> struct ReadMM<CSRMatrix<VT>> {
         rowIdx++;
     }
   }
+
+  /**
+   * @brief Builds the CSR matrix from the parsed entries without sorting them
+   * as a whole: the entries are counted per row in parallel, the row offsets
+   * are the prefix sums of the counts, and the entries (including the mirrored
+   * ones) are scattered into their rows in parallel. Only the columns within
+   * each row are sorted afterwards. Duplicate entries are kept.
+   */
+  static void buildFromCoordinates(CSRMatrix<VT> *&res, const MMCoordinates<VT> &coords, DCTX(ctx)) {
+    const size_t numRows = coords.numRows;
+    const size_t numEntries = coords.numEntries();
+    const size_t numEntryTasks = (numEntries + ENTRIES_PER_TASK - 1) / ENTRIES_PER_TASK;
+    auto forEachEntry = [&](auto func) {
+      WorkerPool::parallelFor(ctx, numEntryTasks, [&](size_t t) {
+        for(size_t i = t * ENTRIES_PER_TASK, end = std::min(numEntries, i + ENTRIES_PER_TASK); i < end; i++)
+          func(i);
+      });
+    };
+
+    // the number of entries per row, then the next free position in each row
+    std::unique_ptr<std::atomic<size_t>[]> rowPos(new std::atomic<size_t>[numRows]());
+    forEachEntry([&](size_t i) {
+      rowPos[coords.rows[i]].fetch_add(1, std::memory_order_relaxed);
+      if(coords.isMirrored(i))
+        rowPos[coords.cols[i]].fetch_add(1, std::memory_order_relaxed);
+    });
+    size_t nnz = 0;
+    for(size_t r = 0; r < numRows; r++)
+      nnz += rowPos[r].load(std::memory_order_relaxed);
+
+    if(res == nullptr)
+      res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, coords.numCols, nnz, false);
+    auto *rowOffsets = res->getRowOffsets();
+    auto *colIdxs = res->getColIdxs();
+    auto *values = res->getValues();
+    rowOffsets[0] = 0;
+    for(size_t r = 0; r < numRows; r++) {
+      rowOffsets[r + 1] = rowOffsets[r] + rowPos[r].load(std::memory_order_relaxed);
+      rowPos[r].store(rowOffsets[r], std::memory_order_relaxed);
+    }
+
+    forEachEntry([&](size_t i) {
+      size_t pos = rowPos[coords.rows[i]].fetch_add(1, std::memory_order_relaxed);
+      colIdxs[pos] = coords.cols[i];
+      values[pos] = coords.values[i];
+      if(coords.isMirrored(i)) {
+        pos = rowPos[coords.cols[i]].fetch_add(1, std::memory_order_relaxed);
+        colIdxs[pos] = coords.rows[i];
+        values[pos] = coords.mirroredValue(i);
+      }
+    });
+
+    // the order of the entries within a row depends on the scheduling of the threads
+    WorkerPool::parallelFor(ctx, (numRows + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](size_t t) {
+      std::vector<std::pair<size_t, VT>> row;
+      for(size_t r = t * ROWS_PER_TASK, end = std::min(numRows, r + ROWS_PER_TASK); r < end; r++) {
+        const size_t begin = rowOffsets[r], rowEnd = rowOffsets[r + 1];
+        if(std::is_sorted(colIdxs + begin, colIdxs + rowEnd))
+          continue;
+        row.clear();
+        for(size_t k = begin; k < rowEnd; k++)
+          row.emplace_back(colIdxs[k], values[k]);
+        std::stable_sort(row.begin(), row.end(),
+            [](const std::pair<size_t, VT> &a, const std::pair<size_t, VT> &b) { return a.first < b.first; });
+        for(size_t k = begin; k < rowEnd; k++) {
+          colIdxs[k] = row[k - begin].first;
+          values[k] = row[k - begin].second;
+        }
+      }
+    });
+  }
 };
 
 template <> struct ReadMM<Frame> {
-  static void apply(Frame *&res, const char *filename){
+  static void apply(Frame *&res, const char *filename, DCTX(ctx)){
     MMFile<double> mmfile(filename);
 
     if(res == nullptr){
@@ -17,42 +17,98 @@
 #pragma once
 #ifdef USE_ARROW
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
 
 #include <runtime/local/io/File.h>
+#include <runtime/local/io/ObjectStore.h>
 #include <runtime/local/io/ReadCsvFile.h>
 #include <runtime/local/io/utils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <queue>
-#include <fstream>
-#include <limits>
-#include <sstream>
+#include <cstring>
 
 #include <arrow/api.h>
 #include <arrow/io/memory.h>
 #include <arrow/ipc/api.h>
 #include <parquet/arrow/reader.h>
+#include <parquet/metadata.h>
+#include <parquet/statistics.h>
 #include <arrow/filesystem/localfs.h>
 #include <arrow/csv/api.h>
 
+// ****************************************************************************
+// Options
+// ****************************************************************************
+
+/**
+ * @brief A comparison of a column with a constant, e.g., from the `WHERE`
+ * clause of a SQL query, by which the row groups of a Parquet file whose
+ * statistics show that none of their rows satisfies it are skipped.
+ *
+ * The rows of the remaining row groups are not filtered, i.e., the predicate
+ * must still be evaluated on the result.
+ */
+struct ParquetPredicate {
+  enum class Cmp { EQ, NE, LT, LE, GT, GE };
+
+  std::string column;
+  Cmp cmp;
+  double value;
+
+  // whether no value in [min, max] satisfies the predicate
+  bool excludes(double min, double max) const {
+    switch (cmp) {
+      case Cmp::EQ: return value < min || value > max;
+      case Cmp::NE: return min == max && min == value;
+      case Cmp::LT: return min >= value;
+      case Cmp::LE: return min > value;
+      case Cmp::GT: return max <= value;
+      case Cmp::GE: return max < value;
+    }
+    return false;
+  }
+};
+
+struct ParquetReadOptions {
+  // the labels of the columns to read, in this order, or all columns if empty
+  std::vector<std::string> columns;
+  // the row groups read are those no predicate excludes
+  std::vector<ParquetPredicate> predicates;
+  // whether Arrow decodes the columns in parallel
+  bool useThreads = true;
+  // whether an Arrow array of the value type of the column without nulls becomes the column without copying
+  bool zeroCopy = true;
+};
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
 
 template <class DTRes> struct ReadParquet {
-  static void apply(DTRes *&res, const char *filename, size_t numRows, size_t numCols) = delete;
+  static void apply(DTRes *&res, const char *filename, size_t numRows, size_t numCols, DCTX(ctx)) = delete;
   static void apply(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
                     ValueTypeCode *schema) = delete;
   static void apply(DTRes *&res, const char *filename, size_t numRows, size_t numCols,
                     ssize_t numNonZeros, bool sorted = true) = delete;
+  static void apply(DTRes *&res, const char *filename, const ValueTypeCode *schema, const std::string *labels,
+                    const ParquetReadOptions &options) = delete;
 };
 
 // ****************************************************************************
@@ -60,8 +116,8 @@ template <class DTRes> struct ReadParquet {
 // ****************************************************************************
 
 template <class DTRes>
-void readParquet(DTRes *&res, const char *filename, size_t numRows, size_t numCols) {
-  ReadParquet<DTRes>::apply(res, filename, numRows, numCols);
+void readParquet(DTRes *&res, const char *filename, size_t numRows, size_t numCols, DCTX(ctx) = nullptr) {
+  ReadParquet<DTRes>::apply(res, filename, numRows, numCols, ctx);
 }
 
 template <class DTRes>
@@ -76,25 +132,325 @@ void readParquet(DTRes *&res, const char *filename, size_t numRows, size_t numCo
     ReadParquet<DTRes>::apply(res, filename, numRows, numCols, numNonZeros, sorted);
 }
 
+/**
+ * @brief Reads the rows [rowBegin, rowEnd) of a dense matrix from a Parquet
+ * file, of which only the row groups containing these rows are read.
+ */
+template <typename VT>
+void readParquetRows(DenseMatrix<VT> *&res, const char *filename, size_t rowBegin, size_t rowEnd,
+                     DCTX(ctx) = nullptr) {
+  ReadParquet<DenseMatrix<VT>>::applyRows(res, filename, rowBegin, rowEnd, ctx);
+}
+
+/**
+ * @brief Reads the columns of `options` (with the value types `schema` and the
+ * labels `labels`, or the names in the file if `nullptr`) from the row groups
+ * of a Parquet file not excluded by the predicates of `options`.
+ */
+template <class DTRes>
+void readParquet(DTRes *&res, const char *filename, const ValueTypeCode *schema, const std::string *labels,
+                 const ParquetReadOptions &options) {
+  ReadParquet<DTRes>::apply(res, filename, schema, labels, options);
+}
+
 // ****************************************************************************
-// (Partial) template specializations for different data/value types
+// Reading Arrow tables
 // ****************************************************************************
 
-inline struct File *arrowToCsv(const char *filename){
-    arrow::Status st;
-    arrow::MemoryPool* pool = arrow::default_memory_pool();
-    arrow::fs::LocalFileSystem file_system;
-    std::shared_ptr<arrow::io::RandomAccessFile> input = file_system.OpenInputFile(filename).ValueOrDie();
-
-    std::unique_ptr<parquet::arrow::FileReader> arrow_reader;
-    st = parquet::arrow::OpenFile(input, pool, &arrow_reader);
-    if (!st.ok()) {
-       // TODO: Handle error instantiating file reader...
-       return NULL;
+/**
+ * @brief An object in an object store as an Arrow file, whose ranges (e.g.,
+ * the footer and the column chunks of the row groups read) are fetched as
+ * Arrow reads them.
+ */
+class ObjectStoreInputFile : public arrow::io::RandomAccessFile {
+  std::shared_ptr<ObjectStoreObject> object;
+  int64_t pos = 0;
+  bool isClosed = false;
+
+public:
+  explicit ObjectStoreInputFile(std::shared_ptr<ObjectStoreObject> object) : object(std::move(object)) {}
+
+  arrow::Status Close() override {
+    isClosed = true;
+    return arrow::Status::OK();
+  }
+
+  bool closed() const override { return isClosed; }
+
+  arrow::Result<int64_t> Tell() const override { return pos; }
+
+  arrow::Status Seek(int64_t position) override {
+    pos = position;
+    return arrow::Status::OK();
+  }
+
+  arrow::Result<int64_t> GetSize() override { return static_cast<int64_t>(object->getSize()); }
+
+  arrow::Result<int64_t> ReadAt(int64_t position, int64_t nbytes, void *out) override {
+    const int64_t size = static_cast<int64_t>(object->getSize());
+    if (position < 0 || nbytes < 0 || position > size)
+      return arrow::Status::IOError("ReadParquet: read out of the bounds of ", object->getURL());
+    nbytes = std::min(nbytes, size - position);
+    try {
+      object->read(position, out, nbytes);
+    } catch (const std::exception &e) {
+      return arrow::Status::IOError(e.what());
+    }
+    return nbytes;
+  }
+
+  arrow::Result<std::shared_ptr<arrow::Buffer>> ReadAt(int64_t position, int64_t nbytes) override {
+    ARROW_ASSIGN_OR_RAISE(auto buffer, arrow::AllocateResizableBuffer(nbytes));
+    ARROW_ASSIGN_OR_RAISE(const int64_t n, ReadAt(position, nbytes, buffer->mutable_data()));
+    ARROW_RETURN_NOT_OK(buffer->Resize(n));
+    return std::shared_ptr<arrow::Buffer>(std::move(buffer));
+  }
+
+  arrow::Result<int64_t> Read(int64_t nbytes, void *out) override {
+    ARROW_ASSIGN_OR_RAISE(const int64_t n, ReadAt(pos, nbytes, out));
+    pos += n;
+    return n;
+  }
+
+  arrow::Result<std::shared_ptr<arrow::Buffer>> Read(int64_t nbytes) override {
+    ARROW_ASSIGN_OR_RAISE(auto buffer, ReadAt(pos, nbytes));
+    pos += buffer->size();
+    return buffer;
+  }
+};
+
+/**
+ * @brief A Parquet file opened by Arrow, whose row groups and columns can be
+ * read selectively.
+ */
+class ParquetFile {
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  std::shared_ptr<parquet::FileMetaData> metadata;
+
+  static void check(const arrow::Status &st, const char *filename, const char *what) {
+    if (!st.ok())
+      throw std::runtime_error(std::string("ReadParquet: cannot ") + what + " of file " + filename + ": "
+          + st.ToString());
+  }
+
+  // the minimum and maximum of a column chunk, if the statistics have them and compare like numbers
+  static bool getMinMax(const parquet::Statistics &stats, double &min, double &max) {
+    if (!stats.HasMinMax() || stats.descr()->sort_order() != parquet::SortOrder::SIGNED)
+      return false;
+    switch (stats.physical_type()) {
+      case parquet::Type::INT32: {
+        const auto &s = static_cast<const parquet::Int32Statistics &>(stats);
+        min = s.min();
+        max = s.max();
+        return true;
+      }
+      case parquet::Type::INT64: {
+        const auto &s = static_cast<const parquet::Int64Statistics &>(stats);
+        min = static_cast<double>(s.min());
+        max = static_cast<double>(s.max());
+        return true;
+      }
+      case parquet::Type::FLOAT: {
+        const auto &s = static_cast<const parquet::FloatStatistics &>(stats);
+        min = s.min();
+        max = s.max();
+        return true;
+      }
+      case parquet::Type::DOUBLE: {
+        const auto &s = static_cast<const parquet::DoubleStatistics &>(stats);
+        min = s.min();
+        max = s.max();
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+public:
+  const std::string filename;
+
+  // an object in an object store (see isObjectURL) is read by ranged GETs of the footer and the column chunks read
+  ParquetFile(const char *filename, bool useThreads) : filename(filename) {
+    std::shared_ptr<arrow::io::RandomAccessFile> input;
+    if (isObjectURL(filename))
+      input = std::make_shared<ObjectStoreInputFile>(ObjectStore::get().open(filename));
+    else {
+      arrow::fs::LocalFileSystem file_system;
+      auto file = file_system.OpenInputFile(filename);
+      check(file.status(), filename, "open");
+      input = *file;
+    }
+    check(parquet::arrow::OpenFile(input, arrow::default_memory_pool(), &reader), filename, "read the footer");
+    reader->set_use_threads(useThreads);
+    metadata = reader->parquet_reader()->metadata();
+  }
+
+  int getNumColumns() const {
+    return metadata->num_columns();
+  }
+
+  // the index of the (flat) column with the given name
+  int getColumnIndex(const std::string &name) const {
+    const int idx = metadata->schema()->ColumnIndex(name);
+    if (idx < 0)
+      throw std::runtime_error("ReadParquet: file " + filename + " has no column " + name);
+    return idx;
+  }
+
+  // the row groups that no predicate excludes by the statistics of its column
+  std::vector<int> getRowGroups(const std::vector<ParquetPredicate> &predicates) const {
+    std::vector<int> predColumns;
+    for (auto &pred : predicates)
+      predColumns.push_back(getColumnIndex(pred.column));
+    std::vector<int> rowGroups;
+    for (int rg = 0; rg < metadata->num_row_groups(); rg++) {
+      std::unique_ptr<parquet::RowGroupMetaData> rgMetadata = metadata->RowGroup(rg);
+      bool excluded = false;
+      for (size_t p = 0; p < predicates.size() && !excluded; p++) {
+        std::unique_ptr<parquet::ColumnChunkMetaData> chunk = rgMetadata->ColumnChunk(predColumns[p]);
+        std::shared_ptr<parquet::Statistics> stats = chunk->is_stats_set() ? chunk->statistics() : nullptr;
+        double min, max;
+        excluded = stats && getMinMax(*stats, min, max) && predicates[p].excludes(min, max);
+      }
+      if (!excluded)
+        rowGroups.push_back(rg);
+    }
+    return rowGroups;
+  }
+
+  // the row groups containing any of the rows [rowBegin, rowEnd), and the first row of the first of them
+  std::vector<int> getRowGroups(size_t rowBegin, size_t rowEnd, size_t &firstRow) const {
+    std::vector<int> rowGroups;
+    size_t rgBegin = 0;
+    for (int rg = 0; rg < metadata->num_row_groups() && rgBegin < rowEnd; rg++) {
+      const size_t rgEnd = rgBegin + metadata->RowGroup(rg)->num_rows();
+      if (rgEnd > rowBegin) {
+        if (rowGroups.empty())
+          firstRow = rgBegin;
+        rowGroups.push_back(rg);
+      }
+      rgBegin = rgEnd;
     }
+    return rowGroups;
+  }
 
+  std::shared_ptr<arrow::Table> read(const std::vector<int> &columns, const std::vector<int> &rowGroups) {
     std::shared_ptr<arrow::Table> table;
-    st = arrow_reader->ReadTable(&table);
+    if (rowGroups.empty()) {
+      // all row groups were skipped
+      std::shared_ptr<arrow::Schema> schema;
+      check(reader->GetSchema(&schema), filename.c_str(), "read the schema");
+      arrow::FieldVector fields;
+      for (int c : columns)
+        fields.push_back(schema->field(c));
+      auto empty = arrow::Table::MakeEmpty(arrow::schema(fields));
+      check(empty.status(), filename.c_str(), "create an empty table");
+      return *empty;
+    }
+    check(reader->ReadRowGroups(rowGroups, columns, &table), filename.c_str(), "read the row groups");
+    return table;
+  }
+
+  std::shared_ptr<arrow::Table> readAll() {
+    std::shared_ptr<arrow::Table> table;
+    check(reader->ReadTable(&table), filename.c_str(), "read the table");
+    return table;
+  }
+};
+
+// the value of a missing (null) entry, like an empty field in a CSV file
+template <typename VT> VT parquetNullValue() {
+  if constexpr (std::is_floating_point<VT>::value)
+    return std::numeric_limits<VT>::quiet_NaN();
+  else
+    return VT(0);
+}
+
+template <typename ArrowT, typename VT> void copyArrowChunk(const arrow::Array &chunk, VT *dst, size_t stride) {
+  const auto &arr = static_cast<const arrow::NumericArray<ArrowT> &>(chunk);
+  const auto *values = arr.raw_values();
+  const int64_t length = arr.length();
+  if (arr.null_count() == 0)
+    for (int64_t i = 0; i < length; i++)
+      dst[i * stride] = static_cast<VT>(values[i]);
+  else
+    for (int64_t i = 0; i < length; i++)
+      dst[i * stride] = arr.IsNull(i) ? parquetNullValue<VT>() : static_cast<VT>(values[i]);
+}
+
+/**
+ * @brief Copies an Arrow column to every `stride`-th element of `dst`,
+ * converting the values to `VT`.
+ */
+template <typename VT> void copyArrowColumn(const arrow::ChunkedArray &col, VT *dst, size_t stride) {
+  for (const std::shared_ptr<arrow::Array> &chunk : col.chunks()) {
+    switch (chunk->type_id()) {
+      case arrow::Type::INT8:   copyArrowChunk<arrow::Int8Type>(*chunk, dst, stride); break;
+      case arrow::Type::INT16:  copyArrowChunk<arrow::Int16Type>(*chunk, dst, stride); break;
+      case arrow::Type::INT32:  copyArrowChunk<arrow::Int32Type>(*chunk, dst, stride); break;
+      case arrow::Type::INT64:  copyArrowChunk<arrow::Int64Type>(*chunk, dst, stride); break;
+      case arrow::Type::UINT8:  copyArrowChunk<arrow::UInt8Type>(*chunk, dst, stride); break;
+      case arrow::Type::UINT16: copyArrowChunk<arrow::UInt16Type>(*chunk, dst, stride); break;
+      case arrow::Type::UINT32: copyArrowChunk<arrow::UInt32Type>(*chunk, dst, stride); break;
+      case arrow::Type::UINT64: copyArrowChunk<arrow::UInt64Type>(*chunk, dst, stride); break;
+      case arrow::Type::FLOAT:  copyArrowChunk<arrow::FloatType>(*chunk, dst, stride); break;
+      case arrow::Type::DOUBLE: copyArrowChunk<arrow::DoubleType>(*chunk, dst, stride); break;
+      case arrow::Type::BOOL: {
+        const auto &arr = static_cast<const arrow::BooleanArray &>(*chunk);
+        for (int64_t i = 0; i < arr.length(); i++)
+          dst[i * stride] = arr.IsNull(i) ? parquetNullValue<VT>() : static_cast<VT>(arr.Value(i));
+        break;
+      }
+      default:
+        throw std::runtime_error("ReadParquet: unsupported column type " + chunk->type()->ToString());
+    }
+    dst += chunk->length() * stride;
+  }
+}
+
+/**
+ * @brief Converts an Arrow column to a single-column matrix, which adopts the
+ * values of the Arrow array without copying them if the column is a single
+ * array of the value type without nulls and the values are aligned.
+ */
+template <typename VT> DenseMatrix<VT> *arrowToColumnMatrix(const std::shared_ptr<arrow::ChunkedArray> &col,
+                                                            bool zeroCopy) {
+  using ArrowT = typename arrow::CTypeTraits<VT>::ArrowType;
+  const size_t numRows = static_cast<size_t>(col->length());
+  if (zeroCopy && col->num_chunks() == 1 && col->null_count() == 0 && col->type()->id() == ArrowT::type_id) {
+    auto arr = std::static_pointer_cast<arrow::NumericArray<ArrowT>>(col->chunk(0));
+    VT *vals = const_cast<VT *>(arr->raw_values());
+    if (vals && reinterpret_cast<uintptr_t>(vals) % alignof(VT) == 0) {
+      // the values keep the Arrow array (and its buffers) alive
+      std::shared_ptr<VT[]> values(arr, vals);
+      return DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, values);
+    }
+  }
+  auto *res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+  copyArrowColumn(*col, res->getValues(), 1);
+  return res;
+}
+
+inline Structure *arrowToColumnMatrix(const std::shared_ptr<arrow::ChunkedArray> &col, ValueTypeCode vtc,
+                                      bool zeroCopy) {
+  switch (vtc) {
+    case ValueTypeCode::SI8:  return arrowToColumnMatrix<int8_t>(col, zeroCopy);
+    case ValueTypeCode::SI32: return arrowToColumnMatrix<int32_t>(col, zeroCopy);
+    case ValueTypeCode::SI64: return arrowToColumnMatrix<int64_t>(col, zeroCopy);
+    case ValueTypeCode::UI8:  return arrowToColumnMatrix<uint8_t>(col, zeroCopy);
+    case ValueTypeCode::UI32: return arrowToColumnMatrix<uint32_t>(col, zeroCopy);
+    case ValueTypeCode::UI64: return arrowToColumnMatrix<uint64_t>(col, zeroCopy);
+    case ValueTypeCode::F32:  return arrowToColumnMatrix<float>(col, zeroCopy);
+    case ValueTypeCode::F64:  return arrowToColumnMatrix<double>(col, zeroCopy);
+    default:
+      throw std::runtime_error("ReadParquet: unsupported value type of a frame column");
+  }
+}
+
+inline struct File *arrowToCsv(const char *filename){
+    ParquetFile file(filename, true);
+    std::shared_ptr<arrow::Table> table = file.readAll();
 
     auto output = arrow::io::BufferOutputStream::Create().ValueOrDie();
     arrow::csv::WriteCSV(*table, arrow::csv::WriteOptions::Defaults(), output.get());
@@ -104,12 +460,16 @@ inline struct File *arrowToCsv(const char *filename){
     void *ccsv = csv.data();
 
     FILE *buf = fmemopen(ccsv, csv.size(), "r");
-    struct File *file = openMemFile(buf);
-    getLine(file); // Parquet has headers, readCsv does not expect that.
+    struct File *f = openMemFile(buf);
+    getLine(f); // Parquet has headers, readCsv does not expect that.
 
-    return file;
+    return f;
 }
 
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
 // ----------------------------------------------------------------------------
 // Frame
 // ----------------------------------------------------------------------------
@@ -117,9 +477,50 @@ inline struct File *arrowToCsv(const char *filename){
 template <> struct ReadParquet<Frame> {
   static void apply(Frame *&res, const char *filename, size_t numRows,
                     size_t numCols, ValueTypeCode *schema) {
-    struct File *file = arrowToCsv(filename);
-    readCsvFile<Frame>(res, file, numRows, numCols, ',', schema);
-    closeFile(file);
+    Frame *frame = nullptr;
+    apply(frame, filename, schema, nullptr, ParquetReadOptions());
+    if (frame->getNumRows() != numRows || frame->getNumCols() != numCols) {
+      DataObjectFactory::destroy(frame);
+      throw std::runtime_error(std::string("ReadParquet: file ") + filename + " does not have the expected shape");
+    }
+    if (res == nullptr) {
+      res = frame;
+      return;
+    }
+    // copies into the given frame
+    for (size_t c = 0; c < numCols; c++)
+      memcpy(res->getColumnRaw(c), frame->getColumnRaw(c), numRows * ValueTypeUtils::sizeOf(schema[c]));
+    DataObjectFactory::destroy(frame);
+  }
+
+  static void apply(Frame *&res, const char *filename, const ValueTypeCode *schema, const std::string *labels,
+                    const ParquetReadOptions &options) {
+    ParquetFile file(filename, options.useThreads);
+    std::vector<int> columns;
+    if (options.columns.empty())
+      for (int c = 0; c < file.getNumColumns(); c++)
+        columns.push_back(c);
+    else
+      for (const std::string &label : options.columns)
+        columns.push_back(file.getColumnIndex(label));
+    std::shared_ptr<arrow::Table> table = file.read(columns, file.getRowGroups(options.predicates));
+
+    std::vector<Structure *> colMats;
+    std::vector<std::string> names;
+    try {
+      for (size_t c = 0; c < columns.size(); c++) {
+        colMats.push_back(arrowToColumnMatrix(table->column(c), schema[c], options.zeroCopy));
+        names.push_back(labels ? labels[c] : table->field(c)->name());
+      }
+      res = DataObjectFactory::create<Frame>(colMats, names.data());
+    } catch (...) {
+      for (Structure *colMat : colMats)
+        DataObjectFactory::destroy(colMat);
+      throw;
+    }
+    // the frame shares the values of the column matrices
+    for (Structure *colMat : colMats)
+      DataObjectFactory::destroy(colMat);
   }
 };
 
@@ -142,11 +543,43 @@ template <typename VT> struct ReadParquet<CSRMatrix<VT>> {
 
 template <typename VT> struct ReadParquet<DenseMatrix<VT>> {
   static void apply(DenseMatrix<VT> *&res, const char *filename, size_t numRows,
-                    size_t numCols) {
-        struct File *file = arrowToCsv(filename);
-        readCsvFile<DenseMatrix<VT>>(res, file, numRows, numCols, ',');
-        closeFile(file);
-    }
+                    size_t numCols, DCTX(ctx)) {
+    ParquetFile file(filename, true);
+    std::shared_ptr<arrow::Table> table = file.readAll();
+    if (static_cast<size_t>(table->num_rows()) != numRows || static_cast<size_t>(table->num_columns()) != numCols)
+      throw std::runtime_error(std::string("ReadParquet: file ") + filename + " does not have the expected shape");
+
+    if (res == nullptr)
+      res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    VT *valuesRes = res->getValues();
+    const size_t rowSkip = res->getRowSkip();
+    WorkerPool::parallelFor(ctx, numCols, [&](size_t c) {
+      copyArrowColumn(*table->column(c), valuesRes + c, rowSkip);
+    });
+  }
+
+  static void applyRows(DenseMatrix<VT> *&res, const char *filename, size_t rowBegin, size_t rowEnd,
+                        DCTX(ctx)) {
+    ParquetFile file(filename, true);
+    size_t firstRow = rowBegin;
+    const std::vector<int> rowGroups = file.getRowGroups(rowBegin, rowEnd, firstRow);
+    std::vector<int> columns(file.getNumColumns());
+    for (size_t c = 0; c < columns.size(); c++)
+      columns[c] = static_cast<int>(c);
+    std::shared_ptr<arrow::Table> table =
+        file.read(columns, rowGroups)->Slice(rowBegin - firstRow, rowEnd - rowBegin);
+    if (static_cast<size_t>(table->num_rows()) != rowEnd - rowBegin)
+      throw std::runtime_error(std::string("ReadParquet: file ") + filename + " has less rows than expected");
+
+    const size_t numCols = columns.size();
+    if (res == nullptr)
+      res = DataObjectFactory::create<DenseMatrix<VT>>(rowEnd - rowBegin, numCols, false);
+    VT *valuesRes = res->getValues();
+    const size_t rowSkip = res->getRowSkip();
+    WorkerPool::parallelFor(ctx, numCols, [&](size_t c) {
+      copyArrowColumn(*table->column(c), valuesRes + c, rowSkip);
+    });
+  }
 };
 
 #endif
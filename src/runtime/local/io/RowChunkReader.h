@@ -0,0 +1,127 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/io/File.h>
+#include <runtime/local/io/ReadCsvFile.h>
+#include <runtime/local/io/ReadDaphne.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <cstddef>
+
+/**
+ * @brief Reads a dense matrix from a file one chunk of rows after the other,
+ * such that the whole matrix is never held in memory, e.g., by a vectorized
+ * pipeline processing each chunk while the next one is read.
+ *
+ * CSV files are parsed from the current position on, Daphne binary files are
+ * read by `readDaphneRows`, i.e., blocked files only read the blocks of the
+ * chunk. Matrix Market files do not store the entries in the order of the
+ * rows in general and cannot be read in chunks.
+ */
+template<typename VT>
+class RowChunkReader {
+public:
+    enum class Format { CSV, DAPHNE };
+
+private:
+    const std::string filename;
+    const Format format;
+    const size_t numRows;
+    const size_t numCols;
+    const char delim;
+    // the context on whose workers the rows of a chunk of a Daphne binary file are read, sequentially if none
+    DaphneContext * const ctx;
+    size_t nextRow = 0;
+    // the open CSV file, whose next line is the first row of the next chunk
+    File * file = nullptr;
+
+public:
+    RowChunkReader(const char * filename, Format format, size_t numRows, size_t numCols, char delim = ',',
+            DCTX(ctx) = nullptr) : filename(filename), format(format), numRows(numRows), numCols(numCols),
+            delim(delim), ctx(ctx) {
+        if(format == Format::CSV) {
+            file = openFile(filename);
+            if(file == nullptr)
+                throw std::runtime_error(std::string("RowChunkReader: cannot open file '") + filename + "'");
+        }
+    }
+
+    RowChunkReader(const RowChunkReader &) = delete;
+    RowChunkReader & operator=(const RowChunkReader &) = delete;
+
+    ~RowChunkReader() {
+        if(file)
+            closeFile(file);
+    }
+
+    size_t getNumRows() const { return numRows; }
+    size_t getNumCols() const { return numCols; }
+
+    /**
+     * @brief Returns the index of the first row the next call of `readNext`
+     * reads.
+     */
+    size_t getNextRow() const { return nextRow; }
+
+    /**
+     * @brief Skips the next (at most) `numSkipped` rows, e.g., to read only a
+     * range of rows. CSV lines are skipped without parsing them.
+     */
+    void skip(size_t numSkipped) {
+        numSkipped = std::min(numSkipped, numRows - nextRow);
+        if(format == Format::CSV)
+            for(size_t i = 0; i < numSkipped; i++)
+                if(*getLine(file) == '\0')
+                    throw std::runtime_error("RowChunkReader: the file '" + filename + "' has less rows than expected");
+        nextRow += numSkipped;
+    }
+
+    /**
+     * @brief Reads the next (at most) `maxRows` rows into a new matrix, or
+     * returns `nullptr` if all rows were read.
+     */
+    DenseMatrix<VT> * readNext(size_t maxRows) {
+        const size_t chunkRows = std::min(maxRows, numRows - nextRow);
+        if(chunkRows == 0)
+            return nullptr;
+        DenseMatrix<VT> * chunk = nullptr;
+        try {
+            if(format == Format::CSV)
+                ReadCsvFile<DenseMatrix<VT>>::apply(chunk, file, chunkRows, numCols, delim);
+            else {
+                readDaphneRows(chunk, filename.c_str(), nextRow, nextRow + chunkRows, ctx);
+                if(chunk == nullptr || chunk->getNumRows() != chunkRows || chunk->getNumCols() != numCols)
+                    throw std::runtime_error("RowChunkReader: the file '" + filename
+                            + "' does not contain the dense matrix of the expected shape");
+            }
+        }
+        catch(...) {
+            if(chunk)
+                DataObjectFactory::destroy(chunk);
+            throw;
+        }
+        nextRow += chunkRows;
+        return chunk;
+    }
+};
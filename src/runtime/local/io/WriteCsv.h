@@ -17,20 +17,102 @@
 #ifndef SRC_RUNTIME_LOCAL_IO_WRITECSV_H
 #define SRC_RUNTIME_LOCAL_IO_WRITECSV_H
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 
 #include <runtime/local/io/File.h>
 #include <runtime/local/io/utils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
-#include <limits>
-#include <sstream>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+struct CsvWriteOptions {
+    // the context on whose workers the rows are formatted and written,
+    // sequentially if none
+    DaphneContext * ctx = nullptr;
+    // if not zero, the rows are split into this many partitions, each written
+    // to its own file (see csvPartitionFilename) without a global scan
+    size_t numPartitions = 0;
+};
+
+/**
+ * @brief Returns the name of the file of the i-th partition, i.e., the index
+ * is inserted before the extension (`out.csv` becomes `out.3.csv`).
+ */
+inline std::string csvPartitionFilename(const char * filename, size_t i) {
+    const std::string fn(filename);
+    const size_t dot = fn.find_last_of('.');
+    const size_t slash = fn.find_last_of('/');
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return fn + "." + std::to_string(i);
+    return fn.substr(0, dot) + "." + std::to_string(i) + fn.substr(dot);
+}
+
+// ****************************************************************************
+// Formatting of the cells
+// ****************************************************************************
+
+// the maximum number of characters of a formatted value
+template<typename VT>
+constexpr size_t csvMaxValueChars() {
+    if constexpr(std::is_floating_point<VT>::value)
+        // sign, integral digits, point, and the 6 digits of the fraction
+        return std::numeric_limits<VT>::max_exponent10 + 10;
+    else
+        return std::numeric_limits<VT>::digits10 + 3;
+}
+
+// formats like "%f" for floating-point and "%d" for integral values
+template<typename VT>
+char * formatCsvValue(char * dst, char * end, VT v) {
+    std::to_chars_result r;
+    if constexpr(std::is_floating_point<VT>::value)
+        r = std::to_chars(dst, end, v, std::chars_format::fixed, 6);
+    else
+        r = std::to_chars(dst, end, v);
+    assert(r.ec == std::errc() && "the buffer of a row is too small");
+    return r.ptr;
+}
+
+/**
+ * @brief Appends the rows [rowBegin, rowEnd) of the matrix as CSV lines to
+ * buf[0, len), growing buf, and returns the new length.
+ */
+template<typename VT>
+size_t formatCsvRows(const DenseMatrix<VT> * arg, size_t rowBegin, size_t rowEnd, std::vector<char> & buf, size_t len = 0) {
+    const size_t numCols = arg->getNumCols();
+    const size_t rowSkip = arg->getRowSkip();
+    const VT * valuesArg = arg->getValues();
+    const size_t maxRowChars = std::max<size_t>(1, numCols * (csvMaxValueChars<VT>() + 1));
+    for(size_t r = rowBegin; r < rowEnd; r++) {
+        if(buf.size() - len < maxRowChars)
+            buf.resize(std::max(2 * buf.size(), len + maxRowChars));
+        char * dst = buf.data() + len;
+        char * end = buf.data() + buf.size();
+        const VT * row = valuesArg + r * rowSkip;
+        for(size_t c = 0; c < numCols; c++) {
+            dst = formatCsvValue(dst, end, row[c]);
+            *dst++ = (c + 1 < numCols) ? ',' : '\n';
+        }
+        len = dst - buf.data();
+    }
+    return len;
+}
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -39,6 +121,7 @@
 template <class DTArg>
 struct WriteCsv {
     static void apply(const DTArg *arg, File *file) = delete;
+    static void apply(const DTArg *arg, const char * filename, const CsvWriteOptions & opts) = delete;
 };
 
 // ****************************************************************************
@@ -50,6 +133,15 @@ void writeCsv(const DTArg *arg, File *file) {
     WriteCsv<DTArg>::apply(arg, file);
 }
 
+/**
+ * @brief Writes a data object to a CSV file (or one file per partition, see
+ * `CsvWriteOptions`), formatting and writing chunks of rows in parallel.
+ */
+template <class DTArg>
+void writeCsv(const DTArg *arg, const char * filename, const CsvWriteOptions & opts = CsvWriteOptions()) {
+    WriteCsv<DTArg>::apply(arg, filename, opts);
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -60,26 +152,99 @@ void writeCsv(const DTArg *arg, File *file) {
 
 template <typename VT>
 struct WriteCsv<DenseMatrix<VT>> {
+    // the cells formatted into the buffer of one chunk of rows
+    static constexpr size_t CELLS_PER_CHUNK = 1 << 16;
+    // the chunks of each worker formatted before they are written
+    static constexpr size_t CHUNKS_PER_WORKER = 4;
+
+    static size_t getRowsPerChunk(const DenseMatrix<VT> *arg) {
+        return std::max<size_t>(1, CELLS_PER_CHUNK / std::max<size_t>(1, arg->getNumCols()));
+    }
+
     static void apply(const DenseMatrix<VT> *arg, File* file) {
         assert(file != nullptr && "File required");
-        const VT * valuesArg = arg->getValues();
-        size_t cell = 0;
-        for (size_t i = 0; i < arg->getNumRows(); ++i)
-        {
-            for(size_t j = 0; j < arg->getNumCols(); ++j)
-            {
-                fprintf(
-                        file->identifier,
-                        std::is_floating_point<VT>::value ? "%f" : (std::is_same<VT, long int>::value ? "%ld" : "%d"),
-                        valuesArg[cell++]
-                );
-                if(j < (arg->getNumCols() - 1))
-                    fprintf(file->identifier, ",");
-                else
-                    fprintf(file->identifier, "\n");
+        const size_t numRows = arg->getNumRows();
+        const size_t rowsPerChunk = getRowsPerChunk(arg);
+        std::vector<char> buf;
+        for(size_t r = 0; r < numRows; r += rowsPerChunk) {
+            const size_t len = formatCsvRows(arg, r, std::min(numRows, r + rowsPerChunk), buf);
+            if(fwrite(buf.data(), 1, len, file->identifier) != len)
+                throw std::runtime_error("WriteCsv: cannot write the file");
+        }
+    }
+
+    static void apply(const DenseMatrix<VT> *arg, const char * filename, const CsvWriteOptions & opts) {
+        if(opts.numPartitions)
+            writePartitions(arg, filename, opts);
+        else
+            writeFile(arg, filename, opts.ctx);
+    }
+
+private:
+    static int openForWrite(const std::string & filename) {
+        const int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0)
+            throw std::runtime_error("WriteCsv: cannot open file " + filename);
+        return fd;
+    }
+
+    // rounds of chunks are formatted in parallel, the offsets of their lines
+    // are the exclusive scan of the chunk lengths
+    static void writeFile(const DenseMatrix<VT> *arg, const char * filename, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t rowsPerChunk = getRowsPerChunk(arg);
+        const size_t numChunks = (numRows + rowsPerChunk - 1) / rowsPerChunk;
+        const size_t chunksPerRound = WorkerPool::getNumWorkers(ctx) * CHUNKS_PER_WORKER;
+
+        std::vector<std::vector<char>> bufs(std::min(numChunks, chunksPerRound));
+        std::vector<size_t> lens(bufs.size());
+        std::vector<uint64_t> offsets(bufs.size());
+        const int fd = openForWrite(filename);
+        try {
+            uint64_t pos = 0;
+            for(size_t first = 0; first < numChunks; first += chunksPerRound) {
+                const size_t n = std::min(chunksPerRound, numChunks - first);
+                WorkerPool::parallelFor(ctx, n, [&](size_t i) {
+                    const size_t r = (first + i) * rowsPerChunk;
+                    lens[i] = formatCsvRows(arg, r, std::min(numRows, r + rowsPerChunk), bufs[i]);
+                });
+                for(size_t i = 0; i < n; i++) {
+                    offsets[i] = pos;
+                    pos += lens[i];
+                }
+                WorkerPool::parallelFor(ctx, n, [&](size_t i) {
+                    pwriteAll(fd, bufs[i].data(), lens[i], offsets[i]);
+                });
             }
+        } catch(...) {
+            close(fd);
+            throw;
         }
-   }
+        close(fd);
+    }
+
+    static void writePartitions(const DenseMatrix<VT> *arg, const char * filename, const CsvWriteOptions & opts) {
+        const size_t numRows = arg->getNumRows();
+        const size_t rowsPerChunk = getRowsPerChunk(arg);
+        WorkerPool::parallelFor(opts.ctx, opts.numPartitions, [&](size_t p) {
+            const size_t rowBegin = numRows * p / opts.numPartitions;
+            const size_t rowEnd = numRows * (p + 1) / opts.numPartitions;
+            std::vector<char> buf;
+            const int fd = openForWrite(csvPartitionFilename(filename, p));
+            try {
+                uint64_t pos = 0;
+                for(size_t r = rowBegin; r < rowEnd; r += rowsPerChunk) {
+                    const size_t len = formatCsvRows(arg, r, std::min(rowEnd, r + rowsPerChunk), buf);
+                    pwriteAll(fd, buf.data(), len, pos);
+                    pos += len;
+                }
+            } catch(...) {
+                close(fd);
+                throw;
+            }
+            close(fd);
+        });
+    }
 };
   
-#endif // SRC_RUNTIME_LOCAL_IO_WRITECSV_H
\ No newline at end of file
+#endif // SRC_RUNTIME_LOCAL_IO_WRITECSV_H
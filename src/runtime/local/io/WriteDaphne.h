@@ -17,42 +17,106 @@
 #ifndef SRC_RUNTIME_LOCAL_IO_WRITEDAPHNE_H
 #define SRC_RUNTIME_LOCAL_IO_WRITEDAPHNE_H
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 
 #include <runtime/local/io/utils.h>
 #include <runtime/local/io/DaphneFile.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include <cassert>
+#include <cerrno>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <ios>
 #include <limits>
 #include <stdlib.h>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
 
 template <class DTArg>
 struct WriteDaphne {
-    static void apply(const DTArg *arg, const char * filename) = delete;
+    static void apply(const DTArg *arg, const char * filename, const DF_options & opts) = delete;
 };
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
+/**
+ * @brief Writes a data object to a Daphne binary file.
+ *
+ * @param opts Whether a dense matrix is stored as (compressed) blocks, see
+ * `DF_options`. Sparse matrices are always stored as a single body, frames
+ * column by column (see `DF_version_frame`).
+ */
 template <class DTArg>
-void writeDaphne(const DTArg *arg, const char * filename) {
-    WriteDaphne<DTArg>::apply(arg, filename);
+void writeDaphne(const DTArg *arg, const char * filename, const DF_options & opts = DF_options()) {
+    WriteDaphne<DTArg>::apply(arg, filename, opts);
+}
+
+inline void appendDaphneBytes(std::vector<uint8_t> & head, const void * src, size_t nbytes) {
+	head.insert(head.end(), static_cast<const uint8_t *>(src), static_cast<const uint8_t *>(src) + nbytes);
+}
+
+inline int openDaphneFileForWrite(const char * filename) {
+	const int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		throw std::runtime_error(std::string("WriteDaphne: cannot open file ") + filename);
+	return fd;
+}
+
+/**
+ * @brief Writes the header at the start of the file, lets write(fd) write the
+ * rest at precomputed offsets, and ends the file at size (the padding between
+ * the parts is left to the file system).
+ */
+template <typename Func>
+void writeDaphneFile(const char * filename, const std::vector<uint8_t> & head, uint64_t size, Func write) {
+	const int fd = openDaphneFileForWrite(filename);
+	try {
+		pwriteAll(fd, head.data(), head.size(), 0);
+		write(fd);
+		if (ftruncate(fd, size) != 0)
+			throw std::runtime_error("WriteDaphne: cannot write the file");
+	} catch (...) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+}
+
+// writes the contiguous array src in pieces of DF_default_block_bytes on the workers of ctx
+inline void writeDaphneArray(int fd, const void * src, uint64_t nbytes, uint64_t pos, DCTX(ctx)) {
+	const uint8_t * s = static_cast<const uint8_t *>(src);
+	const uint64_t numPieces = (nbytes + DF_default_block_bytes - 1) / DF_default_block_bytes;
+	WorkerPool::parallelFor(ctx, numPieces, [&](size_t i) {
+		const uint64_t offset = i * DF_default_block_bytes;
+		pwriteAll(fd, s + offset, std::min(DF_default_block_bytes, nbytes - offset), pos + offset);
+	});
 }
 
 // ****************************************************************************
@@ -65,189 +129,447 @@ void writeDaphne(const DTArg *arg, const char * filename) {
 
 template <typename VT>
 struct WriteDaphne<DenseMatrix<VT>> {
-    static void apply(const DenseMatrix<VT> *arg, const char * filename) {
+    static void apply(const DenseMatrix<VT> *arg, const char * filename, const DF_options & opts) {
+	writeValues(arg->getValues(), arg->getNumRows(), arg->getNumCols(), arg->getRowSkip(), filename, opts);
+    }
 
-	std::ofstream f;
-	f.open(filename, std::ios::out|std::ios::binary);
-	// TODO: check f.good()
+    /**
+     * @brief Writes the values of a dense matrix, whose rows are `rowSkip` values apart, e.g., those of a matrix
+     * spilled to disk (see `AllocationDescriptorDisk`).
+     */
+    static void writeValues(const VT *valuesArg, uint64_t numRows, uint64_t numCols, size_t rowSkip,
+		    const char * filename, const DF_options & opts) {
+	if (opts.rowsPerBlock != 0 || opts.compression != DF_compression_t::none) {
+		writeBlocks(valuesArg, numRows, numCols, rowSkip, filename, opts);
+		return;
+	}
 
-	// write header
-	DF_header h;
-	h.version = 1;
+	// header, single body, and block header
+	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;
+	DF_header h = {};
+	h.version = DF_version;
 	h.dt = DF_data_t::DenseMatrix_t;
-	h.nbrows = (uint64_t) arg->getNumRows();
-	h.nbcols = (uint64_t) arg->getNumCols();
-	f.write((const char *)&h, sizeof(h));
-
-	// value type
-	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;	
-	f.write((const char *) &vt, sizeof(vt)); 
-
-	// write body
-        // single block
-	DF_body b;
-	b.rx = 0;
-	b.cx = 0;
-	f.write((const char *)&b, sizeof(b));
-
-	// block header
-	DF_body_block bb;
-	bb.nbrows = (uint32_t) arg->getNumRows();
-	bb.nbcols = (uint32_t) arg->getNumCols();
+	h.nbrows = numRows;
+	h.nbcols = numCols;
+	DF_body b = {};
+	DF_body_block bb = {};
+	bb.nbrows = (uint32_t) numRows;
+	bb.nbcols = (uint32_t) numCols;
 	bb.bt = DF_body_t::dense;
-	f.write((const char *)&bb, sizeof(bb));
+	std::vector<uint8_t> head;
+	appendDaphneBytes(head, &h, sizeof(h));
+	appendDaphneBytes(head, &vt, sizeof(vt));
+	appendDaphneBytes(head, &b, sizeof(b));
+	appendDaphneBytes(head, &bb, sizeof(bb));
+	appendDaphneBytes(head, &vt, sizeof(vt));
+
+	// block values, the rows of views are gathered in chunks
+	const uint64_t rowBytes = numCols * sizeof(VT);
+	const uint64_t valuesPos = DF_align(head.size());
+	const uint64_t size = valuesPos + numRows * rowBytes;
+	writeDaphneFile(filename, head, size, [&](int fd) {
+		if (rowSkip == numCols || numRows <= 1) {
+			writeDaphneArray(fd, valuesArg, numRows * rowBytes, valuesPos, opts.ctx);
+			return;
+		}
+		const uint64_t rowsPerChunk = std::max<uint64_t>(1, DF_default_block_bytes / std::max<uint64_t>(1, rowBytes));
+		const uint64_t numChunks = (numRows + rowsPerChunk - 1) / rowsPerChunk;
+		WorkerPool::parallelFor(opts.ctx, numChunks, [&](size_t i) {
+			const uint64_t rx = i * rowsPerChunk;
+			const uint64_t n = std::min(rowsPerChunk, numRows - rx);
+			std::vector<uint8_t> gathered(n * rowBytes);
+			for (uint64_t r = 0; r < n; r++)
+				memcpy(gathered.data() + r * rowBytes, valuesArg + (rx + r) * rowSkip, rowBytes);
+			pwriteAll(fd, gathered.data(), gathered.size(), valuesPos + rx * rowBytes);
+		});
+	});
+   }
 
-	// value type
-	f.write((const char *) &vt, sizeof(vt)); 
+    static void writeBlocks(const VT *valuesArg, uint64_t numRows, uint64_t numCols, size_t rowSkip,
+		    const char * filename, const DF_options & opts) {
+#ifndef USE_ZLIB
+	if (opts.compression == DF_compression_t::zlib)
+		throw std::runtime_error("WriteDaphne: zlib compression is not supported by this build");
+#endif
+#ifndef USE_LZ4
+	if (opts.compression == DF_compression_t::lz4)
+		throw std::runtime_error("WriteDaphne: lz4 compression is not supported by this build");
+#endif
+	const uint64_t rowBytes = numCols * sizeof(VT);
+	uint64_t rowsPerBlock = opts.rowsPerBlock;
+	if (rowsPerBlock == 0)
+		rowsPerBlock = std::max<uint64_t>(1, DF_default_block_bytes / std::max<uint64_t>(1, rowBytes));
+	const uint64_t numBlocks = (numRows + rowsPerBlock - 1) / rowsPerBlock;
+
+	// compress and check the blocks in parallel, keeping the blocks not stored as in the matrix
+	std::vector<DF_block_entry> entries(numBlocks);
+	std::vector<std::vector<uint8_t>> stored(numBlocks);
+	std::vector<const uint8_t *> blocks(numBlocks);
+	WorkerPool::parallelFor(opts.ctx, numBlocks, [&](size_t i) {
+		DF_block_entry & e = entries[i];
+		e.rx = i * rowsPerBlock;
+		e.nbrows = std::min(rowsPerBlock, numRows - e.rx);
+		const uint64_t rawBytes = e.nbrows * rowBytes;
+
+		const VT * raw = valuesArg + e.rx * rowSkip;
+		std::vector<uint8_t> gathered;
+		if (rowSkip != numCols && e.nbrows > 1) {
+			gathered.resize(rawBytes);
+			for (uint64_t r = 0; r < e.nbrows; r++)
+				memcpy(gathered.data() + r * rowBytes, valuesArg + (e.rx + r) * rowSkip, rowBytes);
+			raw = reinterpret_cast<const VT *>(gathered.data());
+		}
 
-	// block values
-	const VT * valuesArg = arg->getValues();
-	f.write((const char *)valuesArg, arg->getNumRows() * arg->getNumCols() * sizeof(VT));
+		VT minVal = numCols ? raw[0] : VT(0);
+		VT maxVal = minVal;
+		for (uint64_t j = 1; j < e.nbrows * numCols; j++) {
+			minVal = std::min(minVal, raw[j]);
+			maxVal = std::max(maxVal, raw[j]);
+		}
+		e.min = DF_packStat(minVal);
+		e.max = DF_packStat(maxVal);
+
+		blocks[i] = reinterpret_cast<const uint8_t *>(raw);
+		e.nbytes = rawBytes;
+#ifdef USE_ZLIB
+		if (opts.compression == DF_compression_t::zlib) {
+			uLongf n = compressBound(rawBytes);
+			stored[i].resize(n);
+			if (compress2(stored[i].data(), &n, blocks[i], rawBytes, Z_BEST_SPEED) != Z_OK)
+				throw std::runtime_error("WriteDaphne: cannot compress a block");
+			stored[i].resize(n);
+			blocks[i] = stored[i].data();
+			e.nbytes = n;
+		}
+		else
+#endif
+#ifdef USE_LZ4
+		if (opts.compression == DF_compression_t::lz4) {
+			if (rawBytes > static_cast<uint64_t>(LZ4_MAX_INPUT_SIZE))
+				throw std::runtime_error("WriteDaphne: the block is too large for lz4 compression");
+			stored[i].resize(LZ4_compressBound(static_cast<int>(rawBytes)));
+			const int n = LZ4_compress_default(reinterpret_cast<const char *>(blocks[i]),
+					reinterpret_cast<char *>(stored[i].data()), static_cast<int>(rawBytes),
+					static_cast<int>(stored[i].size()));
+			if (n <= 0)
+				throw std::runtime_error("WriteDaphne: cannot compress a block");
+			stored[i].resize(n);
+			blocks[i] = stored[i].data();
+			e.nbytes = n;
+		}
+		else
+#endif
+		if (!gathered.empty()) {
+			stored[i] = std::move(gathered);
+			blocks[i] = stored[i].data();
+		}
+		e.checksum = DF_crc32(0, blocks[i], e.nbytes);
+	});
+
+	uint64_t pos = sizeof(DF_header) + sizeof(ValueTypeCode) + sizeof(DF_block_index)
+			+ numBlocks * sizeof(DF_block_entry);
+	for (DF_block_entry & e : entries) {
+		pos = DF_align(pos);
+		e.offset = pos;
+		pos += e.nbytes;
+	}
 
-	f.close();
-	return;
+	// the header and the block index, the padding between the blocks is left to the file system
+	DF_header h = {};
+	h.version = DF_version_blocks;
+	h.dt = DF_data_t::DenseMatrix_t;
+	h.nbrows = numRows;
+	h.nbcols = numCols;
+	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;
+	DF_block_index idx = {};
+	idx.nbblocks = numBlocks;
+	idx.rowsPerBlock = rowsPerBlock;
+	idx.compression = opts.compression;
+	std::vector<uint8_t> head;
+	appendDaphneBytes(head, &h, sizeof(h));
+	appendDaphneBytes(head, &vt, sizeof(vt));
+	appendDaphneBytes(head, &idx, sizeof(idx));
+	appendDaphneBytes(head, entries.data(), numBlocks * sizeof(DF_block_entry));
+
+	// the file ends after the last block, even if that is empty
+	writeDaphneFile(filename, head, pos, [&](int fd) {
+		WorkerPool::parallelFor(opts.ctx, numBlocks, [&](size_t i) {
+			pwriteAll(fd, blocks[i], entries[i].nbytes, entries[i].offset);
+		});
+	});
    }
 };
   
 template <typename VT>
 struct WriteDaphne<CSRMatrix<VT>> {
-    static void apply(const CSRMatrix<VT> *arg, const char * filename) {
-
-	std::ofstream f;
-	f.open(filename, std::ios::out|std::ios::binary);
-	// TODO: check f.good()
+    static void apply(const CSRMatrix<VT> *arg, const char * filename, const DF_options & opts) {
 
-	// write header
-	DF_header h;
-	h.version = 1;
+	// header, single body, block header, and the number of non-zeros
+	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;
+	DF_header h = {};
+	h.version = DF_version;
 	h.dt = DF_data_t::CSRMatrix_t;
 	h.nbrows = (uint64_t) arg->getNumRows();
 	h.nbcols = (uint64_t) arg->getNumCols();
-	f.write((const char *)&h, sizeof(h));
-
-	// value type
-	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;	
-	f.write((const char *) &vt, sizeof(vt)); 
-
-	// write body
-        // single block
-	DF_body b;
-	b.rx = 0;
-	b.cx = 0;
-	f.write((const char *)&b, sizeof(b));
-
-	// block header
-	DF_body_block bb;
+	DF_body b = {};
+	DF_body_block bb = {};
 	bb.nbrows = (uint32_t) arg->getNumRows();
 	bb.nbcols = (uint32_t) arg->getNumCols();
-	bb.bt = DF_body_t::sparse;
-	f.write((const char *)&bb, sizeof(bb));
-
-	// value type
-	f.write((const char *) &vt, sizeof(vt));
-
-	// nzb value
-        const size_t nzb = arg->getNumNonZeros();
-	f.write((const char *) &nzb, sizeof(nzb) );
-
-	// CSR values
-	for (size_t i = 0; i < arg->getNumRows(); i++) {
-		// nzv for row i
-		const size_t nzb_i = arg->getNumNonZeros(i);
-	        f.write((const char *) &nzb_i, sizeof(nzb_i));
-
-		// values for row i
-		const VT * vals= arg->getValues(i);
-		const size_t * colIdxs= arg->getColIdxs(i);
+	bb.bt = DF_body_t::csr;
+	const size_t nzb = arg->getNumNonZeros();
+	std::vector<uint8_t> head;
+	appendDaphneBytes(head, &h, sizeof(h));
+	appendDaphneBytes(head, &vt, sizeof(vt));
+	appendDaphneBytes(head, &b, sizeof(b));
+	appendDaphneBytes(head, &bb, sizeof(bb));
+	appendDaphneBytes(head, &vt, sizeof(vt));
+	appendDaphneBytes(head, &nzb, sizeof(nzb));
+
+	// the aligned CSR arrays
+	const size_t numRows = arg->getNumRows();
+	const uint64_t rowOffsetsPos = DF_align(head.size());
+	const uint64_t colIdxsPos = DF_align(rowOffsetsPos + (numRows + 1) * sizeof(size_t));
+	const uint64_t valuesPos = DF_align(colIdxsPos + nzb * sizeof(size_t));
+	const uint64_t size = valuesPos + nzb * sizeof(VT);
+
+	// the row offsets of views are rebased to zero
+	const size_t * rowOffsets = arg->getRowOffsets();
+	std::vector<size_t> rebased;
+	if (rowOffsets[0] != 0) {
+		rebased.resize(numRows + 1);
+		for (size_t i = 0; i <= numRows; i++)
+			rebased[i] = rowOffsets[i] - rowOffsets[0];
+		rowOffsets = rebased.data();
+	}
 
-		for (size_t j=0; j < nzb_i; j++) {
-			f.write((const char *) &colIdxs[j], sizeof(colIdxs[j]));
-			f.write((const char *) &(vals[j]), sizeof(VT));
+	writeDaphneFile(filename, head, size, [&](int fd) {
+		writeDaphneArray(fd, rowOffsets, (numRows + 1) * sizeof(size_t), rowOffsetsPos, opts.ctx);
+		writeDaphneArray(fd, arg->getColIdxs(0), nzb * sizeof(size_t), colIdxsPos, opts.ctx);
+		writeDaphneArray(fd, arg->getValues(0), nzb * sizeof(VT), valuesPos, opts.ctx);
+	});
+   }
+};
+  
+template <typename VT>
+struct WriteDaphne<DCSRMatrix<VT>> {
+    static void apply(const DCSRMatrix<VT> *arg, const char * filename, const DF_options & opts) {
+	const size_t numRows = arg->getNumRows();
+	const size_t numCols = arg->getNumCols();
+	if (numRows > std::numeric_limits<uint32_t>::max() || numCols > std::numeric_limits<uint32_t>::max())
+		throw std::runtime_error("WriteDaphne: the ultra-sparse format supports at most 2^32 - 1 rows and columns");
+
+	// header, single body, block header, and the number of non-zeros
+	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;
+	DF_header h = {};
+	h.version = DF_version;
+	h.dt = DF_data_t::CSRMatrix_t;
+	h.nbrows = (uint64_t) numRows;
+	h.nbcols = (uint64_t) numCols;
+	DF_body b = {};
+	DF_body_block bb = {};
+	bb.nbrows = (uint32_t) numRows;
+	bb.nbcols = (uint32_t) numCols;
+	bb.bt = DF_body_t::ultra_sparse;
+	const uint64_t nzb = arg->getNumNonZeros();
+	std::vector<uint8_t> head;
+	appendDaphneBytes(head, &h, sizeof(h));
+	appendDaphneBytes(head, &vt, sizeof(vt));
+	appendDaphneBytes(head, &b, sizeof(b));
+	appendDaphneBytes(head, &bb, sizeof(bb));
+	appendDaphneBytes(head, &vt, sizeof(vt));
+	appendDaphneBytes(head, &nzb, sizeof(nzb));
+
+	// the coordinates (without the column of a single-column matrix) and the value of each non-zero
+	const bool singleCol = numCols == 1;
+	const size_t entrySize = (singleCol ? 1 : 2) * sizeof(uint32_t) + sizeof(VT);
+	std::vector<uint8_t> body(nzb * entrySize);
+	const size_t * rowIdxs = arg->getRowIdxs();
+	const size_t * rowOffsets = arg->getRowOffsets();
+	const size_t * colIdxs = arg->getColIdxs();
+	const VT * values = arg->getValues();
+	uint8_t * entry = body.data();
+	for (size_t i = 0; i < arg->getNumNonZeroRows(); i++) {
+		const uint32_t row = (uint32_t) rowIdxs[i];
+		for (size_t k = rowOffsets[i]; k < rowOffsets[i + 1]; k++, entry += entrySize) {
+			const uint32_t col = (uint32_t) colIdxs[k];
+			memcpy(entry, &row, sizeof(row));
+			if (!singleCol)
+				memcpy(entry + sizeof(row), &col, sizeof(col));
+			memcpy(entry + entrySize - sizeof(VT), values + k, sizeof(VT));
 		}
 	}
 
-	f.close();
-	return;
+	writeDaphneFile(filename, head, head.size() + body.size(), [&](int fd) {
+		writeDaphneArray(fd, body.data(), body.size(), head.size(), opts.ctx);
+	});
    }
 };
   
+// the arrays of a string column of a frame, see DF_column_t
+struct DF_string_arrays {
+	std::vector<uint32_t> codes;
+	std::vector<uint64_t> offsets;
+	std::string bytes;
+
+	void pack(const std::string * strings, size_t n) {
+		offsets.resize(n + 1);
+		offsets[0] = 0;
+		for (size_t i = 0; i < n; i++)
+			offsets[i + 1] = offsets[i] + strings[i].size();
+		bytes.reserve(offsets[n]);
+		for (size_t i = 0; i < n; i++)
+			bytes += strings[i];
+	}
+};
+
 template <>
 struct WriteDaphne<Frame> {
-    static void apply(const Frame *arg, const char * filename) {
-
-	std::ofstream f;
-	f.open(filename, std::ios::out|std::ios::binary);
-	// TODO: check f.good()
-
-	// write header
-	DF_header h;
-	h.version = 1;
-	h.dt = DF_data_t::Frame_t;
-	h.nbrows = (uint64_t) arg->getNumRows();
-	h.nbcols = (uint64_t) arg->getNumCols();
-	f.write((const char *)&h, sizeof(h));
-
+    static void apply(const Frame *arg, const char * filename, const DF_options & opts) {
+	const uint64_t numRows = arg->getNumRows();
+	const uint64_t numCols = arg->getNumCols();
 	const ValueTypeCode * schema = arg->getSchema();
-	const std::string *labels = arg->getLabels();
+	const std::string * labels = arg->getLabels();
 
-	for (uint64_t c = 0; c < h.nbcols; c++) {
-		f.write((const char *)&(schema[c]), sizeof(ValueTypeCode));
-	}
-
-	for (uint64_t c = 0; c < h.nbcols; c++) {
-		uint16_t len = (labels[c]).length();
-		f.write((const char *) &len, sizeof(len));
-		f.write((const char *) &(labels[c]), len);
+	// header, schema, labels, and (below) the column descriptors
+	DF_header h = {};
+	h.version = DF_version_frame;
+	h.dt = DF_data_t::Frame_t;
+	h.nbrows = numRows;
+	h.nbcols = numCols;
+	std::vector<uint8_t> head;
+	appendDaphneBytes(head, &h, sizeof(h));
+	appendDaphneBytes(head, schema, numCols * sizeof(ValueTypeCode));
+	for (uint64_t c = 0; c < numCols; c++) {
+		if (labels[c].size() > std::numeric_limits<uint16_t>::max())
+			throw std::runtime_error("WriteDaphne: the label of a column must have at most 65535 bytes");
+		const uint16_t len = labels[c].size();
+		appendDaphneBytes(head, &len, sizeof(len));
+		appendDaphneBytes(head, labels[c].data(), len);
 	}
 
-	DF_body b;
-	b.rx = 0; b.cx = 0;
-	f.write((char *)&b, sizeof(b));
-	//TODO: consider multiple blocks
-	// Assuming a dense block representation
-	// TODO: Consider alternative representations for frames
-
-	void* vals[h.nbcols];
-	for (size_t c = 0; c < h.nbcols; c++) {
-		vals[c] = const_cast<void*>(arg->getColumnRaw(c));
+	std::vector<DF_frame_column> cols(numCols);
+	std::vector<DF_string_arrays> strings(numCols);
+	uint64_t pos = DF_align(head.size() + numCols * sizeof(DF_frame_column));
+	for (uint64_t c = 0; c < numCols; c++) {
+		DF_frame_column & col = cols[c];
+		col.offset = pos;
+		if (schema[c] != ValueTypeCode::STR)
+			col.ct = DF_column_t::plain;
+		else if (packDictionary(arg, c, strings[c])) {
+			col.ct = DF_column_t::dictionary;
+			col.dictsize = strings[c].offsets.size() - 1;
+			col.nbytes = strings[c].bytes.size();
+		}
+		else {
+			col.ct = DF_column_t::strings;
+			strings[c].pack(static_cast<const std::string *>(arg->getColumnRaw(c)), numRows);
+			col.nbytes = strings[c].bytes.size();
+		}
+		pos = DF_align(DF_layoutColumn(col, numRows, ValueTypeUtils::sizeOf(schema[c])).end);
 	}
-
-	for (size_t r=0; r < h.nbrows; r++) {
-		for (size_t c=0; c < h.nbcols; c++) { 
-			switch (schema[c]) {
-				case ValueTypeCode::SI8:
-					f.write((char *)&(reinterpret_cast<int8_t *>(vals[c])[r]), sizeof(int8_t));
-					break;
-				case ValueTypeCode::SI32:
-					f.write((char *)&(reinterpret_cast<int32_t *>(vals[c])[r]), sizeof(int32_t));
-						break;
-				case ValueTypeCode::SI64:
-					f.write((char *)&(reinterpret_cast<int64_t *>(vals[c])[r]), sizeof(int64_t));
-					break;
-				case ValueTypeCode::UI8:
-					f.write((char *)&(reinterpret_cast<uint8_t *>(vals[c])[r]), sizeof(uint8_t));
+	appendDaphneBytes(head, cols.data(), numCols * sizeof(DF_frame_column));
+
+	writeDaphneFile(filename, head, pos, [&](int fd) {
+		for (uint64_t c = 0; c < numCols; c++) {
+			const DF_column_layout l = DF_layoutColumn(cols[c], numRows, ValueTypeUtils::sizeOf(schema[c]));
+			const DF_string_arrays & s = strings[c];
+			switch (cols[c].ct) {
+				case DF_column_t::plain:
+					writeDaphneArray(fd, arg->getColumnRaw(c), l.end - l.values, l.values, opts.ctx);
 					break;
-				case ValueTypeCode::UI32:
-					f.write((char *)&(reinterpret_cast<uint32_t *>(vals[c])[r]), sizeof(uint32_t));
+				case DF_column_t::dictionary:
+					writeDaphneArray(fd, s.codes.data(), s.codes.size() * sizeof(uint32_t), l.codes, opts.ctx);
+					// fall through
+				case DF_column_t::strings:
+					writeDaphneArray(fd, s.offsets.data(), s.offsets.size() * sizeof(uint64_t), l.offsets,
+							opts.ctx);
+					writeDaphneArray(fd, s.bytes.data(), s.bytes.size(), l.values, opts.ctx);
 					break;
-				case ValueTypeCode::UI64:
-					f.write((char *)&(reinterpret_cast<uint64_t *>(vals[c])[r]), sizeof(uint64_t));
-					break;
-				case ValueTypeCode::F32:
-					f.write((char *)&(reinterpret_cast<float *>(vals[c])[r]), sizeof(float));
-					break;
-				case ValueTypeCode::F64:
-					f.write((char *)&(reinterpret_cast<double *>(vals[c])[r]), sizeof(double));
-					break;
-				default:
-					throw std::runtime_error("WriteDaphne::apply: unknown value type code");
 			}
 		}
+	});
+	writeKeyIndexes(arg, filename, opts);
+    }
+
+    /**
+     * @brief Writes the indexes of the frame next to its file (see
+     * `DF_key_indexes_header`), if requested and the frame has any, and
+     * removes the ones of an earlier file of the same name otherwise.
+     */
+    static void writeKeyIndexes(const Frame *arg, const char * filename, const DF_options & opts) {
+	static_assert(sizeof(size_t) == sizeof(uint64_t), "WriteDaphne: the rows of indexes are stored as uint64_t");
+	const std::string idxFilename = std::string(filename) + DF_key_indexes_suffix;
+	const std::vector<std::shared_ptr<const KeyIndex>> keyIndexes = arg->getKeyIndexes();
+	if (!opts.keyIndexes || keyIndexes.empty()) {
+		if (unlink(idxFilename.c_str()) != 0 && errno != ENOENT)
+			throw std::runtime_error("WriteDaphne: cannot remove the stale indexes " + idxFilename);
+		return;
+	}
+	struct stat st;
+	if (stat(filename, &st) != 0)
+		throw std::runtime_error(std::string("WriteDaphne: cannot read the size of ") + filename);
+
+	DF_key_indexes_header h = {DF_key_indexes_magic, arg->getNumRows(), keyIndexes.size(),
+			static_cast<uint64_t>(st.st_size)};
+	std::vector<uint8_t> head;
+	appendDaphneBytes(head, &h, sizeof(h));
+	for (const auto & keyIndex : keyIndexes) {
+		const uint64_t numKeyCols = keyIndex->getKeyCols().size();
+		const uint64_t numKeys = keyIndex->getNumKeys();
+		appendDaphneBytes(head, &numKeyCols, sizeof(numKeyCols));
+		appendDaphneBytes(head, keyIndex->getKeyCols().data(), numKeyCols * sizeof(uint64_t));
+		appendDaphneBytes(head, &numKeys, sizeof(numKeys));
+	}
+	uint64_t pos = head.size();
+	for (const auto & keyIndex : keyIndexes)
+		pos += (keyIndex->getBegins().size() + keyIndex->getRows().size()) * sizeof(uint64_t);
+
+	writeDaphneFile(idxFilename.c_str(), head, pos, [&](int fd) {
+		uint64_t p = head.size();
+		for (const auto & keyIndex : keyIndexes)
+			for (const std::vector<size_t> * a : {&keyIndex->getBegins(), &keyIndex->getRows()}) {
+				writeDaphneArray(fd, a->data(), a->size() * sizeof(uint64_t), p, opts.ctx);
+				p += a->size() * sizeof(uint64_t);
+			}
+	});
+    }
 
+    /**
+     * @brief Packs the codes and the sorted distinct strings of the c-th
+     * column, if it is dictionary-encoded or has few distinct strings (see
+     * `DF_dictionary_max_distinct`).
+     */
+    static bool packDictionary(const Frame *arg, size_t c, DF_string_arrays & arrays) {
+	const size_t numRows = arg->getNumRows();
+	if (numRows > std::numeric_limits<uint32_t>::max())
+		return false;
+	if (auto dictCol = arg->getDictionaryColumn<std::string>(c)) {
+		const std::vector<std::string> & dictionary = *dictCol->getDictionary();
+		arrays.codes.resize(numRows);
+		for (size_t r = 0; r < numRows; r++)
+			arrays.codes[r] = dictCol->getCode(r);
+		arrays.pack(dictionary.data(), dictionary.size());
+		return true;
 	}
 
-	f.close();
-	return;
+	const std::string * values = static_cast<const std::string *>(arg->getColumnRaw(c));
+	const size_t maxDistinct = numRows * DF_dictionary_max_distinct;
+	std::unordered_map<std::string_view, uint32_t> codes;
+	for (size_t r = 0; r < numRows; r++)
+		if (codes.emplace(values[r], 0).second && codes.size() > maxDistinct)
+			return false;
+	std::vector<std::string> dictionary;
+	dictionary.reserve(codes.size());
+	for (const auto & entry : codes)
+		dictionary.emplace_back(entry.first);
+	std::sort(dictionary.begin(), dictionary.end());
+	for (size_t i = 0; i < dictionary.size(); i++)
+		codes[dictionary[i]] = i;
+	arrays.codes.resize(numRows);
+	for (size_t r = 0; r < numRows; r++)
+		arrays.codes[r] = codes[values[r]];
+	arrays.pack(dictionary.data(), dictionary.size());
+	return true;
     }
 };
 
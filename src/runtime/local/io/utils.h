@@ -17,12 +17,19 @@
 #ifndef SRC_RUNTIME_LOCAL_IO_UTILS_H
 #define SRC_RUNTIME_LOCAL_IO_UTILS_H
 
+#include <charconv>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <type_traits>
 
+#include <cerrno>
 #include <cstdint>
+#include <cstdlib>
+
+#include <unistd.h>
 
 // Conversion of std::string.
 
@@ -56,25 +63,95 @@ inline void convertStr(std::string const &x, uint32_t *v) { *v = stoi(x); }
 inline void convertStr(std::string const &x, uint64_t *v) { *v = stoi(x); }
 
 // Conversion of char *.
+//
+// The conversions parse the longest prefix of [x, end) that is a number, like
+// strtod() and atoi(), after leading whitespace. Floating-point numbers are
+// parsed by std::from_chars(), which is independent of the locale (and much
+// faster), falling back to strtod() only for numbers out of range. A string
+// without a number is converted to NaN (floating-point) or zero (integers).
 
-inline void convertCstr(const char * x, double *v) {
-  char * end;
-  *v = strtod(x, &end);
-  if(x == end)
-    *v = std::numeric_limits<double>::quiet_NaN();
+inline const char *skipSpaces(const char *x, const char *end) {
+  while (x < end && (*x == ' ' || (*x >= '\t' && *x <= '\r')))
+    x++;
+  return x;
 }
-inline void convertCstr(const char * x, float *v) {
-  char * end;
-  *v = strtof(x, &end);
-  if(x == end)
-    *v = std::numeric_limits<float>::quiet_NaN();
+
+template <typename VT>
+inline void convertCstrFloat(const char *x, const char *end, VT *v) {
+  x = skipSpaces(x, end);
+  // from_chars() does not accept a leading plus sign
+  if (x < end && *x == '+' && (x + 1 == end || x[1] != '-'))
+    x++;
+  const std::from_chars_result r = std::from_chars(x, end, *v);
+  if (r.ec == std::errc::invalid_argument)
+    *v = std::numeric_limits<VT>::quiet_NaN();
+  else if (r.ec == std::errc::result_out_of_range) {
+    // infinity, zero or a subnormal number, as with strtod()
+    const std::string str(x, r.ptr);
+    if constexpr (std::is_same<VT, float>::value)
+      *v = strtof(str.c_str(), nullptr);
+    else
+      *v = strtod(str.c_str(), nullptr);
+  }
+}
+
+// like atoi(), but for the whole range of the type (wrapping around on overflow)
+template <typename VT>
+inline void convertCstrInt(const char *x, const char *end, VT *v) {
+  x = skipSpaces(x, end);
+  bool negative = false;
+  if (x < end && (*x == '-' || *x == '+'))
+    negative = *x++ == '-';
+  uint64_t u = 0;
+  for (; x < end && static_cast<unsigned char>(*x - '0') < 10; x++)
+    u = u * 10 + static_cast<uint64_t>(*x - '0');
+  *v = static_cast<VT>(negative ? uint64_t(0) - u : u);
+}
+
+inline void convertCstr(const char *x, const char *end, double *v) { convertCstrFloat(x, end, v); }
+inline void convertCstr(const char *x, const char *end, float *v) { convertCstrFloat(x, end, v); }
+inline void convertCstr(const char *x, const char *end, int8_t *v) { convertCstrInt(x, end, v); }
+inline void convertCstr(const char *x, const char *end, int32_t *v) { convertCstrInt(x, end, v); }
+inline void convertCstr(const char *x, const char *end, int64_t *v) { convertCstrInt(x, end, v); }
+inline void convertCstr(const char *x, const char *end, uint8_t *v) { convertCstrInt(x, end, v); }
+inline void convertCstr(const char *x, const char *end, uint32_t *v) { convertCstrInt(x, end, v); }
+inline void convertCstr(const char *x, const char *end, uint64_t *v) { convertCstrInt(x, end, v); }
+
+// the end of the number (or of the word, e.g., inf or nan) at x in a null-terminated string
+inline const char *numberEnd(const char *x) {
+  while (*x == ' ' || (*x >= '\t' && *x <= '\r'))
+    x++;
+  while ((*x >= '0' && *x <= '9') || (*x >= 'a' && *x <= 'z') || (*x >= 'A' && *x <= 'Z') || *x == '.' || *x == '-'
+         || *x == '+')
+    x++;
+  return x;
+}
+
+template <typename VT>
+inline void convertCstr(const char *x, VT *v) {
+  convertCstr(x, numberEnd(x), v);
+}
+
+// Writing of files.
+
+/**
+ * @brief Writes nbytes bytes to the file at position pos, retrying short and
+ * interrupted writes, such that several threads can write disjoint ranges of
+ * the same file.
+ */
+inline void pwriteAll(int fd, const void * src, uint64_t nbytes, uint64_t pos) {
+  const uint8_t * s = static_cast<const uint8_t *>(src);
+  while (nbytes > 0) {
+    const ssize_t n = pwrite(fd, s, nbytes, pos);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      throw std::runtime_error("cannot write the file");
+    s += n;
+    pos += n;
+    nbytes -= n;
+  }
 }
-inline void convertCstr(const char * x, int8_t *v) { *v = atoi(x); }
-inline void convertCstr(const char * x, int32_t *v) { *v = atoi(x); }
-inline void convertCstr(const char * x, int64_t *v) { *v = atoi(x); }
-inline void convertCstr(const char * x, uint8_t *v) { *v = atoi(x); }
-inline void convertCstr(const char * x, uint32_t *v) { *v = atoi(x); }
-inline void convertCstr(const char * x, uint64_t *v) { *v = atoi(x); }
 
 #endif // SRC_RUNTIME_LOCAL_IO_UTILS_H
 
@@ -19,15 +19,75 @@
 #include "runtime/local/context/DaphneContext.h"
 #include "runtime/local/datastructures/DataObjectFactory.h"
 #include "runtime/local/datastructures/DenseMatrix.h"
+#include "runtime/local/kernels/FastMath.h"
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
 
 namespace Activation {
     struct ReLU {
         static inline int getActivationType() { /* ToDo: ReLU activation */ return 0; }
+
+        template<bool fastMath, typename VT>
+        static inline VT apply(VT x) { return x > VT(0) ? x : VT(0); }
+    };
+
+    struct Sigmoid {
+        // FastMath::sigmoid if the user enabled fast math (a few ULPs off), otherwise via std::exp
+        template<bool fastMath, typename VT>
+        static inline VT apply(VT x) {
+            if constexpr(fastMath)
+                return FastMath::sigmoid(x);
+            else
+                return VT(1) / (VT(1) + std::exp(-x));
+        }
     };
 
     template<typename OP, typename DTRes, typename DTArg>
     struct Forward {
         static void apply(DTRes *&res, [[maybe_unused]] const DTArg *data, DCTX(dctx)) { throw
-                std::runtime_error("C++ ReLU activation not implemented"); }
+                std::runtime_error("C++ activation not implemented for these data types"); }
+    };
+
+    /**
+     * @brief Applies the activation function to each value in a single pass, which the compiler can vectorize.
+     */
+    template<typename OP, typename VT>
+    struct Forward<OP, DenseMatrix<VT>, DenseMatrix<VT>> {
+        static void apply(DenseMatrix<VT> *&res, const DenseMatrix<VT> *data, DCTX(dctx)) {
+            if(res == nullptr)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(data->getNumRows(), data->getNumCols(), false);
+            if(dctx && dctx->config.fast_math)
+                applyOp<true>(res, data);
+            else
+                applyOp<false>(res, data);
+        }
+
+    private:
+        template<bool fastMath>
+        static void applyOp(DenseMatrix<VT> *res, const DenseMatrix<VT> *data) {
+            const size_t numRows = data->getNumRows();
+            const size_t numCols = data->getNumCols();
+            const size_t rowSkipData = data->getRowSkip();
+            const size_t rowSkipRes = res->getRowSkip();
+            const VT *valuesData = data->getValues();
+            VT *valuesRes = res->getValues();
+
+            if(rowSkipData == numCols && rowSkipRes == numCols) {
+                const size_t numCells = numRows * numCols;
+                #pragma omp simd
+                for(size_t i = 0; i < numCells; i++)
+                    valuesRes[i] = OP::template apply<fastMath>(valuesData[i]);
+                return;
+            }
+            for(size_t r = 0; r < numRows; r++) {
+                #pragma omp simd
+                for(size_t c = 0; c < numCols; c++)
+                    valuesRes[c] = OP::template apply<fastMath>(valuesData[c]);
+                valuesData += rowSkipData;
+                valuesRes += rowSkipRes;
+            }
+        }
     };
 }
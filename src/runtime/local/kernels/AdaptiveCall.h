@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_ADAPTIVECALL_H
+#define SRC_RUNTIME_LOCAL_KERNELS_ADAPTIVECALL_H
+
+#include <runtime/local/context/AdaptiveExecution.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Structure.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+template<typename VT>
+int64_t countNonZeros(const DenseMatrix<VT> * arg) {
+    const size_t numRows = arg->getNumRows();
+    const size_t numCols = arg->getNumCols();
+    const size_t rowSkip = arg->getRowSkip();
+    const VT * values = arg->getValues();
+    int64_t nnz = 0;
+    for(size_t r = 0; r < numRows; r++, values += rowSkip)
+        for(size_t c = 0; c < numCols; c++)
+            nnz += values[c] != VT(0);
+    return nnz;
+}
+
+// the properties of a matrix or frame, the number of non-zeros only for matrices of the common value types
+inline ObservedProperties observeProperties(const Structure * arg) {
+    ObservedProperties props{arg->getNumRows(), arg->getNumCols(), -1, false};
+#define OBSERVE_MATRIX(VT) \
+    if(auto mat = dynamic_cast<const CSRMatrix<VT> *>(arg)) { \
+        props.numNonZeros = static_cast<int64_t>(mat->getNumNonZeros()); \
+        props.isSparse = true; \
+    } \
+    else if(auto mat = dynamic_cast<const DenseMatrix<VT> *>(arg)) \
+        props.numNonZeros = countNonZeros(mat);
+    OBSERVE_MATRIX(double)
+    else OBSERVE_MATRIX(float)
+    else OBSERVE_MATRIX(int64_t)
+    else OBSERVE_MATRIX(uint64_t)
+    else OBSERVE_MATRIX(uint8_t)
+#undef OBSERVE_MATRIX
+    return props;
+}
+
+/**
+ * @brief Observes the shapes and numbers of non-zeros of the arguments at an
+ * adaptive checkpoint and hands them over to the compiler of the remainder of
+ * the function, which compiles it for these properties and runs it (see
+ * `AdaptiveCheckpointsPass`).
+ *
+ * @param ir The remainder of the function, as the textual IR of a module.
+ */
+inline void adaptiveCall(const char * ir, const Structure ** args, size_t numArgs, DCTX(ctx)) {
+    if(ctx == nullptr || !ctx->config.adaptive_call)
+        throw std::runtime_error("adaptiveCall: no compiler for the remainder of the function is set");
+    std::vector<ObservedProperties> props;
+    props.reserve(numArgs);
+    for(size_t i = 0; i < numArgs; i++)
+        props.push_back(observeProperties(args[i]));
+    ctx->config.adaptive_call(ir, args, props.data(), numArgs);
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_ADAPTIVECALL_H
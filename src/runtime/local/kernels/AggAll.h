@@ -18,13 +18,21 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_AGGALL_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/AggOpCode.h>
+#include <runtime/local/kernels/AggReduce.h>
+#include <runtime/local/kernels/BitMask.h>
 #include <runtime/local/kernels/EwBinarySca.h>
 
 #include <cassert>
 #include <cstddef>
+#include <stdexcept>
+#include <vector>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -55,100 +63,252 @@ typename DT::VT aggAll(AggOpCode opCode, const DT * arg, DCTX(ctx)) {
 template<typename VT>
 struct AggAll<DenseMatrix<VT>> {
     static VT apply(AggOpCode opCode, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        // the aggregate of a lazy transposition is that of its source
+        if(const DenseMatrix<VT> * src = arg->getTransposedSource())
+            return apply(opCode, src, ctx);
+
+        switch(opCode) {
+            case AggOpCode::SUM: return aggAll<BinaryOpCode::ADD>(arg, VT(0), ctx);
+            case AggOpCode::MIN: return aggAll<BinaryOpCode::MIN>(arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MAX: return aggAll<BinaryOpCode::MAX>(arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MEAN:
+                return aggAll<BinaryOpCode::ADD>(arg, VT(0), ctx) / (arg->getNumCols() * arg->getNumRows());
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggAll for DenseMatrix");
+        }
+    }
+
+private:
+    template<BinaryOpCode op>
+    static VT aggAll(const DenseMatrix<VT> * arg, VT neutral, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
-        
+        const size_t rowSkip = arg->getRowSkip();
         const VT * valuesArg = arg->getValues();
 
-        EwBinaryScaFuncPtr<VT, VT, VT> func;
-        VT agg;
-        if (AggOpCodeUtils::isPureBinaryReduction(opCode)) {
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
-            agg = AggOpCodeUtils::template getNeutral<VT>(opCode);
-        }
-        else {
-            // TODO Setting the function pointer yields the correct result.
-            // However, since MEAN and STDDEV are not sparse-safe, the program
-            // does not take the same path for doing the summation, and is less
-            // efficient.
-            // for MEAN and STDDDEV, we need to sum
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
-            agg = VT(0);
-        }
+        if(rowSkip == numCols || numRows == 1)
+            // contiguous values, reduced as a single array
+            return AggReduce::parallelReduce<op>(valuesArg, numRows * numCols, neutral, ctx);
+
+        // the aggregates of the rows, which are aggregated in turn
+        std::vector<VT> rowAggs(numRows);
+        const size_t numChunks = std::min(AggReduce::getNumChunks(numRows * numCols), numRows);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const auto [rowBegin, rowEnd] = AggReduce::getChunk(numRows, numChunks, i);
+            for(size_t r = rowBegin; r < rowEnd; r++)
+                rowAggs[r] = AggReduce::reduce<op>(valuesArg + r * rowSkip, numCols, neutral, ctx);
+        });
+        return AggReduce::reduce<op>(rowAggs.data(), numRows, neutral, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// scalar <- CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct AggAll<CSRMatrix<VT>> {
+    /**
+     * @brief Aggregates the non-zero values of (a part of) a sparse matrix of `numCells` cells, taking the zeros into
+     * account for operations which are not sparse-safe.
+     */
+    template<BinaryOpCode op>
+    static VT aggArray(const VT * values, size_t numNonZeros, size_t numCells, bool isSparseSafe, VT neutral, DCTX(ctx)) {
+        VT agg = AggReduce::parallelReduce<op>(values, numNonZeros, neutral, ctx);
+        if(!numNonZeros || (!isSparseSafe && numNonZeros < numCells))
+            agg = EwBinarySca<op, VT, VT, VT>::apply(agg, 0, ctx);
+        return agg;
+    }
+
+    static VT apply(AggOpCode opCode, const CSRMatrix<VT> * arg, DCTX(ctx)) {
+        const VT * values = arg->getValues(0);
+        const size_t numNonZeros = arg->getNumNonZeros();
+        const size_t numCells = arg->getNumRows() * arg->getNumCols();
+        const bool isSparseSafe = AggOpCodeUtils::isSparseSafe(opCode);
 
-        for(size_t r = 0; r < numRows; r++) {
-            for(size_t c = 0; c < numCols; c++)
-                agg = func(agg, valuesArg[c], ctx);
-            valuesArg += arg->getRowSkip();
+        switch(opCode) {
+            case AggOpCode::SUM:
+                return aggArray<BinaryOpCode::ADD>(values, numNonZeros, numCells, isSparseSafe, VT(0), ctx);
+            case AggOpCode::MIN:
+                return aggArray<BinaryOpCode::MIN>(values, numNonZeros, numCells, isSparseSafe,
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MAX:
+                return aggArray<BinaryOpCode::MAX>(values, numNonZeros, numCells, isSparseSafe,
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MEAN:
+                return aggArray<BinaryOpCode::ADD>(values, numNonZeros, numCells, true, VT(0), ctx) / numCells;
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggAll for CSRMatrix");
         }
-        if (AggOpCodeUtils::isPureBinaryReduction(opCode))
-            return agg;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// scalar <- BlockedMatrix
+// ----------------------------------------------------------------------------
 
-        // The op-code is either MEAN or STDDEV.
-        if (opCode == AggOpCode::MEAN) {
-            agg /= arg->getNumCols() * arg->getNumRows();
-            return agg;
+template<typename VT>
+struct AggAll<BlockedMatrix<VT>> {
+    static VT apply(AggOpCode opCode, const BlockedMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numCells = arg->getNumRows() * arg->getNumCols();
+        switch(opCode) {
+            case AggOpCode::SUM: return aggAll<BinaryOpCode::ADD>(AggOpCode::SUM, arg, VT(0), ctx);
+            case AggOpCode::MIN:
+                return aggAll<BinaryOpCode::MIN>(opCode, arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MAX:
+                return aggAll<BinaryOpCode::MAX>(opCode, arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MEAN:
+                return aggAll<BinaryOpCode::ADD>(AggOpCode::SUM, arg, VT(0), ctx) / numCells;
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggAll for BlockedMatrix");
         }
-        // else op-code is STDDEV
-        // TODO STDDEV
-        throw std::runtime_error("unsupported AggOpCode in AggAll for DenseMatrix");
+    }
+
+private:
+    /**
+     * @brief Combines the aggregates of the blocks, which are computed in parallel (an empty block aggregates to
+     * zero).
+     */
+    template<BinaryOpCode op>
+    static VT aggAll(AggOpCode opCode, const BlockedMatrix<VT> * arg, VT neutral, DCTX(ctx)) {
+        const size_t numColBlocks = arg->getNumColBlocks();
+        const size_t numBlocks = arg->getNumRowBlocks() * numColBlocks;
+        if(numBlocks == 0)
+            return neutral;
+        // a single block may be aggregated in parallel itself
+        DaphneContext * blockCtx = numBlocks == 1 ? ctx : nullptr;
+        std::vector<VT> blockAggs(numBlocks);
+        WorkerPool::parallelFor(ctx, numBlocks, [&](size_t i) {
+            const size_t rb = i / numColBlocks;
+            const size_t cb = i % numColBlocks;
+            if(auto dense = arg->getDenseBlock(rb, cb))
+                blockAggs[i] = AggAll<DenseMatrix<VT>>::apply(opCode, dense, blockCtx);
+            else if(auto sparse = arg->getSparseBlock(rb, cb))
+                blockAggs[i] = AggAll<CSRMatrix<VT>>::apply(opCode, sparse, blockCtx);
+            else
+                blockAggs[i] = VT(0);
+        });
+        return AggReduce::reduce<op>(blockAggs.data(), numBlocks, neutral, ctx);
     }
 };
 
 // ----------------------------------------------------------------------------
-// scalar <- CSRMatrix
+// scalar <- DCSRMatrix
 // ----------------------------------------------------------------------------
 
 template<typename VT>
-struct AggAll<CSRMatrix<VT>> {
-    static VT aggArray(const VT * values, size_t numNonZeros, size_t numCells, EwBinaryScaFuncPtr<VT, VT, VT> func, bool isSparseSafe, VT neutral, DCTX(ctx)) {
-        if(numNonZeros) {
-            VT agg = values[0];
-            for(size_t i = 1; i < numNonZeros; i++)
-                agg = func(agg, values[i], ctx);
+struct AggAll<DCSRMatrix<VT>> {
+    static VT apply(AggOpCode opCode, const DCSRMatrix<VT> * arg, DCTX(ctx)) {
+        // the non-zeros are contiguous like those of a CSRMatrix
+        const VT * values = arg->getValues();
+        const size_t numNonZeros = arg->getNumNonZeros();
+        const size_t numCells = arg->getNumRows() * arg->getNumCols();
+        const bool isSparseSafe = AggOpCodeUtils::isSparseSafe(opCode);
+        using AggCSR = AggAll<CSRMatrix<VT>>;
+
+        switch(opCode) {
+            case AggOpCode::SUM:
+                return AggCSR::template aggArray<BinaryOpCode::ADD>(values, numNonZeros, numCells, isSparseSafe,
+                        VT(0), ctx);
+            case AggOpCode::MIN:
+                return AggCSR::template aggArray<BinaryOpCode::MIN>(values, numNonZeros, numCells, isSparseSafe,
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MAX:
+                return AggCSR::template aggArray<BinaryOpCode::MAX>(values, numNonZeros, numCells, isSparseSafe,
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MEAN:
+                return AggCSR::template aggArray<BinaryOpCode::ADD>(values, numNonZeros, numCells, true, VT(0), ctx)
+                        / numCells;
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggAll for DCSRMatrix");
+        }
+    }
+};
 
-            if(!isSparseSafe && numNonZeros < numCells)
-                agg = func(agg, 0, ctx);
+// ----------------------------------------------------------------------------
+// scalar <- CompressedMatrix
+// ----------------------------------------------------------------------------
 
-            return agg;
+template<typename VT>
+struct AggAll<CompressedMatrix<VT>> {
+    static VT apply(AggOpCode opCode, const CompressedMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numCells = arg->getNumRows() * arg->getNumCols();
+        switch(opCode) {
+            case AggOpCode::SUM:
+                return aggAll<BinaryOpCode::ADD>(arg, VT(0), ctx);
+            case AggOpCode::MIN:
+                return aggAll<BinaryOpCode::MIN>(arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MAX:
+                return aggAll<BinaryOpCode::MAX>(arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+            case AggOpCode::MEAN:
+                return aggAll<BinaryOpCode::ADD>(arg, VT(0), ctx) / numCells;
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggAll for CompressedMatrix");
         }
-        else
-            return func(neutral, 0, ctx);
     }
-    
-    static VT apply(AggOpCode opCode, const CSRMatrix<VT> * arg, DCTX(ctx)) {
-        if(AggOpCodeUtils::isPureBinaryReduction(opCode)) {
-
-            EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
-            
-            return aggArray(
-                    arg->getValues(0),
-                    arg->getNumNonZeros(),
-                    arg->getNumRows() * arg->getNumCols(),
-                    func,
-                    AggOpCodeUtils::isSparseSafe(opCode),
-                    AggOpCodeUtils::template getNeutral<VT>(opCode),
-                    ctx
-            );
+
+private:
+    /**
+     * @brief Combines the aggregates of the column groups. The tuples of a dictionary are aggregated once, a sum
+     * weights them by their numbers of rows.
+     */
+    template<BinaryOpCode op>
+    static VT aggAll(const CompressedMatrix<VT> * arg, VT neutral, DCTX(ctx)) {
+        using Op = EwBinarySca<op, VT, VT, VT>;
+        const size_t numRows = arg->getNumRows();
+        VT agg = neutral;
+        for(const ColGroup<VT> & group : arg->getColGroups()) {
+            if(group.encoding == ColGroupEncoding::UNCOMPRESSED) {
+                agg = Op::apply(agg, AggReduce::parallelReduce<op>(group.values.data(), group.values.size(), neutral,
+                        ctx), ctx);
+                continue;
+            }
+            const size_t numTuples = group.getNumTuples();
+            const std::vector<size_t> counts = group.getTupleCounts(numRows);
+            for(size_t t = 0; t <= numTuples; t++) {
+                if(counts[t] == 0)
+                    continue;
+                const VT * tuple = t < numTuples ? group.getTuple(t) : group.defaultTuple.data();
+                for(size_t i = 0; i < group.getNumCols(); i++)
+                    agg = op == BinaryOpCode::ADD ? agg + tuple[i] * VT(counts[t]) : Op::apply(agg, tuple[i], ctx);
+            }
         }
-        else { // The op-code is either MEAN or STDDEV.
-            EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));            
-            auto agg = aggArray(
-                arg->getValues(0),
-                arg->getNumNonZeros(),
-                arg->getNumRows() * arg->getNumCols(),
-                func,
-                true,
-                VT(0),
-                ctx
-            );
-            if (opCode == AggOpCode::MEAN)
-                return agg / (arg->getNumRows() * arg->getNumCols());
-            
-            // TODO STDDEV
-            throw std::runtime_error("unsupported AggOpCode in AggAll for CSRMatrix");
+        return agg;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// scalar <- BitMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * The sum of a mask is its number of set bits, which is counted by popcount one word at a time (see `BitMask`), such
+ * that the result is a count rather than a `bool`. The minimum and maximum are whether all or any bits are set.
+ */
+template<>
+struct AggAll<BitMatrix> {
+    static size_t apply(AggOpCode opCode, const BitMatrix * arg, DCTX(ctx)) {
+        const size_t numCells = arg->getNumRows() * arg->getNumCols();
+        switch(opCode) {
+            case AggOpCode::SUM:
+                return BitMask::count(arg, ctx);
+            case AggOpCode::MIN:
+                return BitMask::count(arg, ctx) == numCells;
+            case AggOpCode::MAX:
+                return BitMask::count(arg, ctx) > 0;
+            default:
+                throw std::runtime_error("unsupported AggOpCode in AggAll for BitMatrix");
         }
     }
 };
 
+inline size_t aggAll(AggOpCode opCode, const BitMatrix * arg, DCTX(ctx)) {
+    return AggAll<BitMatrix>::apply(opCode, arg, ctx);
+}
+
 #endif //SRC_RUNTIME_LOCAL_KERNELS_AGGALL_H
\ No newline at end of file
@@ -18,14 +18,22 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_AGGCOL_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/kernels/AggOpCode.h>
+#include <runtime/local/kernels/AggReduce.h>
+#include <runtime/local/kernels/AggRow.h>
 #include <runtime/local/kernels/EwBinarySca.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <stdexcept>
+#include <vector>
 #include <cstring>
 #include <cmath>
 
@@ -63,27 +71,41 @@ struct AggCol<DenseMatrix<VT>, DenseMatrix<VT>> {
         
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, false);
+
+        // the column aggregates of a lazy transposition are the row aggregates of its source
+        const DenseMatrix<VT> * src = arg->getTransposedSource();
+        if(src && (opCode == AggOpCode::SUM || opCode == AggOpCode::MIN || opCode == AggOpCode::MAX
+                || opCode == AggOpCode::MEAN)) {
+            DenseMatrix<VT> * rowAggs = nullptr;
+            aggRow(opCode, rowAggs, src, ctx);
+            const VT * valuesRowAggs = rowAggs->getValues();
+            std::copy(valuesRowAggs, valuesRowAggs + numCols, res->getValues());
+            DataObjectFactory::destroy(rowAggs);
+            return;
+        }
         
         const VT * valuesArg = arg->getValues();
         VT * valuesRes = res->getValues();
-        
-        EwBinaryScaFuncPtr<VT, VT, VT> func;
-        if(AggOpCodeUtils::isPureBinaryReduction(opCode))
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
-        else
-            // TODO Setting the function pointer yields the correct result.
-            // However, since MEAN and STDDEV are not sparse-safe, the program
-            // does not take the same path for doing the summation, and is less
-            // efficient.
-            // for MEAN and STDDDEV, we need to sum
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
-
-        memcpy(valuesRes, valuesArg, numCols * sizeof(VT));
-        
-        for(size_t r = 1; r < numRows; r++) {
-            valuesArg += arg->getRowSkip();
-            for(size_t c = 0; c < numCols; c++)
-                valuesRes[c] = func(valuesRes[c], valuesArg[c], ctx);
+        const size_t rowSkipArg = arg->getRowSkip();
+
+        // The columns are reduced in blocks, streaming over the rows (instead of striding over the columns).
+        switch(opCode) {
+            case AggOpCode::SUM:
+            case AggOpCode::MEAN:
+            case AggOpCode::STDDEV:
+                AggReduce::parallelReduceCols<BinaryOpCode::ADD>(valuesArg, rowSkipArg, numRows, numCols, valuesRes,
+                        VT(0), AggReduce::Identity(), ctx);
+                break;
+            case AggOpCode::MIN:
+                AggReduce::parallelReduceCols<BinaryOpCode::MIN>(valuesArg, rowSkipArg, numRows, numCols, valuesRes,
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), AggReduce::Identity(), ctx);
+                break;
+            case AggOpCode::MAX:
+                AggReduce::parallelReduceCols<BinaryOpCode::MAX>(valuesArg, rowSkipArg, numRows, numCols, valuesRes,
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), AggReduce::Identity(), ctx);
+                break;
+            default:
+                throw std::runtime_error("unsupported AggOpCode in AggCol for DenseMatrix");
         }
         
         if(AggOpCodeUtils::isPureBinaryReduction(opCode))
@@ -97,17 +119,14 @@ struct AggCol<DenseMatrix<VT>, DenseMatrix<VT>> {
         if(opCode != AggOpCode::STDDEV)
             return;
 
-        auto tmp = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, true);
+        auto tmp = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, false);
         VT * valuesT = tmp->getValues();
-        valuesArg = arg->getValues();
-
-        for(size_t r = 0; r < numRows; r++) {
-            for(size_t c = 0; c < numCols; c++) {
-                VT val = valuesArg[c] - valuesRes[c];
-                valuesT[c] = valuesT[c] + val * val;
-            }
-            valuesArg += arg->getRowSkip();
-        }
+        const VT * means = valuesRes;
+        AggReduce::parallelReduceCols<BinaryOpCode::ADD>(valuesArg, rowSkipArg, numRows, numCols, valuesT, VT(0),
+                [means](VT value, size_t col) {
+                    const VT val = value - means[col];
+                    return val * val;
+                }, ctx);
 
         for(size_t c = 0; c < numCols; c++) {
             valuesT[c] /= numRows;
@@ -121,12 +140,80 @@ struct AggCol<DenseMatrix<VT>, DenseMatrix<VT>> {
     }
 };
 
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct AggCol<DenseMatrix<VT>, DenseMatrixCM<VT>> {
+    static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const DenseMatrixCM<VT> * arg, DCTX(ctx)) {
+        switch(opCode) {
+            case AggOpCode::SUM:
+            case AggOpCode::MEAN:
+            case AggOpCode::STDDEV:
+                aggCols<BinaryOpCode::ADD>(opCode, res, arg, VT(0), ctx);
+                break;
+            case AggOpCode::MIN:
+                aggCols<BinaryOpCode::MIN>(opCode, res, arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+                break;
+            case AggOpCode::MAX:
+                aggCols<BinaryOpCode::MAX>(opCode, res, arg, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+                break;
+            default:
+                throw std::runtime_error("unsupported AggOpCode in AggCol for DenseMatrixCM");
+        }
+    }
+
+private:
+    /**
+     * @brief Reduces each (contiguous) column like an array. Many columns are reduced in parallel, each by one
+     * thread, while the rows of few long columns are reduced in parallel chunks.
+     */
+    template<BinaryOpCode op>
+    static void aggCols(AggOpCode opCode, DenseMatrix<VT> *& res, const DenseMatrixCM<VT> * arg, VT neutral,
+            DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, false);
+
+        VT * valuesRes = res->getValues();
+        auto aggCol = [&](size_t c, bool parallel) {
+            const VT * col = arg->getColumn(c);
+            VT agg = parallel ? AggReduce::parallelReduce<op>(col, numRows, neutral, ctx)
+                    : AggReduce::reduce<op>(col, numRows, neutral, ctx);
+            if(!AggOpCodeUtils::isPureBinaryReduction(opCode)) {
+                agg /= numRows;
+                if(opCode == AggOpCode::STDDEV) {
+                    VT sqDiffs = 0;
+                    for(size_t r = 0; r < numRows; r++) {
+                        const VT diff = col[r] - agg;
+                        sqDiffs += diff * diff;
+                    }
+                    agg = sqrt(sqDiffs / numRows);
+                }
+            }
+            valuesRes[c] = agg;
+        };
+
+        if(numCols >= AggReduce::getNumChunks(numRows * numCols))
+            WorkerPool::parallelFor(ctx, numCols, [&](size_t c) { aggCol(c, false); });
+        else
+            for(size_t c = 0; c < numCols; c++)
+                aggCol(c, true);
+    }
+};
+
 // ----------------------------------------------------------------------------
 // DenseMatrix <- CSRMatrix
 // ----------------------------------------------------------------------------
 
 template<typename VT>
 struct AggCol<DenseMatrix<VT>, CSRMatrix<VT>> {
+    // the maximum number of cells of the partial results of all chunks of rows
+    static constexpr size_t MAX_PARTIAL_CELLS = 1 << 22;
+
     static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
@@ -135,52 +222,26 @@ struct AggCol<DenseMatrix<VT>, CSRMatrix<VT>> {
             res = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, true);
         
         VT * valuesRes = res->getValues();
-        
-        EwBinaryScaFuncPtr<VT, VT, VT> func;
-        if(AggOpCodeUtils::isPureBinaryReduction(opCode))
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
-        else
-            // TODO Setting the function pointer yields the correct result.
-            // However, since MEAN and STDDEV are not sparse-safe, the program
-            // does not take the same path for doing the summation, and is less
-            // efficient.
-            // for MEAN and STDDDEV, we need to sum
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
+
+        switch(opCode) {
+            case AggOpCode::SUM:
+            case AggOpCode::MEAN:
+            case AggOpCode::STDDEV:
+                aggCols<BinaryOpCode::ADD>(valuesRes, arg, true, VT(0), ctx);
+                break;
+            case AggOpCode::MIN:
+                aggCols<BinaryOpCode::MIN>(valuesRes, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+                break;
+            case AggOpCode::MAX:
+                aggCols<BinaryOpCode::MAX>(valuesRes, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+                break;
+            default:
+                throw std::runtime_error("unsupported AggOpCode in AggCol for CSRMatrix");
+        }
 
         const VT * valuesArg = arg->getValues(0);
         const size_t * colIdxsArg = arg->getColIdxs(0);
-        
         const size_t numNonZeros = arg->getNumNonZeros();
-        
-        if(AggOpCodeUtils::isSparseSafe(opCode)) {
-            for(size_t i = 0; i < numNonZeros; i++) {
-                const size_t colIdx = colIdxsArg[i];
-                valuesRes[colIdx] = func(valuesRes[colIdx], valuesArg[i], ctx);
-            }
-        }
-        else {
-            size_t * hist = new size_t[numCols](); // initialized to zeros
-
-            const size_t numNonZerosFirstRowArg = arg->getNumNonZeros(0);
-            for(size_t i = 0; i < numNonZerosFirstRowArg; i++) {
-                size_t colIdx = colIdxsArg[i];
-                valuesRes[colIdx] = valuesArg[i];
-                hist[colIdx]++;
-            }
-
-            if(arg->getNumRows() > 1) {
-                for(size_t i = numNonZerosFirstRowArg; i < numNonZeros; i++) {
-                    const size_t colIdx = colIdxsArg[i];
-                    valuesRes[colIdx] = func(valuesRes[colIdx], valuesArg[i], ctx);
-                    hist[colIdx]++;
-                }
-                for(size_t c = 0; c < numCols; c++)
-                    if(hist[c] < numRows)
-                        valuesRes[c] = func(valuesRes[c], 0, ctx);
-            }
-            
-            delete[] hist;
-        }
 
         if(AggOpCodeUtils::isPureBinaryReduction(opCode))
             return;
@@ -220,6 +281,269 @@ struct AggCol<DenseMatrix<VT>, CSRMatrix<VT>> {
         DataObjectFactory::destroy<DenseMatrix<VT>>(tmp);
 
     }
+
+private:
+    /**
+     * @brief Reduces the non-zeros of each column into `res`, taking the zeros into account for operations which are
+     * not sparse-safe. Chunks of rows are reduced into partial results in parallel, which are combined pairwise. If
+     * `arg` has cached its transposition, its columns are reduced as the rows of that instead.
+     */
+    template<BinaryOpCode op>
+    static void aggCols(VT * res, const CSRMatrix<VT> * arg, bool isSparseSafe, VT neutral, DCTX(ctx)) {
+        using Op = EwBinarySca<op, VT, VT, VT>;
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t * rowOffsets = arg->getRowOffsets();
+
+        if(auto transposed = arg->getCachedTransposed()) {
+            const size_t numChunks = std::max<size_t>(1,
+                    std::min(AggReduce::getNumChunks(arg->getNumNonZeros()), numCols));
+            WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+                const auto [colBegin, colEnd] = AggReduce::getChunk(numCols, numChunks, i);
+                for(size_t c = colBegin; c < colEnd; c++) {
+                    const size_t numNonZeros = transposed->getNumNonZeros(c);
+                    res[c] = AggReduce::reduce<op>(transposed->getValues(c), numNonZeros, neutral, ctx);
+                    if(!isSparseSafe && numNonZeros < numRows)
+                        res[c] = Op::apply(res[c], 0, ctx);
+                }
+            });
+            return;
+        }
+
+        const size_t numChunks = std::max<size_t>(1, std::min({AggReduce::getNumChunks(arg->getNumNonZeros()),
+                MAX_PARTIAL_CELLS / std::max<size_t>(1, numCols), numRows}));
+        std::vector<VT> partials(numChunks * numCols, neutral);
+        // the number of non-zeros per column, if the zeros need to be taken into account
+        std::vector<size_t> counts(isSparseSafe ? 0 : numChunks * numCols, 0);
+
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const auto [rowBegin, rowEnd] = AggReduce::getChunk(numRows, numChunks, i);
+            const size_t numNonZeros = rowOffsets[rowEnd] - rowOffsets[rowBegin];
+            const VT * values = arg->getValues(rowBegin);
+            const size_t * colIdxs = arg->getColIdxs(rowBegin);
+            VT * partial = partials.data() + i * numCols;
+            for(size_t k = 0; k < numNonZeros; k++)
+                partial[colIdxs[k]] = Op::apply(partial[colIdxs[k]], values[k], ctx);
+            if(!isSparseSafe) {
+                size_t * count = counts.data() + i * numCols;
+                for(size_t k = 0; k < numNonZeros; k++)
+                    count[colIdxs[k]]++;
+            }
+        });
+
+        AggReduce::combineRows<op>(partials.data(), numChunks, numCols, ctx);
+        if(!isSparseSafe)
+            AggReduce::combineRows<BinaryOpCode::ADD>(counts.data(), numChunks, numCols, ctx);
+        for(size_t c = 0; c < numCols; c++)
+            res[c] = (isSparseSafe || counts[c] == numRows) ? partials[c] : Op::apply(partials[c], 0, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DCSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct AggCol<DenseMatrix<VT>, DCSRMatrix<VT>> {
+    static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const DCSRMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, false);
+
+        VT * valuesRes = res->getValues();
+
+        switch(opCode) {
+            case AggOpCode::SUM:
+            case AggOpCode::MEAN:
+            case AggOpCode::STDDEV:
+                aggCols<BinaryOpCode::ADD>(valuesRes, arg, true, VT(0), ctx);
+                break;
+            case AggOpCode::MIN:
+                aggCols<BinaryOpCode::MIN>(valuesRes, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+                break;
+            case AggOpCode::MAX:
+                aggCols<BinaryOpCode::MAX>(valuesRes, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), ctx);
+                break;
+            default:
+                throw std::runtime_error("unsupported AggOpCode in AggCol for DCSRMatrix");
+        }
+
+        if(AggOpCodeUtils::isPureBinaryReduction(opCode))
+            return;
+
+        // The op-code is either MEAN or STDDEV.
+
+        for(size_t c = 0; c < numCols; c++)
+            valuesRes[c] /= numRows;
+
+        if(opCode != AggOpCode::STDDEV)
+            return;
+
+        const size_t * colIdxs = arg->getColIdxs();
+        const VT * values = arg->getValues();
+        std::vector<VT> sqDiffs(numCols, VT(0));
+        std::vector<size_t> counts(numCols, 0);
+        for(size_t k = 0; k < arg->getNumNonZeros(); k++) {
+            const VT diff = values[k] - valuesRes[colIdxs[k]];
+            sqDiffs[colIdxs[k]] += diff * diff;
+            counts[colIdxs[k]]++;
+        }
+        for(size_t c = 0; c < numCols; c++) {
+            // Take all zeros in the column into account.
+            const VT sqDiffs0 = sqDiffs[c] + (valuesRes[c] * valuesRes[c]) * (numRows - counts[c]);
+            valuesRes[c] = sqrt(sqDiffs0 / numRows);
+        }
+    }
+
+private:
+    /**
+     * @brief Reduces the non-zeros of each column into `res` in a single pass over the non-zeros, i.e., without
+     * partial results per chunk of rows, which would be as large as the (potentially huge) number of columns. The
+     * zeros need to be taken into account for operations which are not sparse-safe, which is the case for all columns
+     * if some row has no non-zeros.
+     */
+    template<BinaryOpCode op>
+    static void aggCols(VT * res, const DCSRMatrix<VT> * arg, bool isSparseSafe, VT neutral, DCTX(ctx)) {
+        using Op = EwBinarySca<op, VT, VT, VT>;
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t numNonZeros = arg->getNumNonZeros();
+        const size_t * colIdxs = arg->getColIdxs();
+        const VT * values = arg->getValues();
+
+        std::fill(res, res + numCols, neutral);
+        for(size_t k = 0; k < numNonZeros; k++)
+            res[colIdxs[k]] = Op::apply(res[colIdxs[k]], values[k], ctx);
+        if(isSparseSafe)
+            return;
+
+        if(arg->getNumNonZeroRows() < numRows) {
+            for(size_t c = 0; c < numCols; c++)
+                res[c] = Op::apply(res[c], 0, ctx);
+            return;
+        }
+        std::vector<size_t> counts(numCols, 0);
+        for(size_t k = 0; k < numNonZeros; k++)
+            counts[colIdxs[k]]++;
+        for(size_t c = 0; c < numCols; c++)
+            if(counts[c] < numRows)
+                res[c] = Op::apply(res[c], 0, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CompressedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct AggCol<DenseMatrix<VT>, CompressedMatrix<VT>> {
+    static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const CompressedMatrix<VT> * arg, DCTX(ctx)) {
+        switch(opCode) {
+            case AggOpCode::SUM:
+            case AggOpCode::MEAN:
+            case AggOpCode::STDDEV:
+            case AggOpCode::MIN:
+            case AggOpCode::MAX:
+                break;
+            default:
+                throw std::runtime_error("unsupported AggOpCode in AggCol for CompressedMatrix");
+        }
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(1, arg->getNumCols(), false);
+
+        VT * valuesRes = res->getValues();
+        const auto & groups = arg->getColGroups();
+        const size_t numRows = arg->getNumRows();
+
+        // The uncompressed group is reduced in parallel itself, the dictionaries of the other groups in parallel.
+        for(const ColGroup<VT> & group : groups)
+            if(group.encoding == ColGroupEncoding::UNCOMPRESSED)
+                aggUncompressed(opCode, valuesRes, group, numRows, ctx);
+        WorkerPool::parallelFor(ctx, groups.size(), [&](size_t g) {
+            if(groups[g].encoding != ColGroupEncoding::UNCOMPRESSED)
+                aggDictionary(opCode, valuesRes, groups[g], numRows, ctx);
+        });
+    }
+
+private:
+    static void aggUncompressed(AggOpCode opCode, VT * res, const ColGroup<VT> & group, size_t numRows, DCTX(ctx)) {
+        const size_t numCols = group.getNumCols();
+        const VT * values = group.values.data();
+        std::vector<VT> agg(numCols);
+        switch(opCode) {
+            case AggOpCode::MIN:
+                AggReduce::parallelReduceCols<BinaryOpCode::MIN>(values, numCols, numRows, numCols, agg.data(),
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), AggReduce::Identity(), ctx);
+                break;
+            case AggOpCode::MAX:
+                AggReduce::parallelReduceCols<BinaryOpCode::MAX>(values, numCols, numRows, numCols, agg.data(),
+                        AggOpCodeUtils::template getNeutral<VT>(opCode), AggReduce::Identity(), ctx);
+                break;
+            default:
+                AggReduce::parallelReduceCols<BinaryOpCode::ADD>(values, numCols, numRows, numCols, agg.data(), VT(0),
+                        AggReduce::Identity(), ctx);
+        }
+
+        if(!AggOpCodeUtils::isPureBinaryReduction(opCode)) {
+            for(size_t i = 0; i < numCols; i++)
+                agg[i] /= numRows;
+            if(opCode == AggOpCode::STDDEV) {
+                const std::vector<VT> means = agg;
+                AggReduce::parallelReduceCols<BinaryOpCode::ADD>(values, numCols, numRows, numCols, agg.data(), VT(0),
+                        [&means](VT value, size_t col) {
+                            const VT val = value - means[col];
+                            return val * val;
+                        }, ctx);
+                for(size_t i = 0; i < numCols; i++)
+                    agg[i] = sqrt(agg[i] / numRows);
+            }
+        }
+
+        for(size_t i = 0; i < numCols; i++)
+            res[group.colIdxs[i]] = agg[i];
+    }
+
+    /**
+     * @brief Aggregates the columns of a dictionary-encoded group on its tuples, weighted by their numbers of rows.
+     */
+    static void aggDictionary(AggOpCode opCode, VT * res, const ColGroup<VT> & group, size_t numRows, DCTX(ctx)) {
+        const size_t numTuples = group.getNumTuples();
+        const std::vector<size_t> counts = group.getTupleCounts(numRows);
+        auto tuple = [&](size_t t) { return t < numTuples ? group.getTuple(t) : group.defaultTuple.data(); };
+
+        for(size_t i = 0; i < group.getNumCols(); i++) {
+            VT agg = opCode == AggOpCode::MIN || opCode == AggOpCode::MAX
+                    ? AggOpCodeUtils::template getNeutral<VT>(opCode) : VT(0);
+            for(size_t t = 0; t <= numTuples; t++) {
+                if(counts[t] == 0)
+                    continue;
+                const VT v = tuple(t)[i];
+                switch(opCode) {
+                    case AggOpCode::MIN: agg = EwBinarySca<BinaryOpCode::MIN, VT, VT, VT>::apply(agg, v, ctx); break;
+                    case AggOpCode::MAX: agg = EwBinarySca<BinaryOpCode::MAX, VT, VT, VT>::apply(agg, v, ctx); break;
+                    default: agg += v * VT(counts[t]); break;
+                }
+            }
+
+            if(!AggOpCodeUtils::isPureBinaryReduction(opCode)) {
+                agg /= numRows;
+                if(opCode == AggOpCode::STDDEV) {
+                    VT sqDiffs = 0;
+                    for(size_t t = 0; t <= numTuples; t++) {
+                        if(counts[t] == 0)
+                            continue;
+                        const VT diff = tuple(t)[i] - agg;
+                        sqDiffs += diff * diff * VT(counts[t]);
+                    }
+                    agg = sqrt(sqDiffs / numRows);
+                }
+            }
+            res[group.colIdxs[i]] = agg;
+        }
+    }
 };
 
 #endif //SRC_RUNTIME_LOCAL_KERNELS_AGGCOL_H
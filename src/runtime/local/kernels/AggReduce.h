@@ -0,0 +1,246 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/EwBinarySca.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The building blocks of the aggregation kernels: vectorized reductions of arrays and columns, and their
+ * parallel execution on the `WorkerPool`.
+ *
+ * Arrays are reduced with `LANES` independent accumulators, which the compiler maps to SIMD registers without having
+ * to reassociate floating-point additions. Floating-point sums are computed pairwise (arrays by recursive halving,
+ * columns by a cascade over blocks of rows), which bounds the rounding error by O(log n) instead of O(n) ULPs.
+ *
+ * Large inputs are split into chunks, whose number only depends on the size of the input (not on the number of
+ * threads), such that the results do not depend on the number of threads either.
+ */
+namespace AggReduce {
+    // the number of independent accumulators of an array reduction
+    constexpr size_t LANES = 8;
+    // floating-point sums of at most this many values are computed by the accumulators directly
+    constexpr size_t PAIRWISE_BLOCK = 128;
+    // the number of rows summed up by the accumulators directly, before the cascade of a column sum
+    constexpr size_t PAIRWISE_ROWS = 64;
+    // the number of columns reduced at once by streaming over the rows, such that the accumulators stay in the cache
+    constexpr size_t COL_BLOCK = 512;
+    // inputs are split into chunks of at least this many cells, but at most MAX_CHUNKS
+    constexpr size_t MIN_CELLS_PER_CHUNK = 1 << 16;
+    constexpr size_t MAX_CHUNKS = 256;
+
+    template<BinaryOpCode op, typename VT>
+    constexpr bool isPairwise = op == BinaryOpCode::ADD && std::is_floating_point<VT>::value;
+
+    /**
+     * @brief Returns the number of chunks to split an input of the given number of cells into.
+     */
+    inline size_t getNumChunks(size_t numCells) {
+        return std::clamp<size_t>(numCells / MIN_CELLS_PER_CHUNK, 1, MAX_CHUNKS);
+    }
+
+    /**
+     * @brief Returns the range of the i-th of `numChunks` chunks of `n` elements, whose starts are multiples of
+     * `alignment`.
+     */
+    inline std::pair<size_t, size_t> getChunk(size_t n, size_t numChunks, size_t i, size_t alignment = 1) {
+        const size_t perChunk = ((n + numChunks - 1) / numChunks + alignment - 1) / alignment * alignment;
+        const size_t begin = std::min(i * perChunk, n);
+        return {begin, std::min(begin + perChunk, n)};
+    }
+
+    template<BinaryOpCode op, typename VT>
+    VT reduceLanes(const VT * values, size_t n, VT neutral, DCTX(ctx)) {
+        using Op = EwBinarySca<op, VT, VT, VT>;
+        VT acc[LANES];
+        for(size_t l = 0; l < LANES; l++)
+            acc[l] = neutral;
+        size_t i = 0;
+        for(; i + LANES <= n; i += LANES) {
+            #pragma omp simd
+            for(size_t l = 0; l < LANES; l++)
+                acc[l] = Op::apply(acc[l], values[i + l], ctx);
+        }
+        for(size_t l = 0; i < n; i++, l++)
+            acc[l] = Op::apply(acc[l], values[i], ctx);
+        for(size_t width = LANES / 2; width > 0; width /= 2)
+            for(size_t l = 0; l < width; l++)
+                acc[l] = Op::apply(acc[l], acc[l + width], ctx);
+        return acc[0];
+    }
+
+    template<BinaryOpCode op, typename VT>
+    VT reducePairwise(const VT * values, size_t n, VT neutral, DCTX(ctx)) {
+        if constexpr(isPairwise<op, VT>) {
+            if(n > PAIRWISE_BLOCK) {
+                // halves of a multiple of LANES values keep the accumulators aligned
+                const size_t half = (n / 2 + LANES - 1) / LANES * LANES;
+                return reducePairwise<op>(values, half, neutral, ctx)
+                        + reducePairwise<op>(values + half, n - half, neutral, ctx);
+            }
+        }
+        return reduceLanes<op>(values, n, neutral, ctx);
+    }
+
+    /**
+     * @brief Reduces the given array by the given operation, `neutral` for an empty array, vectorized for the
+     * instruction set of the CPU (see `CpuDispatch`).
+     */
+    template<BinaryOpCode op, typename VT>
+    VT reduce(const VT * values, size_t n, VT neutral, DCTX(ctx)) {
+        VT res;
+        CpuDispatch::run("AggReduce", [&](auto) { res = reducePairwise<op>(values, n, neutral, ctx); });
+        return res;
+    }
+
+    /**
+     * @brief Reduces the given array by the given operation in parallel chunks.
+     */
+    template<BinaryOpCode op, typename VT>
+    VT parallelReduce(const VT * values, size_t n, VT neutral, DCTX(ctx)) {
+        const size_t numChunks = getNumChunks(n);
+        if(numChunks == 1)
+            return reduce<op>(values, n, neutral, ctx);
+        std::vector<VT> partials(numChunks);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const auto [begin, end] = getChunk(n, numChunks, i, LANES);
+            partials[i] = reduce<op>(values + begin, end - begin, neutral, ctx);
+        });
+        return reduce<op>(partials.data(), numChunks, neutral, ctx);
+    }
+
+    /**
+     * @brief Combines `numRows` rows of `numCols` values each (in place, into the first one) by a pairwise tree.
+     */
+    template<BinaryOpCode op, typename VT>
+    void combineRows(VT * rows, size_t numRows, size_t numCols, DCTX(ctx)) {
+        using Op = EwBinarySca<op, VT, VT, VT>;
+        for(size_t step = 1; step < numRows; step *= 2)
+            for(size_t r = 0; r + step < numRows; r += 2 * step) {
+                VT * lhs = rows + r * numCols;
+                const VT * rhs = rows + (r + step) * numCols;
+                #pragma omp simd
+                for(size_t c = 0; c < numCols; c++)
+                    lhs[c] = Op::apply(lhs[c], rhs[c], ctx);
+            }
+    }
+
+    /**
+     * @brief Reduces the columns from `colBegin` to `colEnd` of `numRows` rows (at a distance of `rowSkip`) into
+     * `res`, streaming over the rows. `transform(value, col)` is applied to each value before its reduction.
+     */
+    template<BinaryOpCode op, typename VT, class Transform>
+    void reduceColBlock(const VT * values, size_t rowSkip, size_t numRows, size_t colBegin, size_t colEnd, VT * res,
+            VT neutral, const Transform & transform, DCTX(ctx)) {
+        using Op = EwBinarySca<op, VT, VT, VT>;
+        const size_t width = colEnd - colBegin;
+        // reduces the rows from rowBegin to rowEnd into acc
+        auto reduceRowsInto = [&](size_t rowBegin, size_t rowEnd, VT * acc) {
+            CpuDispatch::run("AggReduce", [&](auto) {
+                for(size_t c = 0; c < width; c++)
+                    acc[c] = neutral;
+                for(size_t r = rowBegin; r < rowEnd; r++) {
+                    const VT * row = values + r * rowSkip + colBegin;
+                    #pragma omp simd
+                    for(size_t c = 0; c < width; c++)
+                        acc[c] = Op::apply(acc[c], transform(row[c], colBegin + c), ctx);
+                }
+            });
+        };
+
+        if constexpr(isPairwise<op, VT>) {
+            if(numRows > PAIRWISE_ROWS) {
+                // A cascade like a binary counter: level k holds the sum of 2^k blocks of rows (if occupied), such
+                // that every row is added up only O(log numRows) times.
+                std::vector<VT> levels;
+                std::vector<bool> occupied;
+                std::vector<VT> carry(width);
+                for(size_t rowBegin = 0; rowBegin < numRows; rowBegin += PAIRWISE_ROWS) {
+                    reduceRowsInto(rowBegin, std::min(rowBegin + PAIRWISE_ROWS, numRows), carry.data());
+                    size_t k = 0;
+                    for(; k < occupied.size() && occupied[k]; k++) {
+                        const VT * level = levels.data() + k * width;
+                        #pragma omp simd
+                        for(size_t c = 0; c < width; c++)
+                            carry[c] += level[c];
+                        occupied[k] = false;
+                    }
+                    if(k == occupied.size()) {
+                        occupied.push_back(false);
+                        levels.resize(levels.size() + width);
+                    }
+                    std::copy(carry.begin(), carry.end(), levels.begin() + k * width);
+                    occupied[k] = true;
+                }
+                for(size_t c = 0; c < width; c++)
+                    res[colBegin + c] = 0;
+                for(size_t k = 0; k < occupied.size(); k++)
+                    if(occupied[k]) {
+                        const VT * level = levels.data() + k * width;
+                        #pragma omp simd
+                        for(size_t c = 0; c < width; c++)
+                            res[colBegin + c] += level[c];
+                    }
+                return;
+            }
+        }
+        reduceRowsInto(0, numRows, res + colBegin);
+    }
+
+    /**
+     * @brief Reduces each column of a row-major matrix into `res`, in parallel blocks of columns and, if there are
+     * few of them, chunks of rows. `transform(value, col)` is applied to each value before its reduction.
+     */
+    template<BinaryOpCode op, typename VT, class Transform>
+    void parallelReduceCols(const VT * values, size_t rowSkip, size_t numRows, size_t numCols, VT * res, VT neutral,
+            const Transform & transform, DCTX(ctx)) {
+        const size_t numColBlocks = std::max<size_t>(1, (numCols + COL_BLOCK - 1) / COL_BLOCK);
+        // the rows are only split as far as the blocks of columns do not yield enough chunks
+        const size_t numRowChunks = std::min(std::max<size_t>(1, getNumChunks(numRows * numCols) / numColBlocks),
+                std::max<size_t>(1, numRows));
+        std::vector<VT> partials(numRowChunks > 1 ? numRowChunks * numCols : 0);
+
+        WorkerPool::parallelFor(ctx, numRowChunks * numColBlocks, [&](size_t i) {
+            const size_t rowChunk = i / numColBlocks;
+            const size_t colBegin = (i % numColBlocks) * COL_BLOCK;
+            const auto [rowBegin, rowEnd] = getChunk(numRows, numRowChunks, rowChunk);
+            VT * dst = numRowChunks > 1 ? partials.data() + rowChunk * numCols : res;
+            reduceColBlock<op>(values + rowBegin * rowSkip, rowSkip, rowEnd - rowBegin, colBegin,
+                    std::min(colBegin + COL_BLOCK, numCols), dst, neutral, transform, ctx);
+        });
+
+        if(numRowChunks > 1) {
+            combineRows<op>(partials.data(), numRowChunks, numCols, ctx);
+            std::copy(partials.begin(), partials.begin() + numCols, res);
+        }
+    }
+
+    // the identity as a transform of parallelReduceCols()
+    struct Identity {
+        template<typename VT>
+        VT operator()(VT value, [[maybe_unused]] size_t col) const { return value; }
+    };
+}
@@ -20,13 +20,16 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
-#include <runtime/local/kernels/AggAll.h>
 #include <runtime/local/kernels/AggOpCode.h>
+#include <runtime/local/kernels/AggReduce.h>
 #include <runtime/local/kernels/EwBinarySca.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <stdexcept>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -65,71 +68,64 @@ struct AggRow<DenseMatrix<VT>, DenseMatrix<VT>> {
         
         const VT * valuesArg = arg->getValues();
         VT * valuesRes = res->getValues();
-        
-        if(opCode == AggOpCode::IDXMIN) {
-            for(size_t r = 0; r < numRows; r++) {
-                VT minVal = valuesArg[0];
-                size_t minValIdx = 0;
-                for(size_t c = 1; c < numCols; c++)
-                    if(valuesArg[c] < minVal) {
-                        minVal = valuesArg[c];
-                        minValIdx = c;
-                    }
-                *valuesRes = static_cast<VT>(minValIdx);
-                valuesArg += arg->getRowSkip();
-                valuesRes += res->getRowSkip();
-            }
-        }
-        else if(opCode == AggOpCode::IDXMAX) {
-            for(size_t r = 0; r < numRows; r++) {
-                VT maxVal = valuesArg[0];
-                size_t maxValIdx = 0;
-                for(size_t c = 1; c < numCols; c++)
-                    if(valuesArg[c] > maxVal) {
-                        maxVal = valuesArg[c];
-                        maxValIdx = c;
-                    }
-                *valuesRes = static_cast<VT>(maxValIdx);
-                valuesArg += arg->getRowSkip();
-                valuesRes += res->getRowSkip();
-            }
-        }
-        else {
-            EwBinaryScaFuncPtr<VT, VT, VT> func;    
-            if(AggOpCodeUtils::isPureBinaryReduction(opCode))
-                func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
-            else
-                // TODO Setting the function pointer yields the correct result.
-                // However, since MEAN and STDDEV are not sparse-safe, the program
-                // does not take the same path for doing the summation, and is less
-                // efficient.
-                // for MEAN and STDDDEV, we need to sum
-                func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
-
-            for(size_t r = 0; r < numRows; r++) {
-                VT agg = *valuesArg;
-                for(size_t c = 1; c < numCols; c++)
-                    agg = func(agg, valuesArg[c], ctx);
-                *valuesRes = agg;
-                valuesArg += arg->getRowSkip();
-                valuesRes += res->getRowSkip();
-            }
-
-            if(AggOpCodeUtils::isPureBinaryReduction(opCode))
-                return;
-
-            // The op-code is either MEAN or STDDEV
-            valuesRes = res->getValues();
-            for(size_t r = 0; r < numRows; r++) {
-                *valuesRes = (*valuesRes) / numCols;
-                valuesRes += res->getRowSkip();
+        const size_t rowSkipArg = arg->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        // the row aggregates of each chunk of rows are computed by func(row, values of row)
+        auto aggRows = [&](auto func) {
+            const size_t numChunks = std::max<size_t>(1, std::min(AggReduce::getNumChunks(numRows * numCols), numRows));
+            WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+                const auto [rowBegin, rowEnd] = AggReduce::getChunk(numRows, numChunks, i);
+                for(size_t r = rowBegin; r < rowEnd; r++)
+                    valuesRes[r * rowSkipRes] = func(valuesArg + r * rowSkipArg);
+            });
+        };
+
+        switch(opCode) {
+            case AggOpCode::SUM:
+                aggRows([&](const VT * row) { return AggReduce::reduce<BinaryOpCode::ADD>(row, numCols, VT(0), ctx); });
+                break;
+            case AggOpCode::MIN:
+            case AggOpCode::MAX: {
+                const VT neutral = AggOpCodeUtils::template getNeutral<VT>(opCode);
+                if(opCode == AggOpCode::MIN)
+                    aggRows([&](const VT * row) { return AggReduce::reduce<BinaryOpCode::MIN>(row, numCols, neutral, ctx); });
+                else
+                    aggRows([&](const VT * row) { return AggReduce::reduce<BinaryOpCode::MAX>(row, numCols, neutral, ctx); });
+                break;
             }
-            if(opCode == AggOpCode::MEAN)
-                return;
-            
-            // else op-code is STDDEV
-            // TODO STDDEV
-            throw std::runtime_error("unsupported AggOpCode in AggRow for DenseMatrix");
+            case AggOpCode::IDXMIN:
+                aggRows([&](const VT * row) {
+                    VT minVal = row[0];
+                    size_t minValIdx = 0;
+                    for(size_t c = 1; c < numCols; c++)
+                        if(row[c] < minVal) {
+                            minVal = row[c];
+                            minValIdx = c;
+                        }
+                    return static_cast<VT>(minValIdx);
+                });
+                break;
+            case AggOpCode::IDXMAX:
+                aggRows([&](const VT * row) {
+                    VT maxVal = row[0];
+                    size_t maxValIdx = 0;
+                    for(size_t c = 1; c < numCols; c++)
+                        if(row[c] > maxVal) {
+                            maxVal = row[c];
+                            maxValIdx = c;
+                        }
+                    return static_cast<VT>(maxValIdx);
+                });
+                break;
+            case AggOpCode::MEAN:
+                aggRows([&](const VT * row) {
+                    return AggReduce::reduce<BinaryOpCode::ADD>(row, numCols, VT(0), ctx) / numCols;
+                });
+                break;
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggRow for DenseMatrix");
         }
     }
 };
@@ -141,56 +137,116 @@ struct AggRow<DenseMatrix<VT>, DenseMatrix<VT>> {
 template<typename VT>
 struct AggRow<DenseMatrix<VT>, CSRMatrix<VT>> {
     static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
-        const size_t numCols = arg->getNumCols();
         const size_t numRows = arg->getNumRows();
         
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
         
-        VT * valuesRes = res->getValues();
-        
-        if (AggOpCodeUtils::isPureBinaryReduction(opCode)) {
-        
-            EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
+        switch(opCode) {
+            case AggOpCode::SUM:
+                aggRows<BinaryOpCode::ADD>(res, arg, true, VT(0), false, ctx);
+                break;
+            case AggOpCode::MIN:
+                aggRows<BinaryOpCode::MIN>(res, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), false, ctx);
+                break;
+            case AggOpCode::MAX:
+                aggRows<BinaryOpCode::MAX>(res, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), false, ctx);
+                break;
+            case AggOpCode::MEAN:
+                aggRows<BinaryOpCode::ADD>(res, arg, true, VT(0), true, ctx);
+                break;
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggRow for CSRMatrix");
+        }
+    }
 
-            const bool isSparseSafe = AggOpCodeUtils::isSparseSafe(opCode);
-            const VT neutral = AggOpCodeUtils::template getNeutral<VT>(opCode);
-        
-            for(size_t r = 0; r < numRows; r++) {
-                *valuesRes = AggAll<CSRMatrix<VT>>::aggArray(
-                        arg->getValues(r),
-                        arg->getNumNonZeros(r),
-                        numCols,
-                        func,
-                        isSparseSafe,
-                        neutral,
-                        ctx
-                );
-                valuesRes += res->getRowSkip();
+private:
+    template<BinaryOpCode op>
+    static void aggRows(DenseMatrix<VT> * res, const CSRMatrix<VT> * arg, bool isSparseSafe, VT neutral, bool mean,
+            DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        const size_t numChunks = std::max<size_t>(1, std::min(AggReduce::getNumChunks(arg->getNumNonZeros()), numRows));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const auto [rowBegin, rowEnd] = AggReduce::getChunk(numRows, numChunks, i);
+            for(size_t r = rowBegin; r < rowEnd; r++) {
+                const size_t numNonZeros = arg->getNumNonZeros(r);
+                VT agg = AggReduce::reduce<op>(arg->getValues(r), numNonZeros, neutral, ctx);
+                if(!numNonZeros || (!isSparseSafe && numNonZeros < numCols))
+                    agg = EwBinarySca<op, VT, VT, VT>::apply(agg, 0, ctx);
+                valuesRes[r * rowSkipRes] = mean ? agg / numCols : agg;
             }
+        });
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DCSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct AggRow<DenseMatrix<VT>, DCSRMatrix<VT>> {
+    static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const DCSRMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+
+        switch(opCode) {
+            case AggOpCode::SUM:
+                aggRows<BinaryOpCode::ADD>(res, arg, true, VT(0), false, ctx);
+                break;
+            case AggOpCode::MIN:
+                aggRows<BinaryOpCode::MIN>(res, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), false, ctx);
+                break;
+            case AggOpCode::MAX:
+                aggRows<BinaryOpCode::MAX>(res, arg, false, AggOpCodeUtils::template getNeutral<VT>(opCode), false, ctx);
+                break;
+            case AggOpCode::MEAN:
+                aggRows<BinaryOpCode::ADD>(res, arg, true, VT(0), true, ctx);
+                break;
+            default:
+                // TODO STDDEV
+                throw std::runtime_error("unsupported AggOpCode in AggRow for DCSRMatrix");
         }
-        else { // The op-code is either MEAN or STDDEV
-            // get sum for each row
-            const VT neutral = VT(0);
-            const bool isSparseSafe = true;
-            EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
-            for (size_t r = 0; r < numRows; r++){
-                *valuesRes = AggAll<CSRMatrix<VT>>::aggArray(
-                    arg->getValues(r),
-                    arg->getNumNonZeros(r),
-                    numCols,
-                    func,
-                    isSparseSafe,
-                    neutral,
-                    ctx
-                );
-                if (opCode == AggOpCode::MEAN)
-                    *valuesRes = *valuesRes / numCols;
-                else
-                    throw std::runtime_error("unsupported AggOpCode in AggRow for CSRMatrix");
-                valuesRes += res->getRowSkip();
+    }
+
+private:
+    /**
+     * @brief Like for a `CSRMatrix`, but only the rows with non-zeros are reduced (in parallel chunks), all others
+     * aggregate to zero for the supported operations.
+     */
+    template<BinaryOpCode op>
+    static void aggRows(DenseMatrix<VT> * res, const DCSRMatrix<VT> * arg, bool isSparseSafe, VT neutral, bool mean,
+            DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t numNonZeroRows = arg->getNumNonZeroRows();
+        const size_t * rowIdxs = arg->getRowIdxs();
+        const size_t * rowOffsets = arg->getRowOffsets();
+        const VT * values = arg->getValues();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        for(size_t r = 0; r < numRows; r++)
+            valuesRes[r * rowSkipRes] = VT(0);
+
+        const size_t numChunks = std::max<size_t>(1,
+                std::min(AggReduce::getNumChunks(arg->getNumNonZeros()), numNonZeroRows));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const auto [begin, end] = AggReduce::getChunk(numNonZeroRows, numChunks, i);
+            for(size_t j = begin; j < end; j++) {
+                const size_t numNonZeros = rowOffsets[j + 1] - rowOffsets[j];
+                VT agg = AggReduce::reduce<op>(values + rowOffsets[j], numNonZeros, neutral, ctx);
+                if(!isSparseSafe && numNonZeros < numCols)
+                    agg = EwBinarySca<op, VT, VT, VT>::apply(agg, 0, ctx);
+                valuesRes[rowIdxs[j] * rowSkipRes] = mean ? agg / numCols : agg;
             }
-        }
+        });
     }
 };
 
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/MatMul.h>
+#include <runtime/local/vectorized/BlasThreads.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <cblas.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include <cstddef>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTLhs, class DTRhs>
+struct BatchMatMul {
+    static void apply(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, size_t numBatches, bool transa, bool transb,
+            DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Multiplies many small matrices in one call: `lhs` and `rhs` consist of `numBatches` blocks of equally many
+ * rows stacked on top of each other, and the result stacks the products `op(lhs_b) @ op(rhs_b)` of the blocks in the
+ * same way, e.g., the covariance matrices `t(X_b) @ X_b` of equally large groups.
+ */
+template<class DTRes, class DTLhs, class DTRhs>
+void batchMatMul(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, size_t numBatches, bool transa, bool transb,
+        DCTX(ctx)) {
+    BatchMatMul<DTRes, DTLhs, DTRhs>::apply(res, lhs, rhs, numBatches, transa, transb, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * The batches are processed in parallel chunks of about `MIN_CHUNK_WORK` multiply-adds. Small blocks are multiplied
+ * by the loops of `MatMulSmall`, larger floating-point blocks by BLAS, single-threaded within the workers (see
+ * `BlasThreads`).
+ */
+template<typename VT>
+struct BatchMatMul<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
+    static constexpr size_t MIN_CHUNK_WORK = 1 << 16;
+
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs,
+            size_t numBatches, bool transa, bool transb, DCTX(ctx)) {
+        if(numBatches == 0 || lhs->getNumRows() % numBatches || rhs->getNumRows() % numBatches)
+            throw std::runtime_error("BatchMatMul - the #rows of lhs and rhs must be multiples of numBatches");
+        const size_t numRowsLhs = lhs->getNumRows() / numBatches;
+        const size_t numRowsRhs = rhs->getNumRows() / numBatches;
+        const size_t m = transa ? lhs->getNumCols() : numRowsLhs;
+        const size_t k = transa ? numRowsLhs : lhs->getNumCols();
+        const size_t n = transb ? numRowsRhs : rhs->getNumCols();
+        if(k != (transb ? rhs->getNumCols() : numRowsRhs))
+            throw std::runtime_error("BatchMatMul - the blocks of lhs and rhs have incompatible shapes");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numBatches * m, n, false);
+
+        const VT * valuesLhs = lhs->getValues();
+        const VT * valuesRhs = rhs->getValues();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+        const bool small = MatMulSmall::isSmall(m, n, k) || !std::is_floating_point<VT>::value;
+
+        const size_t batchesPerChunk = std::max<size_t>(1, MIN_CHUNK_WORK / std::max<size_t>(1, m * n * k));
+        const size_t numChunks = (numBatches + batchesPerChunk - 1) / batchesPerChunk;
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t end = std::min(numBatches, (chunk + 1) * batchesPerChunk);
+            if(!small)
+                BlasThreads::prepare(ctx);
+            for(size_t b = chunk * batchesPerChunk; b < end; b++) {
+                const VT * blockLhs = valuesLhs + b * numRowsLhs * rowSkipLhs;
+                const VT * blockRhs = valuesRhs + b * numRowsRhs * rowSkipRhs;
+                VT * blockRes = valuesRes + b * m * rowSkipRes;
+                if(small)
+                    MatMulSmall::gemm(m, n, k, blockLhs, rowSkipLhs, transa, blockRhs, rowSkipRhs, transb, blockRes,
+                            rowSkipRes);
+                else
+                    gemmBlas(m, n, k, blockLhs, rowSkipLhs, transa, blockRhs, rowSkipRhs, transb, blockRes,
+                            rowSkipRes);
+            }
+        });
+    }
+
+private:
+    static void gemmBlas(size_t m, size_t n, size_t k, const VT * lhs, size_t rowSkipLhs, bool transa, const VT * rhs,
+            size_t rowSkipRhs, bool transb, VT * res, size_t rowSkipRes) {
+        if constexpr(std::is_same<VT, float>::value)
+            cblas_sgemm(CblasRowMajor, transa ? CblasTrans : CblasNoTrans, transb ? CblasTrans : CblasNoTrans,
+                    static_cast<int>(m), static_cast<int>(n), static_cast<int>(k), 1, lhs,
+                    static_cast<int>(rowSkipLhs), rhs, static_cast<int>(rowSkipRhs), 0, res,
+                    static_cast<int>(rowSkipRes));
+        else if constexpr(std::is_same<VT, double>::value)
+            cblas_dgemm(CblasRowMajor, transa ? CblasTrans : CblasNoTrans, transb ? CblasTrans : CblasNoTrans,
+                    static_cast<int>(m), static_cast<int>(n), static_cast<int>(k), 1, lhs,
+                    static_cast<int>(rowSkipLhs), rhs, static_cast<int>(rowSkipRhs), 0, res,
+                    static_cast<int>(rowSkipRes));
+        else
+            MatMulSmall::gemm(m, n, k, lhs, rowSkipLhs, transa, rhs, rowSkipRhs, transb, res, rowSkipRes);
+    }
+};
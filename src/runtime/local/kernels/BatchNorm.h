@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "runtime/local/context/DaphneContext.h"
+#include "runtime/local/datastructures/DataObjectFactory.h"
+#include "runtime/local/datastructures/DenseMatrix.h"
+#include "runtime/local/vectorized/WorkerPool.h"
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace BatchNorm {
+    template<typename DTRes, typename DTArg>
+    struct Forward {
+        static void apply(DTRes *&res, const DTArg *data, const DTArg *gamma, const DTArg *beta, const DTArg *ema_mean,
+                const DTArg *ema_var, typename DTArg::VT eps, DCTX(dctx)) {
+            throw std::runtime_error("C++ batch normalization not implemented for these data types");
+        }
+    };
+
+    /**
+     * @brief Normalizes each channel of each image (a row of `data` in NCHW layout) by the given moving averages of
+     * the mean and the variance of the channel and scales and shifts it by `gamma` and `beta` (inference mode, like
+     * the CUDA kernel). The channels are the values of `gamma`.
+     *
+     * The normalization is folded into one scale and shift per channel, which are applied to the images in parallel.
+     */
+    template<typename VT>
+    struct Forward<DenseMatrix<VT>, DenseMatrix<VT>> {
+        static void apply(DenseMatrix<VT> *&res, const DenseMatrix<VT> *data, const DenseMatrix<VT> *gamma,
+                const DenseMatrix<VT> *beta, const DenseMatrix<VT> *ema_mean, const DenseMatrix<VT> *ema_var, VT eps,
+                DCTX(dctx)) {
+            const size_t numRows = data->getNumRows();
+            const size_t numCols = data->getNumCols();
+            const size_t C = gamma->getNumRows() * gamma->getNumCols();
+            for(const DenseMatrix<VT> *arg : {beta, ema_mean, ema_var})
+                if(arg->getNumRows() * arg->getNumCols() != C)
+                    throw std::runtime_error("BatchNorm: gamma, beta, mean, and variance must have a value per channel");
+            if(C == 0 || numCols % C)
+                throw std::runtime_error("BatchNorm: the number of columns of the input must be a multiple of the "
+                        "number of channels");
+            const size_t HW = numCols / C;
+
+            std::vector<VT> scale(C);
+            std::vector<VT> shift(C);
+            for(size_t c = 0; c < C; c++) {
+                scale[c] = get(gamma, c) / std::sqrt(get(ema_var, c) + eps);
+                shift[c] = get(beta, c) - get(ema_mean, c) * scale[c];
+            }
+
+            if(res == nullptr)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+            WorkerPool::parallelFor(dctx, numRows, [&](size_t r) {
+                const VT *in = data->getValues() + r * data->getRowSkip();
+                VT *out = res->getValues() + r * res->getRowSkip();
+                for(size_t c = 0; c < C; c++) {
+                    const VT s = scale[c];
+                    const VT t = shift[c];
+                    #pragma omp simd
+                    for(size_t i = c * HW; i < (c + 1) * HW; i++)
+                        out[i] = in[i] * s + t;
+                }
+            });
+        }
+
+    private:
+        // the i-th value of a row or column matrix
+        static VT get(const DenseMatrix<VT> *vec, size_t i) {
+            return vec->getNumCols() == 1 ? vec->get(i, 0) : vec->get(0, i);
+        }
+    };
+}
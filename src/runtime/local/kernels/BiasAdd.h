@@ -0,0 +1,69 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "runtime/local/context/DaphneContext.h"
+#include "runtime/local/datastructures/DataObjectFactory.h"
+#include "runtime/local/datastructures/DenseMatrix.h"
+#include "runtime/local/vectorized/WorkerPool.h"
+
+#include <cstddef>
+#include <stdexcept>
+
+namespace BiasAdd {
+    template<typename DTRes, typename DTArg>
+    struct Forward {
+        static void apply(DTRes *&res, const DTArg *input, const DTArg *bias, DCTX(dctx)) {
+            throw std::runtime_error("C++ bias add not implemented for these data types");
+        }
+    };
+
+    /**
+     * @brief Adds the value of `bias` (a row or column matrix) of each channel to the channel of each row of `input`
+     * (in NCHW layout). The channels are the values of `bias`, such that a bias of a value per column adds it to each
+     * column (like the CUDA kernel). The rows are processed in parallel.
+     */
+    template<typename VT>
+    struct Forward<DenseMatrix<VT>, DenseMatrix<VT>> {
+        static void apply(DenseMatrix<VT> *&res, const DenseMatrix<VT> *input, const DenseMatrix<VT> *bias,
+                DCTX(dctx)) {
+            const size_t numRows = input->getNumRows();
+            const size_t numCols = input->getNumCols();
+            const size_t C = bias->getNumRows() * bias->getNumCols();
+            if(C == 0 || numCols % C)
+                throw std::runtime_error("BiasAdd: the number of columns of the input must be a multiple of the "
+                        "number of values of the bias");
+            const size_t HW = numCols / C;
+            const VT *valuesBias = bias->getValues();
+            const size_t stepBias = bias->getNumCols() == 1 ? bias->getRowSkip() : 1;
+
+            if(res == nullptr)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+            WorkerPool::parallelFor(dctx, numRows, [&](size_t r) {
+                const VT *in = input->getValues() + r * input->getRowSkip();
+                VT *out = res->getValues() + r * res->getRowSkip();
+                for(size_t c = 0; c < C; c++) {
+                    const VT b = valuesBias[c * stepBias];
+                    #pragma omp simd
+                    for(size_t i = c * HW; i < (c + 1) * HW; i++)
+                        out[i] = in[i] + b;
+                }
+            });
+        }
+    };
+}
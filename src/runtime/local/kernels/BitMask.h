@@ -0,0 +1,308 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/EwBinarySca.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <runtime/local/kernels/ZoneMaps.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief The building blocks of the kernels on `BitMatrix` masks, which process the cells in words of 64 and run
+ * chunk-parallel on the `WorkerPool`.
+ */
+namespace BitMask {
+    // the words of a chunk handled by one task, whose cells are a block of the statistics of a column (see
+    // `ZoneMap`)
+    constexpr size_t CHUNK_WORDS = 1 << 10;
+    static_assert(CHUNK_WORDS * 64 == ColumnStats::BLOCK_ROWS, "BitMask: a chunk must cover a block of a zone map");
+
+    /**
+     * @brief Returns the number of chunks of the given number of words.
+     */
+    inline size_t getNumChunks(size_t numWords) {
+        return (numWords + CHUNK_WORDS - 1) / CHUNK_WORDS;
+    }
+
+    /**
+     * @brief Returns whether an operation is a comparison, whose result can be a mask.
+     */
+    inline bool isComparison(BinaryOpCode opCode) {
+        switch(opCode) {
+            case BinaryOpCode::EQ:
+            case BinaryOpCode::NEQ:
+            case BinaryOpCode::LT:
+            case BinaryOpCode::LE:
+            case BinaryOpCode::GT:
+            case BinaryOpCode::GE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Packs the results of a comparison of `n <= 64` values of `lhs` with those of `rhs` into the bits of a
+     * word, where `rhsStep` is 1 for an array and 0 for a scalar.
+     */
+    template<BinaryOpCode opCode, typename VT>
+    struct PackWord {
+        static uint64_t apply(const VT * lhs, const VT * rhs, size_t rhsStep, size_t n) {
+            uint64_t word = 0;
+            for(size_t j = 0; j < n; j++)
+                word |= uint64_t(EwBinarySca<opCode, bool, VT, VT>::apply(lhs[j], rhs[j * rhsStep], nullptr)) << j;
+            return word;
+        }
+    };
+
+#if defined(__AVX__)
+    // The AVX comparison predicates, which (like C++) are false for NaNs except for NEQ.
+    template<BinaryOpCode opCode>
+    constexpr int avxPredicate() {
+        switch(opCode) {
+            case BinaryOpCode::EQ:  return _CMP_EQ_OQ;
+            case BinaryOpCode::NEQ: return _CMP_NEQ_UQ;
+            case BinaryOpCode::LT:  return _CMP_LT_OQ;
+            case BinaryOpCode::LE:  return _CMP_LE_OQ;
+            case BinaryOpCode::GT:  return _CMP_GT_OQ;
+            default:                return _CMP_GE_OQ;
+        }
+    }
+
+    template<BinaryOpCode opCode>
+    struct PackWord<opCode, double> {
+        static uint64_t apply(const double * lhs, const double * rhs, size_t rhsStep, size_t n) {
+            if(n < 64)
+                return packRest(lhs, rhs, rhsStep, n);
+            constexpr int pred = avxPredicate<opCode>();
+            const __m256d scalar = _mm256_set1_pd(*rhs);
+            uint64_t word = 0;
+            for(size_t j = 0; j < 64; j += 4) {
+                const __m256d r = rhsStep ? _mm256_loadu_pd(rhs + j) : scalar;
+                const __m256d m = _mm256_cmp_pd(_mm256_loadu_pd(lhs + j), r, pred);
+                word |= uint64_t(_mm256_movemask_pd(m)) << j;
+            }
+            return word;
+        }
+
+    private:
+        static uint64_t packRest(const double * lhs, const double * rhs, size_t rhsStep, size_t n) {
+            uint64_t word = 0;
+            for(size_t j = 0; j < n; j++)
+                word |= uint64_t(EwBinarySca<opCode, bool, double, double>::apply(lhs[j], rhs[j * rhsStep], nullptr))
+                        << j;
+            return word;
+        }
+    };
+
+    template<BinaryOpCode opCode>
+    struct PackWord<opCode, float> {
+        static uint64_t apply(const float * lhs, const float * rhs, size_t rhsStep, size_t n) {
+            if(n < 64)
+                return packRest(lhs, rhs, rhsStep, n);
+            constexpr int pred = avxPredicate<opCode>();
+            const __m256 scalar = _mm256_set1_ps(*rhs);
+            uint64_t word = 0;
+            for(size_t j = 0; j < 64; j += 8) {
+                const __m256 r = rhsStep ? _mm256_loadu_ps(rhs + j) : scalar;
+                const __m256 m = _mm256_cmp_ps(_mm256_loadu_ps(lhs + j), r, pred);
+                word |= uint64_t(_mm256_movemask_ps(m)) << j;
+            }
+            return word;
+        }
+
+    private:
+        static uint64_t packRest(const float * lhs, const float * rhs, size_t rhsStep, size_t n) {
+            uint64_t word = 0;
+            for(size_t j = 0; j < n; j++)
+                word |= uint64_t(EwBinarySca<opCode, bool, float, float>::apply(lhs[j], rhs[j * rhsStep], nullptr))
+                        << j;
+            return word;
+        }
+    };
+#endif
+
+    /**
+     * @brief Writes the mask of the point comparison (`EQ` or `NEQ`) of a column with a scalar to `res` by looking
+     * up the rows of the scalar in the index of the column (see `KeyIndex`), without reading the other values.
+     */
+    template<BinaryOpCode opCode, typename VT>
+    void compareIndexed(BitMatrix * res, const VT * values, const KeyIndex & keyIndex, VT rhs, DCTX(ctx)) {
+        static_assert(opCode == BinaryOpCode::EQ || opCode == BinaryOpCode::NEQ,
+                "BitMask: only point comparisons look up an index");
+        const size_t numRows = keyIndex.getNumRows();
+        const size_t numWords = res->getNumWords();
+        uint64_t * words = res->getWords();
+        WorkerPool::parallelFor(ctx, getNumChunks(numWords), [&](size_t chunk) {
+            const size_t endWord = std::min(numWords, (chunk + 1) * CHUNK_WORDS);
+            for(size_t w = chunk * CHUNK_WORDS; w < endWord; w++) {
+                const size_t n = std::min<size_t>(64, numRows - w * 64);
+                words[w] = opCode == BinaryOpCode::NEQ ? (n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1) : 0;
+            }
+        });
+        const size_t k = KeyIndexes::lookup(keyIndex, values, rhs);
+        if(k != KeyIndex::npos)
+            for(const size_t * r = keyIndex.getRowsBegin(k); r != keyIndex.getRowsEnd(k); r++)
+                words[*r / 64] ^= uint64_t(1) << (*r % 64);
+    }
+
+    /**
+     * @brief Writes the mask of the comparison of `lhs` with `rhs` to `res`, where `rhs` is either a matrix of the
+     * size of `lhs` (`rhsStep` 1) or a scalar (`rhsStep` 0, `rhsRowSkip` 0).
+     *
+     * Operands whose rows are adjacent are compared 64 cells at a time, the others cell by cell. The chunks of a
+     * column with statistics (see `DenseMatrix::getZoneMap()`) whose bounds decide the comparison with a scalar for
+     * all their cells are filled without reading the values. A point comparison of a column with an index (see
+     * `DenseMatrix::getKeyIndex()`) with a scalar looks up the index instead, see `compareIndexed()`.
+     */
+    template<BinaryOpCode opCode, typename VT>
+    void compare(BitMatrix * res, const DenseMatrix<VT> * lhs, const VT * rhs, size_t rhsStep, size_t rhsRowSkip,
+            DCTX(ctx)) {
+        const size_t numCols = lhs->getNumCols();
+        const size_t numCells = lhs->getNumRows() * numCols;
+        const size_t numWords = res->getNumWords();
+        const VT * valuesLhs = lhs->getValues();
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        if constexpr(opCode == BinaryOpCode::EQ || opCode == BinaryOpCode::NEQ) {
+            const auto keyIndex = (numCols == 1 && rowSkipLhs == 1 && rhsStep == 0) ? lhs->getKeyIndex(0) : nullptr;
+            if(keyIndex && keyIndex->getNumRows() == numCells) {
+                compareIndexed<opCode>(res, valuesLhs, *keyIndex, *rhs, ctx);
+                return;
+            }
+        }
+        uint64_t * words = res->getWords();
+        const bool contiguous = rowSkipLhs == numCols && (rhsStep == 0 || rhsRowSkip == numCols);
+        const auto zoneMap = (numCols == 1 && rhsStep == 0) ? lhs->getZoneMap(0) : nullptr;
+
+        WorkerPool::parallelFor(ctx, getNumChunks(numWords), [&](size_t chunk) {
+            const size_t endWord = std::min(numWords, (chunk + 1) * CHUNK_WORDS);
+            const ZoneMaps::BlockMatch match = zoneMap && chunk < zoneMap->getNumBlocks()
+                    ? ZoneMaps::match(opCode, *zoneMap, chunk, *rhs) : ZoneMaps::BlockMatch::SOME;
+            if(match != ZoneMaps::BlockMatch::SOME) {
+                for(size_t w = chunk * CHUNK_WORDS; w < endWord; w++) {
+                    const size_t n = std::min<size_t>(64, numCells - w * 64);
+                    const uint64_t all = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+                    words[w] = match == ZoneMaps::BlockMatch::ALL ? all : 0;
+                }
+                return;
+            }
+            for(size_t w = chunk * CHUNK_WORDS; w < endWord; w++) {
+                const size_t begin = w * 64;
+                const size_t n = std::min<size_t>(64, numCells - begin);
+                if(contiguous) {
+                    words[w] = PackWord<opCode, VT>::apply(valuesLhs + begin, rhs + begin * rhsStep, rhsStep, n);
+                    continue;
+                }
+                uint64_t word = 0;
+                for(size_t j = 0; j < n; j++) {
+                    const size_t r = (begin + j) / numCols;
+                    const size_t c = (begin + j) % numCols;
+                    word |= uint64_t(EwBinarySca<opCode, bool, VT, VT>::apply(valuesLhs[r * rowSkipLhs + c],
+                            rhs[(r * rhsRowSkip + c) * rhsStep], ctx)) << j;
+                }
+                words[w] = word;
+            }
+        });
+    }
+
+    /**
+     * @brief Dispatches `compare()` on the op code, which must be a comparison.
+     */
+    template<typename VT>
+    void compare(BinaryOpCode opCode, BitMatrix * res, const DenseMatrix<VT> * lhs, const VT * rhs, size_t rhsStep,
+            size_t rhsRowSkip, DCTX(ctx)) {
+        switch(opCode) {
+#define MAKE_CASE(opCode) case opCode: compare<opCode>(res, lhs, rhs, rhsStep, rhsRowSkip, ctx); break;
+            MAKE_CASE(BinaryOpCode::EQ)
+            MAKE_CASE(BinaryOpCode::NEQ)
+            MAKE_CASE(BinaryOpCode::LT)
+            MAKE_CASE(BinaryOpCode::LE)
+            MAKE_CASE(BinaryOpCode::GT)
+            MAKE_CASE(BinaryOpCode::GE)
+#undef MAKE_CASE
+            default:
+                throw std::runtime_error("BitMask: only comparisons result in a mask");
+        }
+    }
+
+    /**
+     * @brief Returns the number of set bits of a mask by popcount, one word at a time.
+     */
+    inline size_t count(const BitMatrix * mask, DCTX(ctx)) {
+        const size_t numWords = mask->getNumWords();
+        const uint64_t * words = mask->getWords();
+        const size_t numChunks = getNumChunks(numWords);
+        std::vector<size_t> counts(numChunks, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t endWord = std::min(numWords, (chunk + 1) * CHUNK_WORDS);
+            size_t n = 0;
+            for(size_t w = chunk * CHUNK_WORDS; w < endWord; w++)
+                n += __builtin_popcountll(words[w]);
+            counts[chunk] = n;
+        });
+        size_t n = 0;
+        for(size_t c : counts)
+            n += c;
+        return n;
+    }
+
+    /**
+     * @brief Writes the indexes of the set bits of a mask to `positions`, in ascending order, and returns their
+     * number.
+     *
+     * The set bits of each chunk are counted by popcount and then written to their offsets in parallel, skipping
+     * from one set bit to the next by counting the trailing zeros.
+     */
+    inline size_t positions(size_t * positions, const BitMatrix * mask, DCTX(ctx)) {
+        const size_t numWords = mask->getNumWords();
+        const uint64_t * words = mask->getWords();
+        const size_t numChunks = getNumChunks(numWords);
+        std::vector<size_t> offsets(numChunks + 1, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t endWord = std::min(numWords, (chunk + 1) * CHUNK_WORDS);
+            size_t n = 0;
+            for(size_t w = chunk * CHUNK_WORDS; w < endWord; w++)
+                n += __builtin_popcountll(words[w]);
+            offsets[chunk + 1] = n;
+        });
+        for(size_t chunk = 0; chunk < numChunks; chunk++)
+            offsets[chunk + 1] += offsets[chunk];
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t endWord = std::min(numWords, (chunk + 1) * CHUNK_WORDS);
+            size_t * out = positions + offsets[chunk];
+            for(size_t w = chunk * CHUNK_WORDS; w < endWord; w++)
+                for(uint64_t word = words[w]; word; word &= word - 1)
+                    *out++ = w * 64 + __builtin_ctzll(word);
+        });
+        return offsets[numChunks];
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/BloomFilter.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The building and probing of the blocked Bloom filters of the keys of the rows of frames (see
+ * `BlockedBloomFilter`), by which the rows of the larger input of a join without a match in the smaller one are
+ * dropped early, e.g., before they are materialized by a filter or shuffled between the distributed workers.
+ *
+ * The keys are hashed like those of the hash joins (see `KeyIndexes::Keys`), such that the key columns of the
+ * probed frame must have the same value types as those of the frame the filter was built on.
+ */
+namespace BloomFilters {
+    // the rows hashed at once by a task probing a filter
+    constexpr size_t BATCH_ROWS = 1024;
+
+    /**
+     * @brief Inserts the keys of all rows into the filter. The keys are hashed in parallel.
+     */
+    inline void insert(uint64_t * words, size_t numWords, const KeyIndexes::Keys & keys, size_t numRows, DCTX(ctx)) {
+        const std::vector<uint64_t> hashes = KeyIndexes::hashRows(keys, numRows, ctx);
+        for(uint64_t h : hashes)
+            BlockedBloomFilter::insert(words, numWords, h);
+    }
+
+    /**
+     * @brief Writes whether the key of each row may be in the filter to `sel`, in parallel chunks of rows.
+     */
+    template<typename VTSel>
+    void probe(VTSel * sel, const KeyIndexes::Keys & keys, size_t numRows, const uint64_t * words, size_t numWords,
+            DCTX(ctx)) {
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / KeyIndexes::CHUNK_ROWS));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            uint64_t hashes[BATCH_ROWS];
+            const size_t end = numRows * (chunk + 1) / numChunks;
+            for(size_t begin = numRows * chunk / numChunks; begin < end; begin += BATCH_ROWS) {
+                const size_t n = std::min(BATCH_ROWS, end - begin);
+                keys.hash(hashes, begin, begin + n);
+                for(size_t i = 0; i < n; i++)
+                    sel[begin + i] = BlockedBloomFilter::mayContain(words, numWords, hashes[i]);
+            }
+        });
+    }
+
+    /**
+     * @brief Returns the rows of `probed` whose keys may be among the keys of `build`, in ascending order, by a
+     * filter of the keys of `build`. The key columns of both frames must have the same value types.
+     */
+    inline std::vector<size_t> matchingRows(const Frame * probed, const std::vector<size_t> & keyColsProbed,
+            const Frame * build, const std::vector<size_t> & keyColsBuild, DCTX(ctx)) {
+        const size_t numWords = BlockedBloomFilter::numWordsFor(build->getNumRows());
+        std::vector<uint64_t> words(numWords, 0);
+        insert(words.data(), numWords, KeyIndexes::Keys(build, keyColsBuild), build->getNumRows(), ctx);
+
+        const size_t numRows = probed->getNumRows();
+        std::vector<uint8_t> sel(numRows);
+        probe(sel.data(), KeyIndexes::Keys(probed, keyColsProbed), numRows, words.data(), numWords, ctx);
+        std::vector<size_t> rows;
+        for(size_t r = 0; r < numRows; r++)
+            if(sel[r])
+                rows.push_back(r);
+        return rows;
+    }
+}
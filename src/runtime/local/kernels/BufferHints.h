@@ -0,0 +1,41 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BufferPool.h>
+
+#include <cstddef>
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Reserves `count` arrays of `numBytes` in the buffer pool, which the
+ * intermediates of a loop body need at the same time, see PlanMemoryPass.
+ */
+inline void reserveBuffers(size_t numBytes, size_t count, DCTX(ctx)) {
+    BufferPool::get().reserve(numBytes, count);
+}
+
+/**
+ * @brief Undoes a `reserveBuffers()` of the same arguments after the loop.
+ */
+inline void releaseBuffers(size_t numBytes, size_t count, DCTX(ctx)) {
+    BufferPool::get().unreserve(numBytes, count);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_BUILDBLOOMFILTER_H
+#define SRC_RUNTIME_LOCAL_KERNELS_BUILDBLOOMFILTER_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/BloomFilters.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <util/BloomFilter.h>
+
+#include <algorithm>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Builds a blocked Bloom filter of the values of a column of a frame,
+ * e.g., of the key column of the smaller input of a join, by which
+ * `probeBloomFilter` drops the rows of the other input without a match.
+ *
+ * The result is a single-column matrix of the words of the filter (see
+ * `BlockedBloomFilter`), followed by the value type code of the column, which
+ * the probed column must have as well.
+ *
+ * @param res The filter
+ * @param arg The frame
+ * @param on The label of the column
+ */
+inline void buildBloomFilter(DenseMatrix<uint64_t> *& res, const Frame * arg, const char * on, DCTX(ctx)) {
+    const size_t c = arg->getColumnIdx(on);
+    const size_t numWords = BlockedBloomFilter::numWordsFor(arg->getNumRows());
+    if(res == nullptr)
+        res = DataObjectFactory::create<DenseMatrix<uint64_t>>(numWords + 1, 1, false);
+    uint64_t * words = res->getValues();
+    std::fill(words, words + numWords, 0);
+    BloomFilters::insert(words, numWords, KeyIndexes::Keys(arg, {c}), arg->getNumRows(), ctx);
+    words[numWords] = static_cast<uint64_t>(arg->getColumnType(c));
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_BUILDBLOOMFILTER_H
@@ -21,6 +21,17 @@
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/FlatHashMap.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -29,10 +40,11 @@
 template<class DTRes, class DTLhs, class DTRhs>
 struct CTable {
     static void apply(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, DCTX(ctx)) = delete;
+    static void apply(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, const DTLhs * weights, DCTX(ctx)) = delete;
 };
 
 // ****************************************************************************
-// Convenience function
+// Convenience functions
 // ****************************************************************************
 
 template<class DTRes, class DTLhs, class DTRhs>
@@ -40,6 +52,37 @@ void ctable(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, DCTX(ctx)) {
     CTable<DTRes, DTLhs, DTRhs>::apply(res, lhs, rhs, ctx);
 }
 
+/**
+ * @brief Computes the contingency table of lhs and rhs, in which each pair
+ * `(lhs[k], rhs[k])` is counted with the weight `weights[k]` instead of one.
+ */
+template<class DTRes, class DTLhs, class DTRhs>
+void ctable(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, const DTLhs * weights, DCTX(ctx)) {
+    CTable<DTRes, DTLhs, DTRhs>::apply(res, lhs, rhs, weights, ctx);
+}
+
+// ****************************************************************************
+// Functions called by multiple template specializations
+// ****************************************************************************
+
+// The rows of the arguments counted by one task.
+constexpr size_t CTABLE_CHUNK_ROWS = 1 << 16;
+
+template<typename VT>
+void ctableCheckArgs(const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, const DenseMatrix<VT> * weights) {
+    if((lhs->getNumCols() != 1) || (rhs->getNumCols() != 1))
+        throw std::runtime_error("ctable: lhs and rhs must have only one column");
+    if(lhs->getNumRows() != rhs->getNumRows())
+        throw std::runtime_error("ctable: lhs and rhs must have the same number of rows");
+    if(weights && (weights->getNumCols() != 1 || weights->getNumRows() != lhs->getNumRows()))
+        throw std::runtime_error("ctable: weights must be a column with the same number of rows as lhs and rhs");
+}
+
+// The number of chunks of the given number of rows.
+inline size_t ctableNumChunks(size_t numRows) {
+    return std::max<size_t>(1, std::min<size_t>(64, numRows / CTABLE_CHUNK_ROWS));
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -51,27 +94,70 @@ void ctable(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, DCTX(ctx)) {
 template<typename VT>
 struct CTable<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
     static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
-        const size_t lhsNumRows = lhs->getNumRows();
-        const size_t lhsNumCols = lhs->getNumCols();
-        const size_t rhsNumRows = rhs->getNumRows();
-        const size_t rhsNumCols = rhs->getNumCols();
+        apply(res, lhs, rhs, nullptr, ctx);
+    }
 
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs,
+            const DenseMatrix<VT> * weights, DCTX(ctx)) {
+        ctableCheckArgs(lhs, rhs, weights);
+        const size_t numRows = lhs->getNumRows();
         auto lhsVals = lhs->getValues();
         auto rhsVals = rhs->getValues();
+        const VT * weightVals = weights ? weights->getValues() : nullptr;
 
-        if((lhsNumCols != 1) || (rhsNumCols != 1))
-            throw std::runtime_error("ctable: lhs and rhs must have only one column");
-        if(lhsNumRows != rhsNumRows)
-            throw std::runtime_error("ctable: lhs and rhs must have the same number of rows");
         if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<VT>>(*std::max_element(lhsVals, &lhsVals[lhsNumRows]) + 1, 
-                                                                *std::max_element(rhsVals, &rhsVals[rhsNumRows]) + 1, true);
+            res = DataObjectFactory::create<DenseMatrix<VT>>(*std::max_element(lhsVals, &lhsVals[numRows]) + 1, 
+                                                                *std::max_element(rhsVals, &rhsVals[numRows]) + 1, true);
 
         // res[i, j] = |{ k | lhs[k] = i and rhs[k] = j, 0 ≤ k ≤ n-1 }|.
-        auto resVals = res->getValues();
+        const size_t resNumCols = res->getNumCols();
+        const size_t resNumCells = res->getNumRows() * resNumCols;
+        auto count = [&](VT * table, size_t rowSkip, size_t begin, size_t end) {
+            if(weightVals)
+                for(size_t c = begin; c < end; c++)
+                    table[static_cast<size_t>(lhsVals[c]) * rowSkip + static_cast<size_t>(rhsVals[c])] += weightVals[c];
+            else
+                for(size_t c = begin; c < end; c++)
+                    table[static_cast<size_t>(lhsVals[c]) * rowSkip + static_cast<size_t>(rhsVals[c])]++;
+        };
+
+        // Each chunk of the rows is counted into a table of its own, as long
+        // as the tables take no more space than the arguments.
+        size_t numChunks = ctableNumChunks(numRows);
+        while(numChunks > 1 && (numChunks - 1) * resNumCells > numRows)
+            numChunks /= 2;
+        if(numChunks == 1) {
+            count(res->getValues(), res->getRowSkip(), 0, numRows);
+            return;
+        }
+        auto tables = std::make_unique<VT[]>(numChunks * resNumCells);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            VT * table = tables.get() + chunk * resNumCells;
+            std::fill(table, table + resNumCells, VT(0));
+            count(table, resNumCols, numRows * chunk / numChunks, numRows * (chunk + 1) / numChunks);
+        });
+
+        // Sum the tables pairwise, splitting each table into slices of cells.
+        const size_t numSlices = std::max<size_t>(1, std::min<size_t>(16, resNumCells / CTABLE_CHUNK_ROWS));
+        for(size_t stride = 1; stride < numChunks; stride *= 2) {
+            const size_t numPairs = (numChunks + 2 * stride - 1) / (2 * stride);
+            WorkerPool::parallelFor(ctx, numPairs * numSlices, [&](size_t task) {
+                const size_t into = task / numSlices * 2 * stride;
+                if(into + stride >= numChunks)
+                    return;
+                const size_t slice = task % numSlices;
+                VT * dst = tables.get() + into * resNumCells;
+                const VT * src = tables.get() + (into + stride) * resNumCells;
+                for(size_t i = resNumCells * slice / numSlices; i < resNumCells * (slice + 1) / numSlices; i++)
+                    dst[i] += src[i];
+            });
+        }
+
+        VT * resVals = res->getValues();
         const size_t resRowSkip = res->getRowSkip();
-        for(size_t c = 0; c < lhsNumRows; c++)
-            resVals[static_cast<size_t>(lhsVals[c] * resRowSkip + rhsVals[c])]++;
+        for(size_t i = 0; i < res->getNumRows(); i++)
+            for(size_t j = 0; j < resNumCols; j++)
+                resVals[i * resRowSkip + j] += tables[i * resNumCols + j];
     }
 };
 
@@ -81,29 +167,95 @@ struct CTable<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
 template<typename VT>
 struct CTable<CSRMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
     static void apply(CSRMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
-        const size_t lhsNumRows = lhs->getNumRows();
-        const size_t lhsNumCols = lhs->getNumCols();
-        const size_t rhsNumRows = rhs->getNumRows();
-        const size_t rhsNumCols = rhs->getNumCols();
+        apply(res, lhs, rhs, nullptr, ctx);
+    }
 
+    static void apply(CSRMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs,
+            const DenseMatrix<VT> * weights, DCTX(ctx)) {
+        ctableCheckArgs(lhs, rhs, weights);
+        const size_t numRows = lhs->getNumRows();
         auto lhsVals = lhs->getValues();
         auto rhsVals = rhs->getValues();
+        const VT * weightVals = weights ? weights->getValues() : nullptr;
 
-        if((lhsNumCols != 1) || (rhsNumCols != 1))
-            throw std::runtime_error("ctable: lhs and rhs must have only one column");
-        if(lhsNumRows != rhsNumRows)
-            throw std::runtime_error("ctable: lhs and rhs must have the same number of rows");
-        if(res == nullptr) {
-            const size_t resNumRows = *std::max_element(lhsVals, &lhsVals[lhsNumRows]) + 1;
-            const size_t resNumCols = *std::max_element(rhsVals, &rhsVals[rhsNumRows]) + 1;
-            res = DataObjectFactory::create<CSRMatrix<VT>>(resNumRows, resNumCols, std::min(lhsNumRows, resNumRows * resNumCols), true);
-        }
+        const size_t resNumRows = res ? res->getNumRows() : *std::max_element(lhsVals, &lhsVals[numRows]) + 1;
+        const size_t resNumCols = res ? res->getNumCols() : *std::max_element(rhsVals, &rhsVals[numRows]) + 1;
 
-        for(size_t c = 0; c < lhsNumRows; c++){
-            auto i = lhsVals[c];
-            auto j = rhsVals[c];
-            res->set(i, j, res->get(i, j) + 1);
+        // Count the occurrences of each distinct pair (i, j) of each chunk of
+        // the rows in a hash map instead of looking up and updating res for
+        // every row. The pairs of each chunk are then split into blocks of
+        // the rows of res.
+        const size_t numChunks = ctableNumChunks(numRows);
+        const size_t numBlocks = numChunks;
+        using Entry = std::pair<uint64_t, VT>;
+        std::vector<std::vector<std::vector<Entry>>> chunkBlocks(numChunks, std::vector<std::vector<Entry>>(numBlocks));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            FlatHashMap<uint64_t, VT> counts;
+            for(size_t c = numRows * chunk / numChunks; c < numRows * (chunk + 1) / numChunks; c++) {
+                const size_t i = static_cast<size_t>(lhsVals[c]);
+                const size_t j = static_cast<size_t>(rhsVals[c]);
+                counts[uint64_t(i) * resNumCols + j] += weightVals ? weightVals[c] : VT(1);
+            }
+            for(const auto & entry : counts)
+                chunkBlocks[chunk][entry.first / resNumCols * numBlocks / resNumRows].push_back(entry);
+        });
+
+        if(res) {
+            for(const auto & blocks : chunkBlocks)
+                for(const auto & block : blocks)
+                    for(const auto & [ij, count] : block) {
+                        const size_t i = ij / resNumCols;
+                        const size_t j = ij % resNumCols;
+                        res->set(i, j, res->get(i, j) + count);
+                    }
+            return;
         }
+
+        // Merge the pairs of each block, sorted by row and column.
+        std::vector<std::vector<Entry>> blocks(numBlocks);
+        WorkerPool::parallelFor(ctx, numBlocks, [&](size_t b) {
+            std::vector<Entry> & block = blocks[b];
+            for(size_t chunk = 0; chunk < numChunks; chunk++) {
+                block.insert(block.end(), chunkBlocks[chunk][b].begin(), chunkBlocks[chunk][b].end());
+                std::vector<Entry>().swap(chunkBlocks[chunk][b]);
+            }
+            std::sort(block.begin(), block.end(), [](const Entry & x, const Entry & y) { return x.first < y.first; });
+            size_t n = 0;
+            for(size_t k = 0; k < block.size(); k++) {
+                if(n > 0 && block[n - 1].first == block[k].first)
+                    block[n - 1].second += block[k].second;
+                else
+                    block[n++] = block[k];
+            }
+            // Weights can sum up to zero.
+            block.erase(std::remove_if(block.begin(), block.begin() + n, [](const Entry & e) { return e.second == VT(0); }),
+                    block.end());
+        });
+
+        // Build the CSR representation, each block at the position given by
+        // the numbers of non-zeros of the blocks before it.
+        std::vector<size_t> blockOffsets(numBlocks + 1, 0);
+        for(size_t b = 0; b < numBlocks; b++)
+            blockOffsets[b + 1] = blockOffsets[b] + blocks[b].size();
+        const size_t numNonZeros = blockOffsets[numBlocks];
+        res = DataObjectFactory::create<CSRMatrix<VT>>(resNumRows, resNumCols, std::max<size_t>(1, numNonZeros), true);
+        VT * resVals = res->getValues();
+        size_t * resColIdxs = res->getColIdxs();
+        size_t * resRowOffsets = res->getRowOffsets();
+        WorkerPool::parallelFor(ctx, numBlocks, [&](size_t b) {
+            const std::vector<Entry> & block = blocks[b];
+            const size_t rowBegin = (resNumRows * b + numBlocks - 1) / numBlocks;
+            const size_t rowEnd = (resNumRows * (b + 1) + numBlocks - 1) / numBlocks;
+            size_t k = 0;
+            for(size_t i = rowBegin; i < rowEnd; i++) {
+                resRowOffsets[i] = blockOffsets[b] + k;
+                for(; k < block.size() && block[k].first / resNumCols == i; k++) {
+                    resVals[blockOffsets[b] + k] = block[k].second;
+                    resColIdxs[blockOffsets[b] + k] = block[k].first % resNumCols;
+                }
+            }
+        });
+        resRowOffsets[resNumRows] = numNonZeros;
     }
 };
 #endif //SRC_RUNTIME_LOCAL_KERNELS_CTABLE_H
@@ -16,21 +16,27 @@
 
 #include "Affine.h"
 #include "HostUtils.h"
+#include "MixedPrecision.h"
 #include <runtime/local/datastructures/AllocationDescriptorCUDA.h>
 
 template<typename T>
-static void launch_cublas_gemm(const CUDAContext& ctx, size_t nr1, size_t nc1, size_t nc2, const T* alpha, const T* beta,
+static void launch_cublas_gemm(CUDAContext& ctx, size_t nr1, size_t nc1, size_t nc2, const T* alpha, const T* beta,
                                const T* d_lhs, const T* d_rhs, T* d_res);
 
 template<>
-[[maybe_unused]] void launch_cublas_gemm<float>(const CUDAContext& ctx, size_t nr1, size_t nc1, size_t nc2,
+[[maybe_unused]] void launch_cublas_gemm<float>(CUDAContext& ctx, size_t nr1, size_t nc1, size_t nc2,
         const float* alpha,    const float* beta, const float* d_lhs, const float* d_rhs, float* d_res) {
+    if(ctx.usesHalfPrecision()) {
+        CUDA::launchMixedPrecisionGemm(&ctx, CUBLAS_OP_N, CUBLAS_OP_N, nc2, nr1, nc1, d_rhs, nc2, d_lhs, nc1, d_res,
+                nc2);
+        return;
+    }
     CHECK_CUBLAS(cublasSgemm(ctx.getCublasHandle(), CUBLAS_OP_N, CUBLAS_OP_N, nc2, nr1, nc1, alpha, d_rhs, nc2, d_lhs,
             nc1, beta, d_res, nc2));
 }
 
 template<>
-[[maybe_unused]] void launch_cublas_gemm<double>(const CUDAContext& ctx, size_t nr1, size_t nc1, size_t nc2,
+[[maybe_unused]] void launch_cublas_gemm<double>(CUDAContext& ctx, size_t nr1, size_t nc1, size_t nc2,
         const double* alpha, const double* beta, const double* d_lhs, const double* d_rhs, double* d_res) {
     CHECK_CUBLAS(cublasDgemm(ctx.getCublasHandle(), CUBLAS_OP_N, CUBLAS_OP_N, nc2, nr1, nc1, alpha, d_rhs, nc2, d_lhs,
                              nc1, beta, d_res, nc2));
@@ -39,7 +45,7 @@ template<>
 namespace CUDA::Affine {
     template<typename DTRes, typename DTArg>
     void Forward<DTRes, DTArg>::apply(DTRes *&res, const DTArg *data, const DTArg *weights, const DTArg *bias, DCTX(dctx)) {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         using VT = typename DTRes::VT;
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AggAll.h"
+#include "CSRUtils.h"
+#include "agg_ops.cuh"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace CUDA {
+    // each block reduces a grid-strided part of the values into one accumulator
+    template<typename VT, class R>
+    __global__ void agg_all_partial(typename R::Acc *partials, const VT *arg, size_t numRows, size_t numCols,
+            size_t rowSkip, R r) {
+        const size_t N = numRows * numCols;
+        auto acc = r.init();
+        for(size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += gridDim.x * blockDim.x)
+            acc = r.add(acc, arg[rowSkip == numCols ? i : i / numCols * rowSkip + i % numCols], i);
+        acc = blockReduce(r, acc);
+        if(threadIdx.x == 0)
+            partials[blockIdx.x] = acc;
+    }
+
+    // a single block merges the accumulators of the blocks
+    template<typename VT, class R>
+    __global__ void agg_all_final(VT *res, const typename R::Acc *partials, size_t numPartials, R r) {
+        auto acc = r.init();
+        for(size_t p = threadIdx.x; p < numPartials; p += blockDim.x)
+            acc = r.merge(acc, partials[p]);
+        acc = blockReduce(r, acc);
+        if(threadIdx.x == 0)
+            *res = r.result(acc);
+    }
+
+    template<typename VT>
+    VT AggAll<DenseMatrix<VT>>::apply(AggOpCode opCode, const DenseMatrix<VT> *arg, DCTX(dctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+
+        constexpr size_t blockSize = 256;
+        const size_t maxGridSize = 4 * static_cast<size_t>(ctx->getDeviceProperties()->multiProcessorCount);
+        const size_t gridSize = std::max<size_t>(1, std::min((numRows * numCols + blockSize - 1) / blockSize,
+                maxGridSize));
+        const VT *valuesArg = arg->getValues(&alloc_desc);
+        auto d_res = ctx->allocate(sizeof(VT));
+        auto stream = CUDAContext::getComputeStream();
+        withAggReducer<VT>(opCode, false, [&](auto r) {
+            using Acc = typename decltype(r)::Acc;
+            auto partials = ctx->allocate(gridSize * sizeof(Acc));
+            agg_all_partial<<<gridSize, blockSize, 0, stream>>>(reinterpret_cast<Acc *>(partials.get()), valuesArg,
+                    numRows, numCols, arg->getRowSkip(), r);
+            agg_all_final<<<1, blockSize, 0, stream>>>(reinterpret_cast<VT *>(d_res.get()),
+                    reinterpret_cast<const Acc *>(partials.get()), gridSize, r);
+        });
+        // only the scalar is copied to the host
+        VT res;
+        CHECK_CUDART(cudaMemcpyAsync(&res, d_res.get(), sizeof(VT), cudaMemcpyDeviceToHost, stream));
+        CHECK_CUDART(cudaStreamSynchronize(stream));
+        return res;
+    }
+
+    template<typename VT>
+    void launch_cublas_dot(cublasHandle_t handle, int n, const VT *x, const VT *y, VT *res);
+
+    template<>
+    [[maybe_unused]] void launch_cublas_dot<float>(cublasHandle_t handle, int n, const float *x, const float *y,
+            float *res) {
+        CHECK_CUBLAS(cublasSdot(handle, n, x, 1, y, 1, res));
+    }
+
+    template<>
+    [[maybe_unused]] void launch_cublas_dot<double>(cublasHandle_t handle, int n, const double *x, const double *y,
+            double *res) {
+        CHECK_CUBLAS(cublasDdot(handle, n, x, 1, y, 1, res));
+    }
+
+    template<typename VT>
+    VT AggAll<CSRMatrix<VT>>::apply(AggOpCode opCode, const CSRMatrix<VT> *arg, DCTX(dctx)) {
+        if(opCode != AggOpCode::SUM)
+            throw std::runtime_error("AggAll(CUDA, CSR) - only SUM is supported");
+
+        const size_t numNonZeros = arg->getNumNonZeros();
+        if(numNonZeros > static_cast<size_t>(std::numeric_limits<int>::max()))
+            throw std::runtime_error("AggAll(CUDA, CSR) - cuBLAS supports less than 2^31 non-zeros");
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+
+        auto placement = arg->getPlacement(&alloc_desc);
+        auto ones = onesOnDevice<VT>(ctx, numNonZeros);
+        // the result is written to host memory, which synchronizes with the device
+        VT res = 0;
+        launch_cublas_dot<VT>(ctx->getCublasHandle(), static_cast<int>(numNonZeros), placement->getValues(),
+                reinterpret_cast<VT *>(ones.get()), &res);
+        return res;
+    }
+
+    template struct AggAll<DenseMatrix<double>>;
+    template struct AggAll<DenseMatrix<float>>;
+    template struct AggAll<DenseMatrix<int64_t>>;
+    template struct AggAll<CSRMatrix<double>>;
+    template struct AggAll<CSRMatrix<float>>;
+}
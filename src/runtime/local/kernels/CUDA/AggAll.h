@@ -0,0 +1,67 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/AggOpCode.h>
+
+namespace CUDA {
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+    template<class DTArg>
+    struct AggAll {
+        static typename DTArg::VT apply(AggOpCode opCode, const DTArg *arg, DCTX(ctx)) = delete;
+    };
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+    template<class DTArg>
+    typename DTArg::VT aggAll(AggOpCode opCode, const DTArg *arg, DCTX(ctx)) {
+        return AggAll<DTArg>::apply(opCode, arg, ctx);
+    }
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// scalar <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+    // a block-wise reduction with warp shuffles, whose partial results are merged on the device, too
+    template<typename VT>
+    struct AggAll<DenseMatrix<VT>> {
+        static VT apply(AggOpCode opCode, const DenseMatrix<VT> *arg, DCTX(ctx));
+    };
+
+// ----------------------------------------------------------------------------
+// scalar <- CSRMatrix
+// ----------------------------------------------------------------------------
+
+    // supports SUM only, as the dot product of the non-zeros with a vector of ones
+    template<typename VT>
+    struct AggAll<CSRMatrix<VT>> {
+        static VT apply(AggOpCode opCode, const CSRMatrix<VT> *arg, DCTX(ctx));
+    };
+}
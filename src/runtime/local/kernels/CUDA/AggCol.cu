@@ -15,78 +15,115 @@
  */
 
 #include "AggCol.h"
+#include "CSRUtils.h"
 #include "HostUtils.h"
+#include "agg_ops.cuh"
 
 #include <runtime/local/datastructures/AllocationDescriptorCUDA.h>
 
-#include "bin_ops.cuh"
+#include <algorithm>
 
 namespace CUDA {
 
-    template<class VT, class OP>
-    __global__ void agg_col(VT* res, const VT* arg, size_t N, size_t cols, OP op) {
-        auto tid = blockIdx.x * blockDim.x + threadIdx.x;
-
-        if (tid >= cols) {
-            return;
+    // the rows of a tile of AGG_COL_TILE_COLS columns are split between AGG_COL_TILE_ROWS threads per column and the
+    // blocks of the grid's y-dimension, each block stores the accumulators of its rows of the tile's columns
+    constexpr unsigned AGG_COL_TILE_COLS = WARP_SIZE;
+    constexpr unsigned AGG_COL_TILE_ROWS = 8;
+
+    template<typename VT, class R>
+    __global__ void agg_col_partial(typename R::Acc *partials, const VT *arg, size_t numRows, size_t numCols,
+            size_t rowSkip, R r) {
+        __shared__ typename R::Acc tile[AGG_COL_TILE_ROWS][AGG_COL_TILE_COLS];
+        const size_t col = blockIdx.x * AGG_COL_TILE_COLS + threadIdx.x;
+        auto acc = r.init();
+        if(col < numCols)
+            for(size_t row = blockIdx.y * AGG_COL_TILE_ROWS + threadIdx.y; row < numRows;
+                    row += gridDim.y * AGG_COL_TILE_ROWS)
+                acc = r.add(acc, arg[row * rowSkip + col], row);
+        tile[threadIdx.y][threadIdx.x] = acc;
+        __syncthreads();
+        if(threadIdx.y == 0 && col < numCols) {
+            for(unsigned y = 1; y < AGG_COL_TILE_ROWS; y++)
+                acc = r.merge(acc, tile[y][threadIdx.x]);
+            partials[blockIdx.y * numCols + col] = acc;
         }
+    }
 
-        auto i = tid;
-        auto grid_size = cols;
-        VT val = OP::init();
-
-        while (i < N) {
-            val = op.exec(val, arg[i]);
-            i += grid_size;
-        }
-        res[tid] = val;
+    // one thread per column merges the accumulators of the blocks
+    template<typename VT, class R>
+    __global__ void agg_col_final(VT *res, const typename R::Acc *partials, size_t numPartials, size_t numCols, R r) {
+        const size_t col = blockIdx.x * blockDim.x + threadIdx.x;
+        if(col >= numCols)
+            return;
+        auto acc = partials[col];
+        for(size_t p = 1; p < numPartials; p++)
+            acc = r.merge(acc, partials[p * numCols + col]);
+        res[col] = r.result(acc);
     }
 
     template<typename VT>
     void AggCol<DenseMatrix<VT>, DenseMatrix<VT>>::apply(AggOpCode opCode, DenseMatrix<VT> *&res,
             const DenseMatrix<VT> *arg, DCTX(dctx)) {
+        const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
         
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
-        
-        int blockSize;
-        int minGridSize; // The minimum grid size needed to achieve the maximum occupancy for a full device launch
-        size_t gridSize;
 
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, false,  &alloc_desc);
+        if(numCols == 0)
+            return;
 
-        auto N = arg->getNumItems();
+        // enough blocks for a few waves, the rows of tall matrices are split between the blocks of a tile
+        const size_t numTiles = (numCols + AGG_COL_TILE_COLS - 1) / AGG_COL_TILE_COLS;
+        const size_t targetBlocks = 4 * static_cast<size_t>(ctx->getDeviceProperties()->multiProcessorCount);
+        const size_t numRowBlocks = std::max<size_t>(1, std::min<size_t>({(targetBlocks + numTiles - 1) / numTiles,
+                (numRows + AGG_COL_TILE_ROWS - 1) / AGG_COL_TILE_ROWS, 65535}));
+        VT *valuesRes = res->getValues(&alloc_desc);
+        const VT *valuesArg = arg->getValues(&alloc_desc);
+        withAggReducer<VT>(opCode, true, [&](auto r) {
+            using Acc = typename decltype(r)::Acc;
+            auto partials = ctx->allocate(numRowBlocks * numCols * sizeof(Acc));
+            auto stream = CUDAContext::getComputeStream();
+            const dim3 grid(numTiles, numRowBlocks);
+            const dim3 block(AGG_COL_TILE_COLS, AGG_COL_TILE_ROWS);
+            agg_col_partial<<<grid, block, 0, stream>>>(reinterpret_cast<Acc *>(partials.get()), valuesArg, numRows,
+                    numCols, arg->getRowSkip(), r);
+            constexpr size_t blockSize = 256;
+            agg_col_final<<<(numCols + blockSize - 1) / blockSize, blockSize, 0, stream>>>(valuesRes,
+                    reinterpret_cast<const Acc *>(partials.get()), numRowBlocks, numCols, r);
+            // the partials return to the pool of the stream, which orders their reuse after the kernels
+        });
+    }
 
-        if (opCode == AggOpCode::SUM) {
-            SumOp<VT> op;
+    template<typename VT>
+    void AggCol<DenseMatrix<VT>, CSRMatrix<VT>>::apply(AggOpCode opCode, DenseMatrix<VT> *&res,
+            const CSRMatrix<VT> *arg, DCTX(dctx)) {
+        if(opCode != AggOpCode::SUM)
+            throw std::runtime_error("AggCol(CUDA, CSR) - only SUM is supported");
 
-            CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, agg_col<VT, SumOp<VT>>, 0, 0));
-            gridSize = (N + blockSize - 1) / blockSize;
-            agg_col<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), arg->getValues(&alloc_desc), N, numCols, op);
-        }
-        else if (opCode == AggOpCode::MAX) {
-            MaxOp<VT> op;
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
 
-            CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, agg_col<VT, MaxOp<VT>>, 0, 0));
-            gridSize = (N + blockSize - 1) / blockSize;
-            agg_col<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), arg->getValues(&alloc_desc), N, numCols, op);
-        }
-        else if (opCode == AggOpCode::MIN) {
-            MinOp<VT> op;
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(1, numCols, false, &alloc_desc);
 
-            CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, agg_col<VT, MinOp<VT>>, 0, 0));
-            gridSize = (N + blockSize - 1) / blockSize;
-            agg_col<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), arg->getValues(&alloc_desc), N, numCols, op);
-        }
-        else {
-            std::cerr << "opCode=" << static_cast<uint32_t>(opCode) << std::endl;
-            throw std::runtime_error("unknown operator for aggCol");
-        }
+        DeviceCSR<VT> d_arg(arg, &alloc_desc, ctx);
+        auto ones = onesOnDevice<VT>(ctx, numRows);
+        spMV<VT>(ctx, CUSPARSE_OPERATION_TRANSPOSE, d_arg, reinterpret_cast<VT *>(ones.get()), numRows,
+                res->getValues(&alloc_desc), numCols);
     }
+
     template struct AggCol<DenseMatrix<double>, DenseMatrix<double>>;
     template struct AggCol<DenseMatrix<float>, DenseMatrix<float>>;
     template struct AggCol<DenseMatrix<int64_t>, DenseMatrix<int64_t>>;
+    template struct AggCol<DenseMatrix<size_t>, DenseMatrix<size_t>>;
+    template struct AggCol<DenseMatrix<double>, CSRMatrix<double>>;
+    template struct AggCol<DenseMatrix<float>, CSRMatrix<float>>;
 }
 
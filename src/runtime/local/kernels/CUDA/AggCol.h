@@ -17,6 +17,7 @@
 #pragma once
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/AggOpCode.h>
@@ -49,8 +50,19 @@ namespace CUDA {
 // DenseMatrix <- DenseMatrix
 // ----------------------------------------------------------------------------
 
+    // a reduction of tiles of columns split between the blocks by rows, the result stays on the device
     template<typename VT>
     struct AggCol<DenseMatrix<VT>, DenseMatrix<VT>> {
         static void apply(AggOpCode opCode, DenseMatrix<VT> *&res, const DenseMatrix<VT> *arg, DCTX(ctx));
     };
-}
\ No newline at end of file
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CSRMatrix
+// ----------------------------------------------------------------------------
+
+    // supports SUM only, as a product of the transposed matrix with a vector of ones (cuSPARSE's SpMV)
+    template<typename VT>
+    struct AggCol<DenseMatrix<VT>, CSRMatrix<VT>> {
+        static void apply(AggOpCode opCode, DenseMatrix<VT> *&res, const CSRMatrix<VT> *arg, DCTX(ctx));
+    };
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AggRow.h"
+#include "CSRUtils.h"
+#include "agg_ops.cuh"
+
+#include <runtime/local/datastructures/AllocationDescriptorCUDA.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace CUDA {
+    // one warp per row, whose lanes stride over its columns
+    template<typename VT, class R>
+    __global__ void agg_row(VT *res, const VT *arg, size_t numRows, size_t numCols, size_t rowSkipArg,
+            size_t rowSkipRes, R r) {
+        const size_t lane = threadIdx.x % WARP_SIZE;
+        const size_t numWarps = gridDim.x * blockDim.x / WARP_SIZE;
+        for(size_t row = (blockIdx.x * blockDim.x + threadIdx.x) / WARP_SIZE; row < numRows; row += numWarps) {
+            const VT *values = arg + row * rowSkipArg;
+            auto acc = r.init();
+            for(size_t c = lane; c < numCols; c += WARP_SIZE)
+                acc = r.add(acc, values[c], c);
+            acc = warpReduce(r, acc);
+            if(lane == 0)
+                res[row * rowSkipRes] = r.result(acc);
+        }
+    }
+
+    template<typename VT>
+    void AggRow<DenseMatrix<VT>, DenseMatrix<VT>>::apply(AggOpCode opCode, DenseMatrix<VT> *&res,
+            const DenseMatrix<VT> *arg, DCTX(dctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false, &alloc_desc);
+        if(numRows == 0)
+            return;
+
+        constexpr size_t blockSize = 256;
+        constexpr size_t rowsPerBlock = blockSize / WARP_SIZE;
+        // the rows beyond a few waves of blocks are strided over
+        const size_t maxGridSize = 32 * static_cast<size_t>(ctx->getDeviceProperties()->multiProcessorCount);
+        const size_t gridSize = std::min((numRows + rowsPerBlock - 1) / rowsPerBlock, maxGridSize);
+        VT *valuesRes = res->getValues(&alloc_desc);
+        const VT *valuesArg = arg->getValues(&alloc_desc);
+        withAggReducer<VT>(opCode, true, [&](auto r) {
+            agg_row<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(valuesRes, valuesArg, numRows,
+                    numCols, arg->getRowSkip(), res->getRowSkip(), r);
+        });
+    }
+    template<typename VT>
+    void AggRow<DenseMatrix<VT>, CSRMatrix<VT>>::apply(AggOpCode opCode, DenseMatrix<VT> *&res,
+            const CSRMatrix<VT> *arg, DCTX(dctx)) {
+        if(opCode != AggOpCode::SUM)
+            throw std::runtime_error("AggRow(CUDA, CSR) - only SUM is supported");
+
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false, &alloc_desc);
+
+        DeviceCSR<VT> d_arg(arg, &alloc_desc, ctx);
+        auto ones = onesOnDevice<VT>(ctx, numCols);
+        spMV<VT>(ctx, CUSPARSE_OPERATION_NON_TRANSPOSE, d_arg, reinterpret_cast<VT *>(ones.get()), numCols,
+                res->getValues(&alloc_desc), numRows);
+    }
+
+    template struct AggRow<DenseMatrix<double>, DenseMatrix<double>>;
+    template struct AggRow<DenseMatrix<float>, DenseMatrix<float>>;
+    template struct AggRow<DenseMatrix<int64_t>, DenseMatrix<int64_t>>;
+    template struct AggRow<DenseMatrix<size_t>, DenseMatrix<size_t>>;
+    template struct AggRow<DenseMatrix<double>, CSRMatrix<double>>;
+    template struct AggRow<DenseMatrix<float>, CSRMatrix<float>>;
+}
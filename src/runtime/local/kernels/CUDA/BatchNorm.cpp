@@ -22,7 +22,7 @@ namespace CUDA::BatchNorm {
     void Forward<DTRes, DTArg>::apply(DTRes *&res, const DTArg *data, const DTArg *gamma, const DTArg *beta,
                                       const DTArg *ema_mean, const DTArg *ema_var, const typename DTArg::VT eps, DCTX(dctx))
     {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         using VT = typename DTRes::VT;
@@ -20,7 +20,7 @@
 namespace CUDA::BiasAdd {
     template<typename DTRes, typename DTArg>
     void Forward<DTRes, DTArg>::apply(DTRes *&res, const DTArg *data, const DTArg *bias, DCTX(dctx)) {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/CUDAContext.h>
+#include <runtime/local/datastructures/AllocationDescriptorCUDA.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/kernels/CUDA/HostUtils.h>
+
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+
+namespace CUDA {
+
+    /**
+     * @brief A `CSRMatrix` in the memory of a device, described for the generic API of cuSPARSE.
+     *
+     * The arrays are the placement of the matrix (see `CSRMatrix::getPlacement()`), which the matrix keeps until it
+     * is written, so a matrix is transferred once for any number of kernels. The indexes stay 64-bit.
+     */
+    template<typename VT>
+    struct DeviceCSR {
+        std::shared_ptr<const CSRPlacement<VT>> placement;
+        cusparseSpMatDescr_t descr{};
+
+        DeviceCSR(const CSRMatrix<VT> *mat, const AllocationDescriptorCUDA *alloc_desc, const CUDAContext *ctx) :
+                placement(mat->getPlacement(alloc_desc)) {
+            CHECK_CUSPARSE(cusparseCreateCsr(&descr, mat->getNumRows(), mat->getNumCols(), mat->getNumNonZeros(),
+                    const_cast<size_t *>(placement->getRowOffsets()), const_cast<size_t *>(placement->getColIdxs()),
+                    const_cast<VT *>(placement->getValues()), CUSPARSE_INDEX_64I, CUSPARSE_INDEX_64I,
+                    CUSPARSE_INDEX_BASE_ZERO, ctx->template getCUSparseDataType<VT>()));
+        }
+
+        DeviceCSR(const DeviceCSR &) = delete;
+        DeviceCSR &operator=(const DeviceCSR &) = delete;
+
+        ~DeviceCSR() {
+            cusparseDestroySpMat(descr);
+        }
+    };
+
+    /**
+     * @brief Computes `y = op(mat) * x` with cuSPARSE, where `x` and `y` are vectors in device memory.
+     */
+    template<typename VT>
+    void spMV(CUDAContext *ctx, cusparseOperation_t op, const DeviceCSR<VT> &mat, const VT *x, size_t lenX, VT *y,
+            size_t lenY) {
+        const VT alpha = 1;
+        const VT beta = 0;
+        const cudaDataType type = ctx->template getCUSparseDataType<VT>();
+        cusparseHandle_t handle = ctx->getCusparseHandle();
+
+        cusparseDnVecDescr_t vecX, vecY;
+        CHECK_CUSPARSE(cusparseCreateDnVec(&vecX, lenX, const_cast<VT *>(x), type));
+        CHECK_CUSPARSE(cusparseCreateDnVec(&vecY, lenY, y, type));
+
+        size_t bufferSize = 0;
+        CHECK_CUSPARSE(cusparseSpMV_bufferSize(handle, op, &alpha, mat.descr, vecX, &beta, vecY, type,
+                CUSPARSE_SPMV_ALG_DEFAULT, &bufferSize));
+        auto buffer = ctx->allocate(bufferSize);
+        CHECK_CUSPARSE(cusparseSpMV(handle, op, &alpha, mat.descr, vecX, &beta, vecY, type, CUSPARSE_SPMV_ALG_DEFAULT,
+                buffer.get()));
+
+        CHECK_CUSPARSE(cusparseDestroyDnVec(vecX));
+        CHECK_CUSPARSE(cusparseDestroyDnVec(vecY));
+    }
+
+    /**
+     * @brief Returns a temporary vector of `len` ones in device memory, e.g., to sum up the rows or columns of a
+     * sparse matrix by a product with it.
+     */
+    template<typename VT>
+    std::shared_ptr<std::byte> onesOnDevice(CUDAContext *ctx, size_t len) {
+        std::vector<VT> ones(len, VT(1));
+        auto res = ctx->allocate(len * sizeof(VT));
+        CHECK_CUDART(cudaMemcpy(res.get(), ones.data(), len * sizeof(VT), cudaMemcpyHostToDevice));
+        return res;
+    }
+}
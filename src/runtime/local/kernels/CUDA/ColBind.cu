@@ -49,7 +49,7 @@ namespace CUDA {
     template<typename VTres, typename VTlhs, typename VTrhs>
     void ColBind<DenseMatrix<VTres>, DenseMatrix<VTlhs>, DenseMatrix<VTrhs>>::apply(DenseMatrix<VTres> *& res,
             const DenseMatrix<VTlhs> * lhs, const DenseMatrix<VTrhs> * rhs, DCTX(dctx)) {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
 
         const size_t numRowsLhs = lhs->getNumRows();
@@ -73,7 +73,7 @@ namespace CUDA {
                 " total threads for " << N << " items" << std::endl;
 #endif
 
-        cbind<<<gridSize, blockSize>>>(lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc), res->getValues(&alloc_desc),
+        cbind<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc), res->getValues(&alloc_desc),
                 numRowsLhs, numColsLhs, numRowsRhs, numColsRhs);
     }
     template struct ColBind<DenseMatrix<int64_t>, DenseMatrix<int64_t>, DenseMatrix<int64_t>>;
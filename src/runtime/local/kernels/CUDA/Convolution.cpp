@@ -23,7 +23,7 @@ namespace CUDA::Convolution {
             const size_t batch_size, const size_t num_channels, const size_t img_h, const size_t img_w, const size_t filter_h,
             const size_t filter_w, const size_t stride_h, const size_t stride_w, const size_t pad_h, const size_t pad_w, DCTX(dctx))
     {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         
@@ -51,13 +51,11 @@ namespace CUDA::Convolution {
         int upscaleA[convDims] = {1,1};
         cudnnDataType_t convDataType = ctx->template getCUDNNDataType<VT>();
 
-        // ToDo: Math are done in FP32 when tensor are in FP16.
-//        if (ctx->data_type == CUDNN_DATA_HALF) {
-//            convDataType = CUDNN_DATA_FLOAT;
-//        }
-
+        // the math type of cuDNN rounds FP32 tensors to TF32/FP16 internally (accumulating in FP32) per the precision
+        // of the context, the data stays in FP32
         CHECK_CUDNN(cudnnSetConvolutionNdDescriptor(ctx->conv_desc, convDims, padA, filterStrideA, upscaleA,
                 CUDNN_CROSS_CORRELATION, convDataType));
+        CHECK_CUDNN(cudnnSetConvolutionMathType(ctx->conv_desc, ctx->getConvMathType()));
 
         CHECK_CUDNN(cudnnGetConvolutionNdForwardOutputDim(ctx->conv_desc, ctx->src_tensor_desc, ctx->filter_desc,
                 tensorDims, tensorOuputDimA));
@@ -24,8 +24,31 @@
 // ****************************************************************************
 
 namespace CUDA {
+    /**
+     * @brief Creates one CUDA context per device listed in the user config (`cuda_devices`), or per visible device if
+     * none are listed, and enables peer access between them where supported. The first device stays the current one
+     * of the calling thread. The contexts use the precision (`cuda_precision`, `cuda_loss_scale`) of the user config.
+     */
     static void createCUDAContext(DCTX(ctx)) {
-        // ToDo: one context per device
-        ctx->cuda_contexts.emplace_back(CUDAContext::createCudaContext(0));
+        const auto& config = ctx->getUserConfig();
+        const CUDAPrecision precision = CUDAContext::precisionFromString(config.cuda_precision);
+        std::vector<int> devices = config.cuda_devices;
+        if(devices.empty()) {
+            int device_count = 0;
+            CHECK_CUDART(cudaGetDeviceCount(&device_count));
+            for(int i = 0; i < device_count; i++)
+                devices.push_back(i);
+        }
+        for(auto device : devices)
+            if(auto cuda_ctx = CUDAContext::createCudaContext(device, precision, config.cuda_loss_scale))
+                ctx->cuda_contexts.emplace_back(std::move(cuda_ctx));
+
+        const size_t num_devices = ctx->cuda_contexts.size();
+        for(size_t i = 0; i < num_devices; i++)
+            for(size_t j = 0; j < num_devices; j++)
+                if(i != j)
+                    CUDAContext::get(ctx, i)->enablePeerAccess(CUDAContext::get(ctx, j));
+        if(num_devices)
+            CUDAContext::setCurrentDevice(ctx, 0);
     }
 }
\ No newline at end of file
@@ -20,6 +20,8 @@
 #include "runtime/local/kernels/CUDA/bin_ops.cuh"
 #include <cstdint>
 
+#include <cub/cub.cuh>
+
 namespace CUDA {
     template<class VT, class OP>
     __global__ void ewBinMat(VT *res, const VT *lhs, const VT *rhs, size_t N, OP op) {
@@ -81,13 +83,41 @@ namespace CUDA {
         CHECK_CUBLAS(cublasSaxpy(handle, n, alpha, x, incx, y, incy));
     }
 
+    // launches the element-wise kernel of op on lhs and rhs of the same shape or rhs broadcast as a row or column
+    // vector, returns false for other shapes
+    template<typename VT, class OP>
+    static bool launchEwBinMat(VT *res, const VT *lhs, const VT *rhs, size_t numRowsLhs, size_t numColsLhs,
+            size_t numRowsRhs, size_t numColsRhs, OP op, int &blockSize, size_t &gridSize) {
+        int minGridSize;
+        const size_t N = numRowsLhs * numColsLhs;
+        auto stream = CUDAContext::getComputeStream();
+        if(numRowsLhs == numRowsRhs && numColsLhs == numColsRhs) {
+            CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMat<VT, OP>, 0, 0));
+            gridSize = (N + blockSize - 1) / blockSize;
+            ewBinMat<<<gridSize, blockSize, 0, stream>>>(res, lhs, rhs, N, op);
+        }
+        else if(numColsLhs == numColsRhs && numRowsRhs == 1) {
+            CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMatRVec<VT, OP>, 0, 0));
+            gridSize = (N + blockSize - 1) / blockSize;
+            ewBinMatRVec<<<gridSize, blockSize, 0, stream>>>(res, lhs, rhs, numColsRhs, N, op);
+        }
+        else if(numRowsLhs == numRowsRhs && numColsRhs == 1) {
+            CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMatCVec<VT, OP>, 0, 0));
+            gridSize = (N + blockSize - 1) / blockSize;
+            ewBinMatCVec<<<gridSize, blockSize, 0, stream>>>(res, lhs, rhs, numColsLhs, N, op);
+        }
+        else
+            return false;
+        return true;
+    }
+
 // ----------------------------------------------------------------------------
 // DenseMatrix <- DenseMatrix, DenseMatrix
 // ----------------------------------------------------------------------------
     template<typename VTres, typename VTlhs, typename VTrhs>
     void EwBinaryMat<DenseMatrix<VTres>, DenseMatrix<VTlhs>, DenseMatrix<VTrhs>>::apply(BinaryOpCode opCode,
             DenseMatrix<VTres> *&res, const DenseMatrix<VTlhs> *lhs, const DenseMatrix<VTrhs> *rhs, DCTX(dctx)) {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
 
@@ -115,7 +145,7 @@ namespace CUDA {
                         cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMat<VTres, SumOp<VTres>>, 0,
                                                            0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMat<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc), N,
+                ewBinMat<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc), N,
                                                   op);
             }
             else if(numColsLhs == numColsRhs && (numRowsRhs == 1 || numRowsLhs == 1)) {
@@ -124,7 +154,7 @@ namespace CUDA {
                                                            0,
                                                            0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMatRVec<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
+                ewBinMatRVec<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
                                                       numColsRhs, N, op);
             }
             else if(numRowsLhs == numRowsRhs && (numColsRhs == 1 || numColsLhs == 1)) {
@@ -133,7 +163,7 @@ namespace CUDA {
                                                            0,
                                                            0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMatCVec<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
+                ewBinMatCVec<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
                                                       numRowsRhs, N, op);
             }
             else {
@@ -147,7 +177,7 @@ namespace CUDA {
                         cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMat<VTres, decltype(op)>, 0,
                                                            0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMat<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc), N,
+                ewBinMat<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc), N,
                                                   op);
             }
             else if(numColsLhs == numColsRhs && (numRowsRhs == 1 || numRowsLhs == 1)) {
@@ -156,7 +186,7 @@ namespace CUDA {
                                                            0,
                                                            0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMatRVec<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
+                ewBinMatRVec<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
                                                       numColsRhs, N, op);
             }
             else if(numRowsLhs == numRowsRhs && (numColsRhs == 1 || numColsLhs == 1)) {
@@ -165,7 +195,7 @@ namespace CUDA {
                                                            0,
                                                            0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMatCVec<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
+                ewBinMatCVec<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
                                                       numRowsRhs, N, op);
             }
             else {
@@ -178,7 +208,7 @@ namespace CUDA {
                 CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMat<VTres, decltype(op)>,
                                                                 0, 0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMat<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc),
+                ewBinMat<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc),
                                                   rhs->getValues(&alloc_desc), N, op);
             }
             else if(numColsLhs == numColsRhs && (numRowsRhs == 1 || numRowsLhs == 1)) {
@@ -186,7 +216,7 @@ namespace CUDA {
                         decltype(op)>, 0, 0));
                 gridSize = (N + blockSize - 1) / blockSize;
 
-                ewBinMatRVec<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc),
+                ewBinMatRVec<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc),
                                                       rhs->getValues(&alloc_desc), numColsRhs, N, op);
             }
             else if(numRowsLhs == numRowsRhs && (numColsRhs == 1 || numColsLhs == 1)) {
@@ -194,13 +224,21 @@ namespace CUDA {
                         cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMatCVec<VTres, decltype(op)>,
                                                            0, 0));
                 gridSize = (N + blockSize - 1) / blockSize;
-                ewBinMatRVec<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc),
+                ewBinMatRVec<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc),
                                                       rhs->getValues(&alloc_desc), numColsRhs, N, op);
             }
             else {
                 err = true;
             }
         }
+        else if(opCode == BinaryOpCode::MIN) {
+            err = !launchEwBinMat(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
+                    numRowsLhs, numColsLhs, numRowsRhs, numColsRhs, MinOp<VTres>(), blockSize, gridSize);
+        }
+        else if(opCode == BinaryOpCode::MAX) {
+            err = !launchEwBinMat(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs->getValues(&alloc_desc),
+                    numRowsLhs, numColsLhs, numRowsRhs, numColsRhs, MaxOp<VTres>(), blockSize, gridSize);
+        }
         else {
             std::cerr << "opCode=" << static_cast<uint32_t>(opCode) << std::endl;
             throw std::runtime_error("unknown operator for EwBinaryMat");
@@ -219,7 +257,113 @@ namespace CUDA {
 #endif
     }
 
+// ----------------------------------------------------------------------------
+// CSRMatrix <- CSRMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+    // the cell of rhs (broadcast if it is a row/column vector) multiplied by the non-zero at pos in row r of lhs
+    template<class VT>
+    __device__ VT ewMulCSRDense(const VT *lhsValues, const size_t *lhsColIdxs, size_t pos, size_t r, const VT *rhs,
+            size_t rhsRows, size_t rhsCols) {
+        const size_t rhsRow = rhsRows == 1 ? 0 : r;
+        const size_t rhsCol = rhsCols == 1 ? 0 : lhsColIdxs[pos];
+        return lhsValues[pos] * rhs[rhsRow * rhsCols + rhsCol];
+    }
+
+    // one thread per row counts the non-zero products
+    template<class VT>
+    __global__ void ewMulCSRDenseCount(size_t *resNumNonZeros, const VT *lhsValues, const size_t *lhsColIdxs,
+            const size_t *lhsRowOffsets, const VT *rhs, size_t rhsRows, size_t rhsCols, size_t numRows) {
+        const size_t r = blockIdx.x * blockDim.x + threadIdx.x;
+        if(r >= numRows)
+            return;
+        size_t count = 0;
+        for(size_t pos = lhsRowOffsets[r]; pos < lhsRowOffsets[r + 1]; pos++)
+            if(ewMulCSRDense(lhsValues, lhsColIdxs, pos, r, rhs, rhsRows, rhsCols) != VT(0))
+                count++;
+        resNumNonZeros[r] = count;
+    }
+
+    // one thread per row writes the non-zero products at the row offsets scanned from the counts
+    template<class VT>
+    __global__ void ewMulCSRDenseWrite(VT *resValues, size_t *resColIdxs, const size_t *resRowOffsets,
+            const VT *lhsValues, const size_t *lhsColIdxs, const size_t *lhsRowOffsets, const VT *rhs, size_t rhsRows,
+            size_t rhsCols, size_t numRows) {
+        const size_t r = blockIdx.x * blockDim.x + threadIdx.x;
+        if(r >= numRows)
+            return;
+        size_t posRes = resRowOffsets[r];
+        for(size_t pos = lhsRowOffsets[r]; pos < lhsRowOffsets[r + 1]; pos++) {
+            const VT val = ewMulCSRDense(lhsValues, lhsColIdxs, pos, r, rhs, rhsRows, rhsCols);
+            if(val != VT(0)) {
+                resValues[posRes] = val;
+                resColIdxs[posRes] = lhsColIdxs[pos];
+                posRes++;
+            }
+        }
+    }
+
+    template<typename VT>
+    void EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>>::apply(BinaryOpCode opCode, CSRMatrix<VT> *&res,
+            const CSRMatrix<VT> *lhs, const DenseMatrix<VT> *rhs, DCTX(dctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+        const size_t rhsRows = rhs->getNumRows();
+        const size_t rhsCols = rhs->getNumCols();
+        if((numRows != rhsRows && rhsRows != 1) || (numCols != rhsCols && rhsCols != 1))
+            throw std::runtime_error("EwBinaryMat(CUDA, CSR) - lhs and rhs must have the same dimensions (or "
+                    "broadcast)");
+        if(opCode != BinaryOpCode::MUL)
+            throw std::runtime_error("EwBinaryMat(CUDA, CSR) - only MUL is supported");
+
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+
+        auto placement = lhs->getPlacement(&alloc_desc);
+        const VT *d_rhs = rhs->getValues(&alloc_desc);
+
+        int blockSize;
+        int minGridSize; // The minimum grid size needed to achieve the maximum occupancy for a full device launch
+        CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewMulCSRDenseWrite<VT>, 0, 0));
+        const size_t gridSize = (numRows + blockSize - 1) / blockSize;
+
+        // the counts of the rows, followed by a zero, become the row offsets of the result by an exclusive scan
+        auto counts = ctx->allocate((numRows + 1) * sizeof(size_t));
+        auto rowOffsets = ctx->allocate((numRows + 1) * sizeof(size_t));
+        auto d_counts = reinterpret_cast<size_t *>(counts.get());
+        auto d_rowOffsets = reinterpret_cast<size_t *>(rowOffsets.get());
+        CHECK_CUDART(cudaMemset(d_counts + numRows, 0, sizeof(size_t)));
+        if(numRows)
+            ewMulCSRDenseCount<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(d_counts, placement->getValues(), placement->getColIdxs(),
+                    placement->getRowOffsets(), d_rhs, rhsRows, rhsCols, numRows);
+        size_t scanSize = 0;
+        CHECK_CUDART(cub::DeviceScan::ExclusiveSum(nullptr, scanSize, d_counts, d_rowOffsets, numRows + 1));
+        auto scanBuffer = ctx->allocate(scanSize);
+        CHECK_CUDART(cub::DeviceScan::ExclusiveSum(scanBuffer.get(), scanSize, d_counts, d_rowOffsets,
+                numRows + 1));
+
+        size_t numNonZeros;
+        CHECK_CUDART(cudaMemcpy(&numNonZeros, d_rowOffsets + numRows, sizeof(size_t), cudaMemcpyDeviceToHost));
+        auto values = ctx->allocate(numNonZeros * sizeof(VT));
+        auto colIdxs = ctx->allocate(numNonZeros * sizeof(size_t));
+        if(numRows)
+            ewMulCSRDenseWrite<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(reinterpret_cast<VT *>(values.get()),
+                    reinterpret_cast<size_t *>(colIdxs.get()), d_rowOffsets, placement->getValues(),
+                    placement->getColIdxs(), placement->getRowOffsets(), d_rhs, rhsRows, rhsCols, numRows);
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, numNonZeros, false);
+        CHECK_CUDART(cudaMemcpy(res->getRowOffsets(), d_rowOffsets, (numRows + 1) * sizeof(size_t),
+                cudaMemcpyDeviceToHost));
+        CHECK_CUDART(cudaMemcpy(res->getColIdxs(), colIdxs.get(), numNonZeros * sizeof(size_t),
+                cudaMemcpyDeviceToHost));
+        CHECK_CUDART(cudaMemcpy(res->getValues(), values.get(), numNonZeros * sizeof(VT), cudaMemcpyDeviceToHost));
+    }
+
     template struct EwBinaryMat<DenseMatrix<long>, DenseMatrix<long>, DenseMatrix<long>>;
     template struct EwBinaryMat<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>>;
     template struct EwBinaryMat<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>>;
+    template struct EwBinaryMat<CSRMatrix<float>, CSRMatrix<float>, DenseMatrix<float>>;
+    template struct EwBinaryMat<CSRMatrix<double>, CSRMatrix<double>, DenseMatrix<double>>;
 }
\ No newline at end of file
@@ -40,6 +40,14 @@ namespace CUDA {
                           const DenseMatrix<VTrhs> *rhs, DCTX(ctx));
     };
 
+    // supports MUL only (like the CPU kernel); rhs may be a row/column vector, and the result is returned in main
+    // memory, without the products that are zero
+    template<typename VT>
+    struct EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>> {
+        static void apply(BinaryOpCode opCode, CSRMatrix<VT> *&res, const CSRMatrix<VT> *lhs,
+                          const DenseMatrix<VT> *rhs, DCTX(ctx));
+    };
+
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
@@ -34,7 +34,7 @@ namespace CUDA {
         const size_t numRows = lhs->getNumRows();
         const size_t numCols = lhs->getNumCols();
     
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         
         int blockSize;
@@ -51,25 +51,25 @@ namespace CUDA {
             SumOp<VT> op;
             CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMatSca<VT, SumOp<VT>>, 0, 0));
             gridSize = (N + blockSize - 1) / blockSize;
-            ewBinMatSca<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
+            ewBinMatSca<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
         }
         else if (opCode == BinaryOpCode::DIV) {
             DivOp<VT> op;
             CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMatSca<VT, decltype(op)>, 0, 0));
             gridSize = (N + blockSize - 1) / blockSize;
-            ewBinMatSca<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
+            ewBinMatSca<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
         }
         else if (opCode == BinaryOpCode::POW) {
             PowOp<VT> op;
             CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMatSca<VT, decltype(op)>, 0, 0));
             gridSize = (N + blockSize - 1) / blockSize;
-            ewBinMatSca<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
+            ewBinMatSca<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
         }
         else if (opCode == BinaryOpCode::SUB) {
             MinusOp<VT> op;
             CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, ewBinMatSca<VT, decltype(op)>, 0, 0));
             gridSize = (N + blockSize - 1) / blockSize;
-            ewBinMatSca<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
+            ewBinMatSca<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), lhs->getValues(&alloc_desc), rhs, N, op);
         }
 
         else {
@@ -0,0 +1,334 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EwFused.h"
+#include "HostUtils.h"
+#include "runtime/local/datastructures/AllocationDescriptorCUDA.h"
+#include "runtime/local/kernels/EwFused.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace CUDA {
+    // the threads of a block (also the size of the shared memory of the block reductions)
+    constexpr unsigned EWFUSED_BLOCK_SIZE = 256;
+
+    // How an argument is broadcast to the shape of the result: a full matrix, a row vector, a column vector, or a
+    // single value.
+    enum class EwFusedBroadcast : char { FULL = 'm', ROW = 'r', COL = 'c', SINGLE = 's' };
+
+    // the exact value of a constant, also if it is not finite
+    static std::string ewFusedConstant(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        std::ostringstream os;
+        os << "((T)__longlong_as_double(0x" << std::hex << bits << "LL))";
+        return os.str();
+    }
+
+    static std::string ewFusedOperand(const EwFusedOperand &o) {
+        switch(o.kind) {
+            case EwFusedOperand::Kind::ARG: return "x" + std::to_string(o.idx);
+            case EwFusedOperand::Kind::REG: return "r" + std::to_string(o.idx);
+            default: return ewFusedConstant(o.value);
+        }
+    }
+
+    // the expression of an operation, with the semantics of EwBinarySca/EwUnarySca
+    static std::string ewFusedExpr(const EwFusedInstr &instr) {
+        const std::string l = ewFusedOperand(instr.lhs);
+        if(instr.isUnary) {
+            switch(instr.unaryOp) {
+                case UnaryOpCode::SIGN:
+                    return "(" + l + " == 0 ? (T)0 : (" + l + " < 0 ? (T)-1 : (" + l + " > 0 ? (T)1 : " + l + ")))";
+                case UnaryOpCode::SQRT: return "sqrt(" + l + ")";
+                case UnaryOpCode::EXP: return "exp(" + l + ")";
+                case UnaryOpCode::LN: return "log(" + l + ")";
+                case UnaryOpCode::ABS: return "fabs(" + l + ")";
+                case UnaryOpCode::FLOOR: return "floor(" + l + ")";
+                case UnaryOpCode::CEIL: return "ceil(" + l + ")";
+                case UnaryOpCode::ROUND: return "round(" + l + ")";
+                default: break;
+            }
+        }
+        else {
+            const std::string r = ewFusedOperand(instr.rhs);
+            switch(instr.binaryOp) {
+                case BinaryOpCode::ADD: return "(" + l + " + " + r + ")";
+                case BinaryOpCode::SUB: return "(" + l + " - " + r + ")";
+                case BinaryOpCode::MUL: return "(" + l + " * " + r + ")";
+                case BinaryOpCode::DIV: return "(" + l + " / " + r + ")";
+                case BinaryOpCode::POW: return "pow(" + l + ", " + r + ")";
+                case BinaryOpCode::MOD: return "fmod(" + l + ", " + r + ")";
+                case BinaryOpCode::LOG: return "(log(" + l + ") / log(" + r + "))";
+                case BinaryOpCode::EQ: return "(T)(" + l + " == " + r + ")";
+                case BinaryOpCode::NEQ: return "(T)(" + l + " != " + r + ")";
+                case BinaryOpCode::LT: return "(T)(" + l + " < " + r + ")";
+                case BinaryOpCode::LE: return "(T)(" + l + " <= " + r + ")";
+                case BinaryOpCode::GT: return "(T)(" + l + " > " + r + ")";
+                case BinaryOpCode::GE: return "(T)(" + l + " >= " + r + ")";
+                case BinaryOpCode::MIN: return "(" + r + " < " + l + " ? " + r + " : " + l + ")";
+                case BinaryOpCode::MAX: return "(" + l + " < " + r + " ? " + r + " : " + l + ")";
+                case BinaryOpCode::AND: return "(T)(" + l + " && " + r + ")";
+                case BinaryOpCode::OR: return "(T)(" + l + " || " + r + ")";
+                default: break;
+            }
+        }
+        throw std::runtime_error("CUDA::ewFused: unsupported operation");
+    }
+
+    /**
+     * @brief Generates the CUDA source of a program: `eval()` computes the result of the program for one cell, and
+     * `ewfused()` writes it to each cell of the result or aggregates it (`ALL` into one partial aggregate per block,
+     * which `ewfused_final()` aggregates).
+     *
+     * The operations are evaluated eagerly: per cell, a short-circuited `and`/`or` would only diverge the warps.
+     */
+    static std::string ewFusedSource(const EwFusedProgram &prog, const char *typeName,
+            const std::vector<EwFusedBroadcast> &broadcasts) {
+        using Agg = EwFusedProgram::Agg;
+        std::ostringstream params, names, os;
+        for(size_t i = 0; i < broadcasts.size(); i++) {
+            params << ", const T* __restrict__ a" << i << ", ull s" << i;
+            names << ", a" << i << ", s" << i;
+        }
+
+        os << "typedef " << typeName << " T;\n"
+           << "typedef unsigned long long ull;\n\n"
+           << "__device__ __forceinline__ T eval(ull r, ull c" << params.str() << ") {\n";
+        for(size_t i = 0; i < broadcasts.size(); i++) {
+            os << "    const T x" << i << " = a" << i;
+            switch(broadcasts[i]) {
+                case EwFusedBroadcast::FULL: os << "[r * s" << i << " + c];\n"; break;
+                case EwFusedBroadcast::ROW: os << "[c];\n"; break;
+                case EwFusedBroadcast::COL: os << "[r * s" << i << "];\n"; break;
+                case EwFusedBroadcast::SINGLE: os << "[0];\n"; break;
+            }
+        }
+        for(size_t k = 0; k < prog.instrs.size(); k++)
+            os << "    const T r" << k << " = " << ewFusedExpr(prog.instrs[k]) << ";\n";
+        os << "    return r" << prog.instrs.size() - 1 << ";\n}\n\n";
+
+        const std::string signature = "(T* __restrict__ res, ull resSkip, ull numRows, ull numCols" + params.str() + ")";
+        const std::string call = "eval(r, c" + names.str() + ")";
+        const std::string gridStride = "for(ull i = blockIdx.x * (ull)blockDim.x + threadIdx.x; i < n; "
+                "i += (ull)gridDim.x * blockDim.x)";
+        if(prog.agg == Agg::NONE) {
+            os << "extern \"C\" __global__ void ewfused" << signature << " {\n"
+               << "    const ull n = numRows * numCols;\n"
+               << "    " << gridStride << " {\n"
+               << "        const ull r = i / numCols;\n"
+               << "        const ull c = i % numCols;\n"
+               << "        res[r * resSkip + c] = " << call << ";\n"
+               << "    }\n}\n";
+            return os.str();
+        }
+
+        std::string combine, identity;
+        switch(prog.aggOp) {
+            case BinaryOpCode::ADD: combine = "acc + v"; identity = "(T)0"; break;
+            case BinaryOpCode::MIN: combine = "v < acc ? v : acc"; identity = ewFusedConstant(INFINITY); break;
+            case BinaryOpCode::MAX: combine = "acc < v ? v : acc"; identity = ewFusedConstant(-INFINITY); break;
+            default: throw std::runtime_error("CUDA::ewFused: unsupported aggregation");
+        }
+        os << "__device__ __forceinline__ T agg(T acc, T v) { return " << combine << "; }\n\n"
+           << "__device__ T blockReduce(T v) {\n"
+           << "    __shared__ T buf[" << EWFUSED_BLOCK_SIZE << "];\n"
+           << "    buf[threadIdx.x] = v;\n"
+           << "    __syncthreads();\n"
+           << "    for(unsigned s = blockDim.x / 2; s > 0; s >>= 1) {\n"
+           << "        if(threadIdx.x < s)\n"
+           << "            buf[threadIdx.x] = agg(buf[threadIdx.x], buf[threadIdx.x + s]);\n"
+           << "        __syncthreads();\n"
+           << "    }\n"
+           << "    const T out = buf[0];\n"
+           << "    __syncthreads();\n"
+           << "    return out;\n"
+           << "}\n\n"
+           << "extern \"C\" __global__ void ewfused" << signature << " {\n";
+        switch(prog.agg) {
+            case Agg::ROW:
+                // a block per row
+                os << "    for(ull r = blockIdx.x; r < numRows; r += gridDim.x) {\n"
+                   << "        T acc = " << identity << ";\n"
+                   << "        for(ull c = threadIdx.x; c < numCols; c += blockDim.x)\n"
+                   << "            acc = agg(acc, " << call << ");\n"
+                   << "        acc = blockReduce(acc);\n"
+                   << "        if(threadIdx.x == 0)\n"
+                   << "            res[r * resSkip] = acc;\n"
+                   << "    }\n}\n";
+                break;
+            case Agg::COL:
+                // a thread per column, whose loads are coalesced across the threads of a warp
+                os << "    const ull n = numCols;\n"
+                   << "    " << gridStride << " {\n"
+                   << "        const ull c = i;\n"
+                   << "        T acc = " << identity << ";\n"
+                   << "        for(ull r = 0; r < numRows; r++)\n"
+                   << "            acc = agg(acc, " << call << ");\n"
+                   << "        res[c] = acc;\n"
+                   << "    }\n}\n";
+                break;
+            default:
+                // res holds a partial aggregate per block
+                os << "    const ull n = numRows * numCols;\n"
+                   << "    T acc = " << identity << ";\n"
+                   << "    " << gridStride << " {\n"
+                   << "        const ull r = i / numCols;\n"
+                   << "        const ull c = i % numCols;\n"
+                   << "        acc = agg(acc, " << call << ");\n"
+                   << "    }\n"
+                   << "    acc = blockReduce(acc);\n"
+                   << "    if(threadIdx.x == 0)\n"
+                   << "        res[blockIdx.x] = acc;\n"
+                   << "}\n\n"
+                   << "extern \"C\" __global__ void ewfused_final(T* __restrict__ res, const T* __restrict__ partials, "
+                      "ull n) {\n"
+                   << "    T acc = " << identity << ";\n"
+                   << "    for(ull i = threadIdx.x; i < n; i += blockDim.x)\n"
+                   << "        acc = agg(acc, partials[i]);\n"
+                   << "    acc = blockReduce(acc);\n"
+                   << "    if(threadIdx.x == 0)\n"
+                   << "        res[0] = acc;\n"
+                   << "}\n";
+                break;
+        }
+        return os.str();
+    }
+
+    static void ewFusedLaunch(CUfunction func, size_t gridSize, void **params) {
+        if(cuLaunchKernel(func, gridSize, 1, 1, EWFUSED_BLOCK_SIZE, 1, 1, 0,
+                CUDAContext::getComputeStream(), params, nullptr) != CUDA_SUCCESS)
+            throw std::runtime_error("CUDA::ewFused: failed to launch the generated kernel");
+    }
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+    template<typename VT>
+    void EwFused<DenseMatrix<VT>, DenseMatrix<VT>>::apply(DenseMatrix<VT> *&res, const char *program,
+            const DenseMatrix<VT> **args, size_t numArgs, DCTX(dctx)) {
+        using Agg = EwFusedProgram::Agg;
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+        const EwFusedProgram prog = EwFusedProgram::parse(program, numArgs);
+
+        size_t numRows = 0;
+        size_t numCols = 0;
+        for(size_t i = 0; i < numArgs; i++) {
+            numRows = std::max(numRows, args[i]->getNumRows());
+            numCols = std::max(numCols, args[i]->getNumCols());
+        }
+        std::vector<EwFusedBroadcast> broadcasts(numArgs);
+        for(size_t i = 0; i < numArgs; i++) {
+            const size_t r = args[i]->getNumRows();
+            const size_t c = args[i]->getNumCols();
+            if((r != numRows && r != 1) || (c != numCols && c != 1))
+                throw std::runtime_error("CUDA::ewFused: the arguments cannot be broadcast to the same shape");
+            if(r == numRows && c == numCols)
+                broadcasts[i] = EwFusedBroadcast::FULL;
+            else if(c == numCols)
+                broadcasts[i] = EwFusedBroadcast::ROW;
+            else if(r == numRows)
+                broadcasts[i] = EwFusedBroadcast::COL;
+            else
+                broadcasts[i] = EwFusedBroadcast::SINGLE;
+        }
+
+        const size_t numRowsRes = prog.agg == Agg::NONE || prog.agg == Agg::ROW ? numRows : 1;
+        const size_t numColsRes = prog.agg == Agg::NONE || prog.agg == Agg::COL ? numCols : 1;
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsRes, numColsRes, false, &alloc_desc);
+        VT *valuesRes = res->getValues(&alloc_desc);
+        if(numRows == 0 || numCols == 0) {
+            // the aggregates of no values
+            CHECK_CUDART(cudaMemsetAsync(valuesRes, 0, res->getNumRows() * res->getRowSkip() * sizeof(VT),
+                    CUDAContext::getComputeStream()));
+            return;
+        }
+
+        const char *typeName = std::is_same<VT, double>::value ? "double" : "float";
+        std::string signature = std::string("ewFused;") + typeName + ";";
+        for(EwFusedBroadcast b : broadcasts)
+            signature += static_cast<char>(b);
+        signature += ";" + std::string(program);
+        CUmodule module = ctx->getGeneratedModule(signature, [&]() {
+            return ewFusedSource(prog, typeName, broadcasts);
+        });
+        CUfunction func;
+        if(cuModuleGetFunction(&func, module, "ewfused") != CUDA_SUCCESS)
+            throw std::runtime_error("CUDA::ewFused: the generated module has no kernel");
+
+        // the kernel parameters: the result, its row skip, the shape, and each argument with its row skip
+        VT *out = valuesRes;
+        unsigned long long outSkip = res->getRowSkip();
+        unsigned long long nr = numRows;
+        unsigned long long nc = numCols;
+        std::vector<const VT *> ptrs(numArgs);
+        std::vector<unsigned long long> skips(numArgs);
+        std::vector<void *> params = {&out, &outSkip, &nr, &nc};
+        for(size_t i = 0; i < numArgs; i++) {
+            ptrs[i] = args[i]->getValues(&alloc_desc);
+            skips[i] = args[i]->getRowSkip();
+            params.push_back(&ptrs[i]);
+            params.push_back(&skips[i]);
+        }
+
+        const size_t maxBlocks = static_cast<size_t>(ctx->getDeviceProperties()->multiProcessorCount) * 32;
+        const size_t cellBlocks = (numRows * numCols + EWFUSED_BLOCK_SIZE - 1) / EWFUSED_BLOCK_SIZE;
+        switch(prog.agg) {
+            case Agg::NONE:
+                ewFusedLaunch(func, std::min(cellBlocks, maxBlocks), params.data());
+                break;
+            case Agg::ROW:
+                ewFusedLaunch(func, std::min(numRows, maxBlocks), params.data());
+                break;
+            case Agg::COL:
+                ewFusedLaunch(func, std::min((numCols + EWFUSED_BLOCK_SIZE - 1) / EWFUSED_BLOCK_SIZE, maxBlocks),
+                        params.data());
+                break;
+            case Agg::ALL: {
+                // a partial aggregate per block, aggregated by a single block
+                const size_t numBlocks = std::min(cellBlocks, maxBlocks);
+                auto partials = ctx->allocate(numBlocks * sizeof(VT));
+                out = reinterpret_cast<VT *>(partials.get());
+                ewFusedLaunch(func, numBlocks, params.data());
+
+                CUfunction final;
+                if(cuModuleGetFunction(&final, module, "ewfused_final") != CUDA_SUCCESS)
+                    throw std::runtime_error("CUDA::ewFused: the generated module has no final kernel");
+                const VT *partialsPtr = out;
+                unsigned long long n = numBlocks;
+                void *finalParams[] = {&valuesRes, &partialsPtr, &n};
+                // the partials return to the pool of the default stream, which orders their reuse after the kernels
+                ewFusedLaunch(final, 1, finalParams);
+                break;
+            }
+        }
+    }
+
+    template struct EwFused<DenseMatrix<double>, DenseMatrix<double>>;
+    template struct EwFused<DenseMatrix<float>, DenseMatrix<float>>;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <cstddef>
+
+namespace CUDA {
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+    template<class DTRes, class DTArg>
+    struct EwFused {
+        static void apply(DTRes *&res, const char *program, const DTArg **args, size_t numArgs, DCTX(ctx)) = delete;
+    };
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+    /**
+     * @brief Evaluates a program of element-wise operations, optionally aggregated, like `ewFused` (see
+     * `EwFused.h`) in a single CUDA kernel.
+     *
+     * The kernel is generated from the program, compiled with NVRTC, and cached in the `CUDAContext` by the program,
+     * the value type, and how each argument is broadcast, so a pipeline launches one kernel per program instead of
+     * one per operation, and the intermediate results stay in registers instead of global memory.
+     */
+    template<class DTRes, class DTArg>
+    void ewFused(DTRes *&res, const char *program, const DTArg **args, size_t numArgs, DCTX(ctx)) {
+        EwFused<DTRes, DTArg>::apply(res, program, args, numArgs, ctx);
+    }
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+    template<typename VT>
+    struct EwFused<DenseMatrix<VT>, DenseMatrix<VT>> {
+        static void apply(DenseMatrix<VT> *&res, const char *program, const DenseMatrix<VT> **args, size_t numArgs,
+                DCTX(ctx));
+    };
+}
@@ -37,7 +37,7 @@ namespace CUDA {
     template<class DTRes, class DTArg, class DTSel>
     void ExtractCol<DenseMatrix<DTRes>, DenseMatrix<DTArg>, DenseMatrix<DTSel>>::apply(DenseMatrix<DTRes>*& res,
             const DenseMatrix<DTArg>* arg, const DenseMatrix<DTSel>* sel, DCTX(dctx)) {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         if(res == nullptr) {
             res = DataObjectFactory::create<DenseMatrix<DTRes>>(arg->getNumRows(), sel->getNumRows(), false,
@@ -56,7 +56,7 @@ namespace CUDA {
                 << " total threads for " << N << " items" << std::endl;
 #endif
 
-        extract_col<<<gridSize, blockSize>>>(res->getValues(&alloc_desc), arg->getValues(&alloc_desc),
+        extract_col<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(res->getValues(&alloc_desc), arg->getValues(&alloc_desc),
                 sel->getValues(&alloc_desc), sel->getNumRows(), arg->getNumCols(), N);
     }
     template struct ExtractCol<DenseMatrix<int64_t>, DenseMatrix<int64_t>, DenseMatrix<int64_t>>;
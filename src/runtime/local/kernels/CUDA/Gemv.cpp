@@ -15,8 +15,11 @@
  */
 
 #include "Gemv.h"
+#include "CSRUtils.h"
 #include "runtime/local/datastructures/AllocationDescriptorCUDA.h"
 
+#include <stdexcept>
+
 namespace CUDA {
     template<>
     [[maybe_unused]] void
@@ -38,7 +41,7 @@ namespace CUDA {
                                                                 const DenseMatrix<T> *vec, DCTX(dctx)) {
 
         using VT = typename DenseMatrix<T>::VT;
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         
@@ -58,7 +61,29 @@ namespace CUDA {
         launch_cublas_gemv<VT>(*ctx, numCols, numRows, &blend_alpha, &blend_beta, d_mat, d_vec, d_res, CUBLAS_OP_N);
     }
 
+    template<typename T>
+    void Gemv<DenseMatrix<T>, CSRMatrix<T>, DenseMatrix<T>>::apply(DenseMatrix<T> *&res, const CSRMatrix<T> *mat,
+                                                                const DenseMatrix<T> *vec, DCTX(dctx)) {
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+
+        const size_t numRows = mat->getNumRows();
+        const size_t numCols = mat->getNumCols();
+        if(vec->getNumRows() != numRows || vec->getNumCols() != 1)
+            throw std::runtime_error("Gemv(CUDA, CSR) - vec must be a column vector with as many rows as mat");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<T>>(numCols, 1, false, &alloc_desc);
+
+        DeviceCSR<T> d_mat(mat, &alloc_desc, ctx);
+        spMV<T>(ctx, CUSPARSE_OPERATION_TRANSPOSE, d_mat, vec->getValues(&alloc_desc), numRows,
+                res->getValues(&alloc_desc), numCols);
+    }
+
     // explicit instantiations to satisfy linker
     template struct Gemv<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>>;
     template struct Gemv<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>>;
+    template struct Gemv<DenseMatrix<float>, CSRMatrix<float>, DenseMatrix<float>>;
+    template struct Gemv<DenseMatrix<double>, CSRMatrix<double>, DenseMatrix<double>>;
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/CUDA/HostUtils.h>
@@ -40,6 +41,12 @@ namespace CUDA {
         static void apply(DenseMatrix<T>*& res, const DenseMatrix<T>* mat, const DenseMatrix<T>* vec, DCTX(dctx));
     };
 
+    // computes t(mat) @ vec like the dense variant, with cuSPARSE's SpMV on the placement of mat on the device
+    template<typename T>
+    struct Gemv<DenseMatrix<T>, CSRMatrix<T>, DenseMatrix<T>> {
+        static void apply(DenseMatrix<T>*& res, const CSRMatrix<T>* mat, const DenseMatrix<T>* vec, DCTX(dctx));
+    };
+
     // ****************************************************************************
     // Convenience function
     // ****************************************************************************
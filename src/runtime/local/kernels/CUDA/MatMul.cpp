@@ -16,8 +16,16 @@
 
 #include "MatMul.h"
 //#include "Gemv.h"
+#include "CSRUtils.h"
+#include "MixedPrecision.h"
 #include "runtime/local/datastructures/AllocationDescriptorCUDA.h"
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
 namespace CUDA {
     template<typename T>
     void
@@ -43,7 +51,7 @@ namespace CUDA {
     void MatMul<DenseMatrix<T>, DenseMatrix<T>, DenseMatrix<T>>::apply(DenseMatrix<T> *&res, const DenseMatrix<T> *lhs,
             const DenseMatrix<T> *rhs, bool transa, bool transb, DCTX(dctx)) {
         using VT = typename DenseMatrix<T>::VT;
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
 
@@ -79,134 +87,193 @@ namespace CUDA {
 //            launch_cublas_gemv<VT>(*ctx, m, n, &blend_alpha, &blend_beta, A, B, C, CUBLAS_OP_T);
 //        }
 //        else
-        {
-            launch_cublas_gemm<VT>(ctx->getCublasHandle(), transa ? CUBLAS_OP_T : CUBLAS_OP_N, transb ? CUBLAS_OP_T :
-                    CUBLAS_OP_N, m, n, k, &alpha, A, lda, B, ldb, &beta, C, ldc);
+        if constexpr(std::is_same_v<VT, float>) {
+            if(ctx->usesHalfPrecision()) {
+                launchMixedPrecisionGemm(ctx, transa ? CUBLAS_OP_T : CUBLAS_OP_N, transb ? CUBLAS_OP_T : CUBLAS_OP_N,
+                        m, n, k, A, lda, B, ldb, C, ldc);
+                return;
+            }
         }
+        launch_cublas_gemm<VT>(ctx->getCublasHandle(), transa ? CUBLAS_OP_T : CUBLAS_OP_N, transb ? CUBLAS_OP_T :
+                CUBLAS_OP_N, m, n, k, &alpha, A, lda, B, ldb, &beta, C, ldc);
     }
 
-    // ToDo: sparse mat mult (sample code below compiles but is not usable)
-    // from cusparse sample code:
-    // https://github.com/NVIDIA/CUDALibrarySamples/blob/master/cuSPARSE/spgemm/spgemm_example.c
     template<typename T>
-    void MatMul<CSRMatrix<T>, CSRMatrix<T>, CSRMatrix<T>>::apply(CSRMatrix<T> *&res, const CSRMatrix<T> *lhs,
-            const CSRMatrix<T> *rhs, bool transa, bool transb, DCTX(dctx)) {
-        using VT = typename DenseMatrix<T>::VT;
-        auto ctx = CUDAContext::get(dctx, 0);
-        cusparseHandle_t handle = ctx->getCusparseHandle();
+    void MatMul<DenseMatrix<T>, CSRMatrix<T>, DenseMatrix<T>>::apply(DenseMatrix<T> *&res, const CSRMatrix<T> *lhs,
+            const DenseMatrix<T> *rhs, bool transa, bool transb, DCTX(dctx)) {
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
 
-        const size_t nr1 = lhs->getNumRows();
-        const size_t nc1 = lhs->getNumCols();
-        const size_t nr2 = rhs->getNumRows();
-        const size_t nc2 = rhs->getNumCols();
-        const size_t A_nnz = lhs->getNumNonZeros();
-        const size_t B_nnz = rhs->getNumNonZeros();
-        assert((nc1 == nr2) && "#cols of lhs and #rows of rhs must be the same");
-        const VT blend_alpha = 1.0f;
-        const VT blend_beta = 0.0f;
-        cusparseOperation_t opA = transa ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
-        cusparseOperation_t opB = transb ? CUSPARSE_OPERATION_TRANSPOSE: CUSPARSE_OPERATION_NON_TRANSPOSE;
-        cudaDataType computeType = ctx->template getCUSparseDataType<VT>();
-
-        //--------------------------------------------------------------------------
-        // Device memory management: Allocate and copy A, B
-        int *dA_csrOffsets, *dA_columns, *dB_csrOffsets, *dB_columns, *dC_csrOffsets, *dC_columns;
-        VT *dA_values, *dB_values, *dC_values;
-
-        // allocate A
-        CHECK_CUDART(cudaMalloc((void **) &dA_csrOffsets, (nr1 + 1) * sizeof(int)));
-        CHECK_CUDART(cudaMalloc((void **) &dA_columns, A_nnz * sizeof(int)));
-        CHECK_CUDART(cudaMalloc((void **) &dA_values, A_nnz * sizeof(VT)));
-
-        // allocate B
-        CHECK_CUDART(cudaMalloc((void **) &dB_csrOffsets, (nr2 + 1) * sizeof(int)));
-        CHECK_CUDART(cudaMalloc((void **) &dB_columns, B_nnz * sizeof(int)));
-        CHECK_CUDART(cudaMalloc((void **) &dB_values, B_nnz * sizeof(VT)));
-
-        // allocate C offsets
-        CHECK_CUDART(cudaMalloc((void **) &dC_csrOffsets, (nr1 + 1) * sizeof(int)));
-
-        // copy A
-        CHECK_CUDART(cudaMemcpy(dA_csrOffsets, lhs->getRowOffsets(), (nr1 + 1) * sizeof(int), cudaMemcpyHostToDevice));
-        CHECK_CUDART(cudaMemcpy(dA_columns, lhs->getColIdxs(), A_nnz * sizeof(int), cudaMemcpyHostToDevice));
-        CHECK_CUDART(cudaMemcpy(dA_values, lhs->getValues(), A_nnz * sizeof(VT), cudaMemcpyHostToDevice));
-
-        // copy B
-        CHECK_CUDART(cudaMemcpy(dB_csrOffsets, rhs->getRowOffsets(), (nr2 + 1) * sizeof(int), cudaMemcpyHostToDevice));
-        CHECK_CUDART(cudaMemcpy(dB_columns, rhs->getColIdxs(), B_nnz * sizeof(int), cudaMemcpyHostToDevice));
-        CHECK_CUDART(cudaMemcpy(dB_values, rhs->getValues(), B_nnz * sizeof(VT), cudaMemcpyHostToDevice));
-
-        cusparseSpMatDescr_t matA, matB, matC;
-        void *dBuffer1 = nullptr, *dBuffer2 = nullptr;
-        size_t bufferSize1 = 0, bufferSize2 = 0;
+        // cuSPARSE supports a transposed CSR operand of SpMM only with some algorithms, so we use the cached
+        // transposition of lhs, whose placement is cached as well
+        std::shared_ptr<const CSRMatrix<T>> lhsT;
+        if(transa)
+            lhsT = lhs->getTransposed();
+        const CSRMatrix<T> *A = transa ? lhsT.get() : lhs;
 
-        // Create sparse matrix A in CSR format
-        CHECK_CUSPARSE(
-                cusparseCreateCsr(&matA, nr1, nc1, A_nnz, dA_csrOffsets, dA_columns, dA_values, CUSPARSE_INDEX_32I,
-                                  CUSPARSE_INDEX_32I, CUSPARSE_INDEX_BASE_ZERO, CUDA_R_32F));
+        const size_t nr1 = A->getNumRows();
+        const size_t nc1 = A->getNumCols();
+        const size_t nr2 = transb ? rhs->getNumCols() : rhs->getNumRows();
+        const size_t nc2 = transb ? rhs->getNumRows() : rhs->getNumCols();
+        if(nc1 != nr2)
+            throw std::runtime_error("MatMul(CUDA, CSR) - #cols of lhs and #rows of rhs must be the same");
 
-        CHECK_CUSPARSE(
-                cusparseCreateCsr(&matB, nr2, nc2, B_nnz, dB_csrOffsets, dB_columns, dB_values, CUSPARSE_INDEX_32I,
-                                  CUSPARSE_INDEX_32I, CUSPARSE_INDEX_BASE_ZERO, CUDA_R_32F));
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<T>>(nr1, nc2, false, &alloc_desc);
 
-        CHECK_CUSPARSE(cusparseCreateCsr(&matC, nr1, nc2, 0, nullptr, nullptr, nullptr, CUSPARSE_INDEX_32I,
-                                         CUSPARSE_INDEX_32I, CUSPARSE_INDEX_BASE_ZERO, CUDA_R_32F));
+        const T alpha = 1;
+        const T beta = 0;
+        const cudaDataType type = ctx->template getCUSparseDataType<T>();
+        cusparseHandle_t handle = ctx->getCusparseHandle();
+        const cusparseOperation_t opA = CUSPARSE_OPERATION_NON_TRANSPOSE;
+        const cusparseOperation_t opB = transb ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+
+        DeviceCSR<T> matA(A, &alloc_desc, ctx);
+        cusparseDnMatDescr_t matB, matC;
+        CHECK_CUSPARSE(cusparseCreateDnMat(&matB, rhs->getNumRows(), rhs->getNumCols(), rhs->getNumCols(),
+                const_cast<T *>(rhs->getValues(&alloc_desc)), type, CUSPARSE_ORDER_ROW));
+        CHECK_CUSPARSE(cusparseCreateDnMat(&matC, nr1, nc2, nc2, res->getValues(&alloc_desc), type,
+                CUSPARSE_ORDER_ROW));
+
+        size_t bufferSize = 0;
+        CHECK_CUSPARSE(cusparseSpMM_bufferSize(handle, opA, opB, &alpha, matA.descr, matB, &beta, matC, type,
+                CUSPARSE_SPMM_ALG_DEFAULT, &bufferSize));
+        auto buffer = ctx->allocate(bufferSize);
+        CHECK_CUSPARSE(cusparseSpMM(handle, opA, opB, &alpha, matA.descr, matB, &beta, matC, type,
+                CUSPARSE_SPMM_ALG_DEFAULT, buffer.get()));
+
+        CHECK_CUSPARSE(cusparseDestroyDnMat(matB));
+        CHECK_CUSPARSE(cusparseDestroyDnMat(matC));
+    }
 
-        // SpGEMM Computation
-        cusparseSpGEMMDescr_t spgemmDesc;
-        CHECK_CUSPARSE(cusparseSpGEMM_createDescr(&spgemmDesc));
+    /**
+     * @brief Copies a `CSRMatrix` to temporary device buffers with 32-bit indexes, which cuSPARSE's SpGEMM requires.
+     */
+    template<typename T>
+    struct DeviceCSR32 {
+        std::shared_ptr<std::byte> rowOffsets, colIdxs, values;
+        cusparseSpMatDescr_t descr{};
+
+        DeviceCSR32(const CSRMatrix<T> *mat, CUDAContext *ctx) {
+            const size_t numRows = mat->getNumRows();
+            const size_t nnz = mat->getNumNonZeros();
+            const size_t *rowOffsetsMat = mat->getRowOffsets();
+            const size_t offset = rowOffsetsMat[0];
+
+            std::vector<int32_t> hostRowOffsets(numRows + 1);
+            for(size_t r = 0; r <= numRows; r++)
+                hostRowOffsets[r] = static_cast<int32_t>(rowOffsetsMat[r] - offset);
+            std::vector<int32_t> hostColIdxs(mat->getColIdxs() + offset, mat->getColIdxs() + offset + nnz);
+
+            rowOffsets = ctx->allocate((numRows + 1) * sizeof(int32_t));
+            colIdxs = ctx->allocate(nnz * sizeof(int32_t));
+            values = ctx->allocate(nnz * sizeof(T));
+            CHECK_CUDART(cudaMemcpy(rowOffsets.get(), hostRowOffsets.data(), (numRows + 1) * sizeof(int32_t),
+                    cudaMemcpyHostToDevice));
+            CHECK_CUDART(cudaMemcpy(colIdxs.get(), hostColIdxs.data(), nnz * sizeof(int32_t),
+                    cudaMemcpyHostToDevice));
+            CHECK_CUDART(cudaMemcpy(values.get(), mat->getValues() + offset, nnz * sizeof(T),
+                    cudaMemcpyHostToDevice));
+            CHECK_CUSPARSE(cusparseCreateCsr(&descr, numRows, mat->getNumCols(), nnz, rowOffsets.get(), colIdxs.get(),
+                    values.get(), CUSPARSE_INDEX_32I, CUSPARSE_INDEX_32I, CUSPARSE_INDEX_BASE_ZERO,
+                    ctx->template getCUSparseDataType<T>()));
+        }
 
-        // ask bufferSize1 bytes for external memory
-        CHECK_CUSPARSE(cusparseSpGEMM_workEstimation(handle, opA, opB, &blend_alpha, matA, matB, &blend_beta, matC,
-                                                     computeType,
-                                                     CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize1, nullptr));
+        DeviceCSR32(const DeviceCSR32 &) = delete;
+        DeviceCSR32 &operator=(const DeviceCSR32 &) = delete;
 
-        CHECK_CUDART(cudaMalloc((void **) &dBuffer1, bufferSize1));
+        ~DeviceCSR32() {
+            cusparseDestroySpMat(descr);
+        }
+    };
 
-        // inspect the matrices A and B to understand the memory requirement for
-        // the next step
+    template<typename T>
+    void MatMul<CSRMatrix<T>, CSRMatrix<T>, CSRMatrix<T>>::apply(CSRMatrix<T> *&res, const CSRMatrix<T> *lhs,
+            const CSRMatrix<T> *rhs, bool transa, bool transb, DCTX(dctx)) {
+        auto ctx = CUDAContext::get(dctx, CUDAContext::getCurrentDevice());
+        cusparseHandle_t handle = ctx->getCusparseHandle();
 
-        CHECK_CUSPARSE(cusparseSpGEMM_workEstimation(handle, opA, opB, &blend_alpha, matA, matB, &blend_beta, matC,
-                                                     computeType,
-                                                     CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize1, dBuffer1));
+        // SpGEMM supports non-transposed operands only, so we use the cached transpositions
+        std::shared_ptr<const CSRMatrix<T>> lhsT, rhsT;
+        if(transa)
+            lhsT = lhs->getTransposed();
+        if(transb)
+            rhsT = rhs->getTransposed();
+        const CSRMatrix<T> *A = transa ? lhsT.get() : lhs;
+        const CSRMatrix<T> *B = transb ? rhsT.get() : rhs;
+
+        const size_t nr1 = A->getNumRows();
+        const size_t nc1 = A->getNumCols();
+        const size_t nr2 = B->getNumRows();
+        const size_t nc2 = B->getNumCols();
+        if(nc1 != nr2)
+            throw std::runtime_error("MatMul(CUDA, CSR) - #cols of lhs and #rows of rhs must be the same");
+        const size_t maxIdx = std::numeric_limits<int32_t>::max();
+        if(nr1 > maxIdx || nc1 > maxIdx || nc2 > maxIdx || A->getNumNonZeros() > maxIdx ||
+                B->getNumNonZeros() > maxIdx)
+            throw std::runtime_error("MatMul(CUDA, CSR) - the operands of SpGEMM must have less than 2^31 rows, "
+                    "columns, and non-zeros");
+
+        const T alpha = 1;
+        const T beta = 0;
+        const cusparseOperation_t op = CUSPARSE_OPERATION_NON_TRANSPOSE;
+        const cudaDataType computeType = ctx->template getCUSparseDataType<T>();
+
+        DeviceCSR32<T> matA(A, ctx);
+        DeviceCSR32<T> matB(B, ctx);
+        auto dC_rowOffsets = ctx->allocate((nr1 + 1) * sizeof(int32_t));
+        cusparseSpMatDescr_t matC;
+        CHECK_CUSPARSE(cusparseCreateCsr(&matC, nr1, nc2, 0, nullptr, nullptr, nullptr, CUSPARSE_INDEX_32I,
+                CUSPARSE_INDEX_32I, CUSPARSE_INDEX_BASE_ZERO, computeType));
 
-        // ask bufferSize2 bytes for external memory
-        CHECK_CUSPARSE(
-                cusparseSpGEMM_compute(handle, opA, opB, &blend_alpha, matA, matB, &blend_beta, matC, computeType,
-                                       CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize2, nullptr));
+        cusparseSpGEMMDescr_t spgemmDesc;
+        CHECK_CUSPARSE(cusparseSpGEMM_createDescr(&spgemmDesc));
 
-        CHECK_CUDART(cudaMalloc((void **) &dBuffer2, bufferSize2));
+        // inspect the matrices A and B to understand the memory requirement of the computation
+        size_t bufferSize1 = 0, bufferSize2 = 0;
+        CHECK_CUSPARSE(cusparseSpGEMM_workEstimation(handle, op, op, &alpha, matA.descr, matB.descr, &beta, matC,
+                computeType, CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize1, nullptr));
+        auto workspace1 = ctx->allocate(bufferSize1);
+        CHECK_CUSPARSE(cusparseSpGEMM_workEstimation(handle, op, op, &alpha, matA.descr, matB.descr, &beta, matC,
+                computeType, CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize1, workspace1.get()));
 
         // compute the intermediate product of A * B
-        CHECK_CUSPARSE(
-                cusparseSpGEMM_compute(handle, opA, opB, &blend_alpha, matA, matB, &blend_beta, matC, computeType,
-                                       CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize2, dBuffer2));
-
-        // get matrix C non-zero entries C_nnz1
-        int64_t C_num_rows1, C_num_cols1, C_nnz1;
-        CHECK_CUSPARSE(cusparseSpMatGetSize(matC, &C_num_rows1, &C_num_cols1, &C_nnz1));
-
-        // allocate matrix C
-        CHECK_CUDART(cudaMalloc((void **) &dC_columns, C_nnz1 * sizeof(int)));
-        CHECK_CUDART(cudaMalloc((void **) &dC_values, C_nnz1 * sizeof(VT)));
-
-        // update matC with the new pointers
-        CHECK_CUSPARSE(cusparseCsrSetPointers(matC, dC_csrOffsets, dC_columns, dC_values));
+        CHECK_CUSPARSE(cusparseSpGEMM_compute(handle, op, op, &alpha, matA.descr, matB.descr, &beta, matC,
+                computeType, CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize2, nullptr));
+        auto workspace2 = ctx->allocate(bufferSize2);
+        CHECK_CUSPARSE(cusparseSpGEMM_compute(handle, op, op, &alpha, matA.descr, matB.descr, &beta, matC,
+                computeType, CUSPARSE_SPGEMM_DEFAULT, spgemmDesc, &bufferSize2, workspace2.get()));
+
+        // copy the product to C, once we know its number of non-zeros
+        int64_t numRowsC, numColsC, nnzC;
+        CHECK_CUSPARSE(cusparseSpMatGetSize(matC, &numRowsC, &numColsC, &nnzC));
+        auto dC_colIdxs = ctx->allocate(nnzC * sizeof(int32_t));
+        auto dC_values = ctx->allocate(nnzC * sizeof(T));
+        CHECK_CUSPARSE(cusparseCsrSetPointers(matC, dC_rowOffsets.get(), dC_colIdxs.get(), dC_values.get()));
+        CHECK_CUSPARSE(cusparseSpGEMM_copy(handle, op, op, &alpha, matA.descr, matB.descr, &beta, matC, computeType,
+                CUSPARSE_SPGEMM_DEFAULT, spgemmDesc));
 
-        // if beta != 0, cusparseSpGEMM_copy reuses/updates the values of dC_values
-
-        // copy the final products to the matrix C
-        CHECK_CUSPARSE(cusparseSpGEMM_copy(handle, opA, opB, &blend_alpha, matA, matB, &blend_beta, matC, computeType,
-                                           CUSPARSE_SPGEMM_DEFAULT, spgemmDesc));
-
-        // destroy matrix/vector descriptors
         CHECK_CUSPARSE(cusparseSpGEMM_destroyDescr(spgemmDesc));
-        CHECK_CUSPARSE(cusparseDestroySpMat(matA));
-        CHECK_CUSPARSE(cusparseDestroySpMat(matB));
         CHECK_CUSPARSE(cusparseDestroySpMat(matC));
+
+        // download the product and widen its indexes
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<T>>(nr1, nc2, nnzC, false);
+        std::vector<int32_t> hostRowOffsets(nr1 + 1);
+        std::vector<int32_t> hostColIdxs(nnzC);
+        CHECK_CUDART(cudaMemcpy(hostRowOffsets.data(), dC_rowOffsets.get(), (nr1 + 1) * sizeof(int32_t),
+                cudaMemcpyDeviceToHost));
+        CHECK_CUDART(cudaMemcpy(hostColIdxs.data(), dC_colIdxs.get(), nnzC * sizeof(int32_t),
+                cudaMemcpyDeviceToHost));
+        CHECK_CUDART(cudaMemcpy(res->getValues(), dC_values.get(), nnzC * sizeof(T), cudaMemcpyDeviceToHost));
+        std::copy(hostRowOffsets.begin(), hostRowOffsets.end(), res->getRowOffsets());
+        std::copy(hostColIdxs.begin(), hostColIdxs.end(), res->getColIdxs());
     }
 
     // explicit instantiations to satisfy linker
+    template struct MatMul<DenseMatrix<float>, CSRMatrix<float>, DenseMatrix<float>>;
+    template struct MatMul<DenseMatrix<double>, CSRMatrix<double>, DenseMatrix<double>>;
     template struct MatMul<CSRMatrix<float>, CSRMatrix<float>, CSRMatrix<float>>;
     template struct MatMul<CSRMatrix<double>, CSRMatrix<double>, CSRMatrix<double>>;
     template struct MatMul<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>>;
@@ -39,6 +39,19 @@ namespace CUDA {
                 bool transb, DCTX(dctx));
     };
 
+    /**
+     * @brief Multiplies a sparse by a dense matrix with cuSPARSE's SpMM, reusing the placement of `lhs` on the
+     * device (see `CSRMatrix::getPlacement()`).
+     */
+    template<typename T>
+    struct MatMul<DenseMatrix<T>, CSRMatrix<T>, DenseMatrix<T>> {
+        static void apply(DenseMatrix<T> *&res, const CSRMatrix<T> *lhs, const DenseMatrix<T> *rhs, bool transa,
+                bool transb, DCTX(dctx));
+    };
+
+    /**
+     * @brief Multiplies two sparse matrices with cuSPARSE's SpGEMM. The result is returned in main memory.
+     */
     template<typename T>
     struct MatMul<CSRMatrix<T>, CSRMatrix<T>, CSRMatrix<T>> {
         static void apply(CSRMatrix<T> *&res, const CSRMatrix<T> *lhs, const CSRMatrix<T> *rhs, bool transa, bool transb,
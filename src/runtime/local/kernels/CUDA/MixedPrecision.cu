@@ -0,0 +1,90 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MixedPrecision.h"
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <stdexcept>
+
+namespace CUDA {
+    template<typename T>
+    __device__ T roundFromFloat(float val);
+
+    template<>
+    __device__ __half roundFromFloat<__half>(float val) {
+        return __float2half_rn(val);
+    }
+
+    template<>
+    __device__ __nv_bfloat16 roundFromFloat<__nv_bfloat16>(float val) {
+        return __float2bfloat16_rn(val);
+    }
+
+    template<typename T>
+    __global__ void round_scaled(T *res, const float *arg, size_t N, float scale) {
+        auto tid = blockIdx.x * blockDim.x + threadIdx.x;
+        if(tid < N)
+            res[tid] = roundFromFloat<T>(arg[tid] * scale);
+    }
+
+    // rounds the scaled FP32 values to a temporary buffer of T
+    template<typename T>
+    static std::shared_ptr<std::byte> roundToDevice(CUDAContext *ctx, const float *arg, size_t N, float scale) {
+        auto res = ctx->allocate(N * sizeof(T));
+        if(N == 0)
+            return res;
+        int blockSize;
+        int minGridSize;
+        CHECK_CUDART(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, round_scaled<T>, 0, 0));
+        const size_t gridSize = (N + blockSize - 1) / blockSize;
+        round_scaled<<<gridSize, blockSize, 0, CUDAContext::getComputeStream()>>>(reinterpret_cast<T *>(res.get()), arg, N,
+                scale);
+        return res;
+    }
+
+    template<typename T>
+    static void launchGemmEx(CUDAContext *ctx, cudaDataType type, cublasOperation_t transa, cublasOperation_t transb,
+            int32_t m, int32_t n, int32_t k, const float *A, int32_t lda, const float *B, int32_t ldb, float *C,
+            int32_t ldc) {
+        const float scale = ctx->getLossScale();
+        // column-major, so A has lda rows and as many columns as op(A) has rows (if transposed) or columns
+        const size_t sizeA = static_cast<size_t>(lda) * (transa == CUBLAS_OP_N ? k : m);
+        const size_t sizeB = static_cast<size_t>(ldb) * (transb == CUBLAS_OP_N ? n : k);
+        auto d_A = roundToDevice<T>(ctx, A, sizeA, scale);
+        auto d_B = roundToDevice<T>(ctx, B, sizeB, scale);
+
+        const float alpha = 1.0f / (scale * scale);
+        const float beta = 0.0f;
+        CHECK_CUBLAS(cublasGemmEx(ctx->getCublasHandle(), transa, transb, m, n, k, &alpha, d_A.get(), type, lda,
+                d_B.get(), type, ldb, &beta, C, CUDA_R_32F, ldc, CUBLAS_COMPUTE_32F, CUBLAS_GEMM_DEFAULT_TENSOR_OP));
+    }
+
+    void launchMixedPrecisionGemm(CUDAContext *ctx, cublasOperation_t transa, cublasOperation_t transb, int32_t m,
+            int32_t n, int32_t k, const float *A, int32_t lda, const float *B, int32_t ldb, float *C, int32_t ldc) {
+        switch(ctx->getPrecision()) {
+            case CUDAPrecision::FP16:
+                launchGemmEx<__half>(ctx, CUDA_R_16F, transa, transb, m, n, k, A, lda, B, ldb, C, ldc);
+                break;
+            case CUDAPrecision::BF16:
+                launchGemmEx<__nv_bfloat16>(ctx, CUDA_R_16BF, transa, transb, m, n, k, A, lda, B, ldb, C, ldc);
+                break;
+            default:
+                throw std::runtime_error("launchMixedPrecisionGemm: the CUDA context does not use FP16/BF16");
+        }
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/CUDAContext.h>
+
+#include <cstdint>
+
+namespace CUDA {
+
+    /**
+     * @brief Computes `C = op(A) * op(B)` like `cublasSgemm` (column-major, same arguments, `alpha = 1`, `beta = 0`),
+     * but with the inputs rounded to FP16 or BF16 (per the precision of the context) and accumulated in FP32 on the
+     * tensor cores.
+     *
+     * The inputs are scaled by the loss scale of the context before the rounding, and the result is scaled back,
+     * such that small values do not flush to zero in FP16. The rounded copies of the inputs are temporary buffers
+     * from the memory pool of the context.
+     */
+    void launchMixedPrecisionGemm(CUDAContext *ctx, cublasOperation_t transa, cublasOperation_t transb, int32_t m,
+            int32_t n, int32_t k, const float *A, int32_t lda, const float *B, int32_t ldb, float *C, int32_t ldc);
+}
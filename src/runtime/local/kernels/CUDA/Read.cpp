@@ -0,0 +1,261 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Read.h"
+
+#include <runtime/local/datastructures/AllocationDescriptorCUDA.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/io/AsyncReads.h>
+#include <runtime/local/io/ReadDaphne.h>
+
+#ifdef USE_CUFILE
+#include <cufile.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace CUDA {
+    namespace {
+        // the size of each of the two pinned buffers the values are staged in
+        constexpr uint64_t STAGING_BYTES = uint64_t(8) << 20;
+
+        // a range of the file holding the values from the byte `dst` of the values of the matrix on
+        struct Extent {
+            uint64_t offset;
+            uint64_t nbytes;
+            uint64_t dst;
+            // the CRC-32 of the range and its first row, if it is a block of a file with blocks
+            bool checked;
+            uint32_t checksum;
+            uint64_t rx;
+        };
+
+        /**
+         * @brief Determines the dimensions of a dense matrix in a Daphne binary file and the ranges of the file
+         * holding its values, unless they are compressed (or the matrix is empty).
+         */
+        template<typename VT>
+        bool getExtents(const DaphneFileReader &f, const char *filename, size_t &numRows, size_t &numCols,
+                std::vector<Extent> &extents) {
+            uint64_t pos = 0;
+            DF_header h;
+            f.read(pos, h);
+            if(h.dt != DF_data_t::DenseMatrix_t)
+                throw std::runtime_error(std::string("ReadDaphne: the file does not hold a dense matrix: ") + filename);
+            ValueTypeCode vt;
+            f.read(pos, vt);
+
+            if(h.version >= DF_version_blocks) {
+                if(vt != ValueTypeUtils::codeFor<VT>)
+                    throw std::runtime_error("ReadDaphne: the value type of the file does not match the matrix");
+                DF_block_index idx;
+                const std::vector<DF_block_entry> entries = readDaphneBlocks(filename, &idx);
+                if(idx.compression != DF_compression_t::none || h.nbrows == 0 || h.nbcols == 0)
+                    return false;
+                const uint64_t rowBytes = h.nbcols * sizeof(VT);
+                for(const DF_block_entry &e : entries) {
+                    if(e.nbytes != e.nbrows * rowBytes)
+                        throw std::runtime_error("ReadDaphne: corrupt block index");
+                    extents.push_back({e.offset, e.nbytes, e.rx * rowBytes, true, e.checksum, e.rx});
+                }
+                numRows = h.nbrows;
+                numCols = h.nbcols;
+                return true;
+            }
+
+            DF_body b;
+            f.read(pos, b);
+            DF_body_block bb;
+            f.read(pos, bb);
+            if(bb.bt != DF_body_t::dense || bb.nbrows == 0 || bb.nbcols == 0)
+                return false;
+            f.read(pos, vt);
+            if(h.version >= 2)
+                pos = DF_align(pos);
+            numRows = bb.nbrows;
+            numCols = bb.nbcols;
+            extents.push_back({pos, uint64_t(bb.nbrows) * bb.nbcols * sizeof(VT), 0, false, 0, 0});
+            return true;
+        }
+
+#ifdef USE_CUFILE
+        // whether the cuFile driver could be opened, which is tried once per process
+        bool isGDSAvailable() {
+            static const bool available = cuFileDriverOpen().err == CU_FILE_SUCCESS;
+            return available;
+        }
+
+        /**
+         * @brief Reads the extents into the device memory `dst` by GPUDirect Storage.
+         *
+         * @return Whether the file could be read this way (e.g., not if its file system does not support it).
+         */
+        bool readDirect(const char *filename, const std::vector<Extent> &extents, std::byte *dst) {
+            if(!isGDSAvailable())
+                return false;
+            // the direct reads bypass the page cache
+            const int fd = open(filename, O_RDONLY | O_DIRECT);
+            if(fd < 0)
+                return false;
+            CUfileDescr_t descr{};
+            descr.handle.fd = fd;
+            descr.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+            CUfileHandle_t handle;
+            if(cuFileHandleRegister(&handle, &descr).err != CU_FILE_SUCCESS) {
+                close(fd);
+                return false;
+            }
+            bool success = true;
+            for(const Extent &e : extents) {
+                for(uint64_t done = 0; success && done < e.nbytes;) {
+                    const ssize_t n = cuFileRead(handle, dst + e.dst, e.nbytes - done, e.offset + done, done);
+                    success = n > 0;
+                    done += success ? n : 0;
+                }
+            }
+            cuFileHandleDeregister(handle);
+            close(fd);
+            return success;
+        }
+#endif
+
+        // two pinned host buffers, each with the event of its last copy to the device
+        class PinnedStaging {
+            cudaStream_t stream;
+            void *buffers[2] = {nullptr, nullptr};
+            cudaEvent_t copied[2] = {nullptr, nullptr};
+
+        public:
+            explicit PinnedStaging(cudaStream_t stream) : stream(stream) {
+                for(size_t i = 0; i < 2; i++) {
+                    CHECK_CUDART(cudaHostAlloc(&buffers[i], STAGING_BYTES, cudaHostAllocDefault));
+                    CHECK_CUDART(cudaEventCreateWithFlags(&copied[i], cudaEventDisableTiming));
+                }
+            }
+            PinnedStaging(const PinnedStaging &) = delete;
+            PinnedStaging &operator=(const PinnedStaging &) = delete;
+
+            ~PinnedStaging() {
+                // no copy from the buffers may be pending, even if reading failed
+                cudaStreamSynchronize(stream);
+                for(size_t i = 0; i < 2; i++) {
+                    if(copied[i])
+                        cudaEventDestroy(copied[i]);
+                    if(buffers[i])
+                        cudaFreeHost(buffers[i]);
+                }
+            }
+
+            // returns the buffer once its last copy finished
+            uint8_t *acquire(size_t i) {
+                CHECK_CUDART(cudaEventSynchronize(copied[i]));
+                return static_cast<uint8_t *>(buffers[i]);
+            }
+
+            void copy(size_t i, std::byte *dst, uint64_t nbytes) {
+                CHECK_CUDART(cudaMemcpyAsync(dst, buffers[i], nbytes, cudaMemcpyHostToDevice, stream));
+                CHECK_CUDART(cudaEventRecord(copied[i], stream));
+            }
+        };
+
+        /**
+         * @brief Reads the extents into the device memory `dst` via two pinned host buffers, i.e., reads the next part
+         * of the file into one buffer while the other one is copied to the device, and verifies the checksums of the
+         * blocks on the way.
+         */
+        void readStaged(const DaphneFileReader &f, const std::vector<Extent> &extents, std::byte *dst,
+                cudaStream_t stream) {
+            PinnedStaging staging(stream);
+            size_t next = 0;
+            for(const Extent &e : extents) {
+                uint32_t crc = 0;
+                for(uint64_t done = 0; done < e.nbytes; next ^= 1) {
+                    const uint64_t n = std::min(STAGING_BYTES, e.nbytes - done);
+                    uint8_t *buffer = staging.acquire(next);
+                    f.readBytes(e.offset + done, buffer, n);
+                    if(e.checked)
+                        crc = DF_crc32(crc, buffer, n);
+                    staging.copy(next, dst + e.dst + done, n);
+                    done += n;
+                }
+                if(e.checked && crc != e.checksum)
+                    throw std::runtime_error("ReadDaphne: checksum mismatch in the block of row " + std::to_string(e.rx));
+            }
+            CHECK_CUDART(cudaStreamSynchronize(stream));
+        }
+    }
+
+// ----------------------------------------------------------------------------
+// DenseMatrix
+// ----------------------------------------------------------------------------
+
+    template<typename VT>
+    void Read<DenseMatrix<VT>>::apply(DenseMatrix<VT> *&res, const char *filename, DCTX(dctx)) {
+        // a read started ahead (see prefetchRead) is on the host already, its values are copied to the device on use
+        AsyncReads *reads = AsyncReads::get(dctx);
+        if(res == nullptr && reads) {
+            const int64_t valueType = static_cast<int64_t>(ValueTypeUtils::codeFor<VT>);
+            if(Structure *obj = reads->take({filename, AsyncReadDataType::DenseMatrix, valueType})) {
+                res = static_cast<DenseMatrix<VT> *>(obj);
+                return;
+            }
+        }
+
+        const size_t deviceID = CUDAContext::getCurrentDevice();
+        auto ctx = CUDAContext::get(dctx, deviceID);
+        AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
+
+        DaphneFileReader f(filename);
+        size_t numRows = 0;
+        size_t numCols = 0;
+        std::vector<Extent> extents;
+        if(!getExtents<VT>(f, filename, numRows, numCols, extents)) {
+            // compressed blocks are decompressed on the host
+            readDaphne(res, filename, false, dctx);
+            if(res && res->getNumRows() && res->getNumCols())
+                static_cast<const DenseMatrix<VT> *>(res)->getValues(&alloc_desc);
+            return;
+        }
+
+        auto out = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false, &alloc_desc);
+        try {
+            auto dst = reinterpret_cast<std::byte *>(out->getValues(&alloc_desc));
+#ifdef USE_CUFILE
+            if(!readDirect(filename, extents, dst))
+#endif
+                readStaged(f, extents, dst, ctx->getH2DStream());
+        }
+        catch(...) {
+            DataObjectFactory::destroy(out);
+            throw;
+        }
+        res = out;
+    }
+
+    template struct Read<DenseMatrix<double>>;
+    template struct Read<DenseMatrix<float>>;
+    template struct Read<DenseMatrix<int64_t>>;
+}
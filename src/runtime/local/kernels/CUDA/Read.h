@@ -0,0 +1,64 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+namespace CUDA {
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+    template<class DTRes>
+    struct Read {
+        static void apply(DTRes *&res, const char *filename, DCTX(ctx)) = delete;
+    };
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+    /**
+     * @brief Reads a data object from a Daphne binary file into the memory of the current device, for the CUDA kernels
+     * using it.
+     */
+    template<class DTRes>
+    void read(DTRes *&res, const char *filename, DCTX(ctx)) {
+        Read<DTRes>::apply(res, filename, ctx);
+    }
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix
+// ----------------------------------------------------------------------------
+
+    /**
+     * The values are read from the file into the device memory directly by GPUDirect Storage (cuFile) if it is
+     * available, whose reads do not pass the host and thus do not verify the checksums of the blocks. Otherwise, they
+     * are read into two pinned host buffers in turns, each copied to the device while the other one is read. Files
+     * with compressed blocks are read (and decompressed) on the host and copied to the device as a whole.
+     */
+    template<typename VT>
+    struct Read<DenseMatrix<VT>> {
+        static void apply(DenseMatrix<VT> *&res, const char *filename, DCTX(ctx));
+    };
+}
@@ -80,7 +80,7 @@ namespace CUDA {
     template<class VT>
     void Solve<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>>::apply
             (DenseMatrix<VT> *&res, const DenseMatrix<VT> *lhs, const DenseMatrix<VT> *rhs, DCTX(dctx)) {
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         
@@ -107,7 +107,7 @@ namespace CUDA {
         const VT blend_beta = 0.0f;
 
         launch_cublas_geam<VT>(*ctx, nr1, nc1, &blend_alpha, &blend_beta, lhs->getValues(&alloc_desc), d_A);
-        CHECK_CUBLAS(cublasSetStream(ctx->getCublasHandle(), nullptr));
+        CHECK_CUBLAS(cublasSetStream(ctx->getCublasHandle(), CUDAContext::getComputeStream()));
         auto &m = nc1;
 //    auto d_A = const_cast<VT*>(lhs->getValues(&alloc_desc));
         CHECK_CUDART(
@@ -55,7 +55,7 @@ namespace CUDA {
     void Syrk<DenseMatrix<VTres>, DenseMatrix<VTarg>>::apply(DenseMatrix <VTres> *&res, const DenseMatrix <VTarg> *arg,
             DCTX(dctx)) {
         using VT = typename DenseMatrix<VTres>::VT;
-        const size_t deviceID = 0; //ToDo: multi device support
+        const size_t deviceID = CUDAContext::getCurrentDevice();
         auto ctx = CUDAContext::get(dctx, deviceID);
         AllocationDescriptorCUDA alloc_desc(dctx, deviceID);
         const size_t nr1 = arg->getNumRows();
@@ -83,7 +83,7 @@ namespace CUDA {
         dim3 grid(NB, 1, 1);
         dim3 block(NT, 1, 1);
 
-        copy_u2l_dense<<<grid, block>>>(d_res, nc1, N);
+        copy_u2l_dense<<<grid, block, 0, CUDAContext::getComputeStream()>>>(d_res, nc1, N);
     }
 
     template struct Syrk<DenseMatrix<double>, DenseMatrix<double>>;
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/kernels/AggOpCode.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+
+#include <cuda_runtime.h>
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * The reducers of the aggregation kernels (AggAll, AggRow, AggCol). A reducer accumulates values into an accumulator
+ * (`add`, given the index of the value), merges two accumulators (`merge`), and computes the aggregate of an
+ * accumulator (`result`). The accumulators are plain structs, such that they can be kept in shared memory and
+ * exchanged between the lanes of a warp (`shflDown`).
+ */
+
+namespace CUDA {
+
+    constexpr unsigned FULL_WARP_MASK = 0xffffffffu;
+    constexpr unsigned WARP_SIZE = 32;
+
+    // the sum, minimum, or maximum
+    template<typename VT, BinaryOpCode OP>
+    struct BinaryReducer {
+        using Acc = VT;
+
+        VT neutral;
+
+        __device__ __forceinline__ Acc init() const { return neutral; }
+
+        __device__ __forceinline__ Acc add(Acc a, VT v, size_t) const { return merge(a, v); }
+
+        __device__ __forceinline__ Acc merge(Acc a, Acc b) const {
+            if constexpr(OP == BinaryOpCode::ADD)
+                return a + b;
+            else if constexpr(std::is_floating_point<VT>::value)
+                return OP == BinaryOpCode::MIN ? fmin(a, b) : fmax(a, b);
+            else
+                return OP == BinaryOpCode::MIN ? (b < a ? b : a) : (b > a ? b : a);
+        }
+
+        __device__ __forceinline__ static Acc shflDown(Acc a, unsigned offset) {
+            return __shfl_down_sync(FULL_WARP_MASK, a, offset);
+        }
+
+        __device__ __forceinline__ VT result(Acc a) const { return a; }
+    };
+
+    // the mean or the (population) standard deviation, by Welford's algorithm, whose partial moments are merged by
+    // the formula of Chan et al.
+    template<typename VT, bool STDDEV>
+    struct MomentsReducer {
+        // integers are averaged in double precision
+        using AT = std::conditional_t<std::is_floating_point<VT>::value, VT, double>;
+        struct Acc {
+            AT n;
+            AT mean;
+            AT m2;
+        };
+
+        __device__ __forceinline__ Acc init() const { return {0, 0, 0}; }
+
+        __device__ __forceinline__ Acc add(Acc a, VT v, size_t) const {
+            const AT n = a.n + 1;
+            const AT delta = static_cast<AT>(v) - a.mean;
+            const AT mean = a.mean + delta / n;
+            return {n, mean, a.m2 + delta * (static_cast<AT>(v) - mean)};
+        }
+
+        __device__ __forceinline__ Acc merge(Acc a, Acc b) const {
+            if(b.n == 0)
+                return a;
+            if(a.n == 0)
+                return b;
+            const AT n = a.n + b.n;
+            const AT delta = b.mean - a.mean;
+            return {n, a.mean + delta * b.n / n, a.m2 + b.m2 + delta * delta * a.n * b.n / n};
+        }
+
+        __device__ __forceinline__ static Acc shflDown(Acc a, unsigned offset) {
+            return {__shfl_down_sync(FULL_WARP_MASK, a.n, offset), __shfl_down_sync(FULL_WARP_MASK, a.mean, offset),
+                    __shfl_down_sync(FULL_WARP_MASK, a.m2, offset)};
+        }
+
+        __device__ __forceinline__ VT result(Acc a) const {
+            if constexpr(STDDEV)
+                return static_cast<VT>(a.n == 0 ? AT(0) : sqrt(a.m2 / a.n));
+            else
+                return static_cast<VT>(a.mean);
+        }
+    };
+
+    // the index of the (first) minimum or maximum, as a value of the value type like on the CPU
+    template<typename VT, bool MAX>
+    struct ArgReducer {
+        struct Acc {
+            VT value;
+            // -1 if no value was added
+            int64_t idx;
+        };
+
+        __device__ __forceinline__ Acc init() const { return {VT(0), -1}; }
+
+        __device__ __forceinline__ Acc add(Acc a, VT v, size_t idx) const {
+            // the values are added in the order of their indexes
+            return a.idx < 0 || (MAX ? v > a.value : v < a.value) ? Acc{v, static_cast<int64_t>(idx)} : a;
+        }
+
+        __device__ __forceinline__ Acc merge(Acc a, Acc b) const {
+            if(b.idx < 0)
+                return a;
+            if(a.idx < 0)
+                return b;
+            const bool better = MAX ? b.value > a.value : b.value < a.value;
+            return better || (b.value == a.value && b.idx < a.idx) ? b : a;
+        }
+
+        __device__ __forceinline__ static Acc shflDown(Acc a, unsigned offset) {
+            return {__shfl_down_sync(FULL_WARP_MASK, a.value, offset),
+                    static_cast<int64_t>(__shfl_down_sync(FULL_WARP_MASK, static_cast<long long>(a.idx), offset))};
+        }
+
+        __device__ __forceinline__ VT result(Acc a) const { return static_cast<VT>(a.idx < 0 ? 0 : a.idx); }
+    };
+
+    // reduces the accumulators of the lanes of a (full) warp into the one of its first lane
+    template<class R>
+    __device__ __forceinline__ typename R::Acc warpReduce(const R &r, typename R::Acc acc) {
+        for(unsigned offset = WARP_SIZE / 2; offset > 0; offset /= 2)
+            acc = r.merge(acc, R::shflDown(acc, offset));
+        return acc;
+    }
+
+    // reduces the accumulators of the threads of a block (of full warps) into the one of its first thread
+    template<class R>
+    __device__ typename R::Acc blockReduce(const R &r, typename R::Acc acc) {
+        __shared__ typename R::Acc warpAccs[WARP_SIZE];
+        const unsigned lane = threadIdx.x % WARP_SIZE;
+        const unsigned warp = threadIdx.x / WARP_SIZE;
+        acc = warpReduce(r, acc);
+        if(lane == 0)
+            warpAccs[warp] = acc;
+        __syncthreads();
+        if(warp == 0) {
+            acc = lane < blockDim.x / WARP_SIZE ? warpAccs[lane] : r.init();
+            acc = warpReduce(r, acc);
+        }
+        return acc;
+    }
+
+    /**
+     * @brief Calls `f` with the reducer of an aggregation, `IDXMIN` and `IDXMAX` only if `withIndexes`.
+     */
+    template<typename VT, typename F>
+    void withAggReducer(AggOpCode opCode, bool withIndexes, F f) {
+        switch(opCode) {
+            case AggOpCode::SUM:
+                f(BinaryReducer<VT, BinaryOpCode::ADD>{VT(0)});
+                return;
+            case AggOpCode::MIN:
+                f(BinaryReducer<VT, BinaryOpCode::MIN>{AggOpCodeUtils::getNeutral<VT>(opCode)});
+                return;
+            case AggOpCode::MAX:
+                f(BinaryReducer<VT, BinaryOpCode::MAX>{AggOpCodeUtils::getNeutral<VT>(opCode)});
+                return;
+            case AggOpCode::MEAN:
+                f(MomentsReducer<VT, false>{});
+                return;
+            case AggOpCode::STDDEV:
+                f(MomentsReducer<VT, true>{});
+                return;
+            case AggOpCode::IDXMIN:
+                if(withIndexes) {
+                    f(ArgReducer<VT, false>{});
+                    return;
+                }
+                break;
+            case AggOpCode::IDXMAX:
+                if(withIndexes) {
+                    f(ArgReducer<VT, true>{});
+                    return;
+                }
+                break;
+        }
+        throw std::runtime_error("unsupported AggOpCode " + std::to_string(static_cast<int>(opCode)) +
+                " for this CUDA aggregation");
+    }
+}
@@ -7,136 +7,105 @@
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
 #include <stdexcept>
-#include <tuple>
-#include <unordered_set>
+#include <string>
+#include <vector>
 
 #include <cstddef>
 #include <cstdint>
 
-template<typename VTCol>
-void cartesianSetValue(
-    DenseMatrix<VTCol> * res,
-    const DenseMatrix<VTCol> * arg,
-    const int64_t targetRow,
-    const int64_t fromRow,
-    DCTX(ctx)
-){
-    const VTCol argValue = arg->get(fromRow, 0);
-    res->set(targetRow, 0, argValue);
-}
+// The rows of the result filled by one task.
+constexpr size_t CARTESIAN_CHUNK_ROWS = 1 << 16;
 
-template<typename VTCol>
-void cartesianSet(
-    ValueTypeCode vtcType,
-    Frame *&res,
-    const Frame * arg,
-    const int64_t toRow,
-    const int64_t toCol,
-    const int64_t fromRow,
-    const int64_t fromCol,
-    DCTX(ctx)
-) {
-    if(vtcType == ValueTypeUtils::codeFor<VTCol>){
-        cartesianSetValue<VTCol>(
-            res->getColumn<VTCol>(toCol),
-            arg->getColumn<VTCol>(fromCol),
-            toRow,
-            fromRow,
-            ctx
-        );
+// Fills the rows [begin, end) of a column of the result of a cartesian
+// product whose right side has numRowsRhs rows: with the values of the rows
+// of a column of the left side, repeated numRowsRhs times each, or with the
+// ranges of the values of a column of the right side.
+template<typename VT>
+void cartesianFill(void * res, const void * arg, bool isLhs, size_t numRowsRhs, size_t begin, size_t end) {
+    VT * resVals = static_cast<VT *>(res);
+    const VT * argVals = static_cast<const VT *>(arg);
+    for(size_t pos = begin; pos < end; ) {
+        const size_t i = pos / numRowsRhs;
+        const size_t j = pos % numRowsRhs;
+        const size_t n = std::min(end - pos, numRowsRhs - j);
+        if(isLhs)
+            std::fill(resVals + pos, resVals + pos + n, argVals[i]);
+        else
+            std::copy(argVals + j, argVals + j + n, resVals + pos);
+        pos += n;
     }
 }
 
-void cartesian(
+/**
+ * @brief Returns the cartesian product of two frames, i.e., a row of all
+ * columns of `lhs` and `rhs` for each pair of their rows, ordered by the row
+ * of `lhs` first.
+ *
+ * The columns are filled in chunks of their rows in parallel, each chunk
+ * writing consecutive memory. Queries filtering the product should be joins
+ * instead: the filter on comparisons of columns of both sides is rewritten to
+ * a `thetaJoin` (see `FilterRowOp::canonicalize`), which only materializes
+ * the pairs of rows satisfying them.
+ */
+inline void cartesian(
         Frame *& res,
         const Frame * lhs, const Frame * rhs,
         DCTX(ctx)
 ) {
-    const size_t numRowRhs = rhs->getNumRows();
     const size_t numRowLhs = lhs->getNumRows();
-    const size_t totalRows = numRowRhs * numRowLhs;
-    const size_t numColRhs = rhs->getNumCols();
+    const size_t numRowRhs = rhs->getNumRows();
+    const size_t totalRows = numRowLhs * numRowRhs;
     const size_t numColLhs = lhs->getNumCols();
-    const size_t totalCols = numColRhs + numColLhs;
-    const std::string * oldlabels_l = lhs->getLabels();
-    const std::string * oldlabels_r = rhs->getLabels();
-
-    int64_t row_idx_res = 0;
-    int64_t col_idx_res = 0;
-    ValueTypeCode schema[totalCols];
-    std::string newlabels[totalCols];
+    const size_t numColRhs = rhs->getNumCols();
+    const size_t totalCols = numColLhs + numColRhs;
 
     // Setting Schema and Labels
-    for(size_t col_idx_l = 0; col_idx_l < numColLhs; col_idx_l++){
-        schema[col_idx_res] = lhs->getColumnType(col_idx_l);
-        newlabels[col_idx_res] = oldlabels_l[col_idx_l];
-        col_idx_res++;
+    std::vector<ValueTypeCode> schema(totalCols);
+    std::vector<std::string> labels(totalCols);
+    std::vector<const void *> argCols(totalCols);
+    for(size_t c = 0; c < numColLhs; c++) {
+        schema[c] = lhs->getColumnType(c);
+        labels[c] = lhs->getLabels()[c];
+        argCols[c] = lhs->getColumnRaw(c);
     }
-    for(size_t col_idx_r = 0; col_idx_r < numColRhs; col_idx_r++){
-        schema[col_idx_res] = rhs->getColumnType(col_idx_r);
-        newlabels[col_idx_res] = oldlabels_r[col_idx_r];
-        col_idx_res++;
+    for(size_t c = 0; c < numColRhs; c++) {
+        schema[numColLhs + c] = rhs->getColumnType(c);
+        labels[numColLhs + c] = rhs->getLabels()[c];
+        argCols[numColLhs + c] = rhs->getColumnRaw(c);
     }
 
     // Creating Result Frame
-    res = DataObjectFactory::create<Frame>(totalRows, totalCols, schema, newlabels, false);
-
-    for(size_t row_idx_l = 0; row_idx_l < numRowLhs; row_idx_l++){
-        for(size_t row_idx_r = 0; row_idx_r < numRowRhs; row_idx_r++){
-            col_idx_res = 0;
-
-            for(size_t idx_c = 0; idx_c < numColLhs; idx_c++){
-                cartesianSet<int64_t>(
-                    schema[col_idx_res],
-                    res,
-                    lhs,
-                    row_idx_res,
-                    col_idx_res,
-                    row_idx_l,
-                    idx_c,
-                    ctx
-                );
-                cartesianSet<double>(
-                    schema[col_idx_res],
-                    res,
-                    lhs,
-                    row_idx_res,
-                    col_idx_res,
-                    row_idx_l,
-                    idx_c,
-                    ctx
-                );
-                col_idx_res++;
-            }
+    res = DataObjectFactory::create<Frame>(totalRows, totalCols, schema.data(), labels.data(), false);
+    if(totalRows == 0)
+        return;
+    std::vector<void *> resCols(totalCols);
+    for(size_t c = 0; c < totalCols; c++)
+        resCols[c] = res->getColumnRaw(c);
 
-            for(size_t idx_c = 0; idx_c < numColRhs; idx_c++){
-                cartesianSet<int64_t>(
-                    schema[col_idx_res],
-                    res,
-                    rhs,
-                    row_idx_res,
-                    col_idx_res,
-                    row_idx_r,
-                    idx_c,
-                    ctx
-                );
-                cartesianSet<double>(
-                    schema[col_idx_res],
-                    res,
-                    rhs,
-                    row_idx_res,
-                    col_idx_res,
-                    row_idx_r,
-                    idx_c,
-                    ctx
-                );
-                col_idx_res++;
-            }
-            row_idx_res++;
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, totalRows / CARTESIAN_CHUNK_ROWS));
+    WorkerPool::parallelFor(ctx, totalCols * numChunks, [&](size_t task) {
+        const size_t c = task / numChunks;
+        const size_t chunk = task % numChunks;
+        const size_t begin = totalRows * chunk / numChunks;
+        const size_t end = totalRows * (chunk + 1) / numChunks;
+        const bool isLhs = c < numColLhs;
+        if(schema[c] == ValueTypeCode::STR) {
+            cartesianFill<std::string>(resCols[c], argCols[c], isLhs, numRowRhs, begin, end);
+            return;
         }
-    }
+        switch(ValueTypeUtils::sizeOf(schema[c])) {
+            case 1: cartesianFill<uint8_t> (resCols[c], argCols[c], isLhs, numRowRhs, begin, end); break;
+            case 2: cartesianFill<uint16_t>(resCols[c], argCols[c], isLhs, numRowRhs, begin, end); break;
+            case 4: cartesianFill<uint32_t>(resCols[c], argCols[c], isLhs, numRowRhs, begin, end); break;
+            case 8: cartesianFill<uint64_t>(resCols[c], argCols[c], isLhs, numRowRhs, begin, end); break;
+            default:
+                throw std::runtime_error("cartesian: unsupported value type");
+        }
+    });
 }
 
 #endif //SRC_RUNTIME_LOCAL_KERNELS_CARTESIAN_H
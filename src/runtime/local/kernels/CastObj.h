@@ -18,11 +18,24 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_CASTOBJ_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -59,19 +72,54 @@ void castObj(DTRes *& res, const DTArg * arg, DCTX(ctx)) {
 template<typename VTRes>
 class CastObj<DenseMatrix<VTRes>, Frame> {
     
+    // The rows of a block of the result, which is written column by column,
+    // such that the cache lines of its rows stay in the L1 cache until they
+    // are complete (a cache-blocked transpose of the columnar frame).
+    static constexpr size_t BLOCK_ROWS = 64;
+    // The cells of the result handled by one task at least.
+    static constexpr size_t MIN_CHUNK_CELLS = 1 << 16;
+    
+    using CastBlockFn = void (*)(VTRes * valuesRes, size_t rowSkipRes, const void * argCol, size_t rowBegin,
+            size_t rowEnd);
+    
     /**
-     * @brief Casts the values of the input column at index `c` and stores the
-     * casted values to column `c` in the output matrix.
-     * @param res The output matrix.
-     * @param argFrm The input frame.
-     * @param c The position of the column to cast.
+     * @brief Casts the values of the given rows of an input column and stores
+     * the casted values to the corresponding rows of a column of the output
+     * matrix.
+     * @param valuesRes The values of the output column.
+     * @param rowSkipRes The row skip of the output matrix.
+     * @param argCol The values of the input column.
+     * @param rowBegin The first row to cast.
+     * @param rowEnd The row after the last row to cast.
      */
     template<typename VTArg>
-    static void castCol(DenseMatrix<VTRes> * res, const Frame * argFrm, size_t c) {
-        const size_t numRows = argFrm->getNumRows();
-        const DenseMatrix<VTArg> * argCol = argFrm->getColumn<VTArg>(c);
-        for(size_t r = 0; r < numRows; r++)
-            res->set(r, c, static_cast<VTRes>(argCol->get(r, 0)));
+    static void castBlock(VTRes * valuesRes, size_t rowSkipRes, const void * argCol, size_t rowBegin, size_t rowEnd) {
+        const VTArg * valuesArg = static_cast<const VTArg *>(argCol);
+        for(size_t r = rowBegin; r < rowEnd; r++)
+            valuesRes[r * rowSkipRes] = static_cast<VTRes>(valuesArg[r]);
+    }
+    
+    static CastBlockFn getCastBlock(ValueTypeCode vtc) {
+        // TODO We do not really need all cases.
+        // - All pairs of the same type can be handled by a single
+        //   copy-the-column helper function.
+        // - All pairs of (un)signed integer types of the same width
+        //   as well.
+        // - Truncating integers to a narrower type does not need to
+        //   consider (un)signedness either.
+        // - ...
+        switch(vtc) {
+            // For all value types:
+            case ValueTypeCode::F64: return castBlock<double>;
+            case ValueTypeCode::F32: return castBlock<float >;
+            case ValueTypeCode::SI64: return castBlock<int64_t>;
+            case ValueTypeCode::SI32: return castBlock<int32_t>;
+            case ValueTypeCode::SI8 : return castBlock<int8_t >;
+            case ValueTypeCode::UI64: return castBlock<uint64_t>;
+            case ValueTypeCode::UI32: return castBlock<uint32_t>;
+            case ValueTypeCode::UI8 : return castBlock<uint8_t >;
+            default: throw std::runtime_error("CastObj::apply: unknown value type code");
+        }
     }
     
 public:
@@ -91,31 +139,30 @@ public:
             // than the result.
             // Need to change column-major to row-major layout and/or cast the
             // individual values.
+            // The columns are materialized (e.g., decoded) and their casts
+            // are looked up before the parallel region.
+            std::vector<const void *> argCols(numCols);
+            std::vector<CastBlockFn> castBlocks(numCols);
+            for(size_t c = 0; c < numCols; c++) {
+                castBlocks[c] = getCastBlock(arg->getColumnType(c));
+                argCols[c] = arg->getColumnRaw(c);
+            }
             if(res == nullptr)
                 res = DataObjectFactory::create<DenseMatrix<VTRes>>(numRows, numCols, false);
-            // TODO We could run over the rows in blocks for cache efficiency.
-            for(size_t c = 0; c < numCols; c++) {
-                // TODO We do not really need all cases.
-                // - All pairs of the same type can be handled by a single
-                //   copy-the-column helper function.
-                // - All pairs of (un)signed integer types of the same width
-                //   as well.
-                // - Truncating integers to a narrower type does not need to
-                //   consider (un)signedness either.
-                // - ...
-                switch(arg->getColumnType(c)) {
-                    // For all value types:
-                    case ValueTypeCode::F64: castCol<double>(res, arg, c); break;
-                    case ValueTypeCode::F32: castCol<float >(res, arg, c); break;
-                    case ValueTypeCode::SI64: castCol<int64_t>(res, arg, c); break;
-                    case ValueTypeCode::SI32: castCol<int32_t>(res, arg, c); break;
-                    case ValueTypeCode::SI8 : castCol<int8_t >(res, arg, c); break;
-                    case ValueTypeCode::UI64: castCol<uint64_t>(res, arg, c); break;
-                    case ValueTypeCode::UI32: castCol<uint32_t>(res, arg, c); break;
-                    case ValueTypeCode::UI8 : castCol<uint8_t >(res, arg, c); break;
-                    default: throw std::runtime_error("CastObj::apply: unknown value type code");
+            VTRes * valuesRes = res->getValues();
+            const size_t rowSkipRes = res->getRowSkip();
+            
+            // Each task transposes the blocks of a chunk of rows.
+            const size_t numBlocks = (numRows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+            const size_t numChunks = std::max<size_t>(1, std::min(numBlocks, numRows * numCols / MIN_CHUNK_CELLS));
+            WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+                for(size_t b = numBlocks * chunk / numChunks; b < numBlocks * (chunk + 1) / numChunks; b++) {
+                    const size_t rowBegin = b * BLOCK_ROWS;
+                    const size_t rowEnd = std::min(rowBegin + BLOCK_ROWS, numRows);
+                    for(size_t c = 0; c < numCols; c++)
+                        castBlocks[c](valuesRes + c, rowSkipRes, argCols[c], rowBegin, rowEnd);
                 }
-            }
+            });
         }
     }
 };
@@ -255,4 +302,446 @@ public:
     }
 };
 
+// ----------------------------------------------------------------------------
+//  BlockedMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<BlockedMatrix<VT>, DenseMatrix<VT>> {
+
+public:
+    static void apply(BlockedMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        if(res == nullptr)
+            res = DataObjectFactory::create<BlockedMatrix<VT>>(arg->getNumRows(), arg->getNumCols());
+
+        const size_t blockSize = res->getBlockSize();
+        for(size_t rb = 0; rb < res->getNumRowBlocks(); rb++)
+            for(size_t cb = 0; cb < res->getNumColBlocks(); cb++) {
+                const size_t rows = res->getBlockNumRows(rb);
+                const size_t cols = res->getBlockNumCols(cb);
+                auto block = DataObjectFactory::create<DenseMatrix<VT>>(rows, cols, false);
+                const VT * argRow = arg->getValues() + rb * blockSize * arg->getRowSkip() + cb * blockSize;
+                VT * blockRow = block->getValues();
+                for(size_t r = 0; r < rows; r++, argRow += arg->getRowSkip(), blockRow += block->getRowSkip())
+                    std::copy(argRow, argRow + cols, blockRow);
+                res->setDenseBlock(rb, cb, block);
+                res->compactBlock(rb, cb);
+            }
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  BlockedMatrix <- CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<BlockedMatrix<VT>, CSRMatrix<VT>> {
+
+public:
+    static void apply(BlockedMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
+        if(res == nullptr)
+            res = DataObjectFactory::create<BlockedMatrix<VT>>(arg->getNumRows(), arg->getNumCols());
+
+        res->prepareAppend();
+        for(size_t r = 0; r < arg->getNumRows(); r++) {
+            const size_t rowNumNonZeros = arg->getNumNonZeros(r);
+            const size_t * rowColIdxs = arg->getColIdxs(r);
+            const VT * rowValues = arg->getValues(r);
+            for(size_t i = 0; i < rowNumNonZeros; i++)
+                res->append(r, rowColIdxs[i], rowValues[i]);
+        }
+        res->finishAppend();
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DenseMatrix <- BlockedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<DenseMatrix<VT>, BlockedMatrix<VT>> {
+
+public:
+    static void apply(DenseMatrix<VT> *& res, const BlockedMatrix<VT> * arg, DCTX(ctx)) {
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(arg->getNumRows(), arg->getNumCols(), false);
+
+        const size_t blockSize = arg->getBlockSize();
+        const size_t resRowSkip = res->getRowSkip();
+        for(size_t rb = 0; rb < arg->getNumRowBlocks(); rb++)
+            for(size_t cb = 0; cb < arg->getNumColBlocks(); cb++) {
+                const size_t rows = arg->getBlockNumRows(rb);
+                const size_t cols = arg->getBlockNumCols(cb);
+                VT * resRow = res->getValues() + rb * blockSize * resRowSkip + cb * blockSize;
+                if(auto dense = arg->getDenseBlock(rb, cb)) {
+                    const VT * blockRow = dense->getValues();
+                    for(size_t r = 0; r < rows; r++, resRow += resRowSkip, blockRow += dense->getRowSkip())
+                        std::copy(blockRow, blockRow + cols, resRow);
+                    continue;
+                }
+                auto sparse = arg->getSparseBlock(rb, cb);
+                for(size_t r = 0; r < rows; r++, resRow += resRowSkip) {
+                    std::fill(resRow, resRow + cols, VT(0));
+                    if(!sparse)
+                        continue;
+                    const size_t rowNumNonZeros = sparse->getNumNonZeros(r);
+                    const size_t * rowColIdxs = sparse->getColIdxs(r);
+                    const VT * rowValues = sparse->getValues(r);
+                    for(size_t i = 0; i < rowNumNonZeros; i++)
+                        resRow[rowColIdxs[i]] = rowValues[i];
+                }
+            }
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  CSRMatrix <- BlockedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<CSRMatrix<VT>, BlockedMatrix<VT>> {
+
+public:
+    static void apply(CSRMatrix<VT> *& res, const BlockedMatrix<VT> * arg, DCTX(ctx)) {
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(arg->getNumRows(), arg->getNumCols(),
+                    arg->getNumNonZeros(), false);
+
+        const size_t blockSize = arg->getBlockSize();
+        VT * values = res->getValues();
+        size_t * colIdxs = res->getColIdxs();
+        size_t * rowOffsets = res->getRowOffsets();
+        size_t pos = 0;
+        rowOffsets[0] = 0;
+        for(size_t r = 0; r < arg->getNumRows(); r++) {
+            const size_t rb = r / blockSize;
+            const size_t br = r % blockSize;
+            // the blocks of a row of blocks are visited in the order of their columns
+            for(size_t cb = 0; cb < arg->getNumColBlocks(); cb++) {
+                const size_t colOffset = cb * blockSize;
+                if(auto dense = arg->getDenseBlock(rb, cb)) {
+                    const VT * blockRow = dense->getValues() + br * dense->getRowSkip();
+                    for(size_t c = 0; c < arg->getBlockNumCols(cb); c++)
+                        if(blockRow[c] != VT(0)) {
+                            values[pos] = blockRow[c];
+                            colIdxs[pos] = colOffset + c;
+                            pos++;
+                        }
+                }
+                else if(auto sparse = arg->getSparseBlock(rb, cb)) {
+                    const size_t rowNumNonZeros = sparse->getNumNonZeros(br);
+                    const size_t * rowColIdxs = sparse->getColIdxs(br);
+                    const VT * rowValues = sparse->getValues(br);
+                    for(size_t i = 0; i < rowNumNonZeros; i++) {
+                        values[pos] = rowValues[i];
+                        colIdxs[pos] = colOffset + rowColIdxs[i];
+                        pos++;
+                    }
+                }
+            }
+            rowOffsets[r + 1] = pos;
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DCSRMatrix <- CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<DCSRMatrix<VT>, CSRMatrix<VT>> {
+
+public:
+    static void apply(DCSRMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
+        if(res == nullptr)
+            res = DataObjectFactory::create<DCSRMatrix<VT>>(arg->getNumRows(), arg->getNumCols(),
+                    arg->getNumNonZeros());
+
+        res->prepareAppend();
+        for(size_t r = 0; r < arg->getNumRows(); r++) {
+            const size_t rowNumNonZeros = arg->getNumNonZeros(r);
+            const size_t * rowColIdxs = arg->getColIdxs(r);
+            const VT * rowValues = arg->getValues(r);
+            for(size_t i = 0; i < rowNumNonZeros; i++)
+                res->append(r, rowColIdxs[i], rowValues[i]);
+        }
+        res->finishAppend();
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DCSRMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<DCSRMatrix<VT>, DenseMatrix<VT>> {
+
+public:
+    static void apply(DCSRMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DCSRMatrix<VT>>(numRows, numCols);
+
+        res->prepareAppend();
+        const VT * row = arg->getValues();
+        for(size_t r = 0; r < numRows; r++, row += arg->getRowSkip())
+            for(size_t c = 0; c < numCols; c++)
+                if(row[c] != VT(0))
+                    res->append(r, c, row[c]);
+        res->finishAppend();
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  CSRMatrix <- DCSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<CSRMatrix<VT>, DCSRMatrix<VT>> {
+
+public:
+    static void apply(CSRMatrix<VT> *& res, const DCSRMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numNonZeros = arg->getNumNonZeros();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, arg->getNumCols(), numNonZeros, false);
+
+        // the rows without non-zeros take the offset of the next row with some
+        const size_t * rowIdxsArg = arg->getRowIdxs();
+        const size_t * rowOffsetsArg = arg->getRowOffsets();
+        size_t * rowOffsets = res->getRowOffsets();
+        size_t i = 0;
+        for(size_t r = 0; r <= numRows; r++) {
+            while(i < arg->getNumNonZeroRows() && rowIdxsArg[i] < r)
+                i++;
+            rowOffsets[r] = rowOffsetsArg[i];
+        }
+        std::copy(arg->getColIdxs(), arg->getColIdxs() + numNonZeros, res->getColIdxs());
+        std::copy(arg->getValues(), arg->getValues() + numNonZeros, res->getValues());
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DenseMatrix <- DCSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<DenseMatrix<VT>, DCSRMatrix<VT>> {
+
+public:
+    static void apply(DenseMatrix<VT> *& res, const DCSRMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+        VT * values = res->getValues();
+        const size_t rowSkip = res->getRowSkip();
+        for(size_t r = 0; r < numRows; r++)
+            std::fill(values + r * rowSkip, values + r * rowSkip + numCols, VT(0));
+        const size_t * rowIdxs = arg->getRowIdxs();
+        const size_t * rowOffsets = arg->getRowOffsets();
+        const size_t * colIdxs = arg->getColIdxs();
+        const VT * valuesArg = arg->getValues();
+        for(size_t i = 0; i < arg->getNumNonZeroRows(); i++)
+            for(size_t k = rowOffsets[i]; k < rowOffsets[i + 1]; k++)
+                values[rowIdxs[i] * rowSkip + colIdxs[k]] = valuesArg[k];
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  CompressedMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Compresses the columns of a dense matrix for which a sample of the
+ * rows says that it pays off, the other columns stay uncompressed (see
+ * `CompressedMatrix`).
+ */
+template<typename VT>
+class CastObj<CompressedMatrix<VT>, DenseMatrix<VT>> {
+
+public:
+    static void apply(CompressedMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        if(res != nullptr)
+            throw std::runtime_error("CastObj: a CompressedMatrix cannot be overwritten, res must be nullptr");
+        res = DataObjectFactory::create<CompressedMatrix<VT>>(arg->getNumRows(), arg->getNumCols(), arg->getValues(),
+                arg->getRowSkip());
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DenseMatrix <- CompressedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<DenseMatrix<VT>, CompressedMatrix<VT>> {
+    // the number of rows decompressed at once
+    static constexpr size_t BLOCK_ROWS = 1024;
+
+public:
+    static void apply(DenseMatrix<VT> *& res, const CompressedMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, arg->getNumCols(), false);
+
+        VT * values = res->getValues();
+        const size_t rowSkip = res->getRowSkip();
+        WorkerPool::parallelFor(ctx, (numRows + BLOCK_ROWS - 1) / BLOCK_ROWS, [&](size_t b) {
+            const size_t rowBegin = b * BLOCK_ROWS;
+            arg->decompress(values + rowBegin * rowSkip, rowSkip, rowBegin, std::min(rowBegin + BLOCK_ROWS, numRows));
+        });
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DenseMatrixCM <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Transposes the layout of the values in square blocks, such that both
+ * the rows read and the columns written stay in the cache.
+ */
+template<typename VT>
+class CastObj<DenseMatrixCM<VT>, DenseMatrix<VT>> {
+    static constexpr size_t BLOCK_SIZE = 64;
+
+public:
+    static void apply(DenseMatrixCM<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numCols, false);
+
+        const VT * valuesArg = arg->getValues();
+        const size_t rowSkipArg = arg->getRowSkip();
+        VT * valuesRes = res->getValues();
+        const size_t colSkipRes = res->getColSkip();
+        WorkerPool::parallelFor(ctx, (numCols + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](size_t b) {
+            const size_t colBegin = b * BLOCK_SIZE;
+            const size_t colEnd = std::min(colBegin + BLOCK_SIZE, numCols);
+            for(size_t rowBegin = 0; rowBegin < numRows; rowBegin += BLOCK_SIZE) {
+                const size_t rowEnd = std::min(rowBegin + BLOCK_SIZE, numRows);
+                for(size_t c = colBegin; c < colEnd; c++)
+                    for(size_t r = rowBegin; r < rowEnd; r++)
+                        valuesRes[c * colSkipRes + r] = valuesArg[r * rowSkipArg + c];
+            }
+        });
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DenseMatrix <- DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class CastObj<DenseMatrix<VT>, DenseMatrixCM<VT>> {
+    static constexpr size_t BLOCK_SIZE = 64;
+
+public:
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrixCM<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+        const VT * valuesArg = arg->getValues();
+        const size_t colSkipArg = arg->getColSkip();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+        WorkerPool::parallelFor(ctx, (numRows + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](size_t b) {
+            const size_t rowBegin = b * BLOCK_SIZE;
+            const size_t rowEnd = std::min(rowBegin + BLOCK_SIZE, numRows);
+            for(size_t colBegin = 0; colBegin < numCols; colBegin += BLOCK_SIZE) {
+                const size_t colEnd = std::min(colBegin + BLOCK_SIZE, numCols);
+                for(size_t r = rowBegin; r < rowEnd; r++)
+                    for(size_t c = colBegin; c < colEnd; c++)
+                        valuesRes[r * rowSkipRes + c] = valuesArg[c * colSkipArg + r];
+            }
+        });
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  Frame <- DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Wraps the columns of a column-major matrix in a frame without copying
+ * them, the frame shares the values with the matrix.
+ */
+template<typename VT>
+class CastObj<Frame, DenseMatrixCM<VT>> {
+
+public:
+    static void apply(Frame *& res, const DenseMatrixCM<VT> * arg, DCTX(ctx)) {
+        const size_t numCols = arg->getNumCols();
+        std::shared_ptr<VT[]> values = arg->getValuesSharedPtr();
+        std::vector<ValueTypeCode> schema(numCols, ValueTypeUtils::codeFor<VT>);
+        std::vector<std::shared_ptr<uint8_t>> columns(numCols);
+        for(size_t c = 0; c < numCols; c++)
+            columns[c] = std::shared_ptr<uint8_t>(values, reinterpret_cast<uint8_t *>(values.get() + c * arg->getColSkip()));
+        res = DataObjectFactory::create<Frame>(arg->getNumRows(), numCols, schema.data(),
+                static_cast<const std::string *>(nullptr), columns.data(),
+                static_cast<const std::shared_ptr<const EncodedColumn> *>(nullptr));
+    }
+};
+
+// ----------------------------------------------------------------------------
+//  DenseMatrixCM <- Frame
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Converts a frame whose columns all have the value type of the result.
+ *
+ * If the columns are equidistant slices of one array (e.g., because the frame
+ * was created from a `DenseMatrixCM`), the result shares this array without
+ * copying it. Otherwise, each column is copied as a whole.
+ */
+template<typename VT>
+class CastObj<DenseMatrixCM<VT>, Frame> {
+
+public:
+    static void apply(DenseMatrixCM<VT> *& res, const Frame * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        for(size_t c = 0; c < numCols; c++)
+            if(arg->getColumnType(c) != ValueTypeUtils::codeFor<VT>)
+                throw std::runtime_error("CastObj: a DenseMatrixCM can only be created from a frame whose columns "
+                        "have its value type");
+
+        std::vector<std::shared_ptr<VT[]>> columns(numCols);
+        for(size_t c = 0; c < numCols; c++) {
+            const DenseMatrix<VT> * col = arg->getColumn<VT>(c);
+            columns[c] = col->getValuesSharedPtr();
+            DataObjectFactory::destroy(col);
+        }
+
+        if(res == nullptr && numCols > 0) {
+            const ptrdiff_t colSkip = numCols > 1 ? columns[1].get() - columns[0].get() : ptrdiff_t(numRows);
+            bool shared = colSkip >= ptrdiff_t(numRows);
+            for(size_t c = 1; shared && c < numCols; c++)
+                shared = columns[c].get() == columns[0].get() + c * colSkip
+                        && !columns[c].owner_before(columns[0]) && !columns[0].owner_before(columns[c]);
+            if(shared) {
+                res = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numCols, columns[0], size_t(colSkip));
+                return;
+            }
+        }
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numCols, false);
+        WorkerPool::parallelFor(ctx, numCols, [&](size_t c) {
+            std::copy(columns[c].get(), columns[c].get() + numRows, res->getColumn(c));
+        });
+    }
+};
+
 #endif //SRC_RUNTIME_LOCAL_KERNELS_CASTOBJ_H
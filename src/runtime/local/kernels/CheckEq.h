@@ -18,9 +18,19 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_CHECKEQ_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/ParallelScan.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include <cstddef>
 #include <cstring>
@@ -96,17 +106,16 @@ struct CheckEq<DenseMatrix<VT>> {
         if(valuesLhs == valuesRhs && rowSkipLhs == rowSkipRhs)
             return true;
         
+        // Large matrices are compared in parallel blocks, see ParallelScan.h.
         if(rowSkipLhs == numCols && rowSkipRhs == numCols)
-            return !memcmp(valuesLhs, valuesRhs, numRows * numCols * sizeof(VT));
-        else {
-            for(size_t r = 0; r < numRows; r++) {
-                if(memcmp(valuesLhs, valuesRhs, numCols * sizeof(VT)))
-                    return false;
-                valuesLhs += rowSkipLhs;
-                valuesRhs += rowSkipRhs;
-            }
-            return true;
-        }
+            return !ParallelScan::anyDifferentBytes(valuesLhs, valuesRhs, numRows * numCols * sizeof(VT), ctx);
+        else
+            return !ParallelScan::any("checkEq", numRows, numCols, [&](size_t begin, size_t end) {
+                for(size_t r = begin; r < end; r++)
+                    if(memcmp(valuesLhs + r * rowSkipLhs, valuesRhs + r * rowSkipRhs, numCols * sizeof(VT)))
+                        return true;
+                return false;
+            }, ctx);
     }
 };
 
@@ -138,20 +147,149 @@ struct CheckEq<CSRMatrix<VT>> {
             return false;
         
         if(valuesBegLhs != valuesBegRhs)
-            if(memcmp(valuesBegLhs, valuesBegRhs, nnzLhs * sizeof(VT)))
+            if(ParallelScan::anyDifferentBytes(valuesBegLhs, valuesBegRhs, nnzLhs * sizeof(VT), ctx))
                 return false;
         
         const size_t * colIdxsBegLhs = lhs->getColIdxs(0);
         const size_t * colIdxsBegRhs = rhs->getColIdxs(0);
         
         if(colIdxsBegLhs != colIdxsBegRhs)
-            if(memcmp(colIdxsBegLhs, colIdxsBegRhs, nnzLhs * sizeof(size_t)))
+            if(ParallelScan::anyDifferentBytes(colIdxsBegLhs, colIdxsBegRhs, nnzLhs * sizeof(size_t), ctx))
                 return false;
         
         return true;
     }
 };
 
+// ----------------------------------------------------------------------------
+// BlockedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct CheckEq<BlockedMatrix<VT>> {
+    static bool apply(const BlockedMatrix<VT> * lhs, const BlockedMatrix<VT> * rhs, DCTX(ctx)) {
+        if(lhs == rhs)
+            return true;
+
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+
+        if(numRows != rhs->getNumRows() || numCols != rhs->getNumCols())
+            return false;
+
+        // the blocks are compared logically, regardless of their representation
+        if(lhs->getBlockSize() != rhs->getBlockSize()) {
+            for(size_t r = 0; r < numRows; r++)
+                for(size_t c = 0; c < numCols; c++)
+                    if(lhs->get(r, c) != rhs->get(r, c))
+                        return false;
+            return true;
+        }
+        for(size_t rb = 0; rb < lhs->getNumRowBlocks(); rb++)
+            for(size_t cb = 0; cb < lhs->getNumColBlocks(); cb++) {
+                const DenseMatrix<VT> * blockLhs = lhs->getBlockAsDense(rb, cb);
+                const DenseMatrix<VT> * blockRhs = rhs->getBlockAsDense(rb, cb);
+                const bool equal = CheckEq<DenseMatrix<VT>>::apply(blockLhs, blockRhs, ctx);
+                DataObjectFactory::destroy(blockLhs, blockRhs);
+                if(!equal)
+                    return false;
+            }
+        return true;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DCSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct CheckEq<DCSRMatrix<VT>> {
+    static bool apply(const DCSRMatrix<VT> * lhs, const DCSRMatrix<VT> * rhs, DCTX(ctx)) {
+        if(lhs == rhs)
+            return true;
+
+        if(lhs->getNumRows() != rhs->getNumRows() || lhs->getNumCols() != rhs->getNumCols())
+            return false;
+
+        // zeros are never stored and the column indexes are sorted, so equal matrices have equal arrays
+        const size_t numNonZeroRows = lhs->getNumNonZeroRows();
+        const size_t numNonZeros = lhs->getNumNonZeros();
+        if(numNonZeroRows != rhs->getNumNonZeroRows() || numNonZeros != rhs->getNumNonZeros())
+            return false;
+
+        return std::equal(lhs->getRowIdxs(), lhs->getRowIdxs() + numNonZeroRows, rhs->getRowIdxs())
+                && std::equal(lhs->getRowOffsets(), lhs->getRowOffsets() + numNonZeroRows + 1, rhs->getRowOffsets())
+                && std::equal(lhs->getColIdxs(), lhs->getColIdxs() + numNonZeros, rhs->getColIdxs())
+                && std::equal(lhs->getValues(), lhs->getValues() + numNonZeros, rhs->getValues());
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CompressedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct CheckEq<CompressedMatrix<VT>> {
+    static bool apply(const CompressedMatrix<VT> * lhs, const CompressedMatrix<VT> * rhs, DCTX(ctx)) {
+        if(lhs == rhs)
+            return true;
+
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+        if(numRows != rhs->getNumRows() || numCols != rhs->getNumCols())
+            return false;
+
+        // equal matrices may be encoded differently, so their rows are compared
+        std::vector<VT> rowLhs(numCols);
+        std::vector<VT> rowRhs(numCols);
+        for(size_t r = 0; r < numRows; r++) {
+            lhs->decompress(rowLhs.data(), numCols, r, r + 1);
+            rhs->decompress(rowRhs.data(), numCols, r, r + 1);
+            if(rowLhs != rowRhs)
+                return false;
+        }
+        return true;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct CheckEq<DenseMatrixCM<VT>> {
+    static bool apply(const DenseMatrixCM<VT> * lhs, const DenseMatrixCM<VT> * rhs, DCTX(ctx)) {
+        if(lhs == rhs)
+            return true;
+
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+        if(numRows != rhs->getNumRows() || numCols != rhs->getNumCols())
+            return false;
+
+        for(size_t c = 0; c < numCols; c++)
+            if(!std::equal(lhs->getColumn(c), lhs->getColumn(c) + numRows, rhs->getColumn(c)))
+                return false;
+        return true;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// BitMatrix
+// ----------------------------------------------------------------------------
+
+template<>
+struct CheckEq<BitMatrix> {
+    static bool apply(const BitMatrix * lhs, const BitMatrix * rhs, DCTX(ctx)) {
+        if(lhs == rhs)
+            return true;
+        if(lhs->getNumRows() != rhs->getNumRows() || lhs->getNumCols() != rhs->getNumCols())
+            return false;
+        // the bits beyond the last cell are zero in both
+        return std::equal(lhs->getWords(), lhs->getWords() + lhs->getNumWords(), rhs->getWords());
+    }
+};
+
 // ----------------------------------------------------------------------------
 // Frame
 // ----------------------------------------------------------------------------
@@ -205,6 +343,13 @@ template <> struct CheckEq<Frame> {
                 case ValueTypeCode::UI8 : if (!checkEq(lhs->getColumn<uint8_t>(c),
                     rhs->getColumn<uint8_t>(c), ctx)) return false;
                     break;
+                case ValueTypeCode::STR: {
+                    const std::string * valuesLhs = static_cast<const std::string *>(lhs->getColumnRaw(c));
+                    const std::string * valuesRhs = static_cast<const std::string *>(rhs->getColumnRaw(c));
+                    if(!std::equal(valuesLhs, valuesLhs + numRows, valuesRhs))
+                        return false;
+                    break;
+                }
                 default:
                     throw std::runtime_error("CheckEq::apply: unknown value type code");
             }
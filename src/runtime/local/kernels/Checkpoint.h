@@ -0,0 +1,180 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_CHECKPOINT_H
+#define SRC_RUNTIME_LOCAL_KERNELS_CHECKPOINT_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/io/ReadDaphne.h>
+#include <runtime/local/io/WriteDaphne.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <cstddef>
+
+// ****************************************************************************
+// Checkpoints of the state of loops
+// ****************************************************************************
+// The values updated by a loop (see CheckpointLoopsPass) are saved after an
+// iteration into the directory of the loop as Daphne binary files, one per
+// value:
+//
+//     <dir>/latest        the generation and iteration of the last checkpoint
+//     <dir>/gen<g>/<i>.dbdf
+//     <dir>/next/<i>.dbdf the checkpoint being saved
+//
+// A checkpoint is only used once it is complete: the files are saved into
+// `next`, which is renamed to the next generation, and then `latest` is
+// replaced atomically. A program that is run again, e.g., after a failure,
+// restores the values of the last checkpoint and resumes the loop after its
+// iteration.
+
+namespace CheckpointUtils {
+    struct Latest {
+        size_t generation;
+        size_t iteration;
+    };
+
+    /**
+     * @brief Reads the last checkpoint of the loop of the given directory, returning whether there is one.
+     */
+    inline bool readLatest(const std::filesystem::path &dir, Latest &latest) {
+        std::ifstream ifs(dir / "latest");
+        return static_cast<bool>(ifs >> latest.generation >> latest.iteration);
+    }
+
+    inline std::filesystem::path generationDir(const std::filesystem::path &dir, size_t generation) {
+        return dir / ("gen" + std::to_string(generation));
+    }
+
+    inline std::filesystem::path valueFile(const std::filesystem::path &genDir, size_t index) {
+        return genDir / (std::to_string(index) + ".dbdf");
+    }
+
+    // the time of the last checkpoint of each loop, or of its first iteration
+    inline std::map<std::string, std::chrono::steady_clock::time_point> & lastCheckpoints() {
+        static std::map<std::string, std::chrono::steady_clock::time_point> times;
+        return times;
+    }
+}
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Whether a checkpoint of the loop of the given directory is due, i.e., `checkpoint_interval_s` seconds have
+ * passed since its last one (or since its first iteration).
+ */
+inline bool checkpointDue(const char * dir, DCTX(ctx)) {
+    const auto now = std::chrono::steady_clock::now();
+    auto it = CheckpointUtils::lastCheckpoints().emplace(dir, now).first;
+    return std::chrono::duration<double>(now - it->second).count() >= ctx->config.checkpoint_interval_s;
+}
+
+/**
+ * @brief Saves the value of the given index of the next checkpoint of the loop of the given directory, which only
+ * counts once it is committed.
+ */
+template<class DTArg>
+void checkpointSave(const DTArg * arg, const char * dir, size_t index, DCTX(ctx)) {
+    namespace fs = std::filesystem;
+    const fs::path next = fs::path(dir) / "next";
+    if(index == 0) {
+        // the remains of a checkpoint that was not committed
+        fs::remove_all(next);
+        fs::create_directories(next);
+    }
+    DF_options opts;
+    opts.rowsPerBlock = ctx->config.daphne_file_block_rows;
+    opts.compression = DF_compressionFromString(ctx->config.daphne_file_compression);
+    opts.ctx = ctx;
+    writeDaphne(arg, CheckpointUtils::valueFile(next, index).c_str(), opts);
+}
+
+/**
+ * @brief Makes the saved values the last checkpoint of the loop of the given directory, taken after the given
+ * iteration (of a for-loop, or 0).
+ */
+inline void checkpointCommit(const char * dir, size_t iteration, DCTX(ctx)) {
+    namespace fs = std::filesystem;
+    const fs::path loopDir(dir);
+    CheckpointUtils::Latest latest{0, 0};
+    const bool hasPrevious = CheckpointUtils::readLatest(loopDir, latest);
+    const size_t generation = hasPrevious ? latest.generation + 1 : 0;
+    const fs::path genDir = CheckpointUtils::generationDir(loopDir, generation);
+    fs::remove_all(genDir);
+    fs::rename(loopDir / "next", genDir);
+    {
+        std::ofstream ofs(loopDir / "latest.tmp", std::ios::trunc);
+        ofs << generation << ' ' << iteration << std::endl;
+        if(!ofs)
+            throw std::runtime_error("checkpointCommit: cannot write the checkpoint of " + loopDir.string());
+    }
+    fs::rename(loopDir / "latest.tmp", loopDir / "latest");
+    if(hasPrevious)
+        fs::remove_all(CheckpointUtils::generationDir(loopDir, latest.generation));
+    CheckpointUtils::lastCheckpoints()[dir] = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief The value of the given index of the last checkpoint of the loop of the given directory, or the given
+ * initial value of the loop if there is no checkpoint.
+ */
+template<class DTRes>
+void checkpointRestore(DTRes *& res, const DTRes * init, const char * dir, size_t index, DCTX(ctx)) {
+    const std::filesystem::path loopDir(dir);
+    CheckpointUtils::Latest latest;
+    if(!CheckpointUtils::readLatest(loopDir, latest)) {
+        res = const_cast<DTRes *>(init);
+        res->increaseRefCounter();
+        return;
+    }
+    const auto file = CheckpointUtils::valueFile(CheckpointUtils::generationDir(loopDir, latest.generation), index);
+    readDaphne(res, file.c_str(), false, ctx);
+    if(res->getNumCols() != init->getNumCols())
+        throw std::runtime_error("checkpointRestore: the checkpoint " + file.string()
+                + " does not match the program, whose checkpoints must be removed");
+}
+
+/**
+ * @brief The first iteration of a for-loop with the given lower bound and step, which is the one after the last
+ * checkpoint of the loop of the given directory, if any.
+ */
+inline size_t checkpointResume(size_t lowerBound, size_t step, const char * dir, DCTX(ctx)) {
+    CheckpointUtils::Latest latest;
+    if(!CheckpointUtils::readLatest(dir, latest))
+        return lowerBound;
+    return latest.iteration + step;
+}
+
+/**
+ * @brief Removes the checkpoints of the loop of the given directory after the loop finished, such that the loop
+ * starts over if the program is run again.
+ */
+inline void checkpointClear(const char * dir, DCTX(ctx)) {
+    std::filesystem::remove_all(dir);
+    CheckpointUtils::lastCheckpoints().erase(dir);
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_CHECKPOINT_H
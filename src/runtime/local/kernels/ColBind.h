@@ -20,10 +20,12 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 
-#include <cassert>
+#include <stdexcept>
+
 #include <cstddef>
 #include <cstring>
 
@@ -53,24 +55,93 @@ void colBind(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, DCTX(ctx)) {
 // DenseMatrix <- DenseMatrix, DenseMatrix
 // ----------------------------------------------------------------------------
 
+/**
+ * @brief Helpers of `ColBind` and `RowBind` on dense matrices, which avoid
+ * copying the values where possible.
+ */
+namespace BindBlocks {
+    template<typename VT>
+    bool shareValues(const DenseMatrix<VT> * a, const DenseMatrix<VT> * b) {
+        auto valuesA = a->getValuesSharedPtr();
+        auto valuesB = b->getValuesSharedPtr();
+        return valuesA && valuesB && !valuesA.owner_before(valuesB) && !valuesB.owner_before(valuesA);
+    }
+
+    /**
+     * @brief The number of spare columns to reserve for a result of
+     * `ColBind` with the given number of columns, which later calls may
+     * append columns to in place.
+     */
+    inline size_t getNumReservedCols(size_t numCols) {
+        return numCols / 4 + 1;
+    }
+
+    /**
+     * @brief The number of spare rows to reserve for a result of `RowBind`
+     * with the given number of rows, which later calls may append rows to in
+     * place.
+     *
+     * The capacity grows geometrically, such that appending rows one block
+     * at a time (e.g., in a loop) costs amortised constant time per row.
+     */
+    inline size_t getNumReservedRows(size_t numRows) {
+        return numRows / 2 + 1;
+    }
+}
+
 template<typename VT>
 struct ColBind<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
     static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
         const size_t numRows = lhs->getNumRows();
-        assert((numRows == rhs->getNumRows()) && "lhs and rhs must have the same number of rows");
+        if(numRows != rhs->getNumRows())
+            throw std::runtime_error("lhs and rhs must have the same number of rows");
         
         const size_t numColsLhs = lhs->getNumCols();
         const size_t numColsRhs = rhs->getNumCols();
-        
-        if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numColsLhs + numColsRhs, false);
+        const size_t numColsRes = numColsLhs + numColsRhs;
         
         const VT * valuesLhs = lhs->getValues();
         const VT * valuesRhs = rhs->getValues();
-        VT * valuesRes = res->getValues();
         
         const size_t rowSkipLhs = lhs->getRowSkip();
         const size_t rowSkipRhs = rhs->getRowSkip();
+        
+        if(res == nullptr) {
+            // The columns of rhs directly follow those of lhs in the same
+            // values (e.g., both are column slices of the same matrix), such
+            // that the result is a view on them.
+            if(valuesLhs + numColsLhs == valuesRhs && rowSkipLhs == rowSkipRhs
+                    && lhs->getNumSpareCols() >= numColsRhs && BindBlocks::shareValues(lhs, rhs)) {
+                res = DataObjectFactory::create<DenseMatrix<VT>>(lhs, numRows, numColsRes);
+                return;
+            }
+            // lhs is not used afterwards and has spare columns for rhs (e.g.,
+            // it is the result of a previous `cbind` in a loop), such that rhs
+            // is appended in place and the result is a view on the values of
+            // lhs, which it takes over when lhs is released after this call.
+            if(lhs->isOverwritable() && lhs->getNumSpareCols() >= numColsRhs) {
+                VT * valuesRes = const_cast<VT *>(valuesLhs) + numColsLhs;
+                for(size_t r = 0; r < numRows; r++) {
+                    memcpy(valuesRes, valuesRhs, numColsRhs * sizeof(VT));
+                    valuesRhs += rowSkipRhs;
+                    valuesRes += rowSkipLhs;
+                }
+                res = DataObjectFactory::create<DenseMatrix<VT>>(lhs, numRows, numColsRes);
+                return;
+            }
+            // A result replacing lhs may be extended by further columns, so
+            // spare columns are reserved for appending them in place.
+            if(lhs->isAtLastUse()) {
+                auto base = DataObjectFactory::create<DenseMatrix<VT>>(
+                        numRows, numColsRes + BindBlocks::getNumReservedCols(numColsRes), false);
+                res = DataObjectFactory::create<DenseMatrix<VT>>(base, 0, numRows, 0, numColsRes);
+                DataObjectFactory::destroy(base);
+            }
+            else
+                res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numColsRes, false);
+        }
+        
+        VT * valuesRes = res->getValues();
         const size_t rowSkipRes = res->getRowSkip();
         
         for(size_t r = 0; r < numRows; r++) {
@@ -83,6 +154,44 @@ struct ColBind<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
     }
 };
 
+// ----------------------------------------------------------------------------
+// DenseMatrixCM <- DenseMatrixCM, DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct ColBind<DenseMatrixCM<VT>, DenseMatrixCM<VT>, DenseMatrixCM<VT>> {
+    static void apply(DenseMatrixCM<VT> *& res, const DenseMatrixCM<VT> * lhs, const DenseMatrixCM<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        if(numRows != rhs->getNumRows())
+            throw std::runtime_error("lhs and rhs must have the same number of rows");
+
+        const size_t numColsLhs = lhs->getNumCols();
+        const size_t numColsRhs = rhs->getNumCols();
+        const size_t numColsRes = numColsLhs + numColsRhs;
+
+        if(res == nullptr) {
+            // The columns of rhs directly follow those of lhs in the same
+            // values (e.g., both are column slices of the same matrix), such
+            // that the result is a view on them.
+            auto valuesLhs = lhs->getValuesSharedPtr();
+            auto valuesRhs = rhs->getValuesSharedPtr();
+            if(numColsLhs > 0 && lhs->getColSkip() == rhs->getColSkip()
+                    && valuesLhs.get() + numColsLhs * lhs->getColSkip() == valuesRhs.get()
+                    && !valuesLhs.owner_before(valuesRhs) && !valuesRhs.owner_before(valuesLhs)) {
+                res = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numColsRes, valuesLhs, lhs->getColSkip());
+                return;
+            }
+            res = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numColsRes, false);
+        }
+
+        // Each column is copied as a whole.
+        for(size_t c = 0; c < numColsLhs; c++)
+            memcpy(res->getColumn(c), lhs->getColumn(c), numRows * sizeof(VT));
+        for(size_t c = 0; c < numColsRhs; c++)
+            memcpy(res->getColumn(numColsLhs + c), rhs->getColumn(c), numRows * sizeof(VT));
+    }
+};
+
 // ----------------------------------------------------------------------------
 // Frame <- Frame, Frame
 // ----------------------------------------------------------------------------
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/ColumnStatistics.h>
+#include <runtime/local/kernels/NumDistinctApproxHll.h>
+#include <runtime/local/kernels/QuantileApprox.h>
+#include <util/DeduceType.h>
+#include <util/FlatHashMap.h>
+#include <util/HyperLogLog.h>
+#include <util/KllSketch.h>
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTArg>
+struct CollectColumnStatistics {
+    static std::vector<ColumnStatistics> apply(const DTArg * arg, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Returns the statistics of each column of `arg` (see
+ * `ColumnStatistics`), computed by the HyperLogLog sketches of
+ * `numDistinctApproxHll` and the KLL sketches of `quantileApprox` on all
+ * threads.
+ */
+template<class DTArg>
+std::vector<ColumnStatistics> collectColumnStatistics(const DTArg * arg, DCTX(ctx)) {
+    return CollectColumnStatistics<DTArg>::apply(arg, ctx);
+}
+
+// ****************************************************************************
+// Helpers
+// ****************************************************************************
+
+template<typename VT>
+struct CollectColumnStatisticsColumn {
+    static void apply(ColumnStatistics & res, const Frame * arg, size_t c, DCTX(ctx)) {
+        const VT * values = static_cast<const VT *>(arg->getColumnRaw(c));
+        const size_t numRows = arg->getNumRows();
+        HyperLogLog hll;
+        const uint64_t seed = flatHashMix(0);
+        numDistinctHllParallel(hll, numRows, 1, [&](HyperLogLog & chunk, size_t begin, size_t end) {
+            numDistinctHllAdd(chunk, values + begin, values + end, seed);
+        }, ctx);
+        size_t numNonNull = numRows;
+        if constexpr(std::is_arithmetic<VT>::value) {
+            KllSketch sketch;
+            quantileApproxSketch(sketch, values, numRows, 1, ctx);
+            numNonNull = sketch.getN();
+            if(!sketch.empty()) {
+                res.min = sketch.getMin();
+                res.max = sketch.getMax();
+                if(res.min < res.max)
+                    res.histogram = sketch.equiDepthBounds(ColumnStatistics::NUM_BUCKETS);
+            }
+        }
+        res.nullFraction = numRows ? 1.0 - static_cast<double>(numNonNull) / numRows : 0.0;
+        // the NaNs hash alike, but are not a distinct value
+        double numDistinct = std::round(hll.estimate()) - (numNonNull < numRows);
+        numDistinct = std::min(numDistinct, static_cast<double>(numNonNull));
+        res.numDistinct = static_cast<ssize_t>(std::max(numDistinct, numNonNull ? 1.0 : 0.0));
+    }
+};
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
+
+template<>
+struct CollectColumnStatistics<Frame> {
+    static std::vector<ColumnStatistics> apply(const Frame * arg, DCTX(ctx)) {
+        std::vector<ColumnStatistics> res(arg->getNumCols());
+        for(size_t c = 0; c < arg->getNumCols(); c++)
+            if(arg->getColumnType(c) == ValueTypeCode::STR)
+                CollectColumnStatisticsColumn<std::string>::apply(res[c], arg, c, ctx);
+            else
+                DeduceValueTypeAndExecute<CollectColumnStatisticsColumn>::apply(arg->getColumnType(c), res[c], arg,
+                        c, ctx);
+        return res;
+    }
+};
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/BitMask.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTCond, class DTThen, class DTElse>
+struct CondMatMatMat {
+    static void apply(DTRes *& res, const DTCond * cond, const DTThen * thenVal, const DTElse * elseVal,
+            DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Selects each cell of the result from `thenVal` where `cond` is non-zero and from `elseVal` otherwise, i.e.,
+ * blends the two matrices by the mask `cond`.
+ */
+template<class DTRes, class DTCond, class DTThen, class DTElse>
+void condMatMatMat(DTRes *& res, const DTCond * cond, const DTThen * thenVal, const DTElse * elseVal, DCTX(ctx)) {
+    CondMatMatMat<DTRes, DTCond, DTThen, DTElse>::apply(res, cond, thenVal, elseVal, ctx);
+}
+
+// ****************************************************************************
+// Functions called by multiple template specializations
+// ****************************************************************************
+
+template<class DTCond, typename VT>
+void condMatMatMatCheckShapes(const DTCond * cond, const DenseMatrix<VT> * thenVal, const DenseMatrix<VT> * elseVal) {
+    const size_t numRows = cond->getNumRows();
+    const size_t numCols = cond->getNumCols();
+    if(numRows != thenVal->getNumRows() || numCols != thenVal->getNumCols()
+            || numRows != elseVal->getNumRows() || numCols != elseVal->getNumCols())
+        throw std::runtime_error("CondMatMatMat - cond, thenVal and elseVal must have the same dimensions.");
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix, DenseMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT, typename VTCond>
+struct CondMatMatMat<DenseMatrix<VT>, DenseMatrix<VTCond>, DenseMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VTCond> * cond, const DenseMatrix<VT> * thenVal,
+            const DenseMatrix<VT> * elseVal, DCTX(ctx)) {
+        condMatMatMatCheckShapes(cond, thenVal, elseVal);
+        const size_t numRows = cond->getNumRows();
+        const size_t numCols = cond->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+        const VTCond * valuesCond = cond->getValues();
+        const VT * valuesThen = thenVal->getValues();
+        const VT * valuesElse = elseVal->getValues();
+        VT * valuesRes = res->getValues();
+        for(size_t r = 0; r < numRows; r++) {
+            for(size_t c = 0; c < numCols; c++)
+                valuesRes[c] = valuesCond[c] != VTCond(0) ? valuesThen[c] : valuesElse[c];
+            valuesCond += cond->getRowSkip();
+            valuesThen += thenVal->getRowSkip();
+            valuesElse += elseVal->getRowSkip();
+            valuesRes += res->getRowSkip();
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- BitMatrix, DenseMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * Blends 64 cells per word of the mask, such that the compiler can turn the selection into vector blends; a word
+ * whose bits are all set or all clear is copied from one side. The words are processed in parallel chunks (see
+ * `BitMask`).
+ */
+template<typename VT>
+struct CondMatMatMat<DenseMatrix<VT>, BitMatrix, DenseMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const BitMatrix * cond, const DenseMatrix<VT> * thenVal,
+            const DenseMatrix<VT> * elseVal, DCTX(ctx)) {
+        condMatMatMatCheckShapes(cond, thenVal, elseVal);
+        const size_t numRows = cond->getNumRows();
+        const size_t numCols = cond->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+        const size_t numCells = numRows * numCols;
+        const size_t numWords = cond->getNumWords();
+        const uint64_t * words = cond->getWords();
+        const VT * valuesThen = thenVal->getValues();
+        const VT * valuesElse = elseVal->getValues();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipThen = thenVal->getRowSkip();
+        const size_t rowSkipElse = elseVal->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+        const bool contiguous = rowSkipThen == numCols && rowSkipElse == numCols && rowSkipRes == numCols;
+
+        WorkerPool::parallelFor(ctx, BitMask::getNumChunks(numWords), [&](size_t chunk) {
+            const size_t endWord = std::min(numWords, (chunk + 1) * BitMask::CHUNK_WORDS);
+            for(size_t w = chunk * BitMask::CHUNK_WORDS; w < endWord; w++) {
+                const size_t begin = w * 64;
+                const size_t n = std::min<size_t>(64, numCells - begin);
+                const uint64_t word = words[w];
+                if(!contiguous) {
+                    for(size_t j = 0; j < n; j++) {
+                        const size_t r = (begin + j) / numCols;
+                        const size_t c = (begin + j) % numCols;
+                        valuesRes[r * rowSkipRes + c] = (word >> j) & 1
+                                ? valuesThen[r * rowSkipThen + c] : valuesElse[r * rowSkipElse + c];
+                    }
+                    continue;
+                }
+                if(word == 0)
+                    std::copy(valuesElse + begin, valuesElse + begin + n, valuesRes + begin);
+                else if(n == 64 && word == ~uint64_t(0))
+                    std::copy(valuesThen + begin, valuesThen + begin + n, valuesRes + begin);
+                else
+                    for(size_t j = 0; j < n; j++)
+                        valuesRes[begin + j] = (word >> j) & 1 ? valuesThen[begin + j] : valuesElse[begin + j];
+            }
+        });
+    }
+};
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "runtime/local/context/DaphneContext.h"
+#include "runtime/local/datastructures/DataObjectFactory.h"
+#include "runtime/local/datastructures/DenseMatrix.h"
+#include "runtime/local/vectorized/WorkerPool.h"
+
+#include <cblas.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace Convolution {
+    template<typename DTRes, typename DTArg>
+    struct Forward {
+        static void apply(DTRes *&res, size_t& res_h, size_t& res_w, const DTArg *data, const DTArg *filter,
+                const DTArg *bias, size_t batch_size, size_t num_channels, size_t img_h, size_t img_w,
+                size_t filter_h, size_t filter_w, size_t stride_h, size_t stride_w, size_t pad_h, size_t pad_w,
+                DCTX(dctx)) { throw std::runtime_error("C++ convolution not implemented for these data types"); }
+    };
+
+    /**
+     * @brief Convolves each image (a row of `data` in NCHW layout) with the filters (the rows of `filter`, in CRS
+     * layout), like the CUDA kernel: the result has a row of F x P x Q values per image, and the bias (a value per
+     * filter) is only added if it is not the filter itself (the DaphneDSL `conv2d` passes no bias).
+     *
+     * The images are convolved in parallel. 3 x 3 filters with a stride of 1 use Winograd's minimal filtering
+     * F(2 x 2, 3 x 3), which needs 16 instead of 36 multiplications per 2 x 2 outputs: the filters and the tiles of
+     * the image are transformed once, and the products of all filters and channels are 16 matrix multiplications. All
+     * other filters are convolved as one matrix multiplication of the filters with the patches of the image (im2col).
+     * The matrix multiplications are done by BLAS.
+     */
+    template<typename VT>
+    struct Forward<DenseMatrix<VT>, DenseMatrix<VT>> {
+        static void apply(DenseMatrix<VT> *&res, size_t& res_h, size_t& res_w, const DenseMatrix<VT> *data,
+                const DenseMatrix<VT> *filter, const DenseMatrix<VT> *bias, size_t batch_size, size_t num_channels,
+                size_t img_h, size_t img_w, size_t filter_h, size_t filter_w, size_t stride_h, size_t stride_w,
+                size_t pad_h, size_t pad_w, DCTX(dctx)) {
+            if(filter_h == 3 && filter_w == 3 && stride_h == 1 && stride_w == 1)
+                applyWinograd(res, res_h, res_w, data, filter, bias, batch_size, num_channels, img_h, img_w, pad_h,
+                        pad_w, dctx);
+            else
+                applyIm2col(res, res_h, res_w, data, filter, bias, batch_size, num_channels, img_h, img_w, filter_h,
+                        filter_w, stride_h, stride_w, pad_h, pad_w, dctx);
+        }
+
+        /**
+         * @brief Convolves by a matrix multiplication of the filters (F x CRS) with the patches of each image
+         * (CRS x PQ).
+         */
+        static void applyIm2col(DenseMatrix<VT> *&res, size_t& res_h, size_t& res_w, const DenseMatrix<VT> *data,
+                const DenseMatrix<VT> *filter, const DenseMatrix<VT> *bias, size_t batch_size, size_t num_channels,
+                size_t img_h, size_t img_w, size_t filter_h, size_t filter_w, size_t stride_h, size_t stride_w,
+                size_t pad_h, size_t pad_w, DCTX(dctx)) {
+            const size_t C = num_channels;
+            const size_t RS = filter_h * filter_w;
+            const size_t CRS = C * RS;
+            checkArgs(data, filter, bias, C, img_h, img_w, filter_h, filter_w, stride_h, stride_w, pad_h, pad_w);
+            const size_t F = filter->getNumRows();
+            const size_t P = getPQ(img_h, filter_h, pad_h, stride_h);
+            const size_t Q = getPQ(img_w, filter_w, pad_w, stride_w);
+            const size_t PQ = P * Q;
+            res_h = P;
+            res_w = Q;
+            if(res == nullptr)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(batch_size, F * PQ, false);
+
+            WorkerPool::parallelFor(dctx, batch_size, [&](size_t n) {
+                const VT *img = data->getValues() + n * data->getRowSkip();
+                std::vector<VT> patches(CRS * PQ);
+                for(size_t c = 0; c < C; c++)
+                    for(size_t r = 0; r < filter_h; r++)
+                        for(size_t s = 0; s < filter_w; s++) {
+                            VT *row = patches.data() + (c * RS + r * filter_w + s) * PQ;
+                            for(size_t p = 0; p < P; p++) {
+                                // the image cell of output (p, q) is (p * stride_h + r - pad_h, q * stride_w + s - pad_w)
+                                const size_t h = p * stride_h + r;
+                                if(h < pad_h || h >= img_h + pad_h) {
+                                    std::fill_n(row + p * Q, Q, VT(0));
+                                    continue;
+                                }
+                                const VT *imgRow = img + (c * img_h + h - pad_h) * img_w;
+                                for(size_t q = 0; q < Q; q++) {
+                                    const size_t w = q * stride_w + s;
+                                    row[p * Q + q] = (w < pad_w || w >= img_w + pad_w) ? VT(0) : imgRow[w - pad_w];
+                                }
+                            }
+                        }
+                VT *out = res->getValues() + n * res->getRowSkip();
+                gemm(F, PQ, CRS, filter->getValues(), filter->getRowSkip(), patches.data(), PQ, out, PQ);
+                addBias(out, filter, bias, F, PQ);
+            });
+        }
+
+        /**
+         * @brief Convolves with 3 x 3 filters and a stride of 1 by Winograd's F(2 x 2, 3 x 3), see `apply`.
+         */
+        static void applyWinograd(DenseMatrix<VT> *&res, size_t& res_h, size_t& res_w, const DenseMatrix<VT> *data,
+                const DenseMatrix<VT> *filter, const DenseMatrix<VT> *bias, size_t batch_size, size_t num_channels,
+                size_t img_h, size_t img_w, size_t pad_h, size_t pad_w, DCTX(dctx)) {
+            const size_t C = num_channels;
+            checkArgs(data, filter, bias, C, img_h, img_w, 3, 3, 1, 1, pad_h, pad_w);
+            const size_t F = filter->getNumRows();
+            const size_t P = getPQ(img_h, 3, pad_h, 1);
+            const size_t Q = getPQ(img_w, 3, pad_w, 1);
+            const size_t PQ = P * Q;
+            res_h = P;
+            res_w = Q;
+            if(res == nullptr)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(batch_size, F * PQ, false);
+
+            // the transformed filters G g G^T, as 16 matrices of F x C
+            std::vector<VT> U(16 * F * C);
+            for(size_t f = 0; f < F; f++)
+                for(size_t c = 0; c < C; c++) {
+                    const VT *g = filter->getValues() + f * filter->getRowSkip() + c * 9;
+                    VT gG[4][3];
+                    for(size_t j = 0; j < 3; j++) {
+                        gG[0][j] = g[j];
+                        gG[1][j] = (g[j] + g[3 + j] + g[6 + j]) / 2;
+                        gG[2][j] = (g[j] - g[3 + j] + g[6 + j]) / 2;
+                        gG[3][j] = g[6 + j];
+                    }
+                    for(size_t i = 0; i < 4; i++) {
+                        const VT u[4] = {gG[i][0], (gG[i][0] + gG[i][1] + gG[i][2]) / 2,
+                                (gG[i][0] - gG[i][1] + gG[i][2]) / 2, gG[i][2]};
+                        for(size_t j = 0; j < 4; j++)
+                            U[((i * 4 + j) * F + f) * C + c] = u[j];
+                    }
+                }
+
+            // the image is cut into tiles of 4 x 4 cells overlapping by 2, each yielding 2 x 2 outputs
+            const size_t tilesP = (P + 1) / 2;
+            const size_t tilesQ = (Q + 1) / 2;
+            const size_t T = tilesP * tilesQ;
+            WorkerPool::parallelFor(dctx, batch_size, [&](size_t n) {
+                const VT *img = data->getValues() + n * data->getRowSkip();
+                // the transformed tiles B^T d B, as 16 matrices of C x T
+                std::vector<VT> V(16 * C * T);
+                for(size_t c = 0; c < C; c++)
+                    for(size_t tp = 0; tp < tilesP; tp++)
+                        for(size_t tq = 0; tq < tilesQ; tq++) {
+                            VT d[4][4];
+                            for(size_t i = 0; i < 4; i++) {
+                                const size_t h = 2 * tp + i;
+                                for(size_t j = 0; j < 4; j++) {
+                                    const size_t w = 2 * tq + j;
+                                    d[i][j] = (h < pad_h || h >= img_h + pad_h || w < pad_w || w >= img_w + pad_w)
+                                            ? VT(0) : img[(c * img_h + h - pad_h) * img_w + w - pad_w];
+                                }
+                            }
+                            VT Btd[4][4];
+                            for(size_t j = 0; j < 4; j++) {
+                                Btd[0][j] = d[0][j] - d[2][j];
+                                Btd[1][j] = d[1][j] + d[2][j];
+                                Btd[2][j] = d[2][j] - d[1][j];
+                                Btd[3][j] = d[1][j] - d[3][j];
+                            }
+                            const size_t t = tp * tilesQ + tq;
+                            for(size_t i = 0; i < 4; i++) {
+                                const VT v[4] = {Btd[i][0] - Btd[i][2], Btd[i][1] + Btd[i][2], Btd[i][2] - Btd[i][1],
+                                        Btd[i][1] - Btd[i][3]};
+                                for(size_t j = 0; j < 4; j++)
+                                    V[((i * 4 + j) * C + c) * T + t] = v[j];
+                            }
+                        }
+
+                // the element-wise products summed up over the channels, as 16 matrices of F x T
+                std::vector<VT> M(16 * F * T);
+                for(size_t xi = 0; xi < 16; xi++)
+                    gemm(F, T, C, U.data() + xi * F * C, C, V.data() + xi * C * T, T, M.data() + xi * F * T, T);
+
+                VT *out = res->getValues() + n * res->getRowSkip();
+                for(size_t f = 0; f < F; f++)
+                    for(size_t tp = 0; tp < tilesP; tp++)
+                        for(size_t tq = 0; tq < tilesQ; tq++) {
+                            const size_t t = tp * tilesQ + tq;
+                            VT m[4][4];
+                            for(size_t xi = 0; xi < 16; xi++)
+                                m[xi / 4][xi % 4] = M[(xi * F + f) * T + t];
+                            // A^T m A
+                            VT Atm[2][4];
+                            for(size_t j = 0; j < 4; j++) {
+                                Atm[0][j] = m[0][j] + m[1][j] + m[2][j];
+                                Atm[1][j] = m[1][j] - m[2][j] - m[3][j];
+                            }
+                            for(size_t i = 0; i < 2 && 2 * tp + i < P; i++) {
+                                VT *outRow = out + f * PQ + (2 * tp + i) * Q;
+                                outRow[2 * tq] = Atm[i][0] + Atm[i][1] + Atm[i][2];
+                                if(2 * tq + 1 < Q)
+                                    outRow[2 * tq + 1] = Atm[i][1] - Atm[i][2] - Atm[i][3];
+                            }
+                        }
+                addBias(out, filter, bias, F, PQ);
+            });
+        }
+
+    private:
+        static size_t getPQ(size_t img_extent, size_t filter_extent, size_t pad_extent, size_t stride_extent) {
+            return (img_extent + 2 * pad_extent - filter_extent) / stride_extent + 1;
+        }
+
+        static void checkArgs(const DenseMatrix<VT> *data, const DenseMatrix<VT> *filter, const DenseMatrix<VT> *bias,
+                size_t num_channels, size_t img_h, size_t img_w, size_t filter_h, size_t filter_w, size_t stride_h,
+                size_t stride_w, size_t pad_h, size_t pad_w) {
+            if(stride_h == 0 || stride_w == 0 || filter_h == 0 || filter_w == 0)
+                throw std::runtime_error("Convolution: the filter and stride extents must be positive");
+            if(img_h + 2 * pad_h < filter_h || img_w + 2 * pad_w < filter_w)
+                throw std::runtime_error("Convolution: the filter is larger than the padded image");
+            if(data->getNumCols() != num_channels * img_h * img_w)
+                throw std::runtime_error("Convolution: the number of columns of the input must be the number of "
+                        "channels times the image size");
+            if(filter->getNumCols() != num_channels * filter_h * filter_w)
+                throw std::runtime_error("Convolution: the number of columns of the filter must be the number of "
+                        "channels times the filter size");
+            if(bias && bias != filter && bias->getNumRows() * bias->getNumCols() != filter->getNumRows())
+                throw std::runtime_error("Convolution: the bias must have a value per filter");
+        }
+
+        static void addBias(VT *out, const DenseMatrix<VT> *filter, const DenseMatrix<VT> *bias, size_t F, size_t PQ) {
+            if(!bias || bias == filter)
+                return;
+            const VT *valuesBias = bias->getValues();
+            const size_t stepBias = bias->getNumRows() == 1 ? 1 : bias->getRowSkip();
+            for(size_t f = 0; f < F; f++) {
+                const VT b = valuesBias[f * stepBias];
+                #pragma omp simd
+                for(size_t i = 0; i < PQ; i++)
+                    out[f * PQ + i] += b;
+            }
+        }
+
+        // res (m x n) = lhs (m x k) * rhs (k x n), row-major
+        static void gemm(size_t m, size_t n, size_t k, const float *lhs, size_t ldLhs, const float *rhs, size_t ldRhs,
+                float *res, size_t ldRes) {
+            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k, 1, lhs, ldLhs, rhs, ldRhs, 0, res, ldRes);
+        }
+
+        static void gemm(size_t m, size_t n, size_t k, const double *lhs, size_t ldLhs, const double *rhs,
+                size_t ldRhs, double *res, size_t ldRes) {
+            cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k, 1, lhs, ldLhs, rhs, ldRhs, 0, res, ldRes);
+        }
+    };
+}
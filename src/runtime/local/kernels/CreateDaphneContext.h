@@ -21,6 +21,12 @@
 
 #include <api/cli/DaphneUserConfig.h>
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/MemoryTracker.h>
+#include <runtime/local/datastructures/ReuseCache.h>
+#include <runtime/local/datastructures/SpillManager.h>
+#include <runtime/local/io/ObjectStore.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
 
 #include <cstdint>
 
@@ -30,6 +36,16 @@
 
 void createDaphneContext(DaphneContext *& res, uint64_t configPtr) {
     auto config = reinterpret_cast<DaphneUserConfig *>(configPtr);
+    BufferPool::get().setMaxCachedBytes(config->buffer_pool_max_cached_bytes);
+    BufferPool::get().setUseHugePages(config->buffer_pool_huge_pages);
+    if(config->track_memory || config->memory_limit_bytes)
+        MemoryTracker::get().enable(config->memory_limit_bytes);
+    if(config->spill_budget_bytes)
+        SpillManager::get().enable(config->spill_budget_bytes, config->spill_dir,
+                DF_compressionFromString(config->spill_compression));
+    ReuseCache::get().setBudget(config->reuse_cache_bytes);
+    ObjectStore::get().configure(config->object_store_cache, config->object_store_connections);
+    CpuDispatch::setMaxIsa(config->cpu_isa);
     res = new DaphneContext(*config);
 }
 
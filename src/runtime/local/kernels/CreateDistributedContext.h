@@ -18,11 +18,40 @@
 
 #include "runtime/local/context/DaphneContext.h"
 #include "runtime/local/context/DistributedContext.h"
+#include "runtime/distributed/proto/DistributedGRPCCaller.h"
+#include "runtime/distributed/proto/Tracing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
 static void createDistributedContext(DCTX(ctx)) {
-    ctx->distributed_context = DistributedContext::createDistributedContext();
+    const auto backend = DistributedContext::parseBackend(ctx->config.distributed_backend);
+    ctx->distributed_context = DistributedContext::createDistributedContext(backend);
+    // The calls to the workers carry the context of the trace of the program, which ends with the distributed
+    // context (see DistributedContext::destroy).
+    if (!ctx->config.distributed_trace_file.empty() && backend == ALLOCATION_TYPE::DIST_GRPC) {
+        Tracing::get().open(ctx->config.distributed_trace_file, "coordinator");
+        Tracing::get().startTrace();
+    }
+    // The data at the workers is freed once the data objects placed there are destroyed.
+    if (backend == ALLOCATION_TYPE::DIST_GRPC)
+        DistributedGarbage::get().setFreeFunction([](const std::string &worker,
+                                                     const std::vector<std::string> &identifiers) {
+            return freeWorkerData(worker, identifiers, std::chrono::seconds(10));
+        });
+    // A failed rank aborts the whole MPI job, so only the gRPC backend survives failed workers.
+    if (ctx->config.distributed_max_failures > 0 && backend == ALLOCATION_TYPE::DIST_GRPC) {
+        const std::chrono::milliseconds interval(ctx->config.distributed_heartbeat_ms);
+        // a ping after a failed pipeline waits for a second at least
+        const auto timeout = std::max(interval, std::chrono::milliseconds(1000));
+        DistributedContext::get(ctx)->enableFailureDetection([timeout](const std::string &worker) {
+            return pingWorker(worker, timeout);
+        }, interval);
+    }
 }
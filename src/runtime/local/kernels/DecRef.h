@@ -26,6 +26,9 @@
 // ****************************************************************************
 
 void decRef(const Structure * arg, DCTX(ctx)) {
+    // A preceding markLastUse() only holds for the kernel call in between, the
+    // data object may live on through other references.
+    arg->clearLastUse();
     DataObjectFactory::destroy(arg);
 }
 
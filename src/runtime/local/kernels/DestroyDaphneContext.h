@@ -18,13 +18,36 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_DESTROYDAPHNECONTEXT_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/DistributedGarbage.h>
+#include <runtime/local/datastructures/ReuseCache.h>
+#include <runtime/local/datastructures/SpillManager.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+#include <runtime/distributed/proto/WireStatistics.h>
+
+#include <iostream>
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
 void destroyDaphneContext(const DaphneContext * ctx) {
+    if(ctx->config.buffer_pool_stats) {
+        BufferPool::get().getStats().print(std::cerr);
+        if(SpillManager::isEnabled())
+            SpillManager::get().getStatistics().print(std::cerr);
+        if(ReuseCache::isEnabled())
+            ReuseCache::get().getStatistics().print(std::cerr);
+    }
+    if(ctx->config.cpu_dispatch_stats)
+        CpuDispatch::printSelections(std::cerr);
+    const bool distributedStats = ctx->config.distributed_statistics;
+    // finishes the distributed pipelines still running in the background, too
     delete ctx;
+    if(distributedStats) {
+        WireStatistics::get().print(std::cerr);
+        DistributedGarbage::get().printStats(std::cerr);
+    }
 }
 
 #endif //SRC_RUNTIME_LOCAL_KERNELS_DESTROYDAPHNECONTEXT_H
\ No newline at end of file
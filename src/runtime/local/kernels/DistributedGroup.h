@@ -0,0 +1,43 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/distributed/coordinator/kernels/DistributedGroup.h>
+#include <runtime/local/kernels/Group.h>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Groups the rows of a frame at the distributed workers, see the distributed `DistributedGroup`.
+ */
+template<class DT>
+void distributedGroup(DT *& res, const DT * arg, const char ** keyCols, size_t numKeyCols, const char ** aggCols,
+                      size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs, size_t numAggFuncs, DCTX(ctx)) {
+    // The workers of the MPI backend do not compute relational operators, small frames are not worth sending, and
+    // the aggregation of all rows into a single group is not partitioned.
+    if(DistributedContext::get(ctx)->getBackend() == ALLOCATION_TYPE::DIST_MPI || numKeyCols == 0
+            || arg->getNumRows() == 0 || arg->getNumRows() < ctx->config.distributed_relational_min_rows) {
+        group(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggFuncs, ctx);
+        return;
+    }
+    distributedGroup<ALLOCATION_TYPE::DIST_GRPC, DT>(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs,
+                                                     numAggFuncs, ctx);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/distributed/coordinator/kernels/DistributedInnerJoin.h>
+#include <runtime/local/kernels/InnerJoin.h>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Joins two frames at the distributed workers, see the distributed `DistributedInnerJoin`.
+ */
+inline void distributedInnerJoin(Frame *& res, const Frame * lhs, const Frame * rhs, const char * lhsOn,
+                                 const char * rhsOn, DCTX(ctx)) {
+    // The workers of the MPI backend do not compute relational operators, and small frames are not worth sending.
+    if(DistributedContext::get(ctx)->getBackend() == ALLOCATION_TYPE::DIST_MPI || lhs->getNumRows() == 0
+            || rhs->getNumRows() == 0
+            || lhs->getNumRows() + rhs->getNumRows() < ctx->config.distributed_relational_min_rows) {
+        innerJoin(res, lhs, rhs, lhsOn, rhsOn, ctx);
+        return;
+    }
+    distributedInnerJoin<ALLOCATION_TYPE::DIST_GRPC>(res, lhs, rhs, &lhsOn, &rhsOn, 1, ctx);
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/distributed/coordinator/kernels/DistributedRead.h>
+#include <runtime/local/kernels/Read.h>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Reads a matrix at the distributed workers, see the distributed
+ * `DistributedRead`.
+ */
+template<class DTRes>
+void distributedRead(DTRes *& res, const char * filename, DCTX(ctx)) {
+    if(DistributedContext::get(ctx)->getBackend() == ALLOCATION_TYPE::DIST_MPI) {
+        // The workers of the MPI backend do not read files themselves, so the coordinator reads the matrix.
+        read(res, filename, ctx);
+        return;
+    }
+    distributedRead<ALLOCATION_TYPE::DIST_GRPC, DTRes>(res, filename, ctx);
+}
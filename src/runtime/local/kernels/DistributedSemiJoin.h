@@ -0,0 +1,45 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/context/DistributedContext.h>
+#include <runtime/distributed/coordinator/kernels/DistributedSemiJoin.h>
+#include <runtime/local/kernels/SemiJoin.h>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Finds the rows of a frame with a match in another one at the distributed workers, see the distributed
+ * `DistributedSemiJoin`.
+ */
+template<typename VTLhsTid>
+void distributedSemiJoin(Frame *& res, DenseMatrix<VTLhsTid> *& lhsTid, const Frame * lhs, const Frame * rhs,
+                         const char * lhsOn, const char * rhsOn, DCTX(ctx)) {
+    // The workers of the MPI backend do not compute relational operators, small frames are not worth sending, and
+    // the workers join keys of the value types of the local kernel only.
+    if(DistributedContext::get(ctx)->getBackend() == ALLOCATION_TYPE::DIST_MPI || lhs->getNumRows() == 0
+            || rhs->getNumRows() == 0
+            || lhs->getNumRows() + rhs->getNumRows() < ctx->config.distributed_relational_min_rows
+            || lhs->getColumnType(lhsOn) != ValueTypeCode::SI64 || rhs->getColumnType(rhsOn) != ValueTypeCode::SI64) {
+        semiJoin(res, lhsTid, lhs, rhs, lhsOn, rhsOn, ctx);
+        return;
+    }
+    distributedSemiJoin<ALLOCATION_TYPE::DIST_GRPC, VTLhsTid>(res, lhsTid, lhs, rhs, lhsOn, rhsOn, ctx);
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/EwBinarySca.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+/**
+ * @brief The building blocks of the element-wise kernels with `CSRMatrix` results, which run row-parallel on the
+ * `WorkerPool`.
+ *
+ * A binary operation keeps a sparse operand sparse if it maps zeros to zero. Then, only the non-zeros need to be
+ * combined, and zero results are not stored. Since the number of non-zeros of a result row is only known after
+ * combining its operands, the result is built in two passes over chunks of rows: the first one counts the non-zeros
+ * of each row, the second one writes them (after the row offsets were derived from these counts).
+ */
+namespace EwBinaryCSR {
+    // chunks have at least this many non-zeros of the operands, but there are at most MAX_CHUNKS
+    constexpr size_t MIN_NNZ_PER_CHUNK = 1 << 14;
+    constexpr size_t MAX_CHUNKS = 256;
+
+    /**
+     * @brief Returns whether an operation maps a zero on either side to zero, such that only the cells in which both
+     * sparse operands are non-zero need to be combined.
+     */
+    inline bool isIntersecting(BinaryOpCode opCode) {
+        return opCode == BinaryOpCode::MUL || opCode == BinaryOpCode::AND;
+    }
+
+    /**
+     * @brief Returns whether an operation maps two zeros to zero, such that only the cells in which either sparse
+     * operand is non-zero need to be combined.
+     */
+    inline bool isUniting(BinaryOpCode opCode) {
+        switch(opCode) {
+            case BinaryOpCode::ADD:
+            case BinaryOpCode::SUB:
+            case BinaryOpCode::NEQ:
+            case BinaryOpCode::LT:
+            case BinaryOpCode::GT:
+            case BinaryOpCode::MIN:
+            case BinaryOpCode::MAX:
+            case BinaryOpCode::OR:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Returns whether an operation maps a zero on the left side to zero, whatever the right side, such that
+     * only the non-zeros of a sparse left operand need to be combined with a dense right operand.
+     *
+     * For `DIV`, this treats zero divided by zero as zero.
+     */
+    inline bool isLhsZeroPreserving(BinaryOpCode opCode) {
+        return isIntersecting(opCode) || opCode == BinaryOpCode::DIV;
+    }
+
+    /**
+     * @brief Returns the number of chunks to split `n` non-zeros in `numRows` rows into.
+     */
+    inline size_t getNumChunks(size_t n, size_t numRows) {
+        return std::clamp<size_t>(n / MIN_NNZ_PER_CHUNK, 1, std::max<size_t>(1, std::min(numRows, MAX_CHUNKS)));
+    }
+
+    /**
+     * @brief Combines the non-zeros of a row of two sparse operands, which are given by their (sorted) column
+     * indexes and values. Returns the number of non-zeros of the result row, which are written to `colIdxsRes` and
+     * `valuesRes` unless these are null.
+     *
+     * @param intersect Whether only the cells in which both sides are non-zero are combined, or those in which either
+     * side is.
+     */
+    template<typename VT>
+    size_t combineRows(EwBinaryScaFuncPtr<VT, VT, VT> func, bool intersect,
+            const size_t * colIdxsLhs, const VT * valuesLhs, size_t nnzLhs,
+            const size_t * colIdxsRhs, const VT * valuesRhs, size_t nnzRhs,
+            size_t * colIdxsRes, VT * valuesRes, DCTX(ctx)) {
+        size_t posLhs = 0;
+        size_t posRhs = 0;
+        size_t posRes = 0;
+        auto emit = [&](size_t colIdx, VT value) {
+            if(value != VT(0)) {
+                if(colIdxsRes) {
+                    colIdxsRes[posRes] = colIdx;
+                    valuesRes[posRes] = value;
+                }
+                posRes++;
+            }
+        };
+        while(posLhs < nnzLhs && posRhs < nnzRhs) {
+            const size_t colIdxLhs = colIdxsLhs[posLhs];
+            const size_t colIdxRhs = colIdxsRhs[posRhs];
+            if(colIdxLhs == colIdxRhs)
+                emit(colIdxLhs, func(valuesLhs[posLhs++], valuesRhs[posRhs++], ctx));
+            else if(colIdxLhs < colIdxRhs) {
+                if(!intersect)
+                    emit(colIdxLhs, func(valuesLhs[posLhs], VT(0), ctx));
+                posLhs++;
+            }
+            else {
+                if(!intersect)
+                    emit(colIdxRhs, func(VT(0), valuesRhs[posRhs], ctx));
+                posRhs++;
+            }
+        }
+        if(!intersect) {
+            for(; posLhs < nnzLhs; posLhs++)
+                emit(colIdxsLhs[posLhs], func(valuesLhs[posLhs], VT(0), ctx));
+            for(; posRhs < nnzRhs; posRhs++)
+                emit(colIdxsRhs[posRhs], func(VT(0), valuesRhs[posRhs], ctx));
+        }
+        return posRes;
+    }
+
+    /**
+     * @brief Builds a `CSRMatrix` result with the rows of the sparse operand `arg` (and `arg2`, if any) in two
+     * passes, where `combineRow(r, colIdxsRes, valuesRes)` returns the number of non-zeros of row `r` of the result,
+     * writing them unless the pointers are null (see `combineRows()`).
+     *
+     * The chunks of rows have about the same number of non-zeros of the sparse operands. A given result must have
+     * room for the non-zeros.
+     */
+    template<typename VT, class CombineRow>
+    void build(CSRMatrix<VT> *& res, size_t numCols, const CSRMatrix<VT> * arg, const CSRMatrix<VT> * arg2,
+            CombineRow combineRow, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t * rowOffsetsArg = arg->getRowOffsets();
+        const size_t * rowOffsetsArg2 = arg2 ? arg2->getRowOffsets() : nullptr;
+        // the number of non-zeros of the operands in the rows before the given one
+        auto nnzBefore = [&](size_t r) {
+            size_t nnz = rowOffsetsArg[r] - rowOffsetsArg[0];
+            if(rowOffsetsArg2)
+                nnz += rowOffsetsArg2[r] - rowOffsetsArg2[0];
+            return nnz;
+        };
+        const size_t nnzArgs = nnzBefore(numRows);
+        const size_t numChunks = getNumChunks(nnzArgs, numRows);
+
+        // the first row of each chunk, found by binary search over the rows
+        std::vector<size_t> chunkRows(numChunks + 1, numRows);
+        chunkRows[0] = 0;
+        for(size_t i = 1; i < numChunks; i++) {
+            const size_t target = nnzArgs * i / numChunks;
+            size_t lo = chunkRows[i - 1];
+            size_t hi = numRows;
+            while(lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                if(nnzBefore(mid) < target)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            chunkRows[i] = lo;
+        }
+
+        // first pass: the number of non-zeros of each row, and of the chunks before each chunk
+        std::vector<size_t> rowNnz(numRows);
+        std::vector<size_t> chunkOffsets(numChunks + 1, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            size_t nnz = 0;
+            for(size_t r = chunkRows[i]; r < chunkRows[i + 1]; r++)
+                nnz += rowNnz[r] = combineRow(r, nullptr, nullptr);
+            chunkOffsets[i + 1] = nnz;
+        });
+        for(size_t i = 0; i < numChunks; i++)
+            chunkOffsets[i + 1] += chunkOffsets[i];
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, chunkOffsets[numChunks], false);
+        size_t * rowOffsetsRes = res->getRowOffsets();
+        size_t * colIdxsRes = res->getColIdxs();
+        VT * valuesRes = res->getValues();
+        rowOffsetsRes[0] = 0;
+
+        // second pass: the row offsets and non-zeros of each chunk
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            size_t pos = chunkOffsets[i];
+            for(size_t r = chunkRows[i]; r < chunkRows[i + 1]; r++) {
+                combineRow(r, colIdxsRes + pos, valuesRes + pos);
+                pos += rowNnz[r];
+                rowOffsetsRes[r + 1] = pos;
+            }
+        });
+    }
+}
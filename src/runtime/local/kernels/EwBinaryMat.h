@@ -17,12 +17,22 @@
 #pragma once
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Matrix.h>
 #include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/BitMask.h>
+#include <runtime/local/kernels/EwBinaryCSR.h>
 #include <runtime/local/kernels/EwBinarySca.h>
+#include <runtime/local/kernels/ReuseArg.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
 
 #include <cassert>
 #include <cstddef>
@@ -56,56 +66,164 @@ void ewBinaryMat(BinaryOpCode opCode, DTRes *& res, const DTLhs * lhs, const DTR
 template<typename VTres, typename VTlhs, typename VTrhs>
 struct EwBinaryMat<DenseMatrix<VTres>, DenseMatrix<VTlhs>, DenseMatrix<VTrhs>> {
     static void apply(BinaryOpCode opCode, DenseMatrix<VTres> *& res, const DenseMatrix<VTlhs> * lhs, const DenseMatrix<VTrhs> * rhs, DCTX(ctx)) {
+        const size_t numRowsLhs = lhs->getNumRows();
+        const size_t numColsLhs = lhs->getNumCols();
+
+        // An operand at its last use is overwritten with the result, see ReuseArg.h.
+        if(res == nullptr && !reuseArgAsRes(res, lhs, numRowsLhs, numColsLhs)
+                && !reuseArgAsRes(res, rhs, numRowsLhs, numColsLhs))
+            res = DataObjectFactory::create<DenseMatrix<VTres>>(numRowsLhs, numColsLhs, false);
+
+        // The op code is interpreted once, such that the loops of each operation can be inlined and vectorized.
+        switch(opCode) {
+#define MAKE_CASE(opCode) case opCode: applyOp<opCode>(res, lhs, rhs, ctx); break;
+            // Arithmetic.
+            MAKE_CASE(BinaryOpCode::ADD)
+            MAKE_CASE(BinaryOpCode::SUB)
+            MAKE_CASE(BinaryOpCode::MUL)
+            MAKE_CASE(BinaryOpCode::DIV)
+            MAKE_CASE(BinaryOpCode::POW)
+            MAKE_CASE(BinaryOpCode::MOD)
+            MAKE_CASE(BinaryOpCode::LOG)
+            // Comparisons.
+            MAKE_CASE(BinaryOpCode::EQ)
+            MAKE_CASE(BinaryOpCode::NEQ)
+            MAKE_CASE(BinaryOpCode::LT)
+            MAKE_CASE(BinaryOpCode::LE)
+            MAKE_CASE(BinaryOpCode::GT)
+            MAKE_CASE(BinaryOpCode::GE)
+            // Min/max.
+            MAKE_CASE(BinaryOpCode::MIN)
+            MAKE_CASE(BinaryOpCode::MAX)
+            // Logical.
+            MAKE_CASE(BinaryOpCode::AND)
+            MAKE_CASE(BinaryOpCode::OR)
+#undef MAKE_CASE
+            default:
+                throw std::runtime_error("unknown BinaryOpCode");
+        }
+//        auto end = std::chrono::high_resolution_clock::now();
+//        std::cout << "EwBinaryMat time=" << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "µs)" << std::endl;
+    }
+
+private:
+    template<BinaryOpCode opCode>
+    static void applyOp(DenseMatrix<VTres> * res, const DenseMatrix<VTlhs> * lhs, const DenseMatrix<VTrhs> * rhs, DCTX(ctx)) {
+        using Op = EwBinarySca<opCode, VTres, VTlhs, VTrhs>;
+
         const size_t numRowsLhs = lhs->getNumRows();
         const size_t numColsLhs = lhs->getNumCols();
         const size_t numRowsRhs = rhs->getNumRows();
         const size_t numColsRhs = rhs->getNumCols();
 
-        if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<VTres>>(numRowsLhs, numColsLhs, false);
-        
+        // A lazily transposed operand of the same size is read from its source instead of being transposed, unless
+        // the result overwrites it.
+        const bool isArgRes = static_cast<const void *>(res) == lhs || static_cast<const void *>(res) == rhs;
+        if(numRowsLhs == numRowsRhs && numColsLhs == numColsRhs && !isArgRes
+                && (lhs->getTransposedSource() || rhs->getTransposedSource())) {
+            applyOpTiled<opCode>(res, lhs, rhs, ctx);
+            return;
+        }
+
         const VTlhs * valuesLhs = lhs->getValues();
         const VTrhs * valuesRhs = rhs->getValues();
         VTres * valuesRes = res->getValues();
-        
-        EwBinaryScaFuncPtr<VTres, VTlhs, VTrhs> func = getEwBinaryScaFuncPtr<VTres, VTlhs, VTrhs>(opCode);
-        
-        if(numRowsLhs == numRowsRhs && numColsLhs == numColsRhs) {
-            // matrix op matrix (same size)
-            for(size_t r = 0; r < numRowsLhs; r++) {
-                for(size_t c = 0; c < numColsLhs; c++)
-                    valuesRes[c] = func(valuesLhs[c], valuesRhs[c], ctx);
-                valuesLhs += lhs->getRowSkip();
-                valuesRhs += rhs->getRowSkip();
-                valuesRes += res->getRowSkip();
+
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        // the loops are vectorized for the instruction set of the CPU, see CpuDispatch.h
+        CpuDispatch::run("ewBinaryMat", [&](auto) {
+            if(numRowsLhs == numRowsRhs && numColsLhs == numColsRhs) {
+                // matrix op matrix (same size)
+                if(rowSkipLhs == numColsLhs && rowSkipRhs == numColsLhs && rowSkipRes == numColsLhs) {
+                    // contiguous values, processed as a single row
+                    const size_t numCells = numRowsLhs * numColsLhs;
+                    #pragma omp simd
+                    for(size_t i = 0; i < numCells; i++)
+                        valuesRes[i] = Op::apply(valuesLhs[i], valuesRhs[i], ctx);
+                    return;
+                }
+                for(size_t r = 0; r < numRowsLhs; r++) {
+                    #pragma omp simd
+                    for(size_t c = 0; c < numColsLhs; c++)
+                        valuesRes[c] = Op::apply(valuesLhs[c], valuesRhs[c], ctx);
+                    valuesLhs += rowSkipLhs;
+                    valuesRhs += rowSkipRhs;
+                    valuesRes += rowSkipRes;
+                }
             }
-        }
-        else if(numColsLhs == numColsRhs && (numRowsRhs == 1 || numRowsLhs == 1)) {
-            // matrix op row-vector
-            for(size_t r = 0; r < numRowsLhs; r++) {
-                for(size_t c = 0; c < numColsLhs; c++)
-                    valuesRes[c] = func(valuesLhs[c], valuesRhs[c], ctx);
-                valuesLhs += lhs->getRowSkip();
-                valuesRes += res->getRowSkip();
+            else if(numColsLhs == numColsRhs && (numRowsRhs == 1 || numRowsLhs == 1)) {
+                // matrix op row-vector
+                for(size_t r = 0; r < numRowsLhs; r++) {
+                    #pragma omp simd
+                    for(size_t c = 0; c < numColsLhs; c++)
+                        valuesRes[c] = Op::apply(valuesLhs[c], valuesRhs[c], ctx);
+                    valuesLhs += rowSkipLhs;
+                    valuesRes += rowSkipRes;
+                }
             }
-        }
-        else if(numRowsLhs == numRowsRhs && (numColsRhs == 1 || numColsLhs == 1)) {
-            // matrix op col-vector
-            for(size_t r = 0; r < numRowsLhs; r++) {
-                for(size_t c = 0; c < numColsLhs; c++)
-                    valuesRes[c] = func(valuesLhs[c], valuesRhs[0], ctx);
-                valuesLhs += lhs->getRowSkip();
-                valuesRhs += rhs->getRowSkip();
-                valuesRes += res->getRowSkip();
+            else if(numRowsLhs == numRowsRhs && (numColsRhs == 1 || numColsLhs == 1)) {
+                // matrix op col-vector
+                for(size_t r = 0; r < numRowsLhs; r++) {
+                    const VTrhs valueRhs = valuesRhs[0];
+                    #pragma omp simd
+                    for(size_t c = 0; c < numColsLhs; c++)
+                        valuesRes[c] = Op::apply(valuesLhs[c], valueRhs, ctx);
+                    valuesLhs += rowSkipLhs;
+                    valuesRhs += rowSkipRhs;
+                    valuesRes += rowSkipRes;
+                }
             }
-        }
-        else {
-            throw std::runtime_error("EwBinaryMat(Dense) - lhs and rhs must either "
-                "have the same dimensions, or one of them must be a row/column vector "
-                "with the width/height of the other");
-        }
-//        auto end = std::chrono::high_resolution_clock::now();
-//        std::cout << "EwBinaryMat time=" << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "µs)" << std::endl;
+            else {
+                throw std::runtime_error("EwBinaryMat(Dense) - lhs and rhs must either "
+                    "have the same dimensions, or one of them must be a row/column vector "
+                    "with the width/height of the other");
+            }
+        });
+    }
+
+    // the edge length of the square tiles of applyOpTiled()
+    static constexpr size_t TILE = 32;
+
+    /**
+     * @brief Combines operands of the same size, at least one of which is a lazy transposition, in parallel rows of
+     * square tiles, such that reading the source of a transposition by columns does not stride through memory.
+     */
+    template<BinaryOpCode opCode>
+    static void applyOpTiled(DenseMatrix<VTres> * res, const DenseMatrix<VTlhs> * lhs, const DenseMatrix<VTrhs> * rhs,
+            DCTX(ctx)) {
+        using Op = EwBinarySca<opCode, VTres, VTlhs, VTrhs>;
+
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+
+        // the values of an operand with the strides of its rows and columns
+        auto stridesOf = [](const auto * arg) {
+            if(const auto * src = arg->getTransposedSource())
+                return std::make_tuple(src->getValues(), size_t(1), src->getRowSkip());
+            return std::make_tuple(arg->getValues(), arg->getRowSkip(), size_t(1));
+        };
+        const VTlhs * valuesLhs;
+        const VTrhs * valuesRhs;
+        size_t rowStrideLhs, colStrideLhs, rowStrideRhs, colStrideRhs;
+        std::tie(valuesLhs, rowStrideLhs, colStrideLhs) = stridesOf(lhs);
+        std::tie(valuesRhs, rowStrideRhs, colStrideRhs) = stridesOf(rhs);
+        VTres * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        WorkerPool::parallelFor(ctx, (numRows + TILE - 1) / TILE, [&](size_t t) {
+            const size_t r0 = t * TILE;
+            const size_t rowEnd = std::min(r0 + TILE, numRows);
+            for(size_t c0 = 0; c0 < numCols; c0 += TILE) {
+                const size_t colEnd = std::min(c0 + TILE, numCols);
+                for(size_t r = r0; r < rowEnd; r++)
+                    for(size_t c = c0; c < colEnd; c++)
+                        valuesRes[r * rowSkipRes + c] = Op::apply(valuesLhs[r * rowStrideLhs + c * colStrideLhs],
+                                valuesRhs[r * rowStrideRhs + c * colStrideRhs], ctx);
+            }
+        });
     }
 };
 
@@ -113,6 +231,12 @@ struct EwBinaryMat<DenseMatrix<VTres>, DenseMatrix<VTlhs>, DenseMatrix<VTrhs>> {
 // CSRMatrix <- CSRMatrix, CSRMatrix
 // ----------------------------------------------------------------------------
 
+/**
+ * Supports the operations which map two zeros to zero: those mapping a zero on either side to zero (`MUL`, `AND`)
+ * combine the cells in which both sides are non-zero, the others (`ADD`, `SUB`, `MIN`, `MAX`, `NEQ`, `LT`, `GT`,
+ * `OR`) those in which either side is. Zero results are not stored, e.g., comparisons yield sparse masks. The rows are
+ * processed in parallel (see `EwBinaryCSR`).
+ */
 template<typename VT>
 struct EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, CSRMatrix<VT>> {
     static void apply(BinaryOpCode opCode, CSRMatrix<VT> *& res, const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, DCTX(ctx)) {
@@ -120,133 +244,19 @@ struct EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, CSRMatrix<VT>> {
         const size_t numCols = lhs->getNumCols();
         if( numRows != rhs->getNumRows() || numCols != rhs->getNumCols() )
             throw std::runtime_error("EwBinaryMat(CSR) - lhs and rhs must have the same dimensions.");
-        
-        size_t maxNnz;
-        switch(opCode) {
-            case BinaryOpCode::ADD: // merge
-                maxNnz = lhs->getNumNonZeros() + rhs->getNumNonZeros();
-                break;
-            case BinaryOpCode::MUL: // intersect
-                maxNnz = std::min(lhs->getNumNonZeros(), rhs->getNumNonZeros());
-                break;
-            default:
-                throw std::runtime_error("EwBinaryMat(CSR) - unknown BinaryOpCode");
-        }
-        
-        if(res == nullptr)
-            res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, maxNnz, false);
-        
-        size_t * rowOffsetsRes = res->getRowOffsets();
-        
+
+        const bool intersect = EwBinaryCSR::isIntersecting(opCode);
+        if(!intersect && !EwBinaryCSR::isUniting(opCode))
+            throw std::runtime_error("EwBinaryMat(CSR) - unsupported BinaryOpCode, the result would not be sparse");
+
         EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(opCode);
-        
-        rowOffsetsRes[0] = 0;
-        
-        switch(opCode) {
-            case BinaryOpCode::ADD: { // merge non-zero cells
-                for(size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
-                    size_t nnzRowLhs = lhs->getNumNonZeros(rowIdx);
-                    size_t nnzRowRhs = rhs->getNumNonZeros(rowIdx);
-                    if(nnzRowLhs && nnzRowRhs) {
-                        // merge within row
-                        const VT * valuesRowLhs = lhs->getValues(rowIdx);
-                        const VT * valuesRowRhs = rhs->getValues(rowIdx);
-                        VT * valuesRowRes = res->getValues(rowIdx);
-                        const size_t * colIdxsRowLhs = lhs->getColIdxs(rowIdx);
-                        const size_t * colIdxsRowRhs = rhs->getColIdxs(rowIdx);
-                        size_t * colIdxsRowRes = res->getColIdxs(rowIdx);
-                        size_t posLhs = 0;
-                        size_t posRhs = 0;
-                        size_t posRes = 0;
-                        while(posLhs < nnzRowLhs && posRhs < nnzRowRhs) {
-                            if(colIdxsRowLhs[posLhs] == colIdxsRowRhs[posRhs]) {
-                                valuesRowRes[posRes] = func(valuesRowLhs[posLhs], valuesRowRhs[posRhs], ctx);
-                                colIdxsRowRes[posRes] = colIdxsRowLhs[posLhs];
-                                posLhs++;
-                                posRhs++;
-                            }
-                            else if(colIdxsRowLhs[posLhs] < colIdxsRowRhs[posRhs]) {
-                                valuesRowRes[posRes] = valuesRowLhs[posLhs];
-                                colIdxsRowRes[posRes] = colIdxsRowLhs[posLhs];
-                                posLhs++;
-                            }
-                            else {
-                                valuesRowRes[posRes] = valuesRowRhs[posRhs];
-                                colIdxsRowRes[posRes] = colIdxsRowRhs[posRhs];
-                                posRhs++;
-                            }
-                            posRes++;
-                        }
-                        // copy from left
-                        const size_t restRowLhs = nnzRowLhs - posLhs;
-                        memcpy(valuesRowRes + posRes, valuesRowLhs + posLhs, restRowLhs * sizeof(VT));
-                        memcpy(colIdxsRowRes + posRes, colIdxsRowLhs + posLhs, restRowLhs * sizeof(size_t));
-                        // copy from right
-                        const size_t restRowRhs = nnzRowRhs - posRhs;
-                        memcpy(valuesRowRes + posRes, valuesRowRhs + posRhs, restRowRhs * sizeof(VT));
-                        memcpy(colIdxsRowRes + posRes, colIdxsRowRhs + posRhs, restRowRhs * sizeof(size_t));
-                        
-                        rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx] + posRes + restRowLhs + restRowRhs;
-                    }
-                    else if(nnzRowLhs) {
-                        // copy from left
-                        memcpy(res->getValues(rowIdx), lhs->getValues(rowIdx), nnzRowLhs * sizeof(VT));
-                        memcpy(res->getColIdxs(rowIdx), lhs->getColIdxs(rowIdx), nnzRowLhs * sizeof(size_t));
-                        rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx] + nnzRowLhs;
-                    }
-                    else if(nnzRowRhs) {
-                        // copy from right
-                        memcpy(res->getValues(rowIdx), rhs->getValues(rowIdx), nnzRowRhs * sizeof(VT));
-                        memcpy(res->getColIdxs(rowIdx), rhs->getColIdxs(rowIdx), nnzRowRhs * sizeof(size_t));
-                        rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx] + nnzRowRhs;
-                    }
-                    else
-                        // empty row in result
-                        rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx];
-                }
-                break;
-            }
-            case BinaryOpCode::MUL: { // intersect non-zero cells
-                for(size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
-                    size_t nnzRowLhs = lhs->getNumNonZeros(rowIdx);
-                    size_t nnzRowRhs = rhs->getNumNonZeros(rowIdx);
-                    if(nnzRowLhs && nnzRowRhs) {
-                        // intersect within row
-                        const VT * valuesRowLhs = lhs->getValues(rowIdx);
-                        const VT * valuesRowRhs = rhs->getValues(rowIdx);
-                        VT * valuesRowRes = res->getValues(rowIdx);
-                        const size_t * colIdxsRowLhs = lhs->getColIdxs(rowIdx);
-                        const size_t * colIdxsRowRhs = rhs->getColIdxs(rowIdx);
-                        size_t * colIdxsRowRes = res->getColIdxs(rowIdx);
-                        size_t posLhs = 0;
-                        size_t posRhs = 0;
-                        size_t posRes = 0;
-                        while(posLhs < nnzRowLhs && posRhs < nnzRowRhs) {
-                            if(colIdxsRowLhs[posLhs] == colIdxsRowRhs[posRhs]) {
-                                valuesRowRes[posRes] = func(valuesRowLhs[posLhs], valuesRowRhs[posRhs], ctx);
-                                colIdxsRowRes[posRes] = colIdxsRowLhs[posLhs];
-                                posLhs++;
-                                posRhs++;
-                                posRes++;
-                            }
-                            else if(colIdxsRowLhs[posLhs] < colIdxsRowRhs[posRhs])
-                                posLhs++;
-                            else
-                                posRhs++;
-                        }
-                        rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx] + posRes;
-                    }
-                    else
-                        // empty row in result
-                        rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx];
-                }
-                break;
-            }
-            default:
-                throw std::runtime_error("EwBinaryMat(CSR) - unknown BinaryOpCode");
-        }
-        
-        // TODO Update number of non-zeros in result in the end.
+
+        EwBinaryCSR::build(res, numCols, lhs, rhs, [&](size_t rowIdx, size_t * colIdxsRowRes, VT * valuesRowRes) {
+            return EwBinaryCSR::combineRows(func, intersect,
+                    lhs->getColIdxs(rowIdx), lhs->getValues(rowIdx), lhs->getNumNonZeros(rowIdx),
+                    rhs->getColIdxs(rowIdx), rhs->getValues(rowIdx), rhs->getNumNonZeros(rowIdx),
+                    colIdxsRowRes, valuesRowRes, ctx);
+        }, ctx);
     }
 };
 
@@ -254,6 +264,11 @@ struct EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, CSRMatrix<VT>> {
 // CSRMatrix <- CSRMatrix, DenseMatrix
 // ----------------------------------------------------------------------------
 
+/**
+ * Supports the operations which map a zero on the left side to zero (`MUL`, `DIV`, `AND`), such that only the
+ * non-zeros of lhs are combined with rhs, which may also be a row or column vector. Zero results are not stored. The
+ * rows are processed in parallel (see `EwBinaryCSR`).
+ */
 template<typename VT>
 struct EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>> {
     static void apply(BinaryOpCode opCode, CSRMatrix<VT> *& res, const CSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
@@ -264,58 +279,185 @@ struct EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>> {
             || (numCols != rhs->getNumCols() && rhs->getNumCols() != 1 ) )
             throw std::runtime_error("EwBinaryMat(CSR) - lhs and rhs must have the same dimensions (or broadcast)");
 
-        size_t maxNnz;
-        switch(opCode) {
-        case BinaryOpCode::MUL: // intersect
-            maxNnz = lhs->getNumNonZeros();
-            break;
-        default:
-            throw std::runtime_error("EwBinaryMat(CSR) - unknown BinaryOpCode");
-        }
-
-        if(res == nullptr)
-            res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, maxNnz, false);
-
-        size_t *rowOffsetsRes = res->getRowOffsets();
+        if(!EwBinaryCSR::isLhsZeroPreserving(opCode))
+            throw std::runtime_error("EwBinaryMat(CSR) - unsupported BinaryOpCode, the result would not be sparse");
 
         EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(opCode);
 
-        rowOffsetsRes[0] = 0;
+        const VT * valuesRhs = rhs->getValues();
+        const size_t rowSkipRhs = rhs->getNumRows() == 1 ? 0 : rhs->getRowSkip();
+        const bool broadcastCol = rhs->getNumCols() == 1;
 
-        switch(opCode) {
-        case BinaryOpCode::MUL: { // intersect non-zero cells
-            for(size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
-                size_t nnzRowLhs = lhs->getNumNonZeros(rowIdx);
-                if(nnzRowLhs) {
-                    // intersect within row
-                    const VT * valuesRowLhs = lhs->getValues(rowIdx);
-                    VT * valuesRowRes = res->getValues(rowIdx);
-                    const size_t * colIdxsRowLhs = lhs->getColIdxs(rowIdx);
-                    size_t * colIdxsRowRes = res->getColIdxs(rowIdx);
-                    auto rhsRow = (rhs->getNumRows() == 1 ? 0 : rowIdx);
-                    size_t posRes = 0;
-                    for (size_t posLhs = 0; posLhs < nnzRowLhs; ++posLhs) {
-                        auto rhsCol = (rhs->getNumCols() == 1 ? 0 : colIdxsRowLhs[posLhs]);
-                        auto rVal = rhs->get(rhsRow, rhsCol);
-                        if(rVal != 0) {
-                            valuesRowRes[posRes] = func(valuesRowLhs[posLhs], rVal, ctx);
-                            colIdxsRowRes[posRes] = colIdxsRowLhs[posLhs];
-                            posRes++;
-                        }
+        EwBinaryCSR::build(res, numCols, lhs, static_cast<const CSRMatrix<VT> *>(nullptr),
+                [&](size_t rowIdx, size_t * colIdxsRowRes, VT * valuesRowRes) {
+            const size_t nnzRowLhs = lhs->getNumNonZeros(rowIdx);
+            const VT * valuesRowLhs = lhs->getValues(rowIdx);
+            const size_t * colIdxsRowLhs = lhs->getColIdxs(rowIdx);
+            const VT * valuesRowRhs = valuesRhs + rowIdx * rowSkipRhs;
+            size_t posRes = 0;
+            for(size_t posLhs = 0; posLhs < nnzRowLhs; posLhs++) {
+                const size_t colIdx = colIdxsRowLhs[posLhs];
+                const VT value = func(valuesRowLhs[posLhs], valuesRowRhs[broadcastCol ? 0 : colIdx], ctx);
+                if(value != VT(0)) {
+                    if(colIdxsRowRes) {
+                        colIdxsRowRes[posRes] = colIdx;
+                        valuesRowRes[posRes] = value;
                     }
-                    rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx] + posRes;
+                    posRes++;
                 }
-                else
-                    // empty row in result
-                    rowOffsetsRes[rowIdx + 1] = rowOffsetsRes[rowIdx];
             }
-            break;
+            return posRes;
+        }, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// BlockedMatrix <- BlockedMatrix, BlockedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct EwBinaryMat<BlockedMatrix<VT>, BlockedMatrix<VT>, BlockedMatrix<VT>> {
+    static void apply(BinaryOpCode opCode, BlockedMatrix<VT> *& res, const BlockedMatrix<VT> * lhs,
+            const BlockedMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+        const size_t blockSize = lhs->getBlockSize();
+        if(numRows != rhs->getNumRows() || numCols != rhs->getNumCols())
+            throw std::runtime_error("EwBinaryMat(Blocked) - lhs and rhs must have the same dimensions.");
+        if(blockSize != rhs->getBlockSize())
+            throw std::runtime_error("EwBinaryMat(Blocked) - lhs and rhs must have the same block size.");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<BlockedMatrix<VT>>(numRows, numCols, blockSize);
+        else if(res->getNumRows() != numRows || res->getNumCols() != numCols || res->getBlockSize() != blockSize)
+            throw std::runtime_error("EwBinaryMat(Blocked) - res must have the shape and block size of lhs.");
+
+        const VT zeroOpZero = getEwBinaryScaFuncPtr<VT, VT, VT>(opCode)(VT(0), VT(0), ctx);
+
+        // Like the other element-wise kernels, this one is sequential, the vectorized engine runs it on its workers.
+        for(size_t rb = 0; rb < lhs->getNumRowBlocks(); rb++)
+            for(size_t cb = 0; cb < lhs->getNumColBlocks(); cb++)
+                applyBlock(opCode, zeroOpZero, res, lhs, rhs, rb, cb, ctx);
+    }
+
+private:
+    static void applyBlock(BinaryOpCode opCode, VT zeroOpZero, BlockedMatrix<VT> * res, const BlockedMatrix<VT> * lhs,
+            const BlockedMatrix<VT> * rhs, size_t rb, size_t cb, DCTX(ctx)) {
+        using BlockType = typename BlockedMatrix<VT>::BlockType;
+        const BlockType typeLhs = lhs->getBlockType(rb, cb);
+        const BlockType typeRhs = rhs->getBlockType(rb, cb);
+
+        // blocks of zeros stay empty if the operation maps zeros to zero
+        if(typeLhs == BlockType::EMPTY && typeRhs == BlockType::EMPTY && zeroOpZero == VT(0)) {
+            res->setDenseBlock(rb, cb, nullptr);
+            return;
         }
-        default:
-            throw std::runtime_error("EwBinaryMat(CSR) - unknown BinaryOpCode");
+        if(opCode == BinaryOpCode::MUL && (typeLhs == BlockType::EMPTY || typeRhs == BlockType::EMPTY)) {
+            res->setDenseBlock(rb, cb, nullptr);
+            return;
         }
 
-        // TODO Update number of non-zeros in result in the end.
+        if(typeLhs == BlockType::SPARSE && typeRhs == BlockType::SPARSE
+                && (EwBinaryCSR::isIntersecting(opCode) || EwBinaryCSR::isUniting(opCode))) {
+            CSRMatrix<VT> * block = nullptr;
+            EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, CSRMatrix<VT>>::apply(opCode, block,
+                    lhs->getSparseBlock(rb, cb), rhs->getSparseBlock(rb, cb), ctx);
+            res->setSparseBlock(rb, cb, block);
+        }
+        else if(typeLhs == BlockType::SPARSE && typeRhs == BlockType::DENSE && EwBinaryCSR::isIntersecting(opCode)) {
+            CSRMatrix<VT> * block = nullptr;
+            EwBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>>::apply(opCode, block,
+                    lhs->getSparseBlock(rb, cb), rhs->getDenseBlock(rb, cb), ctx);
+            res->setSparseBlock(rb, cb, block);
+        }
+        else {
+            const DenseMatrix<VT> * blockLhs = lhs->getBlockAsDense(rb, cb);
+            const DenseMatrix<VT> * blockRhs = rhs->getBlockAsDense(rb, cb);
+            DenseMatrix<VT> * block = nullptr;
+            EwBinaryMat<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>>::apply(opCode, block, blockLhs,
+                    blockRhs, ctx);
+            DataObjectFactory::destroy(blockLhs, blockRhs);
+            res->setDenseBlock(rb, cb, block);
+        }
+        res->compactBlock(rb, cb);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// BitMatrix <- DenseMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * Supports the comparisons, whose mask is packed into words of 64 cells in parallel chunks (see `BitMask`).
+ */
+template<typename VT>
+struct EwBinaryMat<BitMatrix, DenseMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(BinaryOpCode opCode, BitMatrix *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+        if( numRows != rhs->getNumRows() || numCols != rhs->getNumCols() )
+            throw std::runtime_error("EwBinaryMat(BitMatrix) - lhs and rhs must have the same dimensions.");
+        if(!BitMask::isComparison(opCode))
+            throw std::runtime_error("EwBinaryMat(BitMatrix) - unsupported BinaryOpCode, only comparisons result in a mask");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<BitMatrix>(numRows, numCols, false);
+
+        BitMask::compare(opCode, res, lhs, rhs->getValues(), 1, rhs->getRowSkip(), ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix, BitMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * Combines each cell of lhs with its bit as zero or one. `MUL` applies the mask: it selects the cells whose bit is set
+ * and zeros the others (also if they are not finite). The words are processed in parallel chunks.
+ */
+template<typename VT>
+struct EwBinaryMat<DenseMatrix<VT>, DenseMatrix<VT>, BitMatrix> {
+    static void apply(BinaryOpCode opCode, DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const BitMatrix * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = lhs->getNumCols();
+        if( numRows != rhs->getNumRows() || numCols != rhs->getNumCols() )
+            throw std::runtime_error("EwBinaryMat(BitMatrix) - lhs and rhs must have the same dimensions.");
+
+        // An operand at its last use is overwritten with the result, see ReuseArg.h.
+        if(res == nullptr && !reuseArgAsRes(res, lhs, numRows, numCols))
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+        const size_t numCells = numRows * numCols;
+        const size_t numWords = rhs->getNumWords();
+        const uint64_t * words = rhs->getWords();
+        const VT * valuesLhs = lhs->getValues();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+        const bool contiguous = rowSkipLhs == numCols && rowSkipRes == numCols;
+        EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(opCode);
+
+        WorkerPool::parallelFor(ctx, BitMask::getNumChunks(numWords), [&](size_t chunk) {
+            const size_t endWord = std::min(numWords, (chunk + 1) * BitMask::CHUNK_WORDS);
+            for(size_t w = chunk * BitMask::CHUNK_WORDS; w < endWord; w++) {
+                const size_t begin = w * 64;
+                const size_t n = std::min<size_t>(64, numCells - begin);
+                const uint64_t word = words[w];
+                if(contiguous && opCode == BinaryOpCode::MUL) {
+                    for(size_t j = 0; j < n; j++)
+                        valuesRes[begin + j] = (word >> j) & 1 ? valuesLhs[begin + j] : VT(0);
+                    continue;
+                }
+                for(size_t j = 0; j < n; j++) {
+                    const size_t r = (begin + j) / numCols;
+                    const size_t c = (begin + j) % numCols;
+                    const VT bit = VT((word >> j) & 1);
+                    valuesRes[r * rowSkipRes + c] = opCode == BinaryOpCode::MUL
+                            ? (bit != VT(0) ? valuesLhs[r * rowSkipLhs + c] : VT(0))
+                            : func(valuesLhs[r * rowSkipLhs + c], bit, ctx);
+                }
+            }
+        });
     }
 };
 
@@ -344,3 +486,63 @@ struct EwBinaryMat<Matrix<VT>, Matrix<VT>, Matrix<VT>> {
         res->finishAppend();
     }
 };
+
+// ****************************************************************************
+// Static shapes
+// ****************************************************************************
+
+/**
+ * @brief An elementwise binary operation on dense matrices of the same static
+ * shape, which is known at compile-time (see MarkStaticShapeOpsPass), such
+ * that the loops over the cells are unrolled completely and no op code is
+ * interpreted after inlining.
+ */
+template<size_t numRows, size_t numCols, typename VTres, typename VTlhs, typename VTrhs>
+struct EwBinaryMatStatic {
+    static void apply(BinaryOpCode opCode, DenseMatrix<VTres> *& res, const DenseMatrix<VTlhs> * lhs, const DenseMatrix<VTrhs> * rhs, DCTX(ctx)) {
+        assert(lhs->getNumRows() == numRows && lhs->getNumCols() == numCols && "lhs must have the static shape");
+        assert(rhs->getNumRows() == numRows && rhs->getNumCols() == numCols && "rhs must have the static shape");
+
+        if(res == nullptr && !reuseArgAsRes(res, lhs, numRows, numCols) && !reuseArgAsRes(res, rhs, numRows, numCols))
+            res = DataObjectFactory::create<DenseMatrix<VTres>>(numRows, numCols, false);
+
+        switch(opCode) {
+#define MAKE_CASE(opCode) case opCode: applyOp<opCode>(res, lhs, rhs, ctx); break;
+            MAKE_CASE(BinaryOpCode::ADD)
+            MAKE_CASE(BinaryOpCode::SUB)
+            MAKE_CASE(BinaryOpCode::MUL)
+            MAKE_CASE(BinaryOpCode::DIV)
+#undef MAKE_CASE
+            default:
+                EwBinaryMat<DenseMatrix<VTres>, DenseMatrix<VTlhs>, DenseMatrix<VTrhs>>::apply(opCode, res, lhs, rhs, ctx);
+        }
+    }
+
+private:
+    template<BinaryOpCode opCode, size_t... c>
+    static void applyRow(VTres * valuesRes, const VTlhs * valuesLhs, const VTrhs * valuesRhs, std::index_sequence<c...>, DCTX(ctx)) {
+        ((valuesRes[c] = EwBinarySca<opCode, VTres, VTlhs, VTrhs>::apply(valuesLhs[c], valuesRhs[c], ctx)), ...);
+    }
+
+    template<BinaryOpCode opCode>
+    static void applyOp(DenseMatrix<VTres> * res, const DenseMatrix<VTlhs> * lhs, const DenseMatrix<VTrhs> * rhs, DCTX(ctx)) {
+        const VTlhs * valuesLhs = lhs->getValues();
+        const VTrhs * valuesRhs = rhs->getValues();
+        VTres * valuesRes = res->getValues();
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+        for(size_t r = 0; r < numRows; r++)
+            applyRow<opCode>(
+                    valuesRes + r * rowSkipRes, valuesLhs + r * rowSkipLhs, valuesRhs + r * rowSkipRhs,
+                    std::make_index_sequence<numCols>(), ctx
+            );
+    }
+};
+
+template<size_t numRows, size_t numCols, class DTRes, class DTLhs, class DTRhs>
+void ewBinaryMat(BinaryOpCode opCode, DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, DCTX(ctx)) {
+    EwBinaryMatStatic<numRows, numCols, typename DTRes::VT, typename DTLhs::VT, typename DTRhs::VT>::apply(
+            opCode, res, lhs, rhs, ctx
+    );
+}
@@ -18,13 +18,25 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_EWBINARYOBJSCA_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/Matrix.h>
 #include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/BitMask.h>
+#include <runtime/local/kernels/EwBinaryCSR.h>
 #include <runtime/local/kernels/EwBinarySca.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <runtime/local/kernels/ReuseArg.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
@@ -62,9 +74,27 @@ struct EwBinaryObjSca<DenseMatrix<VT>, DenseMatrix<VT>, VT> {
         const size_t numRows = lhs->getNumRows();
         const size_t numCols = lhs->getNumCols();
         
-        if(res == nullptr)
+        // An operand at its last use is overwritten with the result, see ReuseArg.h.
+        if(res == nullptr && !reuseArgAsRes(res, lhs, numRows, numCols))
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
         
+        // A point comparison of a column with an index (see `KeyIndex`) looks up the rows of the scalar.
+        if((opCode == BinaryOpCode::EQ || opCode == BinaryOpCode::NEQ) && numCols == 1 && lhs->getRowSkip() == 1
+                && res != lhs) {
+            auto keyIndex = lhs->getKeyIndex(0);
+            if(keyIndex && keyIndex->getNumRows() == numRows) {
+                const size_t k = KeyIndexes::lookup(*keyIndex, lhs->getValues(), rhs);
+                VT * valuesRes = res->getValues();
+                const size_t rowSkipRes = res->getRowSkip();
+                for(size_t r = 0; r < numRows; r++)
+                    valuesRes[r * rowSkipRes] = VT(opCode == BinaryOpCode::NEQ);
+                if(k != KeyIndex::npos)
+                    for(const size_t * r = keyIndex->getRowsBegin(k); r != keyIndex->getRowsEnd(k); r++)
+                        valuesRes[*r * rowSkipRes] = VT(opCode == BinaryOpCode::EQ);
+                return;
+            }
+        }
+        
         const VT * valuesLhs = lhs->getValues();
         VT * valuesRes = res->getValues();
         
@@ -79,6 +109,108 @@ struct EwBinaryObjSca<DenseMatrix<VT>, DenseMatrix<VT>, VT> {
     }
 };
 
+// ----------------------------------------------------------------------------
+// BitMatrix <- DenseMatrix, scalar
+// ----------------------------------------------------------------------------
+
+/**
+ * Supports the comparisons, whose mask is packed into words of 64 cells in parallel chunks (see `BitMask`).
+ */
+template<typename VT>
+struct EwBinaryObjSca<BitMatrix, DenseMatrix<VT>, VT> {
+    static void apply(BinaryOpCode opCode, BitMatrix *& res, const DenseMatrix<VT> * lhs, VT rhs, DCTX(ctx)) {
+        if(!BitMask::isComparison(opCode))
+            throw std::runtime_error("EwBinaryObjSca(BitMatrix) - unsupported BinaryOpCode, only comparisons result in a mask");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<BitMatrix>(lhs->getNumRows(), lhs->getNumCols(), false);
+
+        BitMask::compare(opCode, res, lhs, &rhs, 0, 0, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CSRMatrix <- CSRMatrix, scalar
+// ----------------------------------------------------------------------------
+
+/**
+ * Supports the operations which map zero to zero with the given scalar, e.g., `MUL`, `DIV` by a non-zero, `MIN` with
+ * a non-negative or `GT` with a non-negative scalar. The result has the sparsity structure of lhs, whose buffers it
+ * shares (see `CSRMatrix`), so it stores the non-zeros of lhs which are mapped to zero as explicit zeros, e.g., those
+ * of a mask. The values are computed in parallel.
+ */
+template<typename VT>
+struct EwBinaryObjSca<CSRMatrix<VT>, CSRMatrix<VT>, VT> {
+    static void apply(BinaryOpCode opCode, CSRMatrix<VT> *& res, const CSRMatrix<VT> * lhs, VT rhs, DCTX(ctx)) {
+        EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(opCode);
+
+        // an integral division by zero does not map zero to anything
+        const bool divByZero = std::is_integral<VT>::value
+                && (opCode == BinaryOpCode::DIV || opCode == BinaryOpCode::MOD) && rhs == VT(0);
+        if(divByZero || func(VT(0), rhs, ctx) != VT(0))
+            throw std::runtime_error("EwBinaryObjSca(CSR) - the operation does not map zero to zero with this "
+                    "scalar, the result would not be sparse");
+
+        const size_t numRows = lhs->getNumRows();
+        const size_t nnz = lhs->getNumNonZeros();
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(lhs);
+        else {
+            // a given result gets a copy of the sparsity structure
+            if(res->getNumRows() != numRows || res->getNumCols() != lhs->getNumCols())
+                throw std::runtime_error("EwBinaryObjSca(CSR) - res must have the shape of lhs");
+            const size_t * rowOffsetsLhs = lhs->getRowOffsets();
+            size_t * rowOffsetsRes = res->getRowOffsets();
+            for(size_t r = 0; r <= numRows; r++)
+                rowOffsetsRes[r] = rowOffsetsLhs[r] - rowOffsetsLhs[0];
+            std::copy(lhs->getColIdxs(0), lhs->getColIdxs(0) + nnz, res->getColIdxs());
+        }
+
+        const VT * valuesLhs = lhs->getValues(0);
+        VT * valuesRes = res->getValues(0);
+        const size_t numChunks = EwBinaryCSR::getNumChunks(nnz, nnz);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const size_t end = nnz * (i + 1) / numChunks;
+            for(size_t k = nnz * i / numChunks; k < end; k++)
+                valuesRes[k] = func(valuesLhs[k], rhs, ctx);
+        });
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CompressedMatrix <- CompressedMatrix, scalar
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct EwBinaryObjSca<CompressedMatrix<VT>, CompressedMatrix<VT>, VT> {
+    static void apply(BinaryOpCode opCode, CompressedMatrix<VT> *& res, const CompressedMatrix<VT> * lhs, VT rhs,
+            DCTX(ctx)) {
+        if(res != nullptr)
+            throw std::runtime_error("EwBinaryObjSca(Compressed) - a CompressedMatrix cannot be overwritten, res must "
+                    "be nullptr");
+
+        EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(opCode);
+        auto mapValues = [&](std::vector<VT> & values) {
+            const size_t n = values.size();
+            const size_t numChunks = EwBinaryCSR::getNumChunks(n, n);
+            WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+                const size_t end = n * (i + 1) / numChunks;
+                for(size_t k = n * i / numChunks; k < end; k++)
+                    values[k] = func(values[k], rhs, ctx);
+            });
+        };
+
+        // the result shares the mappings of the rows to the tuples, only the tuples (and uncompressed values) change
+        std::vector<ColGroup<VT>> groups = lhs->getColGroups();
+        for(ColGroup<VT> & group : groups) {
+            mapValues(group.dictionary);
+            mapValues(group.defaultTuple);
+            mapValues(group.values);
+        }
+        res = DataObjectFactory::create<CompressedMatrix<VT>>(lhs->getNumRows(), lhs->getNumCols(), groups);
+    }
+};
+
 // ----------------------------------------------------------------------------
 // Matrix <- Matrix, scalar
 // ----------------------------------------------------------------------------
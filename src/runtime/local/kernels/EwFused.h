@@ -0,0 +1,730 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/kernels/AggReduce.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/EwBinarySca.h>
+#include <runtime/local/kernels/EwUnarySca.h>
+#include <runtime/local/kernels/UnaryOpCode.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// the columns of a row (or the rows of a column) evaluated at once, and the
+// cells evaluated by one task
+constexpr size_t EWFUSED_BLOCK_COLS = 1 << 8;
+constexpr size_t EWFUSED_CHUNK_CELLS = 1 << 16;
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTArg>
+struct EwFused {
+    static void apply(DTRes *& res, const char * program, const DTArg ** args, size_t numArgs, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Evaluates a tree of element-wise operations on the given matrices,
+ * optionally aggregated, in a single pass over them (see `FuseEwiseOpsPass`).
+ *
+ * This is a kernel-level fusion fallback, not generated code: the program is
+ * interpreted once per block of values (not per value), calling the
+ * precompiled loop of each operation on the whole block. It saves the memory
+ * traffic of the intermediate results, but not the dispatch of each operation.
+ * `EwFusedBenchmark` compares it with one kernel call per operation.
+ *
+ * The program consists of the aggregation (`none`, or `sum`, `min`, or `max`
+ * followed by `Row`, `Col`, or `All`) and the operations, separated by `;`.
+ * An operation is the name of a `BinaryOpCode` or `UnaryOpCode` in lower case
+ * followed by its operands, which are the arguments `a<i>`, the results of
+ * the preceding operations `r<i>`, or constants `c<value>`. The result is
+ * the one of the last operation, e.g., `sumAll;sub a0 a1;pow r0 c2;div r1 a2`
+ * for `sum((a0 - a1) ^ 2 / a2)`.
+ *
+ * The arguments are broadcast like by `ewBinaryMat` to the largest number of
+ * rows and columns of all arguments, i.e., each argument is a matrix of this
+ * shape, a row vector, a column vector, or a single value. Each row is
+ * evaluated in blocks of columns, which stay in the L1 cache between the
+ * operations, in loops the compiler vectorizes. If all arguments are
+ * contiguous or single values and the result is not aggregated per row or
+ * column, the blocks span rows instead. Instead of materializing the
+ * result of each operation, only the result of the whole tree is written.
+ *
+ * The aggregation `All` yields a 1x1 matrix.
+ *
+ * The operands of an `and` (`or`) whose right operand is the result of a
+ * subtree of preceding operations are short-circuited block by block: if its
+ * left operand is zero (non-zero) for all values of a block, the subtree is
+ * not evaluated for this block.
+ *
+ * The arguments may also be frames of a single column of any numeric value
+ * type (see `FuseSqlExprsPass`), which are converted to the value type of the
+ * result block by block. Their rows are evaluated in blocks, and they cannot
+ * be aggregated.
+ */
+template<class DTRes, class DTArg>
+void ewFused(DTRes *& res, const char * program, const DTArg ** args, size_t numArgs, DCTX(ctx)) {
+    EwFused<DTRes, DTArg>::apply(res, program, args, numArgs, ctx);
+}
+
+// ****************************************************************************
+// Program
+// ****************************************************************************
+
+struct EwFusedOperand {
+    enum class Kind { ARG, REG, CONST } kind;
+    size_t idx;
+    double value;
+};
+
+struct EwFusedInstr {
+    bool isUnary;
+    BinaryOpCode binaryOp;
+    UnaryOpCode unaryOp;
+    EwFusedOperand lhs;
+    EwFusedOperand rhs;
+};
+
+struct EwFusedProgram {
+    enum class Agg { NONE, ROW, COL, ALL } agg = Agg::NONE;
+    BinaryOpCode aggOp = BinaryOpCode::ADD;
+    std::vector<EwFusedInstr> instrs;
+    // for each operation, the `and`/`or` operations (outermost first) whose
+    // right operand is the subtree starting at this operation and that can
+    // skip it
+    std::vector<std::vector<size_t>> shortCircuits;
+
+    static EwFusedOperand parseOperand(const std::string & token, size_t numArgs, size_t numRegs) {
+        if(token.size() >= 2) {
+            const char * begin = token.c_str() + 1;
+            char * end = nullptr;
+            if(token[0] == 'c') {
+                const double value = std::strtod(begin, &end);
+                if(*end == '\0')
+                    return {EwFusedOperand::Kind::CONST, 0, value};
+            }
+            else if(token[0] == 'a' || token[0] == 'r') {
+                const size_t idx = std::strtoull(begin, &end, 10);
+                if(*end == '\0' && idx < (token[0] == 'a' ? numArgs : numRegs))
+                    return {token[0] == 'a' ? EwFusedOperand::Kind::ARG : EwFusedOperand::Kind::REG, idx, 0};
+            }
+        }
+        throw std::runtime_error("ewFused: invalid operand " + token);
+    }
+
+    static bool parseBinaryOp(const std::string & name, BinaryOpCode & op) {
+        static const std::pair<const char *, BinaryOpCode> ops[] = {
+            {"add", BinaryOpCode::ADD}, {"sub", BinaryOpCode::SUB}, {"mul", BinaryOpCode::MUL},
+            {"div", BinaryOpCode::DIV}, {"pow", BinaryOpCode::POW}, {"mod", BinaryOpCode::MOD},
+            {"log", BinaryOpCode::LOG}, {"eq", BinaryOpCode::EQ}, {"neq", BinaryOpCode::NEQ},
+            {"lt", BinaryOpCode::LT}, {"le", BinaryOpCode::LE}, {"gt", BinaryOpCode::GT},
+            {"ge", BinaryOpCode::GE}, {"min", BinaryOpCode::MIN}, {"max", BinaryOpCode::MAX},
+            {"and", BinaryOpCode::AND}, {"or", BinaryOpCode::OR},
+        };
+        for(const auto & [n, o] : ops)
+            if(name == n) {
+                op = o;
+                return true;
+            }
+        return false;
+    }
+
+    static bool parseUnaryOp(const std::string & name, UnaryOpCode & op) {
+        static const std::pair<const char *, UnaryOpCode> ops[] = {
+            {"sign", UnaryOpCode::SIGN}, {"sqrt", UnaryOpCode::SQRT}, {"exp", UnaryOpCode::EXP},
+            {"ln", UnaryOpCode::LN}, {"abs", UnaryOpCode::ABS}, {"floor", UnaryOpCode::FLOOR},
+            {"ceil", UnaryOpCode::CEIL}, {"round", UnaryOpCode::ROUND},
+        };
+        for(const auto & [n, o] : ops)
+            if(name == n) {
+                op = o;
+                return true;
+            }
+        return false;
+    }
+
+    static EwFusedProgram parse(const std::string & program, size_t numArgs) {
+        EwFusedProgram res;
+        std::stringstream ss(program);
+        std::string part;
+
+        std::getline(ss, part, ';');
+        if(part != "none") {
+            const std::string op = part.substr(0, 3);
+            const std::string dim = part.size() > 3 ? part.substr(3) : "";
+            if(op == "sum")
+                res.aggOp = BinaryOpCode::ADD;
+            else if(op == "min")
+                res.aggOp = BinaryOpCode::MIN;
+            else if(op == "max")
+                res.aggOp = BinaryOpCode::MAX;
+            else
+                throw std::runtime_error("ewFused: invalid aggregation " + part);
+            if(dim == "Row")
+                res.agg = Agg::ROW;
+            else if(dim == "Col")
+                res.agg = Agg::COL;
+            else if(dim == "All")
+                res.agg = Agg::ALL;
+            else
+                throw std::runtime_error("ewFused: invalid aggregation " + part);
+        }
+
+        while(std::getline(ss, part, ';')) {
+            std::stringstream tokens(part);
+            std::string name, lhs, rhs;
+            tokens >> name >> lhs >> rhs;
+            EwFusedInstr instr{};
+            const size_t numRegs = res.instrs.size();
+            if(parseBinaryOp(name, instr.binaryOp) && !rhs.empty()) {
+                instr.isUnary = false;
+                instr.rhs = parseOperand(rhs, numArgs, numRegs);
+            }
+            else if(parseUnaryOp(name, instr.unaryOp) && rhs.empty())
+                instr.isUnary = true;
+            else
+                throw std::runtime_error("ewFused: invalid operation " + part);
+            instr.lhs = parseOperand(lhs, numArgs, numRegs);
+            res.instrs.push_back(instr);
+        }
+        if(res.instrs.empty())
+            throw std::runtime_error("ewFused: the program has no operations");
+        res.findShortCircuits();
+        return res;
+    }
+
+private:
+    static bool isReg(const EwFusedOperand & o) {
+        return o.kind == EwFusedOperand::Kind::REG;
+    }
+
+    void findShortCircuits() {
+        const size_t numInstrs = instrs.size();
+        shortCircuits.assign(numInstrs, {});
+        // the first operation of the subtree of each operation, and the users
+        // of each result
+        std::vector<size_t> start(numInstrs);
+        std::vector<std::vector<size_t>> users(numInstrs);
+        for(size_t k = 0; k < numInstrs; k++) {
+            start[k] = k;
+            for(const EwFusedOperand * o : {&instrs[k].lhs, &instrs[k].rhs})
+                if(!(o == &instrs[k].rhs && instrs[k].isUnary) && isReg(*o)) {
+                    start[k] = std::min(start[k], start[o->idx]);
+                    users[o->idx].push_back(k);
+                }
+        }
+        for(size_t m = numInstrs; m-- > 0;) {
+            const EwFusedInstr & instr = instrs[m];
+            if(instr.isUnary || (instr.binaryOp != BinaryOpCode::AND && instr.binaryOp != BinaryOpCode::OR))
+                continue;
+            if(!isReg(instr.rhs) || instr.rhs.idx + 1 != m)
+                continue;
+            const size_t first = start[instr.rhs.idx];
+            if(isReg(instr.lhs) && instr.lhs.idx >= first)
+                continue;
+            // the skipped results must not be used elsewhere
+            bool skippable = true;
+            for(size_t j = first; j < m; j++)
+                for(size_t u : users[j])
+                    skippable &= u < m || (u == m && j + 1 == m);
+            if(skippable)
+                shortCircuits[first].push_back(m);
+        }
+    }
+};
+
+// ****************************************************************************
+// Evaluation
+// ****************************************************************************
+
+/**
+ * @brief The values of an operand for a block of columns: either `n` values
+ * at `ptr` or a single value broadcast to all columns.
+ */
+template<typename VT>
+struct EwFusedValues {
+    const VT * ptr;
+    VT value;
+};
+
+template<BinaryOpCode op, typename VT>
+void ewFusedBinary(VT * out, EwFusedValues<VT> lhs, EwFusedValues<VT> rhs, size_t n) {
+    using Op = EwBinarySca<op, VT, VT, VT>;
+    if(lhs.ptr && rhs.ptr) {
+        const VT * l = lhs.ptr;
+        const VT * r = rhs.ptr;
+        for(size_t i = 0; i < n; i++)
+            out[i] = Op::apply(l[i], r[i], nullptr);
+    }
+    else if(lhs.ptr) {
+        const VT * l = lhs.ptr;
+        const VT r = rhs.value;
+        for(size_t i = 0; i < n; i++)
+            out[i] = Op::apply(l[i], r, nullptr);
+    }
+    else if(rhs.ptr) {
+        const VT l = lhs.value;
+        const VT * r = rhs.ptr;
+        for(size_t i = 0; i < n; i++)
+            out[i] = Op::apply(l, r[i], nullptr);
+    }
+    else
+        std::fill(out, out + n, Op::apply(lhs.value, rhs.value, nullptr));
+}
+
+template<UnaryOpCode op, typename VT>
+void ewFusedUnary(VT * out, EwFusedValues<VT> arg, size_t n) {
+    using Op = EwUnarySca<op, VT, VT>;
+    if(arg.ptr) {
+        const VT * a = arg.ptr;
+        for(size_t i = 0; i < n; i++)
+            out[i] = Op::apply(a[i], nullptr);
+    }
+    else
+        std::fill(out, out + n, Op::apply(arg.value, nullptr));
+}
+
+template<typename VT>
+void ewFusedApply(const EwFusedInstr & instr, VT * out, EwFusedValues<VT> lhs, EwFusedValues<VT> rhs, size_t n) {
+    if(instr.isUnary) {
+        switch(instr.unaryOp) {
+#define MAKE_CASE(opCode) case opCode: ewFusedUnary<opCode>(out, lhs, n); return;
+            MAKE_CASE(UnaryOpCode::SIGN)
+            MAKE_CASE(UnaryOpCode::SQRT)
+            MAKE_CASE(UnaryOpCode::EXP)
+            MAKE_CASE(UnaryOpCode::LN)
+            MAKE_CASE(UnaryOpCode::ABS)
+            MAKE_CASE(UnaryOpCode::FLOOR)
+            MAKE_CASE(UnaryOpCode::CEIL)
+            MAKE_CASE(UnaryOpCode::ROUND)
+#undef MAKE_CASE
+        }
+    }
+    else {
+        switch(instr.binaryOp) {
+#define MAKE_CASE(opCode) case opCode: ewFusedBinary<opCode>(out, lhs, rhs, n); return;
+            MAKE_CASE(BinaryOpCode::ADD)
+            MAKE_CASE(BinaryOpCode::SUB)
+            MAKE_CASE(BinaryOpCode::MUL)
+            MAKE_CASE(BinaryOpCode::DIV)
+            MAKE_CASE(BinaryOpCode::POW)
+            MAKE_CASE(BinaryOpCode::MOD)
+            MAKE_CASE(BinaryOpCode::LOG)
+            MAKE_CASE(BinaryOpCode::EQ)
+            MAKE_CASE(BinaryOpCode::NEQ)
+            MAKE_CASE(BinaryOpCode::LT)
+            MAKE_CASE(BinaryOpCode::LE)
+            MAKE_CASE(BinaryOpCode::GT)
+            MAKE_CASE(BinaryOpCode::GE)
+            MAKE_CASE(BinaryOpCode::MIN)
+            MAKE_CASE(BinaryOpCode::MAX)
+            MAKE_CASE(BinaryOpCode::AND)
+            MAKE_CASE(BinaryOpCode::OR)
+#undef MAKE_CASE
+            default:
+                break;
+        }
+    }
+    throw std::runtime_error("ewFused: unsupported operation");
+}
+
+/**
+ * @brief Evaluates the operations of a program on a block of `n` values.
+ *
+ * @param values The values of an operand for this block.
+ * @param outOf The destination of the result of an operation.
+ */
+template<typename VT, class ValuesFn, class OutFn>
+void ewFusedEvalBlock(const EwFusedProgram & prog, ValuesFn values, OutFn outOf, size_t n) {
+    const std::vector<EwFusedInstr> & instrs = prog.instrs;
+    const size_t numInstrs = instrs.size();
+    for(size_t k = 0; k < numInstrs;) {
+        // skip the right operand of an `and` (`or`) whose left operand is
+        // zero (non-zero) in the whole block
+        bool skipped = false;
+        for(size_t m : prog.shortCircuits[k]) {
+            const bool isAnd = instrs[m].binaryOp == BinaryOpCode::AND;
+            const EwFusedValues<VT> lhs = values(instrs[m].lhs);
+            const bool decided = lhs.ptr
+                    ? std::all_of(lhs.ptr, lhs.ptr + n, [&](VT v) { return (v != VT(0)) != isAnd; })
+                    : (lhs.value != VT(0)) != isAnd;
+            if(decided) {
+                VT * out = outOf(m);
+                std::fill(out, out + n, VT(isAnd ? 0 : 1));
+                k = m + 1;
+                skipped = true;
+                break;
+            }
+        }
+        if(skipped)
+            continue;
+        ewFusedApply(instrs[k], outOf(k), values(instrs[k].lhs),
+                instrs[k].isUnary ? EwFusedValues<VT>{nullptr, 0} : values(instrs[k].rhs), n);
+        k++;
+    }
+}
+
+// the aggregated value of n values, reduced by independent accumulators (see `AggReduce`)
+template<typename VT>
+VT ewFusedReduce(BinaryOpCode aggOp, VT acc, const VT * vals, size_t n) {
+    switch(aggOp) {
+        case BinaryOpCode::ADD: return acc + AggReduce::reduceLanes<BinaryOpCode::ADD>(vals, n, VT(0), nullptr);
+        case BinaryOpCode::MIN: return AggReduce::reduceLanes<BinaryOpCode::MIN>(vals, n, acc, nullptr);
+        case BinaryOpCode::MAX: return AggReduce::reduceLanes<BinaryOpCode::MAX>(vals, n, acc, nullptr);
+        default: throw std::runtime_error("ewFused: unsupported aggregation");
+    }
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct EwFused<DenseMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const char * program, const DenseMatrix<VT> ** args, size_t numArgs,
+            DCTX(ctx)) {
+        using Agg = EwFusedProgram::Agg;
+        const EwFusedProgram prog = EwFusedProgram::parse(program, numArgs);
+        const std::vector<EwFusedInstr> & instrs = prog.instrs;
+        const size_t numInstrs = instrs.size();
+
+        size_t numRows = 0;
+        size_t numCols = 0;
+        for(size_t i = 0; i < numArgs; i++) {
+            numRows = std::max(numRows, args[i]->getNumRows());
+            numCols = std::max(numCols, args[i]->getNumCols());
+        }
+        for(size_t i = 0; i < numArgs; i++) {
+            const size_t r = args[i]->getNumRows();
+            const size_t c = args[i]->getNumCols();
+            if((r != numRows && r != 1) || (c != numCols && c != 1))
+                throw std::runtime_error("ewFused: the arguments cannot be broadcast to the same shape");
+        }
+
+        const size_t numRowsRes = prog.agg == Agg::NONE || prog.agg == Agg::ROW ? numRows : 1;
+        const size_t numColsRes = prog.agg == Agg::NONE || prog.agg == Agg::COL ? numCols : 1;
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsRes, numColsRes, false);
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+        if(numRows == 0 || numCols == 0) {
+            // the aggregates of no values
+            for(size_t r = 0; r < res->getNumRows(); r++)
+                std::fill(valuesRes + r * rowSkipRes, valuesRes + r * rowSkipRes + res->getNumCols(), VT(0));
+            return;
+        }
+
+        if(isFlat(prog, args, numArgs, res, numRows, numCols)) {
+            applyFlat(prog, args, numArgs, valuesRes, numRows * numCols, ctx);
+            return;
+        }
+
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows * numCols / EWFUSED_CHUNK_CELLS));
+        // the partial column and full aggregates of the chunks
+        std::vector<std::vector<VT>> partials(prog.agg == Agg::COL || prog.agg == Agg::ALL ? numChunks : 0);
+
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t rowBegin = numRows * chunk / numChunks;
+            const size_t rowEnd = numRows * (chunk + 1) / numChunks;
+            std::vector<VT> regs(numInstrs * EWFUSED_BLOCK_COLS);
+            std::vector<VT> * partial = partials.empty() ? nullptr : &partials[chunk];
+            if(partial)
+                partial->resize(prog.agg == Agg::COL ? numCols : 1);
+
+            for(size_t r = rowBegin; r < rowEnd; r++) {
+                VT rowAcc = 0;
+                for(size_t c0 = 0; c0 < numCols; c0 += EWFUSED_BLOCK_COLS) {
+                    const size_t n = std::min(EWFUSED_BLOCK_COLS, numCols - c0);
+                    auto values = [&](const EwFusedOperand & o) -> EwFusedValues<VT> {
+                        switch(o.kind) {
+                            case EwFusedOperand::Kind::CONST:
+                                return {nullptr, static_cast<VT>(o.value)};
+                            case EwFusedOperand::Kind::REG:
+                                return {regs.data() + o.idx * EWFUSED_BLOCK_COLS, 0};
+                            default: {
+                                const DenseMatrix<VT> * arg = args[o.idx];
+                                const VT * row = arg->getValues()
+                                        + (arg->getNumRows() == 1 ? 0 : r * arg->getRowSkip());
+                                if(arg->getNumCols() == 1)
+                                    return {nullptr, row[0]};
+                                return {row + c0, 0};
+                            }
+                        }
+                    };
+                    ewFusedEvalBlock<VT>(prog, values, [&](size_t k) {
+                        // the last operation writes the result directly
+                        return (k + 1 == numInstrs && prog.agg == Agg::NONE)
+                                ? valuesRes + r * rowSkipRes + c0
+                                : regs.data() + k * EWFUSED_BLOCK_COLS;
+                    }, n);
+
+                    const VT * last = regs.data() + (numInstrs - 1) * EWFUSED_BLOCK_COLS;
+                    switch(prog.agg) {
+                        case Agg::NONE:
+                            break;
+                        case Agg::ROW:
+                            rowAcc = ewFusedReduce(prog.aggOp, c0 == 0 ? last[0] : rowAcc, last + (c0 == 0), n - (c0 == 0));
+                            break;
+                        case Agg::COL: {
+                            VT * acc = partial->data() + c0;
+                            if(r == rowBegin)
+                                std::copy(last, last + n, acc);
+                            else
+                                ewFusedBinaryAgg(prog.aggOp, acc, last, n);
+                            break;
+                        }
+                        case Agg::ALL: {
+                            const bool first = r == rowBegin && c0 == 0;
+                            (*partial)[0] = ewFusedReduce(prog.aggOp, first ? last[0] : (*partial)[0], last + first,
+                                    n - first);
+                            break;
+                        }
+                    }
+                }
+                if(prog.agg == Agg::ROW)
+                    valuesRes[r * rowSkipRes] = rowAcc;
+            }
+        });
+
+        if(prog.agg == Agg::COL || prog.agg == Agg::ALL) {
+            std::vector<VT> & acc = partials[0];
+            for(size_t chunk = 1; chunk < numChunks; chunk++)
+                ewFusedBinaryAgg(prog.aggOp, acc.data(), partials[chunk].data(), acc.size());
+            std::copy(acc.begin(), acc.end(), valuesRes);
+        }
+    }
+
+private:
+    // whether the arguments are contiguous arrays of the full shape or single values, and the result is a
+    // contiguous array of this shape or the aggregate of all values
+    static bool isFlat(const EwFusedProgram & prog, const DenseMatrix<VT> ** args, size_t numArgs,
+            const DenseMatrix<VT> * res, size_t numRows, size_t numCols) {
+        using Agg = EwFusedProgram::Agg;
+        if(prog.agg == Agg::NONE && res->getRowSkip() != numCols && numRows > 1)
+            return false;
+        if(prog.agg == Agg::ROW || prog.agg == Agg::COL)
+            return false;
+        for(size_t i = 0; i < numArgs; i++) {
+            const size_t r = args[i]->getNumRows();
+            const size_t c = args[i]->getNumCols();
+            const bool full = r == numRows && c == numCols && (args[i]->getRowSkip() == numCols || numRows == 1);
+            if(!full && !(r == 1 && c == 1))
+                return false;
+        }
+        return true;
+    }
+
+    // Evaluates the program on the cells of contiguous arrays in blocks that span rows, such that the blocks of
+    // narrow matrices (e.g., of a few columns) are as long as the ones of wide matrices.
+    static void applyFlat(const EwFusedProgram & prog, const DenseMatrix<VT> ** args, size_t numArgs, VT * valuesRes,
+            size_t numCells, DCTX(ctx)) {
+        using Agg = EwFusedProgram::Agg;
+        const size_t numInstrs = prog.instrs.size();
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numCells / EWFUSED_CHUNK_CELLS));
+        std::vector<VT> partials(prog.agg == Agg::ALL ? numChunks : 0);
+
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t cellBegin = numCells * chunk / numChunks;
+            const size_t cellEnd = numCells * (chunk + 1) / numChunks;
+            std::vector<VT> regs(numInstrs * EWFUSED_BLOCK_COLS);
+            const VT * last = regs.data() + (numInstrs - 1) * EWFUSED_BLOCK_COLS;
+            for(size_t c0 = cellBegin; c0 < cellEnd; c0 += EWFUSED_BLOCK_COLS) {
+                const size_t n = std::min(EWFUSED_BLOCK_COLS, cellEnd - c0);
+                auto values = [&](const EwFusedOperand & o) -> EwFusedValues<VT> {
+                    switch(o.kind) {
+                        case EwFusedOperand::Kind::CONST:
+                            return {nullptr, static_cast<VT>(o.value)};
+                        case EwFusedOperand::Kind::REG:
+                            return {regs.data() + o.idx * EWFUSED_BLOCK_COLS, 0};
+                        default: {
+                            const DenseMatrix<VT> * arg = args[o.idx];
+                            if(arg->getNumRows() * arg->getNumCols() == 1)
+                                return {nullptr, arg->getValues()[0]};
+                            return {arg->getValues() + c0, 0};
+                        }
+                    }
+                };
+                ewFusedEvalBlock<VT>(prog, values, [&](size_t k) {
+                    // the last operation writes the result directly
+                    return (k + 1 == numInstrs && prog.agg == Agg::NONE)
+                            ? valuesRes + c0
+                            : regs.data() + k * EWFUSED_BLOCK_COLS;
+                }, n);
+                if(prog.agg == Agg::ALL) {
+                    const bool first = c0 == cellBegin;
+                    partials[chunk] = ewFusedReduce(prog.aggOp, first ? last[0] : partials[chunk], last + first,
+                            n - first);
+                }
+            }
+        });
+
+        if(prog.agg == Agg::ALL) {
+            VT acc = partials[0];
+            for(size_t chunk = 1; chunk < numChunks; chunk++)
+                ewFusedBinaryAgg(prog.aggOp, &acc, &partials[chunk], 1);
+            valuesRes[0] = acc;
+        }
+    }
+
+    // acc[i] = aggOp(acc[i], vals[i])
+    static void ewFusedBinaryAgg(BinaryOpCode aggOp, VT * acc, const VT * vals, size_t n) {
+        switch(aggOp) {
+            case BinaryOpCode::ADD: for(size_t i = 0; i < n; i++) acc[i] += vals[i]; break;
+            case BinaryOpCode::MIN: for(size_t i = 0; i < n; i++) acc[i] = std::min(acc[i], vals[i]); break;
+            case BinaryOpCode::MAX: for(size_t i = 0; i < n; i++) acc[i] = std::max(acc[i], vals[i]); break;
+            default: throw std::runtime_error("ewFused: unsupported aggregation");
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- Frame
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+class EwFused<DenseMatrix<VT>, Frame> {
+
+    using LoadFn = void (*)(VT * out, const void * col, size_t rowBegin, size_t n);
+
+    template<typename VTArg>
+    static void load(VT * out, const void * col, size_t rowBegin, size_t n) {
+        const VTArg * values = static_cast<const VTArg *>(col) + rowBegin;
+        for(size_t i = 0; i < n; i++)
+            out[i] = static_cast<VT>(values[i]);
+    }
+
+    static LoadFn getLoad(ValueTypeCode vtc) {
+        switch(vtc) {
+            case ValueTypeCode::F64: return load<double>;
+            case ValueTypeCode::F32: return load<float>;
+            case ValueTypeCode::SI64: return load<int64_t>;
+            case ValueTypeCode::SI32: return load<int32_t>;
+            case ValueTypeCode::SI8 : return load<int8_t>;
+            case ValueTypeCode::UI64: return load<uint64_t>;
+            case ValueTypeCode::UI32: return load<uint32_t>;
+            case ValueTypeCode::UI8 : return load<uint8_t>;
+            default: throw std::runtime_error("ewFused: unsupported value type of a frame column");
+        }
+    }
+
+public:
+    static void apply(DenseMatrix<VT> *& res, const char * program, const Frame ** args, size_t numArgs, DCTX(ctx)) {
+        const EwFusedProgram prog = EwFusedProgram::parse(program, numArgs);
+        if(prog.agg != EwFusedProgram::Agg::NONE)
+            throw std::runtime_error("ewFused: the columns of frames cannot be aggregated");
+        const size_t numInstrs = prog.instrs.size();
+
+        size_t numRows = 0;
+        for(size_t i = 0; i < numArgs; i++) {
+            if(args[i]->getNumCols() != 1)
+                throw std::runtime_error("ewFused: the frame arguments must have a single column");
+            numRows = std::max(numRows, args[i]->getNumRows());
+        }
+        // The columns are materialized (e.g., decoded) and their conversions
+        // are looked up before the parallel region. Columns of the value type
+        // of the result are used in place.
+        std::vector<const void *> cols(numArgs);
+        std::vector<LoadFn> loads(numArgs);
+        std::vector<VT> broadcast(numArgs);
+        for(size_t i = 0; i < numArgs; i++) {
+            const size_t r = args[i]->getNumRows();
+            if(r != numRows && r != 1)
+                throw std::runtime_error("ewFused: the arguments cannot be broadcast to the same shape");
+            const ValueTypeCode vtc = args[i]->getColumnType(0);
+            cols[i] = args[i]->getColumnRaw(0);
+            loads[i] = vtc == ValueTypeUtils::codeFor<VT> ? nullptr : getLoad(vtc);
+            if(r == 1)
+                getLoad(vtc)(&broadcast[i], cols[i], 0, 1);
+        }
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / EWFUSED_CHUNK_CELLS));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t rowBegin = numRows * chunk / numChunks;
+            const size_t rowEnd = numRows * (chunk + 1) / numChunks;
+            std::vector<VT> regs((numInstrs + 1) * EWFUSED_BLOCK_COLS);
+            std::vector<VT> loaded(numArgs * EWFUSED_BLOCK_COLS);
+            std::vector<bool> isLoaded(numArgs);
+            VT * last = regs.data() + numInstrs * EWFUSED_BLOCK_COLS;
+
+            for(size_t r0 = rowBegin; r0 < rowEnd; r0 += EWFUSED_BLOCK_COLS) {
+                const size_t n = std::min(EWFUSED_BLOCK_COLS, rowEnd - r0);
+                // the arguments are converted when a block first reads them,
+                // such that the ones of skipped operations are not
+                std::fill(isLoaded.begin(), isLoaded.end(), false);
+                auto values = [&](const EwFusedOperand & o) -> EwFusedValues<VT> {
+                    switch(o.kind) {
+                        case EwFusedOperand::Kind::CONST:
+                            return {nullptr, static_cast<VT>(o.value)};
+                        case EwFusedOperand::Kind::REG:
+                            return {regs.data() + o.idx * EWFUSED_BLOCK_COLS, 0};
+                        default: {
+                            const size_t i = o.idx;
+                            if(args[i]->getNumRows() == 1)
+                                return {nullptr, broadcast[i]};
+                            if(!loads[i])
+                                return {static_cast<const VT *>(cols[i]) + r0, 0};
+                            VT * buf = loaded.data() + i * EWFUSED_BLOCK_COLS;
+                            if(!isLoaded[i]) {
+                                loads[i](buf, cols[i], r0, n);
+                                isLoaded[i] = true;
+                            }
+                            return {buf, 0};
+                        }
+                    }
+                };
+                // the last operation writes the result directly if it is
+                // contiguous
+                VT * out = rowSkipRes == 1 ? valuesRes + r0 : last;
+                ewFusedEvalBlock<VT>(prog, values, [&](size_t k) {
+                    return k + 1 == numInstrs ? out : regs.data() + k * EWFUSED_BLOCK_COLS;
+                }, n);
+                if(out == last)
+                    for(size_t i = 0; i < n; i++)
+                        valuesRes[(r0 + i) * rowSkipRes] = last[i];
+            }
+        });
+    }
+};
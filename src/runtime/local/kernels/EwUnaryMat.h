@@ -22,9 +22,14 @@
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/UnaryOpCode.h>
 #include <runtime/local/kernels/EwUnarySca.h>
+#include <runtime/local/kernels/FastMath.h>
+#include <runtime/local/kernels/ReuseArg.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
 
 #include <cassert>
 #include <cstddef>
+#include <stdexcept>
+#include <type_traits>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -58,20 +63,79 @@ struct EwUnaryMat<DenseMatrix<VT>, DenseMatrix<VT>> {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
         
-        if(res == nullptr)
+        // An argument at its last use is overwritten with the result, see ReuseArg.h.
+        if(res == nullptr && !reuseArgAsRes(res, arg, numRows, numCols))
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
-        
+
+        // The approximations of FastMath are only used if the user opted in.
+        const bool fastMath = ctx && ctx->config.fast_math;
+
+        // The op code is interpreted once, such that the loops of each operation can be inlined and vectorized.
+        switch(opCode) {
+#define MAKE_CASE(opCode) case opCode: applyOp<EwUnarySca<opCode, VT, VT>>(res, arg, ctx); break;
+            // Arithmetic/general math.
+            MAKE_CASE(UnaryOpCode::SIGN)
+            MAKE_CASE(UnaryOpCode::SQRT)
+            case UnaryOpCode::EXP: applyMaybeFast<UnaryOpCode::EXP, FastExp>(fastMath, res, arg, ctx); break;
+            case UnaryOpCode::LN: applyMaybeFast<UnaryOpCode::LN, FastLn>(fastMath, res, arg, ctx); break;
+            // Rounding.
+            MAKE_CASE(UnaryOpCode::ABS)
+            MAKE_CASE(UnaryOpCode::FLOOR)
+            MAKE_CASE(UnaryOpCode::CEIL)
+            MAKE_CASE(UnaryOpCode::ROUND)
+#undef MAKE_CASE
+            default:
+                throw std::runtime_error("unknown UnaryOpCode");
+        }
+    }
+
+private:
+    struct FastExp {
+        static VT apply(VT arg, DCTX(ctx)) { return static_cast<VT>(FastMath::exp(arg)); }
+    };
+    struct FastLn {
+        static VT apply(VT arg, DCTX(ctx)) { return static_cast<VT>(FastMath::log(arg)); }
+    };
+
+    template<UnaryOpCode opCode, class FastOp>
+    static void applyMaybeFast(bool fastMath, DenseMatrix<VT> * res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        if constexpr(std::is_floating_point<VT>::value) {
+            if(fastMath) {
+                applyOp<FastOp>(res, arg, ctx);
+                return;
+            }
+        }
+        applyOp<EwUnarySca<opCode, VT, VT>>(res, arg, ctx);
+    }
+
+    template<class Op>
+    static void applyOp(DenseMatrix<VT> * res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const size_t rowSkipArg = arg->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+
         const VT * valuesArg = arg->getValues();
         VT * valuesRes = res->getValues();
-        
-        EwUnaryScaFuncPtr<VT, VT> func = getEwUnaryScaFuncPtr<VT, VT>(opCode);
-        
-        for(size_t r = 0; r < numRows; r++) {
-            for(size_t c = 0; c < numCols; c++)
-                valuesRes[c] = func(valuesArg[c], ctx);
-            valuesArg += arg->getRowSkip();
-            valuesRes += res->getRowSkip();
-        }
+
+        // the loops are vectorized for the instruction set of the CPU, see CpuDispatch.h
+        CpuDispatch::run("ewUnaryMat", [&](auto) {
+            if(rowSkipArg == numCols && rowSkipRes == numCols) {
+                // contiguous values, processed as a single row
+                const size_t numCells = numRows * numCols;
+                #pragma omp simd
+                for(size_t i = 0; i < numCells; i++)
+                    valuesRes[i] = Op::apply(valuesArg[i], ctx);
+                return;
+            }
+            for(size_t r = 0; r < numRows; r++) {
+                #pragma omp simd
+                for(size_t c = 0; c < numCols; c++)
+                    valuesRes[c] = Op::apply(valuesArg[c], ctx);
+                valuesArg += rowSkipArg;
+                valuesRes += rowSkipRes;
+            }
+        });
     }
 };
 
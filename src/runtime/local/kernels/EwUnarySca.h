@@ -63,6 +63,7 @@ EwUnaryScaFuncPtr<VTRes, VTArg> getEwUnaryScaFuncPtr(UnaryOpCode opCode) {
         MAKE_CASE(UnaryOpCode::SIGN)
         MAKE_CASE(UnaryOpCode::SQRT)
         MAKE_CASE(UnaryOpCode::EXP)
+        MAKE_CASE(UnaryOpCode::LN)
         // Rounding.
         MAKE_CASE(UnaryOpCode::ABS)
         MAKE_CASE(UnaryOpCode::FLOOR)
@@ -107,6 +108,7 @@ TRes ewUnarySca(UnaryOpCode opCode, TArg arg, DCTX(ctx)) {
 MAKE_EW_UNARY_SCA(UnaryOpCode::SIGN, (arg == 0) ? 0 : ((arg < 0) ? -1 : ((arg > 0) ? 1 : std::numeric_limits<TRes>::quiet_NaN())));
 MAKE_EW_UNARY_SCA(UnaryOpCode::SQRT, sqrt(arg));
 MAKE_EW_UNARY_SCA(UnaryOpCode::EXP, exp(arg));
+MAKE_EW_UNARY_SCA(UnaryOpCode::LN, std::log(arg));
 // Rounding.
 MAKE_EW_UNARY_SCA(UnaryOpCode::ABS, abs(arg));
 MAKE_EW_UNARY_SCA(UnaryOpCode::FLOOR, floor(arg));
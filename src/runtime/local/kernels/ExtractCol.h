@@ -19,8 +19,11 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <cassert>
@@ -88,6 +91,42 @@ struct ExtractCol<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<int64_t>> {
     }
 };
 
+// ----------------------------------------------------------------------------
+// DenseMatrixCM <- DenseMatrixCM, DenseMatrix (positions)
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct ExtractCol<DenseMatrixCM<VT>, DenseMatrixCM<VT>, DenseMatrix<int64_t>> {
+    static void apply(DenseMatrixCM<VT> *& res, const DenseMatrixCM<VT> * arg, const DenseMatrix<int64_t> * sel, DCTX(ctx)) {
+        assert((sel->getNumCols() == 1) && "parameter colIdxs must be a column matrix");
+
+        const size_t numColsRes = sel->getNumRows();
+        const auto* colIdxs = reinterpret_cast<const size_t *>(sel->getValues());
+        for(size_t i = 0; i < numColsRes; i++) {
+            assert((colIdxs[i] < arg->getNumCols()) && "column index out of bounds");
+        }
+
+        // A range of adjacent columns is extracted as a view on them.
+        bool isRange = numColsRes > 0;
+        for(size_t i = 1; isRange && i < numColsRes; i++)
+            isRange = colIdxs[i] == colIdxs[0] + i;
+        if(res == nullptr && isRange) {
+            res = arg->sliceCol(colIdxs[0], colIdxs[0] + numColsRes);
+            return;
+        }
+
+        const size_t numRows = arg->getNumRows();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numColsRes, false);
+
+        WorkerPool::parallelFor(ctx, numColsRes, [&](size_t c) {
+            const VT * col = arg->getColumn(colIdxs[c]);
+            std::copy(col, col + numRows, res->getColumn(c));
+        });
+    }
+};
+
 // ----------------------------------------------------------------------------
 // Frame <- Frame, String (column label)
 // ----------------------------------------------------------------------------
@@ -24,7 +24,10 @@
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <cstddef>
 #include <cstdint>
@@ -84,20 +87,35 @@ struct ExtractRow<Frame, Frame, VTSel> {
         const VTSel * valuesSel = sel->getValues();
         
 #if EXTRACTROW_FRAME_MODE == 0
+        // String columns are copied string by string, all other columns as
+        // bytes (see below).
+        std::vector<size_t> fixedCols;
+        for(size_t c = 0; c < numCols; c++) {
+            if(schema[c] != ValueTypeCode::STR) {
+                fixedCols.push_back(c);
+                continue;
+            }
+            const std::string * argCol = static_cast<const std::string *>(arg->getColumnRaw(c));
+            std::string * resCol = static_cast<std::string *>(res->getColumnRaw(c));
+            for(size_t r = 0; r < numRowsSel; r++)
+                resCol[r] = argCol[static_cast<size_t>(valuesSel[r])];
+        }
+        const size_t numFixedCols = fixedCols.size();
         // Some information on each column.
-        const auto elementSizes = std::make_unique<size_t[]>(numCols);
-        const auto argCols = std::make_unique<const uint8_t*[]>(numCols);
-        auto resCols = std::make_unique<uint8_t*[]>(numCols);
+        const auto elementSizes = std::make_unique<size_t[]>(numFixedCols);
+        const auto argCols = std::make_unique<const uint8_t*[]>(numFixedCols);
+        auto resCols = std::make_unique<uint8_t*[]>(numFixedCols);
         // Initialize information on each column.
-        for(size_t c = 0; c < numCols; c++) {
-            elementSizes[c] = ValueTypeUtils::sizeOf(schema[c]);
-            argCols[c] = reinterpret_cast<const uint8_t *>(arg->getColumnRaw(c));
-            resCols[c] = reinterpret_cast<uint8_t *>(res->getColumnRaw(c));
+        for(size_t i = 0; i < numFixedCols; i++) {
+            const size_t c = fixedCols[i];
+            elementSizes[i] = ValueTypeUtils::sizeOf(schema[c]);
+            argCols[i] = reinterpret_cast<const uint8_t *>(arg->getColumnRaw(c));
+            resCols[i] = reinterpret_cast<uint8_t *>(res->getColumnRaw(c));
         }
         // Actual filtering.
         for(size_t r = 0; r < numRowsSel; r++) {
             const size_t pos = valuesSel[r];
-            for(size_t c = 0; c < numCols; c++) {
+            for(size_t c = 0; c < numFixedCols; c++) {
                 // We always copy in units of 8 bytes (uint64_t). If the
                 // actual element size is lower, the superfluous bytes will
                 // be overwritten by the next match. With this approach, we
@@ -18,14 +18,16 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_MATMUL_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/AllocationDescriptorFPGA.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 
 #include <cblas.h>
-#include <math.h>
 
-#include <cassert>
+#include <algorithm>
 #include <cstddef>
+#include <stdexcept>
+#include <vector>
 #include "gemm_interface.h"
 
 namespace FPGAOPENCL {
@@ -59,94 +61,72 @@ void matMul(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, bool transa, boo
 template<>
 struct MatMul<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
     static void apply(DenseMatrix<float> *& res, const DenseMatrix<float> * lhs, const DenseMatrix<float> * rhs, bool transa, bool transb,DCTX(ctx)) {
+        using namespace sgemm_params;
         const size_t nr1 = lhs->getNumRows();
         const size_t nc1 = lhs->getNumCols();
-        const size_t nc2 = rhs->getNumCols();
-#ifndef NDEBUG
         const size_t nr2 = rhs->getNumRows();
-        assert((nc1 == nr2) && "#cols of lhs and #rows of rhs must be the same");        
-#endif
-//	printf("\ntest MatMul f32 \n");
-// Parameters of the systolic array in the bitstream. Do not change.
-
-#define II   32
-#define JJ   32
-#define KK   32
-#define III  14
-#define JJJ  16
-#define KKK  16
+        const size_t nc2 = rhs->getNumCols();
+        if(nc1 != nr2)
+            throw std::runtime_error("FPGAOPENCL::MatMul: #cols of lhs and #rows of rhs must be the same");
+        if(transa || transb)
+            throw std::runtime_error("FPGAOPENCL::MatMul: transposed operands are not supported");
+        if(nr1 % TILE_I || nc1 % TILE_K || nc1 < 2 * TILE_K || nc2 % TILE_J)
+            throw std::runtime_error("FPGAOPENCL::MatMul: #rows of lhs must be a multiple of 448, #cols of lhs a "
+                    "multiple of 512 (and minimum 1024), and #cols of rhs a multiple of 512");
+
+        const int OUTERMOST_I = nr1 / TILE_I;
+        const int OUTERMOST_J = nc2 / TILE_J;
+        const int OUTERMOST_K = nc1 / TILE_K;
+
+        auto fctx = ctx->getFPGAContext(0);
+        AllocationDescriptorFPGA alloc_desc(ctx, 0);
+
+        // The systolic array reads rhs column by column, so it is transposed
+        // on the host and written to a buffer without blocking, overlapping
+        // the transfer (or the computation) of lhs.
+        std::vector<float> serializedB(nr2 * nc2);
+        const float * valuesRhs = rhs->getValues();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        for(size_t j = 0; j < nc2; j++)
+            for(size_t k = 0; k < nr2; k++)
+                serializedB[j * nr2 + k] = valuesRhs[k * rowSkipRhs + j];
+        AllocationDescriptorFPGA alloc_desc_B(ctx, 0);
+        alloc_desc_B.createAllocation(serializedB.size() * sizeof(float), false);
+        cl_mem B = AllocationDescriptorFPGA::buffer(alloc_desc_B.getData().get());
+        cl_event bWritten;
+        cl_int status = clEnqueueWriteBuffer(fctx->getTransferQueue(1), B, CL_FALSE, 0,
+                serializedB.size() * sizeof(float), serializedB.data(), 0, NULL, &bWritten);
+        if(status != CL_SUCCESS)
+            throw std::runtime_error("FPGAOPENCL::MatMul: transfer to the FPGA failed");
+        fctx->setPending(B, bWritten);
+
+        // lhs is row-major as the array reads it; it stays in FPGA memory
+        // (and may already be there, e.g., as the result of another MatMul).
+        DenseMatrix<float> * lhsCopy = nullptr;
+        if(lhs->getRowSkip() != nc1) {
+            lhsCopy = DataObjectFactory::create<DenseMatrix<float>>(nr1, nc1, false);
+            for(size_t r = 0; r < nr1; r++)
+                std::copy(lhs->getValues() + r * lhs->getRowSkip(), lhs->getValues() + r * lhs->getRowSkip() + nc1,
+                        lhsCopy->getValues() + r * nc1);
+            lhs = lhsCopy;
+        }
+        cl_mem A = AllocationDescriptorFPGA::buffer(lhs->getValues(&alloc_desc));
+
+        // The result stays in FPGA memory until it is read on the host, which
+        // waits for the kernels.
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<float>>(nr1, nc2, false, &alloc_desc);
+        cl_mem C = AllocationDescriptorFPGA::buffer(res->getValues(&alloc_desc));
 
-#ifndef NDEBUG
-	assert((nr1%(II*III)==0) && "lhs #rows number must be a multiple of 448");        
-	assert((nc1%(JJ*JJJ)==0 && nc1>512 && nr2%(JJ*JJJ)==0 && nc1>512) && "#cols of lhs and #rows of rhs must be a multiple of 512 (and minimum 1024)");        
-	assert((nc2%(KK*KKK)==0) && "#cols of rhs must be a multiple of 512");        
-#endif       
-// Testing purpose only: help define the sizes of test inputs
-// Can be arbitrarily set.
-// matrix a: 10K * 2K
-// matrix b: 2K * 8K
-
-//#define OUTERMOST_I 1//32
-//#define OUTERMOST_J 1//32
-//#define OUTERMOST_K 2//4
-
-//#define TYPE float
-
-#define ACL_ALIGNMENT 64
-//void *acl_aligned_malloc(size_t size) {
-//    void *result = NULL;
-//    posix_memalign(&result, ACL_ALIGNMENT, size);
-//    return result;
-//}
-    const int OUTERMOST_I = ceil(nr1/448);
-    const int OUTERMOST_J = ceil(nc2/512);
-    const int OUTERMOST_K = ceil(nc1/512);
-
-    float *A, *B, *C;
-    void *aa=NULL,*bb=NULL,*cc=NULL;
-    const int TOTAL_I = III * II * OUTERMOST_I;
-    const int TOTAL_J = JJJ * JJ * OUTERMOST_J;
-    const int TOTAL_K = KKK * KK * OUTERMOST_K;
-    
-    long int num_elem_A = (long int)TOTAL_I*TOTAL_K;
-    long int num_elem_B = (long int)TOTAL_K*TOTAL_J;
-    long int num_elem_C = (long int)TOTAL_I*TOTAL_J;
-    
-    posix_memalign(&aa,ACL_ALIGNMENT,num_elem_A * sizeof(float));
-    A=(float*)aa;
-    if (A==NULL)
-       perror("Failed malloc of matrix A");
-    posix_memalign(&bb,ACL_ALIGNMENT,num_elem_B * sizeof(float));
-    B=(float*)bb;
-    if (B==NULL)
-       perror("Failed malloc of matrix B");
-    posix_memalign(&cc,ACL_ALIGNMENT,num_elem_C * sizeof(float));
-    C=(float*)cc;
-    if (C==NULL)
-       perror("Failed malloc of matrix C");
-
-
-    // printf("\nbefore memcpy()\n");
-   
-    memcpy(A,lhs->getValues(),num_elem_A * sizeof(float));//sizeof(lhs));
-    memcpy(B,rhs->getValues(),num_elem_B * sizeof(float));//sizeof(rhs));
-     
-    //printf("\nA values %f\n",*A);
-    //printf("\nB values %f\n",*B);
-    sgemm(A, B, C, OUTERMOST_I, OUTERMOST_J, OUTERMOST_K, ctx);
- 
-  //  printf("\nC values %f\n",*C);
- 
-    if(res == nullptr)
-       res = DataObjectFactory::create<DenseMatrix<float>>(nr1, nc2, false);
-
-
-    //printf("\nres: %p\n", res);
-    //printf("\nres->getValues(): %p\n", res->getValues());
-    memcpy(res->getValues(),C,num_elem_C * sizeof(float));//sizeof(C)
-   // printf("\nres memcpy2\n");
-
-   }
+        sgemm(A, B, C, OUTERMOST_I, OUTERMOST_J, OUTERMOST_K, bWritten, ctx);
+
+        // The host copy of B must outlive its transfer; the buffers released
+        // here live on until the kernels enqueued on them have finished.
+        fctx->waitFor(B);
+        clReleaseEvent(bWritten);
+        if(lhsCopy)
+            DataObjectFactory::destroy(lhsCopy);
+    }
 };
 /* TODO
 template<>
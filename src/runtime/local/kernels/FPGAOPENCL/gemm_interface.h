@@ -2,9 +2,33 @@
 #define SGEMM_INTERFACE
 #include <runtime/local/context/DaphneContext.h>
 
+#include <CL/opencl.h>
 
-extern int sgemm(const float *A, const float *B, float *C, const int OUTERMOST_I, const int OUTERMOST_J, const int OUTERMOST_K, DCTX(ctx));
-
-#endif
+// Parameters of the systolic array in the bitstream. Do not change.
+namespace sgemm_params {
+    constexpr int II = 32;
+    constexpr int JJ = 32;
+    constexpr int KK = 32;
+    constexpr int III = 14;
+    constexpr int JJJ = 16;
+    constexpr int KKK = 16;
+    // The sizes of a tile of the result (I x J) and of the reduction (K).
+    constexpr int TILE_I = II * III;
+    constexpr int TILE_J = JJ * JJJ;
+    constexpr int TILE_K = KK * KKK;
+}
 
+/**
+ * @brief Enqueues the kernels of the sgemm bitstream computing `C = A * B` on
+ * buffers in FPGA memory and returns without waiting for them.
+ *
+ * `A` is row-major (`OUTERMOST_I * TILE_I` x `OUTERMOST_K * TILE_K`), `B` is
+ * stored transposed, i.e., column-major (`OUTERMOST_K * TILE_K` x
+ * `OUTERMOST_J * TILE_J`), and `C` is row-major. The kernels start once the
+ * last commands on `A` (see `FPGAContext::getPending()`) and `bWritten` have
+ * finished; the unloader becomes the pending command of `C`.
+ */
+extern void sgemm(cl_mem A, cl_mem B, cl_mem C, const int OUTERMOST_I, const int OUTERMOST_J, const int OUTERMOST_K,
+        cl_event bWritten, DCTX(ctx));
 
+#endif
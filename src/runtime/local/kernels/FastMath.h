@@ -0,0 +1,133 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/**
+ * @brief Branch-free implementations of transcendental functions, which the compiler can vectorize within the loops
+ * of element-wise kernels (unlike calls to the C math library).
+ *
+ * The results are within a few ULPs of the correctly rounded ones (instead of at most one for the C math library)
+ * and special values (NaN, infinities, zeros, subnormals) are handled as by the C math library. Single precision is
+ * computed in double precision. The kernels only use these functions if the user enabled `DaphneUserConfig::fast_math`.
+ */
+namespace FastMath {
+    namespace detail {
+        inline uint64_t toBits(double x) {
+            uint64_t bits;
+            std::memcpy(&bits, &x, sizeof(x));
+            return bits;
+        }
+
+        inline double fromBits(uint64_t bits) {
+            double x;
+            std::memcpy(&x, &bits, sizeof(x));
+            return x;
+        }
+
+        // adding this constant rounds a double (|x| < 2^51) to an integer, which is held in the low mantissa bits
+        constexpr double ROUNDING_MAGIC = 6755399441055744.0; // 1.5 * 2^52
+
+        constexpr double LOG2E = 1.4426950408889634074;
+        // ln(2) split into a part with trailing zero bits (such that n * LN2_HI is exact) and the remainder
+        constexpr double LN2_HI = 6.93147180369123816490e-01;
+        constexpr double LN2_LO = 1.90821492927058770002e-10;
+
+        // 2^n for an integer n (as a double rounded by ROUNDING_MAGIC) within the range of normal numbers
+        inline double pow2(double roundedN) {
+            return fromBits((toBits(roundedN) - toBits(ROUNDING_MAGIC) + 1023) << 52);
+        }
+    }
+
+    inline double exp(double x) {
+        using namespace detail;
+        // beyond these bounds, the result over- or underflows anyway (NaN passes through)
+        const double xc = x < -746.0 ? -746.0 : (x > 710.0 ? 710.0 : x);
+        // x = n * ln(2) + r with |r| <= ln(2) / 2
+        const double t = xc * LOG2E + ROUNDING_MAGIC;
+        const double n = t - ROUNDING_MAGIC;
+        const double r = (xc - n * LN2_HI) - n * LN2_LO;
+        // e^r by its Taylor series up to r^13
+        double p = 1.0 / 6227020800.0;
+        p = p * r + 1.0 / 479001600.0;
+        p = p * r + 1.0 / 39916800.0;
+        p = p * r + 1.0 / 3628800.0;
+        p = p * r + 1.0 / 362880.0;
+        p = p * r + 1.0 / 40320.0;
+        p = p * r + 1.0 / 5040.0;
+        p = p * r + 1.0 / 720.0;
+        p = p * r + 1.0 / 120.0;
+        p = p * r + 1.0 / 24.0;
+        p = p * r + 1.0 / 6.0;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+        // 2^n as the product of two halves, such that the result may be subnormal or overflow to infinity
+        const double tHalf = n * 0.5 + ROUNDING_MAGIC;
+        const double nHalf = tHalf - ROUNDING_MAGIC;
+        const double tRest = (n - nHalf) + ROUNDING_MAGIC;
+        return p * pow2(tHalf) * pow2(tRest);
+    }
+
+    inline double log(double x) {
+        using namespace detail;
+        constexpr double SUBNORMAL_SCALE = 18014398509481984.0; // 2^54
+        // the bit pattern of sqrt(0.5), the lower bound of the reduced mantissa
+        constexpr uint64_t SQRT_HALF_BITS = 0x3fe6a09e667f3bcdULL;
+        constexpr uint64_t ONE_BITS = 0x3ff0000000000000ULL;
+        constexpr uint64_t POW2_52_BITS = 0x4330000000000000ULL;
+
+        const bool subnormal = x < std::numeric_limits<double>::min();
+        const double xs = subnormal ? x * SUBNORMAL_SCALE : x;
+        const uint64_t bits = toBits(xs);
+        // x = 2^k * z with z in [sqrt(0.5), sqrt(2)), kBiased = k + 1023
+        const uint64_t kBiased = (bits - SQRT_HALF_BITS + ONE_BITS) >> 52;
+        const double z = fromBits(bits - (kBiased << 52) + ONE_BITS);
+        const double k = (fromBits(kBiased | POW2_52_BITS) - 4503599627370496.0) - 1023.0
+                - (subnormal ? 54.0 : 0.0);
+        // log(z) = 2 * atanh(s) with s = (z - 1) / (z + 1), |s| <= 0.1716
+        const double f = z - 1.0;
+        const double s = f / (2.0 + f);
+        const double w = s * s;
+        double p = 1.0 / 21.0;
+        p = p * w + 1.0 / 19.0;
+        p = p * w + 1.0 / 17.0;
+        p = p * w + 1.0 / 15.0;
+        p = p * w + 1.0 / 13.0;
+        p = p * w + 1.0 / 11.0;
+        p = p * w + 1.0 / 9.0;
+        p = p * w + 1.0 / 7.0;
+        p = p * w + 1.0 / 5.0;
+        p = p * w + 1.0 / 3.0;
+        // log(z) = 2s + 2s * w * p, separating the leading term for accuracy
+        const double res = k * LN2_HI + (2.0 * s + (2.0 * s * w * p + k * LN2_LO));
+        constexpr double inf = std::numeric_limits<double>::infinity();
+        return (x > 0.0 && x < inf) ? res
+                : (x == 0.0 ? -inf : (x == inf ? inf : std::numeric_limits<double>::quiet_NaN()));
+    }
+
+    inline double sigmoid(double x) {
+        return 1.0 / (1.0 + exp(-x));
+    }
+
+    inline float exp(float x) { return static_cast<float>(exp(static_cast<double>(x))); }
+    inline float log(float x) { return static_cast<float>(log(static_cast<double>(x))); }
+    inline float sigmoid(float x) { return static_cast<float>(sigmoid(static_cast<double>(x))); }
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_FILTERGROUP_H
+#define SRC_RUNTIME_LOCAL_KERNELS_FILTERGROUP_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/FilterRow.h>
+#include <runtime/local/kernels/Group.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <ir/daphneir/Daphne.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DT, typename VTSel>
+struct FilterGroup {
+    static void apply(DT *& res, const DT * arg, const DenseMatrix<VTSel> * sel, const char ** keyCols,
+            size_t numKeyCols, const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs,
+            size_t numAggFuncs, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Groups the rows of a frame selected by a bit vector, i.e., computes
+ * `group(filterRow(arg, sel), ...)` without materializing the filtered frame
+ * where possible.
+ */
+template<class DT, typename VTSel>
+void filterGroup(DT *& res, const DT * arg, const DenseMatrix<VTSel> * sel, const char ** keyCols,
+        size_t numKeyCols, const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs,
+        size_t numAggFuncs, DCTX(ctx)) {
+    FilterGroup<DT, VTSel>::apply(res, arg, sel, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggFuncs, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// Frame <- Frame
+// ----------------------------------------------------------------------------
+
+template<typename VTSel>
+struct FilterGroup<Frame, VTSel> {
+    static void apply(Frame *& res, const Frame * arg, const DenseMatrix<VTSel> * sel, const char ** keyCols,
+            size_t numKeyCols, const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs,
+            size_t numAggFuncs, DCTX(ctx)) {
+        if(arg == nullptr || sel == nullptr)
+            throw std::runtime_error("filterGroup-kernel called with invalid arguments");
+        const size_t numRows = arg->getNumRows();
+        if(sel->getNumRows() != numRows)
+            throw std::runtime_error("number of rows in arg and sel must be the same");
+        if(sel->getNumCols() != 1)
+            throw std::runtime_error("sel must be a single-column matrix");
+
+        // The selection as a byte per row, converted and counted in chunks in
+        // parallel.
+        const VTSel * valuesSel = sel->getValues();
+        const size_t rowSkipSel = sel->getRowSkip();
+        std::vector<uint8_t> selected(numRows);
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / FILTERROW_CHUNK_ROWS));
+        std::vector<size_t> counts(numChunks, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            size_t n = 0;
+            for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++) {
+                selected[r] = valuesSel[r * rowSkipSel] != VTSel(0);
+                n += selected[r];
+            }
+            counts[chunk] = n;
+        });
+        size_t numSelected = 0;
+        for(size_t n : counts)
+            numSelected += n;
+
+        if(Group<Frame>::groupSelected(res, arg, selected.data(), numSelected, keyCols, numKeyCols, aggCols,
+                numAggCols, aggFuncs, ctx))
+            return;
+
+        // In the general case, the selected rows are grouped after all.
+        Frame * filtered = nullptr;
+        filterRow(filtered, arg, sel, ctx);
+        group(res, filtered, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggFuncs, ctx);
+        DataObjectFactory::destroy(filtered);
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_FILTERGROUP_H
\ No newline at end of file
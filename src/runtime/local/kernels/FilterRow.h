@@ -18,13 +18,20 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_FILTERROW_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/kernels/BitMask.h>
+#include <runtime/local/kernels/ZoneMaps.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <cstddef>
 #include <cstdint>
@@ -47,6 +54,57 @@ void filterRow(DTRes *& res, const DTArg * arg, const DenseMatrix<VTSel> * sel,
     FilterRow<DTRes, DTArg, VTSel>::apply(res, arg, sel, ctx);
 }
 
+// ****************************************************************************
+// Functions called by multiple template specializations
+// ****************************************************************************
+
+// The rows of the chunks of the selection and of the result handled by one
+// task.
+constexpr size_t FILTERROW_CHUNK_ROWS = 1 << 16;
+
+/**
+ * @brief Writes the positions of the non-zero values of the selection to
+ * `positions`, in ascending order, and returns their number.
+ *
+ * The positions are compacted without branches: each position is stored and
+ * the end of the list is advanced only if the position is selected. The
+ * selection is split into chunks, whose positions are counted and then
+ * written to their offsets in parallel.
+ */
+template<typename VTSel>
+size_t filterRowPositions(size_t * positions, const VTSel * valuesSel, size_t numRows, DCTX(ctx)) {
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / FILTERROW_CHUNK_ROWS));
+    std::vector<size_t> offsets(numChunks + 1, 0);
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+        size_t n = 0;
+        for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++)
+            n += valuesSel[r] != VTSel(0);
+        offsets[chunk + 1] = n;
+    });
+    for(size_t chunk = 0; chunk < numChunks; chunk++)
+        offsets[chunk + 1] += offsets[chunk];
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+        size_t * out = positions + offsets[chunk];
+        const size_t count = offsets[chunk + 1] - offsets[chunk];
+        // Stop after the last selected row, such that no position is stored
+        // beyond the chunk's part of the list.
+        for(size_t r = numRows * chunk / numChunks, n = 0; n < count; r++) {
+            out[n] = r;
+            n += valuesSel[r] != VTSel(0);
+        }
+    });
+    return offsets[numChunks];
+}
+
+// Copies the values at the given positions of arg to res.
+template<typename VT>
+void filterRowGather(void * res, const void * arg, const size_t * positions, size_t begin, size_t end) {
+    VT * resVals = static_cast<VT *>(res);
+    const VT * argVals = static_cast<const VT *>(arg);
+    for(size_t i = begin; i < end; i++)
+        resVals[i] = argVals[positions[i]];
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -56,7 +114,72 @@ void filterRow(DTRes *& res, const DTArg * arg, const DenseMatrix<VTSel> * sel,
 // ----------------------------------------------------------------------------
 
 // 0 (row-wise) or 1 (column-wise)
-#define FILTERROW_FRAME_MODE 0
+#define FILTERROW_FRAME_MODE 1
+
+// Filters a dictionary-encoded column on its codes by `filter(dictCol)`, the
+// result shares the dictionary.
+template<typename VT, class Filter>
+bool filterDictionaryColumn(Frame * res, const Frame * arg, size_t c, Filter filter) {
+    if(auto dictCol = arg->getDictionaryColumn<VT>(c)) {
+        res->setEncodedColumn(c, filter(*dictCol));
+        return true;
+    }
+    return false;
+}
+
+// Filters a dictionary-encoded column of any value type, see above.
+template<class Filter>
+bool filterDictionaryColumn(Frame * res, const Frame * arg, size_t c, Filter filter) {
+    return filterDictionaryColumn<int8_t>  (res, arg, c, filter)
+        || filterDictionaryColumn<int32_t> (res, arg, c, filter)
+        || filterDictionaryColumn<int64_t> (res, arg, c, filter)
+        || filterDictionaryColumn<uint8_t> (res, arg, c, filter)
+        || filterDictionaryColumn<uint32_t>(res, arg, c, filter)
+        || filterDictionaryColumn<uint64_t>(res, arg, c, filter)
+        || filterDictionaryColumn<float>   (res, arg, c, filter)
+        || filterDictionaryColumn<double>  (res, arg, c, filter)
+        || filterDictionaryColumn<std::string>(res, arg, c, filter);
+}
+
+// Gathers the given (not dictionary-encoded) columns of arg from the
+// positions of the selected rows, in chunks of the result rows in parallel,
+// and keeps the sortedness of the columns.
+inline void filterRowGatherColumns(Frame * res, const Frame * arg, const std::vector<size_t> & denseCols,
+        const size_t * positions, size_t numRowsRes, DCTX(ctx)) {
+    const ValueTypeCode * schema = arg->getSchema();
+    const size_t numDenseCols = denseCols.size();
+    std::vector<const void *> argCols(numDenseCols);
+    std::vector<void *> resCols(numDenseCols);
+    for(size_t i = 0; i < numDenseCols; i++) {
+        argCols[i] = arg->getColumnRaw(denseCols[i]);
+        resCols[i] = res->getColumnRaw(denseCols[i]);
+    }
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRowsRes / FILTERROW_CHUNK_ROWS));
+    WorkerPool::parallelFor(ctx, numDenseCols * numChunks, [&](size_t task) {
+        const size_t i = task / numChunks;
+        const size_t c = denseCols[i];
+        const size_t chunk = task % numChunks;
+        const size_t begin = numRowsRes * chunk / numChunks;
+        const size_t end = numRowsRes * (chunk + 1) / numChunks;
+        const void * argCol = argCols[i];
+        void * resCol = resCols[i];
+        if(schema[c] == ValueTypeCode::STR) {
+            filterRowGather<std::string>(resCol, argCol, positions, begin, end);
+            return;
+        }
+        switch(ValueTypeUtils::sizeOf(schema[c])) {
+            case 1: filterRowGather<uint8_t> (resCol, argCol, positions, begin, end); break;
+            case 2: filterRowGather<uint16_t>(resCol, argCol, positions, begin, end); break;
+            case 4: filterRowGather<uint32_t>(resCol, argCol, positions, begin, end); break;
+            case 8: filterRowGather<uint64_t>(resCol, argCol, positions, begin, end); break;
+            default:
+                throw std::runtime_error("filterRow: unsupported value type");
+        }
+    });
+    // The selected rows of a sorted column are sorted.
+    for(size_t c : denseCols)
+        ZoneMaps::keepSorted(res, c, arg, c);
+}
 
 template<typename VTSel>
 struct FilterRow<Frame, Frame, VTSel> {
@@ -85,20 +208,59 @@ struct FilterRow<Frame, Frame, VTSel> {
         const VTSel * valuesSel = sel->getValues();
         
 #if FILTERROW_FRAME_MODE == 0
+        size_t numRowsRes = 0;
+        for(size_t r = 0; r < numRows; r++)
+            numRowsRes += valuesSel[r] != VTSel(0);
+#elif FILTERROW_FRAME_MODE == 1
+        // The selected rows as a list of their positions, which all columns
+        // are gathered from.
+        std::vector<size_t> positions(numRows);
+        const size_t numRowsRes = filterRowPositions(positions.data(), valuesSel, numRows, ctx);
+#endif
+        // The column arrays keep their allocated size (including the padding).
+        res->shrinkNumRows(numRowsRes);
+        
+        // Dictionary-encoded columns are filtered on their codes, all other
+        // columns (including columns in other encodings) as dense arrays.
+        std::vector<size_t> denseCols;
+        for(size_t c = 0; c < numCols; c++) {
+            bool found = false;
+            if(arg->getColumnEncoding(c) == ColumnEncoding::DICTIONARY)
+                found = filterDictionaryColumn(res, arg, c, [&](const auto & dictCol) {
+                    return dictCol.filter(valuesSel, numRows);
+                });
+#if FILTERROW_FRAME_MODE == 0
+            // String columns are copied string by string.
+            if(!found && schema[c] == ValueTypeCode::STR) {
+                const std::string * argCol = static_cast<const std::string *>(arg->getColumnRaw(c));
+                std::string * resCol = static_cast<std::string *>(res->getColumnRaw(c));
+                for(size_t r = 0, pos = 0; r < numRows; r++)
+                    if(valuesSel[r])
+                        resCol[pos++] = argCol[r];
+                found = true;
+            }
+#endif
+            if(!found)
+                denseCols.push_back(c);
+        }
+        
+#if FILTERROW_FRAME_MODE == 0
+        const size_t numDenseCols = denseCols.size();
         // Some information on each column.
-        size_t * const elementSizes = new size_t[numCols];
-        const uint8_t ** argCols = new const uint8_t *[numCols];
-        uint8_t ** resCols = new uint8_t *[numCols];
+        size_t * const elementSizes = new size_t[numDenseCols];
+        const uint8_t ** argCols = new const uint8_t *[numDenseCols];
+        uint8_t ** resCols = new uint8_t *[numDenseCols];
         // Initialize information on each column.
-        for(size_t c = 0; c < numCols; c++) {
-            elementSizes[c] = ValueTypeUtils::sizeOf(schema[c]);
-            argCols[c] = reinterpret_cast<const uint8_t *>(arg->getColumnRaw(c));
-            resCols[c] = reinterpret_cast<uint8_t *>(res->getColumnRaw(c));
+        for(size_t i = 0; i < numDenseCols; i++) {
+            const size_t c = denseCols[i];
+            elementSizes[i] = ValueTypeUtils::sizeOf(schema[c]);
+            argCols[i] = reinterpret_cast<const uint8_t *>(arg->getColumnRaw(c));
+            resCols[i] = reinterpret_cast<uint8_t *>(res->getColumnRaw(c));
         }
         // Actual filtering.
         for(size_t r = 0; r < numRows; r++) {
             if(valuesSel[r]) {
-                for(size_t c = 0; c < numCols; c++) {
+                for(size_t c = 0; c < numDenseCols; c++) {
                     // We always copy in units of 8 bytes (uint64_t). If the
                     // actual element size is lower, the superfluous bytes will
                     // be overwritten by the next match. With this approach, we
@@ -109,22 +271,73 @@ struct FilterRow<Frame, Frame, VTSel> {
                     resCols[c] += elementSizes[c];
                 }
             }
-            for(size_t c = 0; c < numCols; c++)
+            for(size_t c = 0; c < numDenseCols; c++)
                 argCols[c] += elementSizes[c];
         }
-        auto resColsInit0 = reinterpret_cast<uint8_t *>(res->getColumnRaw(0));
-        const size_t numRowsRes = (resCols[0] - resColsInit0) / elementSizes[0];
-        res->shrinkNumRows(numRowsRes);
         // Free information on each column.
         delete[] elementSizes;
         delete[] argCols;
         delete[] resCols;
 #elif FILTERROW_FRAME_MODE == 1
-        // TODO Implement a columnar approach.
+        // Each column (including string columns) is gathered from the
+        // positions.
+        filterRowGatherColumns(res, arg, denseCols, positions.data(), numRowsRes, ctx);
 #endif
     }
 };
 
 #undef FILTERROW_FRAME_MODE
 
+// ----------------------------------------------------------------------------
+// Frame <- Frame, BitMatrix
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Filters the rows of `arg` by a mask of one bit per row (e.g., of a
+ * comparison, see `BitMatrix`).
+ *
+ * The selected positions are found by popcount and by skipping from one set
+ * bit to the next (see `BitMask::positions()`) rather than by testing each row.
+ */
+template<class DTRes, class DTArg>
+struct FilterRowBits {
+    static void apply(DTRes *& res, const DTArg * arg, const BitMatrix * sel, DCTX(ctx)) = delete;
+};
+
+template<class DTRes, class DTArg>
+void filterRow(DTRes *& res, const DTArg * arg, const BitMatrix * sel, DCTX(ctx)) {
+    FilterRowBits<DTRes, DTArg>::apply(res, arg, sel, ctx);
+}
+
+template<>
+struct FilterRowBits<Frame, Frame> {
+    static void apply(Frame *& res, const Frame * arg, const BitMatrix * sel, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+
+        if(sel->getNumRows() != numRows)
+            throw std::runtime_error("number of rows in arg and sel must be the same");
+        if(sel->getNumCols() != 1)
+            throw std::runtime_error("sel must be a single-column matrix");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<Frame>(numRows, numCols, arg->getSchema(), arg->getLabels(), false);
+
+        std::vector<size_t> positions(numRows);
+        const size_t numRowsRes = BitMask::positions(positions.data(), sel, ctx);
+        res->shrinkNumRows(numRowsRes);
+
+        std::vector<size_t> denseCols;
+        for(size_t c = 0; c < numCols; c++) {
+            const bool found = arg->getColumnEncoding(c) == ColumnEncoding::DICTIONARY
+                    && filterDictionaryColumn(res, arg, c, [&](const auto & dictCol) {
+                        return dictCol.gather(positions.data(), numRowsRes);
+                    });
+            if(!found)
+                denseCols.push_back(c);
+        }
+        filterRowGatherColumns(res, arg, denseCols, positions.data(), numRowsRes, ctx);
+    }
+};
+
 #endif //SRC_RUNTIME_LOCAL_KERNELS_FILTERROW_H
\ No newline at end of file
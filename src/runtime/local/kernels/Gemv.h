@@ -18,8 +18,11 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_GEMV_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/MatMul.h>
+#include <runtime/local/vectorized/BlasThreads.h>
 
 #include <cblas.h>
 
@@ -58,6 +61,7 @@ struct Gemv<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>> {
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<double>>(numCols, 1, false);
 
+        BlasThreads::prepare(ctx);
         cblas_dgemv(CblasRowMajor,
             CblasTrans,
             numRows,
@@ -83,6 +87,7 @@ struct Gemv<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<float>>(numCols, 1, false);
 
+        BlasThreads::prepare(ctx);
         cblas_sgemv(CblasRowMajor,
             CblasTrans,
             numRows,
@@ -99,4 +104,18 @@ struct Gemv<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
     }
 };
 
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CSRMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct Gemv<DenseMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const CSRMatrix<VT> * mat, const DenseMatrix<VT> * vec, DCTX(ctx)) {
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(mat->getNumCols(), 1, false);
+
+        MatMulSparse::spmmMaybeT(res, mat, vec, true, ctx);
+    }
+};
+
 #endif //SRC_RUNTIME_LOCAL_KERNELS_GEMV_H
\ No newline at end of file
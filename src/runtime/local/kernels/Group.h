@@ -25,12 +25,21 @@
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 #include <runtime/local/kernels/Order.h>
 #include <runtime/local/kernels/ExtractCol.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/ColumnHash.h>
 #include <util/DeduceType.h>
+#include <util/FlatHashMap.h>
+#include <util/HyperLogLog.h>
 #include <ir/daphneir/Daphne.h>
 
+#include <algorithm>
 #include <iterator>
+#include <limits>
+#include <numeric>
 #include <vector>
 
+#include <cstdint>
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
@@ -51,6 +60,17 @@ void group(DT *& res, const DT * arg, const char ** keyCols, size_t numKeyCols,
     Group<DT>::apply(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggFuncs, ctx);
 }
 
+/**
+ * @brief Groups the rows of a frame which the compiler knows to be sorted by
+ * the key columns (see `ATTR_SORTED_KEYS`), streaming over the runs of equal
+ * keys instead of hashing or ordering the rows.
+ */
+template<class DT>
+void sortedGroup(DT *& res, const DT * arg, const char ** keyCols, size_t numKeyCols,
+        const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs, size_t numAggFuncs, DCTX(ctx)) {
+    Group<DT>::groupRows(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggFuncs, true, ctx);
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -104,7 +124,7 @@ struct ColumnGroupAgg {
     }
 };
 
-std::string myStringifyGroupEnum(mlir::daphne::GroupEnum val) {
+inline std::string myStringifyGroupEnum(mlir::daphne::GroupEnum val) {
     using mlir::daphne::GroupEnum;
     switch (val) {
         case GroupEnum::COUNT: return "COUNT";
@@ -116,9 +136,551 @@ std::string myStringifyGroupEnum(mlir::daphne::GroupEnum val) {
     return "";
 }
 
+// The maximum number of combinations of the codes of dictionary-encoded key
+// columns, up to which the groups are aggregated on the codes instead of
+// ordering the frame.
+constexpr size_t GROUP_MAX_NUM_CODES = 1 << 20;
+
+// The group of the rows which are not grouped, since they are not selected
+// (see `Group<Frame>::groupSelected`).
+constexpr size_t GROUP_NONE = std::numeric_limits<size_t>::max();
+
+// Writes the key of each group (whose combined code has the key's code at
+// the position given by stride) to the resColIdx-th column of res.
+template<typename VT>
+struct DictionaryGroupKey {
+    static void apply(Frame * res, const Frame * arg, size_t argColIdx, size_t resColIdx,
+            const std::vector<size_t> & groupCodes, size_t stride) {
+        const std::vector<VT> & dictionary = *arg->getDictionaryColumn<VT>(argColIdx)->getDictionary();
+        VT * valuesRes = static_cast<VT *>(res->getColumnRaw(resColIdx));
+        for(size_t g = 0; g < groupCodes.size(); g++)
+            valuesRes[g] = dictionary[(groupCodes[g] / stride) % dictionary.size()];
+    }
+};
+
+// Aggregates the argColIdx-th column of arg per group (given for each row by
+// rowGroups, skipping the rows of GROUP_NONE) into the resColIdx-th column of
+// res, in a single pass.
+template<typename VTRes, typename VTArg>
+struct DictionaryGroupAgg {
+    static void apply(Frame * res, const Frame * arg, size_t argColIdx, size_t resColIdx,
+            const std::vector<size_t> & rowGroups, const std::vector<size_t> & groupSizes,
+            mlir::daphne::GroupEnum aggFunc) {
+        using mlir::daphne::GroupEnum;
+        const VTArg * valuesArg = static_cast<const VTArg *>(arg->getColumnRaw(argColIdx));
+        VTRes * valuesRes = static_cast<VTRes *>(res->getColumnRaw(resColIdx));
+        const size_t numRows = rowGroups.size();
+        const size_t numGroups = groupSizes.size();
+        switch(aggFunc) {
+            case GroupEnum::COUNT:
+                for(size_t g = 0; g < numGroups; g++)
+                    valuesRes[g] = groupSizes[g];
+                break;
+            case GroupEnum::SUM:
+                std::fill(valuesRes, valuesRes + numGroups, VTRes(0));
+                for(size_t r = 0; r < numRows; r++)
+                    if(rowGroups[r] != GROUP_NONE)
+                        valuesRes[rowGroups[r]] += valuesArg[r];
+                break;
+            case GroupEnum::MIN:
+            case GroupEnum::MAX: {
+                std::vector<bool> seen(numGroups, false);
+                for(size_t r = 0; r < numRows; r++) {
+                    const size_t g = rowGroups[r];
+                    if(g == GROUP_NONE)
+                        continue;
+                    if(!seen[g] || (aggFunc == GroupEnum::MIN ? valuesArg[r] < valuesRes[g] : valuesRes[g] < valuesArg[r])) {
+                        valuesRes[g] = valuesArg[r];
+                        seen[g] = true;
+                    }
+                }
+                break;
+            }
+            case GroupEnum::AVG: {
+                std::vector<double> sums(numGroups, 0);
+                for(size_t r = 0; r < numRows; r++)
+                    if(rowGroups[r] != GROUP_NONE)
+                        sums[rowGroups[r]] += valuesArg[r];
+                for(size_t g = 0; g < numGroups; g++)
+                    valuesRes[g] = sums[g] / groupSizes[g];
+                break;
+            }
+        }
+    }
+};
+
+// The parameters of grouping on a hash table: the maximum number of distinct
+// keys (relative to the number of rows) for which the hash table is used
+// instead of ordering the frame, the rows of the chunks aggregated in
+// parallel, and the rows whose keys are looked up at once.
+constexpr size_t GROUP_HASH_MAX_DISTINCT_RATIO = 8;
+constexpr size_t GROUP_HASH_CHUNK_ROWS = 1 << 16;
+constexpr size_t GROUP_HASH_BLOCK_ROWS = 1 << 10;
+
+/**
+ * @brief The groups of the rows of a chunk of a frame with integer key
+ * columns, whose keys are stored as `int64_t`, in a `FlatHashIndex`. Each
+ * group has a partial aggregate per aggregation column.
+ */
+struct GroupHashTable {
+    size_t numKeyCols;
+    std::vector<int64_t> keys; // numKeyCols per group
+    std::vector<size_t> counts; // the rows per group
+    FlatHashIndex index;
+    // per aggregation column, the partial aggregates (of the value type of
+    // the result column) of the groups
+    std::vector<std::vector<uint8_t>> aggs;
+
+    GroupHashTable(size_t numKeyCols, size_t numAggCols, size_t expectedGroups)
+            : numKeyCols(numKeyCols), index(expectedGroups), aggs(numAggCols) {
+        // nothing to do
+    }
+
+    size_t getNumGroups() const { return index.size(); }
+
+    uint64_t getHash(size_t g) const { return index.getHash(g); }
+
+    /**
+     * @brief Writes the hashes of the keys of the rows [begin, end) of a
+     * frame, column by column (see `ColumnHash`), to `hashes`.
+     */
+    static void hash(uint64_t * hashes, const Frame * arg, const size_t * idxs, size_t numKeyCols,
+            size_t begin, size_t end);
+
+    /**
+     * @brief Returns the group of the given key, which is added if it was
+     * not found.
+     */
+    size_t findOrInsert(const int64_t * key, uint64_t h) {
+        const auto [g, inserted] = index.findOrInsert(h, [&](size_t g) {
+            return std::equal(key, key + numKeyCols, keys.data() + g * numKeyCols);
+        });
+        if(inserted) {
+            keys.insert(keys.end(), key, key + numKeyCols);
+            counts.push_back(0);
+        }
+        return g;
+    }
+};
+
+// Reads the keys of the rows [begin, end) of the argColIdx-th column of arg
+// into every numKeyCols-th element of keys, starting at the i-th one.
+template<typename VT>
+struct GroupHashKeys {
+    static void apply(int64_t * keys, const Frame * arg, size_t argColIdx, size_t i, size_t numKeyCols,
+            size_t begin, size_t end) {
+        const VT * values = static_cast<const VT *>(arg->getColumnRaw(argColIdx));
+        for(size_t r = begin; r < end; r++)
+            keys[(r - begin) * numKeyCols + i] = static_cast<int64_t>(values[r]);
+    }
+};
+
+// Hashes the rows [begin, end) of the argColIdx-th column of arg into hashes.
+template<typename VT>
+struct GroupHashKeyHashes {
+    static void apply(uint64_t * hashes, const Frame * arg, size_t argColIdx, bool first, size_t begin, size_t end) {
+        const VT * values = static_cast<const VT *>(arg->getColumnRaw(argColIdx));
+        ColumnHash::hashColumn(hashes, values + begin, end - begin, first);
+    }
+};
+
+inline void GroupHashTable::hash(uint64_t * hashes, const Frame * arg, const size_t * idxs, size_t numKeyCols,
+        size_t begin, size_t end) {
+    // without key columns, all rows form a single group
+    if(numKeyCols == 0)
+        std::fill(hashes, hashes + (end - begin), flatHashMix(0));
+    for(size_t i = 0; i < numKeyCols; i++)
+        DeduceValueTypeAndExecute<GroupHashKeyHashes>::apply(arg->getSchema()[idxs[i]], hashes, arg, idxs[i], i == 0,
+                begin, end);
+}
+
+// Writes the i-th key of the given groups to the resColIdx-th column of res.
+template<typename VT>
+struct GroupHashKeyCol {
+    static void apply(Frame * res, size_t resColIdx, const int64_t * keys, size_t numKeyCols, size_t i,
+            const std::vector<size_t> & groups) {
+        VT * values = static_cast<VT *>(res->getColumnRaw(resColIdx));
+        for(size_t g = 0; g < groups.size(); g++)
+            values[g] = static_cast<VT>(keys[groups[g] * numKeyCols + i]);
+    }
+};
+
+// Aggregates the partial aggregates of a hash table, with VTRes the value
+// type of the result column and VTArg the one of the aggregated column:
+// initializing the partial aggregates of new groups and adding the values of
+// the rows [begin, end) to the partial aggregates of their groups (except for
+// the rows of GROUP_NONE).
+template<typename VTRes, typename VTArg>
+struct GroupHashAgg {
+    static VTRes neutral(mlir::daphne::GroupEnum aggFunc) {
+        using mlir::daphne::GroupEnum;
+        constexpr bool inf = std::numeric_limits<VTRes>::has_infinity;
+        if(aggFunc == GroupEnum::MIN)
+            return inf ? std::numeric_limits<VTRes>::infinity() : std::numeric_limits<VTRes>::max();
+        if(aggFunc == GroupEnum::MAX)
+            return inf ? -std::numeric_limits<VTRes>::infinity() : std::numeric_limits<VTRes>::lowest();
+        return 0;
+    }
+
+    static void combine(VTRes & acc, VTRes v, mlir::daphne::GroupEnum aggFunc) {
+        using mlir::daphne::GroupEnum;
+        switch(aggFunc) {
+            case GroupEnum::MIN: if(v < acc) acc = v; break;
+            case GroupEnum::MAX: if(acc < v) acc = v; break;
+            default: acc += v; break;
+        }
+    }
+
+    static void init(std::vector<uint8_t> & aggs, size_t numGroups, mlir::daphne::GroupEnum aggFunc) {
+        const size_t numGroupsBefore = aggs.size() / sizeof(VTRes);
+        if(numGroups > numGroupsBefore) {
+            aggs.resize(numGroups * sizeof(VTRes));
+            std::fill(reinterpret_cast<VTRes *>(aggs.data()) + numGroupsBefore,
+                    reinterpret_cast<VTRes *>(aggs.data()) + numGroups, neutral(aggFunc));
+        }
+    }
+
+    static void apply(std::vector<uint8_t> & aggs, const Frame * arg, size_t argColIdx, const size_t * rowGroups,
+            size_t begin, size_t end, size_t numGroups, mlir::daphne::GroupEnum aggFunc) {
+        using mlir::daphne::GroupEnum;
+        init(aggs, numGroups, aggFunc);
+        // COUNT is given by the number of rows of the groups
+        if(aggFunc == GroupEnum::COUNT)
+            return;
+        VTRes * acc = reinterpret_cast<VTRes *>(aggs.data());
+        const VTArg * values = static_cast<const VTArg *>(arg->getColumnRaw(argColIdx));
+        for(size_t r = begin; r < end; r++) {
+            const size_t g = rowGroups[r - begin];
+            if(g != GROUP_NONE)
+                combine(acc[g], static_cast<VTRes>(values[r]), aggFunc);
+        }
+    }
+};
+
+// Merges the partial aggregates of the groups from of another table into the
+// groups into of a table.
+template<typename VTRes, typename VTArg>
+struct GroupHashAggMerge {
+    static void apply(std::vector<uint8_t> & aggs, const std::vector<uint8_t> & aggsFrom,
+            const std::vector<size_t> & from, const std::vector<size_t> & into, size_t numGroups,
+            mlir::daphne::GroupEnum aggFunc) {
+        GroupHashAgg<VTRes, VTArg>::init(aggs, numGroups, aggFunc);
+        VTRes * acc = reinterpret_cast<VTRes *>(aggs.data());
+        const VTRes * accFrom = reinterpret_cast<const VTRes *>(aggsFrom.data());
+        for(size_t i = 0; i < from.size(); i++)
+            GroupHashAgg<VTRes, VTArg>::combine(acc[into[i]], accFrom[from[i]], aggFunc);
+    }
+};
+
+// Writes the aggregates of the given groups to the resColIdx-th column of res.
+template<typename VTRes, typename VTArg>
+struct GroupHashAggWrite {
+    static void apply(Frame * res, size_t resColIdx, const std::vector<uint8_t> & aggs,
+            const std::vector<size_t> & counts, const std::vector<size_t> & groups, mlir::daphne::GroupEnum aggFunc) {
+        using mlir::daphne::GroupEnum;
+        VTRes * values = static_cast<VTRes *>(res->getColumnRaw(resColIdx));
+        const VTRes * acc = reinterpret_cast<const VTRes *>(aggs.data());
+        for(size_t i = 0; i < groups.size(); i++) {
+            const size_t g = groups[i];
+            switch(aggFunc) {
+                case GroupEnum::COUNT: values[i] = counts[g]; break;
+                case GroupEnum::AVG: values[i] = acc[g] / counts[g]; break;
+                default: values[i] = acc[g]; break;
+            }
+        }
+    }
+};
+
 template <> struct Group<Frame> {
+    // Sets the labels and value types of the result, whose columns are the
+    // colIdxs-th columns of the given frame.
+    static void initResultSchema(std::string * labels, ValueTypeCode * schema, const Frame * frame,
+            const size_t * colIdxs, const char ** keyCols, size_t numKeyCols, const char ** aggCols, size_t numAggCols,
+            mlir::daphne::GroupEnum * aggFuncs) {
+        const size_t numColsRes = numKeyCols + numAggCols;
+        for (size_t i = 0; i < numKeyCols; i++) {
+            labels[i] = keyCols[i];
+            schema[i] = frame->getColumnType(colIdxs[i]);
+        }
+        using mlir::daphne::GroupEnum;
+        for (size_t i = numKeyCols; i < numColsRes; i++) {
+            // TODO Maybe we can find a good way to call mlir::daphne::stringifyGroupEnum,
+            // we would need to link with the respective library.
+//            labels[i] = mlir::daphne::stringifyGroupEnum(aggFuncs[i-numKeyCols]).str() + "(" +  aggCols[i-numKeyCols] + ")";
+            labels[i] = myStringifyGroupEnum(aggFuncs[i-numKeyCols]) + "(" +  aggCols[i-numKeyCols] + ")";
+            switch(aggFuncs[i-numKeyCols]) {
+                case GroupEnum::COUNT: schema[i] = ValueTypeCode::UI64; break;
+                case GroupEnum::SUM: schema[i] = frame->getColumnType(colIdxs[i]); break;
+                case GroupEnum::MIN: schema[i] = frame->getColumnType(colIdxs[i]); break;
+                case GroupEnum::MAX: schema[i] = frame->getColumnType(colIdxs[i]); break;
+                case GroupEnum::AVG: schema[i] = ValueTypeCode::F64; break;
+            }
+        }
+    }
+
+    /**
+     * @brief Groups on the codes of the key columns, if all of them are
+     * dictionary-encoded and have few combinations of codes.
+     *
+     * The combined code of a row has the code of the first key column as
+     * its most significant digit, such that the groups are ordered by their
+     * keys like in the general case. The frame is neither ordered nor copied.
+     * Only the rows whose entry in `selected` is non-zero are grouped, unless
+     * `selected` is `nullptr`.
+     *
+     * @return `true` if the result was computed, `false` if the general case
+     * must be used.
+     */
+    static bool groupOnCodes(Frame *& res, const Frame * arg, const size_t * idxs, const char ** keyCols,
+            size_t numKeyCols, const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs,
+            const uint8_t * selected) {
+        std::vector<const DictionaryCodes *> keyCodes(numKeyCols);
+        std::vector<size_t> strides(numKeyCols);
+        size_t numCodes = 1;
+        for (size_t i = numKeyCols; i-- > 0; ) {
+            keyCodes[i] = arg->getDictionaryCodes(idxs[i]);
+            if (keyCodes[i] == nullptr || keyCodes[i]->getDictionarySize() == 0)
+                return false;
+            strides[i] = numCodes;
+            numCodes *= keyCodes[i]->getDictionarySize();
+            if (numCodes > GROUP_MAX_NUM_CODES)
+                return false;
+        }
+
+        // combine the codes of each row and number the occurring ones in ascending order
+        const size_t numRows = arg->getNumRows();
+        std::vector<size_t> rowGroups(numRows, 0);
+        for (size_t i = 0; i < numKeyCols; i++)
+            for (size_t r = 0; r < numRows; r++)
+                rowGroups[r] += keyCodes[i]->getCode(r) * strides[i];
+        std::vector<size_t> groupOfCode(numCodes, GROUP_NONE);
+        for (size_t r = 0; r < numRows; r++)
+            if (!selected || selected[r])
+                groupOfCode[rowGroups[r]] = 0;
+        std::vector<size_t> groupCodes;
+        for (size_t code = 0; code < numCodes; code++)
+            if (groupOfCode[code] != GROUP_NONE) {
+                groupOfCode[code] = groupCodes.size();
+                groupCodes.push_back(code);
+            }
+        std::vector<size_t> groupSizes(groupCodes.size(), 0);
+        for (size_t r = 0; r < numRows; r++) {
+            if (selected && !selected[r]) {
+                rowGroups[r] = GROUP_NONE;
+                continue;
+            }
+            rowGroups[r] = groupOfCode[rowGroups[r]];
+            groupSizes[rowGroups[r]]++;
+        }
+
+        const size_t numColsRes = numKeyCols + numAggCols;
+        std::string * labels = new std::string[numColsRes];
+        ValueTypeCode * schema = new ValueTypeCode[numColsRes];
+        initResultSchema(labels, schema, arg, idxs, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs);
+        res = DataObjectFactory::create<Frame>(groupCodes.size(), numColsRes, schema, labels, false);
+        delete [] labels;
+        delete [] schema;
+
+        for (size_t i = 0; i < numKeyCols; i++) {
+            if (res->getSchema()[i] == ValueTypeCode::STR)
+                DictionaryGroupKey<std::string>::apply(res, arg, idxs[i], i, groupCodes, strides[i]);
+            else
+                DeduceValueTypeAndExecute<DictionaryGroupKey>::apply(res->getSchema()[i], res, arg, idxs[i], i, groupCodes, strides[i]);
+        }
+        for (size_t i = numKeyCols; i < numColsRes; i++)
+            DeduceValueTypeAndExecute<DictionaryGroupAgg>::apply(res->getSchema()[i], arg->getSchema()[idxs[i]], res, arg, idxs[i], i, rowGroups, groupSizes, aggFuncs[i-numKeyCols]);
+        return true;
+    }
+
+    /**
+     * @brief Groups on hash tables, if all key columns have integer value
+     * types and a HyperLogLog sketch of their keys estimates few distinct
+     * keys.
+     *
+     * Chunks of the rows are aggregated into a hash table per chunk in
+     * parallel. The groups of these tables are merged into a table per
+     * partition of the hashes of their keys, in parallel, too, and finally
+     * ordered by their keys like in the general case. Without key columns,
+     * the partial aggregates of the chunks form a single group.
+     *
+     * Only the `numSelected` rows whose entry in `selected` is non-zero are
+     * grouped, unless `selected` is `nullptr`.
+     *
+     * @return `true` if the result was computed, `false` if the general case
+     * must be used.
+     */
+    static bool groupOnHash(Frame *& res, const Frame * arg, const size_t * idxs, const char ** keyCols,
+            size_t numKeyCols, const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs,
+            const uint8_t * selected, size_t numSelected, DCTX(ctx)) {
+        const ValueTypeCode * schemaArg = arg->getSchema();
+        for (size_t i = 0; i < numKeyCols + numAggCols; i++) {
+            const ValueTypeCode vtc = schemaArg[idxs[i]];
+            if (vtc == ValueTypeCode::STR || (i < numKeyCols && (vtc == ValueTypeCode::F32 || vtc == ValueTypeCode::F64)))
+                return false;
+            // materialize the columns before reading them in parallel
+            arg->getColumnRaw(idxs[i]);
+        }
+        const size_t numRows = arg->getNumRows();
+        if (numSelected == 0)
+            return false;
+
+        // estimate the number of groups by sketches of the hashes of the keys of the chunks
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / GROUP_HASH_CHUNK_ROWS));
+        std::vector<HyperLogLog> sketches(numChunks);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t c) {
+            std::vector<uint64_t> hashes(GROUP_HASH_BLOCK_ROWS);
+            const size_t chunkEnd = numRows * (c + 1) / numChunks;
+            for (size_t begin = numRows * c / numChunks; begin < chunkEnd; begin += GROUP_HASH_BLOCK_ROWS) {
+                const size_t end = std::min(chunkEnd, begin + GROUP_HASH_BLOCK_ROWS);
+                GroupHashTable::hash(hashes.data(), arg, idxs, numKeyCols, begin, end);
+                size_t n = end - begin;
+                if (selected) {
+                    n = 0;
+                    for (size_t r = begin; r < end; r++)
+                        if (selected[r])
+                            hashes[n++] = hashes[r - begin];
+                }
+                sketches[c].add(hashes.data(), n);
+            }
+        });
+        for (size_t c = 1; c < numChunks; c++)
+            sketches[0].merge(sketches[c]);
+        const size_t numGroupsEst = std::max<size_t>(1, static_cast<size_t>(sketches[0].estimate() + 0.5));
+        if (numGroupsEst * GROUP_HASH_MAX_DISTINCT_RATIO > numSelected)
+            return false;
+
+        const size_t numColsRes = numKeyCols + numAggCols;
+        std::vector<std::string> labels(numColsRes);
+        std::vector<ValueTypeCode> schema(numColsRes);
+        initResultSchema(labels.data(), schema.data(), arg, idxs, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs);
+
+        // aggregate the chunks into their tables
+        const size_t chunkGroupsEst = std::min(numGroupsEst, numSelected / numChunks + 1);
+        std::vector<GroupHashTable> tables(numChunks, GroupHashTable(numKeyCols, numAggCols, chunkGroupsEst));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t c) {
+            GroupHashTable & t = tables[c];
+            std::vector<int64_t> keys(GROUP_HASH_BLOCK_ROWS * numKeyCols);
+            std::vector<uint64_t> hashes(GROUP_HASH_BLOCK_ROWS);
+            std::vector<size_t> rowGroups(GROUP_HASH_BLOCK_ROWS);
+            const size_t chunkEnd = numRows * (c + 1) / numChunks;
+            for (size_t begin = numRows * c / numChunks; begin < chunkEnd; begin += GROUP_HASH_BLOCK_ROWS) {
+                const size_t end = std::min(chunkEnd, begin + GROUP_HASH_BLOCK_ROWS);
+                for (size_t i = 0; i < numKeyCols; i++)
+                    DeduceValueTypeAndExecute<GroupHashKeys>::apply(schemaArg[idxs[i]], keys.data(), arg, idxs[i], i, numKeyCols, begin, end);
+                GroupHashTable::hash(hashes.data(), arg, idxs, numKeyCols, begin, end);
+                for (size_t r = begin; r < end; r++) {
+                    if (selected && !selected[r]) {
+                        rowGroups[r - begin] = GROUP_NONE;
+                        continue;
+                    }
+                    const int64_t * k = keys.data() + (r - begin) * numKeyCols;
+                    const size_t g = t.findOrInsert(k, hashes[r - begin]);
+                    t.counts[g]++;
+                    rowGroups[r - begin] = g;
+                }
+                for (size_t a = 0; a < numAggCols; a++)
+                    DeduceValueTypeAndExecute<GroupHashAgg>::apply(schema[numKeyCols + a], schemaArg[idxs[numKeyCols + a]],
+                            t.aggs[a], arg, idxs[numKeyCols + a], rowGroups.data(), begin, end, t.getNumGroups(), aggFuncs[a]);
+            }
+        });
+
+        // merge the groups of the tables, partitioned by the highest bits of their hashes
+        size_t numChunkGroups = 0;
+        for (const GroupHashTable & t : tables)
+            numChunkGroups += t.getNumGroups();
+        size_t numBits = 0;
+        while (numBits < 6 && (numChunkGroups >> numBits) > GROUP_HASH_CHUNK_ROWS)
+            numBits++;
+        const size_t numParts = size_t(1) << numBits;
+        std::vector<GroupHashTable> parts(numParts, GroupHashTable(numKeyCols, numAggCols, numGroupsEst / numParts));
+        WorkerPool::parallelFor(ctx, numParts, [&](size_t p) {
+            GroupHashTable & m = parts[p];
+            std::vector<size_t> from, into;
+            for (const GroupHashTable & t : tables) {
+                from.clear();
+                into.clear();
+                for (size_t g = 0; g < t.getNumGroups(); g++) {
+                    if (numBits && (t.getHash(g) >> (64 - numBits)) != p)
+                        continue;
+                    const size_t gm = m.findOrInsert(t.keys.data() + g * numKeyCols, t.getHash(g));
+                    m.counts[gm] += t.counts[g];
+                    from.push_back(g);
+                    into.push_back(gm);
+                }
+                for (size_t a = 0; a < numAggCols; a++)
+                    DeduceValueTypeAndExecute<GroupHashAggMerge>::apply(schema[numKeyCols + a], schemaArg[idxs[numKeyCols + a]],
+                            m.aggs[a], t.aggs[a], from, into, m.getNumGroups(), aggFuncs[a]);
+            }
+        });
+
+        // concatenate the partitions and order the groups by their keys
+        GroupHashTable all(numKeyCols, numAggCols, 0);
+        for (const GroupHashTable & m : parts) {
+            all.keys.insert(all.keys.end(), m.keys.begin(), m.keys.end());
+            all.counts.insert(all.counts.end(), m.counts.begin(), m.counts.end());
+            for (size_t a = 0; a < numAggCols; a++)
+                all.aggs[a].insert(all.aggs[a].end(), m.aggs[a].begin(), m.aggs[a].end());
+        }
+        const size_t numGroups = all.counts.size();
+        std::vector<bool> isUnsigned(numKeyCols);
+        for (size_t i = 0; i < numKeyCols; i++)
+            isUnsigned[i] = schema[i] == ValueTypeCode::UI8 || schema[i] == ValueTypeCode::UI32 || schema[i] == ValueTypeCode::UI64;
+        std::vector<size_t> groups(numGroups);
+        std::iota(groups.begin(), groups.end(), 0);
+        std::sort(groups.begin(), groups.end(), [&](size_t g1, size_t g2) {
+            const int64_t * k1 = all.keys.data() + g1 * numKeyCols;
+            const int64_t * k2 = all.keys.data() + g2 * numKeyCols;
+            for (size_t i = 0; i < numKeyCols; i++)
+                if (k1[i] != k2[i])
+                    return isUnsigned[i] ? static_cast<uint64_t>(k1[i]) < static_cast<uint64_t>(k2[i]) : k1[i] < k2[i];
+            return false;
+        });
+
+        res = DataObjectFactory::create<Frame>(numGroups, numColsRes, schema.data(), labels.data(), false);
+        for (size_t i = 0; i < numKeyCols; i++)
+            DeduceValueTypeAndExecute<GroupHashKeyCol>::apply(schema[i], res, i, all.keys.data(), numKeyCols, i, groups);
+        for (size_t a = 0; a < numAggCols; a++)
+            DeduceValueTypeAndExecute<GroupHashAggWrite>::apply(schema[numKeyCols + a], schemaArg[idxs[numKeyCols + a]],
+                    res, numKeyCols + a, all.aggs[a], all.counts, groups, aggFuncs[a]);
+        return true;
+    }
+
+    /**
+     * @brief Groups the `numSelected` rows of the frame whose entry in
+     * `selected` (one per row) is non-zero, without materializing them.
+     *
+     * This is done on the codes of dictionary-encoded key columns or on hash
+     * tables of integer keys, whose chunks of rows are filtered and
+     * aggregated in parallel.
+     *
+     * @return `true` if the result was computed, `false` if the selected rows
+     * must be materialized and grouped in the general case.
+     */
+    static bool groupSelected(Frame *& res, const Frame * arg, const uint8_t * selected, size_t numSelected,
+            const char ** keyCols, size_t numKeyCols, const char ** aggCols, size_t numAggCols,
+            mlir::daphne::GroupEnum * aggFuncs, DCTX(ctx)) {
+        std::vector<size_t> idxs(numKeyCols + numAggCols);
+        for (size_t i = 0; i < numKeyCols; i++)
+            idxs[i] = arg->getColumnIdx(keyCols[i]);
+        for (size_t i = 0; i < numAggCols; i++)
+            idxs[numKeyCols + i] = arg->getColumnIdx(aggCols[i]);
+        return (numKeyCols > 0 && groupOnCodes(res, arg, idxs.data(), keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, selected))
+                || groupOnHash(res, arg, idxs.data(), keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, selected, numSelected, ctx);
+    }
+
     static void apply(Frame *& res, const Frame * arg, const char ** keyCols, size_t numKeyCols,
         const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs, size_t numAggFuncs, DCTX(ctx)) {
+        groupRows(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggFuncs, false, ctx);
+    }
+
+    /**
+     * @brief Groups the rows of a frame, which are sorted by the key columns
+     * if `keysSorted` is set (e.g., known by the compiler, see `sortedGroup`),
+     * such that the groups are found in the order of the rows.
+     */
+    static void groupRows(Frame *& res, const Frame * arg, const char ** keyCols, size_t numKeyCols,
+        const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs, size_t numAggFuncs,
+        bool keysSorted, DCTX(ctx)) {
         size_t numRowsArg = arg->getNumRows();
         size_t numColsRes = numKeyCols + numAggCols;
         size_t numRowsRes = numRowsArg;
@@ -136,6 +698,47 @@ template <> struct Group<Frame> {
         for (size_t i = numKeyCols; i < numColsRes; i++) {
             idxs[i] = arg->getColumnIdx(aggCols[i-numKeyCols]);
         }
+        // Without rows, there are no groups, e.g., in an empty partition of a distributed group-by.
+        if (numKeyCols > 0 && numRowsArg == 0) {
+            delete [] ascending;
+            std::vector<std::string> labels(numColsRes);
+            std::vector<ValueTypeCode> schema(numColsRes);
+            initResultSchema(labels.data(), schema.data(), arg, idxs.get(), keyCols, numKeyCols, aggCols, numAggCols, aggFuncs);
+            res = DataObjectFactory::create<Frame>(0, numColsRes, schema.data(), labels.data(), false);
+            return;
+        }
+        // The rows of sorted key columns (or of a single sorted key column,
+        // see `Frame::isColumnSorted()`) are grouped in their order, without
+        // hashing or ordering them. String keys are grouped on their codes.
+        bool sortedKey = numKeyCols > 0 && (keysSorted || (numKeyCols == 1 && arg->isColumnSorted(idxs[0])));
+        for (size_t i = 0; i < numKeyCols; i++)
+            sortedKey = sortedKey && arg->getColumnType(idxs[i]) != ValueTypeCode::STR;
+        if (numKeyCols > 0 && !sortedKey && groupOnCodes(res, arg, idxs.get(), keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, nullptr)) {
+            delete [] ascending;
+            return;
+        }
+        if (!sortedKey && groupOnHash(res, arg, idxs.get(), keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, nullptr, numRowsArg, ctx)) {
+            delete [] ascending;
+            return;
+        }
+
+        // String key columns are always grouped on codes, once they are
+        // dictionary-encoded in a view of the frame.
+        bool hasStringKeys = false;
+        for (size_t i = 0; i < numKeyCols; i++)
+            hasStringKeys = hasStringKeys || arg->getColumnType(idxs[i]) == ValueTypeCode::STR;
+        if (hasStringKeys) {
+            delete [] ascending;
+            Frame * encoded = arg->sliceCol(0, arg->getNumCols());
+            for (size_t i = 0; i < numKeyCols; i++)
+                if (encoded->getColumnEncoding(idxs[i]) != ColumnEncoding::DICTIONARY)
+                    encoded->encodeColumn(idxs[i], ColumnEncoding::DICTIONARY);
+            const bool grouped = groupOnCodes(res, encoded, idxs.get(), keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, nullptr);
+            DataObjectFactory::destroy(encoded);
+            if (!grouped)
+                throw std::runtime_error("group: too many distinct keys to group on string columns");
+            return;
+        }
         
         // reduce frame columns to keyCols and numAggCols (without copying values or the idx array) and reorder them accordingly 
         Frame* reduced{};
@@ -148,7 +751,13 @@ template <> struct Group<Frame> {
         Frame* ordered{};     
 
         // order frame rows by groups and get the group vector;
-        if (numKeyCols > 0){
+        if (sortedKey) {
+            std::vector<size_t> rows(numRowsArg);
+            std::iota(rows.begin(), rows.end(), 0);
+            const OrderKeys keys = orderFrameKeys(reduced, idxs.get(), numKeyCols, ascending, ctx);
+            orderFindGroups(*groups, rows.data(), keys, ctx);
+            ordered = reduced;
+        } else if (numKeyCols > 0){
             order(ordered, reduced, idxs.get(), numKeyCols, ascending, numKeyCols, false, ctx, groups);
             DataObjectFactory::destroy(reduced);
         } else {
@@ -167,30 +776,14 @@ template <> struct Group<Frame> {
         std::string * labels = new std::string[numColsRes];
         ValueTypeCode * schema = new ValueTypeCode[numColsRes];
 
-        for (size_t i = 0; i < numKeyCols; i++) {
-            labels[i] = keyCols[i];
-            schema[i] = ordered->getColumnType(idxs[i]);
-        }
-        using mlir::daphne::GroupEnum;
-        for (size_t i = numKeyCols; i < numColsRes; i++) {
-            // TODO Maybe we can find a good way to call mlir::daphne::stringifyGroupEnum,
-            // we would need to link with the respective library.
-//            labels[i] = mlir::daphne::stringifyGroupEnum(aggFuncs[i-numKeyCols]).str() + "(" +  aggCols[i-numKeyCols] + ")";
-            labels[i] = myStringifyGroupEnum(aggFuncs[i-numKeyCols]) + "(" +  aggCols[i-numKeyCols] + ")";
-            switch(aggFuncs[i-numKeyCols]) {
-                case GroupEnum::COUNT: schema[i] = ValueTypeCode::UI64; break;
-                case GroupEnum::SUM: schema[i] = ordered->getColumnType(idxs[i]); break;
-                case GroupEnum::MIN: schema[i] = ordered->getColumnType(idxs[i]); break;
-                case GroupEnum::MAX: schema[i] = ordered->getColumnType(idxs[i]); break;
-                case GroupEnum::AVG: schema[i] = ValueTypeCode::F64; break;
-            }
-        } 
+        initResultSchema(labels, schema, ordered, idxs.get(), keyCols, numKeyCols, aggCols, numAggCols, aggFuncs);
         
         res = DataObjectFactory::create<Frame>(numRowsRes, numColsRes, schema, labels, false);
         delete [] labels;
         delete [] schema;
 
         // copying key columns and column-wise group aggregation
+        using mlir::daphne::GroupEnum;
         for (size_t i = 0; i < numColsRes; i++) {
             DeduceValueTypeAndExecute<ColumnGroupAgg>::apply(res->getSchema()[i], ordered->getSchema()[i], res, ordered, i, groups, (i < numKeyCols) ? (GroupEnum) 0 : aggFuncs[i-numKeyCols], ctx);
         }        
@@ -23,10 +23,14 @@
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <util/FlatHashMap.h>
 
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <tuple>
-#include <unordered_map>
+#include <vector>
 
 #include <cstddef>
 #include <cstdint>
@@ -40,6 +44,66 @@
 // ****************************************************************************
 // TODO Maybe this should be a kernel on its own.
 
+// Probes the index of argLhs (see `KeyIndex`) instead of building a hash
+// table. The keys of the index are in the order of their first occurrence,
+// like the entries of the hash table, such that the result is the same.
+template<typename VTLhs, typename VTRhs, typename VTAgg, typename VTTid>
+void groupJoinColIndexed(
+        // results
+        Frame *& res,
+        DenseMatrix<VTTid> *& resLhsTid,
+        // arguments
+        const DenseMatrix<VTLhs> * argLhs,
+        const KeyIndex & indexLhs,
+        const DenseMatrix<VTRhs> * argRhs,
+        const DenseMatrix<VTAgg> * argAgg,
+        // context
+        DCTX(ctx)
+) {
+    const size_t numKeys = indexLhs.getNumKeys();
+    std::vector<VTAgg> aggs(numKeys, VTAgg(0));
+    std::vector<bool> found(numKeys, false);
+    
+    // ------------------------------------------------------------------------
+    // Probe phase on argRhs.
+    // ------------------------------------------------------------------------
+    const VTLhs * valuesLhs = argLhs->getValues();
+    const size_t numArgRhs = argRhs->getNumRows();
+    const VTRhs * valuesRhs = argRhs->getValues();
+    const size_t rowSkipRhs = argRhs->getRowSkip();
+    const VTAgg * valuesAgg = argAgg->getValues();
+    const size_t rowSkipAgg = argAgg->getRowSkip();
+    for(size_t i = 0; i < numArgRhs; i++) {
+        const size_t k = KeyIndexes::lookup(indexLhs, valuesLhs, static_cast<VTLhs>(valuesRhs[i * rowSkipRhs]));
+        if(k != KeyIndex::npos) {
+            aggs[k] += valuesAgg[i * rowSkipAgg];
+            found[k] = true;
+        }
+    }
+    
+    // ------------------------------------------------------------------------
+    // Output phase.
+    // ------------------------------------------------------------------------
+    const size_t numRes = std::count(found.begin(), found.end(), true);
+    if(res == nullptr) {
+        ValueTypeCode schema[] = {ValueTypeUtils::codeFor<VTLhs>, ValueTypeUtils::codeFor<VTAgg>};
+        res = DataObjectFactory::create<Frame>(numRes, 2, schema, nullptr, false);
+    }
+    auto resLhs = res->getColumn<VTLhs>(0);
+    auto resAgg = res->getColumn<VTAgg>(1);
+    if(resLhsTid == nullptr)
+        resLhsTid = DataObjectFactory::create<DenseMatrix<VTTid>>(numRes, 1, false);
+    size_t pos = 0;
+    for(size_t k = 0; k < numKeys; k++)
+        if(found[k]) {
+            const size_t firstRow = indexLhs.getFirstRow(k);
+            resLhs   ->set(pos, 0, valuesLhs[firstRow]);
+            resAgg   ->set(pos, 0, aggs[k]);
+            resLhsTid->set(pos, 0, firstRow);
+            pos++;
+        }
+}
+
 template<typename VTLhs, typename VTRhs, typename VTAgg, typename VTTid>
 void groupJoinCol(
         // results
@@ -60,25 +124,37 @@ void groupJoinCol(
         throw std::runtime_error("parameter argAgg must be a single-column matrix");
     if(argRhs->getNumRows() != argAgg->getNumRows())
         throw std::runtime_error("parameters argRhs and argAgg must have the same number of rows");
+    
+    if(auto indexLhs = argLhs->getKeyIndex(0)) {
+        groupJoinColIndexed(res, resLhsTid, argLhs, *indexLhs, argRhs, argAgg, ctx);
+        return;
+    }
         
-    std::unordered_map<VTLhs, std::tuple<size_t, VTAgg, bool>> ht;
+    // The entries are kept in the order of their first occurrence in argLhs.
+    const size_t numArgLhs = argLhs->getNumRows();
+    FlatHashMap<VTLhs, std::tuple<size_t, VTAgg, bool>> ht(numArgLhs);
     
     // ------------------------------------------------------------------------
     // Build phase on argLhs.
     // ------------------------------------------------------------------------
-    const size_t numArgLhs = argLhs->getNumRows();
+    const VTLhs * valuesLhs = argLhs->getValues();
+    const size_t rowSkipLhs = argLhs->getRowSkip();
     for(size_t i = 0; i < numArgLhs; i++)
-        ht.emplace(argLhs->get(i, 0), std::make_tuple(i, 0, false));
+        ht.emplace(valuesLhs[i * rowSkipLhs], i, VTAgg(0), false);
     
     // ------------------------------------------------------------------------
     // Probe phase on argRhs.
     // ------------------------------------------------------------------------
     const size_t numArgRhs = argRhs->getNumRows();
+    const VTRhs * valuesRhs = argRhs->getValues();
+    const size_t rowSkipRhs = argRhs->getRowSkip();
+    const VTAgg * valuesAgg = argAgg->getValues();
+    const size_t rowSkipAgg = argAgg->getRowSkip();
     for(size_t i = 0; i < numArgRhs; i++) {
-        auto it = ht.find(argRhs->get(i, 0));
-        if(it != ht.end()) {
-            std::get<1>(it->second) += argAgg->get(i, 0);
-            std::get<2>(it->second) = true;
+        auto * v = ht.find(static_cast<VTLhs>(valuesRhs[i * rowSkipRhs]));
+        if(v) {
+            std::get<1>(*v) += valuesAgg[i * rowSkipAgg];
+            std::get<2>(*v) = true;
         }
     }
     
@@ -166,6 +242,10 @@ void groupJoin(
     ValueTypeCode vtcRhsOn = rhs->getColumnType(rhsOn);
     ValueTypeCode vtcRhsAgg = rhs->getColumnType(rhsAgg);
     
+    // The column of lhs keeps an index of lhs on it, if there is one or
+    // indexes are enabled (see `KeyIndexes::get()`).
+    KeyIndexes::get(lhs, {lhs->getColumnIdx(lhsOn)}, ctx);
+    
     // Call the groupJoin-kernel on columns for the actual combination of
     // value types.
     // Repeat this for all type combinations...
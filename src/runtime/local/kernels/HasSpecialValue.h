@@ -22,6 +22,7 @@
 #include <cstdio>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/ParallelScan.h>
 #include <string>
 #include <cmath>
 #include <type_traits>
@@ -47,32 +48,35 @@ template <class DTArg, typename TestType> bool hasSpecialValue(const DTArg *arg,
     return HasSpecialValue<DTArg, TestType>::apply(arg, testVal, ctx);
 }
 
+// The rows (or values) are tested in parallel blocks, NaNs by their bit patterns, see ParallelScan.h.
+
 template <typename VT, typename TestType> struct HasSpecialValue<DenseMatrix<VT>, TestType> {
     static bool apply(const DenseMatrix<VT> *arg, TestType testVal, DCTX(ctx)) {
-        auto numRows = arg->getNumRows();
-        auto numCols = arg->getNumCols();
+        const size_t numRows = arg->getNumRows();
+        const size_t numCols = arg->getNumCols();
+        const VT *values = arg->getValues();
+        const size_t rowSkip = arg->getRowSkip();
 
         if(std::isnan(testVal)) {
-            for(auto rowIdx = 0ul; rowIdx < numRows; rowIdx++) {
-                for(auto colIdx = 0ul; colIdx < numCols; colIdx++) {
-                    auto val = arg->get(rowIdx, colIdx);
-                    if (std::isnan(val)) {
-                        return true;
-                    }
-                }
-            }
-        } else {
-            for(auto rowIdx = 0ul; rowIdx < numRows; rowIdx++) {
-                for(auto colIdx = 0ul; colIdx < numCols; colIdx++) {
-                    auto val = arg->get(rowIdx, colIdx);
-                    if (val == testVal) {
-                        return true;
-                    }
-                }
+            if constexpr(std::is_floating_point<VT>::value) {
+                return ParallelScan::any("hasSpecialValue", numRows, numCols, [&](size_t begin, size_t end) {
+                    for(size_t rowIdx = begin; rowIdx < end; rowIdx++)
+                        if(ParallelScan::anyNaN(values + rowIdx * rowSkip, numCols))
+                            return true;
+                    return false;
+                }, ctx);
             }
+            return false;
         }
-
-        return false;
+        const VT val = static_cast<VT>(testVal);
+        if(val != testVal) // not representable in VT
+            return false;
+        return ParallelScan::any("hasSpecialValue", numRows, numCols, [&](size_t begin, size_t end) {
+            for(size_t rowIdx = begin; rowIdx < end; rowIdx++)
+                if(ParallelScan::anyEqual(values + rowIdx * rowSkip, numCols, val))
+                    return true;
+            return false;
+        }, ctx);
     }
 };
 
@@ -82,29 +86,29 @@ template <typename VT, typename TestType> struct HasSpecialValue<CSRMatrix<VT>,
         auto numCols = arg->getNumCols();
         auto numNonZeros = arg->getNumNonZeros();
         auto numElements = numRows*numCols;
-        auto vBegin = arg->getValues(0);
-        auto vEnd = arg->getValues(numRows);
+        const VT *values = arg->getValues(0);
+        const size_t numValues = arg->getValues(numRows) - values;
         auto hasZeroes = numNonZeros < numElements;
         auto zero = VT(0);
 
         if(std::isnan(testVal)) {
-            for(auto it = vBegin; it != vEnd; it++) {
-                if (std::isnan(*it)) {
-                    return true;
-                }
-            }
-        } else {
-            if (hasZeroes) { // test zero;
-                if ((zero) == testVal) {
-                    return true;
-                }
+            if constexpr(std::is_floating_point<VT>::value) {
+                return ParallelScan::any("hasSpecialValue", numValues, 1, [&](size_t begin, size_t end) {
+                    return ParallelScan::anyNaN(values + begin, end - begin);
+                }, ctx);
             }
-            for(auto it = vBegin; it != vEnd; it++) {
-                if ((*it) == testVal) {
-                    return true;
-                }
+            return false;
+        }
+        if (hasZeroes) { // test zero;
+            if ((zero) == testVal) {
+                return true;
             }
         }
-        return false;
+        const VT val = static_cast<VT>(testVal);
+        if(val != testVal) // not representable in VT
+            return false;
+        return ParallelScan::any("hasSpecialValue", numValues, 1, [&](size_t begin, size_t end) {
+            return ParallelScan::anyEqual(values + begin, end - begin, val);
+        }, ctx);
     }
 };
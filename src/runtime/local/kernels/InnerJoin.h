@@ -5,220 +5,655 @@
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/KeyIndex.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <runtime/local/kernels/ZoneMaps.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/DeduceType.h>
+#include <util/FlatHashMap.h>
 
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
-#include <tuple>
-#include <unordered_set>
+#include <string>
+#include <vector>
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+
+// the rows of the chunks hashed, partitioned, and gathered in parallel
+constexpr size_t INNERJOIN_CHUNK_ROWS = 1 << 16;
+// the rows of the smaller input per partition (at most) and the maximum number
+// of bits of the partitions
+constexpr size_t INNERJOIN_PARTITION_ROWS = 1 << 14;
+constexpr size_t INNERJOIN_MAX_PARTITION_BITS = 10;
 
 // ****************************************************************************
 // Helper functions
 // ****************************************************************************
 
-template<typename VTCol>
-void innerJoinSetValue(
-    DenseMatrix<VTCol> * res,
-    const DenseMatrix<VTCol> * arg,
-    const int64_t targetRow,
-    const int64_t fromRow,
+// Gathers the rows of the result from the rows rowsLhs[i] of lhs and
+// rowsRhs[i] of rhs, in parallel on chunks of the columns.
+inline void innerJoinGather(
+    // results
+    Frame *& res,
+    // input frames
+    const Frame * lhs, const Frame * rhs,
+    // the rows of the result in the input frames
+    const std::vector<size_t> & rowsLhs, const std::vector<size_t> & rowsRhs,
+    // the schema and labels of the result
+    const ValueTypeCode * schema, const std::string * labels,
+    // context
     DCTX(ctx)
-){
-    const VTCol argValue = arg->get(fromRow, 0);
-    res->set(targetRow, 0, argValue);
+) {
+    const size_t numRows = rowsLhs.size();
+    const size_t numColLhs = lhs->getNumCols();
+    const size_t numCols = numColLhs + rhs->getNumCols();
+    res = DataObjectFactory::create<Frame>(numRows, numCols, schema, labels, false);
+
+    std::vector<const uint8_t *> valuesArg(numCols);
+    std::vector<uint8_t *> valuesRes(numCols);
+    for(size_t c = 0; c < numCols; c++) {
+        valuesArg[c] = static_cast<const uint8_t *>(c < numColLhs ? lhs->getColumnRaw(c) : rhs->getColumnRaw(c - numColLhs));
+        valuesRes[c] = static_cast<uint8_t *>(res->getColumnRaw(c));
+    }
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / INNERJOIN_CHUNK_ROWS));
+    WorkerPool::parallelFor(ctx, numCols * numChunks, [&](size_t i) {
+        const size_t c = i / numChunks;
+        const size_t chunk = i % numChunks;
+        const size_t begin = numRows * chunk / numChunks;
+        const size_t end = numRows * (chunk + 1) / numChunks;
+        const std::vector<size_t> & rows = c < numColLhs ? rowsLhs : rowsRhs;
+        if(schema[c] == ValueTypeCode::STR) {
+            const std::string * stringsArg = reinterpret_cast<const std::string *>(valuesArg[c]);
+            std::string * stringsRes = reinterpret_cast<std::string *>(valuesRes[c]);
+            for(size_t r = begin; r < end; r++)
+                stringsRes[r] = stringsArg[rows[r]];
+            return;
+        }
+        const size_t elementSize = ValueTypeUtils::sizeOf(schema[c]);
+        for(size_t r = begin; r < end; r++)
+            memcpy(valuesRes[c] + r * elementSize, valuesArg[c] + rows[r] * elementSize, elementSize);
+    });
+}
+
+// A pair of key columns of the hash join, with the functions hashing and
+// comparing their values (see `KeyIndexes::KeyFuncs`).
+struct InnerJoinKey {
+    const void * lhs;
+    const void * rhs;
+    void (*hash)(uint64_t * hashes, const void * values, size_t begin, size_t end, bool first);
+    bool (*equal)(const void * lhs, size_t l, const void * rhs, size_t r);
+};
+
+inline InnerJoinKey innerJoinMakeKey(ValueTypeCode vtc, const void * lhs, const void * rhs) {
+    const KeyIndexes::KeyFuncs funcs = KeyIndexes::keyFuncsFor(vtc);
+    return {lhs, rhs, funcs.hash, funcs.equal};
+}
+
+// The rows of an input of the hash join partitioned by the highest bits of
+// the hashes of their keys. The rows of each partition are in ascending order.
+struct InnerJoinPartitions {
+    std::vector<size_t> begins; // per partition, and the number of rows
+    std::vector<size_t> rows;
+};
+
+inline InnerJoinPartitions innerJoinPartition(const std::vector<uint64_t> & hashes, size_t numBits, DCTX(ctx)) {
+    const size_t numRows = hashes.size();
+    const size_t numParts = size_t(1) << numBits;
+    const size_t shift = 64 - numBits;
+    auto partOf = [&](size_t r) { return numBits ? static_cast<size_t>(hashes[r] >> shift) : 0; };
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / INNERJOIN_CHUNK_ROWS));
+
+    // the number of rows of each chunk in each partition, then the position
+    // of the first of them
+    std::vector<size_t> counts(numChunks * numParts, 0);
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+        size_t * count = counts.data() + chunk * numParts;
+        for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++)
+            count[partOf(r)]++;
+    });
+    InnerJoinPartitions parts;
+    parts.begins.resize(numParts + 1);
+    size_t pos = 0;
+    for(size_t p = 0; p < numParts; p++) {
+        parts.begins[p] = pos;
+        for(size_t chunk = 0; chunk < numChunks; chunk++) {
+            const size_t n = counts[chunk * numParts + p];
+            counts[chunk * numParts + p] = pos;
+            pos += n;
+        }
+    }
+    parts.begins[numParts] = pos;
+
+    parts.rows.resize(numRows);
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+        size_t * next = counts.data() + chunk * numParts;
+        for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++)
+            parts.rows[next[partOf(r)]++] = r;
+    });
+    return parts;
 }
 
-template<typename VTCol>
-void innerJoinSet(
-    ValueTypeCode vtcType,
-    Frame *&res,
-    const Frame * arg,
-    const int64_t toRow,
-    const int64_t toCol,
-    const int64_t fromRow,
-    const int64_t fromCol,
+// Joins lhs and rhs on the given key columns with a radix-partitioned hash
+// join. The rows of the smaller input are inserted into a hash table per
+// partition, which is probed with the rows of the other input in the same
+// partition. The partitions are joined in parallel, first counting the
+// matches of each row of lhs and then writing them to their positions in the
+// result, such that the rows of the result are ordered by the rows of lhs and
+// then by the rows of rhs, like the rows of a nested-loop join.
+inline void innerJoinHash(
+    // results
+    Frame *& res,
+    // input frames
+    const Frame * lhs, const Frame * rhs,
+    // the key columns
+    const std::vector<InnerJoinKey> & keys,
+    // the schema and labels of the result
+    const ValueTypeCode * schema, const std::string * labels,
+    // context
     DCTX(ctx)
 ) {
-    if(vtcType == ValueTypeUtils::codeFor<VTCol>){
-        innerJoinSetValue<VTCol>(
-            res->getColumn<VTCol>(toCol),
-            arg->getColumn<VTCol>(fromCol),
-            toRow,
-            fromRow,
-            ctx
-        );
+    const size_t numRowLhs = lhs->getNumRows();
+    const size_t numRowRhs = rhs->getNumRows();
+
+    // The hash of the keys of each row.
+    auto hashRows = [&](bool isLhs) {
+        const size_t numRows = isLhs ? numRowLhs : numRowRhs;
+        std::vector<uint64_t> hashes(numRows);
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / INNERJOIN_CHUNK_ROWS));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t begin = numRows * chunk / numChunks;
+            const size_t end = numRows * (chunk + 1) / numChunks;
+            for(size_t k = 0; k < keys.size(); k++)
+                keys[k].hash(hashes.data() + begin, isLhs ? keys[k].lhs : keys[k].rhs, begin, end, k == 0);
+        });
+        return hashes;
+    };
+    const std::vector<uint64_t> hashesLhs = hashRows(true);
+    const std::vector<uint64_t> hashesRhs = hashRows(false);
+    // Whether the keys of the row a of the input in lhsA and the row b of the
+    // input in lhsB are equal.
+    auto keysEqual = [&](bool lhsA, size_t a, bool lhsB, size_t b) {
+        for(const InnerJoinKey & key : keys)
+            if(!key.equal(lhsA ? key.lhs : key.rhs, a, lhsB ? key.lhs : key.rhs, b))
+                return false;
+        return true;
+    };
+
+    // Partition both inputs, such that the hash table of a partition of the
+    // smaller one fits into the cache.
+    const bool buildLhs = numRowLhs < numRowRhs;
+    const size_t numRowBuild = buildLhs ? numRowLhs : numRowRhs;
+    size_t numBits = 0;
+    while(numBits < INNERJOIN_MAX_PARTITION_BITS && (numRowBuild >> numBits) > INNERJOIN_PARTITION_ROWS)
+        numBits++;
+    const InnerJoinPartitions partsLhs = innerJoinPartition(hashesLhs, numBits, ctx);
+    const InnerJoinPartitions partsRhs = innerJoinPartition(hashesRhs, numBits, ctx);
+    const InnerJoinPartitions & partsBuild = buildLhs ? partsLhs : partsRhs;
+    const InnerJoinPartitions & partsProbe = buildLhs ? partsRhs : partsLhs;
+    const std::vector<uint64_t> & hashesBuild = buildLhs ? hashesLhs : hashesRhs;
+    const size_t numParts = size_t(1) << numBits;
+
+    // The hash table of the distinct keys of each partition. The rows of a
+    // key are chained in ascending order (as positions in the partition),
+    // starting at the head of the key's entry.
+    std::vector<FlatHashIndex> tables(numParts);
+    std::vector<std::vector<size_t>> heads(numParts);
+    std::vector<std::vector<size_t>> nexts(numParts);
+    const size_t noRow = std::numeric_limits<size_t>::max();
+    WorkerPool::parallelFor(ctx, numParts, [&](size_t p) {
+        const size_t * rows = partsBuild.rows.data() + partsBuild.begins[p];
+        const size_t n = partsBuild.begins[p + 1] - partsBuild.begins[p];
+        tables[p] = FlatHashIndex(n);
+        nexts[p].resize(n);
+        for(size_t i = n; i-- > 0; ) {
+            const auto [k, inserted] = tables[p].findOrInsert(hashesBuild[rows[i]], [&](size_t k) {
+                return keysEqual(buildLhs, rows[heads[p][k]], buildLhs, rows[i]);
+            });
+            if(inserted) {
+                nexts[p][i] = noRow;
+                heads[p].push_back(i);
+            }
+            else {
+                nexts[p][i] = heads[p][k];
+                heads[p][k] = i;
+            }
+        }
+    });
+
+    // Calls onMatch(l, r) for each pair of matching rows of a partition, in
+    // ascending order of r for each l.
+    auto probe = [&](size_t p, auto onMatch) {
+        const size_t * rowsBuild = partsBuild.rows.data() + partsBuild.begins[p];
+        for(size_t i = partsProbe.begins[p]; i < partsProbe.begins[p + 1]; i++) {
+            const size_t q = partsProbe.rows[i];
+            const uint64_t h = buildLhs ? hashesRhs[q] : hashesLhs[q];
+            const size_t k = tables[p].find(h, [&](size_t k) {
+                return keysEqual(buildLhs, rowsBuild[heads[p][k]], !buildLhs, q);
+            });
+            if(k == FlatHashIndex::npos)
+                continue;
+            for(size_t b = heads[p][k]; b != noRow; b = nexts[p][b])
+                onMatch(buildLhs ? rowsBuild[b] : q, buildLhs ? q : rowsBuild[b]);
+        }
+    };
+
+    // Count the matches of each row of lhs, then write them to the positions
+    // given by the prefix sums of the counts. The rows of lhs are in exactly
+    // one partition each, so that no two tasks write the same count.
+    std::vector<size_t> positions(numRowLhs, 0);
+    WorkerPool::parallelFor(ctx, numParts, [&](size_t p) {
+        probe(p, [&](size_t l, size_t) { positions[l]++; });
+    });
+    size_t numRowsRes = 0;
+    for(size_t l = 0; l < numRowLhs; l++) {
+        const size_t n = positions[l];
+        positions[l] = numRowsRes;
+        numRowsRes += n;
     }
+    std::vector<size_t> rowsLhs(numRowsRes);
+    std::vector<size_t> rowsRhs(numRowsRes);
+    WorkerPool::parallelFor(ctx, numParts, [&](size_t p) {
+        probe(p, [&](size_t l, size_t r) {
+            const size_t pos = positions[l]++;
+            rowsLhs[pos] = l;
+            rowsRhs[pos] = r;
+        });
+    });
+
+    innerJoinGather(res, lhs, rhs, rowsLhs, rowsRhs, schema, labels, ctx);
 }
 
-template<typename VTLhs, typename VTRhs>
-bool innerJoinEqual(
+// Joins lhs and rhs by probing an index on the key columns of one of them
+// (see `KeyIndex`) with the rows of the other one, in parallel chunks, such
+// that the keys of the indexed input are not hashed again. The rows of the
+// result are in the same order as in the general case.
+inline void innerJoinIndexed(
     // results
     Frame *& res,
-    // arguments
-    const DenseMatrix<VTLhs> * argLhs,
-    const DenseMatrix<VTRhs> * argRhs,
-    const int64_t targetLhs,
-    const int64_t targetRhs,
+    // input frames
+    const Frame * lhs, const Frame * rhs,
+    // the key columns, and the index on the ones of lhs (indexLhs) or rhs
+    const std::vector<InnerJoinKey> & keys, const KeyIndex & index, bool indexLhs,
+    // the schema and labels of the result
+    const ValueTypeCode * schema, const std::string * labels,
     // context
     DCTX(ctx)
-){
-    const VTLhs l = argLhs->get(targetLhs, 0);
-    const VTRhs r = argRhs->get(targetRhs, 0);
-    return l == r;
+) {
+    const size_t numRowLhs = lhs->getNumRows();
+    const size_t numRowProbe = indexLhs ? rhs->getNumRows() : numRowLhs;
+    auto numChunksFor = [](size_t n) { return std::max<size_t>(1, std::min<size_t>(64, n / INNERJOIN_CHUNK_ROWS)); };
+
+    // The key of the index of each probing row, or npos.
+    std::vector<size_t> keyOf(numRowProbe);
+    const size_t numChunks = numChunksFor(numRowProbe);
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+        const size_t begin = numRowProbe * chunk / numChunks;
+        const size_t end = numRowProbe * (chunk + 1) / numChunks;
+        std::vector<uint64_t> hashes(end - begin);
+        for(size_t k = 0; k < keys.size(); k++)
+            keys[k].hash(hashes.data(), indexLhs ? keys[k].rhs : keys[k].lhs, begin, end, k == 0);
+        for(size_t p = begin; p < end; p++)
+            keyOf[p] = index.find(hashes[p - begin], [&](size_t i) {
+                for(const InnerJoinKey & key : keys)
+                    if(!(indexLhs ? key.equal(key.lhs, i, key.rhs, p) : key.equal(key.lhs, p, key.rhs, i)))
+                        return false;
+                return true;
+            });
+    });
+
+    std::vector<size_t> rowsLhs;
+    std::vector<size_t> rowsRhs;
+    if(!indexLhs) {
+        // The matches of a row of lhs are the rows of its key in rhs, such
+        // that the chunks of lhs count and then write theirs.
+        std::vector<size_t> offsets(numChunks + 1, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            for(size_t l = numRowLhs * chunk / numChunks; l < numRowLhs * (chunk + 1) / numChunks; l++)
+                if(keyOf[l] != KeyIndex::npos)
+                    offsets[chunk + 1] += index.getRowsEnd(keyOf[l]) - index.getRowsBegin(keyOf[l]);
+        });
+        for(size_t chunk = 0; chunk < numChunks; chunk++)
+            offsets[chunk + 1] += offsets[chunk];
+        rowsLhs.resize(offsets[numChunks]);
+        rowsRhs.resize(offsets[numChunks]);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            size_t pos = offsets[chunk];
+            for(size_t l = numRowLhs * chunk / numChunks; l < numRowLhs * (chunk + 1) / numChunks; l++) {
+                if(keyOf[l] == KeyIndex::npos)
+                    continue;
+                for(const size_t * r = index.getRowsBegin(keyOf[l]); r != index.getRowsEnd(keyOf[l]); r++) {
+                    rowsLhs[pos] = l;
+                    rowsRhs[pos++] = *r;
+                }
+            }
+        });
+    }
+    else {
+        // Group the matching rows of rhs by their key in ascending order, then
+        // write the matches of the rows of each key of lhs to the positions
+        // given by the prefix sums of their counts. The rows of lhs have
+        // exactly one key each, so that the keys are processed in parallel.
+        const size_t numKeys = index.getNumKeys();
+        std::vector<size_t> begins(numKeys + 1, 0);
+        for(size_t r = 0; r < numRowProbe; r++)
+            if(keyOf[r] != KeyIndex::npos)
+                begins[keyOf[r] + 1]++;
+        for(size_t k = 0; k < numKeys; k++)
+            begins[k + 1] += begins[k];
+        std::vector<size_t> rowsByKey(begins[numKeys]);
+        std::vector<size_t> next(begins.begin(), begins.end() - 1);
+        for(size_t r = 0; r < numRowProbe; r++)
+            if(keyOf[r] != KeyIndex::npos)
+                rowsByKey[next[keyOf[r]]++] = r;
+
+        const size_t numKeyChunks = numChunksFor(numKeys);
+        auto forKeys = [&](auto onRowLhs) {
+            WorkerPool::parallelFor(ctx, numKeyChunks, [&](size_t chunk) {
+                for(size_t k = numKeys * chunk / numKeyChunks; k < numKeys * (chunk + 1) / numKeyChunks; k++)
+                    for(const size_t * l = index.getRowsBegin(k); l != index.getRowsEnd(k); l++)
+                        onRowLhs(k, *l);
+            });
+        };
+        std::vector<size_t> positions(numRowLhs, 0);
+        forKeys([&](size_t k, size_t l) { positions[l] = begins[k + 1] - begins[k]; });
+        size_t numRowsRes = 0;
+        for(size_t l = 0; l < numRowLhs; l++) {
+            const size_t n = positions[l];
+            positions[l] = numRowsRes;
+            numRowsRes += n;
+        }
+        rowsLhs.resize(numRowsRes);
+        rowsRhs.resize(numRowsRes);
+        forKeys([&](size_t k, size_t l) {
+            for(size_t i = begins[k], pos = positions[l]; i < begins[k + 1]; i++, pos++) {
+                rowsLhs[pos] = l;
+                rowsRhs[pos] = rowsByKey[i];
+            }
+        });
+    }
+
+    innerJoinGather(res, lhs, rhs, rowsLhs, rowsRhs, schema, labels, ctx);
 }
 
-template<typename VTLhs, typename VTRhs>
-bool innerJoinProbeIf(
-    // value type known only at run-time
-    ValueTypeCode vtcLhs,
-    ValueTypeCode vtcRhs,
+// Finds the matching rows of two key columns sorted in ascending order by
+// merging them. The rows of rhs matching a row of lhs are a run starting at
+// the first key of rhs not less than the key of lhs, such that the chunks of
+// lhs are merged in parallel, first counting and then writing their matches.
+// The rows of the result are in the same order as in the general case.
+template<typename VT>
+struct InnerJoinMerge {
+    static void apply(std::vector<size_t> & rowsLhs, std::vector<size_t> & rowsRhs,
+            const void * lhsKeys, size_t numRowLhs, const void * rhsKeys, size_t numRowRhs, DCTX(ctx)) {
+        const VT * l = static_cast<const VT *>(lhsKeys);
+        const VT * r = static_cast<const VT *>(rhsKeys);
+        // Calls onMatch(l, r) for each pair of matching rows of the chunk.
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRowLhs / INNERJOIN_CHUNK_ROWS));
+        auto merge = [&](size_t chunk, auto onMatch) {
+            const size_t begin = numRowLhs * chunk / numChunks;
+            const size_t end = numRowLhs * (chunk + 1) / numChunks;
+            if(begin == end)
+                return;
+            size_t j = std::lower_bound(r, r + numRowRhs, l[begin]) - r;
+            for(size_t i = begin; i < end; i++) {
+                while(j < numRowRhs && r[j] < l[i])
+                    j++;
+                for(size_t k = j; k < numRowRhs && r[k] == l[i]; k++)
+                    onMatch(i, k);
+            }
+        };
+        std::vector<size_t> offsets(numChunks + 1, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            merge(chunk, [&](size_t, size_t) { offsets[chunk + 1]++; });
+        });
+        for(size_t chunk = 0; chunk < numChunks; chunk++)
+            offsets[chunk + 1] += offsets[chunk];
+        rowsLhs.resize(offsets[numChunks]);
+        rowsRhs.resize(offsets[numChunks]);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            size_t pos = offsets[chunk];
+            merge(chunk, [&](size_t i, size_t k) {
+                rowsLhs[pos] = i;
+                rowsRhs[pos++] = k;
+            });
+        });
+    }
+};
+
+// Joins on a single key column by merging, which must be sorted in both inputs
+// and have the same value type (which is not a string). The key columns of the
+// result are sorted, too, if they are known to be sorted in the inputs.
+inline void innerJoinMerge(
     // results
     Frame *& res,
     // input frames
     const Frame * lhs, const Frame * rhs,
     // input column names
     const char * lhsOn, const char * rhsOn,
-    // input rows
-    const int64_t targetL, const int64_t targetR,
+    // the schema and labels of the result
+    const ValueTypeCode * schema, const std::string * labels,
     // context
     DCTX(ctx)
-){
-    if(vtcLhs == ValueTypeUtils::codeFor<VTLhs> && vtcRhs == ValueTypeUtils::codeFor<VTRhs>) {
-        return innerJoinEqual<VTLhs, VTRhs>(
-                res,
-                lhs->getColumn<VTLhs>(lhsOn),
-                rhs->getColumn<VTRhs>(rhsOn),
-                targetL,
-                targetR,
-                ctx
-        );
-    }
-    return false;
+) {
+    const size_t idxLhs = lhs->getColumnIdx(lhsOn);
+    const size_t idxRhs = rhs->getColumnIdx(rhsOn);
+    std::vector<size_t> rowsLhs;
+    std::vector<size_t> rowsRhs;
+    DeduceValueTypeAndExecute<InnerJoinMerge>::apply(lhs->getColumnType(idxLhs), rowsLhs, rowsRhs,
+            lhs->getColumnRaw(idxLhs), lhs->getNumRows(), rhs->getColumnRaw(idxRhs), rhs->getNumRows(), ctx);
+    innerJoinGather(res, lhs, rhs, rowsLhs, rowsRhs, schema, labels, ctx);
+    ZoneMaps::keepSorted(res, idxLhs, lhs, idxLhs);
+    ZoneMaps::keepSorted(res, lhs->getNumCols() + idxRhs, rhs, idxRhs);
 }
 
-// ****************************************************************************
-// Convenience function
-// ****************************************************************************
+// Joins on a single key column by merging, if it is sorted in both inputs
+// (see `Frame::isColumnSorted()`).
+inline bool innerJoinMergeIf(
+    // results
+    Frame *& res,
+    // input frames
+    const Frame * lhs, const Frame * rhs,
+    // input column names
+    const char * lhsOn, const char * rhsOn,
+    // the schema and labels of the result
+    const ValueTypeCode * schema, const std::string * labels,
+    // context
+    DCTX(ctx)
+) {
+    const size_t idxLhs = lhs->getColumnIdx(lhsOn);
+    const size_t idxRhs = rhs->getColumnIdx(rhsOn);
+    if(!lhs->isColumnSorted(idxLhs) || !rhs->isColumnSorted(idxRhs)
+            || lhs->getColumnType(idxLhs) != rhs->getColumnType(idxRhs))
+        return false;
+    innerJoinMerge(res, lhs, rhs, lhsOn, rhsOn, schema, labels, ctx);
+    return true;
+}
 
-void innerJoin(
+// Joins on the codes of the key columns, if both are dictionary-encoded with
+// the value type VTOn. The rows of the result are in the same order as in the
+// general case.
+template<typename VTOn>
+bool innerJoinOnCodesIf(
     // results
     Frame *& res,
     // input frames
     const Frame * lhs, const Frame * rhs,
     // input column names
     const char * lhsOn, const char * rhsOn,
+    // the schema and labels of the result
+    const ValueTypeCode * schema, const std::string * labels,
     // context
     DCTX(ctx)
 ) {
-    // Find out the value types of the columns to process.
-    ValueTypeCode vtcLhsOn = lhs->getColumnType(lhsOn);
-    ValueTypeCode vtcRhsOn = rhs->getColumnType(rhsOn);
+    const DictionaryColumn<VTOn> * lhsCodes = lhs->getDictionaryColumn<VTOn>(lhs->getColumnIdx(lhsOn));
+    const DictionaryColumn<VTOn> * rhsCodes = rhs->getDictionaryColumn<VTOn>(rhs->getColumnIdx(rhsOn));
+    if(lhsCodes == nullptr || rhsCodes == nullptr)
+        return false;
+
+    // Map the codes of rhs to the codes of lhs by merging the sorted
+    // dictionaries, codes occurring in rhs only are mapped to noCode.
+    const std::vector<VTOn> & lhsDict = *lhsCodes->getDictionary();
+    const std::vector<VTOn> & rhsDict = *rhsCodes->getDictionary();
+    const size_t noCode = lhsDict.size();
+    std::vector<size_t> rhsToLhsCode(rhsDict.size(), noCode);
+    for(size_t i = 0, j = 0; i < lhsDict.size() && j < rhsDict.size(); ) {
+        if(lhsDict[i] < rhsDict[j])
+            i++;
+        else if(rhsDict[j] < lhsDict[i])
+            j++;
+        else
+            rhsToLhsCode[j++] = i++;
+    }
 
-    // Perhaps check if res already allocated.
+    // Bucket the rows of rhs by the code of their key, in ascending order.
     const size_t numRowRhs = rhs->getNumRows();
     const size_t numRowLhs = lhs->getNumRows();
-    const size_t totalRows = numRowRhs * numRowLhs;
-    const size_t numColRhs = rhs->getNumCols();
+    std::vector<size_t> bucketBegins(noCode + 2, 0);
+    for(size_t r = 0; r < numRowRhs; r++)
+        bucketBegins[rhsToLhsCode[rhsCodes->getCode(r)] + 2]++;
+    for(size_t c = 2; c < bucketBegins.size(); c++)
+        bucketBegins[c] += bucketBegins[c - 1];
+    std::vector<size_t> bucketRows(numRowRhs);
+    for(size_t r = 0; r < numRowRhs; r++)
+        bucketRows[bucketBegins[rhsToLhsCode[rhsCodes->getCode(r)] + 1]++] = r;
+
+    // Probe the buckets with the rows of lhs.
+    std::vector<size_t> rowsLhs;
+    std::vector<size_t> rowsRhs;
+    for(size_t l = 0; l < numRowLhs; l++) {
+        const size_t code = lhsCodes->getCode(l);
+        for(size_t i = bucketBegins[code]; i < bucketBegins[code + 1]; i++) {
+            rowsLhs.push_back(l);
+            rowsRhs.push_back(bucketRows[i]);
+        }
+    }
+
+    innerJoinGather(res, lhs, rhs, rowsLhs, rowsRhs, schema, labels, ctx);
+    return true;
+}
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Joins the rows of lhs and rhs whose values in all the key columns
+ * `lhsOn[i]` and `rhsOn[i]` are equal.
+ *
+ * The result has the columns of lhs followed by the columns of rhs. Its rows
+ * are ordered by the rows of lhs and then by the rows of rhs. The key columns
+ * `lhsOn[i]` and `rhsOn[i]` must have the same value type.
+ */
+inline void innerJoin(
+    // results
+    Frame *& res,
+    // input frames
+    const Frame * lhs, const Frame * rhs,
+    // input column names
+    const char ** lhsOn, const char ** rhsOn, size_t numOn,
+    // context
+    DCTX(ctx)
+) {
+    if(numOn == 0)
+        throw std::runtime_error("innerJoin: at least one key column is required");
     const size_t numColLhs = lhs->getNumCols();
-    const size_t totalCols = numColRhs + numColLhs;
-    const std::string * oldlabels_l = lhs->getLabels();
-    const std::string * oldlabels_r = rhs->getLabels();
+    const size_t numColRhs = rhs->getNumCols();
 
-    int64_t col_idx_res = 0;
-    int64_t row_idx_res = 0;
+    std::vector<ValueTypeCode> schema(lhs->getSchema(), lhs->getSchema() + numColLhs);
+    schema.insert(schema.end(), rhs->getSchema(), rhs->getSchema() + numColRhs);
+    std::vector<std::string> labels(lhs->getLabels(), lhs->getLabels() + numColLhs);
+    labels.insert(labels.end(), rhs->getLabels(), rhs->getLabels() + numColRhs);
 
-    ValueTypeCode schema[totalCols];
-    std::string newlabels[totalCols];
+    // Dictionary-encoded key columns are joined on their codes.
+    if(numOn == 1 && (
+            innerJoinOnCodesIf<int64_t>(res, lhs, rhs, lhsOn[0], rhsOn[0], schema.data(), labels.data(), ctx)
+            || innerJoinOnCodesIf<double>(res, lhs, rhs, lhsOn[0], rhsOn[0], schema.data(), labels.data(), ctx)
+            || innerJoinOnCodesIf<std::string>(res, lhs, rhs, lhsOn[0], rhsOn[0], schema.data(), labels.data(), ctx)))
+        return;
+    // Key columns sorted in both inputs are merged.
+    if(numOn == 1 && innerJoinMergeIf(res, lhs, rhs, lhsOn[0], rhsOn[0], schema.data(), labels.data(), ctx))
+        return;
 
-    // Setting Schema and Labels
-    for(size_t col_idx_l = 0; col_idx_l < numColLhs; col_idx_l++){
-        schema[col_idx_res] = lhs->getColumnType(col_idx_l);
-        newlabels[col_idx_res] = oldlabels_l[col_idx_l];
-        col_idx_res++;
+    std::vector<InnerJoinKey> keys;
+    std::vector<size_t> keyColsLhs;
+    std::vector<size_t> keyColsRhs;
+    for(size_t i = 0; i < numOn; i++) {
+        const size_t idxLhs = lhs->getColumnIdx(lhsOn[i]);
+        const size_t idxRhs = rhs->getColumnIdx(rhsOn[i]);
+        const ValueTypeCode vtc = lhs->getColumnType(idxLhs);
+        if(vtc != rhs->getColumnType(idxRhs))
+            throw std::runtime_error(std::string("innerJoin: the key columns ") + lhsOn[i] + " and " + rhsOn[i]
+                    + " must have the same value type");
+        keys.push_back(innerJoinMakeKey(vtc, lhs->getColumnRaw(idxLhs), rhs->getColumnRaw(idxRhs)));
+        keyColsLhs.push_back(idxLhs);
+        keyColsRhs.push_back(idxRhs);
     }
-    for(size_t col_idx_r = 0; col_idx_r < numColRhs; col_idx_r++){
-        schema[col_idx_res] = rhs->getColumnType(col_idx_r);
-        newlabels[col_idx_res] = oldlabels_r[col_idx_r];
-        col_idx_res++;
+
+    // An index on the key columns of either input is probed with the other
+    // one. Otherwise, if indexes are enabled, one is built on the smaller
+    // input and kept for later joins with it (see `KeyIndexes::get()`).
+    bool indexLhs = false;
+    std::shared_ptr<const KeyIndex> index = rhs->getKeyIndex(keyColsRhs);
+    if(!index) {
+        index = lhs->getKeyIndex(keyColsLhs);
+        indexLhs = index != nullptr;
+    }
+    if(!index) {
+        indexLhs = lhs->getNumRows() < rhs->getNumRows();
+        index = indexLhs ? KeyIndexes::get(lhs, keyColsLhs, ctx) : KeyIndexes::get(rhs, keyColsRhs, ctx);
     }
+    if(index) {
+        innerJoinIndexed(res, lhs, rhs, keys, *index, indexLhs, schema.data(), labels.data(), ctx);
+        return;
+    }
+    innerJoinHash(res, lhs, rhs, keys, schema.data(), labels.data(), ctx);
+}
 
-    // Creating Result Frame
-    res = DataObjectFactory::create<Frame>(totalRows, totalCols, schema, newlabels, false);
-
-    for(size_t row_idx_l = 0; row_idx_l < numRowLhs; row_idx_l++){
-        for(size_t row_idx_r = 0; row_idx_r < numRowRhs; row_idx_r++){
-            col_idx_res = 0;
-            //PROBE ROWS
-            bool hit = false;
-            hit = hit || innerJoinProbeIf<int64_t, int64_t>(
-                vtcLhsOn, vtcRhsOn,
-                res,
-                lhs, rhs,
-                lhsOn, rhsOn,
-                row_idx_l, row_idx_r,
-                ctx);
-            hit = hit || innerJoinProbeIf<double, double>(
-                vtcLhsOn, vtcRhsOn,
-                res,
-                lhs, rhs,
-                lhsOn, rhsOn,
-                row_idx_l, row_idx_r,
-                ctx);
-            if(hit){
-                for(size_t idx_c = 0; idx_c < numColLhs; idx_c++){
-                    innerJoinSet<int64_t>(
-                        schema[col_idx_res],
-                        res,
-                        lhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_l,
-                        idx_c,
-                        ctx
-                    );
-                    innerJoinSet<double>(
-                        schema[col_idx_res],
-                        res,
-                        lhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_l,
-                        idx_c,
-                        ctx
-                    );
-                    col_idx_res++;
-                }
-                for(size_t idx_c = 0; idx_c < numColRhs; idx_c++){
-                    innerJoinSet<int64_t>(
-                        schema[col_idx_res],
-                        res,
-                        rhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_r,
-                        idx_c,
-                        ctx
-                    );
-
-                    innerJoinSet<double>(
-                        schema[col_idx_res],
-                        res,
-                        rhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_r,
-                        idx_c,
-                        ctx
-                    );
-                    col_idx_res++;
-                }
-                row_idx_res++;
-            }
-        }
+inline void innerJoin(
+    // results
+    Frame *& res,
+    // input frames
+    const Frame * lhs, const Frame * rhs,
+    // input column names
+    const char * lhsOn, const char * rhsOn,
+    // context
+    DCTX(ctx)
+) {
+    innerJoin(res, lhs, rhs, &lhsOn, &rhsOn, 1, ctx);
+}
+
+/**
+ * @brief Performs an inner join of two frames which the compiler knows to be
+ * sorted by their key columns (see `ATTR_SORTED_KEYS`), by merging them.
+ *
+ * The result is the same as the one of `innerJoin`. Key columns of different
+ * value types or of strings are joined by `innerJoin`.
+ */
+inline void sortedInnerJoin(
+    // results
+    Frame *& res,
+    // input frames
+    const Frame * lhs, const Frame * rhs,
+    // input column names
+    const char * lhsOn, const char * rhsOn,
+    // context
+    DCTX(ctx)
+) {
+    const ValueTypeCode vtc = lhs->getColumnType(lhs->getColumnIdx(lhsOn));
+    if(vtc == ValueTypeCode::STR || vtc != rhs->getColumnType(rhs->getColumnIdx(rhsOn))) {
+        innerJoin(res, lhs, rhs, lhsOn, rhsOn, ctx);
+        return;
     }
-    res->shrinkNumRows(row_idx_res);
+    const size_t numColLhs = lhs->getNumCols();
+    const size_t numColRhs = rhs->getNumCols();
+    std::vector<ValueTypeCode> schema(lhs->getSchema(), lhs->getSchema() + numColLhs);
+    schema.insert(schema.end(), rhs->getSchema(), rhs->getSchema() + numColRhs);
+    std::vector<std::string> labels(lhs->getLabels(), lhs->getLabels() + numColLhs);
+    labels.insert(labels.end(), rhs->getLabels(), rhs->getLabels() + numColRhs);
+    innerJoinMerge(res, lhs, rhs, lhsOn, rhsOn, schema.data(), labels.data(), ctx);
 }
 #endif //SRC_RUNTIME_LOCAL_KERNELS_INNERJOIN_H
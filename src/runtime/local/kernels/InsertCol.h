@@ -20,6 +20,7 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/ReuseArg.h>
 
 #include <stdexcept>
 
@@ -85,8 +86,14 @@ struct InsertCol<DenseMatrix<VT>, DenseMatrix<VT>> {
                     "the number of columns in ins must match"
             );
         
-        if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsArg, numColsArg, false);
+        // An argument at its last use is overwritten with the result, see ReuseArg.h, such that only the columns
+        // of ins are copied (e.g., when a loop fills a matrix column by column).
+        bool inPlace = false;
+        if(res == nullptr) {
+            inPlace = reuseArgAsRes(res, arg, numRowsArg, numColsArg);
+            if(!inPlace)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsArg, numColsArg, false);
+        }
         
         VT * valuesRes = res->getValues();
         const VT * valuesArg = arg->getValues();
@@ -95,6 +102,15 @@ struct InsertCol<DenseMatrix<VT>, DenseMatrix<VT>> {
         const size_t rowSkipArg = arg->getRowSkip();
         const size_t rowSkipIns = ins->getRowSkip();
         
+        if(inPlace) {
+            for(size_t r = 0; r < numRowsArg; r++) {
+                memcpy(valuesRes + colLowerIncl, valuesIns, numColsIns * sizeof(VT));
+                valuesRes += rowSkipRes;
+                valuesIns += rowSkipIns;
+            }
+            return;
+        }
+        
         // TODO Can be simplified/more efficient in certain cases.
         for(size_t r = 0; r < numRowsArg; r++) {
             memcpy(valuesRes, valuesArg, colLowerIncl * sizeof(VT));
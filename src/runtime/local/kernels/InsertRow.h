@@ -20,6 +20,7 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/ReuseArg.h>
 
 #include <stdexcept>
 
@@ -85,8 +86,14 @@ struct InsertRow<DenseMatrix<VT>, DenseMatrix<VT>> {
                     "insertRow: the number of columns in arg and ins must match"
             );
         
-        if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsArg, numColsArg, false);
+        // An argument at its last use is overwritten with the result, see ReuseArg.h, such that only the rows of
+        // ins are copied (e.g., when a loop fills a matrix row by row).
+        bool inPlace = false;
+        if(res == nullptr) {
+            inPlace = reuseArgAsRes(res, arg, numRowsArg, numColsArg);
+            if(!inPlace)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsArg, numColsArg, false);
+        }
         
         VT * valuesRes = res->getValues();
         const VT * valuesArg = arg->getValues();
@@ -95,6 +102,16 @@ struct InsertRow<DenseMatrix<VT>, DenseMatrix<VT>> {
         const size_t rowSkipArg = arg->getRowSkip();
         const size_t rowSkipIns = ins->getRowSkip();
         
+        if(inPlace) {
+            valuesRes += rowLowerIncl * rowSkipRes;
+            for(size_t r = rowLowerIncl; r < rowUpperExcl; r++) {
+                memcpy(valuesRes, valuesIns, numColsArg * sizeof(VT));
+                valuesRes += rowSkipRes;
+                valuesIns += rowSkipIns;
+            }
+            return;
+        }
+        
         // TODO Can be simplified/more efficient in certain cases.
         for(size_t r = 0; r < rowLowerIncl; r++) {
             memcpy(valuesRes, valuesArg, numColsArg * sizeof(VT));
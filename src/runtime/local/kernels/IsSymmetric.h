@@ -17,10 +17,13 @@
 #pragma once
 
 #include <runtime/local/context/DaphneContext.h>
+#include <algorithm>
 #include <cstddef>
 #include <cstdio>
+#include <stdexcept>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/ParallelScan.h>
 #include <string>
 
 template <class DTArg> struct IsSymmetric {
@@ -60,19 +63,47 @@ template <typename VT> struct IsSymmetric<DenseMatrix<VT>> {
             return true;
         }
 
-        // TODO add cache-conscious operations
-        for (size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
-            for (size_t colIdx = rowIdx + 1; colIdx < numCols; colIdx++) {
-
-                const VT val1 = arg->get(rowIdx, colIdx);
-                const VT val2 = arg->get(colIdx, rowIdx);
-
-                if (val1 != val2) {
-                    return false;
+        // Compares the tiles above the diagonal with their transposed tiles below it, such that both are read
+        // from the cache, in parallel (see ParallelScan.h). Row block k of the tiles is paired with row block
+        // numBlocks - 1 - k, such that each pair has numBlocks + 1 tiles and the tiles are numbered evenly.
+        constexpr size_t BLOCK = 64;
+        const VT *values = arg->getValues();
+        const size_t rowSkip = arg->getRowSkip();
+        const size_t numBlocks = (numRows + BLOCK - 1) / BLOCK;
+        const size_t numPairs = (numBlocks + 1) / 2;
+        // whether the tile at the given row and column block differs from its transposed tile
+        auto isAsymmetric = [&](size_t rowBlock, size_t colBlock) {
+            const size_t rowBlockEnd = std::min((rowBlock + 1) * BLOCK, numRows);
+            const size_t colBlockEnd = std::min((colBlock + 1) * BLOCK, numCols);
+            for (size_t rowIdx = rowBlock * BLOCK; rowIdx < rowBlockEnd; rowIdx++) {
+                const VT *row = values + rowIdx * rowSkip;
+                const VT *col = values + rowIdx;
+                unsigned differs = 0;
+                #pragma omp simd reduction(|:differs)
+                for (size_t colIdx = std::max(colBlock * BLOCK, rowIdx + 1); colIdx < colBlockEnd; colIdx++)
+                    differs |= row[colIdx] != col[colIdx * rowSkip];
+                if (differs)
+                    return true;
+            }
+            return false;
+        };
+        return !ParallelScan::any("isSymmetric", numPairs * (numBlocks + 1), BLOCK * BLOCK, [&](size_t begin, size_t end) {
+            for (size_t tile = begin; tile < end; tile++) {
+                const size_t pair = tile / (numBlocks + 1);
+                const size_t k = tile % (numBlocks + 1);
+                if (k < numBlocks - pair) {
+                    if (isAsymmetric(pair, pair + k))
+                        return true;
+                }
+                else {
+                    const size_t rowBlock = numBlocks - 1 - pair;
+                    // the middle row block of an odd number of blocks has no partner
+                    if (rowBlock != pair && isAsymmetric(rowBlock, rowBlock + k - (numBlocks - pair)))
+                        return true;
                 }
             }
-        }
-        return true;
+            return false;
+        }, ctx);
     }
 };
 
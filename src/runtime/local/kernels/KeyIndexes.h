@@ -0,0 +1,183 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/KeyIndex.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/ColumnHash.h>
+#include <util/FlatHashMap.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The hashing and comparison of the keys of the rows of frames, and the building and lookup of the indexes on
+ * the key columns of frames (see `KeyIndex`), by which joins and point filters with the same frame do not hash its
+ * keys again.
+ */
+namespace KeyIndexes {
+    // the rows of the chunks hashed in parallel
+    constexpr size_t CHUNK_ROWS = 1 << 16;
+
+    template<typename VT>
+    void hashColumn(uint64_t * hashes, const void * values, size_t begin, size_t end, bool first) {
+        ColumnHash::hashColumn(hashes, static_cast<const VT *>(values) + begin, end - begin, first);
+    }
+
+    template<typename VT>
+    bool equalValues(const void * lhs, size_t l, const void * rhs, size_t r) {
+        return static_cast<const VT *>(lhs)[l] == static_cast<const VT *>(rhs)[r];
+    }
+
+    /**
+     * @brief The functions hashing and comparing the values of a key column of some value type.
+     *
+     * The hash of a key is the hash of the value of its first column, combined with the hashes of the values of the
+     * others (see `ColumnHash`), such that the hash of a single value is its `FlatHash`.
+     */
+    struct KeyFuncs {
+        // writes (first) or combines the hashes of the rows from begin to end of a column, the one of the row r
+        // at hashes[r - begin]
+        void (*hash)(uint64_t * hashes, const void * values, size_t begin, size_t end, bool first);
+        // whether the l-th value of one column equals the r-th value of another
+        bool (*equal)(const void * lhs, size_t l, const void * rhs, size_t r);
+    };
+
+    template<typename VT>
+    KeyFuncs keyFuncs() {
+        return {&hashColumn<VT>, &equalValues<VT>};
+    }
+
+    inline KeyFuncs keyFuncsFor(ValueTypeCode vtc) {
+        switch(vtc) {
+            case ValueTypeCode::SI8:  return keyFuncs<int8_t>();
+            case ValueTypeCode::SI32: return keyFuncs<int32_t>();
+            case ValueTypeCode::SI64: return keyFuncs<int64_t>();
+            case ValueTypeCode::UI8:  return keyFuncs<uint8_t>();
+            case ValueTypeCode::UI32: return keyFuncs<uint32_t>();
+            case ValueTypeCode::UI64: return keyFuncs<uint64_t>();
+            case ValueTypeCode::F32:  return keyFuncs<float>();
+            case ValueTypeCode::F64:  return keyFuncs<double>();
+            case ValueTypeCode::STR:  return keyFuncs<std::string>();
+            default:
+                throw std::runtime_error("unsupported value type of a key column");
+        }
+    }
+
+    /**
+     * @brief The key columns of a frame, as the values and the functions of each of them.
+     */
+    struct Keys {
+        std::vector<const void *> values;
+        std::vector<KeyFuncs> funcs;
+
+        Keys(const Frame * frame, const std::vector<size_t> & keyCols) {
+            for(size_t c : keyCols) {
+                values.push_back(frame->getColumnRaw(c));
+                funcs.push_back(keyFuncsFor(frame->getColumnType(c)));
+            }
+        }
+
+        // writes the hashes of the keys of the rows from begin to end, the one of the row r at hashes[r - begin]
+        void hash(uint64_t * hashes, size_t begin, size_t end) const {
+            for(size_t k = 0; k < values.size(); k++)
+                funcs[k].hash(hashes, values[k], begin, end, k == 0);
+        }
+
+        // whether the key of the a-th row equals the key of the b-th row of other, which has the same value types
+        bool equal(size_t a, const Keys & other, size_t b) const {
+            for(size_t k = 0; k < values.size(); k++)
+                if(!funcs[k].equal(values[k], a, other.values[k], b))
+                    return false;
+            return true;
+        }
+    };
+
+    /**
+     * @brief Returns the hashes of the keys of all rows, computed in parallel chunks.
+     */
+    inline std::vector<uint64_t> hashRows(const Keys & keys, size_t numRows, DCTX(ctx)) {
+        std::vector<uint64_t> hashes(numRows);
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / CHUNK_ROWS));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t begin = numRows * chunk / numChunks;
+            keys.hash(hashes.data() + begin, begin, numRows * (chunk + 1) / numChunks);
+        });
+        return hashes;
+    }
+
+    /**
+     * @brief Builds the index on the given key columns of a frame and keeps it with the frame (see
+     * `Frame::addKeyIndex()`). The keys are hashed in parallel, and inserted in the order of the rows.
+     */
+    inline std::shared_ptr<const KeyIndex> build(const Frame * frame, const std::vector<size_t> & keyCols, DCTX(ctx)) {
+        const Keys keys(frame, keyCols);
+        const size_t numRows = frame->getNumRows();
+        const std::vector<uint64_t> hashes = hashRows(keys, numRows, ctx);
+        auto keyIndex = std::make_shared<const KeyIndex>(keyCols, hashes.data(), numRows,
+                [&](size_t a, size_t b) { return keys.equal(a, keys, b); });
+        frame->addKeyIndex(keyIndex);
+        return keyIndex;
+    }
+
+    /**
+     * @brief Recreates an index of a frame from its rows grouped by key (e.g., read from a file next to the frame),
+     * and keeps it with the frame.
+     */
+    inline void restore(const Frame * frame, std::vector<size_t> keyCols, std::vector<size_t> begins,
+            std::vector<size_t> rows) {
+        const Keys keys(frame, keyCols);
+        auto hashOfRow = [&](size_t r) {
+            uint64_t h;
+            keys.hash(&h, r, r + 1);
+            return h;
+        };
+        frame->addKeyIndex(std::make_shared<const KeyIndex>(std::move(keyCols), std::move(begins), std::move(rows),
+                hashOfRow, [&](size_t a, size_t b) { return keys.equal(a, keys, b); }));
+    }
+
+    /**
+     * @brief Returns the index on the given key columns of a frame, if the frame has one. Otherwise, the index is
+     * built and kept with the frame if indexes are enabled (see `DaphneUserConfig::key_indexes`), e.g., for the
+     * smaller input of a join, or `nullptr` is returned.
+     */
+    inline std::shared_ptr<const KeyIndex> get(const Frame * frame, const std::vector<size_t> & keyCols, DCTX(ctx)) {
+        if(auto keyIndex = frame->getKeyIndex(keyCols))
+            return keyIndex;
+        if(ctx && ctx->config.key_indexes)
+            return build(frame, keyCols, ctx);
+        return nullptr;
+    }
+
+    /**
+     * @brief Returns the key of an index on a single column with the given values which equals v, or
+     * `KeyIndex::npos`.
+     */
+    template<typename VT>
+    size_t lookup(const KeyIndex & keyIndex, const VT * values, VT v) {
+        return keyIndex.find(FlatHash<VT>()(v), [&](size_t r) { return values[r] == v; });
+    }
+}
@@ -17,13 +17,35 @@
 #pragma once
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
+#include <runtime/local/kernels/Transpose.h>
+#include <runtime/local/vectorized/BlasThreads.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
 #include <cblas.h>
 
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -43,6 +65,65 @@ void matMul(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, bool transa, boo
     MatMul<DTRes, DTLhs, DTRhs>::apply(res, lhs, rhs, transa, transb, ctx);
 }
 
+// ****************************************************************************
+// Small shapes
+// ****************************************************************************
+
+/**
+ * @brief The product of small dense operands whose shapes are only known at run-time (e.g., a chunk of a vectorized
+ * pipeline times a broadcast matrix, or the blocks of `BatchMatMul`), by loops instead of BLAS, whose call and
+ * dispatch overhead exceeds the product itself for such operands.
+ *
+ * The rows of the result are accumulated by vectorized multiply-adds of the rows of `rhs`, or by dot products of
+ * contiguous rows if `rhs` is transposed.
+ */
+namespace MatMulSmall {
+    // the multiply-adds up to which the loops are faster than a BLAS call
+    constexpr size_t MAX_WORK = 8192;
+
+    inline bool isSmall(size_t m, size_t n, size_t k) {
+        return m * n * k <= MAX_WORK;
+    }
+
+    /**
+     * @brief `res = op(lhs) @ op(rhs)` for row-major operands with an (`m` x `k`) `op(lhs)` and a (`k` x `n`)
+     * `op(rhs)`, where `op` transposes if the respective flag is set.
+     */
+    template<typename VT>
+    void gemm(size_t m, size_t n, size_t k, const VT * lhs, size_t rowSkipLhs, bool transa, const VT * rhs,
+            size_t rowSkipRhs, bool transb, VT * res, size_t rowSkipRes) {
+        for(size_t i = 0; i < m; i++) {
+            VT * rowRes = res + i * rowSkipRes;
+            if(!transb) {
+                std::fill(rowRes, rowRes + n, VT(0));
+                for(size_t l = 0; l < k; l++) {
+                    const VT a = transa ? lhs[l * rowSkipLhs + i] : lhs[i * rowSkipLhs + l];
+                    const VT * rowRhs = rhs + l * rowSkipRhs;
+                    #pragma omp simd
+                    for(size_t j = 0; j < n; j++)
+                        rowRes[j] += a * rowRhs[j];
+                }
+            }
+            else {
+                for(size_t j = 0; j < n; j++) {
+                    const VT * rowRhs = rhs + j * rowSkipRhs;
+                    VT acc = 0;
+                    if(!transa) {
+                        const VT * rowLhs = lhs + i * rowSkipLhs;
+                        #pragma omp simd reduction(+:acc)
+                        for(size_t l = 0; l < k; l++)
+                            acc += rowLhs[l] * rowRhs[l];
+                    }
+                    else
+                        for(size_t l = 0; l < k; l++)
+                            acc += lhs[l * rowSkipLhs + i] * rowRhs[l];
+                    rowRes[j] = acc;
+                }
+            }
+        }
+    }
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -54,6 +135,12 @@ void matMul(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, bool transa, boo
 template<>
 struct MatMul<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
     static void apply(DenseMatrix<float> *& res, const DenseMatrix<float> * lhs, const DenseMatrix<float> * rhs, bool transa, bool transb, DCTX(ctx)) {
+        // a lazily transposed operand is passed to BLAS as its source with the opposite transposition flag
+        if(const DenseMatrix<float> * src = lhs->getTransposedSource())
+            return apply(res, src, rhs, !transa, transb, ctx);
+        if(const DenseMatrix<float> * src = rhs->getTransposedSource())
+            return apply(res, lhs, src, transa, !transb, ctx);
+
         const auto nr1 = static_cast<int>(transa ? lhs->getNumCols() : lhs->getNumRows());
         const auto nc1 = static_cast<int>(transa ? lhs->getNumRows() : lhs->getNumCols());
         const auto nc2 = static_cast<int>(transb ? rhs->getNumRows() : rhs->getNumCols());
@@ -62,13 +149,19 @@ struct MatMul<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<float>>(nr1, nc2, false);
 
+        if(MatMulSmall::isSmall(nr1, nc2, nc1)) {
+            MatMulSmall::gemm<float>(nr1, nc2, nc1, lhs->getValues(), lhs->getRowSkip(), transa, rhs->getValues(),
+                    rhs->getRowSkip(), transb, res->getValues(), res->getRowSkip());
+            return;
+        }
+        BlasThreads::prepare(ctx);
         if(nr1 == 1 && nc2 == 1) // Vector-Vector
-            res->set(0, 0, cblas_sdot(nc1, lhs->getValues(), 1, rhs->getValues(),
-                    static_cast<int>(rhs->getRowSkip())));
+            res->set(0, 0, cblas_sdot(nc1, lhs->getValues(), transa ? static_cast<int>(lhs->getRowSkip()) : 1, rhs->getValues(),
+                    transb ? 1 : static_cast<int>(rhs->getRowSkip())));
         else if(nc2 == 1)        // Matrix-Vector
             cblas_sgemv(CblasRowMajor, transa ? CblasTrans : CblasNoTrans, lhs->getNumRows(), lhs->getNumCols(), 1, lhs->getValues(),
                 static_cast<int>(lhs->getRowSkip()), rhs->getValues(),
-                static_cast<int>(rhs->getRowSkip()), 0, res->getValues(),
+                transb ? 1 : static_cast<int>(rhs->getRowSkip()), 0, res->getValues(),
                 static_cast<int>(res->getRowSkip()));
         else                     // Matrix-Matrix
             cblas_sgemm(CblasRowMajor, transa ? CblasTrans : CblasNoTrans, transb ? CblasTrans : CblasNoTrans, nr1, nc2, nc1,
@@ -80,6 +173,12 @@ struct MatMul<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
 template<>
 struct MatMul<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>> {
     static void apply(DenseMatrix<double> *& res, const DenseMatrix<double> * lhs, const DenseMatrix<double> * rhs, bool transa, bool transb, DCTX(ctx)) {
+        // a lazily transposed operand is passed to BLAS as its source with the opposite transposition flag
+        if(const DenseMatrix<double> * src = lhs->getTransposedSource())
+            return apply(res, src, rhs, !transa, transb, ctx);
+        if(const DenseMatrix<double> * src = rhs->getTransposedSource())
+            return apply(res, lhs, src, transa, !transb, ctx);
+
         const auto nr1 = static_cast<int>(transa ? lhs->getNumCols() : lhs->getNumRows());
         const auto nc1 = static_cast<int>(transa ? lhs->getNumRows() : lhs->getNumCols());
         const auto nc2 = static_cast<int>(transb ? rhs->getNumRows() : rhs->getNumCols());
@@ -88,13 +187,19 @@ struct MatMul<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>> {
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<double>>(nr1, nc2, false);
 
+        if(MatMulSmall::isSmall(nr1, nc2, nc1)) {
+            MatMulSmall::gemm<double>(nr1, nc2, nc1, lhs->getValues(), lhs->getRowSkip(), transa, rhs->getValues(),
+                    rhs->getRowSkip(), transb, res->getValues(), res->getRowSkip());
+            return;
+        }
+        BlasThreads::prepare(ctx);
         if(nr1 == 1 && nc2 == 1) // Vector-Vector
-            res->set(0, 0, cblas_ddot(nc1, lhs->getValues(), 1, rhs->getValues(),
-                static_cast<int>(rhs->getRowSkip())));
+            res->set(0, 0, cblas_ddot(nc1, lhs->getValues(), transa ? static_cast<int>(lhs->getRowSkip()) : 1, rhs->getValues(),
+                transb ? 1 : static_cast<int>(rhs->getRowSkip())));
         else if(nc2 == 1)        // Matrix-Vector
             cblas_dgemv(CblasRowMajor, transa ? CblasTrans : CblasNoTrans, lhs->getNumRows(), lhs->getNumCols(), 1, lhs->getValues(),
                 static_cast<int>(lhs->getRowSkip()), rhs->getValues(),
-                static_cast<int>(rhs->getRowSkip()), 0, res->getValues(),
+                transb ? 1 : static_cast<int>(rhs->getRowSkip()), 0, res->getValues(),
                 static_cast<int>(res->getRowSkip()));
         else                     // Matrix-Matrix
             cblas_dgemm(CblasRowMajor, transa ? CblasTrans : CblasNoTrans, transb ? CblasTrans : CblasNoTrans, nr1, nc2, nc1,
@@ -102,3 +207,1191 @@ struct MatMul<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>> {
                 static_cast<int>(rhs->getRowSkip()), 0, res->getValues(), static_cast<int>(res->getRowSkip()));
     }
 };
+
+// ****************************************************************************
+// Sparse matrix multiplication
+// ****************************************************************************
+
+/**
+ * @brief The building blocks of the products involving CSR matrices: a row-parallel sparse-dense product (SpMM) and
+ * a Gustavson sparse-sparse product (SpGEMM), which runs a symbolic phase (counting the non-zeros of each row of the
+ * result) before the numeric one, such that the result is allocated exactly once.
+ *
+ * Products with a transposed CSR matrix `t(lhs) @ rhs` use the transposition cached by the `CSRMatrix`. Views
+ * scatter the rows of `rhs` instead of materializing `t(lhs)`: each chunk of rows of `lhs` scatters into its own partial result (as long as these take at most
+ * `MAX_PARTIAL_CELLS` cells in total), and the partial results are summed up in the end.
+ *
+ * The rows of a sparse-sparse product are accumulated in a dense array (per chunk) if the result has at most
+ * `MAX_DENSE_ACC_COLS` columns, otherwise by sorting the partial products of a row by their column.
+ */
+namespace MatMulSparse {
+    // the number of columns of a dense result accumulated at once, such that the accumulators stay in the L1 cache
+    constexpr size_t COL_BLOCK = 256;
+    // the maximum number of columns of a sparse result for dense accumulators
+    constexpr size_t MAX_DENSE_ACC_COLS = 1 << 20;
+    // the products are split into chunks of rows of at least this many multiply-adds, but at most MAX_CHUNKS
+    constexpr size_t MIN_WORK_PER_CHUNK = 1 << 16;
+    constexpr size_t MAX_CHUNKS = 256;
+    // the maximum number of cells of the partial results of a transposed product
+    constexpr size_t MAX_PARTIAL_CELLS = 1 << 22;
+
+    inline size_t getNumChunks(size_t work, size_t numRows) {
+        return std::clamp<size_t>(work / MIN_WORK_PER_CHUNK, 1, std::min(MAX_CHUNKS, std::max<size_t>(1, numRows)));
+    }
+
+    /**
+     * @brief Returns the bounds of `numChunks` chunks of the rows of a CSR matrix with about the same number of
+     * non-zeros each, i.e., chunk i spans the rows from `bounds[i]` to `bounds[i + 1]`.
+     */
+    inline std::vector<size_t> getRowChunks(const size_t * rowOffsets, size_t numRows, size_t numChunks) {
+        std::vector<size_t> bounds(numChunks + 1, numRows);
+        const size_t nnz = rowOffsets[numRows] - rowOffsets[0];
+        bounds[0] = 0;
+        for(size_t i = 1; i < numChunks; i++) {
+            const size_t target = rowOffsets[0] + nnz / numChunks * i;
+            // rows without non-zeros can go to any chunk, but the chunks must not be empty of rows due to rounding
+            const size_t row = std::lower_bound(rowOffsets, rowOffsets + numRows + 1, target) - rowOffsets;
+            bounds[i] = std::clamp(std::max(row, numRows / numChunks * i), bounds[i - 1], numRows);
+        }
+        return bounds;
+    }
+
+    /**
+     * @brief Returns `arg` or, if `trans`, its transposition in `tmp`, which the caller has to destroy.
+     */
+    template<class DT>
+    const DT * getOperand(const DT * arg, bool trans, DT *& tmp, DCTX(ctx)) {
+        if(!trans)
+            return arg;
+        transpose(tmp, arg, ctx);
+        return tmp;
+    }
+
+    /**
+     * @brief Returns `arg` or, if `trans`, its (cached) transposition, which `tmp` keeps alive.
+     */
+    template<typename VT>
+    const CSRMatrix<VT> * getOperand(const CSRMatrix<VT> * arg, bool trans,
+            std::shared_ptr<const CSRMatrix<VT>> & tmp) {
+        if(!trans)
+            return arg;
+        tmp = arg->getTransposed();
+        return tmp.get();
+    }
+
+    template<class DTLhs, class DTRhs>
+    void checkDims(const DTLhs * lhs, const DTRhs * rhs, bool transa, bool transb) {
+        if((transa ? lhs->getNumRows() : lhs->getNumCols()) != (transb ? rhs->getNumCols() : rhs->getNumRows()))
+            throw std::runtime_error("MatMul: #cols of lhs and #rows of rhs must be the same");
+    }
+
+    /**
+     * @brief `res = lhs @ rhs` for a CSR `lhs` with the given column indexes (of type `size_t` or, compacted,
+     * `uint32_t`), in parallel chunks of rows with about the same number of non-zeros.
+     */
+    template<typename VT, typename IT>
+    void spmm(DenseMatrix<VT> * res, const CSRMatrix<VT> * lhs, const IT * colIdxsLhs, const DenseMatrix<VT> * rhs,
+            DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = rhs->getNumCols();
+        const VT * valuesLhs = lhs->getValues();
+        const size_t * rowOffsetsLhs = lhs->getRowOffsets();
+        const VT * valuesRhs = rhs->getValues();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        const size_t work = (lhs->getNumNonZeros() + numRows) * numCols;
+        const auto bounds = getRowChunks(rowOffsetsLhs, numRows, getNumChunks(work, numRows));
+        WorkerPool::parallelFor(ctx, bounds.size() - 1, [&](size_t i) {
+            if(numCols == 1) {
+                // a sparse dot product per row
+                for(size_t r = bounds[i]; r < bounds[i + 1]; r++) {
+                    VT acc = 0;
+                    for(size_t k = rowOffsetsLhs[r]; k < rowOffsetsLhs[r + 1]; k++)
+                        acc += valuesLhs[k] * valuesRhs[colIdxsLhs[k] * rowSkipRhs];
+                    valuesRes[r * rowSkipRes] = acc;
+                }
+                return;
+            }
+            VT acc[COL_BLOCK];
+            for(size_t r = bounds[i]; r < bounds[i + 1]; r++) {
+                for(size_t c0 = 0; c0 < numCols; c0 += COL_BLOCK) {
+                    const size_t width = std::min(COL_BLOCK, numCols - c0);
+                    std::fill(acc, acc + width, VT(0));
+                    for(size_t k = rowOffsetsLhs[r]; k < rowOffsetsLhs[r + 1]; k++) {
+                        const VT v = valuesLhs[k];
+                        const VT * rowRhs = valuesRhs + colIdxsLhs[k] * rowSkipRhs + c0;
+                        #pragma omp simd
+                        for(size_t c = 0; c < width; c++)
+                            acc[c] += v * rowRhs[c];
+                    }
+                    std::copy(acc, acc + width, valuesRes + r * rowSkipRes + c0);
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Computes the dot products of the `C` rows of a slice of a SELL-C-sigma matrix (see `SellCSigma`) with
+     * `x`, one row per SIMD lane. The padding of shorter rows is masked out, such that it does not read `x`.
+     */
+    template<typename VT>
+    inline void sellSliceGeneric(const VT * values, const uint32_t * colIdxs, const uint32_t * rowLengths,
+            size_t width, const VT * x, size_t xSkip, VT * acc) {
+        constexpr size_t C = SellCSigma<VT>::C;
+        std::fill(acc, acc + C, VT(0));
+        for(size_t j = 0; j < width; j++) {
+            #pragma omp simd
+            for(size_t l = 0; l < C; l++)
+                acc[l] += values[j * C + l] * (j < rowLengths[l] ? x[colIdxs[j * C + l] * xSkip] : VT(0));
+        }
+    }
+
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+    DAPHNE_TARGET_AVX512 inline void sellSliceAvx512(const double * values, const uint32_t * colIdxs,
+            const uint32_t * rowLengths, size_t width, const double * x, double * acc) {
+        const __m256i lengths = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rowLengths));
+        __m512d sum = _mm512_setzero_pd();
+        for(size_t j = 0; j < width; j++) {
+            const __mmask8 mask = static_cast<__mmask8>(_mm256_movemask_ps(_mm256_castsi256_ps(
+                    _mm256_cmpgt_epi32(lengths, _mm256_set1_epi32(static_cast<int>(j))))));
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(colIdxs + j * 8));
+            const __m512d xs = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, idx, x, 8);
+            sum = _mm512_fmadd_pd(_mm512_loadu_pd(values + j * 8), xs, sum);
+        }
+        _mm512_storeu_pd(acc, sum);
+    }
+
+    DAPHNE_TARGET_AVX2 inline void sellSliceAvx2(const double * values, const uint32_t * colIdxs,
+            const uint32_t * rowLengths, size_t width, const double * x, double * acc) {
+        const __m128i lengths0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rowLengths));
+        const __m128i lengths1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rowLengths + 4));
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        for(size_t j = 0; j < width; j++) {
+            const __m128i js = _mm_set1_epi32(static_cast<int>(j));
+            const __m256d mask0 = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(lengths0, js)));
+            const __m256d mask1 = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(lengths1, js)));
+            const __m128i idx0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(colIdxs + j * 8));
+            const __m128i idx1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(colIdxs + j * 8 + 4));
+            const __m256d xs0 = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, idx0, mask0, 8);
+            const __m256d xs1 = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, idx1, mask1, 8);
+            sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(_mm256_loadu_pd(values + j * 8), xs0));
+            sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(_mm256_loadu_pd(values + j * 8 + 4), xs1));
+        }
+        _mm256_storeu_pd(acc, sum0);
+        _mm256_storeu_pd(acc + 4, sum1);
+    }
+
+    DAPHNE_TARGET_AVX2 inline void sellSliceAvx2(const float * values, const uint32_t * colIdxs,
+            const uint32_t * rowLengths, size_t width, const float * x, float * acc) {
+        const __m256i lengths = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rowLengths));
+        __m256 sum = _mm256_setzero_ps();
+        for(size_t j = 0; j < width; j++) {
+            const __m256 mask = _mm256_castsi256_ps(
+                    _mm256_cmpgt_epi32(lengths, _mm256_set1_epi32(static_cast<int>(j))));
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(colIdxs + j * 8));
+            const __m256 xs = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x, idx, mask, 4);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(values + j * 8), xs));
+        }
+        _mm256_storeu_ps(acc, sum);
+    }
+#endif
+
+    /**
+     * @brief `sellSliceGeneric()` with the gathers of the given instruction set (for a contiguous `x`).
+     */
+    template<CpuIsa isa, typename VT>
+    inline void sellSlice(const VT * values, const uint32_t * colIdxs, const uint32_t * rowLengths, size_t width,
+            const VT * x, size_t xSkip, VT * acc) {
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+        if(xSkip == 1) {
+            if constexpr(std::is_same<VT, double>::value && CpuDispatch::includes(isa, CpuIsa::AVX512)) {
+                sellSliceAvx512(values, colIdxs, rowLengths, width, x, acc);
+                return;
+            }
+            else if constexpr((std::is_same<VT, double>::value || std::is_same<VT, float>::value)
+                    && CpuDispatch::includes(isa, CpuIsa::AVX2)) {
+                sellSliceAvx2(values, colIdxs, rowLengths, width, x, acc);
+                return;
+            }
+        }
+#endif
+        sellSliceGeneric(values, colIdxs, rowLengths, width, x, xSkip, acc);
+    }
+
+    /**
+     * @brief `res = lhs @ rhs` for a SELL-C-sigma `lhs` and a single-column `rhs`, in parallel chunks of slices.
+     */
+    template<typename VT>
+    void spmvSell(DenseMatrix<VT> * res, const SellCSigma<VT> & lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
+        constexpr size_t C = SellCSigma<VT>::C;
+        const VT * x = rhs->getValues();
+        const size_t xSkip = rhs->getRowSkip();
+        VT * y = res->getValues();
+        const size_t ySkip = res->getRowSkip();
+
+        const size_t numChunks = getNumChunks(lhs.values.size() + lhs.numRows, lhs.numSlices);
+        const size_t slicesPerChunk = (lhs.numSlices + numChunks - 1) / numChunks;
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            VT acc[C];
+            const size_t end = std::min(lhs.numSlices, (i + 1) * slicesPerChunk);
+            CpuDispatch::run("matMul (SpMV)", [&](auto isa) {
+                for(size_t s = i * slicesPerChunk; s < end; s++) {
+                    const size_t pos = lhs.sliceOffsets[s];
+                    sellSlice<decltype(isa)::value>(lhs.values.data() + pos, lhs.colIdxs.data() + pos,
+                            lhs.rowLengths.data() + s * C, (lhs.sliceOffsets[s + 1] - pos) / C, x, xSkip, acc);
+                    for(size_t l = 0; l < C; l++)
+                        if(lhs.rows[s * C + l] < lhs.numRows)
+                            y[lhs.rows[s * C + l] * ySkip] = acc[l];
+                }
+            });
+        });
+    }
+
+    /**
+     * @brief `res = lhs @ rhs` for a CSR `lhs`. A single-column `rhs` is multiplied with the SELL-C-sigma
+     * representation of `lhs` if it has one (see `CSRMatrix::getSell()`), otherwise, the column indexes of `lhs` are
+     * read in 32 bits if it has a compact copy of them (see `CSRMatrix::getCompactColIdxs()`). Both are built when
+     * the same matrix is multiplied repeatedly.
+     */
+    template<typename VT>
+    void spmm(DenseMatrix<VT> * res, const CSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
+        if(rhs->getNumCols() == 1)
+            if(auto sell = lhs->getSell()) {
+                spmvSell(res, *sell, rhs, ctx);
+                return;
+            }
+        if(auto compact = lhs->getCompactColIdxs())
+            spmm(res, lhs, compact.get(), rhs, ctx);
+        else
+            spmm(res, lhs, lhs->getColIdxs(), rhs, ctx);
+    }
+
+    /**
+     * @brief `res = t(lhs) @ rhs` for a CSR `lhs`, scattering the rows of `rhs` scaled by the non-zeros of the
+     * corresponding rows of `lhs`, in parallel chunks with partial results.
+     */
+    template<typename VT>
+    void spmmT(DenseMatrix<VT> * res, const CSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numRowsRes = lhs->getNumCols();
+        const size_t numCols = rhs->getNumCols();
+        const VT * valuesLhs = lhs->getValues();
+        const size_t * colIdxsLhs = lhs->getColIdxs();
+        const size_t * rowOffsetsLhs = lhs->getRowOffsets();
+        const VT * valuesRhs = rhs->getValues();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        const size_t numCellsRes = numRowsRes * numCols;
+        const size_t work = (lhs->getNumNonZeros() + numRows) * numCols;
+        const size_t numChunks = std::min(getNumChunks(work, numRows),
+                std::max<size_t>(1, MAX_PARTIAL_CELLS / std::max<size_t>(1, numCellsRes)));
+        const auto bounds = getRowChunks(rowOffsetsLhs, numRows, numChunks);
+
+        for(size_t r = 0; r < numRowsRes; r++)
+            std::fill(valuesRes + r * rowSkipRes, valuesRes + r * rowSkipRes + numCols, VT(0));
+        // the first chunk scatters into the result directly
+        std::vector<VT> partials((numChunks - 1) * numCellsRes, VT(0));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            VT * dst = i ? partials.data() + (i - 1) * numCellsRes : valuesRes;
+            const size_t rowSkipDst = i ? numCols : rowSkipRes;
+            for(size_t r = bounds[i]; r < bounds[i + 1]; r++) {
+                const VT * rowRhs = valuesRhs + r * rowSkipRhs;
+                for(size_t k = rowOffsetsLhs[r]; k < rowOffsetsLhs[r + 1]; k++) {
+                    const VT v = valuesLhs[k];
+                    VT * rowDst = dst + colIdxsLhs[k] * rowSkipDst;
+                    #pragma omp simd
+                    for(size_t c = 0; c < numCols; c++)
+                        rowDst[c] += v * rowRhs[c];
+                }
+            }
+        });
+        if(numChunks == 1)
+            return;
+
+        // sums up the partial results in parallel chunks of rows of the result
+        const size_t numReduceChunks = getNumChunks(numChunks * numCellsRes, numRowsRes);
+        WorkerPool::parallelFor(ctx, numReduceChunks, [&](size_t i) {
+            const size_t rowsPerChunk = (numRowsRes + numReduceChunks - 1) / numReduceChunks;
+            const size_t end = std::min(numRowsRes, (i + 1) * rowsPerChunk);
+            for(size_t r = i * rowsPerChunk; r < end; r++) {
+                VT * rowRes = valuesRes + r * rowSkipRes;
+                for(size_t p = 0; p < numChunks - 1; p++) {
+                    const VT * rowPartial = partials.data() + p * numCellsRes + r * numCols;
+                    #pragma omp simd
+                    for(size_t c = 0; c < numCols; c++)
+                        rowRes[c] += rowPartial[c];
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief `res = t(lhs) @ rhs` or `res = lhs @ rhs` for a CSR `lhs`. The transposed product uses the cached
+     * transposition of `lhs`, which is built on the first use, except for views, which scatter instead (views are
+     * typically short-lived, such that building their transposition would not pay off).
+     */
+    template<typename VT>
+    void spmmMaybeT(DenseMatrix<VT> * res, const CSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, bool transa,
+            DCTX(ctx)) {
+        if(!transa)
+            spmm(res, lhs, rhs, ctx);
+        else if(lhs->isView())
+            spmmT(res, lhs, rhs, ctx);
+        else
+            spmm(res, lhs->getTransposed().get(), rhs, ctx);
+    }
+
+    /**
+     * @brief `res = lhs @ rhs` for a CSR `rhs`, in parallel chunks of rows, scattering the rows of `rhs` scaled by
+     * the non-zeros of a row of `lhs`.
+     */
+    template<typename VT>
+    void dmspm(DenseMatrix<VT> * res, const DenseMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numInner = lhs->getNumCols();
+        const size_t numCols = rhs->getNumCols();
+        const VT * valuesLhs = lhs->getValues();
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        const VT * valuesRhs = rhs->getValues();
+        const size_t * colIdxsRhs = rhs->getColIdxs();
+        const size_t * rowOffsetsRhs = rhs->getRowOffsets();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        const size_t numChunks = getNumChunks(numRows * (numInner + rhs->getNumNonZeros() + numCols), numRows);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const size_t rowsPerChunk = (numRows + numChunks - 1) / numChunks;
+            const size_t end = std::min(numRows, (i + 1) * rowsPerChunk);
+            for(size_t r = i * rowsPerChunk; r < end; r++) {
+                const VT * rowLhs = valuesLhs + r * rowSkipLhs;
+                VT * rowRes = valuesRes + r * rowSkipRes;
+                std::fill(rowRes, rowRes + numCols, VT(0));
+                for(size_t j = 0; j < numInner; j++) {
+                    const VT v = rowLhs[j];
+                    if(v == VT(0))
+                        continue;
+                    for(size_t k = rowOffsetsRhs[j]; k < rowOffsetsRhs[j + 1]; k++)
+                        rowRes[colIdxsRhs[k]] += v * valuesRhs[k];
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Accumulates the rows of a sparse-sparse product, in a dense array of `numCols` columns (if not too
+     * many) or by sorting the partial products. One accumulator serves the rows of one chunk.
+     */
+    template<typename VT>
+    class RowAccumulator {
+        const bool dense;
+        // the last row which touched a column, and the accumulated value of that column
+        std::vector<size_t> marker;
+        std::vector<VT> acc;
+        std::vector<size_t> touched;
+        std::vector<std::pair<size_t, VT>> products;
+
+    public:
+        explicit RowAccumulator(size_t numCols) : dense(numCols <= MAX_DENSE_ACC_COLS) {
+            if(dense) {
+                marker.resize(numCols, std::numeric_limits<size_t>::max());
+                acc.resize(numCols);
+            }
+        }
+
+        /**
+         * @brief Accumulates row `r` of `lhs @ rhs` and, if `colIdxsRes` is not `nullptr`, writes its non-zeros
+         * there (sorted by column) and into `valuesRes`.
+         *
+         * @return The number of non-zeros of the row.
+         */
+        size_t apply(size_t r, const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, VT * valuesRes,
+                size_t * colIdxsRes) {
+            const VT * valuesLhs = lhs->getValues();
+            const size_t * colIdxsLhs = lhs->getColIdxs();
+            const size_t * rowOffsetsLhs = lhs->getRowOffsets();
+            const VT * valuesRhs = rhs->getValues();
+            const size_t * colIdxsRhs = rhs->getColIdxs();
+            const size_t * rowOffsetsRhs = rhs->getRowOffsets();
+            const bool numeric = colIdxsRes != nullptr;
+
+            if(dense) {
+                touched.clear();
+                for(size_t k = rowOffsetsLhs[r]; k < rowOffsetsLhs[r + 1]; k++) {
+                    const size_t j = colIdxsLhs[k];
+                    const VT v = valuesLhs[k];
+                    for(size_t l = rowOffsetsRhs[j]; l < rowOffsetsRhs[j + 1]; l++) {
+                        const size_t c = colIdxsRhs[l];
+                        if(marker[c] != r) {
+                            marker[c] = r;
+                            touched.push_back(c);
+                            if(numeric)
+                                acc[c] = v * valuesRhs[l];
+                        }
+                        else if(numeric)
+                            acc[c] += v * valuesRhs[l];
+                    }
+                }
+                if(numeric) {
+                    std::sort(touched.begin(), touched.end());
+                    for(size_t i = 0; i < touched.size(); i++) {
+                        colIdxsRes[i] = touched[i];
+                        valuesRes[i] = acc[touched[i]];
+                    }
+                }
+                return touched.size();
+            }
+
+            products.clear();
+            for(size_t k = rowOffsetsLhs[r]; k < rowOffsetsLhs[r + 1]; k++) {
+                const size_t j = colIdxsLhs[k];
+                for(size_t l = rowOffsetsRhs[j]; l < rowOffsetsRhs[j + 1]; l++)
+                    products.emplace_back(colIdxsRhs[l], numeric ? valuesLhs[k] * valuesRhs[l] : VT(0));
+            }
+            std::sort(products.begin(), products.end(),
+                    [](const auto & a, const auto & b) { return a.first < b.first; });
+            size_t nnz = 0;
+            for(size_t i = 0; i < products.size(); i++) {
+                if(i > 0 && products[i].first == products[i - 1].first) {
+                    if(numeric)
+                        valuesRes[nnz - 1] += products[i].second;
+                    continue;
+                }
+                if(numeric) {
+                    colIdxsRes[nnz] = products[i].first;
+                    valuesRes[nnz] = products[i].second;
+                }
+                nnz++;
+            }
+            return nnz;
+        }
+    };
+
+    /**
+     * @brief Returns `lhs @ rhs` for CSR matrices by Gustavson's algorithm: a parallel symbolic phase counts the
+     * non-zeros of each row of the result, a parallel numeric phase writes them. The result holds all structural
+     * non-zeros, i.e., also products that cancel out to zero.
+     */
+    template<typename VT>
+    CSRMatrix<VT> * spgemm(const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = rhs->getNumCols();
+        const size_t * rowOffsetsLhs = lhs->getRowOffsets();
+
+        const size_t work = lhs->getNumNonZeros() * std::max<size_t>(1, rhs->getNumNonZeros() /
+                std::max<size_t>(1, rhs->getNumRows())) + numRows;
+        const auto bounds = getRowChunks(rowOffsetsLhs, numRows, getNumChunks(work, numRows));
+        const size_t numChunks = bounds.size() - 1;
+
+        std::vector<size_t> rowOffsets(numRows + 1, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            RowAccumulator<VT> acc(numCols);
+            for(size_t r = bounds[i]; r < bounds[i + 1]; r++)
+                rowOffsets[r + 1] = acc.apply(r, lhs, rhs, nullptr, nullptr);
+        });
+        for(size_t r = 0; r < numRows; r++)
+            rowOffsets[r + 1] += rowOffsets[r];
+
+        auto res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, rowOffsets[numRows], false);
+        std::copy(rowOffsets.begin(), rowOffsets.end(), res->getRowOffsets());
+        VT * valuesRes = res->getValues();
+        size_t * colIdxsRes = res->getColIdxs();
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            RowAccumulator<VT> acc(numCols);
+            for(size_t r = bounds[i]; r < bounds[i + 1]; r++)
+                acc.apply(r, lhs, rhs, valuesRes + rowOffsets[r], colIdxsRes + rowOffsets[r]);
+        });
+        return res;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CSRMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const CSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, bool transa,
+            bool transb, DCTX(ctx)) {
+        MatMulSparse::checkDims(lhs, rhs, transa, transb);
+        DenseMatrix<VT> * rhsT = nullptr;
+        const DenseMatrix<VT> * b = MatMulSparse::getOperand(rhs, transb, rhsT, ctx);
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(transa ? lhs->getNumCols() : lhs->getNumRows(),
+                    b->getNumCols(), false);
+        MatMulSparse::spmmMaybeT(res, lhs, b, transa, ctx);
+
+        if(rhsT)
+            DataObjectFactory::destroy(rhsT);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix, CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrix<VT>, DenseMatrix<VT>, CSRMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, bool transa,
+            bool transb, DCTX(ctx)) {
+        MatMulSparse::checkDims(lhs, rhs, transa, transb);
+        DenseMatrix<VT> * lhsT = nullptr;
+        std::shared_ptr<const CSRMatrix<VT>> rhsT;
+        const DenseMatrix<VT> * a = MatMulSparse::getOperand(lhs, transa, lhsT, ctx);
+        const CSRMatrix<VT> * b = MatMulSparse::getOperand(rhs, transb, rhsT);
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(a->getNumRows(), b->getNumCols(), false);
+        MatMulSparse::dmspm(res, a, b, ctx);
+
+        if(lhsT)
+            DataObjectFactory::destroy(lhsT);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CSRMatrix <- CSRMatrix, CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<CSRMatrix<VT>, CSRMatrix<VT>, CSRMatrix<VT>> {
+    static void apply(CSRMatrix<VT> *& res, const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, bool transa,
+            bool transb, DCTX(ctx)) {
+        MatMulSparse::checkDims(lhs, rhs, transa, transb);
+        // the number of non-zeros is only known after the symbolic phase
+        if(res != nullptr)
+            throw std::runtime_error("MatMul: the result of a sparse-sparse product must not be pre-allocated");
+        std::shared_ptr<const CSRMatrix<VT>> lhsT, rhsT;
+        const CSRMatrix<VT> * a = MatMulSparse::getOperand(lhs, transa, lhsT);
+        const CSRMatrix<VT> * b = MatMulSparse::getOperand(rhs, transb, rhsT);
+
+        res = MatMulSparse::spgemm(a, b, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DCSRMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrix<VT>, DCSRMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DCSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, bool transa,
+            bool transb, DCTX(ctx)) {
+        MatMulSparse::checkDims(lhs, rhs, transa, transb);
+        DCSRMatrix<VT> * lhsT = nullptr;
+        DenseMatrix<VT> * rhsT = nullptr;
+        const DCSRMatrix<VT> * a = MatMulSparse::getOperand(lhs, transa, lhsT, ctx);
+        const DenseMatrix<VT> * b = MatMulSparse::getOperand(rhs, transb, rhsT, ctx);
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(a->getNumRows(), b->getNumCols(), false);
+        spmm(res, a, b, ctx);
+
+        if(lhsT)
+            DataObjectFactory::destroy(lhsT);
+        if(rhsT)
+            DataObjectFactory::destroy(rhsT);
+    }
+
+private:
+    /**
+     * @brief Like `MatMulSparse::spmm()`, but the chunks span only the rows of `lhs` with non-zeros, the other rows of
+     * the result are zero.
+     */
+    static void spmm(DenseMatrix<VT> * res, const DCSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const size_t numNonZeroRows = lhs->getNumNonZeroRows();
+        const size_t numCols = rhs->getNumCols();
+        const size_t * rowIdxsLhs = lhs->getRowIdxs();
+        const size_t * rowOffsetsLhs = lhs->getRowOffsets();
+        const size_t * colIdxsLhs = lhs->getColIdxs();
+        const VT * valuesLhs = lhs->getValues();
+        const VT * valuesRhs = rhs->getValues();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        for(size_t r = 0; r < numRows; r++)
+            std::fill(valuesRes + r * rowSkipRes, valuesRes + r * rowSkipRes + numCols, VT(0));
+        if(numNonZeroRows == 0)
+            return;
+
+        const size_t work = (lhs->getNumNonZeros() + numNonZeroRows) * numCols;
+        const auto bounds = MatMulSparse::getRowChunks(rowOffsetsLhs, numNonZeroRows,
+                MatMulSparse::getNumChunks(work, numNonZeroRows));
+        WorkerPool::parallelFor(ctx, bounds.size() - 1, [&](size_t i) {
+            for(size_t j = bounds[i]; j < bounds[i + 1]; j++) {
+                VT * rowRes = valuesRes + rowIdxsLhs[j] * rowSkipRes;
+                for(size_t k = rowOffsetsLhs[j]; k < rowOffsetsLhs[j + 1]; k++) {
+                    const VT v = valuesLhs[k];
+                    const VT * rowRhs = valuesRhs + colIdxsLhs[k] * rowSkipRhs;
+                    #pragma omp simd
+                    for(size_t c = 0; c < numCols; c++)
+                        rowRes[c] += v * rowRhs[c];
+                }
+            }
+        });
+    }
+};
+
+// ****************************************************************************
+// Compressed matrix multiplication
+// ****************************************************************************
+
+/**
+ * @brief The building blocks of the products of a `CompressedMatrix` with dense matrices, which work on the
+ * dictionaries of the column groups instead of the decompressed values.
+ *
+ * A right multiplication `X @ B` multiplies each tuple of a dictionary with the rows of `B` of its columns once, and
+ * adds these products to the rows of the result mapped to the tuple. A left multiplication `W @ X` sums up the
+ * columns of `W` per tuple, and multiplies these sums with the tuples once. The dense operands and the result are
+ * given by strides, such that transposed operands need not be materialized.
+ */
+namespace MatMulCompressed {
+    // the uncompressed columns are multiplied from the left in blocks of this many columns
+    constexpr size_t UNCOMPRESSED_COL_BLOCK = 64;
+
+    /**
+     * @brief A dense matrix accessed by strides, i.e., element (i, j) is at `values[i * strideI + j * strideJ]`.
+     */
+    template<typename T>
+    struct Strided {
+        T * values;
+        size_t strideI;
+        size_t strideJ;
+
+        T & operator()(size_t i, size_t j) const {
+            return values[i * strideI + j * strideJ];
+        }
+    };
+
+    /**
+     * @brief `res = lhs @ rhs` for a `rhs` with `n` columns, in parallel chunks of rows.
+     */
+    template<typename VT>
+    void rightMult(Strided<VT> res, const CompressedMatrix<VT> * lhs, Strided<const VT> rhs, size_t n, DCTX(ctx)) {
+        const size_t numRows = lhs->getNumRows();
+        const auto & groups = lhs->getColGroups();
+
+        // The products of the tuples (followed by the default tuple) of each group with rhs. The rows listed for a
+        // tuple add its difference to the default tuple, which all rows add (if it is not zero).
+        std::vector<std::vector<VT>> pre(groups.size());
+        std::vector<bool> addsDefault(groups.size(), false);
+        for(size_t g = 0; g < groups.size(); g++) {
+            const ColGroup<VT> & group = groups[g];
+            if(group.encoding == ColGroupEncoding::UNCOMPRESSED)
+                continue;
+            const size_t numTuples = group.getNumTuples();
+            pre[g].assign((numTuples + 1) * n, VT(0));
+            for(size_t t = 0; t < numTuples + !group.defaultTuple.empty(); t++) {
+                const VT * tuple = t < numTuples ? group.getTuple(t) : group.defaultTuple.data();
+                for(size_t i = 0; i < group.getNumCols(); i++)
+                    if(tuple[i] != VT(0))
+                        for(size_t j = 0; j < n; j++)
+                            pre[g][t * n + j] += tuple[i] * rhs(group.colIdxs[i], j);
+            }
+            const VT * preDefault = pre[g].data() + numTuples * n;
+            addsDefault[g] = std::any_of(preDefault, preDefault + n, [](VT v) { return v != VT(0); });
+            if(addsDefault[g])
+                for(size_t t = 0; t < numTuples; t++)
+                    for(size_t j = 0; j < n; j++)
+                        pre[g][t * n + j] -= preDefault[j];
+        }
+
+        const size_t numChunks = MatMulSparse::getNumChunks(numRows * (groups.size() + 1) * n, numRows);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t c) {
+            const size_t rowBegin = numRows * c / numChunks;
+            const size_t rowEnd = numRows * (c + 1) / numChunks;
+            auto addRow = [&](size_t r, const VT * v) {
+                for(size_t j = 0; j < n; j++)
+                    res(r, j) += v[j];
+            };
+            for(size_t r = rowBegin; r < rowEnd; r++)
+                for(size_t j = 0; j < n; j++)
+                    res(r, j) = VT(0);
+            for(size_t g = 0; g < groups.size(); g++) {
+                const ColGroup<VT> & group = groups[g];
+                const VT * preG = pre[g].data();
+                switch(group.encoding) {
+                    case ColGroupEncoding::UNCOMPRESSED: {
+                        const size_t numCols = group.getNumCols();
+                        for(size_t r = rowBegin; r < rowEnd; r++) {
+                            const VT * row = group.values.data() + r * numCols;
+                            for(size_t i = 0; i < numCols; i++)
+                                if(row[i] != VT(0))
+                                    for(size_t j = 0; j < n; j++)
+                                        res(r, j) += row[i] * rhs(group.colIdxs[i], j);
+                        }
+                        break;
+                    }
+                    case ColGroupEncoding::DDC: {
+                        const uint8_t * codes = group.mapping->codes.data();
+                        for(size_t r = rowBegin; r < rowEnd; r++)
+                            addRow(r, preG + codes[r] * n);
+                        break;
+                    }
+                    default: {
+                        const size_t numTuples = group.getNumTuples();
+                        if(addsDefault[g])
+                            for(size_t r = rowBegin; r < rowEnd; r++)
+                                addRow(r, preG + numTuples * n);
+                        for(size_t t = 0; t < numTuples; t++)
+                            group.forEachRange(t, rowBegin, rowEnd, [&](size_t begin, size_t end) {
+                                for(size_t r = begin; r < end; r++)
+                                    addRow(r, preG + t * n);
+                            });
+                    }
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief `res = lhs @ rhs` for a `lhs` with `m` rows, in parallel over the column groups (and blocks of the
+     * uncompressed columns), which yield disjoint columns of the result.
+     */
+    template<typename VT>
+    void leftMult(Strided<VT> res, Strided<const VT> lhs, size_t m, const CompressedMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t numRows = rhs->getNumRows();
+        const auto & groups = rhs->getColGroups();
+
+        // a task is a group and a range of its columns
+        std::vector<std::tuple<size_t, size_t, size_t>> tasks;
+        for(size_t g = 0; g < groups.size(); g++) {
+            const size_t numCols = groups[g].getNumCols();
+            const size_t block = groups[g].encoding == ColGroupEncoding::UNCOMPRESSED ? UNCOMPRESSED_COL_BLOCK : numCols;
+            for(size_t i = 0; i < numCols; i += block)
+                tasks.emplace_back(g, i, std::min(i + block, numCols));
+        }
+
+        WorkerPool::parallelFor(ctx, tasks.size(), [&](size_t k) {
+            const auto [g, colBegin, colEnd] = tasks[k];
+            const ColGroup<VT> & group = groups[g];
+            const size_t numCols = group.getNumCols();
+
+            if(group.encoding == ColGroupEncoding::UNCOMPRESSED) {
+                std::vector<VT> sums((colEnd - colBegin) * m, VT(0));
+                for(size_t r = 0; r < numRows; r++) {
+                    const VT * row = group.values.data() + r * numCols;
+                    for(size_t i = colBegin; i < colEnd; i++)
+                        if(row[i] != VT(0))
+                            for(size_t l = 0; l < m; l++)
+                                sums[(i - colBegin) * m + l] += row[i] * lhs(l, r);
+                }
+                for(size_t i = colBegin; i < colEnd; i++)
+                    for(size_t l = 0; l < m; l++)
+                        res(l, group.colIdxs[i]) = sums[(i - colBegin) * m + l];
+                return;
+            }
+
+            // the sums of the columns of lhs per tuple, followed by those of the default tuple
+            const size_t numTuples = group.getNumTuples();
+            std::vector<VT> sums((numTuples + 1) * m, VT(0));
+            if(group.encoding == ColGroupEncoding::DDC) {
+                const uint8_t * codes = group.mapping->codes.data();
+                for(size_t r = 0; r < numRows; r++)
+                    for(size_t l = 0; l < m; l++)
+                        sums[codes[r] * m + l] += lhs(l, r);
+            }
+            else {
+                for(size_t t = 0; t < numTuples; t++)
+                    group.forEachRange(t, 0, numRows, [&](size_t begin, size_t end) {
+                        for(size_t r = begin; r < end; r++)
+                            for(size_t l = 0; l < m; l++)
+                                sums[t * m + l] += lhs(l, r);
+                    });
+                // the rows which are not listed have the default tuple
+                VT * sumsDefault = sums.data() + numTuples * m;
+                for(size_t r = 0; r < numRows; r++)
+                    for(size_t l = 0; l < m; l++)
+                        sumsDefault[l] += lhs(l, r);
+                for(size_t t = 0; t < numTuples; t++)
+                    for(size_t l = 0; l < m; l++)
+                        sumsDefault[l] -= sums[t * m + l];
+            }
+
+            for(size_t i = 0; i < numCols; i++)
+                for(size_t l = 0; l < m; l++) {
+                    VT v = group.defaultTuple.empty() ? VT(0) : sums[numTuples * m + l] * group.defaultTuple[i];
+                    for(size_t t = 0; t < numTuples; t++)
+                        v += sums[t * m + l] * group.getTuple(t)[i];
+                    res(l, group.colIdxs[i]) = v;
+                }
+        });
+    }
+}
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CompressedMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrix<VT>, CompressedMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const CompressedMatrix<VT> * lhs, const DenseMatrix<VT> * rhs,
+            bool transa, bool transb, DCTX(ctx)) {
+        MatMulSparse::checkDims(lhs, rhs, transa, transb);
+        const size_t n = transb ? rhs->getNumRows() : rhs->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(transa ? lhs->getNumCols() : lhs->getNumRows(), n, false);
+
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+        if(!transa)
+            MatMulCompressed::rightMult<VT>({res->getValues(), rowSkipRes, 1}, lhs,
+                    {rhs->getValues(), transb ? 1 : rowSkipRhs, transb ? rowSkipRhs : 1}, n, ctx);
+        else
+            // t(lhs) @ rhs = t(t(rhs) @ lhs)
+            MatMulCompressed::leftMult<VT>({res->getValues(), 1, rowSkipRes},
+                    {rhs->getValues(), transb ? rowSkipRhs : 1, transb ? 1 : rowSkipRhs}, n, lhs, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix, CompressedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrix<VT>, DenseMatrix<VT>, CompressedMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const CompressedMatrix<VT> * rhs,
+            bool transa, bool transb, DCTX(ctx)) {
+        MatMulSparse::checkDims(lhs, rhs, transa, transb);
+        const size_t m = transa ? lhs->getNumCols() : lhs->getNumRows();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(m, transb ? rhs->getNumRows() : rhs->getNumCols(), false);
+
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+        if(!transb)
+            MatMulCompressed::leftMult<VT>({res->getValues(), rowSkipRes, 1},
+                    {lhs->getValues(), transa ? 1 : rowSkipLhs, transa ? rowSkipLhs : 1}, m, rhs, ctx);
+        else
+            // lhs @ t(rhs) = t(rhs @ t(lhs))
+            MatMulCompressed::rightMult<VT>({res->getValues(), 1, rowSkipRes}, rhs,
+                    {lhs->getValues(), transa ? rowSkipLhs : 1, transa ? 1 : rowSkipLhs}, m, ctx);
+    }
+};
+
+// ****************************************************************************
+// Column-major matrix multiplication
+// ****************************************************************************
+
+/**
+ * @brief The products involving a `DenseMatrixCM`, which call BLAS with `CblasColMajor`.
+ *
+ * A row-major `DenseMatrix` is the transposed of a column-major matrix with its row skip as the leading dimension, so
+ * it is passed to BLAS with the opposite transposition flag instead of being transposed. The result is column-major.
+ */
+namespace MatMulColMajor {
+    /**
+     * @brief An operand of a column-major product, i.e., element (i, j) of the stored (not transposed) matrix is at
+     * `values[i + j * ld]`.
+     */
+    template<typename VT>
+    struct Operand {
+        const VT * values;
+        size_t ld;
+        bool trans;
+
+        VT operator()(size_t i, size_t j) const {
+            return trans ? values[j + i * ld] : values[i + j * ld];
+        }
+    };
+
+    template<typename VT>
+    Operand<VT> operandOf(const DenseMatrixCM<VT> * arg, bool trans) {
+        return {arg->getValues(), std::max<size_t>(arg->getColSkip(), 1), trans};
+    }
+
+    template<typename VT>
+    Operand<VT> operandOf(const DenseMatrix<VT> * arg, bool trans) {
+        return {arg->getValues(), std::max<size_t>(arg->getRowSkip(), 1), !trans};
+    }
+
+    /**
+     * @brief `res = lhs @ rhs` for an `m x k` lhs and a `k x n` rhs (after their transpositions), by BLAS for
+     * floating-point values and in parallel columns of the result otherwise.
+     */
+    template<typename VT>
+    void gemm(DenseMatrixCM<VT> * res, size_t m, size_t n, size_t k, Operand<VT> lhs, Operand<VT> rhs, DCTX(ctx)) {
+        VT * valuesRes = res->getValues();
+        const size_t ldRes = std::max<size_t>(res->getColSkip(), 1);
+        BlasThreads::prepare(ctx);
+        if constexpr(std::is_same<VT, float>::value)
+            cblas_sgemm(CblasColMajor, lhs.trans ? CblasTrans : CblasNoTrans, rhs.trans ? CblasTrans : CblasNoTrans,
+                    static_cast<int>(m), static_cast<int>(n), static_cast<int>(k), 1, lhs.values,
+                    static_cast<int>(lhs.ld), rhs.values, static_cast<int>(rhs.ld), 0, valuesRes,
+                    static_cast<int>(ldRes));
+        else if constexpr(std::is_same<VT, double>::value)
+            cblas_dgemm(CblasColMajor, lhs.trans ? CblasTrans : CblasNoTrans, rhs.trans ? CblasTrans : CblasNoTrans,
+                    static_cast<int>(m), static_cast<int>(n), static_cast<int>(k), 1, lhs.values,
+                    static_cast<int>(lhs.ld), rhs.values, static_cast<int>(rhs.ld), 0, valuesRes,
+                    static_cast<int>(ldRes));
+        else
+            WorkerPool::parallelFor(ctx, n, [&](size_t j) {
+                VT * col = valuesRes + j * ldRes;
+                std::fill(col, col + m, VT(0));
+                for(size_t l = 0; l < k; l++) {
+                    const VT b = rhs(l, j);
+                    for(size_t i = 0; i < m; i++)
+                        col[i] += lhs(i, l) * b;
+                }
+            });
+    }
+
+    template<typename VT, class DTLhs, class DTRhs>
+    void matMul(DenseMatrixCM<VT> *& res, const DTLhs * lhs, const DTRhs * rhs, bool transa, bool transb,
+            DCTX(ctx)) {
+        MatMulSparse::checkDims(lhs, rhs, transa, transb);
+        const size_t m = transa ? lhs->getNumCols() : lhs->getNumRows();
+        const size_t k = transa ? lhs->getNumRows() : lhs->getNumCols();
+        const size_t n = transb ? rhs->getNumRows() : rhs->getNumCols();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrixCM<VT>>(m, n, false);
+
+        gemm(res, m, n, k, operandOf(lhs, transa), operandOf(rhs, transb), ctx);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// DenseMatrixCM <- DenseMatrixCM, DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrixCM<VT>, DenseMatrixCM<VT>, DenseMatrixCM<VT>> {
+    static void apply(DenseMatrixCM<VT> *& res, const DenseMatrixCM<VT> * lhs, const DenseMatrixCM<VT> * rhs,
+            bool transa, bool transb, DCTX(ctx)) {
+        MatMulColMajor::matMul(res, lhs, rhs, transa, transb, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrixCM <- DenseMatrix, DenseMatrixCM
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrixCM<VT>, DenseMatrix<VT>, DenseMatrixCM<VT>> {
+    static void apply(DenseMatrixCM<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrixCM<VT> * rhs,
+            bool transa, bool transb, DCTX(ctx)) {
+        MatMulColMajor::matMul(res, lhs, rhs, transa, transb, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrixCM <- DenseMatrixCM, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrixCM<VT>, DenseMatrixCM<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrixCM<VT> *& res, const DenseMatrixCM<VT> * lhs, const DenseMatrix<VT> * rhs,
+            bool transa, bool transb, DCTX(ctx)) {
+        MatMulColMajor::matMul(res, lhs, rhs, transa, transb, ctx);
+    }
+};
+
+// ****************************************************************************
+// Blocked matrix multiplication
+// ****************************************************************************
+
+/**
+ * @brief The products of pairs of blocks of a blocked matrix multiplication, which accumulate into a dense block of
+ * the result: by BLAS for dense blocks and by scattering the non-zeros of sparse blocks.
+ */
+namespace MatMulBlocked {
+    inline void gemmAcc(DenseMatrix<float> * acc, const DenseMatrix<float> * lhs, const DenseMatrix<float> * rhs) {
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, static_cast<int>(lhs->getNumRows()),
+                static_cast<int>(rhs->getNumCols()), static_cast<int>(lhs->getNumCols()), 1, lhs->getValues(),
+                static_cast<int>(lhs->getRowSkip()), rhs->getValues(), static_cast<int>(rhs->getRowSkip()), 1,
+                acc->getValues(), static_cast<int>(acc->getRowSkip()));
+    }
+
+    inline void gemmAcc(DenseMatrix<double> * acc, const DenseMatrix<double> * lhs, const DenseMatrix<double> * rhs) {
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, static_cast<int>(lhs->getNumRows()),
+                static_cast<int>(rhs->getNumCols()), static_cast<int>(lhs->getNumCols()), 1, lhs->getValues(),
+                static_cast<int>(lhs->getRowSkip()), rhs->getValues(), static_cast<int>(rhs->getRowSkip()), 1,
+                acc->getValues(), static_cast<int>(acc->getRowSkip()));
+    }
+
+    template<typename VT>
+    void gemmAcc(DenseMatrix<VT> * acc, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs) {
+        const size_t numK = lhs->getNumCols();
+        const size_t numCols = rhs->getNumCols();
+        for(size_t r = 0; r < lhs->getNumRows(); r++) {
+            VT * accRow = acc->getValues() + r * acc->getRowSkip();
+            const VT * lhsRow = lhs->getValues() + r * lhs->getRowSkip();
+            for(size_t k = 0; k < numK; k++) {
+                const VT * rhsRow = rhs->getValues() + k * rhs->getRowSkip();
+                #pragma omp simd
+                for(size_t c = 0; c < numCols; c++)
+                    accRow[c] += lhsRow[k] * rhsRow[c];
+            }
+        }
+    }
+
+    template<typename VT>
+    void spmmAcc(DenseMatrix<VT> * acc, const CSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs) {
+        const size_t numCols = rhs->getNumCols();
+        for(size_t r = 0; r < lhs->getNumRows(); r++) {
+            VT * accRow = acc->getValues() + r * acc->getRowSkip();
+            const size_t rowNumNonZeros = lhs->getNumNonZeros(r);
+            const size_t * rowColIdxs = lhs->getColIdxs(r);
+            const VT * rowValues = lhs->getValues(r);
+            for(size_t i = 0; i < rowNumNonZeros; i++) {
+                const VT * rhsRow = rhs->getValues() + rowColIdxs[i] * rhs->getRowSkip();
+                const VT v = rowValues[i];
+                #pragma omp simd
+                for(size_t c = 0; c < numCols; c++)
+                    accRow[c] += v * rhsRow[c];
+            }
+        }
+    }
+
+    template<typename VT>
+    void dmspmAcc(DenseMatrix<VT> * acc, const DenseMatrix<VT> * lhs, const CSRMatrix<VT> * rhs) {
+        const size_t numK = lhs->getNumCols();
+        for(size_t r = 0; r < lhs->getNumRows(); r++) {
+            VT * accRow = acc->getValues() + r * acc->getRowSkip();
+            const VT * lhsRow = lhs->getValues() + r * lhs->getRowSkip();
+            for(size_t k = 0; k < numK; k++) {
+                const VT v = lhsRow[k];
+                if(v == VT(0))
+                    continue;
+                const size_t rowNumNonZeros = rhs->getNumNonZeros(k);
+                const size_t * rowColIdxs = rhs->getColIdxs(k);
+                const VT * rowValues = rhs->getValues(k);
+                for(size_t i = 0; i < rowNumNonZeros; i++)
+                    accRow[rowColIdxs[i]] += v * rowValues[i];
+            }
+        }
+    }
+
+    template<typename VT>
+    void spgemmAcc(DenseMatrix<VT> * acc, const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs) {
+        for(size_t r = 0; r < lhs->getNumRows(); r++) {
+            VT * accRow = acc->getValues() + r * acc->getRowSkip();
+            const size_t rowNumNonZeros = lhs->getNumNonZeros(r);
+            const size_t * rowColIdxs = lhs->getColIdxs(r);
+            const VT * rowValues = lhs->getValues(r);
+            for(size_t i = 0; i < rowNumNonZeros; i++) {
+                const size_t k = rowColIdxs[i];
+                const size_t rhsNumNonZeros = rhs->getNumNonZeros(k);
+                const size_t * rhsColIdxs = rhs->getColIdxs(k);
+                const VT * rhsValues = rhs->getValues(k);
+                for(size_t j = 0; j < rhsNumNonZeros; j++)
+                    accRow[rhsColIdxs[j]] += rowValues[i] * rhsValues[j];
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// BlockedMatrix <- BlockedMatrix, BlockedMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<BlockedMatrix<VT>, BlockedMatrix<VT>, BlockedMatrix<VT>> {
+    static void apply(BlockedMatrix<VT> *& res, const BlockedMatrix<VT> * lhs, const BlockedMatrix<VT> * rhs,
+            bool transa, bool transb, DCTX(ctx)) {
+        if(transa || transb)
+            throw std::runtime_error("MatMul: transposed blocked matrices are not supported yet");
+        if(lhs->getNumCols() != rhs->getNumRows())
+            throw std::runtime_error("MatMul: #cols of lhs and #rows of rhs must be the same");
+        const size_t blockSize = lhs->getBlockSize();
+        if(rhs->getBlockSize() != blockSize)
+            throw std::runtime_error("MatMul: lhs and rhs must have the same block size");
+
+        const size_t numRows = lhs->getNumRows();
+        const size_t numCols = rhs->getNumCols();
+        if(res == nullptr)
+            res = DataObjectFactory::create<BlockedMatrix<VT>>(numRows, numCols, blockSize);
+        else if(res->getNumRows() != numRows || res->getNumCols() != numCols || res->getBlockSize() != blockSize)
+            throw std::runtime_error("MatMul: res must have the shape of the product and the block size of lhs");
+
+        // Each block of the result is computed by one task, accumulating the products of a row of blocks of lhs and
+        // a column of blocks of rhs, such that the blocks involved stay in the cache.
+        const size_t numK = lhs->getNumColBlocks();
+        const size_t numColBlocks = res->getNumColBlocks();
+        WorkerPool::parallelFor(ctx, res->getNumRowBlocks() * numColBlocks, [&](size_t i) {
+            const size_t rb = i / numColBlocks;
+            const size_t cb = i % numColBlocks;
+            DenseMatrix<VT> * acc = nullptr;
+            for(size_t k = 0; k < numK; k++) {
+                const auto * denseLhs = lhs->getDenseBlock(rb, k);
+                const auto * sparseLhs = lhs->getSparseBlock(rb, k);
+                const auto * denseRhs = rhs->getDenseBlock(k, cb);
+                const auto * sparseRhs = rhs->getSparseBlock(k, cb);
+                if((!denseLhs && !sparseLhs) || (!denseRhs && !sparseRhs))
+                    continue;
+                if(acc == nullptr)
+                    acc = DataObjectFactory::create<DenseMatrix<VT>>(res->getBlockNumRows(rb),
+                            res->getBlockNumCols(cb), true);
+                if(denseLhs && denseRhs)
+                    MatMulBlocked::gemmAcc(acc, denseLhs, denseRhs);
+                else if(denseRhs)
+                    MatMulBlocked::spmmAcc(acc, sparseLhs, denseRhs);
+                else if(denseLhs)
+                    MatMulBlocked::dmspmAcc(acc, denseLhs, sparseRhs);
+                else
+                    MatMulBlocked::spgemmAcc(acc, sparseLhs, sparseRhs);
+            }
+            res->setDenseBlock(rb, cb, acc);
+            res->compactBlock(rb, cb);
+        });
+    }
+};
+
+// ****************************************************************************
+// Static shapes
+// ****************************************************************************
+
+/**
+ * @brief The product of dense matrices of static shapes, which are known at
+ * compile-time (see MarkStaticShapeOpsPass), i.e., (`M` x `K`) @ (`K` x `N`)
+ * after the transpositions. For such tiny matrices, a BLAS call costs more
+ * than the product itself, while the loops with constant trip counts are
+ * unrolled completely.
+ */
+template<size_t M, size_t K, size_t N, typename VT>
+struct MatMulStatic {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, bool transa, bool transb, DCTX(ctx)) {
+        assert((transa ? lhs->getNumCols() : lhs->getNumRows()) == M && "lhs must have the static shape");
+        assert((transa ? lhs->getNumRows() : lhs->getNumCols()) == K && "lhs must have the static shape");
+        assert((transb ? rhs->getNumCols() : rhs->getNumRows()) == K && "rhs must have the static shape");
+        assert((transb ? rhs->getNumRows() : rhs->getNumCols()) == N && "rhs must have the static shape");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(M, N, false);
+
+        // The strides of the rows and columns of lhs and rhs after the transpositions.
+        const size_t rowSkipLhs = lhs->getRowSkip();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        const size_t rowStrideLhs = transa ? 1 : rowSkipLhs;
+        const size_t colStrideLhs = transa ? rowSkipLhs : 1;
+        const size_t rowStrideRhs = transb ? 1 : rowSkipRhs;
+        const size_t colStrideRhs = transb ? rowSkipRhs : 1;
+
+        const VT * valuesLhs = lhs->getValues();
+        const VT * valuesRhs = rhs->getValues();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+        for(size_t i = 0; i < M; i++)
+            for(size_t j = 0; j < N; j++) {
+                VT acc = 0;
+                for(size_t k = 0; k < K; k++)
+                    acc += valuesLhs[i * rowStrideLhs + k * colStrideLhs] * valuesRhs[k * rowStrideRhs + j * colStrideRhs];
+                valuesRes[i * rowSkipRes + j] = acc;
+            }
+    }
+};
+
+template<size_t M, size_t K, size_t N, class DTRes, class DTLhs, class DTRhs>
+void matMul(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, bool transa, bool transb, DCTX(ctx)) {
+    MatMulStatic<M, K, N, typename DTRes::VT>::apply(res, lhs, rhs, transa, transb, ctx);
+}
@@ -48,7 +48,10 @@ void matrixConstant(DTRes *& res, uint64_t matrixAddr, DCTX(ctx)) {
 template<typename VT>
 struct MatrixConstant<DenseMatrix<VT>> {
     static void apply(DenseMatrix<VT> *& res, uint64_t matrixAddr, DCTX(ctx)) {
+        // The matrix is owned by the compiled program, every execution (e.g., in a loop) gets a new reference,
+        // which also keeps kernels from overwriting it in place.
         res = reinterpret_cast<DenseMatrix<VT>*>(matrixAddr);
+        res->increaseRefCounter();
     }
 };
 #endif //SRC_RUNTIME_LOCAL_KERNELS_MATRIXCONSTANT_H
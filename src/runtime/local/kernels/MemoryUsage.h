@@ -0,0 +1,45 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_MEMORYUSAGE_H
+#define SRC_RUNTIME_LOCAL_KERNELS_MEMORYUSAGE_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/MemoryTracker.h>
+
+#include <iostream>
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Attributes the data objects created from now on to the DaphneDSL statement at the given source location,
+ * see TrackMemoryPass.
+ */
+inline void setMemoryStatement(const char * location, DCTX(ctx)) {
+    MemoryTracker::get().setStatement(location);
+}
+
+/**
+ * @brief Prints the live and peak memory per allocation type and the statements holding the most memory, inserted
+ * at the end of the program by the TrackMemoryPass and available as the built-in function `printMemoryUsage()`.
+ */
+inline void printMemoryUsage(DCTX(ctx)) {
+    MemoryTracker::get().printReport(std::cerr);
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_MEMORYUSAGE_H
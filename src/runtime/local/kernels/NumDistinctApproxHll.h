@@ -0,0 +1,162 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/ColumnHash.h>
+#include <util/FlatHashMap.h>
+#include <util/HyperLogLog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// don't sketch fewer values than this on separate threads
+constexpr size_t NUMDISTINCTHLL_CHUNK_VALUES = 1 << 16;
+// the values hashed before their registers are updated
+constexpr size_t NUMDISTINCTHLL_BLOCK_VALUES = 1 << 10;
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTArg>
+struct NumDistinctApproxHll {
+    static void sketch(HyperLogLog & res, const DTArg * arg, int64_t seed, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Adds the values of `arg` to the HyperLogLog sketch `res`.
+ *
+ * Sketches of different matrices, e.g., of the partitions of a matrix on
+ * different threads or workers, can be merged to a sketch of all their values
+ * if they have the same precision and seed (see `HyperLogLog::merge`).
+ *
+ * @param seed The seed of the 64-bit hash of the values, or -1 for a random
+ * seed.
+ */
+template<class DTArg>
+void numDistinctApproxHllSketch(HyperLogLog & res, const DTArg * arg, int64_t seed, DCTX(ctx)) {
+    if(seed == -1)
+        seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    NumDistinctApproxHll<DTArg>::sketch(res, arg, seed, ctx);
+}
+
+/**
+ * @brief Approximates the number of distinct values using a HyperLogLog
+ * sketch with `2^precision` registers, computed on all threads.
+ *
+ * Unlike `numDistinctApprox`, the sketches of chunks of the values are
+ * merged, such that the values are sketched in parallel, and the error does
+ * not depend on the number of values.
+ */
+template<class DTArg>
+size_t numDistinctApproxHll(const DTArg * arg, size_t precision, int64_t seed, DCTX(ctx)) {
+    HyperLogLog hll(precision);
+    numDistinctApproxHllSketch(hll, arg, seed, ctx);
+    return static_cast<size_t>(std::llround(hll.estimate()));
+}
+
+// ****************************************************************************
+// Helpers
+// ****************************************************************************
+
+/**
+ * @brief Adds the values [begin, end) of an array to the sketch `res`, with
+ * the hashes of one block of them at a time.
+ */
+template<typename VT>
+void numDistinctHllAdd(HyperLogLog & res, const VT * begin, const VT * end, uint64_t seed) {
+    uint64_t hashes[NUMDISTINCTHLL_BLOCK_VALUES];
+    while(begin < end) {
+        const size_t n = std::min<size_t>(NUMDISTINCTHLL_BLOCK_VALUES, end - begin);
+        ColumnHash::hashColumnSeeded(hashes, begin, n, seed);
+        res.add(hashes, n);
+        begin += n;
+    }
+}
+
+/**
+ * @brief Sketches chunks of rows [0, numRows) into their own sketches in
+ * parallel and merges them into `res`.
+ *
+ * @param addRows Adds the given range of rows to the given sketch.
+ */
+template<class AddRows>
+void numDistinctHllParallel(HyperLogLog & res, size_t numRows, size_t valuesPerRow, AddRows addRows, DCTX(ctx)) {
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64,
+            numRows * std::max<size_t>(1, valuesPerRow) / NUMDISTINCTHLL_CHUNK_VALUES));
+    if(numChunks == 1) {
+        addRows(res, 0, numRows);
+        return;
+    }
+    std::vector<HyperLogLog> chunks(numChunks, HyperLogLog(res.getPrecision()));
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t c) {
+        addRows(chunks[c], numRows * c / numChunks, numRows * (c + 1) / numChunks);
+    });
+    for(const HyperLogLog & chunk : chunks)
+        res.merge(chunk);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+template<typename VT>
+struct NumDistinctApproxHll<DenseMatrix<VT>> {
+    static void sketch(HyperLogLog & res, const DenseMatrix<VT> * arg, int64_t seed, DCTX(ctx)) {
+        const size_t numCols = arg->getNumCols();
+        const size_t rowSkip = arg->getRowSkip();
+        const VT * values = arg->getValues();
+        const uint64_t s = flatHashMix(static_cast<uint64_t>(seed));
+        numDistinctHllParallel(res, arg->getNumRows(), numCols, [&](HyperLogLog & hll, size_t begin, size_t end) {
+            if(rowSkip == numCols)
+                numDistinctHllAdd(hll, values + begin * numCols, values + end * numCols, s);
+            else
+                for(size_t r = begin; r < end; r++)
+                    numDistinctHllAdd(hll, values + r * rowSkip, values + r * rowSkip + numCols, s);
+        }, ctx);
+    }
+};
+
+template<typename VT>
+struct NumDistinctApproxHll<CSRMatrix<VT>> {
+    static void sketch(HyperLogLog & res, const CSRMatrix<VT> * arg, int64_t seed, DCTX(ctx)) {
+        const size_t numNonZeros = arg->getNumNonZeros();
+        const VT * values = arg->getValues(0);
+        const uint64_t s = flatHashMix(static_cast<uint64_t>(seed));
+        // the implicit zeros
+        if(arg->getNumRows() * arg->getNumCols() > numNonZeros) {
+            const VT zero = 0;
+            numDistinctHllAdd(res, &zero, &zero + 1, s);
+        }
+        numDistinctHllParallel(res, numNonZeros, 1, [&](HyperLogLog & hll, size_t begin, size_t end) {
+            numDistinctHllAdd(hll, values + begin, values + end, s);
+        }, ctx);
+    }
+};
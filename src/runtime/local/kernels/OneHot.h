@@ -18,10 +18,16 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_ONEHOT_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
 
-#include <cassert>
 #include <cstddef>
 #include <cstdint>
 
@@ -44,20 +50,27 @@ void oneHot(DTRes *& res, const DTArg * arg, const DenseMatrix<int64_t> * info,
 }
 
 // ****************************************************************************
-// (Partial) template specializations for different data/value types
+// Functions called by multiple template specializations
 // ****************************************************************************
 
-// ----------------------------------------------------------------------------
-// DenseMatrix <- DenseMatrix
-// ----------------------------------------------------------------------------
+/**
+ * @brief Helpers of `OneHot`, which check the info and the codes to encode,
+ * and split the rows into chunks for the tasks.
+ */
+namespace OneHotBlocks {
+    // The cells of the argument handled by one task at least.
+    constexpr size_t MIN_CHUNK_CELLS = 1 << 14;
 
-template<typename VT>
-struct OneHot<DenseMatrix<VT>, DenseMatrix<VT>> {
-    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, const DenseMatrix<int64_t> * info, DCTX(ctx)) {
-        assert((info->getNumRows() == 1) && "parameter info must be a row matrix");
-        
+    /**
+     * @brief Checks the info and returns the number of columns of the result.
+     */
+    template<typename VT>
+    size_t getNumColsRes(const DenseMatrix<VT> * arg, const DenseMatrix<int64_t> * info) {
+        if(info->getNumRows() != 1)
+            throw std::runtime_error("oneHot: parameter info must be a row matrix");
         const size_t numColsArg = arg->getNumCols();
-        assert((numColsArg == info->getNumCols()) && "parameter info must provide information for each column of parameter arg");
+        if(numColsArg != info->getNumCols())
+            throw std::runtime_error("oneHot: parameter info must provide information for each column of parameter arg");
         
         size_t numColsRes = 0;
         const int64_t * valuesInfo = info->getValues();
@@ -68,39 +81,164 @@ struct OneHot<DenseMatrix<VT>, DenseMatrix<VT>> {
             else if(numDistinct > 0)
                 numColsRes += numDistinct;
             else
-                assert(false && "invalid info");
+                throw std::runtime_error("oneHot: invalid info");
         }
-        
+        return numColsRes;
+    }
+
+    inline size_t getNumChunks(size_t numRows, size_t numCols) {
+        return std::max<size_t>(1, std::min(numRows, numRows * numCols / MIN_CHUNK_CELLS));
+    }
+
+    // Whether the value is a code of a column with the given number of distinct values, NaN is not.
+    template<typename VT>
+    bool isValidCode(VT value, int64_t numDistinct) {
+        return value >= 0 && value < static_cast<VT>(numDistinct);
+    }
+
+    [[noreturn]] inline void throwInvalidCode() {
+        throw std::runtime_error("oneHot: the values of the columns to encode must be in [0, number of distinct values)");
+    }
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct OneHot<DenseMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, const DenseMatrix<int64_t> * info, DCTX(ctx)) {
+        const size_t numColsRes = OneHotBlocks::getNumColsRes(arg, info);
+        const size_t numColsArg = arg->getNumCols();
         const size_t numRows = arg->getNumRows();
         
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numColsRes, false);
 
+        const int64_t * valuesInfo = info->getValues();
         const VT * valuesArg = arg->getValues();
         VT * valuesRes = res->getValues();
         
         const size_t rowSkipArg = arg->getRowSkip();
         const size_t rowSkipRes = res->getRowSkip();
         
-        for(size_t r = 0; r < numRows; r++) {
-            size_t cRes = 0;
-            for(size_t cArg = 0; cArg < numColsArg; cArg++) {
-                const int64_t numDistinct = valuesInfo[cArg];
-                if(numDistinct == -1)
-                    // retain value from argument matrix
-                    valuesRes[cRes++] = valuesArg[cArg];
-                else {
-                    // one-hot encode value from argument matrix
-                    for(int64_t d = 0; d < numDistinct; d++)
-                        valuesRes[cRes + d] = 0;
-                    valuesRes[cRes + static_cast<size_t>(valuesArg[cArg])] = 1;
-                    cRes += numDistinct;
+        // Invalid codes are not written, the error is raised after the tasks.
+        std::atomic<bool> invalid{false};
+        const size_t numChunks = OneHotBlocks::getNumChunks(numRows, numColsRes);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++) {
+                const VT * rowArg = valuesArg + r * rowSkipArg;
+                VT * rowRes = valuesRes + r * rowSkipRes;
+                size_t cRes = 0;
+                for(size_t cArg = 0; cArg < numColsArg; cArg++) {
+                    const int64_t numDistinct = valuesInfo[cArg];
+                    if(numDistinct == -1)
+                        // retain value from argument matrix
+                        rowRes[cRes++] = rowArg[cArg];
+                    else {
+                        // one-hot encode value from argument matrix
+                        std::fill_n(rowRes + cRes, numDistinct, VT(0));
+                        if(OneHotBlocks::isValidCode(rowArg[cArg], numDistinct))
+                            rowRes[cRes + static_cast<size_t>(rowArg[cArg])] = 1;
+                        else
+                            invalid.store(true, std::memory_order_relaxed);
+                        cRes += numDistinct;
+                    }
                 }
             }
-            valuesArg += rowSkipArg;
-            valuesRes += rowSkipRes;
-        }
+        });
+        if(invalid.load())
+            OneHotBlocks::throwInvalidCode();
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CSRMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct OneHot<CSRMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(CSRMatrix<VT> *& res, const DenseMatrix<VT> * arg, const DenseMatrix<int64_t> * info, DCTX(ctx)) {
+        const size_t numColsRes = OneHotBlocks::getNumColsRes(arg, info);
+        const size_t numColsArg = arg->getNumCols();
+        const size_t numRows = arg->getNumRows();
+        
+        const int64_t * valuesInfo = info->getValues();
+        const VT * valuesArg = arg->getValues();
+        const size_t rowSkipArg = arg->getRowSkip();
+        
+        // Each encoded column has one non-zero per row, and each retained
+        // column as many as it has non-zeros.
+        std::vector<size_t> retainedCols;
+        for(size_t c = 0; c < numColsArg; c++)
+            if(valuesInfo[c] == -1)
+                retainedCols.push_back(c);
+        const size_t numEncodedCols = numColsArg - retainedCols.size();
+        
+        // The non-zeros of the chunks of rows are counted first, such that
+        // each task writes its rows from the offset of its chunk.
+        const size_t numChunks = OneHotBlocks::getNumChunks(numRows, numColsArg);
+        std::vector<size_t> chunkOffsets(numChunks + 1, 0);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t rowBegin = numRows * chunk / numChunks;
+            const size_t rowEnd = numRows * (chunk + 1) / numChunks;
+            size_t numNonZeros = (rowEnd - rowBegin) * numEncodedCols;
+            for(size_t r = rowBegin; r < rowEnd; r++)
+                for(size_t c : retainedCols)
+                    numNonZeros += valuesArg[r * rowSkipArg + c] != VT(0);
+            chunkOffsets[chunk + 1] = numNonZeros;
+        });
+        for(size_t chunk = 0; chunk < numChunks; chunk++)
+            chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+        
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numColsRes, chunkOffsets[numChunks], false);
+        
+        size_t * rowOffsetsRes = res->getRowOffsets();
+        size_t * colIdxsRes = res->getColIdxs();
+        VT * valuesRes = res->getValues();
+        
+        // Invalid codes are not written, the error is raised after the tasks.
+        std::atomic<bool> invalid{false};
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            size_t pos = chunkOffsets[chunk];
+            for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++) {
+                rowOffsetsRes[r] = pos;
+                const VT * rowArg = valuesArg + r * rowSkipArg;
+                size_t cRes = 0;
+                for(size_t cArg = 0; cArg < numColsArg; cArg++) {
+                    const int64_t numDistinct = valuesInfo[cArg];
+                    const VT value = rowArg[cArg];
+                    if(numDistinct == -1) {
+                        // retain value from argument matrix
+                        if(value != VT(0)) {
+                            colIdxsRes[pos] = cRes;
+                            valuesRes[pos++] = value;
+                        }
+                        cRes++;
+                    }
+                    else {
+                        // one-hot encode value from argument matrix
+                        if(OneHotBlocks::isValidCode(value, numDistinct))
+                            colIdxsRes[pos] = cRes + static_cast<size_t>(value);
+                        else {
+                            colIdxsRes[pos] = cRes;
+                            invalid.store(true, std::memory_order_relaxed);
+                        }
+                        valuesRes[pos++] = 1;
+                        cRes += numDistinct;
+                    }
+                }
+            }
+        });
+        rowOffsetsRes[numRows] = chunkOffsets[numChunks];
+        if(invalid.load())
+            OneHotBlocks::throwInvalidCode();
     }
 };
 
-#endif //SRC_RUNTIME_LOCAL_KERNELS_ONEHOT_H
\ No newline at end of file
+#endif //SRC_RUNTIME_LOCAL_KERNELS_ONEHOT_H
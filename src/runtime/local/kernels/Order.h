@@ -23,13 +23,19 @@
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 #include <runtime/local/kernels/ExtractRow.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 #include <util/DeduceType.h>
 
 #include <algorithm>
-#include <functional>
 #include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <cstdint>
+#include <cstring>
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
@@ -55,107 +61,261 @@ void order(DTRes *& res, const DTArg * arg, size_t * colIdxs, size_t numColIdxs,
 // Functions called by multiple template specializations
 // ****************************************************************************
 
-// sorts input idx DenseMatrix within the index ranges in the input groups vector on the values of the input column (column with id colIdx in DenseMatrix arg; id 0 for column matrices)
-template<typename VTIdx, typename VT>
-void columnIDSort(DenseMatrix<VTIdx> *&idx, const DenseMatrix<VT>* arg, size_t colIdx, std::vector<std::pair<VTIdx, VTIdx>> &groups, bool ascending, DCTX(ctx)) {
-    VTIdx * indicies = idx->getValues();
-    const VT * values = arg->getValues();
-    const size_t rowSkip = arg->getRowSkip();
-    auto compare = ascending ?
-        std::function{[&values, rowSkip, colIdx](VTIdx i, VTIdx j) {
-            return values[i * rowSkip + colIdx] < values[j * rowSkip + colIdx];
-        }} :
-        std::function{[&values, rowSkip, colIdx](VTIdx i, VTIdx j) {
-            return values[i * rowSkip + colIdx] > values[j * rowSkip + colIdx];}};
-    for (const auto &group : groups)
-        std::stable_sort(indicies+group.first, indicies+group.second, compare);
+// The number of rows from which on the indexes are sorted with a parallel
+// radix sort instead of a merge sort, and the rows of each chunk handled by
+// one task of the radix sort.
+constexpr size_t ORDER_RADIX_MIN_ROWS = 1 << 12;
+constexpr size_t ORDER_CHUNK_ROWS = 1 << 16;
+
+/**
+ * @brief The key columns of an order as normalized keys: unsigned integers
+ * that are ordered like the rows.
+ *
+ * Each value is mapped to an unsigned integer of its width whose order is the
+ * order of the values (flipping the sign bit of signed integers and all bits
+ * of negative floats, -0.0 being mapped like 0.0), which is inverted for
+ * descending columns. The keys of consecutive columns are concatenated into
+ * 64-bit words as long as they fit, such that the rows are ordered like the
+ * words of their keys compared lexicographically.
+ */
+struct OrderKeys {
+    size_t numRows;
+    // per word, its key of each row (in the order of the rows of the input)
+    std::vector<std::vector<uint64_t>> words;
+    // per word, the number of its lowest bits used by the keys
+    std::vector<unsigned> wordBits;
+
+    /**
+     * @brief Creates the words of the given key columns, the i-th of which
+     * has `widths[i]` bits (the size of its value type).
+     */
+    OrderKeys(size_t numRows, const size_t * widths, size_t numCols) : numRows(numRows) {
+        for(size_t i = 0; i < numCols; i++) {
+            if(wordBits.empty() || wordBits.back() + widths[i] > 64)
+                wordBits.push_back(0);
+            wordBits.back() += widths[i];
+        }
+        words.resize(wordBits.size());
+        for(auto & word : words)
+            word.assign(numRows, 0);
+    }
+
+    bool less(size_t i, size_t j) const {
+        for(const auto & word : words)
+            if(word[i] != word[j])
+                return word[i] < word[j];
+        return false;
+    }
+
+    bool equal(size_t i, size_t j) const {
+        for(const auto & word : words)
+            if(word[i] != word[j])
+                return false;
+        return true;
+    }
+};
+
+template<typename VT>
+uint64_t orderNormalize(VT v) {
+    constexpr unsigned width = sizeof(VT) * 8;
+    constexpr uint64_t sign = uint64_t(1) << (width - 1);
+    if constexpr(std::is_floating_point<VT>::value) {
+        using VTBits = typename std::conditional<sizeof(VT) == 4, uint32_t, uint64_t>::type;
+        // -0.0 == 0.0
+        if(v == 0)
+            v = 0;
+        VTBits bits;
+        memcpy(&bits, &v, sizeof(VT));
+        const uint64_t b = bits;
+        return (b & sign) ? (~b & (sign | (sign - 1))) : (b | sign);
+    }
+    else if constexpr(std::is_signed<VT>::value)
+        return (static_cast<uint64_t>(v) & (sign | (sign - 1))) ^ sign;
+    else
+        return static_cast<uint64_t>(v);
 }
 
+// Adds the normalized keys of the column with the given values (every
+// rowSkip-th one) to the word, shifted by the given number of bits.
 template<typename VT>
-VT* nextWithRowskip(VT*& first, VT*& last, const size_t rowSkip) {
-    for (VT* next = first; next != last; next+=rowSkip) {
-        if (*next != *first)
-            return next;
+struct OrderKeyColumn {
+    static void apply(std::vector<uint64_t> & word, const void * values, size_t rowSkip, unsigned shift,
+            bool ascending, DCTX(ctx)) {
+        const VT * v = static_cast<const VT *>(values);
+        constexpr unsigned width = sizeof(VT) * 8;
+        const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+        const uint64_t flip = ascending ? 0 : mask;
+        const size_t numRows = word.size();
+        const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / ORDER_CHUNK_ROWS));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++)
+                word[r] |= (orderNormalize(v[r * rowSkip]) ^ flip) << shift;
+        });
     }
-    return last;
+};
+
+// Returns the position of the given key column in the words of the keys, as
+// the word and the shift of the column's keys within it.
+inline std::pair<size_t, unsigned> orderKeyPosition(const OrderKeys & keys, const size_t * widths, size_t col) {
+    size_t w = 0;
+    unsigned used = 0;
+    for(size_t i = 0; i <= col; i++) {
+        if(used + widths[i] > keys.wordBits[w]) {
+            w++;
+            used = 0;
+        }
+        used += widths[i];
+    }
+    return {w, keys.wordBits[w] - used};
 }
 
-// scans a column for groups of duplicates (stored as VTIdx pairs forming index ranges)
-// performed only within the index ranges in the input groups vector on the values of the input column (DenseMatrix)
-// replaces the groups in the input vector with the groups found during the scan
-template<typename VTIdx, typename VT>
-void columnGroupScan(std::vector<std::pair<VTIdx, VTIdx>> &groups, DenseMatrix<VT>* col, size_t colIdx, DCTX(ctx)) {
-    const size_t numOldGroups = groups.size();
-    VT * values = col->getValues();
-    const size_t rowSkip = col->getRowSkip();
-    for (size_t g = 0; g < numOldGroups; g++) {
-        VT * first = values + groups[g].first * rowSkip + colIdx;
-        VT * last = values + groups[g].second * rowSkip + colIdx;
-        while (first != last) {
-            VT * next = nextWithRowskip<VT>(first, last, rowSkip);
-            if ((size_t) (next - first) > rowSkip)
-                groups.push_back(std::make_pair((first-values-colIdx)/rowSkip, (next-values-colIdx)/rowSkip));
-            first = next;
+/**
+ * @brief Sorts the given row indexes stably by the keys of their rows.
+ *
+ * Small inputs are sorted with a merge sort. Otherwise, the words are sorted
+ * with a least significant digit radix sort on their bytes, from the last
+ * word to the first one, such that the rows are ordered lexicographically by
+ * all words without breaking ties separately. The bytes of a word in which
+ * the keys of all rows agree are skipped. Each pass counts and scatters the
+ * chunks of the rows in parallel.
+ */
+inline void orderSortIndexes(size_t * idx, const OrderKeys & keys, DCTX(ctx)) {
+    const size_t numRows = keys.numRows;
+    if(numRows < ORDER_RADIX_MIN_ROWS) {
+        std::stable_sort(idx, idx + numRows, [&](size_t i, size_t j) { return keys.less(i, j); });
+        return;
+    }
+
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / ORDER_CHUNK_ROWS));
+    auto chunkBegin = [&](size_t chunk) { return numRows * chunk / numChunks; };
+    std::vector<uint64_t> cur(numRows);
+    std::vector<uint64_t> tmpKeys(numRows);
+    std::vector<size_t> tmpIdx(numRows);
+    std::vector<size_t> counts(numChunks * 256);
+    std::vector<uint64_t> diffs(numChunks);
+    size_t * srcIdx = idx;
+    size_t * dstIdx = tmpIdx.data();
+
+    for(size_t w = keys.words.size(); w-- > 0; ) {
+        const std::vector<uint64_t> & word = keys.words[w];
+        // the keys of the word in the current order of the rows, and the
+        // bits in which any two of them differ
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            uint64_t diff = 0;
+            for(size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++) {
+                cur[i] = word[srcIdx[i]];
+                diff |= cur[i] ^ word[0];
+            }
+            diffs[chunk] = diff;
+        });
+        uint64_t diff = 0;
+        for(uint64_t d : diffs)
+            diff |= d;
+
+        uint64_t * srcKeys = cur.data();
+        uint64_t * dstKeys = tmpKeys.data();
+        for(unsigned shift = 0; shift < keys.wordBits[w]; shift += 8) {
+            if(((diff >> shift) & 0xff) == 0)
+                continue;
+            WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+                size_t * count = counts.data() + chunk * 256;
+                std::fill(count, count + 256, 0);
+                for(size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+                    count[(srcKeys[i] >> shift) & 0xff]++;
+            });
+            size_t pos = 0;
+            for(size_t d = 0; d < 256; d++)
+                for(size_t chunk = 0; chunk < numChunks; chunk++) {
+                    const size_t n = counts[chunk * 256 + d];
+                    counts[chunk * 256 + d] = pos;
+                    pos += n;
+                }
+            WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+                size_t * next = counts.data() + chunk * 256;
+                for(size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++) {
+                    const size_t p = next[(srcKeys[i] >> shift) & 0xff]++;
+                    dstKeys[p] = srcKeys[i];
+                    dstIdx[p] = srcIdx[i];
+                }
+            });
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcIdx, dstIdx);
         }
     }
-    groups.erase(groups.begin(),groups.begin()+numOldGroups);
+    if(srcIdx != idx)
+        std::copy(srcIdx, srcIdx + numRows, idx);
 }
 
-// sorts IDs inside groups by the key column, reorder the column via a row extraction into a temporary
-// DenseMatrix and then scan for groups of duplicates to be tie broken by another subsequent key column
-template<typename VTIdx, typename VT>
-void multiColumnIDSort(DenseMatrix<VTIdx> *&idx, const DenseMatrix<VT>* col, size_t colIdx, std::vector<std::pair<VTIdx, VTIdx>> &groups, bool ascending, DCTX(ctx)){
-    columnIDSort(idx, col, colIdx, groups, ascending, ctx);
-    DenseMatrix<VT> * tmp = nullptr;
-    extractRow<DenseMatrix<VT>, DenseMatrix<VT>, VTIdx>(tmp, col, idx, ctx);
-    columnGroupScan(groups, tmp, colIdx, ctx);
-    DataObjectFactory::destroy(tmp);
+// Returns the normalized keys of the given key columns of a frame.
+inline OrderKeys orderFrameKeys(const Frame * arg, const size_t * colIdxs, size_t numColIdxs, const bool * ascending,
+        DCTX(ctx)) {
+    std::vector<size_t> widths(numColIdxs);
+    for (size_t i = 0; i < numColIdxs; i++)
+        widths[i] = ValueTypeUtils::sizeOf(arg->getSchema()[colIdxs[i]]) * 8;
+    OrderKeys keys(arg->getNumRows(), widths.data(), numColIdxs);
+    for (size_t i = 0; i < numColIdxs; i++) {
+        const auto [w, shift] = orderKeyPosition(keys, widths.data(), i);
+        DeduceValueTypeAndExecute<OrderKeyColumn>::apply(arg->getSchema()[colIdxs[i]], keys.words[w], arg->getColumnRaw(colIdxs[i]), 1, shift, ascending[i], ctx);
+    }
+    return keys;
+}
+
+// Returns the normalized keys of the given key columns of a dense matrix.
+template<typename VT>
+OrderKeys orderMatrixKeys(const DenseMatrix<VT> * arg, const size_t * colIdxs, size_t numColIdxs,
+        const bool * ascending, DCTX(ctx)) {
+    std::vector<size_t> widths(numColIdxs, sizeof(VT) * 8);
+    OrderKeys keys(arg->getNumRows(), widths.data(), numColIdxs);
+    for (size_t i = 0; i < numColIdxs; i++) {
+        const auto [w, shift] = orderKeyPosition(keys, widths.data(), i);
+        OrderKeyColumn<VT>::apply(keys.words[w], arg->getValues() + colIdxs[i], arg->getRowSkip(), shift, ascending[i], ctx);
+    }
+    return keys;
+}
+
+// Appends the ranges of at least two consecutive sorted rows with equal keys
+// to groups, in ascending order.
+inline void orderFindGroups(std::vector<std::pair<size_t, size_t>> & groups, const size_t * idx,
+        const OrderKeys & keys, DCTX(ctx)) {
+    const size_t numRows = keys.numRows;
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / ORDER_CHUNK_ROWS));
+    std::vector<std::vector<std::pair<size_t, size_t>>> chunkGroups(numChunks);
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+        // the groups starting in the chunk
+        const size_t end = numRows * (chunk + 1) / numChunks;
+        size_t first = numRows * chunk / numChunks;
+        while(first > 0 && first < end && keys.equal(idx[first - 1], idx[first]))
+            first++;
+        while(first < end) {
+            size_t next = first + 1;
+            while(next < numRows && keys.equal(idx[next - 1], idx[next]))
+                next++;
+            if(next - first > 1)
+                chunkGroups[chunk].emplace_back(first, next);
+            first = next;
+        }
+    });
+    for(const auto & g : chunkGroups)
+        groups.insert(groups.end(), g.begin(), g.end());
 }
 
 // ----------------------------------------------------------------------------
 //  Frame order structs
 // ----------------------------------------------------------------------------
 
-template<typename VTCol>
-struct ColumnIDSort {
-    static void apply(const Frame * arg, DenseMatrix<size_t> *&idx, std::vector<std::pair<size_t, size_t>> &groups, bool ascending, size_t colIdx, DCTX(ctx)) {
-        columnIDSort(idx, arg->getColumn<VTCol>(colIdx), 0, groups, ascending, ctx);
-    }
-};
-
-// sorts IDs inside groups by the key column, reorder the column via a row extraction into a temporary 
-// DenseMatrix and then scan for groups of duplicates to be tie broken by another subsequent key column
-template<typename VTCol>
-struct MultiColumnIDSort {
-    static void apply(const Frame * arg, DenseMatrix<size_t> *&idx, std::vector<std::pair<size_t, size_t>> &groups, bool ascending, size_t colIdx, DCTX(ctx)) {
-        multiColumnIDSort(idx, arg->getColumn<VTCol>(colIdx), 0, groups, ascending, ctx);
-    }
-};
-
 struct OrderFrame {
     static void apply(DenseMatrix<size_t> *& idx, const Frame * arg, size_t * colIdxs, size_t numColIdxs, bool * ascending, size_t numAscending, std::vector<std::pair<size_t, size_t>> * groupsRes, DCTX(ctx)) {
         size_t numRows = arg->getNumRows();
         idx = DataObjectFactory::create<DenseMatrix<size_t>>(numRows, 1, false);
         auto indicies = idx->getValues();
         std::iota(indicies, indicies+numRows, 0);
-        
-        std::vector<std::pair<size_t, size_t>> groups;
-        groups.push_back(std::make_pair(0, numRows));
-            
-        if (numColIdxs > 1) {
-            for (size_t i = 0; i < numColIdxs-1; i++) {
-                DeduceValueTypeAndExecute<MultiColumnIDSort>::apply(arg->getSchema()[colIdxs[i]], arg, idx, groups, ascending[i], colIdxs[i], ctx);
-            }
-        }
 
-        // efficient last sort pass OR finalizing the groups vector for further use
-        size_t colIdx = colIdxs[numColIdxs-1];
-        if (groupsRes == nullptr) {
-            DeduceValueTypeAndExecute<ColumnIDSort>::apply(arg->getSchema()[colIdx], arg, idx, groups, ascending[numColIdxs-1], colIdx, ctx);
-        } else {
-            DeduceValueTypeAndExecute<MultiColumnIDSort>::apply(arg->getSchema()[colIdx], arg, idx, groups, ascending[numColIdxs-1], colIdx, ctx);
-            groupsRes->insert(groupsRes->end(), groups.begin(), groups.end());
-        }
+        const OrderKeys keys = orderFrameKeys(arg, colIdxs, numColIdxs, ascending, ctx);
+        // A single key column which is sorted already is in order.
+        if (!(numColIdxs == 1 && ascending[0] && arg->isColumnSorted(colIdxs[0])))
+            orderSortIndexes(indicies, keys, ctx);
+        if (groupsRes != nullptr)
+            orderFindGroups(*groupsRes, indicies, keys, ctx);
     }
 };
 
@@ -212,21 +372,11 @@ struct Order<DenseMatrix<VTRes>, DenseMatrix<VTArg>> {
         auto idx = DataObjectFactory::create<DenseMatrix<size_t>>(numRows, 1, false);
         auto indices = idx->getValues();
         std::iota(indices, indices+numRows, 0);
-        std::vector<std::pair<size_t, size_t>> groups;
-        groups.push_back(std::make_pair(0, numRows));
-
-        if (numColIdxs > 1) {
-            for (size_t i = 0; i < numColIdxs-1; i++) {
-                multiColumnIDSort(idx, arg, colIdxs[i], groups, ascending[i], ctx);
-            }
-        }
 
-        if (groupsRes == nullptr) {
-            columnIDSort(idx, arg, colIdxs[numColIdxs-1], groups, ascending[numColIdxs-1], ctx);
-        } else {
-            multiColumnIDSort(idx, arg, colIdxs[numColIdxs-1], groups, ascending[numColIdxs-1], ctx);
-            groupsRes->insert(groupsRes->end(), groups.begin(), groups.end());
-        }
+        const OrderKeys keys = orderMatrixKeys(arg, colIdxs, numColIdxs, ascending, ctx);
+        orderSortIndexes(indices, keys, ctx);
+        if (groupsRes != nullptr)
+            orderFindGroups(*groupsRes, indices, keys, ctx);
 
         if (returnIdx)
         {
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/ExtractRow.h>
+#include <runtime/local/kernels/Order.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/UniqueBoundedPriorityQueue.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTArg>
+struct OrderTopK {
+    static void apply(DTRes *& res, const DTArg * arg, size_t * colIdxs, size_t numColIdxs, bool * ascending,
+            size_t numAscending, bool returnIdx, size_t k, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Returns the first `k` rows (or their indexes) of `order` with the
+ * same arguments, i.e., `sliceRow(order(...), 0, k)`, without sorting all
+ * rows.
+ */
+template<class DTRes, class DTArg>
+void orderTopK(DTRes *& res, const DTArg * arg, size_t * colIdxs, size_t numColIdxs, bool * ascending,
+        size_t numAscending, bool returnIdx, size_t k, DCTX(ctx)) {
+    OrderTopK<DTRes, DTArg>::apply(res, arg, colIdxs, numColIdxs, ascending, numAscending, returnIdx, k, ctx);
+}
+
+// ****************************************************************************
+// Functions called by multiple template specializations
+// ****************************************************************************
+
+// The number of rows filtered by the threshold at once, and the portion of the
+// rows up to which the top rows are selected by heaps instead of sorting all
+// indexes.
+constexpr size_t ORDERTOPK_BLOCK_ROWS = 1 << 10;
+constexpr size_t ORDERTOPK_MAX_K_RATIO = 16;
+
+// A row in a heap of the top rows, which are ordered like in a stable sort of
+// the rows by their keys.
+struct OrderTopKRow {
+    const OrderKeys * keys;
+    size_t row;
+
+    bool operator<(const OrderTopKRow & other) const {
+        if(keys->less(row, other.row))
+            return true;
+        return row < other.row && keys->equal(row, other.row);
+    }
+
+    bool operator>(const OrderTopKRow & other) const {
+        return other < *this;
+    }
+};
+
+/**
+ * @brief Writes the indexes of the first `k` rows of the stable order of the
+ * rows by their keys to `idx`.
+ *
+ * Each chunk of the rows keeps its top rows in a bounded max-heap. A row only
+ * enters the heap if the first word of its keys does not exceed the one of
+ * the top of the heap, which is checked for a block of rows at once in a loop
+ * the compiler vectorizes, such that most rows of large inputs are rejected
+ * without comparing their keys. The top rows of the chunks are sorted at
+ * the end.
+ */
+inline void orderTopKIndexes(size_t * idx, size_t k, const OrderKeys & keys, DCTX(ctx)) {
+    const size_t numRows = keys.numRows;
+    if(k == 0)
+        return;
+    if(k * ORDERTOPK_MAX_K_RATIO > numRows) {
+        std::vector<size_t> all(numRows);
+        std::iota(all.begin(), all.end(), 0);
+        orderSortIndexes(all.data(), keys, ctx);
+        std::copy(all.begin(), all.begin() + k, idx);
+        return;
+    }
+
+    const std::vector<uint64_t> & first = keys.words[0];
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / ORDER_CHUNK_ROWS));
+    std::vector<std::vector<size_t>> tops(numChunks);
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+        UniqueBoundedPriorityQueue<OrderTopKRow> heap(k);
+        uint64_t threshold = std::numeric_limits<uint64_t>::max();
+        uint8_t pass[ORDERTOPK_BLOCK_ROWS];
+        const size_t chunkEnd = numRows * (chunk + 1) / numChunks;
+        for(size_t begin = numRows * chunk / numChunks; begin < chunkEnd; begin += ORDERTOPK_BLOCK_ROWS) {
+            const size_t n = std::min(ORDERTOPK_BLOCK_ROWS, chunkEnd - begin);
+            const uint64_t * w = first.data() + begin;
+            for(size_t i = 0; i < n; i++)
+                pass[i] = w[i] <= threshold;
+            for(size_t i = 0; i < n; i += 8) {
+                // skip eight rejected rows at once
+                uint64_t eight = 0;
+                memcpy(&eight, pass + i, std::min<size_t>(8, n - i));
+                for(; eight; eight &= eight - 1) {
+                    const size_t r = begin + i + __builtin_ctzll(eight) / 8;
+                    heap.push({&keys, r});
+                    if(heap.size() == k)
+                        threshold = first[heap.top().row];
+                }
+            }
+        }
+        tops[chunk].reserve(heap.size());
+        for(; !heap.empty(); heap.pop())
+            tops[chunk].push_back(heap.top().row);
+    });
+
+    std::vector<size_t> candidates;
+    for(const auto & t : tops)
+        candidates.insert(candidates.end(), t.begin(), t.end());
+    std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), [&](size_t i, size_t j) {
+        return OrderTopKRow{&keys, i} < OrderTopKRow{&keys, j};
+    });
+    std::copy(candidates.begin(), candidates.begin() + k, idx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// Frame <- Frame, DenseMatrix <- Frame
+// ----------------------------------------------------------------------------
+
+template<class DTRes>
+struct OrderTopK<DTRes, Frame> {
+    static void apply(DTRes *& res, const Frame * arg, size_t * colIdxs, size_t numColIdxs, bool * ascending,
+            size_t numAscending, bool returnIdx, size_t k, DCTX(ctx)) {
+        if (arg == nullptr || colIdxs == nullptr || numColIdxs == 0 || ascending == nullptr ||
+                returnIdx != std::is_same<DTRes, DenseMatrix<size_t>>::value) {
+            throw std::runtime_error("orderTopK-kernel called with invalid arguments");
+        }
+        k = std::min(k, arg->getNumRows());
+        auto idx = DataObjectFactory::create<DenseMatrix<size_t>>(k, 1, false);
+        const OrderKeys keys = orderFrameKeys(arg, colIdxs, numColIdxs, ascending, ctx);
+        orderTopKIndexes(idx->getValues(), k, keys, ctx);
+        if constexpr (std::is_same<DTRes, Frame>::value) {
+            extractRow(res, arg, idx, ctx);
+            DataObjectFactory::destroy(idx);
+        }
+        else
+            res = idx;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template <typename VTRes, typename VTArg>
+struct OrderTopK<DenseMatrix<VTRes>, DenseMatrix<VTArg>> {
+    static void apply(DenseMatrix<VTRes> *& res, const DenseMatrix<VTArg> * arg, size_t * colIdxs, size_t numColIdxs,
+            bool * ascending, size_t numAscending, bool returnIdx, size_t k, DCTX(ctx)) {
+        if (arg == nullptr || colIdxs == nullptr || numColIdxs == 0 || ascending == nullptr ||
+                (returnIdx == false && !std::is_same<VTRes, VTArg>::value) ||
+                (returnIdx == true && !std::is_same<VTRes, size_t>::value)) {
+            throw std::runtime_error("orderTopK-kernel called with invalid arguments");
+        }
+        k = std::min(k, arg->getNumRows());
+        auto idx = DataObjectFactory::create<DenseMatrix<size_t>>(k, 1, false);
+        const OrderKeys keys = orderMatrixKeys(arg, colIdxs, numColIdxs, ascending, ctx);
+        orderTopKIndexes(idx->getValues(), k, keys, ctx);
+        if (returnIdx)
+            res = reinterpret_cast<DenseMatrix<VTRes> *>(idx);
+        else {
+            extractRow<DenseMatrix<VTArg>, DenseMatrix<VTArg>, size_t>(reinterpret_cast<DenseMatrix<VTArg> *&>(res), arg, idx, ctx);
+            DataObjectFactory::destroy(idx);
+        }
+    }
+};
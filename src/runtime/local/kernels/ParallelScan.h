@@ -0,0 +1,123 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief The building blocks of the validation kernels (`HasSpecialValue`, `IsSymmetric`, `CheckEq`): branch-free
+ * tests of blocks of values, which the compiler vectorizes for the instruction set of the CPU (see `CpuDispatch`),
+ * and a parallel scan over the blocks on the `WorkerPool`, which stops as soon as any block is found.
+ *
+ * The chunks of the scan check a shared flag before each block, such that all threads stop within one block after
+ * one of them found a match.
+ */
+namespace ParallelScan {
+    // the number of cells tested at once, between the checks of the flag
+    constexpr size_t BLOCK_CELLS = 4096;
+    // inputs are split into chunks of at least this many cells, but at most MAX_CHUNKS
+    constexpr size_t MIN_CELLS_PER_CHUNK = 1 << 16;
+    constexpr size_t MAX_CHUNKS = 256;
+
+    /**
+     * @brief Returns whether `found(begin, end)` is true for any range of the units (e.g., rows) from 0 to
+     * `numUnits`, which consist of `cellsPerUnit` cells each.
+     *
+     * `found` is called for blocks of about `BLOCK_CELLS` cells in parallel chunks, within the variant of the
+     * instruction set of the CPU.
+     *
+     * @param kernel The name of the calling kernel, as reported by `CpuDispatch::printSelections()`.
+     */
+    template<class Found>
+    bool any(const char * kernel, size_t numUnits, size_t cellsPerUnit, const Found & found, DCTX(ctx)) {
+        cellsPerUnit = std::max<size_t>(cellsPerUnit, 1);
+        const size_t unitsPerBlock = std::max<size_t>(BLOCK_CELLS / cellsPerUnit, 1);
+        const size_t numChunks = std::clamp<size_t>(
+                numUnits * cellsPerUnit / MIN_CELLS_PER_CHUNK, 1, std::clamp<size_t>(numUnits, 1, MAX_CHUNKS)
+        );
+        std::atomic<bool> isFound{false};
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t end = numUnits * (chunk + 1) / numChunks;
+            CpuDispatch::run(kernel, [&](auto) {
+                for(size_t begin = numUnits * chunk / numChunks; begin < end; begin += unitsPerBlock) {
+                    if(isFound.load(std::memory_order_relaxed))
+                        return;
+                    if(found(begin, std::min(begin + unitsPerBlock, end))) {
+                        isFound.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+            });
+        });
+        return isFound.load();
+    }
+
+    /**
+     * @brief Returns whether any of the given floating-point values is a NaN, by the bit pattern of its absolute
+     * value exceeding the one of infinity.
+     */
+    template<typename VT>
+    bool anyNaN(const VT * values, size_t n) {
+        static_assert(std::is_floating_point<VT>::value && (sizeof(VT) == 4 || sizeof(VT) == 8));
+        using BT = std::conditional_t<sizeof(VT) == 8, uint64_t, uint32_t>;
+        constexpr BT absMask = ~BT(0) >> 1;
+        // all bits of the exponent set, none of the mantissa
+        constexpr BT infBits = absMask & ~((BT(1) << (std::numeric_limits<VT>::digits - 1)) - 1);
+        BT found = 0;
+        #pragma omp simd reduction(|:found)
+        for(size_t i = 0; i < n; i++) {
+            BT bits;
+            std::memcpy(&bits, values + i, sizeof(BT));
+            found |= (bits & absMask) > infBits;
+        }
+        return found;
+    }
+
+    /**
+     * @brief Returns whether any of the given values equals `testVal` (which is not a NaN).
+     */
+    template<typename VT>
+    bool anyEqual(const VT * values, size_t n, VT testVal) {
+        unsigned found = 0;
+        #pragma omp simd reduction(|:found)
+        for(size_t i = 0; i < n; i++)
+            found |= values[i] == testVal;
+        return found;
+    }
+
+    /**
+     * @brief Returns whether the given arrays of bytes differ, in parallel chunks.
+     */
+    inline bool anyDifferentBytes(const void * lhs, const void * rhs, size_t numBytes, DCTX(ctx)) {
+        const char * bytesLhs = static_cast<const char *>(lhs);
+        const char * bytesRhs = static_cast<const char *>(rhs);
+        return any("ParallelScan", numBytes, 1, [&](size_t begin, size_t end) {
+            return std::memcmp(bytesLhs + begin, bytesRhs + begin, end - begin) != 0;
+        }, ctx);
+    }
+}
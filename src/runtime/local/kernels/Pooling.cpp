@@ -16,63 +16,115 @@
 
 #include "Pooling.h"
 
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
 namespace Pooling {
 
-    uint32_t getPQ(uint32_t img_extent, uint32_t filter_extent, uint32_t pad_extent, uint32_t stride_extent) {
-        uint32_t padded_image_extent = img_extent + 2 * pad_extent;
+    size_t getPQ(size_t img_extent, size_t filter_extent, size_t pad_extent, size_t stride_extent) {
+        size_t padded_image_extent = img_extent + 2 * pad_extent;
         return (padded_image_extent - filter_extent) / stride_extent + 1;
     }
 
+    // the channels pooled by a task at least
+    constexpr size_t MIN_CHUNK_CELLS = 1 << 14;
+
     template<template<typename> class OP, typename DTRes, typename DTArg>
     void Forward<OP, DTRes, DTArg>::apply(DTRes *&res, size_t& res_h, size_t& res_w,
             const DTArg *data, const size_t batch_size, const size_t num_channels, const size_t img_h, const size_t img_w,
             const size_t pool_h, const size_t pool_w, const size_t stride_h, const size_t stride_w, const size_t pad_h,
             const size_t pad_w, DCTX(dctx))
     {
-        auto HW = img_h * img_w;
-        auto C = num_channels;
-        auto CHW = C * HW;
-        // padded height/width
-        auto P = getPQ(img_h, pool_h, pad_h, stride_w);
-        auto Q = getPQ(img_w, pool_w, pad_w, stride_h);
-        auto CPQ = C * P * Q;
+        using VT = typename DTRes::VT;
+        using Op = OP<VT>;
+
+        if(stride_h == 0 || stride_w == 0 || pool_h == 0 || pool_w == 0)
+            throw std::runtime_error("Pooling: the pool and stride extents must be positive");
+        if(img_h + 2 * pad_h < pool_h || img_w + 2 * pad_w < pool_w)
+            throw std::runtime_error("Pooling: the pool is larger than the padded image");
+        if(pad_h >= pool_h || pad_w >= pool_w)
+            throw std::runtime_error("Pooling: the padding must be smaller than the pool");
+        if(data->getNumCols() != num_channels * img_h * img_w)
+            throw std::runtime_error("Pooling: the number of columns of the input must be the number of channels "
+                    "times the image size");
+
+        const size_t HW = img_h * img_w;
+        const size_t P = getPQ(img_h, pool_h, pad_h, stride_h);
+        const size_t Q = getPQ(img_w, pool_w, pad_w, stride_w);
+        const size_t PQ = P * Q;
         res_h = P;
         res_w = Q;
-        auto start = 0;
-        auto stop = batch_size;
 
-        auto ii = start * CHW;
-        auto oi = start * CPQ;
+        if (res == nullptr)
+            res = DataObjectFactory::create<DTRes>(batch_size, num_channels * PQ, false);
 
-        // 1 / pool length for averaging
-        auto plen = static_cast<typename DTRes::VT>(1) / static_cast<typename DTRes::VT>(pool_w * pool_h);
+        const VT * valuesData = data->getValues();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipData = data->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
 
-        if (res == nullptr) {
-            res = DataObjectFactory::create<DTRes>(batch_size, CPQ, true);
+        // the first and last (exclusive) output column whose window covers the image column of the given offset in
+        // the window
+        std::vector<size_t> qBegin(pool_w);
+        std::vector<size_t> qEnd(pool_w);
+        for(size_t dw = 0; dw < pool_w; dw++) {
+            // q * stride_w + dw - pad_w in [0, img_w)
+            qBegin[dw] = dw >= pad_w ? 0 : (pad_w - dw + stride_w - 1) / stride_w;
+            qEnd[dw] = img_w + pad_w > dw ? std::min(Q, (img_w + pad_w - dw - 1) / stride_w + 1) : 0;
         }
-        if (P == 1 && Q == 1 && img_w == 1) {
-            //quick-path w/o materialized index arrays and
-            //simplified inner loops for P = 1, Q = 1, W = 1
-            uint32_t lenh = std::min(pool_h, img_h);
-            for (uint32_t i = start; i < stop; i++, oi += C)
-                for (uint32_t c = 0, off = ii + (i - start) * CHW; c < C; c++, off += img_h) {
-                    res->getValues()[oi + c] = OP<typename DTArg::VT>::run(OP<typename DTArg::VT>::getNeutralElement(),
-                                                                           data->getValues(), off, lenh, plen);
-                }
+        // the number of image columns in the window of each output column
+        std::vector<VT> colCounts(Q);
+        for(size_t q = 0; q < Q; q++) {
+            const size_t w0 = q * stride_w;
+            const size_t w1 = std::min(w0 + pool_w, img_w + pad_w);
+            colCounts[q] = static_cast<VT>(w1 - std::max(w0, pad_w));
         }
-        else if (stride_w == 1 && stride_h == 1 && pad_h == 0 && pad_w == 0) {
-            //quick-path w/o materialized index arrays
-            for (uint32_t i = start; i < stop; i++)
-                for (uint32_t c = 0, off = ii + (i - start) * CHW, oix = oi + (i - start) * CPQ; c < C; c++, off += HW)
-                    for (uint32_t p = 0; p < P; p++, oix += Q)
-                        for (uint32_t h = p; h < std::min(p + pool_h, img_h); h++)
-                            for (uint32_t q = 0, off2 = off + h * img_w; q < Q; q++) {
-                                res->getValues()[oix + q] = OP<typename DTArg::VT>::run(res->getValues()[oix + q],
-                                        data->getValues(), off2 + q, std::min(pool_w, img_w - q), plen);
+
+        const size_t numPlanes = batch_size * num_channels;
+        const size_t planesPerChunk = std::max<size_t>(1, MIN_CHUNK_CELLS / std::max<size_t>(1, HW));
+        const size_t numChunks = (numPlanes + planesPerChunk - 1) / planesPerChunk;
+        WorkerPool::parallelFor(dctx, numChunks, [&](size_t chunk) {
+            const size_t end = std::min(numPlanes, (chunk + 1) * planesPerChunk);
+            for(size_t plane = chunk * planesPerChunk; plane < end; plane++) {
+                const size_t n = plane / num_channels;
+                const size_t c = plane % num_channels;
+                const VT * in = valuesData + n * rowSkipData + c * HW;
+                VT * out = valuesRes + n * rowSkipRes + c * PQ;
+                for(size_t p = 0; p < P; p++) {
+                    VT * outRow = out + p * Q;
+                    std::fill_n(outRow, Q, Op::getNeutralElement());
+                    // the image rows of the window
+                    const size_t h0 = p * stride_h;
+                    const size_t h1 = std::min(h0 + pool_h, img_h + pad_h);
+                    const size_t hBegin = std::max(h0, pad_h) - pad_h;
+                    const size_t hEnd = h1 - pad_h;
+                    for(size_t h = hBegin; h < hEnd; h++) {
+                        const VT * inRow = in + h * img_w;
+                        for(size_t dw = 0; dw < pool_w; dw++) {
+                            // the image column of output column q is q * stride_w + dw - pad_w
+                            if(stride_w == 1) {
+                                #pragma omp simd
+                                for(size_t q = qBegin[dw]; q < qEnd[dw]; q++)
+                                    outRow[q] = Op::combine(outRow[q], inRow[q + dw - pad_w]);
                             }
-        }
-        else
-            throw std::runtime_error("ToDo: pooling general case with stride & padding");
+                            else {
+                                for(size_t q = qBegin[dw]; q < qEnd[dw]; q++)
+                                    outRow[q] = Op::combine(outRow[q], inRow[q * stride_w + dw - pad_w]);
+                            }
+                        }
+                    }
+                    if(!Op::isMAX()) {
+                        const VT rowCount = static_cast<VT>(hEnd - hBegin);
+                        #pragma omp simd
+                        for(size_t q = 0; q < Q; q++)
+                            outRow[q] /= rowCount * colCounts[q];
+                    }
+                }
+            }
+        });
     }
 
     template struct Forward<AVG, DenseMatrix<float>, DenseMatrix<float>>;
@@ -81,4 +133,3 @@ namespace Pooling {
     template struct Forward<MAX, DenseMatrix<float>, DenseMatrix<float>>;
     template struct Forward<MAX, DenseMatrix<double>, DenseMatrix<double>>;
 }
-
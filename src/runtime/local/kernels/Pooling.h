@@ -22,8 +22,6 @@
 #include <runtime/local/datastructures/DenseMatrix.h>
 
 #include <limits>
-#include <random>
-#include <type_traits>
 
 #include <cassert>
 #include <cstddef>
@@ -33,13 +31,8 @@ namespace Pooling {
 
     template<typename VT>
     struct AVG {
-        static inline VT run(VT initial_value, const VT *in, uint32_t start, uint32_t length, VT plen) {
-            VT ret = 0;
-            auto end = start + length;
-            for (auto i = start; i < end; ++i)
-                ret += in[i];
-            return ret * plen + initial_value;
-        }
+        // the sum of the window, divided by the number of its cells within the image (excluding the padding)
+        static inline VT combine(VT acc, VT x) { return acc + x; }
 
         static inline VT getNeutralElement() { return 0; }
         static inline bool isMAX() { return false; }
@@ -47,19 +40,19 @@ namespace Pooling {
 
     template<typename VT>
     struct MAX {
-        static inline VT
-        run(VT initial_value, const VT *in, uint32_t start, uint32_t length, __attribute__((unused)) VT plen) {
-            VT ret = initial_value;
-            auto end = start + length;
-            for (auto i = start; i < end; ++i)
-                ret = std::max(ret, in[i]);
-            return ret;
-        }
+        static inline VT combine(VT acc, VT x) { return x > acc ? x : acc; }
 
-        static inline VT getNeutralElement() { return std::numeric_limits<VT>::max(); }
+        static inline VT getNeutralElement() { return std::numeric_limits<VT>::lowest(); }
         static inline bool isMAX() { return true; }
     };
 
+    /**
+     * @brief Pools the windows of each channel of each image (a row of `data` in NCHW layout), with any stride and
+     * padding.
+     *
+     * The channels of all images are pooled in parallel chunks. Within a channel, the windows of a row of outputs are
+     * combined one cell offset of the window at a time over all outputs of the row, which the compiler vectorizes.
+     */
     template<template<typename> class OP, typename DTRes, typename DTArg>
     struct Forward {
         static void apply(DTRes *&res, size_t& res_h, size_t& res_w,
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_PREFETCHREAD_H
+#define SRC_RUNTIME_LOCAL_KERNELS_PREFETCHREAD_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/Structure.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/AsyncReads.h>
+#include <runtime/local/kernels/Read.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <cstdint>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+// reads the file into a matrix of the given value type
+template<template<typename> class DT>
+Structure * readMatrixAs(const std::string & filename, ValueTypeCode valueType, DCTX(ctx)) {
+    switch(valueType) {
+#define READ_MATRIX_AS(vtc, VT) \
+        case ValueTypeCode::vtc: { \
+            DT<VT> * res = nullptr; \
+            Read<DT<VT>>::readFile(res, filename.c_str(), ctx); \
+            return res; \
+        }
+        READ_MATRIX_AS(SI8, int8_t)
+        READ_MATRIX_AS(SI32, int32_t)
+        READ_MATRIX_AS(SI64, int64_t)
+        READ_MATRIX_AS(UI8, uint8_t)
+        READ_MATRIX_AS(UI32, uint32_t)
+        READ_MATRIX_AS(UI64, uint64_t)
+        READ_MATRIX_AS(F32, float)
+        READ_MATRIX_AS(F64, double)
+#undef READ_MATRIX_AS
+        default:
+            throw std::runtime_error("prefetchRead: unsupported value type");
+    }
+}
+
+/**
+ * @brief Starts reading a file in the background, such that the `read` kernel
+ * of the same file, data type, and value type takes the data object without
+ * waiting for the file, if the read finished in the meantime.
+ *
+ * The compiler inserts this kernel ahead of a read (see PrefetchReadsPass),
+ * after the last operation that might write files.
+ *
+ * @param dataType The data type of the result, see `AsyncReadDataType`.
+ * @param valueType The `ValueTypeCode` of a matrix, ignored for frames.
+ */
+inline void prefetchRead(const char * filename, int64_t dataType, int64_t valueType, DCTX(ctx)) {
+    if(ctx == nullptr)
+        return;
+    const std::string fn(filename);
+    const auto dt = static_cast<AsyncReadDataType>(dataType);
+    const auto vtc = static_cast<ValueTypeCode>(valueType);
+    std::function<Structure *()> read;
+    switch(dt) {
+        case AsyncReadDataType::DenseMatrix:
+            read = [fn, vtc, ctx]() { return readMatrixAs<DenseMatrix>(fn, vtc, ctx); };
+            break;
+        case AsyncReadDataType::CSRMatrix:
+            read = [fn, vtc, ctx]() { return readMatrixAs<CSRMatrix>(fn, vtc, ctx); };
+            break;
+        case AsyncReadDataType::Frame:
+            valueType = -1;
+            read = [fn, ctx]() -> Structure * {
+                Frame * res = nullptr;
+                Read<Frame>::readFile(res, fn.c_str(), ctx);
+                return res;
+            };
+            break;
+        default:
+            throw std::runtime_error("prefetchRead: unsupported data type");
+    }
+    AsyncReads::getOrCreate(ctx)->submit({fn, dt, valueType}, std::move(read));
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_PREFETCHREAD_H
@@ -35,12 +35,12 @@
  */
 template<class DT>
 void printObj(const DT * arg, bool newline, bool err, DCTX(ctx)) {
-    arg->print(err ? std::cerr : std::cout);
+    arg->print(getPrintStream(err, ctx));
 }
 
 template<>
 void printObj(const char * arg, bool newline, bool err, DCTX(ctx)) {
-    std::ostream & os = err ? std::cerr : std::cout;
+    std::ostream & os = getPrintStream(err, ctx);
     os << arg;
     if(newline)
         os << std::endl;
@@ -32,7 +32,7 @@
  */
 template<typename VT>
 void printSca(VT arg, bool newline, bool err, DCTX(ctx)) {
-    std::ostream & os = err ? std::cerr : std::cout;
+    std::ostream & os = getPrintStream(err, ctx);
     os << arg;
     if(newline)
         os << std::endl;
@@ -41,14 +41,14 @@ void printSca(VT arg, bool newline, bool err, DCTX(ctx)) {
 //For printing int8_t/uint8_t as numbers as opposed to characters
 template<>
 void printSca(int8_t arg, bool newline, bool err, DCTX(ctx)) {
-    std::ostream & os = err ? std::cerr : std::cout;
+    std::ostream & os = getPrintStream(err, ctx);
     os << static_cast<int32_t>(arg);
     if(newline)
         os << std::endl;
 }
 template<>
 void printSca(uint8_t arg, bool newline, bool err, DCTX(ctx)) {
-    std::ostream & os = err ? std::cerr : std::cout;
+    std::ostream & os = getPrintStream(err, ctx);
     os << static_cast<uint32_t>(arg);
     if(newline)
         os << std::endl;
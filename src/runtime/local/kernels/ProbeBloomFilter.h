@@ -0,0 +1,71 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_PROBEBLOOMFILTER_H
+#define SRC_RUNTIME_LOCAL_KERNELS_PROBEBLOOMFILTER_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/kernels/BloomFilters.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Selects the rows of a frame whose values of a column may be in a
+ * blocked Bloom filter (see `buildBloomFilter`), as a bit vector for
+ * `filterRow`. A row is never dropped if its value is in the filter, but a
+ * few rows whose values are not in it may be selected.
+ *
+ * @param res The single-column matrix of ones for the selected rows and
+ * zeros for the others
+ * @param arg The frame
+ * @param on The label of the column, which must have the value type of the
+ * column the filter was built on
+ * @param filter The filter
+ */
+template<typename VTSel>
+void probeBloomFilter(DenseMatrix<VTSel> *& res, const Frame * arg, const char * on,
+        const DenseMatrix<uint64_t> * filter, DCTX(ctx)) {
+    const size_t c = arg->getColumnIdx(on);
+    if(filter->getNumCols() != 1 || filter->getRowSkip() != 1 || filter->getNumRows() < 2)
+        throw std::runtime_error("probeBloomFilter: the filter must be a single-column matrix of its words");
+    const uint64_t * words = filter->getValues();
+    const size_t numWords = filter->getNumRows() - 1;
+    if(static_cast<ValueTypeCode>(words[numWords]) != arg->getColumnType(c))
+        throw std::runtime_error("probeBloomFilter: the column " + std::string(on) + " has the value type "
+                + ValueTypeUtils::cppNameForCode(arg->getColumnType(c))
+                + ", but the filter was built on another value type");
+
+    const size_t numRows = arg->getNumRows();
+    if(res == nullptr)
+        res = DataObjectFactory::create<DenseMatrix<VTSel>>(numRows, 1, false);
+    BloomFilters::probe(res->getValues(), KeyIndexes::Keys(arg, {c}), numRows, words, numWords, ctx);
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_PROBEBLOOMFILTER_H
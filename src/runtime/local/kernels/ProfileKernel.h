@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_PROFILEKERNEL_H
+#define SRC_RUNTIME_LOCAL_KERNELS_PROFILEKERNEL_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/Structure.h>
+#include <runtime/local/instrumentation/KernelProfiler.h>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+// ****************************************************************************
+// Hooks around the kernel calls
+// ****************************************************************************
+// The ProfileKernelsPass surrounds each kernel call by these hooks: the inputs
+// and the cost estimates of the compiler are recorded before the call, and the
+// outputs after it.
+
+inline void profileKernelInput(const Structure * arg, DCTX(ctx)) {
+    KernelProfiler::get().addInput(arg);
+}
+
+inline void profileKernelCost(double flops, double bytesRead, double bytesWritten, DCTX(ctx)) {
+    KernelProfiler::get().setCost(flops, bytesRead, bytesWritten);
+}
+
+inline void profileKernelBegin(const char * kernel, const char * location, DCTX(ctx)) {
+    KernelProfiler::get().begin(kernel, location, ctx->config.profile_perf_counters);
+}
+
+inline void profileKernelEnd(DCTX(ctx)) {
+    KernelProfiler::get().end();
+}
+
+inline void profileKernelOutput(const Structure * res, DCTX(ctx)) {
+    KernelProfiler::get().addOutput(res);
+}
+
+/**
+ * @brief Prints the summary of the profiled kernel calls and their roofline analysis, if they have cost estimates,
+ * and writes them as a Chrome trace to the file of `profile_trace_file`, if any, at the end of the program.
+ */
+inline void profileKernelReport(DCTX(ctx)) {
+    KernelProfiler & profiler = KernelProfiler::get();
+    profiler.printSummary(std::cerr);
+    if(profiler.hasCosts()) {
+        const DaphneUserConfig & config = ctx->config;
+        KernelProfiler::Peaks peaks{config.machine_peak_gflops, config.machine_peak_gbps};
+        if(peaks.gflops <= 0 || peaks.gbps <= 0) {
+            const int numThreads = config.numberOfThreads > 0
+                    ? config.numberOfThreads : static_cast<int>(std::thread::hardware_concurrency());
+            const KernelProfiler::Peaks estimated = KernelProfiler::estimatePeaks(numThreads);
+            if(peaks.gflops <= 0)
+                peaks.gflops = estimated.gflops;
+            if(peaks.gbps <= 0)
+                peaks.gbps = estimated.gbps;
+        }
+        profiler.printRoofline(std::cerr, peaks);
+    }
+    const std::string & traceFile = ctx->config.profile_trace_file;
+    if(!traceFile.empty()) {
+        std::ofstream ofs(traceFile);
+        profiler.writeChromeTrace(ofs);
+        if(!ofs)
+            throw std::runtime_error("profileKernelReport: cannot write the kernel trace to " + traceFile);
+    }
+    profiler.clear();
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_PROFILEKERNEL_H
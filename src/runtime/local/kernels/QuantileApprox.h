@@ -0,0 +1,149 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/DeduceType.h>
+#include <util/KllSketch.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// don't sketch fewer values than this on separate threads
+constexpr size_t QUANTILEAPPROX_CHUNK_VALUES = 1 << 16;
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTArg>
+struct QuantileApprox {
+    static void apply(DTRes *& res, const DTArg * arg, double q, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+/**
+ * @brief Approximates the `q`-quantile of each column of `arg` (e.g., the
+ * median for `q` = 0.5) by a KLL sketch of the column, computed on all
+ * threads, without ordering the column.
+ *
+ * The result is a row of the quantiles of the columns, a column of only
+ * missing values (NaNs) has the quantile NaN. See `KllSketch` for the error.
+ */
+template<class DTRes, class DTArg>
+void quantileApprox(DTRes *& res, const DTArg * arg, double q, DCTX(ctx)) {
+    QuantileApprox<DTRes, DTArg>::apply(res, arg, q, ctx);
+}
+
+/**
+ * @brief Adds the `numRows` values, `stride` apart from each other, to the
+ * KLL sketch `res`, sketching chunks of them in parallel and merging their
+ * sketches.
+ *
+ * Sketches of different columns, e.g., of the partitions of a column on
+ * different workers, can be merged to a sketch of all their values if they
+ * have the same `k` (see `KllSketch::merge`).
+ */
+template<typename VT>
+void quantileApproxSketch(KllSketch & res, const VT * values, size_t numRows, size_t stride, DCTX(ctx)) {
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(64, numRows / QUANTILEAPPROX_CHUNK_VALUES));
+    if(numChunks == 1) {
+        res.add(values, numRows, stride);
+        return;
+    }
+    std::vector<KllSketch> chunks;
+    for(size_t c = 0; c < numChunks; c++)
+        chunks.emplace_back(res.getK(), c + 1);
+    WorkerPool::parallelFor(ctx, numChunks, [&](size_t c) {
+        const size_t begin = numRows * c / numChunks;
+        chunks[c].add(values + begin * stride, numRows * (c + 1) / numChunks - begin, stride);
+    });
+    for(const KllSketch & chunk : chunks)
+        res.merge(chunk);
+}
+
+// ****************************************************************************
+// Helpers
+// ****************************************************************************
+
+template<typename VT>
+struct QuantileApproxColumn {
+    static void apply(KllSketch & res, const Frame * arg, size_t c, DCTX(ctx)) {
+        quantileApproxSketch(res, static_cast<const VT *>(arg->getColumnRaw(c)), arg->getNumRows(), 1, ctx);
+    }
+};
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VTRes, typename VTArg>
+struct QuantileApprox<DenseMatrix<VTRes>, DenseMatrix<VTArg>> {
+    static void apply(DenseMatrix<VTRes> *& res, const DenseMatrix<VTArg> * arg, double q, DCTX(ctx)) {
+        if(!(q >= 0 && q <= 1))
+            throw std::runtime_error("quantileApprox: the quantile must be in [0, 1], but is " + std::to_string(q));
+        const size_t numCols = arg->getNumCols();
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VTRes>>(1, numCols, false);
+        for(size_t c = 0; c < numCols; c++) {
+            KllSketch sketch;
+            quantileApproxSketch(sketch, arg->getValues() + c, arg->getNumRows(), arg->getRowSkip(), ctx);
+            res->set(0, c, static_cast<VTRes>(sketch.quantile(q)));
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- Frame
+// ----------------------------------------------------------------------------
+
+template<typename VTRes>
+struct QuantileApprox<DenseMatrix<VTRes>, Frame> {
+    static void apply(DenseMatrix<VTRes> *& res, const Frame * arg, double q, DCTX(ctx)) {
+        if(!(q >= 0 && q <= 1))
+            throw std::runtime_error("quantileApprox: the quantile must be in [0, 1], but is " + std::to_string(q));
+        const size_t numCols = arg->getNumCols();
+        for(size_t c = 0; c < numCols; c++)
+            if(arg->getColumnType(c) == ValueTypeCode::STR)
+                throw std::runtime_error("quantileApprox: the column " + arg->getLabels()[c]
+                        + " is not numeric");
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VTRes>>(1, numCols, false);
+        for(size_t c = 0; c < numCols; c++) {
+            KllSketch sketch;
+            DeduceValueTypeAndExecute<QuantileApproxColumn>::apply(arg->getColumnType(c), sketch, arg, c, ctx);
+            res->set(0, c, static_cast<VTRes>(sketch.quantile(q)));
+        }
+    }
+};
@@ -22,6 +22,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -41,7 +42,7 @@ void quantize(DTRes *& res, const DTArg * arg, float min, float max, DCTX(ctx))
     Quantize<DTRes, DTArg>::apply(res, arg, min, max, ctx);
 }
 
-void calc_quantization_params(float min, float max, float& scale, uint8_t& quantized_zero) {
+inline void calc_quantization_params(float min, float max, float& scale, uint8_t& quantized_zero) {
     // Make sure that 0 is included
     min = (min > 0) ? 0 : min;
     max = (max < 0) ? 0 : max;
@@ -64,7 +65,7 @@ void calc_quantization_params(float min, float max, float& scale, uint8_t& quant
     }
 }
 
-uint8_t quantize_value(float a, float scale, uint8_t quantized_zero) {
+inline uint8_t quantize_value(float a, float scale, uint8_t quantized_zero) {
     // Map
     float value = static_cast<float>(quantized_zero) + a/scale;
 
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/Quantize.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+/**
+ * @brief Multiplies two matrices quantized by `Quantize` with the ranges `[lhsMin, lhsMax]` and `[rhsMin, rhsMax]`,
+ * accumulating the products of their 8-bit values in 32-bit integers.
+ *
+ * The result is either the accumulators relative to the zero points of both sides (`int32_t`), or these dequantized
+ * to the product of the real values (`float`), which is applied as an epilogue to the accumulators while they are in
+ * registers.
+ */
+template<class DTRes, class DTLhs, class DTRhs>
+struct QuantizedMatMul {
+    static void apply(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, float lhsMin, float lhsMax, float rhsMin,
+            float rhsMax, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+template<class DTRes, class DTLhs, class DTRhs>
+void quantizedMatMul(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, float lhsMin, float lhsMax, float rhsMin,
+        float rhsMax, DCTX(ctx)) {
+    QuantizedMatMul<DTRes, DTLhs, DTRhs>::apply(res, lhs, rhs, lhsMin, lhsMax, rhsMin, rhsMax, ctx);
+}
+
+// ****************************************************************************
+// Blocked integer multiplication
+// ****************************************************************************
+
+/**
+ * @brief The building blocks of the quantized multiplication: the rhs is packed once, such that the columns of a
+ * block are contiguous, and each chunk of rows of the lhs is multiplied with panels of these blocks, which stay in the
+ * L2 cache for all rows of the chunk.
+ *
+ * With AVX-512 VNNI, a block has 16 columns of groups of 4 rows, as `vpdpbusd` multiplies unsigned with signed bytes
+ * and adds groups of 4 products to 16 32-bit lanes. The rhs is shifted to signed bytes by subtracting 128, which the
+ * correction by the row sums of the lhs adds back. Without VNNI, the columns of the rhs are transposed and multiplied
+ * by a loop the compiler vectorizes.
+ *
+ * The zero points are subtracted after the accumulation: with the row sums `ra` of the lhs, the column sums `cb` of
+ * the rhs, and the inner dimension `k`,
+ * `sum((a - za) * (b - zb)) = sum(a * b) - zb * ra - za * cb + k * za * zb`.
+ */
+namespace QuantizedMatMulBlocks {
+    // the columns of a block
+    constexpr size_t BLOCK_COLS = 16;
+    // the blocks of a panel, 256 columns
+    constexpr size_t PANEL_BLOCKS = 16;
+    // the rows of the lhs of a chunk
+    constexpr size_t CHUNK_ROWS = 64;
+
+    struct PackedRhs {
+        size_t numRows;
+        size_t numCols;
+        // the rows rounded up to a multiple of 4
+        size_t numRows4;
+        size_t numBlocks;
+        std::vector<int8_t> values;
+        std::vector<int32_t> colSums;
+    };
+
+    inline PackedRhs pack(const DenseMatrix<uint8_t> * rhs) {
+        PackedRhs p;
+        p.numRows = rhs->getNumRows();
+        p.numCols = rhs->getNumCols();
+        p.numRows4 = (p.numRows + 3) / 4 * 4;
+        p.numBlocks = (p.numCols + BLOCK_COLS - 1) / BLOCK_COLS;
+        p.values.assign(p.numBlocks * p.numRows4 * BLOCK_COLS, 0);
+        p.colSums.assign(p.numCols, 0);
+        const uint8_t * valuesRhs = rhs->getValues();
+        const size_t rowSkip = rhs->getRowSkip();
+        for(size_t r = 0; r < p.numRows; r++)
+            for(size_t c = 0; c < p.numCols; c++) {
+                const uint8_t v = valuesRhs[r * rowSkip + c];
+                p.colSums[c] += v;
+                const size_t block = c / BLOCK_COLS;
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+                // 16 columns of 4 consecutive rows each
+                p.values[(block * p.numRows4 + r / 4 * 4) * BLOCK_COLS + (c % BLOCK_COLS) * 4 + r % 4] =
+                        static_cast<int8_t>(static_cast<int>(v) - 128);
+#else
+                // the columns of the block one after the other
+                p.values[(block * BLOCK_COLS + c % BLOCK_COLS) * p.numRows4 + r] = static_cast<int8_t>(v ^ 0x80);
+#endif
+            }
+        return p;
+    }
+
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+    /**
+     * @brief Computes `acc[j] = sum(a * (b - 128))` for the `NB` blocks starting at the given one.
+     */
+    template<size_t NB>
+    inline void multiplyBlocks(const uint8_t * a, const PackedRhs & p, size_t block, int32_t * acc) {
+        __m512i sums[NB];
+        for(size_t b = 0; b < NB; b++)
+            sums[b] = _mm512_setzero_si512();
+        const int8_t * bValues = p.values.data() + block * p.numRows4 * BLOCK_COLS;
+        const size_t blockSize = p.numRows4 * BLOCK_COLS;
+        for(size_t r = 0; r < p.numRows4; r += 4) {
+            int32_t a4;
+            std::copy(a + r, a + r + 4, reinterpret_cast<uint8_t *>(&a4));
+            const __m512i va = _mm512_set1_epi32(a4);
+            for(size_t b = 0; b < NB; b++)
+                sums[b] = _mm512_dpbusd_epi32(sums[b], va,
+                        _mm512_loadu_si512(bValues + b * blockSize + r * BLOCK_COLS));
+        }
+        for(size_t b = 0; b < NB; b++)
+            _mm512_storeu_si512(acc + b * BLOCK_COLS, sums[b]);
+    }
+#else
+    template<size_t NB>
+    inline void multiplyBlocks(const uint8_t * a, const PackedRhs & p, size_t block, int32_t * acc) {
+        for(size_t j = 0; j < NB * BLOCK_COLS; j++) {
+            const int8_t * col = p.values.data() + (block * BLOCK_COLS + j) * p.numRows4;
+            int32_t sum = 0;
+            for(size_t r = 0; r < p.numRows4; r++)
+                sum += static_cast<int32_t>(a[r]) * static_cast<int32_t>(col[r]);
+            acc[j] = sum;
+        }
+    }
+#endif
+
+    /**
+     * @brief Multiplies the quantized matrices and calls `epilogue(row, col, acc)` with the accumulators relative to
+     * the zero points of both sides, in parallel chunks of rows.
+     */
+    template<class Epilogue>
+    void multiply(const DenseMatrix<uint8_t> * lhs, const DenseMatrix<uint8_t> * rhs, uint8_t lhsZero,
+            uint8_t rhsZero, Epilogue epilogue, DCTX(ctx)) {
+        const PackedRhs p = pack(rhs);
+        const size_t numRows = lhs->getNumRows();
+        const size_t numChunks = (numRows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        const int64_t za = lhsZero;
+        const int64_t zb = rhsZero;
+        const int64_t kzz = static_cast<int64_t>(p.numRows) * za * zb;
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t r0 = chunk * CHUNK_ROWS;
+            const size_t r1 = std::min(numRows, r0 + CHUNK_ROWS);
+            // the rows of the chunk, padded with zeros to the packed rows of the rhs, and their sums
+            std::vector<uint8_t> a((r1 - r0) * p.numRows4, 0);
+            std::vector<int32_t> rowSums(r1 - r0, 0);
+            for(size_t r = r0; r < r1; r++) {
+                const uint8_t * row = lhs->getValues() + r * lhs->getRowSkip();
+                std::copy(row, row + p.numRows, a.data() + (r - r0) * p.numRows4);
+                for(size_t k = 0; k < p.numRows; k++)
+                    rowSums[r - r0] += row[k];
+            }
+            int32_t acc[PANEL_BLOCKS * BLOCK_COLS];
+            for(size_t panel = 0; panel < p.numBlocks; panel += PANEL_BLOCKS) {
+                const size_t panelEnd = std::min(p.numBlocks, panel + PANEL_BLOCKS);
+                for(size_t r = r0; r < r1; r++) {
+                    const uint8_t * aRow = a.data() + (r - r0) * p.numRows4;
+                    size_t block = panel;
+                    for(; block + 4 <= panelEnd; block += 4)
+                        multiplyBlocks<4>(aRow, p, block, acc + (block - panel) * BLOCK_COLS);
+                    for(; block < panelEnd; block++)
+                        multiplyBlocks<1>(aRow, p, block, acc + (block - panel) * BLOCK_COLS);
+                    // sum(a * b) = sum(a * (b - 128)) + 128 * ra
+                    const int64_t ra = rowSums[r - r0];
+                    const int64_t rowCorrection = 128 * ra - zb * ra + kzz;
+                    const size_t c0 = panel * BLOCK_COLS;
+                    const size_t c1 = std::min(p.numCols, panelEnd * BLOCK_COLS);
+                    for(size_t c = c0; c < c1; c++)
+                        epilogue(r, c, static_cast<int32_t>(acc[c - c0] + rowCorrection - za * p.colSums[c]));
+                }
+            }
+        });
+    }
+
+    inline void checkShapes(const DenseMatrix<uint8_t> * lhs, const DenseMatrix<uint8_t> * rhs) {
+        if(lhs->getNumCols() != rhs->getNumRows())
+            throw std::runtime_error("QuantizedMatMul: #cols of lhs and #rows of rhs must be the same");
+        // the largest accumulator is k * 255 * 255
+        if(lhs->getNumCols() > static_cast<size_t>(INT32_MAX) / (255 * 255))
+            throw std::runtime_error("QuantizedMatMul: the inner dimension is too large for 32-bit accumulators");
+    }
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<>
+struct QuantizedMatMul<DenseMatrix<int32_t>, DenseMatrix<uint8_t>, DenseMatrix<uint8_t>> {
+    static void apply(DenseMatrix<int32_t> *& res, const DenseMatrix<uint8_t> * lhs, const DenseMatrix<uint8_t> * rhs,
+            float lhsMin, float lhsMax, float rhsMin, float rhsMax, DCTX(ctx)) {
+        QuantizedMatMulBlocks::checkShapes(lhs, rhs);
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<int32_t>>(lhs->getNumRows(), rhs->getNumCols(), false);
+
+        float lhsScale, rhsScale;
+        uint8_t lhsZero, rhsZero;
+        calc_quantization_params(lhsMin, lhsMax, lhsScale, lhsZero);
+        calc_quantization_params(rhsMin, rhsMax, rhsScale, rhsZero);
+
+        int32_t * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+        QuantizedMatMulBlocks::multiply(lhs, rhs, lhsZero, rhsZero, [=](size_t r, size_t c, int32_t acc) {
+            valuesRes[r * rowSkipRes + c] = acc;
+        }, ctx);
+    }
+};
+
+template<>
+struct QuantizedMatMul<DenseMatrix<float>, DenseMatrix<uint8_t>, DenseMatrix<uint8_t>> {
+    static void apply(DenseMatrix<float> *& res, const DenseMatrix<uint8_t> * lhs, const DenseMatrix<uint8_t> * rhs,
+            float lhsMin, float lhsMax, float rhsMin, float rhsMax, DCTX(ctx)) {
+        QuantizedMatMulBlocks::checkShapes(lhs, rhs);
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<float>>(lhs->getNumRows(), rhs->getNumCols(), false);
+
+        float lhsScale, rhsScale;
+        uint8_t lhsZero, rhsZero;
+        calc_quantization_params(lhsMin, lhsMax, lhsScale, lhsZero);
+        calc_quantization_params(rhsMin, rhsMax, rhsScale, rhsZero);
+
+        // dequantization as the epilogue
+        const float scale = lhsScale * rhsScale;
+        float * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+        QuantizedMatMulBlocks::multiply(lhs, rhs, lhsZero, rhsZero, [=](size_t r, size_t c, int32_t acc) {
+            valuesRes[r * rowSkipRes + c] = scale * static_cast<float>(acc);
+        }, ctx);
+    }
+};
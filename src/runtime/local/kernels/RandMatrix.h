@@ -21,17 +21,157 @@
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
 #include <algorithm>
 #include <random>
-#include <set>
 #include <type_traits>
+#include <vector>
 
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <chrono>
+
+// ****************************************************************************
+// Counter-based generation in blocks
+// ****************************************************************************
+
+/**
+ * @brief The building blocks of the random matrix generation: the cells are generated in blocks of rows, each from a
+ * generator of its own, which is derived from the seed and the index of the block only. Thus, the blocks are
+ * generated in parallel and the result is the same for any number of threads, and any block can be generated without
+ * the ones before it.
+ *
+ * The number of non-zeros of the cells before a cell is a function of the sparsity, such that the total number of
+ * non-zeros is exact and each block knows its share (and its offset in a CSR matrix) upfront.
+ */
+namespace RandBlocks {
+    // the number of cells of a block (fewer if a row is longer)
+    constexpr size_t BLOCK_CELLS = 1 << 16;
+    // the draws reserved for each block in the stream of the generator
+    constexpr uint64_t BLOCK_DRAWS = uint64_t(1) << 32;
+
+    /**
+     * @brief The SplitMix64 generator, whose state is a counter. Jumping ahead by `n` draws is a single
+     * multiply-add, which places the blocks at disjoint windows of one stream.
+     */
+    class Generator {
+        static constexpr uint64_t GAMMA = 0x9e3779b97f4a7c15ull;
+        uint64_t state;
+
+    public:
+        using result_type = uint64_t;
+
+        explicit Generator(uint64_t seed) : state(seed) {}
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+        result_type operator()() {
+            uint64_t z = (state += GAMMA);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        void jump(uint64_t n) {
+            state += n * GAMMA;
+        }
+
+        // a double in [0, 1)
+        double uniform() {
+            return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+        }
+    };
+
+    template<typename VT>
+    using Distribution = typename std::conditional<
+            std::is_floating_point<VT>::value,
+            std::uniform_real_distribution<VT>,
+            std::uniform_int_distribution<VT>
+    >::type;
+
+    template<class Distr>
+    typename Distr::result_type drawNonZero(Distr & distrVal, Generator & gen) {
+        using VT = typename Distr::result_type;
+        static_assert(
+                std::is_floating_point<VT>::value || std::is_integral<VT>::value,
+                "the value type must be either floating point or integral"
+        );
+        VT v = distrVal(gen);
+        while(v == 0)
+            v = distrVal(gen);
+        return v;
+    }
+
+    // a random seed for -1
+    inline uint64_t getSeed(int64_t seed) {
+        if(seed != -1)
+            return static_cast<uint64_t>(seed);
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+
+    struct Layout {
+        const size_t numRows;
+        const size_t numCols;
+        const double sparsity;
+        const uint64_t seed;
+        const size_t rowsPerBlock;
+        const size_t numBlocks;
+
+        Layout(size_t numRows, size_t numCols, double sparsity, uint64_t seed) :
+                numRows(numRows), numCols(numCols), sparsity(sparsity), seed(seed),
+                rowsPerBlock(std::max<size_t>(1, BLOCK_CELLS / numCols)),
+                numBlocks((numRows + rowsPerBlock - 1) / rowsPerBlock) {}
+
+        size_t getFirstRow(size_t b) const {
+            return std::min(numRows, b * rowsPerBlock);
+        }
+
+        // the number of non-zeros of the cells before the given one (in row-major order)
+        size_t getNumNonZerosBefore(size_t cell) const {
+            return static_cast<size_t>(std::round(sparsity * static_cast<double>(cell)));
+        }
+
+        Generator getGenerator(size_t b) const {
+            Generator gen(seed);
+            gen.jump(b * BLOCK_DRAWS);
+            return gen;
+        }
+
+        /**
+         * @brief Draws the positions of the non-zeros of the given block, relative to its first cell, in ascending
+         * order.
+         */
+        void samplePositions(size_t b, Generator & gen, std::vector<size_t> & positions) const {
+            const size_t first = getFirstRow(b) * numCols;
+            const size_t numCells = getFirstRow(b + 1) * numCols - first;
+            const size_t k = getNumNonZerosBefore(first + numCells) - getNumNonZerosBefore(first);
+            positions.clear();
+            positions.reserve(k);
+            if(k * 8 < numCells) {
+                // few non-zeros: draw positions until k distinct ones are found
+                while(positions.size() < k) {
+                    while(positions.size() < k)
+                        positions.push_back(static_cast<size_t>(gen.uniform() * numCells));
+                    std::sort(positions.begin(), positions.end());
+                    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+                }
+            }
+            else {
+                // selection sampling: each cell is selected with the probability of the non-zeros still needed
+                size_t needed = k;
+                for(size_t i = 0; i < numCells && needed; i++)
+                    if(gen.uniform() * (numCells - i) < needed) {
+                        positions.push_back(i);
+                        needed--;
+                    }
+            }
+        }
+    };
+}
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -73,78 +213,21 @@ struct RandMatrix<DenseMatrix<VT>, VT> {
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
 
-        if (seed == -1) {
-            std::random_device rd;
-            std::uniform_int_distribution<int64_t> seedRnd;
-            seed = seedRnd(rd);
-        }
-
-        std::mt19937 genVal(seed);
-        std::mt19937 genIndex(seed * 3);
-        
-        static_assert(
-                std::is_floating_point<VT>::value || std::is_integral<VT>::value,
-                "the value type must be either floating point or integral"
-        );
-        typename std::conditional<
-                std::is_floating_point<VT>::value,
-                std::uniform_real_distribution<VT>,
-                std::uniform_int_distribution<VT>
-        >::type distrVal(min, max);
-        std::uniform_int_distribution<int> distrIndex(0, numCols * numRows - 1);
-
+        const RandBlocks::Layout layout(numRows, numCols, sparsity, RandBlocks::getSeed(seed));
         VT * valuesRes = res->getValues();
-
-        // If sparsity >= 0.5, we initialize with random values and insert zeros,
-        // else if sparsity < 0.5, it is more efficient to initialize with zero values and insert random.
-        size_t insertedValuesLimit;
-        if (sparsity >= 0.5) {
-            insertedValuesLimit = size_t(round((1 - sparsity) * numCols * numRows));                    
-        } else {
-            insertedValuesLimit = size_t(round(sparsity * numCols * numRows));
-        }
-        
-        // Fill Matrix with non-zero/random values
-        // TODO It might be faster to pull the check on sparsity out of the
-        // loop, including a duplication of the loop.
-        for(size_t r = 0; r < numRows; r++) {
-            for(size_t c = 0; c < numCols; c++) {
-                if (sparsity >= 0.5) {
-                    valuesRes[c] = distrVal(genVal);
-                    while (valuesRes[c] == 0)
-                        valuesRes[c] = distrVal(genVal);
-                } else {
-                    valuesRes[c] = VT(0);
-                }
-            }
-            valuesRes += res->getRowSkip();
-        }
-
-        // Use Knuth's algorithm to calculate unique random indexes equal to insertedValuesLimit, to be set to zero/random value.
-        valuesRes = res->getValues();
-        size_t iRange, iSize;
-        iSize = 0;
-        // TODO It might be faster to pull the check on sparsity out of the
-        // loop, including a duplication of the loop.
-        // TODO If res->getRowSkip() == res->getNumCols(), it might be faster
-        // not to calculate row and col by / and %, but to directly use the
-        // generated index.
-        for (iRange = 0; iRange < (numCols * numRows) && iSize < insertedValuesLimit; iRange++) {            
-            size_t rRange = (numCols * numRows) - iRange;
-            size_t rSize = insertedValuesLimit - iSize;
-            if (fmod(distrIndex(genIndex), rRange) < rSize) {
-                size_t row = iRange / numCols;
-                size_t col = iRange % numCols; 
-                if (sparsity >= 0.5) {
-                    valuesRes[row * res->getRowSkip() + col] = VT(0);
-                } else {
-                    valuesRes[row * res->getRowSkip() + col] = distrVal(genVal);
-                    while (valuesRes[row * res->getRowSkip() + col] == 0)
-                        valuesRes[row * res->getRowSkip() + col] = distrVal(genVal);
-                }
-                iSize++;
-            }
-        }
+        const size_t rowSkip = res->getRowSkip();
+        WorkerPool::parallelFor(ctx, layout.numBlocks, [&](size_t b) {
+            RandBlocks::Generator gen = layout.getGenerator(b);
+            RandBlocks::Distribution<VT> distrVal(min, max);
+            const size_t r0 = layout.getFirstRow(b);
+            const size_t r1 = layout.getFirstRow(b + 1);
+            for(size_t r = r0; r < r1; r++)
+                std::fill_n(valuesRes + r * rowSkip, numCols, VT(0));
+            std::vector<size_t> positions;
+            layout.samplePositions(b, gen, positions);
+            for(size_t pos : positions)
+                valuesRes[(r0 + pos / numCols) * rowSkip + pos % numCols] = RandBlocks::drawNonZero(distrVal, gen);
+        });
     }
 };
 
@@ -158,100 +241,43 @@ struct RandMatrix<CSRMatrix<VT>, VT> {
         assert(numRows > 0 && "numRows must be > 0");
         assert(numCols > 0 && "numCols must be > 0");
         assert(min <= max && "min must be <= max");
+        assert((min != 0 || max != 0) &&
+               "min and max must not both be zero, consider setting sparsity to zero instead");
         assert(sparsity >= 0.0 && sparsity <= 1.0 &&
                "sparsity has to be in the interval [0.0, 1.0]");
 
+        const RandBlocks::Layout layout(numRows, numCols, sparsity, RandBlocks::getSeed(seed));
+
         // The exact number of non-zeros to generate.
-        // TODO Ideally, it should not be allowed that zero is included in [min, max].
-        const size_t nnz = static_cast<size_t>(round(numRows * numCols * sparsity));
-        
+        const size_t nnz = layout.getNumNonZerosBefore(numRows * numCols);
+
         if(res == nullptr)
             res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, nnz, false);
 
-        // Initialize pseudo random number generators.
-        if (seed == -1)
-            seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-        std::default_random_engine gen(seed);
-        
-        static_assert(
-                std::is_floating_point<VT>::value || std::is_integral<VT>::value,
-                "the value type must be either floating point or integral"
-        );
-        typename std::conditional<
-                std::is_floating_point<VT>::value,
-                std::uniform_real_distribution<VT>,
-                std::uniform_int_distribution<VT>
-        >::type distrVal(min, max);
-        
-        std::uniform_int_distribution<size_t> distrRow(0, numRows - 1);
-        std::uniform_int_distribution<size_t> distrCol(0, numCols - 1);
-        
-        // Generate non-zero values (positions in the matrix do not matter here).
+        // Each block writes its non-zeros and row offsets directly, starting at the number of non-zeros of the
+        // blocks before it, which is known without generating them.
         VT * valuesRes = res->getValues();
-        for(size_t i = 0; i < nnz; i++)
-            valuesRes[i] = distrVal(gen);
-        
-        // Randomly determine the number of non-zeros per row. Store them in
-        // the result matrix's rowOffsets array to avoid an additional
-        // allocation and to make the prefix sum more cache-efficient.
+        size_t * colIdxsRes = res->getColIdxs();
         size_t * rowOffsetsRes = res->getRowOffsets();
-        // We need signed ssize_t for the >0 check.
-        ssize_t * nnzPerRow = reinterpret_cast<ssize_t *>(rowOffsetsRes + 1);
-        if(sparsity <= 0.5) {
-            // Start with empty rows, increment nnz of random row until the
-            // desired total number of non-zeros is reached.
-            std::fill_n(nnzPerRow, numRows, 0);
-            size_t assigned = 0;
-            while(assigned < nnz) {
-                const size_t r = distrRow(gen);
-                if(nnzPerRow[r] < static_cast<ssize_t>(numCols)) {
-                    nnzPerRow[r]++;
-                    assigned++;
+        WorkerPool::parallelFor(ctx, layout.numBlocks, [&](size_t b) {
+            RandBlocks::Generator gen = layout.getGenerator(b);
+            RandBlocks::Distribution<VT> distrVal(min, max);
+            const size_t r0 = layout.getFirstRow(b);
+            const size_t r1 = layout.getFirstRow(b + 1);
+            std::vector<size_t> positions;
+            layout.samplePositions(b, gen, positions);
+            size_t i = layout.getNumNonZerosBefore(r0 * numCols);
+            auto it = positions.begin();
+            for(size_t r = r0; r < r1; r++) {
+                rowOffsetsRes[r] = i;
+                const size_t rowEnd = (r - r0 + 1) * numCols;
+                for(; it != positions.end() && *it < rowEnd; it++, i++) {
+                    colIdxsRes[i] = *it % numCols;
+                    valuesRes[i] = RandBlocks::drawNonZero(distrVal, gen);
                 }
             }
-        }
-        else {
-            // Start with full rows, decrement nnz of random row until the
-            // desired total number of non-zeros is reached.
-            std::fill_n(nnzPerRow, numRows, numCols);
-            size_t assigned = numRows * numCols;
-            while(assigned > nnz) {
-                const size_t r = distrRow(gen);
-                if(nnzPerRow[r] > 0) {
-                    nnzPerRow[r]--;
-                    assigned--;
-                }
-            }
-        }
-        
-        // Generate random column indexes, sorted within each row.
-        size_t * colIdxsRes = res->getColIdxs();
-        if(sparsity <= 0.5) {
-            // Use the generated column indexes.
-            for(size_t r = 0; r < numRows; r++) {
-                std::set<size_t> sortedColIdxs;
-                while(static_cast<ssize_t>(sortedColIdxs.size()) < nnzPerRow[r])
-                    sortedColIdxs.emplace(distrCol(gen));
-                for(auto it = sortedColIdxs.begin(); it != sortedColIdxs.end(); it++)
-                    *colIdxsRes++ = *it;
-            }
-        }
-        else {
-            // Use all but the generated column indexes.
-            for(size_t r = 0; r < numRows; r++) {
-                std::set<size_t> sortedColIdxs;
-                while(sortedColIdxs.size() < numCols - nnzPerRow[r])
-                    sortedColIdxs.emplace(distrCol(gen));
-                for(size_t c = 0; c < numCols; c++)
-                    if(!sortedColIdxs.count(c))
-                        *colIdxsRes++ = c;
-            }
-        }
-        
-        // Calculate the row offsets as the prefix sum over the nnz per row.
-        rowOffsetsRes[0] = 0;
-        for(size_t i = 1; i <= numRows; i++)
-            rowOffsetsRes[i] += rowOffsetsRes[i - 1];
+        });
+        rowOffsetsRes[numRows] = nnz;
     }
 };
 
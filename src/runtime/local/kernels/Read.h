@@ -21,16 +21,25 @@
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/ArrowIpc.h>
+#include <runtime/local/io/AsyncReads.h>
 #include <runtime/local/io/File.h>
+#include <runtime/local/io/ReadCache.h>
 #include <runtime/local/io/ReadCsv.h>
 #include <runtime/local/io/ReadMM.h>
+#include <runtime/local/io/ReadHDF5.h>
 #include <runtime/local/io/ReadParquet.h>
 #include <runtime/local/io/ReadDaphne.h>
+#include <runtime/local/kernels/CollectColumnStatistics.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <runtime/local/kernels/ZoneMaps.h>
 #include <parser/metadata/MetaDataParser.h>
 
+#include <stdexcept>
 #include <string>
 #include <regex>
 #include <map>
+#include <utility>
 
 struct FileExt {
 	static std::map<std::string, int> create_map() {
@@ -39,6 +48,12 @@ struct FileExt {
 		m["mtx"] = 1;
 		m["parquet"] = 2;
 		m["dbdf"] = 3;
+		// Arrow IPC: the file format (Feather v2) and the stream format
+		m["arrow"] = 4;
+		m["feather"] = 4;
+		m["arrows"] = 4;
+		m["h5"] = 5;
+		m["hdf5"] = 5;
 		return m;
 	}
 	static const std::map<std::string, int> map;
@@ -48,6 +63,36 @@ inline const std::map<std::string, int> FileExt::map = FileExt::create_map();
 
 int extValue(const char * filename);
 
+// takes the data object of the read of the file started ahead by prefetchRead, if there is one
+template<class DTRes>
+bool takePrefetchedRead(DTRes *& res, const char * filename, AsyncReadDataType dataType, int64_t valueType,
+        DCTX(ctx)) {
+	AsyncReads * reads = AsyncReads::get(ctx);
+	if(res != nullptr || reads == nullptr)
+		return false;
+	Structure * obj = reads->take({filename, dataType, valueType});
+	if(obj == nullptr)
+		return false;
+	res = static_cast<DTRes *>(obj);
+	return true;
+}
+
+// reads the file with the given function, or takes the data object read from it by an earlier run of this process if
+// reads are cached (see ReadCache)
+template<class DTRes>
+void readThroughCache(DTRes *& res, const char * filename, AsyncReadDataType dataType, int64_t valueType,
+        DCTX(ctx), void (*readFile)(DTRes *&, const char *, DCTX(ctx))) {
+	if(res != nullptr || ctx == nullptr || !ctx->config.cache_reads) {
+		readFile(res, filename, ctx);
+		return;
+	}
+	const ReadCache::Key key{filename, static_cast<int64_t>(dataType), valueType};
+	if((res = ReadCache::get().lookup<DTRes>(key)))
+		return;
+	readFile(res, filename, ctx);
+	ReadCache::get().insert(key, res);
+}
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
@@ -77,6 +122,12 @@ void read(DTRes *& res, const char * filename, DCTX(ctx)) {
 template<typename VT>
 struct Read<DenseMatrix<VT>> {
     static void apply(DenseMatrix<VT> *& res, const char * filename, DCTX(ctx)) {
+        const int64_t valueType = static_cast<int64_t>(ValueTypeUtils::codeFor<VT>);
+        if(!takePrefetchedRead(res, filename, AsyncReadDataType::DenseMatrix, valueType, ctx))
+            readThroughCache(res, filename, AsyncReadDataType::DenseMatrix, valueType, ctx, &readFile);
+    }
+
+    static void readFile(DenseMatrix<VT> *& res, const char * filename, DCTX(ctx)) {
 
 	FileMetaData fmd = MetaDataParser::readMetaData(filename);
 	int extv = extValue(filename);
@@ -86,10 +137,10 @@ struct Read<DenseMatrix<VT>> {
 			res = DataObjectFactory::create<DenseMatrix<VT>>(
 				fmd.numRows, fmd.numCols, false
 			);
-		readCsv(res, filename, fmd.numRows, fmd.numCols, ',');
+		readCsv(res, filename, fmd.numRows, fmd.numCols, ',', ctx);
 		break;
 	case 1:
-		readMM(res, filename);
+		readMM(res, filename, ctx);
 		break;
 #ifdef USE_ARROW
 	case 2:
@@ -97,15 +148,29 @@ struct Read<DenseMatrix<VT>> {
 			res = DataObjectFactory::create<DenseMatrix<VT>>(
 				fmd.numRows, fmd.numCols, false
 			);
-		readParquet(res, filename, fmd.numRows, fmd.numCols);
+		readParquet(res, filename, fmd.numRows, fmd.numCols, ctx);
 		break;
 #endif
 	case 3:
-		readDaphne(res, filename);
+		readDaphne(res, filename, ctx && ctx->config.mmap_daphne_files, ctx);
                 break;
+#ifdef USE_ARROW
+	case 4:
+		if(res != nullptr)
+			throw std::runtime_error("Arrow IPC files cannot be read into an existing matrix");
+		readArrowIpc(res, filename, nullptr, nullptr, ctx);
+		break;
+#endif
+#ifdef USE_HDF5
+	case 5:
+		readHDF5(res, filename, ctx);
+		break;
+#endif
         default:
             throw std::runtime_error("File extension not supported");
 	}
+	if(ctx && ctx->config.zone_maps)
+		ZoneMaps::computeMatrix(res, ctx);
     }
 };
 
@@ -116,6 +181,12 @@ struct Read<DenseMatrix<VT>> {
 template<typename VT>
 struct Read<CSRMatrix<VT>> {
     static void apply(CSRMatrix<VT> *& res, const char * filename, DCTX(ctx)) {
+        const int64_t valueType = static_cast<int64_t>(ValueTypeUtils::codeFor<VT>);
+        if(!takePrefetchedRead(res, filename, AsyncReadDataType::CSRMatrix, valueType, ctx))
+            readThroughCache(res, filename, AsyncReadDataType::CSRMatrix, valueType, ctx, &readFile);
+    }
+
+    static void readFile(CSRMatrix<VT> *& res, const char * filename, DCTX(ctx)) {
 
 	FileMetaData fmd = MetaDataParser::readMetaData(filename);
 	int extv = extValue(filename);
@@ -130,10 +201,10 @@ struct Read<CSRMatrix<VT>> {
 			);
 
 		// FIXME: ensure file is sorted, or set `sorted` argument correctly
-		readCsv(res, filename, fmd.numRows, fmd.numCols, ',', fmd.numNonZeros, true);
+		readCsv(res, filename, fmd.numRows, fmd.numCols, ',', fmd.numNonZeros, true, ctx);
 		break;
 	case 1:
-		readMM(res, filename);
+		readMM(res, filename, ctx);
 		break;
 #ifdef USE_ARROW
 	case 2:
@@ -145,7 +216,7 @@ struct Read<CSRMatrix<VT>> {
 		break;
 #endif
 	case 3:
-		readDaphne(res, filename);
+		readDaphne(res, filename, ctx && ctx->config.mmap_daphne_files, ctx);
                 break;
         default:
             throw std::runtime_error("File extension not supported");
@@ -160,7 +231,65 @@ struct Read<CSRMatrix<VT>> {
 template<>
 struct Read<Frame> {
     static void apply(Frame *& res, const char * filename, DCTX(ctx)) {
+        if(!takePrefetchedRead(res, filename, AsyncReadDataType::Frame, -1, ctx))
+            readThroughCache(res, filename, AsyncReadDataType::Frame, -1, ctx, &readFile);
+    }
+
+    static void readFile(Frame *& res, const char * filename, DCTX(ctx)) {
+        readFormat(res, filename, ctx);
+        if(ctx && ctx->config.zone_maps)
+            ZoneMaps::computeFrame(res, ctx);
+        // the indexes stored next to a Daphne binary file, see KeyIndex
+        if(ctx && ctx->config.key_indexes && extValue(filename) == 3)
+            for(DF_key_index & keyIndex : readDaphneKeyIndexes(filename, res->getNumRows(), res->getNumCols()))
+                KeyIndexes::restore(res, std::move(keyIndex.keyCols), std::move(keyIndex.begins),
+                        std::move(keyIndex.rows));
+        if(ctx && ctx->config.column_statistics)
+            keepColumnStatistics(res, filename, ctx);
+    }
+
+    // keeps the statistics of the columns in the meta data file for the compilation of later runs, unless it has
+    // them already, see ColumnStatistics
+    static void keepColumnStatistics(const Frame * res, const char * filename, DCTX(ctx)) {
+        try {
+            if(!MetaDataParser::readMetaData(filename).columnStats.empty())
+                return;
+        }
+        catch(const std::exception &) {
+            // Daphne binary files need no meta data file
+            return;
+        }
+        MetaDataParser::writeColumnStatistics(filename, collectColumnStatistics(res, ctx));
+    }
+
+    static void readFormat(Frame *& res, const char * filename, DCTX(ctx)) {
+        if(extValue(filename) == 3) {
+            // the schema and labels are stored in the file, no meta data are needed
+            if(res != nullptr)
+                throw std::runtime_error("Read: frames cannot be read from Daphne binary files into existing frames");
+            readDaphne(res, filename, false, ctx);
+            return;
+        }
+
         FileMetaData fmd = MetaDataParser::readMetaData(filename);
+#ifdef USE_ARROW
+        if(extValue(filename) == 2 && res == nullptr) {
+            // all columns, which Arrow decodes in parallel and the frame adopts if possible
+            std::vector<ValueTypeCode> colTypes = fmd.isSingleValueType
+                    ? std::vector<ValueTypeCode>(fmd.numCols, fmd.schema[0]) : fmd.schema;
+            readParquet(res, filename, colTypes.data(), fmd.labels.empty() ? nullptr : fmd.labels.data(),
+                    ParquetReadOptions());
+            return;
+        }
+        if(extValue(filename) == 4 && res == nullptr) {
+            // the mapped columns of a single record batch are not copied
+            std::vector<ValueTypeCode> colTypes = fmd.isSingleValueType
+                    ? std::vector<ValueTypeCode>(fmd.numCols, fmd.schema[0]) : fmd.schema;
+            readArrowIpc(res, filename, colTypes.data(), fmd.labels.empty() ? nullptr : fmd.labels.data(),
+                    ctx);
+            return;
+        }
+#endif
         
         ValueTypeCode * schema;
         if(fmd.isSingleValueType) {
@@ -182,7 +311,7 @@ struct Read<Frame> {
                     fmd.numRows, fmd.numCols, schema, labels, false
             );
         
-        readCsv(res, filename, fmd.numRows, fmd.numCols, ',', schema);
+        readCsv(res, filename, fmd.numRows, fmd.numCols, ',', schema, ctx);
         
         if(fmd.isSingleValueType)
             delete[] schema;
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_READCOLUMNS_H
+#define SRC_RUNTIME_LOCAL_KERNELS_READCOLUMNS_H
+
+#include <ir/daphneir/Daphne.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/Read.h>
+#include <parser/metadata/MetaDataParser.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using mlir::daphne::CompareOperation;
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes>
+struct ReadColumns {
+    static void apply(DTRes *& res, const char * filename, const char ** columns, size_t numColumns,
+                      const char ** predColumns, size_t numPredColumns, CompareOperation * predCmps,
+                      size_t numPredCmps, double * predValues, size_t numPredValues, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Reads the columns with the given labels of a frame from a Parquet
+ * file, skipping the row groups in which no row satisfies all predicates
+ * `predColumns[i] predCmps[i] predValues[i]`.
+ *
+ * The rows of the other row groups are not filtered, i.e., the predicates must
+ * still be evaluated on the result.
+ */
+template<class DTRes>
+void readColumns(DTRes *& res, const char * filename, const char ** columns, size_t numColumns,
+                 const char ** predColumns, size_t numPredColumns, CompareOperation * predCmps, size_t numPredCmps,
+                 double * predValues, size_t numPredValues, DCTX(ctx)) {
+    ReadColumns<DTRes>::apply(res, filename, columns, numColumns, predColumns, numPredColumns, predCmps,
+            numPredCmps, predValues, numPredValues, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+template<>
+struct ReadColumns<Frame> {
+    static void apply(Frame *& res, const char * filename, const char ** columns, size_t numColumns,
+                      const char ** predColumns, size_t numPredColumns, CompareOperation * predCmps,
+                      size_t numPredCmps, double * predValues, size_t numPredValues, DCTX(ctx)) {
+        if(numPredColumns != numPredCmps || numPredColumns != numPredValues)
+            throw std::runtime_error("readColumns: the predicates must have a column, a comparison, and a value");
+        if(extValue(filename) != 2)
+            throw std::runtime_error(std::string("readColumns: only Parquet files are supported, not ") + filename);
+#ifdef USE_ARROW
+        FileMetaData fmd = MetaDataParser::readMetaData(filename);
+        ParquetReadOptions options;
+        std::vector<ValueTypeCode> schema;
+        for(size_t i = 0; i < numColumns; i++) {
+            options.columns.emplace_back(columns[i]);
+            if(fmd.isSingleValueType)
+                schema.push_back(fmd.schema[0]);
+            else {
+                auto it = std::find(fmd.labels.begin(), fmd.labels.end(), options.columns.back());
+                if(it == fmd.labels.end())
+                    throw std::runtime_error("readColumns: the meta data of " + std::string(filename)
+                            + " have no column " + options.columns.back());
+                schema.push_back(fmd.schema[it - fmd.labels.begin()]);
+            }
+        }
+        for(size_t i = 0; i < numPredColumns; i++) {
+            ParquetPredicate::Cmp cmp;
+            switch(predCmps[i]) {
+                case CompareOperation::Equal:        cmp = ParquetPredicate::Cmp::EQ; break;
+                case CompareOperation::NotEqual:     cmp = ParquetPredicate::Cmp::NE; break;
+                case CompareOperation::LessThan:     cmp = ParquetPredicate::Cmp::LT; break;
+                case CompareOperation::LessEqual:    cmp = ParquetPredicate::Cmp::LE; break;
+                case CompareOperation::GreaterThan:  cmp = ParquetPredicate::Cmp::GT; break;
+                case CompareOperation::GreaterEqual: cmp = ParquetPredicate::Cmp::GE; break;
+                default:
+                    throw std::runtime_error("readColumns: unsupported comparison in a predicate");
+            }
+            options.predicates.push_back({predColumns[i], cmp, predValues[i]});
+        }
+        readParquet(res, filename, schema.data(), options.columns.data(), options);
+#else
+        throw std::runtime_error("readColumns: reading Parquet files requires DAPHNE to be built with Arrow");
+#endif
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_READCOLUMNS_H
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_RECEIVEFROMARROW_H
+#define SRC_RUNTIME_LOCAL_KERNELS_RECEIVEFROMARROW_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/ArrowCData.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes>
+struct ReceiveFromArrow {
+    static void apply(DTRes *& res, uint64_t arrayAddress, uint64_t schemaAddress, size_t numRows, size_t numCols,
+                      DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Imports a record batch the Python program running the script (see `DaphneLib.h`) exported through Arrow's
+ * C data interface (e.g., of a pandas `DataFrame`) as a frame, whose numeric columns share the buffers of the batch.
+ *
+ * The frame takes over the exported array and releases it through its release callback once the columns are not
+ * used anymore.
+ *
+ * @param arrayAddress The address of the exported `ArrowArray`.
+ * @param schemaAddress The address of the exported `ArrowSchema`.
+ * @param numRows The number of rows the batch must have.
+ * @param numCols The number of columns the batch must have.
+ */
+template<class DTRes>
+void receiveFromArrow(DTRes *& res, uint64_t arrayAddress, uint64_t schemaAddress, size_t numRows, size_t numCols,
+                      DCTX(ctx)) {
+    ReceiveFromArrow<DTRes>::apply(res, arrayAddress, schemaAddress, numRows, numCols, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
+
+template<>
+struct ReceiveFromArrow<Frame> {
+    static void apply(Frame *& res, uint64_t arrayAddress, uint64_t schemaAddress, size_t numRows, size_t numCols,
+                      DCTX(ctx)) {
+        if(arrayAddress == 0 || schemaAddress == 0)
+            throw std::runtime_error("receiveFromArrow: the addresses must not be null");
+#ifdef USE_ARROW
+        Frame * frame = arrowCDataToFrame(reinterpret_cast<struct ArrowArray *>(arrayAddress),
+                                          reinterpret_cast<struct ArrowSchema *>(schemaAddress));
+        if(frame->getNumRows() != numRows || frame->getNumCols() != numCols) {
+            const std::string shape = std::to_string(frame->getNumRows()) + "x" + std::to_string(frame->getNumCols());
+            DataObjectFactory::destroy(frame);
+            throw std::runtime_error("receiveFromArrow: the record batch has the shape " + shape + " instead of "
+                    + std::to_string(numRows) + "x" + std::to_string(numCols));
+        }
+        res = frame;
+#else
+        throw std::runtime_error("receiveFromArrow: exchanging frames requires DAPHNE to be built with Arrow");
+#endif
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_RECEIVEFROMARROW_H
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_RECEIVEFROMNUMPY_H
+#define SRC_RUNTIME_LOCAL_KERNELS_RECEIVEFROMNUMPY_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <memory>
+#include <stdexcept>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes>
+struct ReceiveFromNumpy {
+    static void apply(DTRes *& res, uint64_t address, size_t numRows, size_t numCols, size_t rowSkip,
+                      DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Wraps the values of a NumPy array of the Python program running the script (see `DaphneLib.h`) as a
+ * matrix without copying them.
+ *
+ * The array must outlive the matrix, which does not own the values. Its rows may be strided, i.e., the row skip is
+ * the stride of the rows in values, but the values of a row must be adjacent.
+ */
+template<class DTRes>
+void receiveFromNumpy(DTRes *& res, uint64_t address, size_t numRows, size_t numCols, size_t rowSkip, DCTX(ctx)) {
+    ReceiveFromNumpy<DTRes>::apply(res, address, numRows, numCols, rowSkip, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct ReceiveFromNumpy<DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, uint64_t address, size_t numRows, size_t numCols, size_t rowSkip,
+                      DCTX(ctx)) {
+        if(address == 0)
+            throw std::runtime_error("receiveFromNumpy: the address must not be null");
+        if(rowSkip < numCols)
+            throw std::runtime_error("receiveFromNumpy: the row skip must be at least the number of columns");
+
+        // The values are owned by the Python program.
+        std::shared_ptr<VT[]> values(reinterpret_cast<VT *>(address), [](VT *) {});
+        if(rowSkip == numCols) {
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, values);
+            return;
+        }
+        // The strided rows are a view on the columns of a matrix as wide as the row skip, whose last row is never
+        // accessed beyond the view.
+        auto wide = DataObjectFactory::create<DenseMatrix<VT>>(numRows, rowSkip, values);
+        res = DataObjectFactory::create<DenseMatrix<VT>>(wide, 0, numRows, 0, numCols);
+        DataObjectFactory::destroy(wide);
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_RECEIVEFROMNUMPY_H
@@ -20,6 +20,10 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/ReuseArg.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
 
 #include <string.h>
 #include <cstddef>
@@ -44,6 +48,38 @@ void replace(DTRes *& res, const DTArg * arg, VT pattern, VT replacement, DCTX(c
     Replace<DTRes, DTArg, VT>::apply(res, arg, pattern, replacement, ctx);
 }
 
+// ****************************************************************************
+// Functions called by multiple template specializations
+// ****************************************************************************
+
+/**
+ * @brief Helpers of `Replace`, which select the replacement or the original
+ * value of each cell without branches, such that the loops are vectorized to
+ * masked blends, and split the cells into chunks for the tasks.
+ */
+namespace ReplaceBlocks {
+    // The cells handled by one task at least.
+    constexpr size_t MIN_CHUNK_CELLS = 1 << 16;
+
+    inline size_t getNumChunks(size_t numUnits, size_t numCells) {
+        return std::max<size_t>(1, std::min(numUnits, numCells / MIN_CHUNK_CELLS));
+    }
+
+    template<typename VT>
+    void replaceValues(VT * res, const VT * arg, size_t n, VT pattern, VT replacement) {
+        if(pattern != pattern) { // pattern is NaN
+            #pragma omp simd
+            for(size_t i = 0; i < n; i++)
+                res[i] = arg[i] != arg[i] ? replacement : arg[i];
+        }
+        else { // pattern is not NaN --> replacement can still be NaN
+            #pragma omp simd
+            for(size_t i = 0; i < n; i++)
+                res[i] = arg[i] == pattern ? replacement : arg[i];
+        }
+    }
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -61,68 +97,41 @@ struct Replace<DenseMatrix<VT>, DenseMatrix<VT>, VT> {
         const size_t numRows = arg->getNumRows(); // number of rows
         const size_t numCols = arg->getNumCols(); // number of columns
         const size_t elementCount = numRows * numCols;
-        bool requireCopy=false; // this variable is to indicate whether we need to copy to res (when not using inplace update semantic)s
         if(elementCount==0){// This case means that the kernel do nothing, i.e.,  no values to replace
             return;
         }
+        // An argument at its last use is updated in place, see ReuseArg.h.
+        reuseArgAsRes(res, arg, numRows, numCols);
         if(res!=nullptr){ // In this case, the caller reuses the res matrix
             assert(res->getNumRows()== numRows && "res is a not a nullptr but it has a different numRows than arg");
             assert(res->getNumCols()== numCols && "res is a not a nullptr but it has a different numCols than arg");
         }
-        if((replacement!=replacement && pattern!=pattern) || (pattern == replacement)){// nothing to be done pattern equals replacement
-            if(res!=nullptr && res==arg){  // arg and res are the same
-                return; 
-            }
-            else if (res==nullptr){
-                res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols,  false);
-            }
-            //copy and return in this case replace will be a copy function that copies arg to res
-            const VT * allValues = arg->getValues();
-            VT * allUpdatedValues = res->getValues();
-            for(size_t r = 0; r < numRows; r++){
-                for(size_t c = 0; c < numCols; c++){
-                    allUpdatedValues[c]=allValues[c];
-                }
-                allUpdatedValues += res->getRowSkip();
-                allValues += arg->getRowSkip();
-            }
+        // nothing to be done if pattern equals replacement, replace is a copy then
+        const bool copyOnly = (replacement!=replacement && pattern!=pattern) || (pattern == replacement);
+        if(copyOnly && res==arg){  // arg and res are the same
             return;
         }
         if(res==nullptr){
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
-            requireCopy=true;
         }
-        const VT * allValues = arg->getValues() ;
-        VT * allUpdatedValues = res->getValues();
         //--------main logic --------------------------
-        if(pattern!=pattern){ // pattern is NaN
-            for(size_t r = 0; r < numRows; r++){
-                for(size_t c = 0; c < numCols; c++){
-                    if(allValues[c]!=allValues[c]){
-                        allUpdatedValues[c]=replacement;
-                    }
-                    else if(requireCopy){
-                        allUpdatedValues[c]=allValues[c];
-                    }
-                }
-                allUpdatedValues += res->getRowSkip();
-                allValues += arg->getRowSkip();
-            }
-        }
-        else{ // pattern is not NaN --> replacement can still be NaN
-            for(size_t r = 0; r < numRows; r++){
-                for(size_t c = 0; c < numCols; c++){
-                    if(allValues[c]==pattern){
-                        allUpdatedValues[c]=replacement;
-                    }
-                    else if(requireCopy){
-                        allUpdatedValues[c]=allValues[c];
-                    }
-                }
-                allUpdatedValues += res->getRowSkip();
-                allValues += arg->getRowSkip();    
+        // An argument updated in place is overwritten with the same values in
+        // all cells but the replaced ones.
+        const VT * allValues = arg->getValues();
+        VT * allUpdatedValues = res->getValues();
+        const size_t rowSkipArg = arg->getRowSkip();
+        const size_t rowSkipRes = res->getRowSkip();
+        const size_t numChunks = ReplaceBlocks::getNumChunks(numRows, elementCount);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            for(size_t r = numRows * chunk / numChunks; r < numRows * (chunk + 1) / numChunks; r++) {
+                const VT * rowValues = allValues + r * rowSkipArg;
+                VT * rowUpdatedValues = allUpdatedValues + r * rowSkipRes;
+                if(copyOnly)
+                    std::copy_n(rowValues, numCols, rowUpdatedValues);
+                else
+                    ReplaceBlocks::replaceValues(rowUpdatedValues, rowValues, numCols, pattern, replacement);
             }
-        }
+        });
     }   
 };
 
@@ -168,30 +177,17 @@ struct Replace<CSRMatrix<VT>, CSRMatrix<VT>, VT> {
 
         }
         //--------main logic --------------------------
-        if(pattern!=pattern){ // pattern is NaN
-            for(size_t r = 0; r < numRows; r++){
-                const VT * allValues = arg->getValues(r);
-                VT * allUpdatedValues = res->getValues(r);
-                const size_t nnzElementsRes= arg->getNumNonZeros(r);
-                for(size_t c = 0; c < nnzElementsRes; c++){
-                    if(allValues[c]!=allValues[c]){
-                        allUpdatedValues[c]=replacement;
-                    }
-                }
-            }
-        }
-        else{
-            for(size_t r = 0; r < numRows; r++){
-                const VT * allValues = arg->getValues(r);
-                VT * allUpdatedValues = res->getValues(r);
-                const size_t nnzElementsRes= arg->getNumNonZeros(r);
-                for(size_t c = 0; c < nnzElementsRes; c++){
-                    if(allValues[c]==pattern){
-                        allUpdatedValues[c]=replacement;
-                    }
-                }
-            }
-        }
+        // The non-zeros of all rows are consecutive, such that they are
+        // replaced in chunks regardless of the rows.
+        const VT * allValues = arg->getValues(0);
+        VT * allUpdatedValues = res->getValues(0);
+        const size_t numChunks = ReplaceBlocks::getNumChunks(nnzElements, nnzElements);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t chunk) {
+            const size_t begin = nnzElements * chunk / numChunks;
+            const size_t end = nnzElements * (chunk + 1) / numChunks;
+            ReplaceBlocks::replaceValues(allUpdatedValues + begin, allValues + begin, end - begin, pattern,
+                    replacement);
+        });
     }
 };
 
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+
+/**
+ * @brief Makes the argument of an element-wise kernel its result, if the result
+ * has not been allocated yet and the argument may be overwritten, i.e., the
+ * argument is at its last use, is not referenced elsewhere, and has the value
+ * type and shape of the result.
+ *
+ * The result becomes a new reference to the argument, such that the argument
+ * lives on as the result when its reference is released after the kernel call.
+ *
+ * @return Whether the argument was reused.
+ */
+template<typename VTRes, typename VTArg>
+bool reuseArgAsRes(DenseMatrix<VTRes> *& res, const DenseMatrix<VTArg> * arg, size_t numRows, size_t numCols) {
+    if constexpr(std::is_same<VTRes, VTArg>::value) {
+        if(res == nullptr && arg->getNumRows() == numRows && arg->getNumCols() == numCols && arg->isOverwritable()) {
+            res = const_cast<DenseMatrix<VTRes> *>(arg);
+            res->increaseRefCounter();
+            // The values of the argument are overwritten, so they get a new lineage.
+            res->renewLineageId();
+            // The copies of the argument at distributed workers do not hold the values of the result.
+            auto &mdo = res->getMetaDataObject();
+            std::vector<size_t> distributedIds;
+            for(auto type : {ALLOCATION_TYPE::DIST_GRPC, ALLOCATION_TYPE::DIST_MPI})
+                for(auto &dp : *mdo.getDataPlacementByType(type))
+                    distributedIds.push_back(dp->dp_id);
+            for(size_t id : distributedIds)
+                mdo.removeDataPlacement(id);
+            return true;
+        }
+    }
+    return false;
+}
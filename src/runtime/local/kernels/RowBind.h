@@ -18,15 +18,17 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_ROWBIND_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/kernels/ColBind.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 
-#include <cassert>
 #include <cstddef>
 #include <cstring>
 
@@ -65,22 +67,60 @@ struct RowBind<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
         
         const size_t numRowsUps = ups->getNumRows();
         const size_t numRowsLows = lows->getNumRows();
-        const size_t numColsUps = ups->getNumCols();
-        const size_t numColsLows = lows->getNumCols();
-        
-        if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsUps + numRowsLows, numCols, false);
-        
         
         const VT * valuesUps = ups->getValues();
         const VT * valuesLows = lows->getValues();
-        VT * valuesRes = res->getValues();
         
-        // TODO Take rowSkip into account. If ups/lows/res are views into
-        // column segments of larger data objects, we must proceed row-by-row.
-        memcpy(valuesRes, valuesUps, numColsUps * numRowsUps * sizeof(VT));
-        memcpy(valuesRes + numRowsUps * numColsUps, valuesLows, numColsLows * numRowsLows * sizeof(VT));
+        const size_t rowSkipUps = ups->getRowSkip();
+        const size_t rowSkipLows = lows->getRowSkip();
+        
+        if(res == nullptr) {
+            // The rows of lows directly follow those of ups in the same values
+            // (e.g., both are row slices of the same matrix), such that the
+            // result is a view on them.
+            if(valuesUps + numRowsUps * rowSkipUps == valuesLows && rowSkipUps == rowSkipLows
+                    && BindBlocks::shareValues(ups, lows)) {
+                res = DataObjectFactory::create<DenseMatrix<VT>>(ups, numRowsUps + numRowsLows, numCols);
+                return;
+            }
+            // ups is not used afterwards and has spare rows for lows (e.g.,
+            // it is the result of a previous `rbind` in a loop), such that
+            // lows is appended in place and the result is a view on the values
+            // of ups, which it takes over when ups is released after this call.
+            if(ups->isOverwritable() && ups->getNumSpareRows() >= numRowsLows) {
+                VT * valuesRes = const_cast<VT *>(valuesUps) + numRowsUps * rowSkipUps;
+                for(size_t r = 0; r < numRowsLows; r++) {
+                    memcpy(valuesRes, valuesLows, numCols * sizeof(VT));
+                    valuesLows += rowSkipLows;
+                    valuesRes += rowSkipUps;
+                }
+                res = DataObjectFactory::create<DenseMatrix<VT>>(ups, numRowsUps + numRowsLows, numCols);
+                return;
+            }
+            // ups is not used afterwards, but its values are too small, such
+            // that spare rows are reserved for appending rows in place.
+            const size_t numRowsRes = numRowsUps + numRowsLows;
+            if(ups->isAtLastUse()) {
+                res = DataObjectFactory::create<DenseMatrix<VT>>(
+                        numRowsRes + BindBlocks::getNumReservedRows(numRowsRes), numCols, false);
+                res->shrinkNumRows(numRowsRes);
+            }
+            else
+                res = DataObjectFactory::create<DenseMatrix<VT>>(numRowsRes, numCols, false);
+        }
+        
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
         
+        auto copyRows = [numCols, rowSkipRes](VT * dst, const VT * src, size_t numRows, size_t rowSkipSrc) {
+            if(rowSkipSrc == numCols && rowSkipRes == numCols)
+                memcpy(dst, src, numRows * numCols * sizeof(VT));
+            else
+                for(size_t r = 0; r < numRows; r++)
+                    memcpy(dst + r * rowSkipRes, src + r * rowSkipSrc, numCols * sizeof(VT));
+        };
+        copyRows(valuesRes, valuesUps, numRowsUps, rowSkipUps);
+        copyRows(valuesRes + numRowsUps * rowSkipRes, valuesLows, numRowsLows, rowSkipLows);
     }
 };
 
@@ -112,6 +152,12 @@ struct RowBind<Frame, Frame, Frame> {
             const void * colLows = lows->getColumnRaw(i);
             uint8_t * colRes = reinterpret_cast<uint8_t *>(res->getColumnRaw(i));
             
+            if(schema[i] == ValueTypeCode::STR) {
+                std::string * stringsRes = reinterpret_cast<std::string *>(colRes);
+                std::copy_n(static_cast<const std::string *>(colUps), ups->getNumRows(), stringsRes);
+                std::copy_n(static_cast<const std::string *>(colLows), lows->getNumRows(), stringsRes + ups->getNumRows());
+                continue;
+            }
             const size_t elemSize = ValueTypeUtils::sizeOf(schema[i]);
             memcpy(colRes, colUps, ups->getNumRows() * elemSize);
             memcpy(colRes + ups->getNumRows() * elemSize, colLows, lows->getNumRows() * elemSize);
@@ -20,18 +20,20 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/RandMatrix.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
 #include <algorithm>
 #include <random>
-#include <set>
+#include <stdexcept>
 #include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
-#include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <chrono>
-#include <unordered_set>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -51,6 +53,121 @@ void sample(DTRes *& res, VTArg range, size_t size, bool withReplacement, int64_
     Sample<DTRes, VTArg>::apply(res, range, size, withReplacement, seed, ctx);
 }
 
+// ****************************************************************************
+// Functions called by multiple template specializations
+// ****************************************************************************
+
+/**
+ * @brief The building blocks of the sampling kernels (see also `SampleBernoulli` and `SampleStratified`).
+ *
+ * Every position gets a random key, which only depends on the seed and the position. The positions with the `k`
+ * smallest keys are a uniform sample of `k` positions without replacement (bottom-k sampling), and the positions whose
+ * keys are below a threshold are a Bernoulli sample. Hence, the positions are processed in blocks in parallel, and the
+ * sample is the same for any number of threads. The keys are 53 bits, such that a threshold is a fraction of 2^53.
+ */
+namespace SampleBlocks {
+    // the positions processed by one task
+    constexpr size_t BLOCK_SIZE = 1 << 16;
+    // up to this fraction of the range, a sample without replacement is drawn by Floyd's algorithm, which only
+    // touches the drawn values, but sequentially
+    constexpr double FLOYD_MAX_FRACTION = 1.0 / 16;
+
+    inline uint64_t getKey(uint64_t seed, uint64_t pos) {
+        RandBlocks::Generator gen(seed);
+        gen.jump(pos);
+        return gen() >> 11;
+    }
+
+    // the threshold of the keys selected with the given probability
+    inline uint64_t getThreshold(double fraction) {
+        return static_cast<uint64_t>(std::min(1.0, std::max(0.0, fraction)) * 0x1.0p53);
+    }
+
+    /**
+     * @brief Selects the positions in `[0, n)` whose keys are below a threshold, in ascending order.
+     */
+    class KeyFilter {
+        const uint64_t n;
+        const uint64_t threshold;
+        const uint64_t seed;
+        const size_t numBlocks;
+        // per block, the number of selected positions before it
+        std::vector<size_t> offsets;
+
+    public:
+        KeyFilter(uint64_t n, uint64_t threshold, uint64_t seed, DCTX(ctx)) :
+                n(n), threshold(threshold), seed(seed), numBlocks((n + BLOCK_SIZE - 1) / BLOCK_SIZE),
+                offsets(numBlocks + 1, 0) {
+            WorkerPool::parallelFor(ctx, numBlocks, [&](size_t b) {
+                const uint64_t end = std::min<uint64_t>(n, (b + 1) * BLOCK_SIZE);
+                size_t count = 0;
+#pragma omp simd reduction(+:count)
+                for(uint64_t pos = b * BLOCK_SIZE; pos < end; pos++)
+                    count += getKey(seed, pos) < threshold;
+                offsets[b + 1] = count;
+            });
+            for(size_t b = 0; b < numBlocks; b++)
+                offsets[b + 1] += offsets[b];
+        }
+
+        size_t getNumSelected() const {
+            return offsets[numBlocks];
+        }
+
+        /**
+         * @brief Writes the selected positions, and their keys if `keys` is not `nullptr`.
+         */
+        template<typename VTPos>
+        void fill(VTPos * positions, uint64_t * keys, DCTX(ctx)) const {
+            WorkerPool::parallelFor(ctx, numBlocks, [&](size_t b) {
+                const uint64_t end = std::min<uint64_t>(n, (b + 1) * BLOCK_SIZE);
+                size_t i = offsets[b];
+                for(uint64_t pos = b * BLOCK_SIZE; pos < end; pos++) {
+                    const uint64_t key = getKey(seed, pos);
+                    if(key < threshold) {
+                        positions[i] = static_cast<VTPos>(pos);
+                        if(keys)
+                            keys[i] = key;
+                        i++;
+                    }
+                }
+            });
+        }
+    };
+
+    /**
+     * @brief Writes the positions of `[0, n)` with the `k` smallest keys in the order of their keys, i.e., a uniform
+     * sample without replacement in random order.
+     *
+     * Only the positions whose keys are below a threshold slightly above the expected `k`-th smallest key are
+     * collected (in parallel), and the sample is selected from them. In the rare case of too few candidates, the
+     * threshold is raised.
+     */
+    template<typename VTPos>
+    void drawSmallestKeys(VTPos * res, uint64_t n, size_t k, uint64_t seed, DCTX(ctx)) {
+        double margin = 4.0;
+        while(true) {
+            const double fraction = (static_cast<double>(k) + margin * std::sqrt(static_cast<double>(k)) + 16.0) / n;
+            KeyFilter filter(n, getThreshold(fraction), seed, ctx);
+            const size_t numCandidates = filter.getNumSelected();
+            if(numCandidates >= k) {
+                std::vector<uint64_t> positions(numCandidates);
+                std::vector<uint64_t> keys(numCandidates);
+                filter.fill(positions.data(), keys.data(), ctx);
+                std::vector<std::pair<uint64_t, uint64_t>> candidates(numCandidates);
+                for(size_t i = 0; i < numCandidates; i++)
+                    candidates[i] = {keys[i], positions[i]};
+                std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end());
+                std::sort(candidates.begin(), candidates.begin() + k);
+                for(size_t i = 0; i < k; i++)
+                    res[i] = static_cast<VTPos>(candidates[i].second);
+                return;
+            }
+            margin *= 2;
+        }
+    }
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -62,81 +179,74 @@ void sample(DTRes *& res, VTArg range, size_t size, bool withReplacement, int64_
 template<typename VT>
 struct Sample<DenseMatrix<VT>, VT> {
     static void apply(DenseMatrix<VT> *& res, VT range, int64_t size, bool withReplacement, int64_t seed, DCTX(ctx)) {
-        assert(size > 0 && "size (rows) must be > 0");
-        assert(range > 0 && "range must be > 0");        
-        if ( ! withReplacement ){
-            if (!std::is_floating_point<VT>::value){
-                assert(range >= size && "if no duplicates are allowed, then must be range >= size");
-            }
-        }
+        static_assert(
+                std::is_floating_point<VT>::value || std::is_integral<VT>::value,
+                "the value type must be either floating point or integral"
+        );
+        if(size <= 0)
+            throw std::runtime_error("sample: size (rows) must be > 0");
+        if(!(range > 0))
+            throw std::runtime_error("sample: range must be > 0");
+        if(!withReplacement && std::is_integral<VT>::value && static_cast<int64_t>(range) < size)
+            throw std::runtime_error("sample: if no duplicates are allowed, then must be range >= size");
 
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(size, 1, false);
 
-        if (seed == -1) {
-            std::random_device rd;
-            std::uniform_int_distribution<int64_t> seedRnd;
-            seed = seedRnd(rd);
-        }
+        const uint64_t seedVal = RandBlocks::getSeed(seed);
+        VT *valuesRes = res->getValues();
 
-        std::mt19937 genVal(seed);
-        
-        static_assert(
-        std::is_floating_point<VT>::value || std::is_integral<VT>::value,
-                "the value type must be either floating point or integral"
-        );
         // TODO For std::uniform_real_distribution, the upper bound is not
         // included in the interval of possible values, so when VT is a
         // floating-point type, std::nextafter() is not required. However, we
         // don't lose much by that, so it is fine for now.
-        typename std::conditional<
-                    std::is_floating_point<VT>::value,
-                    std::uniform_real_distribution<VT>,
-                    std::uniform_int_distribution<VT>>::type distrVal(0, std::nextafter(range, 0));
-        if (withReplacement) {            
-
-            VT *valuesRes = res->getValues();
-            for (int64_t c = 0; c < size; c++)
-            {
-                valuesRes[c] = distrVal(genVal);
-            }
+        const VT upper = std::nextafter(range, 0);
+        if (withReplacement) {
+            // in blocks, each from a generator of its own (see RandBlocks)
+            const size_t numBlocks = (size + SampleBlocks::BLOCK_SIZE - 1) / SampleBlocks::BLOCK_SIZE;
+            WorkerPool::parallelFor(ctx, numBlocks, [&](size_t b) {
+                RandBlocks::Generator gen(seedVal);
+                gen.jump(b * RandBlocks::BLOCK_DRAWS);
+                RandBlocks::Distribution<VT> distrVal(0, upper);
+                const size_t end = std::min<size_t>(size, (b + 1) * SampleBlocks::BLOCK_SIZE);
+                for(size_t c = b * SampleBlocks::BLOCK_SIZE; c < end; c++)
+                    valuesRes[c] = distrVal(gen);
+            });
         }
-        else {
-            // If range is `double` we can simply store each number we 
+        else if (std::is_floating_point<VT>::value) {
+            // If range is `double` we can simply store each number we
             // generate and check if it already exists each time (doubles
             // are rarely duplicate).
-            if (std::is_floating_point<VT>::value){
-                
-                std::unordered_set<VT> contained;
-                VT *valuesRes = res->getValues();
-                for (int64_t c = 0; c < size; c++)
-                {
-                    VT generatedValue = distrVal(genVal);
-                    while (contained.find(generatedValue) != contained.end()){
-                        generatedValue = distrVal(genVal);                        
-                    }                    
-                    valuesRes[c] = generatedValue;
-                    contained.insert(generatedValue);
-                }   
+            RandBlocks::Generator gen(seedVal);
+            RandBlocks::Distribution<VT> distrVal(0, upper);
+            std::unordered_set<VT> contained;
+            for (int64_t c = 0; c < size; c++) {
+                VT generatedValue = distrVal(gen);
+                while (contained.find(generatedValue) != contained.end())
+                    generatedValue = distrVal(gen);
+                valuesRes[c] = generatedValue;
+                contained.insert(generatedValue);
             }
-            // Else if range is `int` the above method does not work efficiently.
-            // Ex. size = range, finding the correct number is increasingly
-            // harder as we fill the array. We must implement an efficient algorithm
-            // to create non-duplicate numbers (see Knuth's algorithm).
-            else {                
-                VT *valuesRes = res->getValues();
-                int64_t iRange, iSize;
-                iSize = 0;
-
-                for (iRange = 0; iRange < range && iSize < size; iRange++) {
-                    size_t rRange = range - iRange;
-                    size_t rSize = size - iSize;
-                    if (fmod(distrVal(genVal), rRange) < rSize)
-                        valuesRes[iSize++] = iRange;
-                }
-                std::shuffle(valuesRes, valuesRes + size, genVal);
+        }
+        else if (size <= SampleBlocks::FLOYD_MAX_FRACTION * static_cast<double>(range)) {
+            // Floyd's algorithm: the j-th draw adds a value of [0, j] not drawn before, or j itself.
+            RandBlocks::Generator gen(seedVal);
+            std::unordered_set<int64_t> contained;
+            contained.reserve(size);
+            const int64_t iRange = static_cast<int64_t>(range);
+            int64_t c = 0;
+            for (int64_t j = iRange - size; j < iRange; j++) {
+                const int64_t v = std::uniform_int_distribution<int64_t>(0, j)(gen);
+                const int64_t drawn = contained.insert(v).second ? v : j;
+                if (drawn == j)
+                    contained.insert(j);
+                valuesRes[c++] = static_cast<VT>(drawn);
             }
+            std::shuffle(valuesRes, valuesRes + size, gen);
         }
+        else
+            // a larger share of the range is drawn in parallel
+            SampleBlocks::drawSmallestKeys(valuesRes, static_cast<uint64_t>(range), size, seedVal, ctx);
     }
 };
 #endif //SRC_RUNTIME_LOCAL_KERNELS_SAMPLEOP_H
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_SAMPLEBERNOULLI_H
+#define SRC_RUNTIME_LOCAL_KERNELS_SAMPLEBERNOULLI_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/RandMatrix.h>
+#include <runtime/local/kernels/Sample.h>
+
+#include <stdexcept>
+
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTArg>
+struct SampleBernoulli {
+    static void apply(DTRes *& res, const DTArg * arg, double fraction, int64_t seed, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Selects each row of `arg` independently with the probability `fraction`.
+ *
+ * The result is a single-column matrix of the positions of the selected rows in ascending order, which can be
+ * passed to `extractRow` to obtain the sampled rows of a matrix or frame. For a fixed seed, the sample does not
+ * depend on the number of threads.
+ */
+template<class DTRes, class DTArg>
+void sampleBernoulli(DTRes *& res, const DTArg * arg, double fraction, int64_t seed, DCTX(ctx)) {
+    SampleBernoulli<DTRes, DTArg>::apply(res, arg, fraction, seed, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix, Frame
+// ----------------------------------------------------------------------------
+
+template<typename VTPos, class DTArg>
+struct SampleBernoulli<DenseMatrix<VTPos>, DTArg> {
+    static void apply(DenseMatrix<VTPos> *& res, const DTArg * arg, double fraction, int64_t seed, DCTX(ctx)) {
+        if(!(fraction >= 0 && fraction <= 1))
+            throw std::runtime_error("sampleBernoulli: the fraction must be in [0, 1]");
+
+        const SampleBlocks::KeyFilter filter(
+                arg->getNumRows(), SampleBlocks::getThreshold(fraction), RandBlocks::getSeed(seed), ctx
+        );
+        const size_t numSelected = filter.getNumSelected();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VTPos>>(numSelected, 1, false);
+        else if(res->getNumRows() != numSelected || res->getNumCols() != 1)
+            throw std::runtime_error("sampleBernoulli: the result has the wrong shape");
+
+        filter.fill(res->getValues(), nullptr, ctx);
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_SAMPLEBERNOULLI_H
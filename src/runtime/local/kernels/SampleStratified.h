@@ -0,0 +1,200 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_SAMPLESTRATIFIED_H
+#define SRC_RUNTIME_LOCAL_KERNELS_SAMPLESTRATIFIED_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/kernels/RandMatrix.h>
+#include <runtime/local/kernels/Sample.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTArg>
+struct SampleStratified {
+    static void apply(DTRes *& res, const DTArg * arg, size_t keyCol, double fraction, int64_t seed, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Draws the same fraction of the rows of each stratum of `arg` without replacement, where the strata are the
+ * rows with equal values in the column `keyCol`.
+ *
+ * Of a stratum of `n` rows, `round(fraction * n)` rows are drawn. The result is a single-column matrix of the
+ * positions of the drawn rows in ascending order, which can be passed to `extractRow`. For a fixed seed, the sample
+ * does not depend on the number of threads.
+ */
+template<class DTRes, class DTArg>
+void sampleStratified(DTRes *& res, const DTArg * arg, size_t keyCol, double fraction, int64_t seed, DCTX(ctx)) {
+    SampleStratified<DTRes, DTArg>::apply(res, arg, keyCol, fraction, seed, ctx);
+}
+
+// ****************************************************************************
+// Functions called by multiple template specializations
+// ****************************************************************************
+
+namespace SampleStratifiedBlocks {
+    // the stratum of each row, numbered in the order of their first rows
+    template<typename VT>
+    std::vector<size_t> getStrata(const VT * keys, size_t numRows, size_t keyStride, size_t & numStrata) {
+        std::vector<size_t> strata(numRows);
+        std::unordered_map<VT, size_t> ids;
+        numStrata = 0;
+        // all NaN keys form one stratum, although they are not equal
+        size_t nanId = SIZE_MAX;
+        for(size_t r = 0; r < numRows; r++) {
+            const VT & key = keys[r * keyStride];
+            if constexpr(std::is_floating_point<VT>::value) {
+                if(std::isnan(key)) {
+                    if(nanId == SIZE_MAX)
+                        nanId = numStrata++;
+                    strata[r] = nanId;
+                    continue;
+                }
+            }
+            auto it = ids.find(key);
+            if(it == ids.end())
+                it = ids.emplace(key, numStrata++).first;
+            strata[r] = it->second;
+        }
+        return strata;
+    }
+
+    template<typename VTPos>
+    void sample(DenseMatrix<VTPos> *& res, const std::vector<size_t> & strata, size_t numStrata, double fraction,
+                int64_t seed, DCTX(ctx)) {
+        if(!(fraction >= 0 && fraction <= 1))
+            throw std::runtime_error("sampleStratified: the fraction must be in [0, 1]");
+        const uint64_t seedVal = RandBlocks::getSeed(seed);
+        const size_t numRows = strata.size();
+
+        std::vector<std::vector<size_t>> rowsPerStratum(numStrata);
+        for(size_t r = 0; r < numRows; r++)
+            rowsPerStratum[strata[r]].push_back(r);
+
+        // Within each stratum, the rows with the smallest keys (see SampleBlocks) are drawn.
+        std::vector<uint8_t> drawn(numRows, 0);
+        WorkerPool::parallelFor(ctx, numStrata, [&](size_t s) {
+            const std::vector<size_t> & rows = rowsPerStratum[s];
+            const size_t k = static_cast<size_t>(std::llround(fraction * rows.size()));
+            if(k == rows.size()) {
+                for(size_t r : rows)
+                    drawn[r] = 1;
+                return;
+            }
+            std::vector<std::pair<uint64_t, size_t>> keys(rows.size());
+            for(size_t i = 0; i < rows.size(); i++)
+                keys[i] = {SampleBlocks::getKey(seedVal, rows[i]), rows[i]};
+            std::nth_element(keys.begin(), keys.begin() + k, keys.end());
+            for(size_t i = 0; i < k; i++)
+                drawn[keys[i].second] = 1;
+        });
+
+        size_t numDrawn = 0;
+        for(size_t r = 0; r < numRows; r++)
+            numDrawn += drawn[r];
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VTPos>>(numDrawn, 1, false);
+        else if(res->getNumRows() != numDrawn || res->getNumCols() != 1)
+            throw std::runtime_error("sampleStratified: the result has the wrong shape");
+        VTPos * valuesRes = res->getValues();
+        for(size_t r = 0; r < numRows; r++)
+            if(drawn[r])
+                *valuesRes++ = static_cast<VTPos>(r);
+    }
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VTPos, typename VTArg>
+struct SampleStratified<DenseMatrix<VTPos>, DenseMatrix<VTArg>> {
+    static void apply(DenseMatrix<VTPos> *& res, const DenseMatrix<VTArg> * arg, size_t keyCol, double fraction,
+                      int64_t seed, DCTX(ctx)) {
+        if(keyCol >= arg->getNumCols())
+            throw std::runtime_error("sampleStratified: the key column is out of bounds");
+        size_t numStrata;
+        const std::vector<size_t> strata = SampleStratifiedBlocks::getStrata(
+                arg->getValues() + keyCol, arg->getNumRows(), arg->getRowSkip(), numStrata
+        );
+        SampleStratifiedBlocks::sample(res, strata, numStrata, fraction, seed, ctx);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- Frame
+// ----------------------------------------------------------------------------
+
+template<typename VTPos>
+struct SampleStratified<DenseMatrix<VTPos>, Frame> {
+    template<typename VT>
+    static std::vector<size_t> getStrata(const Frame * arg, size_t keyCol, size_t & numStrata) {
+        return SampleStratifiedBlocks::getStrata(
+                static_cast<const VT *>(arg->getColumnRaw(keyCol)), arg->getNumRows(), 1, numStrata
+        );
+    }
+
+    static void apply(DenseMatrix<VTPos> *& res, const Frame * arg, size_t keyCol, double fraction,
+                      int64_t seed, DCTX(ctx)) {
+        if(keyCol >= arg->getNumCols())
+            throw std::runtime_error("sampleStratified: the key column is out of bounds");
+        size_t numStrata;
+        std::vector<size_t> strata;
+        switch(arg->getColumnType(keyCol)) {
+            case ValueTypeCode::SI8:  strata = getStrata<int8_t>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::SI32: strata = getStrata<int32_t>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::SI64: strata = getStrata<int64_t>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::UI8:  strata = getStrata<uint8_t>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::UI32: strata = getStrata<uint32_t>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::UI64: strata = getStrata<uint64_t>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::F32:  strata = getStrata<float>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::F64:  strata = getStrata<double>(arg, keyCol, numStrata); break;
+            case ValueTypeCode::STR:  strata = getStrata<std::string>(arg, keyCol, numStrata); break;
+            default:
+                throw std::runtime_error("sampleStratified: unsupported value type of the key column");
+        }
+        SampleStratifiedBlocks::sample(res, strata, numStrata, fraction, seed, ctx);
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_SAMPLESTRATIFIED_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_SAVEDAPHNELIBRESULT_H
+#define SRC_RUNTIME_LOCAL_KERNELS_SAVEDAPHNELIBRESULT_H
+
+#include <api/daphnelib/DaphneLibResult.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTArg>
+struct SaveDaphneLibResult {
+    static void apply(const DTArg * arg, size_t index, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Passes the given matrix as the result of the given index of the script to the Python program running it
+ * (see `DaphneLib.h`), which accesses its values without copying them until it releases the matrix.
+ *
+ * A script computing several outputs at once saves each of them at its own index.
+ */
+template<class DTArg>
+void saveDaphneLibResult(const DTArg * arg, size_t index, DCTX(ctx)) {
+    SaveDaphneLibResult<DTArg>::apply(arg, index, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct SaveDaphneLibResult<DenseMatrix<VT>> {
+    static void apply(const DenseMatrix<VT> * arg, size_t index, DCTX(ctx)) {
+        if(ctx->config.result_struct == nullptr)
+            throw std::runtime_error("saveDaphneLibResult: the script is not run by DaphneLib");
+        if(index >= ctx->config.num_result_structs)
+            throw std::runtime_error("saveDaphneLibResult: the result index " + std::to_string(index) +
+                    " is out of bounds for " + std::to_string(ctx->config.num_result_structs) + " results");
+        DaphneLibResult * result = ctx->config.result_struct + index;
+        if(result->handle)
+            throw std::runtime_error("saveDaphneLibResult: the script saved a result at index " +
+                    std::to_string(index) + " before");
+
+        // The reference is released by daphneReleaseResult.
+        arg->increaseRefCounter();
+        result->address = const_cast<VT *>(arg->getValues());
+        result->rows = static_cast<int64_t>(arg->getNumRows());
+        result->cols = static_cast<int64_t>(arg->getNumCols());
+        result->rowSkip = static_cast<int64_t>(arg->getRowSkip());
+        result->vtc = static_cast<int64_t>(ValueTypeUtils::codeFor<VT>);
+        result->handle = const_cast<DenseMatrix<VT> *>(arg);
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_SAVEDAPHNELIBRESULT_H
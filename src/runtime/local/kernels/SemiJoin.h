@@ -23,10 +23,11 @@
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <util/FlatHashMap.h>
 
 #include <stdexcept>
 #include <tuple>
-#include <unordered_set>
 
 #include <cstddef>
 #include <cstdint>
@@ -56,15 +57,18 @@ void semiJoinCol(
     if(argRhs->getNumCols() != 1)
         throw std::runtime_error("parameter argRhs must be a single-column matrix");
         
-    std::unordered_set<VTRhs> hs;
-    
     // ------------------------------------------------------------------------
-    // Build phase on argRhs.
+    // Build phase on argRhs, unless it has an index (see `KeyIndex`).
     // ------------------------------------------------------------------------
     
     const size_t numArgRhs = argRhs->getNumRows();
-    for(size_t i = 0; i < numArgRhs; i++)
-        hs.emplace(argRhs->get(i, 0));
+    const VTRhs * valuesRhs = argRhs->getValues();
+    const size_t rowSkipRhs = argRhs->getRowSkip();
+    const std::shared_ptr<const KeyIndex> indexRhs = argRhs->getKeyIndex(0);
+    FlatHashSet<VTRhs> hs(indexRhs ? 0 : numArgRhs);
+    if(!indexRhs)
+        for(size_t i = 0; i < numArgRhs; i++)
+            hs.insert(valuesRhs[i * rowSkipRhs]);
     
     // ------------------------------------------------------------------------
     // Probe phase on argLhs.
@@ -81,10 +85,15 @@ void semiJoinCol(
     if(resLhsTid == nullptr)
         resLhsTid = DataObjectFactory::create<DenseMatrix<VTTid>>(numArgLhs, 1, false);
     
+    const VTLhs * valuesLhs = argLhs->getValues();
+    const size_t rowSkipLhs = argLhs->getRowSkip();
     size_t pos = 0;
     for(size_t i = 0; i < numArgLhs; i++) {
-        const VTLhs vLhs = argLhs->get(i, 0);
-        if(hs.count(vLhs)) {
+        const VTLhs vLhs = valuesLhs[i * rowSkipLhs];
+        const bool found = indexRhs
+                ? KeyIndexes::lookup(*indexRhs, valuesRhs, static_cast<VTRhs>(vLhs)) != KeyIndex::npos
+                : hs.contains(static_cast<VTRhs>(vLhs));
+        if(found) {
             resLhs   ->set(pos, 0, vLhs);
             resLhsTid->set(pos, 0, i);
             pos++;
@@ -144,6 +153,10 @@ void semiJoin(
     ValueTypeCode vtcLhsOn = lhs->getColumnType(lhsOn);
     ValueTypeCode vtcRhsOn = rhs->getColumnType(rhsOn);
     
+    // The column of rhs keeps an index of rhs on it, if there is one or
+    // indexes are enabled (see `KeyIndexes::get()`).
+    KeyIndexes::get(rhs, {rhs->getColumnIdx(rhsOn)}, ctx);
+    
     // Call the semiJoin-kernel on columns for the actual combination of
     // value types.
     // Repeat this for all type combinations...
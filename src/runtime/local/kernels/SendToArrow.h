@@ -0,0 +1,78 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_SENDTOARROW_H
+#define SRC_RUNTIME_LOCAL_KERNELS_SENDTOARROW_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/ArrowCData.h>
+
+#include <stdexcept>
+
+#include <cstdint>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTArg>
+struct SendToArrow {
+    static void apply(const DTArg * arg, uint64_t arrayAddress, uint64_t schemaAddress, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Exports the given frame as a record batch through Arrow's C data interface to the Python program running
+ * the script (see `DaphneLib.h`), e.g., to convert it to a pandas `DataFrame`.
+ *
+ * The numeric columns are exported without copying them and stay alive until the Python program releases the
+ * array.
+ *
+ * @param arrayAddress The address of the `ArrowArray` to export to, owned by the Python program.
+ * @param schemaAddress The address of the `ArrowSchema` to export to, owned by the Python program.
+ */
+template<class DTArg>
+void sendToArrow(const DTArg * arg, uint64_t arrayAddress, uint64_t schemaAddress, DCTX(ctx)) {
+    SendToArrow<DTArg>::apply(arg, arrayAddress, schemaAddress, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
+
+template<>
+struct SendToArrow<Frame> {
+    static void apply(const Frame * arg, uint64_t arrayAddress, uint64_t schemaAddress, DCTX(ctx)) {
+        if(arrayAddress == 0 || schemaAddress == 0)
+            throw std::runtime_error("sendToArrow: the addresses must not be null");
+#ifdef USE_ARROW
+        frameToArrowCData(arg, reinterpret_cast<struct ArrowArray *>(arrayAddress),
+                          reinterpret_cast<struct ArrowSchema *>(schemaAddress));
+#else
+        throw std::runtime_error("sendToArrow: exchanging frames requires DAPHNE to be built with Arrow");
+#endif
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_SENDTOARROW_H
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "runtime/local/context/DaphneContext.h"
+#include "runtime/local/datastructures/DataObjectFactory.h"
+#include "runtime/local/datastructures/DenseMatrix.h"
+#include "runtime/local/kernels/FastMath.h"
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace Softmax {
+    template<typename DTRes, typename DTArg>
+    struct Forward {
+        static void apply(DTRes *&res, [[maybe_unused]] const DTArg *data, DCTX(dctx)) { throw
+                std::runtime_error("C++ softmax not implemented for these data types"); }
+    };
+
+    /**
+     * @brief Computes the softmax of each row (like the CUDA kernel, which treats the rows as the channels of an
+     * image each). The row maximum is subtracted before exponentiating for numerical stability. The exponentials are
+     * written to the result and summed up in the same (vectorized) pass, and then scaled by the reciprocal of the sum.
+     */
+    template<typename VT>
+    struct Forward<DenseMatrix<VT>, DenseMatrix<VT>> {
+        static void apply(DenseMatrix<VT> *&res, const DenseMatrix<VT> *data, DCTX(dctx)) {
+            if(res == nullptr)
+                res = DataObjectFactory::create<DenseMatrix<VT>>(data->getNumRows(), data->getNumCols(), false);
+            if(dctx && dctx->config.fast_math)
+                applyRows<true>(res, data);
+            else
+                applyRows<false>(res, data);
+        }
+
+    private:
+        template<bool fastMath>
+        static void applyRows(DenseMatrix<VT> *res, const DenseMatrix<VT> *data) {
+            const size_t numRows = data->getNumRows();
+            const size_t numCols = data->getNumCols();
+            const VT *valuesData = data->getValues();
+            VT *valuesRes = res->getValues();
+
+            for(size_t r = 0; r < numRows; r++) {
+                VT max = numCols ? valuesData[0] : VT(0);
+                #pragma omp simd reduction(max:max)
+                for(size_t c = 1; c < numCols; c++)
+                    max = valuesData[c] > max ? valuesData[c] : max;
+
+                VT sum = 0;
+                #pragma omp simd reduction(+:sum)
+                for(size_t c = 0; c < numCols; c++) {
+                    VT e;
+                    if constexpr(fastMath)
+                        e = FastMath::exp(valuesData[c] - max);
+                    else
+                        e = std::exp(valuesData[c] - max);
+                    valuesRes[c] = e;
+                    sum += e;
+                }
+
+                const VT scale = VT(1) / sum;
+                #pragma omp simd
+                for(size_t c = 0; c < numCols; c++)
+                    valuesRes[c] *= scale;
+
+                valuesData += data->getRowSkip();
+                valuesRes += res->getRowSkip();
+            }
+        }
+    };
+}
@@ -19,11 +19,18 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/MetaDataObject.h>
+#include <runtime/local/kernels/IsSymmetric.h>
+#include <runtime/local/vectorized/BlasThreads.h>
 
 #include <cblas.h>
 #include <lapacke.h>
 
-#include <cassert>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
 #include <cstddef>
 
 // ****************************************************************************
@@ -44,6 +51,79 @@ void solve(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, DCTX(ctx)) {
     Solve<DTRes, DTLhs, DTRhs>::apply(res, lhs, rhs, ctx);
 }
 
+// ****************************************************************************
+// Factorization of the system matrix
+// ****************************************************************************
+
+namespace SolveFactorization {
+    /**
+     * @brief The factorization of a system matrix, which `solve` keeps with the matrix (see
+     * `MetaDataObject::getDerived()`), such that solving the same system for other right-hand sides only takes
+     * the O(n^2) triangular solves instead of another O(n^3) factorization.
+     */
+    template<typename VT>
+    struct Factors : public DerivedData {
+        // the Cholesky factor L (A = L L^T) of a symmetric positive definite matrix, or the LU factors (A = P L U)
+        bool cholesky;
+        // n x n, row-major
+        std::vector<VT> values;
+        std::vector<lapack_int> pivots;
+    };
+
+    inline lapack_int potrf(lapack_int n, float * a) { return LAPACKE_spotrf(LAPACK_ROW_MAJOR, 'L', n, a, n); }
+    inline lapack_int potrf(lapack_int n, double * a) { return LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'L', n, a, n); }
+
+    inline lapack_int getrf(lapack_int n, float * a, lapack_int * ipiv) {
+        return LAPACKE_sgetrf(LAPACK_ROW_MAJOR, n, n, a, n, ipiv);
+    }
+    inline lapack_int getrf(lapack_int n, double * a, lapack_int * ipiv) {
+        return LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, a, n, ipiv);
+    }
+
+    inline lapack_int solve(const Factors<float> & f, lapack_int n, lapack_int nrhs, float * b, lapack_int ldb) {
+        return f.cholesky
+                ? LAPACKE_spotrs(LAPACK_ROW_MAJOR, 'L', n, nrhs, f.values.data(), n, b, ldb)
+                : LAPACKE_sgetrs(LAPACK_ROW_MAJOR, 'N', n, nrhs, f.values.data(), n, f.pivots.data(), b, ldb);
+    }
+    inline lapack_int solve(const Factors<double> & f, lapack_int n, lapack_int nrhs, double * b, lapack_int ldb) {
+        return f.cholesky
+                ? LAPACKE_dpotrs(LAPACK_ROW_MAJOR, 'L', n, nrhs, f.values.data(), n, b, ldb)
+                : LAPACKE_dgetrs(LAPACK_ROW_MAJOR, 'N', n, nrhs, f.values.data(), n, f.pivots.data(), b, ldb);
+    }
+
+    /**
+     * @brief Factorizes the given square matrix, by Cholesky if it is symmetric positive definite and by LU with
+     * partial pivoting otherwise.
+     */
+    template<typename VT>
+    std::shared_ptr<const Factors<VT>> factorize(const DenseMatrix<VT> * lhs, DCTX(ctx)) {
+        const size_t n = lhs->getNumRows();
+        auto f = std::make_shared<Factors<VT>>();
+        auto copyLhs = [&]() {
+            f->values.resize(n * n);
+            const VT * valuesLhs = lhs->getValues();
+            for(size_t r = 0; r < n; r++)
+                std::copy(valuesLhs + r * lhs->getRowSkip(), valuesLhs + r * lhs->getRowSkip() + n,
+                        f->values.begin() + r * n);
+        };
+
+        copyLhs();
+        if(isSymmetric(lhs, ctx)) {
+            if(potrf(static_cast<lapack_int>(n), f->values.data()) == 0) {
+                f->cholesky = true;
+                return f;
+            }
+            // not positive definite, the failed Cholesky factorization overwrote a part of the copy
+            copyLhs();
+        }
+        f->cholesky = false;
+        f->pivots.resize(n);
+        if(getrf(static_cast<lapack_int>(n), f->values.data(), f->pivots.data()) > 0)
+            throw std::runtime_error("Solve: the matrix is singular, so the solution could not be computed");
+        return f;
+    }
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -52,50 +132,43 @@ void solve(DTRes *& res, const DTLhs * lhs, const DTRhs * rhs, DCTX(ctx)) {
 // DenseMatrix <- DenseMatrix, DenseMatrix
 // ----------------------------------------------------------------------------
 
-template<>
-struct Solve<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
-    static void apply(DenseMatrix<float> *& res, const DenseMatrix<float> * lhs, const DenseMatrix<float> * rhs, DCTX(ctx)) {
-        const auto nr1 = static_cast<int>(lhs->getNumRows());
-        const auto nc1 = static_cast<int>(lhs->getNumCols());
-        const auto nc2 = static_cast<int>(rhs->getNumCols());
-        assert((nr1 == static_cast<int>(rhs->getNumRows())) && "#rows of lhs and #rows of rhs must be the same");
-        assert((nr1 == nc1) && "#rows and #cols of lhs must be the same");
-        assert((static_cast<int>(lhs->getRowSkip()) == nc1) && "#cols of lhs must match row skip");
-        assert((nc2==1) && "#cols of rhs must be 1");
-
-        if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<float>>(nr1, nc2, false);
-
-        // solve system of equations via LU decomposition
-        int ipiv[nr1];       // permutation indexes
-        float work[nr1*nc1]; // LU factorization of gesv
-        memcpy(work, lhs->getValues(), nr1*nc1*sizeof(float));         //for in-place A
-        memcpy(res->getValues(), rhs->getValues(), nr1*sizeof(float)); //for in-place b-out
-        [[maybe_unused]] int info = LAPACKE_sgesv(LAPACK_ROW_MAJOR, nr1, 1, work, nc1, ipiv, res->getValues(), 1);
-        assert((info<=0) && "A factor Ui is exactly singular, so the solution could not be computed");
-    }
-};
-
-template<>
-struct Solve<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>> {
-    static void apply(DenseMatrix<double> *& res, const DenseMatrix<double> * lhs, const DenseMatrix<double> * rhs, DCTX(ctx)) {
-        const auto nr1 = static_cast<int>(lhs->getNumRows());
-        const auto nc1 = static_cast<int>(lhs->getNumCols());
-        const auto nc2 = static_cast<int>(rhs->getNumCols());
-        assert((nr1 == static_cast<int>(rhs->getNumRows())) && "#rows of lhs and #rows of rhs must be the same");
-        assert((nr1 == nc1) && "#rows and #cols of lhs must be the same");
-        assert((static_cast<int>(lhs->getRowSkip()) == nc1) && "#cols of lhs must match row skip");
-        assert((nc2==1) && "#cols of rhs must be 1");
+/**
+ * @brief Solves the system of linear equations `lhs x = rhs` for all columns of `rhs` at once.
+ *
+ * The factorization of `lhs` (Cholesky if it is symmetric positive definite, LU otherwise) is kept with `lhs`
+ * until its values are written, such that solving the same system again (e.g., for other right-hand sides in a
+ * loop) only takes the triangular solves. LAPACK factorizes and solves blocked and, with a multi-threaded BLAS,
+ * in parallel.
+ */
+template<typename VT>
+struct Solve<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t n = lhs->getNumRows();
+        const size_t nrhs = rhs->getNumCols();
+        if(lhs->getNumCols() != n)
+            throw std::runtime_error("Solve: #rows and #cols of lhs must be the same");
+        if(rhs->getNumRows() != n)
+            throw std::runtime_error("Solve: #rows of lhs and #rows of rhs must be the same");
 
         if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<double>>(nr1, nc2, false);
-
-        // solve system of equations via LU decomposition
-        int ipiv[nr1];       // permutation indexes
-        double work[nr1*nc1]; // LU factorization of gesv
-        memcpy(work, lhs->getValues(), nr1*nc1*sizeof(double));         //for in-place A
-        memcpy(res->getValues(), rhs->getValues(), nr1*sizeof(double)); //for in-place b-out
-        [[maybe_unused]] int info = LAPACKE_dgesv(LAPACK_ROW_MAJOR, nr1, 1, work, nc1, ipiv, res->getValues(), 1);
-        assert((info<=0) && "A factor Ui is exactly singular, so the solution could not be computed");
+            res = DataObjectFactory::create<DenseMatrix<VT>>(n, nrhs, false);
+        if(n == 0 || nrhs == 0)
+            return;
+
+        BlasThreads::prepare(ctx);
+        auto factors = lhs->getMetaDataObject().template getDerived<SolveFactorization::Factors<VT>>();
+        if(!factors) {
+            factors = SolveFactorization::factorize(lhs, ctx);
+            lhs->getMetaDataObject().setDerived(factors);
+        }
+
+        // the solution overwrites the right-hand sides
+        const VT * valuesRhs = rhs->getValues();
+        VT * valuesRes = res->getValues();
+        for(size_t r = 0; r < n; r++)
+            std::copy(valuesRhs + r * rhs->getRowSkip(), valuesRhs + r * rhs->getRowSkip() + nrhs,
+                    valuesRes + r * res->getRowSkip());
+        SolveFactorization::solve(*factors, static_cast<lapack_int>(n), static_cast<lapack_int>(nrhs), valuesRes,
+                static_cast<lapack_int>(res->getRowSkip()));
     }
 };
@@ -20,9 +20,18 @@
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/MatMul.h>
+#include <runtime/local/vectorized/BlasThreads.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
 #include <cblas.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
@@ -41,6 +50,103 @@ void syrk(DTRes *& res, const DTArg * arg, DCTX(ctx)) {
     Syrk<DTRes, DTArg>::apply(res, arg, ctx);
 }
 
+// ****************************************************************************
+// Building blocks
+// ****************************************************************************
+
+/**
+ * @brief The building blocks of `t(arg) @ arg`: the upper triangle of the result is computed (by BLAS for a dense
+ * `arg`) and mirrored to the lower one in parallel tiles.
+ *
+ * A CSR `arg` adds the outer product of each row with itself to the upper triangle, in parallel chunks of rows with
+ * about the same number of non-zeros, each into its own dense partial result (as long as these take at most
+ * `MatMulSparse::MAX_PARTIAL_CELLS` cells in total), which are summed up in parallel blocks in the end.
+ */
+namespace SyrkBlocks {
+    // the tiles of the mirroring, such that the rows read and the columns written stay in the cache
+    constexpr size_t TILE = 64;
+    // the cells of the partial results summed up by a task
+    constexpr size_t SUM_BLOCK = 1 << 14;
+
+    /**
+     * @brief Copies the upper triangle of the given (n x n) matrix to the lower one.
+     */
+    template<typename VT>
+    void mirror(VT * values, size_t n, size_t rowSkip, DCTX(ctx)) {
+        const size_t numTiles = (n + TILE - 1) / TILE;
+        WorkerPool::parallelFor(ctx, numTiles, [&](size_t t) {
+            const size_t rowBegin = t * TILE;
+            const size_t rowEnd = std::min(rowBegin + TILE, n);
+            for(size_t colBegin = 0; colBegin <= rowBegin; colBegin += TILE)
+                for(size_t r = rowBegin; r < rowEnd; r++) {
+                    const size_t colEnd = std::min(colBegin + TILE, r);
+                    for(size_t c = colBegin; c < colEnd; c++)
+                        values[r * rowSkip + c] = values[c * rowSkip + r];
+                }
+        });
+    }
+
+    template<typename VT>
+    void syrkUpper(size_t n, size_t k, const VT * arg, size_t ldArg, VT * res, size_t ldRes) {
+        if constexpr(std::is_same<VT, float>::value)
+            cblas_ssyrk(CblasRowMajor, CblasUpper, CblasTrans, n, k, 1, arg, ldArg, 0, res, ldRes);
+        else
+            cblas_dsyrk(CblasRowMajor, CblasUpper, CblasTrans, n, k, 1, arg, ldArg, 0, res, ldRes);
+    }
+
+    /**
+     * @brief Computes `t(arg) @ arg` for a CSR `arg` into the given (n x n) array, both triangles.
+     */
+    template<typename VT>
+    void sparse(VT * res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numRows = arg->getNumRows();
+        const size_t n = arg->getNumCols();
+        const VT * values = arg->getValues();
+        const size_t * colIdxs = arg->getColIdxs();
+        const size_t * rowOffsets = arg->getRowOffsets();
+        const size_t numCells = n * n;
+
+        // the multiply-adds of the outer products, estimated by the average number of non-zeros per row
+        const size_t nnz = arg->getNumNonZeros();
+        const size_t work = numRows ? nnz * (nnz / numRows + 1) / 2 : 0;
+        const size_t numChunks = std::min(MatMulSparse::getNumChunks(work, numRows),
+                std::max<size_t>(1, MatMulSparse::MAX_PARTIAL_CELLS / std::max<size_t>(1, numCells)));
+        const auto bounds = MatMulSparse::getRowChunks(rowOffsets, numRows, numChunks);
+
+        // the first chunk accumulates into the result directly
+        std::vector<VT> partials((numChunks - 1) * numCells, VT(0));
+        std::fill(res, res + numCells, VT(0));
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            VT * acc = i ? partials.data() + (i - 1) * numCells : res;
+            for(size_t r = bounds[i]; r < bounds[i + 1]; r++) {
+                const size_t begin = rowOffsets[r];
+                const size_t end = rowOffsets[r + 1];
+                // the column indexes of a row are sorted, so the products with the later ones are in the upper triangle
+                for(size_t a = begin; a < end; a++) {
+                    const VT v = values[a];
+                    VT * accRow = acc + colIdxs[a] * n;
+                    for(size_t b = a; b < end; b++)
+                        accRow[colIdxs[b]] += v * values[b];
+                }
+            }
+        });
+
+        if(numChunks > 1) {
+            WorkerPool::parallelFor(ctx, (numCells + SUM_BLOCK - 1) / SUM_BLOCK, [&](size_t blk) {
+                const size_t begin = blk * SUM_BLOCK;
+                const size_t end = std::min(begin + SUM_BLOCK, numCells);
+                for(size_t i = 0; i + 1 < numChunks; i++) {
+                    const VT * partial = partials.data() + i * numCells;
+                    #pragma omp simd
+                    for(size_t c = begin; c < end; c++)
+                        res[c] += partial[c];
+                }
+            });
+        }
+        mirror(res, n, n, ctx);
+    }
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -49,58 +155,42 @@ void syrk(DTRes *& res, const DTArg * arg, DCTX(ctx)) {
 // DenseMatrix <- DenseMatrix
 // ----------------------------------------------------------------------------
 
-template<>
-struct Syrk<DenseMatrix<double>, DenseMatrix<double>> {
-    static void apply(DenseMatrix<double> *& res, const DenseMatrix<double> * arg, DCTX(ctx)) {
+template<typename VT>
+struct Syrk<DenseMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
 
         if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<double>>(numCols, numCols, false);
-
-        cblas_dsyrk(CblasRowMajor,
-            CblasUpper,
-            CblasTrans,
-            numCols,
-            numRows,
-            1.0,
-            arg->getValues(),
-            arg->getRowSkip(),
-            0.0,
-            res->getValues(),
-            res->getRowSkip());
-        for (auto r = 0u; r < numCols; ++r) {
-            for (auto c = r + 1; c < numCols; ++c) {
-                res->set(c, r, res->get(r, c));
-            }
-        }
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numCols, numCols, false);
+
+        BlasThreads::prepare(ctx);
+        SyrkBlocks::syrkUpper(numCols, numRows, arg->getValues(), arg->getRowSkip(), res->getValues(),
+                res->getRowSkip());
+        SyrkBlocks::mirror(res->getValues(), numCols, res->getRowSkip(), ctx);
     }
 };
 
-template<>
-struct Syrk<DenseMatrix<float>, DenseMatrix<float>> {
-    static void apply(DenseMatrix<float> *& res, const DenseMatrix<float> * arg, DCTX(ctx)) {
-        const size_t numRows = arg->getNumRows();
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct Syrk<DenseMatrix<VT>, CSRMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numCols = arg->getNumCols();
 
         if(res == nullptr)
-            res = DataObjectFactory::create<DenseMatrix<float>>(numCols, numCols, false);
-
-        cblas_ssyrk(CblasRowMajor,
-            CblasUpper,
-            CblasTrans,
-            numCols,
-            numRows,
-            1.0,
-            arg->getValues(),
-            arg->getRowSkip(),
-            0.0,
-            res->getValues(),
-            res->getRowSkip());
-        for (auto r = 0u; r < numCols; ++r) {
-            for (auto c = r + 1; c < numCols; ++c) {
-                res->set(c, r, res->get(r, c));
-            }
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numCols, numCols, false);
+
+        if(res->getRowSkip() == numCols)
+            SyrkBlocks::sparse(res->getValues(), arg, ctx);
+        else {
+            std::vector<VT> tmp(numCols * numCols);
+            SyrkBlocks::sparse(tmp.data(), arg, ctx);
+            VT * valuesRes = res->getValues();
+            for(size_t r = 0; r < numCols; r++)
+                memcpy(valuesRes + r * res->getRowSkip(), tmp.data() + r * numCols, numCols * sizeof(VT));
         }
     }
 };
@@ -112,11 +202,27 @@ struct Syrk<DenseMatrix<float>, DenseMatrix<float>> {
 template<typename VT>
 struct Syrk<CSRMatrix<VT>, CSRMatrix<VT>> {
     static void apply(CSRMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
-        const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
-        
+
+        std::vector<VT> tmp(numCols * numCols);
+        SyrkBlocks::sparse(tmp.data(), arg, ctx);
+        const size_t numNonZeros = numCols * numCols - std::count(tmp.begin(), tmp.end(), VT(0));
+
         if(res == nullptr)
-            res = DataObjectFactory::create<CSRMatrix<VT>>(numCols, numRows, arg->getNumNonZeros(), false);
-        assert(false && "TODO: Syrk for Sparse");
+            res = DataObjectFactory::create<CSRMatrix<VT>>(numCols, numCols, numNonZeros, false);
+        VT * valuesRes = res->getValues();
+        size_t * colIdxsRes = res->getColIdxs();
+        size_t * rowOffsetsRes = res->getRowOffsets();
+        size_t pos = 0;
+        rowOffsetsRes[0] = 0;
+        for(size_t r = 0; r < numCols; r++) {
+            for(size_t c = 0; c < numCols; c++)
+                if(tmp[r * numCols + c] != VT(0)) {
+                    valuesRes[pos] = tmp[r * numCols + c];
+                    colIdxsRes[pos] = c;
+                    pos++;
+                }
+            rowOffsetsRes[r + 1] = pos;
+        }
     }
 };
@@ -22,6 +22,18 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <util/DeduceType.h>
+#include <util/FlatHashMap.h>
+#include <util/KllSketch.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
 
 using mlir::daphne::CompareOperation;
 
@@ -165,23 +177,22 @@ class ThetaJoin<Frame, Frame, Frame> {
     class ResultContainer {
         using posType = uint64_t;
         
-        DenseMatrix<posType> * positions = nullptr;
+        std::vector<std::pair<posType, posType>> positions;
         
         uint64_t readOffset = 0;
         uint64_t writeOffset = 0;
         uint64_t size_ = 0;
-        uint64_t maxSize = 0;
         
       public:
-        explicit ResultContainer(uint64_t maxNumRows)
-        : positions(DataObjectFactory::create<DenseMatrix<posType>>(maxNumRows, 2, false)),
-          maxSize(maxNumRows)
-        {
-            resetCursor();
-        }
+        ResultContainer() = default;
         
-        ~ResultContainer(){
-            DataObjectFactory::destroy(positions);
+        /**
+         * Creates a finalized container of the given position pairs.
+         */
+        explicit ResultContainer(std::vector<std::pair<posType, posType>> && positions_)
+        : positions(std::move(positions_)), size_(positions.size())
+        {
+            // do nothing
         }
         
         void resetCursor(){
@@ -190,25 +201,23 @@ class ThetaJoin<Frame, Frame, Frame> {
         }
         
         void addPosPair(uint64_t lhsPos_, uint64_t rhsPos_){
-            /// lhs
-            positions->set(writeOffset, 0, lhsPos_);
-            /// rhs
-            positions->set(writeOffset, 1, rhsPos_);
+            /// when filtering, the pairs are written over the pairs read before
+            if(writeOffset < positions.size())
+                positions[writeOffset] = {lhsPos_, rhsPos_};
+            else
+                positions.emplace_back(lhsPos_, rhsPos_);
             ++writeOffset;
         }
         
         [[nodiscard]] std::tuple<posType, posType> readNext(){
-            auto res = std::make_tuple(
-              /// lhs
-              positions->get(readOffset, 0),
-              /// rhs
-              positions->get(readOffset, 1));
+            const auto & pair = positions[readOffset];
             ++readOffset;
-            return std::move(res);
+            return {pair.first, pair.second};
         }
         
         void finalize(){
             size_ = writeOffset;
+            positions.resize(size_);
             resetCursor();
         }
         
@@ -216,12 +225,11 @@ class ThetaJoin<Frame, Frame, Frame> {
             return size_;
         }
         
-        [[nodiscard]] const DenseMatrix<posType> * getPositions() const {
-            return positions;
+        [[nodiscard]] posType getPos(uint64_t i, bool isLhs) const {
+            return isLhs ? positions[i].first : positions[i].second;
         }
     };
 
-    
     template< typename VTCol >
     struct WriteColumn {
         static void apply(Frame *& out, const Container& container, uint64_t inColIdx, uint64_t outColIdx,
@@ -235,7 +243,7 @@ class ThetaJoin<Frame, Frame, Frame> {
             auto * outData = reinterpret_cast<VTCol *>(out->getColumnRaw(outColIdx));
             
             for(uint64_t i = 0; i < positions->size(); ++i){
-                outData[i] = inData[positions->getPositions()->get(i, isLhs ? 0 : 1)];
+                outData[i] = inData[positions->getPos(i, isLhs)];
             }
         }
     };
@@ -293,6 +301,8 @@ class ThetaJoin<Frame, Frame, Frame> {
     /**
      * @brief Generates (or updates) a position list of two join columns, which fulfill the join condition.
      *
+     * Without a position list, all pairs of rows are compared.
+     *
      * @tparam VTLhs value type of left hand side column
      * @tparam VTRhs value type of right hand side column
      */
@@ -318,11 +328,8 @@ class ThetaJoin<Frame, Frame, Frame> {
             size_t lhsRowCount = container.lhs->getNumRows();
             size_t rhsRowCount = container.rhs->getNumRows();
             
-            if(!positions) {
-                positions = new ResultContainer(lhsRowCount * rhsRowCount);
-            }
-            
-            if(depth == 0){
+            if(!positions){
+                positions = new ResultContainer();
                 for(size_t outerLoop = 0; outerLoop < lhsRowCount; ++outerLoop){
                     for(size_t innerLoop = 0; innerLoop < rhsRowCount; ++innerLoop){
                         if(compareValues<VTLhs, VTRhs>(lhsData[outerLoop], rhsData[innerLoop], eq.cmp)){
@@ -342,6 +349,310 @@ class ThetaJoin<Frame, Frame, Frame> {
         }
     };
     
+    struct PairHash {
+        uint64_t operator()(const std::pair<uint64_t, uint64_t> & p) const {
+            return flatHashCombine(flatHashMix(p.first), p.second);
+        }
+    };
+    
+    /// the rank of a value that satisfies no comparison (NaN, or a value of rhs missing in lhs for an equality)
+    static constexpr uint64_t NO_RANK = std::numeric_limits<uint64_t>::max();
+    
+    /**
+     * @brief Maps the values of the join columns of an equation to ranks, which compare like the values (rhs values
+     * being converted to the value type of lhs, like in `compareValues`).
+     *
+     * For an inequality, the ranks are the positions of the values among the sorted distinct values of both columns.
+     * For an equality, only equal ranks are meaningful: the values of lhs are numbered in a hash map, which the values
+     * of rhs are looked up in.
+     *
+     * @tparam VTLhs value type of left hand side column
+     * @tparam VTRhs value type of right hand side column
+     */
+    template<typename VTLhs, typename VTRhs>
+    struct RankColumnPair {
+        static void apply(const Container & container, size_t eqIdx, std::vector<uint64_t> & lhsRanks,
+                          std::vector<uint64_t> & rhsRanks)
+        {
+            const Equation & eq = container.equations.at(eqIdx);
+            auto const * lhsData = reinterpret_cast<VTLhs const*>(container.lhs->getColumnRaw(eq.lhsColumnIndex));
+            auto const * rhsData = reinterpret_cast<VTRhs const*>(container.rhs->getColumnRaw(eq.rhsColumnIndex));
+            const size_t lhsRowCount = container.lhs->getNumRows();
+            const size_t rhsRowCount = container.rhs->getNumRows();
+            lhsRanks.resize(lhsRowCount);
+            rhsRanks.resize(rhsRowCount);
+            /// NaN compares false to everything
+            auto isNaN = [](VTLhs v) { return v != v; };
+            
+            if(eq.cmp == CompareOperation::Equal){
+                FlatHashMap<VTLhs, uint64_t> ids(lhsRowCount);
+                for(size_t i = 0; i < lhsRowCount; ++i)
+                    lhsRanks[i] = isNaN(lhsData[i]) ? NO_RANK : ids.emplace(lhsData[i], ids.size()).first;
+                for(size_t i = 0; i < rhsRowCount; ++i){
+                    const VTLhs v = static_cast<VTLhs>(rhsData[i]);
+                    const uint64_t * id = isNaN(v) ? nullptr : ids.find(v);
+                    rhsRanks[i] = id ? *id : NO_RANK;
+                }
+                return;
+            }
+            
+            std::vector<VTLhs> values;
+            values.reserve(lhsRowCount + rhsRowCount);
+            for(size_t i = 0; i < lhsRowCount; ++i)
+                if(!isNaN(lhsData[i]))
+                    values.push_back(lhsData[i]);
+            for(size_t i = 0; i < rhsRowCount; ++i)
+                if(!isNaN(static_cast<VTLhs>(rhsData[i])))
+                    values.push_back(static_cast<VTLhs>(rhsData[i]));
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+            auto rankOf = [&](VTLhs v) {
+                return isNaN(v) ? NO_RANK : uint64_t(std::lower_bound(values.begin(), values.end(), v) - values.begin());
+            };
+            for(size_t i = 0; i < lhsRowCount; ++i)
+                lhsRanks[i] = rankOf(lhsData[i]);
+            for(size_t i = 0; i < rhsRowCount; ++i)
+                rhsRanks[i] = rankOf(static_cast<VTLhs>(rhsData[i]));
+        }
+    };
+    
+    /// the quantiles of the rhs column at which the fraction of matching lhs rows is estimated
+    static constexpr size_t SELECTIVITY_QUANTILES = 64;
+    
+    /**
+     * @brief Estimates the fraction of the pairs of rows that satisfy an inequality by KLL sketches of both columns:
+     * the average fraction of the lhs values that satisfy it for evenly spaced quantiles of the rhs values.
+     *
+     * @tparam VTLhs value type of left hand side column
+     * @tparam VTRhs value type of right hand side column
+     */
+    template<typename VTLhs, typename VTRhs>
+    struct EstimateSelectivity {
+        static void apply(const Container & container, size_t eqIdx, double & selectivity)
+        {
+            const Equation & eq = container.equations.at(eqIdx);
+            KllSketch lhsSketch, rhsSketch;
+            lhsSketch.add(reinterpret_cast<VTLhs const*>(container.lhs->getColumnRaw(eq.lhsColumnIndex)),
+                          container.lhs->getNumRows());
+            rhsSketch.add(reinterpret_cast<VTRhs const*>(container.rhs->getColumnRaw(eq.rhsColumnIndex)),
+                          container.rhs->getNumRows());
+            selectivity = 0;
+            if(lhsSketch.empty() || rhsSketch.empty())
+                return;
+            std::vector<double> qs(SELECTIVITY_QUANTILES);
+            for(size_t i = 0; i < qs.size(); ++i)
+                qs[i] = (i + 0.5) / qs.size();
+            for(double r : rhsSketch.quantiles(qs)){
+                switch(eq.cmp){
+                    case CompareOperation::LessThan:     selectivity += lhsSketch.rank(r, false); break;
+                    case CompareOperation::LessEqual:    selectivity += lhsSketch.rank(r, true); break;
+                    case CompareOperation::GreaterThan:  selectivity += 1 - lhsSketch.rank(r, true); break;
+                    case CompareOperation::GreaterEqual: selectivity += 1 - lhsSketch.rank(r, false); break;
+                    default:
+                        throw std::runtime_error("ThetaJoin: not an inequality");
+                }
+            }
+            selectivity /= qs.size();
+        }
+    };
+    
+    /**
+     * The ranks of both columns of an inequality, which is expressed as the comparison of the rhs rank to the lhs
+     * rank, e.g., `lhs < rhs` as `rhs > lhs`.
+     */
+    struct Inequality {
+        std::vector<uint64_t> lhsRanks;
+        std::vector<uint64_t> rhsRanks;
+        CompareOperation rhsCmp;
+        
+        /**
+         * Returns the positions [begin, end) of the rhs ranks that satisfy the inequality for the lhs rank among the
+         * given sorted rhs ranks.
+         */
+        std::pair<size_t, size_t> range(const std::vector<uint64_t> & sortedRhsRanks, uint64_t lhsRank) const {
+            auto lower = [&]() { return size_t(std::lower_bound(sortedRhsRanks.begin(), sortedRhsRanks.end(), lhsRank) - sortedRhsRanks.begin()); };
+            auto upper = [&]() { return size_t(std::upper_bound(sortedRhsRanks.begin(), sortedRhsRanks.end(), lhsRank) - sortedRhsRanks.begin()); };
+            switch(rhsCmp){
+                case CompareOperation::GreaterThan:  return {upper(), sortedRhsRanks.size()};
+                case CompareOperation::GreaterEqual: return {lower(), sortedRhsRanks.size()};
+                case CompareOperation::LessThan:     return {0, lower()};
+                case CompareOperation::LessEqual:    return {0, upper()};
+                default:
+                    throw std::runtime_error("ThetaJoin: not an inequality");
+            }
+        }
+    };
+    
+    static CompareOperation mirror(CompareOperation cmp){
+        switch(cmp){
+            case CompareOperation::LessThan:     return CompareOperation::GreaterThan;
+            case CompareOperation::LessEqual:    return CompareOperation::GreaterEqual;
+            case CompareOperation::GreaterThan:  return CompareOperation::LessThan;
+            case CompareOperation::GreaterEqual: return CompareOperation::LessEqual;
+            default:                             return cmp;
+        }
+    }
+    
+    static bool isInequality(CompareOperation cmp){
+        return cmp == CompareOperation::LessThan || cmp == CompareOperation::LessEqual ||
+               cmp == CompareOperation::GreaterThan || cmp == CompareOperation::GreaterEqual;
+    }
+    
+    /**
+     * @brief Joins the rows of one partition (all rows with equal keys in the equalities) on at most two
+     * inequalities, appending the matching position pairs to `pairs`.
+     *
+     * Without an inequality, all pairs match. For one inequality, the rhs rows are sorted by their ranks and the
+     * matches of each lhs row are found by a binary search. For two inequalities, the rows are swept in the order of
+     * the first inequality (like in IEJoin): before each lhs row, the rhs rows satisfying the first inequality for it
+     * are marked in a bit array in the order of the second inequality, whose range satisfying the second inequality
+     * holds the matches.
+     */
+    static void joinPartition(const size_t * lhsBegin, const size_t * lhsEnd, const size_t * rhsBegin,
+                              const size_t * rhsEnd, const std::vector<Inequality> & ineqs,
+                              std::vector<std::pair<uint64_t, uint64_t>> & pairs)
+    {
+        if(lhsBegin == lhsEnd || rhsBegin == rhsEnd)
+            return;
+        if(ineqs.empty()){
+            for(const size_t * l = lhsBegin; l != lhsEnd; ++l)
+                for(const size_t * r = rhsBegin; r != rhsEnd; ++r)
+                    pairs.emplace_back(*l, *r);
+            return;
+        }
+        
+        /// the rhs rows ordered by their ranks in the last inequality
+        const Inequality & last = ineqs.back();
+        std::vector<size_t> byLast(rhsBegin, rhsEnd);
+        std::stable_sort(byLast.begin(), byLast.end(), [&](size_t a, size_t b) { return last.rhsRanks[a] < last.rhsRanks[b]; });
+        std::vector<uint64_t> lastRanks(byLast.size());
+        for(size_t i = 0; i < byLast.size(); ++i)
+            lastRanks[i] = last.rhsRanks[byLast[i]];
+        
+        if(ineqs.size() == 1){
+            for(const size_t * pl = lhsBegin; pl != lhsEnd; ++pl){
+                const size_t l = *pl;
+                const auto [begin, end] = last.range(lastRanks, last.lhsRanks[l]);
+                for(size_t i = begin; i < end; ++i)
+                    pairs.emplace_back(l, byLast[i]);
+            }
+            return;
+        }
+        
+        /// sweep over the first inequality, from the rhs ranks that satisfy it for all lhs ranks on
+        const Inequality & first = ineqs.front();
+        const bool descending = first.rhsCmp == CompareOperation::GreaterThan || first.rhsCmp == CompareOperation::GreaterEqual;
+        const bool strict = first.rhsCmp == CompareOperation::GreaterThan || first.rhsCmp == CompareOperation::LessThan;
+        auto before = [&](uint64_t a, uint64_t b) { return descending ? a > b : a < b; };
+        std::vector<size_t> lhsSweep(lhsBegin, lhsEnd);
+        std::stable_sort(lhsSweep.begin(), lhsSweep.end(), [&](size_t a, size_t b) { return before(first.lhsRanks[a], first.lhsRanks[b]); });
+        /// the positions of the rhs rows in byLast, in the sweep order
+        std::vector<size_t> rhsSweep(byLast.size());
+        for(size_t i = 0; i < rhsSweep.size(); ++i)
+            rhsSweep[i] = i;
+        std::stable_sort(rhsSweep.begin(), rhsSweep.end(), [&](size_t a, size_t b) { return before(first.rhsRanks[byLast[a]], first.rhsRanks[byLast[b]]); });
+        
+        std::vector<uint64_t> marked((byLast.size() + 63) / 64, 0);
+        size_t next = 0;
+        for(size_t l : lhsSweep){
+            const uint64_t a = first.lhsRanks[l];
+            for(; next < rhsSweep.size(); ++next){
+                const uint64_t b = first.rhsRanks[byLast[rhsSweep[next]]];
+                if(!(before(b, a) || (!strict && b == a)))
+                    break;
+                marked[rhsSweep[next] / 64] |= uint64_t(1) << (rhsSweep[next] % 64);
+            }
+            const auto [begin, end] = last.range(lastRanks, last.lhsRanks[l]);
+            for(size_t i = begin; i < end; ){
+                const uint64_t word = marked[i / 64] >> (i % 64);
+                if(word == 0){
+                    i = (i / 64 + 1) * 64;
+                    continue;
+                }
+                i += __builtin_ctzll(word);
+                if(i < end)
+                    pairs.emplace_back(l, byLast[i]);
+                ++i;
+            }
+        }
+    }
+    
+    /**
+     * @brief Generates the position list of the equalities and (up to two) inequalities with the given indexes by
+     * partitioning both relations on the keys of the equalities and joining each partition on the inequalities.
+     */
+    static ResultContainer * joinOnRanks(const Container & container, const std::vector<size_t> & eqIdxs,
+                                         const std::vector<size_t> & ineqIdxs)
+    {
+        const size_t lhsRowCount = container.lhs->getNumRows();
+        const size_t rhsRowCount = container.rhs->getNumRows();
+        
+        /// the partition of each row, numbering the distinct combinations of lhs keys of the equalities
+        std::vector<uint64_t> lhsParts(lhsRowCount, 0);
+        std::vector<uint64_t> rhsParts(rhsRowCount, 0);
+        uint64_t numParts = 1;
+        for(size_t k = 0; k < eqIdxs.size(); ++k){
+            std::vector<uint64_t> lhsRanks, rhsRanks;
+            DeduceValueTypeAndExecute<RankColumnPair>::apply(container.lhsSchema[container.equations[eqIdxs[k]].lhsColumnIndex],
+                    container.rhsSchema[container.equations[eqIdxs[k]].rhsColumnIndex], container, eqIdxs[k], lhsRanks, rhsRanks);
+            if(k == 0){
+                lhsParts = std::move(lhsRanks);
+                rhsParts = std::move(rhsRanks);
+                numParts = lhsRowCount;
+                continue;
+            }
+            /// the ranks are below the number of lhs rows, such that a pair of part and rank fits into 128 bits
+            FlatHashMap<std::pair<uint64_t, uint64_t>, uint64_t, PairHash> ids(lhsRowCount);
+            for(size_t i = 0; i < lhsRowCount; ++i)
+                if(lhsParts[i] != NO_RANK)
+                    lhsParts[i] = lhsRanks[i] == NO_RANK ? NO_RANK : ids.emplace({lhsParts[i], lhsRanks[i]}, ids.size()).first;
+            for(size_t i = 0; i < rhsRowCount; ++i)
+                if(rhsParts[i] != NO_RANK){
+                    const uint64_t * id = rhsRanks[i] == NO_RANK ? nullptr : ids.find({rhsParts[i], rhsRanks[i]});
+                    rhsParts[i] = id ? *id : NO_RANK;
+                }
+        }
+        
+        std::vector<Inequality> ineqs(ineqIdxs.size());
+        for(size_t k = 0; k < ineqIdxs.size(); ++k){
+            const Equation & eq = container.equations[ineqIdxs[k]];
+            DeduceValueTypeAndExecute<RankColumnPair>::apply(container.lhsSchema[eq.lhsColumnIndex],
+                    container.rhsSchema[eq.rhsColumnIndex], container, ineqIdxs[k], ineqs[k].lhsRanks, ineqs[k].rhsRanks);
+            ineqs[k].rhsCmp = mirror(eq.cmp);
+        }
+        
+        /// the rows of each partition, in ascending order, without the rows that cannot match (counting sort)
+        auto partition = [&](std::vector<uint64_t> & parts, bool isLhs, std::vector<size_t> & begins,
+                             std::vector<size_t> & rows) {
+            begins.assign(numParts + 1, 0);
+            for(size_t i = 0; i < parts.size(); ++i){
+                for(const Inequality & ineq : ineqs)
+                    if((isLhs ? ineq.lhsRanks[i] : ineq.rhsRanks[i]) == NO_RANK)
+                        parts[i] = NO_RANK;
+                if(parts[i] != NO_RANK)
+                    ++begins[parts[i] + 1];
+            }
+            for(uint64_t p = 0; p < numParts; ++p)
+                begins[p + 1] += begins[p];
+            rows.resize(begins[numParts]);
+            std::vector<size_t> next(begins.begin(), begins.end() - 1);
+            for(size_t i = 0; i < parts.size(); ++i)
+                if(parts[i] != NO_RANK)
+                    rows[next[parts[i]]++] = i;
+        };
+        std::vector<size_t> lhsBegins, lhsRows, rhsBegins, rhsRows;
+        partition(lhsParts, true, lhsBegins, lhsRows);
+        partition(rhsParts, false, rhsBegins, rhsRows);
+        
+        std::vector<std::pair<uint64_t, uint64_t>> pairs;
+        for(uint64_t p = 0; p < numParts; ++p)
+            joinPartition(lhsRows.data() + lhsBegins[p], lhsRows.data() + lhsBegins[p + 1],
+                          rhsRows.data() + rhsBegins[p], rhsRows.data() + rhsBegins[p + 1], ineqs, pairs);
+        /// the order of the nested loops
+        std::sort(pairs.begin(), pairs.end());
+        return new ResultContainer(std::move(pairs));
+    }
+    
   public:
     static void apply(Frame*& res, const Frame* lhs, const Frame* rhs, const char** lhsOn, size_t numLhsOn,
                       const char** rhsOn, size_t numRhsOn, CompareOperation* cmp, size_t numCmp) {
@@ -357,8 +668,36 @@ class ThetaJoin<Frame, Frame, Frame> {
         /// container to store result position pairs
         ResultContainer * resultPositions = nullptr;
     
-        /// iterate over equations
+        /// the equalities and (up to) two inequalities are joined on the ranks of their values, the remaining
+        /// equations filter the resulting pairs
+        std::vector<size_t> eqIdxs;
+        std::vector<size_t> ineqIdxs;
+        std::vector<size_t> filterIdxs;
         for(size_t i = 0; i < numCmp; ++i){
+            if(cmp[i] == CompareOperation::Equal)
+                eqIdxs.push_back(i);
+            else if(isInequality(cmp[i]))
+                ineqIdxs.push_back(i);
+            else
+                filterIdxs.push_back(i);
+        }
+        /// of more than two inequalities, the most selective ones as estimated by sketches of their columns are
+        /// joined on, such that the fewest pairs are filtered, and the others filter in the order of their selectivity
+        if(ineqIdxs.size() > 2){
+            std::vector<double> selectivities(numCmp, 0);
+            for(size_t i : ineqIdxs)
+                DeduceValueTypeAndExecute<EstimateSelectivity>::apply(container.getVTLhs(i), container.getVTRhs(i),
+                                                                      container, i, selectivities[i]);
+            std::stable_sort(ineqIdxs.begin(), ineqIdxs.end(),
+                             [&](size_t a, size_t b) { return selectivities[a] < selectivities[b]; });
+            filterIdxs.insert(filterIdxs.begin(), ineqIdxs.begin() + 2, ineqIdxs.end());
+            ineqIdxs.resize(2);
+        }
+        if(!eqIdxs.empty() || !ineqIdxs.empty())
+            resultPositions = joinOnRanks(container, eqIdxs, ineqIdxs);
+        
+        /// iterate over equations
+        for(size_t i : filterIdxs){
             DeduceValueTypeAndExecute<CompareColumnPair>::apply(
               /// lhs value type
                 container.getVTLhs(i),
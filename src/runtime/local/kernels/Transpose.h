@@ -19,9 +19,20 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
+#include <algorithm>
 #include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -41,6 +52,201 @@ void transpose(DTRes *& res, const DTArg * arg, DCTX(ctx)) {
     Transpose<DTRes, DTArg>::apply(res, arg, ctx);
 }
 
+// ****************************************************************************
+// Blocked transposition
+// ****************************************************************************
+
+/**
+ * @brief The building blocks of the dense transposition: the matrix is transposed in square tiles, which fit into the
+ * L1 cache together with their transposed counterparts, such that neither the reads nor the writes stride through
+ * memory. Within a tile, blocks of float/double values are transposed in SIMD registers, if available (by AVX on CPUs
+ * with AVX2, see `CpuDispatch`).
+ */
+namespace TransposeTiles {
+    // the edge length of a tile (8 KiB of double values)
+    constexpr size_t TILE = 32;
+    // matrices with fewer cells are transposed in the calling thread
+    constexpr size_t MIN_PARALLEL_CELLS = 1 << 16;
+    constexpr size_t MAX_CHUNKS = 256;
+
+    // transposes a block of SIZE x SIZE values in registers, the fallback is a single value
+    template<typename VT, CpuIsa isa>
+    struct MicroKernel {
+        static constexpr size_t SIZE = 1;
+        static void apply(const VT * src, [[maybe_unused]] size_t srcSkip, VT * dst, [[maybe_unused]] size_t dstSkip) {
+            *dst = *src;
+        }
+    };
+
+#if defined(__SSE2__)
+    // SSE2 is part of x86-64
+    template<>
+    struct MicroKernel<double, CpuIsa::GENERIC> {
+        static constexpr size_t SIZE = 2;
+        static void apply(const double * src, size_t srcSkip, double * dst, size_t dstSkip) {
+            const __m128d r0 = _mm_loadu_pd(src);
+            const __m128d r1 = _mm_loadu_pd(src + srcSkip);
+            _mm_storeu_pd(dst, _mm_unpacklo_pd(r0, r1));
+            _mm_storeu_pd(dst + dstSkip, _mm_unpackhi_pd(r0, r1));
+        }
+    };
+
+    template<>
+    struct MicroKernel<float, CpuIsa::GENERIC> {
+        static constexpr size_t SIZE = 4;
+        static void apply(const float * src, size_t srcSkip, float * dst, size_t dstSkip) {
+            __m128 r0 = _mm_loadu_ps(src);
+            __m128 r1 = _mm_loadu_ps(src + srcSkip);
+            __m128 r2 = _mm_loadu_ps(src + 2 * srcSkip);
+            __m128 r3 = _mm_loadu_ps(src + 3 * srcSkip);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(dst, r0);
+            _mm_storeu_ps(dst + dstSkip, r1);
+            _mm_storeu_ps(dst + 2 * dstSkip, r2);
+            _mm_storeu_ps(dst + 3 * dstSkip, r3);
+        }
+    };
+#endif
+
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+    template<>
+    struct MicroKernel<double, CpuIsa::AVX2> {
+        static constexpr size_t SIZE = 4;
+        DAPHNE_TARGET_AVX2 static void apply(const double * src, size_t srcSkip, double * dst, size_t dstSkip) {
+            const __m256d r0 = _mm256_loadu_pd(src);
+            const __m256d r1 = _mm256_loadu_pd(src + srcSkip);
+            const __m256d r2 = _mm256_loadu_pd(src + 2 * srcSkip);
+            const __m256d r3 = _mm256_loadu_pd(src + 3 * srcSkip);
+            // the even and odd columns of each pair of rows
+            const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+            const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+            const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+            const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+            _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+            _mm256_storeu_pd(dst + dstSkip, _mm256_permute2f128_pd(t1, t3, 0x20));
+            _mm256_storeu_pd(dst + 2 * dstSkip, _mm256_permute2f128_pd(t0, t2, 0x31));
+            _mm256_storeu_pd(dst + 3 * dstSkip, _mm256_permute2f128_pd(t1, t3, 0x31));
+        }
+    };
+
+    template<>
+    struct MicroKernel<float, CpuIsa::AVX2> {
+        static constexpr size_t SIZE = 8;
+        DAPHNE_TARGET_AVX2 static void apply(const float * src, size_t srcSkip, float * dst, size_t dstSkip) {
+            __m256 r[8];
+            for(size_t i = 0; i < 8; i++)
+                r[i] = _mm256_loadu_ps(src + i * srcSkip);
+            // interleave pairs of rows, then combine them into columns within each 128-bit lane
+            __m256 s[8];
+            for(size_t i = 0; i < 8; i += 4) {
+                const __m256 t0 = _mm256_unpacklo_ps(r[i], r[i + 1]);
+                const __m256 t1 = _mm256_unpackhi_ps(r[i], r[i + 1]);
+                const __m256 t2 = _mm256_unpacklo_ps(r[i + 2], r[i + 3]);
+                const __m256 t3 = _mm256_unpackhi_ps(r[i + 2], r[i + 3]);
+                s[i] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+                s[i + 1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+                s[i + 2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+                s[i + 3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            // the low lanes hold the columns 0-3, the high lanes the columns 4-7
+            for(size_t i = 0; i < 4; i++) {
+                _mm256_storeu_ps(dst + i * dstSkip, _mm256_permute2f128_ps(s[i], s[i + 4], 0x20));
+                _mm256_storeu_ps(dst + (i + 4) * dstSkip, _mm256_permute2f128_ps(s[i], s[i + 4], 0x31));
+            }
+        }
+    };
+#endif
+
+    // the microkernels of the given instruction set, the AVX ones on CPUs with AVX2
+    template<typename VT, CpuIsa isa>
+    using MicroKernelFor = MicroKernel<VT, CpuDispatch::includes(isa, CpuIsa::AVX2) ? CpuIsa::AVX2 : CpuIsa::GENERIC>;
+
+    /**
+     * @brief Transposes the `numRows` x `numCols` values at `src` into `dst`, i.e., `dst[c * dstSkip + r]` becomes
+     * `src[r * srcSkip + c]`. The areas must not overlap.
+     */
+    template<typename VT, CpuIsa isa>
+    void transposeTile(const VT * src, size_t srcSkip, VT * dst, size_t dstSkip, size_t numRows, size_t numCols) {
+        using Kernel = MicroKernelFor<VT, isa>;
+        constexpr size_t B = Kernel::SIZE;
+        size_t r = 0;
+        if constexpr(B > 1) {
+            for(; r + B <= numRows; r += B) {
+                size_t c = 0;
+                for(; c + B <= numCols; c += B)
+                    Kernel::apply(src + r * srcSkip + c, srcSkip, dst + c * dstSkip + r, dstSkip);
+                for(; c < numCols; c++)
+                    for(size_t rb = r; rb < r + B; rb++)
+                        dst[c * dstSkip + rb] = src[rb * srcSkip + c];
+            }
+        }
+        for(; r < numRows; r++)
+            for(size_t c = 0; c < numCols; c++)
+                dst[c * dstSkip + r] = src[r * srcSkip + c];
+    }
+
+    // the number of parallel chunks of the rows of tiles of a matrix
+    inline size_t getNumChunks(size_t numRows, size_t numCols, size_t numTileRows) {
+        return numRows * numCols < MIN_PARALLEL_CELLS ? 1 : std::min(numTileRows, MAX_CHUNKS);
+    }
+
+    /**
+     * @brief Transposes a `numRows` x `numCols` matrix at `src` into `dst`, in parallel chunks of rows of tiles.
+     */
+    template<typename VT>
+    void transpose(const VT * src, size_t srcSkip, VT * dst, size_t dstSkip, size_t numRows, size_t numCols,
+            DCTX(ctx)) {
+        const size_t numTileRows = (numRows + TILE - 1) / TILE;
+        const size_t numChunks = getNumChunks(numRows, numCols, numTileRows);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            const size_t tileRowsPerChunk = (numTileRows + numChunks - 1) / numChunks;
+            const size_t end = std::min(numTileRows, (i + 1) * tileRowsPerChunk);
+            CpuDispatch::run("transpose", [&](auto isa) {
+                for(size_t tr = i * tileRowsPerChunk; tr < end; tr++) {
+                    const size_t r0 = tr * TILE;
+                    const size_t tileRows = std::min(TILE, numRows - r0);
+                    for(size_t c0 = 0; c0 < numCols; c0 += TILE)
+                        transposeTile<VT, decltype(isa)::value>(src + r0 * srcSkip + c0, srcSkip,
+                                dst + c0 * dstSkip + r0, dstSkip, tileRows, std::min(TILE, numCols - c0));
+                }
+            });
+        });
+    }
+
+    /**
+     * @brief Transposes the contiguous square `n` x `n` matrix at `values` in place, by swapping the tiles above the
+     * diagonal with their counterparts below (in parallel, each chunk takes every `numChunks`-th row of tiles, which
+     * balances the triangular work).
+     */
+    template<typename VT>
+    void transposeSquareInPlace(VT * values, size_t n, DCTX(ctx)) {
+        const size_t numTiles = (n + TILE - 1) / TILE;
+        const size_t numChunks = getNumChunks(n, n, numTiles);
+        WorkerPool::parallelFor(ctx, numChunks, [&](size_t i) {
+            VT tmp[TILE * TILE];
+            CpuDispatch::run("transpose", [&](auto isa) {
+                constexpr CpuIsa ISA = decltype(isa)::value;
+                for(size_t ti = i; ti < numTiles; ti += numChunks) {
+                    const size_t r0 = ti * TILE;
+                    const size_t height = std::min(TILE, n - r0);
+                    // the tile on the diagonal
+                    for(size_t r = 0; r < height; r++)
+                        for(size_t c = r + 1; c < height; c++)
+                            std::swap(values[(r0 + r) * n + r0 + c], values[(r0 + c) * n + r0 + r]);
+                    for(size_t c0 = r0 + TILE; c0 < n; c0 += TILE) {
+                        const size_t width = std::min(TILE, n - c0);
+                        // tmp holds the transposed upper tile, the transposed lower tile replaces the upper one
+                        transposeTile<VT, ISA>(values + r0 * n + c0, n, tmp, TILE, height, width);
+                        transposeTile<VT, ISA>(values + c0 * n + r0, n, values + r0 * n + c0, n, width, height);
+                        for(size_t c = 0; c < width; c++)
+                            std::copy(tmp + c * TILE, tmp + c * TILE + height, values + (c0 + c) * n + r0);
+                    }
+                }
+            });
+        });
+    }
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
@@ -51,9 +257,27 @@ void transpose(DTRes *& res, const DTArg * arg, DCTX(ctx)) {
 
 template<typename VT>
 struct Transpose<DenseMatrix<VT>, DenseMatrix<VT>> {
+    /**
+     * @brief Transposes `arg` into `res`. If `res` is `arg`, the matrix is transposed in place (see `applyInPlace()`).
+     */
     static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
+
+        if(res == arg) {
+            if(!applyInPlace(res, ctx))
+                throw std::runtime_error("Transpose: in-place transposition requires a square, uniquely referenced "
+                        "matrix, which is not a view");
+            return;
+        }
+
+        // the transposition of a lazy transposition is its source
+        if(res == nullptr && arg->getTransposedSource()) {
+            const DenseMatrix<VT> * src = arg->getTransposedSource();
+            src->increaseRefCounter();
+            res = const_cast<DenseMatrix<VT> *>(src);
+            return;
+        }
         
         // skip data movement for vectors
         // FIXME: The check (numCols == arg->getRowSkip()) is a hack to check if the input arg is only a "view"
@@ -61,23 +285,31 @@ struct Transpose<DenseMatrix<VT>, DenseMatrix<VT>> {
         if ((numRows == 1 || numCols == 1) && (numCols == arg->getRowSkip())) {
             res = DataObjectFactory::create<DenseMatrix<VT>>(numCols, numRows, arg->getValuesSharedPtr());
         }
-        else
-        {
-            if (res == nullptr)
-                res = DataObjectFactory::create<DenseMatrix<VT>>(numCols, numRows, false);
-
-            const VT *valuesArg = arg->getValues();
-            const size_t rowSkipArg = arg->getRowSkip();
-            const size_t rowSkipRes = res->getRowSkip();
-            for (size_t r = 0; r < numRows; r++) {
-                VT *valuesRes = res->getValues() + r;
-                for (size_t c = 0; c < numCols; c++) {
-                    *valuesRes = valuesArg[c];
-                    valuesRes += rowSkipRes;
-                }
-                valuesArg += rowSkipArg;
-            }
+        else if(res == nullptr) {
+            // The values are only transposed when a kernel which cannot read the transposition natively accesses
+            // them, e.g., a transposition passed to a function or kept across the iterations of a loop may never be.
+            res = DataObjectFactory::create<DenseMatrix<VT>>(arg);
         }
+        else
+            TransposeTiles::transpose(arg->getValues(), arg->getRowSkip(), res->getValues(), res->getRowSkip(),
+                    numRows, numCols, ctx);
+    }
+
+    /**
+     * @brief Transposes a square matrix in place, i.e., without allocating a result, e.g., if the input of a
+     * transposition is not used afterwards.
+     *
+     * @return `false` if the matrix was left unchanged, because it is not square, or its values are shared with
+     * other references to it or with views.
+     */
+    static bool applyInPlace(DenseMatrix<VT> * mat, DCTX(ctx)) {
+        const size_t n = mat->getNumRows();
+        // the returned shared pointer is the second owner of the values if there are no views on them
+        if(mat->getNumCols() != n || mat->getRowSkip() != n || mat->getRefCounter() != 1 ||
+                mat->getValuesSharedPtr().use_count() != 2)
+            return false;
+        TransposeTiles::transposeSquareInPlace(mat->getValues(), n, ctx);
+        return true;
     }
 };
 
@@ -94,29 +326,39 @@ struct Transpose<CSRMatrix<VT>, CSRMatrix<VT>> {
         if(res == nullptr)
             res = DataObjectFactory::create<CSRMatrix<VT>>(numCols, numRows, arg->getNumNonZeros(), false);
         
-        const VT * valuesArg = arg->getValues();
-        const size_t * colIdxsArg = arg->getColIdxs();
-        const size_t * rowOffsetsArg = arg->getRowOffsets();
-        
-        VT * valuesRes = res->getValues();
-        VT * const valuesResInit = valuesRes;
-        size_t * colIdxsRes = res->getColIdxs();
-        size_t * rowOffsetsRes = res->getRowOffsets();
-        
-        auto* curRowOffsets = new size_t[numRows + 1];
-        memcpy(curRowOffsets, rowOffsetsArg, (numRows + 1) * sizeof(size_t));
-        
-        rowOffsetsRes[0] = 0;
-        for(size_t c = 0; c < numCols; c++) {
-            for(size_t r = 0; r < numRows; r++)
-                if(curRowOffsets[r] < rowOffsetsArg[r + 1] && colIdxsArg[curRowOffsets[r]] == c) {
-                    *valuesRes++ = valuesArg[curRowOffsets[r]];
-                    *colIdxsRes++ = r;
-                    curRowOffsets[r]++;
-                }
-            rowOffsetsRes[c + 1] = valuesRes - valuesResInit;
-        }
-        
-        delete[] curRowOffsets;
+        arg->transposeInto(res);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DCSRMatrix <- DCSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct Transpose<DCSRMatrix<VT>, DCSRMatrix<VT>> {
+    static void apply(DCSRMatrix<VT> *& res, const DCSRMatrix<VT> * arg, DCTX(ctx)) {
+        const size_t numNonZeros = arg->getNumNonZeros();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DCSRMatrix<VT>>(arg->getNumCols(), arg->getNumRows(), numNonZeros);
+
+        // The non-zeros are sorted by their column rather than counted per column, such that the work and memory
+        // are independent of the number of columns. A stable sort keeps the rows of a column in ascending order.
+        const size_t * rowIdxs = arg->getRowIdxs();
+        const size_t * rowOffsets = arg->getRowOffsets();
+        const size_t * colIdxs = arg->getColIdxs();
+        const VT * values = arg->getValues();
+        std::vector<size_t> rowOf(numNonZeros);
+        for(size_t i = 0; i < arg->getNumNonZeroRows(); i++)
+            std::fill(rowOf.begin() + rowOffsets[i], rowOf.begin() + rowOffsets[i + 1], rowIdxs[i]);
+        std::vector<size_t> perm(numNonZeros);
+        for(size_t k = 0; k < numNonZeros; k++)
+            perm[k] = k;
+        std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) { return colIdxs[a] < colIdxs[b]; });
+
+        res->prepareAppend();
+        for(size_t k : perm)
+            res->append(colIdxs[k], rowOf[k], values[k]);
+        res->finishAppend();
     }
 };
@@ -24,6 +24,7 @@ enum class UnaryOpCode {
     SIGN, // signum (-1, 0, +1)
     SQRT,
     EXP,
+    LN, // natural logarithm
     // Rounding.
     ABS,
     FLOOR,
@@ -19,8 +19,17 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/RowChunkReader.h>
+#include <runtime/local/kernels/Read.h>
 #include <runtime/local/vectorized/MTWrapper.h>
 #include <ir/daphneir/Daphne.h>
+#include <parser/metadata/MetaDataParser.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
@@ -35,8 +44,23 @@ using mlir::daphne::VectorCombine;
 template<class DTRes>
 struct VectorizedPipeline {
     static void apply(DTRes ** outputs, size_t numOutputs, bool* isScalar, Structure **inputs, size_t numInputs, int64_t *outRows,
-            int64_t *outCols, int64_t *splits, int64_t *combines, size_t numFuncs, void** fun, DCTX(ctx)) {
-        auto wrapper = std::make_unique<MTWrapper<DTRes>>(numFuncs, ctx);
+            int64_t *outCols, int64_t *splits, int64_t *combines, size_t numFuncs, void** fun, const char * ops,
+            int64_t numThreads, const char * schedule, DCTX(ctx)) {
+        // a cancelled run stops at the next pipeline
+        RunControl * control = ctx->getRunControl();
+        control->throwIfCancelled();
+
+        // the number of threads and the partitioning scheme of a DaphneDSL annotation override the user config
+        SelfSchedulingScheme scheme = INVALID;
+        if(*schedule) {
+            scheme = Autotuner::parseSchemeName(schedule);
+            if(scheme == INVALID)
+                throw std::runtime_error("unknown partitioning scheme of the vectorized pipeline: "
+                        + std::string(schedule));
+        }
+        const bool isHinted = numThreads > 0 || scheme != INVALID;
+
+        auto wrapper = std::make_unique<MTWrapper<DTRes>>(numFuncs, ctx, numThreads, scheme);
 
         std::vector<std::function<void(DTRes ***, Structure **, DCTX(ctx))>> funcs;
         for (auto i = 0ul; i < numFuncs; ++i) {
@@ -49,13 +73,66 @@ struct VectorizedPipeline {
         for(size_t i = 0; i < numOutputs; i++)
             outputs2[i] = outputs + i;
         
-        if(ctx->getUserConfig().vectorized_single_queue) {
+        // the outputs allocated by the pipeline, which are freed if the run is cancelled
+        std::vector<bool> allocated(numOutputs);
+        for(size_t i = 0; i < numOutputs; i++)
+            allocated[i] = outputs[i] == nullptr;
+
+        auto vSplits = reinterpret_cast<VectorSplit *>(splits);
+        auto streamIt = std::find(vSplits, vSplits + numInputs, VectorSplit::STREAM);
+        if(streamIt == vSplits + numInputs) {
+            uint64_t numRows = 0;
+            for(size_t i = 0; i < numInputs; i++)
+                if(vSplits[i] == VectorSplit::ROWS || vSplits[i] == VectorSplit::COLS)
+                    numRows = std::max<uint64_t>(numRows, BroadcastInputPins::getSplitExtent(vSplits[i], inputs[i]));
+            control->beginPipeline(numRows);
+        }
+        if(streamIt != vSplits + numInputs) {
+            // frames are not read in chunks of rows (see isStreamableRead)
+            if constexpr(std::is_same<DTRes, Frame>::value)
+                throw std::runtime_error("the vectorized pipeline cannot read a frame in chunks of rows");
+            else {
+                // the input is the name of the file of a fused read, see VectorizeComputationsPass
+                const size_t streamInput = streamIt - vSplits;
+                const char * filename = reinterpret_cast<const char *>(inputs[streamInput]);
+                FileMetaData fmd = MetaDataParser::readMetaData(filename);
+                using Format = typename RowChunkReader<typename DTRes::VT>::Format;
+                Format format;
+                switch(extValue(filename)) {
+                    case 0: format = Format::CSV; break;
+                    case 3: format = Format::DAPHNE; break;
+                    default:
+                        throw std::runtime_error("the vectorized pipeline cannot read the file '"
+                                + std::string(filename) + "' in chunks of rows");
+                }
+                RowChunkReader<typename DTRes::VT> source(filename, format, fmd.numRows, fmd.numCols, ',', ctx);
+                control->beginPipeline(fmd.numRows);
+                // the GPU function (if any) is not used, the chunks are processed by the CPU workers
+                wrapper->executeStreaming(funcs, outputs2, isScalar, inputs, numInputs, numOutputs, outRows, outCols,
+                        vSplits, reinterpret_cast<VectorCombine *>(combines), streamInput, source, ctx, false);
+            }
+        }
+        else if(ctx->getUserConfig().vectorized_single_queue) {
             wrapper->executeSingleQueue(funcs, outputs2, isScalar, inputs, numInputs, numOutputs, outRows, outCols,
                     reinterpret_cast<VectorSplit *>(splits), reinterpret_cast<VectorCombine *>(combines), ctx, false);
         }
         else if(!ctx->getUserConfig().vectorized_single_queue && numFuncs == 1) {
-            wrapper->executeCpuQueues(funcs, outputs2, isScalar, inputs, numInputs, numOutputs, outRows, outCols,
-                    reinterpret_cast<VectorSplit *>(splits), reinterpret_cast<VectorCombine *>(combines), ctx, false);
+            bool tuned = false;
+            // only the configuration of dense pipelines is tuned, unless it is given by an annotation
+            if constexpr(!std::is_same<DTRes, Frame>::value) {
+                if constexpr(std::is_same<DTRes, DenseMatrix<typename DTRes::VT>>::value) {
+                    if(ctx->getUserConfig().vectorized_autotune && !isHinted) {
+                        wrapper->executeAutotuned(funcs, outputs2, isScalar, inputs, numInputs, numOutputs, outRows,
+                                outCols, reinterpret_cast<VectorSplit *>(splits),
+                                reinterpret_cast<VectorCombine *>(combines), ops, ctx, false);
+                        tuned = true;
+                    }
+                }
+            }
+            if(!tuned)
+                wrapper->executeCpuQueues(funcs, outputs2, isScalar, inputs, numInputs, numOutputs, outRows, outCols,
+                        reinterpret_cast<VectorSplit *>(splits), reinterpret_cast<VectorCombine *>(combines), ctx,
+                        false);
         }
         else {
             wrapper->executeQueuePerDeviceType(funcs, outputs2, isScalar, inputs, numInputs, numOutputs, outRows, outCols,
@@ -63,6 +140,15 @@ struct VectorizedPipeline {
         }
         
         delete[] outputs2;
+
+        if(control->isCancelled()) {
+            for(size_t i = 0; i < numOutputs; i++)
+                if(allocated[i] && outputs[i]) {
+                    DataObjectFactory::destroy(outputs[i]);
+                    outputs[i] = nullptr;
+                }
+            control->throwIfCancelled();
+        }
     }
 };
 
@@ -73,7 +159,7 @@ struct VectorizedPipeline {
 template<class DTRes>
 [[maybe_unused]] void vectorizedPipeline(DTRes ** outputs, size_t numOutputs, bool* isScalar, Structure **inputs,
         size_t numInputs, int64_t *outRows, int64_t *outCols, int64_t *splits, int64_t *combines, size_t numFuncs,
-        void** fun, DCTX(ctx)) {
+        void** fun, const char * ops, int64_t numThreads, const char * schedule, DCTX(ctx)) {
     VectorizedPipeline<DTRes>::apply(outputs, numOutputs, isScalar, inputs, numInputs, outRows, outCols, splits,
-            combines, numFuncs, fun, ctx);
+            combines, numFuncs, fun, ops, numThreads, schedule, ctx);
 }
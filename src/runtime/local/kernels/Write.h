@@ -20,12 +20,19 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/ArrowIpc.h>
 #include <runtime/local/io/File.h>
 #include <runtime/local/io/FileMetaData.h>
 #include <runtime/local/io/WriteCsv.h>
 #include <runtime/local/io/WriteDaphne.h>
+#include <runtime/local/kernels/CollectColumnStatistics.h>
 #include <parser/metadata/MetaDataParser.h>
 
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -60,14 +67,80 @@ struct Write<DenseMatrix<VT>> {
 	auto pos = fn.find_last_of('.');
 	std::string ext(fn.substr(pos+1)) ;
 	if (ext == "csv") {
-		File * file = openFileForWrite(filename);
 		FileMetaData metaData(arg->getNumRows(), arg->getNumCols(), true, ValueTypeUtils::codeFor<VT>);
 		MetaDataParser::writeMetaData(filename, metaData);
-		writeCsv(arg, file);
-		closeFile(file);
+		CsvWriteOptions opts;
+		opts.ctx = ctx;
+		writeCsv(arg, filename, opts);
 	} else if (ext == "dbdf") {
-		writeDaphne(arg, filename);
+		DF_options opts;
+		if (ctx) {
+			opts.rowsPerBlock = ctx->config.daphne_file_block_rows;
+			opts.compression = DF_compressionFromString(ctx->config.daphne_file_compression);
+			opts.ctx = ctx;
+		}
+		writeDaphne(arg, filename, opts);
 	}
+#ifdef USE_ARROW
+	else if (ext == "arrow" || ext == "feather" || ext == "arrows") {
+		FileMetaData metaData(arg->getNumRows(), arg->getNumCols(), true, ValueTypeUtils::codeFor<VT>);
+		MetaDataParser::writeMetaData(filename, metaData);
+		ArrowIpcWriteOptions opts;
+		opts.stream = ext == "arrows";
+		writeArrowIpc(arg, filename, opts);
+	}
+#else
+	else if (ext == "arrow" || ext == "feather" || ext == "arrows")
+		throw std::runtime_error("Write: writing Arrow IPC files requires DAPHNE to be built with Arrow");
+#endif
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
+
+template<>
+struct Write<Frame> {
+    static void apply(const Frame * arg, const char * filename, DCTX(ctx)) {
+	std::string fn(filename);
+	auto pos = fn.find_last_of('.');
+	std::string ext(fn.substr(pos+1)) ;
+	if (ext == "dbdf") {
+		writeFrameMetaData(arg, filename);
+		DF_options opts;
+		opts.ctx = ctx;
+		opts.keyIndexes = ctx && ctx->config.key_indexes;
+		writeDaphne(arg, filename, opts);
+		writeColumnStatistics(arg, filename, ctx);
+		return;
+	}
+#ifdef USE_ARROW
+	if (ext == "arrow" || ext == "feather" || ext == "arrows") {
+		writeFrameMetaData(arg, filename);
+		ArrowIpcWriteOptions opts;
+		opts.stream = ext == "arrows";
+		writeArrowIpc(arg, filename, opts);
+		writeColumnStatistics(arg, filename, ctx);
+		return;
+	}
+#endif
+	throw std::runtime_error("Write: frames can only be written to Daphne binary or Arrow IPC files, not " + fn);
+    }
+
+    static void writeFrameMetaData(const Frame * arg, const char * filename) {
+	const ValueTypeCode * schema = arg->getSchema();
+	const std::string * labels = arg->getLabels();
+	FileMetaData metaData(arg->getNumRows(), arg->getNumCols(), false,
+			std::vector<ValueTypeCode>(schema, schema + arg->getNumCols()),
+			std::vector<std::string>(labels, labels + arg->getNumCols()));
+	MetaDataParser::writeMetaData(filename, metaData);
+    }
+
+    // after the file, whose size and modification time the statistics are stamped with, see ColumnStatistics
+    static void writeColumnStatistics(const Frame * arg, const char * filename, DCTX(ctx)) {
+	if (ctx && ctx->config.column_statistics)
+		MetaDataParser::writeColumnStatistics(filename, collectColumnStatistics(arg, ctx));
     }
 };
 
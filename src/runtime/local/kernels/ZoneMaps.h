@@ -0,0 +1,169 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/ColumnStats.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+#include <util/DeduceType.h>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+/**
+ * @brief The computation of the statistics of the columns of frames and dense matrices (see `ZoneMap`) in parallel
+ * blocks on the `WorkerPool`, their maintenance by order-preserving kernels, and the skipping of blocks by them.
+ */
+namespace ZoneMaps {
+    /**
+     * @brief The outcome of a comparison of all values of a block with a scalar, as far as the statistics of the
+     * block tell.
+     */
+    enum class BlockMatch {
+        NONE,
+        ALL,
+        SOME,
+    };
+
+    /**
+     * @brief Returns whether the comparison `value op rhs` is false for all values of the b-th block (`NONE`), true
+     * for all of them (`ALL`), or cannot be decided by the statistics (`SOME`).
+     *
+     * Nulls (NaNs) compare false, except for `NEQ`. A NaN `rhs` is never decided.
+     */
+    template<typename VT>
+    BlockMatch match(BinaryOpCode opCode, const ZoneMap<VT> & zm, size_t b, VT rhs) {
+        if(zm.isAllNull(b))
+            return opCode == BinaryOpCode::NEQ ? BlockMatch::ALL : BlockMatch::NONE;
+        const VT mn = zm.getMin(b);
+        const VT mx = zm.getMax(b);
+        const bool noNulls = zm.getNullCount(b) == 0;
+        // the decisions for the values that are not null
+        bool none;
+        bool all;
+        switch(opCode) {
+            case BinaryOpCode::EQ:  none = rhs < mn || mx < rhs; all = mn == rhs && mx == rhs; break;
+            case BinaryOpCode::NEQ: none = mn == rhs && mx == rhs; all = rhs < mn || mx < rhs; break;
+            case BinaryOpCode::LT:  none = mn >= rhs; all = mx < rhs;  break;
+            case BinaryOpCode::LE:  none = mn > rhs;  all = mx <= rhs; break;
+            case BinaryOpCode::GT:  none = mx <= rhs; all = mn > rhs;  break;
+            case BinaryOpCode::GE:  none = mx < rhs;  all = mn >= rhs; break;
+            default: return BlockMatch::SOME;
+        }
+        if(opCode == BinaryOpCode::NEQ) {
+            if(all)
+                return BlockMatch::ALL;
+            return none && noNulls ? BlockMatch::NONE : BlockMatch::SOME;
+        }
+        if(none)
+            return BlockMatch::NONE;
+        return all && noNulls ? BlockMatch::ALL : BlockMatch::SOME;
+    }
+
+    /**
+     * @brief Computes the statistics of all columns of a dense matrix, which keeps them until its values are
+     * written (see `DenseMatrix::getZoneMap()`).
+     */
+    template<typename VT>
+    void computeMatrix(const DenseMatrix<VT> * mat, DCTX(ctx)) {
+        const size_t numCols = mat->getNumCols();
+        const VT * values = mat->getValues();
+        std::vector<std::shared_ptr<ZoneMap<VT>>> zms(numCols);
+        for(size_t c = 0; c < numCols; c++)
+            zms[c] = std::make_shared<ZoneMap<VT>>(mat->getNumRows());
+        const size_t numBlocks = numCols ? zms[0]->getNumBlocks() : 0;
+        WorkerPool::parallelFor(ctx, numCols * numBlocks, [&](size_t i) {
+            const size_t c = i / numBlocks;
+            zms[c]->initBlock(i % numBlocks, values + c, mat->getRowSkip());
+        });
+        std::vector<std::shared_ptr<const ZoneMap<VT>>> res(numCols);
+        for(size_t c = 0; c < numCols; c++) {
+            zms[c]->finish();
+            res[c] = std::move(zms[c]);
+        }
+        mat->setZoneMaps(std::move(res));
+    }
+
+    // Creates the (not yet computed) statistics of the c-th column of a frame and the tasks computing its blocks.
+    template<typename VT>
+    struct FrameColumn {
+        static void apply(std::shared_ptr<ColumnStats> & stats, std::vector<std::function<void()>> & tasks,
+                const Frame * frame, size_t c) {
+            auto zm = std::make_shared<ZoneMap<VT>>(frame->getNumRows());
+            const VT * values = static_cast<const VT *>(frame->getColumnRaw(c));
+            for(size_t b = 0; b < zm->getNumBlocks(); b++)
+                tasks.emplace_back([zm, values, b]() { zm->initBlock(b, values); });
+            stats = zm;
+        }
+    };
+
+    // Finishes the statistics of a column, once all its blocks are computed.
+    template<typename VT>
+    struct FinishFrameColumn {
+        static void apply(ColumnStats * stats) {
+            static_cast<ZoneMap<VT> *>(stats)->finish();
+        }
+    };
+
+    /**
+     * @brief Computes the statistics of all columns of numbers of a frame, all blocks of all columns in parallel.
+     */
+    inline void computeFrame(Frame * frame, DCTX(ctx)) {
+        const size_t numCols = frame->getNumCols();
+        const ValueTypeCode * schema = frame->getSchema();
+        std::vector<std::shared_ptr<ColumnStats>> stats(numCols);
+        std::vector<std::function<void()>> tasks;
+        for(size_t c = 0; c < numCols; c++)
+            if(schema[c] != ValueTypeCode::STR)
+                DeduceValueTypeAndExecute<FrameColumn>::apply(schema[c], stats[c], tasks, frame, c);
+        WorkerPool::parallelFor(ctx, tasks.size(), [&](size_t i) { tasks[i](); });
+        for(size_t c = 0; c < numCols; c++)
+            if(stats[c]) {
+                DeduceValueTypeAndExecute<FinishFrameColumn>::apply(schema[c], stats[c].get());
+                frame->setColumnStats(c, std::move(stats[c]));
+            }
+    }
+
+    // Sets the statistics of a column known to be sorted without nulls, see `keepSorted()`.
+    template<typename VT>
+    struct SortedColumn {
+        static void apply(Frame * res, size_t resCol) {
+            const Frame * constRes = res;
+            const VT * values = static_cast<const VT *>(constRes->getColumnRaw(resCol));
+            res->setColumnStats(resCol, ZoneMap<VT>::computeSorted(values, res->getNumRows()));
+        }
+    };
+
+    /**
+     * @brief Keeps the sortedness of the argCol-th column of arg in the resCol-th column of res, which an
+     * order-preserving kernel (e.g., a filter or a merge join) wrote from its rows in ascending order.
+     *
+     * Only the first and the last value of each block of the result are read, since a sorted column has no nulls.
+     */
+    inline void keepSorted(Frame * res, size_t resCol, const Frame * arg, size_t argCol) {
+        if(arg->isColumnSorted(argCol) && res->getNumRows())
+            DeduceValueTypeAndExecute<SortedColumn>::apply(res->getColumnType(resCol), res, resCol);
+    }
+}
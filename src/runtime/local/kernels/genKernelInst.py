@@ -22,6 +22,13 @@ part of a pre-compiled kernel library. Each kernel instantiation is wrapped by
 a shallow function that can be called from the JIT-compiled user program. An
 input JSON-file specifies which kernel shall be instantiated with which
 template arguments.
+
+The kernels of the C++ API are split into several libraries by the optional
+"library" of each kernel in the JSON-file (by default "AllKernels"). If LIBRARY
+is given, only the kernels of this library are generated. With the API INDEX,
+a text file mapping the functions of the kernels outside of "AllKernels" to
+their library is generated instead, such that only the libraries used by a
+program need to be loaded (see DaphneIrExecutor).
 """
 
 # TODO Note that this script currently makes strong assumptions about the
@@ -31,11 +38,16 @@ template arguments.
 # the input JSON-file will be simplified significantly later on.
 
 import io
+import itertools
 import json
 import sys
 
 INDENT = 4 * " "
 DEFAULT_NEWRESPARAM = "res"
+DEFAULT_LIBRARY = "AllKernels"
+
+# The names of all functions generated so far.
+generatedFunctions = []
 
 
 def toCppType(t):
@@ -50,7 +62,7 @@ def toCppType(t):
         return t
 
 
-def generateKernelInstantiation(kernelTemplateInfo, templateValues, opCodes, outFile, API):
+def generateKernelInstantiation(kernelTemplateInfo, templateValues, opCodes, outFile, API, shape=None):
     # Extract some information.
     opName = kernelTemplateInfo["opName"]
     returnType = kernelTemplateInfo["returnType"]
@@ -59,6 +71,19 @@ def generateKernelInstantiation(kernelTemplateInfo, templateValues, opCodes, out
     opCodeAsTemplateParam = False
     if "opCodeAsTemplateParam" in kernelTemplateInfo:
         opCodeAsTemplateParam = True if kernelTemplateInfo["opCodeAsTemplateParam"] == 1 else False
+    # The optional reuse of the results of a deterministic kernel: "cache" for
+    # looking them up in the ReuseCache, "lineage" for only deriving the lineage
+    # of the results, such that kernels using them may be looked up.
+    reuse = kernelTemplateInfo.get("reuse", None)
+    if reuse not in [None, "cache", "lineage"]:
+        raise RuntimeError("unexpected reuse of kernel {}: {}".format(opName, reuse))
+    # Not for kernels with static shapes, whose small results are cheaper to
+    # recompute than to look up.
+    if API != "CPP" or returnType != "void" or shape is not None:
+        reuse = None
+
+    if shape is not None and opCodeAsTemplateParam:
+        raise RuntimeError("static shapes are not supported for op-codes as template parameters: {}".format(opName))
 
     if opCodes is not None:
         # We assume that the op-code is the first run-time parameter.
@@ -139,6 +164,13 @@ def generateKernelInstantiation(kernelTemplateInfo, templateValues, opCodes, out
             funcName = funcName.replace(opCodeWord, opCode[0].upper() + opCode[1:].lower())
             funcName = funcName.replace(opCodeWord.lower(), opCode.lower())
 
+        # Kernels for a static shape get their dimensions as a suffix, e.g.,
+        # "_ewAdd_2x2", see MarkStaticShapeOpsPass.
+        if shape is not None:
+            funcName += "_" + "x".join(str(d) for d in shape)
+
+        generatedFunctions.append(funcName + typesForName)
+
         # Signature of the function wrapping the kernel instantiation.
         outFile.write(INDENT + "void {}{}({}) {{\n".format(
             funcName,
@@ -160,7 +192,8 @@ def generateKernelInstantiation(kernelTemplateInfo, templateValues, opCodes, out
         ])
 
         # List of template parameters for the call.
-        callTemplateParams = [toCppType(tv) for tv in templateValues]
+        callTemplateParams = ([str(d) for d in shape] if shape is not None else []) + \
+                             [toCppType(tv) for tv in templateValues]
         if opCodeAsTemplateParam and opCode is not None:
             opCodeWord = opCodeType[:-len("OpCode")]
             callTemplateParams = ["{}::{}".format(opCodeWord if API == "CPP" else API + "::" + opCodeWord, opCode)] + callTemplateParams
@@ -170,15 +203,28 @@ def generateKernelInstantiation(kernelTemplateInfo, templateValues, opCodes, out
         if returnType != "void":
             outFile.write("*{} = ".format(DEFAULT_NEWRESPARAM))
 
-        kernelCallString = "{}{}::apply({});\n" if opCodeAsTemplateParam else "{}{}({});\n"
+        kernelCallString = "{}{}::apply({})" if opCodeAsTemplateParam else "{}{}({})"
 
-        outFile.write(kernelCallString.format(
+        kernelCall = kernelCallString.format(
             opName if API == "CPP" else (API + "::" + opName),
             # Template parameters, if the kernel is a template:
-            "<{}>".format(", ".join(callTemplateParams)) if len(templateValues) else "",
+            "<{}>".format(", ".join(callTemplateParams)) if len(templateValues) or shape is not None else "",
             # Run-time parameters, possibly including DaphneContext:
             ", ".join(callParams + ([] if isCreateDaphneContext else ["ctx"])),
-        ))
+        )
+        if reuse is None:
+            outFile.write(kernelCall + ";\n")
+        else:
+            # The kernel call is wrapped by the ReuseCache, which identifies it
+            # by the function name and the inputs (the first parameter is the
+            # result).
+            outFile.write("ReuseCache::{}(\"{}\", *{}, [&]() {{ {}; }}{});\n".format(
+                "call" if reuse == "cache" else "callDerivingLineage",
+                funcName + typesForName,
+                extendedRuntimeParams[0]["name"],
+                kernelCall,
+                "".join(", " + rp["name"] for rp in extendedRuntimeParams[1:])
+            ))
         outFile.write(INDENT + "}\n")
 
     # Generate the function(s).
@@ -190,8 +236,28 @@ def generateKernelInstantiation(kernelTemplateInfo, templateValues, opCodes, out
     # outFile.write(INDENT + "\n")
 
 
+def getStaticShapes(info):
+    """
+    Returns all static shapes a kernel is instantiated for, given by the maximum
+    of each dimension, e.g., [4, 4] for all matrices of up to 4x4 cells.
+    """
+    if "staticShapes" not in info:
+        return []
+    return list(itertools.product(*(range(1, maxDim + 1) for maxDim in info["staticShapes"])))
+
+
+def generateKernelInstantiations(kernelTemplateInfo, info, instantiation, opCodes, outFile, API):
+    # Kernels with static shapes are only instantiated for them, their
+    # generic instantiations are specified separately.
+    shapes = getStaticShapes(info)
+    if not shapes:
+        generateKernelInstantiation(kernelTemplateInfo, instantiation, opCodes, outFile, API)
+    for shape in shapes:
+        generateKernelInstantiation(kernelTemplateInfo, instantiation, opCodes, outFile, API, shape)
+
+
 def printHelp():
-    print("Usage: python3 {} INPUT_SPEC_FILE OUTPUT_CPP_FILE API".format(sys.argv[0]))
+    print("Usage: python3 {} INPUT_SPEC_FILE OUTPUT_CPP_FILE API [LIBRARY]".format(sys.argv[0]))
     print(__doc__)
 
 
@@ -199,7 +265,7 @@ if __name__ == "__main__":
     if len(sys.argv) == 2 and (sys.argv[1] == "-h" or sys.argv[1] == "--help"):
         printHelp()
         sys.exit(0)
-    elif len(sys.argv) != 4:
+    elif len(sys.argv) not in [4, 5]:
         print("Wrong number of arguments.")
         print()
         printHelp()
@@ -208,8 +274,15 @@ if __name__ == "__main__":
     inFilePath = sys.argv[1]
     outFilePath = sys.argv[2]
     API = sys.argv[3]
+    library = sys.argv[4] if len(sys.argv) == 5 else None
+    # The index is generated from the functions of the C++ API.
+    isIndex = API == "INDEX"
+    if isIndex:
+        API = "CPP"
     ops_inst_str = ""
     header_str = ""
+    # The library of each generated function outside of the default library.
+    index = []
 
     # Load the specification (which kernel template shall be instantiated
     # with which template arguments) from a JSON-file.
@@ -218,6 +291,10 @@ if __name__ == "__main__":
 
         for kernelInfo in kernelsInfo:
             kernelTemplateInfo = kernelInfo["kernelTemplate"]
+            kernelLibrary = kernelInfo.get("library", DEFAULT_LIBRARY)
+            if API == "CPP" and library is not None and kernelLibrary != library:
+                continue
+            numGenerated = len(generatedFunctions)
             if "api" in kernelInfo:
                 for api in kernelInfo["api"]:
                     for name in api["name"]:
@@ -240,8 +317,8 @@ if __name__ == "__main__":
 
                             outBuf = io.StringIO()
                             for instantiation in api["instantiations"]:
-                                generateKernelInstantiation(kernelTemplateInfo, instantiation,
-                                                            api.get("opCodes", None), outBuf, API)
+                                generateKernelInstantiations(kernelTemplateInfo, api, instantiation,
+                                                             api.get("opCodes", None), outBuf, API)
                             ops_inst_str += outBuf.getvalue()
             else:
                 if API == "CPP":
@@ -256,13 +333,23 @@ if __name__ == "__main__":
                     opCodes = kernelInfo.get("opCodes", None)
                     outBuf = io.StringIO()
                     for instantiation in kernelInfo["instantiations"]:
-                        generateKernelInstantiation(kernelTemplateInfo, instantiation, opCodes, outBuf, API)
+                        generateKernelInstantiations(kernelTemplateInfo, kernelInfo, instantiation, opCodes, outBuf,
+                                                     API)
                     ops_inst_str += outBuf.getvalue()
-
+            if kernelLibrary != DEFAULT_LIBRARY:
+                index.extend((kernelLibrary, f) for f in generatedFunctions[numGenerated:])
+
+    if isIndex:
+        with open(outFilePath, "w") as outFile:
+            outFile.write("# This file was generated by {}. Don't edit manually!\n".format(sys.argv[0]))
+            for kernelLibrary, f in index:
+                outFile.write("{}\t{}\n".format(kernelLibrary, f))
+        sys.exit(0)
 
     with open(outFilePath, "w") as outFile:
         outFile.write("// This file was generated by {}. Don't edit manually!\n\n".format(sys.argv[0]))
         outFile.write("#include <runtime/local/context/DaphneContext.h>\n")
+        outFile.write("#include <runtime/local/datastructures/ReuseCache.h>\n")
         outFile.write(header_str)
         outFile.write("\nextern \"C\" {\n")
         outFile.write(ops_inst_str)
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/Autotuner.h>
+#include <runtime/local/vectorized/Topology.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <cstdio>
+
+namespace {
+    // in the order of SelfSchedulingScheme, as in the user config
+    const char * const SCHEME_NAMES[] = {
+        "STATIC", "SS", "GSS", "TSS", "FAC2", "TFSS", "FISS", "VISS", "PLS", "MSTATIC", "MFSC", "PSS", "AWF", "AF"
+    };
+    const size_t NUM_SCHEMES = sizeof(SCHEME_NAMES) / sizeof(SCHEME_NAMES[0]);
+
+    unsigned floorLog2(uint64_t n) {
+        unsigned log = 0;
+        while(n >>= 1)
+            log++;
+        return log;
+    }
+
+    std::vector<std::string> splitTabs(const std::string & line) {
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while(std::getline(ss, field, '\t'))
+            fields.push_back(field);
+        return fields;
+    }
+}
+
+Autotuner & Autotuner::get() {
+    static Autotuner * tuner = new Autotuner();
+    return *tuner;
+}
+
+void Autotuner::enable(const std::string & profileFile, const std::string & topologyKey) {
+    std::lock_guard<std::mutex> lock(mtx);
+    this->profileFile = profileFile;
+    this->topologyKey = topologyKey;
+    choices.clear();
+    otherLines.clear();
+    numTuned = 0;
+    numReused = 0;
+    if(!profileFile.empty()) {
+        std::ifstream in(profileFile);
+        std::string line;
+        while(std::getline(in, line)) {
+            if(line.empty() || line[0] == '#')
+                continue;
+            const std::vector<std::string> fields = splitTabs(line);
+            if(fields.size() != 5) {
+                std::cerr << "Autotuner: ignoring malformed line in " << profileFile << ": " << line << std::endl;
+                continue;
+            }
+            if(fields[0] != topologyKey) {
+                otherLines.push_back(line);
+                continue;
+            }
+            const SelfSchedulingScheme scheme = parseSchemeName(fields[3]);
+            size_t numThreads = 0;
+            int minimumTaskSize = 0;
+            try {
+                numThreads = std::stoul(fields[2]);
+                minimumTaskSize = std::stoi(fields[4]);
+            }
+            catch(std::exception &) {
+                numThreads = 0;
+            }
+            if(scheme == INVALID || numThreads == 0) {
+                std::cerr << "Autotuner: ignoring malformed line in " << profileFile << ": " << line << std::endl;
+                continue;
+            }
+            choices[fields[1]] = Choice{numThreads, scheme, minimumTaskSize};
+        }
+    }
+    enabled = true;
+}
+
+void Autotuner::enable(const std::string & profileFile) {
+    enable(profileFile, getTopologyKey(Topology::get()));
+}
+
+void Autotuner::disable() {
+    std::lock_guard<std::mutex> lock(mtx);
+    enabled = false;
+    choices.clear();
+    otherLines.clear();
+}
+
+std::string Autotuner::getTopologyKey(const Topology & topology) {
+    std::stringstream key;
+    key << topology.getNumCpus() << "cpus-" << topology.getNumCores() << "cores-" << topology.getNumSockets()
+            << "sockets-" << topology.getNumNumaNodes() << "numa-" << topology.getNumCacheGroups() << "llc";
+    return key.str();
+}
+
+std::string Autotuner::getSignature(const std::string & ops, const std::string & valueType, uint64_t numRows,
+        uint64_t numCols) {
+    std::stringstream sig;
+    sig << (ops.empty() ? "?" : ops) << '|' << valueType;
+    sig << "|rows~" << (numRows ? "2^" + std::to_string(floorLog2(numRows)) : "0");
+    sig << "|cols~" << (numCols ? "2^" + std::to_string(floorLog2(numCols)) : "0");
+    return sig.str();
+}
+
+std::vector<Autotuner::Choice> Autotuner::getCandidates(const Choice & configured) {
+    const size_t t = std::max<size_t>(configured.numThreads, 1);
+    const std::vector<Choice> all = {
+        configured,
+        {t, GSS, 1},
+        {t, GSS, COARSE_TASK_SIZE},
+        {t, FAC2, 1},
+        {std::max<size_t>(t / 2, 1), configured.scheme, configured.minimumTaskSize},
+        {std::max<size_t>(t / 4, 1), configured.scheme, configured.minimumTaskSize}
+    };
+    std::vector<Choice> candidates;
+    for(const Choice & c : all)
+        if(std::find(candidates.begin(), candidates.end(), c) == candidates.end())
+            candidates.push_back(c);
+    return candidates;
+}
+
+uint64_t Autotuner::getTrialRows(uint64_t numRows, size_t numCandidates, size_t numThreads) {
+    if(numCandidates == 0)
+        return 0;
+    const uint64_t trialRows = numRows / (MAX_TRIAL_FRACTION * numCandidates);
+    // every thread shall get some rows of a trial
+    const uint64_t minRows = std::max<uint64_t>(MIN_TRIAL_ROWS, 16 * numThreads);
+    return trialRows >= minRows ? trialRows : 0;
+}
+
+std::optional<Autotuner::Choice> Autotuner::lookup(const std::string & signature) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = choices.find(signature);
+    if(it == choices.end())
+        return std::nullopt;
+    numReused++;
+    return it->second;
+}
+
+void Autotuner::record(const std::string & signature, const Choice & choice) {
+    std::lock_guard<std::mutex> lock(mtx);
+    choices[signature] = choice;
+    numTuned++;
+    if(!profileFile.empty())
+        save();
+}
+
+void Autotuner::save() const {
+    // written to a temporary file first, such that concurrent runs never read a partial profile
+    const std::string tmpFile = profileFile + ".tmp";
+    {
+        std::ofstream out(tmpFile);
+        if(!out) {
+            std::cerr << "Autotuner: cannot write the profile " << profileFile << std::endl;
+            return;
+        }
+        out << "# DAPHNE autotuning profile: topology, pipeline signature, threads, scheme, minimum task size"
+                << std::endl;
+        for(const std::string & line : otherLines)
+            out << line << std::endl;
+        for(const auto & [signature, c] : choices)
+            out << topologyKey << '\t' << signature << '\t' << c.numThreads << '\t' << getSchemeName(c.scheme)
+                    << '\t' << c.minimumTaskSize << std::endl;
+    }
+    if(std::rename(tmpFile.c_str(), profileFile.c_str()) != 0)
+        std::cerr << "Autotuner: cannot write the profile " << profileFile << std::endl;
+}
+
+std::pair<size_t, size_t> Autotuner::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return {numTuned, numReused};
+}
+
+const char * Autotuner::getSchemeName(SelfSchedulingScheme scheme) {
+    if(scheme < 0 || static_cast<size_t>(scheme) >= NUM_SCHEMES)
+        return "INVALID";
+    return SCHEME_NAMES[scheme];
+}
+
+SelfSchedulingScheme Autotuner::parseSchemeName(const std::string & name) {
+    for(size_t i = 0; i < NUM_SCHEMES; i++)
+        if(name == SCHEME_NAMES[i])
+            return static_cast<SelfSchedulingScheme>(i);
+    return INVALID;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/vectorized/LoadPartitioningDefs.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+class Topology;
+
+/**
+ * @brief Chooses the number of threads, the partitioning scheme, and the minimum task size of the vectorized
+ * pipelines per pipeline signature, and persists the choices in a profile file per machine topology.
+ *
+ * The signature of a pipeline consists of its ops (see `VectorizedPipelineOpLowering`), its value type, and the
+ * power-of-two buckets of its rows and columns. The first time a signature is executed, its first rows are split
+ * into one trial range per candidate configuration (see `getCandidates()`), each range is processed with its
+ * candidate, and the remaining rows with the fastest one per row (see `MTWrapper::executeAutotuned()`). Hence, no
+ * row is processed twice and the results are the same as without tuning. The choice is added to the profile, which
+ * later runs on a machine of the same topology load, such that the tuning is paid once.
+ *
+ * The profile is a text file with one choice per line: the topology, the signature, the number of threads, the name
+ * of the scheme, and the minimum task size, separated by tabs. The choices of other topologies are kept when it is
+ * rewritten.
+ */
+class Autotuner {
+public:
+    struct Choice {
+        size_t numThreads;
+        SelfSchedulingScheme scheme;
+        int minimumTaskSize;
+
+        bool operator==(const Choice & other) const {
+            return numThreads == other.numThreads && scheme == other.scheme
+                    && minimumTaskSize == other.minimumTaskSize;
+        }
+    };
+
+    // the rows of every trial range at least, such that the time of a trial is not dominated by starting the workers
+    static constexpr uint64_t MIN_TRIAL_ROWS = 1024;
+    // the trial ranges together take at most this fraction of the rows of a pipeline, which is not tuned otherwise
+    static constexpr uint64_t MAX_TRIAL_FRACTION = 4;
+    // the minimum task size of the candidates with coarse chunks
+    static constexpr int COARSE_TASK_SIZE = 256;
+
+private:
+    std::atomic<bool> enabled{false};
+    std::string profileFile;
+    std::string topologyKey;
+
+    mutable std::mutex mtx;
+    // the choices of this topology by signature
+    std::map<std::string, Choice> choices;
+    // the lines of the profile of other topologies, which are written back unchanged
+    std::vector<std::string> otherLines;
+    size_t numTuned = 0;
+    size_t numReused = 0;
+
+    Autotuner() = default;
+
+    void save() const;
+
+public:
+    Autotuner(const Autotuner &) = delete;
+    Autotuner & operator=(const Autotuner &) = delete;
+
+    static Autotuner & get();
+
+    /**
+     * @brief Starts tuning the vectorized pipelines of a machine of the given topology, loading the choices of this
+     * topology from the given profile file (if it exists). If the file is empty, the choices are not persisted.
+     */
+    void enable(const std::string & profileFile, const std::string & topologyKey);
+
+    /**
+     * @brief Like `enable(profileFile, topologyKey)`, for the topology of this process.
+     */
+    void enable(const std::string & profileFile);
+
+    /**
+     * @brief Stops tuning and forgets the loaded choices.
+     */
+    void disable();
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the key of the profile of a machine, i.e., its numbers of CPUs, cores, sockets, NUMA nodes,
+     * and last-level caches.
+     */
+    static std::string getTopologyKey(const Topology & topology);
+
+    /**
+     * @brief Returns the signature of a pipeline of the given ops and value type processing the given numbers of
+     * rows and columns (of all row-split inputs), which are rounded down to powers of two.
+     */
+    static std::string getSignature(const std::string & ops, const std::string & valueType, uint64_t numRows,
+            uint64_t numCols);
+
+    /**
+     * @brief Returns the configurations tried for a pipeline: the configured one, the guided scheme with fine and
+     * coarse chunks, the factoring scheme, and the configured one with half and a quarter of the threads.
+     */
+    static std::vector<Choice> getCandidates(const Choice & configured);
+
+    /**
+     * @brief Returns the rows of every trial range of a pipeline of the given rows, or 0 if the pipeline is too
+     * short to be tuned.
+     */
+    static uint64_t getTrialRows(uint64_t numRows, size_t numCandidates, size_t numThreads);
+
+    /**
+     * @brief Returns the choice for the given signature, if it was tuned before.
+     */
+    std::optional<Choice> lookup(const std::string & signature);
+
+    /**
+     * @brief Adds the choice for the given signature, rewriting the profile file (if any).
+     */
+    void record(const std::string & signature, const Choice & choice);
+
+    /**
+     * @brief Returns the numbers of signatures tuned and of pipelines executed with a choice tuned before.
+     */
+    std::pair<size_t, size_t> getStatistics() const;
+
+    static const char * getSchemeName(SelfSchedulingScheme scheme);
+
+    static SelfSchedulingScheme parseSchemeName(const std::string & name);
+};
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/vectorized/Topology.h>
+
+#include <cblas.h>
+
+#include <algorithm>
+#include <atomic>
+
+/**
+ * @brief Coordinates the threads of OpenBLAS with the workers of the vectorized engine, such that BLAS calls do not
+ * oversubscribe the cores.
+ *
+ * A BLAS call within a worker (a task of a vectorized pipeline or a chunk of `WorkerPool::parallelFor()`) runs
+ * single-threaded, since the other workers occupy the other cores already. A stand-alone kernel lets BLAS use as many
+ * threads as the pool has workers. The kernels call `prepare()` before their BLAS and LAPACK calls; the number of
+ * threads of OpenBLAS is process-wide, so it is only changed when it differs from the last one.
+ */
+class BlasThreads {
+    // the number of nested `WorkerScope`s of the calling thread
+    inline static thread_local int workerDepth = 0;
+    // the number of threads last set, 0 if none
+    inline static std::atomic<int> numThreadsSet{0};
+
+public:
+    /**
+     * @brief Marks the calling thread as a worker while in scope.
+     */
+    class WorkerScope {
+    public:
+        WorkerScope() { workerDepth++; }
+        ~WorkerScope() { workerDepth--; }
+        WorkerScope(const WorkerScope &) = delete;
+        WorkerScope & operator=(const WorkerScope &) = delete;
+    };
+
+    static bool isInWorker() {
+        return workerDepth > 0;
+    }
+
+    /**
+     * @brief Returns the number of threads for a BLAS call in the calling thread.
+     */
+    static int getNumThreads(DCTX(ctx)) {
+        if(isInWorker())
+            return 1;
+        if(ctx && ctx->config.numberOfThreads > 0)
+            return ctx->config.numberOfThreads;
+        const Topology & topology = Topology::get();
+        const bool hyperthreading = ctx && ctx->config.hyperthreadingEnabled;
+        return static_cast<int>(std::max<size_t>(1, hyperthreading ? topology.getNumCpus() : topology.getNumCores()));
+    }
+
+    /**
+     * @brief Sets the number of threads of OpenBLAS for a BLAS call in the calling thread.
+     */
+    static void prepare(DCTX(ctx)) {
+        const int numThreads = getNumThreads(ctx);
+        if(numThreadsSet.exchange(numThreads, std::memory_order_relaxed) != numThreads)
+            openblas_set_num_threads(numThreads);
+    }
+};
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__linux__) && defined(USE_ARM_SIMD)
+#include <sys/auxv.h>
+#endif
+
+// The attributes compiling a function for an instruction set beyond the target of the build. GCC and Clang accept
+// the intrinsics of the instruction set within such functions and inline other functions into them. The AArch64
+// variants are only compiled with the (experimental) build option USE_ARM_SIMD.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define DAPHNE_CPU_DISPATCH_X86
+#define DAPHNE_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define DAPHNE_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define DAPHNE_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,popcnt")))
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(USE_ARM_SIMD)
+#define DAPHNE_CPU_DISPATCH_ARM
+#if defined(__clang__)
+#define DAPHNE_TARGET_SVE __attribute__((target("sve")))
+#else
+#define DAPHNE_TARGET_SVE __attribute__((target("+sve")))
+#endif
+#endif
+
+/**
+ * @brief The instruction sets the hot kernels have variants for. On x86-64, `GENERIC` is the target of the build
+ * (at least SSE2), on AArch64, NEON is part of the target of the build.
+ */
+enum class CpuIsa { GENERIC, SSE42, AVX2, AVX512, NEON, SVE };
+
+/**
+ * @brief Selects the variants of the hot kernels for the instruction sets of the CPU at run time, such that a single
+ * build of the kernel libraries runs on older CPUs and still uses AVX-512 or SVE where available.
+ *
+ * `run()` calls a (generic) lambda within a variant of a function compiled for the selected instruction set, into
+ * which the lambda and the functions it calls are inlined, such that the compiler vectorizes its loops for this
+ * instruction set. The lambda gets the instruction set as an `std::integral_constant`, such that it can pick
+ * hand-written microkernels, too. The instruction set is detected once and may be limited by the user (see
+ * `DaphneUserConfig::cpu_isa`); the variants the kernels ran are recorded for `printSelections()`.
+ */
+class CpuDispatch {
+    // the selected instruction set, -1 until detected
+    inline static std::atomic<int> selected{-1};
+    // the instruction set the selection is limited to, -1 for none
+    inline static std::atomic<int> maxIsa{-1};
+
+    inline static std::mutex mtxSelections;
+    // the instruction sets each kernel ran with, as a bit mask
+    inline static std::map<std::string, uint32_t> selections;
+
+    template<CpuIsa isa, class F>
+    static void runGeneric(F & f) {
+        f(std::integral_constant<CpuIsa, isa>{});
+    }
+
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+    template<class F>
+    DAPHNE_TARGET_SSE42 __attribute__((flatten)) static void runSse42(F & f) {
+        f(std::integral_constant<CpuIsa, CpuIsa::SSE42>{});
+    }
+
+    template<class F>
+    DAPHNE_TARGET_AVX2 __attribute__((flatten)) static void runAvx2(F & f) {
+        f(std::integral_constant<CpuIsa, CpuIsa::AVX2>{});
+    }
+
+    template<class F>
+    DAPHNE_TARGET_AVX512 __attribute__((flatten)) static void runAvx512(F & f) {
+        f(std::integral_constant<CpuIsa, CpuIsa::AVX512>{});
+    }
+#elif defined(DAPHNE_CPU_DISPATCH_ARM)
+    template<class F>
+    DAPHNE_TARGET_SVE __attribute__((flatten)) static void runSve(F & f) {
+        f(std::integral_constant<CpuIsa, CpuIsa::SVE>{});
+    }
+#endif
+
+    static constexpr bool isX86(CpuIsa isa) {
+        return isa == CpuIsa::SSE42 || isa == CpuIsa::AVX2 || isa == CpuIsa::AVX512;
+    }
+
+public:
+    static constexpr size_t NUM_ISAS = 6;
+
+    /**
+     * @brief Returns whether code for `feature` runs on a CPU supporting `isa`, e.g., `includes(AVX512, AVX2)`.
+     */
+    static constexpr bool includes(CpuIsa isa, CpuIsa feature) {
+        return feature == CpuIsa::GENERIC || isa == feature || (isX86(isa) && isX86(feature) && isa > feature)
+                || (isa == CpuIsa::SVE && feature == CpuIsa::NEON);
+    }
+
+    static const char * toString(CpuIsa isa) {
+        switch(isa) {
+            case CpuIsa::GENERIC: return "generic";
+            case CpuIsa::SSE42: return "sse4.2";
+            case CpuIsa::AVX2: return "avx2";
+            case CpuIsa::AVX512: return "avx512";
+            case CpuIsa::NEON: return "neon";
+            case CpuIsa::SVE: return "sve";
+        }
+        return "unknown";
+    }
+
+    static CpuIsa fromString(const std::string & name) {
+        for(size_t i = 0; i < NUM_ISAS; i++)
+            if(name == toString(static_cast<CpuIsa>(i)))
+                return static_cast<CpuIsa>(i);
+        throw std::runtime_error("CpuDispatch: unknown instruction set '" + name + "', expected auto, generic, "
+                "sse4.2, avx2, avx512, neon, or sve");
+    }
+
+    /**
+     * @brief Returns the best instruction set the kernels have variants for which the CPU supports.
+     */
+    static CpuIsa detect() {
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+        __builtin_cpu_init();
+        if(!__builtin_cpu_supports("popcnt"))
+            return CpuIsa::GENERIC;
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+                && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+            return CpuIsa::AVX512;
+        if(__builtin_cpu_supports("avx2"))
+            return CpuIsa::AVX2;
+        if(__builtin_cpu_supports("sse4.2"))
+            return CpuIsa::SSE42;
+        return CpuIsa::GENERIC;
+#elif defined(DAPHNE_CPU_DISPATCH_ARM)
+#if defined(__linux__) && defined(HWCAP_SVE)
+        if(getauxval(AT_HWCAP) & HWCAP_SVE)
+            return CpuIsa::SVE;
+#endif
+        return CpuIsa::NEON;
+#else
+        return CpuIsa::GENERIC;
+#endif
+    }
+
+    /**
+     * @brief Returns the instruction set the kernels run their variants for.
+     */
+    static CpuIsa getIsa() {
+        int isa = selected.load(std::memory_order_relaxed);
+        if(isa < 0) {
+            const CpuIsa detected = detect();
+            const int max = maxIsa.load(std::memory_order_relaxed);
+            isa = static_cast<int>(max >= 0 && includes(detected, static_cast<CpuIsa>(max))
+                    ? static_cast<CpuIsa>(max) : detected);
+            selected.store(isa, std::memory_order_relaxed);
+        }
+        return static_cast<CpuIsa>(isa);
+    }
+
+    /**
+     * @brief Limits the selection to the given instruction set ("auto" for no limit), e.g., to compare the variants.
+     * A limit beyond the capabilities of the CPU selects the best instruction set of the CPU.
+     */
+    static void setMaxIsa(const std::string & name) {
+        if(name.empty() || name == "auto") {
+            maxIsa.store(-1, std::memory_order_relaxed);
+            selected.store(-1, std::memory_order_relaxed);
+            return;
+        }
+        const CpuIsa isa = fromString(name);
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+        const bool valid = isa == CpuIsa::GENERIC || isX86(isa);
+#elif defined(DAPHNE_CPU_DISPATCH_ARM)
+        const bool valid = isa == CpuIsa::GENERIC || isa == CpuIsa::NEON || isa == CpuIsa::SVE;
+#else
+        const bool valid = isa == CpuIsa::GENERIC;
+#endif
+        if(!valid)
+            throw std::runtime_error(std::string("CpuDispatch: the instruction set ") + toString(isa) +
+                    " is not available on this architecture");
+        maxIsa.store(static_cast<int>(isa), std::memory_order_relaxed);
+        selected.store(-1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Records that the given kernel ran its variant for `isa`, once per bit of `recorded`, which the caller
+     * keeps per call site.
+     */
+    static void record(std::atomic<uint32_t> & recorded, const char * kernel, CpuIsa isa) {
+        const uint32_t bit = uint32_t(1) << static_cast<int>(isa);
+        if(recorded.load(std::memory_order_relaxed) & bit)
+            return;
+        recorded.fetch_or(bit, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mtxSelections);
+        selections[kernel] |= bit;
+    }
+
+    /**
+     * @brief Calls `f(std::integral_constant<CpuIsa, isa>)` within the variant for the selected instruction set.
+     *
+     * @param kernel The name of the calling kernel, as reported by `printSelections()`.
+     */
+    template<class F>
+    static void run(const char * kernel, F && f) {
+        // the lambda type identifies the call site
+        static std::atomic<uint32_t> recorded{0};
+        const CpuIsa isa = getIsa();
+        record(recorded, kernel, isa);
+        switch(isa) {
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+            case CpuIsa::AVX512: runAvx512(f); return;
+            case CpuIsa::AVX2: runAvx2(f); return;
+            case CpuIsa::SSE42: runSse42(f); return;
+#elif defined(DAPHNE_CPU_DISPATCH_ARM)
+            case CpuIsa::SVE: runSve(f); return;
+            case CpuIsa::NEON: runGeneric<CpuIsa::NEON>(f); return;
+#endif
+            default: runGeneric<CpuIsa::GENERIC>(f); return;
+        }
+    }
+
+    /**
+     * @brief Returns the kernels that ran so far with the instruction sets of their variants.
+     */
+    static std::vector<std::pair<std::string, std::vector<CpuIsa>>> getSelections() {
+        std::lock_guard<std::mutex> lock(mtxSelections);
+        std::vector<std::pair<std::string, std::vector<CpuIsa>>> res;
+        for(const auto & [kernel, bits] : selections) {
+            std::vector<CpuIsa> isas;
+            for(size_t i = 0; i < NUM_ISAS; i++)
+                if(bits & (uint32_t(1) << i))
+                    isas.push_back(static_cast<CpuIsa>(i));
+            res.emplace_back(kernel, isas);
+        }
+        return res;
+    }
+
+    static void printSelections(std::ostream & os) {
+        os << "CPU dispatch: detected " << toString(detect()) << ", selected " << toString(getIsa()) << std::endl;
+        for(const auto & [kernel, isas] : getSelections()) {
+            os << "  " << std::left << std::setw(16) << kernel << std::right;
+            for(size_t i = 0; i < isas.size(); i++)
+                os << (i ? ", " : "") << toString(isas[i]);
+            os << std::endl;
+        }
+    }
+};
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/vectorized/LoadPartitioning.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Splits the rows of a vectorized pipeline between the GPU and the CPU workers in proportion to their measured
+ * throughput.
+ *
+ * The GPU workers process the rows from the first one on, the CPU workers from the last one backwards, such that
+ * both parts of the result stay contiguous. At first, each device type processes a small profiling range at its end
+ * of the rows, reporting the execution times of its tasks to `getFeedback()` (one slot per device type). `split()`
+ * waits for both profiling ranges and assigns the rows in between, such that both device types are expected to
+ * finish at the same time.
+ *
+ * Without profiling (e.g., if the CPU workers only start once all tasks are enqueued), the rows are split by a fixed
+ * ratio right away.
+ */
+class HybridPartitioner {
+public:
+    static constexpr size_t CPU_SLOT = 0;
+    static constexpr size_t GPU_SLOT = 1;
+    // the share of the GPU workers without measurements
+    static constexpr double DEFAULT_GPU_RATIO = 0.25;
+
+private:
+    const uint64_t _len;
+    const uint32_t _numCPUWorkers;
+    const uint32_t _numGPUWorkers;
+    const bool _profile;
+    uint64_t _gpuProfileEnd;
+    uint64_t _cpuProfileStart;
+    ChunkFeedback _feedback{2};
+
+public:
+    /**
+     * @param len The number of rows of the pipeline.
+     * @param gpuProfileRows The number of rows the GPU workers process for profiling, e.g., one batch per worker.
+     * @param cpuProfileRows The number of rows the CPU workers process for profiling, e.g., one batch per worker.
+     * @param profile Whether the split shall be based on measurements at all.
+     */
+    HybridPartitioner(uint64_t len, uint32_t numCPUWorkers, uint32_t numGPUWorkers, uint64_t gpuProfileRows,
+            uint64_t cpuProfileRows, bool profile) : _len(len), _numCPUWorkers(numCPUWorkers),
+            _numGPUWorkers(numGPUWorkers), _profile(profile && numCPUWorkers > 0 && numGPUWorkers > 0 && len >= 4) {
+        if(_profile) {
+            // profile on at most a quarter of the rows per device type
+            _gpuProfileEnd = std::clamp<uint64_t>(gpuProfileRows, 1, len / 4);
+            _cpuProfileStart = len - std::clamp<uint64_t>(cpuProfileRows, 1, len / 4);
+        }
+        else if(numGPUWorkers == 0 || numCPUWorkers == 0)
+            // a single device type processes all rows
+            _gpuProfileEnd = _cpuProfileStart = numGPUWorkers ? len : 0;
+        else
+            _gpuProfileEnd = _cpuProfileStart = splitPoint(0, len, 0.0, 0.0);
+    }
+
+    /**
+     * @brief Returns the index of the first row not in the profiling range of the GPU workers, which covers the rows
+     * from 0 on. Without profiling, the GPU workers process exactly these rows.
+     */
+    [[nodiscard]] uint64_t getGPUProfileEnd() const { return _gpuProfileEnd; }
+
+    /**
+     * @brief Returns the first row of the profiling range of the CPU workers, which covers the rows up to the last
+     * one. Without profiling, the CPU workers process exactly these rows.
+     */
+    [[nodiscard]] uint64_t getCPUProfileStart() const { return _cpuProfileStart; }
+
+    [[nodiscard]] bool isProfiling() const { return _profile; }
+
+    ChunkFeedback* getFeedback() { return &_feedback; }
+
+    /**
+     * @brief Waits until both profiling ranges were processed and returns the first row of the CPU workers, i.e.,
+     * the GPU workers additionally process the rows from `getGPUProfileEnd()` to the returned row and the CPU workers
+     * the rows from there to `getCPUProfileStart()`.
+     */
+    uint64_t split() {
+        if(!_profile)
+            return _gpuProfileEnd;
+        _feedback.waitForRows(GPU_SLOT, _gpuProfileEnd);
+        _feedback.waitForRows(CPU_SLOT, _len - _cpuProfileStart);
+        return splitPoint(_gpuProfileEnd, _cpuProfileStart, _feedback.getSlotRate(GPU_SLOT) * _numGPUWorkers,
+                _feedback.getSlotRate(CPU_SLOT) * _numCPUWorkers);
+    }
+
+    /**
+     * @brief Splits the rows from `begin` to `end` such that the GPU and the CPU workers need the same time for
+     * their parts, given their throughputs in rows per second. Falls back to `DEFAULT_GPU_RATIO` if a throughput is
+     * unknown (0).
+     *
+     * @return The first row of the CPU part.
+     */
+    static uint64_t splitPoint(uint64_t begin, uint64_t end, double gpuThroughput, double cpuThroughput) {
+        const double gpuRatio = gpuThroughput > 0.0 && cpuThroughput > 0.0
+                ? gpuThroughput / (gpuThroughput + cpuThroughput) : DEFAULT_GPU_RATIO;
+        const auto gpuRows = static_cast<uint64_t>(std::ceil(static_cast<double>(end - begin) * gpuRatio));
+        return begin + std::min(gpuRows, end - begin);
+    }
+};
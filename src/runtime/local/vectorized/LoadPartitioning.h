@@ -18,9 +18,112 @@
 
 #include "LoadPartitioningDefs.h"
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <cstdlib>
+#include <mutex>
 #include <string>
+#include <vector>
+
+/**
+ * @brief Collects the measured execution times of tasks, from which the adaptive schemes (AWF, AF) derive the sizes
+ * of later chunks.
+ *
+ * Tasks report concurrently from the worker threads while the partitioner reads the statistics. Every report belongs
+ * to a slot, which is the index of the queue the task was enqueued to, such that AWF can weight the chunks of
+ * different queues by the measured speed of the workers draining them.
+ */
+class ChunkFeedback {
+    struct SlotStats {
+        uint64_t rows = 0;
+        uint64_t chunks = 0;
+        double time = 0.0;
+        // for the variance of the time per row: sum(t^2/r)
+        double timeSqPerRow = 0.0;
+    };
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    std::vector<SlotStats> _slots;
+
+public:
+    explicit ChunkFeedback(size_t numSlots) : _slots(std::max<size_t>(numSlots, 1)) {}
+
+    void report(size_t slot, uint64_t rows, double seconds) {
+        if(rows == 0)
+            return;
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto& stats = _slots[slot % _slots.size()];
+        stats.rows += rows;
+        stats.chunks++;
+        stats.time += seconds;
+        stats.timeSqPerRow += seconds * seconds / rows;
+        _cv.notify_all();
+    }
+
+    /**
+     * @brief Blocks until at least the given number of rows was reported for the given slot.
+     */
+    void waitForRows(size_t slot, uint64_t rows) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cv.wait(lock, [&]() { return _slots[slot % _slots.size()].rows >= rows; });
+    }
+
+    /**
+     * @brief Returns the measured number of rows per second a single task of the given slot processes, or 0 if there
+     * are no measurements for it yet.
+     */
+    double getSlotRate(size_t slot) const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        const auto& stats = _slots[slot % _slots.size()];
+        return stats.rows > 0 && stats.time > 0.0 ? stats.rows / stats.time : 0.0;
+    }
+
+    /**
+     * @brief Estimates mean and standard deviation of the execution time of a single row over all slots.
+     *
+     * A chunk of r rows taking t seconds contributes (t - r*mean)^2 / r as an estimate of the per-row variance.
+     *
+     * @return `false` if nothing was reported yet.
+     */
+    bool getRowTimeStatistics(double& mean, double& stddev) const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        uint64_t rows = 0;
+        double time = 0.0, timeSqPerRow = 0.0;
+        for(const auto& stats : _slots) {
+            rows += stats.rows;
+            time += stats.time;
+            timeSqPerRow += stats.timeSqPerRow;
+        }
+        if(rows == 0 || time <= 0.0)
+            return false;
+        mean = time / rows;
+        // sum((t - r*mean)^2 / r) = sum(t^2/r) - 2*mean*sum(t) + mean^2*sum(r)
+        double variance = (timeSqPerRow - 2 * mean * time + mean * mean * rows) / rows;
+        stddev = std::sqrt(std::max(variance, 0.0));
+        return true;
+    }
+
+    /**
+     * @brief Returns the relative speed of the given slot compared to the average of all slots with measurements,
+     * or 1 if there are no measurements for it yet.
+     */
+    double getSlotWeight(size_t slot) const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        const auto& own = _slots[slot % _slots.size()];
+        if(own.rows == 0 || own.time <= 0.0)
+            return 1.0;
+        double sumRates = 0.0;
+        size_t numMeasured = 0;
+        for(const auto& stats : _slots) {
+            if(stats.rows > 0 && stats.time > 0.0) {
+                sumRates += stats.rows / stats.time;
+                numMeasured++;
+            }
+        }
+        return (own.rows / own.time) / (sumRates / numMeasured);
+    }
+};
 
 class LoadPartitioning {
 
@@ -36,9 +139,12 @@ private:
     uint64_t tssDelta;
     uint64_t mfscChunk;
     uint32_t fissStages;
-    int getMethod (const char * method){
-        return std::stoi(method);
-    }
+    ChunkFeedback* feedback;
+    // if set, the tasks are measured in the cost given by these prefix sums over the rows [firstRow, endRow)
+    const size_t* rowCosts = nullptr;
+    uint64_t firstRow = 0;
+    uint64_t nextRow = 0;
+    uint64_t endRow = 0;
     int getStages(int tasks, int workers){
         int actual_step=0;
         int scheduled=0;
@@ -51,13 +157,27 @@ private:
         }
         return actual_step+1;
     }
+    // converts the cost scheduled so far into the next row range (at least one row)
+    uint64_t costToRows(){
+        uint64_t beginRow = nextRow;
+        if(scheduledTasks >= totalTasks)
+            nextRow = endRow;
+        else
+            nextRow = std::lower_bound(rowCosts + beginRow + 1, rowCosts + endRow + 1,
+                    rowCosts[firstRow] + scheduledTasks) - rowCosts;
+        // trailing rows without cost are attached to the last chunk
+        if(rowCosts[nextRow] == rowCosts[endRow])
+            nextRow = endRow;
+        // the last row is assigned completely, so account for its whole cost
+        scheduledTasks = rowCosts[nextRow] - rowCosts[firstRow];
+        remainingTasks = totalTasks - scheduledTasks;
+        return nextRow - beginRow;
+    }
 public:
-    LoadPartitioning(int method, uint64_t tasks, uint64_t chunk, uint32_t workers, bool autochunk){
+    LoadPartitioning(int method, uint64_t tasks, uint64_t chunk, uint32_t workers, bool autochunk,
+            ChunkFeedback* feedback = nullptr) : feedback(feedback) {
         
-        if(const char* env_m = std::getenv("DAPHNE_TASK_PARTITION")){
-            method= getMethod(env_m);
-        } 
-        schedulingMethod = method;
+        schedulingMethod = getMethod(method);
         totalTasks = tasks;
         double tSize = (totalTasks+workers-1.0)/workers;
         mfscChunk = ceil(tSize*log(2.0)/log((1.0*tSize)));
@@ -76,10 +196,47 @@ public:
         uint64_t nTemp = (uint64_t) ceil(2.0*totalTasks/(tssChunk+1.0));
         tssDelta  = (uint64_t) (tssChunk - 1.0)/(double)(nTemp-1.0);
     }
+    /**
+     * @brief Partitions the rows [rowBegin, rowEnd), where the schemes operate on the cost of the rows given by the
+     * prefix sums `rowCosts` (e.g., the row offsets of a CSR matrix, to balance the number of non-zeros per task)
+     * instead of the number of rows. `getNextChunk()` still returns numbers of rows; as rows are not split, a chunk
+     * covers at least the requested cost.
+     */
+    LoadPartitioning(int method, const size_t* rowCosts, uint64_t rowBegin, uint64_t rowEnd, uint64_t chunk,
+            uint32_t workers, bool autochunk, ChunkFeedback* feedback = nullptr) :
+            LoadPartitioning(method, rowCosts[rowEnd] - rowCosts[rowBegin], chunk, workers, autochunk, feedback) {
+        this->rowCosts = rowCosts;
+        firstRow = rowBegin;
+        nextRow = rowBegin;
+        endRow = rowEnd;
+    }
     bool hasNextChunk(){
+        if(rowCosts)
+            return nextRow < endRow;
         return scheduledTasks < totalTasks; 
     }  
-    uint64_t getNextChunk(){
+    /**
+     * @brief Returns the scheduling method to use, which can be overridden by the environment variable
+     * DAPHNE_TASK_PARTITION.
+     */
+    static int getMethod(int method){
+        if(const char* env_m = std::getenv("DAPHNE_TASK_PARTITION")){
+            method = std::stoi(env_m);
+        }
+        return method;
+    }
+    /**
+     * @brief Whether the scheme sizes chunks based on the execution times reported to a `ChunkFeedback`. Callers
+     * should then only create chunks as workers become idle, such that the statistics are up-to-date.
+     */
+    static bool isAdaptive(int method){
+        method = getMethod(method);
+        return method == AWF || method == AF;
+    }
+    /**
+     * @param slot The queue the chunk will be enqueued to (only used by AWF).
+     */
+    uint64_t getNextChunk(size_t slot = 0){
         uint64_t chunkSize = 0;
         switch (schedulingMethod){
             case STATIC:{//STATIC
@@ -142,6 +299,26 @@ public:
                 chunkSize=mfscChunk;
                 break;
             }
+            case AWF:{//adaptive weighted factoring (AWF)
+                // FAC2 batches, where each chunk is scaled by the measured relative speed of its queue's workers
+                uint64_t actualStep = schedulingStep/totalWorkers; // has to be an integer division
+                double weight = feedback ? feedback->getSlotWeight(slot) : 1.0;
+                chunkSize = (uint64_t) ceil(weight*pow(0.5,actualStep+1)*((double)totalTasks/totalWorkers));
+                break;
+            }
+            case AF:{//adaptive factoring (AF)
+                double mu, sigma;
+                if(feedback && feedback->getRowTimeStatistics(mu, sigma)) {
+                    // chunk = (D + 2ER - sqrt(D^2 + 4DER)) / (2mu), with D = P*sigma^2/mu, E = mu/P (identical workers)
+                    double D = totalWorkers*sigma*sigma/mu;
+                    double E = mu/totalWorkers;
+                    double R = (double)remainingTasks;
+                    chunkSize = (uint64_t) ceil((D + 2.0*E*R - sqrt(D*D + 4.0*D*E*R))/(2.0*mu));
+                }
+                else // no measurements yet: first FAC2 batch
+                    chunkSize = (uint64_t) ceil((double)remainingTasks/(2.0*totalWorkers));
+                break;
+            }
             default:{
                 chunkSize = (uint64_t)ceil(totalTasks/totalWorkers/4.0);
                 break;
@@ -152,6 +329,8 @@ public:
         schedulingStep++;
         scheduledTasks+=chunkSize;
         remainingTasks-=chunkSize;
+        if(rowCosts)
+            return costToRows();
         return chunkSize;
     } 
 };
@@ -19,14 +19,16 @@
 enum QueueTypeOption {
     CENTRALIZED=0,
     PERGROUP,
-    PERCPU
+    PERCPU,
+    PERCPU_LOCKFREE
 };
 
 enum victimSelectionLogic {
     SEQ=0,
     SEQPRI,
     RANDOM,
-    RANDOMPRI
+    RANDOMPRI,
+    SEQLOCAL
 };
 
 enum SelfSchedulingScheme {
@@ -42,5 +44,7 @@ enum SelfSchedulingScheme {
     MSTATIC,
     MFSC,
     PSS,
+    AWF,
+    AF,
     INVALID=-1 /* only for JSON enum conversion */
 };
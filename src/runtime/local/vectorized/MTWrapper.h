@@ -21,17 +21,23 @@
 #endif
 
 #include <ir/daphneir/Daphne.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/RowChunkReader.h>
+#include <runtime/local/vectorized/Autotuner.h>
 #include <runtime/local/vectorized/LoadPartitioning.h>
+#include <runtime/local/vectorized/TaskArena.h>
+#include <runtime/local/vectorized/Topology.h>
 #include <runtime/local/vectorized/VectorizedDataSink.h>
 #include <runtime/local/vectorized/WorkerCPU.h>
 #include <runtime/local/vectorized/WorkerGPU.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 
-#include <fstream>
+#include <algorithm>
 #include <functional>
 #include <queue>
 #include <set>
+#include <type_traits>
 
-//TODO use the wrapper to cache threads
 //TODO generalize for arbitrary inputs (not just binary)
 
 using mlir::daphne::VectorSplit;
@@ -42,119 +48,199 @@ class MTWrapperBase {
 protected:
     std::vector<std::unique_ptr<Worker>> cuda_workers;
     std::vector<std::unique_ptr<Worker>> cpp_workers;
+    // set if the CPU workers of this pipeline run on the persistent pool of the context
+    WorkerPool* _workerPool{};
     std::vector<int> topologyPhysicalIds;
     std::vector<int> topologyUniqueThreads;
     std::vector<int> topologyResponsibleThreads;
-    std::string _cpuinfoPath = "/proc/cpuinfo";
     size_t _numThreads{};
     uint32_t _numCPPThreads{};
+    // the configured number of CPU workers, which a tuned choice does not exceed
+    uint32_t _maxCPPThreads{};
     uint32_t _numCUDAThreads{};
+    // the id of this pipeline in the SchedulingTrace while its workers run, 0 if it is not traced
+    uint32_t _traceId{};
     int _queueMode;
     // _queueMode 0: Centralized queue for all workers, 1: One queue for every physical ID (socket), 2: One queue per CPU
     int _numQueues;
+    // lock-free deques may only be filled by their owner, so the workers are started after all tasks were enqueued
+    bool _lockFreeQueues{};
+    // NUMA-aware mode: every queue gets a contiguous block of rows and its pinned workers never steal from other NUMA
+    // domains, such that the rows of the (not yet touched) outputs are first touched on the node computing them
+    bool _numaAware{};
     int _stealLogic;
     int _totalNumaDomains;
+    // the partitioning scheme and the minimum task size, configured or tuned by the Autotuner
+    SelfSchedulingScheme _scheme;
+    int _minimumTaskSize;
     DCTX(_ctx);
 
+    // the size of an input, which may be sparse or a frame regardless of the data type of the results of the pipeline
+    static size_t getInputBytes(const Structure* input) {
+        if(auto frame = dynamic_cast<const Frame*>(input)) {
+            size_t rowBytes = 0;
+            for(size_t c = 0; c < frame->getNumCols(); c++)
+                rowBytes += ValueTypeUtils::sizeOf(frame->getColumnType(c));
+            return frame->getNumRows() * rowBytes;
+        }
+        if constexpr(std::is_same<DT, Frame>::value)
+            return input->getNumItems() * sizeof(double);
+        else {
+            using VT = typename DT::VT;
+            if(auto csr = dynamic_cast<const CSRMatrix<VT>*>(input))
+                return csr->getNumNonZeros() * (sizeof(VT) + sizeof(size_t))
+                        + (csr->getNumRows() + 1) * sizeof(size_t);
+            return input->getNumItems() * sizeof(VT);
+        }
+    }
+
     std::pair<size_t, size_t> getInputProperties(Structure** inputs, size_t numInputs, VectorSplit* splits) {
         auto len = 0ul;
         auto mem_required = 0ul;
 
         // due to possible broadcasting we have to check all inputs
         for (auto i = 0u; i < numInputs; ++i) {
-            if (splits[i] == mlir::daphne::VectorSplit::ROWS) {
-                len = std::max(len, inputs[i]->getNumRows());
-                mem_required += inputs[i]->getNumItems() * sizeof(typename DT::VT);
+            if (splits[i] == mlir::daphne::VectorSplit::ROWS || splits[i] == mlir::daphne::VectorSplit::COLS) {
+                len = std::max(len, BroadcastInputPins::getSplitExtent(splits[i], inputs[i]));
+                mem_required += getInputBytes(inputs[i]);
             }
         }
         return std::make_pair(len, mem_required);
     }
 
-    bool _parseStringLine(const std::string& input, const std::string& keyword, int *val ) {
-        auto seperatorLocation = input.find(':');
-        if(seperatorLocation != std::string::npos) {
-            if(input.find(keyword) == 0) {
-                *val = stoi(input.substr(seperatorLocation + 1));
-                return true;
-            }
-        }
-        return false;
+    void get_topology(std::vector<int> &physicalIds, std::vector<int> &uniqueThreads, std::vector<int> &responsibleThreads) {
+        WorkerPool::deriveTopology(_ctx->config, physicalIds, uniqueThreads, responsibleThreads);
     }
 
-    void get_topology(std::vector<int> &physicalIds, std::vector<int> &uniqueThreads, std::vector<int> &responsibleThreads) {
-        std::ifstream cpuinfoFile(_cpuinfoPath);
-        std::vector<int> utilizedThreads;
-        std::vector<int> core_ids;
-        int index = 0;
-        if( cpuinfoFile.is_open() ) {
-            std::string line;
-            int value;
-            while ( std::getline(cpuinfoFile, line) ) {
-                if( _parseStringLine(line, "processor", &value ) ) {
-                    utilizedThreads.push_back(value);
-                } else if( _parseStringLine(line, "physical id", &value) ) {
-                    if ( _ctx->getUserConfig().queueSetupScheme == PERGROUP ) {
-                        if (std::find(physicalIds.begin(), physicalIds.end(), value) == physicalIds.end()) {
-                            responsibleThreads.push_back(utilizedThreads[index]);
-                        }
-                    }
-                    physicalIds.push_back(value);
-                } else if( _parseStringLine(line, "core id", &value) ) {
-                    int found = 0;
-                    for (int i=0; i<index; i++) {
-                        if (core_ids[i] == value && physicalIds[i] == physicalIds[index]) {
-                                found++;
-                        }
-                    }
-                    core_ids.push_back(value);
-                    if( _ctx->config.hyperthreadingEnabled || found == 0 ) {
-                        uniqueThreads.push_back(utilizedThreads[index]);
-                        if ( _ctx->getUserConfig().queueSetupScheme == PERCPU ) {
-                            responsibleThreads.push_back(value);
-                        } else if ( _ctx->getUserConfig().queueSetupScheme == CENTRALIZED ) {
-                            responsibleThreads.push_back(0);
-                        }
-                    }
-                    index++;
-                }
-            }
-            cpuinfoFile.close();
-        }
+    std::unique_ptr<TaskQueue> createTaskQueue(uint64_t capacity) const {
+        if(_lockFreeQueues)
+            return std::make_unique<WorkStealingDeque>(capacity);
+        return std::make_unique<BlockingTaskQueue>(capacity);
     }
+
+    [[nodiscard]] bool prePartitionRows() const { return _ctx->config.prePartitionRows || _numaAware; }
+    [[nodiscard]] bool pinWorkers() const { return _ctx->config.pinWorkers || _numaAware; }
+
+    // adaptive partitioning schemes need the execution times of the tasks
+    std::unique_ptr<ChunkFeedback> createChunkFeedback(size_t numQueues) const {
+        if(LoadPartitioning::isAdaptive(_scheme))
+            return std::make_unique<ChunkFeedback>(numQueues);
+        return nullptr;
+    }
+
+    // Adaptive schemes derive every chunk from the execution times measured so far. Hence, the queues are bounded
+    // to about one task per worker, such that the next chunk is only created when a worker has become idle.
+    uint64_t getQueueCapacity(uint64_t len, size_t numQueues) const {
+        if(!LoadPartitioning::isAdaptive(_scheme) || prePartitionRows())
+            return len;
+        return std::max<uint64_t>(1, (_numThreads + numQueues - 1) / numQueues);
+    }
+
+    // the number of tasks enqueued at once
+    static constexpr uint64_t TASK_BATCH_SIZE = 64;
+
+    // the values per chunk of a streamed input unless configured otherwise
+    static constexpr size_t STREAM_CHUNK_BYTES = 16 * 1024 * 1024;
+
+    /**
+     * @brief Returns the rows per chunk of a streamed input with rows of the given size. Every chunk has at least
+     * two rows, such that it cannot be mistaken for a broadcast row.
+     */
+    size_t getStreamChunkRows(size_t rowBytes) const {
+        size_t chunkRows = _ctx->config.vectorized_stream_chunk_rows;
+        if(chunkRows == 0)
+            chunkRows = STREAM_CHUNK_BYTES / std::max<size_t>(rowBytes, 1);
+        return std::max<size_t>(chunkRows, 2);
+    }
+
+    uint64_t getTaskBatchSize(uint64_t len, size_t numQueues) const {
+        // bounded queues (adaptive schemes) shall receive every chunk as late as possible
+        return getQueueCapacity(len, numQueues) < len ? 1 : TASK_BATCH_SIZE;
+    }
+
+    /**
+     * @brief Returns whether the configuration of the CPU workers may be tuned, i.e., they take their tasks from a
+     * single queue in any order, and there are no GPU workers.
+     */
+    [[nodiscard]] bool canAutotune() const {
+        return _queueMode == 0 && !prePartitionRows() && !pinWorkers() && _numCUDAThreads == 0;
+    }
+
+    [[nodiscard]] Autotuner::Choice getChoice() const {
+        return {_numCPPThreads, _scheme, _minimumTaskSize};
+    }
+
+    void applyChoice(const Autotuner::Choice& choice) {
+        _numCPPThreads = std::clamp<uint32_t>(choice.numThreads, 1, _maxCPPThreads);
+        _numThreads = _numCPPThreads + _numCUDAThreads;
+        _scheme = choice.scheme;
+        _minimumTaskSize = std::max(choice.minimumTaskSize, 1);
+    }
+
+    // the id of this pipeline in the SchedulingTrace, starting it with the first workers if tracing is enabled
+    uint32_t startTrace() {
+        if(!_traceId && SchedulingTrace::get().isEnabled())
+            _traceId = SchedulingTrace::get().beginPipeline(_numThreads);
+        return _traceId;
+    }
+
     void initCPPWorkers(std::vector<TaskQueue *> &qvector, uint32_t batchSize, const bool verbose = false,
-            int numQueues = 0, int queueMode = 0, bool pinWorkers = false) {
-        cpp_workers.resize(_numCPPThreads);
+            int numQueues = 0, int queueMode = 0, bool pinWorkers = false, bool trace = true) {
         if( numQueues == 0 ) {
             throw std::runtime_error("MTWrapper::initCPPWorkers: numQueues is 0, this should not happen.");
         }
+        const uint32_t traceId = trace ? startTrace() : 0;
+        // the tasks combining the results (see parallelFor) are neither traced nor part of the progress of the run
+        RunControl* control = trace ? _ctx->getRunControl() : nullptr;
+
+        if(auto pool = WorkerPool::get(_ctx)) {
+            WorkerPoolJob job{qvector, topologyPhysicalIds, topologyUniqueThreads, batchSize, numQueues, queueMode,
+                    this->_stealLogic, pinWorkers, verbose, traceId, control};
+            if(pool->trySubmit(job, _numCPPThreads)) {
+                _workerPool = pool;
+                return;
+            }
+        }
 
+        cpp_workers.resize(_numCPPThreads);
         int i = 0;
         for( auto& w : cpp_workers ) {
             w = std::make_unique<WorkerCPU>(qvector, topologyPhysicalIds, topologyUniqueThreads, verbose, 0, batchSize,
-                    i, numQueues, queueMode, this->_stealLogic, pinWorkers);
+                    i, numQueues, queueMode, this->_stealLogic, pinWorkers, true, traceId, control);
             i++;
         }
     }
 #ifdef USE_CUDA
-    void initCUDAWorkers(TaskQueue* q, uint32_t batchSize, bool verbose = false) {
+    // starts one GPU worker per device, the worker of the i-th device takes its tasks from the i-th queue (modulo
+    // the number of queues, i.e., all share a single queue)
+    void initCUDAWorkers(const std::vector<TaskQueue*>& qvector, uint32_t batchSize, bool verbose = false) {
         cuda_workers.resize(_numCUDAThreads);
-        for (auto& w : cuda_workers)
-            w = std::make_unique<WorkerGPU>(q, verbose, 1, batchSize);
+        for (size_t i = 0; i < cuda_workers.size(); ++i)
+            cuda_workers[i] = std::make_unique<WorkerGPU>(qvector[i % qvector.size()], verbose, 1, batchSize, _ctx,
+                    i, startTrace(), _numCPPThreads + i);
     }
 
+    // copies the row-split inputs to every device whose memory budget suffices for the whole pipeline
     void cudaPrefetchInputs(Structure** inputs, uint32_t numInputs, size_t mem_required,
             mlir::daphne::VectorSplit* splits) {
-        const size_t deviceID = 0; //ToDo: multi device support
-        auto ctx = CUDAContext::get(_ctx, deviceID);
-        AllocationDescriptorCUDA alloc_desc(_ctx, deviceID);
-        auto buffer_usage = static_cast<float>(mem_required) / static_cast<float>(ctx->getMemBudget());
+        for(size_t deviceID = 0; deviceID < _ctx->cuda_contexts.size(); ++deviceID) {
+            auto ctx = CUDAContext::get(_ctx, deviceID);
+            AllocationDescriptorCUDA alloc_desc(_ctx, deviceID);
+            auto buffer_usage = static_cast<float>(mem_required) / static_cast<float>(ctx->getMemBudget());
 #ifndef NDEBUG
-        std::cout << "\nVect pipe total in/out buffer usage: " << buffer_usage << std::endl;
+            std::cout << "\nVect pipe total in/out buffer usage on device " << deviceID << ": " << buffer_usage
+                    << std::endl;
 #endif
-        if(buffer_usage < 1.0) {
-            for (auto i = 0u; i < numInputs; ++i) {
-                if(splits[i] == mlir::daphne::VectorSplit::ROWS) {
-                    [[maybe_unused]] auto unused = static_cast<const DT*>(inputs[i])->getValues(&alloc_desc);
+            if(buffer_usage < 1.0) {
+                for (auto i = 0u; i < numInputs; ++i) {
+                    // the row views of sparse inputs do not share the placements of the input, so only dense inputs
+                    // are prefetched
+                    auto mat = dynamic_cast<const DenseMatrix<typename DT::VT>*>(inputs[i]);
+                    if(mat && splits[i] == mlir::daphne::VectorSplit::ROWS) {
+                        [[maybe_unused]] auto unused = mat->getValues(&alloc_desc);
+                        // keep the prefetched inputs resident until the GPU workers access them
+                        ctx->getResidencyManager()->hint(inputs[i]);
+                    }
                 }
             }
         }
@@ -165,6 +251,9 @@ protected:
         auto mem_required = 0ul;
         // output allocation for row-wise combine
         for(size_t i = 0; i < numOutputs; ++i) {
+            // the min and max combines start from the first part instead of an initial value
+            if(combines[i] == mlir::daphne::VectorCombine::MIN || combines[i] == mlir::daphne::VectorCombine::MAX)
+                continue;
             if((*res[i]) == nullptr && outRows[i] != -1 && outCols[i] != -1) {
                 auto zeroOut = combines[i] == mlir::daphne::VectorCombine::ADD;
                 (*res[i]) = DataObjectFactory::create<DT>(outRows[i], outCols[i], zeroOut);
@@ -174,23 +263,71 @@ protected:
         return mem_required;
     }
 
-    virtual void combineOutputs(DT***& res, DT***& res_cuda, size_t numOutputs, mlir::daphne::VectorCombine* combines,
-            DCTX(ctx)) = 0;
+    // Merges the aggregation combines of the GPU workers, i.e., one partial result per device
+    // (`deviceAddRes[device][output]`, the one of the first device being the output itself for add combines), into the
+    // outputs on the first device. The GPU workers write row-wise and column-wise combines into the outputs directly.
+    virtual void combineOutputs(DT***& res, std::vector<std::vector<DT*>>& deviceAddRes, size_t numOutputs,
+            mlir::daphne::VectorCombine* combines, DCTX(ctx)) = 0;
 
-    void joinAll() {
+    void joinCPPWorkers() {
+        if(_workerPool) {
+            _workerPool->wait();
+            _workerPool = nullptr;
+        }
         for(auto& w : cpp_workers)
             w->join();
+        cpp_workers.clear();
+    }
+
+    void joinAll() {
+        joinCPPWorkers();
         for(auto& w : cuda_workers)
             w->join();
+        if(_traceId) {
+            SchedulingTrace::get().endPipeline(_traceId, std::cerr);
+            _traceId = 0;
+        }
+    }
+
+    /**
+     * @brief Executes `func(0)`, ..., `func(n-1)` on the CPU workers (the persistent pool, if any) and waits for
+     * their completion, e.g., to combine the results of a pipeline in parallel. Must not be called while the
+     * workers of a pipeline are running.
+     */
+    void parallelFor(size_t n, const std::function<void(size_t)>& func) {
+        if(n <= 1 || _numCPPThreads <= 1) {
+            for(size_t i = 0; i < n; i++)
+                func(i);
+            return;
+        }
+        BlockingTaskQueue q(n);
+        for(size_t i = 0; i < n; i++)
+            q.enqueueTask(new FunctionTask([&func, i]() { func(i); }));
+        q.closeInput();
+        std::vector<TaskQueue*> qvector{&q};
+        initCPPWorkers(qvector, 1, false, 1, 0, false, false);
+        joinCPPWorkers();
     }
 
 public:
-    explicit MTWrapperBase(uint32_t numFunctions, DCTX(ctx)) : _ctx(ctx) {
-        get_topology(topologyPhysicalIds, topologyUniqueThreads, topologyResponsibleThreads);
-        if(ctx->config.numberOfThreads > 0)
+    /**
+     * @param numThreads The number of CPU workers of this pipeline, if positive, instead of the configured one
+     * @param scheme The partitioning scheme of this pipeline, if not `INVALID`, instead of the configured one
+     */
+    explicit MTWrapperBase(uint32_t numFunctions, DCTX(ctx), int64_t numThreads = -1,
+            SelfSchedulingScheme scheme = INVALID) : _ctx(ctx) {
+        if(auto pool = WorkerPool::getOrCreate(ctx)) {
+            topologyPhysicalIds = pool->getPhysicalIds();
+            topologyUniqueThreads = pool->getUniqueThreads();
+            topologyResponsibleThreads = pool->getResponsibleThreads();
+        } else
+            get_topology(topologyPhysicalIds, topologyUniqueThreads, topologyResponsibleThreads);
+        if(numThreads > 0)
+            _numCPPThreads = numThreads;
+        else if(ctx->config.numberOfThreads > 0)
             _numCPPThreads = ctx->config.numberOfThreads;
         else
-            _numCPPThreads = std::thread::hardware_concurrency();
+            _numCPPThreads = Topology::get().getNumCpus();
 
         if(_ctx->getUserConfig().queueSetupScheme != CENTRALIZED)
             _numCPPThreads = topologyUniqueThreads.size();
@@ -207,8 +344,19 @@ public:
         _queueMode = 0;
         _numQueues = 1;
         _stealLogic = _ctx->getUserConfig().victimSelection;
-        if( std::thread::hardware_concurrency() < topologyUniqueThreads.size() && _ctx->config.hyperthreadingEnabled )
-            topologyUniqueThreads.resize(_numCPPThreads);
+        _scheme = scheme != INVALID ? scheme : _ctx->config.taskPartitioningScheme;
+        _minimumTaskSize = std::max(_ctx->config.minimumTaskSize, 1);
+        if(!_ctx->config.vectorized_trace_file.empty() && !SchedulingTrace::get().isEnabled())
+            SchedulingTrace::get().enable(_ctx->config.vectorized_trace_file);
+        if(_ctx->config.vectorized_autotune && !Autotuner::get().isEnabled())
+            Autotuner::get().enable(_ctx->config.vectorized_autotune_profile);
+        // more workers than usable CPUs (e.g., via --num-threads) share the CPUs round-robin
+        const size_t numUsableCPUs = topologyUniqueThreads.size();
+        for(size_t i = numUsableCPUs; i < _numCPPThreads; i++) {
+            topologyPhysicalIds.push_back(topologyPhysicalIds[i % numUsableCPUs]);
+            topologyUniqueThreads.push_back(topologyUniqueThreads[i % numUsableCPUs]);
+        }
+        _maxCPPThreads = _numCPPThreads;
         _numThreads = _numCPPThreads + _numCUDAThreads;
         _totalNumaDomains = std::set<double>( topologyPhysicalIds.begin(), topologyPhysicalIds.end() ).size();
 
@@ -218,6 +366,19 @@ public:
         } else if ( _ctx->getUserConfig().queueSetupScheme == PERCPU ) {
             _queueMode = 2;
             _numQueues = _numCPPThreads;
+        } else if ( _ctx->getUserConfig().queueSetupScheme == PERCPU_LOCKFREE ) {
+            _queueMode = 2;
+            _numQueues = _numCPPThreads;
+            _lockFreeQueues = true;
+        }
+
+        if( _ctx->config.numaAware ) {
+            _numaAware = true;
+            if( _queueMode == 0 ) {
+                _queueMode = 1;
+                _numQueues = _totalNumaDomains;
+            }
+            _stealLogic = SEQLOCAL;
         }
 
         if( _ctx->config.debugMultiThreading ) {
@@ -253,7 +414,9 @@ class MTWrapper<DenseMatrix<VT>> : public  MTWrapperBase<DenseMatrix<VT>> {
 public:
     using PipelineFunc = void(DenseMatrix<VT> ***, Structure **, DCTX(ctx));
 
-    explicit MTWrapper(uint32_t numFunctions, DCTX(ctx)) : MTWrapperBase<DenseMatrix<VT>>(numFunctions, ctx){}
+    explicit MTWrapper(uint32_t numFunctions, DCTX(ctx), int64_t numThreads = -1,
+            SelfSchedulingScheme scheme = INVALID) :
+            MTWrapperBase<DenseMatrix<VT>>(numFunctions, ctx, numThreads, scheme){}
 
 
     [[maybe_unused]] void executeSingleQueue(std::vector<std::function<PipelineFunc>> funcs, DenseMatrix<VT>*** res,
@@ -268,8 +431,44 @@ public:
             const bool* isScalar,Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows,
             int64_t* outCols, VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose);
 
-    void combineOutputs(DenseMatrix<VT>***& res, DenseMatrix<VT>***& res_cuda, size_t numOutputs,
-            mlir::daphne::VectorCombine* combines, DCTX(ctx)) override;
+    /**
+     * @brief Executes a pipeline like `executeCpuQueues()` with the number of threads, the partitioning scheme, and
+     * the minimum task size the Autotuner chose for its signature (the ops `ops`, the value type, and the shape). If
+     * the signature was not tuned yet, the first rows are split into one trial range per candidate configuration,
+     * the remaining rows are processed with the fastest one, which is recorded. Pipelines whose workers cannot be
+     * tuned (see `canAutotune()`) or whose rows are too few for the trials are executed as configured.
+     */
+    [[maybe_unused]] void executeAutotuned(std::vector<std::function<PipelineFunc>> funcs, DenseMatrix<VT>*** res,
+            const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows,
+            int64_t* outCols, VectorSplit* splits, VectorCombine* combines, const char* ops, DCTX(ctx), bool verbose);
+
+    /**
+     * @brief Executes a pipeline whose input `streamInput` (split `STREAM`) is read from `source` one chunk of rows
+     * after the other on the CPU workers. While the workers process the tasks of one chunk, the next one is read,
+     * and at most two chunks are held in memory. The other row-split inputs are viewed chunk by chunk.
+     */
+    [[maybe_unused]] void executeStreaming(std::vector<std::function<PipelineFunc>> funcs, DenseMatrix<VT>*** res,
+            const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows,
+            int64_t* outCols, VectorSplit* splits, VectorCombine* combines, size_t streamInput,
+            RowChunkReader<VT>& source, DCTX(ctx), bool verbose);
+
+    void combineOutputs(DenseMatrix<VT>***& res, std::vector<std::vector<DenseMatrix<VT>*>>& deviceAddRes,
+            size_t numOutputs, mlir::daphne::VectorCombine* combines, DCTX(ctx)) override;
+
+private:
+    /**
+     * @brief Creates one data sink per output, writing into the allocated outputs (row-wise and column-wise combines)
+     * or into one partial result per worker thread (aggregation combines).
+     */
+    std::vector<VectorizedDataSink<DenseMatrix<VT>> *> createDataSinks(DenseMatrix<VT>*** res, size_t numOutputs,
+            VectorCombine* combines);
+
+    /**
+     * @brief Stores the merged results of the aggregation combines in the outputs and destroys the data sinks. Must only be
+     * called after all tasks have finished.
+     */
+    void consumeDataSinks(std::vector<VectorizedDataSink<DenseMatrix<VT>> *>& dataSinks, DenseMatrix<VT>*** res,
+            size_t numOutputs, VectorCombine* combines);
 };
 
 template<typename VT>
@@ -277,14 +476,13 @@ class MTWrapper<CSRMatrix<VT>> : public MTWrapperBase<CSRMatrix<VT>> {
 public:
     using PipelineFunc = void(CSRMatrix<VT> ***, Structure **, DCTX(ctx));
 
-    explicit MTWrapper(uint32_t numFunctions, DCTX(ctx)) :
-            MTWrapperBase<CSRMatrix<VT>>(numFunctions, ctx){ }
+    explicit MTWrapper(uint32_t numFunctions, DCTX(ctx), int64_t numThreads = -1,
+            SelfSchedulingScheme scheme = INVALID) :
+            MTWrapperBase<CSRMatrix<VT>>(numFunctions, ctx, numThreads, scheme){ }
 
     [[maybe_unused]] void executeSingleQueue(std::vector<std::function<PipelineFunc>> funcs, CSRMatrix<VT>*** res,
             const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, const int64_t* outRows,
-            const int64_t* outCols, VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose) {
-        throw std::runtime_error("sparse single queue vect exec not implemented");
-    }
+            const int64_t* outCols, VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose);
 
     [[maybe_unused]] void executeCpuQueues(std::vector<std::function<PipelineFunc>> funcs, CSRMatrix<VT>*** res,
             const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, const int64_t* outRows,
@@ -292,10 +490,93 @@ public:
 
     [[maybe_unused]] void executeQueuePerDeviceType(std::vector<std::function<PipelineFunc>> funcs, CSRMatrix<VT>*** res,
             const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows, int64_t* outCols,
-                            VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose) {
-        throw std::runtime_error("sparse queuePerDeviceType vect exec not implemented");
+                            VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose);
+
+    [[maybe_unused]] void executeStreaming(std::vector<std::function<PipelineFunc>> funcs, CSRMatrix<VT>*** res,
+            const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows,
+            int64_t* outCols, VectorSplit* splits, VectorCombine* combines, size_t streamInput,
+            RowChunkReader<VT>& source, DCTX(ctx), bool verbose) {
+        throw std::runtime_error("sparse streaming vect exec not implemented");
     }
     
-    void combineOutputs(CSRMatrix<VT>***& res, CSRMatrix<VT>***& res_cuda, [[maybe_unused]] size_t numOutputs,
-                        [[maybe_unused]] mlir::daphne::VectorCombine* combines, DCTX(ctx)) override {}
-};
\ No newline at end of file
+    void combineOutputs(CSRMatrix<VT>***& res, std::vector<std::vector<CSRMatrix<VT>*>>& deviceAddRes,
+                        [[maybe_unused]] size_t numOutputs, [[maybe_unused]] mlir::daphne::VectorCombine* combines,
+                        DCTX(ctx)) override {}
+
+private:
+    /**
+     * @brief Returns the row offsets of the row-split CSR input with the most non-zeros as the cost of each row, or
+     * `nullptr` if there is no such input with non-zeros.
+     */
+    const size_t* getRowCosts(Structure** inputs, size_t numInputs, VectorSplit* splits, uint64_t len);
+
+    /**
+     * @brief Partitions the rows `rowBegin` to `rowEnd` by the configured scheme, which operates on the non-zeros of
+     * the rows instead of the rows if `rowCosts` is given (see `getRowCosts()`).
+     */
+    LoadPartitioning createPartitioning(const size_t* rowCosts, uint64_t rowBegin, uint64_t rowEnd,
+            ChunkFeedback* feedback, DCTX(ctx)) const;
+
+    /**
+     * @brief Creates one data sink per output, which is shared by all tasks, since the parts of row-wise and
+     * column-wise combines are stored in slots of their first row (column), and the parts of the aggregation
+     * combines are aggregated per worker thread. An output given already is the initial value of an aggregation
+     * combine, and replaced by the result otherwise.
+     */
+    std::vector<VectorizedDataSink<CSRMatrix<VT>> *> createDataSinks(CSRMatrix<VT>*** res, size_t numOutputs,
+            const int64_t* outRows, const int64_t* outCols, VectorCombine* combines);
+
+    /**
+     * @brief Merges the parts collected by the data sinks into the outputs (on the idle workers) and destroys the data
+     * sinks. Must only be called after all tasks have finished.
+     */
+    void consumeDataSinks(std::vector<VectorizedDataSink<CSRMatrix<VT>> *>& dataSinks, CSRMatrix<VT>*** res,
+            size_t numOutputs);
+};
+
+/**
+ * @brief Executes pipelines whose results are frames, whose tasks view the rows of their row-split inputs (frames or
+ * matrices) and whose parts are concatenated column by column (see `VectorizedDataSink<Frame>`). Frames only support
+ * the row-wise combine and are processed by the CPU workers.
+ */
+template<>
+class MTWrapper<Frame> : public MTWrapperBase<Frame> {
+public:
+    using PipelineFunc = void(Frame ***, Structure **, DCTX(ctx));
+
+    explicit MTWrapper(uint32_t numFunctions, DCTX(ctx), int64_t numThreads = -1,
+            SelfSchedulingScheme scheme = INVALID) : MTWrapperBase<Frame>(numFunctions, ctx, numThreads, scheme) {}
+
+    [[maybe_unused]] void executeSingleQueue(std::vector<std::function<PipelineFunc>> funcs, Frame*** res,
+            const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows,
+            int64_t* outCols, VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose);
+
+    [[maybe_unused]] void executeCpuQueues(std::vector<std::function<PipelineFunc>> funcs, Frame*** res,
+            const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows,
+            int64_t* outCols, VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose);
+
+    // there are no GPU kernels of frames, so the pipeline is executed by the CPU workers
+    [[maybe_unused]] void executeQueuePerDeviceType(std::vector<std::function<PipelineFunc>> funcs, Frame*** res,
+            const bool* isScalar, Structure** inputs, size_t numInputs, size_t numOutputs, int64_t* outRows,
+            int64_t* outCols, VectorSplit* splits, VectorCombine* combines, DCTX(ctx), bool verbose) {
+        executeCpuQueues(funcs, res, isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, ctx,
+                verbose);
+    }
+
+    void combineOutputs(Frame***& res, std::vector<std::vector<Frame*>>& deviceAddRes,
+            [[maybe_unused]] size_t numOutputs, [[maybe_unused]] mlir::daphne::VectorCombine* combines,
+            DCTX(ctx)) override {}
+
+private:
+    /**
+     * @brief Creates one data sink per output with one slot per row of the split inputs. Throws for other combines
+     * than the row-wise one.
+     */
+    std::vector<VectorizedDataSink<Frame> *> createDataSinks(size_t numOutputs, uint64_t len, VectorCombine* combines);
+
+    /**
+     * @brief Concatenates the parts collected by the data sinks into the outputs (on the idle workers) and destroys
+     * the data sinks. Must only be called after all tasks have finished.
+     */
+    void consumeDataSinks(std::vector<VectorizedDataSink<Frame> *>& dataSinks, Frame*** res, size_t numOutputs);
+};
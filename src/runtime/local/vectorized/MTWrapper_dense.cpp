@@ -15,9 +15,14 @@
  */
 
 #include "MTWrapper.h"
+#include <runtime/local/datastructures/ValueTypeUtils.h>
 #include <runtime/local/vectorized/Tasks.h>
 
+#include <chrono>
+
 #ifdef USE_CUDA
+#include <runtime/local/kernels/CUDA/EwBinaryMat.h>
+#include <runtime/local/vectorized/HybridPartitioner.h>
 #include <runtime/local/vectorized/TasksCUDA.h>
 #endif
 
@@ -33,7 +38,8 @@ template<typename VT>
     auto row_mem = mem_required / len;
 
     // create task queue (w/o size-based blocking)
-    std::unique_ptr<TaskQueue> q = std::make_unique<BlockingTaskQueue>(len);
+    std::unique_ptr<TaskQueue> q = std::make_unique<BlockingTaskQueue>(this->getQueueCapacity(len, 1));
+    auto feedback = this->createChunkFeedback(1);
 
     std::vector<TaskQueue*> tmp_q{q.get()};
     auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
@@ -41,7 +47,7 @@ template<typename VT>
 
 #ifdef USE_CUDA
     if(this->_numCUDAThreads) {
-        this->initCUDAWorkers(q.get(), batchSize8M * 4, verbose);
+        this->initCUDAWorkers(tmp_q, batchSize8M * 4, verbose);
         this->cudaPrefetchInputs(inputs, numInputs, mem_required, splits);
 #ifndef NDEBUG
         std::cerr << "Required memory (ins/outs): " << mem_required << "\nRequired mem/row: " << row_mem << std::endl;
@@ -50,28 +56,30 @@ template<typename VT>
     }
 #endif
 
-    // lock for aggregation combine
-    // TODO: multiple locks per output
-    std::mutex resLock;
+    auto dataSinks = this->createDataSinks(res, numOutputs, combines);
 
     // create tasks and close input
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    typename TaskArena<CompiledPipelineTask<DenseMatrix<VT>>>::Lease tasks;
+    TaskBatcher batcher(tmp_q, this->getTaskBatchSize(len, 1));
     uint64_t startChunk = 0;
     uint64_t endChunk = 0;
-    int method=ctx->config.taskPartitioningScheme;
-    int chunkParam = ctx->config.minimumTaskSize;
-    if(chunkParam<=0)
-        chunkParam=1;
-    LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false);
+    // the configured scheme and task size, unless tuned for this pipeline
+    int method = this->_scheme;
+    int chunkParam = this->_minimumTaskSize;
+    LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false, feedback.get());
     while (lp.hasNextChunk()) {
         endChunk += lp.getNextChunk();
-        q->enqueueTask(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs,
+        batcher.enqueue(0, tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs.data(),
                 isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk,
-                outRows, outCols, 0, ctx}, resLock, res));
+                outRows, outCols, 0, ctx, feedback.get(), 0, pins.getNumCalls()}, dataSinks));
         startChunk = endChunk;
     }
+    batcher.flush();
     q->closeInput();
 
     this->joinAll();
+    this->consumeDataSinks(dataSinks, res, numOutputs, combines);
 }
 
 template<typename VT>
@@ -93,92 +101,205 @@ template<typename VT>
             CPU_ZERO(&cpuset);
             CPU_SET(i, &cpuset);
             sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
-            std::unique_ptr<TaskQueue> tmp = std::make_unique<BlockingTaskQueue>(len);
+            std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(this->getQueueCapacity(len, this->_numQueues));
             q.push_back(std::move(tmp));
             qvector.push_back(q[i].get());
         }
     } else {
         for(int i=0; i<this->_numQueues; i++) {
-            std::unique_ptr<TaskQueue> tmp = std::make_unique<BlockingTaskQueue>(len);
+            std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(this->getQueueCapacity(len, this->_numQueues));
             q.push_back(std::move(tmp));
             qvector.push_back(q[i].get());
         }
     }
 
+    auto feedback = this->createChunkFeedback(this->_numQueues);
+
     auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
-    this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode, ctx->getUserConfig().pinWorkers);
+    if(!this->_lockFreeQueues)
+        this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                this->pinWorkers());
 
-    // lock for aggregation combine
-    // TODO: multiple locks per output
-    std::mutex resLock;
+    auto dataSinks = this->createDataSinks(res, numOutputs, combines);
 
     // create tasks and close input
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    // the pinned workers read the large broadcast inputs from a copy on their NUMA node
+    std::unique_ptr<BroadcastReplicas> replicas;
+    if(this->pinWorkers())
+        replicas = BroadcastReplicas::create<VT>(inputs, isScalar, splits, numInputs, len,
+                ctx->config.numa_replicate_broadcast_bytes);
+    typename TaskArena<CompiledPipelineTask<DenseMatrix<VT>>>::Lease tasks;
+    TaskBatcher batcher(qvector, this->getTaskBatchSize(len, this->_numQueues));
     uint64_t startChunk = 0;
     uint64_t endChunk = 0;
     uint64_t currentItr = 0;
     uint64_t target;
-    int method=ctx->config.taskPartitioningScheme;
-    int chunkParam = ctx->config.minimumTaskSize;
-    if(chunkParam<=0)
-        chunkParam=1;
-    if (ctx->getUserConfig().prePartitionRows) {
+    // the configured scheme and task size, unless tuned for this pipeline
+    int method = this->_scheme;
+    int chunkParam = this->_minimumTaskSize;
+    if (this->prePartitionRows()) {
         uint64_t oneChunk = len/this->_numQueues;
         int remainder = len - (oneChunk * this->_numQueues);
         std::vector<LoadPartitioning> lps;
-        lps.emplace_back(method, oneChunk+remainder, chunkParam, this->_numThreads, false);
+        lps.emplace_back(method, oneChunk+remainder, chunkParam, this->_numThreads, false, feedback.get());
         for(int i=1; i<this->_numQueues; i++) {
-            lps.emplace_back(method, oneChunk, chunkParam, this->_numThreads, false);
+            lps.emplace_back(method, oneChunk, chunkParam, this->_numThreads, false, feedback.get());
         }
         if (ctx->getUserConfig().pinWorkers) {
             for(int i=0; i<this->_numQueues; i++) {
                 while (lps[i].hasNextChunk()) {
-                    endChunk += lps[i].getNextChunk();
-                    qvector[i]->enqueueTaskPinned(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs, isScalar,
+                    endChunk += lps[i].getNextChunk(i);
+                    qvector[i]->enqueueTaskPinned(tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs.data(), isScalar,
                             inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                            outCols, 0, ctx}, resLock, res), this->topologyResponsibleThreads[i]);
+                            outCols, 0, ctx, feedback.get(), static_cast<size_t>(i), pins.getNumCalls(), 0, replicas.get()}, dataSinks), this->topologyResponsibleThreads[i]);
                     startChunk = endChunk;
                 }
             }
         } else {
             for(int i=0; i<this->_numQueues; i++) {
                 while (lps[i].hasNextChunk()) {
-                    endChunk += lps[i].getNextChunk();
-                    qvector[i]->enqueueTask(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs, isScalar,
+                    endChunk += lps[i].getNextChunk(i);
+                    batcher.enqueue(i, tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs.data(), isScalar,
                             inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                            outCols, 0, ctx}, resLock, res));
+                            outCols, 0, ctx, feedback.get(), static_cast<size_t>(i), pins.getNumCalls(), 0, replicas.get()}, dataSinks));
                     startChunk = endChunk;
                 }
             }
         }
     } else {
-        LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false);
+        LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false, feedback.get());
         if (ctx->getUserConfig().pinWorkers) {
             while (lp.hasNextChunk()) {
-                endChunk += lp.getNextChunk();
                 target = currentItr % this->_numQueues;
-                qvector[target]->enqueueTaskPinned(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs, isScalar,
+                endChunk += lp.getNextChunk(target);
+                qvector[target]->enqueueTaskPinned(tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs.data(), isScalar,
                         inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                        outCols, 0, ctx}, resLock, res), this->topologyUniqueThreads[target]);
+                        outCols, 0, ctx, feedback.get(), target, pins.getNumCalls(), 0, replicas.get()}, dataSinks), this->topologyUniqueThreads[target]);
                 startChunk = endChunk;
 		currentItr++;
             }
         } else {
             while (lp.hasNextChunk()) {
-                endChunk += lp.getNextChunk();
                 target = currentItr % this->_numQueues;
-                qvector[target]->enqueueTask(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs, isScalar,
+                endChunk += lp.getNextChunk(target);
+                batcher.enqueue(target, tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs.data(), isScalar,
                         inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                        outCols, 0, ctx}, resLock, res));
+                        outCols, 0, ctx, feedback.get(), target, pins.getNumCalls(), 0, replicas.get()}, dataSinks));
                 startChunk = endChunk;
 		currentItr++;
             }
         }
     }
+    batcher.flush();
     for(int i=0; i<this->_numQueues; i++) {
         qvector[i]->closeInput();
     }
+    if(this->_lockFreeQueues)
+        this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                this->pinWorkers());
 
     this->joinAll();
+    this->consumeDataSinks(dataSinks, res, numOutputs, combines);
+}
+
+template<typename VT>
+[[maybe_unused]] void MTWrapper<DenseMatrix<VT>>::executeAutotuned(
+        std::vector<std::function<typename MTWrapper<DenseMatrix<VT>>::PipelineFunc>> funcs, DenseMatrix<VT> ***res,
+        const bool* isScalar, Structure **inputs, size_t numInputs, size_t numOutputs, int64_t *outRows, int64_t *outCols,
+        VectorSplit *splits, VectorCombine *combines, const char* ops, DCTX(ctx), bool verbose) {
+    Autotuner& tuner = Autotuner::get();
+    if(!tuner.isEnabled() || !this->canAutotune()) {
+        executeCpuQueues(funcs, res, isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, ctx,
+                verbose);
+        return;
+    }
+    auto inputProps = this->getInputProperties(inputs, numInputs, splits);
+    auto len = inputProps.first;
+    // the extent of the split inputs along the other dimension
+    uint64_t numCols = 0;
+    for(size_t i = 0; i < numInputs; i++)
+        if(!isScalar[i] && splits[i] == VectorSplit::ROWS)
+            numCols += inputs[i]->getNumCols();
+        else if(!isScalar[i] && splits[i] == VectorSplit::COLS)
+            numCols += inputs[i]->getNumRows();
+    const std::string signature = Autotuner::getSignature(ops ? ops : "", ValueTypeUtils::cppNameFor<VT>, len,
+            numCols);
+
+    if(auto choice = tuner.lookup(signature)) {
+        this->applyChoice(*choice);
+        executeCpuQueues(funcs, res, isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, ctx,
+                verbose);
+        return;
+    }
+    const std::vector<Autotuner::Choice> candidates = Autotuner::getCandidates(this->getChoice());
+    const uint64_t trialRows = Autotuner::getTrialRows(len, candidates.size(), this->_numCPPThreads);
+    if(trialRows == 0) {
+        executeCpuQueues(funcs, res, isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, ctx,
+                verbose);
+        return;
+    }
+
+    auto mem_required = inputProps.second;
+    mem_required += this->allocateOutput(res, numOutputs, outRows, outCols, combines);
+    auto row_mem = mem_required / len;
+    auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
+
+    // created with the most threads of all candidates (the configured ones), such that the add combines have a
+    // partial result per worker of every candidate
+    auto dataSinks = this->createDataSinks(res, numOutputs, combines);
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    typename TaskArena<CompiledPipelineTask<DenseMatrix<VT>>>::Lease tasks;
+
+    // processes the rows [begin, end) with the current choice on a single queue, returning the seconds it took
+    auto executeRows = [&](uint64_t begin, uint64_t end) {
+        const auto start = std::chrono::steady_clock::now();
+        BlockingTaskQueue q(this->getQueueCapacity(end - begin, 1));
+        std::vector<TaskQueue*> qvector{&q};
+        auto feedback = this->createChunkFeedback(1);
+        this->initCPPWorkers(qvector, batchSize8M, verbose, 1, 0, false);
+        TaskBatcher batcher(qvector, this->getTaskBatchSize(end - begin, 1));
+        LoadPartitioning lp(this->_scheme, end - begin, this->_minimumTaskSize, this->_numThreads, false,
+                feedback.get());
+        uint64_t startChunk = begin;
+        uint64_t endChunk = begin;
+        while (lp.hasNextChunk()) {
+            endChunk += lp.getNextChunk();
+            batcher.enqueue(0, tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs.data(), isScalar,
+                    inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
+                    outCols, 0, ctx, feedback.get(), 0, pins.getNumCalls()}, dataSinks));
+            startChunk = endChunk;
+        }
+        batcher.flush();
+        q.closeInput();
+        this->joinAll();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // one trial range per candidate, the remaining rows with the fastest one per row
+    uint64_t begin = 0;
+    size_t best = 0;
+    double bestSecondsPerRow = 0;
+    for(size_t c = 0; c < candidates.size(); c++) {
+        this->applyChoice(candidates[c]);
+        const double secondsPerRow = executeRows(begin, begin + trialRows) / trialRows;
+        if(c == 0 || secondsPerRow < bestSecondsPerRow) {
+            best = c;
+            bestSecondsPerRow = secondsPerRow;
+        }
+        begin += trialRows;
+    }
+    this->applyChoice(candidates[best]);
+    executeRows(begin, len);
+    // the trials of a cancelled run skipped their tasks
+    if(!ctx->getRunControl()->isCancelled())
+        tuner.record(signature, this->getChoice());
+    if(ctx->config.debugMultiThreading)
+        std::cout << "autotuned " << signature << ": " << this->_numCPPThreads << " threads, "
+                << Autotuner::getSchemeName(this->_scheme) << ", minimum task size " << this->_minimumTaskSize
+                << std::endl;
+
+    this->consumeDataSinks(dataSinks, res, numOutputs, combines);
 }
 
 template<typename VT>
@@ -186,56 +307,80 @@ template<typename VT>
         std::vector<std::function<typename MTWrapper<DenseMatrix<VT>>::PipelineFunc>> funcs, DenseMatrix<VT> ***res,
         const bool* isScalar, Structure **inputs, size_t numInputs, size_t numOutputs, int64_t *outRows, int64_t *outCols,
         VectorSplit *splits, VectorCombine *combines, DCTX(ctx), bool verbose) {
-    size_t device_task_len = 0ul;
     auto inputProps = this->getInputProperties(inputs, numInputs, splits);
     auto len = inputProps.first;
     auto mem_required = inputProps.second;
     mem_required += this->allocateOutput(res, numOutputs, outRows, outCols, combines);
     auto row_mem = mem_required / len;
     auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
-    // lock for aggregation combine
-    // TODO: multiple locks per output
-    std::mutex resLock;
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
 
+    // the CPU workers process (a part of) the rows [cpuBegin, len), which are combined in res_cpp
+    uint64_t cpuBegin = 0;
+    // the rows [cpuRangeBegin, cpuRangeEnd) are left for the CPU workers once the GPU workers got their part
+    uint64_t cpuRangeBegin = 0;
+    uint64_t cpuRangeEnd = len;
 #ifdef USE_CUDA
-    // ToDo: multi-device support :-P
-    float taskRatioCUDA = 0.25f;
-    auto gpu_task_len = static_cast<size_t>(std::ceil(static_cast<float>(len) * taskRatioCUDA));
-    device_task_len += gpu_task_len;
-    std::unique_ptr<TaskQueue> q_cuda = std::make_unique<BlockingTaskQueue>(gpu_task_len);
-    this->initCUDAWorkers(q_cuda.get(), batchSize8M * 4, verbose);
-
-    auto*** res_cuda = new DenseMatrix<VT>**[numOutputs];
-    auto blksize = gpu_task_len / ctx->cuda_contexts.size();
+    const size_t numDevices = this->_numCUDAThreads;
+
+    // The GPU workers process the rows from the first one on, the CPU workers from the last one backwards. Both
+    // profile one batch per worker before the remaining rows are split by their measured throughput. The CPU workers
+    // of lock-free queues only start once all tasks are enqueued, so they cannot be profiled beforehand.
+    HybridPartitioner hybrid(len, this->_numCPPThreads, numDevices, batchSize8M * 4 * numDevices,
+            batchSize8M * this->_numCPPThreads, !this->_lockFreeQueues);
+    cpuBegin = hybrid.getGPUProfileEnd();
+    // the GPU workers process at most the rows up to the profiling range of the CPU workers
+    const uint64_t gpuMaxEnd = hybrid.getCPUProfileStart();
+    cpuRangeEnd = hybrid.isProfiling() ? gpuMaxEnd : len;
 #ifndef NDEBUG
-    std::cerr << "gpu_task_len:  " << gpu_task_len << "\ntaskRatioCUDA: " << taskRatioCUDA << "\nBlock size: "
-              << blksize << std::endl;
+    std::cerr << "GPU profiling rows: " << cpuBegin << "\nCPU profiling rows: " << len - gpuMaxEnd << std::endl;
 #endif
+
+    // one worker and queue per device, which gets one task of the profiling range and one of the remaining rows
+    std::vector<std::unique_ptr<TaskQueue>> q_cuda;
+    std::vector<TaskQueue*> qvector_cuda;
+    for(size_t d = 0; d < numDevices; ++d) {
+        q_cuda.push_back(std::make_unique<BlockingTaskQueue>(2));
+        qvector_cuda.push_back(q_cuda.back().get());
+    }
+    this->initCUDAWorkers(qvector_cuda, batchSize8M * 4, verbose);
+
+    // The GPU workers copy the parts of row-wise and column-wise combines into the outputs directly. Aggregation
+    // combines are aggregated on the device, per device (guarded by the lock of the device), the first device adding
+    // into the output itself. The min and max combines start from the first part of each device instead.
+    std::vector<VectorizedDataSink<DenseMatrix<VT>> *> dataSinksCuda(numOutputs, nullptr);
+    std::vector<std::vector<DenseMatrix<VT>*>> deviceAddRes(numDevices, std::vector<DenseMatrix<VT>*>(numOutputs));
+    auto deviceLocks = std::make_unique<std::mutex[]>(numDevices);
     for (size_t i = 0; i < numOutputs; ++i) {
-        res_cuda[i] = new DenseMatrix<VT>*;
-        if(combines[i] == mlir::daphne::VectorCombine::ROWS) {
-            auto rc2 = static_cast<DenseMatrix<VT> *>((*res[i]))->sliceRow(0, gpu_task_len);
-            (*res_cuda[i]) = rc2;
-        }
-        else if(combines[i] == mlir::daphne::VectorCombine::COLS) {
-            (*res_cuda[i]) = static_cast<DenseMatrix<VT> *>((*res[i]))->slice(0, outRows[i], 0, gpu_task_len);
-        }
-        else {
-            (*res_cuda[i]) = (*res[i]);
+        if(isAggCombine(combines[i])) {
+            if(numDevices && combines[i] == mlir::daphne::VectorCombine::ADD)
+                deviceAddRes[0][i] = (*res[i]);
         }
+        else
+            dataSinksCuda[i] = new VectorizedDataSink<DenseMatrix<VT>>(combines[i], (*res[i]));
     }
 
-    for (uint32_t k = 0; k < gpu_task_len; k += blksize) {
-        q_cuda->enqueueTask(new CompiledPipelineTaskCUDA<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{
-                funcs, isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, k,
-                std::min(k + blksize, len), outRows, outCols, 0, ctx}, resLock, res_cuda));
-    }
-    q_cuda->closeInput();
+    // the rows are split evenly between the devices
+    auto enqueueCudaTasks = [&](uint64_t begin, uint64_t end) {
+        if(begin >= end)
+            return;
+        const uint64_t blksize = (end - begin + numDevices - 1) / numDevices;
+        for (size_t d = 0; d < numDevices && begin + d * blksize < end; ++d) {
+            const uint64_t k = begin + d * blksize;
+            q_cuda[d]->enqueueTask(new CompiledPipelineTaskCUDA<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{
+                    funcs.data(), isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, k,
+                    std::min(k + blksize, end), outRows, outCols, 0, ctx, hybrid.getFeedback(),
+                    HybridPartitioner::GPU_SLOT, pins.getNumCalls()}, dataSinksCuda, deviceLocks[d], deviceAddRes[d],
+                    d));
+        }
+    };
+    enqueueCudaTasks(0, cpuBegin);
 #endif
 
-    auto cpu_task_len = len - device_task_len;
+    auto cpu_task_len = len - cpuBegin;
+    typename TaskArena<CompiledPipelineTask<DenseMatrix<VT>>>::Lease tasks;
     DenseMatrix<VT> ***res_cpp{};
-    std::unique_ptr<TaskQueue> q_cpp;
+    std::vector<VectorizedDataSink<DenseMatrix<VT>> *> dataSinksCpp;
 
     std::vector<std::unique_ptr<TaskQueue>> q;
     std::vector<TaskQueue*> qvector;
@@ -247,65 +392,100 @@ template<typename VT>
                 CPU_ZERO(&cpuset);
                 CPU_SET(i, &cpuset);
                 sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
-                std::unique_ptr<TaskQueue> tmp = std::make_unique<BlockingTaskQueue>(cpu_task_len);
+                std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(cpu_task_len);
                 q.push_back(std::move(tmp));
                 qvector.push_back(q[i].get());
             }
         } else {
             for(int i=0; i<this->_numQueues; i++) {
-                std::unique_ptr<TaskQueue> tmp = std::make_unique<BlockingTaskQueue>(cpu_task_len);
+                std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(cpu_task_len);
                 q.push_back(std::move(tmp));
                 qvector.push_back(q[i].get());
             }
         }
-        this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode, ctx->getUserConfig().pinWorkers);
+        if(!this->_lockFreeQueues)
+            this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                    ctx->getUserConfig().pinWorkers);
 // End Multiple Queues
 
         res_cpp = new DenseMatrix<VT> **[numOutputs];
-        auto offset = device_task_len;
-
         for (size_t i = 0; i < numOutputs; ++i) {
             res_cpp[i] = new DenseMatrix<VT> *;
             if(combines[i] == mlir::daphne::VectorCombine::ROWS) {
-                (*res_cpp[i]) = static_cast<DenseMatrix<VT> *>((*res[i]))->sliceRow(device_task_len, len);
+                (*res_cpp[i]) = static_cast<DenseMatrix<VT> *>((*res[i]))->sliceRow(cpuBegin, len);
             }
             else if(combines[i] == mlir::daphne::VectorCombine::COLS) {
-                (*res_cpp[i]) = static_cast<DenseMatrix<VT> *>((*res[i]))->sliceCol(device_task_len, len);
+                (*res_cpp[i]) = static_cast<DenseMatrix<VT> *>((*res[i]))->sliceCol(cpuBegin, len);
             }
             else {
                 (*res_cpp[i]) = (*res[i]);
             }
         }
+        dataSinksCpp = this->createDataSinks(res_cpp, numOutputs, combines);
+    }
+    TaskBatcher batcher(qvector, this->TASK_BATCH_SIZE);
+    uint64_t currentItr = 0;
+    auto enqueueCpuTask = [&](uint64_t startChunk, uint64_t endChunk, ChunkFeedback* feedback) {
+        const auto target = currentItr++ % this->_numQueues;
+        batcher.enqueue(target, tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{
+                funcs.data(), isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk,
+                endChunk, outRows, outCols, cpuBegin, ctx, feedback, 0, pins.getNumCalls()}, dataSinksCpp));
+    };
 
-        uint64_t startChunk = device_task_len;
-        uint64_t endChunk = device_task_len;
-        uint64_t currentItr = 0;
-        uint64_t target;
+#ifdef USE_CUDA
+    if(hybrid.isProfiling()) {
+        // one task per CPU worker for the profiling range
+        const uint64_t profileLen = len - gpuMaxEnd;
+        for(uint64_t w = 0; w < this->_numCPPThreads; w++) {
+            const uint64_t startChunk = gpuMaxEnd + profileLen * w / this->_numCPPThreads;
+            const uint64_t endChunk = gpuMaxEnd + profileLen * (w + 1) / this->_numCPPThreads;
+            if(startChunk < endChunk)
+                enqueueCpuTask(startChunk, endChunk, hybrid.getFeedback());
+        }
+        batcher.flush();
+    }
+    cpuRangeBegin = hybrid.split();
+    enqueueCudaTasks(cpuBegin, cpuRangeBegin);
+    for(auto& q_dev : q_cuda)
+        q_dev->closeInput();
+#ifndef NDEBUG
+    std::cerr << "GPU rows: " << cpuRangeBegin << "\nCPU rows: " << len - cpuRangeBegin << std::endl;
+#endif
+#endif
+
+    if(cpuRangeBegin < cpuRangeEnd) {
+        uint64_t startChunk = cpuRangeBegin;
+        uint64_t endChunk = cpuRangeBegin;
         int method=ctx->config.taskPartitioningScheme;
         int chunkParam = ctx->config.minimumTaskSize;
         if(chunkParam<=0)
             chunkParam=1;
-        LoadPartitioning lp(method, cpu_task_len, chunkParam, this->_numCPPThreads, true);
+        LoadPartitioning lp(method, cpuRangeEnd - cpuRangeBegin, chunkParam, this->_numCPPThreads, true);
         while (lp.hasNextChunk()) {
             endChunk += lp.getNextChunk();
-            target = currentItr % this->_numQueues;
-            qvector[target]->enqueueTask(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{
-                    funcs, isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk,
-                    outRows, outCols, offset, ctx}, resLock, res_cpp));
+            enqueueCpuTask(startChunk, endChunk, nullptr);
             startChunk = endChunk;
-            currentItr++;
         }
+    }
+    if(cpu_task_len > 0) {
+        batcher.flush();
         for(int i=0; i<this->_numQueues; i++) {
             qvector[i]->closeInput();
         }
+        if(this->_lockFreeQueues)
+            this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                    ctx->getUserConfig().pinWorkers);
     }
     this->joinAll();
 
 #ifdef USE_CUDA
-    this->combineOutputs(res, res_cuda, numOutputs, combines, ctx);
+    for(auto* dataSink : dataSinksCuda)
+        delete dataSink;
+    this->combineOutputs(res, deviceAddRes, numOutputs, combines, ctx);
 #endif
 
     if(cpu_task_len > 0) {
+        this->consumeDataSinks(dataSinksCpp, res, numOutputs, combines);
         for (size_t i = 0; i < numOutputs; ++i) {
             if(combines[i] == mlir::daphne::VectorCombine::ROWS || combines[i] == mlir::daphne::VectorCombine::COLS)
                 DataObjectFactory::destroy((*res_cpp[i]));
@@ -313,41 +493,205 @@ template<typename VT>
     }
 }
 
+template<typename VT>
+[[maybe_unused]] void MTWrapper<DenseMatrix<VT>>::executeStreaming(
+        std::vector<std::function<typename MTWrapper<DenseMatrix<VT>>::PipelineFunc>> funcs, DenseMatrix<VT> ***res,
+        const bool* isScalar, Structure **inputs, size_t numInputs, size_t numOutputs, int64_t *outRows, int64_t *outCols,
+        VectorSplit *splits, VectorCombine *combines, size_t streamInput, RowChunkReader<VT>& source, DCTX(ctx),
+        bool verbose) {
+    const uint64_t len = source.getNumRows();
+    // the chunks are split like row-split inputs
+    std::vector<VectorSplit> chunkSplits(splits, splits + numInputs);
+    chunkSplits[streamInput] = VectorSplit::ROWS;
+
+    if(len < 2) {
+        // a single row would be broadcast, so it is read at once
+        std::vector<Structure*> wholeInputs(inputs, inputs + numInputs);
+        auto whole = source.readNext(len);
+        wholeInputs[streamInput] = whole;
+        executeSingleQueue(funcs, res, isScalar, wholeInputs.data(), numInputs, numOutputs, outRows, outCols,
+                chunkSplits.data(), combines, ctx, verbose);
+        DataObjectFactory::destroy(whole);
+        return;
+    }
+
+    const size_t rowBytes = source.getNumCols() * sizeof(VT);
+    const uint64_t chunkRows = this->getStreamChunkRows(rowBytes);
+    // a remaining single row is appended to the last chunk
+    const size_t numChunks = std::max<uint64_t>(1, len % chunkRows == 1 ? len / chunkRows
+            : (len + chunkRows - 1) / chunkRows);
+    auto chunkBegin = [&](size_t c) { return c * chunkRows; };
+    auto chunkEnd = [&](size_t c) { return c + 1 == numChunks ? len : (c + 1) * chunkRows; };
+
+    auto inputProps = this->getInputProperties(inputs, numInputs, splits);
+    auto mem_required = inputProps.second + len * rowBytes;
+    mem_required += this->allocateOutput(res, numOutputs, outRows, outCols, combines);
+    auto row_mem = mem_required / len;
+
+    // the tasks are enqueued chunk by chunk, hence the workers have to be started first
+    std::unique_ptr<TaskQueue> q = std::make_unique<BlockingTaskQueue>(len);
+    std::vector<TaskQueue*> tmp_q{q.get()};
+    auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
+    this->initCPPWorkers(tmp_q, batchSize8M, verbose, 1, 0, false);
+
+    auto dataSinks = this->createDataSinks(res, numOutputs, combines);
+
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    typename TaskArena<StreamedPipelineTask<DenseMatrix<VT>>>::Lease tasks;
+    TaskBatcher batcher(tmp_q, this->TASK_BATCH_SIZE);
+    ChunkTaskCounter counter(numChunks);
+    int method=ctx->config.taskPartitioningScheme;
+    int chunkParam = ctx->config.minimumTaskSize;
+    if(chunkParam<=0)
+        chunkParam=1;
+
+    // the inputs of the tasks of every chunk, i.e., the chunk of the streamed input and the views of the chunk's rows
+    // of the other row-split inputs
+    std::vector<std::vector<Structure*>> chunkInputs(numChunks);
+    auto isChunked = [&](size_t i) {
+        return i == streamInput || (!isScalar[i] && splits[i] == VectorSplit::ROWS
+                && !BroadcastInputPins::isBroadcast(splits[i], inputs[i]));
+    };
+    auto freeChunk = [&](size_t c) {
+        counter.wait(c);
+        for(size_t i = 0; i < chunkInputs[c].size(); i++)
+            if(isChunked(i) && chunkInputs[c][i])
+                DataObjectFactory::destroy(chunkInputs[c][i]);
+        chunkInputs[c].clear();
+    };
+
+    size_t numRead = 0;
+    try {
+        for(size_t c = 0; c < numChunks; c++) {
+            // the rest of the file is not read for a cancelled run
+            if(ctx->getRunControl()->isCancelled())
+                break;
+            // at most two chunks are held in memory: the one processed by the workers and the one being read
+            if(c >= 2)
+                freeChunk(c - 2);
+            const uint64_t begin = chunkBegin(c);
+            const uint64_t end = chunkEnd(c);
+            auto& cin = chunkInputs[c];
+            cin.assign(numInputs, nullptr);
+            numRead = c + 1;
+            for(size_t i = 0; i < numInputs; i++)
+                if(!isChunked(i))
+                    cin[i] = inputs[i];
+                else if(i != streamInput)
+                    cin[i] = inputs[i]->sliceRow(begin, end);
+            cin[streamInput] = source.readNext(end - begin);
+
+            LoadPartitioning lp(method, end - begin, chunkParam, this->_numCPPThreads, false);
+            uint64_t startChunk = begin;
+            uint64_t endChunk = begin;
+            while (lp.hasNextChunk()) {
+                endChunk += lp.getNextChunk();
+                counter.add(c);
+                batcher.enqueue(0, tasks.create(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs.data(), isScalar,
+                        cin.data(), numInputs, numOutputs, outRows, outCols, chunkSplits.data(), combines, startChunk,
+                        endChunk, outRows, outCols, 0, ctx, nullptr, 0, pins.getNumCalls(), begin}, dataSinks,
+                        counter, c));
+                startChunk = endChunk;
+            }
+            batcher.flush();
+        }
+    }
+    catch(...) {
+        // let the workers finish the tasks of the chunks read so far before giving up
+        batcher.flush();
+        q->closeInput();
+        this->joinAll();
+        for(size_t c = 0; c < numRead; c++)
+            freeChunk(c);
+        this->consumeDataSinks(dataSinks, res, numOutputs, combines);
+        throw;
+    }
+    q->closeInput();
+
+    this->joinAll();
+    for(size_t c = 0; c < numRead; c++)
+        freeChunk(c);
+    this->consumeDataSinks(dataSinks, res, numOutputs, combines);
+}
+
+template<typename VT>
+std::vector<VectorizedDataSink<DenseMatrix<VT>> *> MTWrapper<DenseMatrix<VT>>::createDataSinks(DenseMatrix<VT>*** res,
+        size_t numOutputs, VectorCombine* combines) {
+    std::vector<VectorizedDataSink<DenseMatrix<VT>> *> dataSinks(numOutputs);
+    for(size_t i = 0; i < numOutputs; i++)
+        dataSinks[i] = new VectorizedDataSink<DenseMatrix<VT>>(combines[i], *(res[i]), this->_numThreads);
+    return dataSinks;
+}
+
+template<typename VT>
+void MTWrapper<DenseMatrix<VT>>::consumeDataSinks(std::vector<VectorizedDataSink<DenseMatrix<VT>> *>& dataSinks,
+        DenseMatrix<VT>*** res, size_t numOutputs, VectorCombine* combines) {
+    for(size_t i = 0; i < numOutputs; i++) {
+        // row-wise and column-wise combines were written into the outputs directly
+        if(isAggCombine(combines[i])) {
+            auto* merged = dataSinks[i]->consume();
+            // the min and max combines of the GPU workers (if any) are not part of the sink
+            if(*(res[i]) && merged && merged != *(res[i])) {
+                ewBinaryMat(getAggCombineOpCode(combines[i]), *(res[i]), *(res[i]), merged, nullptr);
+                DataObjectFactory::destroy(merged);
+            }
+            else if(merged)
+                *(res[i]) = merged;
+        }
+        delete dataSinks[i];
+    }
+    dataSinks.clear();
+}
+
 #ifdef USE_CUDA
 template<typename VT>
-void MTWrapper<DenseMatrix<VT>>::combineOutputs(DenseMatrix<VT>***& res_, DenseMatrix<VT>***& res_cuda_, size_t numOutputs,
-                                                mlir::daphne::VectorCombine* combines, DCTX(ctx)) {
-    const size_t deviceID = 0; //ToDo: multi device support
+void MTWrapper<DenseMatrix<VT>>::combineOutputs(DenseMatrix<VT>***& res_,
+        std::vector<std::vector<DenseMatrix<VT>*>>& deviceAddRes, size_t numOutputs,
+        mlir::daphne::VectorCombine* combines, DCTX(ctx)) {
+    // the partial results are reduced on the first device, which is the current one of the calling thread
+    const size_t deviceID = 0;
     AllocationDescriptorCUDA alloc_desc(ctx, deviceID);
+    auto* dst_ctx = CUDAContext::get(ctx, deviceID);
     for (size_t i = 0; i < numOutputs; ++i) {
-        auto* res = static_cast<DenseMatrix<VT> *>((*res_[i]));
-        auto* res_cuda = static_cast<DenseMatrix<VT> *>((*res_cuda_[i]));
-        if (combines[i] == mlir::daphne::VectorCombine::ROWS) {
-            const auto &const_res_cuda = *res_cuda;
-            auto data_dest = res->getValues();
-            CHECK_CUDART(cudaMemcpy(data_dest, const_res_cuda.getValues(&alloc_desc), const_res_cuda.bufferSize(),
-                                    cudaMemcpyDeviceToHost));
-//            debugPrintCUDABuffer("MTWrapperDense: combine outputs", const_res_cuda.getValues(&alloc_desc), const_res_cuda.getNumItems());
-            DataObjectFactory::destroy(res_cuda);
+        if (!isAggCombine(combines[i]))
+            continue;
+        auto& res = (*res_[i]);
+        // the min and max combines have no output yet
+        if(res == nullptr && !deviceAddRes.empty()) {
+            res = deviceAddRes[0][i];
+            deviceAddRes[0][i] = nullptr;
         }
-        else if (combines[i] == mlir::daphne::VectorCombine::COLS) {
-            const auto &const_res_cuda = *res_cuda;
-            auto dst_base_ptr = res->getValues();
-            auto src_base_ptr = const_res_cuda.getValues(&alloc_desc);
-            for(auto j = 0u; j < res_cuda->getNumRows(); ++j) {
-                //ToDo: rowSkip would be correct here if res_cuda wasn't a shallow copy
-//                auto data_src = src_base_ptr + res_cuda->getRowSkip() * j;
-                auto data_src = src_base_ptr + res_cuda->getNumCols() * j;
-                auto data_dst = dst_base_ptr + res->getRowSkip() * j;
-                CHECK_CUDART(cudaMemcpy(data_dst, data_src,res_cuda->getNumCols() * sizeof(VT), cudaMemcpyDeviceToHost));
+        for (size_t d = 1; d < deviceAddRes.size(); ++d) {
+            auto* partial = deviceAddRes[d][i];
+            if(partial == nullptr)
+                continue;
+            auto* src_ctx = CUDAContext::get(ctx, d);
+            if(dst_ctx->canAccessPeer(src_ctx)) {
+                // copy the partial result between the devices directly
+                auto* copy = DataObjectFactory::create<DenseMatrix<VT>>(partial->getNumRows(), partial->getNumCols(),
+                        false, &alloc_desc);
+                AllocationDescriptorCUDA src_alloc_desc(ctx, d);
+                const auto& const_partial = *partial;
+                CHECK_CUDART(cudaMemcpyPeer(copy->getValues(&alloc_desc), dst_ctx->getDeviceID(),
+                        const_partial.getValues(&src_alloc_desc), src_ctx->getDeviceID(), partial->bufferSize()));
+                DataObjectFactory::destroy(partial);
+                partial = copy;
+            }
+            deviceAddRes[d][i] = nullptr;
+            if(res == nullptr) {
+                res = partial;
+                continue;
             }
-            DataObjectFactory::destroy(res_cuda);
+            // otherwise, the partial result is transferred via the host
+            CUDA::ewBinaryMat(getAggCombineOpCode(combines[i]), res, res, partial, ctx);
+            DataObjectFactory::destroy(partial);
         }
     }
 }
 #else
 template<typename VT>
-void MTWrapper<DenseMatrix<VT>>::combineOutputs(DenseMatrix<VT>***& res_, DenseMatrix<VT>***& res_cuda_, size_t numOutputs,
+void MTWrapper<DenseMatrix<VT>>::combineOutputs(DenseMatrix<VT>***& res_,
+        std::vector<std::vector<DenseMatrix<VT>*>>& deviceAddRes, size_t numOutputs,
         mlir::daphne::VectorCombine* combines, DCTX(ctx)) { }
 #endif
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MTWrapper.h"
+#include <runtime/local/vectorized/Tasks.h>
+
+[[maybe_unused]] void MTWrapper<Frame>::executeSingleQueue(std::vector<std::function<PipelineFunc>> funcs,
+        Frame ***res, const bool* isScalar, Structure **inputs, size_t numInputs, size_t numOutputs, int64_t *outRows,
+        int64_t *outCols, VectorSplit *splits, VectorCombine *combines, DCTX(ctx), const bool verbose) {
+    auto inputProps = this->getInputProperties(inputs, numInputs, splits);
+    auto len = inputProps.first;
+    auto mem_required = inputProps.second;
+    // the frame outputs are not allocated up-front
+    auto row_mem = std::max<size_t>(1, mem_required / std::max<size_t>(1, len));
+    // before any worker is started, since it throws for unsupported combines
+    auto dataSinks = createDataSinks(numOutputs, len, combines);
+
+    // create task queue (w/o size-based blocking)
+    std::unique_ptr<TaskQueue> q = std::make_unique<BlockingTaskQueue>(this->getQueueCapacity(len, 1));
+    auto feedback = this->createChunkFeedback(1);
+
+    std::vector<TaskQueue*> tmp_q{q.get()};
+    auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
+    this->initCPPWorkers(tmp_q, batchSize8M, verbose, 1, 0, false);
+
+    // create tasks and close input
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    TaskArena<CompiledPipelineTask<Frame>>::Lease tasks;
+    TaskBatcher batcher(tmp_q, this->getTaskBatchSize(len, 1));
+    uint64_t startChunk = 0;
+    uint64_t endChunk = 0;
+    LoadPartitioning lp(this->_scheme, len, this->_minimumTaskSize, this->_numThreads, false, feedback.get());
+    while (lp.hasNextChunk()) {
+        endChunk += lp.getNextChunk();
+        batcher.enqueue(0, tasks.create(CompiledPipelineTaskData<Frame>{funcs.data(), isScalar, inputs, numInputs,
+                numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows, outCols, 0, ctx,
+                feedback.get(), 0, pins.getNumCalls()}, dataSinks));
+        startChunk = endChunk;
+    }
+    batcher.flush();
+    q->closeInput();
+
+    this->joinAll();
+    consumeDataSinks(dataSinks, res, numOutputs);
+}
+
+[[maybe_unused]] void MTWrapper<Frame>::executeCpuQueues(std::vector<std::function<PipelineFunc>> funcs,
+        Frame ***res, const bool* isScalar, Structure **inputs, size_t numInputs, size_t numOutputs, int64_t *outRows,
+        int64_t *outCols, VectorSplit *splits, VectorCombine *combines, DCTX(ctx), bool verbose) {
+    auto inputProps = this->getInputProperties(inputs, numInputs, splits);
+    auto len = inputProps.first;
+    auto mem_required = inputProps.second;
+    // the frame outputs are not allocated up-front
+    auto row_mem = std::max<size_t>(1, mem_required / std::max<size_t>(1, len));
+    auto dataSinks = createDataSinks(numOutputs, len, combines);
+
+    std::vector<std::unique_ptr<TaskQueue>> q;
+    std::vector<TaskQueue*> qvector;
+    for(int i=0; i<this->_numQueues; i++) {
+        if (ctx->getUserConfig().pinWorkers) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(i, &cpuset);
+            sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+        }
+        q.push_back(this->createTaskQueue(this->getQueueCapacity(len, this->_numQueues)));
+        qvector.push_back(q[i].get());
+    }
+
+    auto feedback = this->createChunkFeedback(this->_numQueues);
+
+    auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
+    if(!this->_lockFreeQueues)
+        this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                this->pinWorkers());
+
+    // create tasks and close input
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    TaskArena<CompiledPipelineTask<Frame>>::Lease tasks;
+    TaskBatcher batcher(qvector, this->getTaskBatchSize(len, this->_numQueues));
+    uint64_t startChunk = 0;
+    uint64_t endChunk = 0;
+    auto enqueue = [&](uint64_t target, uint64_t chunk, int pinnedThread) {
+        endChunk += chunk;
+        auto *task = tasks.create(CompiledPipelineTaskData<Frame>{funcs.data(), isScalar, inputs, numInputs,
+                numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows, outCols, 0, ctx,
+                feedback.get(), target, pins.getNumCalls()}, dataSinks);
+        if(pinnedThread >= 0)
+            qvector[target]->enqueueTaskPinned(task, pinnedThread);
+        else
+            batcher.enqueue(target, task);
+        startChunk = endChunk;
+    };
+    const bool pinned = ctx->getUserConfig().pinWorkers;
+    if (this->prePartitionRows()) {
+        uint64_t oneChunk = len/this->_numQueues;
+        int remainder = len - (oneChunk * this->_numQueues);
+        for(int i=0; i<this->_numQueues; i++) {
+            LoadPartitioning lp(this->_scheme, i == 0 ? oneChunk + remainder : oneChunk, this->_minimumTaskSize,
+                    this->_numThreads, false, feedback.get());
+            while (lp.hasNextChunk())
+                enqueue(i, lp.getNextChunk(i), pinned ? this->topologyResponsibleThreads[i] : -1);
+        }
+    } else {
+        LoadPartitioning lp(this->_scheme, len, this->_minimumTaskSize, this->_numThreads, false, feedback.get());
+        for(uint64_t currentItr = 0; lp.hasNextChunk(); currentItr++) {
+            const uint64_t target = currentItr % this->_numQueues;
+            enqueue(target, lp.getNextChunk(target), pinned ? this->topologyUniqueThreads[target] : -1);
+        }
+    }
+    batcher.flush();
+    for(int i=0; i<this->_numQueues; i++) {
+        qvector[i]->closeInput();
+    }
+    if(this->_lockFreeQueues)
+        this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                this->pinWorkers());
+
+    this->joinAll();
+    consumeDataSinks(dataSinks, res, numOutputs);
+}
+
+std::vector<VectorizedDataSink<Frame> *> MTWrapper<Frame>::createDataSinks(size_t numOutputs, uint64_t len,
+        VectorCombine* combines) {
+    for(size_t i = 0; i < numOutputs; i++)
+        if(combines[i] != VectorCombine::ROWS)
+            throw std::runtime_error("vectorized pipelines over frames only support the row-wise combine");
+    std::vector<VectorizedDataSink<Frame> *> dataSinks;
+    for(size_t i = 0; i < numOutputs; i++)
+        dataSinks.push_back(new VectorizedDataSink<Frame>(combines[i], len));
+    return dataSinks;
+}
+
+void MTWrapper<Frame>::consumeDataSinks(std::vector<VectorizedDataSink<Frame> *>& dataSinks, Frame*** res,
+        size_t numOutputs) {
+    // copy the parts of the tasks on the (now idle) workers
+    auto parallelFor = [this](size_t n, const std::function<void(size_t)>& func) { this->parallelFor(n, func); };
+    for(size_t i = 0; i < numOutputs; i++) {
+        auto* combined = dataSinks[i]->consume(parallelFor);
+        if(*(res[i]) != nullptr)
+            DataObjectFactory::destroy(*(res[i]));
+        *(res[i]) = combined;
+        delete dataSinks[i];
+    }
+    dataSinks.clear();
+}
@@ -14,9 +14,65 @@
  * limitations under the License.
  */
 
+
 #include "MTWrapper.h"
 #include <runtime/local/vectorized/Tasks.h>
 
+#ifdef USE_CUDA
+#include <runtime/local/vectorized/HybridPartitioner.h>
+#endif
+
+template<typename VT>
+[[maybe_unused]] void MTWrapper<CSRMatrix<VT>>::executeSingleQueue(
+        std::vector<std::function<typename MTWrapper<CSRMatrix<VT>>::PipelineFunc>> funcs, CSRMatrix<VT> ***res,
+        const bool* isScalar, Structure **inputs, size_t numInputs, size_t numOutputs, const int64_t *outRows,
+        const int64_t *outCols, VectorSplit *splits, VectorCombine *combines, DCTX(ctx), const bool verbose) {
+    auto inputProps = this->getInputProperties(inputs, numInputs, splits);
+    auto len = inputProps.first;
+    auto mem_required = inputProps.second;
+    // the sparse outputs are not allocated up-front
+    auto row_mem = std::max<size_t>(1, mem_required / len);
+
+    // create task queue (w/o size-based blocking)
+    std::unique_ptr<TaskQueue> q = std::make_unique<BlockingTaskQueue>(this->getQueueCapacity(len, 1));
+    auto feedback = this->createChunkFeedback(1);
+
+    std::vector<TaskQueue*> tmp_q{q.get()};
+    auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
+    this->initCPPWorkers(tmp_q, batchSize8M, verbose, 1, 0, false);
+
+#ifdef USE_CUDA
+    // the CUDA kernels transfer the sparse inputs themselves, and the sparse results are returned in host memory,
+    // hence the GPU workers execute the same tasks as the CPU workers
+    if(this->_numCUDAThreads)
+        this->initCUDAWorkers(tmp_q, batchSize8M * 4, verbose);
+#endif
+
+    auto dataSinks = this->createDataSinks(res, numOutputs, outRows, outCols, combines);
+
+    // create tasks and close input
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    typename TaskArena<CompiledPipelineTask<CSRMatrix<VT>>>::Lease tasks;
+    TaskBatcher batcher(tmp_q, this->getTaskBatchSize(len, 1));
+    uint64_t startChunk = 0;
+    uint64_t endChunk = 0;
+    const size_t* rowCosts = ctx->getUserConfig().nnzBalancedPartitioning ?
+            getRowCosts(inputs, numInputs, splits, len) : nullptr;
+    LoadPartitioning lp = createPartitioning(rowCosts, 0, len, feedback.get(), ctx);
+    while (lp.hasNextChunk()) {
+        endChunk += lp.getNextChunk();
+        batcher.enqueue(0, tasks.create(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs.data(), isScalar, inputs,
+                numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows, outCols, 0,
+                ctx, feedback.get(), 0, pins.getNumCalls()}, dataSinks));
+        startChunk = endChunk;
+    }
+    batcher.flush();
+    q->closeInput();
+
+    this->joinAll();
+    consumeDataSinks(dataSinks, res, numOutputs);
+}
+
 template<typename VT>
 void MTWrapper<CSRMatrix<VT>>::executeCpuQueues(std::vector<std::function<void(CSRMatrix<VT> ***, Structure **,
         DCTX(ctx))>> funcs, CSRMatrix<VT> ***res, const bool* isScalar, Structure **inputs, size_t numInputs,
@@ -26,8 +82,8 @@ void MTWrapper<CSRMatrix<VT>>::executeCpuQueues(std::vector<std::function<void(C
     auto inputProps = this->getInputProperties(inputs, numInputs, splits);
     auto len = inputProps.first;
     auto mem_required = inputProps.second;
-    // TODO: sparse output mem requirements
-    auto row_mem = mem_required / len;
+    // the sparse outputs are not allocated up-front
+    auto row_mem = std::max<size_t>(1, mem_required / len);
 
     std::vector<std::unique_ptr<TaskQueue>> q;
     std::vector<TaskQueue*> qvector;
@@ -37,103 +93,306 @@ void MTWrapper<CSRMatrix<VT>>::executeCpuQueues(std::vector<std::function<void(C
             CPU_ZERO(&cpuset);
             CPU_SET(i, &cpuset);
             sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
-            std::unique_ptr<TaskQueue> tmp = std::make_unique<BlockingTaskQueue>(len);
+            std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(this->getQueueCapacity(len, this->_numQueues));
             q.push_back(std::move(tmp));
             qvector.push_back(q[i].get());
         }
     } else {
         for(int i=0; i<this->_numQueues; i++) {
-            std::unique_ptr<TaskQueue> tmp = std::make_unique<BlockingTaskQueue>(len);
+            std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(this->getQueueCapacity(len, this->_numQueues));
             q.push_back(std::move(tmp));
             qvector.push_back(q[i].get());
         }
     }
 
+    auto feedback = this->createChunkFeedback(this->_numQueues);
+
     auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
-    this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
-            ctx->getUserConfig().pinWorkers);
+    if(!this->_lockFreeQueues)
+        this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                this->pinWorkers());
 
-    for(size_t i = 0; i < numOutputs; i++)
-        if(*(res[i]) != nullptr)
-            throw std::runtime_error("TODO");
+    auto dataSinks = this->createDataSinks(res, numOutputs, outRows, outCols, combines);
 
-    std::vector<VectorizedDataSink<CSRMatrix<VT>> *> dataSinks(numOutputs);
-    for(size_t i = 0; i < numOutputs; i++)
-        dataSinks[i] = new VectorizedDataSink<CSRMatrix<VT>>(combines[i], outRows[i], outCols[i]);
-
-    // lock for aggregation combine
-    // TODO: multiple locks per output
     // create tasks and close input
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    typename TaskArena<CompiledPipelineTask<CSRMatrix<VT>>>::Lease tasks;
+    TaskBatcher batcher(qvector, this->getTaskBatchSize(len, this->_numQueues));
     uint64_t startChunk = 0;
     uint64_t endChunk = 0;
     uint64_t currentItr = 0;
     uint64_t target;
-    int method=ctx->config.taskPartitioningScheme;
-    int chunkParam = ctx->config.minimumTaskSize;
-    if(chunkParam<=0)
-        chunkParam=1;
-    if (ctx->getUserConfig().prePartitionRows) {
-        uint64_t oneChunk = len/this->_numQueues;
-        int remainder = len - (oneChunk * this->_numQueues);
+    const size_t* rowCosts = ctx->getUserConfig().nnzBalancedPartitioning ?
+            getRowCosts(inputs, numInputs, splits, len) : nullptr;
+    if (this->prePartitionRows()) {
+        // the row ranges of the queues
+        std::vector<uint64_t> bounds(this->_numQueues + 1, len);
+        bounds[0] = 0;
+        if(rowCosts) {
+            const size_t totalCost = rowCosts[len] - rowCosts[0];
+            for(int i=1; i<this->_numQueues; i++)
+                bounds[i] = std::lower_bound(rowCosts, rowCosts + len,
+                        rowCosts[0] + totalCost * i / this->_numQueues) - rowCosts;
+        } else {
+            uint64_t oneChunk = len/this->_numQueues;
+            int remainder = len - (oneChunk * this->_numQueues);
+            for(int i=1; i<this->_numQueues; i++)
+                bounds[i] = oneChunk * i + remainder;
+        }
         std::vector<LoadPartitioning> lps;
-        lps.emplace_back(method, oneChunk+remainder, chunkParam, this->_numThreads, false);
-        for(int i=1; i<this->_numQueues; i++) {
-            lps.emplace_back(method, oneChunk, chunkParam, this->_numThreads, false);
+        for(int i=0; i<this->_numQueues; i++) {
+            lps.push_back(createPartitioning(rowCosts, bounds[i], bounds[i + 1], feedback.get(), ctx));
         }
         if (ctx->getUserConfig().pinWorkers) {
             for(int i=0; i<this->_numQueues; i++) {
                 while (lps[i].hasNextChunk()) {
-                    endChunk += lps[i].getNextChunk();
-                    qvector[i]->enqueueTaskPinned(new CompiledPipelineTask<CSRMatrix<VT>>(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs, isScalar,
+                    endChunk += lps[i].getNextChunk(i);
+                    qvector[i]->enqueueTaskPinned(tasks.create(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs.data(), isScalar,
                             inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                            outCols, 0, ctx}, dataSinks), this->topologyResponsibleThreads[i]);
+                            outCols, 0, ctx, feedback.get(), static_cast<size_t>(i), pins.getNumCalls()}, dataSinks), this->topologyResponsibleThreads[i]);
                     startChunk = endChunk;
                 }
             }
         } else {
             for(int i=0; i<this->_numQueues; i++) {
                 while (lps[i].hasNextChunk()) {
-                    endChunk += lps[i].getNextChunk();
-                    qvector[i]->enqueueTask(new CompiledPipelineTask<CSRMatrix<VT>>(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs, isScalar,
+                    endChunk += lps[i].getNextChunk(i);
+                    batcher.enqueue(i, tasks.create(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs.data(), isScalar,
                             inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                            outCols, 0, ctx}, dataSinks));
+                            outCols, 0, ctx, feedback.get(), static_cast<size_t>(i), pins.getNumCalls()}, dataSinks));
                     startChunk = endChunk;
                 }
             }
         }
     } else {
-        LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false);
+        LoadPartitioning lp = createPartitioning(rowCosts, 0, len, feedback.get(), ctx);
         if (ctx->getUserConfig().pinWorkers) {
             while (lp.hasNextChunk()) {
-                endChunk += lp.getNextChunk();
                 target = currentItr % this->_numQueues;
-                qvector[target]->enqueueTaskPinned(new CompiledPipelineTask<CSRMatrix<VT>>(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs, isScalar,
+                endChunk += lp.getNextChunk(target);
+                qvector[target]->enqueueTaskPinned(tasks.create(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs.data(), isScalar,
                         inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                        outCols, 0, ctx}, dataSinks), target);
+                        outCols, 0, ctx, feedback.get(), target, pins.getNumCalls()}, dataSinks), target);
                 startChunk = endChunk;
 		currentItr++;
             }
         } else {
             while (lp.hasNextChunk()) {
-                endChunk += lp.getNextChunk();
                 target = currentItr % this->_numQueues;
-                qvector[target]->enqueueTask(new CompiledPipelineTask<CSRMatrix<VT>>(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs, isScalar,
+                endChunk += lp.getNextChunk(target);
+                batcher.enqueue(target, tasks.create(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs.data(), isScalar,
                         inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                        outCols, 0, ctx}, dataSinks));
+                        outCols, 0, ctx, feedback.get(), target, pins.getNumCalls()}, dataSinks));
                 startChunk = endChunk;
 		currentItr++;
             }
         }
     }
+    batcher.flush();
     for(int i=0; i<this->_numQueues; i++) {
         qvector[i]->closeInput();
     }
+    if(this->_lockFreeQueues)
+        this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                this->pinWorkers());
 
     this->joinAll();
+    consumeDataSinks(dataSinks, res, numOutputs);
+}
+
+template<typename VT>
+[[maybe_unused]] void MTWrapper<CSRMatrix<VT>>::executeQueuePerDeviceType(
+        std::vector<std::function<typename MTWrapper<CSRMatrix<VT>>::PipelineFunc>> funcs, CSRMatrix<VT> ***res,
+        const bool* isScalar, Structure **inputs, size_t numInputs, size_t numOutputs, int64_t *outRows, int64_t *outCols,
+        VectorSplit *splits, VectorCombine *combines, DCTX(ctx), bool verbose) {
+    auto inputProps = this->getInputProperties(inputs, numInputs, splits);
+    auto len = inputProps.first;
+    auto mem_required = inputProps.second;
+    // the sparse outputs are not allocated up-front
+    auto row_mem = std::max<size_t>(1, mem_required / len);
+    auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
+    BroadcastInputPins pins(inputs, isScalar, splits, numInputs, len);
+    const size_t* rowCosts = ctx->getUserConfig().nnzBalancedPartitioning ?
+            getRowCosts(inputs, numInputs, splits, len) : nullptr;
+
+    // Unlike for dense outputs, the GPU and CPU workers share the data sinks: the sparse results of the CUDA kernels
+    // are returned in host memory, and the parts of all tasks are stored by their first row or aggregated per worker
+    // thread anyway.
+    auto dataSinks = this->createDataSinks(res, numOutputs, outRows, outCols, combines);
+
+    // the CPU workers process (a part of) the rows [cpuBegin, len)
+    uint64_t cpuBegin = 0;
+    // the rows [cpuRangeBegin, cpuRangeEnd) are left for the CPU workers once the GPU workers got their part
+    uint64_t cpuRangeBegin = 0;
+    uint64_t cpuRangeEnd = len;
+#ifdef USE_CUDA
+    const size_t numDevices = this->_numCUDAThreads;
+
+    // the rows are split by the measured throughput of both device types, like for dense outputs
+    HybridPartitioner hybrid(len, this->_numCPPThreads, numDevices, batchSize8M * 4 * numDevices,
+            batchSize8M * this->_numCPPThreads, !this->_lockFreeQueues);
+    cpuBegin = hybrid.getGPUProfileEnd();
+    const uint64_t gpuMaxEnd = hybrid.getCPUProfileStart();
+    cpuRangeEnd = hybrid.isProfiling() ? gpuMaxEnd : len;
+
+    // one worker and queue per device, which gets one task of the profiling range and one of the remaining rows
+    std::vector<std::unique_ptr<TaskQueue>> q_cuda;
+    std::vector<TaskQueue*> qvector_cuda;
+    for(size_t d = 0; d < numDevices; ++d) {
+        q_cuda.push_back(std::make_unique<BlockingTaskQueue>(2));
+        qvector_cuda.push_back(q_cuda.back().get());
+    }
+    this->initCUDAWorkers(qvector_cuda, batchSize8M * 4, verbose);
+
+    // the rows are split evenly between the devices
+    auto enqueueCudaTasks = [&](uint64_t begin, uint64_t end) {
+        if(begin >= end)
+            return;
+        const uint64_t blksize = (end - begin + numDevices - 1) / numDevices;
+        for (size_t d = 0; d < numDevices && begin + d * blksize < end; ++d) {
+            const uint64_t k = begin + d * blksize;
+            q_cuda[d]->enqueueTask(new CompiledPipelineTask<CSRMatrix<VT>>(CompiledPipelineTaskData<CSRMatrix<VT>>{
+                    funcs.data(), isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, k,
+                    std::min(k + blksize, end), outRows, outCols, 0, ctx, hybrid.getFeedback(),
+                    HybridPartitioner::GPU_SLOT, pins.getNumCalls()}, dataSinks));
+        }
+    };
+    enqueueCudaTasks(0, cpuBegin);
+#endif
+
+    auto cpu_task_len = len - cpuBegin;
+    typename TaskArena<CompiledPipelineTask<CSRMatrix<VT>>>::Lease tasks;
+    std::vector<std::unique_ptr<TaskQueue>> q;
+    std::vector<TaskQueue*> qvector;
+    if(cpu_task_len > 0) {
+        if (ctx->getUserConfig().pinWorkers) {
+            for(int i=0; i<this->_numQueues; i++) {
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                CPU_SET(i, &cpuset);
+                sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+                std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(cpu_task_len);
+                q.push_back(std::move(tmp));
+                qvector.push_back(q[i].get());
+            }
+        } else {
+            for(int i=0; i<this->_numQueues; i++) {
+                std::unique_ptr<TaskQueue> tmp = this->createTaskQueue(cpu_task_len);
+                q.push_back(std::move(tmp));
+                qvector.push_back(q[i].get());
+            }
+        }
+        if(!this->_lockFreeQueues)
+            this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                    ctx->getUserConfig().pinWorkers);
+    }
+    TaskBatcher batcher(qvector, this->TASK_BATCH_SIZE);
+    uint64_t currentItr = 0;
+    auto enqueueCpuTask = [&](uint64_t startChunk, uint64_t endChunk, ChunkFeedback* feedback) {
+        const auto target = currentItr++ % this->_numQueues;
+        batcher.enqueue(target, tasks.create(CompiledPipelineTaskData<CSRMatrix<VT>>{
+                funcs.data(), isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk,
+                endChunk, outRows, outCols, 0, ctx, feedback, 0, pins.getNumCalls()}, dataSinks));
+    };
+
+#ifdef USE_CUDA
+    if(hybrid.isProfiling()) {
+        // one task per CPU worker for the profiling range
+        const uint64_t profileLen = len - gpuMaxEnd;
+        for(uint64_t w = 0; w < this->_numCPPThreads; w++) {
+            const uint64_t startChunk = gpuMaxEnd + profileLen * w / this->_numCPPThreads;
+            const uint64_t endChunk = gpuMaxEnd + profileLen * (w + 1) / this->_numCPPThreads;
+            if(startChunk < endChunk)
+                enqueueCpuTask(startChunk, endChunk, hybrid.getFeedback());
+        }
+        batcher.flush();
+    }
+    cpuRangeBegin = hybrid.split();
+    enqueueCudaTasks(cpuBegin, cpuRangeBegin);
+    for(auto& q_dev : q_cuda)
+        q_dev->closeInput();
+#endif
+
+    if(cpuRangeBegin < cpuRangeEnd) {
+        uint64_t startChunk = cpuRangeBegin;
+        uint64_t endChunk = cpuRangeBegin;
+        LoadPartitioning lp = createPartitioning(rowCosts, cpuRangeBegin, cpuRangeEnd, nullptr, ctx);
+        while (lp.hasNextChunk()) {
+            endChunk += lp.getNextChunk();
+            enqueueCpuTask(startChunk, endChunk, nullptr);
+            startChunk = endChunk;
+        }
+    }
+    if(cpu_task_len > 0) {
+        batcher.flush();
+        for(int i=0; i<this->_numQueues; i++) {
+            qvector[i]->closeInput();
+        }
+        if(this->_lockFreeQueues)
+            this->initCPPWorkers(qvector, batchSize8M, verbose, this->_numQueues, this->_queueMode,
+                    ctx->getUserConfig().pinWorkers);
+    }
+    this->joinAll();
+    consumeDataSinks(dataSinks, res, numOutputs);
+}
+
+template<typename VT>
+const size_t* MTWrapper<CSRMatrix<VT>>::getRowCosts(Structure** inputs, size_t numInputs, VectorSplit* splits,
+        uint64_t len) {
+    // the row-split CSR input with the most non-zeros dominates the cost of a row
+    const CSRMatrix<VT>* costInput = nullptr;
+    for(size_t i = 0; i < numInputs; i++) {
+        if(splits[i] != VectorSplit::ROWS || inputs[i]->getNumRows() != len)
+            continue;
+        if(auto csr = dynamic_cast<const CSRMatrix<VT>*>(inputs[i]))
+            if(!costInput || csr->getNumNonZeros() > costInput->getNumNonZeros())
+                costInput = csr;
+    }
+    if(!costInput || costInput->getNumNonZeros() == 0)
+        return nullptr;
+    return costInput->getRowOffsets();
+}
+
+template<typename VT>
+LoadPartitioning MTWrapper<CSRMatrix<VT>>::createPartitioning(const size_t* rowCosts, uint64_t rowBegin,
+        uint64_t rowEnd, ChunkFeedback* feedback, DCTX(ctx)) const {
+    int method=ctx->config.taskPartitioningScheme;
+    int chunkParam = ctx->config.minimumTaskSize;
+    if(chunkParam<=0)
+        chunkParam=1;
+    if(rowCosts)
+        return LoadPartitioning(method, rowCosts, rowBegin, rowEnd, chunkParam, this->_numThreads, false, feedback);
+    return LoadPartitioning(method, rowEnd - rowBegin, chunkParam, this->_numThreads, false, feedback);
+}
+
+template<typename VT>
+std::vector<VectorizedDataSink<CSRMatrix<VT>> *> MTWrapper<CSRMatrix<VT>>::createDataSinks(CSRMatrix<VT>*** res,
+        size_t numOutputs, const int64_t* outRows, const int64_t* outCols, VectorCombine* combines) {
+    std::vector<VectorizedDataSink<CSRMatrix<VT>> *> dataSinks(numOutputs);
     for(size_t i = 0; i < numOutputs; i++) {
-        *(res[i]) = dataSinks[i]->consume();
+        if(isAggCombine(combines[i])) {
+            dataSinks[i] = new VectorizedDataSink<CSRMatrix<VT>>(combines[i], *(res[i]), this->_numThreads);
+            *(res[i]) = nullptr;
+        }
+        else
+            dataSinks[i] = new VectorizedDataSink<CSRMatrix<VT>>(combines[i], outRows[i], outCols[i], true);
+    }
+    return dataSinks;
+}
+
+template<typename VT>
+void MTWrapper<CSRMatrix<VT>>::consumeDataSinks(std::vector<VectorizedDataSink<CSRMatrix<VT>> *>& dataSinks,
+        CSRMatrix<VT>*** res, size_t numOutputs) {
+    // merge the parts of the tasks on the (now idle) workers
+    auto parallelFor = [this](size_t n, const std::function<void(size_t)>& func) { this->parallelFor(n, func); };
+    for(size_t i = 0; i < numOutputs; i++) {
+        auto* combined = dataSinks[i]->consume(parallelFor);
+        if(*(res[i]) != nullptr)
+            DataObjectFactory::destroy(*(res[i]));
+        *(res[i]) = combined;
         delete dataSinks[i];
     }
+    dataSinks.clear();
 }
 
 template class MTWrapper<CSRMatrix<double>>;
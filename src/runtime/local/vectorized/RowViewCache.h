@@ -0,0 +1,122 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Structure.h>
+
+#include <vector>
+
+/**
+ * @brief Keeps one row view per pipeline input for the worker thread, which is moved to the next row range of the
+ * input (`Structure::rebindRowView()`) instead of allocating a new view by `sliceRow()` for every batch.
+ *
+ * A view can only be reused if the pipeline did not keep a reference to it (e.g., by returning it as its result);
+ * otherwise, the cache releases its own reference and creates a new view. At the end of a lease, the views drop their
+ * references to the viewed data, such that the cache does not keep inputs alive beyond the pipeline.
+ */
+class RowViewCache {
+    // the view of the i-th input, owned by the cache
+    std::vector<Structure*> _views;
+    bool _leased = false;
+
+    // returns the cache of the calling thread, or nullptr if it is already leased
+    static RowViewCache* acquire() {
+        thread_local RowViewCache cache;
+        if(cache._leased)
+            return nullptr;
+        cache._leased = true;
+        return &cache;
+    }
+
+    void dropView(Structure*& view) {
+        DataObjectFactory::destroy(view);
+        view = nullptr;
+    }
+
+public:
+    RowViewCache() = default;
+    RowViewCache(const RowViewCache&) = delete;
+    RowViewCache& operator=(const RowViewCache&) = delete;
+    ~RowViewCache() {
+        for(auto& view : _views)
+            if(view)
+                dropView(view);
+    }
+
+    /**
+     * @brief Returns a view on the rows `rl` to `ru` of `src` as the `i`-th input of a pipeline function.
+     *
+     * The returned view carries one reference for the pipeline function, which releases its inputs itself.
+     */
+    Structure* getRowView(size_t i, const Structure* src, size_t rl, size_t ru) {
+        if(i >= _views.size())
+            _views.resize(i + 1, nullptr);
+        Structure*& view = _views[i];
+        if(view && (view->getRefCounter() != 1 || !view->rebindRowView(src, rl, ru)))
+            dropView(view);
+        if(!view)
+            view = src->sliceRow(rl, ru);
+        view->increaseRefCounter();
+        return view;
+    }
+
+    /**
+     * @brief Lets all views drop the data they refer to, keeping the view objects for later reuse.
+     */
+    void release() {
+        for(auto& view : _views)
+            if(view && (view->getRefCounter() != 1 || !view->rebindRowView(nullptr, 0, 0)))
+                dropView(view);
+    }
+
+    [[nodiscard]] size_t getNumViews() const {
+        size_t res = 0;
+        for(auto view : _views)
+            res += view != nullptr;
+        return res;
+    }
+
+    /**
+     * @brief Grants one task exclusive use of the cache of the calling thread and releases the views at the end of
+     * the scope.
+     *
+     * If the cache of the thread is already leased (e.g., by a task starting a nested pipeline), every view is
+     * created by `sliceRow()`.
+     */
+    class Lease {
+        RowViewCache* _cache;
+    public:
+        Lease() : _cache(acquire()) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() {
+            if(_cache) {
+                _cache->release();
+                _cache->_leased = false;
+            }
+        }
+
+        Structure* getRowView(size_t i, const Structure* src, size_t rl, size_t ru) {
+            if(_cache)
+                return _cache->getRowView(i, src, rl, ru);
+            return src->sliceRow(rl, ru);
+        }
+
+        [[nodiscard]] RowViewCache* getCache() const { return _cache; }
+    };
+};
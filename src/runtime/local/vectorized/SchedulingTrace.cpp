@@ -0,0 +1,231 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/SchedulingTrace.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+
+#include <cstdlib>
+
+#include <unistd.h>
+
+struct SchedulingTrace::ThreadRing {
+    std::vector<Event> events;
+    // all events recorded so far, of which the last RING_CAPACITY ones are kept
+    uint64_t numRecorded = 0;
+};
+
+double SchedulingTrace::PipelineStats::getImbalance() const {
+    if(workers.empty())
+        return 1;
+    uint64_t maxBusy = 0;
+    uint64_t sumBusy = 0;
+    for(auto & w : workers) {
+        maxBusy = std::max(maxBusy, w.busyTicks);
+        sumBusy += w.busyTicks;
+    }
+    return sumBusy ? static_cast<double>(maxBusy) * workers.size() / sumBusy : 1;
+}
+
+double SchedulingTrace::PipelineStats::getIdleFraction() const {
+    const uint64_t span = end - begin;
+    if(workers.empty() || !span)
+        return 0;
+    uint64_t sumBusy = 0;
+    for(auto & w : workers)
+        sumBusy += w.busyTicks;
+    return std::max(0.0, 1 - static_cast<double>(sumBusy) / (static_cast<double>(span) * workers.size()));
+}
+
+void SchedulingTrace::PipelineStats::print(std::ostream & os, double ticksPerNano) const {
+    size_t numTasks = 0;
+    size_t numStolen = 0;
+    size_t numFailedSteals = 0;
+    uint64_t waitTicks = 0;
+    uint64_t firstDone = end;
+    uint64_t lastDone = begin;
+    for(auto & w : workers) {
+        numTasks += w.numTasks;
+        numStolen += w.numStolen;
+        numFailedSteals += w.numFailedSteals;
+        waitTicks += w.waitTicks;
+        if(w.numTasks) {
+            firstDone = std::min(firstDone, w.lastEnd);
+            lastDone = std::max(lastDone, w.lastEnd);
+        }
+    }
+    auto ms = [ticksPerNano](uint64_t ticks) { return ticks / ticksPerNano / 1e6; };
+    const std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3) << "Vectorized pipeline " << id << ": " << workers.size()
+            << " workers, " << ms(end - begin) << " ms, " << numTasks << " tasks (" << numStolen << " stolen, "
+            << numFailedSteals << " failed steals), busy max/mean " << std::setprecision(2) << getImbalance()
+            << ", idle " << std::setprecision(1) << (100 * getIdleFraction()) << "%, blocked "
+            << std::setprecision(3) << ms(waitTicks) << " ms, finish spread "
+            << ms(lastDone > firstDone ? lastDone - firstDone : 0) << " ms" << std::endl;
+    os.flags(flags);
+}
+
+SchedulingTrace::SchedulingTrace() : epochTicks(now()), epochTime(std::chrono::steady_clock::now()) {}
+
+SchedulingTrace::~SchedulingTrace() = default;
+
+SchedulingTrace & SchedulingTrace::get() {
+    // lives until the process ends, such that the trace can be written at its end
+    static SchedulingTrace * trace = new SchedulingTrace();
+    return *trace;
+}
+
+SchedulingTrace::ThreadRing & SchedulingTrace::getThreadRing() {
+    static thread_local ThreadRing * ring = nullptr;
+    if(!ring) {
+        std::lock_guard<std::mutex> lock(mtx);
+        rings.push_back(std::make_unique<ThreadRing>());
+        ring = rings.back().get();
+        ring->events.resize(RING_CAPACITY);
+    }
+    return *ring;
+}
+
+void SchedulingTrace::enable(const std::string & file) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        traceFile = file;
+    }
+    enabled = true;
+    static std::once_flag registered;
+    std::call_once(registered, []() {
+        std::atexit([]() {
+            SchedulingTrace & trace = SchedulingTrace::get();
+            std::ofstream ofs(trace.traceFile);
+            trace.writeChromeTrace(ofs);
+            if(!ofs)
+                std::cerr << "SchedulingTrace: cannot write the trace to " << trace.traceFile << std::endl;
+        });
+    });
+}
+
+uint32_t SchedulingTrace::beginPipeline(size_t numWorkers) {
+    const uint64_t begin = now();
+    std::lock_guard<std::mutex> lock(mtx);
+    pipelines.push_back({++lastPipeline, numWorkers, begin, 0, {}});
+    return lastPipeline;
+}
+
+void SchedulingTrace::record(const Event & event) {
+    ThreadRing & ring = getThreadRing();
+    ring.events[ring.numRecorded % RING_CAPACITY] = event;
+    ring.numRecorded++;
+}
+
+void SchedulingTrace::addWorkerStats(uint32_t pipeline, const WorkerStats & stats) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for(auto it = pipelines.rbegin(); it != pipelines.rend(); ++it)
+        if(it->id == pipeline) {
+            it->workers.push_back(stats);
+            return;
+        }
+}
+
+SchedulingTrace::PipelineStats SchedulingTrace::endPipeline(uint32_t pipeline, std::ostream & os) {
+    const uint64_t end = now();
+    PipelineStats stats{};
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for(auto it = pipelines.rbegin(); it != pipelines.rend(); ++it)
+            if(it->id == pipeline) {
+                it->end = end;
+                std::sort(it->workers.begin(), it->workers.end(), [](const auto & a, const auto & b) {
+                    return a.worker < b.worker;
+                });
+                stats = *it;
+                break;
+            }
+    }
+    stats.print(os, getTicksPerNano());
+    return stats;
+}
+
+double SchedulingTrace::getTicksPerNano() const {
+#if defined(__x86_64__) || defined(__i386__)
+    const uint64_t ticks = now() - epochTicks;
+    const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epochTime).count();
+    return nanos > 0 && ticks > 0 ? static_cast<double>(ticks) / nanos : 1;
+#else
+    return 1;
+#endif
+}
+
+void SchedulingTrace::writeChromeTrace(std::ostream & os) const {
+    const double ticksPerNano = getTicksPerNano();
+    const auto pid = getpid();
+    std::lock_guard<std::mutex> lock(mtx);
+    // the time stamps and durations are in microseconds, the pipelines are shown as thread 0, and the workers as
+    // the threads from 1 on
+    auto us = [&](uint64_t ticks) { return ticks / ticksPerNano / 1e3; };
+    auto ts = [&](uint64_t ticks) { return us(ticks - std::min(ticks, epochTicks)); };
+
+    const std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    os << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+            << ", \"tid\": 0, \"args\": {\"name\": \"pipelines\"}}";
+    std::set<int32_t> workers;
+    for(auto & p : pipelines) {
+        if(!p.end)
+            continue;
+        os << ",\n{\"name\": \"pipeline " << p.id << "\", \"cat\": \"pipeline\", \"ph\": \"X\", \"ts\": "
+                << ts(p.begin) << ", \"dur\": " << us(p.end - p.begin) << ", \"pid\": " << pid
+                << ", \"tid\": 0, \"args\": {\"workers\": " << p.workers.size()
+                << ", \"imbalance\": " << p.getImbalance() << ", \"idleFraction\": " << p.getIdleFraction() << "}}";
+    }
+    size_t numOverwritten = 0;
+    for(auto & ring : rings) {
+        const uint64_t numKept = std::min<uint64_t>(ring->numRecorded, RING_CAPACITY);
+        numOverwritten += ring->numRecorded - numKept;
+        for(uint64_t i = ring->numRecorded - numKept; i < ring->numRecorded; i++) {
+            const Event & e = ring->events[i % RING_CAPACITY];
+            workers.insert(e.worker);
+            const int32_t tid = e.worker + 1;
+            if(e.type == EventType::FAILED_STEAL) {
+                os << ",\n{\"name\": \"failed steal\", \"cat\": \"steal\", \"ph\": \"i\", \"s\": \"t\", \"ts\": "
+                        << ts(e.begin) << ", \"pid\": " << pid << ", \"tid\": " << tid
+                        << ", \"args\": {\"pipeline\": " << e.pipeline << ", \"queue\": " << e.queue << "}}";
+                continue;
+            }
+            const char * name = e.type == EventType::TASK ? "task"
+                    : e.type == EventType::STOLEN_TASK ? "stolen task" : "wait";
+            os << ",\n{\"name\": \"" << name << "\", \"cat\": \"" << (e.type == EventType::WAIT ? "wait" : "task")
+                    << "\", \"ph\": \"X\", \"ts\": " << ts(e.begin) << ", \"dur\": " << us(e.end - e.begin)
+                    << ", \"pid\": " << pid << ", \"tid\": " << tid << ", \"args\": {\"pipeline\": " << e.pipeline
+                    << ", \"queue\": " << e.queue;
+            if(e.type != EventType::WAIT)
+                os << ", \"rows\": " << e.size;
+            os << "}}";
+        }
+    }
+    for(int32_t w : workers)
+        os << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << (w + 1)
+                << ", \"args\": {\"name\": \"worker " << w << "\"}}";
+    os << "\n]}" << std::endl;
+    os.flags(flags);
+    if(numOverwritten)
+        std::cerr << "SchedulingTrace: the trace lacks the " << numOverwritten << " oldest events, the ring buffer of "
+                "a thread holds " << RING_CAPACITY << " events" << std::endl;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Records what the workers of the vectorized pipelines do, in order to tune the partitioning, the queue
+ * layout, and the victim selection.
+ *
+ * The workers (see WorkerCPU and WorkerGPU) record their tasks (with the number of rows and the queue they came
+ * from), their successful and failed steals, and the time they were blocked in `dequeueTask()` as events in a ring
+ * buffer of their thread, which is written without synchronization and stamped with the time-stamp counter of the
+ * CPU. Once a pipeline has finished, its summary (see `PipelineStats`) is printed, and at the end of the process, the
+ * events are written as a Chrome trace, which chrome://tracing and Perfetto display.
+ */
+class SchedulingTrace {
+public:
+    static constexpr size_t RING_CAPACITY = size_t(1) << 16;
+
+    enum class EventType : uint8_t {
+        TASK,
+        STOLEN_TASK,
+        FAILED_STEAL,
+        WAIT
+    };
+
+    struct Event {
+        // time-stamp counter ticks, see now()
+        uint64_t begin;
+        uint64_t end;
+        // the rows of a task
+        uint64_t size;
+        uint32_t pipeline;
+        int32_t worker;
+        int32_t queue;
+        EventType type;
+    };
+
+    // what a worker did in a pipeline, summed up by the worker itself
+    struct WorkerStats {
+        int32_t worker = 0;
+        uint64_t busyTicks = 0;
+        uint64_t waitTicks = 0;
+        uint64_t lastEnd = 0;
+        size_t numTasks = 0;
+        size_t numStolen = 0;
+        size_t numFailedSteals = 0;
+        uint64_t numRows = 0;
+    };
+
+    struct PipelineStats {
+        uint32_t id;
+        size_t numWorkers;
+        uint64_t begin;
+        uint64_t end;
+        std::vector<WorkerStats> workers;
+
+        // the maximum busy time of a worker divided by the mean, 1 if perfectly balanced
+        double getImbalance() const;
+        // the fraction of the time of the workers in the pipeline they did not execute tasks
+        double getIdleFraction() const;
+
+        void print(std::ostream & os, double ticksPerNano) const;
+    };
+
+private:
+    struct ThreadRing;
+
+    std::atomic<bool> enabled{false};
+    std::string traceFile;
+    const uint64_t epochTicks;
+    const std::chrono::steady_clock::time_point epochTime;
+
+    mutable std::mutex mtx;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::vector<PipelineStats> pipelines;
+    uint32_t lastPipeline = 0;
+
+    SchedulingTrace();
+
+    ThreadRing & getThreadRing();
+
+public:
+    SchedulingTrace(const SchedulingTrace &) = delete;
+    SchedulingTrace & operator=(const SchedulingTrace &) = delete;
+    ~SchedulingTrace();
+
+    static SchedulingTrace & get();
+
+    /**
+     * @brief The current value of the time-stamp counter, or of the steady clock in nanoseconds on CPUs without one.
+     */
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /**
+     * @brief Starts recording the vectorized pipelines, whose events are written to the given file at the end of the
+     * process.
+     */
+    void enable(const std::string & traceFile);
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Starts a pipeline of the given number of workers, returning its id for the events (never 0).
+     */
+    uint32_t beginPipeline(size_t numWorkers);
+
+    /**
+     * @brief Records an event in the ring buffer of the calling thread.
+     */
+    void record(const Event & event);
+
+    /**
+     * @brief Adds what a worker did in a pipeline, when it is done with it.
+     */
+    void addWorkerStats(uint32_t pipeline, const WorkerStats & stats);
+
+    /**
+     * @brief Ends a pipeline once all its workers are done, printing its summary to the given stream.
+     */
+    PipelineStats endPipeline(uint32_t pipeline, std::ostream & os);
+
+    /**
+     * @brief Returns the time-stamp counter ticks per nanosecond, measured since the creation of the trace.
+     */
+    double getTicksPerNano() const;
+
+    /**
+     * @brief Writes the recorded events and pipelines in the Chrome trace format. Must only be called while no
+     * pipeline is running.
+     */
+    void writeChromeTrace(std::ostream & os) const;
+};
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include <cstdint>
+
+template<class TaskT> class TaskArena;
+
+class Task {
+    template<class TaskT> friend class TaskArena;
+    // tasks created in a TaskArena are destroyed with the arena
+    bool _inArena = false;
+
+public:
+    virtual ~Task() = default;
+
+    virtual void execute(uint32_t fid, uint32_t batchSize) = 0;
+    virtual uint64_t getTaskSize() = 0;
+
+    // called by the worker instead of execute() once the run was cancelled (see RunControl)
+    virtual void skip() {}
+
+    // called by the worker once the task was executed
+    void release() {
+        if(!_inArena)
+            delete this;
+    }
+};
+
+// task for signaling closed input queue (no more tasks)
+class EOFTask : public Task {
+public:
+    EOFTask() = default;
+    ~EOFTask() override = default;
+    void execute(uint32_t fid, uint32_t batchSize) override {}
+    uint64_t getTaskSize() override {return 0;}
+};
+
+// task executing an arbitrary function, e.g., one part of combining the results of a pipeline
+class FunctionTask : public Task {
+    std::function<void()> _func;
+public:
+    explicit FunctionTask(std::function<void()> func) : _func(std::move(func)) {}
+    ~FunctionTask() override = default;
+    void execute(uint32_t fid, uint32_t batchSize) override { _func(); }
+    uint64_t getTaskSize() override {return 1;}
+};
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/vectorized/Tasks.h>
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Provides the memory of the tasks of vectorized pipelines in chunks, which are reused across pipelines.
+ *
+ * The tasks of a pipeline are created by the single thread filling its task queues, while the workers only mark
+ * them as done via `Task::release()`. Once all workers have finished, `reset()` destroys all tasks at once and keeps
+ * the chunks for the next pipeline. Hence, creating a task is a placement new into the current chunk instead of a
+ * heap allocation, and the workers do not free any memory.
+ */
+template<class TaskT>
+class TaskArena {
+    static constexpr size_t CHUNK_SIZE = 1024;
+    // the number of chunks kept by reset(), such that a single pipeline with very many tasks does not pin its
+    // memory until the end of the thread
+    static constexpr size_t MAX_RETAINED_CHUNKS = 64;
+
+    struct Slot {
+        alignas(TaskT) unsigned char bytes[sizeof(TaskT)];
+    };
+    std::vector<std::unique_ptr<Slot[]>> _chunks;
+    size_t _numTasks = 0;
+    bool _leased = false;
+
+    TaskT* getTask(size_t i) {
+        return std::launder(reinterpret_cast<TaskT*>(_chunks[i / CHUNK_SIZE][i % CHUNK_SIZE].bytes));
+    }
+
+    // returns the arena of the calling thread, or nullptr if it is already leased
+    static TaskArena* acquire() {
+        thread_local TaskArena arena;
+        if(arena._leased)
+            return nullptr;
+        arena._leased = true;
+        return &arena;
+    }
+
+public:
+    TaskArena() = default;
+    TaskArena(const TaskArena&) = delete;
+    TaskArena& operator=(const TaskArena&) = delete;
+    ~TaskArena() { reset(); }
+
+    template<typename... Args>
+    TaskT* create(Args&&... args) {
+        const size_t chunk = _numTasks / CHUNK_SIZE;
+        if(chunk == _chunks.size())
+            _chunks.emplace_back(new Slot[CHUNK_SIZE]);
+        auto* task = new (_chunks[chunk][_numTasks % CHUNK_SIZE].bytes) TaskT(std::forward<Args>(args)...);
+        task->_inArena = true;
+        _numTasks++;
+        return task;
+    }
+
+    /**
+     * @brief Destroys all tasks created so far. Must only be called once no worker accesses them anymore.
+     */
+    void reset() {
+        for(size_t i = 0; i < _numTasks; i++)
+            getTask(i)->~TaskT();
+        _numTasks = 0;
+        if(_chunks.size() > MAX_RETAINED_CHUNKS)
+            _chunks.resize(MAX_RETAINED_CHUNKS);
+    }
+
+    [[nodiscard]] size_t getNumTasks() const { return _numTasks; }
+    [[nodiscard]] size_t getNumChunks() const { return _chunks.size(); }
+
+    /**
+     * @brief Grants the tasks of one pipeline exclusive use of the arena of the calling thread and resets it at the
+     * end of the scope, i.e., the lease must outlive the workers processing its tasks.
+     *
+     * If the arena of the thread is already leased, the tasks are allocated on the heap (and deleted by the workers).
+     */
+    class Lease {
+        TaskArena* _arena;
+    public:
+        Lease() : _arena(acquire()) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() {
+            if(_arena) {
+                _arena->reset();
+                _arena->_leased = false;
+            }
+        }
+
+        template<typename... Args>
+        TaskT* create(Args&&... args) {
+            if(_arena)
+                return _arena->create(std::forward<Args>(args)...);
+            return new TaskT(std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]] TaskArena* getArena() const { return _arena; }
+    };
+};
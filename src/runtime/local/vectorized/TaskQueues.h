@@ -17,12 +17,18 @@
 #ifndef SRC_RUNTIME_LOCAL_VECTORIZED_TASKQUEUES_H
 #define SRC_RUNTIME_LOCAL_VECTORIZED_TASKQUEUES_H
 
+#include <algorithm>
+#include <atomic>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
-#include <runtime/local/vectorized/Tasks.h>
+#include <thread>
+#include <vector>
+#include <runtime/local/vectorized/Task.h>
 
 const uint64_t DEFAULT_MAX_SIZE = 100000;
+const uint64_t DEFAULT_DEQUE_INIT_SIZE = 1024;
 
 class TaskQueue {
 public:
@@ -30,7 +36,20 @@ public:
 
     virtual void enqueueTask(Task* t) = 0;
     virtual void enqueueTaskPinned(Task* t, int targetCPU) = 0;
+    /**
+     * @brief Enqueues several tasks in their order, which queues with a lock may do with one lock acquisition.
+     */
+    virtual void enqueueTasks(Task* const* tasks, size_t numTasks) {
+        for(size_t i = 0; i < numTasks; i++)
+            enqueueTask(tasks[i]);
+    }
     virtual Task* dequeueTask() = 0;
+    /**
+     * @brief Takes a task on behalf of another worker than the owner of this queue.
+     *
+     * Queues without a separate steal end simply fall back to `dequeueTask()`.
+     */
+    virtual Task* stealTask() { return dequeueTask(); }
     virtual uint64_t size() = 0;
     virtual void closeInput() = 0;
 };
@@ -64,6 +83,19 @@ public:
         _cv.notify_one();
     }
 
+    void enqueueTasks(Task* const* tasks, size_t numTasks) override {
+        std::unique_lock<std::mutex> ul(_qmutex);
+        size_t i = 0;
+        while( i < numTasks ) {
+            // blocking wait until tasks dequeued, then add as many tasks as fit
+            while( _data.size() + 1 > _capacity )
+                _cv.wait(ul);
+            while( i < numTasks && _data.size() < _capacity )
+                _data.push_back(tasks[i++]);
+            _cv.notify_all();
+        }
+    }
+
     void enqueueTaskPinned(Task* t, int targetCPU) override {
         // Change CPU pinning before enqueue to utilize NUMA first-touch policy
         cpu_set_t cpuset;
@@ -106,4 +138,182 @@ public:
     }
 };
 
+/**
+ * @brief A lock-free work-stealing deque following Chase and Lev ("Dynamic Circular Work-Stealing Deque", SPAA 2005)
+ * with the memory orderings of Le et al. ("Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013).
+ *
+ * The owner of the deque pushes and pops tasks at the bottom end (`enqueueTask()`, `dequeueTask()`), while any other
+ * worker may concurrently steal tasks from the top end (`stealTask()`). Only the owner side is allowed to enqueue, so
+ * the vectorized engine fills these deques before it starts the workers; the thread start then hands the ownership
+ * of the bottom end over to the worker. Unlike `BlockingTaskQueue`, the capacity is only the initial size hint of the
+ * circular buffer, which grows on demand instead of blocking.
+ */
+class WorkStealingDeque : public TaskQueue {
+private:
+    class CircularArray {
+        int64_t _mask;
+        std::unique_ptr<std::atomic<Task*>[]> _items;
+    public:
+        explicit CircularArray(int64_t capacity) : _mask(capacity - 1), _items(new std::atomic<Task*>[capacity]) {}
+
+        [[nodiscard]] int64_t capacity() const { return _mask + 1; }
+
+        Task* get(int64_t i) const { return _items[i & _mask].load(std::memory_order_relaxed); }
+
+        void put(int64_t i, Task* t) { _items[i & _mask].store(t, std::memory_order_relaxed); }
+
+        CircularArray* grow(int64_t bottom, int64_t top) const {
+            auto* larger = new CircularArray(2 * capacity());
+            for(int64_t i = top; i < bottom; i++)
+                larger->put(i, get(i));
+            return larger;
+        }
+    };
+
+    // top and bottom are kept on separate cache lines, since thieves hammer on top while the owner works on bottom
+    alignas(64) std::atomic<int64_t> _top;
+    alignas(64) std::atomic<int64_t> _bottom;
+    alignas(64) std::atomic<CircularArray*> _array;
+    // arrays replaced by grow() may still be read by concurrent thieves, so they are only freed with the deque
+    std::vector<std::unique_ptr<CircularArray>> _retired;
+    std::atomic<bool> _closedInput;
+    EOFTask _eof; //end marker
+
+    static int64_t roundUpPow2(uint64_t capacity) {
+        int64_t res = 1;
+        while(static_cast<uint64_t>(res) < capacity)
+            res <<= 1;
+        return res;
+    }
+
+    // returns nullptr if the deque is empty
+    Task* tryPop() {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        CircularArray* a = _array.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        Task* task = nullptr;
+        if(t <= b) {
+            task = a->get(b);
+            if(t == b) {
+                // last element, race against thieves
+                if(!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    task = nullptr;
+                _bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        return task;
+    }
+
+public:
+    WorkStealingDeque() : WorkStealingDeque(DEFAULT_DEQUE_INIT_SIZE) {}
+    explicit WorkStealingDeque(uint64_t capacity) : _top(0), _bottom(0), _closedInput(false) {
+        _retired.emplace_back(new CircularArray(roundUpPow2(std::max(std::min(capacity, DEFAULT_DEQUE_INIT_SIZE),
+                uint64_t(1)))));
+        _array.store(_retired.back().get(), std::memory_order_relaxed);
+    }
+    ~WorkStealingDeque() override = default;
+
+    void enqueueTask(Task* t) override {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t tp = _top.load(std::memory_order_acquire);
+        CircularArray* a = _array.load(std::memory_order_relaxed);
+        if(b - tp > a->capacity() - 1) {
+            a = a->grow(b, tp);
+            _retired.emplace_back(a);
+            _array.store(a, std::memory_order_release);
+        }
+        a->put(b, t);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    void enqueueTaskPinned(Task* t, int targetCPU) override {
+        // Change CPU pinning before enqueue to utilize NUMA first-touch policy
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(targetCPU, &cpuset);
+        sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+        enqueueTask(t);
+    }
+
+    Task* dequeueTask() override {
+        while(true) {
+            if(Task* t = tryPop())
+                return t;
+            if(_closedInput.load(std::memory_order_acquire) && size() == 0)
+                return &_eof;
+            std::this_thread::yield();
+        }
+    }
+
+    Task* stealTask() override {
+        while(true) {
+            int64_t t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = _bottom.load(std::memory_order_acquire);
+            if(t < b) {
+                Task* task = _array.load(std::memory_order_consume)->get(t);
+                if(_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return task;
+                // lost the race against the owner or another thief, try again
+                continue;
+            }
+            if(_closedInput.load(std::memory_order_acquire))
+                return &_eof;
+            std::this_thread::yield();
+        }
+    }
+
+    uint64_t size() override {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    void closeInput() override {
+        _closedInput.store(true, std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Collects the tasks for a set of task queues and enqueues them in batches, such that a queue is locked once
+ * per batch instead of once per task. `flush()` must be called before the input of the queues is closed.
+ */
+class TaskBatcher {
+    const std::vector<TaskQueue*>& _queues;
+    std::vector<std::vector<Task*>> _batches;
+    size_t _batchSize;
+
+public:
+    TaskBatcher(const std::vector<TaskQueue*>& queues, size_t batchSize) : _queues(queues),
+            _batches(queues.size()), _batchSize(std::max<size_t>(1, batchSize)) {
+        for(auto& batch : _batches)
+            batch.reserve(_batchSize);
+    }
+
+    void enqueue(size_t queue, Task* t) {
+        auto& batch = _batches[queue];
+        batch.push_back(t);
+        if(batch.size() >= _batchSize)
+            flush(queue);
+    }
+
+    void flush(size_t queue) {
+        auto& batch = _batches[queue];
+        if(!batch.empty()) {
+            _queues[queue]->enqueueTasks(batch.data(), batch.size());
+            batch.clear();
+        }
+    }
+
+    void flush() {
+        for(size_t i = 0; i < _batches.size(); i++)
+            flush(i);
+    }
+};
+
 #endif //SRC_RUNTIME_LOCAL_VECTORIZED_TASKQUEUES_H
@@ -19,21 +19,32 @@
 
 template<typename VT>
 void CompiledPipelineTask<DenseMatrix<VT>>::execute(uint32_t fid, uint32_t batchSize) {
+    auto start = std::chrono::steady_clock::now();
     // local add aggregation to minimize locking
     std::vector<DenseMatrix<VT>*> localAddRes(_data._numOutputs);
     std::vector<DenseMatrix<VT>*> localResults(_data._numOutputs);
     std::vector<DenseMatrix<VT>**> outputs;
     for (auto &lres : localResults)
         outputs.push_back(&lres);
+    RowViewCache::Lease views;
+    std::vector<Structure *> linputs;
+    std::vector<PrefetchedInput> prefetched;
+    for(size_t i = 0; i < _data._numInputs; i++)
+        if(_data._splits[i] == VectorSplit::ROWS && !_data._isScalar[i]
+                && !BroadcastInputPins::isBroadcast(_data._splits[i], _data._inputs[i]))
+            if(auto m = dynamic_cast<const DenseMatrix<VT>*>(_data._inputs[i]))
+                prefetched.push_back({m->getValues(), m->getRowSkip(), m->getNumCols() * sizeof(VT)});
     for(uint64_t r = _data._rl ; r < _data._ru ; r += batchSize) {
         //create zero-copy views of inputs/outputs
         uint64_t r2 = std::min(r + batchSize, _data._ru);
         
-        auto linputs = this->createFuncInputs(r, r2);
+        this->createFuncInputs(linputs, r, r2, &views);
+        if(r2 < _data._ru)
+            prefetchRows(prefetched, r2, std::min(r2 + batchSize, _data._ru));
         
         //execute function on given data binding (batch size)
         _data._funcs[fid](outputs.data(), linputs.data(), _data._ctx);
-        accumulateOutputs(localResults, localAddRes, r, r2);
+        accumulateOutputs(localResults, localAddRes, r);
         
         // cleanup
         for (auto &localResult : localResults)
@@ -47,20 +58,26 @@ void CompiledPipelineTask<DenseMatrix<VT>>::execute(uint32_t fid, uint32_t batch
         // here.
     }
     
-    for(size_t o = 0; o < _data._numOutputs; ++o) {
-        if(_data._combines[o] == VectorCombine::ADD) {
-            auto &result = (*_res[o]);
-            _resLock.lock();
-            if(result == nullptr) {
-                result = localAddRes[o];
-                _resLock.unlock();
-            }
-            else {
-                ewBinaryMat(BinaryOpCode::ADD, result, result, localAddRes[o], _data._ctx);
-                _resLock.unlock();
-                //cleanup
-                DataObjectFactory::destroy(localAddRes[o]);
-            }
+    // hand the local aggregates to the partial result of this worker
+    for(size_t o = 0; o < _data._numOutputs; ++o)
+        if(isAggCombine(_data._combines[o]) && localAddRes[o])
+            _resultSinks[o]->addPartial(localAddRes[o]);
+    this->countCalls(batchSize);
+    this->reportExecutionTime(start);
+}
+
+template<typename VT>
+void CompiledPipelineTask<DenseMatrix<VT>>::prefetchRows(const std::vector<PrefetchedInput>& inputs,
+        uint64_t rowStart, uint64_t rowEnd) {
+    constexpr size_t CACHE_LINE = 64;
+    for(const auto& in : inputs) {
+        size_t budget = PREFETCH_BYTES;
+        for(uint64_t r = rowStart - _data._inputOffset; r < rowEnd - _data._inputOffset && budget; r++) {
+            const char* row = reinterpret_cast<const char*>(in.values + r * in.rowSkip);
+            const size_t bytes = std::min(in.rowBytes, budget);
+            for(size_t b = 0; b < bytes; b += CACHE_LINE)
+                __builtin_prefetch(row + b, 0, 3);
+            budget -= bytes;
         }
     }
 }
@@ -72,46 +89,28 @@ uint64_t CompiledPipelineTask<DenseMatrix<VT>>::getTaskSize() {
 
 template<typename VT>
 void CompiledPipelineTask<DenseMatrix<VT>>::accumulateOutputs(std::vector<DenseMatrix<VT> *> &localResults,
-        std::vector<DenseMatrix<VT> *> &localAddRes, uint64_t rowStart, uint64_t rowEnd) {
+        std::vector<DenseMatrix<VT> *> &localAddRes, uint64_t rowStart) {
     //TODO: in-place computation via better compiled pipelines
     //TODO: multi-return
     for(auto o = 0u ; o < _data._numOutputs ; ++o) {
-        auto &result = (*_res[o]);
         switch (_data._combines[o]) {
-            case VectorCombine::ROWS: {
-                rowStart -= _data._offset;
-                rowEnd -= _data._offset;
-                auto slice = result->sliceRow(rowStart, rowEnd);
-                // TODO It's probably more efficient to memcpy than to get/set.
-                // But eventually, we don't want to copy at all.
-                for(auto i = 0u ; i < slice->getNumRows() ; ++i) {
-                    for(auto j = 0u ; j < slice->getNumCols() ; ++j) {
-                        slice->set(i, j, localResults[o]->get(i, j));
-                    }
-                }
-                DataObjectFactory::destroy(slice);
-                break;
-            }
+            case VectorCombine::ROWS:
             case VectorCombine::COLS: {
-                auto slice = result->sliceCol(rowStart-_data._offset, rowEnd-_data._offset);
-                // TODO It's probably more efficient to memcpy than to get/set.
-                // But eventually, we don't want to copy at all.
-                for(auto i = 0u ; i < slice->getNumRows() ; ++i) {
-                    for(auto j = 0u ; j < slice->getNumCols() ; ++j) {
-                        slice->set(i, j, localResults[o]->get(i, j));
-                    }
-                }
-                DataObjectFactory::destroy(slice);
+                // the tasks write disjoint slices of the result, hence no locking
+                _resultSinks[o]->add(localResults[o], rowStart - _data._offset);
                 break;
             }
-            case VectorCombine::ADD: {
+            case VectorCombine::ADD:
+            case VectorCombine::MIN:
+            case VectorCombine::MAX: {
                 if(localAddRes[o] == nullptr) {
                     // take lres and reset it to nullptr
                     localAddRes[o] = localResults[o];
                     localResults[o] = nullptr;
                 }
                 else {
-                    ewBinaryMat(BinaryOpCode::ADD, localAddRes[o], localAddRes[o], localResults[o], nullptr);
+                    ewBinaryMat(getAggCombineOpCode(_data._combines[o]), localAddRes[o], localAddRes[o],
+                            localResults[o], nullptr);
                 }
                 break;
             }
@@ -125,6 +124,7 @@ void CompiledPipelineTask<DenseMatrix<VT>>::accumulateOutputs(std::vector<DenseM
 
 template<typename VT>
 void CompiledPipelineTask<CSRMatrix<VT>>::execute(uint32_t fid, uint32_t batchSize) {
+    auto start = std::chrono::steady_clock::now();
     std::vector<size_t> localResNumRows(_data._numOutputs);
     std::vector<size_t> localResNumCols(_data._numOutputs);
     for(size_t i = 0; i < _data._numOutputs; i++) {
@@ -141,29 +141,42 @@ void CompiledPipelineTask<CSRMatrix<VT>>::execute(uint32_t fid, uint32_t batchSi
                 localResNumCols[i] = _data._ru - _data._rl;
                 break;
             }
+            case VectorCombine::ADD:
+            case VectorCombine::MIN:
+            case VectorCombine::MAX:
+                // the parts are aggregated into the partial result of this worker right away
+                break;
             default:
                 throw std::runtime_error("Not implemented");
         }
     }
     
-    std::vector<VectorizedDataSink<CSRMatrix<VT>>*> localSinks(_data._numOutputs);
+    std::vector<VectorizedDataSink<CSRMatrix<VT>>*> localSinks(_data._numOutputs, nullptr);
     for(size_t i = 0; i < _data._numOutputs; i++)
-        localSinks[i] = new VectorizedDataSink<CSRMatrix<VT>>(_data._combines[i], localResNumRows[i], localResNumCols[i]);
+        if(!isAggCombine(_data._combines[i]))
+            localSinks[i] = new VectorizedDataSink<CSRMatrix<VT>>(_data._combines[i], localResNumRows[i],
+                    localResNumCols[i]);
     
     std::vector<CSRMatrix<VT>*> lres(_data._numOutputs, nullptr);
+    RowViewCache::Lease views;
+    std::vector<Structure *> linputs;
     for(uint64_t r = _data._rl ; r < _data._ru ; r += batchSize) {
         //create zero-copy views of inputs/outputs
         uint64_t r2 = std::min(r + batchSize, _data._ru);
         
-        auto linputs = this->createFuncInputs(r, r2);
+        this->createFuncInputs(linputs, r, r2, &views);
         CSRMatrix<VT> *** outputs = new CSRMatrix<VT>**[_data._numOutputs];
         for(size_t i = 0; i < _data._numOutputs; i++)
             outputs[i] = &(lres[i]);
         //execute function on given data binding (batch size)
         _data._funcs[fid](outputs, linputs.data(), _data._ctx);
         delete[] outputs;
-        for(size_t i = 0; i < _data._numOutputs; i++)
-            localSinks[i]->add(lres[i], r - _data._rl, false);
+        for(size_t i = 0; i < _data._numOutputs; i++) {
+            if(localSinks[i])
+                localSinks[i]->add(lres[i], r - _data._rl, false);
+            else
+                _resultSinks[i]->addPartial(lres[i]);
+        }
 
         // cleanup
         for(size_t i = 0; i < _data._numOutputs; i++)
@@ -174,9 +187,13 @@ void CompiledPipelineTask<CSRMatrix<VT>>::execute(uint32_t fid, uint32_t batchSi
         // here.
     }
     for(size_t i = 0; i < _data._numOutputs; i++) {
+        if(!localSinks[i])
+            continue;
         _resultSinks[i]->add(localSinks[i]->consume(), _data._rl);
         delete localSinks[i];
     }
+    this->countCalls(batchSize);
+    this->reportExecutionTime(start);
 }
 
 
@@ -185,6 +202,40 @@ uint64_t CompiledPipelineTask<CSRMatrix<VT>>::getTaskSize() {
 return _data._ru-_data._rl;
 }
 
+void CompiledPipelineTask<Frame>::execute(uint32_t fid, uint32_t batchSize) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Frame*> lres(_data._numOutputs, nullptr);
+    std::vector<Frame**> outputs;
+    for(auto &res : lres)
+        outputs.push_back(&res);
+    RowViewCache::Lease views;
+    std::vector<Structure *> linputs;
+    for(uint64_t r = _data._rl ; r < _data._ru ; r += batchSize) {
+        //create zero-copy views of inputs/outputs
+        uint64_t r2 = std::min(r + batchSize, _data._ru);
+
+        this->createFuncInputs(linputs, r, r2, &views);
+
+        //execute function on given data binding (batch size)
+        _data._funcs[fid](outputs.data(), linputs.data(), _data._ctx);
+
+        // the parts are stored by the first row they were computed from, since they may have fewer rows
+        for(size_t i = 0; i < _data._numOutputs; i++) {
+            _resultSinks[i]->add(lres[i], r - _data._offset);
+            lres[i] = nullptr;
+        }
+
+        // Note that a pipeline manages the reference counters of its inputs
+        // internally. Thus, we do not need to care about freeing the inputs
+        // here.
+    }
+    this->countCalls(batchSize);
+    this->reportExecutionTime(start);
+}
+
+uint64_t CompiledPipelineTask<Frame>::getTaskSize() {
+    return _data._ru-_data._rl;
+}
 
 template class CompiledPipelineTask<DenseMatrix<double>>;
 template class CompiledPipelineTask<DenseMatrix<float>>;
@@ -21,35 +21,192 @@
 #include <runtime/local/kernels/EwBinaryMat.h>
 #include <runtime/local/vectorized/VectorizedDataSink.h>
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/vectorized/LoadPartitioning.h>
+#include <runtime/local/vectorized/RowViewCache.h>
+#include <runtime/local/vectorized/Task.h>
+#include <runtime/local/vectorized/Topology.h>
+#include <runtime/local/vectorized/Worker.h>
 #include <ir/daphneir/Daphne.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include <sched.h>
 
 using mlir::daphne::VectorSplit;
 using mlir::daphne::VectorCombine;
 
-class Task {
+/**
+ * @brief Pins the broadcast inputs of a vectorized pipeline once for all calls of its pipeline functions.
+ *
+ * Every call of a pipeline function releases one reference to each of its inputs. Instead of increasing the
+ * (mutex-protected) reference counters of the broadcast inputs before every call, the pipeline pins them for an upper
+ * bound of the number of calls up front. The tasks count their calls, and the unused references are dropped once the
+ * pipeline has finished, i.e., the pins must outlive the workers.
+ */
+class BroadcastInputPins {
+    std::vector<const Structure*> _pinned;
+    uint64_t _maxNumCalls;
+    std::atomic<uint64_t> _numCalls{0};
+
 public:
-    virtual ~Task() = default;
+    // the extent of the input along the dimension it is split by, i.e., its number of rows or columns
+    static size_t getSplitExtent(VectorSplit splitMethod, const Structure* input) {
+        return splitMethod == VectorSplit::COLS ? input->getNumCols() : input->getNumRows();
+    }
+
+    // the input of a streamed split (the name of a file) is not a data object, and never broadcast
+    static bool isBroadcast(VectorSplit splitMethod, const Structure* input) {
+        return splitMethod == VectorSplit::NONE
+                || ((splitMethod == VectorSplit::ROWS || splitMethod == VectorSplit::COLS)
+                        && getSplitExtent(splitMethod, input) == 1);
+    }
 
-    virtual void execute(uint32_t fid, uint32_t batchSize) = 0;
-    virtual uint64_t getTaskSize() = 0;
+    /**
+     * @param maxNumCalls An upper bound of the number of calls of the pipeline functions, e.g., the number of rows,
+     * since every call processes at least one row.
+     */
+    BroadcastInputPins(Structure** inputs, const bool* isScalar, const VectorSplit* splits, size_t numInputs,
+            uint64_t maxNumCalls) : _maxNumCalls(maxNumCalls) {
+        for(size_t i = 0; i < numInputs; i++)
+            // This might be a scalar disguised as a Structure*.
+            if(!isScalar[i] && isBroadcast(splits[i], inputs[i]))
+                _pinned.push_back(inputs[i]);
+        for(auto input : _pinned)
+            input->increaseRefCounter(_maxNumCalls);
+    }
+    BroadcastInputPins(const BroadcastInputPins&) = delete;
+    BroadcastInputPins& operator=(const BroadcastInputPins&) = delete;
+
+    ~BroadcastInputPins() {
+        const uint64_t unused = _maxNumCalls - _numCalls.load();
+        if(unused)
+            for(auto input : _pinned)
+                input->unpinRefCounter(unused);
+    }
+
+    /**
+     * @brief Returns the counter the tasks add their number of calls to, or `nullptr` if there is nothing pinned.
+     */
+    std::atomic<uint64_t>* getNumCalls() { return _pinned.empty() ? nullptr : &_numCalls; }
 };
 
-// task for signaling closed input queue (no more tasks)
-class EOFTask : public Task {
+/**
+ * @brief Copies of the large dense broadcast inputs of a vectorized pipeline on every NUMA node, such that the workers
+ * pinned to a node read them from its local memory instead of the node they were allocated on (usually the first).
+ *
+ * Every copy is allocated fresh and first touched by a thread pinned to the CPUs of its node. A task reads the inputs
+ * of the node of the worker executing it (see `Worker::currentNumaNode()`), the original inputs on threads that are
+ * not pinned. The copies are pinned for all calls like the original inputs, and the references to the originals the
+ * calls on copies did not release are dropped along with the copies once the pipeline has finished, i.e., the
+ * replicas must outlive the workers, too.
+ */
+class BroadcastReplicas {
+    Structure** _inputs;
+    // the inputs of every NUMA node, and the indexes of the inputs replaced by copies
+    std::vector<std::vector<Structure*>> _nodeInputs;
+    std::vector<size_t> _replicated;
+    // the calls of the pipeline functions on the copies
+    std::atomic<uint64_t> _numCalls{0};
+
+    BroadcastReplicas(Structure** inputs, size_t numInputs, size_t numNodes, std::vector<size_t> replicated)
+            : _inputs(inputs), _nodeInputs(numNodes, std::vector<Structure*>(inputs, inputs + numInputs)),
+            _replicated(std::move(replicated)) {}
+
 public:
-    EOFTask() = default;
-    ~EOFTask() override = default;
-    void execute(uint32_t fid, uint32_t batchSize) override {}
-    uint64_t getTaskSize() override {return 0;}
+    /**
+     * @brief Copies the dense broadcast inputs of at least `minBytes` to every NUMA node, returning `nullptr` if
+     * there is a single node or no such input.
+     *
+     * @param maxNumCalls An upper bound of the number of calls of the pipeline functions (see `BroadcastInputPins`).
+     */
+    template<typename VT>
+    static std::unique_ptr<BroadcastReplicas> create(Structure** inputs, const bool* isScalar,
+            const VectorSplit* splits, size_t numInputs, uint64_t maxNumCalls, size_t minBytes) {
+        const Topology& topology = Topology::get();
+        const size_t numNodes = topology.getNumNumaNodes();
+        if(minBytes == 0 || numNodes < 2)
+            return nullptr;
+        std::vector<size_t> replicated;
+        for(size_t i = 0; i < numInputs; i++)
+            if(!isScalar[i] && BroadcastInputPins::isBroadcast(splits[i], inputs[i]))
+                if(auto m = dynamic_cast<const DenseMatrix<VT>*>(inputs[i]))
+                    if(m->getNumItems() * sizeof(VT) >= minBytes)
+                        replicated.push_back(i);
+        if(replicated.empty())
+            return nullptr;
+
+        std::unique_ptr<BroadcastReplicas> replicas(new BroadcastReplicas(inputs, numInputs, numNodes, replicated));
+        std::vector<std::thread> threads;
+        for(size_t n = 0; n < numNodes; n++)
+            threads.emplace_back([&, n] {
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                for(const auto& cpu : topology.getCpus())
+                    if(static_cast<size_t>(cpu.numaNode) == n)
+                        CPU_SET(cpu.cpu, &cpuset);
+                sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+                for(size_t i : replicas->_replicated) {
+                    auto src = static_cast<const DenseMatrix<VT>*>(inputs[i]);
+                    const size_t numRows = src->getNumRows();
+                    const size_t numCols = src->getNumCols();
+                    // not from the BufferPool, whose cached arrays were touched elsewhere
+                    std::shared_ptr<VT[]> values(new VT[numRows * numCols]);
+                    const VT* srcValues = src->getValues();
+                    for(size_t r = 0; r < numRows; r++)
+                        std::memcpy(values.get() + r * numCols, srcValues + r * src->getRowSkip(),
+                                numCols * sizeof(VT));
+                    auto copy = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, values);
+                    copy->increaseRefCounter(maxNumCalls);
+                    replicas->_nodeInputs[n][i] = copy;
+                }
+            });
+        for(auto& t : threads)
+            t.join();
+        return replicas;
+    }
+
+    BroadcastReplicas(const BroadcastReplicas&) = delete;
+    BroadcastReplicas& operator=(const BroadcastReplicas&) = delete;
+
+    ~BroadcastReplicas() {
+        const uint64_t numCalls = _numCalls.load();
+        for(size_t i : _replicated) {
+            if(numCalls)
+                _inputs[i]->unpinRefCounter(numCalls);
+            for(auto& inputs : _nodeInputs) {
+                // the copies are not referenced outside of the pipeline
+                const size_t unused = inputs[i]->getRefCounter() - 1;
+                if(unused)
+                    inputs[i]->unpinRefCounter(unused);
+                DataObjectFactory::destroy(inputs[i]);
+            }
+        }
+    }
+
+    // the inputs of the tasks executed on the given NUMA node (-1 if not pinned)
+    Structure** getInputs(int node) {
+        return node >= 0 && static_cast<size_t>(node) < _nodeInputs.size() ? _nodeInputs[node].data() : _inputs;
+    }
+
+    void countCalls(int node, uint64_t numCalls) {
+        if(getInputs(node) != _inputs)
+            _numCalls.fetch_add(numCalls);
+    }
 };
 
 template<class DT>
 struct CompiledPipelineTaskData {
-    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> _funcs;
+    // the pipeline functions, shared by all tasks of the pipeline
+    const std::function<void(DT ***, Structure **, DCTX(ctx))>* _funcs;
     const bool* _isScalar;
     Structure **_inputs;
     const size_t _numInputs;
@@ -64,6 +221,15 @@ struct CompiledPipelineTaskData {
     const int64_t *_wholeResultCols; // number of cols of the complete result
     const uint64_t _offset;
     DCTX(_ctx);
+    // receives the execution time of the task if an adaptive partitioning scheme is used
+    ChunkFeedback* _feedback = nullptr;
+    size_t _feedbackSlot = 0;
+    // counts the calls of the pipeline functions if the broadcast inputs are pinned by a BroadcastInputPins
+    std::atomic<uint64_t>* _numCalls = nullptr;
+    // the row of the whole input the row-split inputs start at, i.e., the first row of the chunk of a streamed input
+    uint64_t _inputOffset = 0;
+    // the copies of the broadcast inputs on the NUMA node of the executing worker, if any
+    BroadcastReplicas* _replicas = nullptr;
 
     [[maybe_unused]] CompiledPipelineTaskData<DT> withDifferentRange(uint64_t newRl, uint64_t newRu) {
         CompiledPipelineTaskData<DT> flatCopy = *this;
@@ -75,6 +241,9 @@ struct CompiledPipelineTaskData {
 
 template<class DT>
 class CompiledPipelineTaskBase : public Task {
+    // every task holds its own copy, so it must stay cheap to copy
+    static_assert(std::is_trivially_copyable<CompiledPipelineTaskData<DT>>::value,
+            "CompiledPipelineTaskData must only refer to the shared data of the pipeline");
 protected:
     CompiledPipelineTaskData<DT> _data;
 
@@ -84,54 +253,138 @@ public:
     uint64_t getTaskSize() override = 0;
 
 protected:
-    bool isBroadcast(mlir::daphne::VectorSplit splitMethod, Structure *input) {
-        return splitMethod == VectorSplit::NONE || (splitMethod == VectorSplit::ROWS && input->getNumRows() == 1);
+    void reportExecutionTime(std::chrono::steady_clock::time_point start) {
+        if(_data._feedback) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            _data._feedback->report(_data._feedbackSlot, _data._ru - _data._rl, elapsed.count());
+        }
+    }
+
+    // accounts for the references to pinned broadcast inputs released by the calls of this task
+    void countCalls(uint32_t batchSize) {
+        const uint64_t numCalls = (_data._ru - _data._rl + batchSize - 1) / batchSize;
+        if(_data._numCalls)
+            _data._numCalls->fetch_add(numCalls);
+        if(_data._replicas)
+            _data._replicas->countCalls(Worker::currentNumaNode(), numCalls);
     }
 
-    std::vector<Structure *> createFuncInputs(uint64_t rowStart, uint64_t rowEnd) {
-        std::vector<Structure *> linputs;
+    /**
+     * @brief Fills `linputs` with the inputs of one call of a pipeline function on the rows (or columns, for
+     * column-split inputs) `rowStart` to `rowEnd`.
+     *
+     * The row-split inputs are viewed through the reusable views of `views` if given, or by new views otherwise.
+     */
+    void createFuncInputs(std::vector<Structure *>& linputs, uint64_t rowStart, uint64_t rowEnd,
+            RowViewCache::Lease* views = nullptr) {
+        linputs.resize(_data._numInputs);
+        Structure** inputs = _data._replicas ? _data._replicas->getInputs(Worker::currentNumaNode()) : _data._inputs;
         for(auto i = 0u ; i < _data._numInputs ; i++) {
-            if (isBroadcast(_data._splits[i], _data._inputs[i])) {
-                linputs.push_back(_data._inputs[i]);
+            if (BroadcastInputPins::isBroadcast(_data._splits[i], _data._inputs[i])) {
+                linputs[i] = inputs[i];
                 // We need to increase the reference counter, since the
-                // pipeline manages the reference counter itself.
+                // pipeline manages the reference counter itself, unless the
+                // MTWrapper pinned the broadcast inputs for all calls.
                 // This might be a scalar disguised as a Structure*.
-                if(!_data._isScalar[i])
-                    // Note that increaseRefCounter() synchronizes the access
-                    // via a std::mutex. If that turns out to slow down things,
-                    // creating a shallow copy of the input would be an
-                    // alternative.
-                    _data._inputs[i]->increaseRefCounter();
+                if(!_data._isScalar[i] && !_data._numCalls)
+                    inputs[i]->increaseRefCounter();
             }
             else if (VectorSplit::ROWS == _data._splits[i]) {
-                linputs.push_back(_data._inputs[i]->sliceRow(rowStart, rowEnd));
+                const uint64_t rl = rowStart - _data._inputOffset;
+                const uint64_t ru = rowEnd - _data._inputOffset;
+                linputs[i] = views ? views->getRowView(i, _data._inputs[i], rl, ru)
+                        : _data._inputs[i]->sliceRow(rl, ru);
+            }
+            else if (VectorSplit::COLS == _data._splits[i]) {
+                // column-split inputs are never streamed
+                linputs[i] = _data._inputs[i]->sliceCol(rowStart, rowEnd);
             }
             else {
                 llvm_unreachable("Not all vector splits handled");
             }
         }
-        return linputs;
     }
 };
 
 template<class DT>
 class CompiledPipelineTask : public CompiledPipelineTaskBase<DT> {};
 
+/**
+ * @brief Counts the unfinished tasks of every chunk of a streamed input, such that a chunk can be freed as soon as
+ * all of its tasks were executed.
+ */
+class ChunkTaskCounter {
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::vector<size_t> _pending;
+
+public:
+    explicit ChunkTaskCounter(size_t numChunks) : _pending(numChunks, 0) {}
+
+    void add(size_t chunk) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _pending[chunk]++;
+    }
+
+    void done(size_t chunk) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if(--_pending[chunk] == 0)
+            _cv.notify_all();
+    }
+
+    // must only be called once all tasks of the chunk were enqueued
+    void wait(size_t chunk) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cv.wait(lock, [&] { return _pending[chunk] == 0; });
+    }
+};
+
 template<typename VT>
 class CompiledPipelineTask<DenseMatrix<VT>> : public CompiledPipelineTaskBase<DenseMatrix<VT>> {
-    std::mutex &_resLock;
-    DenseMatrix<VT> ***_res;
+    std::vector<VectorizedDataSink<DenseMatrix<VT>> *>& _resultSinks;
     using CompiledPipelineTaskBase<DenseMatrix<VT>>::_data;
 public:
-    CompiledPipelineTask(CompiledPipelineTaskData<DenseMatrix<VT>> data, std::mutex &resLock, DenseMatrix<VT> ***res)
-        : CompiledPipelineTaskBase<DenseMatrix<VT>>(data), _resLock(resLock), _res(res) {}
+    CompiledPipelineTask(CompiledPipelineTaskData<DenseMatrix<VT>> data, std::vector<VectorizedDataSink<DenseMatrix<VT>> *>& resultSinks)
+        : CompiledPipelineTaskBase<DenseMatrix<VT>>(data), _resultSinks(resultSinks) {}
 
     void execute(uint32_t fid, uint32_t batchSize) override;
     uint64_t getTaskSize() override;
 
 private:
+    // the bytes of the next rows of every row-split input prefetched while the current rows are processed, such that
+    // the first accesses of the next call do not wait for memory until the hardware prefetchers caught up
+    static constexpr size_t PREFETCH_BYTES = 16 * 1024;
+
+    struct PrefetchedInput {
+        const VT* values;
+        size_t rowSkip;
+        size_t rowBytes;
+    };
+
     void accumulateOutputs(std::vector<DenseMatrix<VT>*>& localResults, std::vector<DenseMatrix<VT> *> &localAddRes,
-            uint64_t rowStart, uint64_t rowEnd);
+            uint64_t rowStart);
+
+    void prefetchRows(const std::vector<PrefetchedInput>& inputs, uint64_t rowStart, uint64_t rowEnd);
+};
+
+// task on (a part of) one chunk of a streamed input, which reports its completion to the counter of the chunks
+template<class DT>
+class StreamedPipelineTask : public CompiledPipelineTask<DT> {
+    ChunkTaskCounter& _counter;
+    const size_t _chunk;
+public:
+    StreamedPipelineTask(CompiledPipelineTaskData<DT> data, std::vector<VectorizedDataSink<DT> *>& resultSinks,
+            ChunkTaskCounter& counter, size_t chunk)
+        : CompiledPipelineTask<DT>(data, resultSinks), _counter(counter), _chunk(chunk) {}
+
+    void execute(uint32_t fid, uint32_t batchSize) override {
+        CompiledPipelineTask<DT>::execute(fid, batchSize);
+        _counter.done(_chunk);
+    }
+
+    void skip() override {
+        _counter.done(_chunk);
+    }
 };
 
 template<typename VT>
@@ -145,3 +398,14 @@ public:
     void execute(uint32_t fid, uint32_t batchSize) override;
     uint64_t getTaskSize() override;
 };
+
+template<>
+class CompiledPipelineTask<Frame> : public CompiledPipelineTaskBase<Frame> {
+    std::vector<VectorizedDataSink<Frame> *>& _resultSinks;
+public:
+    CompiledPipelineTask(CompiledPipelineTaskData<Frame> data, std::vector<VectorizedDataSink<Frame> *>& resultSinks)
+        : CompiledPipelineTaskBase<Frame>(data), _resultSinks(resultSinks) {}
+
+    void execute(uint32_t fid, uint32_t batchSize) override;
+    uint64_t getTaskSize() override;
+};
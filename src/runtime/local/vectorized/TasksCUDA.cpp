@@ -18,23 +18,68 @@
 #include "runtime/local/vectorized/TasksCUDA.h"
 #include "runtime/local/kernels/CUDA/EwBinaryMat.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <string>
+
+// copies the row-split dense inputs of one batch, i.e., the views created for this batch, to the device
+template<typename VT>
+static void transferSplitInputs(const CompiledPipelineTaskData<DenseMatrix<VT>>& data,
+        const std::vector<Structure *>& linputs, const AllocationDescriptorCUDA* alloc_desc) {
+    for(size_t i = 0; i < linputs.size(); i++) {
+        if(linputs[i] == data._inputs[i])
+            continue;
+        if(auto mat = dynamic_cast<const DenseMatrix<VT>*>(linputs[i]))
+            [[maybe_unused]] auto unused = mat->getValues(alloc_desc);
+    }
+}
+
 template<typename VT>
 void CompiledPipelineTaskCUDA<DenseMatrix<VT>>::execute(uint32_t fid, uint32_t batchSize) {
+    if(_data._ctx->config.cudaStreamPipelining) {
+        executeStreamPipelined(fid, batchSize);
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    AllocationDescriptorCUDA alloc_desc(_data._ctx, _deviceID);
     // local add aggregation to minimize locking
     std::vector<DenseMatrix<VT>*> localAddRes(_data._numOutputs);
     std::vector<DenseMatrix<VT>*> localResults(_data._numOutputs);
+    std::vector<Structure *> linputs;
+    // the host-to-device transfer of the inputs of the next batch overlaps with the computation of the current one
+    std::vector<Structure *> nextInputs;
+    std::future<void> transfer;
+    auto prefetch = [&](uint64_t rowStart) {
+        if(rowStart >= _data._ru)
+            return;
+        this->createFuncInputs(nextInputs, rowStart, std::min(rowStart + batchSize, _data._ru));
+        transfer = std::async(std::launch::async, [this, &nextInputs, &alloc_desc]() {
+            transferSplitInputs(_data, nextInputs, &alloc_desc);
+        });
+    };
+    // the transfers on the default stream would fail the capture of a graph, thus, they are issued after its launch
+    const bool graphs = _data._ctx->config.cuda_graphs;
+    prefetch(_data._rl);
     for(uint64_t r = _data._rl ; r < _data._ru ; r += batchSize) {
-        //create zero-copy views of inputs/outputs
         uint64_t r2 = std::min(r + batchSize, _data._ru);
         
-        auto linputs = this->createFuncInputs(r, r2);
+        // the zero-copy views of the inputs of this batch were created (and transferred) ahead
+        transfer.get();
+        std::swap(linputs, nextInputs);
+        if(!graphs)
+            prefetch(r2);
         std::vector<DenseMatrix<VT>**> outputs;
         
         for (auto &lres : localResults) {
             outputs.push_back(&lres);
         }
         //execute function on given data binding (batch size)
-        _data._funcs[fid](outputs.data(), linputs.data(), _data._ctx);
+        if(!graphs || !executeCaptured(fid, outputs, linputs, alloc_desc))
+            _data._funcs[fid](outputs.data(), linputs.data(), _data._ctx);
+        if(graphs)
+            prefetch(r2);
         accumulateOutputs(localResults, localAddRes, r, r2);
         
         // cleanup
@@ -46,66 +91,288 @@ void CompiledPipelineTaskCUDA<DenseMatrix<VT>>::execute(uint32_t fid, uint32_t b
         }
     }
     
+    mergeAddResults(localAddRes);
+    this->countCalls(batchSize);
+    this->reportExecutionTime(start);
+}
+
+template<typename VT>
+bool CompiledPipelineTaskCUDA<DenseMatrix<VT>>::executeCaptured(uint32_t fid, std::vector<DenseMatrix<VT>**>& outputs,
+        std::vector<Structure *>& linputs, const AllocationDescriptorCUDA& alloc_desc) {
+    std::string key = std::to_string(reinterpret_cast<uintptr_t>(&_data._funcs[fid]));
+    for(auto input : linputs) {
+        auto mat = dynamic_cast<const DenseMatrix<VT>*>(input);
+        if(!mat)
+            return false;
+        // the transfers to the device must not be captured
+        [[maybe_unused]] auto unused = mat->getValues(&alloc_desc);
+        key += ";" + std::to_string(mat->getNumRows()) + "x" + std::to_string(mat->getNumCols());
+    }
+    auto ctx = CUDAContext::get(_data._ctx, _deviceID);
+    if(ctx->runCaptured(key, [&]() { _data._funcs[fid](outputs.data(), linputs.data(), _data._ctx); }))
+        return true;
+    // the results of the failed capture were not computed
+    for(auto output : outputs)
+        if(*output) {
+            DataObjectFactory::destroy(*output);
+            *output = nullptr;
+        }
+    return false;
+}
+
+template<typename VT>
+void CompiledPipelineTaskCUDA<DenseMatrix<VT>>::mergeAddResults(std::vector<DenseMatrix<VT>*>& localAddRes) {
     for(size_t o = 0; o < _data._numOutputs; ++o) {
-        if(_data._combines[o] == VectorCombine::ADD) {
-            auto &result = (*_res[o]);
+        if(isAggCombine(_data._combines[o]) && localAddRes[o]) {
+            auto &result = _addRes[o];
             _resLock.lock();
             if(result == nullptr) {
                 result = localAddRes[o];
                 _resLock.unlock();
             }
             else {
-                CUDA::ewBinaryMat(BinaryOpCode::ADD, result, result, localAddRes[o], _data._ctx);
+                CUDA::ewBinaryMat(getAggCombineOpCode(_data._combines[o]), result, result, localAddRes[o],
+                        _data._ctx);
                 _resLock.unlock();
                 //cleanup
                 DataObjectFactory::destroy(localAddRes[o]);
             }
+            localAddRes[o] = nullptr;
         }
     }
 }
 
+// whether the latest version of the matrix is on the device of the allocation descriptor
+template<typename VT>
+static bool isLatestOnDevice(const DenseMatrix<VT>* mat, const AllocationDescriptorCUDA& alloc_desc) {
+    const auto& mdo = mat->getMetaDataObject();
+    for(const auto& placement : *mdo.getDataPlacementByType(ALLOCATION_TYPE::GPU_CUDA))
+        if(placement->allocation->getLocation() == alloc_desc.getLocation() && mdo.isLatestVersion(placement->dp_id))
+            return true;
+    return false;
+}
+
+namespace {
+    // one of the two batches in flight of the stream-pipelined execution
+    template<typename VT>
+    struct StreamSlot {
+        // the part of a row-wise or column-wise combine being copied to the staging buffer
+        struct PendingPart {
+            size_t output;
+            DenseMatrix<VT>* result;
+            size_t offset;
+        };
+
+        cudaEvent_t inputsCopied{};
+        cudaEvent_t computed{};
+        cudaEvent_t outputsCopied{};
+        // the pinned buffer slots of the device used for the inputs and results
+        size_t inputBuffer;
+        size_t outputBuffer;
+        std::byte* outputStaging{};
+        // the results stay alive until their transfer completed, such that their memory is not reused before
+        std::vector<PendingPart> parts;
+        uint64_t rowStart{};
+
+        explicit StreamSlot(size_t i) : inputBuffer(2 * i), outputBuffer(2 * i + 1) {
+            CHECK_CUDART(cudaEventCreateWithFlags(&inputsCopied, cudaEventDisableTiming));
+            CHECK_CUDART(cudaEventCreateWithFlags(&computed, cudaEventDisableTiming));
+            CHECK_CUDART(cudaEventCreateWithFlags(&outputsCopied, cudaEventDisableTiming));
+        }
+        StreamSlot(const StreamSlot&) = delete;
+        StreamSlot& operator=(const StreamSlot&) = delete;
+        ~StreamSlot() {
+            cudaEventDestroy(inputsCopied);
+            cudaEventDestroy(computed);
+            cudaEventDestroy(outputsCopied);
+        }
+    };
+}
+
+template<typename VT>
+void CompiledPipelineTaskCUDA<DenseMatrix<VT>>::executeStreamPipelined(uint32_t fid, uint32_t batchSize) {
+    auto start = std::chrono::steady_clock::now();
+    auto* cudaCtx = CUDAContext::get(_data._ctx, _deviceID);
+    AllocationDescriptorCUDA alloc_desc(_data._ctx, _deviceID);
+    cudaStream_t h2d = cudaCtx->getH2DStream();
+    cudaStream_t d2h = cudaCtx->getD2HStream();
+    // the kernels run on the (legacy) default stream
+    cudaStream_t compute = nullptr;
+    StreamSlot<VT> slots[2] = {StreamSlot<VT>(0), StreamSlot<VT>(1)};
+
+    std::vector<DenseMatrix<VT>*> localAddRes(_data._numOutputs);
+    std::vector<DenseMatrix<VT>*> localResults(_data._numOutputs);
+    std::vector<Structure *> linputs;
+    std::vector<Structure *> nextInputs;
+
+    // creates the views of the batch starting at rowStart and fills their device placements on the H2D stream
+    auto copyIn = [&](StreamSlot<VT>& slot, uint64_t rowStart, std::vector<Structure *>& views) {
+        this->createFuncInputs(views, rowStart, std::min(rowStart + batchSize, _data._ru));
+        std::vector<DenseMatrix<VT>*> mats;
+        size_t total = 0;
+        for(size_t i = 0; i < views.size(); i++) {
+            if(views[i] == _data._inputs[i])
+                continue;
+            auto mat = dynamic_cast<DenseMatrix<VT>*>(views[i]);
+            if(!mat)
+                continue;
+            // only contiguous views without a device placement are staged, the others are transferred as usual
+            if(mat->getRowSkip() != mat->getNumCols() || mat->getMetaDataObject().hasPlacementsOtherThan(
+                    ALLOCATION_TYPE::HOST)) {
+                [[maybe_unused]] auto unused = static_cast<const DenseMatrix<VT>*>(mat)->getValues(&alloc_desc);
+                continue;
+            }
+            mats.push_back(mat);
+            total += mat->bufferSize();
+        }
+        if(mats.empty())
+            return;
+        // the staging buffer is free once the previous transfer from it completed, and the device memory released by
+        // earlier batches once their kernels completed
+        CHECK_CUDART(cudaEventSynchronize(slot.inputsCopied));
+        CHECK_CUDART(cudaStreamWaitEvent(h2d, slot.computed, 0));
+        auto staging = static_cast<std::byte*>(cudaCtx->getPinnedBuffer(slot.inputBuffer, total));
+        size_t offset = 0;
+        for(auto* mat : mats) {
+            const size_t bytes = mat->bufferSize();
+            std::memcpy(staging + offset, static_cast<const DenseMatrix<VT>*>(mat)->getValues(), bytes);
+            auto& mdo = mat->getMetaDataObject();
+            auto placement = mdo.addDataPlacement(&alloc_desc);
+            placement->allocation->createAllocation(bytes, false);
+            CHECK_CUDART(cudaMemcpyAsync(placement->allocation->getData().get(), staging + offset, bytes,
+                    cudaMemcpyHostToDevice, h2d));
+            mdo.addLatest(placement->dp_id);
+            offset += bytes;
+        }
+        CHECK_CUDART(cudaEventRecord(slot.inputsCopied, h2d));
+    };
+
+    // copies the staged results of the slot into the outputs once their transfer completed
+    auto finishOutputs = [&](StreamSlot<VT>& slot) {
+        if(slot.parts.empty())
+            return;
+        CHECK_CUDART(cudaEventSynchronize(slot.outputsCopied));
+        for(auto& part : slot.parts) {
+            const size_t numRows = part.result->getNumRows();
+            const size_t rowBytes = part.result->getNumCols() * sizeof(VT);
+            auto [dst, dstRowSkip] = _dataSinks[part.output]->getResultBuffer(slot.rowStart);
+            const std::byte* src = slot.outputStaging + part.offset;
+            for(size_t r = 0; r < numRows; ++r)
+                std::memcpy(dst + r * dstRowSkip, src + r * rowBytes, rowBytes);
+            DataObjectFactory::destroy(part.result);
+        }
+        slot.parts.clear();
+    };
+
+    // starts the transfer of the results of the batch computed in the slot on the D2H stream
+    auto copyOut = [&](StreamSlot<VT>& slot, uint64_t rowStart) {
+        size_t total = 0;
+        for(auto o = 0u; o < _data._numOutputs; ++o) {
+            auto combine = _data._combines[o];
+            if(isAggCombine(combine)) {
+                if(localAddRes[o] == nullptr) {
+                    localAddRes[o] = localResults[o];
+                    localResults[o] = nullptr;
+                }
+                else
+                    CUDA::ewBinaryMat(getAggCombineOpCode(combine), localAddRes[o], localAddRes[o], localResults[o],
+                            _data._ctx);
+            }
+            else if(combine == VectorCombine::ROWS || combine == VectorCombine::COLS) {
+                if(isLatestOnDevice(localResults[o], alloc_desc)) {
+                    slot.parts.push_back({o, localResults[o], total});
+                    total += localResults[o]->getNumItems() * sizeof(VT);
+                    localResults[o] = nullptr;
+                }
+                else
+                    // computed on the host, e.g., by a kernel without a CUDA implementation
+                    _dataSinks[o]->add(localResults[o], rowStart);
+            }
+            else
+                throw std::runtime_error(("VectorCombine case `" + std::to_string(static_cast<int64_t>(combine)) +
+                        "` not supported"));
+        }
+        if(slot.parts.empty())
+            return;
+        slot.rowStart = rowStart;
+        slot.outputStaging = static_cast<std::byte*>(cudaCtx->getPinnedBuffer(slot.outputBuffer, total));
+        CHECK_CUDART(cudaStreamWaitEvent(d2h, slot.computed, 0));
+        for(auto& part : slot.parts) {
+            const auto* lres = part.result;
+            CHECK_CUDART(cudaMemcpy2DAsync(slot.outputStaging + part.offset, lres->getNumCols() * sizeof(VT),
+                    lres->getValues(&alloc_desc), lres->getRowSkip() * sizeof(VT), lres->getNumCols() * sizeof(VT),
+                    lres->getNumRows(), cudaMemcpyDeviceToHost, d2h));
+        }
+        CHECK_CUDART(cudaEventRecord(slot.outputsCopied, d2h));
+    };
+
+    uint64_t k = 0;
+    copyIn(slots[0], _data._rl, nextInputs);
+    for(uint64_t r = _data._rl; r < _data._ru; r += batchSize, ++k) {
+        uint64_t r2 = std::min(r + batchSize, _data._ru);
+        auto& slot = slots[k % 2];
+        std::swap(linputs, nextInputs);
+        // the inputs of batch k+1 are copied while the kernels of batch k run
+        if(r2 < _data._ru)
+            copyIn(slots[(k + 1) % 2], r2, nextInputs);
+
+        CHECK_CUDART(cudaStreamWaitEvent(compute, slot.inputsCopied, 0));
+        std::vector<DenseMatrix<VT>**> outputs;
+        for (auto &lres : localResults)
+            outputs.push_back(&lres);
+        _data._funcs[fid](outputs.data(), linputs.data(), _data._ctx);
+        CHECK_CUDART(cudaEventRecord(slot.computed, compute));
+
+        // the results of batch k-2 used the staging buffer of this slot, the ones of batch k-1 are still in flight
+        finishOutputs(slot);
+        copyOut(slot, r);
+        for (auto &localResult : localResults) {
+            if(localResult) {
+                DataObjectFactory::destroy(localResult);
+                localResult = nullptr;
+            }
+        }
+    }
+    finishOutputs(slots[k % 2]);
+    finishOutputs(slots[(k + 1) % 2]);
+
+    mergeAddResults(localAddRes);
+    this->countCalls(batchSize);
+    this->reportExecutionTime(start);
+}
+
 template<typename VT>
 void CompiledPipelineTaskCUDA<DenseMatrix<VT>>::accumulateOutputs(std::vector<DenseMatrix<VT>*>& localResults,
         std::vector<DenseMatrix<VT> *> &localAddRes, uint64_t rowStart, uint64_t rowEnd) {
     
     //TODO: in-place computation via better compiled pipelines
     //TODO: multi-return
-    const size_t deviceID = 0; //ToDo: multi device support
-    AllocationDescriptorCUDA alloc_desc(_data._ctx, deviceID);
+    AllocationDescriptorCUDA alloc_desc(_data._ctx, _deviceID);
     for(auto o = 0u ; o < _data._numOutputs ; ++o) {
-        auto &result = (*_res[o]);
         switch (_data._combines[o]) {
-            case VectorCombine::ROWS: {
-                auto bufsize = localResults[o]->bufferSize();
-                auto data = result->getValues(&alloc_desc);
-                data += result->getRowSkip() * rowStart;
-                CHECK_CUDART(cudaMemcpy(data, localResults[o]->getValues(&alloc_desc), bufsize, cudaMemcpyDeviceToDevice));
-//                debugPrintCUDABuffer("TaskCUDA: accumulate outputs", localResults[o]->getValues(&alloc_desc), localResults[o]->getNumItems());
-                break;
-            }
+            case VectorCombine::ROWS:
             case VectorCombine::COLS: {
-                auto res_base_ptr = result->getValues(&alloc_desc);
-                auto lres_data_base_ptr = localResults[o]->getValues(&alloc_desc);
-                auto rlen = rowEnd - rowStart;
-                auto slice = result->slice(0, this->_data._outRows[o], rowStart, rowEnd);
-                for(auto i = 0u; i < slice->getNumRows(); ++i) {
-                    auto data_src = lres_data_base_ptr + localResults[o]->getRowSkip() * i;
-//                    auto data_dst = res_base_ptr + result->getRowSkip() * i + rowStart;
-                    auto data_dst = res_base_ptr + result->getNumCols() * i + rowStart;
-//                    auto data_dst = res_base_ptr;
-                    CHECK_CUDART(cudaMemcpy(data_dst, data_src, sizeof(VT) * rlen, cudaMemcpyDeviceToDevice));
-                }
-                DataObjectFactory::destroy(slice);
+                // the part is copied straight into the host memory of the output, such that the parts of several
+                // devices (and of the CPU workers) need no further combination
+                const auto* lres = localResults[o];
+                auto [dst, dstRowSkip] = _dataSinks[o]->getResultBuffer(rowStart);
+                CHECK_CUDART(cudaMemcpy2D(dst, dstRowSkip * sizeof(VT), lres->getValues(&alloc_desc),
+                        lres->getRowSkip() * sizeof(VT), lres->getNumCols() * sizeof(VT), lres->getNumRows(),
+                        cudaMemcpyDeviceToHost));
                 break;
             }
-            case VectorCombine::ADD: {
+            case VectorCombine::ADD:
+            case VectorCombine::MIN:
+            case VectorCombine::MAX: {
+                // the parts are aggregated on the device
                 if(localAddRes[o] == nullptr) {
                     // take lres and reset it to nullptr
                     localAddRes[o] = localResults[o];
                     localResults[o] = nullptr;
                 }
                 else {
-                    CUDA::ewBinaryMat(BinaryOpCode::ADD, localAddRes[o], localAddRes[o], localResults[o], nullptr);
+                    CUDA::ewBinaryMat(getAggCombineOpCode(_data._combines[o]), localAddRes[o], localAddRes[o],
+                            localResults[o], _data._ctx);
                 }
                 break;
             }
@@ -17,24 +17,54 @@
 #pragma once
 
 #include "Tasks.h"
+#include <runtime/local/datastructures/AllocationDescriptorCUDA.h>
+#include <runtime/local/vectorized/VectorizedDataSink.h>
 
 template<class DT>
 class CompiledPipelineTaskCUDA : public CompiledPipelineTaskBase<DT> {};
 
 template<typename VT>
 class CompiledPipelineTaskCUDA<DenseMatrix<VT>> : public CompiledPipelineTaskBase<DenseMatrix<VT>> {
+    // the sinks of the row-wise and column-wise combines (nullptr for the aggregation combines)
+    std::vector<VectorizedDataSink<DenseMatrix<VT>>*>& _dataSinks;
+    // the partial results of the aggregation combines (add, min, max) of the device, guarded by the lock
     std::mutex &_resLock;
-    DenseMatrix<VT> ***_res;
+    std::vector<DenseMatrix<VT>*>& _addRes;
+    // the index of the device (in DaphneContext::cuda_contexts) this task runs on
+    const size_t _deviceID;
     using CompiledPipelineTaskBase<DenseMatrix<VT>>::_data;
 public:
-    CompiledPipelineTaskCUDA(CompiledPipelineTaskData<DenseMatrix<VT>> data, std::mutex &resLock, DenseMatrix<VT> ***res)
-            : CompiledPipelineTaskBase<DenseMatrix<VT>>(data), _resLock(resLock), _res(res) {}
+    CompiledPipelineTaskCUDA(CompiledPipelineTaskData<DenseMatrix<VT>> data,
+            std::vector<VectorizedDataSink<DenseMatrix<VT>>*>& dataSinks, std::mutex &resLock,
+            std::vector<DenseMatrix<VT>*>& addRes, size_t deviceID)
+            : CompiledPipelineTaskBase<DenseMatrix<VT>>(data), _dataSinks(dataSinks), _resLock(resLock),
+            _addRes(addRes), _deviceID(deviceID) {}
     
     void execute(uint32_t fid, uint32_t batchSize) override;
 
     uint64_t getTaskSize() override;
 
 private:
+    /**
+     * @brief Executes the batches of the task on separate CUDA streams for the host-to-device and device-to-host
+     * transfers, overlapping the kernels of one batch with the transfer of the inputs of the next and the results of
+     * the previous batch (via pinned staging buffers of the device).
+     */
+    void executeStreamPipelined(uint32_t fid, uint32_t batchSize);
+
+    /**
+     * @brief Executes the pipeline function on the inputs of one batch as a CUDA graph (see `CUDAContext::runCaptured`),
+     * keyed by the function and the shapes of the inputs, such that the batches of the same shapes only update and
+     * launch the graph of the first one.
+     *
+     * @return Whether the function was executed, otherwise it has to be executed without capturing.
+     */
+    bool executeCaptured(uint32_t fid, std::vector<DenseMatrix<VT>**>& outputs, std::vector<Structure *>& linputs,
+            const AllocationDescriptorCUDA& alloc_desc);
+
+    // aggregates the local results of the aggregation combines into the partial results of the device
+    void mergeAddResults(std::vector<DenseMatrix<VT>*>& localAddRes);
+
     void accumulateOutputs(std::vector<DenseMatrix<VT>*>& localResults, std::vector<DenseMatrix<VT> *> &localAddRes,
             uint64_t rowStart, uint64_t rowEnd);
 };
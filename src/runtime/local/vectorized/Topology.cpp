@@ -0,0 +1,202 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Topology.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
+
+#include <sched.h>
+
+namespace {
+    bool readLine(const std::string& path, std::string& line) {
+        std::ifstream file(path);
+        return file.is_open() && std::getline(file, line) && !line.empty();
+    }
+
+    int readInt(const std::string& path, int fallback) {
+        std::string line;
+        if(!readLine(path, line))
+            return fallback;
+        try {
+            return std::stoi(line);
+        }
+        catch(std::exception&) {
+            return fallback;
+        }
+    }
+
+    // the smallest CPU id in the given sysfs CPU list file, which identifies the group of CPUs it describes
+    int readGroupId(const std::string& path, int fallback) {
+        std::string line;
+        if(!readLine(path, line))
+            return fallback;
+        auto cpus = Topology::parseCpuList(line);
+        return cpus.empty() ? fallback : *std::min_element(cpus.begin(), cpus.end());
+    }
+
+    // maps arbitrary ids to dense indices in the order of their first appearance
+    class DenseIds {
+        std::map<int, int> _ids;
+    public:
+        int operator()(int id) {
+            return _ids.emplace(id, static_cast<int>(_ids.size())).first->second;
+        }
+        [[nodiscard]] size_t size() const { return _ids.size(); }
+    };
+}
+
+std::vector<int> Topology::parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while(pos < list.size()) {
+        auto end = list.find(',', pos);
+        if(end == std::string::npos)
+            end = list.size();
+        const std::string range = list.substr(pos, end - pos);
+        pos = end + 1;
+        if(range.find_first_of("0123456789") == std::string::npos)
+            continue;
+        auto dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for(int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::vector<int> Topology::getAffinityCpus() {
+    std::vector<int> cpus;
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0) {
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if(CPU_ISSET(cpu, &cpuset))
+                cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+Topology Topology::fromSysfs(const std::string& sysfsRoot, const std::vector<int>& allowedCpus) {
+    namespace fs = std::filesystem;
+    const std::string cpuDir = sysfsRoot + "/devices/system/cpu";
+    const std::string nodeDir = sysfsRoot + "/devices/system/node";
+
+    std::string onlineList;
+    std::vector<int> cpus;
+    if(readLine(cpuDir + "/online", onlineList))
+        cpus = parseCpuList(onlineList);
+    if(!allowedCpus.empty()) {
+        if(cpus.empty())
+            cpus = allowedCpus;
+        else {
+            std::set<int> allowed(allowedCpus.begin(), allowedCpus.end());
+            cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&](int cpu) { return !allowed.count(cpu); }),
+                    cpus.end());
+        }
+    }
+    if(cpus.empty()) {
+        for(unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++)
+            cpus.push_back(static_cast<int>(cpu));
+    }
+    std::sort(cpus.begin(), cpus.end());
+
+    std::map<int, int> cpuToNode;
+    std::error_code ec;
+    if(fs::is_directory(nodeDir, ec)) {
+        for(const auto& entry : fs::directory_iterator(nodeDir, ec)) {
+            const std::string name = entry.path().filename().string();
+            if(name.rfind("node", 0) != 0 || name.size() == 4 ||
+                    name.find_first_not_of("0123456789", 4) != std::string::npos)
+                continue;
+            std::string list;
+            if(readLine(entry.path().string() + "/cpulist", list))
+                for(int cpu : parseCpuList(list))
+                    cpuToNode[cpu] = std::stoi(name.substr(4));
+        }
+    }
+
+    Topology topo;
+    DenseIds sockets, nodes, cacheGroups, cores;
+    for(int cpu : cpus) {
+        const std::string dir = cpuDir + "/cpu" + std::to_string(cpu);
+        const int socket = readInt(dir + "/topology/physical_package_id", 0);
+        const int core = readGroupId(dir + "/topology/thread_siblings_list", cpu);
+
+        // the shared CPUs of the highest cache level describe the last-level cache domain
+        int llc = -1;
+        int llcLevel = 0;
+        for(int index = 0; fs::is_directory(dir + "/cache/index" + std::to_string(index), ec); index++) {
+            const std::string cacheDir = dir + "/cache/index" + std::to_string(index);
+            const int level = readInt(cacheDir + "/level", 0);
+            if(level >= llcLevel) {
+                int group = readGroupId(cacheDir + "/shared_cpu_list", -1);
+                if(group >= 0) {
+                    llc = group;
+                    llcLevel = level;
+                }
+            }
+        }
+
+        auto node = cpuToNode.find(cpu);
+        CpuInfo info{};
+        info.cpu = cpu;
+        info.socket = sockets(socket);
+        info.numaNode = nodes(node == cpuToNode.end() ? socket : node->second);
+        // without cache information, the socket is the best guess for the shared-cache domain
+        info.cacheGroup = cacheGroups(llc >= 0 ? llc : -1 - socket);
+        info.core = cores(core);
+        topo._cpus.push_back(info);
+    }
+    topo._numSockets = sockets.size();
+    topo._numNumaNodes = nodes.size();
+    topo._numCacheGroups = cacheGroups.size();
+    topo._numCores = cores.size();
+    return topo;
+}
+
+const Topology& Topology::get() {
+    static const Topology topology = fromSysfs("/sys", getAffinityCpus());
+    return topology;
+}
+
+std::vector<CpuInfo> Topology::getCoreCpus() const {
+    std::vector<CpuInfo> res;
+    std::vector<bool> seen(_numCores, false);
+    for(const auto& info : _cpus) {
+        if(!seen[info.core]) {
+            seen[info.core] = true;
+            res.push_back(info);
+        }
+    }
+    return res;
+}
+
+std::vector<int> Topology::getSmtSiblings(int cpu) const {
+    std::vector<int> res;
+    auto it = std::find_if(_cpus.begin(), _cpus.end(), [cpu](const CpuInfo& info) { return info.cpu == cpu; });
+    if(it == _cpus.end())
+        return res;
+    for(const auto& info : _cpus)
+        if(info.core == it->core)
+            res.push_back(info.cpu);
+    return res;
+}
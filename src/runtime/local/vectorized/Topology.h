@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The location of one logical CPU in the machine hierarchy.
+ *
+ * Except for `cpu`, all ids are dense indices starting at 0 (the n-th distinct socket, NUMA node, etc. among the
+ * usable CPUs), such that they can directly be used to address per-domain data structures like task queues.
+ */
+struct CpuInfo {
+    // the OS id of the logical CPU, as used by sched_setaffinity()
+    int cpu;
+    int socket;
+    int numaNode;
+    // CPUs sharing the last-level cache (usually L3)
+    int cacheGroup;
+    // CPUs sharing one physical core (SMT siblings)
+    int core;
+};
+
+/**
+ * @brief The CPU topology of the node this process runs on, restricted to the CPUs the process may run on.
+ *
+ * The topology is read from sysfs (/sys/devices/system/cpu and /sys/devices/system/node) and limited to the
+ * CPU affinity mask of the process, so cgroup/cpuset restrictions (e.g., in containers or Slurm allocations) are
+ * honoured. If sysfs is not available, every usable CPU is treated as its own core on a single socket.
+ */
+class Topology {
+    std::vector<CpuInfo> _cpus;
+    size_t _numSockets = 0;
+    size_t _numNumaNodes = 0;
+    size_t _numCacheGroups = 0;
+    size_t _numCores = 0;
+
+public:
+    /**
+     * @brief Reads the topology rooted at the given sysfs directory, keeping only the given CPUs.
+     *
+     * @param sysfsRoot The directory containing `devices/system/...`, usually `/sys`.
+     * @param allowedCpus The OS ids of the usable CPUs; an empty vector means all online CPUs.
+     */
+    static Topology fromSysfs(const std::string& sysfsRoot, const std::vector<int>& allowedCpus);
+
+    /**
+     * @brief Returns the topology of this process, which is detected once on first use.
+     */
+    static const Topology& get();
+
+    /**
+     * @brief Returns the OS ids of the CPUs in the affinity mask of the calling thread.
+     */
+    static std::vector<int> getAffinityCpus();
+
+    /**
+     * @brief Parses a sysfs CPU list like `0-3,8,10-11`.
+     */
+    static std::vector<int> parseCpuList(const std::string& list);
+
+    [[nodiscard]] const std::vector<CpuInfo>& getCpus() const { return _cpus; }
+    [[nodiscard]] size_t getNumCpus() const { return _cpus.size(); }
+    [[nodiscard]] size_t getNumSockets() const { return _numSockets; }
+    [[nodiscard]] size_t getNumNumaNodes() const { return _numNumaNodes; }
+    [[nodiscard]] size_t getNumCacheGroups() const { return _numCacheGroups; }
+    [[nodiscard]] size_t getNumCores() const { return _numCores; }
+
+    /**
+     * @brief Returns the usable CPUs skipping all but the first SMT sibling of every core.
+     */
+    [[nodiscard]] std::vector<CpuInfo> getCoreCpus() const;
+
+    /**
+     * @brief Returns the OS ids of the usable CPUs on the same physical core as the given CPU (including itself).
+     */
+    [[nodiscard]] std::vector<int> getSmtSiblings(int cpu) const;
+};
@@ -17,24 +17,250 @@
 #pragma once
 
 #include <ir/daphneir/Daphne.h>
-#include <runtime/local/kernels/Transpose.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
 #include <util/preprocessor_defs.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using mlir::daphne::VectorCombine;
 
+/**
+ * @brief Whether the parts of the tasks of an output are aggregated element-wise (add, min, or max combine) instead of
+ * being placed side by side.
+ */
+inline bool isAggCombine(VectorCombine combine) {
+    return combine == VectorCombine::ADD || combine == VectorCombine::MIN || combine == VectorCombine::MAX;
+}
+
+// the element-wise operation aggregating two parts of an output of the given aggregation combine
+inline BinaryOpCode getAggCombineOpCode(VectorCombine combine) {
+    switch (combine) {
+    case VectorCombine::ADD: return BinaryOpCode::ADD;
+    case VectorCombine::MIN: return BinaryOpCode::MIN;
+    case VectorCombine::MAX: return BinaryOpCode::MAX;
+    default:
+        throw std::runtime_error("VectorCombine case `" + std::to_string(static_cast<int64_t>(combine)) +
+                "` is not an aggregation");
+    }
+}
+
+// a dense index of the calling thread, such that the workers of a pipeline mostly use distinct partial results
+inline size_t getDataSinkThreadSlot() {
+    static std::atomic<size_t> nextSlot{0};
+    thread_local size_t slot = nextSlot++;
+    return slot;
+}
+
 template<typename DT>
 class VectorizedDataSink {
 public:
     void add(DT *matrix, size_t startRow) = delete;
 };
 
-// TODO: VectorizedDataSink for DenseMatrix
+/**
+ * @brief Collects the results of the tasks of a vectorized pipeline for one dense output.
+ *
+ * For row-wise and column-wise combines, the result is allocated up-front and every task copies its part straight
+ * into its own slice of it. Since these slices are disjoint, no synchronization is needed. For the aggregation combines
+ * (add, min, max), every worker thread accumulates the parts of its tasks into its own partial result, and `consume()`
+ * merges the partial results by a tree reduction, whose merges on the same level run in parallel for large outputs.
+ */
+template<typename VT>
+class VectorizedDataSink<DenseMatrix<VT>> {
+    // below this number of cells, merging two partial results is cheaper than starting a thread
+    static constexpr size_t PARALLEL_REDUCTION_THRESHOLD = 1 << 16;
+
+    VectorCombine _combine;
+    DenseMatrix<VT> *_result;
+    // fetched once, such that concurrent tasks do not touch the meta data of the result
+    VT *_resultValues = nullptr;
+    size_t _resultRowSkip = 0;
+    // for aggregation combines
+    BinaryOpCode _aggOpCode = BinaryOpCode::ADD;
+    std::vector<DenseMatrix<VT> *> _partials;
+    std::unique_ptr<std::mutex[]> _partialMtx;
+
+public:
+    /**
+     * @param combine The combine of the output.
+     * @param result For row-wise and column-wise combines, the allocated result the parts are copied into. For the
+     * aggregation combines, an optional initial value the partial results are aggregated into (may be `nullptr`).
+     * @param numPartials The number of partial results for the aggregation combines, usually the number of worker
+     * threads.
+     */
+    VectorizedDataSink(VectorCombine combine, DenseMatrix<VT> *result, size_t numPartials = 1)
+            : _combine(combine), _result(result) {
+        switch (_combine) {
+        case VectorCombine::ROWS:
+        case VectorCombine::COLS: {
+            if(_result == nullptr)
+                throw std::runtime_error("VectorizedDataSink: row-wise and column-wise combines need an allocated result");
+            _resultValues = _result->getValues();
+            _resultRowSkip = _result->getRowSkip();
+            break;
+        }
+        case VectorCombine::ADD:
+        case VectorCombine::MIN:
+        case VectorCombine::MAX: {
+            _aggOpCode = getAggCombineOpCode(_combine);
+            _partials.resize(std::max<size_t>(1, numPartials), nullptr);
+            _partialMtx = std::make_unique<std::mutex[]>(_partials.size());
+            break;
+        }
+        default: {
+            throw std::runtime_error(("VectorCombine case `" + std::to_string(static_cast<int64_t>(_combine)) +
+                    "` not supported"));
+        }
+        }
+    }
+
+    ~VectorizedDataSink() {
+        for(auto *partial : _partials)
+            if(partial)
+                DataObjectFactory::destroy(partial);
+    }
+
+    /**
+     * @brief Copies the part of a task into the result, starting at the given row (row-wise combine) or column
+     * (column-wise combine). The part stays owned by the caller.
+     */
+    void add(const DenseMatrix<VT> *matrix, uint64_t start) {
+        const VT *values = matrix->getValues();
+        const size_t rowSkip = matrix->getRowSkip();
+        const size_t numRows = matrix->getNumRows();
+        const size_t numCols = matrix->getNumCols();
+        if (_combine == VectorCombine::ROWS) {
+            VT *dst = _resultValues + start * _resultRowSkip;
+            if(rowSkip == numCols && _resultRowSkip == numCols)
+                std::memcpy(dst, values, numRows * numCols * sizeof(VT));
+            else
+                for(size_t r = 0; r < numRows; ++r)
+                    std::memcpy(dst + r * _resultRowSkip, values + r * rowSkip, numCols * sizeof(VT));
+        }
+        else if (_combine == VectorCombine::COLS) {
+            VT *dst = _resultValues + start;
+            for(size_t r = 0; r < numRows; ++r)
+                std::memcpy(dst + r * _resultRowSkip, values + r * rowSkip, numCols * sizeof(VT));
+        }
+        else {
+            throw std::runtime_error("VectorizedDataSink: add() is only supported for row-wise and column-wise "
+                    "combines, use addPartial() for the aggregation combines");
+        }
+    }
+
+    /**
+     * @brief Returns the memory of the result starting at the given row (row-wise combine) or column (column-wise
+     * combine) and the distance between its rows, e.g., to copy the part of a task from device memory directly.
+     */
+    std::pair<VT *, size_t> getResultBuffer(uint64_t start) const {
+        if (_combine == VectorCombine::ROWS)
+            return {_resultValues + start * _resultRowSkip, _resultRowSkip};
+        if (_combine == VectorCombine::COLS)
+            return {_resultValues + start, _resultRowSkip};
+        throw std::runtime_error("VectorizedDataSink: getResultBuffer() is only supported for row-wise and "
+                "column-wise combines");
+    }
+
+    /**
+     * @brief Aggregates the (locally aggregated) part of a task into the partial result of the calling thread and takes
+     * ownership of it.
+     */
+    void addPartial(DenseMatrix<VT> *matrix) {
+        if (!isAggCombine(_combine))
+            throw std::runtime_error("VectorizedDataSink: addPartial() is only supported for the aggregation "
+                    "combines");
+        const size_t slot = getDataSinkThreadSlot() % _partials.size();
+        std::unique_lock<std::mutex> lock(_partialMtx[slot]);
+        auto &partial = _partials[slot];
+        if(partial == nullptr)
+            partial = matrix;
+        else {
+            ewBinaryMat(_aggOpCode, partial, partial, matrix, nullptr);
+            DataObjectFactory::destroy(matrix);
+        }
+    }
+
+    /**
+     * @brief Returns the combined result. Must only be called once all tasks have finished.
+     *
+     * For the aggregation combines, the partial results are merged into the initial value (if any); the returned
+     * matrix is owned by the caller. Returns `nullptr` if neither an initial value nor any part was given.
+     */
+    DenseMatrix<VT> *consume() {
+        if (!isAggCombine(_combine))
+            return _result;
 
+        std::vector<DenseMatrix<VT> *> parts;
+        if(_result)
+            parts.push_back(_result);
+        for(auto *&partial : _partials) {
+            if(partial)
+                parts.push_back(partial);
+            partial = nullptr;
+        }
+        if(parts.empty())
+            return nullptr;
+
+        const size_t n = parts.size();
+        const bool parallel = parts[0]->getNumRows() * parts[0]->getNumCols() >= PARALLEL_REDUCTION_THRESHOLD;
+        for(size_t stride = 1; stride < n; stride *= 2) {
+            std::vector<std::thread> threads;
+            for(size_t i = 0; i + stride < n; i += 2 * stride) {
+                auto merge = [this, &parts, i, stride]() {
+                    auto *lhs = parts[i];
+                    ewBinaryMat(_aggOpCode, lhs, lhs, parts[i + stride], nullptr);
+                    DataObjectFactory::destroy(parts[i + stride]);
+                };
+                // the calling thread performs the last merge of each level itself
+                if(parallel && i + 2 * stride + stride < n)
+                    threads.emplace_back(merge);
+                else
+                    merge();
+            }
+            for(auto &t : threads)
+                t.join();
+        }
+        return parts[0];
+    }
+};
+
+/**
+ * @brief Collects the results of the tasks of a vectorized pipeline for one sparse output.
+ *
+ * By default, the parts are ordered by a priority queue (protected by a mutex if they are added concurrently) and
+ * copied into the result one after another. In slotted mode, every part is stored in the slot of its first row
+ * (row-wise combine) or column (column-wise combine) of a pre-sized array instead, which needs no synchronization
+ * since the parts of the tasks are disjoint. `consume()` then computes the row offsets of the result and copies the
+ * column indices and values of the parts in parallel.
+ *
+ * For the aggregation combines (add, min, max), every worker thread aggregates the parts of its tasks into its own
+ * partial result, like for dense outputs. `consume()` aggregates the partial results block of rows by block of rows
+ * in parallel, merging the sorted non-zeros of each row of all partial results at once. The aggregated cells that
+ * become zero are not stored.
+ */
 template<typename VT>
 class VectorizedDataSink<CSRMatrix<VT>> {
+public:
+    // executes func(0), ..., func(n-1), possibly in parallel
+    using ParallelFor = std::function<void(size_t, const std::function<void(size_t)>&)>;
+
+private:
+    // the number of rows handled together when merging column-wise parts in parallel
+    static constexpr size_t ROW_BLOCK_SIZE = 4096;
+
     using QueueElements = std::pair<size_t, CSRMatrix<VT> *>;
     VectorCombine _combine;
     std::priority_queue<QueueElements, std::vector<QueueElements>, std::greater<>> _results;
@@ -44,11 +270,59 @@ class VectorizedDataSink<CSRMatrix<VT>> {
     uint64_t _numNnz = 0;
     // for column-wise combine
     std::vector<size_t> _rowNnz;
+    // for slotted mode
+    bool _slotted;
+    std::vector<CSRMatrix<VT> *> _slots;
+    // for aggregation combines
+    BinaryOpCode _aggOpCode = BinaryOpCode::ADD;
+    CSRMatrix<VT> *_initial = nullptr;
+    std::vector<CSRMatrix<VT> *> _partials;
+    std::unique_ptr<std::mutex[]> _partialMtx;
 public:
-    VectorizedDataSink(VectorCombine combine, uint64_t numRows, uint64_t numCols)
-        : _combine(combine), _numRows(numRows), _numCols(numCols), _rowNnz(numRows) {}
+    /**
+     * @brief Creates a sink for a row-wise or column-wise combine of a result of the given size.
+     */
+    VectorizedDataSink(VectorCombine combine, uint64_t numRows, uint64_t numCols, bool slotted = false)
+        : _combine(combine), _numRows(numRows), _numCols(numCols), _rowNnz(slotted ? 0 : numRows), _slotted(slotted) {
+        if (_slotted)
+            _slots.resize(_combine == VectorCombine::COLS ? numCols : numRows, nullptr);
+    }
+
+    /**
+     * @brief Creates a sink for an aggregation combine.
+     *
+     * @param initial An optional initial value the parts are aggregated into (may be `nullptr`), which is owned by
+     * the sink from now on.
+     * @param numPartials The number of partial results, usually the number of worker threads.
+     */
+    VectorizedDataSink(VectorCombine combine, CSRMatrix<VT> *initial, size_t numPartials)
+        : _combine(combine), _slotted(false), _aggOpCode(getAggCombineOpCode(combine)), _initial(initial),
+          _partials(std::max<size_t>(1, numPartials), nullptr),
+          _partialMtx(std::make_unique<std::mutex[]>(_partials.size())) {}
+
+    ~VectorizedDataSink() {
+        for (auto *slot : _slots)
+            if (slot)
+                DataObjectFactory::destroy(slot);
+        if (_initial)
+            DataObjectFactory::destroy(_initial);
+        for (auto *partial : _partials)
+            if (partial)
+                DataObjectFactory::destroy(partial);
+    }
 
     void add(CSRMatrix<VT> *matrix, uint64_t startRow, bool multiThreaded = true) {
+        if (isAggCombine(_combine))
+            throw std::runtime_error("VectorizedDataSink: add() is only supported for row-wise and column-wise "
+                    "combines, use addPartial() for the aggregation combines");
+        if (_slotted) {
+            if (_combine != VectorCombine::ROWS && _combine != VectorCombine::COLS)
+                throw std::runtime_error("Vectorization of sparse matrices only implemented for row-wise combines");
+            if (startRow >= _slots.size() || _slots[startRow] != nullptr)
+                throw std::runtime_error("VectorizedDataSink: invalid or duplicate start of a part");
+            _slots[startRow] = matrix;
+            return;
+        }
         std::unique_lock<std::mutex> lock(_mtx, std::defer_lock);
         if (multiThreaded) {
             lock.lock();
@@ -75,7 +349,40 @@ public:
         }
     }
 
-    CSRMatrix<VT> *consume() {
+    /**
+     * @brief Aggregates the (locally aggregated) part of a task into the partial result of the calling thread and takes
+     * ownership of it.
+     */
+    void addPartial(CSRMatrix<VT> *matrix) {
+        if (!isAggCombine(_combine))
+            throw std::runtime_error("VectorizedDataSink: addPartial() is only supported for the aggregation "
+                    "combines");
+        const size_t slot = getDataSinkThreadSlot() % _partials.size();
+        std::unique_lock<std::mutex> lock(_partialMtx[slot]);
+        auto &partial = _partials[slot];
+        if (partial == nullptr)
+            partial = matrix;
+        else {
+            auto *merged = aggregate({partial, matrix}, nullptr);
+            DataObjectFactory::destroy(partial);
+            DataObjectFactory::destroy(matrix);
+            partial = merged;
+        }
+    }
+
+    /**
+     * @brief Returns the combined result. Must only be called once all parts were added.
+     *
+     * For the aggregation combines, returns `nullptr` if neither an initial value nor any part was given.
+     *
+     * @param parallelFor In slotted mode and for the aggregation combines, used to run the merge of the parts in
+     * parallel; if empty, the merge runs on the calling thread.
+     */
+    CSRMatrix<VT> *consume(const ParallelFor &parallelFor = nullptr) {
+        if (isAggCombine(_combine))
+            return consumeAggregated(parallelFor);
+        if (_slotted)
+            return consumeSlotted(parallelFor);
         if(_results.empty()) {
             throw std::runtime_error("Vectorized CSRMatrix without any iterations");
         }
@@ -142,4 +449,304 @@ public:
 
         return res;
     }
+
+private:
+    static void run(const ParallelFor &parallelFor, size_t n, const std::function<void(size_t)> &func) {
+        if (parallelFor)
+            parallelFor(n, func);
+        else
+            for (size_t i = 0; i < n; ++i)
+                func(i);
+    }
+
+    CSRMatrix<VT> *consumeAggregated(const ParallelFor &parallelFor) {
+        std::vector<CSRMatrix<VT> *> parts;
+        if (_initial)
+            parts.push_back(_initial);
+        _initial = nullptr;
+        for (auto *&partial : _partials) {
+            if (partial)
+                parts.push_back(partial);
+            partial = nullptr;
+        }
+        if (parts.empty())
+            return nullptr;
+        if (parts.size() == 1)
+            return parts[0];
+        auto *res = aggregate(parts, parallelFor);
+        for (auto *part : parts)
+            DataObjectFactory::destroy(part);
+        return res;
+    }
+
+    /**
+     * @brief Aggregates the parts element-wise into a new matrix, where a part without a non-zero in a cell
+     * contributes a zero (which matters for the min and max combines).
+     *
+     * The blocks of rows are aggregated independently. Within a row, the sorted non-zeros of all parts are merged by
+     * their column indexes, which needs no accumulator of the width of the matrix.
+     */
+    CSRMatrix<VT> *aggregate(const std::vector<CSRMatrix<VT> *> &parts, const ParallelFor &parallelFor) const {
+        const size_t numRows = parts[0]->getNumRows();
+        const size_t numCols = parts[0]->getNumCols();
+        for (auto *part : parts)
+            if (part->getNumRows() != numRows || part->getNumCols() != numCols)
+                throw std::runtime_error("VectorizedDataSink: the parts of an aggregation combine must have the same "
+                        "dimensions");
+        EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(_aggOpCode);
+
+        const size_t numBlocks = (numRows + ROW_BLOCK_SIZE - 1) / ROW_BLOCK_SIZE;
+        std::vector<size_t> rowNnz(numRows);
+        std::vector<std::vector<size_t>> blockColIdxs(numBlocks);
+        std::vector<std::vector<VT>> blockValues(numBlocks);
+        run(parallelFor, numBlocks, [&](size_t b) {
+            const size_t rowEnd = std::min<size_t>(numRows, (b + 1) * ROW_BLOCK_SIZE);
+            auto &colIdxs = blockColIdxs[b];
+            auto &values = blockValues[b];
+            // the position of every part in the current row, and the column of its next non-zero (smallest first)
+            std::vector<size_t> pos(parts.size());
+            std::vector<size_t> end(parts.size());
+            using Cursor = std::pair<size_t, size_t>;
+            std::priority_queue<Cursor, std::vector<Cursor>, std::greater<>> next;
+            for (size_t row = b * ROW_BLOCK_SIZE; row < rowEnd; ++row) {
+                for (size_t p = 0; p < parts.size(); ++p) {
+                    pos[p] = 0;
+                    end[p] = parts[p]->getNumNonZeros(row);
+                    if (end[p])
+                        next.emplace(parts[p]->getColIdxs(row)[0], p);
+                }
+                const size_t rowBegin = colIdxs.size();
+                while (!next.empty()) {
+                    const size_t colIdx = next.top().first;
+                    VT value = VT(0);
+                    size_t numParts = 0;
+                    while (!next.empty() && next.top().first == colIdx) {
+                        const size_t p = next.top().second;
+                        next.pop();
+                        const VT v = parts[p]->getValues(row)[pos[p]];
+                        value = numParts++ ? func(value, v, nullptr) : v;
+                        if (++pos[p] < end[p])
+                            next.emplace(parts[p]->getColIdxs(row)[pos[p]], p);
+                    }
+                    if (numParts < parts.size())
+                        value = func(value, VT(0), nullptr);
+                    if (value != VT(0)) {
+                        colIdxs.push_back(colIdx);
+                        values.push_back(value);
+                    }
+                }
+                rowNnz[row] = colIdxs.size() - rowBegin;
+            }
+        });
+
+        std::vector<size_t> blockNnzBegin(numBlocks + 1, 0);
+        for (size_t b = 0; b < numBlocks; ++b)
+            blockNnzBegin[b + 1] = blockNnzBegin[b] + blockColIdxs[b].size();
+        auto *res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, blockNnzBegin[numBlocks], false);
+        auto *resRowOff = res->getRowOffsets();
+        resRowOff[0] = 0;
+        for (size_t row = 0; row < numRows; ++row)
+            resRowOff[row + 1] = resRowOff[row] + rowNnz[row];
+        auto *resValues = res->getValues();
+        auto *resColIdxs = res->getColIdxs();
+        run(parallelFor, numBlocks, [&](size_t b) {
+            std::memcpy(resColIdxs + blockNnzBegin[b], blockColIdxs[b].data(),
+                blockColIdxs[b].size() * sizeof(*resColIdxs));
+            std::memcpy(resValues + blockNnzBegin[b], blockValues[b].data(),
+                blockValues[b].size() * sizeof(*resValues));
+        });
+        return res;
+    }
+
+    CSRMatrix<VT> *consumeSlotted(const ParallelFor &parallelFor) {
+        std::vector<QueueElements> parts;
+        for (size_t i = 0; i < _slots.size(); ++i) {
+            if (_slots[i]) {
+                parts.emplace_back(i, _slots[i]);
+                _slots[i] = nullptr;
+            }
+        }
+        if(parts.empty()) {
+            throw std::runtime_error("Vectorized CSRMatrix without any iterations");
+        }
+
+        size_t numNnz = 0;
+        for (auto &part : parts)
+            numNnz += part.second->getNumNonZeros();
+        auto *res = DataObjectFactory::create<CSRMatrix<VT>>(_numRows, _numCols, numNnz, false);
+        auto *resRowOff = res->getRowOffsets();
+        resRowOff[0] = 0;
+        auto *resValues = res->getValues();
+        auto *resColIdxs = res->getColIdxs();
+
+        if (_combine == VectorCombine::ROWS) {
+            // the position of the first non-zero of each part in the result
+            std::vector<size_t> partNnzBegin(parts.size() + 1, 0);
+            for (size_t i = 0; i < parts.size(); ++i)
+                partNnzBegin[i + 1] = partNnzBegin[i] + parts[i].second->getNumNonZeros();
+
+            run(parallelFor, parts.size(), [&](size_t i) {
+                auto rowStart = parts[i].first;
+                auto currMat = parts[i].second;
+                auto *currRowOff = currMat->getRowOffsets();
+                const size_t nnzBegin = partNnzBegin[i];
+                for (size_t row = 0; row < currMat->getNumRows(); ++row) {
+                    resRowOff[rowStart + row + 1] = nnzBegin + currRowOff[row + 1];
+                }
+                std::memcpy(resColIdxs + nnzBegin,
+                    currMat->getColIdxs(),
+                    currMat->getNumNonZeros() * sizeof(*resColIdxs));
+                std::memcpy(resValues + nnzBegin,
+                    currMat->getValues(),
+                    currMat->getNumNonZeros() * sizeof(*resValues));
+            });
+        }
+        else {
+            // every part spans all rows, so the rows are split into blocks, whose non-zeros are counted first
+            const size_t numBlocks = (_numRows + ROW_BLOCK_SIZE - 1) / ROW_BLOCK_SIZE;
+            std::vector<size_t> blockNnzBegin(numBlocks + 1, 0);
+            run(parallelFor, numBlocks, [&](size_t b) {
+                const size_t rowEnd = std::min<size_t>(_numRows, (b + 1) * ROW_BLOCK_SIZE);
+                size_t nnz = 0;
+                for (auto &part : parts) {
+                    auto *currRowOff = part.second->getRowOffsets();
+                    nnz += currRowOff[rowEnd] - currRowOff[b * ROW_BLOCK_SIZE];
+                }
+                blockNnzBegin[b + 1] = nnz;
+            });
+            for (size_t b = 0; b < numBlocks; ++b)
+                blockNnzBegin[b + 1] += blockNnzBegin[b];
+
+            // we start with first columns
+            run(parallelFor, numBlocks, [&](size_t b) {
+                const size_t rowEnd = std::min<size_t>(_numRows, (b + 1) * ROW_BLOCK_SIZE);
+                size_t pos = blockNnzBegin[b];
+                for (size_t row = b * ROW_BLOCK_SIZE; row < rowEnd; ++row) {
+                    for (auto &part : parts) {
+                        auto colStart = part.first;
+                        auto currMat = part.second;
+                        auto *currRowOff = currMat->getRowOffsets();
+                        auto *currValues = currMat->getValues();
+                        auto *currColIdxs = currMat->getColIdxs();
+                        auto offset = currRowOff[row];
+                        auto len = currRowOff[row + 1] - offset;
+                        std::memcpy(resValues + pos, currValues + offset, len * sizeof(*resValues));
+                        for (size_t i = 0; i < len; ++i) {
+                            resColIdxs[pos + i] = colStart + currColIdxs[offset + i];
+                        }
+                        pos += len;
+                    }
+                    resRowOff[row + 1] = pos;
+                }
+            });
+        }
+
+        for (auto &part : parts)
+            DataObjectFactory::destroy(part.second);
+        return res;
+    }
+};
+
+/**
+ * @brief Collects the results of the tasks of a vectorized pipeline for one frame output, which supports the row-wise
+ * combine only.
+ *
+ * The parts may have fewer rows than the rows they were computed from (e.g., by `filterRow`), so they cannot be
+ * copied into a result allocated up-front. Instead, every part is stored in the slot of the first row it was computed
+ * from, which needs no synchronization since the rows of the tasks are disjoint. `consume()` concatenates the parts in
+ * the order of their slots column by column, copying the parts in parallel.
+ */
+template<>
+class VectorizedDataSink<Frame> {
+public:
+    // executes func(0), ..., func(n-1), possibly in parallel
+    using ParallelFor = std::function<void(size_t, const std::function<void(size_t)>&)>;
+
+private:
+    std::vector<Frame *> _slots;
+
+public:
+    /**
+     * @param numSlots The number of rows the parts are computed from.
+     */
+    VectorizedDataSink(VectorCombine combine, uint64_t numSlots) : _slots(numSlots, nullptr) {
+        if (combine != VectorCombine::ROWS)
+            throw std::runtime_error("VectorizedDataSink: frames only support the row-wise combine, not `" +
+                    std::to_string(static_cast<int64_t>(combine)) + "`");
+    }
+
+    ~VectorizedDataSink() {
+        for (auto *slot : _slots)
+            if (slot)
+                DataObjectFactory::destroy(slot);
+    }
+
+    /**
+     * @brief Stores the part computed from the rows starting at the given one and takes ownership of it.
+     */
+    void add(Frame *frame, uint64_t startRow) {
+        if (startRow >= _slots.size() || _slots[startRow] != nullptr)
+            throw std::runtime_error("VectorizedDataSink: invalid or duplicate start of a part");
+        _slots[startRow] = frame;
+    }
+
+    /**
+     * @brief Returns the concatenated parts, with the schema and labels of the first one. Must only be called once
+     * all parts were added.
+     *
+     * @param parallelFor Used to copy the parts in parallel; if empty, they are copied on the calling thread.
+     */
+    Frame *consume(const ParallelFor &parallelFor = nullptr) {
+        std::vector<Frame *> parts;
+        for (auto *&slot : _slots) {
+            if (slot)
+                parts.push_back(slot);
+            slot = nullptr;
+        }
+        if (parts.empty())
+            throw std::runtime_error("Vectorized Frame without any iterations");
+
+        const Frame *first = parts[0];
+        const size_t numCols = first->getNumCols();
+        const ValueTypeCode *schema = first->getSchema();
+        // the first row of each part in the result
+        std::vector<size_t> partRowBegin(parts.size() + 1, 0);
+        for (size_t i = 0; i < parts.size(); ++i) {
+            if (parts[i]->getNumCols() != numCols ||
+                    !std::equal(schema, schema + numCols, parts[i]->getSchema()))
+                throw std::runtime_error("VectorizedDataSink: the parts of a frame must have the same schema");
+            partRowBegin[i + 1] = partRowBegin[i] + parts[i]->getNumRows();
+        }
+
+        auto *res = DataObjectFactory::create<Frame>(partRowBegin.back(), numCols, schema, first->getLabels(), false);
+        std::vector<uint8_t *> resCols(numCols);
+        for (size_t c = 0; c < numCols; ++c)
+            resCols[c] = static_cast<uint8_t *>(res->getColumnRaw(c));
+        auto copy = [&](size_t i) {
+            const Frame *part = parts[i];
+            const size_t numRows = part->getNumRows();
+            if (numRows == 0)
+                return;
+            for (size_t c = 0; c < numCols; ++c) {
+                const void *src = part->getColumnRaw(c);
+                if (schema[c] == ValueTypeCode::STR) {
+                    auto *strs = static_cast<const std::string *>(src);
+                    std::copy(strs, strs + numRows, reinterpret_cast<std::string *>(resCols[c]) + partRowBegin[i]);
+                }
+                else {
+                    const size_t vtBytes = ValueTypeUtils::sizeOf(schema[c]);
+                    std::memcpy(resCols[c] + partRowBegin[i] * vtBytes, src, numRows * vtBytes);
+                }
+            }
+        };
+        if (parallelFor)
+            parallelFor(parts.size(), copy);
+        else
+            for (size_t i = 0; i < parts.size(); ++i)
+                copy(i);
+
+        for (auto *part : parts)
+            DataObjectFactory::destroy(part);
+        return res;
+    }
 };
@@ -16,7 +16,7 @@
 
 #pragma once
 
-#include <runtime/local/vectorized/Tasks.h>
+#include <runtime/local/vectorized/Task.h>
 
 #include <thread>
 #include <sched.h>
@@ -38,14 +38,14 @@ public:
 
     // move assignment operator
     Worker& operator=(Worker&& obj)  noexcept {
-        if(t->joinable())
+        if(t && t->joinable())
             t->join();
         t = std::move(obj.t);
         return *this;
     }
 
     virtual ~Worker() {
-        if(t->joinable())
+        if(t && t->joinable())
             t->join();
     };
 
@@ -56,4 +56,10 @@ public:
     static bool isEOF(Task* t) {
         return dynamic_cast<EOFTask*>(t);
     }
+
+    // the NUMA node the calling thread is pinned to while it runs as a worker, -1 if it is not pinned
+    static int& currentNumaNode() {
+        static thread_local int node = -1;
+        return node;
+    }
 };
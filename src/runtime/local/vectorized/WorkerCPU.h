@@ -17,8 +17,15 @@
 #pragma once
 
 #include "Worker.h"
+#include <runtime/local/context/RunControl.h>
+#include <runtime/local/vectorized/BlasThreads.h>
+#include <runtime/local/vectorized/SchedulingTrace.h>
 #include <runtime/local/vectorized/TaskQueues.h>
 
+#include <array>
+#include <iostream>
+#include <vector>
+
 class WorkerCPU : public Worker {
     std::vector<TaskQueue*> _q;
     std::vector<int> _physical_ids;
@@ -32,30 +39,98 @@ class WorkerCPU : public Worker {
     int _queueMode;
     int _stealLogic;
     bool _pinWorkers;
+    // the pipeline of the SchedulingTrace this worker records to, 0 if not traced
+    uint32_t _traceId;
+    // the run whose cancellation is checked and whose progress is reported between the tasks, if any
+    RunControl* _control;
+    SchedulingTrace::WorkerStats _stats;
+
+    // the queue operations and the execution of tasks, which are recorded if the pipeline is traced
+
+    Task* dequeue(int queue) {
+        if(!_traceId)
+            return _q[queue]->dequeueTask();
+        const uint64_t begin = SchedulingTrace::now();
+        Task* t = _q[queue]->dequeueTask();
+        const uint64_t end = SchedulingTrace::now();
+        _stats.waitTicks += end - begin;
+        SchedulingTrace::get().record({begin, end, 0, _traceId, _threadID, queue, SchedulingTrace::EventType::WAIT});
+        return t;
+    }
+
+    Task* steal(int queue) {
+        Task* t = _q[queue]->stealTask();
+        if(_traceId && isEOF(t)) {
+            const uint64_t now = SchedulingTrace::now();
+            _stats.numFailedSteals++;
+            SchedulingTrace::get().record({now, now, 0, _traceId, _threadID, queue,
+                    SchedulingTrace::EventType::FAILED_STEAL});
+        }
+        return t;
+    }
+
+    void execute(Task* t, int queue, bool stolen) {
+        if(_control) {
+            // the queues of a cancelled run are drained without executing the remaining tasks
+            if(_control->isCancelled()) {
+                t->skip();
+                t->release();
+                return;
+            }
+            _control->addRows(t->getTaskSize());
+        }
+        if(!_traceId) {
+            t->execute(_fid, _batchSize);
+            t->release();
+            return;
+        }
+        const uint64_t size = t->getTaskSize();
+        const uint64_t begin = SchedulingTrace::now();
+        t->execute(_fid, _batchSize);
+        t->release();
+        const uint64_t end = SchedulingTrace::now();
+        _stats.busyTicks += end - begin;
+        _stats.lastEnd = end;
+        _stats.numTasks++;
+        _stats.numStolen += stolen;
+        _stats.numRows += size;
+        SchedulingTrace::get().record({begin, end, size, _traceId, _threadID, queue,
+                stolen ? SchedulingTrace::EventType::STOLEN_TASK : SchedulingTrace::EventType::TASK});
+    }
+
 public:
-    // this constructor is to be used in practice
+    // this constructor is to be used in practice; with startThread == false, no thread is started and the caller
+    // has to invoke run() on a thread it owns (e.g., a thread of the WorkerPool)
     WorkerCPU(std::vector<TaskQueue*> deques, std::vector<int> physical_ids, std::vector<int> unique_threads,
             bool verbose, uint32_t fid = 0, uint32_t batchSize = 100, int threadID = 0, int numQueues = 0,
-            int queueMode = 0, int stealLogic = 0, bool pinWorkers = 0) : Worker(), _q(deques),
-            _physical_ids(physical_ids), _unique_threads(unique_threads),
+            int queueMode = 0, int stealLogic = 0, bool pinWorkers = 0, bool startThread = true, uint32_t traceId = 0,
+            RunControl* control = nullptr) :
+            Worker(), _q(deques), _physical_ids(physical_ids), _unique_threads(unique_threads),
             _verbose(verbose), _fid(fid), _batchSize(batchSize), _threadID(threadID), _numQueues(numQueues),
-            _queueMode(queueMode), _stealLogic(stealLogic), _pinWorkers(pinWorkers) {
+            _queueMode(queueMode), _stealLogic(stealLogic), _pinWorkers(pinWorkers), _traceId(traceId),
+            _control(control) {
         // at last, start the thread
-        t = std::make_unique<std::thread>(&WorkerCPU::run, this);
+        if(startThread)
+            t = std::make_unique<std::thread>(&WorkerCPU::run, this);
     }
 
     ~WorkerCPU() override = default;
 
     void run() override {
+        // the kernels of the tasks call BLAS single-threaded, since the other workers occupy the other cores
+        BlasThreads::WorkerScope blasScope;
         if (_pinWorkers) {
-            // pin worker to CPU core
+            // pin worker to its CPU core (the CPU ids need not be contiguous, e.g., in a restricted cpuset)
             cpu_set_t cpuset;
             CPU_ZERO(&cpuset);
-            CPU_SET(_threadID, &cpuset);
+            CPU_SET(static_cast<size_t>(_threadID) < _unique_threads.size() ? _unique_threads[_threadID] : _threadID,
+                    &cpuset);
             sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
         }
 
         int currentDomain = _physical_ids[_threadID];
+        // the tasks read the copies of the broadcast inputs on this node, if any (see BroadcastReplicas)
+        currentNumaNode() = _pinWorkers ? currentDomain : -1;
         int targetQueue = _threadID;
         if( _queueMode == 0 ) {
             targetQueue = 0;
@@ -67,17 +142,18 @@ public:
             std::cout << "Error finding queue." << std::endl;
         }
         int startingQueue = targetQueue;
+        _stats = SchedulingTrace::WorkerStats();
+        _stats.worker = _threadID;
 
-        Task* t = _q[targetQueue]->dequeueTask();
+        Task* t = dequeue(targetQueue);
 
         while( !isEOF(t) ) {
             //execute self-contained task
             if( _verbose )
                 std::cerr << "WorkerCPU: executing task." << std::endl;
-            t->execute(_fid, _batchSize);
-            delete t;
+            execute(t, targetQueue, false);
             //get next tasks (blocking)
-            t = _q[targetQueue]->dequeueTask();
+            t = dequeue(targetQueue);
         }
 
         // All tasks from own queue have completed. Now stealing from other queues.
@@ -89,12 +165,11 @@ public:
                 targetQueue = (targetQueue+1)%_numQueues;
 
                 while ( targetQueue != startingQueue ) {
-                    t = _q[targetQueue]->dequeueTask();
+                    t = steal(targetQueue);
                     if( isEOF(t) ) {
                         targetQueue = (targetQueue+1)%_numQueues;
                     } else {
-                        t->execute(_fid, _batchSize);
-                        delete t;
+                        execute(t, targetQueue, true);
                     }
                 }
             } else if ( _stealLogic == 1) {
@@ -104,12 +179,11 @@ public:
 
                     while ( targetQueue != startingQueue ) {
                         if ( _physical_ids[targetQueue] == currentDomain ){
-                            t = _q[targetQueue]->dequeueTask();
+                            t = steal(targetQueue);
                             if( isEOF(t) ) {
                                 targetQueue = (targetQueue+1)%_numQueues;
                             } else {
-                                t->execute(_fid, _batchSize);
-                                delete t;
+                                execute(t, targetQueue, true);
                             }
                         } else {
                             targetQueue = (targetQueue+1)%_numQueues;
@@ -122,12 +196,11 @@ public:
                 targetQueue = (targetQueue+1)%_numQueues;
 
                 while ( targetQueue != startingQueue ) {
-                    t = _q[targetQueue]->dequeueTask();
+                    t = steal(targetQueue);
                     if( isEOF(t) ) {
                         targetQueue = (targetQueue+1)%_numQueues;
                     } else {
-                        t->execute(_fid, _batchSize);
-                        delete t;
+                        execute(t, targetQueue, true);
                     }
                 }
             } else if( _stealLogic == 2) {
@@ -137,13 +210,12 @@ public:
                 while( std::accumulate(eofWorkers.begin(), eofWorkers.end(), 0) < _numQueues ) {
                     targetQueue = rand() % _numQueues;
                     if( eofWorkers[targetQueue] == false ) {
-                        t = _q[targetQueue]->dequeueTask();
+                        t = steal(targetQueue);
                         //std::cout << "Execute task stolen from: " << targetQueue << std::endl;
                         if( isEOF(t) ) {
                             eofWorkers[targetQueue] = true;
                         } else {
-                            t->execute(_fid, _batchSize);
-                            delete t;
+                            execute(t, targetQueue, true);
                         }
                     }
                 }
@@ -163,12 +235,11 @@ public:
                         targetQueue = rand() % _numQueues;
                         if( _physical_ids[targetQueue] == currentDomain) {
                             if( eofWorkers[targetQueue] == false ) {
-                                t = _q[targetQueue]->dequeueTask();
+                                t = steal(targetQueue);
                                 if( isEOF(t) ) {
                                     eofWorkers[targetQueue] = true;
                                 } else {
-                                    t->execute(_fid, _batchSize);
-                                    delete t;
+                                    execute(t, targetQueue, true);
                                 }
                             }
                         }
@@ -182,12 +253,29 @@ public:
                     targetQueue = rand() % _numQueues;
                     // no need to check if they are on the other domain, because otherwise they would be EOF anyway
                     if( eofWorkers[targetQueue] == false ) {
-                        t = _q[targetQueue]->dequeueTask();
+                        t = steal(targetQueue);
                         if( isEOF(t) ) {
                             eofWorkers[targetQueue] = true;
                         } else {
-                            t->execute(_fid, _batchSize);
-                            delete t;
+                            execute(t, targetQueue, true);
+                        }
+                    }
+                }
+            } else if ( _stealLogic == 4) {
+                // Stealing in sequential order from same domain only, such that tasks stay on the NUMA node of their data
+                if ( _queueMode == 2 ) {
+                    targetQueue = (targetQueue+1)%_numQueues;
+
+                    while ( targetQueue != startingQueue ) {
+                        if ( _physical_ids[targetQueue] == currentDomain ){
+                            t = steal(targetQueue);
+                            if( isEOF(t) ) {
+                                targetQueue = (targetQueue+1)%_numQueues;
+                            } else {
+                                execute(t, targetQueue, true);
+                            }
+                        } else {
+                            targetQueue = (targetQueue+1)%_numQueues;
                         }
                     }
                 }
@@ -195,6 +283,8 @@ public:
         }
 
         // No more tasks available anywhere
+        if( _traceId )
+            SchedulingTrace::get().addWorkerStats(_traceId, _stats);
         if( _verbose )
             std::cerr << "WorkerCPU: received EOF, finalized." << std::endl;
     }
@@ -17,17 +17,32 @@
 #pragma once
 
 #include "Worker.h"
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/vectorized/SchedulingTrace.h>
 #include <runtime/local/vectorized/TaskQueues.h>
 
+#ifdef USE_CUDA
+#include <runtime/local/context/CUDAContext.h>
+#endif
+
 class WorkerGPU : public Worker {
     TaskQueue* _q;
     bool _verbose;
     uint32_t _fid;
     uint32_t _batchSize;
+    DCTX(_ctx);
+    // the index of the device (in DaphneContext::cuda_contexts) the tasks of this worker run on
+    size_t _deviceID;
+    // the pipeline of the SchedulingTrace this worker records to (0 if not traced) and its worker id in the trace,
+    // which follows the ones of the CPU workers
+    uint32_t _traceId;
+    int32_t _traceWorker;
 public:
     // this constructor is to be used in practice
-    WorkerGPU(TaskQueue* tq, bool verbose, uint32_t fid = 0, uint32_t batchSize = 100) : Worker(), _q(tq),
-            _verbose(verbose), _fid(fid), _batchSize(batchSize) {
+    WorkerGPU(TaskQueue* tq, bool verbose, uint32_t fid = 0, uint32_t batchSize = 100, DCTX(ctx) = nullptr,
+            size_t deviceID = 0, uint32_t traceId = 0, int32_t traceWorker = 0) : Worker(), _q(tq), _verbose(verbose),
+            _fid(fid), _batchSize(batchSize), _ctx(ctx), _deviceID(deviceID), _traceId(traceId),
+            _traceWorker(traceWorker) {
         // at last, start the thread
         t = std::make_unique<std::thread>(&WorkerGPU::run, this);
     }
@@ -35,17 +50,45 @@ public:
     ~WorkerGPU() override = default;
 
     void run() override {
+#ifdef USE_CUDA
+        if(_ctx)
+            CUDAContext::setCurrentDevice(_ctx, _deviceID);
+#endif
+        SchedulingTrace::WorkerStats stats;
+        stats.worker = _traceWorker;
+        uint64_t begin = _traceId ? SchedulingTrace::now() : 0;
         Task* t = _q->dequeueTask();
 
         while( !isEOF(t) ) {
+            uint64_t end = 0;
+            if( _traceId ) {
+                end = SchedulingTrace::now();
+                stats.waitTicks += end - begin;
+                SchedulingTrace::get().record({begin, end, 0, _traceId, _traceWorker, 0,
+                        SchedulingTrace::EventType::WAIT});
+            }
             //execute self-contained task
             if( _verbose )
                 std::cerr << "WorkerGPU: executing task." << std::endl;
+            const uint64_t size = _traceId ? t->getTaskSize() : 0;
             t->execute(_fid, _batchSize);
-            delete t;
+            t->release();
+            if( _traceId ) {
+                begin = end;
+                end = SchedulingTrace::now();
+                stats.busyTicks += end - begin;
+                stats.lastEnd = end;
+                stats.numTasks++;
+                stats.numRows += size;
+                SchedulingTrace::get().record({begin, end, size, _traceId, _traceWorker, 0,
+                        SchedulingTrace::EventType::TASK});
+                begin = end;
+            }
             //get next tasks (blocking)
             t = _q->dequeueTask();
         }
+        if( _traceId )
+            SchedulingTrace::get().addWorkerStats(_traceId, stats);
         if( _verbose )
             std::cerr << "WorkerGPU: received EOF, finalized." << std::endl;
     }
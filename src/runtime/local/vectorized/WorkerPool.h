@@ -0,0 +1,333 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/vectorized/LoadPartitioningDefs.h>
+#include <runtime/local/vectorized/Topology.h>
+#include <runtime/local/vectorized/WorkerCPU.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A latch that blocks `wait()` until `countDown()` was called the given number of times.
+ */
+class CompletionLatch {
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    uint64_t _count = 0;
+public:
+    void reset(uint64_t count) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _count = count;
+    }
+
+    void countDown() {
+        std::unique_lock<std::mutex> lock(_mtx);
+        if(--_count == 0)
+            _cv.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cv.wait(lock, [this]() { return _count == 0; });
+    }
+};
+
+/**
+ * @brief The parameters of one batch of tasks submitted to the `WorkerPool`, i.e., the task queues of one vectorized
+ * pipeline and how the workers shall process them.
+ */
+struct WorkerPoolJob {
+    std::vector<TaskQueue*> queues;
+    std::vector<int> physicalIds;
+    std::vector<int> uniqueThreads;
+    uint32_t batchSize;
+    int numQueues;
+    int queueMode;
+    int stealLogic;
+    bool pinWorkers;
+    bool verbose;
+    // the pipeline of the SchedulingTrace the workers record to, 0 if not traced
+    uint32_t traceId = 0;
+    // the run the workers check for cancellation and report their progress to, if any
+    RunControl* control = nullptr;
+};
+
+/**
+ * @brief A persistent pool of CPU worker threads shared by all vectorized pipelines executed with one `DaphneContext`.
+ *
+ * The pool is created once with the per-worker topology information, which later pipelines reuse instead of
+ * deriving it again. Threads are started on demand and kept alive. Each vectorized pipeline submits its task
+ * queues as one job and waits for its completion on a latch, instead of starting and joining a fresh set of threads.
+ * Only one job runs at a time; a pipeline that finds the pool busy (e.g., a nested pipeline started from within a
+ * task) falls back to its own threads.
+ */
+class WorkerPool final : public IContext {
+    std::vector<std::thread> _threads;
+    std::vector<int> _physicalIds;
+    std::vector<int> _uniqueThreads;
+    std::vector<int> _responsibleThreads;
+
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    WorkerPoolJob _job{};
+    size_t _numJobWorkers = 0;
+    uint64_t _epoch = 0;
+    bool _shutdown = false;
+    CompletionLatch _latch;
+    // serializes submit()/wait() pairs of different callers
+    std::mutex _jobMtx;
+
+    void threadMain(int threadID) {
+        uint64_t seenEpoch = 0;
+        while(true) {
+            WorkerPoolJob job;
+            bool participate;
+            {
+                std::unique_lock<std::mutex> lock(_mtx);
+                _cv.wait(lock, [&]() { return _shutdown || _epoch != seenEpoch; });
+                if(_shutdown)
+                    return;
+                seenEpoch = _epoch;
+                job = _job;
+                participate = static_cast<size_t>(threadID) < _numJobWorkers;
+            }
+            if(participate) {
+                WorkerCPU worker(job.queues, job.physicalIds, job.uniqueThreads, job.verbose, 0, job.batchSize, threadID,
+                        job.numQueues, job.queueMode, job.stealLogic, job.pinWorkers, false, job.traceId, job.control);
+                worker.run();
+                _latch.countDown();
+            }
+        }
+    }
+
+    void ensureThreads(size_t numThreads) {
+        while(_threads.size() < numThreads)
+            _threads.emplace_back(&WorkerPool::threadMain, this, static_cast<int>(_threads.size()));
+    }
+
+    // the pool shared by all contexts of the process, which is never destroyed, such that its idle threads do not
+    // need to be joined at exit
+    static std::unique_ptr<IContext>& persistentPool() {
+        static auto* pool = new std::unique_ptr<IContext>();
+        return *pool;
+    }
+
+    static std::mutex& persistentMutex() {
+        static auto* mtx = new std::mutex();
+        return *mtx;
+    }
+
+    WorkerPool(std::vector<int> physicalIds, std::vector<int> uniqueThreads, std::vector<int> responsibleThreads) :
+            _physicalIds(std::move(physicalIds)), _uniqueThreads(std::move(uniqueThreads)),
+            _responsibleThreads(std::move(responsibleThreads)) {}
+
+public:
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool() { destroy(); }
+
+    static std::unique_ptr<IContext> createWorkerPool(std::vector<int> physicalIds, std::vector<int> uniqueThreads,
+            std::vector<int> responsibleThreads) {
+        return std::unique_ptr<WorkerPool>(new WorkerPool(std::move(physicalIds), std::move(uniqueThreads),
+                std::move(responsibleThreads)));
+    }
+
+    static WorkerPool* get(DaphneContext* ctx) {
+        if(ctx->config.persistent_worker_pool) {
+            std::lock_guard<std::mutex> lock(persistentMutex());
+            return dynamic_cast<WorkerPool*>(persistentPool().get());
+        }
+        return dynamic_cast<WorkerPool*>(ctx->getWorkerPool());
+    }
+
+    /**
+     * @brief Derives the per-worker topology information from the process-wide `Topology`.
+     *
+     * Every worker gets one usable CPU (one per physical core unless hyperthreading is enabled). `physicalIds` holds
+     * the NUMA domain of each worker, `uniqueThreads` its CPU, and `responsibleThreads` the CPU on which the tasks of
+     * each queue are enqueued when workers are pinned.
+     */
+    static void deriveTopology(const DaphneUserConfig& config, std::vector<int>& physicalIds,
+            std::vector<int>& uniqueThreads, std::vector<int>& responsibleThreads) {
+        const Topology& topology = Topology::get();
+        auto cpus = config.hyperthreadingEnabled ? topology.getCpus() : topology.getCoreCpus();
+        auto scheme = config.queueSetupScheme;
+        // the NUMA-aware mode needs at least one queue per NUMA domain
+        if(scheme == CENTRALIZED && config.numaAware)
+            scheme = PERGROUP;
+        std::vector<bool> seenDomain(topology.getNumNumaNodes(), false);
+        for(const auto& cpu : cpus) {
+            physicalIds.push_back(cpu.numaNode);
+            uniqueThreads.push_back(cpu.cpu);
+            if ( scheme == PERGROUP ) {
+                if( !seenDomain[cpu.numaNode] ) {
+                    seenDomain[cpu.numaNode] = true;
+                    responsibleThreads.push_back(cpu.cpu);
+                }
+            } else if ( scheme == PERCPU || scheme == PERCPU_LOCKFREE ) {
+                responsibleThreads.push_back(cpu.cpu);
+            } else if ( scheme == CENTRALIZED ) {
+                responsibleThreads.push_back(cpus.front().cpu);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the pool of the given context, creating it on first use unless the user disabled the pool.
+     *
+     * With a persistent pool (see `DaphneUserConfig::persistent_worker_pool`), all contexts of the process share one
+     * pool, whose threads stay alive in between, e.g., the runs of the requests to the daphne server. Concurrent
+     * runs take turns on it or fall back to their own threads.
+     */
+    static WorkerPool* getOrCreate(DaphneContext* ctx) {
+        if(auto pool = get(ctx))
+            return pool;
+        if(!ctx->config.useWorkerPool)
+            return nullptr;
+        std::vector<int> physicalIds, uniqueThreads, responsibleThreads;
+        deriveTopology(ctx->config, physicalIds, uniqueThreads, responsibleThreads);
+        if(ctx->config.persistent_worker_pool) {
+            std::lock_guard<std::mutex> lock(persistentMutex());
+            if(!persistentPool())
+                persistentPool() = createWorkerPool(std::move(physicalIds), std::move(uniqueThreads),
+                        std::move(responsibleThreads));
+            return dynamic_cast<WorkerPool*>(persistentPool().get());
+        }
+        ctx->worker_pool = createWorkerPool(std::move(physicalIds), std::move(uniqueThreads),
+                std::move(responsibleThreads));
+        return get(ctx);
+    }
+
+    /**
+     * @brief Returns the number of workers `parallelFor()` uses for the given context at most (the number of threads
+     * of the user config, or else one per usable CPU), or 1 if there is no context or pool. Callers splitting their
+     * work, e.g., a file into byte ranges, use it to choose the number of pieces.
+     */
+    static size_t getNumWorkers(DaphneContext* ctx) {
+        WorkerPool* pool = ctx ? getOrCreate(ctx) : nullptr;
+        if(!pool)
+            return 1;
+        return ctx->config.numberOfThreads > 0 ? ctx->config.numberOfThreads : pool->getPhysicalIds().size();
+    }
+
+    /**
+     * @brief Executes `func(0)`, ..., `func(n-1)` on the pool of the given context (e.g., the chunks of a kernel
+     * outside of vectorized pipelines) and waits for their completion.
+     *
+     * The functions are executed in the calling thread if there is no context or pool, or if the pool is busy, e.g.,
+     * if the kernel runs within a task of a vectorized pipeline, which is parallel already. The first exception of a
+     * function is rethrown in the calling thread after all functions have finished.
+     */
+    static void parallelFor(DaphneContext* ctx, size_t n, const std::function<void(size_t)>& func) {
+        WorkerPool* pool = (ctx && n > 1) ? getOrCreate(ctx) : nullptr;
+        const size_t numWorkers = pool ? std::min(getNumWorkers(ctx), n) : 0;
+        if(numWorkers <= 1 || !pool->tryParallelFor(n, numWorkers, func, ctx->config.victimSelection)) {
+            for(size_t i = 0; i < n; i++)
+                func(i);
+        }
+    }
+
+    void destroy() override {
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _shutdown = true;
+            _cv.notify_all();
+        }
+        for(auto& t : _threads)
+            if(t.joinable())
+                t.join();
+        _threads.clear();
+    }
+
+    [[nodiscard]] const std::vector<int>& getPhysicalIds() const { return _physicalIds; }
+    [[nodiscard]] const std::vector<int>& getUniqueThreads() const { return _uniqueThreads; }
+    [[nodiscard]] const std::vector<int>& getResponsibleThreads() const { return _responsibleThreads; }
+    [[nodiscard]] size_t getNumThreads() const { return _threads.size(); }
+
+    /**
+     * @brief Hands the given task queues to the first `numWorkers` threads of the pool, starting additional threads
+     * if the pool is smaller. Returns immediately; use `wait()` to block until all workers have drained the queues.
+     *
+     * @return `false` if another job is still running, in which case nothing was submitted.
+     */
+    bool trySubmit(const WorkerPoolJob& job, size_t numWorkers) {
+        if(!_jobMtx.try_lock())
+            return false;
+        std::unique_lock<std::mutex> lock(_mtx);
+        ensureThreads(numWorkers);
+        _job = job;
+        _numJobWorkers = numWorkers;
+        _latch.reset(numWorkers);
+        _epoch++;
+        _cv.notify_all();
+        return true;
+    }
+
+    /**
+     * @brief Blocks until all workers of the job accepted by the last successful `trySubmit()` have finished.
+     */
+    void wait() {
+        _latch.wait();
+        _jobMtx.unlock();
+    }
+
+    /**
+     * @brief Executes `func(0)`, ..., `func(n-1)` on the first `numWorkers` threads of the pool and waits for their
+     * completion. The first exception of a function is rethrown after all functions have finished.
+     *
+     * @return `false` if another job is still running, in which case nothing was executed.
+     */
+    bool tryParallelFor(size_t n, size_t numWorkers, const std::function<void(size_t)>& func, int stealLogic = 0) {
+        BlockingTaskQueue q(n + 1);
+        std::vector<TaskQueue*> queues{&q};
+        WorkerPoolJob job{queues, _physicalIds, _uniqueThreads, 1, 1, 0, stealLogic, false, false};
+        // more workers than usable CPUs share the CPUs round-robin
+        for(size_t i = _physicalIds.size(); i < numWorkers; i++) {
+            job.physicalIds.push_back(_physicalIds[i % _physicalIds.size()]);
+            job.uniqueThreads.push_back(_uniqueThreads[i % _uniqueThreads.size()]);
+        }
+        if(!trySubmit(job, numWorkers))
+            return false;
+        // an exception must not leave a worker thread, which would terminate the process
+        std::exception_ptr error;
+        std::mutex mtxError;
+        for(size_t i = 0; i < n; i++)
+            q.enqueueTask(new FunctionTask([&func, &error, &mtxError, i]() {
+                try {
+                    func(i);
+                } catch(...) {
+                    std::lock_guard<std::mutex> lock(mtxError);
+                    if(!error)
+                        error = std::current_exception();
+                }
+            }));
+        q.closeInput();
+        wait();
+        if(error)
+            std::rethrow_exception(error);
+        return true;
+    }
+};
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <util/FlatHashMap.h>
+
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief The hashing of whole columns into a vector of 64-bit hashes, which
+ * all hash-based kernels (joins, group-by, Bloom filters, HyperLogLog
+ * sketches, and the hash partitioning of the distributed shuffle) share.
+ *
+ * The hash of a value is its `FlatHash`, and the hash of a tuple of several
+ * key columns is the hash of its first value combined with the hashes of the
+ * others (see `flatHashCombine()`). Thus, a hash computed here equals the
+ * hash of the single value by `FlatHash`, e.g., of a key looked up in a hash
+ * table built on a column. The numeric columns are hashed four values at a
+ * time with AVX2, if the build targets it, and the results do not depend on
+ * the instruction set, such that the workers of a distributed computation
+ * may partition their rows alike on different hardware.
+ *
+ * The frames have no null bitmaps, the missing values of floating-point
+ * columns are NaNs. All NaNs (and both zeros) have the same hash.
+ */
+namespace ColumnHash {
+
+#if defined(__AVX2__)
+    // the low 64 bits of the products of the lanes of a and c
+    inline __m256i mul64(__m256i a, uint64_t c) {
+#if defined(__AVX512DQ__) && defined(__AVX512VL__)
+        return _mm256_mullo_epi64(a, _mm256_set1_epi64x(c));
+#else
+        const __m256i cLo = _mm256_set1_epi64x(c & 0xffffffffULL);
+        const __m256i cHi = _mm256_set1_epi64x(c >> 32);
+        const __m256i lo = _mm256_mul_epu32(a, cLo);
+        const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), cLo),
+                _mm256_mul_epu32(a, cHi));
+        return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+#endif
+    }
+
+    // `flatHashMix()` of the lanes of h
+    inline __m256i mix4(__m256i h) {
+        h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+        h = mul64(h, 0xff51afd7ed558ccdULL);
+        h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+        h = mul64(h, 0xc4ceb9fe1a85ec53ULL);
+        return _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+    }
+
+    // the four values from v on as the 64-bit words `FlatHash` mixes
+    template<typename VT>
+    __m256i load4(const VT * v) {
+        if constexpr(std::is_same<VT, double>::value) {
+            __m256d x = _mm256_loadu_pd(v);
+            x = _mm256_andnot_pd(_mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_EQ_OQ), x);
+            x = _mm256_blendv_pd(x, _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN()),
+                    _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+            return _mm256_castpd_si256(x);
+        }
+        else if constexpr(std::is_same<VT, float>::value) {
+            __m128 x = _mm_loadu_ps(v);
+            x = _mm_andnot_ps(_mm_cmpeq_ps(x, _mm_setzero_ps()), x);
+            x = _mm_blendv_ps(x, _mm_set1_ps(std::numeric_limits<float>::quiet_NaN()), _mm_cmpunord_ps(x, x));
+            return _mm256_cvtepu32_epi64(_mm_castps_si128(x));
+        }
+        else if constexpr(sizeof(VT) == 8)
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v));
+        else if constexpr(sizeof(VT) == 4) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v));
+            return std::is_signed<VT>::value ? _mm256_cvtepi32_epi64(x) : _mm256_cvtepu32_epi64(x);
+        }
+        else {
+            static_assert(sizeof(VT) == 1, "unsupported width of a numeric column");
+            int32_t bytes;
+            memcpy(&bytes, v, 4);
+            const __m128i x = _mm_cvtsi32_si128(bytes);
+            return std::is_signed<VT>::value ? _mm256_cvtepi8_epi64(x) : _mm256_cvtepu8_epi64(x);
+        }
+    }
+#endif
+
+    /**
+     * @brief Writes the hashes of the values of a column to `hashes` (if
+     * `first`), or combines them into the hashes of the preceding key
+     * columns there.
+     *
+     * @param hashes The hashes, the one of `values[i]` at `hashes[i]`
+     * @param values The values of the column
+     * @param n The number of values
+     * @param first Whether the column is the first key column
+     */
+    template<typename VT>
+    void hashColumn(uint64_t * hashes, const VT * values, size_t n, bool first) {
+        const FlatHash<VT> hash;
+        size_t i = 0;
+#if defined(__AVX2__)
+        if constexpr(std::is_arithmetic<VT>::value) {
+            if(first)
+                for(; i + 4 <= n; i += 4)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(hashes + i), mix4(load4(values + i)));
+            else
+                for(; i + 4 <= n; i += 4) {
+                    // flatHashCombine(seed, h) = flatHashMix(seed * 31 + h)
+                    const __m256i seed = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hashes + i));
+                    const __m256i seed31 = _mm256_sub_epi64(_mm256_slli_epi64(seed, 5), seed);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(hashes + i),
+                            mix4(_mm256_add_epi64(seed31, mix4(load4(values + i)))));
+                }
+        }
+#endif
+        if(first)
+            for(; i < n; i++)
+                hashes[i] = hash(values[i]);
+        else
+            for(; i < n; i++)
+                hashes[i] = flatHashCombine(hashes[i], hash(values[i]));
+    }
+
+    /**
+     * @brief Writes the hashes of the values of a column, seeded by `seed`,
+     * to `hashes`, e.g., for independent sketches of the same values. The
+     * seeded hash of a value is `flatHashMix(FlatHash(value) ^ seed)`.
+     */
+    template<typename VT>
+    void hashColumnSeeded(uint64_t * hashes, const VT * values, size_t n, uint64_t seed) {
+        hashColumn(hashes, values, n, true);
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i s = _mm256_set1_epi64x(seed);
+        for(; i + 4 <= n; i += 4) {
+            const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hashes + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(hashes + i), mix4(_mm256_xor_si256(h, s)));
+        }
+#endif
+        for(; i < n; i++)
+            hashes[i] = flatHashMix(hashes[i] ^ seed);
+    }
+
+}
@@ -0,0 +1,399 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(USE_ARM_SIMD)
+#include <arm_neon.h>
+#endif
+
+// ****************************************************************************
+// Hash functions
+// ****************************************************************************
+
+/**
+ * @brief The 64-bit finalizer of MurmurHash3, which mixes all bits of `h`
+ * into all bits of the result.
+ */
+inline uint64_t flatHashMix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Combines the hash `h` of a value into the hash `seed` of the
+ * preceding values of a tuple.
+ */
+inline uint64_t flatHashCombine(uint64_t seed, uint64_t h) {
+    return flatHashMix(seed * 31 + h);
+}
+
+/**
+ * @brief Hashes the given bytes, eight at a time (like MurmurHash64A).
+ */
+inline uint64_t flatHashBytes(const void * data, size_t len) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const unsigned char * p = static_cast<const unsigned char *>(data);
+    uint64_t h = len * m;
+    for(; len >= 8; p += 8, len -= 8) {
+        uint64_t k;
+        memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> 47;
+        k *= m;
+        h = (h ^ k) * m;
+    }
+    if(len) {
+        uint64_t k = 0;
+        memcpy(&k, p, len);
+        h = (h ^ k) * m;
+    }
+    return flatHashMix(h);
+}
+
+/**
+ * @brief The default hash function of `FlatHashMap` and `FlatHashSet`, for
+ * arithmetic types and strings.
+ */
+template<typename K>
+struct FlatHash {
+    uint64_t operator()(const K & key) const {
+        if constexpr(std::is_same<K, std::string>::value || std::is_same<K, std::string_view>::value)
+            return flatHashBytes(key.data(), key.size());
+        else if constexpr(std::is_floating_point<K>::value) {
+            // -0.0 == 0.0, and all NaNs (the missing values) hash alike
+            K k = key == 0 ? 0 : key;
+            if(k != k)
+                k = std::numeric_limits<K>::quiet_NaN();
+            uint64_t bits = 0;
+            memcpy(&bits, &k, sizeof(K));
+            return flatHashMix(bits);
+        }
+        else {
+            static_assert(std::is_integral<K>::value, "FlatHash supports arithmetic types and strings only");
+            return flatHashMix(static_cast<uint64_t>(key));
+        }
+    }
+};
+
+// ****************************************************************************
+// Index
+// ****************************************************************************
+
+/**
+ * @brief An open-addressing hash table of the indexes 0, 1, ... of entries
+ * stored elsewhere, e.g., in a dense array.
+ *
+ * The slots are probed linearly in groups of 16. Each slot has a tag byte
+ * holding seven bits of the hash of its entry (or marking the slot as
+ * empty), such that a group is compared to the hash of a key with a few SIMD
+ * instructions and the entries are only compared to the key if their tags
+ * match. The hashes of the entries are kept, such that growing the table
+ * does not hash the entries again. Entries cannot be removed.
+ */
+class FlatHashIndex {
+public:
+    static constexpr size_t GROUP_SIZE = 16;
+
+private:
+    static constexpr uint8_t EMPTY = 0x80;
+
+    // the tag of each slot, followed by a copy of the tags of the first
+    // GROUP_SIZE slots, such that a group starting at any slot can be loaded
+    std::vector<uint8_t> tags;
+    std::vector<size_t> slots;
+    std::vector<uint64_t> hashes;
+    size_t mask;
+
+    // bits of the hash that neither choose the slot (in tables of up to 2^32
+    // slots) nor a partition in its highest bits
+    static uint8_t tagOf(uint64_t h) {
+        return (h >> 32) & 0x7f;
+    }
+
+    // the slots of the group starting at pos whose tag is tag, and the empty
+    // slots of the group, as bit masks
+    void matchGroup(size_t pos, uint8_t tag, uint32_t & matches, uint32_t & empties) const {
+#if defined(__SSE2__)
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags.data() + pos));
+        matches = _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag))));
+        empties = _mm_movemask_epi8(group);
+#elif defined(__ARM_NEON) && defined(USE_ARM_SIMD)
+        // NEON has no movemask, the lanes are weighted by their bits and summed up per half
+        static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        const uint8x16_t bits = vld1q_u8(weights);
+        const uint8x16_t group = vld1q_u8(tags.data() + pos);
+        const uint8x16_t eq = vandq_u8(vceqq_u8(group, vdupq_n_u8(tag)), bits);
+        const uint8x16_t empty = vandq_u8(vtstq_u8(group, vdupq_n_u8(EMPTY)), bits);
+        matches = vaddv_u8(vget_low_u8(eq)) | (uint32_t(vaddv_u8(vget_high_u8(eq))) << 8);
+        empties = vaddv_u8(vget_low_u8(empty)) | (uint32_t(vaddv_u8(vget_high_u8(empty))) << 8);
+#else
+        matches = 0;
+        empties = 0;
+        for(size_t i = 0; i < GROUP_SIZE; i++) {
+            matches |= uint32_t(tags[pos + i] == tag) << i;
+            empties |= uint32_t(tags[pos + i] == EMPTY) << i;
+        }
+#endif
+    }
+
+    void setTag(size_t slot, uint8_t tag) {
+        tags[slot] = tag;
+        if(slot < GROUP_SIZE)
+            tags[slots.size() + slot] = tag;
+    }
+
+    void allocate(size_t numSlots) {
+        tags.assign(numSlots + GROUP_SIZE, EMPTY);
+        slots.resize(numSlots);
+        mask = numSlots - 1;
+    }
+
+    // inserts the given index into the first empty slot of its probe sequence
+    void place(size_t idx) {
+        const uint64_t h = hashes[idx];
+        for(size_t pos = h & mask; ; pos = (pos + GROUP_SIZE) & mask) {
+            uint32_t matches, empties;
+            matchGroup(pos, 0, matches, empties);
+            if(empties) {
+                const size_t slot = (pos + __builtin_ctz(empties)) & mask;
+                setTag(slot, tagOf(h));
+                slots[slot] = idx;
+                return;
+            }
+        }
+    }
+
+    void grow() {
+        allocate(2 * slots.size());
+        for(size_t idx = 0; idx < hashes.size(); idx++)
+            place(idx);
+    }
+
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * @brief Creates an empty index with room for the given number of entries.
+     */
+    explicit FlatHashIndex(size_t expectedSize = 0) {
+        size_t numSlots = GROUP_SIZE;
+        while(numSlots * 3 < expectedSize * 4)
+            numSlots *= 2;
+        allocate(numSlots);
+    }
+
+    size_t size() const { return hashes.size(); }
+
+    uint64_t getHash(size_t idx) const { return hashes[idx]; }
+
+    /**
+     * @brief Returns the index of the entry with the hash `h` for which
+     * `isKey(index)` is true, or `npos`.
+     */
+    template<class IsKey>
+    size_t find(uint64_t h, IsKey isKey) const {
+        const uint8_t tag = tagOf(h);
+        for(size_t pos = h & mask; ; pos = (pos + GROUP_SIZE) & mask) {
+            uint32_t matches, empties;
+            matchGroup(pos, tag, matches, empties);
+            // the entries after the first empty slot are not in the probe sequence
+            if(empties)
+                matches &= (empties & (~empties + 1)) - 1;
+            for(; matches; matches &= matches - 1) {
+                const size_t idx = slots[(pos + __builtin_ctz(matches)) & mask];
+                if(hashes[idx] == h && isKey(idx))
+                    return idx;
+            }
+            if(empties)
+                return npos;
+        }
+    }
+
+    /**
+     * @brief Returns the index of the entry with the hash `h` for which
+     * `isKey(index)` is true, or adds the index `size()` with this hash.
+     *
+     * @return The index and whether it was added. The caller must append the
+     * entry of an added index to its entries.
+     */
+    template<class IsKey>
+    std::pair<size_t, bool> findOrInsert(uint64_t h, IsKey isKey) {
+        const size_t idx = find(h, isKey);
+        if(idx != npos)
+            return {idx, false};
+        hashes.push_back(h);
+        if(hashes.size() * 4 > slots.size() * 3)
+            grow();
+        else
+            place(hashes.size() - 1);
+        return {hashes.size() - 1, true};
+    }
+
+    void clear() {
+        hashes.clear();
+        allocate(GROUP_SIZE);
+    }
+};
+
+// ****************************************************************************
+// Map and set
+// ****************************************************************************
+
+/**
+ * @brief A hash map from keys to values, whose entries are stored in a dense
+ * array in the order of their insertion, see `FlatHashIndex`.
+ *
+ * Unlike `std::unordered_map`, the map does not allocate memory per entry
+ * and a lookup usually touches a single cache line of tags. Entries cannot be
+ * removed, and references to them are invalidated by insertions.
+ */
+template<typename K, typename V, class Hash = FlatHash<K>, class KeyEqual = std::equal_to<K>>
+class FlatHashMap {
+    FlatHashIndex index;
+    std::vector<std::pair<K, V>> entries;
+    Hash hash;
+    KeyEqual equal;
+
+public:
+    using value_type = std::pair<K, V>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    explicit FlatHashMap(size_t expectedSize = 0) : index(expectedSize) {
+        entries.reserve(expectedSize);
+    }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    /**
+     * @brief Inserts the key with the value constructed from the given
+     * arguments, unless the key is contained already.
+     *
+     * @return The position of the key's entry in the order of insertion and
+     * whether it was inserted.
+     */
+    template<typename... Args>
+    std::pair<size_t, bool> emplace(const K & key, Args &&... args) {
+        const auto [pos, inserted] = index.findOrInsert(hash(key),
+                [&](size_t i) { return equal(entries[i].first, key); });
+        if(inserted)
+            entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+        return {pos, inserted};
+    }
+
+    V & operator[](const K & key) {
+        return entries[emplace(key).first].second;
+    }
+
+    /**
+     * @brief Returns the value of the given key, or `nullptr` if the key is
+     * not contained.
+     */
+    V * find(const K & key) {
+        const size_t pos = index.find(hash(key), [&](size_t i) { return equal(entries[i].first, key); });
+        return pos == FlatHashIndex::npos ? nullptr : &entries[pos].second;
+    }
+
+    const V * find(const K & key) const {
+        return const_cast<FlatHashMap *>(this)->find(key);
+    }
+
+    bool contains(const K & key) const { return find(key) != nullptr; }
+
+    value_type & at(size_t pos) { return entries[pos]; }
+    const value_type & at(size_t pos) const { return entries[pos]; }
+
+    // the entries in the order of their insertion
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    void clear() {
+        index.clear();
+        entries.clear();
+    }
+};
+
+/**
+ * @brief A hash set, whose keys are stored in a dense array in the order of
+ * their insertion, see `FlatHashMap`.
+ */
+template<typename K, class Hash = FlatHash<K>, class KeyEqual = std::equal_to<K>>
+class FlatHashSet {
+    FlatHashIndex index;
+    std::vector<K> keys;
+    Hash hash;
+    KeyEqual equal;
+
+public:
+    using const_iterator = typename std::vector<K>::const_iterator;
+
+    explicit FlatHashSet(size_t expectedSize = 0) : index(expectedSize) {
+        keys.reserve(expectedSize);
+    }
+
+    size_t size() const { return keys.size(); }
+    bool empty() const { return keys.empty(); }
+
+    /**
+     * @brief Inserts the key, unless it is contained already.
+     *
+     * @return The position of the key in the order of insertion and whether
+     * it was inserted.
+     */
+    std::pair<size_t, bool> insert(const K & key) {
+        const auto [pos, inserted] = index.findOrInsert(hash(key),
+                [&](size_t i) { return equal(keys[i], key); });
+        if(inserted)
+            keys.push_back(key);
+        return {pos, inserted};
+    }
+
+    bool contains(const K & key) const {
+        return index.find(hash(key), [&](size_t i) { return equal(keys[i], key); }) != FlatHashIndex::npos;
+    }
+
+    // the keys in the order of their insertion
+    const_iterator begin() const { return keys.begin(); }
+    const_iterator end() const { return keys.end(); }
+
+    void clear() {
+        index.clear();
+        keys.clear();
+    }
+};
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A KLL sketch of the distribution of the numbers added to it, which
+ * answers quantile and rank queries with a small error in the rank.
+ *
+ * The sketch keeps a hierarchy of compactors. The items of level `h` stand
+ * for `2^h` added numbers each. A level over its capacity is compacted by
+ * sorting it and promoting every other item (starting at a random offset) to
+ * the next level. The capacities shrink geometrically (by 2/3) from the top
+ * level down, such that the sketch keeps `O(k)` items. Sketches of the same
+ * `k` are merged by concatenating their levels and compacting, e.g., the
+ * sketches of the chunks of a column computed on different threads or
+ * workers, which exchange their state (see `getState`).
+ *
+ * The rank of a number estimated by the sketch is within about 1.7% (as a
+ * fraction of all numbers) of its true rank with high probability at the
+ * default `k` = 200. NaNs (the missing values) are not added, the minimum and
+ * the maximum are exact.
+ */
+class KllSketch {
+public:
+    static constexpr size_t MIN_K = 8;
+    static constexpr size_t MAX_K = 1 << 16;
+    static constexpr size_t DEFAULT_K = 200;
+
+private:
+    size_t k;
+    // the number of numbers added
+    uint64_t n = 0;
+    double minValue = std::numeric_limits<double>::quiet_NaN();
+    double maxValue = std::numeric_limits<double>::quiet_NaN();
+    // the items of each level, the ones of level h have the weight 2^h
+    std::vector<std::vector<double>> levels;
+    size_t numItems = 0;
+    size_t totalCapacity = 0;
+    // the state of the generator of the offsets of the compactions
+    uint64_t rng;
+
+    static void checkK(size_t k) {
+        if(k < MIN_K || k > MAX_K)
+            throw std::runtime_error("KllSketch: k must be between " + std::to_string(MIN_K) + " and "
+                    + std::to_string(MAX_K) + ", but is " + std::to_string(k));
+    }
+
+    size_t capacity(size_t h) const {
+        const size_t depth = levels.size() - 1 - h;
+        return std::max<size_t>(2, static_cast<size_t>(std::ceil(k * std::pow(2.0 / 3.0, depth))));
+    }
+
+    void updateTotalCapacity() {
+        totalCapacity = 0;
+        for(size_t h = 0; h < levels.size(); h++)
+            totalCapacity += capacity(h);
+    }
+
+    bool randomBit() {
+        // xorshift64*
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        return (rng * 0x2545f4914f6cdd1dULL) >> 63;
+    }
+
+    void compact(size_t h) {
+        if(h + 1 == levels.size()) {
+            levels.emplace_back();
+            updateTotalCapacity();
+        }
+        std::vector<double> & level = levels[h];
+        std::vector<double> & up = levels[h + 1];
+        std::sort(level.begin(), level.end());
+        // an odd item stays at this level
+        const size_t begin = level.size() % 2;
+        const size_t numBefore = level.size() + up.size();
+        for(size_t i = begin + randomBit(); i < level.size(); i += 2)
+            up.push_back(level[i]);
+        level.resize(begin);
+        numItems -= numBefore - level.size() - up.size();
+    }
+
+    void compress() {
+        while(numItems > totalCapacity) {
+            size_t h = 0;
+            while(levels[h].size() < capacity(h))
+                h++;
+            compact(h);
+        }
+    }
+
+    // the items and their weights in ascending order of the items
+    std::vector<std::pair<double, uint64_t>> sortedItems() const {
+        std::vector<std::pair<double, uint64_t>> items;
+        items.reserve(numItems);
+        for(size_t h = 0; h < levels.size(); h++)
+            for(double v : levels[h])
+                items.emplace_back(v, uint64_t(1) << h);
+        std::sort(items.begin(), items.end());
+        return items;
+    }
+
+public:
+    explicit KllSketch(size_t k = DEFAULT_K, uint64_t seed = 0) : k(k), levels(1), rng(seed * 2 + 0x9e3779b97f4a7c15ULL) {
+        checkK(k);
+        updateTotalCapacity();
+    }
+
+    /**
+     * @brief Creates a sketch from the state of another one (see
+     * `getState`), e.g., one received from a distributed worker.
+     */
+    explicit KllSketch(const std::vector<double> & state) : k(0), rng(0x9e3779b97f4a7c15ULL) {
+        auto invalid = []() { return std::runtime_error("KllSketch: invalid state"); };
+        if(state.size() < 5)
+            throw invalid();
+        k = static_cast<size_t>(state[0]);
+        checkK(k);
+        n = static_cast<uint64_t>(state[1]);
+        minValue = state[2];
+        maxValue = state[3];
+        const size_t numLevels = static_cast<size_t>(state[4]);
+        if(numLevels == 0 || numLevels > 64 || state.size() < 5 + numLevels)
+            throw invalid();
+        levels.resize(numLevels);
+        size_t pos = 5 + numLevels;
+        uint64_t weight = 0;
+        for(size_t h = 0; h < numLevels; h++) {
+            const size_t size = static_cast<size_t>(state[5 + h]);
+            if(size > state.size() - pos)
+                throw invalid();
+            levels[h].assign(state.begin() + pos, state.begin() + pos + size);
+            pos += size;
+            numItems += size;
+            weight += uint64_t(size) << h;
+        }
+        if(pos != state.size() || weight != n)
+            throw invalid();
+        updateTotalCapacity();
+        compress();
+    }
+
+    size_t getK() const { return k; }
+
+    /**
+     * @brief The number of numbers added to this sketch and the sketches
+     * merged into it.
+     */
+    uint64_t getN() const { return n; }
+
+    bool empty() const { return n == 0; }
+
+    double getMin() const { return minValue; }
+
+    double getMax() const { return maxValue; }
+
+    /**
+     * @brief The state of this sketch as a vector of numbers, from which an
+     * equal sketch is created: `k`, the number of numbers, the minimum, the
+     * maximum, the number of levels, the number of items of each level, and
+     * the items of each level.
+     */
+    std::vector<double> getState() const {
+        std::vector<double> state = {double(k), double(n), minValue, maxValue, double(levels.size())};
+        for(const std::vector<double> & level : levels)
+            state.push_back(static_cast<double>(level.size()));
+        for(const std::vector<double> & level : levels)
+            state.insert(state.end(), level.begin(), level.end());
+        return state;
+    }
+
+    void add(double v) {
+        if(std::isnan(v))
+            return;
+        if(n == 0)
+            minValue = maxValue = v;
+        else {
+            minValue = std::min(minValue, v);
+            maxValue = std::max(maxValue, v);
+        }
+        n++;
+        levels[0].push_back(v);
+        if(++numItems > totalCapacity)
+            compress();
+    }
+
+    /**
+     * @brief Adds `numValues` numbers, `stride` apart from each other (e.g.,
+     * the values of a column of a matrix).
+     */
+    template<typename VT>
+    void add(const VT * values, size_t numValues, size_t stride = 1) {
+        for(size_t i = 0; i < numValues; i++)
+            add(static_cast<double>(values[i * stride]));
+    }
+
+    /**
+     * @brief Merges the given sketch of the same `k` into this one, such that
+     * this one sketches the numbers added to both.
+     */
+    void merge(const KllSketch & other) {
+        if(other.k != k)
+            throw std::runtime_error("KllSketch: cannot merge sketches of different k");
+        if(other.n == 0)
+            return;
+        if(n == 0) {
+            minValue = other.minValue;
+            maxValue = other.maxValue;
+        }
+        else {
+            minValue = std::min(minValue, other.minValue);
+            maxValue = std::max(maxValue, other.maxValue);
+        }
+        n += other.n;
+        if(other.levels.size() > levels.size()) {
+            levels.resize(other.levels.size());
+            updateTotalCapacity();
+        }
+        for(size_t h = 0; h < other.levels.size(); h++) {
+            levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+            numItems += other.levels[h].size();
+        }
+        compress();
+    }
+
+    /**
+     * @brief Returns the estimated fraction of the numbers that are less than
+     * (or equal to, if `inclusive`) `v`.
+     */
+    double rank(double v, bool inclusive = true) const {
+        if(n == 0)
+            return std::numeric_limits<double>::quiet_NaN();
+        uint64_t weight = 0;
+        for(size_t h = 0; h < levels.size(); h++)
+            for(double item : levels[h])
+                weight += (inclusive ? item <= v : item < v) ? uint64_t(1) << h : 0;
+        return static_cast<double>(weight) / static_cast<double>(n);
+    }
+
+    /**
+     * @brief Returns the estimated `q`-quantiles of the numbers for the given
+     * fractions `q` in [0, 1], i.e., the smallest numbers whose rank is at
+     * least `q`, or NaNs if the sketch is empty.
+     */
+    std::vector<double> quantiles(const std::vector<double> & qs) const {
+        for(double q : qs)
+            if(!(q >= 0 && q <= 1))
+                throw std::runtime_error("KllSketch: a quantile must be in [0, 1], but is " + std::to_string(q));
+        std::vector<double> res(qs.size(), std::numeric_limits<double>::quiet_NaN());
+        if(n == 0)
+            return res;
+        const std::vector<std::pair<double, uint64_t>> items = sortedItems();
+        std::vector<uint64_t> cumWeights(items.size());
+        uint64_t cum = 0;
+        for(size_t i = 0; i < items.size(); i++)
+            cumWeights[i] = cum += items[i].second;
+        for(size_t j = 0; j < qs.size(); j++) {
+            if(qs[j] == 0)
+                res[j] = minValue;
+            else if(qs[j] == 1)
+                res[j] = maxValue;
+            else {
+                const double target = qs[j] * static_cast<double>(n);
+                const size_t i = std::lower_bound(cumWeights.begin(), cumWeights.end(), target,
+                        [](uint64_t w, double t) { return static_cast<double>(w) < t; }) - cumWeights.begin();
+                res[j] = items[std::min(i, items.size() - 1)].first;
+            }
+        }
+        return res;
+    }
+
+    double quantile(double q) const {
+        return quantiles({q})[0];
+    }
+
+    /**
+     * @brief Returns the `numBuckets - 1` inner bounds of an equi-depth
+     * histogram of the numbers, i.e., the `i / numBuckets`-quantiles.
+     */
+    std::vector<double> equiDepthBounds(size_t numBuckets) const {
+        std::vector<double> qs;
+        for(size_t i = 1; i < numBuckets; i++)
+            qs.push_back(static_cast<double>(i) / static_cast<double>(numBuckets));
+        return quantiles(qs);
+    }
+};
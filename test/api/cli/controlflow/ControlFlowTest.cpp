@@ -35,5 +35,5 @@ const std::string dirPath = "test/api/cli/controlflow/";
     }
 
 MAKE_TEST_CASE("if", 8)
-MAKE_TEST_CASE("for", 23)
-MAKE_TEST_CASE("while", 16)
\ No newline at end of file
+MAKE_TEST_CASE("for", 26)
+MAKE_TEST_CASE("while", 16)
@@ -26,6 +26,9 @@
 
 #include <grpcpp/grpcpp.h>
 
+#include <sys/wait.h>
+
+#include <chrono>
 #include<thread>
 
 const std::string dirPath = "test/api/cli/distributed/";
@@ -43,7 +46,7 @@ TEST_CASE("Simple distributed execution test", TAG_DISTRIBUTED)
 
     SECTION("Execution of distributed scripts"){
         // TODO Make these script individual DYNAMIC_SECTIONs.
-        for (auto i = 1u; i < 4; ++i) {
+        for (auto i = 1u; i < 7; ++i) {
             auto filename = dirPath + "distributed_" + std::to_string(i) + ".daphne";
 
             std::stringstream outLocal;
@@ -65,6 +68,37 @@ TEST_CASE("Simple distributed execution test", TAG_DISTRIBUTED)
             CHECK(outLocal.str() == outDist.str());
         }
     }
+    SECTION("Execution of distributed scripts with a failed worker"){
+        // A third worker, which fails before the scripts run, such that their pipelines fail at it and run again at
+        // the other two.
+        auto addr3 = "0.0.0.0:50053";
+        auto pid3 = runProgramInBackground(nullFd, nullFd, "build/src/runtime/distributed/worker/DistributedWorker", "DistributedWorker", addr3);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        kill(pid3, SIGKILL);
+        waitpid(pid3, NULL, 0);
+        auto configPath = dirPath + "fault_tolerance.json";
+        for (auto i = 1u; i < 7; ++i) {
+            auto filename = dirPath + "distributed_" + std::to_string(i) + ".daphne";
+
+            std::stringstream outLocal;
+            std::stringstream errLocal;
+            int status = runDaphne(outLocal, errLocal, filename.c_str());
+
+            CHECK(errLocal.str() == "");
+            REQUIRE(status == StatusCode::SUCCESS);
+            // distributed run
+            auto envVar = "DISTRIBUTED_WORKERS";
+            std::stringstream outDist;
+            std::stringstream errDist;
+            setenv(envVar, (distWorkerStr + ',' + addr3).c_str(), 1);
+            status = runDaphne(outDist, errDist, "--vec", "--config", configPath.c_str(), filename.c_str());
+            unsetenv(envVar);
+            CHECK(errDist.str() == "");
+            REQUIRE(status == StatusCode::SUCCESS);
+
+            CHECK(outLocal.str() == outDist.str());
+        }
+    }
     // SECTION("Distributed read operation"){
     //     auto filenameLocal = dirPath + "distributedRead/readLocalMat.daphne";
     //     auto filenameDistr = dirPath + "distributedRead/readDistrMat.daphne";
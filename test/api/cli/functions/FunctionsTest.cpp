@@ -51,4 +51,5 @@ MAKE_TEST_CASE("typed", 3)
 MAKE_TEST_CASE("untyped", 4)
 MAKE_TEST_CASE("mixtyped", 2)
 MAKE_TEST_CASE("early_return", 3)
+MAKE_TEST_CASE("inlining", 1)
 MAKE_INVALID_TEST_CASE("invalid_parser", 7, StatusCode::PARSER_ERROR)
@@ -18,8 +18,13 @@
 #include <tags.h>
 
 #include <catch.hpp>
+
+#include <filesystem>
+#include <fstream>
 #include <string>
 
+#include <unistd.h>
+
 const std::string dirPath = "test/api/cli/import/";
 const char* configFilePath = "test/api/cli/import/UserConfig.json";
 
@@ -43,3 +48,29 @@ const char* configFilePath = "test/api/cli/import/UserConfig.json";
 
 MAKE_SUCCESS_TEST_CASE("import", 4)
 MAKE_FAILURE_TEST_CASE("import", 5)
+
+TEST_CASE("import, parse cache", TAG_IMPORT) {
+    const std::string cacheDir = "/tmp/daphne-parse-cache-test-" + std::to_string(getpid());
+    const std::string cacheArg = "--parse-cache-dir=" + cacheDir;
+    const std::string configArg = std::string("--config=").append(configFilePath);
+
+    SECTION("the cached IR is reused") {
+        // the first run fills the cache, the second one reuses it
+        for(int i = 0; i < 2; i++)
+            compareDaphneToRef(dirPath + "import_success_1.txt", dirPath + "import_success_1.daphne",
+                               configArg.c_str(), cacheArg.c_str());
+        CHECK(std::distance(std::filesystem::directory_iterator(cacheDir), std::filesystem::directory_iterator())
+                == 1);
+    }
+    SECTION("a changed import invalidates the cached IR") {
+        const std::string scriptDir = cacheDir + "-scripts";
+        std::filesystem::create_directories(scriptDir);
+        std::ofstream(scriptDir + "/main.daphne") << "import \"lib.daphne\";\nprint(lib.x);\n";
+        std::ofstream(scriptDir + "/lib.daphne") << "x = 1;\n";
+        compareDaphneToStr("1\n", scriptDir + "/main.daphne", cacheArg.c_str());
+        std::ofstream(scriptDir + "/lib.daphne") << "x = 22;\n";
+        compareDaphneToStr("22\n", scriptDir + "/main.daphne", cacheArg.c_str());
+        std::filesystem::remove_all(scriptDir);
+    }
+    std::filesystem::remove_all(cacheDir);
+}
@@ -38,4 +38,24 @@ const std::string dirPath = "test/api/cli/inference/";
 MAKE_TEST_CASE("if_sparsity", 1);
 MAKE_TEST_CASE("for_sparsity", 1);
 MAKE_TEST_CASE("while_sparsity", 1);
+
+TEST_CASE("sparse_chain", TAG_INFERENCE) {
+    checkDaphneStatusCodeSimple(StatusCode::SUCCESS, dirPath, "sparse_chain", 1, "--select-matrix-repr");
+    checkDaphneStatusCodeSimple(
+            StatusCode::SUCCESS, dirPath, "sparse_chain", 1,
+            "--select-matrix-repr", "--sparse-cost-model", "--sparse-threshold", "0.25"
+    );
+    checkDaphneStatusCodeSimple(
+            StatusCode::SUCCESS, dirPath, "sparse_chain", 1,
+            "--select-matrix-repr", "--sparse-cost-model", "--sparsity-worst-case"
+    );
+}
+
+// the remainder after a filter of unknown result shape is compiled at run-time
+TEST_CASE("adaptive", TAG_INFERENCE) {
+    compareDaphneToRefSimple(dirPath, "adaptive", 1);
+    compareDaphneToRefSimple(dirPath, "adaptive", 1, "--adaptive");
+    compareDaphneToRefSimple(dirPath, "adaptive", 1, "--adaptive", "--select-matrix-repr");
+}
+
 // TODO: more complex checks
\ No newline at end of file
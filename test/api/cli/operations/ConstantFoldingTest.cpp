@@ -34,4 +34,4 @@ const std::string dirPath = "test/api/cli/operations/";
         } \
     }
 
-MAKE_TEST_CASE("constantFolding", 1)
\ No newline at end of file
+MAKE_TEST_CASE("constantFolding", 2)
\ No newline at end of file
@@ -50,6 +50,7 @@ MAKE_TEST_CASE("operator_slash", 1)
 MAKE_TEST_CASE("operator_times", 1)
 MAKE_TEST_CASE("rbind", 1)
 MAKE_TEST_CASE("replace", 1)
+MAKE_TEST_CASE("scalarOps", 1)
 MAKE_TEST_CASE("seq", 1)
 MAKE_TEST_CASE("solve", 1)
 MAKE_TEST_CASE("sqrt", 1)
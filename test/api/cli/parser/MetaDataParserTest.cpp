@@ -22,7 +22,13 @@
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/Frame.h>
 
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include <cmath>
 
 const std::string dirPath = "test/api/cli/parser/metadataFiles/";
 
@@ -115,3 +121,45 @@ TEST_CASE("Write proper meta data file for Frame", TAG_PARSER)
         std::filesystem::remove(metaDataFile);
     }
 }
+
+TEST_CASE("Write and read column statistics", TAG_PARSER)
+{
+    const std::filesystem::path dataFile(dirPath + "WriteColumnStatistics.csv");
+    const std::filesystem::path metaDataFile(dirPath + "WriteColumnStatistics.csv.meta");
+    std::ofstream(dataFile) << "1,0.5\n2,1.0\n";
+
+    std::vector<ValueTypeCode> schema = {ValueTypeCode::SI64, ValueTypeCode::F64};
+    std::vector<std::string> labels = {"foo", "bar"};
+    MetaDataParser::writeMetaData(dataFile, FileMetaData(2, 2, false, schema, labels));
+    CHECK(MetaDataParser::readMetaData(dataFile).columnStats.empty());
+
+    std::vector<ColumnStatistics> stats(2);
+    stats[0].numDistinct = 2;
+    stats[0].min = 1;
+    stats[0].max = 2;
+    stats[0].nullFraction = 0;
+    stats[0].histogram = {1.5};
+    // the second column has unknown statistics
+    MetaDataParser::writeColumnStatistics(dataFile, stats);
+    FileMetaData fmd = MetaDataParser::readMetaData(dataFile);
+    CHECK(fmd.labels == labels);
+    REQUIRE(fmd.columnStats.size() == 2);
+    CHECK(fmd.columnStats[0].numDistinct == 2);
+    CHECK(fmd.columnStats[0].min == 1);
+    CHECK(fmd.columnStats[0].max == 2);
+    CHECK(fmd.columnStats[0].nullFraction == 0);
+    CHECK(fmd.columnStats[0].histogram == std::vector<double>{1.5});
+    CHECK(fmd.columnStats[1].numDistinct == -1);
+    CHECK_FALSE(fmd.columnStats[1].hasRange());
+    CHECK(std::isnan(fmd.columnStats[1].nullFraction));
+
+    REQUIRE_THROWS(MetaDataParser::writeColumnStatistics(dataFile, std::vector<ColumnStatistics>(3)));
+
+    // the statistics of a changed file are dropped
+    std::ofstream(dataFile, std::ios::app) << "3,1.5\n";
+    CHECK(MetaDataParser::readMetaData(dataFile).columnStats.empty());
+
+    // cleanup
+    std::filesystem::remove(dataFile);
+    std::filesystem::remove(metaDataFile);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/StatusCode.h>
+#include <api/cli/Utils.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+const std::string dirPath = "test/api/cli/server/";
+
+TEST_CASE("server, scripts and functions", TAG_SERVER) {
+    const std::string socketPath = "/tmp/daphne-server-test-" + std::to_string(getpid()) + ".sock";
+    const std::string serveArg = "--serve=" + socketPath;
+    const std::string connectArg = "--connect=" + socketPath;
+    int nullFd = open("/dev/null", O_WRONLY);
+    // the clients wait for the server to listen
+    pid_t pid = runProgramInBackground(nullFd, nullFd, "build/bin/daphne", "daphne", "--vec", serveArg.c_str());
+
+    SECTION("a script is compiled once per distinct arguments") {
+        compareDaphneToStr("100\n", dirPath + "server_1.daphne", connectArg.c_str(), "--args", "x=1");
+        compareDaphneToStr("100\n", dirPath + "server_1.daphne", connectArg.c_str(), "--args", "x=1");
+        compareDaphneToStr("200\n", dirPath + "server_1.daphne", connectArg.c_str(), "--args", "x=2");
+    }
+    SECTION("a registered function is called") {
+        compareDaphneToStr("", dirPath + "server_1.daphne", connectArg.c_str(), "--register=double");
+        std::stringstream out;
+        std::stringstream err;
+        int status = runDaphne(out, err, connectArg.c_str(), "--call=double", "--args", "x=3");
+        CHECK(status == StatusCode::SUCCESS);
+        CHECK(out.str() == "300\n");
+        CHECK(err.str() == "");
+
+        status = runDaphne(out, err, connectArg.c_str(), "--call=unknown");
+        CHECK(status == StatusCode::PARSER_ERROR);
+    }
+    SECTION("a changed script is compiled again") {
+        const std::string scriptPath = "/tmp/daphne-server-test-" + std::to_string(getpid()) + ".daphne";
+        std::ofstream(scriptPath) << "print(1);\n";
+        compareDaphneToStr("1\n", scriptPath, connectArg.c_str());
+        std::ofstream(scriptPath) << "print(22);\n";
+        compareDaphneToStr("22\n", scriptPath, connectArg.c_str());
+        std::filesystem::remove(scriptPath);
+    }
+
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    close(nullFd);
+    std::filesystem::remove(socketPath);
+}
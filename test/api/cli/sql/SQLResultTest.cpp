@@ -34,4 +34,4 @@ const std::string dirPath = "test/api/cli/sql/";
         } \
     }
 
-MAKE_TEST_CASE("group", 1)
\ No newline at end of file
+MAKE_TEST_CASE("group", 3)
\ No newline at end of file
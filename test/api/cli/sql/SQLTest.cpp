@@ -94,5 +94,9 @@ MAKE_TEST_CASE("thetaJoin_lessEqual", 2)
 MAKE_TEST_CASE("thetaJoin_notEqual", 2)
 MAKE_TEST_CASE("thetaJoin_combinedCompare", 2)
 
+MAKE_TEST_CASE("optimize", 1)
+
+MAKE_TEST_CASE("expr", 1)
+
 
 // TODO Use the scripts testing failure cases.
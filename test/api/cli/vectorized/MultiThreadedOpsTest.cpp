@@ -50,6 +50,7 @@ MAKE_TEST_CASE_SPARSE("runColAggSparse")
 MAKE_TEST_CASE("runIndexing", "", "--vec")
 MAKE_TEST_CASE("runReorganization", "", "--vec")
 MAKE_TEST_CASE("runOther", "", "--vec")
+MAKE_TEST_CASE("runFrame", "", "--vec")
 
 //ToDo: make these tests work
 //#ifdef USE_CUDA
@@ -65,4 +65,14 @@ void compareDaphneToDaphneOtherArgs(const std::string &scriptFilePath) {
         } \
     }
 
-MAKE_TEST_CASE("pipeline", 6)
\ No newline at end of file
+#define MAKE_FAILURE_TEST_CASE(name, count) \
+    TEST_CASE(name ", failure", TAG_VECTORIZED) { \
+        for(unsigned i = 1; i <= count; i++) { \
+            DYNAMIC_SECTION(name "_failure_" << i << ".daphne") { \
+                checkDaphneFailsSimple(dirPath, name "_failure", i); \
+            } \
+        } \
+    }
+
+MAKE_TEST_CASE("pipeline", 8)
+MAKE_FAILURE_TEST_CASE("annotation", 3)
\ No newline at end of file
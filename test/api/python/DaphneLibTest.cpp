@@ -51,3 +51,8 @@ MAKE_TEST_CASE("random_matrix_functions")
 MAKE_TEST_CASE("scalar_ops")
 MAKE_TEST_CASE_SCALAR("numpy_matrix_ops")
 MAKE_TEST_CASE_SCALAR("numpy_matrix_ops_extended")
+MAKE_TEST_CASE_SCALAR("numpy_strided_view")
+MAKE_TEST_CASE_SCALAR("multi_output_compute")
+#ifdef USE_ARROW
+MAKE_TEST_CASE_SCALAR("pandas_frame_exchange")
+#endif
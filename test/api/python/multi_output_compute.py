@@ -0,0 +1,42 @@
+#!/usr/bin/python
+
+# -------------------------------------------------------------
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+# -------------------------------------------------------------
+
+
+import numpy as np
+from api.python.context.daphne_context import DaphneContext
+
+m1 = np.array(np.arange(12), dtype=np.double)
+m1.shape = (3, 4)
+daphne_context = DaphneContext()
+
+# One script computes the shared sub-DAG X - 1 once for all three outputs.
+X = daphne_context.from_numpy(m1)
+C = X - 1
+a, b, s = daphne_context.compute(C * 2, C + 1, (C * 2).sum())
+print(a.sum())
+print(b.sum())
+print(s)
+
+# A later script uses the computed C * 2 instead of computing it again.
+c = ((C * 2) * 3).compute()
+print(c.sum())
@@ -0,0 +1,42 @@
+#!/usr/bin/python
+
+# -------------------------------------------------------------
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+# -------------------------------------------------------------
+
+
+import pandas as pd
+from api.python.context.daphne_context import DaphneContext
+
+df = pd.DataFrame({
+    "x": [0.5, 1.5, 2.0, 4.0],
+    "id": [1, 2, 3, 4],
+    "name": ["a", "b", "c", "d"],
+    "kind": pd.Categorical(["u", "v", "u", "w"]),
+})
+daphne_context = DaphneContext()
+
+# The frame is passed to DAPHNE and back through Arrow's C data interface.
+F = daphne_context.from_pandas(df)
+r = F.rbind(F).to_pandas()
+print(r["x"].sum())
+print(r["id"].sum())
+print(len(r))
+print((r["kind"] == "u").sum())
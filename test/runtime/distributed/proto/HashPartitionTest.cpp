@@ -0,0 +1,108 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/distributed/proto/HashPartition.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+namespace {
+    // The partition of each row.
+    std::vector<size_t> getPartOfRows(const std::vector<std::vector<size_t>> &parts, size_t numRows) {
+        std::vector<size_t> partOfRows(numRows, parts.size());
+        for (size_t p = 0; p < parts.size(); p++)
+            for (size_t r : parts[p])
+                partOfRows[r] = p;
+        return partOfRows;
+    }
+}
+
+TEST_CASE("hashPartition", TAG_DISTRIBUTED) {
+    const ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::STR};
+    const std::string labels[] = {"a", "b", "c"};
+    const size_t numRows = 6;
+    auto frame = DataObjectFactory::create<Frame>(numRows, 3, schema, labels, false);
+    const int64_t a[] = {1, 2, 1, 3, 2, 1};
+    const double b[] = {0.0, 1.5, -0.0, 2.5, 1.5, 7.0};
+    const std::string c[] = {"x", "y", "x", "z", "w", "x"};
+    std::copy(a, a + numRows, static_cast<int64_t *>(frame->getColumnRaw(0)));
+    std::copy(b, b + numRows, static_cast<double *>(frame->getColumnRaw(1)));
+    std::copy(c, c + numRows, static_cast<std::string *>(frame->getColumnRaw(2)));
+
+    SECTION("all rows in ascending order") {
+        auto parts = hashPartition(frame, {"a"}, 4);
+        REQUIRE(parts.size() == 4);
+        std::vector<size_t> rows;
+        for (auto &part : parts) {
+            CHECK(std::is_sorted(part.begin(), part.end()));
+            rows.insert(rows.end(), part.begin(), part.end());
+        }
+        std::sort(rows.begin(), rows.end());
+        CHECK(rows == std::vector<size_t>({0, 1, 2, 3, 4, 5}));
+    }
+    SECTION("equal keys in the same partition") {
+        auto partOfRows = getPartOfRows(hashPartition(frame, {"a"}, 3), numRows);
+        CHECK(partOfRows[0] == partOfRows[2]);
+        CHECK(partOfRows[0] == partOfRows[5]);
+        CHECK(partOfRows[1] == partOfRows[4]);
+        // -0.0 == 0.0
+        partOfRows = getPartOfRows(hashPartition(frame, {"a", "b", "c"}, 5), numRows);
+        CHECK(partOfRows[0] == partOfRows[2]);
+        partOfRows = getPartOfRows(hashPartition(frame, {"c"}, 5), numRows);
+        CHECK(partOfRows[0] == partOfRows[5]);
+    }
+    SECTION("same partitions across frames") {
+        auto other = DataObjectFactory::create<Frame>(frame, 3, numRows, 1, std::vector<size_t>{0}.data());
+        auto partOfRows = getPartOfRows(hashPartition(frame, {"a"}, 7), numRows);
+        auto partOfRowsOther = getPartOfRows(hashPartition(other, {"a"}, 7), 3);
+        for (size_t r = 0; r < 3; r++)
+            CHECK(partOfRowsOther[r] == partOfRows[3 + r]);
+        DataObjectFactory::destroy(other);
+    }
+    SECTION("single partition") {
+        auto parts = hashPartition(frame, {"b"}, 1);
+        REQUIRE(parts.size() == 1);
+        CHECK(parts[0].size() == numRows);
+    }
+    SECTION("gather rows") {
+        auto res = gatherRows(frame, {4, 0}, {1, 0});
+        REQUIRE(res->getNumRows() == 2);
+        REQUIRE(res->getNumCols() == 2);
+        CHECK(res->getLabels()[0] == "b");
+        CHECK(res->getColumn<int64_t>(1)->get(0, 0) == 2);
+        CHECK(res->getColumn<double>(0)->get(1, 0) == 0.0);
+        DataObjectFactory::destroy(res);
+        res = gatherRows(frame, {3});
+        REQUIRE(res->getNumCols() == 3);
+        CHECK(static_cast<const std::string *>(res->getColumnRaw(2))[0] == "z");
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("errors") {
+        CHECK_THROWS(hashPartition(frame, {"a"}, 0));
+        CHECK_THROWS(hashPartition(frame, {"d"}, 2));
+    }
+
+    DataObjectFactory::destroy(frame);
+}
@@ -0,0 +1,147 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+TEMPLATE_PRODUCT_TEST_CASE("ProtoDataConverter, any matrix, round trip", TAG_DISTRIBUTED, (DenseMatrix, CSRMatrix),
+                           (double, float, int64_t, int32_t)) {
+    using DT = TestType;
+    auto mat = genGivenVals<DT>(5, {
+        0, 1, 0, 2,
+        0, 0, 0, 0,
+        3, 0, 4, 0,
+        0, 0, 0, 5,
+        6, 7, 0, 0,
+    });
+
+    SECTION("whole matrix") {
+        distributed::Matrix matProto;
+        convertMatrixToProto(mat, &matProto);
+        Structure *res = createMatrixFromProto(matProto);
+        auto resMat = dynamic_cast<DT *>(res);
+        REQUIRE(resMat != nullptr);
+        CHECK(*resMat == *mat);
+        DataObjectFactory::destroy(resMat);
+    }
+    SECTION("partition of rows") {
+        distributed::Matrix matProto;
+        convertMatrixToProto(mat, &matProto, 2, 5, 0, 4);
+        CHECK(matProto.num_rows() == 3);
+        auto exp = genGivenVals<DT>(3, {
+            3, 0, 4, 0,
+            0, 0, 0, 5,
+            6, 7, 0, 0,
+        });
+        Structure *res = createMatrixFromProto(matProto);
+        auto resMat = dynamic_cast<DT *>(res);
+        REQUIRE(resMat != nullptr);
+        CHECK(*resMat == *exp);
+        DataObjectFactory::destroy(resMat, exp);
+    }
+
+    DataObjectFactory::destroy(mat);
+}
+
+TEST_CASE("ProtoDataConverter, any matrix, unsupported value type", TAG_DISTRIBUTED) {
+    auto mat = DataObjectFactory::create<DenseMatrix<uint8_t>>(2, 2, true);
+    distributed::Matrix matProto;
+    CHECK_THROWS(convertMatrixToProto(mat, &matProto));
+    DataObjectFactory::destroy(mat);
+}
+
+TEST_CASE("ProtoDataConverter, frame, round trip", TAG_DISTRIBUTED) {
+    const ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::STR};
+    const std::string labels[] = {"k", "v", "s"};
+    auto frame = DataObjectFactory::create<Frame>(4, 3, schema, labels, false);
+    const int64_t keys[] = {1, 2, 3, 4};
+    const double values[] = {0.5, 1.5, 2.5, 3.5};
+    const std::string strings[] = {"a", "bb", "", "dddd"};
+    std::copy(keys, keys + 4, static_cast<int64_t *>(frame->getColumnRaw(0)));
+    std::copy(values, values + 4, static_cast<double *>(frame->getColumnRaw(1)));
+    std::copy(strings, strings + 4, static_cast<std::string *>(frame->getColumnRaw(2)));
+
+    SECTION("whole frame") {
+        distributed::Frame frameProto;
+        convertFrameToProto(frame, &frameProto);
+        Frame *res = createFrameFromProto(frameProto);
+        CHECK(*res == *frame);
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("rows with row ids") {
+        distributed::Frame frameProto;
+        convertFrameToProto(frame, &frameProto, 1, 3, "rid");
+        Frame *res = createFrameFromProto(frameProto);
+        REQUIRE(res->getNumRows() == 2);
+        REQUIRE(res->getNumCols() == 4);
+        CHECK(res->getLabels()[3] == "rid");
+        CHECK(res->getColumnType(3) == ValueTypeCode::UI64);
+        CHECK(res->getColumn<int64_t>("k")->get(0, 0) == 2);
+        CHECK(static_cast<const std::string *>(res->getColumnRaw(2))[1] == "");
+        CHECK(res->getColumn<uint64_t>("rid")->get(0, 0) == 1);
+        CHECK(res->getColumn<uint64_t>("rid")->get(1, 0) == 2);
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("gathered rows") {
+        distributed::Frame frameProto;
+        convertFrameToProto(frame, &frameProto, std::vector<size_t>{3, 0});
+        Frame *res = createFrameFromProto(frameProto);
+        REQUIRE(res->getNumRows() == 2);
+        CHECK(res->getColumn<int64_t>("k")->get(0, 0) == 4);
+        CHECK(res->getColumn<double>("v")->get(1, 0) == 0.5);
+        CHECK(static_cast<const std::string *>(res->getColumnRaw(2))[0] == "dddd");
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("several messages") {
+        distributed::Frame frameProto0, frameProto1, frameProto2;
+        convertFrameToProto(frame, &frameProto0, 0, 1);
+        convertFrameToProto(frame, &frameProto1, 1, 1);
+        convertFrameToProto(frame, &frameProto2, 1, 4);
+        Frame *res = createFrameFromProto(std::vector<const distributed::Frame *>{&frameProto0, &frameProto1,
+                                                                                 &frameProto2});
+        CHECK(*res == *frame);
+        DataObjectFactory::destroy(res);
+
+        distributed::Frame frameProtoRowIds;
+        convertFrameToProto(frame, &frameProtoRowIds, 0, 1, "rid");
+        CHECK_THROWS(createFrameFromProto(std::vector<const distributed::Frame *>{&frameProto0, &frameProtoRowIds}));
+    }
+    SECTION("no rows") {
+        distributed::Frame frameProto;
+        convertFrameToProto(frame, &frameProto, std::vector<size_t>{});
+        Frame *res = createFrameFromProto(frameProto);
+        CHECK(res->getNumRows() == 0);
+        CHECK(res->getNumCols() == 3);
+        DataObjectFactory::destroy(res);
+    }
+
+    DataObjectFactory::destroy(frame);
+}
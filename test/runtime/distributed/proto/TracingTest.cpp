@@ -0,0 +1,77 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <runtime/distributed/proto/Tracing.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <fstream>
+#include <string>
+
+#include <cstdio>
+
+#include <unistd.h>
+
+TEST_CASE("TraceContext, traceparent header", TAG_DISTRIBUTED) {
+    auto &tracing = Tracing::get();
+    const TraceContext context{tracing.newId(16), tracing.newId(8)};
+    CHECK(context.traceId.size() == 32);
+    CHECK(context.spanId.size() == 16);
+
+    const std::string header = context.toHeader();
+    CHECK(header.size() == 55);
+    const TraceContext parsed = TraceContext::fromHeader(header);
+    CHECK(parsed.isValid());
+    CHECK(parsed.traceId == context.traceId);
+    CHECK(parsed.spanId == context.spanId);
+
+    CHECK_FALSE(TraceContext::fromHeader("").isValid());
+    CHECK_FALSE(TraceContext::fromHeader("00-xyz").isValid());
+    CHECK_FALSE(TraceContext::fromHeader("00-" + std::string(32, 'g') + "-" + context.spanId + "-01").isValid());
+}
+
+TEST_CASE("Tracing, trace of a job", TAG_DISTRIBUTED) {
+    auto &tracing = Tracing::get();
+    CHECK_FALSE(tracing.getCurrent().isValid());
+    tracing.startTrace();
+    const TraceContext root = tracing.getCurrent();
+    CHECK(root.isValid());
+    tracing.endTrace("job");
+    CHECK_FALSE(tracing.getCurrent().isValid());
+}
+
+TEST_CASE("Tracing, reopened by a later context", TAG_DISTRIBUTED) {
+    auto &tracing = Tracing::get();
+    const std::string first = "/tmp/daphne-tracing-test-" + std::to_string(getpid()) + "-1.json";
+    const std::string second = "/tmp/daphne-tracing-test-" + std::to_string(getpid()) + "-2.json";
+    tracing.open(first, "coordinator");
+    tracing.open(second, "coordinator");
+    CHECK(tracing.isEnabled());
+    tracing.startTrace();
+    tracing.endTrace("job");
+
+    std::ifstream firstIn(first);
+    std::ifstream secondIn(second);
+    std::string line;
+    CHECK_FALSE(std::getline(firstIn, line));
+    REQUIRE(std::getline(secondIn, line));
+    CHECK(line.find("\"name\":\"job\"") != std::string::npos);
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+}
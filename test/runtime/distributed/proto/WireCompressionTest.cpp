@@ -0,0 +1,109 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <runtime/distributed/proto/ProtoDataConverter.h>
+#include <runtime/distributed/proto/WireCompression.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <cstddef>
+
+namespace {
+    std::vector<WireCompression> getCompressions() {
+        std::vector<WireCompression> compressions = {WireCompression::NONE, WireCompression::ADAPTIVE};
+#ifdef USE_LZ4
+        compressions.push_back(WireCompression::LZ4);
+#endif
+#ifdef USE_ZSTD
+        compressions.push_back(WireCompression::ZSTD);
+#endif
+        return compressions;
+    }
+}
+
+TEST_CASE("WireCompression, DenseMatrix, round trip", TAG_DISTRIBUTED) {
+    const size_t numRows = 300;
+    const size_t numCols = 20;
+    auto mat = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+    for (size_t r = 0; r < numRows; r++)
+        for (size_t c = 0; c < numCols; c++)
+            mat->set(r, c, static_cast<double>((r * c) % 7));
+
+    for (auto compression : getCompressions()) {
+        distributed::Matrix matProto;
+        ProtoDataConverter<DenseMatrix<double>>::convertToProto(mat, &matProto, 10, numRows, 0, numCols);
+        compressMatrix(&matProto, compression);
+        if (compression == WireCompression::NONE)
+            CHECK_FALSE(isCompressed(matProto));
+        else if (compression != WireCompression::ADAPTIVE)
+            CHECK(matProto.dense_matrix().raw_f64().size() < (numRows - 10) * numCols * sizeof(double));
+
+        auto res = DataObjectFactory::create<DenseMatrix<double>>(numRows - 10, numCols, false);
+        ProtoDataConverter<DenseMatrix<double>>::convertFromProto(matProto, res);
+        auto exp = DataObjectFactory::create<DenseMatrix<double>>(mat, 10, numRows, 0, numCols);
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(res, exp);
+    }
+    DataObjectFactory::destroy(mat);
+}
+
+TEST_CASE("WireCompression, CSRMatrix, round trip", TAG_DISTRIBUTED) {
+    const size_t numRows = 1000;
+    const size_t numCols = 1000;
+    auto mat = DataObjectFactory::create<CSRMatrix<double>>(numRows, numCols, 3 * numRows, true);
+    size_t *rowOffsets = mat->getRowOffsets();
+    size_t *colIdxs = mat->getColIdxs();
+    double *values = mat->getValues();
+    size_t nnz = 0;
+    rowOffsets[0] = 0;
+    for (size_t r = 0; r < numRows; r++) {
+        // the diagonal and a few cells to its right, except in every fifth row, which is empty
+        if (r % 5 != 0)
+            for (size_t c = r; c < std::min(numCols, r + 3); c++) {
+                colIdxs[nnz] = c;
+                values[nnz] = static_cast<double>(c % 4 + 1);
+                nnz++;
+            }
+        rowOffsets[r + 1] = nnz;
+    }
+
+    for (auto compression : getCompressions()) {
+        distributed::Matrix matProto;
+        ProtoDataConverter<CSRMatrix<double>>::convertToProto(mat, &matProto, 100, numRows, 0, numCols);
+        compressMatrix(&matProto, compression);
+        // the indexes are encoded as varints whenever the matrix is compressed
+        CHECK(isCompressed(matProto) == (compression != WireCompression::NONE));
+
+        distributed::Matrix decompressed;
+        const auto &plain = decompressMatrix(matProto, decompressed);
+        const size_t numNonZeros = plain.csr_matrix().raw_values_f64().size() / sizeof(double);
+        auto res = DataObjectFactory::create<CSRMatrix<double>>(numRows - 100, numCols, numNonZeros, true);
+        ProtoDataConverter<CSRMatrix<double>>::convertFromProto(matProto, res);
+        auto exp = DataObjectFactory::create<CSRMatrix<double>>(mat, 100, numRows);
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(res, exp);
+    }
+    DataObjectFactory::destroy(mat);
+}
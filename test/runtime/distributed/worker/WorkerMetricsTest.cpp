@@ -0,0 +1,58 @@
+/*
+ *  Copyright 2022 The DAPHNE Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <runtime/distributed/worker/WorkerMetrics.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <string>
+
+TEST_CASE("WorkerMetrics, Prometheus text format", TAG_DISTRIBUTED) {
+    WorkerMetrics metrics;
+    metrics.recordCall("Compute", 0.003, true, 100, 20);
+    metrics.recordCall("Compute", 2, false, 50, 0);
+    metrics.recordCall("Store", 0.0001, true, 1000, 10);
+    metrics.recordFragment(false, 0.5);
+    metrics.recordFragment(true);
+    metrics.recordFragment(true);
+    metrics.setResident(4096, 3);
+    metrics.beginCall();
+
+    const std::string text = metrics.render();
+    auto contains = [&text](const std::string &line) { return text.find(line + "\n") != std::string::npos; };
+    CHECK(contains("# TYPE daphne_worker_rpc_duration_seconds histogram"));
+    CHECK(contains("daphne_worker_rpcs_total{rpc=\"Compute\"} 2"));
+    CHECK(contains("daphne_worker_rpc_errors_total{rpc=\"Compute\"} 1"));
+    CHECK(contains("daphne_worker_received_bytes_total{rpc=\"Compute\"} 150"));
+    CHECK(contains("daphne_worker_sent_bytes_total{rpc=\"Store\"} 10"));
+    // the buckets are cumulative
+    CHECK(contains("daphne_worker_rpc_duration_seconds_bucket{rpc=\"Compute\",le=\"0.0025\"} 0"));
+    CHECK(contains("daphne_worker_rpc_duration_seconds_bucket{rpc=\"Compute\",le=\"0.005\"} 1"));
+    CHECK(contains("daphne_worker_rpc_duration_seconds_bucket{rpc=\"Compute\",le=\"1\"} 1"));
+    CHECK(contains("daphne_worker_rpc_duration_seconds_bucket{rpc=\"Compute\",le=\"5\"} 2"));
+    CHECK(contains("daphne_worker_rpc_duration_seconds_bucket{rpc=\"Compute\",le=\"+Inf\"} 2"));
+    CHECK(contains("daphne_worker_rpc_duration_seconds_bucket{rpc=\"Store\",le=\"0.0005\"} 1"));
+    CHECK(contains("daphne_worker_rpc_duration_seconds_sum{rpc=\"Compute\"} 2.003"));
+    CHECK(contains("daphne_worker_rpc_duration_seconds_count{rpc=\"Compute\"} 2"));
+    CHECK(contains("daphne_worker_fragment_cache_hits_total 2"));
+    CHECK(contains("daphne_worker_fragment_cache_misses_total 1"));
+    CHECK(contains("daphne_worker_compile_seconds_total 0.5"));
+    CHECK(contains("daphne_worker_resident_bytes 4096"));
+    CHECK(contains("daphne_worker_objects 3"));
+    CHECK(contains("daphne_worker_rpcs_in_flight 1"));
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/context/DeviceMemoryPool.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+
+namespace {
+    // host memory standing in for the device allocator, counting its calls
+    struct CountingAllocator {
+        size_t numAllocs = 0;
+        size_t numFrees = 0;
+        size_t limit = SIZE_MAX;
+        size_t allocated = 0;
+        std::map<void*, size_t> sizes;
+
+        std::shared_ptr<DeviceMemoryPool> createPool(size_t budget) {
+            return DeviceMemoryPool::create(budget,
+                    [this](size_t size) -> void* {
+                        if(allocated + size > limit)
+                            return nullptr;
+                        numAllocs++;
+                        allocated += size;
+                        void* ptr = std::malloc(size);
+                        sizes[ptr] = size;
+                        return ptr;
+                    },
+                    [this](void* ptr) {
+                        numFrees++;
+                        allocated -= sizes.at(ptr);
+                        sizes.erase(ptr);
+                        std::free(ptr);
+                    });
+        }
+    };
+}
+
+TEST_CASE("DeviceMemoryPool: size classes", TAG_DATASTRUCTURES) {
+    CHECK(DeviceMemoryPool::roundSize(0) == 512);
+    CHECK(DeviceMemoryPool::roundSize(1) == 512);
+    CHECK(DeviceMemoryPool::roundSize(513) == 1024);
+    CHECK(DeviceMemoryPool::roundSize(1 << 20) == 1 << 20);
+    // four classes per power of two above the small blocks
+    CHECK(DeviceMemoryPool::roundSize((1 << 20) + 1) == (5 << 18));
+    CHECK(DeviceMemoryPool::roundSize(3 << 20) == (3 << 20));
+    CHECK(DeviceMemoryPool::roundSize((4 << 20) + 1) == (5 << 20));
+    for(size_t size : {1000000ul, 3000000ul, 100000000ul}) {
+        auto rounded = DeviceMemoryPool::roundSize(size);
+        CHECK(rounded >= size);
+        CHECK(rounded < size + size / 4 + 1);
+    }
+}
+
+TEST_CASE("DeviceMemoryPool: released blocks are reused", TAG_DATASTRUCTURES) {
+    CountingAllocator allocator;
+    auto pool = allocator.createPool(1 << 30);
+
+    auto block = pool->allocate(1000);
+    auto* ptr = block.get();
+    block.reset();
+    CHECK(allocator.numFrees == 0);
+
+    // same size class
+    auto again = pool->allocate(900);
+    CHECK(again.get() == ptr);
+    CHECK(allocator.numAllocs == 1);
+
+    auto stats = pool->getStatistics();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 1);
+    CHECK(stats.reservedBytes == 1024);
+    CHECK(stats.requestedBytes == 900);
+    CHECK(stats.getFragmentation() == Approx(1.0 - 900.0 / 1024.0));
+
+    // another size class
+    auto other = pool->allocate(5000);
+    CHECK(allocator.numAllocs == 2);
+}
+
+TEST_CASE("DeviceMemoryPool: free lists per stream", TAG_DATASTRUCTURES) {
+    CountingAllocator allocator;
+    auto pool = allocator.createPool(1 << 30);
+    int s1, s2;
+
+    pool->allocate(1000, &s1).reset();
+    // a block released on one stream is not reused by another one
+    auto onS2 = pool->allocate(1000, &s2);
+    CHECK(allocator.numAllocs == 2);
+    auto onS1 = pool->allocate(1000, &s1);
+    CHECK(allocator.numAllocs == 2);
+    CHECK(pool->getStatistics().hits == 1);
+}
+
+TEST_CASE("DeviceMemoryPool: budget", TAG_DATASTRUCTURES) {
+    CountingAllocator allocator;
+    auto pool = allocator.createPool(4096);
+
+    pool->allocate(2048).reset();
+    CHECK(pool->getStatistics().cachedBytes == 2048);
+    // exceeding the budget releases the cached blocks first
+    auto big = pool->allocate(3000);
+    CHECK(allocator.numFrees == 1);
+    auto stats = pool->getStatistics();
+    CHECK(stats.cachedBytes == 0);
+    CHECK(stats.cacheReleases == 1);
+    CHECK(stats.reservedBytes == 3072);
+
+    // blocks beyond the budget are not cached
+    auto beyond = pool->allocate(2048);
+    beyond.reset();
+    CHECK(allocator.numFrees == 2);
+    CHECK(pool->getStatistics().reservedBytes == 3072);
+}
+
+TEST_CASE("DeviceMemoryPool: retry after releasing the cache", TAG_DATASTRUCTURES) {
+    CountingAllocator allocator;
+    allocator.limit = 4096;
+    auto pool = allocator.createPool(1 << 30);
+
+    pool->allocate(3000).reset();
+    // the device is out of memory while the block is cached
+    auto block = pool->allocate(2000);
+    CHECK(block);
+    CHECK(allocator.numFrees == 1);
+
+    // neither the device nor the cache can serve the allocation
+    CHECK_THROWS_AS(pool->allocate(100000), std::runtime_error);
+}
+
+TEST_CASE("DeviceMemoryPool: blocks keep the pool alive", TAG_DATASTRUCTURES) {
+    CountingAllocator allocator;
+    auto pool = allocator.createPool(1 << 30);
+    auto block = pool->allocate(100);
+    pool.reset();
+    // the last block returns to the pool, which then returns it to the device allocator
+    block.reset();
+    CHECK(allocator.numFrees == 1);
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/context/ResidencyManager.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    // host memory standing in for the memory of a device with a residency manager
+    class FakeDeviceAllocation : public IAllocationDescriptor {
+        ResidencyManager* residency;
+        std::shared_ptr<std::byte> data{};
+    public:
+        explicit FakeDeviceAllocation(ResidencyManager* residency) : residency(residency) {}
+
+        [[nodiscard]] ALLOCATION_TYPE getType() const override { return ALLOCATION_TYPE::GPU_HIP; }
+        void createAllocation(size_t size, bool zero) override {
+            data = std::shared_ptr<std::byte>(new std::byte[size], std::default_delete<std::byte[]>());
+            if(zero)
+                std::memset(data.get(), 0, size);
+        }
+        [[nodiscard]] std::string getLocation() const override { return "0"; }
+        std::shared_ptr<std::byte> getData() override { return data; }
+        void transferTo(std::byte* src, size_t size) override { std::memcpy(data.get(), src, size); }
+        void transferFrom(std::byte* dst, size_t size) override { std::memcpy(dst, data.get(), size); }
+        [[nodiscard]] std::unique_ptr<IAllocationDescriptor> clone() const override {
+            return std::make_unique<FakeDeviceAllocation>(*this);
+        }
+        [[nodiscard]] ResidencyManager* getResidencyManager() const override { return residency; }
+    };
+
+    // tracks a placement of the given owner without a data object behind it
+    void trackFake(ResidencyManager& residency, const void* owner, size_t bytes, bool dirty,
+            std::vector<const void*>& evicted) {
+        residency.track(static_cast<const Structure*>(owner), 0, bytes, [dirty]() { return dirty; },
+                [owner, &evicted]() { evicted.push_back(owner); });
+    }
+}
+
+TEST_CASE("ResidencyManager: least recently used placements are evicted", TAG_DATASTRUCTURES) {
+    ResidencyManager residency(300, 1);
+    std::vector<const void*> evicted;
+    int a, b, c;
+    trackFake(residency, &a, 100, true, evicted);
+    trackFake(residency, &b, 100, true, evicted);
+    trackFake(residency, &c, 100, true, evicted);
+    residency.touch(reinterpret_cast<const Structure*>(&a), 0);
+
+    CHECK(residency.makeRoom(100));
+    CHECK(evicted == std::vector<const void*>{&b});
+    auto stats = residency.getStatistics();
+    CHECK(stats.residentBytes == 200);
+    CHECK(stats.writeBacks == 1);
+}
+
+TEST_CASE("ResidencyManager: clean placements are evicted first", TAG_DATASTRUCTURES) {
+    ResidencyManager residency(300, 1);
+    std::vector<const void*> evicted;
+    int a, b, c;
+    trackFake(residency, &a, 100, true, evicted);
+    trackFake(residency, &b, 100, false, evicted);
+    trackFake(residency, &c, 100, true, evicted);
+
+    CHECK(residency.makeRoom(100));
+    CHECK(evicted == std::vector<const void*>{&b});
+    CHECK(residency.getStatistics().writeBacks == 0);
+}
+
+TEST_CASE("ResidencyManager: recently used and hinted placements are protected", TAG_DATASTRUCTURES) {
+    ResidencyManager residency(200, 2);
+    std::vector<const void*> evicted;
+    int a, b;
+    trackFake(residency, &a, 100, false, evicted);
+    trackFake(residency, &b, 100, false, evicted);
+    // both were accessed within the last two accesses
+    CHECK_FALSE(residency.makeRoom(100));
+    CHECK(evicted.empty());
+
+    residency.hint(reinterpret_cast<const Structure*>(&a));
+    residency.touch(reinterpret_cast<const Structure*>(&b), 0);
+    residency.touch(reinterpret_cast<const Structure*>(&b), 0);
+    residency.touch(reinterpret_cast<const Structure*>(&b), 0);
+    // b is still protected, a by its hint
+    CHECK(residency.evict(100) == 0);
+
+    residency.forget(reinterpret_cast<const Structure*>(&b));
+    CHECK(residency.getStatistics().residentBytes == 100);
+    CHECK(residency.makeRoom(100));
+}
+
+TEST_CASE("DenseMatrix: evicted device placements are written back", TAG_DATASTRUCTURES) {
+    ResidencyManager residency(1024, 0);
+    FakeDeviceAllocation device(&residency);
+
+    SECTION("dirty placement") {
+        auto m = DataObjectFactory::create<DenseMatrix<double>>(2, 2, false, &device);
+        double* d = m->getValues(&device);
+        for(size_t i = 0; i < 4; i++)
+            d[i] = static_cast<double>(i);
+        CHECK(residency.isTracked(m, m->getMetaDataObject().getLatest().front()));
+
+        CHECK(residency.evict(1) == m->bufferSize());
+        CHECK(m->getMetaDataObject().getDataPlacementByType(ALLOCATION_TYPE::GPU_HIP)->empty());
+        CHECK(m->get(1, 1) == 3);
+        DataObjectFactory::destroy(m);
+    }
+    SECTION("clean placement") {
+        auto m = genGivenVals<DenseMatrix<double>>(2, {1, 2, 3, 4});
+        [[maybe_unused]] auto unused = static_cast<const DenseMatrix<double>*>(m)->getValues(&device);
+        CHECK(residency.evict(1) == m->bufferSize());
+        CHECK(residency.getStatistics().writeBacks == 0);
+        CHECK(m->get(1, 0) == 3);
+        DataObjectFactory::destroy(m);
+    }
+    // destroyed matrices are not tracked anymore
+    CHECK(residency.getStatistics().numResident == 0);
+}
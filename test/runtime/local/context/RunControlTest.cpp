@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/context/RunControl.h>
+#include <runtime/local/vectorized/TaskQueues.h>
+#include <runtime/local/vectorized/WorkerCPU.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST_CASE("RunControl: cancellation and time limit", TAG_VECTORIZED) {
+    RunControl control;
+    CHECK_FALSE(control.hasTimeout());
+    CHECK_FALSE(control.isCancelled());
+    CHECK_NOTHROW(control.throwIfCancelled());
+
+    SECTION("cancel") {
+        control.cancel();
+        CHECK(control.isCancelled());
+        CHECK_THROWS_WITH(control.throwIfCancelled(), "the run was cancelled");
+    }
+    SECTION("time limit") {
+        control.setTimeout(0.01);
+        CHECK(control.hasTimeout());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK(control.isCancelled());
+        CHECK(control.getProgress().cancelled);
+        CHECK_THROWS_AS(control.throwIfCancelled(), CancelledError);
+        CHECK_THROWS_WITH(control.throwIfCancelled(), "the run exceeded its time limit");
+    }
+}
+
+TEST_CASE("RunControl: the workers count the rows and skip the tasks once cancelled", TAG_VECTORIZED) {
+    RunControl control;
+    control.beginPipeline(3);
+
+    BlockingTaskQueue q(3);
+    size_t numExecuted = 0;
+    for(size_t i = 0; i < 3; i++)
+        q.enqueueTask(new FunctionTask([&numExecuted]() { numExecuted++; }));
+    q.closeInput();
+    std::vector<TaskQueue*> queues{&q};
+    WorkerCPU worker(queues, {0}, {0}, false, 0, 1, 0, 1, 0, 0, false, false, 0, &control);
+    worker.run();
+    CHECK(numExecuted == 3);
+    RunControl::Progress progress = control.getProgress();
+    CHECK(progress.numPipelines == 1);
+    CHECK(progress.pipelineRows == 3);
+    CHECK(progress.pipelineRowsDone == 3);
+    CHECK(progress.totalRowsDone == 3);
+
+    control.beginPipeline(2);
+    control.cancel();
+    BlockingTaskQueue q2(2);
+    for(size_t i = 0; i < 2; i++)
+        q2.enqueueTask(new FunctionTask([&numExecuted]() { numExecuted++; }));
+    q2.closeInput();
+    std::vector<TaskQueue*> queues2{&q2};
+    // the queue is drained without executing its tasks
+    WorkerCPU cancelled(queues2, {0}, {0}, false, 0, 1, 0, 1, 0, 0, false, false, 0, &control);
+    cancelled.run();
+    CHECK(numExecuted == 3);
+    CHECK(dynamic_cast<EOFTask*>(q2.dequeueTask()) != nullptr);
+    progress = control.getProgress();
+    CHECK(progress.numPipelines == 2);
+    CHECK(progress.pipelineRowsDone == 0);
+    CHECK(progress.totalRowsDone == 3);
+    CHECK(progress.cancelled);
+}
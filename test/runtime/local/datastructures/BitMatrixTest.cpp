@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+
+#include <cstdint>
+
+TEST_CASE("BitMatrix packs the cells into words", TAG_DATASTRUCTURES) {
+    const size_t numRows = 13;
+    const size_t numCols = 11;
+    auto m = DataObjectFactory::create<BitMatrix>(numRows, numCols, true);
+    CHECK(m->getNumWords() == 3);
+    CHECK(m->getSizeInBytes() == 24);
+
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            m->set(r, c, (r * 3 + c) % 4 == 0);
+    m->set(12, 10, true);
+    m->set(0, 0, false);
+
+    bool allEqual = true;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            allEqual &= m->get(r, c) == ((r == 12 && c == 10) || ((r * 3 + c) % 4 == 0 && r + c > 0));
+    CHECK(allEqual);
+    // cell 64 is the first bit of the second word, the last cell (142) is bit 14 of the third word
+    CHECK((m->getWords()[1] & 1) == ((5 * 3 + 9) % 4 == 0));
+    CHECK(m->getWords()[2] >> 14 == 1);
+
+    SECTION("slices are copies") {
+        BitMatrix * s = m->slice(5, 13, 9, 11);
+        CHECK(s->getNumRows() == 8);
+        CHECK(s->getNumCols() == 2);
+        bool sliceEqual = true;
+        for(size_t r = 0; r < 8; r++)
+            for(size_t c = 0; c < 2; c++)
+                sliceEqual &= s->get(r, c) == m->get(5 + r, 9 + c);
+        CHECK(sliceEqual);
+        DataObjectFactory::destroy(s);
+        CHECK_THROWS_AS(m->sliceCol(0, numCols + 1), std::runtime_error);
+    }
+    SECTION("appended bits") {
+        m->prepareAppend();
+        m->append(2, 1, true);
+        m->append(3, 0, false);
+        m->finishAppend();
+        CHECK(m->get(2, 1));
+        CHECK_FALSE(m->get(3, 0));
+        CHECK(m->getWords()[0] == uint64_t(1) << 23);
+        CHECK(m->getWords()[2] == 0);
+    }
+
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("BitMatrix clears the bits beyond the last cell", TAG_DATASTRUCTURES) {
+    auto m = DataObjectFactory::create<BitMatrix>(3, 30, false);
+    CHECK(m->getWords()[1] == 0);
+    DataObjectFactory::destroy(m);
+}
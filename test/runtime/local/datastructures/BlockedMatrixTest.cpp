@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("BlockedMatrix chooses the representation per block", TAG_DATASTRUCTURES, double, int64_t) {
+    using VT = TestType;
+    using BlockType = typename BlockedMatrix<VT>::BlockType;
+
+    // 3x4 blocks, the last row and column of blocks are smaller
+    auto m = DataObjectFactory::create<BlockedMatrix<VT>>(21, 34, 10);
+    CHECK(m->getNumRowBlocks() == 3);
+    CHECK(m->getNumColBlocks() == 4);
+    CHECK(m->getBlockNumRows(2) == 1);
+    CHECK(m->getBlockNumCols(3) == 4);
+
+    m->prepareAppend();
+    // block (0, 0) dense, block (0, 1) sparse, the small block (2, 3) with a single value
+    for(size_t r = 0; r < 10; r++) {
+        for(size_t c = 0; c < 10; c++)
+            m->append(r, c, VT(r + c + 1));
+        if(r % 5 == 0)
+            m->append(r, 10 + r, VT(7));
+    }
+    m->append(20, 33, VT(3));
+    m->finishAppend();
+
+    CHECK(m->getBlockType(0, 0) == BlockType::DENSE);
+    CHECK(m->getBlockType(0, 1) == BlockType::SPARSE);
+    CHECK(m->getBlockType(1, 1) == BlockType::EMPTY);
+    CHECK(m->getBlockType(2, 3) == BlockType::DENSE);
+    CHECK(m->getDenseBlock(2, 3)->getNumRows() == 1);
+    CHECK(m->getNumNonZeros() == 103);
+
+    CHECK(m->get(3, 4) == VT(8));
+    CHECK(m->get(5, 15) == VT(7));
+    CHECK(m->get(5, 16) == VT(0));
+    CHECK(m->get(15, 15) == VT(0));
+    CHECK(m->get(20, 33) == VT(3));
+
+    SECTION("set densifies a block until compact") {
+        m->set(15, 15, VT(4));
+        m->set(5, 16, VT(5));
+        CHECK(m->getBlockType(1, 1) == BlockType::DENSE);
+        CHECK(m->getBlockType(0, 1) == BlockType::DENSE);
+        CHECK(m->get(15, 15) == VT(4));
+        CHECK(m->get(5, 16) == VT(5));
+        CHECK(m->get(5, 15) == VT(7));
+
+        m->set(0, 0, VT(0));
+        m->set(20, 33, VT(0));
+        m->compact();
+        CHECK(m->getBlockType(0, 0) == BlockType::DENSE);
+        CHECK(m->getBlockType(0, 1) == BlockType::SPARSE);
+        CHECK(m->getBlockType(1, 1) == BlockType::SPARSE);
+        CHECK(m->getBlockType(2, 3) == BlockType::EMPTY);
+        CHECK(m->getNumNonZeros() == 103);
+        CHECK(m->get(5, 16) == VT(5));
+    }
+    SECTION("blocks can be replaced") {
+        auto block = DataObjectFactory::create<DenseMatrix<VT>>(10, 10, true);
+        block->set(1, 2, VT(9));
+        m->setDenseBlock(1, 1, block);
+        CHECK(m->get(11, 12) == VT(9));
+        m->compactBlock(1, 1);
+        CHECK(m->getBlockType(1, 1) == BlockType::SPARSE);
+
+        m->setSparseBlock(0, 0, nullptr);
+        CHECK(m->getBlockType(0, 0) == BlockType::EMPTY);
+        CHECK(m->get(3, 4) == VT(0));
+
+        auto wrongShape = DataObjectFactory::create<DenseMatrix<VT>>(10, 10, true);
+        CHECK_THROWS_AS(m->setDenseBlock(2, 0, wrongShape), std::runtime_error);
+        DataObjectFactory::destroy(wrongShape);
+    }
+
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("BlockedMatrix returns its blocks as dense matrices", TAG_DATASTRUCTURES) {
+    auto m = DataObjectFactory::create<BlockedMatrix<double>>(4, 4, 2);
+    m->prepareAppend();
+    m->append(0, 0, 1);
+    m->append(0, 1, 2);
+    m->append(1, 0, 3);
+    m->append(3, 2, 4);
+    m->finishAppend();
+
+    for(size_t rb = 0; rb < 2; rb++)
+        for(size_t cb = 0; cb < 2; cb++) {
+            const DenseMatrix<double> * block = m->getBlockAsDense(rb, cb);
+            REQUIRE(block->getNumRows() == 2);
+            for(size_t r = 0; r < 2; r++)
+                for(size_t c = 0; c < 2; c++)
+                    CHECK(block->get(r, c) == m->get(rb * 2 + r, cb * 2 + c));
+            DataObjectFactory::destroy(block);
+        }
+    // the dense block itself survives the destruction of the returned matrix
+    CHECK(m->getDenseBlock(0, 0)->get(1, 0) == 3);
+
+    DataObjectFactory::destroy(m);
+}
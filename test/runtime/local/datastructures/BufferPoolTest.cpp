@@ -0,0 +1,149 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdint>
+
+TEST_CASE("BufferPool size classes", TAG_DATASTRUCTURES) {
+    CHECK(BufferPool::getSizeClass(100) == 100);
+    CHECK(BufferPool::getSizeClass(BufferPool::MIN_POOLED_BYTES) == BufferPool::MIN_POOLED_BYTES);
+    CHECK(BufferPool::getSizeClass(BufferPool::MIN_POOLED_BYTES + 1) == BufferPool::MIN_POOLED_BYTES * 5 / 4);
+    CHECK(BufferPool::getSizeClass(1000000) == 1048576);
+    // huge arrays consist of whole huge pages
+    CHECK(BufferPool::getSizeClass(BufferPool::HUGE_PAGE_BYTES + 1) % BufferPool::HUGE_PAGE_BYTES == 0);
+}
+
+TEST_CASE("BufferPool reuses the arrays of dropped matrices", TAG_DATASTRUCTURES) {
+    BufferPool & pool = BufferPool::get();
+    const size_t maxCachedBytesBefore = pool.getMaxCachedBytes();
+    pool.setMaxCachedBytes(size_t(64) << 20);
+    pool.clear();
+
+    SECTION("dense, below and above the huge page size") {
+        for(size_t numRows : {100, 1000}) {
+            const BufferPool::Stats before = pool.getStats();
+            for(size_t i = 0; i < 3; i++) {
+                // the same shape in every iteration, like the intermediates of a loop body
+                auto m = DataObjectFactory::create<DenseMatrix<double>>(numRows, 300, i == 0);
+                m->set(numRows - 1, 299, double(i));
+                CHECK(m->get(numRows - 1, 299) == double(i));
+                if(i == 0)
+                    CHECK(m->get(0, 0) == 0.0);
+                DataObjectFactory::destroy(m);
+            }
+            const BufferPool::Stats after = pool.getStats();
+            CHECK(after.numRequests - before.numRequests == 3);
+            CHECK(after.numHits - before.numHits == 2);
+            CHECK(after.cachedBytes == BufferPool::getSizeClass(numRows * 300 * sizeof(double)));
+            pool.clear();
+        }
+    }
+    SECTION("sparse") {
+        const BufferPool::Stats before = pool.getStats();
+        for(size_t i = 0; i < 2; i++) {
+            auto m = DataObjectFactory::create<CSRMatrix<float>>(20000, 100, 20000, true);
+            DataObjectFactory::destroy(m);
+        }
+        // values, column indexes, and row offsets
+        CHECK(pool.getStats().numHits - before.numHits == 3);
+    }
+    SECTION("views keep the array alive") {
+        auto m = DataObjectFactory::create<DenseMatrix<int64_t>>(100, 200, true);
+        auto view = m->sliceRow(50, 100);
+        DataObjectFactory::destroy(m);
+        CHECK(pool.getStats().cachedBytes == 0);
+        DataObjectFactory::destroy(view);
+        CHECK(pool.getStats().cachedBytes == BufferPool::getSizeClass(100 * 200 * sizeof(int64_t)));
+    }
+    SECTION("the cache is bounded") {
+        pool.setMaxCachedBytes(1 << 20);
+        const BufferPool::Stats before = pool.getStats();
+        auto m1 = DataObjectFactory::create<DenseMatrix<double>>(1024, 96, false);
+        auto m2 = DataObjectFactory::create<DenseMatrix<double>>(1024, 96, false);
+        DataObjectFactory::destroy(m1, m2);
+        CHECK(pool.getStats().numEvictions - before.numEvictions == 1);
+        CHECK(pool.getStats().cachedBytes <= (1 << 20));
+        pool.setMaxCachedBytes(0);
+        CHECK(pool.getStats().cachedBytes == 0);
+    }
+    SECTION("reserved arrays are cached beyond the bound") {
+        pool.setMaxCachedBytes(0);
+        const size_t numBytes = 1024 * 96 * sizeof(double);
+        pool.reserve(numBytes, 2);
+        const BufferPool::Stats before = pool.getStats();
+        for(size_t i = 0; i < 3; i++) {
+            // two intermediates live at the same time, like in a loop body
+            auto m1 = DataObjectFactory::create<DenseMatrix<double>>(1024, 96, false);
+            auto m2 = DataObjectFactory::create<DenseMatrix<double>>(1024, 96, false);
+            DataObjectFactory::destroy(m1, m2);
+        }
+        CHECK(pool.getStats().numHits - before.numHits == 4);
+        CHECK(pool.getStats().numEvictions == before.numEvictions);
+        pool.unreserve(numBytes, 2);
+        CHECK(pool.getStats().cachedBytes == 0);
+    }
+
+    pool.clear();
+    pool.setMaxCachedBytes(maxCachedBytesBefore);
+}
+
+TEST_CASE("BufferPool arrays are aligned", TAG_DATASTRUCTURES) {
+    BufferPool & pool = BufferPool::get();
+    const bool useHugePagesBefore = pool.getUseHugePages();
+
+    for(bool useHugePages : {true, false}) {
+        pool.setUseHugePages(useHugePages);
+        for(size_t numBytes : {size_t(1), size_t(100), BufferPool::MIN_POOLED_BYTES + 8, BufferPool::HUGE_PAGE_BYTES + 8}) {
+            void * ptr = pool.allocate(numBytes);
+            CHECK(reinterpret_cast<uintptr_t>(ptr) % BufferPool::ALIGNMENT == 0);
+            pool.release(ptr, numBytes);
+        }
+    }
+    pool.setUseHugePages(useHugePagesBefore);
+
+    SECTION("DenseMatrix") {
+        // rows of 64 bytes
+        auto m = DataObjectFactory::create<DenseMatrix<double>>(10, 8, false);
+        auto rowView = m->sliceRow(1, 3);
+        auto colView = m->sliceCol(1, 3);
+        CHECK(m->isAligned());
+        CHECK(rowView->isAligned());
+        CHECK_FALSE(colView->isAligned());
+        // rows of 24 bytes
+        auto m2 = DataObjectFactory::create<DenseMatrix<double>>(10, 3, false);
+        auto m2Row = m2->sliceRow(0, 1);
+        CHECK_FALSE(m2->isAligned());
+        CHECK(m2Row->isAligned());
+        DataObjectFactory::destroy(m, rowView, colView, m2, m2Row);
+    }
+    SECTION("Frame") {
+        const ValueTypeCode schema[] = {ValueTypeCode::SI8, ValueTypeCode::F64};
+        auto f = DataObjectFactory::create<Frame>(3, 2, schema, nullptr, false);
+        for(size_t c = 0; c < 2; c++)
+            CHECK(reinterpret_cast<uintptr_t>(f->getColumnRaw(c)) % BufferPool::ALIGNMENT == 0);
+        DataObjectFactory::destroy(f);
+    }
+}
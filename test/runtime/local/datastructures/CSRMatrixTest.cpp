@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
@@ -23,6 +24,28 @@
 #include <catch.hpp>
 
 #include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+    // Stands in for the memory of a device in the tests of `CSRMatrix::getPlacement()`.
+    class AllocationDescriptorMock : public IAllocationDescriptor {
+        std::shared_ptr<std::byte> data{};
+
+    public:
+        [[nodiscard]] ALLOCATION_TYPE getType() const override { return ALLOCATION_TYPE::GPU_CUDA; }
+        std::string getLocation() const override { return "0"; }
+        void createAllocation(size_t size, bool zero) override {
+            data = std::shared_ptr<std::byte>(new std::byte[size](), std::default_delete<std::byte[]>());
+        }
+        std::shared_ptr<std::byte> getData() override { return data; }
+        void transferTo(std::byte* src, size_t size) override { memcpy(data.get(), src, size); }
+        void transferFrom(std::byte* dst, size_t size) override { memcpy(dst, data.get(), size); }
+        [[nodiscard]] std::unique_ptr<IAllocationDescriptor> clone() const override {
+            return std::make_unique<AllocationDescriptorMock>(*this);
+        }
+    };
+}
 
 TEMPLATE_TEST_CASE("CSRMatrix allocates enough space", TAG_DATASTRUCTURES, ALL_VALUE_TYPES) {
     // No assertions in this test case. We just want to see if it runs without
@@ -86,4 +109,150 @@ TEST_CASE("CSRMatrix sub-matrix works properly", TAG_DATASTRUCTURES) {
         DataObjectFactory::destroy(mSub);
         DataObjectFactory::destroy(mOrig);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("CSRMatrix caches its transposition until it is written", TAG_DATASTRUCTURES) {
+    auto m = genGivenVals<CSRMatrix<double>>(3, {
+        1, 0, 2,
+        0, 0, 3,
+        4, 0, 0,
+    });
+    const CSRMatrix<double> * cm = m;
+    CHECK(cm->getCachedTransposed() == nullptr);
+
+    auto t = cm->getTransposed();
+    CHECK(t->getNumRows() == 3);
+    CHECK(t->getNumNonZeros() == 4);
+    CHECK(t->get(0, 2) == 4);
+    CHECK(t->get(2, 0) == 2);
+    CHECK(t->get(2, 1) == 3);
+    CHECK(t->getNumNonZeros(1) == 0);
+    // built once, read accesses keep it
+    CHECK(cm->getTransposed() == t);
+    CHECK(cm->get(1, 2) == 3);
+    CHECK(cm->getValues(1)[0] == 3);
+    CHECK(cm->getCachedTransposed() == t);
+
+    // writes drop it, while the returned transposition stays valid (the
+    // matrix has no capacity for further non-zeros, so we overwrite one)
+    m->set(1, 2, 5);
+    CHECK(cm->getCachedTransposed() == nullptr);
+    CHECK(t->get(2, 1) == 3);
+    CHECK(cm->getTransposed()->get(2, 1) == 5);
+
+    // views do not cache their transposition
+    auto view = DataObjectFactory::create<CSRMatrix<double>>(m, 1, 3);
+    const CSRMatrix<double> * cview = view;
+    CHECK(cview->getTransposed()->get(0, 1) == 4);
+    CHECK(cview->getCachedTransposed() == nullptr);
+
+    DataObjectFactory::destroy(view, m);
+}
+
+TEST_CASE("CSRMatrix caches its placements until it is written", TAG_DATASTRUCTURES) {
+    auto m = genGivenVals<CSRMatrix<double>>(3, {
+        1, 0, 2,
+        0, 0, 3,
+        4, 0, 0,
+    });
+    const CSRMatrix<double> * cm = m;
+    AllocationDescriptorMock device;
+
+    auto p = cm->getPlacement(&device);
+    CHECK(std::vector<size_t>(p->getRowOffsets(), p->getRowOffsets() + 4) == std::vector<size_t>({0, 2, 3, 4}));
+    CHECK(std::vector<size_t>(p->getColIdxs(), p->getColIdxs() + 4) == std::vector<size_t>({0, 2, 2, 0}));
+    CHECK(std::vector<double>(p->getValues(), p->getValues() + 4) == std::vector<double>({1, 2, 3, 4}));
+    // read accesses keep it, writes drop it
+    CHECK(cm->get(1, 2) == 3);
+    CHECK(cm->getPlacement(&device) == p);
+    m->set(1, 2, 5);
+    auto p2 = cm->getPlacement(&device);
+    CHECK(p2 != p);
+    CHECK(p2->getValues()[2] == 5);
+    CHECK(p->getValues()[2] == 3);
+
+    // views copy only their rows, with row offsets starting at zero, and do not cache them
+    auto view = DataObjectFactory::create<CSRMatrix<double>>(m, 1, 3);
+    const CSRMatrix<double> * cview = view;
+    auto pv = cview->getPlacement(&device);
+    CHECK(std::vector<size_t>(pv->getRowOffsets(), pv->getRowOffsets() + 3) == std::vector<size_t>({0, 1, 2}));
+    CHECK(std::vector<size_t>(pv->getColIdxs(), pv->getColIdxs() + 2) == std::vector<size_t>({2, 0}));
+    CHECK(std::vector<double>(pv->getValues(), pv->getValues() + 2) == std::vector<double>({5, 4}));
+    CHECK(cview->getPlacement(&device) != pv);
+
+    DataObjectFactory::destroy(view, m);
+}
+
+TEST_CASE("CSRMatrix caches its compact column indexes until it is written", TAG_DATASTRUCTURES) {
+    auto m = genGivenVals<CSRMatrix<double>>(3, {
+        1, 0, 2,
+        0, 0, 3,
+        4, 0, 0,
+    });
+    const CSRMatrix<double> * cm = m;
+
+    // built on the second request only
+    CHECK(cm->getCompactColIdxs() == nullptr);
+    auto c = cm->getCompactColIdxs();
+    REQUIRE(c != nullptr);
+    CHECK(std::vector<uint32_t>(c.get(), c.get() + 4) == std::vector<uint32_t>({0, 2, 2, 0}));
+    CHECK(cm->getCompactColIdxs() == c);
+    CHECK(cm->getCachedCompactColIdxs() == c);
+
+    // views share the copy of their source, positioned like its column indexes
+    auto view = DataObjectFactory::create<CSRMatrix<double>>(m, 1, 3);
+    const CSRMatrix<double> * cview = view;
+    CHECK(cview->getCompactColIdxs() == c);
+    CHECK(cview->getCompactColIdxs().get()[cview->getRowOffsets()[0]] == 2);
+
+    // writes drop it and start over
+    m->set(1, 2, 5);
+    CHECK(cm->getCachedCompactColIdxs() == nullptr);
+    CHECK(cm->getCompactColIdxs() == nullptr);
+    CHECK(cm->getCompactColIdxs() != nullptr);
+
+    DataObjectFactory::destroy(view, m);
+}
+
+TEST_CASE("CSRMatrix caches its SELL-C-sigma representation until it is written", TAG_DATASTRUCTURES) {
+    // the rows have 1, 3, 0, and 2 non-zeros
+    auto m = genGivenVals<CSRMatrix<double>>(4, {
+        1, 0, 0,
+        2, 3, 4,
+        0, 0, 0,
+        0, 5, 6,
+    });
+    const CSRMatrix<double> * cm = m;
+
+    // built on the second request only
+    CHECK(cm->getSell() == nullptr);
+    auto sell = cm->getSell();
+    REQUIRE(sell != nullptr);
+    CHECK(cm->getSell() == sell);
+
+    // one slice of the rows sorted by their length, padded to the longest one
+    constexpr size_t C = SellCSigma<double>::C;
+    CHECK(sell->numSlices == 1);
+    CHECK(std::vector<size_t>(sell->rows.begin(), sell->rows.begin() + 5) == std::vector<size_t>({1, 3, 0, 2, 4}));
+    CHECK(std::vector<uint32_t>(sell->rowLengths.begin(), sell->rowLengths.begin() + 5) ==
+            std::vector<uint32_t>({3, 2, 1, 0, 0}));
+    REQUIRE(sell->values.size() == 3 * C);
+    CHECK(sell->values[0] == 2);
+    CHECK(sell->values[1] == 5);
+    CHECK(sell->values[2] == 1);
+    CHECK(sell->values[C] == 3);
+    CHECK(sell->colIdxs[C] == 1);
+    CHECK(sell->values[C + 1] == 6);
+    CHECK(sell->values[2 * C] == 4);
+    CHECK(sell->colIdxs[2 * C] == 2);
+    CHECK(sell->values[2 * C + 1] == 0);
+
+    // writes drop it, views do not build it
+    m->set(0, 0, 7);
+    CHECK(cm->getSell() == nullptr);
+    auto view = DataObjectFactory::create<CSRMatrix<double>>(m, 1, 3);
+    const CSRMatrix<double> * cview = view;
+    CHECK(cview->getSell() == nullptr);
+    CHECK(cview->getSell() == nullptr);
+
+    DataObjectFactory::destroy(view, m);
+}
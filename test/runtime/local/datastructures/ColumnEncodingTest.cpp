@@ -0,0 +1,160 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/ColumnEncoding.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+TEST_CASE("BitPackedArray", TAG_DATASTRUCTURES) {
+    CHECK(BitPackedArray::bitWidthFor(0) == 0);
+    CHECK(BitPackedArray::bitWidthFor(1) == 1);
+    CHECK(BitPackedArray::bitWidthFor(255) == 8);
+    CHECK(BitPackedArray::bitWidthFor(256) == 9);
+    CHECK(BitPackedArray::bitWidthFor(UINT64_MAX) == 64);
+
+    for(unsigned width : {0u, 3u, 13u, 64u}) {
+        const uint64_t mask = width == 64 ? UINT64_MAX : (uint64_t(1) << width) - 1;
+        BitPackedArray a(100, width);
+        for(size_t i = 0; i < 100; i++)
+            a.init(i, (i * 0x9E3779B97F4A7C15ull) & mask);
+        for(size_t i = 0; i < 100; i++)
+            CHECK(a.get(i) == ((i * 0x9E3779B97F4A7C15ull) & mask));
+    }
+}
+
+TEMPLATE_TEST_CASE("Encoded columns decode to the original values", TAG_DATASTRUCTURES, int64_t, uint32_t, double) {
+    using VT = TestType;
+    const std::vector<VT> values = {VT(7), VT(7), VT(3), VT(7), VT(9), VT(9), VT(9), VT(3), VT(100), VT(7)};
+    const size_t numRows = values.size();
+
+    std::vector<ColumnEncoding> encodings = {ColumnEncoding::DICTIONARY, ColumnEncoding::RUN_LENGTH};
+    if(std::is_integral<VT>::value)
+        encodings.push_back(ColumnEncoding::FRAME_OF_REFERENCE);
+    else
+        CHECK_THROWS_AS(
+                ColumnEncodingUtils::encode(ColumnEncoding::FRAME_OF_REFERENCE, values.data(), numRows),
+                std::runtime_error
+        );
+
+    for(ColumnEncoding encoding : encodings) {
+        auto col = ColumnEncodingUtils::encode(encoding, ValueTypeUtils::codeFor<VT>, values.data(), numRows);
+        CHECK(col->getEncoding() == encoding);
+        CHECK(col->getValueType() == ValueTypeUtils::codeFor<VT>);
+        CHECK(col->getNumRows() == numRows);
+
+        std::vector<VT> decoded(numRows);
+        col->decode(decoded.data(), 0, numRows);
+        CHECK(decoded == values);
+        // decoding a range, starting within a run
+        std::vector<VT> part(4);
+        col->decode(part.data(), 5, 9);
+        CHECK(part == std::vector<VT>(values.begin() + 5, values.begin() + 9));
+    }
+}
+
+TEMPLATE_TEST_CASE("Equality predicates on encoded columns", TAG_DATASTRUCTURES, int64_t, uint32_t) {
+    using VT = TestType;
+    const std::vector<VT> values = {5, 5, 8, 6, 5, 8, 8, 1000};
+    const size_t numRows = values.size();
+    const std::vector<int64_t> expEq8 = {0, 0, 1, 0, 0, 1, 1, 0};
+    const std::vector<int64_t> expNone(numRows, 0);
+
+    auto dict = DictionaryColumn<VT>::encode(values.data(), numRows);
+    auto rle = RunLengthColumn<VT>::encode(values.data(), numRows);
+    auto forCol = FrameOfReferenceColumn<VT>::encode(values.data(), numRows);
+
+    CHECK(dict->getDictionarySize() == 4);
+    CHECK(dict->findCode(8) == 2);
+    CHECK(dict->findCode(7) == 4);
+    CHECK(rle->getNumRuns() == 6);
+    CHECK(forCol->getReference() == 5);
+    CHECK(forCol->getBitWidth() == 10);
+
+    std::vector<int64_t> res(numRows);
+    dict->selectEq(8, res.data(), numRows);
+    CHECK(res == expEq8);
+    rle->selectEq(8, res.data(), numRows);
+    CHECK(res == expEq8);
+    forCol->selectEq(8, res.data(), numRows);
+    CHECK(res == expEq8);
+
+    // values outside the dictionary or the frame of reference
+    dict->selectEq(7, res.data(), numRows);
+    CHECK(res == expNone);
+    forCol->selectEq(4, res.data(), numRows);
+    CHECK(res == expNone);
+    forCol->selectEq(5 + 1024, res.data(), numRows);
+    CHECK(res == expNone);
+
+    // filtering keeps the dictionary
+    auto filtered = dict->filter(expEq8.data(), numRows);
+    CHECK(filtered->getNumRows() == 3);
+    CHECK(filtered->getDictionary().get() == dict->getDictionary().get());
+    CHECK(filtered->get(0) == 8);
+}
+
+TEST_CASE("Frame with encoded columns", TAG_DATASTRUCTURES) {
+    const size_t numRows = 6;
+    auto c0 = genGivenVals<DenseMatrix<int64_t>>(numRows, {3, 3, 1, 3, 2, 1});
+    auto c1 = genGivenVals<DenseMatrix<double>>(numRows, {0.5, 0.5, 0.5, 1.5, 1.5, 1.5});
+    std::vector<Structure *> cols = {c0, c1};
+    std::string labels[] = {"a", "b"};
+    auto f = DataObjectFactory::create<Frame>(cols, labels);
+
+    f->encodeColumn(0, ColumnEncoding::DICTIONARY);
+    f->encodeColumn(1, ColumnEncoding::RUN_LENGTH);
+    CHECK(f->getColumnEncoding(0) == ColumnEncoding::DICTIONARY);
+    CHECK(f->getColumnEncoding(1) == ColumnEncoding::RUN_LENGTH);
+    CHECK(f->getDictionaryCodes(0)->getDictionarySize() == 3);
+    CHECK(f->getDictionaryColumn<int64_t>(1) == nullptr);
+
+    // reading a column through a const frame keeps the encoding
+    const Frame * cf = f;
+    auto c0Dec = cf->getColumn<int64_t>(0);
+    CHECK(*c0Dec == *c0);
+    CHECK(f->getColumnEncoding(0) == ColumnEncoding::DICTIONARY);
+
+    // views on the leading rows share the encoding, other views are decoded
+    auto head = f->sliceRow(0, 4);
+    CHECK(head->getColumnEncoding(0) == ColumnEncoding::DICTIONARY);
+    CHECK(head->getColumn<int64_t>(0)->get(3, 0) == 3);
+    auto tail = f->sliceRow(2, 6);
+    CHECK(tail->getColumnEncoding(1) == ColumnEncoding::NONE);
+    CHECK(tail->getColumn<double>(1)->get(0, 0) == 0.5);
+    CHECK(tail->getColumn<double>(1)->get(1, 0) == 1.5);
+
+    // writable access drops the encoding
+    f->getColumn<double>(1)->set(0, 0, 2.5);
+    CHECK(f->getColumnEncoding(1) == ColumnEncoding::NONE);
+    CHECK(cf->getColumn<double>(1)->get(0, 0) == 2.5);
+
+    CHECK_THROWS_AS(f->setEncodedColumn(1, f->getEncodedColumn(0)), std::runtime_error);
+
+    DataObjectFactory::destroy(c0, c1, c0Dec, head, tail, f);
+}
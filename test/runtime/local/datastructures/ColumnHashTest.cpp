@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <util/ColumnHash.h>
+#include <util/FlatHashMap.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("ColumnHash equals FlatHash", TAG_DATASTRUCTURES, int8_t, int32_t, int64_t, uint8_t, uint32_t,
+        uint64_t, float, double) {
+    using VT = TestType;
+
+    // not a multiple of the values hashed at a time, with negative values
+    const size_t n = 1003;
+    std::vector<VT> a(n), b(n);
+    for(size_t i = 0; i < n; i++) {
+        a[i] = static_cast<VT>(static_cast<int64_t>(i * 7919 % 251) - 100);
+        b[i] = static_cast<VT>(i % 7);
+    }
+    std::vector<uint64_t> hashes(n);
+    ColumnHash::hashColumn(hashes.data(), a.data(), n, true);
+    const FlatHash<VT> hash;
+    bool allEqual = true;
+    for(size_t i = 0; i < n; i++)
+        allEqual &= hashes[i] == hash(a[i]);
+    CHECK(allEqual);
+
+    ColumnHash::hashColumn(hashes.data(), b.data(), n, false);
+    allEqual = true;
+    for(size_t i = 0; i < n; i++)
+        allEqual &= hashes[i] == flatHashCombine(hash(a[i]), hash(b[i]));
+    CHECK(allEqual);
+
+    ColumnHash::hashColumnSeeded(hashes.data(), a.data(), n, 42);
+    allEqual = true;
+    for(size_t i = 0; i < n; i++)
+        allEqual &= hashes[i] == flatHashMix(hash(a[i]) ^ 42);
+    CHECK(allEqual);
+}
+
+TEMPLATE_TEST_CASE("ColumnHash of zeros and NaNs", TAG_DATASTRUCTURES, float, double) {
+    using VT = TestType;
+
+    const VT nan = std::numeric_limits<VT>::quiet_NaN();
+    const std::vector<VT> v = {VT(0), -VT(0), nan, -nan, std::numeric_limits<VT>::signaling_NaN(), VT(1), nan, VT(0)};
+    std::vector<uint64_t> hashes(v.size());
+    ColumnHash::hashColumn(hashes.data(), v.data(), v.size(), true);
+    CHECK(hashes[0] == hashes[1]);
+    CHECK(hashes[0] == hashes[7]);
+    CHECK(hashes[2] == hashes[3]);
+    CHECK(hashes[2] == hashes[4]);
+    CHECK(hashes[2] == hashes[6]);
+    CHECK(hashes[0] != hashes[2]);
+    CHECK(hashes[0] != hashes[5]);
+    CHECK(hashes[2] == FlatHash<VT>()(-nan));
+}
+
+TEST_CASE("ColumnHash of strings", TAG_DATASTRUCTURES) {
+    const std::vector<std::string> v = {"", "a", "abcdefghijk", "a", ""};
+    const std::vector<int64_t> k = {1, 2, 3, 2, 1};
+    std::vector<uint64_t> hashes(v.size());
+    ColumnHash::hashColumn(hashes.data(), k.data(), k.size(), true);
+    ColumnHash::hashColumn(hashes.data(), v.data(), v.size(), false);
+    for(size_t i = 0; i < v.size(); i++)
+        CHECK(hashes[i] == flatHashCombine(FlatHash<int64_t>()(k[i]), flatHashBytes(v[i].data(), v[i].size())));
+    CHECK(hashes[1] == hashes[3]);
+    CHECK(hashes[0] == hashes[4]);
+    CHECK(hashes[0] != hashes[1]);
+}
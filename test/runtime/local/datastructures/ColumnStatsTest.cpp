@@ -0,0 +1,115 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/ColumnStats.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+TEST_CASE("ZoneMap of the blocks of a column", TAG_DATASTRUCTURES) {
+    const size_t numRows = 2 * ColumnStats::BLOCK_ROWS + 10;
+    std::vector<int64_t> values(numRows);
+    for(size_t r = 0; r < numRows; r++)
+        values[r] = r;
+
+    auto sorted = ZoneMap<int64_t>::compute(values.data(), numRows);
+    REQUIRE(sorted->getNumBlocks() == 3);
+    CHECK(sorted->isSorted());
+    CHECK(sorted->getMin(1) == int64_t(ColumnStats::BLOCK_ROWS));
+    CHECK(sorted->getMax(1) == int64_t(2 * ColumnStats::BLOCK_ROWS - 1));
+    CHECK(sorted->getMax(2) == int64_t(numRows - 1));
+    CHECK(sorted->getNullCount(0) == 0);
+
+    // reading only the bounds of the blocks of a sorted column gives the same
+    auto bounds = ZoneMap<int64_t>::computeSorted(values.data(), numRows);
+    for(size_t b = 0; b < 3; b++) {
+        CHECK(bounds->getMin(b) == sorted->getMin(b));
+        CHECK(bounds->getMax(b) == sorted->getMax(b));
+    }
+
+    // each block is sorted, but not the column
+    std::swap(values[0], values[ColumnStats::BLOCK_ROWS]);
+    std::swap(values[1], values[ColumnStats::BLOCK_ROWS + 1]);
+    CHECK_FALSE(ZoneMap<int64_t>::compute(values.data(), numRows)->isSorted());
+
+    // a column of a row-major matrix
+    std::vector<int64_t> matrix = {5, 0, 3, 9, 4, 1};
+    auto strided = ZoneMap<int64_t>::compute(matrix.data() + 1, 3, 2);
+    CHECK(strided->getNumRows() == 3);
+    CHECK(strided->getMin(0) == 0);
+    CHECK(strided->getMax(0) == 9);
+    CHECK_FALSE(strided->isSorted());
+}
+
+TEST_CASE("ZoneMap counts the NaNs as nulls", TAG_DATASTRUCTURES) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> values = {nan, 2.0, 1.0, nan, 5.0};
+    auto zm = ZoneMap<double>::compute(values.data(), values.size());
+    CHECK(zm->getNullCount(0) == 2);
+    CHECK(zm->getMin(0) == 1.0);
+    CHECK(zm->getMax(0) == 5.0);
+    CHECK_FALSE(zm->isAllNull(0));
+    CHECK_FALSE(zm->isSorted());
+
+    // a sorted column has no nulls
+    std::vector<double> withNull = {1.0, 2.0, nan};
+    CHECK_FALSE(ZoneMap<double>::compute(withNull.data(), withNull.size())->isSorted());
+
+    std::vector<double> allNull = {nan, nan};
+    CHECK(ZoneMap<double>::compute(allNull.data(), allNull.size())->isAllNull(0));
+}
+
+TEST_CASE("Frame column statistics are shared by views and dropped by writes", TAG_DATASTRUCTURES) {
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64};
+    auto f = DataObjectFactory::create<Frame>(4, 2, schema, nullptr, false);
+    int64_t * a = static_cast<int64_t *>(f->getColumnRaw(0));
+    for(size_t r = 0; r < 4; r++)
+        a[r] = r;
+    const Frame * cf = f;
+    auto zm = ZoneMap<int64_t>::compute(static_cast<const int64_t *>(cf->getColumnRaw(0)), 4);
+    f->setColumnStats(0, zm);
+    CHECK(f->isColumnSorted(0));
+    CHECK_FALSE(f->isColumnSorted(1));
+    CHECK_THROWS(f->setColumnStats(1, zm));
+
+    // a view on the leading rows shares them, other views have none
+    auto leading = f->sliceRow(0, 2);
+    auto trailing = f->sliceRow(2, 4);
+    CHECK(leading->getZoneMap<int64_t>(0) == zm);
+    CHECK(trailing->getColumnStats(0) == nullptr);
+
+    // a column matrix keeps them until its values are written
+    auto col = cf->getColumn<int64_t>(0);
+    CHECK(col->getZoneMap(0) == zm);
+    const_cast<DenseMatrix<int64_t> *>(col)->getValues();
+    CHECK(col->getZoneMap(0) == nullptr);
+
+    f->getColumnRaw(0);
+    CHECK(f->getColumnStats(0) == nullptr);
+    CHECK(leading->isColumnSorted(0));
+
+    DataObjectFactory::destroy(f, leading, trailing, col);
+}
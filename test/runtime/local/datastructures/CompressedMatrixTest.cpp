@@ -0,0 +1,112 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/CompressedMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include <cstdint>
+
+// Columns 0-2 one-hot encode a feature of four categories (the last one has no column).
+// Column 3 is sorted, column 4 has a few distinct values in no particular order, column 5 has a distinct value in each
+// row, and column 6 is mostly 5.
+template<typename VT>
+std::vector<VT> genFeatures(size_t numRows, size_t numCols) {
+    std::vector<VT> values(numRows * numCols);
+    for(size_t r = 0; r < numRows; r++) {
+        VT * row = values.data() + r * numCols;
+        const size_t category = (r * 7919) % 4;
+        for(size_t c = 0; c < 3; c++)
+            row[c] = category == c;
+        row[3] = VT(r * 4 / numRows);
+        row[4] = VT((r * 13) % 5);
+        row[5] = VT(r);
+        row[6] = r % 97 == 3 ? VT(1) : VT(5);
+    }
+    return values;
+}
+
+TEMPLATE_TEST_CASE("CompressedMatrix encodes column groups", TAG_DATASTRUCTURES, double, int64_t) {
+    using VT = TestType;
+    const size_t numRows = 1000;
+    const size_t numCols = 7;
+    const std::vector<VT> values = genFeatures<VT>(numRows, numCols);
+    auto m = DataObjectFactory::create<CompressedMatrix<VT>>(numRows, numCols, values.data(), numCols);
+
+    // the one-hot columns are co-coded
+    const auto & groups = m->getColGroups();
+    REQUIRE(groups.size() == 5);
+    CHECK(groups[0].colIdxs == std::vector<size_t>{0, 1, 2});
+    CHECK(groups[0].encoding == ColGroupEncoding::DDC);
+    CHECK(groups[0].getNumTuples() == 4);
+    CHECK(groups[1].colIdxs == std::vector<size_t>{3});
+    CHECK(groups[1].encoding == ColGroupEncoding::RLE);
+    CHECK(groups[2].colIdxs == std::vector<size_t>{4});
+    CHECK(groups[2].encoding == ColGroupEncoding::DDC);
+    CHECK(groups[3].colIdxs == std::vector<size_t>{6});
+    CHECK(groups[3].encoding == ColGroupEncoding::OLE);
+    CHECK(groups[3].defaultTuple == std::vector<VT>{5});
+    CHECK(groups[4].colIdxs == std::vector<size_t>{5});
+    CHECK(groups[4].encoding == ColGroupEncoding::UNCOMPRESSED);
+    CHECK(m->getSizeInBytes() < numRows * numCols * sizeof(VT) / 2);
+
+    bool allEqual = true;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            allEqual &= m->get(r, c) == values[r * numCols + c];
+    CHECK(allEqual);
+
+    std::vector<VT> decompressed(numRows * numCols);
+    m->decompress(decompressed.data(), numCols, 0, numRows);
+    CHECK(decompressed == values);
+    // a range of rows within runs and lists
+    std::vector<VT> rows(10 * numCols);
+    m->decompress(rows.data(), numCols, 245, 255);
+    CHECK(std::equal(rows.begin(), rows.end(), values.begin() + 245 * numCols));
+
+    SECTION("slices are compressed copies") {
+        CompressedMatrix<VT> * s = m->slice(240, 260, 3, 7);
+        CHECK(s->getNumRows() == 20);
+        CHECK(s->getNumCols() == 4);
+        bool sliceEqual = true;
+        for(size_t r = 0; r < 20; r++)
+            for(size_t c = 0; c < 4; c++)
+                sliceEqual &= s->get(r, c) == values[(240 + r) * numCols + 3 + c];
+        CHECK(sliceEqual);
+        DataObjectFactory::destroy(s);
+        CHECK_THROWS_AS(m->sliceRow(0, numRows + 1), std::runtime_error);
+    }
+    SECTION("appended values are compressed") {
+        auto a = DataObjectFactory::create<CompressedMatrix<VT>>(numRows, numCols, values.data(), numCols);
+        a->prepareAppend();
+        a->append(2, 1, VT(7));
+        a->append(999, 6, VT(3));
+        a->finishAppend();
+        CHECK(a->get(2, 1) == VT(7));
+        CHECK(a->get(999, 6) == VT(3));
+        CHECK(a->get(500, 5) == VT(0));
+        CHECK_THROWS_AS(a->set(0, 0, VT(1)), std::runtime_error);
+        DataObjectFactory::destroy(a);
+    }
+
+    DataObjectFactory::destroy(m);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("DCSRMatrix stores only the rows with non-zeros", TAG_DATASTRUCTURES, double, int64_t) {
+    using VT = TestType;
+
+    // a billion users times a billion items, which a CSRMatrix could not even store the row offsets of
+    const size_t numRows = 1000000000;
+    const size_t numCols = 1000000000;
+    auto m = DataObjectFactory::create<DCSRMatrix<VT>>(numRows, numCols);
+    m->prepareAppend();
+    m->append(3, 5, VT(1));
+    m->append(3, 999999999, VT(2));
+    m->append(7, 0, VT(0));
+    m->append(123456789, 42, VT(3));
+    m->finishAppend();
+
+    CHECK(m->getNumNonZeros() == 3);
+    REQUIRE(m->getNumNonZeroRows() == 2);
+    CHECK(m->getRowIdxs()[0] == 3);
+    CHECK(m->getRowIdxs()[1] == 123456789);
+    CHECK(m->getRowOffsets()[1] == 2);
+    CHECK(m->getRowOffsets()[2] == 3);
+
+    CHECK(m->get(3, 5) == VT(1));
+    CHECK(m->get(3, 999999999) == VT(2));
+    CHECK(m->get(3, 6) == VT(0));
+    CHECK(m->get(7, 0) == VT(0));
+    CHECK(m->get(123456789, 42) == VT(3));
+    CHECK(m->get(numRows - 1, numCols - 1) == VT(0));
+
+    SECTION("set inserts and removes non-zeros and rows") {
+        m->set(5, 1, VT(4));
+        m->set(3, 0, VT(5));
+        m->set(3, 5, VT(6));
+        CHECK(m->getNumNonZeroRows() == 3);
+        CHECK(m->getNumNonZeros() == 5);
+        CHECK(m->get(5, 1) == VT(4));
+        CHECK(m->get(3, 0) == VT(5));
+        CHECK(m->get(3, 5) == VT(6));
+        CHECK(m->get(123456789, 42) == VT(3));
+
+        m->set(5, 1, VT(0));
+        m->set(8, 8, VT(0));
+        CHECK(m->getNumNonZeroRows() == 2);
+        CHECK(m->getNumNonZeros() == 4);
+        CHECK(m->getRowIdxs()[1] == 123456789);
+        CHECK(m->getRowOffsets()[1] == 3);
+    }
+    SECTION("slices are copies of the non-zeros in bounds") {
+        DCSRMatrix<VT> * s = m->slice(2, 123456790, 5, 1000);
+        CHECK(s->getNumRows() == 123456788);
+        CHECK(s->getNumCols() == 995);
+        CHECK(s->getNumNonZeros() == 2);
+        CHECK(s->get(1, 0) == VT(1));
+        CHECK(s->get(123456787, 37) == VT(3));
+        DataObjectFactory::destroy(s);
+
+        DCSRMatrix<VT> * rows = m->sliceRow(4, 100);
+        CHECK(rows->getNumNonZeros() == 0);
+        CHECK(rows->getNumNonZeroRows() == 0);
+        DataObjectFactory::destroy(rows);
+
+        CHECK_THROWS_AS(m->sliceCol(0, numCols + 1), std::runtime_error);
+    }
+
+    DataObjectFactory::destroy(m);
+}
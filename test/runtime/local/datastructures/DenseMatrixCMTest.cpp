@@ -0,0 +1,69 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("DenseMatrixCM stores the columns contiguously", TAG_DATASTRUCTURES, double, int64_t) {
+    using VT = TestType;
+    const size_t numRows = 4;
+    const size_t numCols = 3;
+    auto m = DataObjectFactory::create<DenseMatrixCM<VT>>(numRows, numCols, false);
+    m->prepareAppend();
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            m->append(r, c, VT(r * 10 + c));
+    m->finishAppend();
+
+    CHECK(m->getColSkip() == numRows);
+    CHECK(m->isContiguous());
+    const VT * values = m->getValues();
+    for(size_t c = 0; c < numCols; c++) {
+        CHECK(m->getColumn(c) == values + c * numRows);
+        for(size_t r = 0; r < numRows; r++)
+            CHECK(values[c * numRows + r] == VT(r * 10 + c));
+    }
+
+    SECTION("slices are views") {
+        DenseMatrixCM<VT> * s = m->slice(1, 3, 1, 3);
+        CHECK(s->getNumRows() == 2);
+        CHECK(s->getNumCols() == 2);
+        CHECK(s->getColSkip() == numRows);
+        CHECK_FALSE(s->isContiguous());
+        CHECK(s->getColumn(0) == m->getColumn(1) + 1);
+        CHECK(s->get(1, 1) == VT(22));
+        s->set(0, 0, VT(-1));
+        CHECK(m->get(1, 1) == VT(-1));
+        DataObjectFactory::destroy(s);
+
+        DenseMatrixCM<VT> * cols = m->sliceCol(1, 2);
+        CHECK(cols->isContiguous());
+        CHECK(cols->getValues() == m->getColumn(1));
+        DataObjectFactory::destroy(cols);
+
+        CHECK_THROWS_AS(m->sliceRow(0, numRows + 1), std::runtime_error);
+    }
+
+    DataObjectFactory::destroy(m);
+}
@@ -24,6 +24,8 @@
 #include <catch.hpp>
 
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 TEMPLATE_TEST_CASE("DenseMatrix allocates enough space", TAG_DATASTRUCTURES, ALL_VALUE_TYPES) {
     // No assertions in this test case. We just want to see if it runs without
@@ -199,4 +201,32 @@ TEST_CASE("DenseMatrix sub-matrix works properly", TAG_DATASTRUCTURES) {
         DataObjectFactory::destroy(mSub);
         DataObjectFactory::destroy(mOrig);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("DenseMatrix reference counting is thread-safe", TAG_DATASTRUCTURES) {
+    const size_t numThreads = 4;
+    const size_t numIters = 10000;
+
+    auto m = DataObjectFactory::create<DenseMatrix<double>>(2, 2, true);
+
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++)
+        threads.emplace_back([m]() {
+            for(size_t i = 0; i < numIters; i++) {
+                m->increaseRefCounter();
+                DataObjectFactory::destroy(m);
+            }
+        });
+    for(auto& t : threads)
+        t.join();
+    CHECK(m->getRefCounter() == 1);
+
+    m->increaseRefCounter(numIters);
+    CHECK(m->getRefCounter() == numIters + 1);
+    m->unpinRefCounter(numIters);
+    CHECK(m->getRefCounter() == 1);
+    // the last reference can only be released by destroy()
+    CHECK_THROWS(m->unpinRefCounter(1));
+
+    DataObjectFactory::destroy(m);
+}
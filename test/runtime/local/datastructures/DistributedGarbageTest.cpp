@@ -0,0 +1,78 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DistributedGarbage.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("DistributedGarbage frees the data at the workers in batches", TAG_DATASTRUCTURES) {
+    DistributedGarbage & garbage = DistributedGarbage::get();
+    std::mutex mtx;
+    std::map<std::string, std::vector<size_t>> batchSizes;
+    std::set<std::string> freed;
+    garbage.setFreeFunction([&](const std::string &worker, const std::vector<std::string> &ids)
+            -> std::optional<uint64_t> {
+        if (worker == "failed:1")
+            return std::nullopt;
+        std::lock_guard<std::mutex> lock(mtx);
+        batchSizes[worker].push_back(ids.size());
+        freed.insert(ids.begin(), ids.end());
+        return 1000;
+    });
+
+    {
+        auto handle = garbage.hold("worker:1", "tmp_0");
+        auto copy = handle;
+        handle.reset();
+        garbage.flush();
+        // a copy of the handle is still alive
+        CHECK(freed.empty());
+    }
+    garbage.flush();
+    CHECK(freed.count("tmp_0"));
+
+    const size_t n = DistributedGarbage::BATCH_SIZE + 3;
+    for (size_t i = 0; i < n; i++)
+        garbage.release("worker:2", "tmp_" + std::to_string(i + 1));
+    garbage.release("failed:1", "tmp_x");
+    garbage.flush();
+    REQUIRE(batchSizes["worker:2"].size() == 2);
+    CHECK(batchSizes["worker:2"][0] == DistributedGarbage::BATCH_SIZE);
+    CHECK(batchSizes["worker:2"][1] == 3);
+
+    auto stats = garbage.getStats();
+    CHECK(stats["worker:2"].numFreed == n);
+    CHECK(stats["worker:2"].residentBytes == 1000u);
+    CHECK(stats["failed:1"].numFailed == 1);
+    std::stringstream report;
+    garbage.printStats(report);
+    CHECK(report.str().find("worker:2") != std::string::npos);
+
+    garbage.shutdown();
+    // without a free function, the identifiers are dropped
+    garbage.release("worker:1", "tmp_y");
+    garbage.flush();
+    CHECK_FALSE(freed.count("tmp_y"));
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <util/FlatHashMap.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <string>
+#include <unordered_map>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("FlatHashMap", TAG_DATASTRUCTURES, int64_t, uint32_t, double) {
+    using K = TestType;
+
+    // many colliding tags and slots, and growing from the minimal capacity
+    FlatHashMap<K, size_t> map;
+    std::unordered_map<K, size_t> exp;
+    for(size_t i = 0; i < 100000; i++) {
+        const K k = static_cast<K>((i * 7919) % 30011);
+        map[k] += i;
+        exp[k] += i;
+    }
+    REQUIRE(map.size() == exp.size());
+    for(const auto & [k, v] : exp) {
+        const size_t * found = map.find(k);
+        REQUIRE(found != nullptr);
+        CHECK(*found == v);
+    }
+    CHECK_FALSE(map.contains(static_cast<K>(30011)));
+
+    // the entries are in the order of their insertion
+    size_t pos = 0;
+    for(const auto & [k, v] : map)
+        CHECK(k == static_cast<K>((pos++ * 7919) % 30011));
+
+    const auto [posOld, inserted] = map.emplace(static_cast<K>(0), 42);
+    CHECK(posOld == 0);
+    CHECK_FALSE(inserted);
+    CHECK(map.at(0).second == exp[0]);
+
+    map.clear();
+    CHECK(map.empty());
+    CHECK_FALSE(map.contains(static_cast<K>(0)));
+}
+
+TEST_CASE("FlatHashSet", TAG_DATASTRUCTURES) {
+    FlatHashSet<std::string> set(10);
+    for(size_t i = 0; i < 5000; i++)
+        CHECK(set.insert("key" + std::to_string(i % 1000)).second == (i < 1000));
+    CHECK(set.size() == 1000);
+    CHECK(set.contains("key999"));
+    CHECK_FALSE(set.contains("key1000"));
+    CHECK(*set.begin() == "key0");
+
+    FlatHashSet<double> zeros;
+    zeros.insert(0.0);
+    CHECK(zeros.contains(-0.0));
+}
@@ -145,4 +145,29 @@ TEST_CASE("Frame column labels must be unique", TAG_DATASTRUCTURES) {
     ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::UI8};
     const std::string labels[] = {"foo", "bar", "foo"};
     CHECK_THROWS(DataObjectFactory::create<Frame>(4, 3, schema, labels, false));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Frame slices share the schema and the labels", TAG_DATASTRUCTURES) {
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::UI8};
+    const std::string labels[] = {"a", "b", "c"};
+    auto f = DataObjectFactory::create<Frame>(4, 3, schema, labels, false);
+
+    auto rows = f->sliceRow(1, 3);
+    CHECK(rows->getFrameSchema().get() == f->getFrameSchema().get());
+    CHECK(rows->getColumnIdx("c") == 2);
+
+    // a slice of some of the columns has labels of its own
+    auto cols = f->sliceCol(1, 3);
+    CHECK(cols->getFrameSchema().get() != f->getFrameSchema().get());
+    CHECK(cols->getColumnIdx("c") == 1);
+    CHECK(cols->getColumnType(0) == ValueTypeCode::F64);
+
+    // the slices keep the labels the frame had when they were created
+    const std::string newLabels[] = {"x", "y", "z"};
+    f->setLabels(newLabels);
+    CHECK(f->getColumnIdx("z") == 2);
+    CHECK(rows->getLabels()[2] == "c");
+    CHECK_THROWS(rows->getColumnIdx("z"));
+
+    DataObjectFactory::destroy(f, rows, cols);
+}
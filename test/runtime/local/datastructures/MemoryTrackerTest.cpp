@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/MemoryTracker.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("MemoryTracker attributes the data objects to statements", TAG_DATASTRUCTURES) {
+    MemoryTracker & tracker = MemoryTracker::get();
+    tracker.enable();
+
+    tracker.setStatement("script.daph:1:5");
+    auto m1 = DataObjectFactory::create<DenseMatrix<double>>(1000, 100, false);
+    // a view allocates nothing, thus, it is not attributed
+    auto view = DataObjectFactory::create<DenseMatrix<double>>(m1, 0, 10, 0, 100);
+    tracker.setStatement("script.daph:2:5");
+    auto m2 = DataObjectFactory::create<DenseMatrix<double>>(10, 10, false);
+
+    const int64_t bytes1 = 1000 * 100 * sizeof(double);
+    const int64_t bytes2 = 10 * 10 * sizeof(double);
+    CHECK(tracker.getTypeStats(ALLOCATION_TYPE::HOST).liveBytes == bytes1 + bytes2);
+    auto statements = tracker.getStatementStats();
+    REQUIRE(statements.size() == 2);
+    CHECK(statements["script.daph:1:5"].numLiveObjects == 1);
+    CHECK(statements["script.daph:1:5"].liveBytes == bytes1);
+    CHECK(statements["script.daph:2:5"].liveBytes == bytes2);
+
+    std::stringstream report;
+    tracker.printReport(report);
+    // the statement holding the most memory comes first
+    CHECK(report.str().find("script.daph:1:5") < report.str().find("script.daph:2:5"));
+
+    DataObjectFactory::destroy(view, m1);
+    const MemoryTracker::TypeStats host = tracker.getTypeStats(ALLOCATION_TYPE::HOST);
+    CHECK(host.liveBytes == bytes2);
+    CHECK(host.peakBytes == bytes1 + bytes2);
+    statements = tracker.getStatementStats();
+    CHECK(statements["script.daph:1:5"].numLiveObjects == 0);
+    CHECK(statements["script.daph:1:5"].numObjects == 1);
+    CHECK(statements["script.daph:1:5"].peakBytes == bytes1);
+
+    DataObjectFactory::destroy(m2);
+    CHECK(tracker.getTypeStats(ALLOCATION_TYPE::HOST).liveBytes == 0);
+
+    SECTION("placements tracked by handles") {
+        {
+            auto handle = tracker.track(ALLOCATION_TYPE::DIST_GRPC, 1024);
+            auto copy = handle;
+            handle.reset();
+            CHECK(tracker.getTypeStats(ALLOCATION_TYPE::DIST_GRPC).liveBytes == 1024);
+        }
+        CHECK(tracker.getTypeStats(ALLOCATION_TYPE::DIST_GRPC).liveBytes == 0);
+        CHECK(tracker.getTypeStats(ALLOCATION_TYPE::DIST_GRPC).peakBytes == 1024);
+    }
+    tracker.disable();
+}
+
+TEST_CASE("MemoryTracker enforces the soft memory limit", TAG_DATASTRUCTURES) {
+    MemoryTracker & tracker = MemoryTracker::get();
+    BufferPool::get().clear();
+    tracker.enable(size_t(4) << 20);
+    tracker.setStatement("script.daph:3:1");
+
+    // the array of the first matrix is cached by the BufferPool when it is dropped, which is freed for the second one
+    auto m1 = DataObjectFactory::create<DenseMatrix<double>>(256, 1024, false);
+    DataObjectFactory::destroy(m1);
+    auto m2 = DataObjectFactory::create<DenseMatrix<double>>(384, 1024, false);
+    CHECK(BufferPool::get().getStats().cachedBytes == 0);
+
+    // both matrices together exceed the limit
+    try {
+        DataObjectFactory::create<DenseMatrix<double>>(384, 1024, false);
+        FAIL("the memory limit was not enforced");
+    }
+    catch(const std::runtime_error & e) {
+        const std::string msg = e.what();
+        CHECK(msg.find("memory limit") != std::string::npos);
+        CHECK(msg.find("script.daph:3:1") != std::string::npos);
+    }
+    CHECK(tracker.getTypeStats(ALLOCATION_TYPE::HOST).liveBytes == 384 * 1024 * sizeof(double));
+
+    DataObjectFactory::destroy(m2);
+    tracker.disable();
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/ReuseCache.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstddef>
+
+namespace {
+    const size_t numBytes = 10 * 10 * sizeof(double);
+
+    // a "kernel" adding a scalar to each cell, which counts its calls
+    void addSca(DenseMatrix<double> *& res, const DenseMatrix<double> * arg, double sca, size_t & numCalls) {
+        ReuseCache::call("addSca", res, [&]() {
+            numCalls++;
+            res = DataObjectFactory::create<DenseMatrix<double>>(arg->getNumRows(), arg->getNumCols(), false);
+            for(size_t i = 0; i < arg->getNumItems(); i++)
+                res->getValues()[i] = arg->getValues()[i] + sca;
+        }, arg, sca);
+    }
+
+    DenseMatrix<double> * createMatrix() {
+        return DataObjectFactory::create<DenseMatrix<double>>(10, 10, true);
+    }
+}
+
+TEST_CASE("ReuseCache reuses the results of calls with the same lineage", TAG_DATASTRUCTURES) {
+    ReuseCache & cache = ReuseCache::get();
+    cache.clear();
+    cache.setBudget(10 * numBytes);
+
+    size_t numCalls = 0;
+    auto x = createMatrix();
+
+    DenseMatrix<double> * r1 = nullptr;
+    addSca(r1, x, 1, numCalls);
+    DenseMatrix<double> * r2 = nullptr;
+    addSca(r2, x, 1, numCalls);
+    CHECK(numCalls == 1);
+    CHECK(r2 == r1);
+    CHECK(r1->getRefCounter() == 3);
+    CHECK(r1->get(0, 0) == 1);
+
+    SECTION("different scalar arguments") {
+        DenseMatrix<double> * r3 = nullptr;
+        addSca(r3, x, 2, numCalls);
+        CHECK(numCalls == 2);
+        CHECK(r3->get(0, 0) == 2);
+        DataObjectFactory::destroy(r3);
+    }
+    SECTION("results of reused results") {
+        // the result carries the lineage of its call, so an equal result computed again is recognized
+        DenseMatrix<double> * r3 = nullptr;
+        addSca(r3, r2, 1, numCalls);
+        auto y = createMatrix();
+        y->setLineageId(r1->getLineageId());
+        DenseMatrix<double> * r4 = nullptr;
+        addSca(r4, y, 1, numCalls);
+        CHECK(numCalls == 2);
+        CHECK(r4 == r3);
+        DataObjectFactory::destroy(r3, r4, y);
+    }
+    SECTION("overwritten argument") {
+        x->getValues()[0] = 5;
+        x->renewLineageId();
+        DenseMatrix<double> * r3 = nullptr;
+        addSca(r3, x, 1, numCalls);
+        CHECK(numCalls == 2);
+        CHECK(r3->get(0, 0) == 6);
+        DataObjectFactory::destroy(r3);
+    }
+    SECTION("disabled cache") {
+        cache.setBudget(0);
+        CHECK(cache.getStatistics().numEntries == 0);
+        CHECK(r1->getRefCounter() == 2);
+        DenseMatrix<double> * r3 = nullptr;
+        addSca(r3, x, 1, numCalls);
+        CHECK(numCalls == 2);
+        DataObjectFactory::destroy(r3);
+    }
+
+    const ReuseCache::Statistics stats = cache.getStatistics();
+    CHECK(stats.hits >= 1);
+    CHECK(stats.misses >= 1);
+
+    DataObjectFactory::destroy(r1, r2, x);
+    cache.setBudget(0);
+    cache.clear();
+}
+
+TEST_CASE("ReuseCache evicts the results cheapest to recompute per byte", TAG_DATASTRUCTURES) {
+    ReuseCache & cache = ReuseCache::get();
+    cache.clear();
+    cache.setBudget(2 * numBytes);
+
+    auto expensive = createMatrix();
+    auto cheap = createMatrix();
+    auto other = createMatrix();
+    cache.insert("expensive", expensive, numBytes, 10);
+    cache.insert("cheap", cheap, numBytes, 1);
+    cache.insert("other", other, numBytes, 5);
+    // a result beyond the budget is not cached
+    auto huge = createMatrix();
+    cache.insert("huge", huge, 3 * numBytes, 100);
+
+    CHECK(cache.getStatistics().evictions == 1);
+    CHECK(cache.getStatistics().cachedBytes == 2 * numBytes);
+    CHECK(cheap->getRefCounter() == 1);
+    CHECK(huge->getRefCounter() == 1);
+    const Structure * hit = cache.lookup("expensive");
+    CHECK(hit == expensive);
+    CHECK(cache.lookup("cheap") == nullptr);
+    CHECK(cache.lookup("other") == other);
+
+    DataObjectFactory::destroy(expensive, expensive, cheap, other, other, huge);
+    cache.setBudget(0);
+    cache.clear();
+}
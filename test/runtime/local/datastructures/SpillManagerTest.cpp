@@ -0,0 +1,130 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/SpillManager.h>
+#include <runtime/local/io/ReadDaphne.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+    const size_t numRows = 100;
+    const size_t numCols = 100;
+    const size_t numBytes = numRows * numCols * sizeof(double);
+
+    DenseMatrix<double> * createFilled(double offset) {
+        auto m = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+        double * v = m->getValues();
+        for(size_t i = 0; i < numRows * numCols; i++)
+            v[i] = offset + i;
+        return m;
+    }
+
+    bool isSpilled(const DenseMatrix<double> * m) {
+        auto & mdo = m->getMetaDataObject();
+        return mdo.getDataPlacementByType(ALLOCATION_TYPE::HOST)->empty()
+                && !mdo.getDataPlacementByType(ALLOCATION_TYPE::DISK)->empty();
+    }
+
+    std::string getSpillFile(const DenseMatrix<double> * m) {
+        return m->getMetaDataObject().getDataPlacementByType(ALLOCATION_TYPE::DISK)->front()->allocation
+                ->getLocation();
+    }
+
+    void checkValues(const DenseMatrix<double> * m, double offset) {
+        const double * v = m->getValues();
+        bool equal = true;
+        for(size_t i = 0; i < numRows * numCols; i++)
+            equal = equal && v[i] == offset + i;
+        CHECK(equal);
+    }
+}
+
+TEST_CASE("SpillManager spills the least recently used matrices and reloads them", TAG_DATASTRUCTURES) {
+    std::vector<DF_compression_t> compressions = {DF_compression_t::none};
+#ifdef USE_LZ4
+    compressions.push_back(DF_compression_t::lz4);
+#endif
+    for(DF_compression_t compression : compressions) {
+        SpillManager & spill = SpillManager::get();
+        // room for the values of two matrices, only the last access is protected
+        spill.enable(2 * numBytes, "", compression, 1);
+
+        auto a = createFilled(0);
+        auto b = createFilled(1000);
+        // the values of c do not fit anymore, a is the least recently used matrix
+        auto c = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+        CHECK(isSpilled(a));
+        CHECK_FALSE(isSpilled(b));
+        CHECK(spill.getStatistics().spills == 1);
+        const std::string fileA = getSpillFile(a);
+        CHECK(access(fileA.c_str(), F_OK) == 0);
+        if(compression == DF_compression_t::none) {
+            // the spill file is a Daphne binary file
+            DenseMatrix<double> * read = nullptr;
+            readDaphne(read, fileA.c_str());
+            checkValues(read, 0);
+            DataObjectFactory::destroy(read);
+        }
+
+        // reloaded transparently, the spill file remains up to date
+        checkValues(a, 0);
+        CHECK_FALSE(isSpilled(a));
+        CHECK(spill.getStatistics().reloads == 1);
+
+        // a is up to date in its spill file, thus, it is evicted before b without writing
+        checkValues(b, 1000);
+        double * vc = c->getValues();
+        vc[0] = 42;
+        auto d = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+        CHECK(isSpilled(a));
+        CHECK(isSpilled(b));
+        CHECK(spill.getStatistics().spills == 2);
+        CHECK(spill.getStatistics().evictions == 3);
+
+        // values changed after the reload are spilled again
+        a->getValues()[0] = -1;
+        CHECK(a->get(0, 0) == -1);
+        checkValues(b, 1000);
+        CHECK(isSpilled(a) == false);
+        c->getValues();
+        d->getValues();
+        CHECK(isSpilled(a));
+        CHECK(a->get(0, 0) == -1);
+        CHECK(a->get(0, 1) == 1);
+
+        // views share the values, which are not spilled then
+        auto view = a->sliceRow(0, 10);
+        b->getValues();
+        c->getValues();
+        d->getValues();
+        CHECK_FALSE(isSpilled(a));
+        CHECK(view->get(9, 0) == 900);
+
+        DataObjectFactory::destroy(view, a, b, c, d);
+        // the spill files are removed with their matrices
+        CHECK(access(fileA.c_str(), F_OK) != 0);
+        spill.disable();
+    }
+}
@@ -15,18 +15,23 @@
  */
 
 #include <runtime/local/vectorized/TaskQueues.h>
+#include <runtime/local/vectorized/Tasks.h>
 #include <tags.h>
 #include <catch.hpp>
+#include <atomic>
 #include <cstdint>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 TEST_CASE("Task sequence", TAG_DATASTRUCTURES) {
     TaskQueue* bq = new BlockingTaskQueue(5);
-    std::mutex mtx;
+    std::vector<VectorizedDataSink<DenseMatrix<double>>*> sinks;
     CompiledPipelineTaskData<DenseMatrix<double>> data{{}, {}, {}, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0,
             nullptr, nullptr, 0, nullptr};
-    Task* t1 = new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr);
-    Task* t2 = new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr);
-    Task* t3 = new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr);
+    Task* t1 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
+    Task* t2 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
+    Task* t3 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
     
     //check return sequence
     bq->enqueueTask(t1);
@@ -44,11 +49,11 @@ TEST_CASE("Task sequence", TAG_DATASTRUCTURES) {
 
 TEST_CASE("Queue size", TAG_DATASTRUCTURES) {
     TaskQueue* bq = new BlockingTaskQueue(5);
-    std::mutex mtx;
+    std::vector<VectorizedDataSink<DenseMatrix<double>>*> sinks;
     CompiledPipelineTaskData<DenseMatrix<double>> data{{}, {}, {}, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0,
             nullptr, nullptr, 0, nullptr};
-    Task* t1 = new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr);
-    Task* t2 = new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr);
+    Task* t1 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
+    Task* t2 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
 
     // check proper size management
     CHECK(bq->size() == 0);
@@ -68,10 +73,10 @@ TEST_CASE("Queue size", TAG_DATASTRUCTURES) {
 
 TEST_CASE("EOF handling", TAG_DATASTRUCTURES) {
     TaskQueue* bq = new BlockingTaskQueue(5);
-    std::mutex mtx;
+    std::vector<VectorizedDataSink<DenseMatrix<double>>*> sinks;
     CompiledPipelineTaskData<DenseMatrix<double>> data{{}, {}, {}, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0,
             nullptr, nullptr, 0, nullptr};
-    Task* t1 = new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr);
+    Task* t1 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
 
     // check EOF after last task
     bq->enqueueTask(t1);
@@ -83,3 +88,101 @@ TEST_CASE("EOF handling", TAG_DATASTRUCTURES) {
     delete t1;
     delete bq;
 }
+
+TEST_CASE("Work-stealing deque: owner and thief ends", TAG_DATASTRUCTURES) {
+    TaskQueue* dq = new WorkStealingDeque(2);
+    std::vector<VectorizedDataSink<DenseMatrix<double>>*> sinks;
+    CompiledPipelineTaskData<DenseMatrix<double>> data{{}, {}, {}, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0,
+            nullptr, nullptr, 0, nullptr};
+    Task* t1 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
+    Task* t2 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
+    Task* t3 = new CompiledPipelineTask<DenseMatrix<double>>(data, sinks);
+
+    // the initial capacity of 2 forces the circular buffer to grow
+    dq->enqueueTask(t1);
+    dq->enqueueTask(t2);
+    dq->enqueueTask(t3);
+    CHECK(dq->size() == 3);
+    // the owner pops from the bottom, thieves steal from the top
+    CHECK(dq->dequeueTask() == t3);
+    CHECK(dq->stealTask() == t1);
+    CHECK(dq->size() == 1);
+    dq->closeInput();
+    CHECK(dq->dequeueTask() == t2);
+    CHECK(dynamic_cast<EOFTask*>(dq->dequeueTask()));
+    CHECK(dynamic_cast<EOFTask*>(dq->stealTask()));
+
+    delete t1;
+    delete t2;
+    delete t3;
+    delete dq;
+}
+
+TEST_CASE("Work-stealing deque: concurrent stealing", TAG_DATASTRUCTURES) {
+    const size_t numTasks = 10000;
+    const size_t numThieves = 3;
+    auto* dq = new WorkStealingDeque();
+    std::vector<VectorizedDataSink<DenseMatrix<double>>*> sinks;
+    CompiledPipelineTaskData<DenseMatrix<double>> data{{}, {}, {}, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0,
+            nullptr, nullptr, 0, nullptr};
+    std::vector<Task*> tasks;
+    std::unordered_map<Task*, size_t> taskIdxs;
+    for(size_t i = 0; i < numTasks; i++) {
+        tasks.push_back(new CompiledPipelineTask<DenseMatrix<double>>(data, sinks));
+        taskIdxs[tasks.back()] = i;
+        dq->enqueueTask(tasks.back());
+    }
+    dq->closeInput();
+
+    // every task must be handed out exactly once, either to the owner or to one of the thieves
+    std::vector<std::atomic<int>> taken(numTasks);
+    auto record = [&](Task* t) { taken[taskIdxs.at(t)]++; };
+    std::vector<std::thread> thieves;
+    for(size_t i = 0; i < numThieves; i++)
+        thieves.emplace_back([&]() {
+            for(Task* t = dq->stealTask(); !dynamic_cast<EOFTask*>(t); t = dq->stealTask())
+                record(t);
+        });
+    for(Task* t = dq->dequeueTask(); !dynamic_cast<EOFTask*>(t); t = dq->dequeueTask())
+        record(t);
+    for(auto& thief : thieves)
+        thief.join();
+
+    size_t numTakenOnce = 0;
+    for(size_t i = 0; i < numTasks; i++)
+        numTakenOnce += taken[i] == 1;
+    CHECK(numTakenOnce == numTasks);
+
+    for(auto t : tasks)
+        delete t;
+    delete dq;
+}
+
+TEST_CASE("Batched enqueue into bounded queue", TAG_DATASTRUCTURES) {
+    const size_t numTasks = 100;
+    TaskQueue* bq = new BlockingTaskQueue(3);
+    std::vector<Task*> tasks;
+    for(size_t i = 0; i < numTasks; i++)
+        tasks.push_back(new EOFTask());
+
+    // the batch is larger than the capacity, so the producer has to wait for the consumer in between
+    std::vector<TaskQueue*> queues{bq};
+    std::thread producer([&]() {
+        TaskBatcher batcher(queues, 40);
+        for(auto t : tasks)
+            batcher.enqueue(0, t);
+        batcher.flush();
+        bq->closeInput();
+    });
+    std::vector<Task*> dequeued;
+    for(size_t i = 0; i < numTasks; i++)
+        dequeued.push_back(bq->dequeueTask());
+    producer.join();
+
+    // all tasks in their order
+    CHECK(dequeued == tasks);
+
+    for(auto t : tasks)
+        delete t;
+    delete bq;
+}
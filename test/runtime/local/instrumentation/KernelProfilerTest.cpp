@@ -0,0 +1,120 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/instrumentation/KernelProfiler.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <sstream>
+#include <string>
+
+TEST_CASE("KernelProfiler kernel names", TAG_KERNELS) {
+    CHECK(KernelProfiler::getKernelName("_ewAdd__DenseMatrix_double__DenseMatrix_double__DenseMatrix_double")
+            == "ewAdd");
+    CHECK(KernelProfiler::getKernelName("_profileKernelEnd") == "profileKernelEnd");
+    CHECK(KernelProfiler::getKernelName("vectorizedPipeline") == "vectorizedPipeline");
+}
+
+TEST_CASE("KernelProfiler sums up the calls per source location", TAG_KERNELS) {
+    KernelProfiler & profiler = KernelProfiler::get();
+    profiler.clear();
+
+    const char * randKernel = "_randMatrix__DenseMatrix_double__size_t__size_t__double__double__double__int64_t";
+    const char * addKernel = "_ewAdd__DenseMatrix_double__DenseMatrix_double__DenseMatrix_double";
+    DenseMatrix<double> * arg = nullptr;
+    for(size_t i = 0; i < 3; i++) {
+        profiler.begin(randKernel, "test.daph:1:4", false);
+        arg = DataObjectFactory::create<DenseMatrix<double>>(10, 20, true);
+        profiler.end();
+        profiler.addOutput(arg);
+
+        profiler.addInput(arg);
+        profiler.addInput(arg);
+        profiler.begin(addKernel, "test.daph:2:6", false);
+        profiler.end();
+        DataObjectFactory::destroy(arg);
+    }
+
+    auto sites = profiler.getSiteStats();
+    REQUIRE(sites.size() == 2);
+    const KernelProfiler::SiteStats & rand = sites.at({"randMatrix", "test.daph:1:4"});
+    CHECK(rand.numCalls == 3);
+    CHECK(rand.allocatedBytes >= 3 * 10 * 20 * sizeof(double));
+    CHECK(rand.maxNanos <= rand.totalNanos);
+    const KernelProfiler::SiteStats & add = sites.at({"ewAdd", "test.daph:2:6"});
+    CHECK(add.numCalls == 3);
+    CHECK(add.allocatedBytes == 0);
+
+    std::stringstream summary;
+    profiler.printSummary(summary);
+    CHECK(summary.str().find("6 calls") != std::string::npos);
+    CHECK(summary.str().find("randMatrix @ test.daph:1:4") != std::string::npos);
+
+    std::stringstream trace;
+    profiler.writeChromeTrace(trace);
+    const std::string json = trace.str();
+    CHECK(json.find("\"traceEvents\"") != std::string::npos);
+    CHECK(json.find("\"name\": \"ewAdd\"") != std::string::npos);
+    CHECK(json.find("\"inputs\": \"10x20, 10x20\"") != std::string::npos);
+    CHECK(json.find("\"outputs\": \"10x20\"") != std::string::npos);
+
+    profiler.clear();
+    CHECK(profiler.getSiteStats().empty());
+}
+
+TEST_CASE("KernelProfiler relates the cost estimates to the time of the calls", TAG_KERNELS) {
+    KernelProfiler & profiler = KernelProfiler::get();
+    profiler.clear();
+
+    const char * mmKernel = "_matMul__DenseMatrix_double__DenseMatrix_double__DenseMatrix_double__bool__bool";
+    const char * sumKernel = "_sumAll__double__DenseMatrix_double";
+    for(size_t i = 0; i < 2; i++) {
+        profiler.setCost(2e6, 16e3, 8e3);
+        profiler.begin(mmKernel, "test.daph:3:4", false);
+        profiler.end();
+        // without estimates
+        profiler.begin(sumKernel, "test.daph:4:4", false);
+        profiler.end();
+    }
+    CHECK(profiler.hasCosts());
+
+    auto sites = profiler.getSiteStats();
+    const KernelProfiler::SiteStats & mm = sites.at({"matMul", "test.daph:3:4"});
+    CHECK(mm.flops == 4e6);
+    CHECK(mm.bytes == 48e3);
+    CHECK(mm.estimatedNanos == mm.totalNanos);
+    const KernelProfiler::SiteStats & sum = sites.at({"sumAll", "test.daph:4:4"});
+    CHECK(sum.flops == 0);
+    CHECK(sum.estimatedNanos == 0);
+
+    std::stringstream roofline;
+    // the ridge at 10 FLOP/B, the matMul has an intensity of 83 FLOP/B
+    profiler.printRoofline(roofline, {100, 10});
+    CHECK(roofline.str().find("ridge at 10.00 FLOP/B") != std::string::npos);
+    CHECK(roofline.str().find("compute  matMul @ test.daph:3:4") != std::string::npos);
+    CHECK(roofline.str().find("sumAll") == std::string::npos);
+
+    const KernelProfiler::Peaks peaks = KernelProfiler::estimatePeaks(1);
+    CHECK(peaks.gflops > 0);
+    CHECK(peaks.gbps > 0);
+
+    profiler.clear();
+    CHECK_FALSE(profiler.hasCosts());
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef USE_ARROW
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/ArrowCData.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+TEST_CASE("ArrowCData, Frame round trip", TAG_IO) {
+  auto c0 = genGivenVals<DenseMatrix<double>>(4, {0.5, -1.0, 2.25, 3.0});
+  auto c1 = genGivenVals<DenseMatrix<int64_t>>(4, {3, 1, 3, 2});
+  std::vector<Structure *> cols = {c0, c1};
+  const std::string labels[] = {"x", "id"};
+  auto f = DataObjectFactory::create<Frame>(cols, labels);
+  f->encodeColumn(1, ColumnEncoding::DICTIONARY);
+
+  struct ArrowArray array;
+  struct ArrowSchema schema;
+  frameToArrowCData(f, &array, &schema);
+  Frame *read = arrowCDataToFrame(&array, &schema);
+
+  REQUIRE(read->getNumRows() == 4);
+  REQUIRE(read->getNumCols() == 2);
+  CHECK(read->getSchema()[0] == ValueTypeCode::F64);
+  CHECK(read->getSchema()[1] == ValueTypeCode::SI64);
+  CHECK(read->getLabels()[0] == "x");
+  // the dictionary encoding survives the round trip
+  auto dict = read->getDictionaryColumn<int64_t>(1);
+  REQUIRE(dict != nullptr);
+  CHECK(*dict->getDictionary() == std::vector<int64_t>({1, 2, 3}));
+
+  const Frame *cread = read;
+  auto readC0 = cread->getColumn<double>(0);
+  auto readC1 = cread->getColumn<int64_t>(1);
+  CHECK(*readC0 == *c0);
+  CHECK(*readC1 == *c1);
+
+  DataObjectFactory::destroy(read, readC0, readC1);
+  DataObjectFactory::destroy(f, c0, c1);
+}
+
+TEST_CASE("ArrowCData, string column", TAG_IO) {
+  const size_t numRows = 3;
+  ValueTypeCode schemaCodes[] = {ValueTypeCode::STR};
+  const std::string labels[] = {"name"};
+  auto f = DataObjectFactory::create<Frame>(numRows, 1, schemaCodes, labels, false);
+  std::string *strs = static_cast<std::string *>(f->getColumnRaw(0));
+  const char *vals[] = {"b", "", "a"};
+  std::copy(vals, vals + numRows, strs);
+
+  struct ArrowArray array;
+  struct ArrowSchema schema;
+  frameToArrowCData(f, &array, &schema);
+  Frame *read = arrowCDataToFrame(&array, &schema);
+
+  REQUIRE(read->getNumRows() == numRows);
+  CHECK(read->getSchema()[0] == ValueTypeCode::STR);
+  const std::string *readStrs = static_cast<const std::string *>(std::as_const(*read).getColumnRaw(0));
+  for (size_t r = 0; r < numRows; r++)
+    CHECK(readStrs[r] == vals[r]);
+
+  DataObjectFactory::destroy(read, f);
+}
+
+#endif
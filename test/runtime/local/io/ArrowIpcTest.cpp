@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef USE_ARROW
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/ArrowIpc.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstdio>
+
+TEST_CASE("ArrowIpc, Frame", TAG_IO) {
+  auto c0 = genGivenVals<DenseMatrix<double>>(4, {0.5, -1.0, 2.25, 3.0});
+  auto c1 = genGivenVals<DenseMatrix<int64_t>>(4, {1, 2, 3, -4});
+  std::vector<Structure *> cols = {c0, c1};
+  const std::string labels[] = {"x", "id"};
+  auto f = DataObjectFactory::create<Frame>(cols, labels);
+
+  for (const char *fn : {"./test/runtime/local/io/ArrowIpcFrame.feather", "./test/runtime/local/io/ArrowIpcFrame.arrows"}) {
+    ArrowIpcWriteOptions opts;
+    opts.stream = std::string(fn).find(".arrows") != std::string::npos;
+    for (size_t rowsPerBatch : {0, 3}) {
+      opts.rowsPerBatch = rowsPerBatch;
+      writeArrowIpc(f, fn, opts);
+
+      Frame *read = nullptr;
+      readArrowIpc(read, fn);
+      REQUIRE(read->getNumRows() == 4);
+      REQUIRE(read->getNumCols() == 2);
+      CHECK(read->getSchema()[0] == ValueTypeCode::F64);
+      CHECK(read->getSchema()[1] == ValueTypeCode::SI64);
+      CHECK(read->getLabels()[1] == "id");
+      auto readC0 = read->getColumn<double>(0);
+      auto readC1 = read->getColumn<int64_t>(1);
+      CHECK(*readC0 == *c0);
+      CHECK(*readC1 == *c1);
+      DataObjectFactory::destroy(read, readC0, readC1);
+
+      // record batches one after the other
+      ArrowIpcReader reader(fn);
+      size_t numRows = 0;
+      while (auto batch = reader.readNext())
+        numRows += batch->num_rows();
+      CHECK(numRows == 4);
+    }
+    std::remove(fn);
+  }
+
+  DataObjectFactory::destroy(f, c0, c1);
+}
+
+TEST_CASE("ArrowIpc, DenseMatrix", TAG_IO) {
+  auto m = genGivenVals<DenseMatrix<float>>(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  // the rows of the view are not contiguous
+  auto view = m->sliceCol(1, 3);
+  const char fn[] = "./test/runtime/local/io/ArrowIpcMatrix.arrow";
+
+  for (DenseMatrix<float> *arg : {m, view}) {
+    for (size_t rowsPerBatch : {0, 2}) {
+      ArrowIpcWriteOptions opts;
+      opts.rowsPerBatch = rowsPerBatch;
+      writeArrowIpc(arg, fn, opts);
+      DenseMatrix<float> *read = nullptr;
+      readArrowIpc(read, fn);
+      CHECK(*read == *arg);
+      DataObjectFactory::destroy(read);
+    }
+  }
+
+  // converted to another value type
+  writeArrowIpc(m, fn);
+  DenseMatrix<double> *read = nullptr;
+  readArrowIpc(read, fn);
+  auto expected = genGivenVals<DenseMatrix<double>>(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  CHECK(*read == *expected);
+
+  std::remove(fn);
+  DataObjectFactory::destroy(m, view, read, expected);
+}
+
+#endif
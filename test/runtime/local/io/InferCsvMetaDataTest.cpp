@@ -0,0 +1,131 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <parser/metadata/MetaDataParser.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/CsvTokenizer.h>
+#include <runtime/local/io/InferCsvMetaData.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <cstdio>
+
+namespace {
+    void writeFile(const std::string & filename, const std::string & content) {
+        std::ofstream f(filename);
+        f << content;
+    }
+}
+
+TEST_CASE("InferCsvMetaData counts lines", TAG_IO) {
+    std::string s;
+    for(size_t i = 0; i < 1000; i++)
+        s += std::to_string(i) + ((i % 7) ? "," : "\n");
+    uint64_t expected = 0;
+    for(char c : s)
+        expected += c == '\n';
+    CHECK(csvCount(s.data(), s.data() + s.size(), '\n') == expected);
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = 3;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    CHECK(InferCsvMetaData::countLines(s.data(), s.size(), ctx.get()) == expected + 1);
+    s += '\n';
+    CHECK(InferCsvMetaData::countLines(s.data(), s.size(), ctx.get()) == expected + 1);
+}
+
+TEST_CASE("InferCsvMetaData infers the value types", TAG_IO) {
+    const std::string filename = "./test/runtime/local/io/InferCsvMetaData.csv";
+
+    SECTION("single value type") {
+        writeFile(filename, "1,-2,3\n4,+5,\n7,8,9\n");
+        FileMetaData fmd = inferCsvMetaData(filename.c_str());
+        CHECK(fmd.numRows == 3);
+        CHECK(fmd.numCols == 3);
+        CHECK(fmd.isSingleValueType);
+        CHECK(fmd.schema[0] == ValueTypeCode::SI64);
+    }
+    SECTION("individual column types") {
+        writeFile(filename, "1,2.5,\"3\"\r\n4,nan,6\r\n7,1e3,99999999999999999999");
+        FileMetaData fmd = inferCsvMetaData(filename.c_str());
+        CHECK(fmd.numRows == 3);
+        REQUIRE(fmd.numCols == 3);
+        CHECK_FALSE(fmd.isSingleValueType);
+        REQUIRE(fmd.schema.size() == 3);
+        CHECK(fmd.schema[0] == ValueTypeCode::SI64);
+        CHECK(fmd.schema[1] == ValueTypeCode::F64);
+        CHECK(fmd.schema[2] == ValueTypeCode::F64);
+        REQUIRE(fmd.labels.size() == 3);
+        CHECK(fmd.labels[1] == "col_1");
+    }
+    SECTION("samples spread over the file") {
+        std::string s;
+        for(size_t i = 0; i < 100000; i++)
+            s += i == 90000 ? "1.5,2\n" : "1,2\n";
+        writeFile(filename, s);
+        FileMetaData fmd = inferCsvMetaData(filename.c_str());
+        CHECK(fmd.numRows == 100000);
+        REQUIRE(fmd.schema.size() == 2);
+        CHECK(fmd.schema[0] == ValueTypeCode::F64);
+        CHECK(fmd.schema[1] == ValueTypeCode::SI64);
+    }
+    SECTION("invalid files") {
+        writeFile(filename, "1,2\n3,abc\n");
+        CHECK_THROWS(inferCsvMetaData(filename.c_str()));
+        writeFile(filename, "1,2\n3\n");
+        CHECK_THROWS(inferCsvMetaData(filename.c_str()));
+        writeFile(filename, "");
+        CHECK_THROWS(inferCsvMetaData(filename.c_str()));
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("MetaDataParser infers and caches the meta data of CSV files", TAG_IO) {
+    const std::string filename = "./test/runtime/local/io/InferCsvMetaDataCached.csv";
+    const std::string metaFilename = filename + ".meta";
+    std::remove(metaFilename.c_str());
+
+    writeFile(filename, "1,2\n3,4\n");
+    FileMetaData fmd = MetaDataParser::readMetaData(filename);
+    CHECK(fmd.numRows == 2);
+    CHECK(fmd.schema[0] == ValueTypeCode::SI64);
+    REQUIRE(std::ifstream(metaFilename).good());
+
+    // the cached meta data are used while the file is unchanged
+    nlohmann::json json = nlohmann::json::parse(std::ifstream(metaFilename));
+    REQUIRE(json.contains("inferredFrom"));
+    json["numRows"] = 7;
+    writeFile(metaFilename, json.dump());
+    CHECK(MetaDataParser::readMetaData(filename).numRows == 7);
+
+    // and inferred again once it changes
+    writeFile(filename, "1,2.5\n3,4\n5,6\n");
+    FileMetaData fmd2 = MetaDataParser::readMetaData(filename);
+    CHECK(fmd2.numRows == 3);
+    CHECK_FALSE(fmd2.isSingleValueType);
+
+    std::remove(filename.c_str());
+    std::remove(metaFilename.c_str());
+    CHECK_THROWS(MetaDataParser::readMetaData(filename));
+}
@@ -14,15 +14,22 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/io/ReadCsv.h>
+#include <runtime/local/io/ReadCsvFile.h>
 #include <runtime/local/io/File.h>
 
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <fstream>
+#include <memory>
 #include <vector>
 
 #include <cmath>
@@ -267,3 +274,110 @@ TEST_CASE("ReadCsv, varying columns", TAG_IO) {
   DataObjectFactory::destroy(m);
 
 }
+
+TEST_CASE("ReadCsv, in parallel", TAG_IO) {
+  // large enough to be split into several ranges, without a trailing newline
+  const size_t numRows = 200000;
+  char filename[] = "./test/runtime/local/io/ReadCsvParallel.csv";
+  {
+    std::ofstream f(filename);
+    for (size_t r = 0; r < numRows; r++)
+      f << r << ',' << (r % 7) << ".5," << (r % 3) << (r + 1 < numRows ? "\n" : "");
+  }
+
+  for (size_t numThreads : {1, 4}) {
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = numThreads;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    DenseMatrix<double> *m = nullptr;
+    readCsv(m, filename, numRows, 3, ',', ctx.get());
+    bool equal = true;
+    for (size_t r = 0; r < numRows; r++)
+      equal = equal && m->get(r, 0) == r && m->get(r, 1) == (r % 7) + 0.5 && m->get(r, 2) == r % 3;
+    CHECK(equal);
+    DataObjectFactory::destroy(m);
+
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F32, ValueTypeCode::UI8};
+    Frame *fr = nullptr;
+    readCsv(fr, filename, numRows, 3, ',', schema, ctx.get());
+    auto c0 = fr->getColumn<int64_t>(0);
+    auto c1 = fr->getColumn<float>(1);
+    auto c2 = fr->getColumn<uint8_t>(2);
+    equal = true;
+    for (size_t r = 0; r < numRows; r++)
+      equal = equal && c0->get(r, 0) == int64_t(r) && c1->get(r, 0) == (r % 7) + 0.5f && c2->get(r, 0) == r % 3;
+    CHECK(equal);
+    DataObjectFactory::destroy(c0, c1, c2, fr);
+
+    // the first two columns as sorted coordinates
+    CSRMatrix<double> *s = nullptr;
+    readCsv(s, filename, numRows, 7, ',', numRows, true, ctx.get());
+    CHECK(s->getNumNonZeros() == numRows);
+    CHECK(s->getNumNonZeros(numRows - 1) == 1);
+    CHECK(s->get(numRows - 1, (numRows - 1) % 7) == 1);
+    CHECK(s->get(numRows - 1, 0) == ((numRows - 1) % 7 == 0));
+    DataObjectFactory::destroy(s);
+  }
+
+  DaphneUserConfig userConfig{};
+  userConfig.numberOfThreads = 4;
+  auto ctx = std::make_unique<DaphneContext>(userConfig);
+  DenseMatrix<double> *m = nullptr;
+  CHECK_THROWS(readCsv(m, filename, numRows + 1, 3, ',', ctx.get()));
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("ReadCsv, quotes, signs and spaces", TAG_IO, (DenseMatrix), (double, int64_t)) {
+  using DT = TestType;
+  using VT = typename DT::VT;
+  char filename[] = "./test/runtime/local/io/ReadCsv5.csv";
+
+  for (bool mapped : {true, false}) {
+    DT *m = nullptr;
+    if (mapped)
+      readCsv(m, filename, 2, 4, ',');
+    else {
+      struct File *file = openFile(filename);
+      readCsvFile(m, file, 2, 4, ',');
+      closeFile(file);
+    }
+
+    if (std::is_floating_point<VT>::value) {
+      CHECK(m->get(0, 0) == 1.5);
+      CHECK(m->get(0, 1) == 2);
+      CHECK(m->get(0, 2) == 300);
+      CHECK(m->get(0, 3) == -4);
+      CHECK(m->get(1, 0) == 9000000000.0);
+      CHECK(m->get(1, 1) == -0.25);
+      CHECK(m->get(1, 2) == std::numeric_limits<VT>::infinity());
+      CHECK(std::isnan(m->get(1, 3)));
+    } else {
+      CHECK(m->get(0, 0) == 1);
+      CHECK(m->get(0, 1) == 2);
+      CHECK(m->get(0, 2) == 3);
+      CHECK(m->get(0, 3) == -4);
+      // beyond the range of int
+      CHECK(m->get(1, 0) == VT(9000000000));
+      CHECK(m->get(1, 1) == 0);
+      CHECK(m->get(1, 2) == 0);
+      CHECK(m->get(1, 3) == 0);
+    }
+
+    DataObjectFactory::destroy(m);
+  }
+}
+
+TEST_CASE("CsvTokenizer", TAG_IO) {
+  // long enough for the vectorized scans, with a delimiter inside quotes
+  const std::string line = "0123456789012345678901234567890123456789,\"a,b\",,x";
+  const char *pos = line.data();
+  const char *lineEnd = line.data() + line.size();
+  const char *fieldBegin, *fieldEnd;
+  std::vector<std::string> fields;
+  while (pos < lineEnd) {
+    csvNextField(pos, lineEnd, ',', fieldBegin, fieldEnd);
+    fields.emplace_back(fieldBegin, fieldEnd);
+  }
+  CHECK(fields == std::vector<std::string>{"0123456789012345678901234567890123456789", "a,b", "", "x"});
+  for (size_t i = 0; i < line.size(); i++)
+    CHECK(csvFind2(line.data() + i, lineEnd, 'x', 'x') == lineEnd - 1);
+}
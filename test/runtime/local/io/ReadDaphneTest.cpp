@@ -14,13 +14,21 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/io/WriteDaphne.h>
+#include <runtime/local/kernels/CheckEq.h>
 
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <fstream>
+#include <memory>
 #include <vector>
 
 #include <cmath>
@@ -578,3 +586,151 @@ TEST_CASE("ReadDaphne AIS (Frame)", TAG_IO) {
 
   DataObjectFactory::destroy(m);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("ReadDaphne mapped", TAG_IO, (DenseMatrix, CSRMatrix), (double, int32_t)) {
+  using DT = TestType;
+  auto m = genGivenVals<DT>(3, {
+      1, 0, 2, 0,
+      0, 0, 0, 3,
+      4, 5, 0, 0,
+  });
+  char filename[] = "./test/runtime/local/io/mapped.dbdf";
+  writeDaphne(m, filename);
+
+  DT *copied = nullptr;
+  readDaphne(copied, filename);
+  CHECK(*copied == *m);
+
+  DT *mapped = nullptr;
+  readDaphne(mapped, filename, true);
+  CHECK(*mapped == *m);
+  CHECK(reinterpret_cast<uintptr_t>(mapped->getValues()) % DF_body_alignment == 0);
+
+  // writes to the mapping are private
+  mapped->set(1, 3, 7);
+  CHECK(mapped->get(1, 3) == 7);
+  DT *reread = nullptr;
+  readDaphne(reread, filename, true);
+  CHECK(*reread == *m);
+
+  DataObjectFactory::destroy(m, copied, mapped, reread);
+}
+
+TEST_CASE("ReadDaphne version 1", TAG_IO) {
+  // a dense matrix in the format before DF_version 2, without the padding
+  const int64_t vals[] = {1, 2, 3, 4, 5, 6};
+  char filename[] = "./test/runtime/local/io/version1.dbdf";
+  std::ofstream f(filename, std::ios::out | std::ios::binary);
+  DF_header h = {1, DF_data_t::DenseMatrix_t, 2, 3};
+  const ValueTypeCode vt = ValueTypeCode::SI64;
+  DF_body b = {0, 0};
+  DF_body_block bb = {2, 3, DF_body_t::dense};
+  f.write((const char *)&h, sizeof(h));
+  f.write((const char *)&vt, sizeof(vt));
+  f.write((const char *)&b, sizeof(b));
+  f.write((const char *)&bb, sizeof(bb));
+  f.write((const char *)&vt, sizeof(vt));
+  f.write((const char *)vals, sizeof(vals));
+  f.close();
+
+  auto exp = genGivenVals<DenseMatrix<int64_t>>(2, {1, 2, 3, 4, 5, 6});
+  for (bool mapped : {false, true}) {
+    DenseMatrix<int64_t> *m = nullptr;
+    readDaphne(m, filename, mapped);
+    CHECK(*m == *exp);
+    DataObjectFactory::destroy(m);
+  }
+  DataObjectFactory::destroy(exp);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("ReadDaphne blocks", TAG_IO, (DenseMatrix), (double, int64_t, uint8_t)) {
+  using DT = TestType;
+  using VT = typename DT::VT;
+  const size_t numRows = 1000;
+  const size_t numCols = 7;
+  auto m = DataObjectFactory::create<DT>(numRows, numCols, false);
+  for (size_t r = 0; r < numRows; r++)
+    for (size_t c = 0; c < numCols; c++)
+      m->set(r, c, VT((r * numCols + c) % 97));
+  char filename[] = "./test/runtime/local/io/blocks.dbdf";
+
+  std::vector<DF_compression_t> compressions = {DF_compression_t::none};
+#ifdef USE_ZLIB
+  compressions.push_back(DF_compression_t::zlib);
+#endif
+#ifdef USE_LZ4
+  compressions.push_back(DF_compression_t::lz4);
+#endif
+  DaphneUserConfig userConfig{};
+  userConfig.numberOfThreads = 4;
+  auto ctx = std::make_unique<DaphneContext>(userConfig);
+  for (DF_compression_t compression : compressions) {
+    DF_options opts;
+    opts.rowsPerBlock = 64;
+    opts.compression = compression;
+    opts.ctx = ctx.get();
+    writeDaphne(m, filename, opts);
+
+    DF_block_index idx;
+    const std::vector<DF_block_entry> blocks = readDaphneBlocks(filename, &idx);
+    REQUIRE(blocks.size() == 16);
+    CHECK(idx.compression == compression);
+    CHECK(blocks[15].rx == 960);
+    CHECK(blocks[15].nbrows == 40);
+    CHECK(DF_unpackStat<VT>(blocks[0].min) == 0);
+    CHECK(DF_unpackStat<VT>(blocks[0].max) == 96);
+
+    DT *res = nullptr;
+    readDaphne(res, filename);
+    CHECK(*res == *m);
+    DataObjectFactory::destroy(res);
+
+    // rows within a block and across blocks
+    for (auto range : {std::make_pair(10, 20), std::make_pair(100, 300), std::make_pair(960, 1000)}) {
+      DT *rows = nullptr;
+      readDaphneRows(rows, filename, range.first, range.second, ctx.get());
+      auto exp = m->sliceRow(range.first, range.second);
+      CHECK(*rows == *exp);
+      DataObjectFactory::destroy(rows, exp);
+    }
+  }
+
+  SECTION("views") {
+    auto view = m->sliceCol(2, 5);
+    DF_options opts;
+    opts.rowsPerBlock = 100;
+    writeDaphne(view, filename, opts);
+    DT *res = nullptr;
+    readDaphne(res, filename, true);
+    CHECK(*res == *view);
+    DataObjectFactory::destroy(view, res);
+  }
+  SECTION("single body") {
+    writeDaphne(m, filename);
+    CHECK(readDaphneBlocks(filename).empty());
+    DT *rows = nullptr;
+    readDaphneRows(rows, filename, 500, 1000);
+    auto exp = m->sliceRow(500, 1000);
+    CHECK(*rows == *exp);
+    DataObjectFactory::destroy(rows, exp);
+  }
+  SECTION("corrupt block") {
+    DF_options opts;
+    opts.rowsPerBlock = 64;
+    writeDaphne(m, filename, opts);
+    const std::vector<DF_block_entry> blocks = readDaphneBlocks(filename);
+    std::fstream f(filename, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(blocks[3].offset + 5);
+    f.put(char(101));
+    f.close();
+    DT *res = nullptr;
+    CHECK_THROWS(readDaphne(res, filename));
+    // the other blocks are intact
+    readDaphneRows(res, filename, 0, 64 * 3);
+    auto exp = m->sliceRow(0, 64 * 3);
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(res, exp);
+  }
+
+  DataObjectFactory::destroy(m);
+}
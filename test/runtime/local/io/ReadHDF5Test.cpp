@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef USE_HDF5
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/io/ReadHDF5.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <hdf5.h>
+#include <unistd.h>
+
+namespace {
+  // writes the values i / 2 of a numRows x numCols dataset of the given file type, optionally in chunks of 7 rows and
+  // chunkCols columns, shuffled and compressed
+  std::string writeDataset(const std::string &name, hid_t fileType, size_t numRows, size_t numCols, size_t chunkCols,
+                           bool compressed) {
+    const std::string path = (std::filesystem::temp_directory_path()
+                              / ("daphne-" + name + "-" + std::to_string(getpid()) + ".h5")).string();
+    const hid_t file = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    hsize_t dims[2] = {numRows, numCols};
+    const hid_t space = H5Screate_simple(2, dims, nullptr);
+    const hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    if (chunkCols) {
+      hsize_t chunk[2] = {7, chunkCols};
+      H5Pset_chunk(dcpl, 2, chunk);
+      if (compressed) {
+        H5Pset_shuffle(dcpl);
+        H5Pset_deflate(dcpl, 6);
+      }
+    }
+    const hid_t dset = H5Dcreate2(file, "values", fileType, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+    std::vector<double> values(numRows * numCols);
+    for (size_t i = 0; i < values.size(); i++)
+      values[i] = i * 0.5;
+    H5Dwrite(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+
+    const char *labels[] = {"a", "b", "c", "d", "e"};
+    const hid_t strType = H5Tcopy(H5T_C_S1);
+    H5Tset_size(strType, H5T_VARIABLE);
+    hsize_t numLabels = numCols;
+    const hid_t attrSpace = H5Screate_simple(1, &numLabels, nullptr);
+    const hid_t attr = H5Acreate2(dset, "labels", strType, attrSpace, H5P_DEFAULT, H5P_DEFAULT);
+    H5Awrite(attr, strType, labels);
+    H5Aclose(attr);
+    H5Sclose(attrSpace);
+    H5Tclose(strType);
+
+    H5Dclose(dset);
+    H5Pclose(dcpl);
+    H5Sclose(space);
+    H5Fclose(file);
+    return path;
+  }
+}
+
+TEST_CASE("ReadHDF5, DenseMatrix", TAG_IO) {
+  const size_t numRows = 50;
+  const size_t numCols = 5;
+  std::string path;
+  SECTION("chunks of whole rows, compressed") {
+    path = writeDataset("rows", H5T_IEEE_F64LE, numRows, numCols, numCols, true);
+  }
+  SECTION("chunks of some columns, compressed") {
+    path = writeDataset("cols", H5T_IEEE_F64LE, numRows, numCols, 3, true);
+  }
+  SECTION("chunks, uncompressed") {
+    path = writeDataset("plain", H5T_IEEE_F64LE, numRows, numCols, 3, false);
+  }
+  SECTION("contiguous") {
+    path = writeDataset("contiguous", H5T_IEEE_F64LE, numRows, numCols, 0, false);
+  }
+  SECTION("converted from float") {
+    path = writeDataset("float", H5T_IEEE_F32LE, numRows, numCols, 3, true);
+  }
+
+  DaphneUserConfig userConfig{};
+  userConfig.numberOfThreads = 4;
+  auto ctx = std::make_unique<DaphneContext>(userConfig);
+  DenseMatrix<double> *m = nullptr;
+  readHDF5(m, path.c_str(), ctx.get());
+  REQUIRE(m->getNumRows() == numRows);
+  REQUIRE(m->getNumCols() == numCols);
+  bool equal = true;
+  for (size_t r = 0; r < numRows; r++)
+    for (size_t c = 0; c < numCols; c++)
+      equal = equal && m->get(r, c) == (r * numCols + c) * 0.5;
+  CHECK(equal);
+  DataObjectFactory::destroy(m);
+
+  // the rows of a distributed worker, a hyperslab across chunks
+  m = nullptr;
+  readHDF5Rows(m, path.c_str(), 9, 33, 1, 4, ctx.get());
+  REQUIRE(m->getNumRows() == 24);
+  REQUIRE(m->getNumCols() == 3);
+  equal = true;
+  for (size_t r = 0; r < 24; r++)
+    for (size_t c = 0; c < 3; c++)
+      equal = equal && m->get(r, c) == ((r + 9) * numCols + c + 1) * 0.5;
+  CHECK(equal);
+  DataObjectFactory::destroy(m);
+
+  const FileMetaData fmd = readHDF5MetaData(path.c_str());
+  CHECK(fmd.numRows == numRows);
+  CHECK(fmd.numCols == numCols);
+  REQUIRE(fmd.labels.size() == numCols);
+  CHECK(fmd.labels[1] == "b");
+
+  std::filesystem::remove(path);
+}
+
+#endif
@@ -14,18 +14,28 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/io/ReadMM.h>
+#include <runtime/local/kernels/CheckEq.h>
 
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <utility>
 #include <vector>
 
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <limits>
 
 TEMPLATE_PRODUCT_TEST_CASE("ReadMM CIG", TAG_IO, (DenseMatrix), (int32_t)) {
@@ -392,6 +402,54 @@ TEMPLATE_PRODUCT_TEST_CASE("ReadMM AIS (CSR)", TAG_IO, (CSRMatrix), (int32_t)) {
   DataObjectFactory::destroy(m);
 }
 
+TEST_CASE("ReadMM shuffled symmetric coordinates in parallel (CSR)", TAG_IO) {
+  // large enough to be split into several byte ranges
+  const size_t n = 1000;
+  auto value = [](size_t r, size_t c) { return double((r * 31 + c) % 997) + 0.25; };
+  std::vector<std::pair<size_t, size_t>> lower;
+  for(size_t r = 0; r < n; r++)
+    for(size_t c = 0; c <= r; c++)
+      if((r + c) % 2 == 0)
+        lower.emplace_back(r, c);
+  std::shuffle(lower.begin(), lower.end(), std::mt19937(42));
+
+  const char filename[] = "./test/runtime/local/io/ReadMMShuffled.mtx";
+  {
+    std::ofstream f(filename);
+    f << "%%MatrixMarket matrix coordinate real symmetric\n% shuffled\n" << n << " " << n << " " << lower.size() << "\n";
+    for(auto &e : lower)
+      f << e.first + 1 << "  " << e.second + 1 << " " << value(e.first, e.second) << "\n";
+  }
+
+  CSRMatrix<double> *seq = nullptr;
+  readMM(seq, filename);
+  for(size_t numThreads : {2, 4}) {
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = numThreads;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    CSRMatrix<double> *m = nullptr;
+    readMM(m, filename, ctx.get());
+    REQUIRE(m->getNumRows() == n);
+    REQUIRE(m->getNumCols() == n);
+    // the diagonal and both triangles
+    REQUIRE(m->getNumNonZeros() == 2 * lower.size() - n);
+
+    bool correct = true;
+    for(size_t r = 0; r < n; r++) {
+      const size_t *colIdxs = m->getColIdxs(r);
+      const double *values = m->getValues(r);
+      for(size_t k = 0; k < m->getNumNonZeros(r); k++)
+        correct = correct && (k == 0 || colIdxs[k - 1] < colIdxs[k])
+                  && values[k] == value(std::max(r, colIdxs[k]), std::min(r, colIdxs[k]));
+    }
+    CHECK(correct);
+    CHECK(*m == *seq);
+    DataObjectFactory::destroy(m);
+  }
+  DataObjectFactory::destroy(seq);
+  std::remove(filename);
+}
+
 TEST_CASE("ReadMM CIG (Frame)", TAG_IO) {
   using DT = Frame;
   DT *m = nullptr;
@@ -59,6 +59,41 @@ TEST_CASE("ReadParquet, Frame", TAG_IO) {
   DataObjectFactory::destroy(m);
 }
 
+TEST_CASE("ReadParquet, Frame, selected columns and row groups", TAG_IO) {
+  ValueTypeCode schema[] = { ValueTypeCode::F64, ValueTypeCode::F64 };
+  const char filename[] = "./test/runtime/local/io/ReadParquet1.parquet";
+
+  ParquetReadOptions options;
+  options.columns = {"column_3", "column_1"};
+  Frame *m = nullptr;
+
+  SECTION("all row groups") {
+    readParquet(m, filename, schema, nullptr, options);
+
+    REQUIRE(m->getNumRows() == 2);
+    REQUIRE(m->getNumCols() == 2);
+    CHECK(m->getLabels()[0] == "column_3");
+    CHECK(m->getLabels()[1] == "column_1");
+    CHECK(m->getColumn<double>(0)->get(0, 0) == 0.1);
+    CHECK(m->getColumn<double>(0)->get(1, 0) == 6.22216);
+    CHECK(m->getColumn<double>(1)->get(0, 0) == -0.1);
+    CHECK(m->getColumn<double>(1)->get(1, 0) == 3.14);
+  }
+  SECTION("a predicate some row satisfies") {
+    options.predicates.push_back({"column_1", ParquetPredicate::Cmp::GE, 3.14});
+    readParquet(m, filename, schema, nullptr, options);
+    CHECK(m->getNumRows() == 2);
+  }
+  SECTION("a predicate no row satisfies") {
+    options.predicates.push_back({"column_2", ParquetPredicate::Cmp::GT, 100});
+    readParquet(m, filename, schema, nullptr, options);
+    CHECK(m->getNumRows() == 0);
+    CHECK(m->getNumCols() == 2);
+  }
+
+  DataObjectFactory::destroy(m);
+}
+
 TEMPLATE_PRODUCT_TEST_CASE("ReadParquet, DenseMatrix", TAG_IO, (DenseMatrix), (double)) {
   using DT = TestType;
   DT *m = nullptr;
@@ -86,4 +121,23 @@ TEMPLATE_PRODUCT_TEST_CASE("ReadParquet, DenseMatrix", TAG_IO, (DenseMatrix), (d
   DataObjectFactory::destroy(m);
 }
 
+TEMPLATE_PRODUCT_TEST_CASE("ReadParquet, DenseMatrix, range of rows", TAG_IO, (DenseMatrix), (double)) {
+  using DT = TestType;
+  DT *m = nullptr;
+
+  char filename[] = "./test/runtime/local/io/ReadParquet1.parquet";
+
+  readParquetRows(m, filename, 1, 2);
+
+  REQUIRE(m->getNumRows() == 1);
+  REQUIRE(m->getNumCols() == 4);
+
+  CHECK(m->get(0, 0) == 3.14);
+  CHECK(m->get(0, 1) == 5.41);
+  CHECK(m->get(0, 2) == 6.22216);
+  CHECK(m->get(0, 3) == 5);
+
+  DataObjectFactory::destroy(m);
+}
+
 #endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/io/File.h>
+#include <runtime/local/io/ReadCsv.h>
+#include <runtime/local/io/WriteCsv.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+    std::string readFile(const std::string & filename) {
+        std::ifstream f(filename);
+        std::stringstream s;
+        s << f.rdbuf();
+        return s.str();
+    }
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("WriteCsv formats like printf", TAG_IO, (DenseMatrix), (double, int64_t)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+    auto m = DataObjectFactory::create<DT>(3, 2, false);
+    const VT vals[] = {VT(1.5), VT(-2), VT(0), VT(123456789), VT(-0.25), VT(7)};
+    for(size_t i = 0; i < 6; i++)
+        m->set(i / 2, i % 2, vals[i]);
+
+    std::string expected;
+    char cell[64];
+    for(size_t i = 0; i < 6; i++) {
+        if(std::is_floating_point<VT>::value)
+            snprintf(cell, sizeof(cell), "%f", double(vals[i]));
+        else
+            snprintf(cell, sizeof(cell), "%ld", static_cast<long>(vals[i]));
+        expected += cell;
+        expected += (i % 2) ? "\n" : ",";
+    }
+
+    const char filename[] = "./test/runtime/local/io/WriteCsvFormat.csv";
+    File * file = openFileForWrite(filename);
+    writeCsv(m, file);
+    closeFile(file);
+    CHECK(readFile(filename) == expected);
+
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = 2;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    CsvWriteOptions opts;
+    opts.ctx = ctx.get();
+    writeCsv(m, filename, opts);
+    CHECK(readFile(filename) == expected);
+
+    std::remove(filename);
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("WriteCsv in parallel and per partition", TAG_IO) {
+    using DT = DenseMatrix<int64_t>;
+    // a view of many chunks of rows
+    const size_t numRows = 100000;
+    auto m = DataObjectFactory::create<DT>(numRows, 4, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < 4; c++)
+            m->set(r, c, int64_t(r * 4 + c) - 1000);
+    auto view = m->sliceCol(1, 3);
+
+    const char filename[] = "./test/runtime/local/io/WriteCsvParallel.csv";
+    File * file = openFileForWrite(filename);
+    writeCsv(view, file);
+    closeFile(file);
+    const std::string expected = readFile(filename);
+
+    for(size_t numThreads : {1, 3}) {
+        DaphneUserConfig userConfig{};
+        userConfig.numberOfThreads = numThreads;
+        auto ctx = std::make_unique<DaphneContext>(userConfig);
+        CsvWriteOptions opts;
+        opts.ctx = ctx.get();
+        writeCsv(view, filename, opts);
+        CHECK(readFile(filename) == expected);
+    }
+
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = 2;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    CsvWriteOptions opts;
+    opts.ctx = ctx.get();
+    opts.numPartitions = 3;
+    writeCsv(view, filename, opts);
+    std::string concatenated;
+    for(size_t p = 0; p < 3; p++) {
+        const std::string partFilename = csvPartitionFilename(filename, p);
+        concatenated += readFile(partFilename);
+        if(p == 1) {
+            const size_t rowBegin = numRows / 3;
+            const size_t rowEnd = numRows * 2 / 3;
+            DT * part = nullptr;
+            readCsv(part, partFilename.c_str(), rowEnd - rowBegin, 2, ',');
+            auto expectedPart = view->sliceRow(rowBegin, rowEnd);
+            CHECK(*part == *expectedPart);
+            DataObjectFactory::destroy(part, expectedPart);
+        }
+        std::remove(partFilename.c_str());
+    }
+    CHECK(concatenated == expected);
+    CHECK(csvPartitionFilename("dir.x/out", 2) == "dir.x/out.2");
+
+    std::remove(filename);
+    DataObjectFactory::destroy(m, view);
+}
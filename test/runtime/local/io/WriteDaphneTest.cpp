@@ -14,18 +14,27 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/io/WriteDaphne.h>
+#include <runtime/local/io/ReadDaphne.h>
 #include <runtime/local/io/ReadMM.h>
+#include <runtime/local/kernels/CheckEq.h>
 
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <limits>
 
 TEMPLATE_PRODUCT_TEST_CASE("WriteDaphne CIG", TAG_IO, (DenseMatrix), (int32_t)) {
@@ -636,3 +645,114 @@ TEST_CASE("WriteDaphne AIS (Frame)", TAG_IO) {
 
   DataObjectFactory::destroy(m);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("WriteDaphne views in parallel", TAG_IO, (DenseMatrix, CSRMatrix), (double)) {
+  using DT = TestType;
+  DT *m = nullptr;
+
+  char filename[] = "./test/runtime/local/io/crg.mtx";
+  readMM(m, filename);
+  // rows of a dense view are not contiguous, the row offsets of a sparse view do not start at zero
+  DT *view = m->sliceRow(10, 490);
+  if constexpr(std::is_same<DT, DenseMatrix<double>>::value) {
+    DT *rows = view;
+    view = rows->sliceCol(3, 400);
+    DataObjectFactory::destroy(rows);
+  }
+
+  char fn[] = "./test/runtime/local/io/crg-view.dbdf";
+  for(size_t numThreads : {1, 3}) {
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = numThreads;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    DF_options opts;
+    opts.ctx = ctx.get();
+    writeDaphne(view, fn, opts);
+    DT *read = nullptr;
+    readDaphne(read, fn);
+    CHECK(*read == *view);
+    DataObjectFactory::destroy(read);
+  }
+
+  std::remove(fn);
+  DataObjectFactory::destroy(m, view);
+}
+
+TEMPLATE_TEST_CASE("WriteDaphne ultra-sparse", TAG_IO, double, int32_t) {
+  using VT = TestType;
+
+  for(size_t numCols : {size_t(1), size_t(3000000000)}) {
+    // the non-zeros are stored as coordinates, independent of the number of rows
+    const size_t numRows = 4000000000;
+    DCSRMatrix<VT> *m = DataObjectFactory::create<DCSRMatrix<VT>>(numRows, numCols);
+    m->prepareAppend();
+    m->append(0, 0, VT(1));
+    m->append(17, numCols - 1, VT(-2));
+    m->append(numRows - 1, numCols / 2, VT(3));
+    m->finishAppend();
+
+    char fn[] = "./test/runtime/local/io/ultra-sparse.dbdf";
+    writeDaphne(m, fn);
+    DCSRMatrix<VT> *read = nullptr;
+    readDaphne(read, fn);
+    CHECK(*read == *m);
+    DataObjectFactory::destroy(read);
+
+    // a CSRMatrix needs row offsets for all rows, so it reads a smaller one
+    if(numCols == 1) {
+      DCSRMatrix<VT> *small = m->sliceRow(0, 100);
+      writeDaphne(small, fn);
+      CSRMatrix<VT> *csr = nullptr;
+      readDaphne(csr, fn);
+      REQUIRE(csr->getNumRows() == 100);
+      REQUIRE(csr->getNumCols() == 1);
+      CHECK(csr->getNumNonZeros() == 2);
+      CHECK(csr->get(0, 0) == VT(1));
+      CHECK(csr->get(17, 0) == VT(-2));
+      CHECK(csr->get(18, 0) == VT(0));
+      DataObjectFactory::destroy(small, csr);
+    }
+
+    std::remove(fn);
+    DataObjectFactory::destroy(m);
+  }
+}
+
+TEST_CASE("WriteDaphne Frame with string columns", TAG_IO) {
+  const size_t numRows = 1000;
+  ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::STR, ValueTypeCode::STR, ValueTypeCode::F64};
+  std::string labels[] = {"id", "name", "city", "x"};
+  Frame *f = DataObjectFactory::create<Frame>(numRows, 4, schema, labels, false);
+  int64_t *ids = static_cast<int64_t *>(f->getColumnRaw(0));
+  std::string *names = static_cast<std::string *>(f->getColumnRaw(1));
+  std::string *cities = static_cast<std::string *>(f->getColumnRaw(2));
+  double *xs = static_cast<double *>(f->getColumnRaw(3));
+  const char *someCities[] = {"Graz", "Berlin", "", "Amsterdam, NL"};
+  for(size_t r = 0; r < numRows; r++) {
+    ids[r] = r;
+    // distinct values are stored as offsets and bytes, few distinct values as a dictionary page
+    names[r] = "name-" + std::to_string(r * 7);
+    cities[r] = someCities[r % 4];
+    xs[r] = r * 0.5;
+  }
+
+  char fn[] = "./test/runtime/local/io/strings-f.dbdf";
+  for(size_t numThreads : {1, 3}) {
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = numThreads;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    DF_options opts;
+    opts.ctx = ctx.get();
+    writeDaphne(f, fn, opts);
+    Frame *read = nullptr;
+    readDaphne(read, fn, false, ctx.get());
+    CHECK(read->getColumnEncoding(1) == ColumnEncoding::NONE);
+    REQUIRE(read->getDictionaryColumn<std::string>(2) != nullptr);
+    CHECK(read->getDictionaryColumn<std::string>(2)->getDictionary()->size() == 4);
+    CHECK(*read == *f);
+    DataObjectFactory::destroy(read);
+  }
+
+  std::remove(fn);
+  DataObjectFactory::destroy(f);
+}
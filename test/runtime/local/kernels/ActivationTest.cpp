@@ -0,0 +1,68 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/Activation.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cmath>
+#include <memory>
+
+TEMPLATE_PRODUCT_TEST_CASE("Activation::ReLU::Forward", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    auto input = genGivenVals<DT>(3, { -3, -2, -1, 0, 1, 2, 3, 4, 5});
+    auto result = genGivenVals<DT>(3, { 0, 0, 0, 0, 1, 2, 3, 4, 5 });
+
+    DT* res = nullptr;
+    Activation::Forward<Activation::ReLU, DT, DT>::apply(res, input, nullptr);
+    CHECK(*res == *result);
+
+    // a view on the last two columns
+    auto view = DataObjectFactory::create<DT>(input, 0, 3, 1, 3);
+    auto resultView = genGivenVals<DT>(3, { 0, 0, 1, 2, 4, 5 });
+    DT* resView = nullptr;
+    Activation::Forward<Activation::ReLU, DT, DT>::apply(resView, view, nullptr);
+    CHECK(*resView == *resultView);
+
+    DataObjectFactory::destroy(input, result, res, view, resultView, resView);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Activation::Sigmoid::Forward", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+    auto input = genGivenVals<DT>(1, { -20, -2, -0.5, 0, 0.5, 2, 20 });
+
+    DaphneUserConfig userConfig{};
+    userConfig.fast_math = GENERATE(false, true);
+    auto dctx = std::make_unique<DaphneContext>(userConfig);
+
+    DT* res = nullptr;
+    Activation::Forward<Activation::Sigmoid, DT, DT>::apply(res, input, dctx.get());
+    for(size_t c = 0; c < input->getNumCols(); c++) {
+        const VT x = input->get(0, c);
+        CHECK(res->get(0, c) == Approx(1.0 / (1.0 + std::exp(-static_cast<double>(x)))).epsilon(1e-6));
+    }
+    CHECK(res->get(0, 3) == VT(0.5));
+
+    DataObjectFactory::destroy(input, res);
+}
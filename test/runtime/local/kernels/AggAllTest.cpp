@@ -15,22 +15,38 @@
  */
 
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/AggAll.h>
 #include <runtime/local/kernels/AggOpCode.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #define TEST_NAME(opName) "AggAll (" opName ")"
-#define DATA_TYPES DenseMatrix, CSRMatrix
+#define DATA_TYPES DenseMatrix, CSRMatrix, BlockedMatrix, DCSRMatrix, CompressedMatrix
 #define VALUE_TYPES double, uint32_t
 
+// a matrix large enough to be aggregated in parallel chunks, with some zeros
+template<class DT>
+DT * genLarge(size_t numRows, size_t numCols) {
+    std::vector<typename DT::VT> vals(numRows * numCols);
+    for(size_t i = 0; i < vals.size(); i++)
+        vals[i] = static_cast<typename DT::VT>(i % 7 == 0 ? 0 : (i * 31) % 17);
+    return genGivenVals<DT>(numRows, vals);
+}
+
 template<class DT>
 void checkAggAll(AggOpCode opCode, const DT * arg, typename DT::VT exp) {
     typename DT::VT res = aggAll<DT>(opCode, arg, nullptr);
@@ -141,4 +157,68 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("mean"), TAG_KERNELS, (DATA_TYPES), (VALUE_
     DataObjectFactory::destroy(m0);
     DataObjectFactory::destroy(m1);
     DataObjectFactory::destroy(m2);
-}
\ No newline at end of file
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("large, parallel"), TAG_KERNELS, (DATA_TYPES), (VALUE_TYPES)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+    ParallelContext ctx;
+
+    const size_t numRows = 1000, numCols = 700;
+    auto m = genLarge<DT>(numRows, numCols);
+    VT sum = 0, min = m->get(0, 0), max = min;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            sum += m->get(r, c);
+            min = std::min(min, m->get(r, c));
+            max = std::max(max, m->get(r, c));
+        }
+
+    CHECK(aggAll<DT>(AggOpCode::SUM, m, ctx.get()) == sum);
+    CHECK(aggAll<DT>(AggOpCode::MIN, m, ctx.get()) == min);
+    CHECK(aggAll<DT>(AggOpCode::MAX, m, ctx.get()) == max);
+    CHECK(aggAll<DT>(AggOpCode::SUM, m, nullptr) == sum);
+
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE(TEST_NAME("sum, pairwise"), TAG_KERNELS) {
+    using DT = DenseMatrix<double>;
+    const size_t numRows = 1000, numCols = 1000;
+    auto m = DataObjectFactory::create<DT>(numRows, numCols, false);
+    std::fill(m->getValues(), m->getValues() + numRows * numCols, 0.1);
+    // summing up sequentially is off by about 1e-6
+    CHECK(std::abs(aggAll<DT>(AggOpCode::SUM, m, nullptr) - 1e5) < 1e-8);
+
+    // a view, whose rows are not contiguous
+    auto view = DataObjectFactory::create<DT>(m, 0, numRows, 1, numCols);
+    CHECK(std::abs(aggAll<DT>(AggOpCode::SUM, view, nullptr) - 0.1 * numRows * (numCols - 1)) < 1e-8);
+
+    DataObjectFactory::destroy(m, view);
+}
+
+TEST_CASE(TEST_NAME("mask, popcount"), TAG_KERNELS) {
+    ParallelContext ctx;
+
+    const size_t numRows = 3001, numCols = 101;
+    auto m = DataObjectFactory::create<BitMatrix>(numRows, numCols, true);
+    size_t count = 0;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            if((r * 7 + c * 3) % 5 == 0) {
+                m->set(r, c, true);
+                count++;
+            }
+
+    CHECK(aggAll(AggOpCode::SUM, m, ctx.get()) == count);
+    CHECK(aggAll(AggOpCode::SUM, m, nullptr) == count);
+    CHECK(aggAll(AggOpCode::MIN, m, ctx.get()) == 0);
+    CHECK(aggAll(AggOpCode::MAX, m, ctx.get()) == 1);
+    CHECK_THROWS(aggAll(AggOpCode::MEAN, m, ctx.get()));
+
+    auto ones = genGivenVals<BitMatrix>(2, {1, 1, 1, 1, 1, 1});
+    CHECK(aggAll(AggOpCode::SUM, ones, nullptr) == 6);
+    CHECK(aggAll(AggOpCode::MIN, ones, nullptr) == 1);
+
+    DataObjectFactory::destroy(m, ones);
+}
@@ -15,27 +15,52 @@
  */
 
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/AggCol.h>
 #include <runtime/local/kernels/AggOpCode.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 
 #define TEST_NAME(opName) "AggCol (" opName ")"
-#define DATA_TYPES DenseMatrix, CSRMatrix
+#define DATA_TYPES DenseMatrix, CSRMatrix, DCSRMatrix, CompressedMatrix, DenseMatrixCM
 #define VALUE_TYPES double, uint32_t
 
+// a matrix large enough to be aggregated in parallel chunks, with some zeros
+template<class DT>
+DT * genLarge(size_t numRows, size_t numCols) {
+    std::vector<typename DT::VT> vals(numRows * numCols);
+    for(size_t i = 0; i < vals.size(); i++)
+        vals[i] = static_cast<typename DT::VT>(i % 7 == 0 ? 0 : (i * 31) % 17);
+    return genGivenVals<DT>(numRows, vals);
+}
+
 template<class DTRes, class DTArg>
 void checkAggCol(AggOpCode opCode, const DTArg * arg, const DTRes * exp) {
     DTRes * res = nullptr;
     aggCol<DTRes, DTArg>(opCode, res, arg, nullptr);
     CHECK(*res == *exp);
+    DataObjectFactory::destroy(res);
+    if constexpr(std::is_same_v<DTArg, CSRMatrix<typename DTArg::VT>>) {
+        // the columns as the rows of the cached transposition
+        arg->getTransposed();
+        res = nullptr;
+        aggCol<DTRes, DTArg>(opCode, res, arg, nullptr);
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(res);
+    }
 }
 
 TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("sum"), TAG_KERNELS, (DATA_TYPES), (VALUE_TYPES)) {
@@ -189,3 +214,53 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("stddev"), TAG_KERNELS, (DATA_TYPES), (int6
     DataObjectFactory::destroy(m2);
     DataObjectFactory::destroy(m2exp);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("large, parallel"), TAG_KERNELS, (DATA_TYPES), (VALUE_TYPES)) {
+    using DT = TestType;
+    using DTRes = DenseMatrix<typename DT::VT>;
+    using VT = typename DT::VT;
+    ParallelContext ctx;
+
+    // more columns than one block, and enough rows for several chunks of rows
+    for(size_t numCols : {3, 1100}) {
+        const size_t numRows = 600000 / numCols;
+        auto m = genLarge<DT>(numRows, numCols);
+        auto expSum = DataObjectFactory::create<DTRes>(1, numCols, true);
+        auto expMin = DataObjectFactory::create<DTRes>(1, numCols, false);
+        for(size_t c = 0; c < numCols; c++)
+            expMin->set(0, c, m->get(0, c));
+        for(size_t r = 0; r < numRows; r++)
+            for(size_t c = 0; c < numCols; c++) {
+                expSum->set(0, c, expSum->get(0, c) + m->get(r, c));
+                expMin->set(0, c, std::min(expMin->get(0, c), m->get(r, c)));
+            }
+
+        DTRes * res = nullptr;
+        aggCol<DTRes, DT>(AggOpCode::SUM, res, m, ctx.get());
+        CHECK(*res == *expSum);
+        aggCol<DTRes, DT>(AggOpCode::MIN, res, m, ctx.get());
+        CHECK(*res == *expMin);
+        if constexpr(std::is_same_v<DT, CSRMatrix<VT>>) {
+            static_cast<const DT *>(m)->getTransposed();
+            aggCol<DTRes, DT>(AggOpCode::SUM, res, m, ctx.get());
+            CHECK(*res == *expSum);
+            aggCol<DTRes, DT>(AggOpCode::MIN, res, m, ctx.get());
+            CHECK(*res == *expMin);
+        }
+
+        DataObjectFactory::destroy(m, expSum, expMin, res);
+    }
+}
+
+TEST_CASE(TEST_NAME("sum, pairwise"), TAG_KERNELS) {
+    using DT = DenseMatrix<double>;
+    const size_t numRows = 1000000, numCols = 2;
+    auto m = DataObjectFactory::create<DT>(numRows, numCols, false);
+    std::fill(m->getValues(), m->getValues() + numRows * numCols, 0.1);
+    DT * res = nullptr;
+    aggCol<DT, DT>(AggOpCode::SUM, res, m, nullptr);
+    // summing up sequentially is off by about 1e-6
+    CHECK(std::abs(res->get(0, 0) - 1e5) < 1e-8);
+    CHECK(std::abs(res->get(0, 1) - 1e5) < 1e-8);
+    DataObjectFactory::destroy(m, res);
+}
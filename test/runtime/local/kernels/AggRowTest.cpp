@@ -16,21 +16,34 @@
 
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/AggRow.h>
 #include <runtime/local/kernels/AggOpCode.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #define TEST_NAME(opName) "AggRow (" opName ")"
-#define DATA_TYPES DenseMatrix, CSRMatrix
+#define DATA_TYPES DenseMatrix, CSRMatrix, DCSRMatrix
 #define VALUE_TYPES double, uint32_t
 
+// a matrix large enough to be aggregated in parallel chunks, with some zeros
+template<class DT>
+DT * genLarge(size_t numRows, size_t numCols) {
+    std::vector<typename DT::VT> vals(numRows * numCols);
+    for(size_t i = 0; i < vals.size(); i++)
+        vals[i] = static_cast<typename DT::VT>(i % 7 == 0 ? 0 : (i * 31) % 17);
+    return genGivenVals<DT>(numRows, vals);
+}
+
 template<class DTRes, class DTArg>
 void checkAggRow(AggOpCode opCode, const DTArg * arg, const DTRes * exp) {
     DTRes * res = nullptr;
@@ -223,4 +236,32 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("mean"), TAG_KERNELS, (DATA_TYPES), (VALUE_
     checkAggRow(AggOpCode::MEAN, m2, m2exp);
     
     DataObjectFactory::destroy(m0, m0exp, m1, m1exp, m2, m2exp);
-}
\ No newline at end of file
+}
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("large, parallel"), TAG_KERNELS, (DATA_TYPES), (VALUE_TYPES)) {
+    using DT = TestType;
+    using DTRes = DenseMatrix<typename DT::VT>;
+    using VT = typename DT::VT;
+    ParallelContext ctx;
+
+    const size_t numRows = 2000, numCols = 300;
+    auto m = genLarge<DT>(numRows, numCols);
+    auto expSum = DataObjectFactory::create<DTRes>(numRows, 1, false);
+    auto expMax = DataObjectFactory::create<DTRes>(numRows, 1, false);
+    for(size_t r = 0; r < numRows; r++) {
+        VT sum = 0, max = m->get(r, 0);
+        for(size_t c = 0; c < numCols; c++) {
+            sum += m->get(r, c);
+            max = std::max(max, m->get(r, c));
+        }
+        expSum->set(r, 0, sum);
+        expMax->set(r, 0, max);
+    }
+
+    DTRes * res = nullptr;
+    aggRow<DTRes, DT>(AggOpCode::SUM, res, m, ctx.get());
+    CHECK(*res == *expSum);
+    aggRow<DTRes, DT>(AggOpCode::MAX, res, m, ctx.get());
+    CHECK(*res == *expMax);
+
+    DataObjectFactory::destroy(m, expSum, expMax, res);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/BatchMatMul.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/MatMul.h>
+#include <runtime/local/kernels/SliceRow.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdint>
+
+TEMPLATE_PRODUCT_TEST_CASE("BatchMatMul", TAG_KERNELS, (DenseMatrix), (double, int64_t)) {
+    using DT = TestType;
+
+    // two blocks of 2x3 and 3x2 rows, respectively
+    auto lhs = genGivenVals<DT>(4, {
+        1, 2, 3,
+        4, 5, 6,
+        1, 0, 0,
+        0, 1, 0,
+    });
+    auto rhs = genGivenVals<DT>(6, {
+        1, 0,
+        0, 1,
+        1, 1,
+        2, 3,
+        4, 5,
+        6, 7,
+    });
+    auto exp = genGivenVals<DT>(4, {
+        4, 5,
+        10, 11,
+        2, 3,
+        4, 5,
+    });
+
+    DT * res = nullptr;
+    batchMatMul<DT, DT, DT>(res, lhs, rhs, 2, false, false, nullptr);
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(res);
+
+    SECTION("transposed blocks") {
+        // the per-block t(X_b) @ X_b of two blocks of 2x3
+        auto expCov = genGivenVals<DT>(6, {
+            17, 22, 27,
+            22, 29, 36,
+            27, 36, 45,
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 0,
+        });
+        res = nullptr;
+        batchMatMul<DT, DT, DT>(res, lhs, lhs, 2, true, false, nullptr);
+        CHECK(*res == *expCov);
+        DataObjectFactory::destroy(res, expCov);
+    }
+    SECTION("shape mismatch") {
+        res = nullptr;
+        CHECK_THROWS(batchMatMul<DT, DT, DT>(res, lhs, rhs, 3, false, false, nullptr));
+        CHECK_THROWS(batchMatMul<DT, DT, DT>(res, lhs, lhs, 2, false, false, nullptr));
+        CHECK_THROWS(batchMatMul<DT, DT, DT>(res, lhs, rhs, 0, false, false, nullptr));
+    }
+
+    DataObjectFactory::destroy(lhs, rhs, exp);
+}
+
+TEMPLATE_TEST_CASE("BatchMatMul, many blocks in parallel", TAG_KERNELS, float, double) {
+    using DT = DenseMatrix<TestType>;
+    ParallelContext ctx;
+
+    // small blocks (the loops of MatMulSmall) and large ones (BLAS)
+    for(size_t n : {4, 32}) {
+        const size_t numBatches = 64;
+        auto lhs = DataObjectFactory::create<DT>(numBatches * n, n, false);
+        auto rhs = DataObjectFactory::create<DT>(numBatches * n, n, false);
+        for(size_t i = 0; i < numBatches * n * n; i++) {
+            lhs->getValues()[i] = static_cast<TestType>(i % 7);
+            rhs->getValues()[i] = static_cast<TestType>(i % 3) - 1;
+        }
+        for(bool transb : {false, true}) {
+            DT * res = nullptr;
+            batchMatMul<DT, DT, DT>(res, lhs, rhs, numBatches, false, transb, ctx.get());
+            REQUIRE(res->getNumRows() == numBatches * n);
+            for(size_t b = 0; b < numBatches; b++) {
+                DT * blockLhs = nullptr;
+                DT * blockRhs = nullptr;
+                DT * blockRes = nullptr;
+                DT * exp = nullptr;
+                sliceRow(blockLhs, lhs, b * n, (b + 1) * n, nullptr);
+                sliceRow(blockRhs, rhs, b * n, (b + 1) * n, nullptr);
+                sliceRow(blockRes, res, b * n, (b + 1) * n, nullptr);
+                matMul(exp, blockLhs, blockRhs, false, transb, nullptr);
+                CHECK(*blockRes == *exp);
+                DataObjectFactory::destroy(blockLhs, blockRhs, blockRes, exp);
+            }
+            DataObjectFactory::destroy(res);
+        }
+        DataObjectFactory::destroy(lhs, rhs);
+    }
+}
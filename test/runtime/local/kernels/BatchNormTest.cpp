@@ -0,0 +1,49 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/BatchNorm.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+
+TEMPLATE_PRODUCT_TEST_CASE("BatchNorm::Forward", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+
+    ParallelContext dctx;
+
+    // two images of two channels of 2 pixels
+    auto input = genGivenVals<DT>(2, { 1, 2, 3, 4,
+            5, 6, 7, 8 });
+    auto gamma = genGivenVals<DT>(2, { 1, 2 });
+    auto beta = genGivenVals<DT>(2, { 0, 1 });
+    auto mean = genGivenVals<DT>(2, { 1, 4 });
+    auto var = genGivenVals<DT>(2, { 4, 1 });
+    // gamma * (x - mean) / sqrt(var + eps) + beta
+    auto exp = genGivenVals<DT>(2, { 0, 0.5, -1, 1,
+            2, 2.5, 7, 9 });
+
+    DT * res = nullptr;
+    BatchNorm::Forward<DT, DT>::apply(res, input, gamma, beta, mean, var, 0, dctx.get());
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(input, gamma, beta, mean, var, exp, res);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/BiasAdd.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+
+TEMPLATE_PRODUCT_TEST_CASE("BiasAdd::Forward", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+
+    ParallelContext dctx;
+
+    auto input = genGivenVals<DT>(2, { 1, 2, 3, 4, 5, 6,
+            7, 8, 9, 10, 11, 12 });
+    DT * exp = nullptr;
+    DT * bias = nullptr;
+    SECTION("a value per channel of 2 pixels") {
+        bias = genGivenVals<DT>(1, { 10, 20, 30 });
+        exp = genGivenVals<DT>(2, { 11, 12, 23, 24, 35, 36,
+                17, 18, 29, 30, 41, 42 });
+    }
+    SECTION("a value per column") {
+        bias = genGivenVals<DT>(6, { 1, 2, 3, 4, 5, 6 });
+        exp = genGivenVals<DT>(2, { 2, 4, 6, 8, 10, 12,
+                8, 10, 12, 14, 16, 18 });
+    }
+
+    DT * res = nullptr;
+    BiasAdd::Forward<DT, DT>::apply(res, input, bias, dctx.get());
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(input, bias, exp, res);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/BloomFilters.h>
+#include <runtime/local/kernels/BuildBloomFilter.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/FilterRow.h>
+#include <runtime/local/kernels/InnerJoin.h>
+#include <runtime/local/kernels/ProbeBloomFilter.h>
+#include <util/BloomFilter.h>
+#include <util/FlatHashMap.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+TEST_CASE("BlockedBloomFilter has no false negatives and few false positives", TAG_KERNELS) {
+    const size_t numKeys = 10000;
+    const size_t numWords = BlockedBloomFilter::numWordsFor(numKeys);
+    CHECK(numWords % BlockedBloomFilter::BLOCK_WORDS == 0);
+    std::vector<uint64_t> words(numWords, 0);
+    const FlatHash<int64_t> hash;
+    for(int64_t k = 0; k < int64_t(numKeys); k++)
+        BlockedBloomFilter::insert(words.data(), numWords, hash(k * 3));
+
+    size_t numMissing = 0;
+    for(int64_t k = 0; k < int64_t(numKeys); k++)
+        numMissing += !BlockedBloomFilter::mayContain(words.data(), numWords, hash(k * 3));
+    CHECK(numMissing == 0);
+
+    size_t numFalse = 0;
+    const size_t numOthers = 100000;
+    for(int64_t k = 0; k < int64_t(numOthers); k++)
+        numFalse += BlockedBloomFilter::mayContain(words.data(), numWords, hash(k * 3 + 1));
+    CHECK(numFalse < numOthers / 200);
+
+    // an empty filter still has one block
+    CHECK(BlockedBloomFilter::numWordsFor(0) == BlockedBloomFilter::BLOCK_WORDS);
+}
+
+TEST_CASE("probeBloomFilter selects the rows of a frame with a match in another one", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    // a selective dimension with a few keys of a large fact table
+    const size_t numDim = 50;
+    const size_t numFact = 200000;
+    ValueTypeCode schemaDim[] = {ValueTypeCode::SI64, ValueTypeCode::STR};
+    std::string labelsDim[] = {"d.id", "d.name"};
+    auto dim = DataObjectFactory::create<Frame>(numDim, 2, schemaDim, labelsDim, false);
+    auto dimId = static_cast<int64_t *>(dim->getColumnRaw(0));
+    auto dimName = static_cast<std::string *>(dim->getColumnRaw(1));
+    for(size_t r = 0; r < numDim; r++) {
+        dimId[r] = r * 97;
+        dimName[r] = "n" + std::to_string(r * 97);
+    }
+    ValueTypeCode schemaFact[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::STR};
+    std::string labelsFact[] = {"f.id", "f.val", "f.name"};
+    auto fact = DataObjectFactory::create<Frame>(numFact, 3, schemaFact, labelsFact, false);
+    auto factId = static_cast<int64_t *>(fact->getColumnRaw(0));
+    auto factVal = static_cast<double *>(fact->getColumnRaw(1));
+    auto factName = static_cast<std::string *>(fact->getColumnRaw(2));
+    for(size_t r = 0; r < numFact; r++) {
+        factId[r] = (r * 7919) % 10000;
+        factVal[r] = r;
+        factName[r] = "n" + std::to_string(factId[r]);
+    }
+
+    DenseMatrix<uint64_t> * filter = nullptr;
+    buildBloomFilter(filter, dim, "d.id", ctx.get());
+    DenseMatrix<int64_t> * sel = nullptr;
+    probeBloomFilter(sel, fact, "f.id", filter, ctx.get());
+    REQUIRE(sel->getNumRows() == numFact);
+    size_t numMatches = 0;
+    size_t numSelected = 0;
+    bool allMatchesSelected = true;
+    for(size_t r = 0; r < numFact; r++) {
+        const bool match = factId[r] % 97 == 0 && factId[r] / 97 < int64_t(numDim);
+        numMatches += match;
+        numSelected += sel->get(r, 0);
+        allMatchesSelected &= !match || sel->get(r, 0) == 1;
+    }
+    CHECK(allMatchesSelected);
+    CHECK(numSelected < numMatches + numFact / 200);
+
+    // the join of the filtered fact table has the same rows
+    Frame * filtered = nullptr;
+    filterRow(filtered, fact, sel, ctx.get());
+    Frame * expected = nullptr;
+    innerJoin(expected, fact, dim, "f.id", "d.id", ctx.get());
+    Frame * joined = nullptr;
+    innerJoin(joined, filtered, dim, "f.id", "d.id", ctx.get());
+    CHECK(expected->getNumRows() == numMatches);
+    CHECK(*joined == *expected);
+
+    // string keys, and a double filter
+    DenseMatrix<uint64_t> * filterName = nullptr;
+    buildBloomFilter(filterName, dim, "d.name", ctx.get());
+    DenseMatrix<double> * selName = nullptr;
+    probeBloomFilter(selName, fact, "f.name", filterName, ctx.get());
+    bool allNamesSelected = true;
+    for(size_t r = 0; r < numFact; r++)
+        allNamesSelected &= !(factId[r] % 97 == 0 && factId[r] / 97 < int64_t(numDim)) || selName->get(r, 0) == 1.0;
+    CHECK(allNamesSelected);
+
+    // the key columns must have the same value type
+    DenseMatrix<int64_t> * selWrong = nullptr;
+    CHECK_THROWS_AS(probeBloomFilter(selWrong, fact, "f.val", filter, ctx.get()), std::runtime_error);
+
+    DataObjectFactory::destroy(dim, fact, filter, sel, filtered, expected, joined, filterName, selName);
+}
+
+TEST_CASE("BloomFilters keep the rows with a match on several key columns", TAG_KERNELS) {
+    auto userConfig = std::make_unique<DaphneUserConfig>();
+    auto ctx = std::make_unique<DaphneContext>(*userConfig);
+
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::STR};
+    std::string labels[] = {"a", "b"};
+    auto build = DataObjectFactory::create<Frame>(3, 2, schema, labels, false);
+    auto probed = DataObjectFactory::create<Frame>(1000, 2, schema, labels, false);
+    for(size_t r = 0; r < 3; r++) {
+        static_cast<int64_t *>(build->getColumnRaw(0))[r] = r;
+        static_cast<std::string *>(build->getColumnRaw(1))[r] = "x" + std::to_string(r);
+    }
+    for(size_t r = 0; r < 1000; r++) {
+        static_cast<int64_t *>(probed->getColumnRaw(0))[r] = r % 10;
+        static_cast<std::string *>(probed->getColumnRaw(1))[r] = "x" + std::to_string(r % 20);
+    }
+
+    const std::vector<size_t> rows = BloomFilters::matchingRows(probed, {0, 1}, build, {0, 1}, ctx.get());
+    // the rows whose keys are (0, "x0"), (1, "x1"), and (2, "x2"), and maybe a few others
+    std::vector<size_t> matches;
+    for(size_t r = 0; r < 1000; r++)
+        if(r % 20 < 3)
+            matches.push_back(r);
+    std::vector<size_t> kept;
+    for(size_t r : rows)
+        if(r % 20 < 3)
+            kept.push_back(r);
+    CHECK(kept == matches);
+    CHECK(rows.size() < matches.size() + 20);
+    CHECK(std::is_sorted(rows.begin(), rows.end()));
+
+    DataObjectFactory::destroy(build, probed);
+}
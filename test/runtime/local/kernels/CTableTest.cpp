@@ -14,12 +14,14 @@
  * limitations under the License.
  */
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/kernels/CTable.h>
 #include <runtime/local/kernels/CheckEq.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 #include <catch.hpp>
 #include <vector>
@@ -90,4 +92,44 @@ TEMPLATE_PRODUCT_TEST_CASE("CTable", TAG_KERNELS, (DenseMatrix, CSRMatrix), (int
     DataObjectFactory::destroy(m1);
     DataObjectFactory::destroy(exp);
     DataObjectFactory::destroy(res);
-}
\ No newline at end of file
+}
+TEMPLATE_PRODUCT_TEST_CASE("CTable, large, weighted, parallel", TAG_KERNELS, (DenseMatrix, CSRMatrix), (int64_t, double)) {
+    using DTRes = TestType;
+    using VT = typename DTRes::VT;
+
+    const size_t numRows = 300000;
+    const size_t numResRows = 300;
+    const size_t numResCols = 50;
+    auto lhs = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+    auto rhs = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+    auto weights = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+    std::vector<VT> expCounts(numResRows * numResCols, 0);
+    std::vector<VT> expWeighted(numResRows * numResCols, 0);
+    for(size_t r = 0; r < numRows; r++) {
+        // only every third row of the result (and the last one) is not empty
+        const size_t i = r == 0 ? numResRows - 1 : (r * 7919 % (numResRows / 3)) * 3;
+        const size_t j = r == 0 ? numResCols - 1 : (r / 7) % numResCols;
+        lhs->getValues()[r] = static_cast<VT>(i);
+        rhs->getValues()[r] = static_cast<VT>(j);
+        weights->getValues()[r] = static_cast<VT>(r % 5);
+        expCounts[i * numResCols + j] += 1;
+        expWeighted[i * numResCols + j] += static_cast<VT>(r % 5);
+    }
+    auto expCountsMat = genGivenVals<DTRes>(numResRows, expCounts);
+    auto expWeightedMat = genGivenVals<DTRes>(numResRows, expWeighted);
+
+    ParallelContext ctx;
+    for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        DTRes * res = nullptr;
+        ctable(res, lhs, rhs, c);
+        CHECK(*res == *expCountsMat);
+        DataObjectFactory::destroy(res);
+
+        res = nullptr;
+        ctable(res, lhs, rhs, weights, c);
+        CHECK(*res == *expWeightedMat);
+        DataObjectFactory::destroy(res);
+    }
+
+    DataObjectFactory::destroy(lhs, rhs, weights, expCountsMat, expWeightedMat);
+}
@@ -24,6 +24,7 @@
 
 #include <catch.hpp>
 
+#include <string>
 #include <vector>
 
 template<class DT>
@@ -204,3 +205,47 @@ TEMPLATE_PRODUCT_TEST_CASE("CUDA::matMul Transposed", TAG_KERNELS, (DenseMatrix)
 
     DataObjectFactory::destroy(m0, m1, m2, m3, m4, m5, v0, v1, v2, v3, v4, v5, v6);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("CUDA::matMul mixed precision", TAG_KERNELS, (DenseMatrix), (float)) {
+    using DT = TestType;
+
+    // small integers are exact in FP16, BF16 and TF32, and their products are accumulated in FP32
+    auto precision = GENERATE(as<std::string>{}, "tf32", "fp16", "bf16");
+    DaphneUserConfig user_config{};
+    user_config.cuda_precision = precision;
+    user_config.cuda_loss_scale = 4;
+    auto dctx = std::make_unique<DaphneContext>(user_config);
+    CUDA::createCUDAContext(dctx.get());
+
+    auto m0 = genGivenVals<DT>(2, {
+            1, 0, 3, 0,
+            0, 0, 2, 0,
+    });
+    auto m1 = genGivenVals<DT>(4, {
+            0, 1,
+            2, 0,
+            1, 1,
+            0, 0,
+    });
+    auto m2 = genGivenVals<DT>(2, {
+            3, 4,
+            2, 2,
+    });
+    auto m3 = genGivenVals<DT>(4, {
+            0, 2, 1, 0,
+            0, 0, 0, 0,
+            2, 6, 5, 0,
+            0, 0, 0, 0,
+    });
+
+    checkMatMulCUDA(m0, m1, m2, false, false, dctx.get());
+    checkMatMulCUDA(m0, m1, m3, true, true, dctx.get());
+
+    DataObjectFactory::destroy(m0, m1, m2, m3);
+}
+
+TEST_CASE("CUDA precision from string", TAG_KERNELS) {
+    CHECK(CUDAContext::precisionFromString("default") == CUDAPrecision::DEFAULT);
+    CHECK(CUDAContext::precisionFromString("bf16") == CUDAPrecision::BF16);
+    CHECK_THROWS(CUDAContext::precisionFromString("fp8"));
+}
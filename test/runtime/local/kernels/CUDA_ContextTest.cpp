@@ -29,3 +29,24 @@ TEST_CASE("CreateCUDAContext", TAG_KERNELS) {
     auto p = CUDAContext::get(dctx.get(), deviceID)->getDeviceProperties();
     CHECK(p);
 }
+
+TEST_CASE("CreateCUDAContext: one context per device", TAG_KERNELS) {
+    int device_count = 0;
+    CHECK_CUDART(cudaGetDeviceCount(&device_count));
+
+    DaphneUserConfig user_config{};
+    auto dctx = std::make_unique<DaphneContext>(user_config);
+    CUDA::createCUDAContext(dctx.get());
+    REQUIRE(dctx->cuda_contexts.size() == static_cast<size_t>(device_count));
+    for(size_t i = 0; i < dctx->cuda_contexts.size(); i++)
+        CHECK(CUDAContext::get(dctx.get(), i)->getDeviceID() == static_cast<int>(i));
+    // the first device stays the default one
+    CHECK(CUDAContext::getCurrentDevice() == 0);
+
+    // only the listed devices
+    user_config.cuda_devices = {device_count - 1};
+    auto dctx2 = std::make_unique<DaphneContext>(user_config);
+    CUDA::createCUDAContext(dctx2.get());
+    REQUIRE(dctx2->cuda_contexts.size() == 1);
+    CHECK(CUDAContext::get(dctx2.get(), 0)->getDeviceID() == device_count - 1);
+}
@@ -22,6 +22,7 @@
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/Seq.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
@@ -76,3 +77,51 @@ TEST_CASE("Cartesian", TAG_KERNELS) {
     CHECK(*(res->getColumn<int64_t>(3)) == *resC3Exp);
     CHECK(*(res->getColumn<double >(4)) == *resC4Exp);
 }
+
+TEST_CASE("Cartesian, large, parallel", TAG_KERNELS) {
+    const size_t numRowsLhs = 300;
+    const size_t numRowsRhs = 700;
+    auto lhsC0 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRowsLhs, 1, false);
+    auto lhsC1 = DataObjectFactory::create<DenseMatrix<float>>(numRowsLhs, 1, false);
+    for(size_t r = 0; r < numRowsLhs; r++) {
+        lhsC0->getValues()[r] = static_cast<int64_t>(r) - 100;
+        lhsC1->getValues()[r] = 0.5f * r;
+    }
+    auto rhsC0 = DataObjectFactory::create<DenseMatrix<uint8_t>>(numRowsRhs, 1, false);
+    for(size_t r = 0; r < numRowsRhs; r++)
+        rhsC0->getValues()[r] = static_cast<uint8_t>(r * 7);
+    std::vector<Structure *> lhsCols = {lhsC0, lhsC1};
+    std::vector<Structure *> rhsCols = {rhsC0};
+    std::string lhsLabels[] = {"a", "b"};
+    std::string rhsLabels[] = {"c"};
+    auto lhs = DataObjectFactory::create<Frame>(lhsCols, lhsLabels);
+    auto rhs = DataObjectFactory::create<Frame>(rhsCols, rhsLabels);
+
+    ParallelContext ctx;
+    Frame * res = nullptr;
+    cartesian(res, lhs, rhs, ctx.get());
+
+    REQUIRE(res->getNumRows() == numRowsLhs * numRowsRhs);
+    REQUIRE(res->getNumCols() == 3);
+    CHECK(res->getColumnType(2) == ValueTypeCode::UI8);
+    const int64_t * c0 = res->getColumn<int64_t>(0)->getValues();
+    const float * c1 = res->getColumn<float>(1)->getValues();
+    const uint8_t * c2 = res->getColumn<uint8_t>(2)->getValues();
+    size_t numWrong = 0;
+    for(size_t i = 0; i < numRowsLhs; i++)
+        for(size_t j = 0; j < numRowsRhs; j++) {
+            const size_t r = i * numRowsRhs + j;
+            numWrong += c0[r] != lhsC0->getValues()[i] || c1[r] != lhsC1->getValues()[i]
+                    || c2[r] != rhsC0->getValues()[j];
+        }
+    CHECK(numWrong == 0);
+
+    // an empty side
+    auto empty = DataObjectFactory::create<Frame>(0, 1, rhs->getSchema(), rhsLabels, false);
+    Frame * resEmpty = nullptr;
+    cartesian(resEmpty, lhs, empty, ctx.get());
+    CHECK(resEmpty->getNumRows() == 0);
+    CHECK(resEmpty->getNumCols() == 3);
+
+    DataObjectFactory::destroy(res, resEmpty, empty, lhs, rhs, lhsC0, lhsC1, rhsC0);
+}
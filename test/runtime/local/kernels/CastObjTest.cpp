@@ -15,18 +15,24 @@
  */
 
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/Structure.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/kernels/CastObj.h>
 #include <runtime/local/kernels/CheckEq.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <algorithm>
 #include <vector>
 
 #include <cstdint>
@@ -94,6 +100,41 @@ TEMPLATE_PRODUCT_TEST_CASE("castObj, frame to matrix, multi-column", TAG_KERNELS
     DataObjectFactory::destroy(res);
 }
 
+TEMPLATE_PRODUCT_TEST_CASE("castObj, frame to matrix, multi-column, in parallel", TAG_KERNELS, (DenseMatrix), (double, int64_t)) {
+    using DTRes = TestType;
+    using VTRes = typename DTRes::VT;
+    
+    ParallelContext ctx;
+    
+    // not a multiple of the rows of a block
+    const size_t numRows = 10001;
+    auto c0 = DataObjectFactory::create<DenseMatrix<double>>(numRows, 1, false);
+    auto c1 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    auto c2 = DataObjectFactory::create<DenseMatrix<uint8_t>>(numRows, 1, false);
+    for(size_t r = 0; r < numRows; r++) {
+        c0->set(r, 0, r + 0.5);
+        c1->set(r, 0, -static_cast<int64_t>(r));
+        c2->set(r, 0, r % 256);
+    }
+    std::vector<Structure *> cols = {c0, c1, c2};
+    auto arg = DataObjectFactory::create<Frame>(cols, nullptr);
+    
+    DTRes * res = nullptr;
+    castObj<DTRes, Frame>(res, arg, ctx.get());
+    
+    REQUIRE(res->getNumRows() == numRows);
+    REQUIRE(res->getNumCols() == 3);
+    size_t numMismatches = 0;
+    for(size_t r = 0; r < numRows; r++) {
+        numMismatches += res->get(r, 0) != static_cast<VTRes>(r + 0.5);
+        numMismatches += res->get(r, 1) != static_cast<VTRes>(-static_cast<int64_t>(r));
+        numMismatches += res->get(r, 2) != static_cast<VTRes>(r % 256);
+    }
+    CHECK(numMismatches == 0);
+    
+    DataObjectFactory::destroy(c0, c1, c2, arg, res);
+}
+
 TEMPLATE_PRODUCT_TEST_CASE("castObj, matrix to frame, single-column", TAG_KERNELS, (DenseMatrix), (double, int64_t, uint32_t)) {
     using DTArg = TestType;
     using VTArg = typename DTArg::VT;
@@ -411,4 +452,162 @@ TEMPLATE_TEST_CASE("CastObj DenseMatrix to CSRMatrix", TAG_KERNELS, double, floa
     DataObjectFactory::destroy(m0, d0, res0);
     DataObjectFactory::destroy(m1, d1, res1);
     DataObjectFactory::destroy(m2, d2, res2);
-}
\ No newline at end of file
+}
+TEMPLATE_TEST_CASE("CastObj BlockedMatrix from and to DenseMatrix and CSRMatrix", TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+    using BlockType = typename BlockedMatrix<VT>::BlockType;
+    const size_t numRows = 30;
+    const size_t numCols = 21;
+    const size_t blockSize = 8;
+
+    // the blocks are dense, sparse, or empty in turn
+    auto dense = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const size_t kind = (r / blockSize + c / blockSize) % 3;
+            const bool nonZero = kind == 0 || (kind == 1 && (r * numCols + c) % 17 == 0);
+            dense->set(r, c, nonZero ? VT((r + c) % 5 + 1) : VT(0));
+        }
+    CSRMatrix<VT> * sparse = nullptr;
+    castObj<CSRMatrix<VT>, DenseMatrix<VT>>(sparse, dense, nullptr);
+
+    auto fromDense = DataObjectFactory::create<BlockedMatrix<VT>>(numRows, numCols, blockSize);
+    castObj<BlockedMatrix<VT>, DenseMatrix<VT>>(fromDense, dense, nullptr);
+    auto fromSparse = DataObjectFactory::create<BlockedMatrix<VT>>(numRows, numCols, blockSize);
+    castObj<BlockedMatrix<VT>, CSRMatrix<VT>>(fromSparse, sparse, nullptr);
+
+    for(auto m : {fromDense, fromSparse}) {
+        CHECK(m->getBlockType(0, 0) == BlockType::DENSE);
+        CHECK(m->getBlockType(0, 1) == BlockType::SPARSE);
+        CHECK(m->getBlockType(0, 2) == BlockType::EMPTY);
+        CHECK(m->getNumNonZeros() == sparse->getNumNonZeros());
+
+        DenseMatrix<VT> * resDense = nullptr;
+        castObj<DenseMatrix<VT>, BlockedMatrix<VT>>(resDense, m, nullptr);
+        CHECK(*resDense == *dense);
+        CSRMatrix<VT> * resSparse = nullptr;
+        castObj<CSRMatrix<VT>, BlockedMatrix<VT>>(resSparse, m, nullptr);
+        CHECK(*resSparse == *sparse);
+        DataObjectFactory::destroy(resDense, resSparse);
+    }
+
+    DataObjectFactory::destroy(dense, sparse, fromDense, fromSparse);
+}
+
+TEMPLATE_TEST_CASE("CastObj DCSRMatrix from and to DenseMatrix and CSRMatrix", TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+
+    // the first rows, a middle one and the last one have no non-zeros
+    auto dense = genGivenVals<DenseMatrix<VT>>(6, {
+        0, 0, 0, 0,
+        0, 0, 0, 0,
+        1, 0, 0, 2,
+        0, 0, 0, 0,
+        0, 3, 4, 0,
+        0, 0, 0, 0,
+    });
+    auto sparse = genGivenVals<CSRMatrix<VT>>(6, {
+        0, 0, 0, 0,
+        0, 0, 0, 0,
+        1, 0, 0, 2,
+        0, 0, 0, 0,
+        0, 3, 4, 0,
+        0, 0, 0, 0,
+    });
+
+    DCSRMatrix<VT> * fromDense = nullptr;
+    castObj<DCSRMatrix<VT>, DenseMatrix<VT>>(fromDense, dense, nullptr);
+    DCSRMatrix<VT> * fromSparse = nullptr;
+    castObj<DCSRMatrix<VT>, CSRMatrix<VT>>(fromSparse, sparse, nullptr);
+    CHECK(fromDense->getNumNonZeroRows() == 2);
+    CHECK(fromDense->getNumNonZeros() == 4);
+    CHECK(*fromDense == *fromSparse);
+
+    DenseMatrix<VT> * resDense = nullptr;
+    castObj<DenseMatrix<VT>, DCSRMatrix<VT>>(resDense, fromSparse, nullptr);
+    CHECK(*resDense == *dense);
+    CSRMatrix<VT> * resSparse = nullptr;
+    castObj<CSRMatrix<VT>, DCSRMatrix<VT>>(resSparse, fromDense, nullptr);
+    CHECK(*resSparse == *sparse);
+    for(size_t r = 0; r < 6; r++)
+        CHECK(resSparse->getNumNonZeros(r) == sparse->getNumNonZeros(r));
+
+    DataObjectFactory::destroy(dense, sparse, fromDense, fromSparse, resDense, resSparse);
+}
+
+TEMPLATE_TEST_CASE("CastObj CompressedMatrix from and to DenseMatrix", TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    // a view, whose row skip differs from its number of columns, of a few distinct and of all distinct values
+    const size_t numRows = 3000;
+    auto orig = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 4, false);
+    for(size_t r = 0; r < numRows; r++) {
+        orig->set(r, 0, VT(r % 3));
+        orig->set(r, 1, VT(r / 1000));
+        orig->set(r, 2, VT(r));
+        orig->set(r, 3, VT(0));
+    }
+    auto dense = orig->sliceCol(0, 3);
+
+    CompressedMatrix<VT> * compressed = nullptr;
+    castObj<CompressedMatrix<VT>, DenseMatrix<VT>>(compressed, dense, ctx.get());
+    CHECK(compressed->getColGroups().size() == 3);
+    CHECK(compressed->getSizeInBytes() < numRows * 3 * sizeof(VT) / 2);
+    CHECK_THROWS(castObj<CompressedMatrix<VT>, DenseMatrix<VT>>(compressed, dense, ctx.get()));
+
+    DenseMatrix<VT> * res = nullptr;
+    castObj<DenseMatrix<VT>, CompressedMatrix<VT>>(res, compressed, ctx.get());
+    CHECK(*res == *dense);
+
+    DataObjectFactory::destroy(orig, dense, compressed, res);
+}
+
+TEMPLATE_TEST_CASE("CastObj DenseMatrixCM from and to DenseMatrix and Frame", TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    // a view, whose row skip differs from its number of columns, over more than one block of rows and columns
+    const size_t numRows = 200;
+    const size_t numCols = 70;
+    auto orig = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols + 1, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c <= numCols; c++)
+            orig->set(r, c, VT(r * 100 + c));
+    auto dense = orig->sliceCol(1, numCols + 1);
+
+    DenseMatrixCM<VT> * cm = nullptr;
+    castObj<DenseMatrixCM<VT>, DenseMatrix<VT>>(cm, dense, ctx.get());
+    CHECK(cm->getColumn(3)[5] == VT(5 * 100 + 4));
+    DenseMatrix<VT> * res = nullptr;
+    castObj<DenseMatrix<VT>, DenseMatrixCM<VT>>(res, cm, ctx.get());
+    CHECK(*res == *dense);
+
+    SECTION("the columns are shared with a frame") {
+        Frame * frame = nullptr;
+        castObj<Frame, DenseMatrixCM<VT>>(frame, cm, ctx.get());
+        CHECK(frame->getNumRows() == numRows);
+        CHECK(frame->getNumCols() == numCols);
+        CHECK(frame->getColumnType(0) == ValueTypeUtils::codeFor<VT>);
+        CHECK(frame->getColumnRaw(2) == cm->getColumn(2));
+
+        DenseMatrixCM<VT> * back = nullptr;
+        castObj<DenseMatrixCM<VT>, Frame>(back, frame, ctx.get());
+        CHECK(back->getValues() == cm->getValues());
+        CHECK(*back == *cm);
+
+        // the columns of a frame of a column slice are not equidistant, so they are copied
+        Frame * cols = nullptr;
+        std::vector<size_t> colIdxs = {0, 2, 5};
+        cols = DataObjectFactory::create<Frame>(frame, 0, numRows, colIdxs.size(), colIdxs.data());
+        DenseMatrixCM<VT> * copied = nullptr;
+        castObj<DenseMatrixCM<VT>, Frame>(copied, cols, ctx.get());
+        CHECK(copied->getValues() != cm->getValues());
+        for(size_t i = 0; i < colIdxs.size(); i++)
+            CHECK(std::equal(copied->getColumn(i), copied->getColumn(i) + numRows, cm->getColumn(colIdxs[i])));
+
+        DataObjectFactory::destroy(frame, back, cols, copied);
+    }
+
+    DataObjectFactory::destroy(orig, dense, cm, res);
+}
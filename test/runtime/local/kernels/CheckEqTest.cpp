@@ -20,10 +20,12 @@
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/kernels/CheckEq.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <type_traits>
 #include <vector>
 
 #include <cstdint>
@@ -299,4 +301,40 @@ TEST_CASE("CheckEq, frames", TAG_KERNELS) {
     DataObjectFactory::destroy(c0);
     DataObjectFactory::destroy(c1);
     DataObjectFactory::destroy(c2);
-}
\ No newline at end of file
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("CheckEq, in parallel", TAG_KERNELS, (DenseMatrix, CSRMatrix), (double, uint32_t)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    ParallelContext ctx;
+
+    const size_t numRows = 1000;
+    const size_t numCols = 300;
+    std::vector<VT> vals(numRows * numCols);
+    for(size_t i = 0; i < vals.size(); i++)
+        vals[i] = VT(i % 3);
+    auto m1 = genGivenVals<DT>(numRows, vals);
+    auto m2 = genGivenVals<DT>(numRows, vals);
+    CHECK(checkEq(m1, m2, ctx.get()));
+
+    // a difference in the last block
+    vals[vals.size() - 2] = VT(7);
+    auto m3 = genGivenVals<DT>(numRows, vals);
+    CHECK_FALSE(checkEq(m1, m3, ctx.get()));
+
+    // views without the difference, which are strided for dense matrices
+    DT * view1;
+    DT * view3;
+    if constexpr(std::is_same<DT, DenseMatrix<VT>>::value) {
+        view1 = DataObjectFactory::create<DT>(m1, 0, numRows, 0, numCols - 2);
+        view3 = DataObjectFactory::create<DT>(m3, 0, numRows, 0, numCols - 2);
+    }
+    else {
+        view1 = DataObjectFactory::create<DT>(m1, 0, numRows - 1);
+        view3 = DataObjectFactory::create<DT>(m3, 0, numRows - 1);
+    }
+    CHECK(checkEq(view1, view3, ctx.get()));
+
+    DataObjectFactory::destroy(m1, m2, m3, view1, view3);
+}
@@ -16,6 +16,7 @@
 
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/Structure.h>
@@ -30,7 +31,7 @@
 
 #include <cstdint>
 
-TEMPLATE_PRODUCT_TEST_CASE("ColBind", TAG_KERNELS, (DenseMatrix), (double, uint32_t)) {
+TEMPLATE_PRODUCT_TEST_CASE("ColBind", TAG_KERNELS, (DenseMatrix, DenseMatrixCM), (double, uint32_t)) {
     using DT = TestType;
     
     auto m0 = genGivenVals<DT>(3, {
@@ -60,6 +61,90 @@ TEMPLATE_PRODUCT_TEST_CASE("ColBind", TAG_KERNELS, (DenseMatrix), (double, uint3
     DataObjectFactory::destroy(res);
 }
 
+TEMPLATE_PRODUCT_TEST_CASE("ColBind - views and appending in place", TAG_KERNELS, (DenseMatrix), (double, uint32_t)) {
+    using DT = TestType;
+    
+    auto m = genGivenVals<DT>(2, {
+        1, 2, 3, 4,
+        5, 6, 7, 8,
+    });
+    
+    SECTION("adjacent column slices") {
+        auto lhs = DataObjectFactory::create<DT>(m, 0, 2, 0, 1);
+        auto rhs = DataObjectFactory::create<DT>(m, 0, 2, 1, 3);
+        auto exp = genGivenVals<DT>(2, {
+            1, 2, 3,
+            5, 6, 7,
+        });
+        
+        DT * res = nullptr;
+        colBind<DT, DT, DT>(res, lhs, rhs, nullptr);
+        CHECK(*res == *exp);
+        // the result is a view on the values of m
+        CHECK(res->getValues() == m->getValues());
+        
+        // rhs does not directly follow lhs
+        DT * res2 = nullptr;
+        colBind<DT, DT, DT>(res2, rhs, lhs, nullptr);
+        CHECK(res2->getValues() != m->getValues());
+        
+        DataObjectFactory::destroy(lhs, rhs, exp, res, res2);
+    }
+    SECTION("appending to the spare columns of the last use") {
+        auto c0 = genGivenVals<DT>(2, {10, 20});
+        auto c1 = genGivenVals<DT>(2, {30, 40});
+        auto exp = genGivenVals<DT>(2, {
+            1, 2, 3, 4, 10, 30,
+            5, 6, 7, 8, 20, 40,
+        });
+        
+        DT * res0 = nullptr;
+        m->markLastUse();
+        colBind<DT, DT, DT>(res0, m, c0, nullptr);
+        CHECK(res0->getNumSpareCols() > 0);
+        
+        res0->markLastUse();
+        DT * res1 = nullptr;
+        colBind<DT, DT, DT>(res1, res0, c1, nullptr);
+        CHECK(res1->getValues() == res0->getValues());
+        DataObjectFactory::destroy(res0);
+        CHECK(*res1 == *exp);
+        
+        DataObjectFactory::destroy(c0, c1, exp, res1);
+    }
+    
+    DataObjectFactory::destroy(m);
+}
+
+TEMPLATE_TEST_CASE("ColBind - column-major views", TAG_KERNELS, double, uint32_t) {
+    using DT = DenseMatrixCM<TestType>;
+
+    auto m = genGivenVals<DT>(2, {
+        1, 2, 3, 4,
+        5, 6, 7, 8,
+    });
+    auto lhs = m->sliceCol(0, 1);
+    auto rhs = m->sliceCol(1, 3);
+    auto exp = genGivenVals<DT>(2, {
+        1, 2, 3,
+        5, 6, 7,
+    });
+
+    DT * res = nullptr;
+    colBind<DT, DT, DT>(res, lhs, rhs, nullptr);
+    CHECK(*res == *exp);
+    // the result is a view on the values of m
+    CHECK(res->getValues() == m->getValues());
+
+    // rhs does not directly follow lhs
+    DT * res2 = nullptr;
+    colBind<DT, DT, DT>(res2, rhs, lhs, nullptr);
+    CHECK(res2->getValues() != m->getValues());
+    CHECK(res2->get(1, 2) == 5);
+
+    DataObjectFactory::destroy(m, lhs, rhs, exp, res, res2);
+}
+
 TEST_CASE("ColBind - Frame", TAG_KERNELS) {
     auto c0 = genGivenVals<DenseMatrix<double>>(3, {1, 2, 3});
     auto c1 = genGivenVals<DenseMatrix<double>>(3, {4, 5, 6});
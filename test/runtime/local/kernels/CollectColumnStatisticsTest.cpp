@@ -0,0 +1,104 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/io/ColumnStatistics.h>
+#include <runtime/local/kernels/CollectColumnStatistics.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+TEST_CASE("collectColumnStatistics", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    const size_t numRows = 200000;
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::STR};
+    std::string labels[] = {"id", "val", "name"};
+    auto f = DataObjectFactory::create<Frame>(numRows, 3, schema, labels, false);
+    auto id = static_cast<int64_t *>(f->getColumnRaw(0));
+    auto val = static_cast<double *>(f->getColumnRaw(1));
+    auto name = static_cast<std::string *>(f->getColumnRaw(2));
+    for(size_t r = 0; r < numRows; r++) {
+        id[r] = (r * 7919) % numRows;
+        // a tenth missing, the others the 900 numbers in [0, 1000) but the multiples of 10
+        val[r] = r % 10 == 0 ? std::numeric_limits<double>::quiet_NaN() : static_cast<double>((r * 31) % 1000);
+        name[r] = "n" + std::to_string(r % 50);
+    }
+
+    const std::vector<ColumnStatistics> stats = collectColumnStatistics(f, ctx.get());
+    REQUIRE(stats.size() == 3);
+
+    CHECK(std::abs(stats[0].numDistinct - ssize_t(numRows)) < ssize_t(numRows) / 20);
+    CHECK(stats[0].min == 0);
+    CHECK(stats[0].max == numRows - 1);
+    CHECK(stats[0].nullFraction == 0);
+    CHECK(stats[0].histogram.size() == ColumnStatistics::NUM_BUCKETS - 1);
+    CHECK(std::is_sorted(stats[0].histogram.begin(), stats[0].histogram.end()));
+
+    CHECK(std::abs(stats[1].numDistinct - 900) < 45);
+    CHECK(stats[1].nullFraction == Approx(0.1));
+    CHECK(stats[1].min == 1);
+    CHECK(stats[1].max == 999);
+    // the fraction of the rows below 500, of which a tenth are missing
+    CHECK(*stats[1].fractionBelow(500, false) == Approx(0.9 * 0.5).margin(0.03));
+    CHECK(*stats[1].fractionEqual(21) == Approx(0.9 / 900).margin(0.0001));
+    CHECK(*stats[1].fractionEqual(2000) == 0);
+
+    CHECK(stats[2].numDistinct == 50);
+    CHECK(stats[2].nullFraction == 0);
+    CHECK_FALSE(stats[2].hasRange());
+    CHECK_FALSE(stats[2].fractionBelow(0, true));
+
+    DataObjectFactory::destroy(f);
+}
+
+TEST_CASE("ColumnStatistics estimate selectivities and join sizes", TAG_KERNELS) {
+    ColumnStatistics s;
+    CHECK_FALSE(s.fractionBelow(1, true));
+    CHECK_FALSE(s.fractionEqual(1));
+
+    // a skewed column: a third of the values 0, the others uniform in (0, 100]
+    s.numDistinct = 101;
+    s.min = 0;
+    s.max = 100;
+    s.nullFraction = 0;
+    s.histogram = {0, 50};
+    CHECK(*s.fractionBelow(-1, true) == 0);
+    CHECK(*s.fractionBelow(0, false) == 0);
+    CHECK(*s.fractionBelow(0, true) == Approx(1.0 / 3));
+    CHECK(*s.fractionBelow(75, true) == Approx(2.0 / 3 + 1.0 / 6));
+    CHECK(*s.fractionBelow(100, true) == 1);
+    CHECK(*s.fractionEqual(0) == Approx(1.0 / 3));
+    CHECK(*s.fractionEqual(30) == Approx(1.0 / 101));
+
+    ColumnStatistics key;
+    key.numDistinct = 1000;
+    ColumnStatistics foreignKey;
+    foreignKey.numDistinct = 100;
+    CHECK(*ColumnStatistics::joinSize(1000, key, 50000, foreignKey) == Approx(50000));
+    CHECK_FALSE(ColumnStatistics::joinSize(1000, key, 50000, ColumnStatistics()));
+}
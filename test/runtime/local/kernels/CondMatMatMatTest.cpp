@@ -0,0 +1,96 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/CondMatMatMat.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("CondMatMatMat", TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+
+    auto thenVal = genGivenVals<DenseMatrix<VT>>(2, {1, 2, 3, 4, 5, 6});
+    auto elseVal = genGivenVals<DenseMatrix<VT>>(2, {-1, -2, -3, -4, -5, -6});
+    auto exp = genGivenVals<DenseMatrix<VT>>(2, {1, -2, -3, 4, 5, -6});
+
+    DenseMatrix<VT> * res = nullptr;
+    SECTION("dense condition") {
+        auto cond = genGivenVals<DenseMatrix<double>>(2, {1, 0, 0, 0.5, -1, 0});
+        condMatMatMat(res, cond, thenVal, elseVal, nullptr);
+        DataObjectFactory::destroy(cond);
+    }
+    SECTION("mask") {
+        auto cond = genGivenVals<BitMatrix>(2, {1, 0, 0, 1, 1, 0});
+        condMatMatMat(res, cond, thenVal, elseVal, nullptr);
+        DataObjectFactory::destroy(cond);
+    }
+    CHECK(*res == *exp);
+
+    auto cond = genGivenVals<BitMatrix>(3, {1, 0, 0, 1, 1, 0});
+    DenseMatrix<VT> * res2 = nullptr;
+    CHECK_THROWS(condMatMatMat(res2, cond, thenVal, elseVal, nullptr));
+
+    DataObjectFactory::destroy(thenVal, elseVal, exp, res, cond);
+}
+
+TEMPLATE_TEST_CASE("CondMatMatMat, mask, parallel", TAG_KERNELS, double, float) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    const size_t numRows = 1500;
+    const size_t numCols = 201;
+    auto thenVal = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    auto wide = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols + 2, false);
+    for(size_t i = 0; i < numRows * numCols; i++)
+        thenVal->getValues()[i] = static_cast<VT>(i % 1000);
+    for(size_t i = 0; i < numRows * (numCols + 2); i++)
+        wide->getValues()[i] = -static_cast<VT>(i % 1000);
+    auto elseVal = DataObjectFactory::create<DenseMatrix<VT>>(wide, 0, numRows, 0, numCols);
+    auto cond = DataObjectFactory::create<BitMatrix>(numRows, numCols, true);
+    auto denseCond = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, numCols, true);
+    // runs of set and clear words, and words with both
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const size_t i = r * numCols + c;
+            if((i / 640) % 3 == 0 || ((i / 640) % 3 == 1 && i % 5 == 0)) {
+                cond->set(r, c, true);
+                denseCond->set(r, c, 1);
+            }
+        }
+
+    DenseMatrix<VT> * res = nullptr;
+    condMatMatMat(res, cond, thenVal, elseVal, ctx.get());
+    DenseMatrix<VT> * exp = nullptr;
+    condMatMatMat(exp, denseCond, thenVal, elseVal, ctx.get());
+    CHECK(*res == *exp);
+
+    // a view as result
+    auto wideRes = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols + 2, false);
+    auto viewRes = DataObjectFactory::create<DenseMatrix<VT>>(wideRes, 0, numRows, 2, numCols + 2);
+    condMatMatMat(viewRes, cond, thenVal, elseVal, ctx.get());
+    CHECK(*viewRes == *exp);
+
+    DataObjectFactory::destroy(thenVal, wide, elseVal, cond, denseCond, res, exp, wideRes, viewRes);
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/Convolution.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <random>
+#include <vector>
+
+// the convolution by its definition, with a bias per filter
+template<class DT>
+std::vector<typename DT::VT> convolve(const DT *data, const DT *filter, const DT *bias, size_t C, size_t H, size_t W,
+        size_t R, size_t S, size_t strideH, size_t strideW, size_t padH, size_t padW) {
+    using VT = typename DT::VT;
+    const size_t F = filter->getNumRows();
+    const size_t P = (H + 2 * padH - R) / strideH + 1;
+    const size_t Q = (W + 2 * padW - S) / strideW + 1;
+    std::vector<VT> exp;
+    for(size_t n = 0; n < data->getNumRows(); n++)
+        for(size_t f = 0; f < F; f++)
+            for(size_t p = 0; p < P; p++)
+                for(size_t q = 0; q < Q; q++) {
+                    VT sum = bias->get(0, f);
+                    for(size_t c = 0; c < C; c++)
+                        for(size_t r = 0; r < R; r++)
+                            for(size_t s = 0; s < S; s++) {
+                                const size_t h = p * strideH + r;
+                                const size_t w = q * strideW + s;
+                                if(h >= padH && h < H + padH && w >= padW && w < W + padW)
+                                    sum += data->get(n, (c * H + h - padH) * W + w - padW)
+                                            * filter->get(f, (c * R + r) * S + s);
+                            }
+                    exp.push_back(sum);
+                }
+    return exp;
+}
+
+template<class DT>
+DT * genRandom(size_t numRows, size_t numCols, std::mt19937 & gen) {
+    std::uniform_real_distribution<double> distr(-1, 1);
+    std::vector<typename DT::VT> values(numRows * numCols);
+    for(auto & v : values)
+        v = distr(gen);
+    return genGivenVals<DT>(numRows, values);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Convolution::Forward", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+
+    ParallelContext dctx;
+
+    // 3 x 3 filters with a stride of 1 use Winograd's algorithm, all others im2col
+    size_t R, S, strideH, strideW, padH, padW;
+    SECTION("3x3 filter, stride 1, padding 1") { R = 3; S = 3; strideH = 1; strideW = 1; padH = 1; padW = 1; }
+    SECTION("3x3 filter, stride 1, no padding") { R = 3; S = 3; strideH = 1; strideW = 1; padH = 0; padW = 0; }
+    SECTION("2x3 filter, stride 2x1, padding 1x2") { R = 2; S = 3; strideH = 2; strideW = 1; padH = 1; padW = 2; }
+    SECTION("3x3 filter, stride 2, padding 1") { R = 3; S = 3; strideH = 2; strideW = 2; padH = 1; padW = 1; }
+
+    // 3 images of 3 channels of 7 x 6 pixels (an odd number of outputs per dimension), 4 filters
+    const size_t N = 3, C = 3, H = 7, W = 6, F = 4;
+    std::mt19937 gen(42);
+    auto data = genRandom<DT>(N, C * H * W, gen);
+    auto filter = genRandom<DT>(F, C * R * S, gen);
+    auto bias = genRandom<DT>(1, F, gen);
+
+    DT * res = nullptr;
+    size_t P, Q;
+    Convolution::Forward<DT, DT>::apply(res, P, Q, data, filter, bias, N, C, H, W, R, S, strideH, strideW, padH, padW,
+            dctx.get());
+    CHECK(P == (H + 2 * padH - R) / strideH + 1);
+    CHECK(Q == (W + 2 * padW - S) / strideW + 1);
+    REQUIRE(res->getNumRows() == N);
+    REQUIRE(res->getNumCols() == F * P * Q);
+    const auto exp = convolve(data, filter, bias, C, H, W, R, S, strideH, strideW, padH, padW);
+    for(size_t n = 0; n < N; n++)
+        for(size_t i = 0; i < F * P * Q; i++)
+            CHECK(res->get(n, i) == Approx(exp[n * F * P * Q + i]).epsilon(1e-4));
+
+    DataObjectFactory::destroy(data, filter, bias, res);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Convolution::Forward, no bias", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+
+    auto input = genGivenVals<DT>(1, { 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+    auto filter = genGivenVals<DT>(1, { 1, 0, 0, 1 });
+    // expected output for a 2x2 filter, stride 1x1, padding 0x0, where the filter as the bias means no bias
+    auto exp = genGivenVals<DT>(1, { 6, 8, 12, 14 });
+
+    DT * res = nullptr;
+    size_t P, Q;
+    Convolution::Forward<DT, DT>::apply(res, P, Q, input, filter, filter, 1, 1, 3, 3, 2, 2, 1, 1, 0, 0, nullptr);
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(input, filter, exp, res);
+}
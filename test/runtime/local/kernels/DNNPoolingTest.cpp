@@ -26,6 +26,7 @@
     #include <runtime/local/kernels/Pooling.h>
 #endif
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
@@ -112,3 +113,34 @@ TEMPLATE_PRODUCT_TEST_CASE("pool_fwd_max", TAG_DNN, (DenseMatrix), (float, doubl
     DataObjectFactory::destroy(inputs);
     DataObjectFactory::destroy(out_f2x2_s1x1_p0x0);
 }
+
+#ifndef USE_CUDA
+TEMPLATE_PRODUCT_TEST_CASE("pool_fwd, stride and padding", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+
+    ParallelContext dctx;
+
+    // a negative "image" of 4x4 pixels, such that the padding must not take part in the maximum
+    auto input = genGivenVals<DT>(1, { -1, -2, -3, -4, -5, -6, -7, -8, -9, -10, -11, -12, -13, -14, -15, -16 });
+
+    // expected outputs when used with settings filter 3x3, stride 2x2, padding 1x1, where the average excludes the
+    // padding
+    auto out_max = genGivenVals<DT>(1, { -1, -2, -5, -6 });
+    auto out_avg = genGivenVals<DT>(1, { -3.5, -5, -9.5, -11 });
+
+    DT* res_max = nullptr;
+    DT* res_avg = nullptr;
+    size_t out_h;
+    size_t out_w;
+    Pooling::Forward<Pooling::MAX, DT, DT>::apply(res_max, out_h, out_w, input, 1, 1, 4, 4, 3, 3, 2, 2, 1, 1,
+            dctx.get());
+    CHECK(out_h == 2);
+    CHECK(out_w == 2);
+    CHECK(*res_max == *out_max);
+    Pooling::Forward<Pooling::AVG, DT, DT>::apply(res_avg, out_h, out_w, input, 1, 1, 4, 4, 3, 3, 2, 2, 1, 1,
+            dctx.get());
+    CHECK(*res_avg == *out_avg);
+
+    DataObjectFactory::destroy(input, out_max, out_avg, res_max, res_avg);
+}
+#endif // USE_CUDA
@@ -14,22 +14,31 @@
  * limitations under the License.
  */
 
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CastObj.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/RandMatrix.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <limits>
+#include <type_traits>
 #include <vector>
 
+#include <cmath>
 #include <cstdint>
 
 #define TEST_NAME(opName) "EwBinaryMat (" opName ")"
-#define DATA_TYPES DenseMatrix, CSRMatrix
+#define DATA_TYPES DenseMatrix, CSRMatrix, BlockedMatrix
 #define VALUE_TYPES double, uint32_t
 
 template<class DT>
@@ -182,6 +191,138 @@ TEMPLATE_TEST_CASE(TEST_NAME("mul_sparse_dense"), TAG_KERNELS, VALUE_TYPES) {
     DataObjectFactory::destroy(exp1);
 }
 
+/**
+ * @brief Checks a sparse result against the one of the dense kernel, which must not have non-zeros where the sparse
+ * result has none, and that the sparse result does not store zeros.
+ */
+template<typename VT, class DTRhs>
+void checkSparseAgainstDense(BinaryOpCode opCode, const CSRMatrix<VT> * lhs, const DTRhs * rhs, DCTX(ctx)) {
+    CSRMatrix<VT> * res = nullptr;
+    ewBinaryMat<CSRMatrix<VT>, CSRMatrix<VT>, DTRhs>(opCode, res, lhs, rhs, ctx);
+
+    DenseMatrix<VT> * denseLhs = nullptr;
+    castObj<DenseMatrix<VT>>(denseLhs, lhs, nullptr);
+    DenseMatrix<VT> * denseRhs = nullptr;
+    castObj<DenseMatrix<VT>>(denseRhs, rhs, nullptr);
+    DenseMatrix<VT> * exp = nullptr;
+    ewBinaryMat<DenseMatrix<VT>, DenseMatrix<VT>, DenseMatrix<VT>>(opCode, exp, denseLhs, denseRhs, nullptr);
+
+    REQUIRE(res->getNumRows() == exp->getNumRows());
+    REQUIRE(res->getNumCols() == exp->getNumCols());
+    size_t nnzExp = 0;
+    bool allEqual = true;
+    for(size_t r = 0; r < exp->getNumRows(); r++)
+        for(size_t c = 0; c < exp->getNumCols(); c++) {
+            nnzExp += exp->get(r, c) != VT(0);
+            allEqual &= res->get(r, c) == exp->get(r, c);
+        }
+    CHECK(allEqual);
+    CHECK(res->getNumNonZeros() == nnzExp);
+
+    DataObjectFactory::destroy(res, denseLhs, denseRhs, exp);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("sparse, sparsity-preserving op-codes"), TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+    using SparseDT = CSRMatrix<VT>;
+    using DT = DenseMatrix<VT>;
+
+    auto lhs = genGivenVals<SparseDT>(4, {
+        1, -2, 0, 0, 3, 0,
+        0, 0, 0, 0, 0, 0,
+        4, 0, 5, 0, 0, -6,
+        0, 2, 0, 0, 0, 1,
+    });
+    auto rhs = genGivenVals<SparseDT>(4, {
+        1, 0, 0, 2, -3, 0,
+        0, 7, 0, 0, 0, 0,
+        4, 0, 1, 0, 0, -6,
+        0, 0, 0, 0, 0, 0,
+    });
+    auto rhsDense = genGivenVals<DT>(4, {
+        1, 2, 3, 4, 5, 6,
+        -1, -2, -3, -4, -5, -6,
+        2, 0, 1, 3, 1, 2,
+        1, 1, 1, 1, 1, 0,
+    });
+    auto rhsRow = genGivenVals<DT>(1, {2, -1, 1, 0, 3, 1});
+    auto rhsCol = genGivenVals<DT>(4, {1, 0, -2, 3});
+
+    SECTION("sparse rhs") {
+        for(auto opCode : {BinaryOpCode::ADD, BinaryOpCode::SUB, BinaryOpCode::MUL, BinaryOpCode::MIN,
+                BinaryOpCode::MAX, BinaryOpCode::NEQ, BinaryOpCode::LT, BinaryOpCode::GT, BinaryOpCode::AND,
+                BinaryOpCode::OR})
+            checkSparseAgainstDense(opCode, lhs, rhs, nullptr);
+    }
+    SECTION("dense rhs") {
+        for(auto opCode : {BinaryOpCode::MUL, BinaryOpCode::AND}) {
+            checkSparseAgainstDense(opCode, lhs, rhsDense, nullptr);
+            checkSparseAgainstDense(opCode, lhs, rhsRow, nullptr);
+            checkSparseAgainstDense(opCode, lhs, rhsCol, nullptr);
+        }
+        // the cells of rhs where lhs is zero do not matter, even if they are zero
+        SparseDT * res = nullptr;
+        ewBinaryMat<SparseDT, SparseDT, DT>(BinaryOpCode::DIV, res, lhs, rhsCol, nullptr);
+        auto exp = genGivenVals<SparseDT>(4, {
+            1, -2, 0, 0, 3, 0,
+            0, 0, 0, 0, 0, 0,
+            -2, 0, VT(-2.5), 0, 0, 3,
+            0, VT(2) / 3, 0, 0, 0, VT(1) / 3,
+        });
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(res, exp);
+    }
+    SECTION("comparisons yield sparse masks") {
+        SparseDT * res = nullptr;
+        ewBinaryMat<SparseDT, SparseDT, SparseDT>(BinaryOpCode::GT, res, lhs, rhs, nullptr);
+        auto exp = genGivenVals<SparseDT>(4, {
+            0, 0, 0, 0, 1, 0,
+            0, 0, 0, 0, 0, 0,
+            0, 0, 1, 0, 0, 0,
+            0, 1, 0, 0, 0, 1,
+        });
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(res, exp);
+    }
+    SECTION("op-codes which do not map zeros to zero") {
+        SparseDT * res = nullptr;
+        CHECK_THROWS(ewBinaryMat<SparseDT, SparseDT, SparseDT>(BinaryOpCode::EQ, res, lhs, rhs, nullptr));
+        CHECK_THROWS(ewBinaryMat<SparseDT, SparseDT, SparseDT>(BinaryOpCode::DIV, res, lhs, rhs, nullptr));
+        CHECK_THROWS(ewBinaryMat<SparseDT, SparseDT, DT>(BinaryOpCode::ADD, res, lhs, rhsDense, nullptr));
+        CHECK_THROWS(ewBinaryMat<SparseDT, SparseDT, DT>(BinaryOpCode::GT, res, lhs, rhsDense, nullptr));
+    }
+
+    DataObjectFactory::destroy(lhs, rhs, rhsDense, rhsRow, rhsCol);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("sparse, row-parallel"), TAG_KERNELS, double, float) {
+    using VT = TestType;
+    using SparseDT = CSRMatrix<VT>;
+    using DT = DenseMatrix<VT>;
+    ParallelContext ctx;
+
+    // enough non-zeros for several chunks of rows
+    const size_t numRows = 2000;
+    const size_t numCols = 300;
+    SparseDT * lhs = nullptr;
+    SparseDT * rhs = nullptr;
+    DT * rhsDense = nullptr;
+    randMatrix<SparseDT, VT>(lhs, numRows, numCols, -2, 2, 0.1, 1, nullptr);
+    randMatrix<SparseDT, VT>(rhs, numRows, numCols, -2, 2, 0.05, 2, nullptr);
+    randMatrix<DT, VT>(rhsDense, numRows, numCols, 1, 3, 1, 3, nullptr);
+    // a view, whose non-zeros do not start at the beginning of the arrays
+    auto view = DataObjectFactory::create<SparseDT>(lhs, 17, numRows);
+    auto rhsView = DataObjectFactory::create<SparseDT>(rhs, 17, numRows);
+
+    for(auto opCode : {BinaryOpCode::ADD, BinaryOpCode::MUL, BinaryOpCode::MAX, BinaryOpCode::GT}) {
+        checkSparseAgainstDense(opCode, lhs, rhs, ctx.get());
+        checkSparseAgainstDense(opCode, view, rhsView, ctx.get());
+    }
+    checkSparseAgainstDense(BinaryOpCode::DIV, lhs, rhsDense, ctx.get());
+
+    DataObjectFactory::destroy(lhs, rhs, rhsDense, view, rhsView);
+}
+
 TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("div"), TAG_KERNELS, (DenseMatrix), (VALUE_TYPES)) {
     using DT = TestType;
     
@@ -361,13 +502,276 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("or"), TAG_KERNELS, (DenseMatrix), (VALUE_T
     DataObjectFactory::destroy(m1, m2, m3);
 }
 
+// ****************************************************************************
+// Broadcasting and views
+// ****************************************************************************
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("sub, broadcasting"), TAG_KERNELS, (DenseMatrix), (VALUE_TYPES)) {
+    using DT = TestType;
+
+    auto m = genGivenVals<DT>(2, {
+            5, 6, 7,
+            8, 9, 10,
+    });
+    auto rowVec = genGivenVals<DT>(1, {1, 2, 3});
+    auto colVec = genGivenVals<DT>(2, {1, 2});
+    auto expRow = genGivenVals<DT>(2, {
+            4, 4, 4,
+            7, 7, 7,
+    });
+    auto expCol = genGivenVals<DT>(2, {
+            4, 5, 6,
+            6, 7, 8,
+    });
+
+    checkEwBinaryMat(BinaryOpCode::SUB, m, rowVec, expRow);
+    checkEwBinaryMat(BinaryOpCode::SUB, m, colVec, expCol);
+
+    DataObjectFactory::destroy(m, rowVec, colVec, expRow, expCol);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("max, views"), TAG_KERNELS, (DenseMatrix), (VALUE_TYPES)) {
+    using DT = TestType;
+
+    auto m = genGivenVals<DT>(3, {
+            1, 5, 2,
+            6, 0, 3,
+            4, 4, 9,
+    });
+    // sub-matrices with a row skip larger than their number of columns
+    auto lhs = DataObjectFactory::create<DT>(m, 0, 2, 0, 2);
+    auto rhs = DataObjectFactory::create<DT>(m, 1, 3, 1, 3);
+    auto exp = genGivenVals<DT>(2, {
+            1, 5,
+            6, 9,
+    });
+
+    checkEwBinaryMat(BinaryOpCode::MAX, lhs, rhs, exp);
+
+    DataObjectFactory::destroy(m, lhs, rhs, exp);
+}
+
+// ****************************************************************************
+// Blocked matrices
+// ****************************************************************************
+
+TEMPLATE_TEST_CASE(TEST_NAME("blocked, mixed blocks"), TAG_KERNELS, VALUE_TYPES) {
+    using VT = TestType;
+    using BlockType = typename BlockedMatrix<VT>::BlockType;
+    const size_t numRows = 40, numCols = 50, blockSize = 16;
+
+    // the blocks are dense, sparse, or empty in turn, shifted between lhs and rhs
+    auto gen = [&](size_t shift) {
+        auto m = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+        for(size_t r = 0; r < numRows; r++)
+            for(size_t c = 0; c < numCols; c++) {
+                const size_t kind = (r / blockSize + c / blockSize + shift) % 3;
+                const bool nonZero = kind == 0 || (kind == 1 && (r * numCols + c + shift) % 13 == 0);
+                m->set(r, c, nonZero ? VT((r + c + shift) % 4 + 1) : VT(0));
+            }
+        return m;
+    };
+    auto lhs = gen(0);
+    auto rhs = gen(1);
+    auto blockedLhs = DataObjectFactory::create<BlockedMatrix<VT>>(numRows, numCols, blockSize);
+    auto blockedRhs = DataObjectFactory::create<BlockedMatrix<VT>>(numRows, numCols, blockSize);
+    castObj<BlockedMatrix<VT>>(blockedLhs, lhs, nullptr);
+    castObj<BlockedMatrix<VT>>(blockedRhs, rhs, nullptr);
+
+    for(BinaryOpCode opCode : {BinaryOpCode::ADD, BinaryOpCode::MUL, BinaryOpCode::MAX, BinaryOpCode::EQ}) {
+        DenseMatrix<VT> * exp = nullptr;
+        ewBinaryMat(opCode, exp, lhs, rhs, nullptr);
+        BlockedMatrix<VT> * res = nullptr;
+        ewBinaryMat(opCode, res, blockedLhs, blockedRhs, nullptr);
+        DenseMatrix<VT> * resDense = nullptr;
+        castObj<DenseMatrix<VT>>(resDense, res, nullptr);
+        CHECK(*resDense == *exp);
+        if(opCode == BinaryOpCode::MUL)
+            // an empty block of lhs times a dense block of rhs
+            CHECK(res->getBlockType(0, 2) == BlockType::EMPTY);
+        DataObjectFactory::destroy(exp, res, resDense);
+    }
+
+    DataObjectFactory::destroy(lhs, rhs, blockedLhs, blockedRhs);
+}
+
 // ****************************************************************************
 // Invalid op-code
 // ****************************************************************************
 
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("add, operands at their last use"), TAG_KERNELS, (DenseMatrix), (VALUE_TYPES)) {
+    using DT = TestType;
+    auto m1 = genGivenVals<DT>(2, {1, 2, 3, 4});
+    auto m2 = genGivenVals<DT>(2, {10, 20, 30, 40});
+    auto v = genGivenVals<DT>(1, {1, 2});
+    auto exp = genGivenVals<DT>(2, {11, 22, 33, 44});
+    DT * res = nullptr;
+
+    SECTION("lhs is overwritten") {
+        m1->markLastUse();
+        ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, res, m1, m2, nullptr);
+        CHECK(res == m1);
+        CHECK(res->getRefCounter() == 2);
+        CHECK(*res == *exp);
+    }
+    SECTION("rhs is overwritten") {
+        m2->markLastUse();
+        ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, res, m1, m2, nullptr);
+        CHECK(res == m2);
+        CHECK(*res == *exp);
+    }
+    SECTION("broadcast row vector is not overwritten") {
+        v->markLastUse();
+        ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, res, m1, v, nullptr);
+        CHECK(res != v);
+    }
+    SECTION("other references") {
+        m1->markLastUse();
+        m1->increaseRefCounter();
+        ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, res, m1, m2, nullptr);
+        CHECK(res != m1);
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(m1);
+    }
+    SECTION("values shared with a view") {
+        auto view = m1->sliceRow(0, 1);
+        m1->markLastUse();
+        ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, res, m1, m2, nullptr);
+        CHECK(res != m1);
+        CHECK(view->get(0, 1) == 2);
+        DataObjectFactory::destroy(view);
+    }
+
+    DataObjectFactory::destroy(m1, m2, v, exp, res);
+}
+
 TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("some invalid op-code"), TAG_KERNELS, (DATA_TYPES), (VALUE_TYPES)) {
     using DT = TestType;
     DT * res = nullptr;
     auto m = genGivenVals<DT>(1, {1});
     CHECK_THROWS(ewBinaryMat<DT, DT, DT>(static_cast<BinaryOpCode>(999), res, m, m, nullptr));
-}
\ No newline at end of file
+}
+// ****************************************************************************
+// Static shapes
+// ****************************************************************************
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("static shape"), TAG_KERNELS, (DenseMatrix), (float, double)) {
+    using DT = TestType;
+
+    auto m0 = genGivenVals<DT>(2, {
+            1, 2, 3,
+            4, 5, 6,
+    });
+    auto m1 = genGivenVals<DT>(2, {
+            2, 4, 6,
+            8, 10, 12,
+    });
+    auto v0 = genGivenVals<DT>(1, {1, 2, 3, 4});
+    auto v1 = genGivenVals<DT>(1, {1, 4, 9, 16});
+    auto v2 = genGivenVals<DT>(1, {1, 1, 1, 1});
+
+    DT * res = nullptr;
+    ewBinaryMat<2, 3, DT, DT, DT>(BinaryOpCode::ADD, res, m0, m0, nullptr);
+    CHECK(*res == *m1);
+    DataObjectFactory::destroy(res);
+
+    res = nullptr;
+    ewBinaryMat<1, 4, DT, DT, DT>(BinaryOpCode::MUL, res, v0, v0, nullptr);
+    CHECK(*res == *v1);
+    DataObjectFactory::destroy(res);
+
+    res = nullptr;
+    ewBinaryMat<1, 4, DT, DT, DT>(BinaryOpCode::DIV, res, v1, v1, nullptr);
+    CHECK(*res == *v2);
+    DataObjectFactory::destroy(res);
+
+    DataObjectFactory::destroy(m0, m1, v0, v1, v2);
+}
+
+// ****************************************************************************
+// Masks
+// ****************************************************************************
+
+// values with many ties and some NaNs (for floating-point types), such that all comparisons are covered
+template<typename VT>
+DenseMatrix<VT> * genMaskOperand(size_t numRows, size_t numCols, size_t seed) {
+    auto m = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    VT * values = m->getValues();
+    for(size_t i = 0; i < numRows * numCols; i++)
+        values[i] = (std::is_floating_point<VT>::value && (i * seed) % 29 == 3)
+                ? std::numeric_limits<VT>::quiet_NaN() : static_cast<VT>((i * seed) % 5);
+    return m;
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("comparison masks"), TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    // a number of cells which is not a multiple of the words, and spans several chunks of words
+    const size_t numRows = 1031;
+    const size_t numCols = 131;
+    auto lhs = genMaskOperand<VT>(numRows, numCols, 7);
+    auto rhs = genMaskOperand<VT>(numRows, numCols, 3);
+    auto wide = genMaskOperand<VT>(numRows, numCols + 5, 11);
+    auto view = DataObjectFactory::create<DenseMatrix<VT>>(wide, 0, numRows, 2, numCols + 2);
+
+    for(BinaryOpCode opCode : {BinaryOpCode::EQ, BinaryOpCode::NEQ, BinaryOpCode::LT, BinaryOpCode::LE,
+            BinaryOpCode::GT, BinaryOpCode::GE}) {
+        for(const DenseMatrix<VT> * r : {static_cast<const DenseMatrix<VT> *>(rhs), static_cast<const DenseMatrix<VT> *>(view)}) {
+            DenseMatrix<VT> * exp = nullptr;
+            ewBinaryMat(opCode, exp, lhs, r, ctx.get());
+            BitMatrix * res = nullptr;
+            ewBinaryMat(opCode, res, lhs, r, ctx.get());
+            REQUIRE(res->getNumRows() == numRows);
+            REQUIRE(res->getNumCols() == numCols);
+            bool allEqual = true;
+            for(size_t i = 0; i < numRows; i++)
+                for(size_t j = 0; j < numCols; j++)
+                    allEqual &= res->get(i, j) == (exp->get(i, j) != VT(0));
+            CHECK(allEqual);
+            // the bits beyond the last cell stay clear
+            CHECK(res->getWords()[res->getNumWords() - 1] >> ((numRows * numCols) % 64) == 0);
+            DataObjectFactory::destroy(exp, res);
+        }
+    }
+
+    BitMatrix * res = nullptr;
+    CHECK_THROWS(ewBinaryMat(BinaryOpCode::ADD, res, lhs, rhs, ctx.get()));
+
+    DataObjectFactory::destroy(lhs, rhs, wide, view);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("mask applied"), TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    const size_t numRows = 700;
+    const size_t numCols = 150;
+    auto lhs = genMaskOperand<VT>(numRows, numCols, 7);
+    auto rhs = genMaskOperand<VT>(numRows, numCols, 3);
+    BitMatrix * mask = nullptr;
+    ewBinaryMat(BinaryOpCode::GT, mask, rhs, lhs, ctx.get());
+    auto wide = genMaskOperand<VT>(numRows, numCols + 3, 11);
+    auto view = DataObjectFactory::create<DenseMatrix<VT>>(wide, 0, numRows, 1, numCols + 1);
+
+    for(const DenseMatrix<VT> * l : {static_cast<const DenseMatrix<VT> *>(lhs), static_cast<const DenseMatrix<VT> *>(view)}) {
+        DenseMatrix<VT> * selected = nullptr;
+        ewBinaryMat(BinaryOpCode::MUL, selected, l, mask, ctx.get());
+        DenseMatrix<VT> * added = nullptr;
+        ewBinaryMat(BinaryOpCode::ADD, added, l, mask, ctx.get());
+        bool allEqual = true;
+        for(size_t i = 0; i < numRows; i++)
+            for(size_t j = 0; j < numCols; j++) {
+                const VT v = l->get(i, j);
+                const bool bit = mask->get(i, j);
+                const VT expSelected = bit ? v : VT(0);
+                const VT expAdded = v + VT(bit);
+                allEqual &= (selected->get(i, j) == expSelected || (std::isnan(double(v)) && bit))
+                        && (added->get(i, j) == expAdded || std::isnan(double(v)));
+            }
+        CHECK(allEqual);
+        DataObjectFactory::destroy(selected, added);
+    }
+
+    DataObjectFactory::destroy(lhs, rhs, mask, wide, view);
+}
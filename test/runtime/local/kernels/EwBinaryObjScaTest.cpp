@@ -15,11 +15,16 @@
  */
 
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/CastObj.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/EwBinaryObjSca.h>
+#include <runtime/local/kernels/RandMatrix.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
@@ -511,6 +516,137 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("or"), TAG_KERNELS, (DATA_TYPES), (VALUE_TY
     DataObjectFactory::destroy(m1, mExp);
 }
 
+// ****************************************************************************
+// Matrix at its last use
+// ****************************************************************************
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("mul, matrix at its last use"), TAG_KERNELS, (DATA_TYPES), (VALUE_TYPES)) {
+    using DT = TestType;
+    auto m = genGivenVals<DT>(2, {1, 2, 3, 4});
+    auto exp = genGivenVals<DT>(2, {2, 4, 6, 8});
+    DT * res = nullptr;
+    m->markLastUse();
+    ewBinaryObjSca<DT, DT, typename DT::VT>(BinaryOpCode::MUL, res, m, 2, nullptr);
+    CHECK(res == m);
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(m, exp, res);
+}
+
+// ****************************************************************************
+// Sparse matrix
+// ****************************************************************************
+
+TEMPLATE_TEST_CASE(TEST_NAME("sparse, structure of lhs"), TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+    using DT = CSRMatrix<VT>;
+    auto m = genGivenVals<DT>(3, {
+        1, 0, -2, 0,
+        0, 0, 0, 0,
+        3, 4, 0, -5,
+    });
+
+    SECTION("arithmetic") {
+        DT * res = nullptr;
+        ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::MUL, res, m, 2, nullptr);
+        auto exp = genGivenVals<DT>(3, {2, 0, -4, 0, 0, 0, 0, 0, 6, 8, 0, -10});
+        CHECK(*res == *exp);
+        // the structure is shared, the values are not
+        CHECK(res->getColIdxs() == m->getColIdxs());
+        CHECK(res->getRowOffsets() == m->getRowOffsets());
+        CHECK(m->get(0, 0) == 1);
+        DataObjectFactory::destroy(res, exp);
+    }
+    SECTION("masks store explicit zeros") {
+        DT * res = nullptr;
+        ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::GT, res, m, 1, nullptr);
+        CHECK(res->getNumNonZeros() == m->getNumNonZeros());
+        auto exp = genGivenVals<DenseMatrix<VT>>(3, {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0});
+        bool allEqual = true;
+        for(size_t r = 0; r < 3; r++)
+            for(size_t c = 0; c < 4; c++)
+                allEqual &= res->get(r, c) == exp->get(r, c);
+        CHECK(allEqual);
+        DataObjectFactory::destroy(res, exp);
+    }
+    SECTION("view") {
+        auto view = DataObjectFactory::create<DT>(m, 2, 3);
+        DT * res = nullptr;
+        ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::MIN, res, view, 0, nullptr);
+        CHECK(res->get(0, 3) == VT(-5));
+        CHECK(res->getNumNonZeros() == 3);
+        CHECK(res->getColIdxs(0) == view->getColIdxs(0));
+        DataObjectFactory::destroy(view, res);
+    }
+    SECTION("given result") {
+        auto res = DataObjectFactory::create<DT>(3, 4, m->getNumNonZeros(), false);
+        ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::MAX, res, m, 0, nullptr);
+        CHECK(res->get(0, 0) == 1);
+        CHECK(res->get(0, 2) == 0);
+        CHECK(res->get(2, 1) == 4);
+        CHECK(res->getNumNonZeros() == m->getNumNonZeros());
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("op-codes which do not map zero to zero") {
+        DT * res = nullptr;
+        CHECK_THROWS(ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::ADD, res, m, 1, nullptr));
+        CHECK_THROWS(ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::EQ, res, m, 0, nullptr));
+        CHECK_THROWS(ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::DIV, res, m, 0, nullptr));
+        CHECK_THROWS(ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::MAX, res, m, 1, nullptr));
+        CHECK(res == nullptr);
+    }
+
+    DataObjectFactory::destroy(m);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("sparse, parallel"), TAG_KERNELS, double, float) {
+    using VT = TestType;
+    using DT = CSRMatrix<VT>;
+    ParallelContext ctx;
+
+    DT * m = nullptr;
+    randMatrix<DT, VT>(m, 2000, 300, -2, 2, 0.1, 1, nullptr);
+    DT * res = nullptr;
+    ewBinaryObjSca<DT, DT, VT>(BinaryOpCode::MUL, res, m, 3, ctx.get());
+    bool allEqual = true;
+    for(size_t k = 0; k < m->getNumNonZeros(); k++)
+        allEqual &= res->getValues()[k] == m->getValues()[k] * 3;
+    CHECK(allEqual);
+    DataObjectFactory::destroy(m, res);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("compressed, on the dictionaries"), TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+    // a dictionary-encoded column, a mostly non-zero one, and one with too many distinct values
+    const size_t numRows = 500;
+    auto dense = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 3, false);
+    for(size_t r = 0; r < numRows; r++) {
+        dense->set(r, 0, VT((r * 13) % 5));
+        dense->set(r, 1, r % 97 == 3 ? VT(1) : VT(5));
+        dense->set(r, 2, VT(r));
+    }
+    CompressedMatrix<VT> * arg = nullptr;
+    castObj<CompressedMatrix<VT>, DenseMatrix<VT>>(arg, dense, nullptr);
+
+    for(BinaryOpCode opCode : {BinaryOpCode::ADD, BinaryOpCode::MUL, BinaryOpCode::GT}) {
+        CompressedMatrix<VT> * res = nullptr;
+        ewBinaryObjSca<CompressedMatrix<VT>, CompressedMatrix<VT>, VT>(opCode, res, arg, VT(2), nullptr);
+        // the mappings of the rows are shared
+        REQUIRE(res->getColGroups().size() == arg->getColGroups().size());
+        for(size_t g = 0; g < arg->getColGroups().size(); g++)
+            CHECK(res->getColGroups()[g].mapping.get() == arg->getColGroups()[g].mapping.get());
+
+        DenseMatrix<VT> * exp = nullptr;
+        ewBinaryObjSca<DenseMatrix<VT>, DenseMatrix<VT>, VT>(opCode, exp, dense, VT(2), nullptr);
+        DenseMatrix<VT> * resDense = nullptr;
+        castObj<DenseMatrix<VT>, CompressedMatrix<VT>>(resDense, res, nullptr);
+        CHECK(*resDense == *exp);
+        CHECK_THROWS(ewBinaryObjSca<CompressedMatrix<VT>, CompressedMatrix<VT>, VT>(opCode, res, arg, VT(2), nullptr));
+        DataObjectFactory::destroy(res, exp, resDense);
+    }
+
+    DataObjectFactory::destroy(dense, arg);
+}
+
 // ****************************************************************************
 // Invalid op-code
 // ****************************************************************************
@@ -520,4 +656,37 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("some invalid op-code"), TAG_KERNELS, (DATA
     DT * res = nullptr;
     auto m = genGivenVals<DT>(1, {1});
     CHECK_THROWS(ewBinaryObjSca<DT, DT, typename DT::VT>(static_cast<BinaryOpCode>(999), res, m, 1, nullptr));
-}
\ No newline at end of file
+}
+TEMPLATE_TEST_CASE(TEST_NAME("comparison masks"), TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    const size_t numRows = 2049;
+    const size_t numCols = 67;
+    auto wide = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols + 1, false);
+    for(size_t i = 0; i < numRows * (numCols + 1); i++)
+        wide->getValues()[i] = static_cast<VT>((i * 13) % 9);
+    auto lhs = DataObjectFactory::create<DenseMatrix<VT>>(wide, 0, numRows, 0, numCols + 1);
+    auto view = DataObjectFactory::create<DenseMatrix<VT>>(wide, 0, numRows, 1, numCols + 1);
+
+    for(BinaryOpCode opCode : {BinaryOpCode::EQ, BinaryOpCode::NEQ, BinaryOpCode::LT, BinaryOpCode::LE,
+            BinaryOpCode::GT, BinaryOpCode::GE}) {
+        for(const DenseMatrix<VT> * arg : {static_cast<const DenseMatrix<VT> *>(lhs), static_cast<const DenseMatrix<VT> *>(view)}) {
+            DenseMatrix<VT> * exp = nullptr;
+            ewBinaryObjSca(opCode, exp, arg, VT(4), ctx.get());
+            BitMatrix * res = nullptr;
+            ewBinaryObjSca(opCode, res, arg, VT(4), ctx.get());
+            bool allEqual = true;
+            for(size_t r = 0; r < arg->getNumRows(); r++)
+                for(size_t c = 0; c < arg->getNumCols(); c++)
+                    allEqual &= res->get(r, c) == (exp->get(r, c) != VT(0));
+            CHECK(allEqual);
+            DataObjectFactory::destroy(exp, res);
+        }
+    }
+
+    BitMatrix * res = nullptr;
+    CHECK_THROWS(ewBinaryObjSca(BinaryOpCode::MUL, res, lhs, VT(4), ctx.get()));
+
+    DataObjectFactory::destroy(wide, lhs, view);
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/EwFused.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+#include <catch.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("EwFused, broadcast and aggregate", TAG_KERNELS, double, float) {
+    using DT = DenseMatrix<TestType>;
+    auto x = genGivenVals<DT>(3, {
+        1, 2, 3, 4,
+        5, 6, 7, 8,
+        0, 2, 4, 6,
+    });
+    auto mu = genGivenVals<DT>(1, {1, 2, 3, 4});
+    auto sigma = genGivenVals<DT>(1, {1, 2, 4, 8});
+    const DT * args[] = {x, mu, sigma};
+    const char * body = ";sub a0 a1;pow r0 c2;div r1 a2";
+
+    // (x - mu) ^ 2 / sigma
+    auto expEw = genGivenVals<DT>(3, {
+        0, 0, 0, 0,
+        16, 8, 4, 2,
+        1, 0, 0.25, 0.5,
+    });
+    DT * res = nullptr;
+    ewFused(res, (std::string("none") + body).c_str(), args, 3, nullptr);
+    CHECK(*res == *expEw);
+
+    DT * resRow = nullptr;
+    ewFused(resRow, (std::string("sumRow") + body).c_str(), args, 3, nullptr);
+    auto expRow = genGivenVals<DT>(3, {0, 30, 1.75});
+    CHECK(*resRow == *expRow);
+
+    DT * resCol = nullptr;
+    ewFused(resCol, (std::string("maxCol") + body).c_str(), args, 3, nullptr);
+    auto expCol = genGivenVals<DT>(1, {16, 8, 4, 2});
+    CHECK(*resCol == *expCol);
+
+    DT * resAll = nullptr;
+    ewFused(resAll, (std::string("sumAll") + body).c_str(), args, 3, nullptr);
+    auto expAll = genGivenVals<DT>(1, {31.75});
+    CHECK(*resAll == *expAll);
+
+    DataObjectFactory::destroy(x, mu, sigma, res, expEw, resRow, expRow, resCol, expCol, resAll, expAll);
+}
+
+TEST_CASE("EwFused, unary operations and column vectors", TAG_KERNELS) {
+    using DT = DenseMatrix<double>;
+    auto x = genGivenVals<DT>(2, {
+        4, 9,
+        16, 25,
+    });
+    auto y = genGivenVals<DT>(2, {1, -1});
+    const DT * args[] = {x, y};
+
+    DT * res = nullptr;
+    ewFused(res, "minRow;sqrt a0;mul r0 a1;abs r1", args, 2, nullptr);
+    auto exp = genGivenVals<DT>(2, {2, 4});
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(x, y, res, exp);
+}
+
+TEST_CASE("EwFused, large, parallel", TAG_KERNELS) {
+    using DT = DenseMatrix<double>;
+    // more columns than a block and more cells than a chunk
+    const size_t numRows = 1000;
+    const size_t numCols = 300;
+    auto x = DataObjectFactory::create<DT>(numRows, numCols, false);
+    auto mu = DataObjectFactory::create<DT>(1, numCols, false);
+    for(size_t c = 0; c < numCols; c++)
+        mu->getValues()[c] = static_cast<double>(c % 7);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            x->getValues()[r * numCols + c] = static_cast<double>((r * 31 + c * 17) % 23);
+    const DT * args[] = {x, mu};
+
+    ParallelContext ctx;
+
+    std::vector<double> expRow(numRows, 0);
+    std::vector<double> expCol(numCols, 0);
+    double expAll = 0;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const double d = x->getValues()[r * numCols + c] - mu->getValues()[c];
+            expRow[r] += d * d;
+            expCol[c] += d * d;
+            expAll += d * d;
+        }
+
+    DT * resRow = nullptr;
+    ewFused(resRow, "sumRow;sub a0 a1;mul r0 r0", args, 2, ctx.get());
+    DT * resCol = nullptr;
+    ewFused(resCol, "sumCol;sub a0 a1;mul r0 r0", args, 2, ctx.get());
+    DT * resAll = nullptr;
+    ewFused(resAll, "sumAll;sub a0 a1;mul r0 r0", args, 2, ctx.get());
+
+    REQUIRE(resRow->getNumRows() == numRows);
+    REQUIRE(resRow->getNumCols() == 1);
+    for(size_t r = 0; r < numRows; r++)
+        CHECK(resRow->get(r, 0) == expRow[r]);
+    REQUIRE(resCol->getNumRows() == 1);
+    REQUIRE(resCol->getNumCols() == numCols);
+    for(size_t c = 0; c < numCols; c++)
+        CHECK(resCol->get(0, c) == expCol[c]);
+    CHECK(resAll->get(0, 0) == expAll);
+
+    DataObjectFactory::destroy(x, mu, resRow, resCol, resAll);
+}
+
+TEST_CASE("EwFused, short-circuited and/or", TAG_KERNELS) {
+    using DT = DenseMatrix<double>;
+    // runs of zeros and ones longer than a block, such that whole blocks skip
+    // the right operand
+    const size_t numRows = 5000;
+    auto x = DataObjectFactory::create<DT>(numRows, 1, false);
+    auto y = DataObjectFactory::create<DT>(numRows, 1, false);
+    for(size_t r = 0; r < numRows; r++) {
+        x->getValues()[r] = static_cast<double>((r / 700) % 3);
+        y->getValues()[r] = static_cast<double>(r % 11);
+    }
+    const DT * args[] = {x, y};
+
+    DT * resAnd = nullptr;
+    // x > 0 and (y < 5 and y * 2 > 4)
+    ewFused(resAnd, "none;gt a0 c0;lt a1 c5;mul a1 c2;gt r2 c4;and r1 r3;and r0 r4", args, 2, nullptr);
+    DT * resOr = nullptr;
+    // x > 1 or y >= 10
+    ewFused(resOr, "sumAll;gt a0 c1;ge a1 c10;or r0 r1", args, 2, nullptr);
+
+    double expOr = 0;
+    for(size_t r = 0; r < numRows; r++) {
+        const double xr = x->getValues()[r];
+        const double yr = y->getValues()[r];
+        CHECK(resAnd->get(r, 0) == ((xr > 0 && yr < 5 && yr * 2 > 4) ? 1 : 0));
+        expOr += (xr > 1 || yr >= 10) ? 1 : 0;
+    }
+    CHECK(resOr->get(0, 0) == expOr);
+
+    DataObjectFactory::destroy(x, y, resAnd, resOr);
+}
+
+TEMPLATE_TEST_CASE("EwFused, frame columns", TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+    // more rows than a chunk, columns of different value types
+    const size_t numRows = 100000;
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::UI32};
+    std::string labels[] = {"a", "b", "c"};
+    auto frame = DataObjectFactory::create<Frame>(numRows, 3, schema, labels, false);
+    int64_t * a = static_cast<int64_t *>(frame->getColumnRaw(0));
+    double * b = static_cast<double *>(frame->getColumnRaw(1));
+    uint32_t * c = static_cast<uint32_t *>(frame->getColumnRaw(2));
+    for(size_t r = 0; r < numRows; r++) {
+        a[r] = static_cast<int64_t>(r % 1000) - 500;
+        b[r] = static_cast<double>(r % 17);
+        c[r] = static_cast<uint32_t>(r / 5000);
+    }
+    size_t colA = 0, colB = 1, colC = 2;
+    auto fa = DataObjectFactory::create<Frame>(frame, 0, numRows, 1, &colA);
+    auto fb = DataObjectFactory::create<Frame>(frame, 0, numRows, 1, &colB);
+    auto fc = DataObjectFactory::create<Frame>(frame, 0, numRows, 1, &colC);
+    const Frame * args[] = {fa, fb, fc};
+
+    ParallelContext ctx;
+
+    for(DaphneContext * cx : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        DenseMatrix<VT> * sel = nullptr;
+        // c = 3 and (a * 2 + b > 0 or a < -400)
+        ewFused(sel, "none;eq a2 c3;mul a0 c2;add r1 a1;gt r2 c0;lt a0 c-400;or r3 r4;and r0 r5", args, 3, cx);
+        DenseMatrix<VT> * proj = nullptr;
+        // a * b - c
+        ewFused(proj, "none;mul a0 a1;sub r0 a2", args, 3, cx);
+
+        REQUIRE(sel->getNumRows() == numRows);
+        REQUIRE(sel->getNumCols() == 1);
+        REQUIRE(proj->getNumRows() == numRows);
+        REQUIRE(proj->getNumCols() == 1);
+        size_t numWrong = 0;
+        for(size_t r = 0; r < numRows; r++) {
+            const VT va = static_cast<VT>(a[r]);
+            const VT vb = static_cast<VT>(b[r]);
+            const VT vc = static_cast<VT>(c[r]);
+            numWrong += sel->get(r, 0) != ((vc == 3 && (va * 2 + vb > 0 || va < -400)) ? 1 : 0);
+            numWrong += proj->get(r, 0) != va * vb - vc;
+        }
+        CHECK(numWrong == 0);
+        DataObjectFactory::destroy(sel, proj);
+    }
+
+    // broadcast single rows, invalid shapes and aggregations
+    size_t row = 7;
+    auto single = DataObjectFactory::create<Frame>(fa, row, row + 1, 1, &colA);
+    const Frame * argsBroadcast[] = {fa, single};
+    DenseMatrix<VT> * res = nullptr;
+    ewFused(res, "none;sub a0 a1", argsBroadcast, 2, nullptr);
+    for(size_t r = 0; r < numRows; r += 997)
+        CHECK(res->get(r, 0) == static_cast<VT>(a[r] - a[row]));
+    DataObjectFactory::destroy(res);
+    res = nullptr;
+    auto shorter = DataObjectFactory::create<Frame>(fa, 0, 10, 1, &colA);
+    const Frame * argsShort[] = {fa, shorter};
+    CHECK_THROWS_AS(ewFused(res, "none;add a0 a1", argsShort, 2, nullptr), std::runtime_error);
+    const Frame * argsWide[] = {frame};
+    CHECK_THROWS_AS(ewFused(res, "none;abs a0", argsWide, 1, nullptr), std::runtime_error);
+    CHECK_THROWS_AS(ewFused(res, "sumAll;abs a0", args, 1, nullptr), std::runtime_error);
+
+    DataObjectFactory::destroy(frame, fa, fb, fc, single, shorter);
+}
+
+TEST_CASE("EwFused, invalid programs", TAG_KERNELS) {
+    using DT = DenseMatrix<double>;
+    auto x = genGivenVals<DT>(2, {1, 2, 3, 4});
+    auto y = genGivenVals<DT>(3, {1, 2, 3});
+    const DT * args[] = {x, y};
+    DT * res = nullptr;
+
+    CHECK_THROWS_AS(ewFused(res, "none", args, 1, nullptr), std::runtime_error);
+    CHECK_THROWS_AS(ewFused(res, "avgAll;abs a0", args, 1, nullptr), std::runtime_error);
+    CHECK_THROWS_AS(ewFused(res, "none;abs a1", args, 1, nullptr), std::runtime_error);
+    CHECK_THROWS_AS(ewFused(res, "none;add a0 r0", args, 1, nullptr), std::runtime_error);
+    CHECK_THROWS_AS(ewFused(res, "none;frob a0", args, 1, nullptr), std::runtime_error);
+    // a 2x2 and a 3x1 matrix
+    CHECK_THROWS_AS(ewFused(res, "none;add a0 a1", args, 2, nullptr), std::runtime_error);
+
+    DataObjectFactory::destroy(x, y);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/EwUnaryMat.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <cstdint>
+
+#define TEST_NAME(opName) "EwUnaryMat (" opName ")"
+#define FP_VALUE_TYPES float, double
+
+template<class DT>
+void checkEwUnaryMat(UnaryOpCode opCode, const DT * arg, const DT * exp) {
+    DT * res = nullptr;
+    ewUnaryMat<DT, DT>(opCode, res, arg, nullptr);
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(res);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("sqrt"), TAG_KERNELS, (DenseMatrix), (double, int64_t)) {
+    using DT = TestType;
+    auto arg = genGivenVals<DT>(2, {0, 1, 4, 9, 16, 25});
+    auto exp = genGivenVals<DT>(2, {0, 1, 2, 3, 4, 5});
+    checkEwUnaryMat(UnaryOpCode::SQRT, arg, exp);
+    DataObjectFactory::destroy(arg, exp);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("sqrt, argument at its last use"), TAG_KERNELS, (DenseMatrix), (double)) {
+    using DT = TestType;
+    auto arg = genGivenVals<DT>(2, {0, 1, 4, 9, 16, 25});
+    auto exp = genGivenVals<DT>(2, {0, 1, 2, 3, 4, 5});
+    DT * res = nullptr;
+    arg->markLastUse();
+    ewUnaryMat<DT, DT>(UnaryOpCode::SQRT, res, arg, nullptr);
+    CHECK(res == arg);
+    CHECK(*res == *exp);
+
+    // not at its last use anymore
+    arg->clearLastUse();
+    DT * res2 = nullptr;
+    ewUnaryMat<DT, DT>(UnaryOpCode::SQRT, res2, res, nullptr);
+    CHECK(res2 != res);
+
+    DataObjectFactory::destroy(arg, exp, res, res2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("ln"), TAG_KERNELS, (DenseMatrix), (FP_VALUE_TYPES)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+    auto arg = genGivenVals<DT>(2, {1, VT(std::exp(1.0)), VT(std::exp(2.0)), 1});
+    auto exp = genGivenVals<DT>(2, {0, std::log(VT(std::exp(1.0))), std::log(VT(std::exp(2.0))), 0});
+    checkEwUnaryMat(UnaryOpCode::LN, arg, exp);
+    DataObjectFactory::destroy(arg, exp);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("abs, view"), TAG_KERNELS, (DenseMatrix), (double, int64_t)) {
+    using DT = TestType;
+    auto arg = genGivenVals<DT>(3, {-1, 2, -3, 4, -5, 6, -7, 8, -9});
+    // the last two columns, i.e., not contiguous
+    auto view = DataObjectFactory::create<DT>(arg, 0, 3, 1, 3);
+    auto exp = genGivenVals<DT>(3, {2, 3, 5, 6, 8, 9});
+    checkEwUnaryMat(UnaryOpCode::ABS, view, exp);
+    DataObjectFactory::destroy(arg, view, exp);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("exp and ln, fast math"), TAG_KERNELS, (DenseMatrix), (FP_VALUE_TYPES)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+    const VT inf = std::numeric_limits<VT>::infinity();
+
+    auto userConfig = std::make_unique<DaphneUserConfig>();
+    userConfig->fast_math = true;
+    auto ctx = std::make_unique<DaphneContext>(*userConfig);
+
+    std::vector<VT> vals;
+    for(int i = -400; i <= 400; i++)
+        vals.push_back(VT(i) / VT(7.3));
+    auto arg = genGivenVals<DT>(vals.size(), vals);
+
+    for(UnaryOpCode opCode : {UnaryOpCode::EXP, UnaryOpCode::LN}) {
+        DT * resExact = nullptr;
+        DT * resFast = nullptr;
+        ewUnaryMat<DT, DT>(opCode, resExact, arg, nullptr);
+        ewUnaryMat<DT, DT>(opCode, resFast, arg, ctx.get());
+        for(size_t i = 0; i < vals.size(); i++) {
+            const VT e = resExact->get(i, 0);
+            const VT f = resFast->get(i, 0);
+            if(std::isnan(e))
+                CHECK(std::isnan(f));
+            else if(std::isinf(e))
+                CHECK(f == e);
+            else
+                CHECK(f == Approx(e).epsilon(8 * std::numeric_limits<VT>::epsilon()));
+        }
+        DataObjectFactory::destroy(resExact, resFast);
+    }
+
+    auto special = genGivenVals<DT>(5, {0, -1, inf, -inf, std::numeric_limits<VT>::quiet_NaN()});
+    DT * res = nullptr;
+    ewUnaryMat<DT, DT>(UnaryOpCode::LN, res, special, ctx.get());
+    CHECK(res->get(0, 0) == -inf);
+    CHECK(std::isnan(res->get(1, 0)));
+    CHECK(res->get(2, 0) == inf);
+    CHECK(std::isnan(res->get(3, 0)));
+    CHECK(std::isnan(res->get(4, 0)));
+    ewUnaryMat<DT, DT>(UnaryOpCode::EXP, res, special, ctx.get());
+    CHECK(res->get(0, 0) == 1);
+    CHECK(res->get(2, 0) == inf);
+    CHECK(res->get(3, 0) == 0);
+    CHECK(std::isnan(res->get(4, 0)));
+
+    DataObjectFactory::destroy(arg, special, res);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("some invalid op-code"), TAG_KERNELS, (DenseMatrix), (double)) {
+    using DT = TestType;
+    auto arg = genGivenVals<DT>(1, {1});
+    DT * res = nullptr;
+    CHECK_THROWS(ewUnaryMat<DT, DT>(static_cast<UnaryOpCode>(999), res, arg, nullptr));
+    DataObjectFactory::destroy(arg, res);
+}
@@ -16,6 +16,7 @@
 
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/Structure.h>
 #include <runtime/local/kernels/CheckEq.h>
@@ -102,3 +103,38 @@ TEMPLATE_TEST_CASE("ExtractCol - Frame", TAG_KERNELS, int64_t, size_t) { // NOLI
     DataObjectFactory::destroy(exp);
     DataObjectFactory::destroy(res);
 }
+
+TEMPLATE_TEST_CASE("ExtractCol - DenseMatrixCM", TAG_KERNELS, double, int64_t) {
+    using DT = DenseMatrixCM<TestType>;
+
+    auto arg = genGivenVals<DT>(3, {
+        1, 2, 3, 4,
+        5, 6, 7, 8,
+        9, 10, 11, 12,
+    });
+
+    // adjacent columns are a view
+    auto selRange = genGivenVals<DenseMatrix<int64_t>>(2, {1, 2});
+    auto expRange = genGivenVals<DT>(3, {
+        2, 3,
+        6, 7,
+        10, 11,
+    });
+    DT * resRange = nullptr;
+    extractCol(resRange, arg, selRange, nullptr);
+    CHECK(*resRange == *expRange);
+    CHECK(resRange->getValues() == arg->getColumn(1));
+
+    // other columns are copied
+    auto sel = genGivenVals<DenseMatrix<int64_t>>(3, {3, 0, 3});
+    auto exp = genGivenVals<DT>(3, {
+        4, 1, 4,
+        8, 5, 8,
+        12, 9, 12,
+    });
+    DT * res = nullptr;
+    extractCol(res, arg, sel, nullptr);
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(arg, selRange, expRange, resRange, sel, exp, res);
+}
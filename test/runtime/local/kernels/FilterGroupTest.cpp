@@ -0,0 +1,109 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/FilterGroup.h>
+#include <runtime/local/kernels/FilterRow.h>
+#include <runtime/local/kernels/Group.h>
+#include <ir/daphneir/Daphne.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("FilterGroup", TAG_KERNELS, double, int64_t) {
+    using VTSel = TestType;
+
+    ParallelContext ctx;
+
+    // several chunks of rows, of which about half are selected
+    const size_t numRows = 200000;
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::SI64, ValueTypeCode::F64};
+    std::string labels[] = {"k", "f", "x", "y"};
+    auto arg = DataObjectFactory::create<Frame>(numRows, 4, schema, labels, false);
+    int64_t * k = static_cast<int64_t *>(arg->getColumnRaw(0));
+    double * f = static_cast<double *>(arg->getColumnRaw(1));
+    int64_t * x = static_cast<int64_t *>(arg->getColumnRaw(2));
+    double * y = static_cast<double *>(arg->getColumnRaw(3));
+    auto sel = DataObjectFactory::create<DenseMatrix<VTSel>>(numRows, 1, false);
+    VTSel * valuesSel = sel->getValues();
+    for(size_t r = 0; r < numRows; r++) {
+        k[r] = static_cast<int64_t>(r % 13) - 6;
+        f[r] = (r % 5) * 0.5;
+        x[r] = static_cast<int64_t>(r % 1000) - 500;
+        y[r] = (r % 7919) * 0.25;
+        valuesSel[r] = (r % 3 != 0 && r % 7 != 2) ? 1 : 0;
+    }
+
+    const char * aggCols[] = {"x", "x", "y", "y", "x"};
+    mlir::daphne::GroupEnum aggFuncs[] = {mlir::daphne::GroupEnum::COUNT, mlir::daphne::GroupEnum::SUM,
+            mlir::daphne::GroupEnum::MIN, mlir::daphne::GroupEnum::MAX, mlir::daphne::GroupEnum::AVG};
+    std::vector<const char *> keyCols;
+
+    SECTION("integer key column, grouped on a hash table") {
+        keyCols = {"k"};
+    }
+    SECTION("dictionary-encoded key column, grouped on the codes") {
+        keyCols = {"k"};
+        arg->encodeColumn(0, ColumnEncoding::DICTIONARY);
+    }
+    SECTION("floating-point key column, grouped in the general case") {
+        keyCols = {"f"};
+    }
+    SECTION("no key columns") {
+    }
+
+    // the result of grouping the filtered frame
+    Frame * filtered = nullptr;
+    filterRow(filtered, arg, sel, nullptr);
+    Frame * exp = nullptr;
+    group(exp, filtered, keyCols.data(), keyCols.size(), aggCols, 5, aggFuncs, 5, nullptr);
+
+    for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        Frame * res = nullptr;
+        filterGroup(res, arg, sel, keyCols.data(), keyCols.size(), aggCols, 5, aggFuncs, 5, c);
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(res);
+    }
+
+    DataObjectFactory::destroy(arg, sel, filtered, exp);
+}
+
+TEMPLATE_TEST_CASE("FilterGroup, invalid selection", TAG_KERNELS, double, int64_t) {
+    using VTSel = TestType;
+
+    ValueTypeCode schema[] = {ValueTypeCode::SI64};
+    std::string labels[] = {"k"};
+    auto arg = DataObjectFactory::create<Frame>(4, 1, schema, labels, true);
+    auto sel = DataObjectFactory::create<DenseMatrix<VTSel>>(3, 1, true);
+    const char * keyCols[] = {"k"};
+
+    Frame * res = nullptr;
+    CHECK_THROWS(filterGroup(res, arg, sel, keyCols, 1, static_cast<const char **>(nullptr), 0,
+            static_cast<mlir::daphne::GroupEnum *>(nullptr), 0, nullptr));
+
+    DataObjectFactory::destroy(arg, sel);
+}
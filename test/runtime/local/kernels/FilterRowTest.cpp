@@ -15,6 +15,7 @@
  */
 
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/BitMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/Structure.h>
@@ -22,6 +23,7 @@
 #include <runtime/local/kernels/FilterRow.h>
 #include <runtime/local/kernels/RandMatrix.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
@@ -108,6 +110,43 @@ TEMPLATE_TEST_CASE("FilterRow - Frame", TAG_KERNELS, double, int64_t, uint32_t)
     DataObjectFactory::destroy(res);
 }
 
+/**
+ * @brief Runs the filterRow-kernel on a frame with encoded columns, the
+ * dictionary-encoded column stays encoded.
+ */
+TEST_CASE("FilterRow - Frame with encoded columns", TAG_KERNELS) { // NOLINT(cert-err58-cpp)
+    const size_t numRows = 6;
+    
+    auto c0 = genGivenVals<DenseMatrix<int64_t>>(numRows, {30, 10, 30, 20, 10, 30});
+    auto c1 = genGivenVals<DenseMatrix<double>>(numRows, {1.5, 1.5, 2.5, 2.5, 2.5, 3.5});
+    auto c2 = genGivenVals<DenseMatrix<uint32_t>>(numRows, {4, 1, 2, 3, 5, 6});
+    std::vector<Structure *> colMats = {c0, c1, c2};
+    auto arg = DataObjectFactory::create<Frame>(colMats, nullptr);
+    arg->encodeColumn(0, ColumnEncoding::DICTIONARY);
+    arg->encodeColumn(1, ColumnEncoding::RUN_LENGTH);
+    
+    // an equality predicate evaluated on the codes
+    auto sel = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    arg->getDictionaryColumn<int64_t>(0)->selectEq(30, sel->getValues(), numRows);
+    
+    Frame * res = nullptr;
+    filterRow<Frame, Frame, int64_t>(res, arg, sel, nullptr);
+    
+    CHECK(res->getNumRows() == 3);
+    CHECK(res->getColumnEncoding(0) == ColumnEncoding::DICTIONARY);
+    CHECK(res->getColumnEncoding(1) == ColumnEncoding::NONE);
+    auto c0Exp = genGivenVals<DenseMatrix<int64_t>>(3, {30, 30, 30});
+    auto c1Exp = genGivenVals<DenseMatrix<double>>(3, {1.5, 2.5, 3.5});
+    auto c2Exp = genGivenVals<DenseMatrix<uint32_t>>(3, {4, 2, 6});
+    const Frame * cres = res;
+    CHECK(*(cres->getColumn<int64_t>(0)) == *c0Exp);
+    CHECK(*(cres->getColumn<double>(1)) == *c1Exp);
+    CHECK(*(cres->getColumn<uint32_t>(2)) == *c2Exp);
+    
+    DataObjectFactory::destroy(c0, c1, c2, c0Exp, c1Exp, c2Exp);
+    DataObjectFactory::destroy(arg, sel, res);
+}
+
 /**
  * @brief Runs the filterRow-kernel with large random input data only to check
  * if it returns the expected number of rows and doesn't crash.
@@ -147,4 +186,83 @@ TEMPLATE_TEST_CASE("FilterRow (large input) - Frame", TAG_KERNELS, double, int64
     DataObjectFactory::destroy(c2);
     DataObjectFactory::destroy(arg);
     DataObjectFactory::destroy(res);
-}
\ No newline at end of file
+}
+TEST_CASE("FilterRow (large input, parallel) - Frame", TAG_KERNELS) { // NOLINT(cert-err58-cpp)
+    const size_t numRows = 300000;
+
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F32, ValueTypeCode::STR};
+    auto arg = DataObjectFactory::create<Frame>(numRows, 3, schema, nullptr, false);
+    int64_t * c0 = static_cast<int64_t *>(arg->getColumnRaw(0));
+    float * c1 = static_cast<float *>(arg->getColumnRaw(1));
+    std::string * c2 = static_cast<std::string *>(arg->getColumnRaw(2));
+    auto sel = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    std::vector<size_t> exp;
+    for(size_t r = 0; r < numRows; r++) {
+        c0[r] = static_cast<int64_t>(r) * 3;
+        c1[r] = static_cast<float>(r % 100);
+        c2[r] = "s" + std::to_string(r);
+        sel->getValues()[r] = (r * 7919) % 5 == 0 || r == numRows - 1;
+        if(sel->getValues()[r])
+            exp.push_back(r);
+    }
+
+    ParallelContext ctx;
+    Frame * res = nullptr;
+    filterRow<Frame, Frame, int64_t>(res, arg, sel, ctx.get());
+
+    REQUIRE(res->getNumRows() == exp.size());
+    const int64_t * res0 = static_cast<const int64_t *>(res->getColumnRaw(0));
+    const float * res1 = static_cast<const float *>(res->getColumnRaw(1));
+    const std::string * res2 = static_cast<const std::string *>(res->getColumnRaw(2));
+    bool allEqual = true;
+    for(size_t i = 0; i < exp.size(); i++)
+        allEqual = allEqual && res0[i] == c0[exp[i]] && res1[i] == c1[exp[i]] && res2[i] == c2[exp[i]];
+    CHECK(allEqual);
+
+    DataObjectFactory::destroy(arg, sel, res);
+}
+
+/**
+ * @brief Runs the filterRow-kernel with a mask of one bit per row, the
+ * dictionary-encoded column stays encoded.
+ */
+TEST_CASE("FilterRow - Frame, mask", TAG_KERNELS) { // NOLINT(cert-err58-cpp)
+    const size_t numRows = 100003;
+
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64, ValueTypeCode::STR};
+    auto arg = DataObjectFactory::create<Frame>(numRows, 3, schema, nullptr, false);
+    int64_t * c0 = static_cast<int64_t *>(arg->getColumnRaw(0));
+    double * c1 = static_cast<double *>(arg->getColumnRaw(1));
+    std::string * c2 = static_cast<std::string *>(arg->getColumnRaw(2));
+    auto sel = DataObjectFactory::create<BitMatrix>(numRows, 1, true);
+    std::vector<size_t> exp;
+    for(size_t r = 0; r < numRows; r++) {
+        c0[r] = static_cast<int64_t>(r % 7);
+        c1[r] = static_cast<double>(r) / 2;
+        c2[r] = "s" + std::to_string(r);
+        if((r * 7919) % 3 == 0 || r == numRows - 1) {
+            sel->set(r, 0, true);
+            exp.push_back(r);
+        }
+    }
+    arg->encodeColumn(0, ColumnEncoding::DICTIONARY);
+
+    ParallelContext ctx;
+    Frame * res = nullptr;
+    filterRow(res, arg, sel, ctx.get());
+
+    REQUIRE(res->getNumRows() == exp.size());
+    CHECK(res->getColumnEncoding(0) == ColumnEncoding::DICTIONARY);
+    const Frame * cres = res;
+    auto res0 = cres->getColumn<int64_t>(0);
+    const double * res1 = static_cast<const double *>(cres->getColumnRaw(1));
+    const std::string * res2 = static_cast<const std::string *>(cres->getColumnRaw(2));
+    bool allEqual = true;
+    for(size_t i = 0; i < exp.size(); i++)
+        allEqual = allEqual && res0->get(i, 0) == static_cast<int64_t>(exp[i] % 7) && res1[i] == c1[exp[i]]
+                && res2[i] == c2[exp[i]];
+    CHECK(allEqual);
+
+    DataObjectFactory::destroy(res0);
+    DataObjectFactory::destroy(arg, sel, res);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/Gemv.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+
+TEMPLATE_PRODUCT_TEST_CASE("Gemv", TAG_KERNELS, (DenseMatrix, CSRMatrix), (float, double)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+    using DTVec = DenseMatrix<VT>;
+
+    auto m = genGivenVals<DT>(4, {
+        1, 0, 2,
+        0, 0, 0,
+        0, 3, 0,
+        4, 0, 5,
+    });
+    auto v = genGivenVals<DTVec>(4, {1, 2, 3, 4});
+    // t(m) @ v
+    auto exp = genGivenVals<DTVec>(3, {17, 9, 22});
+
+    DTVec * res = nullptr;
+    gemv(res, m, v, nullptr);
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(m, v, exp, res);
+}
+
+TEMPLATE_TEST_CASE("Gemv, sparse, large, parallel", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    const size_t numRows = 20000, numCols = 300, period = 7;
+    // a non-zero in every period-th cell, with small integers, such that the sums are exact
+    auto dense = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, true);
+    for(size_t i = 0; i < numRows * numCols; i += period)
+        dense->getValues()[i] = static_cast<VT>(i % 3) + 1;
+    auto v = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+    for(size_t r = 0; r < numRows; r++)
+        v->set(r, 0, static_cast<VT>(r % 4));
+
+    auto sparse = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, numRows * numCols / period + 1, false);
+    size_t * rowOffsets = sparse->getRowOffsets();
+    rowOffsets[0] = 0;
+    for(size_t r = 0, pos = 0; r < numRows; r++) {
+        for(size_t c = 0; c < numCols; c++)
+            if(dense->get(r, c) != 0) {
+                sparse->getValues()[pos] = dense->get(r, c);
+                sparse->getColIdxs()[pos++] = c;
+            }
+        rowOffsets[r + 1] = pos;
+    }
+
+    DenseMatrix<VT> * exp = nullptr;
+    gemv(exp, dense, v, nullptr);
+    DenseMatrix<VT> * res = nullptr;
+    SECTION("cached transposition") {
+        gemv(res, sparse, v, ctx.get());
+        CHECK(*res == *exp);
+        CHECK(static_cast<const CSRMatrix<VT> *>(sparse)->getCachedTransposed() != nullptr);
+        DataObjectFactory::destroy(res);
+        res = nullptr;
+        gemv(res, sparse, v, ctx.get());
+        CHECK(*res == *exp);
+    }
+    SECTION("view, scattered") {
+        // all rows but the last one
+        auto view = DataObjectFactory::create<CSRMatrix<VT>>(sparse, 0, numRows - 1);
+        auto viewDense = DataObjectFactory::create<DenseMatrix<VT>>(dense, 0, numRows - 1, 0, numCols);
+        auto viewV = DataObjectFactory::create<DenseMatrix<VT>>(v, 0, numRows - 1, 0, 1);
+        DenseMatrix<VT> * expView = nullptr;
+        gemv(expView, viewDense, viewV, nullptr);
+        gemv(res, view, viewV, ctx.get());
+        CHECK(*res == *expView);
+        CHECK(static_cast<const CSRMatrix<VT> *>(view)->getCachedTransposed() == nullptr);
+        DataObjectFactory::destroy(view, viewDense, viewV, expView);
+    }
+
+    DataObjectFactory::destroy(dense, sparse, v, exp, res);
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
@@ -23,8 +24,14 @@
 #include <runtime/local/kernels/CheckEq.h>
 #include <ir/daphneir/Daphne.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 #include <catch.hpp>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
 #include <vector>
 
 
@@ -232,9 +239,96 @@ TEMPLATE_TEST_CASE("Group", TAG_KERNELS, (Frame)) {
 
     group(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggCols, nullptr);
     CHECK(*res == *exp);
+    
+    // with dictionary-encoded key columns, the groups are formed on the codes
+    for (size_t i = 0; i < numKeyCols; i++)
+        arg->encodeColumn(arg->getColumnIdx(keyCols[i]), ColumnEncoding::DICTIONARY);
+    Frame * resEncoded{};
+    group(resEncoded, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, numAggCols, nullptr);
+    CHECK(*resEncoded == *exp);
+    DataObjectFactory::destroy(resEncoded);
     delete [] keyCols;
     delete [] aggCols;
     delete aggFuncs;
     delete context;
     DataObjectFactory::destroy(arg, exp, res);
-}
\ No newline at end of file
+}
+TEST_CASE("Group on a hash table, large, parallel", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    // few distinct integer keys in several chunks of rows
+    const size_t numRows = 300000;
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::UI32, ValueTypeCode::SI64, ValueTypeCode::F64};
+    std::string labels[] = {"a", "b", "x", "y"};
+    auto arg = DataObjectFactory::create<Frame>(numRows, 4, schema, labels, false);
+    int64_t * a = static_cast<int64_t *>(arg->getColumnRaw(0));
+    uint32_t * b = static_cast<uint32_t *>(arg->getColumnRaw(1));
+    int64_t * x = static_cast<int64_t *>(arg->getColumnRaw(2));
+    double * y = static_cast<double *>(arg->getColumnRaw(3));
+    struct Agg { uint64_t count = 0; int64_t sum = 0; double min = 1e300, max = -1e300; };
+    std::map<std::pair<int64_t, uint32_t>, Agg> expected;
+    for (size_t r = 0; r < numRows; r++) {
+        a[r] = static_cast<int64_t>(r % 37) - 18;
+        b[r] = (r * 7) % 5 == 4 ? 4000000000u : (r * 7) % 5;
+        x[r] = r % 1000;
+        y[r] = (r % 7919) * 0.5 - 100;
+        Agg & agg = expected[{a[r], b[r]}];
+        agg.count++;
+        agg.sum += x[r];
+        agg.min = std::min(agg.min, y[r]);
+        agg.max = std::max(agg.max, y[r]);
+    }
+
+    const char * keyCols[] = {"a", "b"};
+    const char * aggCols[] = {"x", "x", "y", "y", "x"};
+    mlir::daphne::GroupEnum aggFuncs[] = {mlir::daphne::GroupEnum::COUNT, mlir::daphne::GroupEnum::SUM,
+            mlir::daphne::GroupEnum::MIN, mlir::daphne::GroupEnum::MAX, mlir::daphne::GroupEnum::AVG};
+    for (DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        Frame * res = nullptr;
+        group(res, arg, keyCols, 2, aggCols, 5, aggFuncs, 5, c);
+        REQUIRE(res->getNumRows() == expected.size());
+        REQUIRE(res->getNumCols() == 7);
+        CHECK(res->getLabels()[3] == "SUM(x)");
+        CHECK(res->getSchema()[2] == ValueTypeCode::UI64);
+        CHECK(res->getSchema()[6] == ValueTypeCode::F64);
+        // the groups are ordered by their keys
+        const int64_t * resA = static_cast<const int64_t *>(std::as_const(*res).getColumnRaw(0));
+        const uint32_t * resB = static_cast<const uint32_t *>(std::as_const(*res).getColumnRaw(1));
+        const uint64_t * resCount = static_cast<const uint64_t *>(std::as_const(*res).getColumnRaw(2));
+        const int64_t * resSum = static_cast<const int64_t *>(std::as_const(*res).getColumnRaw(3));
+        const double * resMin = static_cast<const double *>(std::as_const(*res).getColumnRaw(4));
+        const double * resMax = static_cast<const double *>(std::as_const(*res).getColumnRaw(5));
+        const double * resAvg = static_cast<const double *>(std::as_const(*res).getColumnRaw(6));
+        size_t g = 0;
+        bool equal = true;
+        for (const auto & [key, agg] : expected) {
+            equal = equal && resA[g] == key.first && resB[g] == key.second && resCount[g] == agg.count
+                    && resSum[g] == agg.sum && resMin[g] == agg.min && resMax[g] == agg.max
+                    && resAvg[g] == static_cast<double>(agg.sum) / agg.count;
+            g++;
+        }
+        CHECK(equal);
+        DataObjectFactory::destroy(res);
+    }
+
+    DataObjectFactory::destroy(arg);
+}
+
+TEST_CASE("Group, no rows", TAG_KERNELS) {
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64};
+    std::string labels[] = {"a", "x"};
+    auto arg = DataObjectFactory::create<Frame>(0, 2, schema, labels, false);
+
+    const char * keyCols[] = {"a"};
+    const char * aggCols[] = {"x", "x"};
+    mlir::daphne::GroupEnum aggFuncs[] = {mlir::daphne::GroupEnum::COUNT, mlir::daphne::GroupEnum::MAX};
+    Frame * res = nullptr;
+    group(res, arg, keyCols, 1, aggCols, 2, aggFuncs, 2, nullptr);
+    CHECK(res->getNumRows() == 0);
+    REQUIRE(res->getNumCols() == 3);
+    CHECK(res->getLabels()[1] == "COUNT(x)");
+    CHECK(res->getSchema()[1] == ValueTypeCode::UI64);
+    CHECK(res->getSchema()[2] == ValueTypeCode::F64);
+
+    DataObjectFactory::destroy(arg, res);
+}
@@ -18,6 +18,9 @@
 #include <bits/stdint-uintn.h>
 #include <catch.hpp>
 #include <cmath>
+#include <limits>
+#include <vector>
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
@@ -127,3 +130,39 @@ TEMPLATE_PRODUCT_TEST_CASE("hasSpecialValue - floating point", TAG_KERNELS, (Den
         CHECK_FALSE(hasSpecialValue(infinityMat, sigNaN, nullptr));
     }
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("hasSpecialValue - in parallel", TAG_KERNELS, (DenseMatrix, CSRMatrix), (double, float)) {
+
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    ParallelContext ctx;
+
+    const size_t numRows = 1000;
+    const size_t numCols = 300;
+    std::vector<VT> vals(numRows * numCols);
+    for (size_t i = 0; i < vals.size(); i++)
+        vals[i] = VT(i % 100 + 1);
+
+    auto nan = std::numeric_limits<VT>::quiet_NaN();
+    auto inf = std::numeric_limits<VT>::infinity();
+
+    auto plainMat = genGivenVals<DT>(numRows, vals);
+    CHECK_FALSE(hasSpecialValue(plainMat, nan, ctx.get()));
+    CHECK_FALSE(hasSpecialValue(plainMat, inf, ctx.get()));
+    CHECK_FALSE(hasSpecialValue(plainMat, -inf, ctx.get()));
+    CHECK(hasSpecialValue(plainMat, VT(100), ctx.get()));
+
+    // special values in the last cell, behind all other blocks
+    vals.back() = -nan;
+    auto nanMat = genGivenVals<DT>(numRows, vals);
+    vals.back() = -inf;
+    auto infMat = genGivenVals<DT>(numRows, vals);
+    CHECK(hasSpecialValue(nanMat, nan, ctx.get()));
+    CHECK_FALSE(hasSpecialValue(nanMat, inf, ctx.get()));
+    CHECK(hasSpecialValue(infMat, -inf, ctx.get()));
+    CHECK_FALSE(hasSpecialValue(infMat, inf, ctx.get()));
+    CHECK_FALSE(hasSpecialValue(infMat, nan, ctx.get()));
+
+    DataObjectFactory::destroy(plainMat, nanMat, infMat);
+}
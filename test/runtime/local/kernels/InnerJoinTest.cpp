@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
@@ -21,12 +22,17 @@
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/InnerJoin.h>
 #include <runtime/local/kernels/Seq.h>
+#include <runtime/local/kernels/ZoneMaps.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <cstdint>
@@ -81,3 +87,186 @@ TEST_CASE("innerJoin", TAG_KERNELS) {
     DataObjectFactory::destroy(res);
     DataObjectFactory::destroy(resC0Exp, resC1Exp, resC2Exp, resC3Exp, resC4Exp);
 }
+
+TEST_CASE("innerJoin on dictionary-encoded keys", TAG_KERNELS) {
+    auto lhsC0 = genGivenVals<DenseMatrix<int64_t>>(5, {3, 1, 3, 2, 7});
+    auto lhsC1 = genGivenVals<DenseMatrix<double>>(5, {0.1, 0.2, 0.3, 0.4, 0.5});
+    std::vector<Structure *> lhsCols = {lhsC0, lhsC1};
+    std::string lhsLabels[] = {"a", "b"};
+    auto lhs = DataObjectFactory::create<Frame>(lhsCols, lhsLabels);
+
+    auto rhsC0 = genGivenVals<DenseMatrix<int64_t>>(4, {3, 5, 1, 3});
+    auto rhsC1 = genGivenVals<DenseMatrix<int64_t>>(4, {-1, -2, -3, -4});
+    std::vector<Structure *> rhsCols = {rhsC0, rhsC1};
+    std::string rhsLabels[] = {"c", "d"};
+    auto rhs = DataObjectFactory::create<Frame>(rhsCols, rhsLabels);
+
+    Frame * exp = nullptr;
+    innerJoin(exp, lhs, rhs, "a", "c", nullptr);
+
+    lhs->encodeColumn(0, ColumnEncoding::DICTIONARY);
+    rhs->encodeColumn(0, ColumnEncoding::DICTIONARY);
+    Frame * res = nullptr;
+    innerJoin(res, lhs, rhs, "a", "c", nullptr);
+
+    // the same rows in the same order as without the encoding
+    CHECK(res->getNumRows() == 5);
+    CHECK(*res == *exp);
+    auto resC3Exp = genGivenVals<DenseMatrix<int64_t>>(5, {-1, -4, -3, -1, -4});
+    CHECK(*(res->getColumn<int64_t>(3)) == *resC3Exp);
+
+    DataObjectFactory::destroy(lhsC0, lhsC1, lhs);
+    DataObjectFactory::destroy(rhsC0, rhsC1, rhs);
+    DataObjectFactory::destroy(exp, res, resC3Exp);
+}
+
+TEST_CASE("innerJoin on string keys", TAG_KERNELS) {
+    ValueTypeCode lhsSchema[] = {ValueTypeCode::STR};
+    std::string lhsLabels[] = {"a"};
+    auto lhs = DataObjectFactory::create<Frame>(5, 1, lhsSchema, lhsLabels, false);
+    std::string * lhsKeys = static_cast<std::string *>(lhs->getColumnRaw(0));
+    const char * lhsVals[] = {"Graz", "Berlin", "Graz", "Bern", "Rome"};
+    std::copy(lhsVals, lhsVals + 5, lhsKeys);
+
+    ValueTypeCode rhsSchema[] = {ValueTypeCode::STR, ValueTypeCode::SI64};
+    std::string rhsLabels[] = {"c", "d"};
+    auto rhs = DataObjectFactory::create<Frame>(4, 2, rhsSchema, rhsLabels, false);
+    std::string * rhsKeys = static_cast<std::string *>(rhs->getColumnRaw(0));
+    const char * rhsVals[] = {"Graz", "Paris", "Berlin", "Graz"};
+    std::copy(rhsVals, rhsVals + 4, rhsKeys);
+    int64_t * rhsD = static_cast<int64_t *>(rhs->getColumnRaw(1));
+    for(int64_t r = 0; r < 4; r++)
+        rhsD[r] = -1 - r;
+
+    Frame * res = nullptr;
+    innerJoin(res, lhs, rhs, "a", "c", nullptr);
+
+    REQUIRE(res->getNumRows() == 5);
+    REQUIRE(res->getSchema()[0] == ValueTypeCode::STR);
+    const std::string * resA = static_cast<const std::string *>(std::as_const(*res).getColumnRaw(0));
+    const std::string * resC = static_cast<const std::string *>(std::as_const(*res).getColumnRaw(1));
+    for(size_t r = 0; r < 5; r++)
+        CHECK(resA[r] == resC[r]);
+    auto resC2Exp = genGivenVals<DenseMatrix<int64_t>>(5, {-1, -4, -3, -1, -4});
+    CHECK(*(res->getColumn<int64_t>(2)) == *resC2Exp);
+    // the key columns of the arguments are not encoded
+    CHECK(lhs->getColumnEncoding(0) == ColumnEncoding::NONE);
+
+    DataObjectFactory::destroy(lhs, rhs, res, resC2Exp);
+}
+
+TEST_CASE("innerJoin on multiple keys, large, parallel", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    // more rows than fit into one partition on both sides
+    const size_t numRowLhs = 50000, numRowRhs = 40000;
+    ValueTypeCode lhsSchema[] = {ValueTypeCode::SI64, ValueTypeCode::SI64, ValueTypeCode::STR};
+    std::string lhsLabels[] = {"id", "a", "b"};
+    auto lhs = DataObjectFactory::create<Frame>(numRowLhs, 3, lhsSchema, lhsLabels, false);
+    ValueTypeCode rhsSchema[] = {ValueTypeCode::STR, ValueTypeCode::SI64, ValueTypeCode::SI64};
+    std::string rhsLabels[] = {"c", "rid", "d"};
+    auto rhs = DataObjectFactory::create<Frame>(numRowRhs, 3, rhsSchema, rhsLabels, false);
+    int64_t * lhsId = static_cast<int64_t *>(lhs->getColumnRaw(0));
+    int64_t * lhsA = static_cast<int64_t *>(lhs->getColumnRaw(1));
+    std::string * lhsB = static_cast<std::string *>(lhs->getColumnRaw(2));
+    std::string * rhsC = static_cast<std::string *>(rhs->getColumnRaw(0));
+    int64_t * rhsId = static_cast<int64_t *>(rhs->getColumnRaw(1));
+    int64_t * rhsD = static_cast<int64_t *>(rhs->getColumnRaw(2));
+    for(size_t r = 0; r < numRowLhs; r++) {
+        lhsId[r] = r;
+        lhsA[r] = (r * 7919) % 30011;
+        lhsB[r] = std::to_string(r % 3);
+    }
+    for(size_t r = 0; r < numRowRhs; r++) {
+        rhsId[r] = r;
+        rhsD[r] = (r * 104729) % 30011;
+        rhsC[r] = std::to_string(r % 2);
+    }
+
+    // the matches of each row of lhs in the order of the rows of rhs
+    std::map<std::pair<int64_t, std::string>, std::vector<int64_t>> rhsRows;
+    for(size_t r = 0; r < numRowRhs; r++)
+        rhsRows[{rhsD[r], rhsC[r]}].push_back(r);
+    std::vector<int64_t> expLhs, expRhs;
+    for(size_t l = 0; l < numRowLhs; l++) {
+        auto it = rhsRows.find({lhsA[l], lhsB[l]});
+        if(it != rhsRows.end())
+            for(int64_t r : it->second) {
+                expLhs.push_back(l);
+                expRhs.push_back(r);
+            }
+    }
+    REQUIRE(expLhs.size() > 1000);
+
+    const char * lhsOn[] = {"a", "b"};
+    const char * rhsOn[] = {"d", "c"};
+    for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        Frame * res = nullptr;
+        innerJoin(res, lhs, rhs, lhsOn, rhsOn, 2, c);
+        REQUIRE(res->getNumRows() == expLhs.size());
+        REQUIRE(res->getNumCols() == 6);
+        CHECK(res->getLabels()[4] == "rid");
+        const int64_t * resLhs = static_cast<const int64_t *>(std::as_const(*res).getColumnRaw(0));
+        const int64_t * resRhs = static_cast<const int64_t *>(std::as_const(*res).getColumnRaw(4));
+        CHECK(std::equal(expLhs.begin(), expLhs.end(), resLhs));
+        CHECK(std::equal(expRhs.begin(), expRhs.end(), resRhs));
+        DataObjectFactory::destroy(res);
+    }
+
+    // the key columns must have the same value types
+    const char * wrongOn[] = {"a", "rid"};
+    Frame * res = nullptr;
+    CHECK_THROWS(innerJoin(res, lhs, rhs, lhsOn, wrongOn, 2, nullptr));
+
+    DataObjectFactory::destroy(lhs, rhs);
+}
+
+TEST_CASE("innerJoin on sorted keys, large, parallel", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    // sorted keys with runs of equal keys on both sides
+    const size_t numRowLhs = 200000, numRowRhs = 30000;
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F64};
+    std::string lhsLabels[] = {"a", "b"};
+    std::string rhsLabels[] = {"c", "d"};
+    auto lhs = DataObjectFactory::create<Frame>(numRowLhs, 2, schema, lhsLabels, false);
+    auto rhs = DataObjectFactory::create<Frame>(numRowRhs, 2, schema, rhsLabels, false);
+    int64_t * lhsA = static_cast<int64_t *>(lhs->getColumnRaw(0));
+    double * lhsB = static_cast<double *>(lhs->getColumnRaw(1));
+    int64_t * rhsC = static_cast<int64_t *>(rhs->getColumnRaw(0));
+    double * rhsD = static_cast<double *>(rhs->getColumnRaw(1));
+    for(size_t r = 0; r < numRowLhs; r++) {
+        lhsA[r] = r / 3;
+        lhsB[r] = r;
+    }
+    for(size_t r = 0; r < numRowRhs; r++) {
+        rhsC[r] = 2 * (r / 2);
+        rhsD[r] = r;
+    }
+
+    // the hash join, since the keys are not known to be sorted
+    Frame * exp = nullptr;
+    innerJoin(exp, lhs, rhs, "a", "c", ctx.get());
+    CHECK_FALSE(exp->isColumnSorted(0));
+
+    // the merge join of keys the compiler knows to be sorted
+    Frame * merged = nullptr;
+    sortedInnerJoin(merged, lhs, rhs, "a", "c", ctx.get());
+    CHECK(*merged == *exp);
+    DataObjectFactory::destroy(merged);
+
+    ZoneMaps::computeFrame(lhs, ctx.get());
+    ZoneMaps::computeFrame(rhs, ctx.get());
+    REQUIRE(lhs->isColumnSorted(0));
+    REQUIRE(rhs->isColumnSorted(0));
+    for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        Frame * res = nullptr;
+        innerJoin(res, lhs, rhs, "a", "c", c);
+        CHECK(*res == *exp);
+        CHECK(res->isColumnSorted(0));
+        CHECK(res->isColumnSorted(2));
+        DataObjectFactory::destroy(res);
+    }
+
+    DataObjectFactory::destroy(lhs, rhs, exp);
+}
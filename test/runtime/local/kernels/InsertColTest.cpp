@@ -0,0 +1,76 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/InsertCol.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdint>
+
+TEMPLATE_PRODUCT_TEST_CASE("InsertCol", TAG_KERNELS, (DenseMatrix), (double, uint32_t)) {
+    using DT = TestType;
+
+    auto arg = genGivenVals<DT>(3, {
+        1, 2, 3,
+        4, 5, 6,
+        7, 8, 9,
+    });
+    auto ins = genGivenVals<DT>(3, {10, 20, 30});
+    auto exp = genGivenVals<DT>(3, {
+        1, 10, 3,
+        4, 20, 6,
+        7, 30, 9,
+    });
+
+    SECTION("copy") {
+        DT * res = nullptr;
+        insertCol<DT, DT>(res, arg, ins, 1, 2, nullptr);
+        CHECK(res != arg);
+        CHECK(*res == *exp);
+        CHECK(arg->get(1, 1) == 5);
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("argument at its last use") {
+        DT * res = nullptr;
+        arg->markLastUse();
+        insertCol<DT, DT>(res, arg, ins, 1, 2, nullptr);
+        CHECK(res == arg);
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("argument at its last use, but shared with a view") {
+        auto view = DataObjectFactory::create<DT>(arg, 0, 1, 0, 3);
+        DT * res = nullptr;
+        arg->markLastUse();
+        insertCol<DT, DT>(res, arg, ins, 1, 2, nullptr);
+        CHECK(res != arg);
+        CHECK(*res == *exp);
+        CHECK(arg->get(1, 1) == 5);
+        DataObjectFactory::destroy(view, res);
+    }
+    SECTION("size mismatch") {
+        DT * res = nullptr;
+        CHECK_THROWS(insertCol<DT, DT>(res, arg, ins, 0, 2, nullptr));
+    }
+
+    DataObjectFactory::destroy(arg, ins, exp);
+}
@@ -22,6 +22,7 @@
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/IsSymmetric.h>
 #include <stdexcept>
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 #include <catch.hpp>
 
@@ -138,3 +139,33 @@ TEMPLATE_PRODUCT_TEST_CASE("isSymmetric - CSRMatrix-Submatrix", TAG_KERNELS, CSR
         CHECK(isSymmetric(symSubMat, nullptr));
     }
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("isSymmetric - DenseMatrix in parallel", TAG_KERNELS, DenseMatrix, (double, uint32_t)) {
+
+    using DT = TestType;
+
+    ParallelContext ctx;
+
+    // an odd number of row blocks of tiles, the last one partial
+    const size_t n = 300;
+    auto mat = DataObjectFactory::create<DT>(n, n, false);
+    for (size_t r = 0; r < n; r++)
+        for (size_t c = 0; c <= r; c++) {
+            mat->set(r, c, (r * 7 + c * 7) % 11);
+            mat->set(c, r, (r * 7 + c * 7) % 11);
+        }
+    CHECK(isSymmetric(mat, ctx.get()));
+
+    SECTION("asymmetric in the first tile") {
+        mat->set(0, 1, 100);
+    }
+    SECTION("asymmetric in the middle row block") {
+        mat->set(150, 200, 100);
+    }
+    SECTION("asymmetric in the last tile") {
+        mat->set(299, 298, 100);
+    }
+    CHECK_FALSE(isSymmetric(mat, ctx.get()));
+
+    DataObjectFactory::destroy(mat);
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/KeyIndex.h>
+#include <runtime/local/io/ReadDaphne.h>
+#include <runtime/local/io/WriteDaphne.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/EwBinaryObjSca.h>
+#include <runtime/local/kernels/GroupJoin.h>
+#include <runtime/local/kernels/InnerJoin.h>
+#include <runtime/local/kernels/KeyIndexes.h>
+#include <runtime/local/kernels/SemiJoin.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+namespace {
+    // a dimension table with the keys (id, name), each of which has three rows, and a fact table referencing
+    // them and some missing keys
+    Frame * createDimension(size_t numRows) {
+        ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::STR, ValueTypeCode::F64};
+        std::string labels[] = {"d.id", "d.name", "d.val"};
+        auto f = DataObjectFactory::create<Frame>(numRows, 3, schema, labels, false);
+        int64_t * id = static_cast<int64_t *>(f->getColumnRaw(0));
+        std::string * name = static_cast<std::string *>(f->getColumnRaw(1));
+        double * val = static_cast<double *>(f->getColumnRaw(2));
+        for(size_t r = 0; r < numRows; r++) {
+            id[r] = (r * 7) % (numRows / 3);
+            name[r] = "n" + std::to_string(id[r] % 5);
+            val[r] = r;
+        }
+        return f;
+    }
+
+    Frame * createFacts(size_t numRows, size_t numKeys) {
+        ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::STR, ValueTypeCode::F64};
+        std::string labels[] = {"f.id", "f.name", "f.agg"};
+        auto f = DataObjectFactory::create<Frame>(numRows, 3, schema, labels, false);
+        int64_t * id = static_cast<int64_t *>(f->getColumnRaw(0));
+        std::string * name = static_cast<std::string *>(f->getColumnRaw(1));
+        double * agg = static_cast<double *>(f->getColumnRaw(2));
+        for(size_t r = 0; r < numRows; r++) {
+            id[r] = (r * 13) % (numKeys + 10);
+            name[r] = "n" + std::to_string((id[r] + r % 2) % 5);
+            agg[r] = r % 100;
+        }
+        return f;
+    }
+}
+
+TEST_CASE("KeyIndex of the key columns of a frame", TAG_KERNELS) {
+    auto f = createDimension(30);
+
+    auto index = KeyIndexes::build(f, {0}, nullptr);
+    CHECK(f->getKeyIndex({0}).get() == index.get());
+    CHECK(f->getKeyIndex({0, 1}) == nullptr);
+    REQUIRE(index->getNumKeys() == 10);
+    // the keys are numbered in the order of their first occurrence, with their rows in ascending order
+    const Frame * cf = f;
+    const int64_t * id = static_cast<const int64_t *>(cf->getColumnRaw(0));
+    for(size_t k = 0; k < index->getNumKeys(); k++) {
+        CHECK(index->getRowsEnd(k) - index->getRowsBegin(k) == 3);
+        for(const size_t * r = index->getRowsBegin(k); r != index->getRowsEnd(k); r++) {
+            CHECK(id[*r] == id[index->getFirstRow(k)]);
+            CHECK((r == index->getRowsBegin(k) || r[-1] < *r));
+        }
+        CHECK((k == 0 || index->getFirstRow(k - 1) < index->getFirstRow(k)));
+    }
+    CHECK(KeyIndexes::lookup<int64_t>(*index, id, 4) != KeyIndex::npos);
+    CHECK(KeyIndexes::lookup<int64_t>(*index, id, 10) == KeyIndex::npos);
+
+    // the matrix of a column keeps the index of the column
+    auto col = cf->getColumn<int64_t>(0);
+    CHECK(col->getKeyIndex(0).get() == index.get());
+
+    // an index recreated from its rows is the same
+    auto multi = KeyIndexes::build(f, {0, 1}, nullptr);
+    CHECK(f->getKeyIndex({0}).get() == index.get());
+    Frame * g = createDimension(30);
+    KeyIndexes::restore(g, {0, 1}, multi->getBegins(), multi->getRows());
+    auto restored = g->getKeyIndex({0, 1});
+    REQUIRE(restored != nullptr);
+    CHECK(restored->getNumKeys() == multi->getNumKeys());
+    std::vector<size_t> swapped = multi->getRows();
+    std::swap(swapped[0], swapped[1]);
+    CHECK_THROWS(KeyIndexes::restore(g, {0, 1}, multi->getBegins(), swapped));
+    CHECK_THROWS(KeyIndexes::restore(g, {0}, {0, 29}, multi->getRows()));
+
+    // writing a column or changing the number of rows drops the indexes
+    f->getColumnRaw(2);
+    CHECK(f->getKeyIndex({0}) == nullptr);
+    CHECK(col->getKeyIndex(0).get() == index.get());
+    g->shrinkNumRows(20);
+    CHECK(g->getKeyIndex({0, 1}) == nullptr);
+
+    DataObjectFactory::destroy(f, g, col);
+}
+
+TEST_CASE("Joins probe the key index of either input", TAG_KERNELS) {
+    auto userConfig = std::make_unique<DaphneUserConfig>();
+    auto ctx = std::make_unique<DaphneContext>(*userConfig);
+
+    const size_t numDim = 3000;
+    auto dim = createDimension(numDim);
+    auto facts = createFacts(200000, numDim / 3);
+    const char * dimOn[] = {"d.id", "d.name"};
+    const char * factsOn[] = {"f.id", "f.name"};
+
+    // the hash joins without indexes
+    Frame * expLhs = nullptr;
+    innerJoin(expLhs, facts, dim, factsOn, dimOn, 2, ctx.get());
+    Frame * expRhs = nullptr;
+    innerJoin(expRhs, dim, facts, dimOn, factsOn, 2, ctx.get());
+    Frame * expSemi = nullptr;
+    DenseMatrix<int64_t> * expSemiTid = nullptr;
+    semiJoin(expSemi, expSemiTid, facts, dim, "f.id", "d.id", ctx.get());
+    Frame * expGroup = nullptr;
+    DenseMatrix<int64_t> * expGroupTid = nullptr;
+    groupJoin(expGroup, expGroupTid, dim, facts, "d.id", "f.id", "f.agg", ctx.get());
+    CHECK(dim->getKeyIndexes().empty());
+
+    // the index on the smaller input is built and kept, if enabled
+    userConfig->key_indexes = true;
+    Frame * res = nullptr;
+    innerJoin(res, facts, dim, factsOn, dimOn, 2, ctx.get());
+    REQUIRE(dim->getKeyIndex({0, 1}) != nullptr);
+    CHECK(facts->getKeyIndexes().empty());
+    CHECK(*res == *expLhs);
+    DataObjectFactory::destroy(res);
+    userConfig->key_indexes = false;
+
+    // the kept index of either input is probed
+    for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        res = nullptr;
+        innerJoin(res, facts, dim, factsOn, dimOn, 2, c);
+        CHECK(*res == *expLhs);
+        DataObjectFactory::destroy(res);
+        res = nullptr;
+        innerJoin(res, dim, facts, dimOn, factsOn, 2, c);
+        CHECK(*res == *expRhs);
+        DataObjectFactory::destroy(res);
+    }
+
+    // the semi-join and the group-join probe an index on the key column of the dimension
+    KeyIndexes::build(dim, {0}, ctx.get());
+    Frame * semi = nullptr;
+    DenseMatrix<int64_t> * semiTid = nullptr;
+    semiJoin(semi, semiTid, facts, dim, "f.id", "d.id", ctx.get());
+    CHECK(*semi == *expSemi);
+    CHECK(*semiTid == *expSemiTid);
+    Frame * group = nullptr;
+    DenseMatrix<int64_t> * groupTid = nullptr;
+    groupJoin(group, groupTid, dim, facts, "d.id", "f.id", "f.agg", ctx.get());
+    CHECK(*group == *expGroup);
+    CHECK(*groupTid == *expGroupTid);
+
+    DataObjectFactory::destroy(dim, facts, expLhs, expRhs, expSemi, expSemiTid, expGroup, expGroupTid);
+    DataObjectFactory::destroy(semi, semiTid, group, groupTid);
+}
+
+TEST_CASE("Point comparisons of a column look up its key index", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    auto dim = createDimension(300);
+    KeyIndexes::build(dim, {0}, ctx.get());
+    const Frame * cdim = dim;
+    auto col = cdim->getColumn<int64_t>(0);
+    REQUIRE(col->getKeyIndex(0) != nullptr);
+    const int64_t * id = col->getValues();
+
+    for(BinaryOpCode opCode : {BinaryOpCode::EQ, BinaryOpCode::NEQ}) {
+        for(int64_t v : {int64_t(17), int64_t(1000)}) {
+            BitMatrix * mask = nullptr;
+            ewBinaryObjSca(opCode, mask, col, v, ctx.get());
+            DenseMatrix<int64_t> * sel = nullptr;
+            ewBinaryObjSca(opCode, sel, col, v, ctx.get());
+            bool allEqual = true;
+            for(size_t r = 0; r < 300; r++) {
+                const bool exp = (id[r] == v) == (opCode == BinaryOpCode::EQ);
+                allEqual &= mask->get(r, 0) == exp && sel->get(r, 0) == int64_t(exp);
+            }
+            CHECK(allEqual);
+            const size_t numMatches = v == 17 ? 3 : 0;
+            CHECK(BitMask::count(mask, ctx.get()) == (opCode == BinaryOpCode::EQ ? numMatches : 300 - numMatches));
+            DataObjectFactory::destroy(mask, sel);
+        }
+    }
+
+    DataObjectFactory::destroy(dim, col);
+}
+
+TEST_CASE("Key indexes are stored next to Daphne binary files", TAG_KERNELS) {
+    const char * filename = "./test/runtime/local/kernels/KeyIndexesTest.dbdf";
+    const std::string idxFilename = std::string(filename) + DF_key_indexes_suffix;
+    auto dim = createDimension(300);
+    auto index = KeyIndexes::build(dim, {0, 1}, nullptr);
+
+    DF_options opts;
+    opts.keyIndexes = true;
+    writeDaphne(dim, filename, opts);
+    Frame * read = nullptr;
+    readDaphne(read, filename);
+    std::vector<DF_key_index> keyIndexes = readDaphneKeyIndexes(filename, read->getNumRows(), read->getNumCols());
+    REQUIRE(keyIndexes.size() == 1);
+    CHECK(keyIndexes[0].keyCols == std::vector<size_t>({0, 1}));
+    CHECK(keyIndexes[0].begins == index->getBegins());
+    CHECK(keyIndexes[0].rows == index->getRows());
+    KeyIndexes::restore(read, keyIndexes[0].keyCols, keyIndexes[0].begins, keyIndexes[0].rows);
+    CHECK(read->getKeyIndex({0, 1})->getNumKeys() == index->getNumKeys());
+
+    // the indexes of a frame of another size are not used
+    CHECK(readDaphneKeyIndexes(filename, 299, 3).empty());
+
+    // writing the frame without its indexes removes them
+    writeDaphne(dim, filename);
+    CHECK(readDaphneKeyIndexes(filename, 300, 3).empty());
+
+    std::remove(filename);
+    std::remove(idxFilename.c_str());
+    DataObjectFactory::destroy(dim, read);
+}
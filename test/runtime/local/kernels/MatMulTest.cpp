@@ -14,15 +14,25 @@
  * limitations under the License.
  */
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/BlockedMatrix.h>
+#include <runtime/local/datastructures/CompressedMatrix.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DenseMatrixCM.h>
+#include <runtime/local/kernels/CastObj.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/MatMul.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 template<class DT>
@@ -211,3 +221,436 @@ TEMPLATE_PRODUCT_TEST_CASE("MatMul Transposed", TAG_KERNELS, (DenseMatrix), (flo
     DataObjectFactory::destroy(m0, m1, m2, m3, m4, m5, v0, v1, v2, v3, v4, v5, v6);
 }
 
+
+// a matrix with about one non-zero in `period` cells, whose sums are exact in single precision
+template<typename VT>
+DenseMatrix<VT> * genSparse(size_t numRows, size_t numCols, size_t period, size_t seed) {
+    auto m = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const size_t h = (r * 7919 + c * 104729 + seed) % period;
+            m->set(r, c, h == 0 ? static_cast<VT>((r + c + seed) % 5) - 2 : 0);
+        }
+    return m;
+}
+
+template<typename VT>
+CSRMatrix<VT> * toCSR(const DenseMatrix<VT> * arg) {
+    size_t nnz = 0;
+    for(size_t r = 0; r < arg->getNumRows(); r++)
+        for(size_t c = 0; c < arg->getNumCols(); c++)
+            nnz += arg->get(r, c) != 0;
+    auto res = DataObjectFactory::create<CSRMatrix<VT>>(arg->getNumRows(), arg->getNumCols(), nnz, false);
+    size_t * rowOffsets = res->getRowOffsets();
+    rowOffsets[0] = 0;
+    for(size_t r = 0, pos = 0; r < arg->getNumRows(); r++) {
+        for(size_t c = 0; c < arg->getNumCols(); c++)
+            if(arg->get(r, c) != 0) {
+                res->getValues()[pos] = arg->get(r, c);
+                res->getColIdxs()[pos++] = c;
+            }
+        rowOffsets[r + 1] = pos;
+    }
+    return res;
+}
+
+template<class DTLhs, class DTRhs, class DTRes>
+void checkSparseMatMul(const DenseMatrix<typename DTRes::VT> * lhs, const DenseMatrix<typename DTRes::VT> * rhs,
+        bool transa, bool transb, DCTX(ctx)) {
+    using VT = typename DTRes::VT;
+    auto toDT = [](const DenseMatrix<VT> * m, auto * dummy) {
+        using DT = std::remove_pointer_t<decltype(dummy)>;
+        if constexpr(std::is_same_v<DT, CSRMatrix<VT>>)
+            return toCSR(m);
+        else if constexpr(std::is_same_v<DT, DCSRMatrix<VT>>) {
+            DCSRMatrix<VT> * res = nullptr;
+            castObj<DCSRMatrix<VT>, DenseMatrix<VT>>(res, m, nullptr);
+            return res;
+        }
+        else
+            return m;
+    };
+    auto l = toDT(lhs, static_cast<DTLhs *>(nullptr));
+    auto r = toDT(rhs, static_cast<DTRhs *>(nullptr));
+
+    DenseMatrix<VT> * exp = nullptr;
+    matMul(exp, lhs, rhs, transa, transb, nullptr);
+    DTRes * res = nullptr;
+    matMul(res, l, r, transa, transb, ctx);
+
+    REQUIRE(res->getNumRows() == exp->getNumRows());
+    REQUIRE(res->getNumCols() == exp->getNumCols());
+    bool equal = true;
+    for(size_t i = 0; i < exp->getNumRows(); i++)
+        for(size_t j = 0; j < exp->getNumCols(); j++)
+            equal = equal && res->get(i, j) == exp->get(i, j);
+    CHECK(equal);
+
+    if constexpr(!std::is_same_v<DTLhs, DenseMatrix<VT>>)
+        DataObjectFactory::destroy(l);
+    if constexpr(!std::is_same_v<DTRhs, DenseMatrix<VT>>)
+        DataObjectFactory::destroy(r);
+    DataObjectFactory::destroy(exp, res);
+}
+
+template<typename VT>
+void checkSparseMatMuls(size_t m, size_t k, size_t n, size_t period, DCTX(ctx)) {
+    using Dense = DenseMatrix<VT>;
+    using CSR = CSRMatrix<VT>;
+    for(bool transa : {false, true})
+        for(bool transb : {false, true}) {
+            auto lhs = transa ? genSparse<VT>(k, m, period, 1) : genSparse<VT>(m, k, period, 1);
+            auto rhs = transb ? genSparse<VT>(n, k, period, 2) : genSparse<VT>(k, n, period, 2);
+            checkSparseMatMul<CSR, Dense, Dense>(lhs, rhs, transa, transb, ctx);
+            checkSparseMatMul<Dense, CSR, Dense>(lhs, rhs, transa, transb, ctx);
+            checkSparseMatMul<CSR, CSR, CSR>(lhs, rhs, transa, transb, ctx);
+            checkSparseMatMul<DCSRMatrix<VT>, Dense, Dense>(lhs, rhs, transa, transb, ctx);
+            DataObjectFactory::destroy(lhs, rhs);
+        }
+}
+
+TEMPLATE_TEST_CASE("MatMul, sparse", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    checkSparseMatMuls<VT>(7, 5, 3, 3, nullptr);
+    checkSparseMatMuls<VT>(1, 9, 1, 2, nullptr);
+    // more than COL_BLOCK columns
+    checkSparseMatMuls<VT>(4, 20, 300, 4, nullptr);
+}
+
+TEMPLATE_TEST_CASE("MatMul, sparse, large, parallel", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    ParallelContext ctx;
+    checkSparseMatMuls<VT>(400, 300, 350, 10, ctx.get());
+}
+
+TEST_CASE("MatMul, sparse, pre-allocated sparse result", TAG_KERNELS) {
+    auto m = genGivenVals<CSRMatrix<double>>(2, {1, 0, 0, 1});
+    CSRMatrix<double> * res = m;
+    CHECK_THROWS(matMul(res, m, m, false, false, nullptr));
+    DataObjectFactory::destroy(m);
+}
+
+TEMPLATE_TEST_CASE("MatMul, sparse, repeated", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    auto lhsDense = genSparse<VT>(9, 7, 3, 1);
+    auto lhs = toCSR(lhsDense);
+    for(size_t n : {1, 3}) {
+        auto rhs = genSparse<VT>(7, n, 2, 2);
+        DenseMatrix<VT> * exp = nullptr;
+        matMul(exp, lhsDense, rhs, false, false, nullptr);
+        // the second product builds the SELL-C-sigma representation (vectors) or the compact column indexes (matrices)
+        // of lhs, the third one reuses them
+        for(size_t i = 0; i < 3; i++) {
+            DenseMatrix<VT> * res = nullptr;
+            matMul(res, lhs, rhs, false, false, nullptr);
+            CHECK(*res == *exp);
+            DataObjectFactory::destroy(res);
+        }
+        if(n > 1)
+            CHECK(lhs->getCachedCompactColIdxs() != nullptr);
+        DataObjectFactory::destroy(rhs, exp);
+    }
+    DataObjectFactory::destroy(lhsDense, lhs);
+}
+
+TEMPLATE_TEST_CASE("MatMul, sparse, SELL-C-sigma", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    // rows of very different lengths, and not a multiple of the slice height
+    const size_t numRows = 301;
+    const size_t numCols = 40;
+    auto lhsDense = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, true);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < (r * 7) % numCols; c += 1 + r % 3)
+            lhsDense->set(r, c, static_cast<VT>((r + c) % 7) - 3);
+    auto lhs = toCSR(lhsDense);
+    // rhs is also multiplied as a view with a row skip, and x[0] is infinite, which the padding must not read
+    auto rhsWide = genSparse<VT>(numCols, 2, 1, 3);
+    rhsWide->set(0, 0, std::numeric_limits<VT>::infinity());
+    auto rhsView = DataObjectFactory::create<DenseMatrix<VT>>(rhsWide, 0, numCols, 0, 1);
+    auto rhs = DataObjectFactory::create<DenseMatrix<VT>>(numCols, 1, false);
+    for(size_t r = 0; r < numCols; r++)
+        rhs->set(r, 0, rhsWide->get(r, 0));
+
+    for(const DenseMatrix<VT> * x : std::vector<const DenseMatrix<VT> *>{rhs, rhsView}) {
+        DenseMatrix<VT> * exp = nullptr;
+        matMul(exp, lhs, x, false, false, nullptr);
+        for(size_t i = 0; i < 2; i++) {
+            DenseMatrix<VT> * res = nullptr;
+            matMul(res, lhs, x, false, false, nullptr);
+            CHECK(*res == *exp);
+            DataObjectFactory::destroy(res);
+        }
+        DataObjectFactory::destroy(exp);
+    }
+    CHECK(lhs->getSell() != nullptr);
+
+    DataObjectFactory::destroy(lhsDense, lhs, rhsWide, rhsView, rhs);
+}
+
+// a matrix whose blocks of the given size are dense, sparse, or empty in turn
+template<typename VT>
+DenseMatrix<VT> * genBlocky(size_t numRows, size_t numCols, size_t blockSize, size_t seed) {
+    auto m = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const size_t kind = (r / blockSize + c / blockSize + seed) % 3;
+            const bool nonZero = kind == 0 || (kind == 1 && (r * 7919 + c * 104729 + seed) % 17 == 0);
+            m->set(r, c, nonZero ? static_cast<VT>((r + c + seed) % 5) - 2 : 0);
+        }
+    return m;
+}
+
+TEMPLATE_TEST_CASE("MatMul, ultra-sparse", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    // far fewer non-zeros than rows, the rows without any are zero in the result
+    const size_t numRows = 1000000;
+    auto lhs = DataObjectFactory::create<DCSRMatrix<VT>>(numRows, 4);
+    lhs->prepareAppend();
+    lhs->append(2, 1, VT(2));
+    lhs->append(2, 3, VT(-1));
+    lhs->append(777777, 0, VT(3));
+    lhs->finishAppend();
+    auto rhs = genGivenVals<DenseMatrix<VT>>(4, {
+        1, 2,
+        3, 4,
+        5, 6,
+        7, 8,
+    });
+
+    // the result is overwritten, also if it is pre-allocated
+    auto res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 2, false);
+    std::fill(res->getValues(), res->getValues() + numRows * 2, VT(9));
+    matMul(res, lhs, rhs, false, false, nullptr);
+    CHECK(res->get(2, 0) == VT(-1));
+    CHECK(res->get(2, 1) == VT(0));
+    CHECK(res->get(777777, 0) == VT(3));
+    CHECK(res->get(777777, 1) == VT(6));
+    VT sum = 0;
+    for(size_t i = 0; i < numRows * 2; i++)
+        sum += res->getValues()[i];
+    CHECK(sum == VT(8));
+
+    DataObjectFactory::destroy(lhs, rhs, res);
+}
+
+TEMPLATE_TEST_CASE("MatMul, compressed", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    // one-hot encoded, sorted, low-cardinality, continuous, and mostly non-zero columns
+    const size_t numRows = 600;
+    const size_t numCols = 7;
+    auto dense = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    for(size_t r = 0; r < numRows; r++) {
+        for(size_t c = 0; c < 3; c++)
+            dense->set(r, c, VT((r * 7919) % 4 == c));
+        dense->set(r, 3, VT(r * 4 / numRows));
+        dense->set(r, 4, VT((r * 13) % 5));
+        dense->set(r, 5, VT(r % 300));
+        dense->set(r, 6, r % 97 == 3 ? VT(1) : VT(5));
+    }
+    CompressedMatrix<VT> * compressed = nullptr;
+    castObj<CompressedMatrix<VT>, DenseMatrix<VT>>(compressed, dense, nullptr);
+    std::vector<ColGroupEncoding> encodings;
+    for(const auto & group : compressed->getColGroups())
+        encodings.push_back(group.encoding);
+    CHECK(encodings == std::vector<ColGroupEncoding>{ColGroupEncoding::DDC, ColGroupEncoding::RLE,
+            ColGroupEncoding::DDC, ColGroupEncoding::OLE, ColGroupEncoding::UNCOMPRESSED});
+
+    auto check = [&](const auto * lhs, const auto * rhs, const DenseMatrix<VT> * lhsDense,
+            const DenseMatrix<VT> * rhsDense, bool transa, bool transb) {
+        DenseMatrix<VT> * exp = nullptr;
+        matMul(exp, lhsDense, rhsDense, transa, transb, nullptr);
+        DenseMatrix<VT> * res = nullptr;
+        matMul(res, lhs, rhs, transa, transb, ctx.get());
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(exp, res);
+    };
+    // matrix-vector and vector-matrix products, and those with multiple columns
+    for(size_t n : {1, 3})
+        for(bool transa : {false, true})
+            for(bool transb : {false, true}) {
+                const size_t kRhs = transa ? numRows : numCols;
+                auto rhs = transb ? genSparse<VT>(n, kRhs, 1, 1) : genSparse<VT>(kRhs, n, 1, 1);
+                check(compressed, rhs, dense, rhs, transa, transb);
+                const size_t kLhs = transb ? numCols : numRows;
+                auto lhs = transa ? genSparse<VT>(kLhs, n, 1, 2) : genSparse<VT>(n, kLhs, 1, 2);
+                check(lhs, compressed, lhs, dense, transa, transb);
+                DataObjectFactory::destroy(lhs, rhs);
+            }
+
+    DataObjectFactory::destroy(dense, compressed);
+}
+
+TEMPLATE_TEST_CASE("MatMul, column-major", TAG_KERNELS, float, double, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    auto gen = [](size_t numRows, size_t numCols, size_t seed) {
+        auto m = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+        for(size_t r = 0; r < numRows; r++)
+            for(size_t c = 0; c < numCols; c++)
+                m->set(r, c, VT((r * 7 + c * 3 + seed) % 11) - VT(5));
+        return m;
+    };
+    auto toCM = [&](const DenseMatrix<VT> * m) {
+        DenseMatrixCM<VT> * cm = nullptr;
+        castObj<DenseMatrixCM<VT>, DenseMatrix<VT>>(cm, m, nullptr);
+        return cm;
+    };
+    // the product of the (transposed) dense operands, computed cell by cell
+    auto expected = [](const DenseMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, bool transa, bool transb) {
+        const size_t m = transa ? lhs->getNumCols() : lhs->getNumRows();
+        const size_t k = transa ? lhs->getNumRows() : lhs->getNumCols();
+        const size_t n = transb ? rhs->getNumRows() : rhs->getNumCols();
+        auto exp = DataObjectFactory::create<DenseMatrixCM<VT>>(m, n, false);
+        for(size_t i = 0; i < m; i++)
+            for(size_t j = 0; j < n; j++) {
+                VT sum = 0;
+                for(size_t l = 0; l < k; l++)
+                    sum += (transa ? lhs->get(l, i) : lhs->get(i, l)) * (transb ? rhs->get(j, l) : rhs->get(l, j));
+                exp->set(i, j, sum);
+            }
+        return exp;
+    };
+
+    const size_t m = 5;
+    const size_t k = 7;
+    for(size_t n : {1, 3})
+        for(bool transa : {false, true})
+            for(bool transb : {false, true}) {
+                auto lhs = transa ? gen(k, m, 1) : gen(m, k, 1);
+                auto rhs = transb ? gen(n, k, 2) : gen(k, n, 2);
+                auto lhsCM = toCM(lhs);
+                auto rhsCM = toCM(rhs);
+                auto exp = expected(lhs, rhs, transa, transb);
+
+                DenseMatrixCM<VT> * res = nullptr;
+                matMul(res, lhsCM, rhsCM, transa, transb, ctx.get());
+                CHECK(*res == *exp);
+                DataObjectFactory::destroy(res);
+                // a row-major operand is passed to BLAS as the transposed of a column-major one
+                res = nullptr;
+                matMul(res, lhs, rhsCM, transa, transb, ctx.get());
+                CHECK(*res == *exp);
+                DataObjectFactory::destroy(res);
+                res = nullptr;
+                matMul(res, lhsCM, rhs, transa, transb, ctx.get());
+                CHECK(*res == *exp);
+                DataObjectFactory::destroy(res);
+
+                DataObjectFactory::destroy(lhs, rhs, lhsCM, rhsCM, exp);
+            }
+}
+
+TEMPLATE_TEST_CASE("MatMul, blocked", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    ParallelContext ctx;
+    const size_t blockSize = 16;
+
+    for(auto [m, k, n] : {std::make_tuple(70, 50, 40), std::make_tuple(1, 33, 1), std::make_tuple(16, 16, 16)}) {
+        auto lhs = genBlocky<VT>(m, k, blockSize, 0);
+        auto rhs = genBlocky<VT>(k, n, blockSize, 1);
+        auto blockedLhs = DataObjectFactory::create<BlockedMatrix<VT>>(m, k, blockSize);
+        auto blockedRhs = DataObjectFactory::create<BlockedMatrix<VT>>(k, n, blockSize);
+        castObj<BlockedMatrix<VT>>(blockedLhs, lhs, nullptr);
+        castObj<BlockedMatrix<VT>>(blockedRhs, rhs, nullptr);
+
+        DenseMatrix<VT> * exp = nullptr;
+        matMul(exp, lhs, rhs, false, false, nullptr);
+        BlockedMatrix<VT> * res = nullptr;
+        matMul(res, blockedLhs, blockedRhs, false, false, ctx.get());
+        DenseMatrix<VT> * resDense = nullptr;
+        castObj<DenseMatrix<VT>>(resDense, res, nullptr);
+        CHECK(*resDense == *exp);
+
+        DataObjectFactory::destroy(lhs, rhs, blockedLhs, blockedRhs, exp, res, resDense);
+    }
+
+    auto a = DataObjectFactory::create<BlockedMatrix<VT>>(4, 4, 2);
+    auto b = DataObjectFactory::create<BlockedMatrix<VT>>(4, 4, 4);
+    BlockedMatrix<VT> * res = nullptr;
+    CHECK_THROWS(matMul(res, a, b, false, false, nullptr));
+    CHECK_THROWS(matMul(res, a, a, true, false, nullptr));
+    DataObjectFactory::destroy(a, b);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("MatMul Static Shape", TAG_KERNELS, (DenseMatrix), (float, double)) {
+    using DT = TestType;
+
+    auto m0 = genGivenVals<DT>(3, {
+        1, 2, 3,
+        3, 1, 2,
+        2, 3, 1,
+    });
+    auto m1 = genGivenVals<DT>(3, {
+        13, 13, 10,
+        10, 13, 13,
+        13, 10, 13,
+    });
+    auto m2 = genGivenVals<DT>(2, {
+        1, 0, 3, 0,
+        0, 0, 2, 0,
+    });
+    auto m3 = genGivenVals<DT>(4, {
+        0, 1,
+        2, 0,
+        1, 1,
+        0, 0,
+    });
+    auto m4 = genGivenVals<DT>(2, {
+        3, 4,
+        2, 2,
+    });
+    auto m5 = genGivenVals<DT>(4, {
+        1, 0, 3, 0,
+        0, 0, 0, 0,
+        3, 0, 13, 0,
+        0, 0, 0, 0,
+    });
+
+    DT * res = nullptr;
+    matMul<3, 3, 3, DT, DT, DT>(res, m0, m0, false, false, nullptr);
+    CHECK(*res == *m1);
+    DataObjectFactory::destroy(res);
+
+    res = nullptr;
+    matMul<2, 4, 2, DT, DT, DT>(res, m2, m3, false, false, nullptr);
+    CHECK(*res == *m4);
+    DataObjectFactory::destroy(res);
+
+    res = nullptr;
+    matMul<4, 2, 4, DT, DT, DT>(res, m2, m2, true, false, nullptr);
+    CHECK(*res == *m5);
+    DataObjectFactory::destroy(res);
+
+    DataObjectFactory::destroy(m0, m1, m2, m3, m4, m5);
+}
+
+TEMPLATE_TEST_CASE("MatMul, small and large shapes agree", TAG_KERNELS, float, double) {
+    using DT = DenseMatrix<TestType>;
+
+    // 20x20x20 is multiplied by the loops of MatMulSmall, 30x30x30 by BLAS
+    for(size_t n : {1, 3, 20, 30}) {
+        auto lhs = DataObjectFactory::create<DT>(n, n, false);
+        auto rhs = DataObjectFactory::create<DT>(n, n, false);
+        for(size_t i = 0; i < n * n; i++) {
+            lhs->getValues()[i] = static_cast<TestType>(i % 7);
+            rhs->getValues()[i] = static_cast<TestType>(i % 5) - 2;
+        }
+        for(bool transa : {false, true})
+            for(bool transb : {false, true}) {
+                auto exp = DataObjectFactory::create<DT>(n, n, false);
+                for(size_t i = 0; i < n; i++)
+                    for(size_t j = 0; j < n; j++) {
+                        TestType acc = 0;
+                        for(size_t l = 0; l < n; l++)
+                            acc += (transa ? lhs->get(l, i) : lhs->get(i, l)) * (transb ? rhs->get(j, l) : rhs->get(l, j));
+                        exp->set(i, j, acc);
+                    }
+                checkMatMul(lhs, rhs, exp, transa, transb);
+                DataObjectFactory::destroy(exp);
+            }
+        DataObjectFactory::destroy(lhs, rhs);
+    }
+}
@@ -22,8 +22,10 @@
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/NumDistinctApprox.h>
+#include <runtime/local/kernels/NumDistinctApproxHll.h>
 #include <runtime/local/kernels/RandMatrix.h>
 #include <stdexcept>
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 #include <catch.hpp>
 
@@ -187,3 +189,56 @@ TEMPLATE_PRODUCT_TEST_CASE("numDistinctApprox - CSR-Submatrix", TAG_KERNELS, (CS
     // wrong parametriced (K to small) or the algorithm broke.
     CHECK(Approx(approxResult).epsilon(1e-1) == expectedNumDistinct);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("numDistinctApproxHll", TAG_KERNELS, (DenseMatrix, CSRMatrix), (double, uint32_t)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    SECTION("few distinct values") {
+        std::vector<VT> v(10000, 0);
+        for(size_t i = 0; i < 100; i++)
+            v[i * 37] = VT(i + 1);
+        auto m = genGivenVals<DT>(100, v);
+        CHECK(Approx(numDistinctApproxHll(m, 12, 1234567890, nullptr)).epsilon(2e-2) == 101);
+        DataObjectFactory::destroy(m);
+    }
+
+    SECTION("many distinct values, parallel") {
+        const size_t numDistinct = 100000;
+        std::vector<VT> v(4 * numDistinct);
+        for(size_t i = 0; i < v.size(); i++)
+            v[i] = VT((i * 7919) % numDistinct + 1);
+        auto m = genGivenVals<DT>(v.size() / 100, v);
+        CHECK(Approx(numDistinctApproxHll(m, 14, 1234567890, nullptr)).epsilon(5e-2) == numDistinct);
+        // the same sketch with the chunks on the worker pool
+        checkParallelEqualsSequential([&](DCTX(ctx)) { return numDistinctApproxHll(m, 14, 1234567890, ctx); });
+        DataObjectFactory::destroy(m);
+    }
+}
+
+TEST_CASE("numDistinctApproxHll - merged sketches", TAG_KERNELS) {
+    using DT = DenseMatrix<int64_t>;
+
+    std::vector<int64_t> v1(20000), v2(20000);
+    for(size_t i = 0; i < v1.size(); i++) {
+        v1[i] = i;
+        v2[i] = i + 10000;
+    }
+    auto m1 = genGivenVals<DT>(200, v1);
+    auto m2 = genGivenVals<DT>(200, v2);
+
+    HyperLogLog hll1, hll2;
+    numDistinctApproxHllSketch(hll1, m1, 42, nullptr);
+    numDistinctApproxHllSketch(hll2, m2, 42, nullptr);
+    // e.g., the sketch of another worker
+    HyperLogLog received(hll2.getRegisters());
+    hll1.merge(received);
+    CHECK(Approx(hll1.estimate()).epsilon(5e-2) == 30000);
+
+    CHECK_THROWS(hll1.merge(HyperLogLog(10)));
+    CHECK_THROWS(HyperLogLog(std::vector<uint8_t>(100)));
+    CHECK_THROWS(HyperLogLog(2));
+    CHECK(HyperLogLog().estimate() == 0);
+
+    DataObjectFactory::destroy(m1, m2);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/OneHot.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdint>
+
+TEMPLATE_PRODUCT_TEST_CASE("OneHot", TAG_KERNELS, (DenseMatrix, CSRMatrix), (double, int64_t)) {
+    using DTRes = TestType;
+    using VT = typename DTRes::VT;
+    using DTArg = DenseMatrix<VT>;
+    
+    auto arg = genGivenVals<DTArg>(3, {
+        5, 0, 2,
+        0, 1, 0,
+        7, 2, 1,
+    });
+    // the first column is retained, the others are encoded
+    auto info = genGivenVals<DenseMatrix<int64_t>>(1, {-1, 3, 3});
+    
+    DTRes * res = nullptr;
+    SECTION("valid codes") {
+        auto exp = genGivenVals<DTRes>(3, {
+            5, 1, 0, 0, 0, 0, 1,
+            0, 0, 1, 0, 1, 0, 0,
+            7, 0, 0, 1, 0, 1, 0,
+        });
+        oneHot<DTRes, DTArg>(res, arg, info, nullptr);
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(exp, res);
+    }
+    SECTION("invalid code") {
+        // the codes 1 and 2 of the last column exceed its number of distinct values
+        auto info2 = genGivenVals<DenseMatrix<int64_t>>(1, {-1, 3, 1});
+        CHECK_THROWS(oneHot<DTRes, DTArg>(res, arg, info2, nullptr));
+        if(res)
+            DataObjectFactory::destroy(res);
+        DataObjectFactory::destroy(info2);
+    }
+    SECTION("invalid info") {
+        auto info2 = genGivenVals<DenseMatrix<int64_t>>(1, {-1, 0, 2});
+        CHECK_THROWS(oneHot<DTRes, DTArg>(res, arg, info2, nullptr));
+        DataObjectFactory::destroy(info2);
+    }
+    
+    DataObjectFactory::destroy(arg, info);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("OneHot - in parallel", TAG_KERNELS, (DenseMatrix, CSRMatrix), (double)) {
+    using DTRes = TestType;
+    using VT = typename DTRes::VT;
+    using DTArg = DenseMatrix<VT>;
+    
+    ParallelContext ctx;
+    
+    const size_t numRows = 10000;
+    const size_t numDistinct = 7;
+    auto arg = DataObjectFactory::create<DTArg>(numRows, 2, false);
+    auto exp = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1 + numDistinct, true);
+    for(size_t r = 0; r < numRows; r++) {
+        arg->set(r, 0, VT(r % 3));
+        arg->set(r, 1, VT(r % numDistinct));
+        exp->set(r, 0, VT(r % 3));
+        exp->set(r, 1 + r % numDistinct, 1);
+    }
+    auto info = genGivenVals<DenseMatrix<int64_t>>(1, {-1, static_cast<int64_t>(numDistinct)});
+    
+    DTRes * res = nullptr;
+    oneHot<DTRes, DTArg>(res, arg, info, ctx.get());
+    REQUIRE(res->getNumRows() == numRows);
+    REQUIRE(res->getNumCols() == 1 + numDistinct);
+    size_t numMismatches = 0;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < 1 + numDistinct; c++)
+            numMismatches += res->get(r, c) != exp->get(r, c);
+    CHECK(numMismatches == 0);
+    
+    DataObjectFactory::destroy(arg, exp, info, res);
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
@@ -21,11 +22,17 @@
 #include <runtime/local/kernels/Order.h>
 #include <runtime/local/kernels/CheckEq.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 #include <catch.hpp>
 
+#include <algorithm>
+#include <numeric>
+#include <utility>
 #include <vector>
 
+#include <cstdint>
+
 TEMPLATE_TEST_CASE("Order", TAG_KERNELS, (Frame)) {
     using VT0 = double;
     using VT1 = float;
@@ -224,4 +231,68 @@ TEMPLATE_PRODUCT_TEST_CASE("Order", TAG_KERNELS, (DenseMatrix), (double, float))
     DataObjectFactory::destroy(expMatrix);
     DataObjectFactory::destroy(resIdxs);
     DataObjectFactory::destroy(expIdxs);
-}
\ No newline at end of file
+}
+TEST_CASE("Order, large, parallel", TAG_KERNELS) {
+    const size_t numRows = 200000;
+    auto c0 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    auto c1 = DataObjectFactory::create<DenseMatrix<float>>(numRows, 1, false);
+    auto c2 = DataObjectFactory::create<DenseMatrix<uint32_t>>(numRows, 1, false);
+    for(size_t r = 0; r < numRows; r++) {
+        c0->getValues()[r] = static_cast<int64_t>((r * 7919) % 1001) - 500;
+        c1->getValues()[r] = (r % 3 == 0) ? -0.0f : static_cast<float>((r * 31) % 7) - 3.5f;
+        c2->getValues()[r] = static_cast<uint32_t>((r * 104729) % 13) * 400000000u;
+    }
+    std::vector<Structure *> cols = {c0, c1, c2};
+    auto arg = DataObjectFactory::create<Frame>(cols, nullptr);
+
+    size_t colIdxs[] = {1, 0, 2};
+    bool ascending[] = {false, true, false};
+
+    // the order of a stable sort comparing the values
+    std::vector<size_t> exp(numRows);
+    std::iota(exp.begin(), exp.end(), 0);
+    const int64_t * v0 = c0->getValues();
+    const float * v1 = c1->getValues();
+    const uint32_t * v2 = c2->getValues();
+    std::stable_sort(exp.begin(), exp.end(), [&](size_t i, size_t j) {
+        if(v1[i] != v1[j])
+            return v1[i] > v1[j];
+        if(v0[i] != v0[j])
+            return v0[i] < v0[j];
+        return v2[i] > v2[j];
+    });
+    std::vector<std::pair<size_t, size_t>> expGroups;
+    for(size_t first = 0; first < numRows; ) {
+        size_t next = first + 1;
+        while(next < numRows && v0[exp[next]] == v0[exp[first]] && v1[exp[next]] == v1[exp[first]]
+                && v2[exp[next]] == v2[exp[first]])
+            next++;
+        if(next - first > 1)
+            expGroups.emplace_back(first, next);
+        first = next;
+    }
+
+    ParallelContext ctx;
+    for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        DenseMatrix<size_t> * resIdxs = nullptr;
+        std::vector<std::pair<size_t, size_t>> groups;
+        order(resIdxs, arg, colIdxs, 3, ascending, 3, true, c, &groups);
+        CHECK(std::equal(exp.begin(), exp.end(), resIdxs->getValues()));
+        CHECK(groups == expGroups);
+        DataObjectFactory::destroy(resIdxs);
+    }
+
+    // a matrix of a single column of int64_t
+    DenseMatrix<size_t> * resIdxs = nullptr;
+    size_t colIdx = 0;
+    bool asc = true;
+    order(resIdxs, c0, &colIdx, 1, &asc, 1, true, ctx.get());
+    std::vector<size_t> exp0(numRows);
+    std::iota(exp0.begin(), exp0.end(), 0);
+    std::stable_sort(exp0.begin(), exp0.end(), [&](size_t i, size_t j) { return v0[i] < v0[j]; });
+    CHECK(std::equal(exp0.begin(), exp0.end(), resIdxs->getValues()));
+
+    DataObjectFactory::destroy(resIdxs);
+    DataObjectFactory::destroy(arg);
+    DataObjectFactory::destroy(c0, c1, c2);
+}
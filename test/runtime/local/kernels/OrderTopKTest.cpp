@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/Order.h>
+#include <runtime/local/kernels/OrderTopK.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+#include <catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <cstdint>
+
+TEST_CASE("OrderTopK, small", TAG_KERNELS) {
+    auto arg = genGivenVals<DenseMatrix<double>>(6, {
+        3, 1,
+        1, 2,
+        3, 0,
+        2, 5,
+        1, 1,
+        3, 1,
+    });
+    size_t colIdxs[] = {0, 1};
+    bool ascending[] = {false, true};
+
+    DenseMatrix<size_t> * resIdxs = nullptr;
+    orderTopK(resIdxs, arg, colIdxs, 2, ascending, 2, true, 4, nullptr);
+    auto expIdxs = genGivenVals<DenseMatrix<size_t>>(4, {2, 0, 5, 3});
+    CHECK(*resIdxs == *expIdxs);
+
+    DenseMatrix<double> * res = nullptr;
+    orderTopK(res, arg, colIdxs, 2, ascending, 2, false, 10, nullptr);
+    DenseMatrix<double> * exp = nullptr;
+    order(exp, arg, colIdxs, 2, ascending, 2, false, nullptr);
+    CHECK(*res == *exp);
+
+    DenseMatrix<size_t> * none = nullptr;
+    orderTopK(none, arg, colIdxs, 2, ascending, 2, true, 0, nullptr);
+    CHECK(none->getNumRows() == 0);
+
+    DataObjectFactory::destroy(arg, resIdxs, expIdxs, res, exp, none);
+}
+
+TEST_CASE("OrderTopK, large, parallel", TAG_KERNELS) {
+    const size_t numRows = 200000;
+    auto c0 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    auto c1 = DataObjectFactory::create<DenseMatrix<double>>(numRows, 1, false);
+    for(size_t r = 0; r < numRows; r++) {
+        c0->getValues()[r] = static_cast<int64_t>((r * 7919) % 100003) - 50000;
+        c1->getValues()[r] = static_cast<double>((r * 31) % 7);
+    }
+    std::vector<Structure *> cols = {c0, c1};
+    auto arg = DataObjectFactory::create<Frame>(cols, nullptr);
+
+    ParallelContext ctx;
+
+    for(bool asc : {true, false}) {
+        size_t colIdxs[] = {0, 1};
+        bool ascending[] = {asc, !asc};
+        DenseMatrix<size_t> * exp = nullptr;
+        order(exp, arg, colIdxs, 2, ascending, 2, true, nullptr);
+        for(size_t k : {1, 10, 1000}) {
+            for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+                DenseMatrix<size_t> * resIdxs = nullptr;
+                orderTopK(resIdxs, arg, colIdxs, 2, ascending, 2, true, k, c);
+                REQUIRE(resIdxs->getNumRows() == k);
+                CHECK(std::equal(resIdxs->getValues(), resIdxs->getValues() + k, exp->getValues()));
+                DataObjectFactory::destroy(resIdxs);
+            }
+        }
+        DataObjectFactory::destroy(exp);
+    }
+
+    // the rows of a frame, and of a matrix with duplicate keys
+    size_t colIdx = 1;
+    bool asc = true;
+    Frame * res = nullptr;
+    orderTopK(res, arg, &colIdx, 1, &asc, 1, false, 5, ctx.get());
+    REQUIRE(res->getNumRows() == 5);
+    for(size_t r = 0; r < 5; r++) {
+        CHECK(res->getColumn<double>(1)->get(r, 0) == 0);
+        CHECK(res->getColumn<int64_t>(0)->get(r, 0) == c0->get(7 * r, 0));
+    }
+    DenseMatrix<size_t> * resIdxs = nullptr;
+    size_t colIdxMat = 0;
+    orderTopK(resIdxs, c1, &colIdxMat, 1, &asc, 1, true, 5, ctx.get());
+    auto expIdxs = genGivenVals<DenseMatrix<size_t>>(5, {0, 7, 14, 21, 28});
+    CHECK(*resIdxs == *expIdxs);
+    DataObjectFactory::destroy(expIdxs);
+    DataObjectFactory::destroy(res, resIdxs, arg, c0, c1);
+}
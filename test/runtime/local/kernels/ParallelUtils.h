@@ -0,0 +1,66 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_RUNTIME_LOCAL_KERNELS_PARALLELUTILS_H
+#define TEST_RUNTIME_LOCAL_KERNELS_PARALLELUTILS_H
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/kernels/CheckEq.h>
+
+#include <catch.hpp>
+
+#include <type_traits>
+
+/**
+ * @brief A context with the default user config, on whose worker pool the kernels run their chunks, like `daphne`
+ * without `--num-threads`.
+ */
+class ParallelContext {
+    DaphneUserConfig userConfig{};
+    DaphneContext ctx{userConfig};
+
+public:
+    DaphneContext * get() {
+        return &ctx;
+    }
+};
+
+/**
+ * @brief Checks that a kernel computes the same result with a `ParallelContext` as sequentially, i.e., without a
+ * context.
+ *
+ * @tparam DTRes The data type of the result of the kernel, or `void` if the kernel returns a scalar.
+ * @param kernel Calls the kernel with the given context, as `kernel(res, ctx)` storing the result into `res` for a
+ * data type `DTRes`, or as `kernel(ctx)` returning the scalar result otherwise.
+ */
+template<class DTRes = void, typename Kernel>
+void checkParallelEqualsSequential(Kernel kernel) {
+    ParallelContext ctx;
+    if constexpr(std::is_void_v<DTRes>)
+        CHECK(kernel(ctx.get()) == kernel(nullptr));
+    else {
+        DTRes * exp = nullptr;
+        DTRes * res = nullptr;
+        kernel(exp, nullptr);
+        kernel(res, ctx.get());
+        CHECK(*res == *exp);
+        DataObjectFactory::destroy(exp, res);
+    }
+}
+
+#endif //TEST_RUNTIME_LOCAL_KERNELS_PARALLELUTILS_H
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/QuantileApprox.h>
+#include <util/KllSketch.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("quantileApprox", TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    // a permutation of 0, ..., n - 1 in the first column, and its squares in the second one
+    const size_t n = 1000000;
+    std::vector<VT> v(2 * n);
+    for(size_t i = 0; i < n; i++) {
+        const size_t x = (i * 7919) % n;
+        v[2 * i] = VT(x);
+        v[2 * i + 1] = VT(x) * VT(x) / VT(n);
+    }
+    auto m = genGivenVals<DenseMatrix<VT>>(n, v);
+
+    for(double q : {0.0, 0.01, 0.25, 0.5, 0.9, 1.0}) {
+        DenseMatrix<double> * res = nullptr;
+        quantileApprox(res, m, q, ctx.get());
+        REQUIRE(res->getNumRows() == 1);
+        REQUIRE(res->getNumCols() == 2);
+        // within 2% of the rank
+        CHECK(std::abs(res->get(0, 0) / n - q) < 0.02);
+        CHECK(std::abs(std::sqrt(res->get(0, 1) / n) - q) < 0.02);
+        DataObjectFactory::destroy(res);
+        checkParallelEqualsSequential<DenseMatrix<double>>([&](DenseMatrix<double> *& r, DCTX(c)) {
+            quantileApprox(r, m, q, c);
+        });
+    }
+    CHECK_THROWS_AS(([&]() { DenseMatrix<double> * res = nullptr; quantileApprox(res, m, 1.5, nullptr); })(),
+            std::runtime_error);
+
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("quantileApprox of a frame", TAG_KERNELS) {
+    ValueTypeCode schema[] = {ValueTypeCode::SI32, ValueTypeCode::F64};
+    std::string labels[] = {"a", "b"};
+    auto f = DataObjectFactory::create<Frame>(101, 2, schema, labels, false);
+    auto a = static_cast<int32_t *>(f->getColumnRaw(0));
+    auto b = static_cast<double *>(f->getColumnRaw(1));
+    for(size_t r = 0; r < 101; r++) {
+        a[r] = int32_t(100 - r);
+        // the missing values are ignored
+        b[r] = r % 2 ? std::numeric_limits<double>::quiet_NaN() : double(r);
+    }
+    DenseMatrix<double> * res = nullptr;
+    quantileApprox(res, f, 0.5, nullptr);
+    // few values are exact
+    CHECK(res->get(0, 0) == 50);
+    CHECK(res->get(0, 1) == 50);
+
+    ValueTypeCode schemaStr[] = {ValueTypeCode::STR};
+    std::string labelsStr[] = {"s"};
+    auto fStr = DataObjectFactory::create<Frame>(1, 1, schemaStr, labelsStr, false);
+    DenseMatrix<double> * resStr = nullptr;
+    CHECK_THROWS_AS(quantileApprox(resStr, fStr, 0.5, nullptr), std::runtime_error);
+
+    DataObjectFactory::destroy(f, res, fStr);
+}
+
+TEST_CASE("KllSketch - merged and received sketches", TAG_KERNELS) {
+    // the sketches of two workers, of overlapping ranges
+    KllSketch s1, s2(KllSketch::DEFAULT_K, 1);
+    for(int64_t i = 0; i < 300000; i++) {
+        s1.add(double(i));
+        s2.add(double(i + 100000));
+    }
+    KllSketch received(s2.getState());
+    CHECK(received.getN() == s2.getN());
+    CHECK(received.quantile(0.5) == s2.quantile(0.5));
+    s1.merge(received);
+    CHECK(s1.getN() == 600000);
+    CHECK(s1.getMin() == 0);
+    CHECK(s1.getMax() == 399999);
+    // the values from 100000 to 299999 are counted twice
+    CHECK(std::abs(s1.rank(100000) - 1.0 / 6) < 0.02);
+    CHECK(std::abs(s1.rank(300000) - 5.0 / 6) < 0.02);
+    const std::vector<double> bounds = s1.equiDepthBounds(4);
+    REQUIRE(bounds.size() == 3);
+    CHECK(std::abs(s1.rank(bounds[1]) - 0.5) < 0.02);
+
+    CHECK_THROWS(s1.merge(KllSketch(100)));
+    CHECK_THROWS(KllSketch(2));
+    CHECK_THROWS(KllSketch(std::vector<double>{200, 5, 0, 1, 1, 4, 0, 1, 2, 3}));
+    CHECK(std::isnan(KllSketch().quantile(0.5)));
+}
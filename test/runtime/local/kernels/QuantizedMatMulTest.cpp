@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/kernels/Quantize.h>
+#include <runtime/local/kernels/QuantizedMatMul.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+#include <catch.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+TEST_CASE("QuantizedMatMul, small", TAG_KERNELS) {
+    auto lhs = genGivenVals<DenseMatrix<float>>(2, {
+        0, 1,
+        -1, 2,
+    });
+    auto rhs = genGivenVals<DenseMatrix<float>>(2, {
+        1, 0, 2,
+        0.5, -1, 1,
+    });
+    DenseMatrix<uint8_t> * lhsQ = nullptr;
+    DenseMatrix<uint8_t> * rhsQ = nullptr;
+    quantize(lhsQ, lhs, -1, 2, nullptr);
+    quantize(rhsQ, rhs, -1, 2, nullptr);
+
+    DenseMatrix<float> * res = nullptr;
+    quantizedMatMul(res, lhsQ, rhsQ, -1, 2, -1, 2, nullptr);
+    REQUIRE(res->getNumRows() == 2);
+    REQUIRE(res->getNumCols() == 3);
+    // the product of the real values up to the precision of the quantization
+    const float exp[2][3] = {{0.5, -1, 1}, {0, -2, 0}};
+    for(size_t r = 0; r < 2; r++)
+        for(size_t c = 0; c < 3; c++)
+            CHECK(res->get(r, c) == Approx(exp[r][c]).margin(0.05));
+
+    DataObjectFactory::destroy(lhs, rhs, lhsQ, rhsQ, res);
+}
+
+TEST_CASE("QuantizedMatMul, exact accumulators", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    // sizes not a multiple of the blocks, groups of rows, and chunks
+    const size_t m = 130;
+    const size_t k = 37;
+    const size_t n = 301;
+    auto lhs = DataObjectFactory::create<DenseMatrix<uint8_t>>(m, k, false);
+    auto rhs = DataObjectFactory::create<DenseMatrix<uint8_t>>(k, n, false);
+    for(size_t r = 0; r < m; r++)
+        for(size_t c = 0; c < k; c++)
+            lhs->set(r, c, static_cast<uint8_t>((r * 31 + c * 7) % 256));
+    for(size_t r = 0; r < k; r++)
+        for(size_t c = 0; c < n; c++)
+            rhs->set(r, c, static_cast<uint8_t>((r * 13 + c * 5 + 3) % 256));
+
+    float lhsScale, rhsScale;
+    uint8_t lhsZero, rhsZero;
+    calc_quantization_params(-1, 3, lhsScale, lhsZero);
+    calc_quantization_params(-2, 0.5, rhsScale, rhsZero);
+
+    DenseMatrix<int32_t> * acc = nullptr;
+    DenseMatrix<float> * res = nullptr;
+    quantizedMatMul(acc, lhs, rhs, -1, 3, -2, 0.5, ctx.get());
+    quantizedMatMul(res, lhs, rhs, -1, 3, -2, 0.5, ctx.get());
+
+    bool exact = true;
+    bool dequantized = true;
+    for(size_t r = 0; r < m; r++)
+        for(size_t c = 0; c < n; c++) {
+            int64_t exp = 0;
+            for(size_t i = 0; i < k; i++)
+                exp += (int64_t(lhs->get(r, i)) - lhsZero) * (int64_t(rhs->get(i, c)) - rhsZero);
+            exact = exact && acc->get(r, c) == exp;
+            dequantized = dequantized && res->get(r, c) == lhsScale * rhsScale * static_cast<float>(exp);
+        }
+    CHECK(exact);
+    CHECK(dequantized);
+
+    DataObjectFactory::destroy(lhs, rhs, acc, res);
+}
+
+TEST_CASE("QuantizedMatMul, invalid shapes", TAG_KERNELS) {
+    auto lhs = DataObjectFactory::create<DenseMatrix<uint8_t>>(2, 3, true);
+    auto rhs = DataObjectFactory::create<DenseMatrix<uint8_t>>(2, 3, true);
+    DenseMatrix<float> * res = nullptr;
+    CHECK_THROWS(quantizedMatMul(res, lhs, rhs, 0, 1, 0, 1, nullptr));
+    DataObjectFactory::destroy(lhs, rhs);
+}
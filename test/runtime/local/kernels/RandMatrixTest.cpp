@@ -19,6 +19,7 @@
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/RandMatrix.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
@@ -63,3 +64,34 @@ TEMPLATE_PRODUCT_TEST_CASE("RandMatrix", TAG_KERNELS, (DenseMatrix, CSRMatrix),
     }
 }
 
+
+TEMPLATE_TEST_CASE("RandMatrix, reproducible in parallel", TAG_KERNELS, double, int64_t) {
+    using VT = TestType;
+    // enough cells for several blocks, with rows not aligned to them
+    const size_t numRows = 5000;
+    const size_t numCols = 33;
+    ParallelContext ctx;
+
+    for(double sparsity : {0.01, 0.3, 0.9}) {
+        DYNAMIC_SECTION("sparsity = " << sparsity) {
+            // the same cells for any number of threads
+            checkParallelEqualsSequential<DenseMatrix<VT>>([&](DenseMatrix<VT> *& res, DCTX(c)) {
+                randMatrix<DenseMatrix<VT>, VT>(res, numRows, numCols, 1, 9, sparsity, 42, c);
+            });
+
+            // and in both representations
+            DenseMatrix<VT> * dense = nullptr;
+            CSRMatrix<VT> * csr = nullptr;
+            randMatrix<DenseMatrix<VT>, VT>(dense, numRows, numCols, 1, 9, sparsity, 42, nullptr);
+            randMatrix<CSRMatrix<VT>, VT>(csr, numRows, numCols, 1, 9, sparsity, 42, ctx.get());
+            bool equal = true;
+            for(size_t r = 0; r < numRows; r++)
+                for(size_t c = 0; c < numCols; c++)
+                    equal = equal && dense->get(r, c) == csr->get(r, c);
+            CHECK(equal);
+            CHECK(csr->getNumNonZeros() == size_t(round(sparsity * numRows * numCols)));
+
+            DataObjectFactory::destroy(dense, csr);
+        }
+    }
+}
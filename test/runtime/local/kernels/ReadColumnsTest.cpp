@@ -0,0 +1,75 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/ReadColumns.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+
+TEST_CASE("ReadColumns, not a Parquet file", TAG_KERNELS) {
+    const char * columns[] = {"column_1"};
+    Frame * res = nullptr;
+    CHECK_THROWS_AS(readColumns(res, "./test/runtime/local/io/ReadCsv1.csv", columns, 1,
+                                nullptr, 0, nullptr, 0, nullptr, 0, nullptr), std::runtime_error);
+}
+
+#ifdef USE_ARROW
+
+TEST_CASE("ReadColumns, Parquet, subset of the columns", TAG_KERNELS) {
+    const char filename[] = "./test/runtime/local/io/ReadParquet1.parquet";
+    const char * columns[] = {"column_3", "column_1"};
+    Frame * res = nullptr;
+
+    SECTION("no predicates") {
+        readColumns(res, filename, columns, 2, nullptr, 0, nullptr, 0, nullptr, 0, nullptr);
+
+        REQUIRE(res->getNumRows() == 2);
+        REQUIRE(res->getNumCols() == 2);
+        CHECK(res->getLabels()[0] == "column_3");
+        CHECK(res->getLabels()[1] == "column_1");
+        CHECK(res->getColumn<double>(0)->get(0, 0) == 0.1);
+        CHECK(res->getColumn<double>(0)->get(1, 0) == 6.22216);
+        CHECK(res->getColumn<double>(1)->get(0, 0) == -0.1);
+        CHECK(res->getColumn<double>(1)->get(1, 0) == 3.14);
+    }
+    SECTION("a predicate no row satisfies") {
+        const char * predColumns[] = {"column_2"};
+        CompareOperation predCmps[] = {CompareOperation::GreaterThan};
+        double predValues[] = {100};
+        readColumns(res, filename, columns, 2, predColumns, 1, predCmps, 1, predValues, 1, nullptr);
+
+        CHECK(res->getNumRows() == 0);
+        CHECK(res->getNumCols() == 2);
+    }
+
+    DataObjectFactory::destroy(res);
+}
+
+#else
+
+TEST_CASE("ReadColumns, Parquet without Arrow", TAG_KERNELS) {
+    const char * columns[] = {"column_1"};
+    Frame * res = nullptr;
+    CHECK_THROWS_AS(readColumns(res, "./test/runtime/local/io/ReadParquet1.parquet", columns, 1,
+                                nullptr, 0, nullptr, 0, nullptr, 0, nullptr), std::runtime_error);
+}
+
+#endif
@@ -14,17 +14,27 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datagen/GenGivenVals.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/AsyncReads.h>
+#include <runtime/local/kernels/PrefetchRead.h>
 #include <runtime/local/kernels/Read.h>
+#include <runtime/local/kernels/Write.h>
 
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <memory>
+#include <stdexcept>
+#include <string>
+
 #include <cstdint>
+#include <cstdio>
 
 TEMPLATE_PRODUCT_TEST_CASE("Read CSV", TAG_KERNELS, (DenseMatrix), (double)) {
     using DT = TestType;
@@ -97,3 +107,78 @@ TEST_CASE("Read - Frame", TAG_KERNELS) {
     DataObjectFactory::destroy(c0);
     DataObjectFactory::destroy(c1);
 }
+
+TEST_CASE("Read - prefetched", TAG_KERNELS) {
+    DaphneUserConfig userConfig{};
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    const char filename[] = "./test/runtime/local/io/ReadCsv1.csv";
+    const auto dense = static_cast<int64_t>(AsyncReadDataType::DenseMatrix);
+    const auto f64 = static_cast<int64_t>(ValueTypeCode::F64);
+
+    DenseMatrix<double> * expected = nullptr;
+    read(expected, filename, nullptr);
+    auto equalsExpected = [&](const DenseMatrix<double> * m) {
+        if(m->getNumRows() != expected->getNumRows() || m->getNumCols() != expected->getNumCols())
+            return false;
+        for(size_t r = 0; r < m->getNumRows(); r++)
+            for(size_t c = 0; c < m->getNumCols(); c++)
+                if(m->get(r, c) != expected->get(r, c))
+                    return false;
+        return true;
+    };
+
+    SECTION("the read takes the prefetched matrix") {
+        prefetchRead(filename, dense, f64, ctx.get());
+        prefetchRead(filename, dense, f64, ctx.get());
+        DenseMatrix<double> * m1 = nullptr;
+        DenseMatrix<double> * m2 = nullptr;
+        read(m1, filename, ctx.get());
+        read(m2, filename, ctx.get());
+        CHECK(equalsExpected(m1));
+        CHECK(equalsExpected(m2));
+        CHECK(m1 != m2);
+        // nothing is left to take
+        CHECK(AsyncReads::get(ctx.get())->take({filename, AsyncReadDataType::DenseMatrix, f64}) == nullptr);
+        DataObjectFactory::destroy(m1, m2);
+    }
+    SECTION("reads of other types are not affected") {
+        prefetchRead(filename, dense, static_cast<int64_t>(ValueTypeCode::F32), ctx.get());
+        DenseMatrix<double> * m = nullptr;
+        read(m, filename, ctx.get());
+        CHECK(equalsExpected(m));
+        DataObjectFactory::destroy(m);
+        // the prefetched matrix that is never read is destroyed with the context
+    }
+    SECTION("errors surface at the read") {
+        const char missing[] = "./test/runtime/local/io/ReadCsvMissing.csv";
+        prefetchRead(missing, dense, f64, ctx.get());
+        DenseMatrix<double> * m = nullptr;
+        CHECK_THROWS(read(m, missing, ctx.get()));
+    }
+
+    ctx.reset();
+    DataObjectFactory::destroy(expected);
+}
+
+TEST_CASE("Write and read - Arrow IPC", TAG_KERNELS) {
+    auto m = genGivenVals<DenseMatrix<double>>(2, {-0.1, -0.2, 0.1, 0.2, 3.14, 5.41, 6.22216, 5});
+    const char filename[] = "./test/runtime/local/io/WriteReadArrowIpc.arrow";
+
+#ifdef USE_ARROW
+    write(m, filename, nullptr);
+    DenseMatrix<double> * res = nullptr;
+    read(res, filename, nullptr);
+    REQUIRE(res->getNumRows() == 2);
+    REQUIRE(res->getNumCols() == 4);
+    for(size_t r = 0; r < 2; r++)
+        for(size_t c = 0; c < 4; c++)
+            CHECK(res->get(r, c) == m->get(r, c));
+    DataObjectFactory::destroy(res);
+#else
+    CHECK_THROWS_AS(write(m, filename, nullptr), std::runtime_error);
+#endif
+
+    std::remove(filename);
+    std::remove((std::string(filename) + ".meta").c_str());
+    DataObjectFactory::destroy(m);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/ReceiveFromNumpy.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdint>
+
+TEMPLATE_TEST_CASE("ReceiveFromNumpy", TAG_KERNELS, double, int64_t, uint8_t) {
+    using VT = TestType;
+
+    // a 3x4 array, of which the matrices are views without copies
+    VT values[12];
+    for(size_t i = 0; i < 12; i++)
+        values[i] = VT(i);
+    const uint64_t address = reinterpret_cast<uint64_t>(values);
+
+    DenseMatrix<VT> * res = nullptr;
+
+    SECTION("contiguous") {
+        receiveFromNumpy(res, address, 3, 4, 4, nullptr);
+        REQUIRE(res->getNumRows() == 3);
+        REQUIRE(res->getNumCols() == 4);
+        CHECK(res->getValues() == values);
+        CHECK(res->get(2, 3) == VT(11));
+    }
+    SECTION("strided rows") {
+        // the columns 1 and 2
+        receiveFromNumpy(res, address + sizeof(VT), 3, 2, 4, nullptr);
+        REQUIRE(res->getNumRows() == 3);
+        REQUIRE(res->getNumCols() == 2);
+        CHECK(res->getRowSkip() == 4);
+        CHECK(res->getValues() == values + 1);
+        CHECK(res->get(0, 0) == VT(1));
+        CHECK(res->get(2, 1) == VT(10));
+        // the view is writable through to the array
+        res->set(1, 1, VT(42));
+        CHECK(values[6] == VT(42));
+    }
+    SECTION("invalid row skip") {
+        CHECK_THROWS(receiveFromNumpy(res, address, 3, 4, 2, nullptr));
+    }
+
+    // The array is not freed with the matrix.
+    if(res)
+        DataObjectFactory::destroy(res);
+}
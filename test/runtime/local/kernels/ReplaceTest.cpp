@@ -21,10 +21,12 @@
 #include <runtime/local/kernels/CheckEq.h>
 
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <limits>
 #include <vector>
 
 #include <cstdint>
@@ -126,4 +128,54 @@ TEMPLATE_PRODUCT_TEST_CASE("Replace-nan", TAG_KERNELS, (DATA_TYPES), (VALUE_TYPE
     DataObjectFactory::destroy(initMatrix);
     DataObjectFactory::destroy(testMatrix1);
 
-}
\ No newline at end of file
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Replace - argument at its last use", TAG_KERNELS, (DenseMatrix), (VALUE_TYPES)){
+    using DT = TestType;
+    auto arg = genGivenVals<DT>(2, {1, 7, 7, 1});
+    auto exp = genGivenVals<DT>(2, {1, 3, 3, 1});
+    DT * res = nullptr;
+    arg->markLastUse();
+    checkReplace(res, arg, 7, 3, exp);
+    CHECK(res == arg);
+    DataObjectFactory::destroy(arg, exp, res);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Replace - in parallel", TAG_KERNELS, (DenseMatrix), (double, float)){
+    using DT = TestType;
+    using VT = typename DT::VT;
+    
+    ParallelContext ctx;
+    
+    const size_t numRows = 1000;
+    const size_t numCols = 300;
+    auto arg = DataObjectFactory::create<DT>(numRows, numCols, false);
+    auto expNan = DataObjectFactory::create<DT>(numRows, numCols, false);
+    auto expSeven = DataObjectFactory::create<DT>(numRows, numCols, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const size_t i = r * numCols + c;
+            const VT v = i % 3 == 0 ? std::numeric_limits<VT>::quiet_NaN() : (i % 3 == 1 ? 7 : 1);
+            arg->set(r, c, v);
+            expNan->set(r, c, v != v ? 1000 : v);
+            expSeven->set(r, c, v == 7 ? std::numeric_limits<VT>::quiet_NaN() : v);
+        }
+    
+    DT * res = nullptr;
+    replace<DT, DT, VT>(res, arg, std::numeric_limits<VT>::quiet_NaN(), 1000, ctx.get());
+    CHECK(*res == *expNan);
+    
+    // a NaN replacement of a pattern that is not NaN
+    DT * res2 = nullptr;
+    replace<DT, DT, VT>(res2, arg, 7, std::numeric_limits<VT>::quiet_NaN(), ctx.get());
+    size_t numMismatches = 0;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++) {
+            const VT e = expSeven->get(r, c);
+            const VT f = res2->get(r, c);
+            numMismatches += (e != e) ? (f == f) : (f != e);
+        }
+    CHECK(numMismatches == 0);
+    
+    DataObjectFactory::destroy(arg, expNan, expSeven, res, res2);
+}
@@ -76,7 +76,58 @@ TEMPLATE_PRODUCT_TEST_CASE("RowBind", TAG_KERNELS, (DenseMatrix), (double, uint3
         
         DataObjectFactory::destroy(m1);
     }
-    
+    SECTION("views") {
+        auto ups = DataObjectFactory::create<DT>(m0, 0, 1, 1, 3);
+        auto lows = DataObjectFactory::create<DT>(m0, 1, 3, 1, 3);
+        auto exp = genGivenVals<DT>(3, {
+            2, 3,
+            6, 7,
+            10, 11,
+        });
+        
+        rowBind<DT, DT, DT>(res, ups, lows, nullptr);
+        CHECK(*res == *exp);
+        // the result is a view on the values of m0
+        CHECK(res->getValues() == ups->getValues());
+        
+        // lows does not directly follow ups, so the rows are copied one by one
+        auto exp2 = genGivenVals<DT>(3, {
+            6, 7,
+            10, 11,
+            2, 3,
+        });
+        DT * res2 = nullptr;
+        rowBind<DT, DT, DT>(res2, lows, ups, nullptr);
+        CHECK(*res2 == *exp2);
+        
+        DataObjectFactory::destroy(ups, lows, exp, exp2, res, res2);
+    }
+    SECTION("appending to the spare rows of the last use") {
+        // like `X = rbind(X, r)` in a loop, where X is released after each call
+        auto r = genGivenVals<DT>(1, {17, 18, 19, 20});
+        DT * x = m0;
+        m0->increaseRefCounter();
+        size_t numReallocs = 0;
+        for(size_t i = 0; i < 20; i++) {
+            x->markLastUse();
+            DT * next = nullptr;
+            rowBind<DT, DT, DT>(next, x, r, nullptr);
+            numReallocs += next->getValues() != x->getValues();
+            DataObjectFactory::destroy(x);
+            x = next;
+        }
+        // the capacity grows geometrically
+        CHECK(numReallocs < 10);
+        REQUIRE(x->getNumRows() == 24);
+        for(size_t i = 0; i < 4; i++)
+            CHECK(x->get(i, 3) == m0->get(i, 3));
+        for(size_t i = 4; i < 24; i++)
+            for(size_t c = 0; c < 4; c++)
+                CHECK(x->get(i, c) == r->get(0, c));
+
+        DataObjectFactory::destroy(r, x);
+    }
+
     DataObjectFactory::destroy(m0);
 }
 
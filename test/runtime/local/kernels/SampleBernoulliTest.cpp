@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/SampleBernoulli.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <cmath>
+
+TEMPLATE_PRODUCT_TEST_CASE("SampleBernoulli", TAG_KERNELS, (DenseMatrix), (double, int64_t)) {
+    using DT = TestType;
+
+    ParallelContext ctx;
+
+    const size_t numRows = 300000;
+    auto arg = DataObjectFactory::create<DT>(numRows, 2, false);
+    DenseMatrix<size_t> * par = nullptr;
+    DenseMatrix<size_t> * seq = nullptr;
+
+    SECTION("fraction in (0, 1)") {
+        const double fraction = 0.1;
+        checkParallelEqualsSequential<DenseMatrix<size_t>>([&](DenseMatrix<size_t> *& res, DCTX(c)) {
+            sampleBernoulli(res, arg, fraction, 7, c);
+        });
+        sampleBernoulli(par, arg, fraction, 7, ctx.get());
+
+        const size_t numSelected = par->getNumRows();
+        REQUIRE(par->getNumCols() == 1);
+        // far beyond ten standard deviations
+        CHECK(std::abs(double(numSelected) - fraction * numRows) < 2000);
+        CHECK(std::adjacent_find(par->getValues(), par->getValues() + numSelected,
+                                 [](size_t a, size_t b) { return a >= b; }) == par->getValues() + numSelected);
+        CHECK(par->getValues()[numSelected - 1] < numRows);
+    }
+    SECTION("fraction 0 and 1") {
+        sampleBernoulli(par, arg, 0.0, 7, ctx.get());
+        sampleBernoulli(seq, arg, 1.0, 7, ctx.get());
+        CHECK(par->getNumRows() == 0);
+        REQUIRE(seq->getNumRows() == numRows);
+        for(size_t r = 0; r < numRows; r++)
+            CHECK(seq->getValues()[r] == r);
+    }
+    SECTION("invalid fraction") {
+        CHECK_THROWS(sampleBernoulli(par, arg, 1.5, 7, ctx.get()));
+    }
+
+    DataObjectFactory::destroy(arg);
+    if(par)
+        DataObjectFactory::destroy(par);
+    if(seq)
+        DataObjectFactory::destroy(seq);
+}
+
+TEST_CASE("SampleBernoulli - Frame", TAG_KERNELS) {
+    const size_t numRows = 1000;
+    auto c0 = DataObjectFactory::create<DenseMatrix<double>>(numRows, 1, true);
+    auto c1 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, true);
+    std::vector<Structure *> colMats = {c0, c1};
+    auto arg = DataObjectFactory::create<Frame>(colMats, nullptr);
+
+    DenseMatrix<size_t> * resFrame = nullptr;
+    DenseMatrix<size_t> * resMat = nullptr;
+    sampleBernoulli(resFrame, arg, 0.5, 3, nullptr);
+    sampleBernoulli(resMat, c0, 0.5, 3, nullptr);
+
+    // the sample only depends on the number of rows
+    REQUIRE(resFrame->getNumRows() == resMat->getNumRows());
+    CHECK(std::equal(resFrame->getValues(), resFrame->getValues() + resFrame->getNumRows(), resMat->getValues()));
+
+    DataObjectFactory::destroy(c0, c1, arg, resFrame, resMat);
+}
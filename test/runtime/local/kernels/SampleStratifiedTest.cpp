@@ -0,0 +1,98 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/kernels/SampleStratified.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+TEMPLATE_PRODUCT_TEST_CASE("SampleStratified", TAG_KERNELS, (DenseMatrix), (double, int64_t)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    // three strata of 30000 rows each in the second column, and (for double) a stratum of NaNs
+    const size_t numRows = 100000;
+    auto arg = DataObjectFactory::create<DT>(numRows, 2, false);
+    for(size_t r = 0; r < numRows; r++) {
+        arg->set(r, 0, VT(r));
+        if(std::numeric_limits<VT>::has_quiet_NaN && r >= 90000)
+            arg->set(r, 1, std::numeric_limits<VT>::quiet_NaN());
+        else
+            arg->set(r, 1, VT(r < 90000 ? r % 3 : 3));
+    }
+
+    checkParallelEqualsSequential<DenseMatrix<size_t>>([&](DenseMatrix<size_t> *& res, DCTX(ctx)) {
+        sampleStratified(res, arg, 1, 0.25, 11, ctx);
+    });
+
+    DenseMatrix<size_t> * res = nullptr;
+    sampleStratified(res, arg, 1, 0.25, 11, nullptr);
+    const size_t numSelected = res->getNumRows();
+    REQUIRE(numSelected == 25000);
+    const size_t * values = res->getValues();
+    CHECK(std::adjacent_find(values, values + numSelected, [](size_t a, size_t b) { return a >= b; })
+          == values + numSelected);
+
+    size_t counts[4] = {0, 0, 0, 0};
+    for(size_t i = 0; i < numSelected; i++)
+        counts[values[i] < 90000 ? values[i] % 3 : 3]++;
+    CHECK(counts[0] == 7500);
+    CHECK(counts[1] == 7500);
+    CHECK(counts[2] == 7500);
+    CHECK(counts[3] == 2500);
+
+    CHECK_THROWS(sampleStratified(res, arg, 2, 0.25, 11, nullptr));
+
+    DataObjectFactory::destroy(arg, res);
+}
+
+TEST_CASE("SampleStratified - Frame on string keys", TAG_KERNELS) {
+    ValueTypeCode schema[] = {ValueTypeCode::STR};
+    std::string labels[] = {"a"};
+    auto arg = DataObjectFactory::create<Frame>(8, 1, schema, labels, false);
+    std::string * keys = static_cast<std::string *>(arg->getColumnRaw(0));
+    const char * vals[] = {"x", "y", "x", "x", "z", "y", "x", "x"};
+    std::copy(vals, vals + 8, keys);
+
+    DenseMatrix<size_t> * res = nullptr;
+    sampleStratified(res, arg, 0, 0.5, 1, nullptr);
+
+    // round(0.5 * 5) of "x", round(0.5 * 2) of "y", and round(0.5 * 1) of "z"
+    REQUIRE(res->getNumRows() == 5);
+    size_t numX = 0, numY = 0, numZ = 0;
+    for(size_t i = 0; i < 5; i++) {
+        const std::string & key = keys[res->get(i, 0)];
+        numX += key == "x";
+        numY += key == "y";
+        numZ += key == "z";
+    }
+    CHECK(numX == 3);
+    CHECK(numY == 1);
+    CHECK(numZ == 1);
+
+    DataObjectFactory::destroy(arg, res);
+}
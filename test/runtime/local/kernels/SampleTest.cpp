@@ -18,10 +18,13 @@
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/Sample.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <algorithm>
+
 TEMPLATE_PRODUCT_TEST_CASE("Sample", TAG_KERNELS, (DenseMatrix), (double, uint32_t)) {
     using DT = TestType;
     using VT = typename DT::VT;
@@ -65,4 +68,30 @@ TEMPLATE_PRODUCT_TEST_CASE("Sample", TAG_KERNELS, (DenseMatrix), (double, uint32
     }
 
     DataObjectFactory::destroy(m);
-}
\ No newline at end of file
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Sample, reproducible in parallel", TAG_KERNELS, (DenseMatrix), (double, int64_t)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    // enough values for several blocks, and a range for each way of drawing without replacement
+    const size_t size = 200000;
+    const bool withReplacement = GENERATE(true, false);
+    const VT range = GENERATE(VT(250000), VT(10000000));
+
+    checkParallelEqualsSequential<DT>([&](DT *& res, DCTX(ctx)) {
+        sample<DT, VT>(res, range, size, withReplacement, 42, ctx);
+    });
+
+    DT * res = nullptr;
+    sample<DT, VT>(res, range, size, withReplacement, 42, nullptr);
+    REQUIRE(res->getNumRows() == size);
+    VT * values = res->getValues();
+    std::sort(values, values + size);
+    CHECK(values[0] >= 0);
+    CHECK(values[size - 1] < range);
+    if(!withReplacement)
+        CHECK(std::adjacent_find(values, values + size) == values + size);
+
+    DataObjectFactory::destroy(res);
+}
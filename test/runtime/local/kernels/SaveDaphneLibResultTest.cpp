@@ -0,0 +1,79 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <api/cli/DaphneUserConfig.h>
+#include <api/daphnelib/DaphneLibResult.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/kernels/SaveDaphneLibResult.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <memory>
+
+TEST_CASE("SaveDaphneLibResult", TAG_KERNELS) {
+    DaphneLibResult results[2] = {{nullptr, 0, 0, 0, 0, nullptr}, {nullptr, 0, 0, 0, 0, nullptr}};
+    DaphneLibResult & result = results[1];
+    DaphneUserConfig userConfig{};
+    userConfig.result_struct = results;
+    userConfig.num_result_structs = 2;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+
+    auto m = genGivenVals<DenseMatrix<double>>(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+    auto view = DataObjectFactory::create<DenseMatrix<double>>(m, 1, 3, 1, 3);
+
+    saveDaphneLibResult(view, 1, ctx.get());
+    CHECK(results[0].handle == nullptr);
+    CHECK(result.address == view->getValues());
+    CHECK(result.rows == 2);
+    CHECK(result.cols == 2);
+    CHECK(result.rowSkip == 4);
+    CHECK(result.vtc == static_cast<int64_t>(ValueTypeCode::F64));
+    CHECK(result.handle == view);
+
+    // The result keeps the matrix alive after the program released it.
+    DataObjectFactory::destroy(view, m);
+    CHECK(static_cast<const double *>(result.address)[0] == 6);
+    CHECK(static_cast<const double *>(result.address)[5] == 11);
+
+    // only one result per index, and only as many indices as results
+    auto m2 = genGivenVals<DenseMatrix<double>>(1, {1, 2});
+    CHECK_THROWS(saveDaphneLibResult(m2, 1, ctx.get()));
+    CHECK_THROWS(saveDaphneLibResult(m2, 2, ctx.get()));
+
+    saveDaphneLibResult(m2, 0, ctx.get());
+    CHECK(results[0].handle == m2);
+    CHECK(results[0].rows == 1);
+    CHECK(results[0].cols == 2);
+
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(static_cast<DenseMatrix<double> *>(results[0].handle));
+    DataObjectFactory::destroy(static_cast<DenseMatrix<double> *>(result.handle));
+}
+
+TEST_CASE("SaveDaphneLibResult without DaphneLib", TAG_KERNELS) {
+    DaphneUserConfig userConfig{};
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    auto m = genGivenVals<DenseMatrix<double>>(1, {1});
+    CHECK_THROWS(saveDaphneLibResult(m, 0, ctx.get()));
+    DataObjectFactory::destroy(m);
+}
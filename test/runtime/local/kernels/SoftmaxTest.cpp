@@ -0,0 +1,50 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/Softmax.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <memory>
+
+TEMPLATE_PRODUCT_TEST_CASE("Softmax::Forward", TAG_DNN, (DenseMatrix), (float, double)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+
+    DaphneUserConfig userConfig{};
+    userConfig.fast_math = GENERATE(false, true);
+    auto dctx = std::make_unique<DaphneContext>(userConfig);
+
+    // the softmax is computed per row, the large values check the subtraction of the row maximum
+    auto input = genGivenVals<DT>(2, { -3, -2, -1, 0, 1, 2, 3, 4, 5,
+            1000, 1001, 1002, 1003, 1004, 1005, 1006, 1007, 1008 });
+    auto result = genGivenVals<DT>(2, { 0.000212079, 0.00057649, 0.00156706, 0.00425972, 0.0115791, 0.0314753, 0.0855588,
+            0.232573, 0.632199, 0.000212079, 0.00057649, 0.00156706, 0.00425972, 0.0115791, 0.0314753, 0.0855588,
+            0.232573, 0.632199 });
+
+    DT* res = nullptr;
+    Softmax::Forward<DT, DT>::apply(res, input, dctx.get());
+    for(size_t r = 0; r < 2; r++)
+        for(size_t c = 0; c < 9; c++)
+            CHECK(res->get(r, c) == Approx(result->get(r, c)).epsilon(1e-5));
+
+    DataObjectFactory::destroy(input, result, res);
+}
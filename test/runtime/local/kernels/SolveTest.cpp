@@ -72,3 +72,54 @@ TEMPLATE_PRODUCT_TEST_CASE("Solve", TAG_KERNELS, (DenseMatrix), (float, double))
     DataObjectFactory::destroy(A);
     DataObjectFactory::destroy(b);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("Solve, multiple right-hand sides and cached factorization", TAG_KERNELS, (DenseMatrix), (float, double)) {
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    auto x = genGivenVals<DT>(2, {
+        1, 2,
+        3, -1
+    });
+
+    // symmetric positive definite, factorized by Cholesky
+    auto A = genGivenVals<DT>(2, {
+        4, 1,
+        1, 3
+    });
+    auto b = genGivenVals<DT>(2, {
+        7, 7,
+        10, -1
+    });
+    checkSolve(A, b, x);
+    auto factors = A->getMetaDataObject().template getDerived<SolveFactorization::Factors<VT>>();
+    REQUIRE(factors != nullptr);
+    CHECK(factors->cholesky);
+    // the kept factorization is used for the next right-hand sides
+    checkSolve(A, b, x);
+    CHECK(A->getMetaDataObject().template getDerived<SolveFactorization::Factors<VT>>() == factors);
+
+    // a write drops the factorization of the old values
+    A->set(1, 0, 0);
+    CHECK(A->getMetaDataObject().template getDerived<SolveFactorization::Factors<VT>>() == nullptr);
+    auto b2 = genGivenVals<DT>(2, {
+        7, 7,
+        9, -3
+    });
+    checkSolve(A, b2, x);
+    CHECK_FALSE(A->getMetaDataObject().template getDerived<SolveFactorization::Factors<VT>>()->cholesky);
+
+    // symmetric, but not positive definite, factorized by LU
+    auto C = genGivenVals<DT>(2, {
+        1, 2,
+        2, 1
+    });
+    auto c = genGivenVals<DT>(2, {
+        7, 0,
+        5, 3
+    });
+    checkSolve(C, c, x);
+    CHECK_FALSE(C->getMetaDataObject().template getDerived<SolveFactorization::Factors<VT>>()->cholesky);
+
+    DataObjectFactory::destroy(x, A, b, b2, C, c);
+}
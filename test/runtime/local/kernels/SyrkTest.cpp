@@ -15,6 +15,7 @@
  */
 
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/MatMul.h>
@@ -22,6 +23,7 @@
 #include <runtime/local/kernels/Syrk.h>
 #include <runtime/local/kernels/PrintObj.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
@@ -101,4 +103,38 @@ TEMPLATE_PRODUCT_TEST_CASE("Syrk", TAG_KERNELS, (DenseMatrix), (float, double))
     checkSyrk(v2);
 
     DataObjectFactory::destroy(m0, m1, m2, m3, m4, m5, v0, v1, v2);
-}
\ No newline at end of file
+}
+TEMPLATE_TEST_CASE("Syrk, sparse", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    using DTDense = DenseMatrix<VT>;
+    using DTSparse = CSRMatrix<VT>;
+
+    ParallelContext ctx;
+
+    // enough small integers for several chunks of rows, such that the sums are exact
+    const size_t numRows = 20000;
+    const size_t numCols = 7;
+    std::vector<VT> values(numRows * numCols, 0);
+    for(size_t i = 0; i < values.size(); i++)
+        if(i % 3 == 0 || i % 11 == 0)
+            values[i] = static_cast<VT>(i % 5) - 2;
+    auto argDense = genGivenVals<DTDense>(numRows, values);
+    auto argSparse = genGivenVals<DTSparse>(numRows, values);
+
+    DTDense * resExp = nullptr;
+    syrk(resExp, argDense, ctx.get());
+
+    DTDense * resDense = nullptr;
+    syrk(resDense, argSparse, ctx.get());
+    CHECK(*resDense == *resExp);
+
+    DTSparse * resSparse = nullptr;
+    syrk(resSparse, argSparse, ctx.get());
+    REQUIRE(resSparse->getNumRows() == numCols);
+    REQUIRE(resSparse->getNumCols() == numCols);
+    for(size_t r = 0; r < numCols; r++)
+        for(size_t c = 0; c < numCols; c++)
+            CHECK(resSparse->get(r, c) == resExp->get(r, c));
+
+    DataObjectFactory::destroy(argDense, argSparse, resExp, resDense, resSparse);
+}
@@ -17,7 +17,9 @@
 #include <tags.h>
 #include <vector>
 #include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
 
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
@@ -614,3 +616,102 @@ TEST_CASE("ThetaJoin: Test unequal value types", TAG_KERNELS) {
     /// cleanup
     DataObjectFactory::destroy(resultFrame, expectedResult, lhs, rhs);
 }
+
+
+/// Test range, band, and mixed equality/inequality joins against nested loops over all pairs of rows
+TEST_CASE("ThetaJoin: Test inequality joins on larger inputs", TAG_KERNELS) {
+    const size_t lhsRows = 700;
+    const size_t rhsRows = 900;
+    /// R(k, ts, v) and S(k, start, end)
+    auto lhsK = DataObjectFactory::create<DenseMatrix<int64_t>>(lhsRows, 1, false);
+    auto lhsTs = DataObjectFactory::create<DenseMatrix<double>>(lhsRows, 1, false);
+    auto lhsV = DataObjectFactory::create<DenseMatrix<uint32_t>>(lhsRows, 1, false);
+    for(size_t i = 0; i < lhsRows; ++i){
+        lhsK->getValues()[i] = static_cast<int64_t>((i * 7) % 13);
+        lhsTs->getValues()[i] = (i % 50 == 0) ? std::numeric_limits<double>::quiet_NaN() : static_cast<double>((i * 31) % 500);
+        lhsV->getValues()[i] = static_cast<uint32_t>((i * 17) % 11);
+    }
+    auto rhsK = DataObjectFactory::create<DenseMatrix<int32_t>>(rhsRows, 1, false);
+    auto rhsStart = DataObjectFactory::create<DenseMatrix<int64_t>>(rhsRows, 1, false);
+    auto rhsEnd = DataObjectFactory::create<DenseMatrix<float>>(rhsRows, 1, false);
+    for(size_t i = 0; i < rhsRows; ++i){
+        rhsK->getValues()[i] = static_cast<int32_t>((i * 5) % 17);
+        rhsStart->getValues()[i] = static_cast<int64_t>((i * 37) % 480);
+        rhsEnd->getValues()[i] = static_cast<float>(rhsStart->getValues()[i] + static_cast<int64_t>(i % 40));
+    }
+    std::string lhsLabels[] = {"R.k", "R.ts", "R.v"};
+    std::string rhsLabels[] = {"S.k", "S.start", "S.end"};
+    auto lhs = DataObjectFactory::create<Frame>(std::vector<Structure*>{lhsK, lhsTs, lhsV}, lhsLabels);
+    auto rhs = DataObjectFactory::create<Frame>(std::vector<Structure*>{rhsK, rhsStart, rhsEnd}, rhsLabels);
+    
+    auto compare = [](double a, double b, CompareOperation cmp) {
+        switch(cmp){
+            case CompareOperation::Equal:        return a == b;
+            case CompareOperation::LessThan:     return a < b;
+            case CompareOperation::LessEqual:    return a <= b;
+            case CompareOperation::GreaterThan:  return a > b;
+            case CompareOperation::GreaterEqual: return a >= b;
+            default:                             return a != b;
+        }
+    };
+    
+    std::function<void(std::vector<const char*>, std::vector<const char*>, std::vector<CompareOperation>)> test =
+            [&](std::vector<const char*> lhsOn, std::vector<const char*> rhsOn, std::vector<CompareOperation> cmps) {
+        Frame * resultFrame = nullptr;
+        thetaJoin(resultFrame, lhs, rhs, lhsOn.data(), lhsOn.size(), rhsOn.data(), rhsOn.size(), cmps.data(),
+                  cmps.size(), nullptr);
+        
+        std::vector<std::pair<size_t, size_t>> expected;
+        for(size_t l = 0; l < lhsRows; ++l)
+            for(size_t r = 0; r < rhsRows; ++r){
+                bool match = true;
+                for(size_t i = 0; i < cmps.size(); ++i){
+                    const size_t lc = lhs->getColumnIdx(lhsOn[i]);
+                    const size_t rc = rhs->getColumnIdx(rhsOn[i]);
+                    const double a = lc == 0 ? lhsK->getValues()[l] : lc == 1 ? lhsTs->getValues()[l] : lhsV->getValues()[l];
+                    const double b = rc == 0 ? rhsK->getValues()[r] : rc == 1 ? rhsStart->getValues()[r] : rhsEnd->getValues()[r];
+                    match = match && compare(a, b, cmps[i]);
+                }
+                if(match)
+                    expected.emplace_back(l, r);
+            }
+        
+        REQUIRE(resultFrame->getNumRows() == expected.size());
+        const auto * resK = static_cast<const int64_t *>(resultFrame->getColumnRaw(0));
+        const auto * resV = static_cast<const uint32_t *>(resultFrame->getColumnRaw(2));
+        const auto * resStart = static_cast<const int64_t *>(resultFrame->getColumnRaw(4));
+        const auto * resEnd = static_cast<const float *>(resultFrame->getColumnRaw(5));
+        bool allEqual = true;
+        for(size_t i = 0; i < expected.size(); ++i){
+            const auto [l, r] = expected[i];
+            allEqual = allEqual && resK[i] == lhsK->getValues()[l] && resV[i] == lhsV->getValues()[l]
+                    && resStart[i] == rhsStart->getValues()[r] && resEnd[i] == rhsEnd->getValues()[r];
+        }
+        CHECK(allEqual);
+        DataObjectFactory::destroy(resultFrame);
+    };
+    
+    SECTION("single inequality") {
+        test({"R.ts"}, {"S.start"}, {CompareOperation::GreaterEqual});
+        test({"R.ts"}, {"S.end"}, {CompareOperation::LessThan});
+    }
+    SECTION("band join") {
+        test({"R.ts", "R.ts"}, {"S.start", "S.end"}, {CompareOperation::GreaterEqual, CompareOperation::LessEqual});
+        test({"R.ts", "R.ts"}, {"S.end", "S.start"}, {CompareOperation::LessThan, CompareOperation::GreaterThan});
+    }
+    SECTION("equalities and inequalities") {
+        test({"R.k", "R.ts", "R.ts"}, {"S.k", "S.start", "S.end"},
+             {CompareOperation::Equal, CompareOperation::GreaterEqual, CompareOperation::LessEqual});
+        test({"R.k", "R.v"}, {"S.k", "S.start"}, {CompareOperation::Equal, CompareOperation::Equal});
+    }
+    SECTION("more than two inequalities and not-equal") {
+        test({"R.ts", "R.ts", "R.v", "R.k"}, {"S.start", "S.end", "S.start", "S.k"},
+             {CompareOperation::GreaterEqual, CompareOperation::LessEqual, CompareOperation::LessThan, CompareOperation::NotEqual});
+        /// the unselective inequalities first, such that the selective band is chosen by the sketches
+        test({"R.v", "R.k", "R.ts", "R.ts"}, {"S.start", "S.end", "S.start", "S.end"},
+             {CompareOperation::LessThan, CompareOperation::LessEqual, CompareOperation::GreaterEqual, CompareOperation::LessEqual});
+    }
+    
+    DataObjectFactory::destroy(lhsK, lhsTs, lhsV, rhsK, rhsStart, rhsEnd);
+    DataObjectFactory::destroy(lhs, rhs);
+}
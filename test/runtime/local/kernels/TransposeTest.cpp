@@ -15,11 +15,18 @@
  */
 
 #include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DCSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/kernels/AggAll.h>
+#include <runtime/local/kernels/AggCol.h>
 #include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/MatMul.h>
 #include <runtime/local/kernels/Transpose.h>
 
+#include <runtime/local/kernels/ParallelUtils.h>
 #include <tags.h>
 
 #include <catch.hpp>
@@ -33,7 +40,7 @@ void checkTranspose(const DT * arg, const DT * exp) {
     CHECK(*res == *exp);
 }
 
-TEMPLATE_PRODUCT_TEST_CASE("Transpose", TAG_KERNELS, (DenseMatrix, CSRMatrix), (double, uint32_t)) {
+TEMPLATE_PRODUCT_TEST_CASE("Transpose", TAG_KERNELS, (DenseMatrix, CSRMatrix, DCSRMatrix), (double, uint32_t)) {
     using DT = TestType;
     
     DT * m = nullptr;
@@ -87,4 +94,162 @@ TEMPLATE_PRODUCT_TEST_CASE("Transpose", TAG_KERNELS, (DenseMatrix, CSRMatrix), (
 
     DataObjectFactory::destroy(m);
     DataObjectFactory::destroy(mt);
-}
\ No newline at end of file
+}
+// a matrix of distinct values, such that misplaced values are detected
+template<typename VT>
+DenseMatrix<VT> * genLarge(size_t numRows, size_t numCols) {
+    auto m = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    VT * values = m->getValues();
+    for(size_t i = 0; i < numRows * numCols; i++)
+        values[i] = static_cast<VT>(i % 1000003);
+    return m;
+}
+
+template<typename VT>
+bool isTransposed(const DenseMatrix<VT> * arg, const DenseMatrix<VT> * res) {
+    if(res->getNumRows() != arg->getNumCols() || res->getNumCols() != arg->getNumRows())
+        return false;
+    for(size_t r = 0; r < arg->getNumRows(); r++)
+        for(size_t c = 0; c < arg->getNumCols(); c++)
+            if(res->get(c, r) != arg->get(r, c))
+                return false;
+    return true;
+}
+
+TEMPLATE_TEST_CASE("Transpose, blocked", TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    // sizes below, at, and not a multiple of the tile and micro kernel edge lengths
+    const size_t sizes[][2] = {{7, 9}, {32, 32}, {33, 65}, {100, 3}, {513, 300}};
+    for(auto & size : sizes) {
+        auto m = genLarge<VT>(size[0], size[1]);
+        DenseMatrix<VT> * res = nullptr;
+        transpose(res, m, ctx.get());
+        CHECK(isTransposed(m, res));
+        DataObjectFactory::destroy(m, res);
+    }
+}
+
+TEMPLATE_TEST_CASE("Transpose, view", TAG_KERNELS, double, float) {
+    using VT = TestType;
+    auto m = genLarge<VT>(70, 90);
+    auto view = DataObjectFactory::create<DenseMatrix<VT>>(m, 3, 67, 5, 86);
+    DenseMatrix<VT> * res = nullptr;
+    transpose(res, view, nullptr);
+    CHECK(isTransposed(view, res));
+    DataObjectFactory::destroy(m, view, res);
+}
+
+TEMPLATE_TEST_CASE("Transpose, in place", TAG_KERNELS, double, float, int64_t) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    SECTION("square matrix") {
+        for(size_t n : {1, 5, 32, 70, 300}) {
+            auto m = genLarge<VT>(n, n);
+            auto exp = genLarge<VT>(n, n);
+            DenseMatrix<VT> * res = m;
+            transpose(res, m, ctx.get());
+            CHECK(res == m);
+            CHECK(isTransposed(exp, m));
+            DataObjectFactory::destroy(m, exp);
+        }
+    }
+    SECTION("not applicable") {
+        auto rect = genLarge<VT>(3, 4);
+        CHECK_FALSE(Transpose<DenseMatrix<VT>, DenseMatrix<VT>>::applyInPlace(rect, nullptr));
+        DenseMatrix<VT> * res = rect;
+        CHECK_THROWS(transpose(res, rect, nullptr));
+
+        auto m = genLarge<VT>(8, 8);
+        auto view = DataObjectFactory::create<DenseMatrix<VT>>(m, 0, 4, 0, 4);
+        // neither the view nor the matrix it shares its values with
+        CHECK_FALSE(Transpose<DenseMatrix<VT>, DenseMatrix<VT>>::applyInPlace(view, nullptr));
+        CHECK_FALSE(Transpose<DenseMatrix<VT>, DenseMatrix<VT>>::applyInPlace(m, nullptr));
+        CHECK(m->get(0, 1) == 1);
+        DataObjectFactory::destroy(rect, m, view);
+    }
+}
+
+TEMPLATE_TEST_CASE("Transpose, lazy", TAG_KERNELS, double, float) {
+    using VT = TestType;
+    ParallelContext ctx;
+
+    auto m = genLarge<VT>(45, 70);
+    DenseMatrix<VT> * t = nullptr;
+    transpose(t, m, ctx.get());
+    REQUIRE(t->getTransposedSource() == m);
+    CHECK(t->getNumRows() == 70);
+    CHECK(t->getNumCols() == 45);
+    CHECK(t->get(69, 3) == m->get(3, 69));
+
+    SECTION("transposed back") {
+        DenseMatrix<VT> * tt = nullptr;
+        transpose(tt, t, ctx.get());
+        CHECK(tt == m);
+        DataObjectFactory::destroy(tt);
+    }
+    SECTION("read natively") {
+        // the eager transposition as reference
+        auto exp = DataObjectFactory::create<DenseMatrix<VT>>(70, 45, false);
+        transpose(exp, m, ctx.get());
+        REQUIRE(exp->getTransposedSource() == nullptr);
+
+        DenseMatrix<VT> * resLazy = nullptr;
+        DenseMatrix<VT> * resExp = nullptr;
+        matMul(resLazy, t, m, false, false, ctx.get());
+        matMul(resExp, exp, m, false, false, ctx.get());
+        CHECK(*resLazy == *resExp);
+        DataObjectFactory::destroy(resLazy, resExp);
+        resLazy = nullptr;
+        resExp = nullptr;
+        matMul(resLazy, m, t, true, true, ctx.get());
+        matMul(resExp, m, exp, true, true, ctx.get());
+        CHECK(*resLazy == *resExp);
+        DataObjectFactory::destroy(resLazy, resExp);
+
+        CHECK(aggAll(AggOpCode::SUM, t, ctx.get()) == aggAll(AggOpCode::SUM, exp, ctx.get()));
+        for(AggOpCode opCode : {AggOpCode::SUM, AggOpCode::MAX, AggOpCode::MEAN}) {
+            resLazy = nullptr;
+            resExp = nullptr;
+            aggCol(opCode, resLazy, t, ctx.get());
+            aggCol(opCode, resExp, exp, ctx.get());
+            CHECK(*resLazy == *resExp);
+            DataObjectFactory::destroy(resLazy, resExp);
+        }
+
+        auto other = genLarge<VT>(70, 45);
+        resLazy = nullptr;
+        resExp = nullptr;
+        ewBinaryMat(BinaryOpCode::SUB, resLazy, t, other, ctx.get());
+        ewBinaryMat(BinaryOpCode::SUB, resExp, exp, other, ctx.get());
+        CHECK(*resLazy == *resExp);
+        DataObjectFactory::destroy(resLazy, resExp);
+        resLazy = nullptr;
+        ewBinaryMat(BinaryOpCode::ADD, resLazy, t, t, ctx.get());
+        resExp = nullptr;
+        ewBinaryMat(BinaryOpCode::ADD, resExp, exp, exp, ctx.get());
+        CHECK(*resLazy == *resExp);
+        DataObjectFactory::destroy(resLazy, resExp, other);
+
+        // none of these needed the values of the transposition
+        CHECK(t->getTransposedSource() == m);
+        DataObjectFactory::destroy(exp);
+    }
+    SECTION("materialized") {
+        CHECK(isTransposed(m, t));
+        const DenseMatrix<VT> * ct = t;
+        const VT * values = ct->getValues();
+        CHECK(values[3 * 45 + 2] == m->get(2, 3));
+        // still the transposition of the source, which is only released when written
+        CHECK(t->getTransposedSource() == m);
+        t->set(0, 0, VT(-1));
+        CHECK(t->getTransposedSource() == nullptr);
+        CHECK(t->get(0, 0) == VT(-1));
+        CHECK(t->get(1, 0) == m->get(0, 1));
+        CHECK(m->get(0, 0) == VT(0));
+    }
+
+    DataObjectFactory::destroy(m, t);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BitMatrix.h>
+#include <runtime/local/datastructures/ColumnStats.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/BitMask.h>
+#include <runtime/local/kernels/FilterRow.h>
+#include <runtime/local/kernels/ZoneMaps.h>
+
+#include <runtime/local/kernels/ParallelUtils.h>
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+TEST_CASE("ZoneMaps decide comparisons on the bounds of a block", TAG_KERNELS) {
+    using ZoneMaps::BlockMatch;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> values = {2.0, 4.0, 3.0};
+    auto zm = ZoneMap<double>::compute(values.data(), values.size());
+
+    CHECK(ZoneMaps::match(BinaryOpCode::LT, *zm, 0, 2.0) == BlockMatch::NONE);
+    CHECK(ZoneMaps::match(BinaryOpCode::LT, *zm, 0, 4.5) == BlockMatch::ALL);
+    CHECK(ZoneMaps::match(BinaryOpCode::LT, *zm, 0, 3.0) == BlockMatch::SOME);
+    CHECK(ZoneMaps::match(BinaryOpCode::GE, *zm, 0, 2.0) == BlockMatch::ALL);
+    CHECK(ZoneMaps::match(BinaryOpCode::GT, *zm, 0, 4.0) == BlockMatch::NONE);
+    CHECK(ZoneMaps::match(BinaryOpCode::EQ, *zm, 0, 5.0) == BlockMatch::NONE);
+    CHECK(ZoneMaps::match(BinaryOpCode::NEQ, *zm, 0, 5.0) == BlockMatch::ALL);
+    CHECK(ZoneMaps::match(BinaryOpCode::LE, *zm, 0, nan) == BlockMatch::SOME);
+
+    // the nulls are not less than anything, but not equal to anything either
+    values.push_back(nan);
+    auto withNull = ZoneMap<double>::compute(values.data(), values.size());
+    CHECK(ZoneMaps::match(BinaryOpCode::LT, *withNull, 0, 4.5) == BlockMatch::SOME);
+    CHECK(ZoneMaps::match(BinaryOpCode::LT, *withNull, 0, 2.0) == BlockMatch::NONE);
+    CHECK(ZoneMaps::match(BinaryOpCode::NEQ, *withNull, 0, 5.0) == BlockMatch::ALL);
+
+    std::vector<double> same = {1.0, 1.0};
+    auto constant = ZoneMap<double>::compute(same.data(), same.size());
+    CHECK(ZoneMaps::match(BinaryOpCode::EQ, *constant, 0, 1.0) == BlockMatch::ALL);
+    CHECK(ZoneMaps::match(BinaryOpCode::NEQ, *constant, 0, 1.0) == BlockMatch::NONE);
+}
+
+TEST_CASE("ZoneMaps skip the blocks of comparisons with a scalar", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    // blocks of ascending values, the last one partial and one of them
+    // overlapping the scalar
+    const size_t numRows = 5 * ColumnStats::BLOCK_ROWS + 100;
+    auto arg = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    int64_t * values = arg->getValues();
+    for(size_t r = 0; r < numRows; r++)
+        values[r] = r;
+    const int64_t scalar = 2 * ColumnStats::BLOCK_ROWS + 7;
+
+    ZoneMaps::computeMatrix(arg, ctx.get());
+    REQUIRE(arg->getZoneMap(0) != nullptr);
+    for(BinaryOpCode opCode : {BinaryOpCode::LT, BinaryOpCode::GE, BinaryOpCode::EQ, BinaryOpCode::NEQ}) {
+        BitMatrix * res = DataObjectFactory::create<BitMatrix>(numRows, 1, false);
+        BitMask::compare(opCode, res, arg, &scalar, 0, 0, ctx.get());
+        bool allEqual = true;
+        for(size_t r = 0; r < numRows; r++) {
+            const int64_t v = r;
+            const bool exp = opCode == BinaryOpCode::LT ? v < scalar : opCode == BinaryOpCode::GE ? v >= scalar
+                    : opCode == BinaryOpCode::EQ ? v == scalar : v != scalar;
+            allEqual &= res->get(r, 0) == exp;
+        }
+        CHECK(allEqual);
+        // the bits beyond the last row are zero
+        CHECK(BitMask::count(res, ctx.get()) == (opCode == BinaryOpCode::LT ? size_t(scalar)
+                : opCode == BinaryOpCode::GE ? numRows - scalar : opCode == BinaryOpCode::EQ ? 1 : numRows - 1));
+        DataObjectFactory::destroy(res);
+    }
+
+    // writing the values drops the statistics
+    arg->getValues()[0] = 1;
+    CHECK(arg->getZoneMap(0) == nullptr);
+
+    DataObjectFactory::destroy(arg);
+}
+
+TEST_CASE("ZoneMaps of frames and their filtered rows", TAG_KERNELS) {
+    ParallelContext ctx;
+
+    const size_t numRows = 3 * ColumnStats::BLOCK_ROWS;
+    ValueTypeCode schema[] = {ValueTypeCode::UI32, ValueTypeCode::F64, ValueTypeCode::STR};
+    auto arg = DataObjectFactory::create<Frame>(numRows, 3, schema, nullptr, false);
+    uint32_t * a = static_cast<uint32_t *>(arg->getColumnRaw(0));
+    double * b = static_cast<double *>(arg->getColumnRaw(1));
+    std::string * c = static_cast<std::string *>(arg->getColumnRaw(2));
+    for(size_t r = 0; r < numRows; r++) {
+        a[r] = r / 2;
+        b[r] = r % 10;
+        c[r] = std::to_string(r);
+    }
+
+    ZoneMaps::computeFrame(arg, ctx.get());
+    CHECK(arg->isColumnSorted(0));
+    CHECK_FALSE(arg->isColumnSorted(1));
+    CHECK(arg->getZoneMap<double>(1)->getMax(2) == 9.0);
+    CHECK(arg->getColumnStats(2) == nullptr);
+
+    // the selected rows of a sorted column are sorted
+    auto sel = DataObjectFactory::create<DenseMatrix<uint8_t>>(numRows, 1, false);
+    uint8_t * s = sel->getValues();
+    for(size_t r = 0; r < numRows; r++)
+        s[r] = r % 3 == 0;
+    Frame * res = nullptr;
+    filterRow(res, arg, sel, ctx.get());
+    REQUIRE(res->isColumnSorted(0));
+    auto zm = res->getZoneMap<uint32_t>(0);
+    CHECK(zm->getNumRows() == res->getNumRows());
+    CHECK(zm->getMin(0) == 0);
+    CHECK(zm->getMax(0) == uint32_t((numRows - 3) / 2));
+    CHECK(res->getColumnStats(1) == nullptr);
+
+    DataObjectFactory::destroy(arg, sel, res);
+}
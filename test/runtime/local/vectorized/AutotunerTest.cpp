@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/Autotuner.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+
+#include <unistd.h>
+
+TEST_CASE("Autotuner: signatures bucket the shape of a pipeline", TAG_VECTORIZED) {
+    CHECK(Autotuner::getSignature("ewAdd,sumRow", "double", 1000, 10) == "ewAdd,sumRow|double|rows~2^9|cols~2^3");
+    CHECK(Autotuner::getSignature("ewAdd,sumRow", "double", 1023, 15)
+            == Autotuner::getSignature("ewAdd,sumRow", "double", 1000, 10));
+    CHECK(Autotuner::getSignature("ewAdd,sumRow", "double", 1024, 10)
+            != Autotuner::getSignature("ewAdd,sumRow", "double", 1000, 10));
+    CHECK(Autotuner::getSignature("ewAdd,sumRow", "float", 1000, 10)
+            != Autotuner::getSignature("ewAdd,sumRow", "double", 1000, 10));
+}
+
+TEST_CASE("Autotuner: the candidates and trial ranges", TAG_VECTORIZED) {
+    const Autotuner::Choice configured{8, STATIC, 1};
+    const std::vector<Autotuner::Choice> candidates = Autotuner::getCandidates(configured);
+    REQUIRE(candidates.size() == 6);
+    CHECK(candidates[0] == configured);
+    CHECK(candidates[4] == Autotuner::Choice{4, STATIC, 1});
+    CHECK(candidates[5] == Autotuner::Choice{2, STATIC, 1});
+
+    // duplicates are tried once, e.g., with a single thread
+    CHECK(Autotuner::getCandidates({1, GSS, 1}).size() == 3);
+
+    // all trial ranges together take at most a quarter of the rows
+    const uint64_t trialRows = Autotuner::getTrialRows(1000000, 6, 8);
+    CHECK(trialRows * 6 <= 1000000 / 4);
+    CHECK(trialRows >= Autotuner::MIN_TRIAL_ROWS);
+    // too short to be tuned
+    CHECK(Autotuner::getTrialRows(10000, 6, 8) == 0);
+}
+
+TEST_CASE("Autotuner: the choices are persisted per topology", TAG_VECTORIZED) {
+    const std::string profile = "/tmp/daphne-autotuner-test-" + std::to_string(getpid()) + ".tsv";
+    {
+        std::ofstream out(profile);
+        out << "2cpus-2cores-1sockets-1numa-1llc\tewAdd|double|rows~2^9|cols~2^3\t2\tSTATIC\t1" << std::endl;
+    }
+
+    Autotuner & tuner = Autotuner::get();
+    tuner.enable(profile, "8cpus-4cores-1sockets-1numa-1llc");
+    const std::string sig = Autotuner::getSignature("ewAdd", "double", 1000, 10);
+    // the choice of the other topology is not used
+    CHECK_FALSE(tuner.lookup(sig).has_value());
+    tuner.record(sig, {4, GSS, 256});
+    tuner.disable();
+
+    // a later run of the same topology loads the choice
+    tuner.enable(profile, "8cpus-4cores-1sockets-1numa-1llc");
+    auto choice = tuner.lookup(sig);
+    REQUIRE(choice.has_value());
+    CHECK(*choice == Autotuner::Choice{4, GSS, 256});
+    CHECK(tuner.getStatistics() == std::make_pair<size_t, size_t>(0, 1));
+    tuner.disable();
+
+    // and the other topology keeps its choice
+    tuner.enable(profile, "2cpus-2cores-1sockets-1numa-1llc");
+    choice = tuner.lookup(sig);
+    REQUIRE(choice.has_value());
+    CHECK(*choice == Autotuner::Choice{2, STATIC, 1});
+    tuner.disable();
+
+    std::remove(profile.c_str());
+}
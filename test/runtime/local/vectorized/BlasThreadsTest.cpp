@@ -0,0 +1,60 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/vectorized/BlasThreads.h>
+#include <runtime/local/vectorized/Topology.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+TEST_CASE("BlasThreads: single-threaded BLAS within workers", TAG_VECTORIZED) {
+    DaphneUserConfig userConfig{};
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+
+    CHECK_FALSE(BlasThreads::isInWorker());
+    CHECK(BlasThreads::getNumThreads(ctx.get()) == static_cast<int>(std::max<size_t>(1, Topology::get().getNumCores())));
+    CHECK(BlasThreads::getNumThreads(nullptr) >= 1);
+    {
+        BlasThreads::WorkerScope scope;
+        CHECK(BlasThreads::isInWorker());
+        CHECK(BlasThreads::getNumThreads(ctx.get()) == 1);
+        BlasThreads::prepare(ctx.get());
+        CHECK(openblas_get_num_threads() == 1);
+    }
+    CHECK_FALSE(BlasThreads::isInWorker());
+}
+
+TEST_CASE("BlasThreads: number of threads of the user config", TAG_VECTORIZED) {
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = 3;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+
+    CHECK(BlasThreads::getNumThreads(ctx.get()) == 3);
+
+    // the chunks of a kernel run on the workers of the pool
+    std::atomic<size_t> numInWorker{0};
+    WorkerPool::parallelFor(ctx.get(), 8, [&](size_t) {
+        numInWorker += BlasThreads::isInWorker();
+    });
+    CHECK(numInWorker == 8);
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/io/CsvTokenizer.h>
+#include <runtime/local/kernels/AggAll.h>
+#include <runtime/local/kernels/AggCol.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/EwUnaryMat.h>
+#include <runtime/local/kernels/Transpose.h>
+#include <runtime/local/vectorized/CpuDispatch.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+    // the instruction sets this CPU runs variants for
+    std::vector<CpuIsa> getSupportedIsas() {
+        std::vector<CpuIsa> res;
+        for(size_t i = 0; i < CpuDispatch::NUM_ISAS; i++)
+            if(CpuDispatch::includes(CpuDispatch::detect(), static_cast<CpuIsa>(i)))
+                res.push_back(static_cast<CpuIsa>(i));
+        return res;
+    }
+}
+
+TEST_CASE("CpuDispatch selects the instruction set of the CPU", TAG_VECTORIZED) {
+    for(size_t i = 0; i < CpuDispatch::NUM_ISAS; i++)
+        CHECK(CpuDispatch::fromString(CpuDispatch::toString(static_cast<CpuIsa>(i))) == static_cast<CpuIsa>(i));
+    CHECK_THROWS(CpuDispatch::fromString("mmx"));
+    CHECK(CpuDispatch::includes(CpuIsa::AVX512, CpuIsa::AVX2));
+    CHECK_FALSE(CpuDispatch::includes(CpuIsa::AVX2, CpuIsa::AVX512));
+    CHECK_FALSE(CpuDispatch::includes(CpuIsa::SVE, CpuIsa::AVX2));
+
+    CpuDispatch::setMaxIsa("auto");
+    CHECK(CpuDispatch::getIsa() == CpuDispatch::detect());
+
+    auto runIsa = []() {
+        CpuIsa isa = CpuIsa::SVE;
+        CpuDispatch::run("cpuDispatchTest", [&](auto variant) { isa = decltype(variant)::value; });
+        return isa;
+    };
+    CHECK(runIsa() == CpuDispatch::detect());
+
+    CpuDispatch::setMaxIsa("generic");
+    CHECK(CpuDispatch::getIsa() == CpuIsa::GENERIC);
+    CHECK(runIsa() == CpuIsa::GENERIC);
+#if defined(DAPHNE_CPU_DISPATCH_X86)
+    CHECK_THROWS(CpuDispatch::setMaxIsa("sve"));
+#elif defined(DAPHNE_CPU_DISPATCH_ARM)
+    CHECK_THROWS(CpuDispatch::setMaxIsa("avx2"));
+#endif
+    CpuDispatch::setMaxIsa("auto");
+
+    bool found = false;
+    for(const auto & [kernel, isas] : CpuDispatch::getSelections())
+        if(kernel == "cpuDispatchTest") {
+            found = true;
+            CHECK(isas.front() == CpuIsa::GENERIC);
+        }
+    CHECK(found);
+}
+
+TEMPLATE_TEST_CASE("CpuDispatch: the variants of the kernels agree", TAG_VECTORIZED, float, double) {
+    using DT = DenseMatrix<TestType>;
+    const size_t numRows = 67;
+    const size_t numCols = 45;
+    auto lhs = DataObjectFactory::create<DT>(numRows, numCols, false);
+    auto rhs = DataObjectFactory::create<DT>(numRows, numCols, false);
+    for(size_t i = 0; i < numRows * numCols; i++) {
+        lhs->getValues()[i] = static_cast<TestType>(i % 101) / 8;
+        rhs->getValues()[i] = static_cast<TestType>(i % 13) + 1;
+    }
+    std::string line(1000, 'a');
+    line[700] = ',';
+    line[900] = '\n';
+
+    struct Results {
+        DT * sum = nullptr;
+        DT * sqrt = nullptr;
+        DT * colSums = nullptr;
+        DT * transposed = nullptr;
+        TestType total = 0;
+        const char * delim = nullptr;
+        uint64_t numNewlines = 0;
+    };
+    auto compute = [&](CpuIsa isa) {
+        CpuDispatch::setMaxIsa(CpuDispatch::toString(isa));
+        Results res;
+        ewBinaryMat(BinaryOpCode::ADD, res.sum, lhs, rhs, nullptr);
+        ewUnaryMat(UnaryOpCode::SQRT, res.sqrt, lhs, nullptr);
+        aggCol(AggOpCode::SUM, res.colSums, lhs, nullptr);
+        res.total = aggAll<DT>(AggOpCode::SUM, lhs, nullptr);
+        res.transposed = DataObjectFactory::create<DT>(numCols, numRows, false);
+        transpose(res.transposed, lhs, nullptr);
+        res.delim = csvFind2(line.data(), line.data() + line.size(), ',', '\n');
+        res.numNewlines = csvCount(line.data(), line.data() + line.size(), '\n');
+        return res;
+    };
+
+    const Results exp = compute(CpuIsa::GENERIC);
+    CHECK(exp.transposed->get(3, 5) == lhs->get(5, 3));
+    CHECK(exp.delim == line.data() + 700);
+    CHECK(exp.numNewlines == 1);
+    for(CpuIsa isa : getSupportedIsas()) {
+        DYNAMIC_SECTION(CpuDispatch::toString(isa)) {
+            const Results res = compute(isa);
+            CHECK(*res.sum == *exp.sum);
+            CHECK(*res.sqrt == *exp.sqrt);
+            CHECK(*res.colSums == *exp.colSums);
+            CHECK(res.total == exp.total);
+            CHECK(*res.transposed == *exp.transposed);
+            CHECK(res.delim == exp.delim);
+            CHECK(res.numNewlines == exp.numNewlines);
+            DataObjectFactory::destroy(res.sum, res.sqrt, res.colSums, res.transposed);
+        }
+    }
+    CpuDispatch::setMaxIsa("auto");
+
+    DataObjectFactory::destroy(exp.sum, exp.sqrt, exp.colSums, exp.transposed, lhs, rhs);
+}
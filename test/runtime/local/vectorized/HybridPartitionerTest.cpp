@@ -0,0 +1,72 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/HybridPartitioner.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <thread>
+
+TEST_CASE("HybridPartitioner: split point by throughput", TAG_VECTORIZED) {
+    // the GPU processes three times as many rows per second as all CPU workers together
+    CHECK(HybridPartitioner::splitPoint(100, 900, 3.0, 1.0) == 700);
+    CHECK(HybridPartitioner::splitPoint(0, 1000, 1.0, 1.0) == 500);
+    // without measurements, the default ratio is used
+    CHECK(HybridPartitioner::splitPoint(0, 1000, 0.0, 1.0) == 250);
+    CHECK(HybridPartitioner::splitPoint(10, 10, 1.0, 1.0) == 10);
+}
+
+TEST_CASE("HybridPartitioner: without profiling", TAG_VECTORIZED) {
+    HybridPartitioner hp(1000, 4, 1, 100, 100, false);
+    CHECK_FALSE(hp.isProfiling());
+    CHECK(hp.getGPUProfileEnd() == 250);
+    CHECK(hp.getCPUProfileStart() == 250);
+    CHECK(hp.split() == 250);
+
+    // too few rows for profiling
+    HybridPartitioner tiny(3, 4, 1, 100, 100, true);
+    CHECK_FALSE(tiny.isProfiling());
+    CHECK(tiny.split() == 1);
+
+    // a single device type gets all rows
+    HybridPartitioner cpuOnly(1000, 4, 0, 100, 100, true);
+    CHECK_FALSE(cpuOnly.isProfiling());
+    CHECK(cpuOnly.split() == 0);
+    HybridPartitioner gpuOnly(1000, 0, 2, 100, 100, true);
+    CHECK(gpuOnly.getCPUProfileStart() == 1000);
+    CHECK(gpuOnly.split() == 1000);
+}
+
+TEST_CASE("HybridPartitioner: split after profiling", TAG_VECTORIZED) {
+    const uint32_t numCPUWorkers = 4;
+    HybridPartitioner hp(10000, numCPUWorkers, 1, 500, 400, true);
+    REQUIRE(hp.isProfiling());
+    CHECK(hp.getGPUProfileEnd() == 500);
+    CHECK(hp.getCPUProfileStart() == 9600);
+
+    std::thread gpu([&]() { hp.getFeedback()->report(HybridPartitioner::GPU_SLOT, 500, 1.0); });
+    std::thread cpu([&]() {
+        // every CPU worker processes 100 rows per second
+        for(uint32_t w = 0; w < numCPUWorkers; w++)
+            hp.getFeedback()->report(HybridPartitioner::CPU_SLOT, 100, 1.0);
+    });
+    auto split = hp.split();
+    gpu.join();
+    cpu.join();
+    // 500 rows/s on the GPU, 400 rows/s on the CPU
+    CHECK(split == 500 + (9600 - 500) * 5 / 9 + 1);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/LoadPartitioning.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <cstdint>
+#include <vector>
+
+static std::vector<uint64_t> allChunks(LoadPartitioning& lp, size_t slot = 0) {
+    std::vector<uint64_t> chunks;
+    while(lp.hasNextChunk())
+        chunks.push_back(lp.getNextChunk(slot));
+    return chunks;
+}
+
+static uint64_t sum(const std::vector<uint64_t>& chunks) {
+    uint64_t res = 0;
+    for(auto c : chunks)
+        res += c;
+    return res;
+}
+
+TEST_CASE("ChunkFeedback: row time statistics", TAG_VECTORIZED) {
+    ChunkFeedback feedback(2);
+    double mean, stddev;
+    CHECK_FALSE(feedback.getRowTimeStatistics(mean, stddev));
+
+    // identical time per row in all chunks
+    feedback.report(0, 10, 1.0);
+    feedback.report(1, 20, 2.0);
+    REQUIRE(feedback.getRowTimeStatistics(mean, stddev));
+    CHECK(mean == Approx(0.1));
+    CHECK(stddev == Approx(0.0).margin(1e-9));
+
+    // varying time per row
+    feedback.report(0, 10, 3.0);
+    REQUIRE(feedback.getRowTimeStatistics(mean, stddev));
+    CHECK(mean == Approx(6.0 / 40));
+    CHECK(stddev > 0.0);
+}
+
+TEST_CASE("ChunkFeedback: slot weights", TAG_VECTORIZED) {
+    ChunkFeedback feedback(3);
+    CHECK(feedback.getSlotWeight(0) == 1.0);
+
+    // slot 0 is twice as fast as slot 1, slot 2 without measurements
+    feedback.report(0, 100, 1.0);
+    feedback.report(1, 100, 2.0);
+    CHECK(feedback.getSlotWeight(0) == Approx(100.0 / 75.0));
+    CHECK(feedback.getSlotWeight(1) == Approx(50.0 / 75.0));
+    CHECK(feedback.getSlotWeight(2) == 1.0);
+}
+
+TEST_CASE("LoadPartitioning: adaptive schemes cover all tasks", TAG_VECTORIZED) {
+    const uint64_t numTasks = 10000;
+    const uint32_t numWorkers = 4;
+    auto method = GENERATE(AWF, AF);
+
+    SECTION("without measurements") {
+        LoadPartitioning lp(method, numTasks, 1, numWorkers, false);
+        auto chunks = allChunks(lp);
+        CHECK(sum(chunks) == numTasks);
+        // behaves like factoring: the first chunk is half of the fair share
+        CHECK(chunks.front() == numTasks / (2 * numWorkers));
+    }
+    SECTION("with measurements") {
+        ChunkFeedback feedback(2);
+        feedback.report(0, 100, 1.0);
+        feedback.report(1, 100, 3.0);
+        LoadPartitioning lp(method, numTasks, 1, numWorkers, false, &feedback);
+        auto chunks = allChunks(lp, 1);
+        CHECK(sum(chunks) == numTasks);
+        CHECK(chunks.front() > 0);
+        CHECK(chunks.front() < numTasks / numWorkers);
+    }
+}
+
+TEST_CASE("LoadPartitioning: AWF weights chunks by slot speed", TAG_VECTORIZED) {
+    ChunkFeedback feedback(2);
+    feedback.report(0, 100, 1.0);
+    feedback.report(1, 100, 3.0);
+    LoadPartitioning fast(AWF, 10000, 1, 4, false, &feedback);
+    LoadPartitioning slow(AWF, 10000, 1, 4, false, &feedback);
+    CHECK(fast.getNextChunk(0) > slow.getNextChunk(1));
+}
+
+TEST_CASE("LoadPartitioning: AF shrinks chunks with increasing variance", TAG_VECTORIZED) {
+    ChunkFeedback uniform(1);
+    uniform.report(0, 100, 1.0);
+    uniform.report(0, 100, 1.0);
+    ChunkFeedback skewed(1);
+    skewed.report(0, 100, 0.2);
+    skewed.report(0, 100, 1.8);
+
+    LoadPartitioning lpUniform(AF, 10000, 1, 4, false, &uniform);
+    LoadPartitioning lpSkewed(AF, 10000, 1, 4, false, &skewed);
+    auto chunkUniform = lpUniform.getNextChunk();
+    // without variance, AF assigns the fair share of the remaining tasks
+    CHECK(chunkUniform >= 10000 / 4);
+    CHECK(chunkUniform <= 10000 / 4 + 1);
+    CHECK(lpSkewed.getNextChunk() < chunkUniform);
+}
+
+TEST_CASE("LoadPartitioning: chunks balanced by row costs", TAG_VECTORIZED) {
+    // prefix sums of the non-zeros of 8 rows: 1 heavy row (100) followed by rows with 0, 1, 2, ... non-zeros
+    std::vector<size_t> rowOffsets = {0, 100, 100, 101, 103, 106, 110, 115, 121};
+    const uint64_t numRows = rowOffsets.size() - 1;
+    auto method = GENERATE(STATIC, SS, GSS, FAC2, AF);
+
+    LoadPartitioning lp(method, rowOffsets.data(), 0, numRows, 1, 4, false);
+    auto chunks = allChunks(lp);
+    // every row is assigned exactly once
+    CHECK(sum(chunks) == numRows);
+    for(auto c : chunks)
+        CHECK(c > 0);
+    if(method == STATIC) {
+        // a quarter of the non-zeros ends within the heavy row, which forms a task on its own
+        CHECK(chunks.front() == 1);
+        CHECK(chunks.size() == 2);
+    }
+}
+
+TEST_CASE("LoadPartitioning: row costs of a sub-range", TAG_VECTORIZED) {
+    std::vector<size_t> rowOffsets = {5, 5, 6, 8, 8, 8, 20, 20};
+    LoadPartitioning lp(SS, rowOffsets.data(), 2, 7, 1, 2, false);
+    auto chunks = allChunks(lp);
+    CHECK(sum(chunks) == 5);
+    // rows without non-zeros are attached to the following row with non-zeros, or to the last task
+    CHECK(chunks == std::vector<uint64_t>{1, 4});
+}
@@ -14,15 +14,28 @@
  * limitations under the License.
  */
 
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/io/File.h>
+#include <runtime/local/io/ReadCsv.h>
+#include <runtime/local/io/RowChunkReader.h>
+#include <runtime/local/io/WriteCsv.h>
+#include <runtime/local/io/WriteDaphne.h>
+#include <runtime/local/kernels/AggCol.h>
+#include <runtime/local/kernels/CastObj.h>
 #include <runtime/local/kernels/CheckEqApprox.h>
 #include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/FilterRow.h>
 #include <runtime/local/kernels/RandMatrix.h>
 #include <runtime/local/vectorized/MTWrapper.h>
 
 #include <tags.h>
 #include <catch.hpp>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 
 #define DATA_TYPES DenseMatrix
 #define VALUE_TYPES double, float //TODO uint32_t
@@ -45,6 +58,47 @@ void funMul(DT*** outputs, Structure** inputs, DCTX(ctx)) {
         ctx);
 }
 
+// the product of a sparse and a dense input
+template<class DT>
+void funMulMixed(DT*** outputs, Structure** inputs, DCTX(ctx)) {
+    using VT = typename DT::VT;
+    ewBinaryMat(BinaryOpCode::MUL,
+        *outputs[0],
+        reinterpret_cast<CSRMatrix<VT>*>(inputs[0]),
+        reinterpret_cast<DenseMatrix<VT>*>(inputs[1]),
+        ctx);
+}
+
+// the column sums of a sparse input as a sparse row, which are added up over all tasks
+template<class DT>
+void funColSums(DT*** outputs, Structure** inputs, DCTX(ctx)) {
+    using VT = typename DT::VT;
+    DenseMatrix<VT>* sums = nullptr;
+    aggCol(AggOpCode::SUM, sums, reinterpret_cast<DT*>(inputs[0]), ctx);
+    castObj(*outputs[0], sums, ctx);
+    DataObjectFactory::destroy(sums);
+    // like a compiled pipeline, which releases its inputs
+    DataObjectFactory::destroy(inputs[0]);
+}
+
+// the rows of a frame selected by a matrix
+void funFilterRow(Frame*** outputs, Structure** inputs, DCTX(ctx)) {
+    filterRow(*outputs[0], reinterpret_cast<Frame*>(inputs[0]), reinterpret_cast<DenseMatrix<int64_t>*>(inputs[1]),
+            ctx);
+}
+
+// skewed rows: the first rows are dense, all others contain a single non-zero
+template<class DT>
+DT* genSkewedSparse(size_t numRows, size_t numCols) {
+    using VT = typename DT::VT;
+    std::vector<VT> elements(numRows * numCols, 0);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            if(r < 5 || c == r % numCols)
+                elements[r * numCols + c] = static_cast<VT>(r + c + 1);
+    return genGivenVals<DT>(numRows, elements);
+}
+
 TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded-scheduling", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)){
     using DT = TestType;
     using VT = typename DT::VT;
@@ -121,6 +175,408 @@ TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y", TAG_VECTORIZED, (DATA_TYPES), (
     DataObjectFactory::destroy(r2);
 }
 
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, split along columns", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    // a wide matrix, and a single column broadcast to all tasks
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 10, 1234, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 10, 1, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {10};
+    int64_t outCols[] = {1234};
+    VectorSplit splits[] = {VectorSplit::COLS, VectorSplit::COLS};
+    VectorCombine combines[] = {VectorCombine::COLS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, lock-free work-stealing deques", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.queueSetupScheme = PERCPU_LOCKFREE;
+    user_config.taskPartitioningScheme = SS;
+    user_config.minimumTaskSize = 10;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, repeated pipelines on persistent worker pool", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.queueSetupScheme = GENERATE(CENTRALIZED, PERCPU, PERCPU_LOCKFREE);
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+
+    size_t numPoolThreads = 0;
+    for(size_t i = 0; i < 20; i++) {
+        DT *r2 = nullptr;
+        DT **outputs[] = {&r2};
+        auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+        wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(),
+                false);
+        CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+        DataObjectFactory::destroy(r2);
+
+        auto pool = WorkerPool::get(ctx.get());
+        REQUIRE(pool != nullptr);
+        if(i == 0)
+            numPoolThreads = pool->getNumThreads();
+        // the threads of the first pipeline are reused by all following ones
+        CHECK(pool->getNumThreads() == numPoolThreads);
+    }
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, without worker pool", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.useWorkerPool = false;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+    CHECK(WorkerPool::get(ctx.get()) == nullptr);
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, threads and scheme of an annotation", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.numberOfThreads = 4;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    // more and fewer threads than configured
+    const int64_t numThreads = GENERATE(2, 8);
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get(), numThreads, GSS);
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, adaptive partitioning", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.taskPartitioningScheme = GENERATE(AWF, AF);
+    user_config.queueSetupScheme = GENERATE(CENTRALIZED, PERCPU);
+    user_config.numberOfThreads = 4;
+    user_config.minimumTaskSize = 10;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, NUMA-aware", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.numaAware = true;
+    user_config.taskPartitioningScheme = GENERATE(STATIC, GSS);
+    user_config.queueSetupScheme = GENERATE(CENTRALIZED, PERGROUP, PERCPU, PERCPU_LOCKFREE);
+    user_config.numberOfThreads = 4;
+    user_config.minimumTaskSize = 10;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, autotuned", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.vectorized_autotune = true;
+    user_config.numberOfThreads = 4;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    // enough rows for one trial range per candidate
+    const size_t numRows = 40000;
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, numRows, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, numRows, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {numRows};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+
+    // the first execution tunes the pipeline, the second one reuses the choice
+    for(size_t i = 0; i < 2; i++) {
+        DT *r2 = nullptr;
+        DT **outputs[] = {&r2};
+        auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+        wrapper->executeAutotuned(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, "ewAdd",
+                ctx.get(), false);
+        CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+        DataObjectFactory::destroy(r2);
+    }
+    CHECK(Autotuner::get().getStatistics() == std::make_pair<size_t, size_t>(1, 1));
+    Autotuner::get().disable();
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y, X streamed from a file", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    // 1234 rows are 411 chunks of 3 rows and a single remaining row
+    user_config.vectorized_stream_chunk_rows = GENERATE(3, 100, 0);
+    user_config.numberOfThreads = 4;
+    user_config.minimumTaskSize = 10;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    using Format = typename RowChunkReader<VT>::Format;
+    const char * filename;
+    Format format;
+    DT *x = nullptr;
+    SECTION("CSV") {
+        filename = "test/runtime/local/vectorized/StreamedX.csv";
+        format = Format::CSV;
+        File * file = openFileForWrite(filename);
+        writeCsv(m1, file);
+        closeFile(file);
+        // the values as printed to the file
+        readCsv(x, filename, 1234, 10, ',');
+    }
+    SECTION("Daphne binary") {
+        filename = "test/runtime/local/vectorized/StreamedX.dbdf";
+        format = Format::DAPHNE;
+        DF_options opts;
+        opts.rowsPerBlock = 64;
+        writeDaphne(m1, filename, opts);
+        x = m1;
+        x->increaseRefCounter();
+    }
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, x, m2, nullptr); //single-threaded
+
+    RowChunkReader<VT> source(filename, format, 1234, 10);
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {reinterpret_cast<Structure *>(const_cast<char *>(filename)), m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::STREAM, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeStreaming(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, 0, source,
+            ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+    CHECK(source.getNextRow() == 1234);
+    CHECK(source.readNext(10) == nullptr);
+
+    std::remove(filename);
+    DataObjectFactory::destroy(m1, m2, x, r1, r2);
+}
+
 TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X*Y", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
     using DT = TestType;
     using VT = typename DT::VT;
@@ -156,3 +612,240 @@ TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X*Y", TAG_VECTORIZED, (DATA_TYPES), (
     DataObjectFactory::destroy(r1);
     DataObjectFactory::destroy(r2);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded sparse X*Y, nnz-balanced partitioning", TAG_VECTORIZED, (CSRMatrix), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.nnzBalancedPartitioning = true;
+    user_config.taskPartitioningScheme = GENERATE(STATIC, GSS, SS);
+    user_config.prePartitionRows = GENERATE(false, true);
+    user_config.queueSetupScheme = PERCPU;
+    user_config.numberOfThreads = 4;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    // skewed rows: the first rows are dense, all others contain a single non-zero
+    const size_t numRows = 200;
+    const size_t numCols = 50;
+    std::vector<VT> elements(numRows * numCols, 0);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            if(r < 5 || c == r % numCols)
+                elements[r * numCols + c] = static_cast<VT>(r + c + 1);
+    auto m1 = genGivenVals<DT>(numRows, elements);
+    auto m2 = genGivenVals<DT>(numRows, elements);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::MUL, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {numRows};
+    int64_t outCols[] = {numCols};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funMul<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded sparse X*Y, all execution modes", TAG_VECTORIZED, (CSRMatrix), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.numberOfThreads = 4;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    const size_t numRows = 200;
+    const size_t numCols = 50;
+    auto m1 = genSkewedSparse<DT>(numRows, numCols);
+    auto m2 = genSkewedSparse<DT>(numRows, numCols);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::MUL, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {numRows};
+    int64_t outCols[] = {numCols};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funMul<DT>))));
+    SECTION("single queue") {
+        wrapper->executeSingleQueue(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines,
+                ctx.get(), false);
+    }
+    SECTION("queue per device type") {
+        wrapper->executeQueuePerDeviceType(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines,
+                ctx.get(), false);
+    }
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded sparse X*Y, mixed dense and sparse inputs", TAG_VECTORIZED, (CSRMatrix), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.numberOfThreads = 4;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    const size_t numRows = 200;
+    const size_t numCols = 50;
+    auto m1 = genSkewedSparse<DT>(numRows, numCols);
+    DenseMatrix<VT> *m2 = nullptr;
+    randMatrix<DenseMatrix<VT>, VT>(m2, numRows, numCols, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DenseMatrix<VT>>(BinaryOpCode::MUL, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {numRows};
+    int64_t outCols[] = {numCols};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funMulMixed<DT>))));
+    wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded sparse column sums, add combine", TAG_VECTORIZED, (CSRMatrix), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.numberOfThreads = 4;
+    user_config.taskPartitioningScheme = GENERATE(STATIC, GSS);
+    user_config.vectorized_single_queue = GENERATE(false, true);
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    const size_t numRows = 1000;
+    const size_t numCols = 50;
+    auto m1 = genSkewedSparse<DT>(numRows, numCols);
+
+    DenseMatrix<VT> *sums = nullptr;
+    aggCol(AggOpCode::SUM, sums, m1, nullptr); //single-threaded
+    DT *r1 = nullptr, *r2 = nullptr;
+    castObj(r1, sums, nullptr);
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false};
+    Structure *inputs[] = {m1};
+    int64_t outRows[] = {1};
+    int64_t outCols[] = {numCols};
+    VectorSplit splits[] = {VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ADD};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funColSums<DT>))));
+    if(user_config.vectorized_single_queue)
+        wrapper->executeSingleQueue(funcs, outputs, isScalar, inputs, 1, 1, outRows, outCols, splits, combines,
+                ctx.get(), false);
+    else
+        wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 1, 1, outRows, outCols, splits, combines,
+                ctx.get(), false);
+
+    REQUIRE(r2 != nullptr);
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(sums);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEST_CASE("Multi-threaded filterRow of a frame", TAG_VECTORIZED) { // NOLINT(cert-err58-cpp)
+    DaphneUserConfig user_config{};
+    user_config.numberOfThreads = 4;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    const size_t numRows = 5000;
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::F32, ValueTypeCode::STR};
+    auto arg = DataObjectFactory::create<Frame>(numRows, 3, schema, nullptr, false);
+    auto sel = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    for(size_t r = 0; r < numRows; r++) {
+        static_cast<int64_t *>(arg->getColumnRaw(0))[r] = static_cast<int64_t>(r) * 3;
+        static_cast<float *>(arg->getColumnRaw(1))[r] = static_cast<float>(r % 100);
+        static_cast<std::string *>(arg->getColumnRaw(2))[r] = "s" + std::to_string(r);
+        // a long run of unselected rows leaves some tasks without any result rows
+        sel->getValues()[r] = r < 1000 || r > 3000 ? (r * 7919) % 3 == 0 : 0;
+    }
+
+    Frame *r1 = nullptr, *r2 = nullptr;
+    filterRow<Frame, Frame, int64_t>(r1, arg, sel, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<Frame>>(1, ctx.get());
+
+    Frame **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {arg, sel};
+    int64_t outRows[] = {numRows};
+    int64_t outCols[] = {3};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(Frame ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(Frame***, Structure**, DCTX(ctx))>(&funFilterRow));
+    SECTION("single queue") {
+        wrapper->executeSingleQueue(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines,
+                ctx.get(), false);
+    }
+    SECTION("CPU queues") {
+        wrapper->executeCpuQueues(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines,
+                ctx.get(), false);
+    }
+
+    REQUIRE(r2->getNumRows() == r1->getNumRows());
+    bool allEqual = true;
+    for(size_t c = 0; c < 2; c++)
+        allEqual = allEqual && std::memcmp(r1->getColumnRaw(c), r2->getColumnRaw(c),
+                r1->getNumRows() * ValueTypeUtils::sizeOf(schema[c])) == 0;
+    for(size_t r = 0; r < r1->getNumRows(); r++)
+        allEqual = allEqual && static_cast<const std::string *>(r1->getColumnRaw(2))[r]
+                == static_cast<const std::string *>(r2->getColumnRaw(2))[r];
+    CHECK(allEqual);
+
+    DataObjectFactory::destroy(arg, sel, r1, r2);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/vectorized/RowViewCache.h>
+#include <runtime/local/vectorized/Tasks.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <vector>
+
+TEST_CASE("RowViewCache: views are rebound in place", TAG_VECTORIZED) {
+    auto m = genGivenVals<DenseMatrix<double>>(4, {
+        1, 2,
+        3, 4,
+        5, 6,
+        7, 8,
+    });
+
+    RowViewCache::Lease views;
+    REQUIRE(views.getCache());
+
+    auto v1 = static_cast<DenseMatrix<double>*>(views.getRowView(0, m, 0, 2));
+    CHECK(v1->getNumRows() == 2);
+    CHECK(v1->get(1, 0) == 3);
+    // the pipeline releases its reference to the input
+    DataObjectFactory::destroy(v1);
+
+    auto v2 = static_cast<DenseMatrix<double>*>(views.getRowView(0, m, 2, 3));
+    CHECK(v2 == v1);
+    CHECK(v2->getNumRows() == 1);
+    CHECK(v2->get(0, 1) == 6);
+    CHECK(v2->getValues() == m->getValues() + 4);
+
+    // a view still referenced elsewhere (e.g., returned as a result) is replaced
+    auto v3 = views.getRowView(0, m, 3, 4);
+    CHECK(v3 != v2);
+    CHECK(v2->getRefCounter() == 1);
+    DataObjectFactory::destroy(v2);
+
+    DataObjectFactory::destroy(v3);
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("RowViewCache: nested leases fall back to sliceRow", TAG_VECTORIZED) {
+    auto m = genGivenVals<DenseMatrix<double>>(2, {1, 2});
+    RowViewCache::Lease outer;
+    RowViewCache::Lease inner;
+    CHECK(outer.getCache());
+    CHECK_FALSE(inner.getCache());
+
+    auto v = inner.getRowView(0, m, 0, 1);
+    CHECK(v->getRefCounter() == 1);
+    DataObjectFactory::destroy(v);
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("RowViewCache: released views do not keep inputs alive", TAG_VECTORIZED) {
+    auto m = genGivenVals<DenseMatrix<double>>(2, {1, 2});
+    {
+        RowViewCache::Lease views;
+        DataObjectFactory::destroy(views.getRowView(0, m, 0, 1));
+        CHECK(views.getCache()->getNumViews() == 1);
+    }
+    // only m and the returned copy refer to the values, not the view
+    CHECK(m->getValuesSharedPtr().use_count() == 2);
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("CSRMatrix: rebind row view", TAG_VECTORIZED) {
+    auto m = genGivenVals<CSRMatrix<double>>(4, {
+        0, 1,
+        2, 0,
+        0, 3,
+        4, 5,
+    });
+    auto view = m->sliceRow(0, 1);
+    REQUIRE(view->rebindRowView(m, 2, 4));
+    CHECK(view->getNumRows() == 2);
+    CHECK(view->getNumNonZeros() == 3);
+    CHECK(view->get(0, 1) == 3);
+    CHECK(view->get(1, 0) == 4);
+
+    // views of another type are not rebound
+    auto dense = genGivenVals<DenseMatrix<double>>(1, {1, 2});
+    CHECK_FALSE(view->rebindRowView(dense, 0, 1));
+    CHECK(view->getNumRows() == 2);
+
+    DataObjectFactory::destroy(dense);
+    DataObjectFactory::destroy(view);
+    DataObjectFactory::destroy(m);
+}
+
+TEST_CASE("BroadcastInputPins: unused references are dropped", TAG_VECTORIZED) {
+    auto split = genGivenVals<DenseMatrix<double>>(2, {1, 2});
+    auto bcast = genGivenVals<DenseMatrix<double>>(1, {1, 2});
+    Structure* inputs[] = {split, bcast};
+    bool isScalar[] = {false, false};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::NONE};
+    {
+        BroadcastInputPins pins(inputs, isScalar, splits, 2, 10);
+        CHECK(split->getRefCounter() == 1);
+        CHECK(bcast->getRefCounter() == 11);
+        // 3 calls, each releasing its reference to the broadcast input
+        for(int i = 0; i < 3; i++)
+            DataObjectFactory::destroy(bcast);
+        pins.getNumCalls()->fetch_add(3);
+    }
+    CHECK(bcast->getRefCounter() == 1);
+    DataObjectFactory::destroy(bcast);
+    DataObjectFactory::destroy(split);
+}
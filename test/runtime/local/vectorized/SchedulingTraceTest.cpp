@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/SchedulingTrace.h>
+#include <runtime/local/vectorized/TaskQueues.h>
+#include <runtime/local/vectorized/WorkerCPU.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("SchedulingTrace: the workers record their tasks and steals", TAG_VECTORIZED) {
+    SchedulingTrace & trace = SchedulingTrace::get();
+    const uint32_t pipeline = trace.beginPipeline(2);
+    CHECK(pipeline != 0);
+
+    // all tasks are in the queue of the first worker, the second one steals them
+    BlockingTaskQueue q0(4);
+    BlockingTaskQueue q1(1);
+    size_t numExecuted = 0;
+    for(size_t i = 0; i < 4; i++)
+        q0.enqueueTask(new FunctionTask([&numExecuted]() { numExecuted++; }));
+    q0.closeInput();
+    q1.closeInput();
+    std::vector<TaskQueue*> queues{&q0, &q1};
+    std::vector<int> physicalIds{0, 0};
+    std::vector<int> uniqueThreads{0, 1};
+
+    // the workers run one after the other in this thread, with one queue per worker (mode 2) and sequential stealing
+    WorkerCPU thief(queues, physicalIds, uniqueThreads, false, 0, 1, 1, 2, 2, 0, false, false, pipeline);
+    thief.run();
+    WorkerCPU owner(queues, physicalIds, uniqueThreads, false, 0, 1, 0, 2, 2, 0, false, false, pipeline);
+    owner.run();
+    CHECK(numExecuted == 4);
+
+    std::stringstream summary;
+    SchedulingTrace::PipelineStats stats = trace.endPipeline(pipeline, summary);
+    REQUIRE(stats.workers.size() == 2);
+    const SchedulingTrace::WorkerStats & w0 = stats.workers[0];
+    const SchedulingTrace::WorkerStats & w1 = stats.workers[1];
+    CHECK(w0.worker == 0);
+    CHECK(w0.numTasks == 0);
+    CHECK(w0.numFailedSteals == 1);
+    CHECK(w1.worker == 1);
+    CHECK(w1.numTasks == 4);
+    CHECK(w1.numStolen == 4);
+    CHECK(w1.numRows == 4);
+    CHECK(w1.numFailedSteals == 1);
+    CHECK(stats.getImbalance() == Approx(2));
+    CHECK(summary.str().find("2 workers") != std::string::npos);
+    CHECK(summary.str().find("4 tasks (4 stolen, 2 failed steals)") != std::string::npos);
+
+    std::stringstream json;
+    trace.writeChromeTrace(json);
+    CHECK(json.str().find("\"traceEvents\"") != std::string::npos);
+    CHECK(json.str().find("\"name\": \"stolen task\"") != std::string::npos);
+    CHECK(json.str().find("\"name\": \"failed steal\"") != std::string::npos);
+    CHECK(json.str().find("\"name\": \"pipeline " + std::to_string(pipeline) + "\"") != std::string::npos);
+}
+
+TEST_CASE("SchedulingTrace: untraced workers record nothing", TAG_VECTORIZED) {
+    SchedulingTrace & trace = SchedulingTrace::get();
+    const uint32_t pipeline = trace.beginPipeline(1);
+
+    BlockingTaskQueue q(2);
+    q.enqueueTask(new FunctionTask([]() {}));
+    q.closeInput();
+    std::vector<TaskQueue*> queues{&q};
+    WorkerCPU worker(queues, {0}, {0}, false, 0, 1, 0, 1, 0, 0, false, false);
+    worker.run();
+
+    std::stringstream summary;
+    CHECK(trace.endPipeline(pipeline, summary).workers.empty());
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/TaskArena.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <vector>
+
+namespace {
+    // counts its live instances, to check that the arena destroys all tasks
+    class CountingTask : public Task {
+    public:
+        static inline int numAlive = 0;
+        uint64_t size;
+
+        explicit CountingTask(uint64_t size) : size(size) { numAlive++; }
+        ~CountingTask() override { numAlive--; }
+        void execute(uint32_t fid, uint32_t batchSize) override {}
+        uint64_t getTaskSize() override { return size; }
+    };
+}
+
+TEST_CASE("TaskArena: tasks are destroyed at the end of the lease", TAG_VECTORIZED) {
+    CountingTask::numAlive = 0;
+    {
+        TaskArena<CountingTask>::Lease tasks;
+        REQUIRE(tasks.getArena() != nullptr);
+        std::vector<Task*> created;
+        for(uint64_t i = 0; i < 3000; i++)
+            created.push_back(tasks.create(i));
+        CHECK(CountingTask::numAlive == 3000);
+        CHECK(tasks.getArena()->getNumChunks() == 3);
+        CHECK(created[2500]->getTaskSize() == 2500);
+        // releasing an arena task does not free it
+        for(auto t : created)
+            t->release();
+        CHECK(CountingTask::numAlive == 3000);
+    }
+    CHECK(CountingTask::numAlive == 0);
+}
+
+TEST_CASE("TaskArena: memory is reused across leases", TAG_VECTORIZED) {
+    Task* first;
+    {
+        TaskArena<CountingTask>::Lease tasks;
+        first = tasks.create(1);
+    }
+    TaskArena<CountingTask>::Lease tasks;
+    CHECK(tasks.create(2) == first);
+    CHECK(tasks.getArena()->getNumTasks() == 1);
+}
+
+TEST_CASE("TaskArena: nested lease falls back to the heap", TAG_VECTORIZED) {
+    CountingTask::numAlive = 0;
+    TaskArena<CountingTask>::Lease outer;
+    REQUIRE(outer.getArena() != nullptr);
+    {
+        TaskArena<CountingTask>::Lease inner;
+        CHECK(inner.getArena() == nullptr);
+        Task* t = inner.create(1);
+        CHECK(CountingTask::numAlive == 1);
+        // heap tasks are deleted on release
+        t->release();
+        CHECK(CountingTask::numAlive == 0);
+    }
+    CHECK(outer.getArena() != nullptr);
+}
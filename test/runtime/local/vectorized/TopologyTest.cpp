@@ -0,0 +1,121 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/Topology.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void writeFile(const fs::path& path, const std::string& content) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << content << std::endl;
+}
+
+/**
+ * @brief Creates a fake sysfs tree of 2 sockets (=NUMA nodes) with 2 cores with 2 SMT threads each, i.e., 8 CPUs.
+ * CPU i and i+4 are siblings, the cores of each socket share one L3 cache.
+ */
+static fs::path createFakeSysfs() {
+    fs::path root = fs::temp_directory_path() / "daphne_topology_test";
+    fs::remove_all(root);
+    const fs::path cpuDir = root / "devices/system/cpu";
+    writeFile(cpuDir / "online", "0-7");
+    for(int cpu = 0; cpu < 8; cpu++) {
+        int core = cpu % 4;
+        int socket = core / 2;
+        fs::path dir = cpuDir / ("cpu" + std::to_string(cpu));
+        writeFile(dir / "topology/physical_package_id", std::to_string(socket));
+        writeFile(dir / "topology/thread_siblings_list", std::to_string(core) + "," + std::to_string(core + 4));
+        writeFile(dir / "cache/index0/level", "1");
+        writeFile(dir / "cache/index0/shared_cpu_list", std::to_string(core) + "," + std::to_string(core + 4));
+        writeFile(dir / "cache/index1/level", "3");
+        writeFile(dir / "cache/index1/shared_cpu_list", socket ? "2-3,6-7" : "0-1,4-5");
+    }
+    writeFile(root / "devices/system/node/node0/cpulist", "0-1,4-5");
+    writeFile(root / "devices/system/node/node1/cpulist", "2-3,6-7");
+    return root;
+}
+
+TEST_CASE("Topology: parse CPU list", TAG_VECTORIZED) {
+    CHECK(Topology::parseCpuList("0") == std::vector<int>{0});
+    CHECK(Topology::parseCpuList("0-3,8,10-11") == std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+    CHECK(Topology::parseCpuList("").empty());
+}
+
+TEST_CASE("Topology: read from sysfs", TAG_VECTORIZED) {
+    auto root = createFakeSysfs();
+    auto topo = Topology::fromSysfs(root.string(), {});
+
+    CHECK(topo.getNumCpus() == 8);
+    CHECK(topo.getNumSockets() == 2);
+    CHECK(topo.getNumNumaNodes() == 2);
+    CHECK(topo.getNumCacheGroups() == 2);
+    CHECK(topo.getNumCores() == 4);
+    CHECK(topo.getSmtSiblings(2) == std::vector<int>{2, 6});
+
+    auto cores = topo.getCoreCpus();
+    REQUIRE(cores.size() == 4);
+    for(size_t i = 0; i < cores.size(); i++) {
+        CHECK(cores[i].cpu == static_cast<int>(i));
+        CHECK(cores[i].numaNode == static_cast<int>(i / 2));
+        CHECK(cores[i].cacheGroup == static_cast<int>(i / 2));
+    }
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("Topology: restricted to allowed CPUs", TAG_VECTORIZED) {
+    auto root = createFakeSysfs();
+    // e.g., a cpuset containing only the second socket
+    auto topo = Topology::fromSysfs(root.string(), {2, 3, 6, 7});
+
+    CHECK(topo.getNumCpus() == 4);
+    CHECK(topo.getNumSockets() == 1);
+    CHECK(topo.getNumNumaNodes() == 1);
+    CHECK(topo.getNumCores() == 2);
+    for(const auto& info : topo.getCpus()) {
+        CHECK(info.socket == 0);
+        CHECK(info.numaNode == 0);
+    }
+    CHECK(topo.getCoreCpus().front().cpu == 2);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("Topology: fallback without sysfs", TAG_VECTORIZED) {
+    auto topo = Topology::fromSysfs("/nonexistent", {1, 3});
+
+    REQUIRE(topo.getNumCpus() == 2);
+    CHECK(topo.getCpus()[0].cpu == 1);
+    CHECK(topo.getCpus()[1].cpu == 3);
+    CHECK(topo.getNumSockets() == 1);
+    CHECK(topo.getNumCores() == 2);
+}
+
+TEST_CASE("Topology: process topology", TAG_VECTORIZED) {
+    const auto& topo = Topology::get();
+    CHECK(topo.getNumCpus() >= 1);
+    CHECK(topo.getNumCpus() <= Topology::getAffinityCpus().size());
+    // detected only once
+    CHECK(&topo == &Topology::get());
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Frame.h>
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/vectorized/VectorizedDataSink.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define VALUE_TYPES double, float
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>: row-wise combine", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = DenseMatrix<TestType>;
+    auto res = DataObjectFactory::create<DT>(4, 2, true);
+    VectorizedDataSink<DT> sink(VectorCombine::ROWS, res);
+
+    auto part1 = genGivenVals<DT>(1, {1, 2});
+    auto part2 = genGivenVals<DT>(3, {3, 4, 5, 6, 7, 8});
+    // the parts may arrive in any order
+    sink.add(part2, 1);
+    sink.add(part1, 0);
+    CHECK(sink.consume() == res);
+
+    auto exp = genGivenVals<DT>(4, {1, 2, 3, 4, 5, 6, 7, 8});
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(res, part1, part2, exp);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>: column-wise combine", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = DenseMatrix<TestType>;
+    auto res = DataObjectFactory::create<DT>(2, 3, true);
+    VectorizedDataSink<DT> sink(VectorCombine::COLS, res);
+
+    auto part1 = genGivenVals<DT>(2, {1, 2, 4, 5});
+    auto part2 = genGivenVals<DT>(2, {3, 6});
+    sink.add(part1, 0);
+    sink.add(part2, 2);
+    sink.consume();
+
+    auto exp = genGivenVals<DT>(2, {1, 2, 3, 4, 5, 6});
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(res, part1, part2, exp);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>: result buffer", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = DenseMatrix<TestType>;
+    auto res = DataObjectFactory::create<DT>(4, 3, true);
+    VectorizedDataSink<DT> rows(VectorCombine::ROWS, res);
+    VectorizedDataSink<DT> cols(VectorCombine::COLS, res);
+
+    auto [rowBuf, rowSkip] = rows.getResultBuffer(2);
+    CHECK(rowBuf == res->getValues() + 6);
+    CHECK(rowSkip == 3);
+    auto [colBuf, colRowSkip] = cols.getResultBuffer(2);
+    CHECK(colBuf == res->getValues() + 2);
+    CHECK(colRowSkip == 3);
+
+    VectorizedDataSink<DT> add(VectorCombine::ADD, nullptr);
+    CHECK_THROWS(add.getResultBuffer(0));
+
+    DataObjectFactory::destroy(res);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>: add combine", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = DenseMatrix<TestType>;
+    const size_t numThreads = 5;
+    const size_t numParts = 20;
+    // large enough for the parallel tree reduction
+    const size_t numRows = 300;
+    const size_t numCols = 300;
+    auto withInitial = GENERATE(false, true);
+
+    DT *initial = nullptr;
+    if(withInitial) {
+        initial = DataObjectFactory::create<DT>(numRows, numCols, false);
+        std::fill(initial->getValues(), initial->getValues() + numRows * numCols, TestType(1));
+    }
+    VectorizedDataSink<DT> sink(VectorCombine::ADD, initial, numThreads);
+
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++) {
+        threads.emplace_back([&sink, numParts, numThreads, numRows, numCols, t]() {
+            for(size_t p = t; p < numParts; p += numThreads) {
+                auto part = DataObjectFactory::create<DT>(numRows, numCols, false);
+                std::fill(part->getValues(), part->getValues() + numRows * numCols, TestType(p));
+                sink.addPartial(part);
+            }
+        });
+    }
+    for(auto &t : threads)
+        t.join();
+
+    auto res = sink.consume();
+    REQUIRE(res != nullptr);
+    if(withInitial)
+        CHECK(res == initial);
+    // 0 + 1 + ... + 19 (+ 1)
+    const TestType exp = numParts * (numParts - 1) / 2 + (withInitial ? 1 : 0);
+    bool allEqual = true;
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            allEqual &= res->get(r, c) == exp;
+    CHECK(allEqual);
+
+    DataObjectFactory::destroy(res);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>: min and max combines", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = DenseMatrix<TestType>;
+    const size_t numThreads = 3;
+    auto combine = GENERATE(VectorCombine::MIN, VectorCombine::MAX);
+    VectorizedDataSink<DT> sink(combine, nullptr, numThreads);
+
+    // the column-wise minima/maxima of the row blocks of a matrix
+    std::vector<std::vector<TestType>> partVals = {{3, -1, 5}, {2, 4, 8}, {7, 0, -2}, {1, 6, 5}};
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++) {
+        threads.emplace_back([&sink, &partVals, numThreads, t]() {
+            for(size_t p = t; p < partVals.size(); p += numThreads)
+                sink.addPartial(genGivenVals<DT>(1, partVals[p]));
+        });
+    }
+    for(auto &t : threads)
+        t.join();
+
+    auto res = sink.consume();
+    REQUIRE(res != nullptr);
+    auto exp = genGivenVals<DT>(1, combine == VectorCombine::MIN ? std::vector<TestType>{1, -1, -2}
+                                                                 : std::vector<TestType>{7, 6, 8});
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(res, exp);
+}
+
+TEST_CASE("VectorizedDataSink<DenseMatrix>: add combine without parts", TAG_VECTORIZED) {
+    VectorizedDataSink<DenseMatrix<double>> sink(VectorCombine::ADD, nullptr, 4);
+    CHECK(sink.consume() == nullptr);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<CSRMatrix>: slotted mode", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = CSRMatrix<TestType>;
+    auto combine = GENERATE(VectorCombine::ROWS, VectorCombine::COLS);
+    auto parallel = GENERATE(false, true);
+
+    typename VectorizedDataSink<DT>::ParallelFor parallelFor;
+    if(parallel) {
+        parallelFor = [](size_t n, const std::function<void(size_t)> &func) {
+            std::vector<std::thread> threads;
+            for(size_t i = 0; i < n; i++)
+                threads.emplace_back(func, i);
+            for(auto &t : threads)
+                t.join();
+        };
+    }
+
+    DT *exp;
+    VectorizedDataSink<DT> sink(combine, combine == VectorCombine::ROWS ? 4 : 2, combine == VectorCombine::ROWS ? 3 : 5,
+            true);
+    if(combine == VectorCombine::ROWS) {
+        exp = genGivenVals<DT>(4, {1, 0, 2, 0, 0, 0, 0, 3, 0, 4, 5, 6});
+        // the parts may arrive in any order
+        sink.add(genGivenVals<DT>(2, {0, 0, 0, 0, 3, 0}), 1);
+        sink.add(genGivenVals<DT>(1, {4, 5, 6}), 3);
+        sink.add(genGivenVals<DT>(1, {1, 0, 2}), 0);
+    }
+    else {
+        exp = genGivenVals<DT>(2, {1, 0, 0, 2, 3, 0, 4, 0, 0, 5});
+        sink.add(genGivenVals<DT>(2, {0, 2, 3, 0, 0, 5}), 2);
+        sink.add(genGivenVals<DT>(2, {1, 0, 0, 4}), 0);
+    }
+    auto res = sink.consume(parallelFor);
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(res, exp);
+}
+
+TEST_CASE("VectorizedDataSink<CSRMatrix>: slotted mode with many row blocks", TAG_VECTORIZED) {
+    using DT = CSRMatrix<double>;
+    // more rows than one block of the parallel column-wise merge
+    const size_t numRows = 10000;
+    const size_t numCols = 6;
+    std::vector<double> vals(numRows * numCols, 0);
+    for(size_t r = 0; r < numRows; r++)
+        vals[r * numCols + r % numCols] = r + 1;
+    auto exp = genGivenVals<DT>(numRows, vals);
+
+    VectorizedDataSink<DT> sink(VectorCombine::COLS, numRows, numCols, true);
+    for(size_t c = 0; c < numCols; c += 2) {
+        std::vector<double> partVals(numRows * 2);
+        for(size_t r = 0; r < numRows; r++)
+            for(size_t j = 0; j < 2; j++)
+                partVals[r * 2 + j] = vals[r * numCols + c + j];
+        sink.add(genGivenVals<DT>(numRows, partVals), c);
+    }
+    auto res = sink.consume([](size_t n, const std::function<void(size_t)> &func) {
+        std::vector<std::thread> threads;
+        for(size_t i = 0; i < n; i++)
+            threads.emplace_back(func, i);
+        for(auto &t : threads)
+            t.join();
+    });
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(res, exp);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<CSRMatrix>: add combine", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = CSRMatrix<TestType>;
+    const size_t numThreads = 4;
+    // more rows than one block of the parallel aggregation
+    const size_t numRows = 9000;
+    const size_t numCols = 7;
+    const size_t numParts = 10;
+    auto withInitial = GENERATE(false, true);
+
+    // part p has the value p + 1 in the cell (r, (r + p) % numCols) of every row r, and -1 in the last column of the
+    // first row, which cancels out with the initial value
+    auto genPart = [&](size_t p) {
+        std::vector<TestType> vals(numRows * numCols, 0);
+        for(size_t r = 0; r < numRows; r++)
+            vals[r * numCols + (r + p) % numCols] = TestType(p + 1);
+        vals[numCols - 1] = TestType(-1);
+        return genGivenVals<DT>(numRows, vals);
+    };
+    std::vector<TestType> expVals(numRows * numCols, 0);
+    for(size_t p = 0; p < numParts; p++)
+        for(size_t r = 0; r < numRows; r++)
+            expVals[r * numCols + (r + p) % numCols] += TestType(p + 1);
+    expVals[numCols - 1] = 0;
+    DT *initial = nullptr;
+    if(withInitial) {
+        std::vector<TestType> initialVals(numRows * numCols, 0);
+        initialVals[numCols - 1] = TestType(numParts);
+        initialVals[numRows * numCols - 1] = TestType(1);
+        expVals[numRows * numCols - 1] += TestType(1);
+        initial = genGivenVals<DT>(numRows, initialVals);
+    }
+    else
+        expVals[numCols - 1] = -TestType(numParts) + expVals[numCols - 1];
+    auto exp = genGivenVals<DT>(numRows, expVals);
+
+    VectorizedDataSink<DT> sink(VectorCombine::ADD, initial, numThreads);
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++) {
+        threads.emplace_back([&sink, &genPart, numParts, numThreads, t]() {
+            for(size_t p = t; p < numParts; p += numThreads)
+                sink.addPartial(genPart(p));
+        });
+    }
+    for(auto &t : threads)
+        t.join();
+
+    auto res = sink.consume([](size_t n, const std::function<void(size_t)> &func) {
+        std::vector<std::thread> threads;
+        for(size_t i = 0; i < n; i++)
+            threads.emplace_back(func, i);
+        for(auto &t : threads)
+            t.join();
+    });
+    REQUIRE(res != nullptr);
+    CHECK(*res == *exp);
+    // the cancelled cell is not stored
+    CHECK(res->getNumNonZeros() == exp->getNumNonZeros());
+
+    DataObjectFactory::destroy(res, exp);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<CSRMatrix>: min and max combines", TAG_VECTORIZED, VALUE_TYPES) {
+    using DT = CSRMatrix<TestType>;
+    const size_t numThreads = 3;
+    auto combine = GENERATE(VectorCombine::MIN, VectorCombine::MAX);
+    VectorizedDataSink<DT> sink(combine, nullptr, numThreads);
+
+    // the implicit zeros of the parts take part in the aggregation
+    std::vector<std::vector<TestType>> partVals = {{3, -1, 0, 0}, {2, 0, 8, 0}, {7, 0, -2, 0}, {1, 6, 5, 0}};
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++) {
+        threads.emplace_back([&sink, &partVals, numThreads, t]() {
+            for(size_t p = t; p < partVals.size(); p += numThreads)
+                sink.addPartial(genGivenVals<DT>(1, partVals[p]));
+        });
+    }
+    for(auto &t : threads)
+        t.join();
+
+    auto res = sink.consume();
+    REQUIRE(res != nullptr);
+    auto exp = genGivenVals<DT>(1, combine == VectorCombine::MIN ? std::vector<TestType>{1, -1, -2, 0}
+                                                                 : std::vector<TestType>{7, 6, 8, 0});
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(res, exp);
+}
+
+TEST_CASE("VectorizedDataSink<CSRMatrix>: add combine without parts", TAG_VECTORIZED) {
+    VectorizedDataSink<CSRMatrix<double>> sink(VectorCombine::ADD, nullptr, 4);
+    CHECK(sink.consume() == nullptr);
+    CHECK_THROWS_AS(sink.add(nullptr, 0), std::runtime_error);
+}
+
+TEST_CASE("VectorizedDataSink<Frame>: row-wise combine", TAG_VECTORIZED) {
+    ValueTypeCode schema[] = {ValueTypeCode::SI64, ValueTypeCode::STR};
+    std::string labels[] = {"a", "b"};
+    auto genPart = [&](std::vector<int64_t> keys) {
+        auto part = DataObjectFactory::create<Frame>(keys.size(), 2, schema, labels, false);
+        for(size_t r = 0; r < keys.size(); r++) {
+            static_cast<int64_t *>(part->getColumnRaw(0))[r] = keys[r];
+            static_cast<std::string *>(part->getColumnRaw(1))[r] = "s" + std::to_string(keys[r]);
+        }
+        return part;
+    };
+
+    VectorizedDataSink<Frame> sink(VectorCombine::ROWS, 10);
+    // the parts may arrive in any order and have fewer rows than they were computed from
+    sink.add(genPart({7, 9}), 6);
+    sink.add(genPart({}), 3);
+    sink.add(genPart({0, 2}), 0);
+    auto res = sink.consume();
+
+    REQUIRE(res->getNumRows() == 4);
+    CHECK(res->getLabels()[1] == "b");
+    const int64_t * keys = static_cast<const int64_t *>(res->getColumnRaw(0));
+    const std::string * strs = static_cast<const std::string *>(res->getColumnRaw(1));
+    CHECK(std::vector<int64_t>(keys, keys + 4) == std::vector<int64_t>{0, 2, 7, 9});
+    CHECK(std::vector<std::string>(strs, strs + 4) == std::vector<std::string>{"s0", "s2", "s7", "s9"});
+
+    DataObjectFactory::destroy(res);
+}
+
+TEST_CASE("VectorizedDataSink<Frame>: unsupported combine", TAG_VECTORIZED) {
+    CHECK_THROWS_AS(VectorizedDataSink<Frame>(VectorCombine::COLS, 4), std::runtime_error);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2022 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+TEST_CASE("WorkerPool: parallelFor rethrows the exception of a function", TAG_VECTORIZED) {
+    DaphneUserConfig userConfig{};
+    userConfig.numberOfThreads = 3;
+    auto ctx = std::make_unique<DaphneContext>(userConfig);
+    const size_t n = 16;
+
+    // on the workers of the pool and in the calling thread without a context
+    for(DaphneContext * c : {ctx.get(), static_cast<DaphneContext *>(nullptr)}) {
+        std::atomic<size_t> numDone{0};
+        CHECK_THROWS_AS(WorkerPool::parallelFor(c, n, [&](size_t i) {
+            if(i == 5)
+                throw std::runtime_error("task 5 failed");
+            numDone++;
+        }), std::runtime_error);
+        if(c)
+            // the other functions still ran
+            CHECK(numDone == n - 1);
+    }
+
+    // the pool is usable after the exception
+    std::atomic<size_t> numDone{0};
+    WorkerPool::parallelFor(ctx.get(), n, [&](size_t) { numDone++; });
+    CHECK(numDone == n);
+}